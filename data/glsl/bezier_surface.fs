@@ -0,0 +1,36 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+
+
+/* headlight shading of the tessellated vl::BezierSurface */
+
+#version 400
+
+in vec3 tesPosition;
+in vec3 tesNormal;
+in vec2 tesTexCoord;
+out vec4 frag_output;
+
+uniform vec4 surface_color = vec4( 1.0 );
+
+void main()
+{
+  vec3 n = normalize( tesNormal );
+  vec3 l = normalize( -tesPosition );
+  // two sided
+  float diffuse = abs( dot( n, l ) );
+  float specular = pow( diffuse, 32.0 );
+  frag_output = vec4( surface_color.rgb * ( 0.2 + 0.8 * diffuse ) + vec3( 0.3 * specular ), surface_color.a );
+}
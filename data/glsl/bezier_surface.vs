@@ -0,0 +1,27 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+
+
+/* bicubic Bezier patch control points, see vl::BezierSurface::createTessellationProgram() */
+
+#version 400
+
+in vec4 vl_VertexPosition;
+out vec4 vPosition;
+
+void main(void)
+{
+  vPosition = vl_VertexPosition;
+}
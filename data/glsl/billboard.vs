@@ -0,0 +1,47 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+#version 150 compatibility
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/std/vertex_attribs.glsl
+
+// Renders the billboards generated by vl::BillboardSet:
+// vl_VertexPosition  = billboard center
+// vl_VertexTexCoord0 = (u, v, size)
+// vl_VertexNormal    = rotation axis for axis aligned billboards, zero for spherical billboards
+
+void main(void)
+{
+	// billboard center in eye space
+	vec4 C = vl_ModelViewMatrix * vl_VertexPosition;
+	vec2 corner = (vl_VertexTexCoord0.xy - vec2(0.5)) * vl_VertexTexCoord0.z;
+
+	vec3 X, Y;
+	if ( dot(vl_VertexNormal, vl_VertexNormal) == 0.0 )
+	{
+		// spherical: face the eye keeping the camera up vector
+		Y = vec3(0.0, 1.0, 0.0);
+		X = normalize(cross(Y, -C.xyz));
+	}
+	else
+	{
+		// axis aligned: rotate around the axis only
+		Y = normalize(mat3(vl_ModelViewMatrix) * vl_VertexNormal);
+		X = normalize(cross(Y, -C.xyz));
+	}
+
+	gl_Position = vl_ProjectionMatrix * vec4(C.xyz + X * corner.x + Y * corner.y, 1.0);
+	gl_FrontColor = gl_Color;
+	gl_TexCoord[0] = vec4(vl_VertexTexCoord0.xy, 0.0, 1.0);
+}
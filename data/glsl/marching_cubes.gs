@@ -0,0 +1,76 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUMarchingCubes: emits the triangles of a cell, captured by transform feedback
+
+layout(points) in;
+layout(triangle_strip, max_vertices = 15) out;
+
+uniform sampler3D      vl_MCVolume;
+uniform isamplerBuffer vl_MCTriangleTable;
+uniform ivec3          vl_MCCells;
+uniform float          vl_MCThreshold;
+uniform vec3           vl_MCBoxMin;
+uniform vec3           vl_MCBoxSize;
+
+flat in int   mcCase[];
+flat in ivec3 mcCell[];
+
+out vec3 vl_MCPosition;
+out vec3 vl_MCNormal;
+
+const ivec3 corners[8] = ivec3[8]( ivec3(0,0,0), ivec3(1,0,0), ivec3(1,1,0), ivec3(0,1,0), ivec3(0,0,1), ivec3(1,0,1), ivec3(1,1,1), ivec3(0,1,1) );
+const ivec2 edges[12]  = ivec2[12]( ivec2(0,1), ivec2(1,2), ivec2(2,3), ivec2(3,0), ivec2(4,5), ivec2(5,6), ivec2(6,7), ivec2(7,4), ivec2(0,4), ivec2(1,5), ivec2(2,6), ivec2(3,7) );
+
+void emitEdgeVertex(int edge)
+{
+	ivec3 a = mcCell[0] + corners[ edges[edge].x ];
+	ivec3 b = mcCell[0] + corners[ edges[edge].y ];
+	float va = texelFetch(vl_MCVolume, a, 0).r;
+	float vb = texelFetch(vl_MCVolume, b, 0).r;
+	vec3 p = mix( vec3(a), vec3(b), (vl_MCThreshold - va) / (vb - va) );
+
+	// the normal points towards the decreasing values like MarchingCubes' high quality normals
+	vec3 samples = vec3(vl_MCCells + 1);
+	vec3 tc = (p + 0.5) / samples;
+	vec3 d  = 0.5 / samples;
+	vec3 n;
+	n.x = texture(vl_MCVolume, tc - vec3(d.x,0,0)).r - texture(vl_MCVolume, tc + vec3(d.x,0,0)).r;
+	n.y = texture(vl_MCVolume, tc - vec3(0,d.y,0)).r - texture(vl_MCVolume, tc + vec3(0,d.y,0)).r;
+	n.z = texture(vl_MCVolume, tc - vec3(0,0,d.z)).r - texture(vl_MCVolume, tc + vec3(0,0,d.z)).r;
+
+	vl_MCPosition = vl_MCBoxMin + p / vec3(vl_MCCells) * vl_MCBoxSize;
+	vl_MCNormal   = normalize( n * vec3(vl_MCCells) / vl_MCBoxSize );
+	EmitVertex();
+}
+
+void main(void)
+{
+	int c = mcCase[0];
+	if (c == 0 || c == 255)
+		return;
+
+	for(int i=0; i<15; i+=3)
+	{
+		int e0 = texelFetch(vl_MCTriangleTable, c*16 + i).r;
+		if (e0 < 0)
+			break;
+		emitEdgeVertex( e0 );
+		emitEdgeVertex( texelFetch(vl_MCTriangleTable, c*16 + i + 1).r );
+		emitEdgeVertex( texelFetch(vl_MCTriangleTable, c*16 + i + 2).r );
+		EndPrimitive();
+	}
+}
@@ -0,0 +1,44 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUMarchingCubes: one point is drawn for each cell of the volume
+
+uniform sampler3D vl_MCVolume;
+uniform ivec3     vl_MCCells;
+uniform float     vl_MCThreshold;
+
+flat out int   mcCase;
+flat out ivec3 mcCell;
+
+void main(void)
+{
+	ivec3 cell = ivec3( gl_VertexID % vl_MCCells.x, (gl_VertexID / vl_MCCells.x) % vl_MCCells.y, gl_VertexID / (vl_MCCells.x * vl_MCCells.y) );
+
+	// same corner numbering of vl::MarchingCubes
+	int c = 0;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(0,0,0), 0).r < vl_MCThreshold ) c += 1;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(1,0,0), 0).r < vl_MCThreshold ) c += 2;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(1,1,0), 0).r < vl_MCThreshold ) c += 4;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(0,1,0), 0).r < vl_MCThreshold ) c += 8;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(0,0,1), 0).r < vl_MCThreshold ) c += 16;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(1,0,1), 0).r < vl_MCThreshold ) c += 32;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(1,1,1), 0).r < vl_MCThreshold ) c += 64;
+	if ( texelFetch(vl_MCVolume, cell + ivec3(0,1,1), 0).r < vl_MCThreshold ) c += 128;
+
+	mcCase = c;
+	mcCell = cell;
+	gl_Position = vec4(0.0);
+}
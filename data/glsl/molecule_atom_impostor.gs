@@ -0,0 +1,37 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::Molecule::setImpostorsEnabled(): one point is drawn for each atom, the sphere is ray cast by molecule_impostor.fs
+
+layout(points) in;
+layout(triangle_strip, max_vertices = 14) out;
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/molecule_impostor_box.glsl
+
+in vec3  molVertexCenter[];
+in vec4  molVertexColor[];
+in float molVertexRadius[];
+
+void main(void)
+{
+	float r = molVertexRadius[0];
+	if ( r <= 0.0 )
+		return;
+
+	vec3 c = molVertexCenter[0];
+	emitImpostorBox( c, vec3(r,0,0), vec3(0,r,0), vec3(0,0,r), c, vec3(0.0), r, molVertexColor[0], molVertexColor[0] );
+}
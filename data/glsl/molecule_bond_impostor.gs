@@ -0,0 +1,44 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::Molecule::setImpostorsEnabled(): one line is drawn for each bond, the cylinder is ray cast by molecule_impostor.fs
+
+layout(lines) in;
+layout(triangle_strip, max_vertices = 14) out;
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/molecule_impostor_box.glsl
+
+in vec3  molVertexCenter[];
+in vec4  molVertexColor[];
+in float molVertexRadius[];
+
+void main(void)
+{
+	vec3 a = molVertexCenter[0];
+	vec3 b = molVertexCenter[1];
+	float r = molVertexRadius[0];
+	vec3 axis = b - a;
+	float len = length( axis );
+	if ( len == 0.0 || r <= 0.0 )
+		return;
+
+	// box aligned to the bond, v and w are any two directions orthogonal to it
+	vec3 u = axis / len;
+	vec3 v = normalize( cross( u, abs(u.x) < 0.9 ? vec3(1,0,0) : vec3(0,1,0) ) );
+	vec3 w = cross( u, v );
+	emitImpostorBox( (a + b) * 0.5, axis * 0.5, v * r, w * r, a, axis, r, molVertexColor[0], molVertexColor[1] );
+}
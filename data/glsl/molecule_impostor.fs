@@ -0,0 +1,39 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::Molecule::setImpostorsEnabled()
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/molecule_impostor.glsl
+
+void main(void)
+{
+	vec3 pos, normal;
+	vec4 color;
+	if ( !impostorHit( pos, normal, color ) )
+		discard;
+	impostorDepth( pos );
+
+	// same as the fixed function lighting with color material and light #0, non local viewer
+	vec3 l = normalize( gl_LightSource[0].position.xyz - pos * gl_LightSource[0].position.w );
+	float diffuse = max( dot( normal, l ), 0.0 );
+	float specular = 0.0;
+	if ( diffuse > 0.0 )
+		specular = pow( max( dot( normal, normalize( l + vec3(0.0, 0.0, 1.0) ) ), 0.0 ), gl_FrontMaterial.shininess );
+	vec3 rgb = color.rgb * ( gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb + gl_LightSource[0].diffuse.rgb * diffuse ) +
+	           gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb * specular;
+	gl_FragColor = vec4( rgb, color.a );
+}
@@ -0,0 +1,83 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+// see vl::Molecule::setImpostorsEnabled(): ray casting of the spheres and cylinders emitted by molecule_impostor_box.glsl,
+// used by molecule_impostor.fs and molecule_impostor_pick.fs
+
+in vec3 molPosition;
+flat in vec3  molOrigin;
+flat in vec3  molAxis;
+flat in float molRadius;
+flat in vec4  molColor1;
+flat in vec4  molColor2;
+
+// Intersects the viewing ray through the current fragment with the impostor, returns false if the ray misses it.
+// 'pos' and 'normal' are in eye space.
+bool impostorHit( out vec3 pos, out vec3 normal, out vec4 color )
+{
+	// viewing ray, orthographic projections have a null perspective divide term
+	vec3 orig, dir;
+	if ( vl_ProjectionMatrix[2][3] == 0.0 )
+	{
+		orig = vec3( molPosition.xy, 0.0 );
+		dir  = vec3( 0.0, 0.0, -1.0 );
+	}
+	else
+	{
+		orig = vec3( 0.0 );
+		dir  = normalize( molPosition );
+	}
+
+	vec3 oc = orig - molOrigin;
+	float len2 = dot( molAxis, molAxis );
+	if ( len2 == 0.0 )
+	{
+		// sphere
+		float b = dot( oc, dir );
+		float c = dot( oc, oc ) - molRadius * molRadius;
+		float h = b * b - c;
+		if ( h < 0.0 )
+			return false;
+		pos    = orig + dir * ( -b - sqrt(h) );
+		normal = ( pos - molOrigin ) / molRadius;
+		color  = molColor1;
+	}
+	else
+	{
+		// cylinder without caps, its ends lie within the atoms
+		vec3 u = molAxis * inversesqrt( len2 );
+		vec3 d = dir - u * dot( dir, u );
+		vec3 o = oc - u * dot( oc, u );
+		float a = dot( d, d );
+		float b = dot( d, o );
+		float c = dot( o, o ) - molRadius * molRadius;
+		float h = b * b - a * c;
+		if ( a == 0.0 || h < 0.0 )
+			return false;
+		pos = orig + dir * ( ( -b - sqrt(h) ) / a );
+		float s = dot( pos - molOrigin, molAxis ) / len2;
+		if ( s < 0.0 || s > 1.0 )
+			return false;
+		normal = normalize( pos - molOrigin - molAxis * s );
+		color  = s < 0.5 ? molColor1 : molColor2;
+	}
+	return true;
+}
+
+// Writes the window space depth of the eye space position 'pos'.
+void impostorDepth( vec3 pos )
+{
+	vec4 clip = vl_ProjectionMatrix * vec4( pos, 1.0 );
+	gl_FragDepth = ( gl_DepthRange.diff * clip.z / clip.w + gl_DepthRange.near + gl_DepthRange.far ) * 0.5;
+}
@@ -0,0 +1,37 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::Molecule::setImpostorsEnabled(): passes the atom centers, or the bond end points, in eye space to
+// molecule_atom_impostor.gs and molecule_bond_impostor.gs
+
+#pragma VL include /glsl/std/uniforms.glsl
+
+in vec4 vl_VertexPosition;
+in vec4 vl_VertexColor;
+in vec4 vl_VertexTexCoord0; // x = radius of the atom or bond
+
+out vec3  molVertexCenter;
+out vec4  molVertexColor;
+out float molVertexRadius;
+
+void main(void)
+{
+	molVertexCenter = ( vl_ModelViewMatrix * vl_VertexPosition ).xyz;
+	molVertexColor  = vl_VertexColor;
+	// assumes a uniform scaling
+	molVertexRadius = vl_VertexTexCoord0.x * length( vl_ModelViewMatrix[0].xyz );
+	gl_Position = vl_ModelViewProjectionMatrix * vl_VertexPosition;
+}
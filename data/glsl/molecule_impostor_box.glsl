@@ -0,0 +1,49 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+// see vl::Molecule::setImpostorsEnabled(): emits the box bounding an impostor, used by molecule_atom_impostor.gs and molecule_bond_impostor.gs.
+// The box is rasterized without face culling so that the impostor is visible also when the camera is inside its box.
+
+out vec3 molPosition;       // point of the box in eye space
+flat out vec3  molOrigin;   // sphere center or first end point of the cylinder, in eye space
+flat out vec3  molAxis;     // from the first to the second end point of the cylinder, zero for spheres
+flat out float molRadius;
+flat out vec4  molColor1;   // sphere color or color of the first half of the cylinder
+flat out vec4  molColor2;   // color of the second half of the cylinder
+
+// a single strip covering the 6 faces of the box, the bits of the corner index select the -/+ side along e0, e1 and e2
+const int box_strip[14] = int[14]( 6, 7, 2, 3, 1, 7, 5, 6, 4, 2, 0, 1, 4, 5 );
+
+// Emits the box centered in 'center' with half extents 'e0', 'e1' and 'e2', all in eye space.
+void emitImpostorBox( vec3 center, vec3 e0, vec3 e1, vec3 e2, vec3 origin, vec3 axis, float radius, vec4 color1, vec4 color2 )
+{
+	for( int i=0; i<14; ++i )
+	{
+		int c = box_strip[i];
+		vec3 p = center + e0 * ( (c & 1) != 0 ? 1.0 : -1.0 )
+		                + e1 * ( (c & 2) != 0 ? 1.0 : -1.0 )
+		                + e2 * ( (c & 4) != 0 ? 1.0 : -1.0 );
+		// the outputs are undefined after EmitVertex()
+		molPosition = p;
+		molOrigin   = origin;
+		molAxis     = axis;
+		molRadius   = radius;
+		molColor1   = color1;
+		molColor2   = color2;
+		gl_PrimitiveID = gl_PrimitiveIDIn;
+		gl_Position = vl_ProjectionMatrix * vec4( p, 1.0 );
+		EmitVertex();
+	}
+	EndPrimitive();
+}
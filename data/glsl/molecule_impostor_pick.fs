@@ -0,0 +1,36 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150
+
+// see vl::Molecule::setupImpostorPicking(): renders the impostors' IDs for vl::PickingRendering
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/molecule_impostor.glsl
+
+uniform uint vl_PickID;
+
+out uvec2 vl_PickOutput;
+
+void main(void)
+{
+	vec3 pos, normal;
+	vec4 color;
+	if ( !impostorHit( pos, normal, color ) )
+		discard;
+	impostorDepth( pos );
+
+	// the primitive ID is the index of the atom or bond, see vl::Molecule::impostorAtom() and vl::Molecule::impostorBond()
+	vl_PickOutput = uvec2( vl_PickID, uint(gl_PrimitiveID) );
+}
@@ -0,0 +1,28 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 430 compatibility
+
+// see vl::ParticleSystem: soft round sprites
+
+in vec4 psColor;
+in vec2 psCorner;
+
+void main(void)
+{
+	float r2 = dot(psCorner, psCorner);
+	if (r2 > 1.0)
+		discard;
+	gl_FragColor = vec4(psColor.rgb, psColor.a * (1.0 - r2));
+}
@@ -0,0 +1,56 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 430 compatibility
+
+// see vl::ParticleSystem: one instance per particle, 4 vertices per instance drawn as a triangle strip
+
+struct Particle
+{
+	vec4 position;    // xyz = position, w = age
+	vec4 velocity;    // xyz = velocity, w = lifetime, 0 if dead
+	vec4 color_begin;
+	vec4 color_end;
+	vec4 size;        // x = begin, y = end
+};
+
+layout(std430, binding = 0) readonly buffer vl_PSParticleBuffer
+{
+	Particle vl_PSParticles[];
+};
+
+out vec4 psColor;
+out vec2 psCorner;
+
+void main(void)
+{
+	Particle p = vl_PSParticles[gl_InstanceID];
+	psCorner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+
+	// dead particles collapse to a degenerate quad
+	if (p.velocity.w <= 0.0)
+	{
+		psColor = vec4(0.0);
+		gl_Position = vec4(0.0);
+		return;
+	}
+
+	float t = clamp(p.position.w / p.velocity.w, 0.0, 1.0);
+	psColor = mix(p.color_begin, p.color_end, t);
+
+	// camera facing quad
+	vec4 eye = gl_ModelViewMatrix * vec4(p.position.xyz, 1.0);
+	eye.xy += psCorner * mix(p.size.x, p.size.y, t) * 0.5;
+	gl_Position = gl_ProjectionMatrix * eye;
+}
@@ -0,0 +1,95 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 430
+
+// see vl::ParticleSystem: spawns vl_PSCount particles from vl_PSFirst on, wrapping around the buffer
+
+layout(local_size_x = 64) in;
+
+struct Particle
+{
+	vec4 position;    // xyz = position, w = age
+	vec4 velocity;    // xyz = velocity, w = lifetime, 0 if dead
+	vec4 color_begin;
+	vec4 color_end;
+	vec4 size;        // x = begin, y = end
+};
+
+layout(std430, binding = 0) buffer vl_PSParticleBuffer
+{
+	Particle vl_PSParticles[];
+};
+
+uniform uint  vl_PSCapacity;
+uniform uint  vl_PSFirst;
+uniform uint  vl_PSCount;
+uniform uint  vl_PSSeed;
+uniform int   vl_PSShape;
+uniform vec3  vl_PSPosition;
+uniform vec3  vl_PSExtent;
+uniform vec3  vl_PSVelocity;
+uniform float vl_PSVelocitySpread;
+uniform vec2  vl_PSLifetime;
+uniform vec2  vl_PSSize;
+uniform vec4  vl_PSColorBegin;
+uniform vec4  vl_PSColorEnd;
+
+uint hash(uint x)
+{
+	x ^= x >> 16; x *= 0x7feb352du;
+	x ^= x >> 15; x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+float random(inout uint state)
+{
+	state = hash(state);
+	return float(state) / 4294967295.0;
+}
+
+// uniformly distributed in the unit sphere
+vec3 randomInSphere(inout uint state)
+{
+	float z   = random(state) * 2.0 - 1.0;
+	float phi = random(state) * 6.28318530718;
+	float r   = pow(random(state), 1.0 / 3.0);
+	float s   = sqrt(max(0.0, 1.0 - z * z));
+	return r * vec3(s * cos(phi), s * sin(phi), z);
+}
+
+void main(void)
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= vl_PSCount)
+		return;
+
+	uint state = hash(i ^ hash(vl_PSSeed));
+
+	vec3 offset = vec3(0.0);
+	if (vl_PSShape == 1) // PES_Box
+		offset = (vec3(random(state), random(state), random(state)) * 2.0 - 1.0) * vl_PSExtent;
+	else
+	if (vl_PSShape == 2) // PES_Sphere
+		offset = randomInSphere(state) * vl_PSExtent.x;
+
+	Particle p;
+	p.position    = vec4(vl_PSPosition + offset, 0.0);
+	p.velocity    = vec4(vl_PSVelocity + randomInSphere(state) * vl_PSVelocitySpread, mix(vl_PSLifetime.x, vl_PSLifetime.y, random(state)));
+	p.color_begin = vl_PSColorBegin;
+	p.color_end   = vl_PSColorEnd;
+	p.size        = vec4(vl_PSSize, 0.0, 0.0);
+	vl_PSParticles[(vl_PSFirst + i) % vl_PSCapacity] = p;
+}
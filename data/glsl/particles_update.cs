@@ -0,0 +1,64 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 430
+
+// see vl::ParticleSystem: ages and moves all the particles by vl_PSTimeStep seconds
+
+layout(local_size_x = 64) in;
+
+struct Particle
+{
+	vec4 position;    // xyz = position, w = age
+	vec4 velocity;    // xyz = velocity, w = lifetime, 0 if dead
+	vec4 color_begin;
+	vec4 color_end;
+	vec4 size;        // x = begin, y = end
+};
+
+layout(std430, binding = 0) buffer vl_PSParticleBuffer
+{
+	Particle vl_PSParticles[];
+};
+
+uniform uint  vl_PSCapacity;
+uniform float vl_PSTimeStep;
+uniform vec3  vl_PSGravity;
+uniform float vl_PSDamping;
+
+void main(void)
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= vl_PSCapacity)
+		return;
+
+	vec4 position = vl_PSParticles[i].position;
+	vec4 velocity = vl_PSParticles[i].velocity;
+	if (velocity.w <= 0.0)
+		return;
+
+	position.w += vl_PSTimeStep;
+	if (position.w >= velocity.w)
+	{
+		vl_PSParticles[i].velocity.w = 0.0;
+		return;
+	}
+
+	velocity.xyz += vl_PSGravity * vl_PSTimeStep;
+	velocity.xyz *= max(0.0, 1.0 - vl_PSDamping * vl_PSTimeStep);
+	position.xyz += velocity.xyz * vl_PSTimeStep;
+
+	vl_PSParticles[i].position = position;
+	vl_PSParticles[i].velocity = velocity;
+}
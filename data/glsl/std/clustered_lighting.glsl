@@ -0,0 +1,84 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2011, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+// Clustered forward lighting, see vl::ClusteredLightManager.
+// Requires GLSL 1.40, include it in the fragment shader after the #version directive.
+
+// <automatic>
+uniform samplerBuffer  vl_ClusterLights;   // 2 texels per light: view-space position & radius, color
+uniform usamplerBuffer vl_ClusterRanges;   // 1 texel per cluster: offset in vl_ClusterIndices, light count
+uniform usamplerBuffer vl_ClusterIndices;  // light indices
+uniform ivec3 vl_ClusterGrid;              // tiles along x and y, depth slices
+uniform vec2  vl_ClusterDepth;             // near plane, slices / log(far/near)
+uniform vec4  vl_ClusterViewport;          // x, y, width, height
+// </automatic>
+
+// Index of the cluster containing the fragment whose view-space position is 'view_pos'.
+int vl_clusterIndex(vec3 view_pos)
+{
+  ivec2 tile = ivec2( (gl_FragCoord.xy - vl_ClusterViewport.xy) / vl_ClusterViewport.zw * vec2(vl_ClusterGrid.xy) );
+  tile = clamp( tile, ivec2(0), vl_ClusterGrid.xy - 1 );
+  int slice = int( log( max(-view_pos.z, vl_ClusterDepth.x) / vl_ClusterDepth.x ) * vl_ClusterDepth.y );
+  slice = clamp( slice, 0, vl_ClusterGrid.z - 1 );
+  return (slice * vl_ClusterGrid.y + tile.y) * vl_ClusterGrid.x + tile.x;
+}
+
+// First entry in the light index list and light count of the fragment's cluster.
+uvec2 vl_clusterLightRange(vec3 view_pos)
+{
+  return texelFetch( vl_ClusterRanges, vl_clusterIndex(view_pos) ).xy;
+}
+
+// The i-th entry of the light index list.
+int vl_clusterLight(uint i)
+{
+  return int( texelFetch( vl_ClusterIndices, int(i) ).x );
+}
+
+// View-space position and radius of a light.
+vec4 vl_clusterLightPositionRadius(int light)
+{
+  return texelFetch( vl_ClusterLights, light * 2 + 0 );
+}
+
+// Color of a light, premultiplied by its intensity.
+vec3 vl_clusterLightColor(int light)
+{
+  return texelFetch( vl_ClusterLights, light * 2 + 1 ).rgb;
+}
+
+// Smooth inverse square falloff reaching zero at the light radius.
+float vl_clusterLightFalloff(float dist, float radius)
+{
+  float x = dist / radius;
+  float window = clamp( 1.0 - x*x*x*x, 0.0, 1.0 );
+  return window * window / ( dist * dist + 1.0 );
+}
+
+// Diffuse contribution of the lights affecting the fragment.
+vec3 vl_clusteredDiffuse(vec3 view_pos, vec3 view_normal)
+{
+  vec3 diffuse = vec3(0.0);
+  uvec2 range = vl_clusterLightRange(view_pos);
+  for(uint i=range.x; i<range.x+range.y; ++i)
+  {
+    int light = vl_clusterLight(i);
+    vec4 pos_radius = vl_clusterLightPositionRadius(light);
+    vec3 L = pos_radius.xyz - view_pos;
+    float dist = length(L);
+    float NdotL = max( dot(view_normal, L / max(dist, 1e-6)), 0.0 );
+    diffuse += vl_clusterLightColor(light) * NdotL * vl_clusterLightFalloff(dist, pos_radius.w);
+  }
+  return diffuse;
+}
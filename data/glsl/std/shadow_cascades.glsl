@@ -0,0 +1,51 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2011, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+// Cascaded shadow maps, see vl::CascadedShadowMap.
+// Requires GLSL 1.50, include it in the fragment shader after the #version directive.
+
+// <automatic>
+uniform sampler2DArrayShadow vl_ShadowMap;  // one depth layer per cascade
+uniform mat4  vl_ShadowMatrix[8];           // world coordinates to shadow map coordinates, per cascade
+uniform float vl_ShadowSplits[8];           // view-space distance at which each cascade ends
+uniform int   vl_ShadowCascadeCount;
+// </automatic>
+
+// Cascade covering the given view-space distance, -1 if beyond the last one.
+int vl_shadowCascade(float view_depth)
+{
+  for(int i=0; i<vl_ShadowCascadeCount; ++i)
+  {
+    if (view_depth <= vl_ShadowSplits[i])
+      return i;
+  }
+  return -1;
+}
+
+// Fraction of light reaching 'world_pos', 0 = in shadow, 1 = lit. 'view_depth' is the positive view-space distance
+// of the fragment, i.e. -view_pos.z. Filtered with 4 hardware PCF taps.
+float vl_shadowFactor(vec3 world_pos, float view_depth)
+{
+  int cascade = vl_shadowCascade(view_depth);
+  if (cascade < 0)
+    return 1.0;
+  vec4 coord = vl_ShadowMatrix[cascade] * vec4(world_pos, 1.0);
+  vec2 texel = 1.0 / vec2( textureSize(vl_ShadowMap, 0).xy );
+  float lit = 0.0;
+  lit += texture( vl_ShadowMap, vec4(coord.xy + vec2(-0.5,-0.5) * texel, float(cascade), coord.z) );
+  lit += texture( vl_ShadowMap, vec4(coord.xy + vec2(+0.5,-0.5) * texel, float(cascade), coord.z) );
+  lit += texture( vl_ShadowMap, vec4(coord.xy + vec2(-0.5,+0.5) * texel, float(cascade), coord.z) );
+  lit += texture( vl_ShadowMap, vec4(coord.xy + vec2(+0.5,+0.5) * texel, float(cascade), coord.z) );
+  return lit * 0.25;
+}
@@ -0,0 +1,65 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+// GPU matrix palette skinning, see vl::SkinningPalette.
+// Requires GLSL 1.40, include it in the vertex shader after the #version directive.
+
+// <automatic>
+uniform samplerBuffer vl_SkinningPalette; // 3 texels per joint: the rows of the 3x4 skinning matrix
+uniform int vl_SkinningOffset;            // first texel of the Actor's skeleton
+// </automatic>
+
+in uvec4 vl_VertexJointIndices; // bound to VA_JointIndices
+in vec4  vl_VertexJointWeights; // bound to VA_JointWeights
+
+// The rows of the skinning matrix of the vertex: the weighted sum of the matrices of its joints.
+void vl_skinningRows(out vec4 r0, out vec4 r1, out vec4 r2)
+{
+  r0 = vec4(0.0); r1 = vec4(0.0); r2 = vec4(0.0);
+  for(int i=0; i<4; ++i)
+  {
+    float w = vl_VertexJointWeights[i];
+    if (w != 0.0)
+    {
+      int t = vl_SkinningOffset + 3 * int(vl_VertexJointIndices[i]);
+      r0 += w * texelFetch(vl_SkinningPalette, t+0);
+      r1 += w * texelFetch(vl_SkinningPalette, t+1);
+      r2 += w * texelFetch(vl_SkinningPalette, t+2);
+    }
+  }
+}
+
+// The skinning matrix of the vertex.
+mat4 vl_skinningMatrix()
+{
+  vec4 r0, r1, r2;
+  vl_skinningRows(r0, r1, r2);
+  return transpose( mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)) );
+}
+
+// Skinned position of 'pos'.
+vec4 vl_skinPosition(vec4 pos)
+{
+  vec4 r0, r1, r2;
+  vl_skinningRows(r0, r1, r2);
+  return vec4( dot(r0, pos), dot(r1, pos), dot(r2, pos), pos.w );
+}
+
+// Skinned position and normal.
+void vl_skin(inout vec4 pos, inout vec3 normal)
+{
+  vec4 r0, r1, r2;
+  vl_skinningRows(r0, r1, r2);
+  pos    = vec4( dot(r0, pos), dot(r1, pos), dot(r2, pos), pos.w );
+  normal = vec3( dot(r0.xyz, normal), dot(r1.xyz, normal), dot(r2.xyz, normal) );
+}
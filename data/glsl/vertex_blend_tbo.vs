@@ -0,0 +1,51 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+#version 150 compatibility
+
+#pragma VL include /glsl/std/uniforms.glsl
+#pragma VL include /glsl/std/vertex_attribs.glsl
+
+// all the frames packed by MorphingCallback::createFramesTexture(): position and normal of each vertex
+uniform samplerBuffer vl_MorphFrames;
+// texel offset of the current and next frame
+uniform int   vl_MorphFrame1;
+uniform int   vl_MorphFrame2;
+uniform float anim_t;
+
+void main(void)
+{
+	int v = gl_VertexID * 2;
+	vec4 P = mix(texelFetch(vl_MorphFrames, vl_MorphFrame1 + v),     texelFetch(vl_MorphFrames, vl_MorphFrame2 + v),     anim_t);
+	vec3 n = mix(texelFetch(vl_MorphFrames, vl_MorphFrame1 + v + 1), texelFetch(vl_MorphFrames, vl_MorphFrame2 + v + 1), anim_t).xyz;
+
+	gl_Position = vl_ModelViewProjectionMatrix * P;
+	vec3 N = normalize(vl_NormalMatrix * n);
+
+	vec3 V = (vl_ModelViewMatrix * P).xyz;
+	vec3 L = normalize(gl_LightSource[0].position.xyz - V.xyz);
+	vec3 H = normalize(L + vec3(0.0,0.0,1.0));
+
+	// compute diffuse equation
+	float NdotL = dot(N,L);
+	vec4 diffuse = gl_Color * vec4(max(0.0,NdotL));
+
+	float NdotH = max(0.0, dot(N,H));
+	vec4 specular = vec4(0.0);
+	const float specularExp = 128.0;
+	if (NdotL > 0.0)
+	  specular = vec4(pow(NdotH, specularExp));
+
+	gl_FrontColor = diffuse + specular;
+	gl_TexCoord[0] = vl_VertexTexCoord0;
+}
@@ -0,0 +1,49 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+
+
+/* virtual texture lookup, see vl::VirtualTexture::setupShader(), requires #version 130 or later */
+
+uniform sampler2D vl_VTCache;     // vl::VirtualTexture::cacheTexture()
+uniform sampler2D vl_VTPageTable; // vl::VirtualTexture::pageTableTexture()
+uniform vec4 vl_VTParams;         // tiles per side of level 0, tile size, tile border, coarsest level
+
+// Returns the level of the tile pyramid to be sampled at the texture coordinate 'uv', must match vl::VirtualTextureFeedback.
+int virtualTextureLevel( vec2 uv )
+{
+  vec2 t = uv * vl_VTParams.x * vl_VTParams.y;
+  vec2 dx = dFdx( t ), dy = dFdy( t );
+  float lod = 0.5 * log2( max( max( dot( dx, dx ), dot( dy, dy ) ), 1.0e-20 ) );
+  return int( clamp( floor( lod ), 0.0, vl_VTParams.w ) );
+}
+
+// Samples the virtual texture at the texture coordinate 'uv', using the finest resident tile if the needed one is not available.
+vec4 virtualTexture( vec2 uv )
+{
+  int level = virtualTextureLevel( uv );
+  uv = clamp( uv, 0.0, 1.0 );
+
+  int pages = int( vl_VTParams.x ) >> level;
+  ivec2 page = min( ivec2( uv * float( pages ) ), ivec2( pages - 1 ) );
+  vec3 entry = floor( texelFetch( vl_VTPageTable, page, level ).xyz * 255.0 + 0.5 );
+
+  // position within the resident tile, which might belong to a coarser level
+  float tiles = vl_VTParams.x / exp2( entry.z );
+  vec2 in_tile = clamp( uv * tiles - floor( min( uv * tiles, vec2( tiles - 1.0 ) ) ), 0.0, 1.0 );
+
+  float slot_side = vl_VTParams.y + 2.0 * vl_VTParams.z;
+  vec2 texel = entry.xy * slot_side + vl_VTParams.z + in_tile * vl_VTParams.y;
+  return textureLod( vl_VTCache, texel / vec2( textureSize( vl_VTCache, 0 ) ), 0.0 );
+}
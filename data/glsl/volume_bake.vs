@@ -0,0 +1,23 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUVolumeBaker: one triangle covering the whole viewport is drawn for each slice of the volume
+
+void main(void)
+{
+	vec2 p = vec2( float((gl_VertexID << 1) & 2), float(gl_VertexID & 2) );
+	gl_Position = vec4( p * 2.0 - 1.0, 0.0, 1.0 );
+}
@@ -0,0 +1,32 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUVolumeBaker::sampleFunction(): writes the function defined by the user shader at each sample of the grid
+
+uniform int  vl_VBSlice;
+uniform vec3 vl_VBMinCorner;
+uniform vec3 vl_VBMaxCorner;
+uniform vec3 vl_VBSize;
+
+// defined by the user shader linked with this one
+float vl_VBFunction(vec3 p);
+
+void main(void)
+{
+	// the first and the last samples lie on the corners, as in vl::VolumePlot::evaluateFunction()
+	vec3 t = vec3( ivec3( ivec2(gl_FragCoord.xy), vl_VBSlice ) ) / max( vl_VBSize - 1.0, vec3(1.0) );
+	gl_FragColor = vec4( vl_VBFunction( mix( vl_VBMinCorner, vl_VBMaxCorner, t ) ) );
+}
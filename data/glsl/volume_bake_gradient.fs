@@ -0,0 +1,39 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUVolumeBaker::genGradientNormals(), same as vl::genGradientNormals()
+
+uniform sampler3D vl_VBVolume;
+uniform int       vl_VBSlice;
+
+float sampleVolume(ivec3 p)
+{
+	return texelFetch( vl_VBVolume, clamp( p, ivec3(0), textureSize(vl_VBVolume, 0) - 1 ), 0 ).r;
+}
+
+void main(void)
+{
+	ivec3 p = ivec3( ivec2(gl_FragCoord.xy), vl_VBSlice );
+	vec3 N = vec3( sampleVolume(p - ivec3(1,0,0)) - sampleVolume(p + ivec3(1,0,0)),
+	               sampleVolume(p - ivec3(0,1,0)) - sampleVolume(p + ivec3(0,1,0)),
+	               sampleVolume(p - ivec3(0,0,1)) - sampleVolume(p + ivec3(0,0,1)) );
+	float len = length(N);
+	if ( len > 0.0 )
+		N /= len;
+
+	// write normal packed into 0..1 format
+	gl_FragColor = vec4( N * 0.5 + 0.5, 1.0 );
+}
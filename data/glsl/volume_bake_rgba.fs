@@ -0,0 +1,62 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::GPUVolumeBaker::genRGBAVolume(), same as vl::genRGBAVolume()
+
+uniform sampler3D vl_VBVolume;
+uniform sampler1D vl_VBTrFunc;
+uniform int       vl_VBSlice;
+uniform bool      vl_VBLighting;
+uniform vec3      vl_VBLightDir; // normalized
+uniform bool      vl_VBAlphaFromData;
+
+float sampleVolume(ivec3 p)
+{
+	return texelFetch( vl_VBVolume, clamp( p, ivec3(0), textureSize(vl_VBVolume, 0) - 1 ), 0 ).r;
+}
+
+void main(void)
+{
+	ivec3 p = ivec3( ivec2(gl_FragCoord.xy), vl_VBSlice );
+	float lum = sampleVolume(p);
+
+	// value -> transfer function
+	float width = float( textureSize(vl_VBTrFunc, 0) );
+	float xval = clamp( lum * width, 0.0, width - 1.001 );
+	int ix1 = int(xval);
+	vec4 rgba = mix( texelFetch(vl_VBTrFunc, ix1, 0), texelFetch(vl_VBTrFunc, ix1 + 1, 0), fract(xval) );
+
+	// bake the lighting
+	if ( vl_VBLighting )
+	{
+		vec3 N1 = vec3( sampleVolume(p - ivec3(1,0,0)) - sampleVolume(p + ivec3(1,0,0)),
+		                sampleVolume(p - ivec3(0,1,0)) - sampleVolume(p + ivec3(0,1,0)),
+		                sampleVolume(p - ivec3(0,0,1)) - sampleVolume(p + ivec3(0,0,1)) );
+		float len = length(N1);
+		if ( len > 0.0 )
+			N1 /= len;
+		vec3 N2 = -N1 * 0.15;
+		float l1 = max( dot(N1, vl_VBLightDir), 0.0 );
+		float l2 = max( dot(N2, vl_VBLightDir), 0.0 ); // opposite dim light to enhance 3D perception
+		rgba.rgb = clamp( rgba.rgb * l1 + rgba.rgb * l2 + 0.2, 0.0, 1.0 ); // +0.2 = ambient light
+	}
+
+	if ( vl_VBAlphaFromData )
+		rgba.a = lum;
+
+	// truncated like vl::genRGBAVolume() does
+	gl_FragColor = floor( clamp(rgba, 0.0, 1.0) * 255.0 ) / 255.0;
+}
@@ -0,0 +1,98 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+/* raycast direct volume rendering of a vl::BrickedVolume, front to back compositing of the transfer function colors */
+
+#version 330 core
+
+in vec3 frag_position; // in object space
+in vec4 tex_coord;
+out vec4 frag_output;  // fragment shader output
+
+uniform sampler3D atlas_texunit;     // vl::BrickedVolume::atlasTexture()
+uniform sampler3D page_texunit;      // vl::BrickedVolume::pageTableTexture()
+uniform sampler1D trfunc_texunit;
+uniform vec3 eye_position;           // camera position in object space
+uniform float sample_step;           // step used to advance the sampling ray at full resolution
+uniform float val_threshold;         // scales the opacity of the transfer function
+uniform float early_termination;     // accumulated opacity at which the ray stops, 0 = never
+uniform vec3 volume_size;            // size in samples of the full resolution volume
+uniform int brick_size;              // samples per brick side
+
+// Samples the volume at the texture coordinate 'pos' from the brick selected by the page table,
+// returns -1 if no brick is available, 'level_scale' receives the sample spacing of the brick.
+float sampleVolume( vec3 pos, out float level_scale )
+{
+  vec3 vox = pos * volume_size;
+  ivec3 page = clamp( ivec3( vox / float( brick_size ) ), ivec3( 0 ), textureSize( page_texunit, 0 ) - 1 );
+  vec4 entry = texelFetch( page_texunit, page, 0 ) * 255.0;
+  level_scale = 1.0;
+  if ( entry.a < 0.5 ) {
+    return -1.0;
+  }
+
+  int level = int( entry.a + 0.5 ) - 1;
+  level_scale = exp2( float( level ) );
+
+  // position inside the brick in samples of its level, skipping the apron
+  vec3 brick_origin = vec3( page >> level ) * float( brick_size );
+  vec3 local = vox / level_scale - brick_origin + 1.0;
+  vec3 slot_origin = floor( entry.rgb + 0.5 ) * float( brick_size + 2 );
+  return texture( atlas_texunit, ( slot_origin + local ) / vec3( textureSize( atlas_texunit, 0 ) ) ).r;
+}
+
+void main(void)
+{
+  vec3 ray_dir = normalize( frag_position - eye_position );
+  vec3 ray_pos = tex_coord.xyz; // the current ray position
+  vec3 pos111 = vec3( 1.0, 1.0, 1.0 );
+  vec3 pos000 = vec3( 0.0, 0.0, 0.0 );
+
+  vec4 color = vec4( 0.0 );
+  do
+  {
+    float level_scale;
+    float val = sampleVolume( ray_pos, level_scale );
+    if ( val >= 0.0 )
+    {
+      vec4 rgba = texture( trfunc_texunit, val );
+      // coarser bricks are sampled with proportionally longer steps, the opacity is corrected accordingly
+      float alpha = 1.0 - pow( 1.0 - clamp( rgba.a * val_threshold, 0.0, 1.0 ), level_scale );
+      color.rgb += ( 1.0 - color.a ) * alpha * rgba.rgb;
+      color.a   += ( 1.0 - color.a ) * alpha;
+
+      // early ray termination
+      if ( early_termination > 0.0 && color.a >= early_termination ) {
+        break;
+      }
+    }
+
+    ray_pos += ray_dir * sample_step * level_scale;
+
+    // Leave if end of cube
+    if ( any( greaterThan( ray_pos, pos111 ) ) || any( lessThan( ray_pos, pos000 ) ) ) {
+      break;
+    }
+  }
+  while(true);
+
+  if ( color.a == 0.0 ) {
+    discard;
+  }
+
+  // un-premultiply for the standard alpha blending
+  frag_output = vec4( color.rgb / color.a, color.a );
+}
+
+// Have fun!
@@ -0,0 +1,50 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+/* empty space skipping helpers for the raycast shaders, see vl::RaycastVolume::setEmptySpaceSkippingEnabled() */
+
+/* requires "uniform sampler3D volume_texunit" to be declared before the include */
+
+uniform bool empty_space_skipping; // whether the brick image should be used to skip empty space
+uniform int brick_size;            // the brick size used by vl::genMinMaxBricks() or vl::genOccupancyBricks()
+
+// Returns the brick containing the texture coordinate 'pos', 'brick_count' is the size of the brick image.
+ivec3 brickCoord( vec3 pos, ivec3 brick_count )
+{
+  vec3 vol_size = vec3( textureSize( volume_texunit, 0 ) );
+  ivec3 brick = ivec3( floor( ( pos * vol_size - 0.5 ) / float( brick_size ) ) );
+  return clamp( brick, ivec3( 0 ), brick_count - 1 );
+}
+
+// Returns the number of whole steps the ray can advance from 'pos' without leaving 'brick'.
+float brickSteps( vec3 pos, vec3 ray_step, ivec3 brick )
+{
+  // brick bounds in texture coordinates, bricks share their boundary samples
+  vec3 vol_size = vec3( textureSize( volume_texunit, 0 ) );
+  vec3 bmin = ( vec3( brick ) * float( brick_size ) + 0.5 ) / vol_size;
+  vec3 bmax = ( vec3( brick + 1 ) * float( brick_size ) + 0.5 ) / vol_size;
+  vec3 bound = mix( bmin, bmax, greaterThan( ray_step, vec3( 0.0 ) ) );
+
+  // distance in steps to the brick faces the ray is moving towards
+  vec3 t = vec3( 1.0e10 );
+  for( int i = 0; i < 3; ++i )
+  {
+    if ( abs( ray_step[i] ) > 1.0e-10 ) {
+      t[i] = ( bound[i] - pos[i] ) / ray_step[i];
+    }
+  }
+
+  // stop one step short of the exit point so that the next sample still falls inside the brick
+  return max( 0.0, ceil( min( t.x, min( t.y, t.z ) ) ) - 1.0 );
+}
@@ -38,8 +38,11 @@ uniform float sample_step;          // step used to advance the sampling ray: a
 uniform float val_threshold;
 uniform bool precomputed_gradient;  // whether the gradient has been precomputed or not
 uniform vec3 gradient_delta;        // for on-the-fly gradient computation: a good value is `1/4 / <tex-dim>`.
+uniform sampler3D minmax_texunit;  // per brick min/max values generated by vl::genMinMaxBricks()
 uniform vec3 texel_centering;       // normalized x/y/z offeset required to center on a texel
 
+#pragma VL include /glsl/volume_raycast_bricks.glsl
+
 // Computes a simplified lighting equation
 vec3 blinn( vec3 N, vec3 V, vec3 L, int light, vec3 diffuse )
 {
@@ -124,8 +127,19 @@ void main()
 
   float val = texture( volume_texunit, tex_coord.xyz ).r;
   bool prev_sign = val > val_threshold;
+  ivec3 brick_count = textureSize( minmax_texunit, 0 );
   do
   {
+    // the isosurface cannot cross a brick whose value range does not contain val_threshold
+    if ( empty_space_skipping )
+    {
+      ivec3 brick = brickCoord( ray_pos, brick_count );
+      vec2 range = texelFetch( minmax_texunit, brick, 0 ).rg;
+      if ( val_threshold < range.x || val_threshold > range.y ) {
+        ray_pos += ray_step * brickSteps( ray_pos, ray_step, brick );
+      }
+    }
+
     ray_pos += ray_step;
 
     // Leave if end of cube
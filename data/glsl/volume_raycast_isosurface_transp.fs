@@ -38,7 +38,11 @@ uniform float sample_step;         // step used to advance the sampling ray: a g
 uniform float val_threshold;
 uniform bool precomputed_gradient; // whether the gradient has been precomputed or not
 uniform vec3 gradient_delta;       // for on-the-fly gradient computation: a good value is `1/4 / <tex-dim>`.
+uniform sampler3D minmax_texunit;  // per brick min/max values generated by vl::genMinMaxBricks()
 uniform vec3 texel_centering;      // normalized x/y/z offeset required to center on a texel
+uniform float early_termination;   // accumulated opacity at which the ray stops, 0 = never
+
+#pragma VL include /glsl/volume_raycast_bricks.glsl
 
 // Computes a simplified lighting equation
 vec3 blinn( vec3 N, vec3 V, vec3 L, int light, vec3 diffuse )
@@ -129,8 +133,19 @@ void main(void)
   bool isosurface_found = false;
   float transmittance = 1.0;
   frag_output.rgb = vec3( 0.0 );
+  ivec3 brick_count = textureSize( minmax_texunit, 0 );
   do
   {
+    // the isosurface cannot cross a brick whose value range does not contain val_threshold
+    if ( empty_space_skipping )
+    {
+      ivec3 brick = brickCoord( ray_pos, brick_count );
+      vec2 range = texelFetch( minmax_texunit, brick, 0 ).rg;
+      if ( val_threshold < range.x || val_threshold > range.y ) {
+        ray_pos += ray_step * brickSteps( ray_pos, ray_step, brick );
+      }
+    }
+
     ray_pos += ray_step;
 
     // Leave if end of cube
@@ -150,8 +165,8 @@ void main(void)
       transmittance *= ( 1.0 - alpha );
       frag_output.a = ( 1.0 - transmittance );
       isosurface_found = true;
-      if ( frag_output.a > 0.996 ) {
-                break;
+      if ( early_termination > 0.0 && frag_output.a > early_termination ) {
+        break;
       }
     }
   }
@@ -24,6 +24,9 @@ uniform sampler1D trfunc_texunit;
 uniform vec3 eye_position;      // camera position in object space
 uniform float sample_step;      // step used to advance the sampling ray
 uniform float val_threshold;
+uniform sampler3D minmax_texunit; // per brick min/max values generated by vl::genMinMaxBricks()
+
+#pragma VL include /glsl/volume_raycast_bricks.glsl
 
 void main(void)
 {
@@ -34,8 +37,19 @@ void main(void)
 
   float max_val = 0.0;
   vec3 prev_pos = ray_pos;
+  vec3 ray_step = ray_dir * sample_step;
+  ivec3 brick_count = textureSize( minmax_texunit, 0 );
   do
   {
+    // bricks whose maximum does not exceed the current maximum cannot change the result
+    if ( empty_space_skipping )
+    {
+      ivec3 brick = brickCoord( ray_pos, brick_count );
+      if ( texelFetch( minmax_texunit, brick, 0 ).g <= max_val ) {
+        ray_pos += ray_step * brickSteps( ray_pos, ray_step, brick );
+      }
+    }
+
     // note:
     // - ray_dir * sample_step can be precomputed
     // - we assume the volume has a cube-like shape
@@ -51,6 +65,10 @@ void main(void)
       break;
 
     max_val = max(max_val, texture(volume_texunit, ray_pos).r);
+
+    // nothing can exceed the maximum value
+    if (max_val >= 1.0)
+      break;
   }
   while(true);
 
@@ -0,0 +1,89 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+/* raycast direct volume rendering with a pre-integrated transfer function, front to back compositing of the ray segments */
+
+#version 330 core
+
+in vec3 frag_position; // in object space
+in vec4 tex_coord;
+out vec4 frag_output;  // fragment shader output
+
+uniform sampler3D volume_texunit;
+uniform sampler2D preint_texunit;    // pre-integration table generated by vl::genPreIntegrationTable()
+uniform sampler3D occupancy_texunit; // per brick occupancy generated by vl::genOccupancyBricks()
+uniform vec3 eye_position;           // camera position in object space
+uniform float sample_step;           // step used to advance the sampling ray, must match the step ratio of the pre-integration table
+uniform float val_threshold;         // scales the opacity of the transfer function
+uniform vec3 texel_centering;        // normalized x/y/z offeset required to center on a texel
+uniform float early_termination;     // accumulated opacity at which the ray stops, 0 = never
+
+#pragma VL include /glsl/volume_raycast_bricks.glsl
+
+void main(void)
+{
+  vec3 ray_dir = normalize( frag_position - eye_position );
+  vec3 ray_step = ray_dir * sample_step;
+  vec3 ray_pos = tex_coord.xyz; // the current ray position
+  vec3 pos111 = vec3( 1.0, 1.0, 1.0 ) - texel_centering;
+  vec3 pos000 = vec3( 0.0, 0.0, 0.0 ) + texel_centering;
+
+  ivec3 brick_count = textureSize( occupancy_texunit, 0 );
+  float front_val = texture( volume_texunit, ray_pos ).r; // value at the beginning of the current segment
+  vec4 color = vec4( 0.0 );
+  do
+  {
+    // skip the bricks whose values are all mapped to zero opacity, every segment inside them is transparent
+    if ( empty_space_skipping )
+    {
+      ivec3 brick = brickCoord( ray_pos, brick_count );
+      if ( texelFetch( occupancy_texunit, brick, 0 ).r < 0.5 ) {
+        ray_pos += ray_step * brickSteps( ray_pos, ray_step, brick );
+        front_val = texture( volume_texunit, ray_pos ).r;
+      }
+    }
+
+    ray_pos += ray_step;
+
+    // Leave if end of cube
+    if ( any( greaterThan( ray_pos, pos111 ) ) || any( lessThan( ray_pos, pos000 ) ) ) {
+      break;
+    }
+
+    // color and opacity of the whole segment, the color is premultiplied
+    float back_val = texture( volume_texunit, ray_pos ).r;
+    vec4 rgba = texture( preint_texunit, vec2( front_val, back_val ) ) * clamp( val_threshold, 0.0, 1.0 );
+    front_val = back_val;
+    if ( rgba.a > 0.0 )
+    {
+      color.rgb += ( 1.0 - color.a ) * rgba.rgb;
+      color.a   += ( 1.0 - color.a ) * rgba.a;
+
+      // early ray termination
+      if ( early_termination > 0.0 && color.a >= early_termination ) {
+        break;
+      }
+    }
+  }
+  while(true);
+
+  if ( color.a == 0.0 ) {
+    discard;
+  }
+
+  // un-premultiply for the standard alpha blending
+  frag_output = vec4( color.rgb / color.a, color.a );
+}
+
+// Have fun!
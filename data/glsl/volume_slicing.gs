@@ -0,0 +1,105 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::SlicedVolume::setGPUSlicingEnabled(): intersects the box of the volume with the view aligned plane of a slice,
+// the slices are placed like vl::SlicedVolume does on the CPU and are generated back to front.
+
+layout(points) in;
+layout(triangle_strip, max_vertices = 6) out;
+
+#pragma VL include /glsl/std/uniforms.glsl
+
+uniform vec3 vl_SVCorners[8];   // box corners in object space
+uniform vec3 vl_SVTexCoords[8]; // 3D texture coordinates of the box corners
+uniform int  vl_SVSliceCount;
+
+flat in int svSlice[];
+
+out vec3 frag_position; // in object space
+out vec4 tex_coord;
+
+// same edges of vl::SlicedVolume
+const ivec2 edges[12] = ivec2[12](
+	ivec2(0,1), ivec2(1,2), ivec2(2,3), ivec2(3,0),
+	ivec2(4,5), ivec2(5,6), ivec2(6,7), ivec2(7,4),
+	ivec2(1,5), ivec2(2,6), ivec2(3,7), ivec2(0,4) );
+
+void main(void)
+{
+	// corners in eye space, the slices are spaced evenly from the farthest to the nearest corner
+	vec3 eye[8];
+	int min_idx = 0;
+	int max_idx = 0;
+	for( int i=0; i<8; ++i )
+	{
+		eye[i] = ( vl_ModelViewMatrix * vec4(vl_SVCorners[i], 1.0) ).xyz;
+		if ( abs(eye[i].z) < abs(eye[min_idx].z) ) min_idx = i;
+		if ( abs(eye[i].z) > abs(eye[max_idx].z) ) max_idx = i;
+	}
+	float zstep = ( eye[max_idx].z - eye[min_idx].z ) / float(vl_SVSliceCount + 1);
+	float z = eye[max_idx].z - zstep * float(svSlice[0] + 1);
+
+	// intersections of the plane with the edges of the box
+	vec3 pos[6];
+	vec3 tex[6];
+	vec2 xy[6];
+	float angle[6];
+	int count = 0;
+	for( int i=0; i<12 && count<6; ++i )
+	{
+		float d0 = eye[ edges[i].x ].z - z;
+		float d1 = eye[ edges[i].y ].z - z;
+		if ( d0 == d1 || d0 * d1 > 0.0 )
+			continue;
+		float lambda = d0 / ( d0 - d1 );
+		pos[count] = mix( vl_SVCorners [ edges[i].x ], vl_SVCorners [ edges[i].y ], lambda );
+		tex[count] = mix( vl_SVTexCoords[ edges[i].x ], vl_SVTexCoords[ edges[i].y ], lambda );
+		xy[count]  = mix( eye[ edges[i].x ].xy, eye[ edges[i].y ].xy, lambda );
+		++count;
+	}
+	if ( count < 3 )
+		return;
+
+	// sort the vertices of the convex polygon by angle around its center
+	vec2 center = vec2(0.0);
+	for( int i=0; i<count; ++i )
+		center += xy[i];
+	center /= float(count);
+	for( int i=0; i<count; ++i )
+		angle[i] = atan( xy[i].y - center.y, xy[i].x - center.x );
+	for( int i=0; i<count-1; ++i )
+	{
+		int k = i;
+		for( int j=i+1; j<count; ++j )
+			if ( angle[j] < angle[k] )
+				k = j;
+		vec3 p = pos[i]; pos[i] = pos[k]; pos[k] = p;
+		vec3 t = tex[i]; tex[i] = tex[k]; tex[k] = t;
+		float a = angle[i]; angle[i] = angle[k]; angle[k] = a;
+	}
+
+	// emit the polygon as a strip zig-zagging between its two sides: 0, 1, n-1, 2, n-2...
+	for( int i=0; i<count; ++i )
+	{
+		int k = ( i == 0 ) ? 0 : ( ( i % 2 == 1 ) ? ( i + 1 ) / 2 : count - i / 2 );
+		frag_position  = pos[k];
+		tex_coord      = vec4( tex[k], 1.0 );
+		gl_TexCoord[0] = tex_coord;
+		gl_Position    = vl_ModelViewProjectionMatrix * vec4( pos[k], 1.0 );
+		EmitVertex();
+	}
+	EndPrimitive();
+}
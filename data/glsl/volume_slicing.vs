@@ -0,0 +1,25 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi.                                            */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  This file is part of Visualization Library                                        */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Released under the OSI approved Simplified BSD License                            */
+/*  http://www.opensource.org/licenses/bsd-license.php                                */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#version 150 compatibility
+
+// see vl::SlicedVolume::setGPUSlicingEnabled(): one point is drawn for each slice, volume_slicing.gs generates the slice polygon
+
+flat out int svSlice;
+
+void main(void)
+{
+	svSlice = gl_VertexID;
+	gl_Position = vec4(0.0);
+}
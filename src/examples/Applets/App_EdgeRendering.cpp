@@ -49,6 +49,7 @@ public:
     "- '4' = edge rendering on: silhouette + creases + hidden lines.\n" +
     "- '5' = edges only: silhouette + creases.\n" +
     "- '6' = edges only: silhouette + creases + hidden lines.\n" +
+    "- 'g' = toggle GPU edge extraction.\n" +
     "\n";
   }
 
@@ -139,6 +140,7 @@ public:
   // '4' = edge rendering on: silhouette + creases + hidden lines.
   // '5' = edges only: silhouette + creases.
   // '6' = edges only: silhouette + creases + hidden lines.
+  // 'g' = toggle GPU edge extraction.
   void keyPressEvent(unsigned short ch, EKey key)
   {
     BaseDemo::keyPressEvent(ch, key);
@@ -203,6 +205,15 @@ public:
       mEdgeRenderer->setShowHiddenLines(true);
       Log::print("Hidden line removal wireframe enabled. Creases = on, hidden lines = on.\n");
     }
+    else
+    if (ch == 'g')
+    {
+      mEdgeRenderer->setGPUEdgesEnabled( !mEdgeRenderer->gpuEdgesEnabled() );
+      if ( mEdgeRenderer->gpuEdgesEnabled() && !EdgeRenderer::isGPUEdgeRenderingSupported() )
+        Log::print("GPU edges not supported, using CPU edges.\n");
+      else
+        Log::print( Say("GPU edges = %s.\n") << (mEdgeRenderer->gpuEdgesEnabled() ? "on" : "off") );
+    }
   }
 
   void resizeEvent(int w, int h)
@@ -122,6 +122,16 @@ public:
     else
     if (mTest == 5)
       runTest5();
+    else
+    if (mTest == 0 && mMarchingCubes.interactive() && mScrubTimer.elapsed() > 0.25)
+    {
+      // the threshold stopped changing: refine the isosurface at full resolution
+      mMarchingCubes.setInteractive(false);
+      mMarchingCubes.run(false);
+      if (mIsosurfGeom)
+        mIsosurfGeom->setBufferObjectDirty(true);
+      openglContext()->update();
+    }
   }
 
   void runTest4()
@@ -650,9 +660,12 @@ public:
 
     mThreshold = vl::clamp(mThreshold, 0.0f, 1.0f);
 
+    // extract a low resolution preview while scrubbing, see updateScene()
     vl::Time time; time.start();
+    mMarchingCubes.setInteractive(true);
     mMarchingCubes.volumeInfo()->at(0)->setThreshold(mThreshold);
     mMarchingCubes.run(false);
+    mScrubTimer.start();
     if (mIsosurfGeom)
       mIsosurfGeom->setBufferObjectDirty(true);
 
@@ -706,6 +719,7 @@ protected:
   std::vector<vl::fvec3> mMetaball;
   std::vector<vl::fvec3> mMetaballVelocity;
   vl::Time mTimer;
+  vl::Time mScrubTimer;
   std::vector< std::vector<vl::fvec3> > mMetaballsFrames;
   static const int mMetaballsResolution = 32;
   static const int mParticleCount = 25;
@@ -37,7 +37,7 @@
 class App_Molecules: public BaseDemo
 {
 public:
-  App_Molecules(): mCurrentMolecule(0), mCurrentStyle(0), mText( new vl::Text ) {}
+  App_Molecules(): mCurrentMolecule(0), mCurrentStyle(0), mImpostors(false), mText( new vl::Text ) {}
 
   void updateMolecule()
   {
@@ -123,6 +123,9 @@ public:
     mMolecules[mCurrentMolecule]->bond(6)->setVisible(false);
     */
 
+    /* renders the atoms and bonds of the "ball & stick" and "cpk" styles as ray cast impostors using a single Actor each */
+    mMolecules[mCurrentMolecule]->setImpostorsEnabled(mImpostors);
+
     /* generates the actual geometry to be rendered, the result of this function will be in
        mMolecules[mCurrentMolecule]->actorTree() and mMolecules[mCurrentMolecule]->transformTree() */
     mMolecules[mCurrentMolecule]->prepareForRendering();
@@ -197,6 +200,12 @@ public:
       if (mCurrentStyle>3) mCurrentStyle = 0;
       updateMolecule();
     }
+    else
+    if (key == vl::Key_I && !mMolecules.empty())
+    {
+      mImpostors = !mImpostors && vl::Molecule::isImpostorRenderingSupported();
+      updateMolecule();
+    }
   }
 
   /* updates the text on top of the window with the current molecule name and style */
@@ -212,8 +221,10 @@ public:
       msg += " - Sticks";
     if (mCurrentStyle == 3)
       msg += " - CPK";
+    if (mImpostors && (mCurrentStyle == 1 || mCurrentStyle == 3))
+      msg += " (impostors)";
 
-    msg += "\nuse the arrow keys to change molecule and style";
+    msg += "\nuse the arrow keys to change molecule and style, 'i' to toggle the impostors";
     mText->setText(msg);
   }
 
@@ -221,6 +232,7 @@ protected:
   std::vector< vl::ref<vl::Molecule> > mMolecules;
   int mCurrentMolecule;
   int mCurrentStyle;
+  bool mImpostors;
   vl::ref<vl::Text> mText;
 };
 
@@ -52,6 +52,8 @@ using namespace vl;
   - RaycastBrightnessControl_Mode
   - RaycastDensityControl_Mode
   - RaycastColorControl_Mode
+  - DVR_Mode
+  - PreIntegrated_Mode
 
   Mouse wheel:
   - In Isosurface_Mode controls the iso-value of the isosurface
@@ -60,10 +62,14 @@ using namespace vl;
   - In RaycastBrightnessControl_Mode controls the brightness of the voxels
   - In RaycastDensityControl_Mode controls the density of the voxels
   - In RaycastColorControl_Mode controls the color-bias of the voxels
+  - In DVR_Mode controls the opacity of the transfer function
+  - In PreIntegrated_Mode controls the opacity of the transfer function
 
   The Up/Down arrow keys are used to higher/lower the ray-advancement precision.
 
   The 'L' key toggles the dynamic and colored lights.
+
+  The 'S' key toggles empty space skipping.
 */
 class App_VolumeRaycast: public BaseDemo
 {
@@ -80,9 +86,15 @@ class App_VolumeRaycast: public BaseDemo
     MIP_Mode,
     RaycastBrightnessControl_Mode,
     RaycastDensityControl_Mode,
-    RaycastColorControl_Mode
+    RaycastColorControl_Mode,
+    DVR_Mode,
+    PreIntegrated_Mode
   } MODE;
 
+  /* The PreIntegrated_Mode uses a sample step this many times larger than the other modes,
+     the pre-integration table accounts for the transfer function variations in between the samples. */
+  float PREINTEGRATION_STEP_SCALE;
+
   /* If enabled, renders the volume using 3 animated lights. */
   bool DYNAMIC_LIGHTS;
 
@@ -93,6 +105,9 @@ class App_VolumeRaycast: public BaseDemo
      Requires more memory ( for the gradient texture ) but can speedup the rendering. */
   bool PRECOMPUTE_GRADIENT;
 
+  /* Skip the bricks of the volume that cannot contribute to the image, see RaycastVolume::setEmptySpaceSkippingEnabled(). */
+  bool EMPTY_SPACE_SKIPPING;
+
 public:
   virtual String appletInfo()
   {
@@ -100,6 +115,7 @@ public:
     "- Left/Right Arrow: change raycast technique.\n" +
     "- Up/Down Arrow: changes SAMPLE_STEP.\n" +
     "- L: toggles lights (useful only for isosurface).\n" +
+    "- S: toggles empty space skipping.\n" +
     "- Mouse Wheel: change the bias used to render the volume.\n" +
     "\n" +
     "- Drop inside the window a set of 2D files or a DDS or DAT volume to display it.\n" +
@@ -113,6 +129,8 @@ public:
     DYNAMIC_LIGHTS      = false;
     COLORED_LIGHTS      = false;
     PRECOMPUTE_GRADIENT = false;
+    EMPTY_SPACE_SKIPPING = true;
+    PREINTEGRATION_STEP_SCALE = 4.0f;
   }
 
   /* initialize the applet with a default volume */
@@ -148,6 +166,8 @@ public:
     // - In RaycastBrightnessControl_Mode controls the brightness of the voxels
     // - In RaycastDensityControl_Mode controls the density of the voxels
     // - In RaycastColorControl_Mode controls the color-bias of the voxels
+    // - In DVR_Mode controls the opacity of the transfer function
+    // - In PreIntegrated_Mode controls the opacity of the transfer function
     mValThreshold = new Uniform( "val_threshold" );
     mValThreshold->setUniformF( 0.5f );
 
@@ -220,7 +240,10 @@ public:
 
     // the GLSL program that performs the actual raycasting
     mGLSL = volume_fx->shader()->gocGLSLProgram();
-    mGLSL->gocUniform( "sample_step" )->setUniformF( 1.0f / SAMPLE_STEP );
+    if ( MODE == PreIntegrated_Mode )
+      mGLSL->gocUniform( "sample_step" )->setUniformF( PREINTEGRATION_STEP_SCALE / SAMPLE_STEP );
+    else
+      mGLSL->gocUniform( "sample_step" )->setUniformF( 1.0f / SAMPLE_STEP );
 
     // attach vertex shader (common to all the raycasting techniques)
     mGLSL->attachShader( new GLSLVertexShader( "/glsl/volume_luminance_light.vs" ) );
@@ -243,6 +266,16 @@ public:
     else
     if ( MODE == RaycastColorControl_Mode )
       mGLSL->attachShader( new GLSLFragmentShader( "/glsl/volume_raycast03.fs" ) );
+    else
+    if ( MODE == DVR_Mode )
+      mGLSL->attachShader( new GLSLFragmentShader( "/glsl/volume_raycast_dvr.fs" ) );
+    else
+    if ( MODE == PreIntegrated_Mode )
+      mGLSL->attachShader( new GLSLFragmentShader( "/glsl/volume_raycast_preintegrated.fs" ) );
+
+    // empty space skipping and adaptive sampling, the brick images are generated in setupVolume()
+    mRaycastVolume->setEmptySpaceSkippingEnabled( EMPTY_SPACE_SKIPPING );
+    mRaycastVolume->setAdaptiveStepMax( 4.0f );
 
     // manipulate volume transform with the trackball
     trackball()->setTransform( mVolumeTr.get() );
@@ -318,6 +351,16 @@ public:
       trfunc = vl::makeColorSpectrum( 128, vl::blue, vl::royalblue, vl::green, vl::yellow, vl::crimson );
     }
 
+    // direct volume rendering: the lowest values are fully transparent, then the opacity ramps up
+    if ( MODE == DVR_Mode || MODE == PreIntegrated_Mode )
+    {
+      for( int i=0; i<trfunc->width(); ++i )
+      {
+        float t = clamp( ( (float)i / trfunc->width() - 0.25f ) / 0.75f, 0.0f, 1.0f );
+        trfunc->pixels()[i*4 + 3] = (unsigned char)( t * 255.0f );
+      }
+    }
+
     // installs the transfer function as texture #1
     vl::ref< vl::Texture > trf_tex = new Texture( trfunc.get(), vl::TF_RGBA, false, false );
     trf_tex->getTexParameter()->setMagFilter( vl::TPF_LINEAR );
@@ -326,6 +369,19 @@ public:
     volume_fx->shader()->gocTextureSampler( 1 )->setTexture( trf_tex.get() );
     volume_fx->shader()->gocUniform( "trfunc_texunit" )->setUniformI( 1 );
 
+    // pre-integrated transfer function as texture #2, whenever the transfer function is edited
+    // vl::updatePreIntegrationTable() recomputes only the entries affected by the modification
+    if ( MODE == PreIntegrated_Mode )
+    {
+      ref<Image> preint = vl::genPreIntegrationTable( trfunc.get(), PREINTEGRATION_STEP_SCALE );
+      vl::ref< vl::Texture > tex = new Texture( preint.get(), TF_RGBA32F, false, false );
+      tex->getTexParameter()->setMagFilter( vl::TPF_LINEAR );
+      tex->getTexParameter()->setMinFilter( vl::TPF_LINEAR );
+      tex->getTexParameter()->setWrap( vl::TPW_CLAMP_TO_EDGE );
+      volume_fx->shader()->gocTextureSampler( 2 )->setTexture( tex.get() );
+      volume_fx->shader()->gocUniform( "preint_texunit" )->setUniformI( 2 );
+    }
+
     // gradient computation, only use for isosurface methods
     if ( MODE == Isosurface_Mode || MODE == Isosurface_Transp_Mode )
     {
@@ -341,6 +397,29 @@ public:
       }
     }
 
+    // brick images used for empty space skipping: the value range of each brick for the isosurface and MIP
+    // shaders and the occupancy of each brick according to the transfer function for the DVR shader.
+    if ( MODE == Isosurface_Mode || MODE == Isosurface_Transp_Mode || MODE == MIP_Mode || MODE == DVR_Mode || MODE == PreIntegrated_Mode )
+    {
+      ref<Image> minmax = vl::genMinMaxBricks( mVolumeImage.get(), mRaycastVolume->brickSize() );
+      ref<Texture> tex;
+      if ( MODE == DVR_Mode || MODE == PreIntegrated_Mode )
+      {
+        ref<Image> occupancy = vl::genOccupancyBricks( minmax.get(), trfunc.get() );
+        tex = new Texture( occupancy.get(), TF_R8, false, false );
+        volume_fx->shader()->gocUniform( "occupancy_texunit" )->setUniformI( 3 );
+      }
+      else
+      {
+        tex = new Texture( minmax.get(), TF_RG32F, false, false );
+        volume_fx->shader()->gocUniform( "minmax_texunit" )->setUniformI( 3 );
+      }
+      tex->getTexParameter()->setMagFilter( vl::TPF_NEAREST );
+      tex->getTexParameter()->setMinFilter( vl::TPF_NEAREST );
+      tex->getTexParameter()->setWrap( vl::TPW_CLAMP_TO_EDGE );
+      volume_fx->shader()->gocTextureSampler( 3 )->setTexture( tex.get() );
+    }
+
     // update text
     updateText();
 
@@ -421,12 +500,15 @@ public:
       case MIP_Mode: technique_name                      = "< raycast maximum intensity projection >"; break;
       case RaycastBrightnessControl_Mode: technique_name = "< raycast brightness control >"; break;
       case RaycastDensityControl_Mode: technique_name    = "< raycast density control >"; break;
-      case RaycastColorControl_Mode: technique_name      = "< raycast color control"; break;
+      case RaycastColorControl_Mode: technique_name      = "< raycast color control >"; break;
+      case DVR_Mode: technique_name                      = "< raycast direct volume rendering >"; break;
+      case PreIntegrated_Mode: technique_name            = "< raycast pre-integrated direct volume rendering"; break;
     };
 
     float val_threshold = 0;
     mValThreshold->getUniform( &val_threshold );
-    mValThresholdText->setText( Say( "val_threshold = %n\n" "sample_step = 1.0 / %.0n\n" "%s" ) << val_threshold << SAMPLE_STEP << technique_name );
+    float sample_step = MODE == PreIntegrated_Mode ? SAMPLE_STEP / PREINTEGRATION_STEP_SCALE : SAMPLE_STEP;
+    mValThresholdText->setText( Say( "val_threshold = %n\n" "sample_step = 1.0 / %.0n\n" "%s" ) << val_threshold << sample_step << technique_name );
   }
 
   void updateValThreshold( int val )
@@ -467,14 +549,14 @@ public:
   virtual void keyPressEvent(unsigned short, EKey key)
   {
     // left/right arrows change raycast technique
-    RaycastMode modes[] = { Isosurface_Mode, Isosurface_Transp_Mode, MIP_Mode, RaycastBrightnessControl_Mode, RaycastDensityControl_Mode, RaycastColorControl_Mode };
+    RaycastMode modes[] = { Isosurface_Mode, Isosurface_Transp_Mode, MIP_Mode, RaycastBrightnessControl_Mode, RaycastDensityControl_Mode, RaycastColorControl_Mode, DVR_Mode, PreIntegrated_Mode };
     int mode = MODE;
     if (key == vl::Key_Right)
       mode++;
     else
     if (key == vl::Key_Left)
       mode--;
-    MODE = modes[ vl::clamp(mode, 0, 5) ];
+    MODE = modes[ vl::clamp(mode, 0, 7) ];
 
     // up/down changes SAMPLE_STEP
     if (key == vl::Key_Up)
@@ -508,6 +590,10 @@ public:
       }
     }
 
+    // S key toggles empty space skipping
+    if (key == vl::Key_S)
+      EMPTY_SPACE_SKIPPING = !EMPTY_SPACE_SKIPPING;
+
     setupScene();
   }
 
@@ -55,6 +55,10 @@ static bool COLORED_LIGHTS = true;
    Requires more memory (for the gradient texture) but can speedup the rendering. */
 static bool PRECOMPUTE_GRADIENT = false; // only if USE_GLSL is true.
 
+/* Generate the slices in a geometry shader instead of recomputing them on the CPU
+   every time the camera moves, see SlicedVolume::setGPUSlicingEnabled(). Requires USE_GLSL. */
+static bool GPU_SLICING = true;
+
 /* The number of slices used to render the volume, the higher the number the better
   (and slower) the rendering will be. */
 static const int  SLICE_COUNT = 1000;
@@ -89,6 +93,7 @@ public:
     DYNAMIC_LIGHTS &= USE_GLSL;
     COLORED_LIGHTS &= DYNAMIC_LIGHTS;
     PRECOMPUTE_GRADIENT &= USE_GLSL;
+    GPU_SLICING &= USE_GLSL && SlicedVolume::isGPUSlicingSupported();
 
     // lights to be used later
     mLight0 = new Light;
@@ -146,7 +151,13 @@ public:
     {
       mGLSL = vol_fx->shader()->gocGLSLProgram();
       mGLSL->attachShader( new GLSLFragmentShader("/glsl/volume_luminance_light.fs") );
-      mGLSL->attachShader( new GLSLVertexShader("/glsl/volume_luminance_light.vs") );
+      if ( GPU_SLICING )
+      {
+        mGLSL->attachShader( new GLSLVertexShader("/glsl/volume_slicing.vs") );
+        mGLSL->attachShader( new GLSLGeometryShader("/glsl/volume_slicing.gs") );
+      }
+      else
+        mGLSL->attachShader( new GLSLVertexShader("/glsl/volume_luminance_light.vs") );
     }
 
     // transform and trackball setup
@@ -261,6 +272,7 @@ public:
         }
         // installs GLSLProgram
         vol_fx->shader()->setRenderState( mGLSL.get() );
+        mSlicedVolume->setGPUSlicingEnabled( GPU_SLICING );
         // install volume image
         vol_fx->shader()->gocTextureSampler(0)->setTexture( new vl::Texture( img.get() ) );
         vol_fx->shader()->gocUniform("volume_texunit")->setUniformI(0);
@@ -295,6 +307,7 @@ public:
       else // precompute transfer function and illumination
       {
         Log::notify("IF_LUMINANCE image and GLSL not supported: transfer function and lighting will be precomputed.\n");
+        mSlicedVolume->setGPUSlicingEnabled( false );
 
         // generate simple transfer function
         ref<Image> trfunc = vl::makeColorSpectrum(128, vl::black, vl::blue, vl::green, vl::yellow, vl::red);
@@ -309,6 +322,7 @@ public:
     else // if it's a color texture just display it as it is
     {
       Log::notify("Non IF_LUMINANCE image: not using GLSL.\n");
+      mSlicedVolume->setGPUSlicingEnabled( false );
       // install volume texture
       vol_fx->shader()->gocTextureSampler(0)->setTexture( new vl::Texture( img.get() ) );
       mSlicedVolume->generateTextureCoordinates( ivec3(img->width(), img->height(), img->depth()) );
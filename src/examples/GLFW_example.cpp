@@ -91,7 +91,7 @@ int main(void)
   /* run GLFW message loop */
   while ( glfw_window->windows().size() )
   {
-    if ( glfw_window->continuousUpdate() ) {
+    if ( glfw_window->continuousUpdate() && glfw_window->updateNeeded() ) {
       glfw_window->update();
     }
     glfwPollEvents();
@@ -59,7 +59,7 @@ public:
     /* run GLFW message loop */
     while ( glfw_window->handle() )
     {
-      if ( glfw_window->continuousUpdate() ) {
+      if ( glfw_window->continuousUpdate() && glfw_window->updateNeeded() ) {
         glfw_window->update();
       }
       glfwPollEvents();
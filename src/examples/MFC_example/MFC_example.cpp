@@ -62,7 +62,7 @@ MFC_Example mfc_app;
 /* updates the GL window */
 BOOL MFC_Example::OnIdle(LONG lCount)
 {
-  if( mVLCWin->continuousUpdate() )
+  if( mVLCWin->continuousUpdate() && mVLCWin->updateNeeded() )
     mVLCWin->Win32Context::update();
   else
     Sleep(1);
@@ -142,7 +142,7 @@ BOOL MFC_Test::InitInstance()
 //-----------------------------------------------------------------------------
 BOOL MFC_Test::OnIdle(LONG lCount)
 {
-  if( mVLCWin->continuousUpdate() )
+  if( mVLCWin->continuousUpdate() && mVLCWin->updateNeeded() )
     mVLCWin->Win32Context::update();
   else
     Sleep(1);
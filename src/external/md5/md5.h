@@ -33,12 +33,11 @@
 //#elif !defined(__APPLE__)
 //typedef unsigned long uint32;
 //#endif
-#ifdef __alpha
-typedef unsigned int uint32;
-#elif defined(__APPLE__)
+// "unsigned long" is 64 bits on LP64 systems (64 bits Linux/BSD), which corrupts the context
+#if defined(__APPLE__)
 typedef uint32_t uint32;
 #else
-typedef unsigned long uint32;
+typedef unsigned int uint32;
 #endif
 
 struct MD5Context {
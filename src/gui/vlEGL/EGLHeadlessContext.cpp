@@ -0,0 +1,234 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlEGL/EGLHeadlessContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <string.h>
+#include <map>
+
+using namespace vl;
+using namespace vlEGL;
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+  #define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace
+{
+  typedef EGLDisplay (EGLAPIENTRY *PFN_GetPlatformDisplayEXT)(EGLenum platform, void* native_display, const EGLint* attrib_list);
+
+  bool hasExtension(EGLDisplay display, const char* name)
+  {
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    size_t len = strlen(name);
+    for( const char* p = extensions ? strstr(extensions, name) : NULL; p; p = strstr(p + len, name) )
+    {
+      if ( (p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == 0) )
+        return true;
+    }
+    return false;
+  }
+
+  // EGL displays are shared by all the contexts of the process: a display is terminated along with its last context
+  std::map<EGLDisplay, int> gDisplayContexts;
+}
+//-----------------------------------------------------------------------------
+// EGLHeadlessContext
+//-----------------------------------------------------------------------------
+EGLHeadlessContext::EGLHeadlessContext()
+{
+  mEGL_Display = EGL_NO_DISPLAY;
+  mEGL_Context = EGL_NO_CONTEXT;
+  mEGL_Surface = EGL_NO_SURFACE;
+}
+//-----------------------------------------------------------------------------
+EGLHeadlessContext::~EGLHeadlessContext()
+{
+  destroyEGLHeadlessContext();
+}
+//-----------------------------------------------------------------------------
+bool EGLHeadlessContext::initEGLHeadlessContext(int width, int height, const vl::OpenGLContextFormat& fmt)
+{
+  destroyEGLHeadlessContext();
+
+  // prefer the surfaceless platform which works without a display server, fall back to the default display
+  PFN_GetPlatformDisplayEXT get_platform_display = (PFN_GetPlatformDisplayEXT)eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (get_platform_display)
+    mEGL_Display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+  EGLint maj_version=0, min_version=0;
+  if ( mEGL_Display == EGL_NO_DISPLAY || !eglInitialize(mEGL_Display, &maj_version, &min_version) )
+  {
+    mEGL_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if ( mEGL_Display == EGL_NO_DISPLAY || !eglInitialize(mEGL_Display, &maj_version, &min_version) )
+    {
+      Log::error( Say("EGLHeadlessContext: EGL initialization failed (0x%hn).\n") << eglGetError() );
+      mEGL_Display = EGL_NO_DISPLAY;
+      return false;
+    }
+  }
+  ++gDisplayContexts[mEGL_Display];
+
+#if defined(VL_OPENGL)
+  EGLenum api = EGL_OPENGL_API;
+  EGLint renderable_type = EGL_OPENGL_BIT;
+  const EGLint* context_attribs = NULL;
+#else
+  EGLenum api = EGL_OPENGL_ES_API;
+  EGLint renderable_type = fmt.contextClientVersion() >= 2 ? EGL_OPENGL_ES2_BIT : EGL_OPENGL_ES_BIT;
+  EGLint context_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, fmt.contextClientVersion(), EGL_NONE };
+#endif
+
+  EGLint attrib_list[] =
+  {
+    EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, renderable_type,
+    EGL_RED_SIZE,        fmt.rgbaBits().r(),
+    EGL_GREEN_SIZE,      fmt.rgbaBits().g(),
+    EGL_BLUE_SIZE,       fmt.rgbaBits().b(),
+    EGL_ALPHA_SIZE,      fmt.rgbaBits().a()      ? fmt.rgbaBits().a()      : EGL_DONT_CARE,
+    EGL_DEPTH_SIZE,      fmt.depthBufferBits()   ? fmt.depthBufferBits()   : EGL_DONT_CARE,
+    EGL_STENCIL_SIZE,    fmt.stencilBufferBits() ? fmt.stencilBufferBits() : EGL_DONT_CARE,
+    EGL_SAMPLE_BUFFERS,  fmt.multisample() ? 1 : 0,
+    EGL_SAMPLES,         fmt.multisample() ? fmt.multisampleSamples() : EGL_DONT_CARE,
+    EGL_NONE
+  };
+
+  EGLConfig config = NULL;
+  EGLint num_configs = 0;
+  if ( !eglChooseConfig(mEGL_Display, attrib_list, &config, 1, &num_configs) || num_configs == 0 )
+  {
+    Log::error("EGLHeadlessContext: no EGL configuration matches the requested format.\n");
+    destroyEGLHeadlessContext();
+    return false;
+  }
+
+  eglBindAPI(api);
+  mEGL_Context = eglCreateContext(mEGL_Display, config, EGL_NO_CONTEXT, context_attribs);
+  if ( mEGL_Context == EGL_NO_CONTEXT )
+  {
+    Log::error( Say("EGLHeadlessContext: could not create the context (0x%hn).\n") << eglGetError() );
+    destroyEGLHeadlessContext();
+    return false;
+  }
+
+  // without a size render only to framebuffer objects, if possible
+  if ( width <= 0 || height <= 0 )
+  {
+    if ( hasExtension(mEGL_Display, "EGL_KHR_surfaceless_context") )
+      width = height = 0;
+    else
+      width = height = 1;
+  }
+
+  if ( width > 0 && height > 0 )
+  {
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    mEGL_Surface = eglCreatePbufferSurface(mEGL_Display, config, pbuffer_attribs);
+    if ( mEGL_Surface == EGL_NO_SURFACE )
+    {
+      Log::error( Say("EGLHeadlessContext: could not create the pbuffer (0x%hn).\n") << eglGetError() );
+      destroyEGLHeadlessContext();
+      return false;
+    }
+  }
+
+  if ( !eglMakeCurrent(mEGL_Display, mEGL_Surface, mEGL_Surface, mEGL_Context) )
+  {
+    Log::error( Say("EGLHeadlessContext: could not make the context current (0x%hn).\n") << eglGetError() );
+    destroyEGLHeadlessContext();
+    return false;
+  }
+
+  if ( !initGLContext() )
+  {
+    destroyEGLHeadlessContext();
+    return false;
+  }
+
+  framebuffer()->setWidth(width);
+  framebuffer()->setHeight(height);
+
+  dispatchInitEvent();
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void EGLHeadlessContext::destroyEGLHeadlessContext()
+{
+  if ( mEGL_Display == EGL_NO_DISPLAY )
+    return;
+
+  if ( mEGL_Context != EGL_NO_CONTEXT )
+  {
+    makeCurrent();
+    dispatchDestroyEvent();
+  }
+
+  eglMakeCurrent(mEGL_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if ( mEGL_Context != EGL_NO_CONTEXT )
+    eglDestroyContext(mEGL_Display, mEGL_Context);
+  if ( mEGL_Surface != EGL_NO_SURFACE )
+    eglDestroySurface(mEGL_Display, mEGL_Surface);
+  if ( --gDisplayContexts[mEGL_Display] <= 0 )
+  {
+    gDisplayContexts.erase(mEGL_Display);
+    eglTerminate(mEGL_Display);
+  }
+
+  mEGL_Display = EGL_NO_DISPLAY;
+  mEGL_Context = EGL_NO_CONTEXT;
+  mEGL_Surface = EGL_NO_SURFACE;
+}
+//-----------------------------------------------------------------------------
+void EGLHeadlessContext::swapBuffers()
+{
+  if ( mEGL_Surface != EGL_NO_SURFACE && !eglSwapBuffers(mEGL_Display, mEGL_Surface) )
+  {
+    Log::error("EGLHeadlessContext::swapBuffers() failed!\n");
+  }
+}
+//-----------------------------------------------------------------------------
+void EGLHeadlessContext::makeCurrent()
+{
+  if ( !eglMakeCurrent(mEGL_Display, mEGL_Surface, mEGL_Surface, mEGL_Context) )
+  {
+    Log::error("EGLHeadlessContext::makeCurrent() failed!\n");
+  }
+}
+//-----------------------------------------------------------------------------
+void EGLHeadlessContext::doneCurrent()
+{
+  if ( mEGL_Display != EGL_NO_DISPLAY )
+    eglMakeCurrent(mEGL_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+//-----------------------------------------------------------------------------
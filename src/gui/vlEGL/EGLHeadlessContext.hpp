@@ -0,0 +1,89 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef EGLHeadlessContext_INCLUDE_ONCE
+#define EGLHeadlessContext_INCLUDE_ONCE
+
+#include <vlEGL/link_config.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <EGL/egl.h>
+
+namespace vlEGL
+{
+//-----------------------------------------------------------------------------
+// EGLHeadlessContext
+//-----------------------------------------------------------------------------
+  /**
+   * An OpenGLContext without a window, for offscreen rendering on servers without a display.
+   *
+   * The context is created on the Mesa surfaceless EGL platform when available, so that it works without any
+   * display server, otherwise on the default EGL display. It renders either to a pbuffer of the given size or,
+   * when the size is 0 and EGL_KHR_surfaceless_context is supported, to no surface at all: in this case
+   * all the rendering must target FramebufferObject[s].
+   *
+   * Desktop OpenGL contexts are created when VL is built for OpenGL, OpenGL ES contexts otherwise.
+   * \sa OffscreenRenderService
+  */
+  class VLEGL_EXPORT EGLHeadlessContext: public vl::OpenGLContext
+  {
+  public:
+    EGLHeadlessContext();
+    ~EGLHeadlessContext();
+
+    // *** OpenGLContext implementation ***
+
+    void swapBuffers();
+    void makeCurrent();
+    void doneCurrent();
+    void update() {}
+
+    //! Initializes a new OpenGL rendering context rendering to a \p width x \p height pbuffer.
+    //! If \p width or \p height is 0 the context is surfaceless if supported, otherwise it uses a 1x1 pbuffer.
+    bool initEGLHeadlessContext(int width=0, int height=0, const vl::OpenGLContextFormat& fmt=vl::OpenGLContextFormat());
+
+    //! Destroys the OpenGL rendering context and its pbuffer
+    void destroyEGLHeadlessContext();
+
+    //! Returns true if the context has no default framebuffer, see initEGLHeadlessContext().
+    bool surfaceless() const { return mEGL_Surface == EGL_NO_SURFACE; }
+
+    const EGLDisplay& eglDisplay() const { return mEGL_Display; }
+    const EGLContext& eglContext() const { return mEGL_Context; }
+    const EGLSurface& eglSurface() const { return mEGL_Surface; }
+
+  protected:
+    EGLDisplay mEGL_Display;
+    EGLContext mEGL_Context;
+    EGLSurface mEGL_Surface;
+  };
+}
+
+#endif
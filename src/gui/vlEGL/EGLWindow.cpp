@@ -548,7 +548,7 @@ void vlEGL::dispatchUpdate()
        ++it )
   {
     EGLWindow* win = it->second;
-    if ( win->continuousUpdate() )
+    if ( win->continuousUpdate() && win->updateNeeded() )
       win->update();
     else
       Sleep(10);
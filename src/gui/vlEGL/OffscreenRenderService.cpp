@@ -0,0 +1,314 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlEGL/OffscreenRenderService.hpp>
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlCore/Image.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+using namespace vlEGL;
+
+//-----------------------------------------------------------------------------
+// OffscreenRenderService
+//-----------------------------------------------------------------------------
+OffscreenRenderService::OffscreenRenderService()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mJobsSubmitted = 0;
+  mNextTicket = 0;
+  mMaxQueuedImages = 64;
+  mMaxFramebuffers = 8;
+  mBusyThreads = 0;
+  mJobsCompleted = 0;
+  mImagesSaved = 0;
+  mSaveErrors = 0;
+  mQuit = false;
+}
+//-----------------------------------------------------------------------------
+OffscreenRenderService::~OffscreenRenderService()
+{
+  shutdown();
+}
+//-----------------------------------------------------------------------------
+bool OffscreenRenderService::init(int encoder_threads, const OpenGLContextFormat& fmt)
+{
+  shutdown();
+
+  mContext = new EGLHeadlessContext;
+  if ( !mContext->initEGLHeadlessContext(0, 0, fmt) )
+  {
+    mContext = NULL;
+    return false;
+  }
+
+  if ( !Has_FBO )
+  {
+    Log::error("OffscreenRenderService::init(): framebuffer objects not supported.\n");
+    mContext = NULL;
+    return false;
+  }
+
+  mReadback = new AsyncReadPixels;
+  mReadback->setFormat( IF_RGBA, IT_UNSIGNED_BYTE );
+  mReadback->setCallback( new ReadbackHandler(this) );
+
+  if ( encoder_threads <= 0 )
+  {
+    encoder_threads = (int)std::thread::hardware_concurrency() - 1;
+    if ( encoder_threads < 1 )
+      encoder_threads = 1;
+  }
+
+  mQuit = false;
+  for( int i=0; i<encoder_threads; ++i )
+    mThreads.push_back( std::thread(&OffscreenRenderService::encoderThread, this) );
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void OffscreenRenderService::shutdown()
+{
+  if ( mContext )
+    finish();
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQuit = true;
+  }
+  mWorkAvailable.notify_all();
+  for( size_t i=0; i<mThreads.size(); ++i )
+    mThreads[i].join();
+  mThreads.clear();
+
+  if ( mContext )
+  {
+    mContext->makeCurrent();
+    mReadback->releaseBuffers();
+    mReadback = NULL;
+    mPendingReadback.clear();
+    mJobsInFlight.clear();
+    mFramebuffers.clear();
+    mContext->destroyEGLHeadlessContext();
+    mContext = NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+FramebufferObject* OffscreenRenderService::framebuffer(int width, int height)
+{
+  std::pair<int,int> key(width, height);
+  std::map< std::pair<int,int>, PooledFramebuffer >::iterator it = mFramebuffers.find(key);
+  if ( it != mFramebuffers.end() )
+  {
+    it->second.mLastUse = mJobsSubmitted;
+    return it->second.mFBO.get();
+  }
+
+  // evict the least recently used size
+  if ( (int)mFramebuffers.size() >= mMaxFramebuffers && !mFramebuffers.empty() )
+  {
+    std::map< std::pair<int,int>, PooledFramebuffer >::iterator lru = mFramebuffers.begin();
+    for( it = mFramebuffers.begin(); it != mFramebuffers.end(); ++it )
+      if ( it->second.mLastUse < lru->second.mLastUse )
+        lru = it;
+    mContext->destroyFramebufferObject( lru->second.mFBO.get() );
+    mFramebuffers.erase(lru);
+  }
+
+  ref<FramebufferObject> fbo = mContext->createFramebufferObject( width, height, RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT0 );
+  fbo->addColorAttachment( AP_COLOR_ATTACHMENT0, new FBOColorBufferAttachment(CBF_RGBA8) );
+  fbo->addDepthAttachment( new FBODepthBufferAttachment(DBF_DEPTH_COMPONENT24) );
+
+  PooledFramebuffer& pooled = mFramebuffers[key];
+  pooled.mFBO = fbo;
+  pooled.mLastUse = mJobsSubmitted;
+  return fbo.get();
+}
+//-----------------------------------------------------------------------------
+bool OffscreenRenderService::submit(RenderJob* job)
+{
+  if ( !mContext )
+  {
+    Log::error("OffscreenRenderService::submit(): service not initialized.\n");
+    return false;
+  }
+
+  Rendering* rendering = job->rendering();
+  if ( !rendering || !rendering->renderer() || !rendering->camera() || job->width() <= 0 || job->height() <= 0 )
+  {
+    Log::error("OffscreenRenderService::submit(): invalid RenderJob.\n");
+    return false;
+  }
+
+  mContext->makeCurrent();
+  releaseCompletedJobs();
+
+  // backpressure: don't let the encoder threads fall too far behind
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while( (int)mEncodeQueue.size() >= mMaxQueuedImages )
+      mWorkDone.wait(lock);
+  }
+
+  FramebufferObject* fbo = framebuffer( job->width(), job->height() );
+
+  // render the job into the pooled framebuffer
+  ref<Framebuffer> prev_framebuffer = rendering->renderer()->framebuffer();
+  rendering->renderer()->setFramebuffer( fbo );
+  rendering->camera()->viewport()->set( 0, 0, job->width(), job->height() );
+  rendering->render();
+  rendering->renderer()->setFramebuffer( prev_framebuffer.get() );
+
+  // schedule the readback, the next jobs can render into the same framebuffer since the commands are executed in order.
+  // Bind both targets: a surfaceless context has no complete default draw framebuffer.
+  fbo->bindFramebuffer( FBB_FRAMEBUFFER );
+  mPendingReadback.push_back( job );
+  ++mJobsSubmitted;
+  mReadback->setup( 0, 0, job->width(), job->height(), RDB_COLOR_ATTACHMENT0 );
+  mReadback->readPixels();
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void OffscreenRenderService::onPixelsRead(Image* image)
+{
+  VL_CHECK( !mPendingReadback.empty() )
+  if ( mPendingReadback.empty() )
+    return;
+
+  InFlightJob in_flight;
+  in_flight.mJob = mPendingReadback.front();
+  in_flight.mImage = image;
+  mPendingReadback.pop_front();
+
+  EncodeItem item;
+  item.mTicket = mNextTicket++;
+  item.mJob = in_flight.mJob.get();
+  item.mImage = image;
+  mJobsInFlight[item.mTicket] = in_flight;
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEncodeQueue.push_back(item);
+  }
+  mWorkAvailable.notify_one();
+}
+//-----------------------------------------------------------------------------
+void OffscreenRenderService::encoderThread()
+{
+  for(;;)
+  {
+    EncodeItem item;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while( !mQuit && mEncodeQueue.empty() )
+        mWorkAvailable.wait(lock);
+      if ( mEncodeQueue.empty() )
+        return;
+      item = mEncodeQueue.front();
+      mEncodeQueue.pop_front();
+      ++mBusyThreads;
+    }
+
+    // OpenGL returns the rows bottom-up
+    item.mImage->flipVertically();
+
+    bool saved = false;
+    bool failed = false;
+    if ( !item.mJob->outputPath().empty() )
+    {
+      saved = saveImage( item.mImage, String::fromUTF8( item.mJob->outputPath().c_str() ) );
+      failed = !saved;
+    }
+
+    if ( item.mJob->callback() )
+      item.mJob->callback()->onJobCompleted( item.mJob, item.mImage, saved );
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mCompletedTickets.push_back( item.mTicket );
+      --mBusyThreads;
+      ++mJobsCompleted;
+      mImagesSaved += saved ? 1 : 0;
+      mSaveErrors += failed ? 1 : 0;
+    }
+    mWorkDone.notify_all();
+  }
+}
+//-----------------------------------------------------------------------------
+void OffscreenRenderService::releaseCompletedJobs()
+{
+  std::vector<unsigned long> tickets;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    tickets.swap( mCompletedTickets );
+  }
+  for( size_t i=0; i<tickets.size(); ++i )
+    mJobsInFlight.erase( tickets[i] );
+}
+//-----------------------------------------------------------------------------
+void OffscreenRenderService::finish()
+{
+  if ( !mContext )
+    return;
+
+  mContext->makeCurrent();
+  mReadback->flush();
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while( !mEncodeQueue.empty() || mBusyThreads )
+      mWorkDone.wait(lock);
+  }
+
+  releaseCompletedJobs();
+}
+//-----------------------------------------------------------------------------
+unsigned long OffscreenRenderService::jobsCompleted() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mJobsCompleted;
+}
+//-----------------------------------------------------------------------------
+unsigned long OffscreenRenderService::imagesSaved() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mImagesSaved;
+}
+//-----------------------------------------------------------------------------
+unsigned long OffscreenRenderService::saveErrors() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mSaveErrors;
+}
+//-----------------------------------------------------------------------------
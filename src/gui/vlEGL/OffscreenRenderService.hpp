@@ -0,0 +1,227 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef OffscreenRenderService_INCLUDE_ONCE
+#define OffscreenRenderService_INCLUDE_ONCE
+
+#include <vlEGL/EGLHeadlessContext.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/AsyncReadPixels.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <map>
+#include <string>
+
+namespace vlEGL
+{
+  class RenderJob;
+//-----------------------------------------------------------------------------
+// RenderJobCallback
+//-----------------------------------------------------------------------------
+  //! Receives the results of the RenderJob[s] processed by an OffscreenRenderService.
+  class RenderJobCallback: public vl::Object
+  {
+  public:
+    /** Called by an encoder thread when the image of \p job is available and, if RenderJob::outputPath() is set, after saving it.
+      * The image rows are top-down. Do not access OpenGL nor the job's Rendering from here. */
+    virtual void onJobCompleted(RenderJob* job, vl::Image* image, bool saved) = 0;
+  };
+//-----------------------------------------------------------------------------
+// RenderJob
+//-----------------------------------------------------------------------------
+  //! A Rendering to be rendered by an OffscreenRenderService at the given size and optionally saved to an image file.
+  class VLEGL_EXPORT RenderJob: public vl::Object
+  {
+  public:
+    RenderJob(vl::Rendering* rendering=NULL, int width=640, int height=480, const vl::String& output_path=vl::String()):
+      mRendering(rendering), mWidth(width), mHeight(height)
+    {
+      setOutputPath(output_path);
+    }
+
+    //! The Rendering to render. Its Renderer's framebuffer and its Camera's viewport are set up by the OffscreenRenderService,
+    //! the projection matrix is left to the user.
+    void setRendering(vl::Rendering* rendering) { mRendering = rendering; }
+    vl::Rendering* rendering() { return mRendering.get(); }
+    const vl::Rendering* rendering() const { return mRendering.get(); }
+
+    void setSize(int width, int height) { mWidth = width; mHeight = height; }
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+
+    //! The image file written by the encoder threads, the format is chosen by the extension (see vl::saveImage()). Empty by default.
+    void setOutputPath(const vl::String& path) { path.toUTF8(mOutputPath, false); }
+    //! The output path UTF8 encoded.
+    const std::string& outputPath() const { return mOutputPath; }
+
+    //! Optional callback receiving the image, see RenderJobCallback.
+    void setCallback(RenderJobCallback* callback) { mCallback = callback; }
+    RenderJobCallback* callback() const { return mCallback.get_writable(); }
+
+  protected:
+    vl::ref<vl::Rendering> mRendering;
+    vl::ref<RenderJobCallback> mCallback;
+    int mWidth;
+    int mHeight;
+    // kept as std::string since it is read by the encoder threads
+    std::string mOutputPath;
+  };
+//-----------------------------------------------------------------------------
+// OffscreenRenderService
+//-----------------------------------------------------------------------------
+  /**
+   * Renders batches of RenderJob[s] on a headless EGL context, for servers producing large numbers of images.
+   *
+   * Each submitted job is rendered into a FramebufferObject taken from a pool of reusable FBOs (one per size), then read back
+   * asynchronously through a ring of pixel buffer objects (see vl::AsyncReadPixels), so that the GPU keeps rendering the
+   * following jobs while the previous ones are transferred. Completed images are handed to a pool of encoder threads that
+   * flip them, save them to RenderJob::outputPath() (PNG, JPG etc.) and call the RenderJobCallback.
+   *
+   * Usage:
+   * \code
+   * ref<OffscreenRenderService> service = new OffscreenRenderService;
+   * service->init();
+   * for(...)
+   *   service->submit( new RenderJob(rendering, 512, 512, Say("thumb_%n.png") << i) );
+   * service->finish();
+   * \endcode
+   *
+   * submit() and finish() must be called by the thread owning the context. Jobs are released by that thread as well, so the
+   * Renderings and their OpenGL resources are never destroyed by the encoder threads.
+   * \sa EGLHeadlessContext, vl::AsyncReadPixels
+  */
+  class VLEGL_EXPORT OffscreenRenderService: public vl::Object
+  {
+  public:
+    OffscreenRenderService();
+    ~OffscreenRenderService();
+
+    /** Creates a surfaceless (or 1x1 pbuffer) EGLHeadlessContext and starts \p encoder_threads encoder threads,
+      * one less than the hardware threads if 0. */
+    bool init(int encoder_threads=0, const vl::OpenGLContextFormat& fmt=vl::OpenGLContextFormat());
+
+    //! Waits for all the jobs, stops the encoder threads and destroys the context.
+    void shutdown();
+
+    //! The context used for all the renderings, for example to create the Renderings' resources.
+    EGLHeadlessContext* context() { return mContext.get(); }
+
+    //! Renders the job and schedules its readback, returns without waiting for the GPU. Blocks if more than maxQueuedImages() images wait to be encoded.
+    bool submit(RenderJob* job);
+
+    //! Waits until all the submitted jobs have been read back, encoded and delivered.
+    void finish();
+
+    //! Number of images waiting to be encoded above which submit() blocks. Default is 64.
+    void setMaxQueuedImages(int count) { mMaxQueuedImages = count; }
+    int maxQueuedImages() const { return mMaxQueuedImages; }
+
+    //! Number of pooled FramebufferObject[s], the least recently used is released when a new size exceeds it. Default is 8.
+    void setMaxFramebuffers(int count) { mMaxFramebuffers = count; }
+    int maxFramebuffers() const { return mMaxFramebuffers; }
+
+    //! The readback ring, see vl::AsyncReadPixels::setRingSize().
+    vl::AsyncReadPixels* readback() { return mReadback.get(); }
+
+    unsigned long jobsSubmitted() const { return mJobsSubmitted; }
+    unsigned long jobsCompleted() const;
+    unsigned long imagesSaved() const;
+    unsigned long saveErrors() const;
+
+  protected:
+    class ReadbackHandler: public vl::ReadbackCallback
+    {
+    public:
+      ReadbackHandler(OffscreenRenderService* owner): mOwner(owner) {}
+      virtual void onPixelsRead(vl::AsyncReadPixels*, vl::Image* image, unsigned long) { mOwner->onPixelsRead(image); }
+    protected:
+      OffscreenRenderService* mOwner;
+    };
+
+    //! A job handed to the encoder threads, which never touch the reference counts of the job and the image.
+    struct EncodeItem
+    {
+      unsigned long mTicket;
+      RenderJob* mJob;
+      vl::Image* mImage;
+    };
+
+    struct InFlightJob
+    {
+      vl::ref<RenderJob> mJob;
+      vl::ref<vl::Image> mImage;
+    };
+
+    struct PooledFramebuffer
+    {
+      vl::ref<vl::FramebufferObject> mFBO;
+      unsigned long mLastUse;
+    };
+
+    vl::FramebufferObject* framebuffer(int width, int height);
+    void onPixelsRead(vl::Image* image);
+    void encoderThread();
+    //! Releases the jobs completed by the encoder threads.
+    void releaseCompletedJobs();
+
+  protected:
+    vl::ref<EGLHeadlessContext> mContext;
+    vl::ref<vl::AsyncReadPixels> mReadback;
+    std::map< std::pair<int,int>, PooledFramebuffer > mFramebuffers;
+    // jobs rendered and waiting for their readback, in submission order
+    std::deque< vl::ref<RenderJob> > mPendingReadback;
+    // jobs and images referenced by the encoder threads, released by the context thread
+    std::map< unsigned long, InFlightJob > mJobsInFlight;
+    unsigned long mJobsSubmitted;
+    unsigned long mNextTicket;
+    int mMaxQueuedImages;
+    int mMaxFramebuffers;
+
+    // shared with the encoder threads, protected by mMutex
+    mutable std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    std::deque<EncodeItem> mEncodeQueue;
+    std::vector<unsigned long> mCompletedTickets;
+    std::vector<std::thread> mThreads;
+    int mBusyThreads;
+    unsigned long mJobsCompleted;
+    unsigned long mImagesSaved;
+    unsigned long mSaveErrors;
+    bool mQuit;
+  };
+}
+
+#endif
@@ -30,6 +30,7 @@
 /**************************************************************************************/
 
 #include <vlGLFW/GLFWWindow.hpp>
+#include <vlCore/Log.hpp>
 #include <cstdlib>
 #include <cstdio>
 
@@ -185,6 +186,25 @@ void GLFWWindow::makeCurrent()
   }
 }
 
+void GLFWWindow::doneCurrent()
+{
+  glfwMakeContextCurrent( NULL );
+}
+
+vl::ref<vl::SharedContext> GLFWWindow::createSharedContext()
+{
+  if ( !mHandle )
+    return NULL;
+
+  vl::ref<GLFWSharedContext> shared = new GLFWSharedContext( this, mHandle );
+  if ( !shared->handle() )
+  {
+    Log::error("GLFWWindow::createSharedContext(): could not create the shared context.\n");
+    return NULL;
+  }
+  return shared;
+}
+
 void GLFWWindow::update() {
   dispatchUpdateEvent();
 }
@@ -624,4 +644,36 @@ vl::EKey GLFWWindow::translateKey(int key, int scancode, int mods)
     // case GLFW_KEY_MENU:
   }
 }
+//-----------------------------------------------------------------------------
+// GLFWSharedContext
+//-----------------------------------------------------------------------------
+GLFWSharedContext::GLFWSharedContext(vl::OpenGLContext* shared_with, GLFWwindow* share): vl::SharedContext(shared_with)
+{
+  // the remaining window hints are still the ones used to create the shared window.
+  glfwWindowHint( GLFW_VISIBLE, GL_FALSE );
+  mHandle = glfwCreateWindow( 1, 1, "", NULL, share );
+  glfwWindowHint( GLFW_VISIBLE, GL_TRUE );
+}
+
+GLFWSharedContext::~GLFWSharedContext()
+{
+  if ( mHandle )
+  {
+    glfwDestroyWindow( mHandle );
+    mHandle = NULL;
+  }
+}
 
+bool GLFWSharedContext::makeCurrent()
+{
+  if ( !mHandle )
+    return false;
+  glfwMakeContextCurrent( mHandle );
+  return true;
+}
+
+void GLFWSharedContext::doneCurrent()
+{
+  glfwMakeContextCurrent( NULL );
+}
+//-----------------------------------------------------------------------------
@@ -40,6 +40,33 @@
 
 namespace vlGLFW
 {
+  //-----------------------------------------------------------------------------
+  // GLFWSharedContext
+  //-----------------------------------------------------------------------------
+  /**
+   * The GLFWSharedContext class implements a vl::SharedContext using a hidden GLFW window.
+   * \note GLFW windows must be created and destroyed by the main thread: release the GLFWSharedContext from the main thread.
+   * \sa GLFWWindow::createSharedContext()
+  */
+  class VLGLFW_EXPORT GLFWSharedContext: public vl::SharedContext
+  {
+  public:
+    GLFWSharedContext(vl::OpenGLContext* shared_with, GLFWwindow* share);
+
+    ~GLFWSharedContext();
+
+    bool makeCurrent();
+
+    void doneCurrent();
+
+    const GLFWwindow* handle() const { return mHandle; }
+
+    GLFWwindow* handle() { return mHandle; }
+
+  protected:
+    GLFWwindow* mHandle;
+  };
+
   //-----------------------------------------------------------------------------
   // GLFWWindow
   //-----------------------------------------------------------------------------
@@ -82,6 +109,10 @@ namespace vlGLFW
     }
 
     void makeCurrent();
+    void doneCurrent();
+
+    //! Creates a hidden GLFW window whose OpenGL context shares its resources with this window. Must be called from the main thread.
+    vl::ref<vl::SharedContext> createSharedContext();
 
     void update();
 
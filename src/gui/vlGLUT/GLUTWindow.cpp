@@ -786,7 +786,7 @@ void GLUTWindow::glut_idle_func()
   bool sleep = true;
   for(std::map< int, GLUTWindow* >::iterator it = mWinMap.begin(); it != mWinMap.end(); ++it)
   {
-    if (it->second->continuousUpdate())
+    if (it->second->continuousUpdate() && it->second->updateNeeded())
     {
       it->second->update();
       sleep = false;
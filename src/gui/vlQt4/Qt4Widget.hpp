@@ -60,9 +60,11 @@ namespace vlQt4
 
     Qt4Widget(QWidget* parent=NULL, const QGLWidget* shareWidget=NULL, Qt::WindowFlags f=0)
       :QGLWidget(parent,shareWidget,f),
-      mRefresh(10) // 100 fps
+      mRefresh(10), // 100 fps
+      mFlushScheduled(false)
     {
       setContinuousUpdate(true);
+      setInputEventCoalescing(true);
       setMouseTracking(true);
       setAutoBufferSwap(false);
       setAcceptDrops(true);
@@ -226,15 +228,15 @@ namespace vlQt4
       mContinuousUpdate = continuous;
       if (continuous)
       {
-        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
-        connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
+        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
+        connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
         mUpdateTimer.setSingleShot(false);
         mUpdateTimer.setInterval(mRefresh);
         mUpdateTimer.start(0);
       }
       else
       {
-        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
+        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
         mUpdateTimer.stop();
       }
     }
@@ -347,6 +349,7 @@ namespace vlQt4
       if (!mIgnoreNextMouseMoveEvent)
         dispatchMouseMoveEvent(ev->x(), ev->y());
       mIgnoreNextMouseMoveEvent = false;
+      scheduleInputEventsFlush();
     }
 
     void mousePressEvent(QMouseEvent* ev)
@@ -380,6 +383,7 @@ namespace vlQt4
     void wheelEvent(QWheelEvent* ev)
     {
       dispatchMouseWheelEvent(ev->delta() / 120);
+      scheduleInputEventsFlush();
     }
 
     void keyPressEvent(QKeyEvent* ev)
@@ -412,12 +416,37 @@ namespace vlQt4
       QGLWidget::setFocus(Qt::OtherFocusReason);
     }
 
+  protected slots:
+    //! Continuous update timer, redraws only if needed, see vl::OpenGLContext::setUpdateOnDemand().
+    void continuousUpdateEvent()
+    {
+      if ( updateNeeded() )
+        updateGL();
+    }
+
+    //! Dispatches the coalesced mouse events at most once per refresh period, see vl::OpenGLContext::setInputEventCoalescing().
+    void flushInputEventsTimeout()
+    {
+      mFlushScheduled = false;
+      flushInputEvents();
+    }
+
   protected:
     void translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, vl::EKey& key_out);
 
+    void scheduleInputEventsFlush()
+    {
+      if ( inputEventsPending() && !mFlushScheduled )
+      {
+        mFlushScheduled = true;
+        QTimer::singleShot(mRefresh, this, SLOT(flushInputEventsTimeout()));
+      }
+    }
+
   protected:
     int    mRefresh;
     QTimer mUpdateTimer;
+    bool   mFlushScheduled;
   };
   //-----------------------------------------------------------------------------
 }
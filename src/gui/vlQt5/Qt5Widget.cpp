@@ -35,7 +35,7 @@
 using namespace vl;
 using namespace vlQt5;
 
-void Qt5Widget::translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, EKey& key_out)
+void vlQt5::translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, EKey& key_out)
 {
   // translate non unicode characters
   key_out     = Key_None;
@@ -34,6 +34,7 @@
 
 #include <vlQt5/link_config.hpp>
 #include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/Log.hpp>
 #include <vlGraphics/OpenGLContext.hpp>
 #include <QApplication>
 #include <QMouseEvent>
@@ -44,9 +45,69 @@
 #include <QMimeData>
 #include <QGLWidget>
 #include <QGLFormat>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
 
 namespace vlQt5
 {
+  //! Translates a Qt key event into a Visualization Library key and unicode character.
+  VLQT5_EXPORT void translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, vl::EKey& key_out);
+//-----------------------------------------------------------------------------
+// Qt5SharedContext
+//-----------------------------------------------------------------------------
+  /** The Qt5SharedContext class implements a vl::SharedContext using a QOpenGLContext and a QOffscreenSurface.
+   * The offscreen surface is created by the GUI thread while the QOpenGLContext is created by the first call to
+   * makeCurrent() so that it belongs to the worker thread, as required by Qt.
+   * \sa Qt5Widget::createSharedContext() */
+  class Qt5SharedContext: public vl::SharedContext
+  {
+  public:
+    Qt5SharedContext(vl::OpenGLContext* shared_with, QOpenGLContext* share): vl::SharedContext(shared_with), mShare(share), mContext(NULL)
+    {
+      mSurface = new QOffscreenSurface;
+      mSurface->setFormat( share->format() );
+      mSurface->create();
+    }
+
+    ~Qt5SharedContext()
+    {
+      delete mContext;
+      delete mSurface;
+    }
+
+    bool makeCurrent()
+    {
+      if ( !mContext )
+      {
+        mContext = new QOpenGLContext;
+        mContext->setFormat( mShare->format() );
+        mContext->setShareContext( mShare );
+        if ( !mContext->create() )
+        {
+          vl::Log::error("Qt5SharedContext::makeCurrent(): shared OpenGL context creation failed.\n");
+          delete mContext;
+          mContext = NULL;
+          return false;
+        }
+      }
+      return mContext->makeCurrent( mSurface );
+    }
+
+    void doneCurrent()
+    {
+      if ( mContext )
+        mContext->doneCurrent();
+    }
+
+    QOpenGLContext* qtContext() { return mContext; }
+
+    QOffscreenSurface* qtSurface() { return mSurface; }
+
+  protected:
+    QOpenGLContext* mShare;
+    QOpenGLContext* mContext;
+    QOffscreenSurface* mSurface;
+  };
 //-----------------------------------------------------------------------------
 // Qt5Widget
 //-----------------------------------------------------------------------------
@@ -61,9 +122,11 @@ namespace vlQt5
 
     Qt5Widget(QWidget* parent=NULL, const QGLWidget* shareWidget=NULL, Qt::WindowFlags f=0)
       :QGLWidget(parent,shareWidget,f),
-      mRefresh(10) // 100 fps
+      mRefresh(10), // 100 fps
+      mFlushScheduled(false)
     {
       setContinuousUpdate(true);
+      setInputEventCoalescing(true);
       setMouseTracking(true);
       setAutoBufferSwap(false);
       setAcceptDrops(true);
@@ -225,15 +288,15 @@ namespace vlQt5
       mContinuousUpdate = continuous;
       if (continuous)
       {
-        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
-        connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
+        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
+        connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
         mUpdateTimer.setSingleShot(false);
         mUpdateTimer.setInterval(mRefresh);
         mUpdateTimer.start(0);
       }
       else
       {
-        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
+        disconnect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
         mUpdateTimer.stop();
       }
     }
@@ -336,6 +399,14 @@ namespace vlQt5
       QGLWidget::makeCurrent();
     }
 
+    //! Creates an auxiliary context sharing its resources with this widget. Must be called from the GUI thread.
+    vl::ref<vl::SharedContext> createSharedContext()
+    {
+      if ( !context() || !context()->contextHandle() )
+        return NULL;
+      return new Qt5SharedContext( this, context()->contextHandle() );
+    }
+
     void setMousePosition(int x, int y)
     {
       QCursor::setPos( mapToGlobal(QPoint(x,y)) );
@@ -346,6 +417,7 @@ namespace vlQt5
       if (!mIgnoreNextMouseMoveEvent)
         dispatchMouseMoveEvent(ev->x(), ev->y());
       mIgnoreNextMouseMoveEvent = false;
+      scheduleInputEventsFlush();
     }
 
     void mousePressEvent(QMouseEvent* ev)
@@ -379,6 +451,7 @@ namespace vlQt5
     void wheelEvent(QWheelEvent* ev)
     {
       dispatchMouseWheelEvent(ev->delta() / 120);
+      scheduleInputEventsFlush();
     }
 
     void keyPressEvent(QKeyEvent* ev)
@@ -411,12 +484,40 @@ namespace vlQt5
       QGLWidget::setFocus(Qt::OtherFocusReason);
     }
 
+  protected slots:
+    //! Continuous update timer, redraws only if needed, see vl::OpenGLContext::setUpdateOnDemand().
+    void continuousUpdateEvent()
+    {
+      if ( updateNeeded() )
+        updateGL();
+    }
+
+    //! Dispatches the coalesced mouse events at most once per refresh period, see vl::OpenGLContext::setInputEventCoalescing().
+    void flushInputEventsTimeout()
+    {
+      mFlushScheduled = false;
+      flushInputEvents();
+    }
+
   protected:
-    void translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, vl::EKey& key_out);
+    void translateKeyEvent(QKeyEvent* ev, unsigned short& unicode_out, vl::EKey& key_out)
+    {
+      vlQt5::translateKeyEvent(ev, unicode_out, key_out);
+    }
+
+    void scheduleInputEventsFlush()
+    {
+      if ( inputEventsPending() && !mFlushScheduled )
+      {
+        mFlushScheduled = true;
+        QTimer::singleShot(mRefresh, this, SLOT(flushInputEventsTimeout()));
+      }
+    }
 
   protected:
     int    mRefresh;
     QTimer mUpdateTimer;
+    bool   mFlushScheduled;
   };
   //-----------------------------------------------------------------------------
 }
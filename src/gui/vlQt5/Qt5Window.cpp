@@ -0,0 +1,627 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlQt5/Qt5Window.hpp>
+#include <vlCore/Log.hpp>
+#include <QThread>
+#include <QCursor>
+#include <QCoreApplication>
+#include <QExposeEvent>
+#include <QResizeEvent>
+#include <limits.h>
+
+using namespace vl;
+using namespace vlQt5;
+
+namespace vlQt5
+{
+//-----------------------------------------------------------------------------
+// Qt5SurfaceWindow
+//-----------------------------------------------------------------------------
+  //! The QWindow used as OpenGL surface by Qt5Window: forwards its events to the owner.
+  //! Qt5Window cannot derive from QWindow since QSurface::size() clashes with vl::OpenGLContext::size().
+  class Qt5SurfaceWindow: public QWindow
+  {
+  public:
+    Qt5SurfaceWindow(Qt5Window* owner, QWindow* parent): QWindow(parent), mOwner(owner)
+    {
+      setSurfaceType(QWindow::OpenGLSurface);
+    }
+
+  protected:
+    bool event(QEvent* ev)
+    {
+      if ( ev->type() == QEvent::UpdateRequest )
+      {
+        mOwner->renderNow();
+        return true;
+      }
+      return QWindow::event(ev);
+    }
+
+    void exposeEvent(QExposeEvent*)           { mOwner->exposeEvent(); }
+    void resizeEvent(QResizeEvent* ev)        { mOwner->resizeEvent( ev->size().width(), ev->size().height() ); }
+    void mouseMoveEvent(QMouseEvent* ev)      { mOwner->mouseMoveEvent(ev); }
+    void mousePressEvent(QMouseEvent* ev)     { mOwner->mouseButtonEvent(ev, true); }
+    void mouseReleaseEvent(QMouseEvent* ev)   { mOwner->mouseButtonEvent(ev, false); }
+    void wheelEvent(QWheelEvent* ev)          { mOwner->wheelEvent(ev); }
+    void keyPressEvent(QKeyEvent* ev)         { mOwner->keyEvent(ev, true); }
+    void keyReleaseEvent(QKeyEvent* ev)       { mOwner->keyEvent(ev, false); }
+
+  protected:
+    Qt5Window* mOwner;
+  };
+//-----------------------------------------------------------------------------
+// Qt5RenderThread
+//-----------------------------------------------------------------------------
+  //! The dedicated render thread of Qt5Window, see Qt5Window::setThreadedRendering().
+  class Qt5RenderThread: public QThread
+  {
+  public:
+    Qt5RenderThread(Qt5Window* owner): mOwner(owner) {}
+
+  protected:
+    void run() { mOwner->renderThreadLoop(); }
+
+  protected:
+    Qt5Window* mOwner;
+  };
+}
+//-----------------------------------------------------------------------------
+// Qt5Window
+//-----------------------------------------------------------------------------
+Qt5Window::Qt5Window(QWindow* parent)
+  :mContext(NULL),
+  mRenderThread(NULL),
+  mRefresh(10), // 100 fps
+  mThreadedRendering(false),
+  mFlushScheduled(false),
+  mGLInitialized(false),
+  mUpdateRequested(false),
+  mStopRendering(false)
+{
+  mWindow = new Qt5SurfaceWindow(this, parent);
+  connect(&mUpdateTimer, SIGNAL(timeout()), this, SLOT(continuousUpdateEvent()));
+  setContinuousUpdate(true);
+  setInputEventCoalescing(true);
+}
+//-----------------------------------------------------------------------------
+Qt5Window::~Qt5Window()
+{
+  mUpdateTimer.stop();
+  if (mRenderThread)
+    // the render thread dispatches the destroy event before exiting
+    stopRenderThread();
+  else
+  if (mGLInitialized)
+    dispatchDestroyEvent();
+  else
+    eraseAllEventListeners();
+  delete mContext;
+  delete mWindow;
+}
+//-----------------------------------------------------------------------------
+bool Qt5Window::initQt5Window(const vl::String& title, const vl::OpenGLContextFormat& info, QOpenGLContext* share_context, int x, int y, int width, int height)
+{
+  if (mContext)
+  {
+    Log::error("Qt5Window::initQt5Window(): OpenGL context already created.\n");
+    return false;
+  }
+
+  QSurfaceFormat fmt;
+
+  switch( info.openGLProfile() )
+  {
+  case vl::GLP_Compatibility:
+    fmt.setProfile( QSurfaceFormat::CompatibilityProfile );
+    fmt.setVersion( info.majVersion(), info.minVersion() );
+    break;
+  case vl::GLP_Core:
+    fmt.setProfile( QSurfaceFormat::CoreProfile );
+    fmt.setVersion( info.majVersion(), info.minVersion() );
+    break;
+  case vl::GLP_Default:
+    // Don't care
+    break;
+  }
+
+  // double buffer
+  fmt.setSwapBehavior( info.doubleBuffer() ? QSurfaceFormat::DoubleBuffer : QSurfaceFormat::SingleBuffer );
+
+  // color buffer
+  fmt.setRedBufferSize( info.rgbaBits().r() );
+  fmt.setGreenBufferSize( info.rgbaBits().g() );
+  fmt.setBlueBufferSize( info.rgbaBits().b() );
+  fmt.setAlphaBufferSize( info.rgbaBits().a() );
+
+  // multisampling
+  if (info.multisample())
+    fmt.setSamples( info.multisampleSamples() );
+
+  // depth and stencil buffers
+  fmt.setDepthBufferSize( info.depthBufferBits() );
+  fmt.setStencilBufferSize( info.stencilBufferBits() );
+
+  // stereo
+  fmt.setStereo( info.stereo() );
+
+  // swap interval / v-sync
+  fmt.setSwapInterval( info.vSync() ? 1 : 0 );
+
+  // note: QSurfaceFormat does not support accumulation buffers
+
+  mWindow->setFormat(fmt);
+  mWindow->create();
+
+  mContext = new QOpenGLContext;
+  mContext->setFormat(fmt);
+  if (share_context)
+    mContext->setShareContext(share_context);
+  if ( !mContext->create() )
+  {
+    Log::error("Qt5Window::initQt5Window(): OpenGL context creation failed.\n");
+    delete mContext;
+    mContext = NULL;
+    return false;
+  }
+
+  if ( mThreadedRendering && !QOpenGLContext::supportsThreadedOpenGL() )
+  {
+    Log::warning("Qt5Window::initQt5Window(): threaded OpenGL not supported, rendering from the GUI thread.\n");
+    mThreadedRendering = false;
+  }
+
+  if (mThreadedRendering)
+    mUpdateTimer.stop();
+
+  framebuffer()->setWidth(width);
+  framebuffer()->setHeight(height);
+
+  setWindowTitle(title);
+  mWindow->setGeometry(x, y, width, height);
+
+  if (info.fullscreen())
+    setFullscreen(true);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+QWindow* Qt5Window::qtWindow()
+{
+  return mWindow;
+}
+//-----------------------------------------------------------------------------
+vl::ref<vl::SharedContext> Qt5Window::createSharedContext()
+{
+  if ( !mContext )
+    return NULL;
+  return new Qt5SharedContext( this, mContext );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setRefreshRate( int msec )
+{
+  mRefresh = msec;
+  if ( !isRenderThread() )
+    mUpdateTimer.setInterval(mRefresh);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setContinuousUpdate(bool continuous)
+{
+  mContinuousUpdate = continuous;
+  if (mThreadedRendering)
+  {
+    // the render thread takes care of the continuous update
+    QMutexLocker lock(&mMutex);
+    mWakeUp.wakeAll();
+  }
+  else
+  if (continuous)
+  {
+    mUpdateTimer.setSingleShot(false);
+    mUpdateTimer.setInterval(mRefresh);
+    mUpdateTimer.start(0);
+  }
+  else
+    mUpdateTimer.stop();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::update()
+{
+  if (mThreadedRendering)
+  {
+    QMutexLocker lock(&mMutex);
+    mUpdateRequested = true;
+    mWakeUp.wakeAll();
+  }
+  else
+    mWindow->requestUpdate();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::swapBuffers()
+{
+  if ( mContext )
+    mContext->swapBuffers(mWindow);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::makeCurrent()
+{
+  // once the render thread is running the context can be made current only by the render thread
+  if ( mContext && (!mRenderThread || isRenderThread()) )
+    mContext->makeCurrent(mWindow);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setWindowTitle(const vl::String& title)
+{
+  QString qtitle = QString::fromStdString( title.toStdString() );
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyWindowTitle", Qt::QueuedConnection, Q_ARG(QString, qtitle));
+  else
+    applyWindowTitle(qtitle);
+}
+//-----------------------------------------------------------------------------
+bool Qt5Window::setFullscreen(bool fullscreen)
+{
+  mFullscreen = fullscreen;
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyFullscreen", Qt::QueuedConnection, Q_ARG(bool, fullscreen));
+  else
+    applyFullscreen(fullscreen);
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::quitApplication()
+{
+  eraseAllEventListeners();
+  QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::show()
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyVisible", Qt::QueuedConnection, Q_ARG(bool, true));
+  else
+    applyVisible(true);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::hide()
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyVisible", Qt::QueuedConnection, Q_ARG(bool, false));
+  else
+    applyVisible(false);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setPosition(int x, int y)
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyPosition", Qt::QueuedConnection, Q_ARG(int, x), Q_ARG(int, y));
+  else
+    applyPosition(x, y);
+}
+//-----------------------------------------------------------------------------
+vl::ivec2 Qt5Window::position() const
+{
+  return vl::ivec2( mWindow->x(), mWindow->y() );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setSize(int w, int h)
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applySize", Qt::QueuedConnection, Q_ARG(int, w), Q_ARG(int, h));
+  else
+    applySize(w, h);
+}
+//-----------------------------------------------------------------------------
+vl::ivec2 Qt5Window::size() const
+{
+  // this already excludes the window's frame so it's ok for Visualization Library standards
+  return vl::ivec2( mWindow->width(), mWindow->height() );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setMouseVisible(bool visible)
+{
+  mMouseVisible = visible;
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyMouseVisible", Qt::QueuedConnection, Q_ARG(bool, visible));
+  else
+    applyMouseVisible(visible);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::setMousePosition(int x, int y)
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyMousePosition", Qt::QueuedConnection, Q_ARG(int, x), Q_ARG(int, y));
+  else
+    applyMousePosition(x, y);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::getFocus()
+{
+  if ( isRenderThread() )
+    QMetaObject::invokeMethod(this, "applyFocus", Qt::QueuedConnection);
+  else
+    applyFocus();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyWindowTitle(QString title)
+{
+  mWindow->setTitle(title);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyFullscreen(bool fullscreen)
+{
+  mWindow->setWindowState( fullscreen ? Qt::WindowFullScreen : Qt::WindowNoState );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyVisible(bool visible)
+{
+  mWindow->setVisible(visible);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyPosition(int x, int y)
+{
+  mWindow->setPosition(x, y);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applySize(int w, int h)
+{
+  mWindow->resize(w, h);
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyMouseVisible(bool visible)
+{
+  mWindow->setCursor( visible ? Qt::ArrowCursor : Qt::BlankCursor );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyMousePosition(int x, int y)
+{
+  // from framebuffer pixels to device independent pixels
+  qreal dpr = mWindow->devicePixelRatio();
+  QCursor::setPos( mWindow->mapToGlobal( QPoint( qRound(x / dpr), qRound(y / dpr) ) ) );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::applyFocus()
+{
+  mWindow->requestActivate();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::continuousUpdateEvent()
+{
+  if ( !mThreadedRendering && updateNeeded() )
+    mWindow->requestUpdate();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::flushInputEventsTimeout()
+{
+  mFlushScheduled = false;
+  if ( !mThreadedRendering )
+    flushInputEvents();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::scheduleInputEventsFlush()
+{
+  if ( inputEventsPending() && !mFlushScheduled )
+  {
+    mFlushScheduled = true;
+    QTimer::singleShot(mRefresh, this, SLOT(flushInputEventsTimeout()));
+  }
+}
+//-----------------------------------------------------------------------------
+bool Qt5Window::isRenderThread() const
+{
+  return mRenderThread && QThread::currentThread() == mRenderThread;
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::exposeEvent()
+{
+  renderNow();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::resizeEvent(int w, int h)
+{
+  // the framebuffer is measured in physical pixels
+  qreal dpr = mWindow->devicePixelRatio();
+  w = qRound(w * dpr);
+  h = qRound(h * dpr);
+
+  if ( mRenderThread )
+    postEvent( QueuedEvent(QueuedEvent::Resize, w, h) );
+  else
+  if ( mGLInitialized )
+    dispatchResizeEvent(w, h);
+  else
+  {
+    // dispatched after the init event
+    framebuffer()->setWidth(w);
+    framebuffer()->setHeight(h);
+  }
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::mouseMoveEvent(QMouseEvent* ev)
+{
+  qreal dpr = mWindow->devicePixelRatio();
+  postEvent( QueuedEvent(QueuedEvent::MouseMove, qRound(ev->x() * dpr), qRound(ev->y() * dpr)) );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::mouseButtonEvent(QMouseEvent* ev, bool pressed)
+{
+  vl::EMouseButton bt = vl::NoButton;
+  switch(ev->button())
+  {
+  case Qt::LeftButton:  bt = vl::LeftButton; break;
+  case Qt::RightButton: bt = vl::RightButton; break;
+  case Qt::MidButton:   bt = vl::MiddleButton; break;
+  default:
+    bt = vl::UnknownButton; break;
+  }
+  qreal dpr = mWindow->devicePixelRatio();
+  postEvent( QueuedEvent(pressed ? QueuedEvent::MouseDown : QueuedEvent::MouseUp, qRound(ev->x() * dpr), qRound(ev->y() * dpr), bt) );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::wheelEvent(QWheelEvent* ev)
+{
+  postEvent( QueuedEvent(QueuedEvent::MouseWheel, ev->delta() / 120) );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::keyEvent(QKeyEvent* ev, bool pressed)
+{
+  unsigned short unicode_ch = 0;
+  vl::EKey key = vl::Key_None;
+  translateKeyEvent(ev, unicode_ch, key);
+  postEvent( QueuedEvent(pressed ? QueuedEvent::KeyPress : QueuedEvent::KeyRelease, unicode_ch, key) );
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::postEvent(const QueuedEvent& ev)
+{
+  if ( mThreadedRendering )
+  {
+    // delivered by the render thread before the next frame, also before the render thread is started
+    QMutexLocker lock(&mMutex);
+    mEventQueue.push_back(ev);
+    mWakeUp.wakeAll();
+  }
+  else
+  {
+    dispatchQueuedEvent(ev);
+    scheduleInputEventsFlush();
+  }
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::dispatchQueuedEvent(const QueuedEvent& ev)
+{
+  switch(ev.mType)
+  {
+  case QueuedEvent::MouseMove:  dispatchMouseMoveEvent(ev.mA, ev.mB); break;
+  case QueuedEvent::MouseDown:  dispatchMouseDownEvent((vl::EMouseButton)ev.mC, ev.mA, ev.mB); break;
+  case QueuedEvent::MouseUp:    dispatchMouseUpEvent((vl::EMouseButton)ev.mC, ev.mA, ev.mB); break;
+  case QueuedEvent::MouseWheel: dispatchMouseWheelEvent(ev.mA); break;
+  case QueuedEvent::KeyPress:   dispatchKeyPressEvent((unsigned short)ev.mA, (vl::EKey)ev.mB); break;
+  case QueuedEvent::KeyRelease: dispatchKeyReleaseEvent((unsigned short)ev.mA, (vl::EKey)ev.mB); break;
+  case QueuedEvent::Resize:     dispatchResizeEvent(ev.mA, ev.mB); break;
+  }
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::renderNow()
+{
+  if ( !mContext || !mWindow->isExposed() )
+    return;
+
+  if ( mThreadedRendering )
+  {
+    if ( !mRenderThread )
+      startRenderThread();
+    else
+      update();
+    return;
+  }
+
+  if ( !mGLInitialized )
+  {
+    mContext->makeCurrent(mWindow);
+    // OpenGL extensions initialization
+    initGLContext();
+    mGLInitialized = true;
+    dispatchInitEvent();
+    dispatchResizeEvent( framebuffer()->width(), framebuffer()->height() );
+  }
+
+  dispatchUpdateEvent();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::startRenderThread()
+{
+  qreal dpr = mWindow->devicePixelRatio();
+  framebuffer()->setWidth( qRound(mWindow->width() * dpr) );
+  framebuffer()->setHeight( qRound(mWindow->height() * dpr) );
+
+  mStopRendering = false;
+  mUpdateRequested = true;
+  mRenderThread = new Qt5RenderThread(this);
+  mContext->moveToThread(mRenderThread);
+  mRenderThread->start();
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::stopRenderThread()
+{
+  {
+    QMutexLocker lock(&mMutex);
+    mStopRendering = true;
+    mWakeUp.wakeAll();
+  }
+  mRenderThread->wait();
+  delete mRenderThread;
+  mRenderThread = NULL;
+}
+//-----------------------------------------------------------------------------
+void Qt5Window::renderThreadLoop()
+{
+  mContext->makeCurrent(mWindow);
+  // OpenGL extensions initialization
+  initGLContext();
+  mGLInitialized = true;
+  dispatchInitEvent();
+  dispatchResizeEvent( framebuffer()->width(), framebuffer()->height() );
+
+  std::vector<QueuedEvent> events;
+  for(;;)
+  {
+    bool update_requested = false;
+    {
+      QMutexLocker lock(&mMutex);
+      bool idle = mEventQueue.empty() && !mUpdateRequested && !mStopRendering;
+      if ( idle && !(continuousUpdate() && updateNeeded()) )
+        mWakeUp.wait( &mMutex, continuousUpdate() ? (unsigned long)mRefresh : ULONG_MAX );
+      if ( mStopRendering )
+        break;
+      events.swap(mEventQueue);
+      update_requested = mUpdateRequested;
+      mUpdateRequested = false;
+    }
+
+    for( size_t i=0; i<events.size(); ++i )
+      dispatchQueuedEvent(events[i]);
+    events.clear();
+
+    // the swap interval throttles the continuous update
+    if ( update_requested || (continuousUpdate() && updateNeeded()) )
+      dispatchUpdateEvent();
+    else
+      flushInputEvents();
+  }
+
+  dispatchDestroyEvent();
+  mGLInitialized = false;
+  mContext->doneCurrent();
+  // give the context back to the GUI thread which will delete it
+  mContext->moveToThread( QCoreApplication::instance()->thread() );
+}
+//-----------------------------------------------------------------------------
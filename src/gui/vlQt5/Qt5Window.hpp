@@ -0,0 +1,213 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef Qt5OpenGLWindow_INCLUDE_ONCE
+#define Qt5OpenGLWindow_INCLUDE_ONCE
+
+#include <vlQt5/Qt5Widget.hpp>
+#include <QWindow>
+#include <QSurfaceFormat>
+#include <QMutex>
+#include <QWaitCondition>
+#include <vector>
+
+namespace vlQt5
+{
+  class Qt5RenderThread;
+  class Qt5SurfaceWindow;
+//-----------------------------------------------------------------------------
+// Qt5Window
+//-----------------------------------------------------------------------------
+  /** The Qt5Window class implements an OpenGLContext using a QWindow and a QOpenGLContext, the same building blocks
+   * used by QOpenGLWindow, without going through the deprecated QGLWidget. Use qtWindow() to access the QWindow,
+   * for example to embed it in a widget hierarchy with QWidget::createWindowContainer().
+   *
+   * By default the rendering happens in the GUI thread like with Qt5Widget. If setThreadedRendering() is enabled
+   * before initQt5Window() the OpenGL context is moved to a dedicated render thread: the init, resize, input, update
+   * and destroy events are all dispatched from the render thread so that the UIEventListener objects never see two
+   * threads at once. The input events are queued by the GUI thread and delivered before the next frame, the window
+   * related requests issued by the listeners (setWindowTitle(), setSize(), quitApplication() etc.) are forwarded to
+   * the GUI thread. The swap interval is set with vl::OpenGLContextFormat::setVSync() and is the one throttling the
+   * render thread during the continuous update.
+   *
+   * Use createSharedContext() from the GUI thread to obtain a context sharing its resources with this window,
+   * for example to upload textures and buffers from a worker thread.
+   * \note Drag & drop is not supported by QWindow, use Qt5Widget if you need vl::UIEventListener::fileDroppedEvent(). */
+  class VLQT5_EXPORT Qt5Window : public QObject, public vl::OpenGLContext
+  {
+    Q_OBJECT
+
+    friend class Qt5RenderThread;
+    friend class Qt5SurfaceWindow;
+
+  public:
+    using vl::Object::setObjectName;
+    using QObject::setObjectName;
+
+    Qt5Window(QWindow* parent=NULL);
+
+    ~Qt5Window();
+
+    //! Creates the OpenGL context and sets the window properties.
+    //! \param share_context If not NULL the new OpenGL context will share its resources with \p share_context.
+    bool initQt5Window(const vl::String& title, const vl::OpenGLContextFormat& info, QOpenGLContext* share_context=NULL, int x=0, int y=0, int width=640, int height=480);
+
+    //! If enabled the rendering is performed by a dedicated thread, see the class documentation.
+    //! Must be called before initQt5Window(). Ignored if the platform does not support threaded OpenGL.
+    void setThreadedRendering(bool threaded) { mThreadedRendering = threaded; }
+
+    //! Whether the rendering is performed by a dedicated thread, see setThreadedRendering().
+    bool threadedRendering() const { return mThreadedRendering; }
+
+    //! The window used as OpenGL surface.
+    QWindow* qtWindow();
+
+    //! The underlying Qt OpenGL context, NULL before initQt5Window().
+    QOpenGLContext* qtContext() { return mContext; }
+
+    //! The swap interval obtained from the platform, 0 if v-sync is disabled.
+    int swapInterval() const { return mContext ? mContext->format().swapInterval() : 0; }
+
+    //! Creates an auxiliary context sharing its resources with this window. Must be called from the GUI thread.
+    vl::ref<vl::SharedContext> createSharedContext();
+
+    void setRefreshRate( int msec );
+
+    int refreshRate() const { return mRefresh; }
+
+    // --- vl::OpenGLContext ---
+
+    virtual void setContinuousUpdate(bool continuous);
+
+    void update();
+
+    void swapBuffers();
+
+    void makeCurrent();
+
+    virtual void setWindowTitle(const vl::String& title);
+
+    virtual bool setFullscreen(bool fullscreen);
+
+    virtual void quitApplication();
+
+    virtual void show();
+
+    virtual void hide();
+
+    virtual void setPosition(int x, int y);
+
+    virtual vl::ivec2 position() const;
+
+    virtual void setSize(int w, int h);
+
+    virtual vl::ivec2 size() const;
+
+    virtual void setMouseVisible(bool visible);
+
+    virtual void setMousePosition(int x, int y);
+
+    virtual void getFocus();
+
+  protected:
+    // --- events forwarded by Qt5SurfaceWindow ---
+
+    void exposeEvent();
+
+    void resizeEvent(int w, int h);
+
+    void mouseMoveEvent(QMouseEvent* ev);
+
+    void mouseButtonEvent(QMouseEvent* ev, bool pressed);
+
+    void wheelEvent(QWheelEvent* ev);
+
+    void keyEvent(QKeyEvent* ev, bool pressed);
+
+  protected slots:
+    //! Continuous update timer of the GUI thread rendering, redraws only if needed, see vl::OpenGLContext::setUpdateOnDemand().
+    void continuousUpdateEvent();
+
+    //! Dispatches the coalesced mouse events at most once per refresh period, see vl::OpenGLContext::setInputEventCoalescing().
+    void flushInputEventsTimeout();
+
+    // Window requests forwarded from the render thread.
+    void applyWindowTitle(QString title);
+    void applyFullscreen(bool fullscreen);
+    void applyVisible(bool visible);
+    void applyPosition(int x, int y);
+    void applySize(int w, int h);
+    void applyMouseVisible(bool visible);
+    void applyMousePosition(int x, int y);
+    void applyFocus();
+
+  protected:
+    //! An input or resize event queued by the GUI thread for the render thread.
+    struct QueuedEvent
+    {
+      enum EType { MouseMove, MouseDown, MouseUp, MouseWheel, KeyPress, KeyRelease, Resize };
+
+      QueuedEvent(EType type, int a=0, int b=0, int c=0): mType(type), mA(a), mB(b), mC(c) {}
+
+      EType mType;
+      int mA, mB, mC;
+    };
+
+    bool isRenderThread() const;
+    void postEvent(const QueuedEvent& ev);
+    void dispatchQueuedEvent(const QueuedEvent& ev);
+    void renderNow();
+    void startRenderThread();
+    void stopRenderThread();
+    void renderThreadLoop();
+    void scheduleInputEventsFlush();
+
+  protected:
+    Qt5SurfaceWindow* mWindow;
+    QOpenGLContext* mContext;
+    Qt5RenderThread* mRenderThread;
+    QTimer mUpdateTimer;
+    int mRefresh;
+    bool mThreadedRendering;
+    bool mFlushScheduled;
+    bool mGLInitialized;
+
+    // render thread state, protected by mMutex
+    QMutex mMutex;
+    QWaitCondition mWakeUp;
+    std::vector<QueuedEvent> mEventQueue;
+    bool mUpdateRequested;
+    bool mStopRendering;
+  };
+  //-----------------------------------------------------------------------------
+}
+
+#endif
@@ -168,6 +168,7 @@ SDL_Surface* SDLWindow::mScreen = NULL;
 //-----------------------------------------------------------------------------
 SDLWindow::SDLWindow()
 {
+  setInputEventCoalescing(true);
 }
 //-----------------------------------------------------------------------------
 SDLWindow::~SDLWindow()
@@ -176,6 +177,7 @@ SDLWindow::~SDLWindow()
 //-----------------------------------------------------------------------------
 SDLWindow::SDLWindow( const vl::String& title, const vl::OpenGLContextFormat& info, int /*x*/, int /*y*/, int width, int height)
 {
+  setInputEventCoalescing(true);
   initSDLWindow(title, info, width, height);
 }
 //-----------------------------------------------------------------------------
@@ -451,7 +453,10 @@ void vlSDL::messageLoop()
       mSDLWindow->translateEvent(&ev);
     else
     {
-      if ( mUpdateFlag || mSDLWindow->continuousUpdate() )
+      // the event queue is empty: dispatch the coalesced mouse events
+      mSDLWindow->flushInputEvents();
+
+      if ( mUpdateFlag || (mSDLWindow->continuousUpdate() && mSDLWindow->updateNeeded()) )
       {
         mSDLWindow->dispatchUpdateEvent();
         mUpdateFlag = false;
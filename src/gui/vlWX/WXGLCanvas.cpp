@@ -96,7 +96,16 @@ void WXGLCanvas::OnDropFiles(wxDropFilesEvent& ev)
 void WXGLCanvas::OnIdle(wxIdleEvent& ev)
 {
   if (continuousUpdate())
-    Refresh(false);
+  {
+    if (updateNeeded())
+      Refresh(false);
+    else
+    {
+      // on-demand update: keep polling the scene changes without spinning
+      Time::sleep(10);
+      ev.RequestMore();
+    }
+  }
   /*else
     Time::sleep(1);*/
 }
@@ -36,6 +36,31 @@
 using namespace vl;
 using namespace vlWin32;
 
+//-----------------------------------------------------------------------------
+// Win32SharedContext
+//-----------------------------------------------------------------------------
+Win32SharedContext::~Win32SharedContext()
+{
+  if (mHGLRC)
+  {
+    if (wglGetCurrentContext() == mHGLRC)
+      wglMakeCurrent(NULL, NULL);
+    wglDeleteContext(mHGLRC);
+    mHGLRC = NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+bool Win32SharedContext::makeCurrent()
+{
+  return mHDC && mHGLRC && wglMakeCurrent(mHDC, mHGLRC) != FALSE;
+}
+//-----------------------------------------------------------------------------
+void Win32SharedContext::doneCurrent()
+{
+  wglMakeCurrent(NULL, NULL);
+}
+//-----------------------------------------------------------------------------
+// Win32Context
 //-----------------------------------------------------------------------------
 Win32Context::~Win32Context()
 {
@@ -53,6 +78,42 @@ void Win32Context::makeCurrent()
     wglMakeCurrent(mHDC, mHGLRC);
 }
 //-----------------------------------------------------------------------------
+void Win32Context::doneCurrent()
+{
+  wglMakeCurrent(NULL, NULL);
+}
+//-----------------------------------------------------------------------------
+vl::ref<vl::SharedContext> Win32Context::createSharedContext()
+{
+  if (!mHDC || !mHGLRC)
+    return NULL;
+
+  HGLRC hglrc = NULL;
+  if (wglCreateContextAttribsARB && mContextAttribs.size() > 1)
+  {
+    VL_CHECK(mContextAttribs.back() == 0);
+    hglrc = wglCreateContextAttribsARB(mHDC, mHGLRC, &mContextAttribs[0]);
+  }
+  else
+  {
+    hglrc = wglCreateContext(mHDC);
+    // the new context has no resources yet so this can't fail because of name clashes.
+    if (hglrc && wglShareLists(mHGLRC, hglrc) == FALSE)
+    {
+      wglDeleteContext(hglrc);
+      hglrc = NULL;
+    }
+  }
+
+  if (!hglrc)
+  {
+    vl::Log::error("Win32Context::createSharedContext(): shared OpenGL context creation failed.\n");
+    return NULL;
+  }
+
+  return new Win32SharedContext(this, mHDC, hglrc);
+}
+//-----------------------------------------------------------------------------
 void Win32Context::update()
 {
   if (hwnd())
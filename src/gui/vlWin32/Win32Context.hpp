@@ -39,6 +39,31 @@ namespace vlWin32
 {
 //-----------------------------------------------------------------------------
   VLWIN32_EXPORT int choosePixelFormat(const vl::OpenGLContextFormat& fmt, bool verbose = true);
+//-----------------------------------------------------------------------------
+  /**
+   * The Win32SharedContext class implements a vl::SharedContext using a WGL context sharing its resources with a Win32Context.
+   * The context uses the device context of the window it is shared with, which has the right pixel format.
+   * \sa Win32Context::createSharedContext()
+   */
+  class VLWIN32_EXPORT Win32SharedContext: public vl::SharedContext
+  {
+  public:
+    Win32SharedContext(vl::OpenGLContext* shared_with, HDC hdc, HGLRC hglrc): vl::SharedContext(shared_with), mHDC(hdc), mHGLRC(hglrc) {}
+
+    ~Win32SharedContext();
+
+    bool makeCurrent();
+
+    void doneCurrent();
+
+    HDC   hdc()   const { return mHDC;   }
+
+    HGLRC hglrc() const { return mHGLRC; }
+
+  protected:
+    HDC   mHDC;
+    HGLRC mHGLRC;
+  };
 //-----------------------------------------------------------------------------
   /**
    * The Win32Context class implements an OpenGLContext using the Win32 API.
@@ -66,6 +91,10 @@ namespace vlWin32
     void shareOpenGLResources(HGLRC hGLRC);
 
     void makeCurrent();
+    void doneCurrent();
+
+    //! Creates a WGL context sharing its resources with this one, using the same context attributes (see contextAttribs()).
+    vl::ref<vl::SharedContext> createSharedContext();
 
     void update();
 
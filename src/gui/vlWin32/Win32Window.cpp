@@ -253,6 +253,7 @@ Win32Window::Win32Window()
   mHDC   = NULL;
   mHGLRC = NULL;
   mMouseDownCount = 0;
+  setInputEventCoalescing(true);
 
   mStyle   = WS_OVERLAPPEDWINDOW | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
   mExStyle = WS_EX_APPWINDOW | WS_EX_ACCEPTFILES;
@@ -340,7 +341,9 @@ void vlWin32::dispatchUpdate()
        ++it )
   {
     Win32Window* win = it->second;
-    if ( win->continuousUpdate() )
+    // the message queue is empty: dispatch the coalesced mouse events
+    win->flushInputEvents();
+    if ( win->continuousUpdate() && win->updateNeeded() )
       win->update();
     else
       Sleep(10);
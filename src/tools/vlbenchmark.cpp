@@ -0,0 +1,491 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <EGL/egl.h>
+#include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/Time.hpp>
+#include <vlCore/Colors.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/SceneManagerActorTree.hpp>
+#include <vlGraphics/SceneManagerActorKdTree.hpp>
+#include <vlGraphics/GeometryPrimitives.hpp>
+#include <vlGraphics/FrameProfiler.hpp>
+#include <vlGraphics/Light.hpp>
+
+using namespace vl;
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+  #define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef EGLDisplay (EGLAPIENTRY *PFN_eglGetPlatformDisplayEXT)(EGLenum platform, void* native_display, const EGLint* attrib_list);
+
+//-----------------------------------------------------------------------------
+// HeadlessContext
+//-----------------------------------------------------------------------------
+// An OpenGLContext rendering to an EGL pbuffer, no window system required.
+class HeadlessContext: public OpenGLContext
+{
+public:
+  HeadlessContext(): mDisplay(EGL_NO_DISPLAY), mSurface(EGL_NO_SURFACE), mContext(EGL_NO_CONTEXT) {}
+
+  ~HeadlessContext() { destroy(); }
+
+  bool init(int width, int height)
+  {
+    // prefer the surfaceless platform which works without a display server, fall back to the default display
+    PFN_eglGetPlatformDisplayEXT get_platform_display = (PFN_eglGetPlatformDisplayEXT)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (get_platform_display)
+      mDisplay = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    EGLint major = 0, minor = 0;
+    if ( mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, &major, &minor) )
+    {
+      mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+      if ( mDisplay == EGL_NO_DISPLAY || !eglInitialize(mDisplay, &major, &minor) )
+      {
+        Log::error( Say("HeadlessContext: EGL initialization failed (0x%hn).\n") << eglGetError() );
+        return false;
+      }
+    }
+
+    const EGLint config_attribs[] =
+    {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_NONE
+    };
+    EGLConfig config = NULL;
+    EGLint config_count = 0;
+    if ( !eglChooseConfig(mDisplay, config_attribs, &config, 1, &config_count) || config_count == 0 )
+    {
+      Log::error("HeadlessContext: no EGL configuration supports desktop OpenGL pbuffers.\n");
+      return false;
+    }
+
+    const EGLint pbuffer_attribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    mSurface = eglCreatePbufferSurface(mDisplay, config, pbuffer_attribs);
+    eglBindAPI(EGL_OPENGL_API);
+    mContext = eglCreateContext(mDisplay, config, EGL_NO_CONTEXT, NULL);
+    if ( mSurface == EGL_NO_SURFACE || mContext == EGL_NO_CONTEXT )
+    {
+      Log::error( Say("HeadlessContext: could not create the pbuffer or the context (0x%hn).\n") << eglGetError() );
+      return false;
+    }
+
+    makeCurrent();
+    if ( !initGLContext(false) )
+      return false;
+    framebuffer()->setWidth(width);
+    framebuffer()->setHeight(height);
+    return true;
+  }
+
+  void destroy()
+  {
+    if ( mDisplay == EGL_NO_DISPLAY )
+      return;
+    if ( mContext != EGL_NO_CONTEXT )
+      dispatchDestroyEvent();
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if ( mContext != EGL_NO_CONTEXT )
+      eglDestroyContext(mDisplay, mContext);
+    if ( mSurface != EGL_NO_SURFACE )
+      eglDestroySurface(mDisplay, mSurface);
+    eglTerminate(mDisplay);
+    mDisplay = EGL_NO_DISPLAY;
+    mSurface = EGL_NO_SURFACE;
+    mContext = EGL_NO_CONTEXT;
+  }
+
+  void swapBuffers() { eglSwapBuffers(mDisplay, mSurface); }
+
+  void makeCurrent() { eglMakeCurrent(mDisplay, mSurface, mSurface, mContext); }
+
+  void update() {}
+
+protected:
+  EGLDisplay mDisplay;
+  EGLSurface mSurface;
+  EGLContext mContext;
+};
+
+//-----------------------------------------------------------------------------
+struct BenchmarkOptions
+{
+  BenchmarkOptions(): width(1280), height(720), frames(300), warmup(20), threads(1), kdtree(true)
+  {
+    scales.push_back(1000);
+    scales.push_back(100000);
+    scales.push_back(1000000);
+    materials.push_back(1);
+    materials.push_back(64);
+  }
+
+  std::vector<int> scales;
+  std::vector<int> materials;
+  int width;
+  int height;
+  int frames;
+  int warmup;
+  int threads;
+  bool kdtree;
+  String out_file;
+  String trace_prefix;
+};
+
+//-----------------------------------------------------------------------------
+// Summary of a series of samples.
+struct SampleStats
+{
+  SampleStats(): count(0), mean(0), median(0), p95(0), min(0), max(0) {}
+
+  SampleStats(std::vector<double> samples): count((int)samples.size()), mean(0), median(0), p95(0), min(0), max(0)
+  {
+    if (samples.empty())
+      return;
+    std::sort(samples.begin(), samples.end());
+    for(size_t i=0; i<samples.size(); ++i)
+      mean += samples[i];
+    mean /= samples.size();
+    median = samples[samples.size() / 2];
+    p95 = samples[ std::min(samples.size() - 1, (size_t)std::ceil(samples.size() * 0.95) - 1) ];
+    min = samples.front();
+    max = samples.back();
+  }
+
+  std::string toJSON() const
+  {
+    char buffer[256];
+    sprintf(buffer, "{ \"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"min\": %.4f, \"max\": %.4f }", mean, median, p95, min, max);
+    return buffer;
+  }
+
+  int count;
+  double mean, median, p95, min, max;
+};
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers so that every run generates the same scene.
+class Random
+{
+public:
+  Random(unsigned int seed): mState(seed) {}
+  float next() { mState = mState * 1664525u + 1013904223u; return (mState >> 8) / 16777216.0f; }
+protected:
+  unsigned int mState;
+};
+
+//-----------------------------------------------------------------------------
+// Generates `actor_count` actors randomly placed in a cube, sharing a few meshes and `material_count` effects.
+// Returns the side of the cube.
+real createScene(ActorCollection& actors, int actor_count, int material_count)
+{
+  Random rnd(12345);
+
+  std::vector< ref<Geometry> > meshes;
+  meshes.push_back( makeBox( vec3(0,0,0), 1, 1, 1, false ) );
+  meshes.push_back( makeIcosphere( vec3(0,0,0), 1, 1 ) );
+  meshes.push_back( makeCone( vec3(0,0,0), 1, 1, 12 ) );
+  for(size_t i=0; i<meshes.size(); ++i)
+    meshes[i]->computeNormals();
+
+  std::vector< ref<Effect> > effects;
+  for(int i=0; i<material_count; ++i)
+  {
+    ref<Effect> effect = new Effect;
+    effect->shader()->enable(EN_DEPTH_TEST);
+    effect->shader()->enable(EN_CULL_FACE);
+    effect->shader()->enable(EN_LIGHTING);
+    effect->shader()->setRenderState( new Light, 0 );
+    effect->shader()->gocMaterial()->setDiffuse( fvec4(rnd.next(), rnd.next(), rnd.next(), 1) );
+    effect->setObjectName( String(Say("material %n") << i).toStdString() );
+    effects.push_back(effect);
+  }
+
+  // about one actor every 4x4x4 units
+  const real side = 4 * pow( (real)actor_count, (real)(1.0/3.0) );
+  actors.resize(actor_count);
+  for(int i=0; i<actor_count; ++i)
+  {
+    ref<Transform> tr = new Transform;
+    tr->setLocalMatrix( mat4::getTranslation( (rnd.next()-0.5f)*side, (rnd.next()-0.5f)*side, (rnd.next()-0.5f)*side ) );
+    tr->computeWorldMatrix();
+    actors[i] = new Actor( meshes[i % meshes.size()].get(), effects[i % effects.size()].get(), tr.get() );
+  }
+  return side;
+}
+
+//-----------------------------------------------------------------------------
+// Scripted camera path: an orbit around the scene with a slow vertical oscillation, a function of the frame only.
+void placeCamera(Camera* camera, int frame, int frame_count, real side)
+{
+  const real t = (real)frame / frame_count;
+  const real angle = t * 2 * (real)dPi;
+  const real radius = side * (real)0.75;
+  vec3 eye( cos(angle) * radius, sin(angle * 3) * side * (real)0.25, sin(angle) * radius );
+  camera->setViewMatrixLookAt( eye, vec3(0,0,0), vec3(0,1,0) );
+}
+
+//-----------------------------------------------------------------------------
+// Renders one benchmark case and returns its JSON record.
+std::string runCase(HeadlessContext* context, const BenchmarkOptions& opt, int actor_count, int material_count)
+{
+  String name = Say("%n_actors_%n_materials") << actor_count << material_count;
+  printf("%s: ", name.toStdString().c_str());
+  fflush(stdout);
+
+  Time timer;
+  timer.start();
+  ActorCollection actors;
+  real side = createScene(actors, actor_count, material_count);
+
+  ref<Rendering> rendering = new Rendering;
+  rendering->renderer()->setFramebuffer( context->framebuffer() );
+  rendering->camera()->viewport()->set( 0, 0, opt.width, opt.height );
+  rendering->camera()->viewport()->setClearColor( black );
+  rendering->camera()->setProjectionPerspective( 60, side * (real)0.01, side * 3 );
+  rendering->setThreadCount( opt.threads );
+  if (opt.kdtree)
+  {
+    ref<SceneManagerActorKdTree> scene_manager = new SceneManagerActorKdTree;
+    scene_manager->tree()->buildKdTree(actors);
+    rendering->sceneManagers()->push_back( scene_manager.get() );
+  }
+  else
+  {
+    ref<SceneManagerActorTree> scene_manager = new SceneManagerActorTree;
+    scene_manager->tree()->actors()->set(actors);
+    rendering->sceneManagers()->push_back( scene_manager.get() );
+  }
+  const double setup_time = timer.elapsed() * 1000.0;
+
+  ref<FrameProfiler> profiler = new FrameProfiler;
+  profiler->setHistorySize( opt.frames );
+  rendering->setProfiler( profiler.get() );
+
+  RenderStats stats;
+  for(int frame=-opt.warmup; frame<opt.frames; ++frame)
+  {
+    if (frame == 0)
+    {
+      profiler->clear();
+      stats.reset();
+    }
+
+    placeCamera( rendering->camera(), frame < 0 ? 0 : frame, opt.frames, side );
+    context->renderStats().reset();
+
+    // the frame time includes the completion of the GPU work
+    profiler->beginFrame();
+    rendering->render();
+    profiler->beginScope("finish");
+    glFinish();
+    profiler->endScope();
+    profiler->endFrame();
+
+    if (frame >= 0)
+      stats += context->renderStats();
+  }
+
+  // gather the samples of each scope by name
+  std::vector<double> frame_times;
+  std::vector<std::string> scope_names;
+  std::map< std::string, std::vector<double> > cpu_samples, gpu_samples;
+  for(size_t i=0; i<profiler->frames().size(); ++i)
+  {
+    const FrameProfiler::Frame& frame = profiler->frames()[i];
+    frame_times.push_back( frame.mDuration );
+    for(size_t j=0; j<frame.mScopes.size(); ++j)
+    {
+      const FrameProfiler::Scope& scope = frame.mScopes[j];
+      if ( cpu_samples.find(scope.mName) == cpu_samples.end() )
+        scope_names.push_back(scope.mName);
+      cpu_samples[scope.mName].push_back( scope.mDuration );
+      if ( scope.mGPUDuration >= 0 )
+        gpu_samples[scope.mName].push_back( scope.mGPUDuration );
+    }
+  }
+
+  if ( !opt.trace_prefix.empty() )
+    profiler->exportChromeTrace( opt.trace_prefix + name + ".json" );
+
+  SampleStats frame_stats(frame_times);
+  printf("%.2f ms/frame (median %.2f, p95 %.2f)\n", frame_stats.mean, frame_stats.median, frame_stats.p95);
+
+  const double n = opt.frames > 0 ? opt.frames : 1;
+  char buffer[1024];
+  std::string json = "    {\n";
+  json += "      \"name\": \"" + name.toStdString() + "\",\n";
+  sprintf(buffer, "      \"actors\": %d,\n      \"materials\": %d,\n      \"frames\": %d,\n      \"setup_ms\": %.2f,\n", actor_count, material_count, opt.frames, setup_time);
+  json += buffer;
+  json += "      \"frame_ms\": " + frame_stats.toJSON() + ",\n";
+  json += "      \"scopes\": {\n";
+  for(size_t i=0; i<scope_names.size(); ++i)
+  {
+    const std::string& scope = scope_names[i];
+    json += "        \"" + scope + "\": { \"cpu_ms\": " + SampleStats(cpu_samples[scope]).toJSON();
+    if ( gpu_samples.find(scope) != gpu_samples.end() )
+      json += ", \"gpu_ms\": " + SampleStats(gpu_samples[scope]).toJSON();
+    json += i + 1 < scope_names.size() ? " },\n" : " }\n";
+  }
+  json += "      },\n";
+  sprintf(buffer,
+    "      \"per_frame\": { \"draw_calls\": %.1f, \"triangles\": %.1f, \"actors\": %.1f, \"render_state_changes\": %.1f, "
+    "\"enable_changes\": %.1f, \"program_switches\": %.1f, \"uniform_uploads\": %.1f, \"buffer_binds\": %.1f, \"texture_binds\": %.1f }\n",
+    stats.mDrawCalls / n, stats.mTriangles / n, stats.mActors / n, stats.mRenderStateChanges / n,
+    stats.mEnableChanges / n, stats.mGLSLProgramSwitches / n, stats.mUniformUploads / n, stats.mBufferBinds / n, stats.mTextureBinds / n);
+  json += buffer;
+  json += "    }";
+
+  // release the OpenGL resources while the context is current
+  rendering = NULL;
+  actors.clear();
+  return json;
+}
+
+//-----------------------------------------------------------------------------
+std::vector<int> parseList(const char* str)
+{
+  std::vector<int> values;
+  std::vector<String> fields;
+  String(str).split(L',', fields, true);
+  for(size_t i=0; i<fields.size(); ++i)
+  {
+    int value = fields[i].toInt();
+    if ( fields[i].endsWith('k') || fields[i].endsWith('K') )
+      value *= 1000;
+    else
+    if ( fields[i].endsWith('m') || fields[i].endsWith('M') )
+      value *= 1000000;
+    if (value > 0)
+      values.push_back(value);
+  }
+  return values;
+}
+
+//-----------------------------------------------------------------------------
+void printHelp()
+{
+  printf("\nusage:\n");
+  printf("  vlbenchmark [-scales list] [-materials list] [-frames N] [-warmup N] [-size WxH] [-threads N] [-nokdtree]\n");
+  printf("              [-out results.json] [-trace prefix]\n");
+  printf("\noptions:\n");
+  printf("  -scales     comma separated actor counts, k and m suffixes allowed (default 1k,100k,1m)\n");
+  printf("  -materials  comma separated effect counts (default 1,64)\n");
+  printf("  -frames     frames rendered along the camera path for each case (default 300)\n");
+  printf("  -warmup     frames rendered before the measurements start (default 20)\n");
+  printf("  -size       size of the offscreen surface (default 1280x720)\n");
+  printf("  -threads    threads used by the culling, see Rendering::setThreadCount() (default 1)\n");
+  printf("  -nokdtree   uses a flat actor list instead of a kd-tree\n");
+  printf("  -out        writes the results in JSON format to the given file\n");
+  printf("  -trace      writes a Chrome trace of each case to <prefix><case>.json\n");
+  printf("\nexample:\n");
+  printf("  >  vlbenchmark -scales 1k,100k -materials 1,16,256 -out results.json\n");
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, const char* argv[])
+{
+  VisualizationLibrary::init(true);
+
+  printf("vlbenchmark 1.0 - Visualization Library Rendering Benchmark\n");
+  printf("Renders generated scenes along a scripted camera path without a window system\n\n");
+
+  BenchmarkOptions opt;
+  for(int i=1; i<argc; ++i)
+  {
+    if ( i+1 < argc && strcmp(argv[i], "-scales") == 0)
+      opt.scales = parseList(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-materials") == 0)
+      opt.materials = parseList(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-frames") == 0)
+      opt.frames = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-warmup") == 0)
+      opt.warmup = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-threads") == 0)
+      opt.threads = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-size") == 0)
+      sscanf(argv[++i], "%dx%d", &opt.width, &opt.height);
+    else
+    if ( strcmp(argv[i], "-nokdtree") == 0)
+      opt.kdtree = false;
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-out") == 0)
+      opt.out_file = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-trace") == 0)
+      opt.trace_prefix = argv[++i];
+    else
+    {
+      printf("unexpected argument '%s'\n", argv[i]);
+      printHelp();
+      return 1;
+    }
+  }
+
+  if ( opt.scales.empty() || opt.materials.empty() || opt.frames < 1 || opt.width < 1 || opt.height < 1 )
+  {
+    printHelp();
+    return 1;
+  }
+
+  ref<HeadlessContext> context = new HeadlessContext;
+  if ( !context->init(opt.width, opt.height) )
+    return 1;
+
+  std::string renderer = (const char*)glGetString(GL_RENDERER);
+  std::string gl_version = (const char*)glGetString(GL_VERSION);
+  printf("OpenGL: %s, %s\n\n", renderer.c_str(), gl_version.c_str());
+
+  std::string json = "{\n";
+  json += "  \"vl_version\": \"" + std::string(versionString()) + "\",\n";
+  json += "  \"gl_renderer\": \"" + renderer + "\",\n";
+  json += "  \"gl_version\": \"" + gl_version + "\",\n";
+  char buffer[256];
+  sprintf(buffer, "  \"width\": %d,\n  \"height\": %d,\n  \"threads\": %d,\n  \"kdtree\": %s,\n  \"gpu_timing\": %s,\n",
+    opt.width, opt.height, opt.threads, opt.kdtree ? "true" : "false", Has_Timer_Query ? "true" : "false");
+  json += buffer;
+  json += "  \"cases\": [\n";
+  for(size_t i=0; i<opt.scales.size(); ++i)
+  {
+    for(size_t j=0; j<opt.materials.size(); ++j)
+    {
+      json += runCase( context.get(), opt, opt.scales[i], opt.materials[j] );
+      json += i + 1 < opt.scales.size() || j + 1 < opt.materials.size() ? ",\n" : "\n";
+    }
+  }
+  json += "  ]\n}\n";
+
+  int result = 0;
+  if ( !opt.out_file.empty() )
+  {
+    ref<DiskFile> file = new DiskFile(opt.out_file);
+    if ( file->open(OM_WriteOnly) && file->write( json.c_str(), json.size() ) == (long long)json.size() )
+      printf("\nresults written to '%s'\n", opt.out_file.toStdString().c_str());
+    else
+    {
+      printf("\ncould not write '%s'\n", opt.out_file.toStdString().c_str());
+      result = 1;
+    }
+    file->close();
+  }
+
+  context->destroy();
+  VisualizationLibrary::shutdown();
+  return result;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,670 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/Time.hpp>
+#include <vlCore/AABB.hpp>
+#include <vlCore/Image.hpp>
+#include <vlCore/Buffer.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <vlCore/CRC32CheckSum.hpp>
+#include <vlCore/MD5CheckSum.hpp>
+#include <vlCore/GZipCodec.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/MemoryFile.hpp>
+#include <vlCore/ZippedDirectory.hpp>
+#include <vlCore/FileSystem.hpp>
+#include <vlCore/TextStream.hpp>
+#include <vlGraphics/Camera.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// Benchmark
+//-----------------------------------------------------------------------------
+// A micro-benchmark: run() executes `iterations` times the measured operation.
+class Benchmark: public Object
+{
+public:
+  Benchmark(const char* name, double bytes_per_op=0): mName(name), mBytesPerOp(bytes_per_op) {}
+
+  //! Prepares the data, called once before the measurements. Returns false if the benchmark cannot run.
+  virtual bool setup() { return true; }
+
+  virtual void run(int iterations) = 0;
+
+  const std::string& name() const { return mName; }
+
+  double bytesPerOp() const { return mBytesPerOp; }
+
+protected:
+  std::string mName;
+  double mBytesPerOp;
+};
+
+// Results are accumulated here so that the compiler cannot discard the measured code.
+volatile double g_Sink = 0;
+
+namespace
+{
+  // fills `data` with reproducible, moderately compressible content
+  void fillData(std::vector<unsigned char>& data, size_t size)
+  {
+    data.resize(size);
+    unsigned int state = 1;
+    for(size_t i=0; i<size; ++i)
+    {
+      state = state * 1664525u + 1013904223u;
+      data[i] = (unsigned char)( (state >> 24) % 16 + 'a' );
+    }
+  }
+
+  ref<MemoryFile> makeMemoryFile(const void* data, size_t size)
+  {
+    ref<MemoryFile> file = new MemoryFile;
+    file->allocateBuffer(size);
+    memcpy(file->buffer()->ptr(), data, size);
+    return file;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Math
+//-----------------------------------------------------------------------------
+class BenchMatrixMultiply: public Benchmark
+{
+public:
+  BenchMatrixMultiply(): Benchmark("mat4 multiply") {}
+  bool setup()
+  {
+    for(int i=0; i<Count; ++i)
+    {
+      mA[i] = mat4::getRotation( (real)i, 1, 2, 3 ) * mat4::getTranslation( (real)i, 2, 3 );
+      mB[i] = mat4::getScaling( 1 + (real)i / Count, 2, 3 );
+    }
+    return true;
+  }
+  void run(int iterations)
+  {
+    real sum = 0;
+    for(int i=0; i<iterations; ++i)
+    {
+      const int k = i & (Count-1);
+      mC[k] = mA[k] * mB[k];
+      sum += mC[k].e(0,3);
+    }
+    g_Sink += sum;
+  }
+protected:
+  static const int Count = 1024;
+  mat4 mA[Count], mB[Count], mC[Count];
+};
+
+class BenchMatrixInverse: public Benchmark
+{
+public:
+  BenchMatrixInverse(): Benchmark("mat4 inverse") {}
+  bool setup()
+  {
+    for(int i=0; i<Count; ++i)
+      mA[i] = mat4::getRotation( (real)i, 1, 2, 3 ) * mat4::getTranslation( (real)i, 2, 3 ) * mat4::getScaling( 1 + (real)i / Count, 2, 3 );
+    return true;
+  }
+  void run(int iterations)
+  {
+    real sum = 0;
+    mat4 inv;
+    for(int i=0; i<iterations; ++i)
+    {
+      mA[i & (Count-1)].getInverse(inv);
+      sum += inv.e(0,3);
+    }
+    g_Sink += sum;
+  }
+protected:
+  static const int Count = 1024;
+  mat4 mA[Count];
+};
+
+class BenchAABBTransformed: public Benchmark
+{
+public:
+  BenchAABBTransformed(): Benchmark("AABB::transformed") {}
+  bool setup()
+  {
+    for(int i=0; i<Count; ++i)
+      mBoxes[i] = AABB( vec3((real)i, 0, 0), vec3((real)i + 1, 2, 3) );
+    mMatrix = mat4::getRotation( 30, 1, 1, 0 ) * mat4::getTranslation( 10, 20, 30 );
+    return true;
+  }
+  void run(int iterations)
+  {
+    real sum = 0;
+    AABB out;
+    for(int i=0; i<iterations; ++i)
+    {
+      mBoxes[i & (Count-1)].transformed(out, mMatrix);
+      sum += out.maxCorner().x();
+    }
+    g_Sink += sum;
+  }
+protected:
+  static const int Count = 1024;
+  AABB mBoxes[Count];
+  mat4 mMatrix;
+};
+
+class BenchFrustumCull: public Benchmark
+{
+public:
+  BenchFrustumCull(bool sphere): Benchmark( sphere ? "Frustum::cull(Sphere)" : "Frustum::cull(AABB)" ), mSphere(sphere) {}
+  bool setup()
+  {
+    ref<Camera> camera = new Camera;
+    camera->viewport()->set(0, 0, 1280, 720);
+    camera->setProjectionPerspective( 60, 1, 1000 );
+    camera->setViewMatrixLookAt( vec3(0,0,0), vec3(0,0,-1), vec3(0,1,0) );
+    camera->computeFrustumPlanes();
+    mFrustum = camera->frustum();
+    // objects scattered around the camera, about half of them visible
+    unsigned int state = 7;
+    for(int i=0; i<Count; ++i)
+    {
+      vec3 p;
+      for(int j=0; j<3; ++j)
+      {
+        state = state * 1664525u + 1013904223u;
+        p[j] = ( (state >> 8) / 16777216.0f - 0.5f ) * 1000;
+      }
+      mBoxes[i] = AABB( p - vec3(1,1,1), p + vec3(1,1,1) );
+      mSpheres[i] = Sphere( p, 1.5f );
+    }
+    return true;
+  }
+  void run(int iterations)
+  {
+    int culled = 0;
+    for(int i=0; i<iterations; ++i)
+      culled += mSphere ? mFrustum.cull( mSpheres[i & (Count-1)] ) : mFrustum.cull( mBoxes[i & (Count-1)] );
+    g_Sink += culled;
+  }
+protected:
+  static const int Count = 1024;
+  Frustum mFrustum;
+  AABB mBoxes[Count];
+  Sphere mSpheres[Count];
+  bool mSphere;
+};
+
+//-----------------------------------------------------------------------------
+// String
+//-----------------------------------------------------------------------------
+class BenchStringFromAscii: public Benchmark
+{
+public:
+  BenchStringFromAscii(): Benchmark("String from char*", 32) {}
+  void run(int iterations)
+  {
+    size_t len = 0;
+    for(int i=0; i<iterations; ++i)
+    {
+      String str("/models/3ds/monkey_0123456789.3ds");
+      len += str.length();
+    }
+    g_Sink += (double)len;
+  }
+};
+
+class BenchStringFromUTF8: public Benchmark
+{
+public:
+  BenchStringFromUTF8(): Benchmark("String::fromUTF8") {}
+  bool setup()
+  {
+    // mixed ASCII, Latin, Greek and CJK characters
+    mUTF8 = "Visualization Library \xc3\xa8 \xce\xb1\xce\xb2\xce\xb3 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e text";
+    mBytesPerOp = (double)mUTF8.size();
+    return true;
+  }
+  void run(int iterations)
+  {
+    size_t len = 0;
+    for(int i=0; i<iterations; ++i)
+      len += String::fromUTF8( mUTF8.c_str(), (int)mUTF8.size() ).length();
+    g_Sink += (double)len;
+  }
+protected:
+  std::string mUTF8;
+};
+
+class BenchStringToStd: public Benchmark
+{
+public:
+  BenchStringToStd(): Benchmark("String::toStdString") {}
+  bool setup()
+  {
+    mString = "/models/3ds/monkey_0123456789.3ds";
+    mBytesPerOp = mString.length();
+    return true;
+  }
+  void run(int iterations)
+  {
+    size_t len = 0;
+    for(int i=0; i<iterations; ++i)
+      len += mString.toStdString().size();
+    g_Sink += (double)len;
+  }
+protected:
+  String mString;
+};
+
+//-----------------------------------------------------------------------------
+// Image and Buffer
+//-----------------------------------------------------------------------------
+class BenchImageConvert: public Benchmark
+{
+public:
+  BenchImageConvert(EImageFormat format, const char* name): Benchmark(name), mFormat(format) {}
+  bool setup()
+  {
+    mImage = new Image( 512, 512, 0, 1, IF_RGBA, IT_UNSIGNED_BYTE );
+    std::vector<unsigned char> data;
+    fillData( data, mImage->requiredMemory() );
+    memcpy( mImage->pixels(), &data[0], data.size() );
+    mBytesPerOp = mImage->requiredMemory();
+    return true;
+  }
+  void run(int iterations)
+  {
+    for(int i=0; i<iterations; ++i)
+      g_Sink += mImage->convertFormat(mFormat)->requiredMemory();
+  }
+protected:
+  ref<Image> mImage;
+  EImageFormat mFormat;
+};
+
+class BenchBufferResize: public Benchmark
+{
+public:
+  // one operation grows a buffer from 0 to 1MB in 4KB steps and releases it
+  BenchBufferResize(): Benchmark("Buffer::resize 0-1MB", 1024*1024) {}
+  void run(int iterations)
+  {
+    ref<Buffer> buffer = new Buffer;
+    for(int i=0; i<iterations; ++i)
+    {
+      for(size_t size = 4096; size <= 1024*1024; size += 4096)
+      {
+        buffer->resize(size);
+        buffer->ptr()[size-1] = (unsigned char)size;
+      }
+      buffer->resize(0);
+    }
+    g_Sink += (double)buffer->bytesUsed();
+  }
+};
+
+//-----------------------------------------------------------------------------
+// Hashing
+//-----------------------------------------------------------------------------
+class BenchHash: public Benchmark
+{
+public:
+  enum EHash { Murmur32, Murmur128, CRC32, MD5 };
+
+  BenchHash(EHash hash, const char* name): Benchmark(name, Size), mHash(hash) {}
+  bool setup()
+  {
+    fillData(mData, Size);
+    return true;
+  }
+  void run(int iterations)
+  {
+    u32 out[4] = { 0, 0, 0, 0 };
+    for(int i=0; i<iterations; ++i)
+    {
+      switch(mHash)
+      {
+      case Murmur32:  MurmurHash3_x86_32( &mData[0], Size, i, out ); break;
+      case Murmur128: MurmurHash3_x64_128( &mData[0], Size, i, out ); break;
+      case CRC32:     out[0] += CRC32CheckSum().compute( &mData[0], Size ); break;
+      case MD5:
+        {
+          MD5CheckSum md5;
+          md5.compute( &mData[0], Size );
+          out[0] += md5.md5()[0];
+        }
+        break;
+      }
+    }
+    g_Sink += out[0];
+  }
+protected:
+  static const int Size = 1024*1024;
+  std::vector<unsigned char> mData;
+  EHash mHash;
+};
+
+//-----------------------------------------------------------------------------
+// Decompression and parsing
+//-----------------------------------------------------------------------------
+class BenchGZipDecode: public Benchmark
+{
+public:
+  BenchGZipDecode(): Benchmark("GZipCodec decode", Size) {}
+  bool setup()
+  {
+    std::vector<unsigned char> data;
+    fillData(data, Size);
+
+    // MemoryFile does not support writing: compress through a temporary file
+    String tmp_path = "vlcorebench_tmp.gz";
+    ref<GZipCodec> encoder = new GZipCodec( new DiskFile(tmp_path) );
+    if ( !encoder->open(OM_WriteOnly) )
+      return false;
+    encoder->write( &data[0], data.size() );
+    encoder->close();
+
+    ref<DiskFile> compressed = new DiskFile(tmp_path);
+    mCompressed = new MemoryFile;
+    mCompressed->copy( compressed.get() );
+    remove( tmp_path.toStdString().c_str() );
+    mOutput.resize(Size);
+    return mCompressed->size() > 0;
+  }
+  void run(int iterations)
+  {
+    long long bytes = 0;
+    for(int i=0; i<iterations; ++i)
+    {
+      ref<GZipCodec> decoder = new GZipCodec( mCompressed.get() );
+      decoder->open(OM_ReadOnly);
+      bytes += decoder->read( &mOutput[0], Size );
+      decoder->close();
+    }
+    g_Sink += (double)bytes;
+  }
+protected:
+  static const int Size = 4*1024*1024;
+  ref<MemoryFile> mCompressed;
+  std::vector<unsigned char> mOutput;
+};
+
+class BenchZippedFileDecode: public Benchmark
+{
+public:
+  BenchZippedFileDecode(): Benchmark("ZippedFile decode (ztest.zip)") {}
+  bool setup()
+  {
+    ref<VirtualFile> zip = defFileSystem()->locateFile("/ztest.zip");
+    if ( !zip )
+      return false;
+    // decode from memory to leave the disk out of the measure
+    ref<MemoryFile> zip_in_memory = new MemoryFile;
+    zip_in_memory->copy( zip.get() );
+    mDirectory = new ZippedDirectory( zip_in_memory.get() );
+    mDirectory->listFilesRecursive( mFiles );
+    mBytesPerOp = 0;
+    for(size_t i=0; i<mFiles.size(); ++i)
+      mBytesPerOp += (double)mDirectory->file( mFiles[i] )->size();
+    return !mFiles.empty();
+  }
+  void run(int iterations)
+  {
+    std::vector<char> data;
+    long long bytes = 0;
+    for(int i=0; i<iterations; ++i)
+    {
+      for(size_t j=0; j<mFiles.size(); ++j)
+      {
+        ref<VirtualFile> file = mDirectory->file( mFiles[j] );
+        bytes += file->load(data);
+      }
+    }
+    g_Sink += (double)bytes;
+  }
+protected:
+  ref<ZippedDirectory> mDirectory;
+  std::vector<String> mFiles;
+};
+
+class BenchTextStream: public Benchmark
+{
+public:
+  BenchTextStream(bool numbers): Benchmark( numbers ? "TextStream::readDouble" : "TextStream::readLine" ), mNumbers(numbers) {}
+  bool setup()
+  {
+    // an OBJ-like text
+    std::string text;
+    char line[128];
+    for(int i=0; i<20000; ++i)
+    {
+      sprintf( line, "v %.6f %.6f %.6f\n", i * 0.001, i * -0.5, i * 1.25 );
+      text += line;
+    }
+    mFile = makeMemoryFile( text.c_str(), text.size() );
+    mBytesPerOp = (double)text.size();
+    return true;
+  }
+  void run(int iterations)
+  {
+    double sum = 0;
+    for(int i=0; i<iterations; ++i)
+    {
+      // the stream closes the file when destroyed
+      mFile->open(OM_ReadOnly);
+      ref<TextStream> stream = new TextStream( mFile.get() );
+      if (mNumbers)
+      {
+        std::string token;
+        double value = 0;
+        while( stream->readStdString(token) )
+        {
+          for(int j=0; j<3 && stream->readDouble(value); ++j)
+            sum += value;
+        }
+      }
+      else
+      {
+        std::string line;
+        while( stream->readLine(line) )
+          sum += line.size();
+      }
+    }
+    g_Sink += sum;
+  }
+protected:
+  ref<MemoryFile> mFile;
+  bool mNumbers;
+};
+
+//-----------------------------------------------------------------------------
+// Harness
+//-----------------------------------------------------------------------------
+struct BenchResult
+{
+  std::string name;
+  int iterations;
+  double median_ns;
+  double min_ns;
+  double mean_ns;
+  double rsd;
+  double mb_per_s;
+};
+
+// Runs `bench` `samples` times, each run lasting about `sample_ms` milliseconds, and returns the nanoseconds per operation.
+BenchResult measure(Benchmark* bench, int samples, double sample_ms)
+{
+  // calibrate the number of iterations of each sample, also warms up caches and allocators
+  int iterations = 1;
+  for(;;)
+  {
+    unsigned long long start = Time::currentMicroseconds();
+    bench->run(iterations);
+    double elapsed_ms = (Time::currentMicroseconds() - start) / 1000.0;
+    if ( elapsed_ms >= sample_ms || iterations >= (1<<30) )
+      break;
+    iterations = elapsed_ms < sample_ms / 100 ? iterations * 10 : (int)std::ceil( iterations * sample_ms / std::max(elapsed_ms, 0.001) );
+  }
+
+  std::vector<double> ns_per_op;
+  for(int i=0; i<samples; ++i)
+  {
+    unsigned long long start = Time::currentMicroseconds();
+    bench->run(iterations);
+    ns_per_op.push_back( (Time::currentMicroseconds() - start) * 1000.0 / iterations );
+  }
+  std::sort( ns_per_op.begin(), ns_per_op.end() );
+
+  BenchResult result;
+  result.name = bench->name();
+  result.iterations = iterations;
+  result.median_ns = ns_per_op[ ns_per_op.size() / 2 ];
+  result.min_ns = ns_per_op.front();
+  result.mean_ns = 0;
+  for(size_t i=0; i<ns_per_op.size(); ++i)
+    result.mean_ns += ns_per_op[i];
+  result.mean_ns /= ns_per_op.size();
+  double variance = 0;
+  for(size_t i=0; i<ns_per_op.size(); ++i)
+    variance += (ns_per_op[i] - result.mean_ns) * (ns_per_op[i] - result.mean_ns);
+  result.rsd = result.mean_ns > 0 ? std::sqrt( variance / ns_per_op.size() ) / result.mean_ns * 100 : 0;
+  // throughput from the median, MB = 2^20 bytes
+  result.mb_per_s = bench->bytesPerOp() > 0 ? bench->bytesPerOp() / (result.median_ns * 1e-9) / (1024.0*1024.0) : 0;
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+void printHelp()
+{
+  printf("\nusage:\n");
+  printf("  vlcorebench [-filter text] [-samples N] [-time ms] [-list] [-csv file]\n");
+  printf("\noptions:\n");
+  printf("  -filter   runs only the benchmarks whose name contains the given text\n");
+  printf("  -samples  number of measurements of each benchmark (default 15)\n");
+  printf("  -time     duration in milliseconds of each measurement (default 20)\n");
+  printf("  -list     lists the available benchmarks\n");
+  printf("  -csv      also writes the results to the given CSV file\n");
+  printf("\nThe statistics are computed over the measurements: median and minimum time per operation,\n");
+  printf("relative standard deviation and throughput computed from the median.\n");
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, const char* argv[])
+{
+  VisualizationLibrary::init(true);
+
+  printf("vlcorebench 1.0 - Visualization Library Core Micro-Benchmarks\n\n");
+
+  std::string filter;
+  std::string csv_file;
+  int samples = 15;
+  double sample_ms = 20;
+  bool list = false;
+
+  for(int i=1; i<argc; ++i)
+  {
+    if ( i+1 < argc && strcmp(argv[i], "-filter") == 0)
+      filter = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-samples") == 0)
+      samples = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-time") == 0)
+      sample_ms = atof(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-csv") == 0)
+      csv_file = argv[++i];
+    else
+    if ( strcmp(argv[i], "-list") == 0)
+      list = true;
+    else
+    {
+      printf("unexpected argument '%s'\n", argv[i]);
+      printHelp();
+      return 1;
+    }
+  }
+
+  if (samples < 1 || sample_ms <= 0)
+  {
+    printHelp();
+    return 1;
+  }
+
+  std::vector< ref<Benchmark> > benchmarks;
+  benchmarks.push_back( new BenchMatrixMultiply );
+  benchmarks.push_back( new BenchMatrixInverse );
+  benchmarks.push_back( new BenchAABBTransformed );
+  benchmarks.push_back( new BenchFrustumCull(false) );
+  benchmarks.push_back( new BenchFrustumCull(true) );
+  benchmarks.push_back( new BenchStringFromAscii );
+  benchmarks.push_back( new BenchStringFromUTF8 );
+  benchmarks.push_back( new BenchStringToStd );
+  benchmarks.push_back( new BenchImageConvert(IF_BGRA, "Image RGBA->BGRA 512x512") );
+  benchmarks.push_back( new BenchImageConvert(IF_RGB, "Image RGBA->RGB 512x512") );
+  benchmarks.push_back( new BenchImageConvert(IF_LUMINANCE, "Image RGBA->LUMINANCE 512x512") );
+  benchmarks.push_back( new BenchBufferResize );
+  benchmarks.push_back( new BenchHash(BenchHash::Murmur32, "MurmurHash3_x86_32 1MB") );
+  benchmarks.push_back( new BenchHash(BenchHash::Murmur128, "MurmurHash3_x64_128 1MB") );
+  benchmarks.push_back( new BenchHash(BenchHash::CRC32, "CRC32 1MB") );
+  benchmarks.push_back( new BenchHash(BenchHash::MD5, "MD5 1MB") );
+  benchmarks.push_back( new BenchGZipDecode );
+  benchmarks.push_back( new BenchZippedFileDecode );
+  benchmarks.push_back( new BenchTextStream(false) );
+  benchmarks.push_back( new BenchTextStream(true) );
+
+  if (list)
+  {
+    for(size_t i=0; i<benchmarks.size(); ++i)
+      printf("%s\n", benchmarks[i]->name().c_str());
+    return 0;
+  }
+
+  printf("%-32s %12s %12s %8s %12s %10s\n", "benchmark", "median ns", "min ns", "rsd %", "MB/s", "iters");
+  std::vector<BenchResult> results;
+  for(size_t i=0; i<benchmarks.size(); ++i)
+  {
+    Benchmark* bench = benchmarks[i].get();
+    if ( !filter.empty() && bench->name().find(filter) == std::string::npos )
+      continue;
+    if ( !bench->setup() )
+    {
+      printf("%-32s skipped, setup failed\n", bench->name().c_str());
+      continue;
+    }
+    BenchResult r = measure(bench, samples, sample_ms);
+    results.push_back(r);
+    if (r.mb_per_s > 0)
+      printf("%-32s %12.1f %12.1f %8.2f %12.1f %10d\n", r.name.c_str(), r.median_ns, r.min_ns, r.rsd, r.mb_per_s, r.iterations);
+    else
+      printf("%-32s %12.1f %12.1f %8.2f %12s %10d\n", r.name.c_str(), r.median_ns, r.min_ns, r.rsd, "-", r.iterations);
+  }
+
+  if ( !csv_file.empty() )
+  {
+    FILE* fout = fopen(csv_file.c_str(), "wt");
+    if (!fout)
+    {
+      printf("\ncould not write '%s'\n", csv_file.c_str());
+      return 1;
+    }
+    fprintf(fout, "benchmark,median_ns,min_ns,mean_ns,rsd_percent,mb_per_s,iterations\n");
+    for(size_t i=0; i<results.size(); ++i)
+    {
+      const BenchResult& r = results[i];
+      fprintf(fout, "\"%s\",%.3f,%.3f,%.3f,%.3f,%.3f,%d\n", r.name.c_str(), r.median_ns, r.min_ns, r.mean_ns, r.rsd, r.mb_per_s, r.iterations);
+    }
+    fclose(fout);
+    printf("\nresults written to '%s'\n", csv_file.c_str());
+  }
+
+  VisualizationLibrary::shutdown();
+  return 0;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,745 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/GlobalSettings.hpp>
+#include <vlCore/Time.hpp>
+#include <vlCore/Image.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/DiskDirectory.hpp>
+#include <vlCore/MemoryFile.hpp>
+#include <vlCore/MemoryTracker.hpp>
+#include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/ResourceDatabase.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/GeometryPrimitives.hpp>
+#include <vlX/ioVLX.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// AssetGenerator
+//-----------------------------------------------------------------------------
+// Writes a reference asset of a given format. The assets come in tiers of increasing size and are
+// reproducible, so the results of different releases can be compared as long as the tier is the same.
+class AssetGenerator: public Object
+{
+public:
+  AssetGenerator(const char* format, const char* ext): mFormat(format), mExtension(ext) {}
+
+  //! Writes the asset of the given tier (0 = small, 1 = medium, 2 = large) to `path`.
+  virtual bool generate(const std::string& path, int tier) = 0;
+
+  //! A short description of the asset of the given tier, for example "100k tris".
+  virtual std::string describe(int tier) const = 0;
+
+  //! The other files written by generate() and needed to load the asset, counted in its size.
+  virtual std::vector<std::string> companionFiles(const std::string& /*path*/) const { return std::vector<std::string>(); }
+
+  const std::string& format() const { return mFormat; }
+
+  const std::string& extension() const { return mExtension; }
+
+protected:
+  std::string mFormat;
+  std::string mExtension;
+};
+
+namespace
+{
+  // side of the grids used by the mesh generators, 2*n*n triangles: ~10k, ~100k and ~1M
+  const int MeshGridSize[] = { 72, 224, 708 };
+
+  // side of the images and of the volumes
+  const int ImageSize[]  = { 256, 1024, 2048 };
+  const int VolumeSize[] = { 64, 128, 256 };
+
+  std::string triangleCount(int tier)
+  {
+    char str[64];
+    int tris = 2 * MeshGridSize[tier] * MeshGridSize[tier];
+    if (tris >= 1000000)
+      sprintf(str, "%.1fM tris", tris / 1000000.0);
+    else
+      sprintf(str, "%dk tris", tris / 1000);
+    return str;
+  }
+
+  // vertex (i,j) of a gently curved grid
+  fvec3 gridVertex(int i, int j)
+  {
+    return fvec3( (float)i, (float)j, 4.0f * sinf(i * 0.05f) * cosf(j * 0.05f) );
+  }
+
+  void appendU16(std::vector<unsigned char>& data, unsigned short v)
+  {
+    data.push_back( (unsigned char)(v & 0xFF) );
+    data.push_back( (unsigned char)(v >> 8) );
+  }
+
+  void appendU32(std::vector<unsigned char>& data, unsigned int v)
+  {
+    for(int i=0; i<4; ++i)
+      data.push_back( (unsigned char)( (v >> (8*i)) & 0xFF ) );
+  }
+
+  void appendF32(std::vector<unsigned char>& data, float f)
+  {
+    unsigned int v;
+    memcpy(&v, &f, 4);
+    appendU32(data, v);
+  }
+
+  bool writeFile(const std::string& path, const void* data, size_t size)
+  {
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout)
+      return false;
+    bool ok = fwrite(data, 1, size, fout) == size;
+    fclose(fout);
+    return ok;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Meshes
+//-----------------------------------------------------------------------------
+class GenOBJ: public AssetGenerator
+{
+public:
+  GenOBJ(): AssetGenerator("OBJ", "obj") {}
+  std::string describe(int tier) const { return triangleCount(tier); }
+  bool generate(const std::string& path, int tier)
+  {
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout)
+      return false;
+    const int n = MeshGridSize[tier];
+    fprintf(fout, "# vlloaderbench grid %dx%d\n", n, n);
+    for(int j=0; j<=n; ++j)
+      for(int i=0; i<=n; ++i)
+      {
+        fvec3 v = gridVertex(i,j);
+        fprintf(fout, "v %.6f %.6f %.6f\n", v.x(), v.y(), v.z());
+      }
+    for(int j=0; j<=n; ++j)
+      for(int i=0; i<=n; ++i)
+        fprintf(fout, "vn 0 0 1\n");
+    for(int j=0; j<n; ++j)
+      for(int i=0; i<n; ++i)
+      {
+        int a = j*(n+1) + i + 1, b = a + 1, c = a + n + 1, d = c + 1;
+        fprintf(fout, "f %d//%d %d//%d %d//%d\n", a, a, b, b, d, d);
+        fprintf(fout, "f %d//%d %d//%d %d//%d\n", a, a, d, d, c, c);
+      }
+    fclose(fout);
+    return true;
+  }
+};
+
+class GenPLY: public AssetGenerator
+{
+public:
+  GenPLY(bool binary): AssetGenerator(binary ? "PLY binary" : "PLY ascii", "ply"), mBinary(binary) {}
+  std::string describe(int tier) const { return triangleCount(tier); }
+  bool generate(const std::string& path, int tier)
+  {
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout)
+      return false;
+    const int n = MeshGridSize[tier];
+    fprintf(fout, "ply\nformat %s 1.0\n", mBinary ? "binary_little_endian" : "ascii");
+    fprintf(fout, "element vertex %d\nproperty float x\nproperty float y\nproperty float z\n", (n+1)*(n+1));
+    fprintf(fout, "element face %d\nproperty list uchar int vertex_indices\nend_header\n", 2*n*n);
+    std::vector<unsigned char> data;
+    for(int j=0; j<=n; ++j)
+      for(int i=0; i<=n; ++i)
+      {
+        fvec3 v = gridVertex(i,j);
+        if (mBinary)
+        {
+          appendF32(data, v.x()); appendF32(data, v.y()); appendF32(data, v.z());
+        }
+        else
+          fprintf(fout, "%.6f %.6f %.6f\n", v.x(), v.y(), v.z());
+      }
+    for(int j=0; j<n; ++j)
+      for(int i=0; i<n; ++i)
+      {
+        int a = j*(n+1) + i, b = a + 1, c = a + n + 1, d = c + 1;
+        int tri[] = { a, b, d, a, d, c };
+        for(int t=0; t<2; ++t)
+        {
+          if (mBinary)
+          {
+            data.push_back(3);
+            appendU32(data, tri[t*3+0]); appendU32(data, tri[t*3+1]); appendU32(data, tri[t*3+2]);
+          }
+          else
+            fprintf(fout, "3 %d %d %d\n", tri[t*3+0], tri[t*3+1], tri[t*3+2]);
+        }
+      }
+    bool ok = data.empty() || fwrite(&data[0], 1, data.size(), fout) == data.size();
+    fclose(fout);
+    return ok;
+  }
+protected:
+  bool mBinary;
+};
+
+class GenSTL: public AssetGenerator
+{
+public:
+  GenSTL(bool binary): AssetGenerator(binary ? "STL binary" : "STL ascii", "stl"), mBinary(binary) {}
+  std::string describe(int tier) const { return triangleCount(tier); }
+  bool generate(const std::string& path, int tier)
+  {
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout)
+      return false;
+    const int n = MeshGridSize[tier];
+    std::vector<unsigned char> data;
+    if (mBinary)
+    {
+      // the 80 bytes header must not start with "solid"
+      data.resize(80, ' ');
+      memcpy(&data[0], "vlloaderbench", 13);
+      appendU32(data, 2*n*n);
+    }
+    else
+      fprintf(fout, "solid vlloaderbench\n");
+    for(int j=0; j<n; ++j)
+      for(int i=0; i<n; ++i)
+      {
+        fvec3 tri[] = { gridVertex(i,j), gridVertex(i+1,j), gridVertex(i+1,j+1), gridVertex(i,j), gridVertex(i+1,j+1), gridVertex(i,j+1) };
+        for(int t=0; t<2; ++t)
+        {
+          fvec3 nrm = cross(tri[t*3+1] - tri[t*3+0], tri[t*3+2] - tri[t*3+0]).normalize();
+          if (mBinary)
+          {
+            appendF32(data, nrm.x()); appendF32(data, nrm.y()); appendF32(data, nrm.z());
+            for(int k=0; k<3; ++k)
+            {
+              appendF32(data, tri[t*3+k].x()); appendF32(data, tri[t*3+k].y()); appendF32(data, tri[t*3+k].z());
+            }
+            appendU16(data, 0);
+          }
+          else
+          {
+            fprintf(fout, "facet normal %.6f %.6f %.6f\n outer loop\n", nrm.x(), nrm.y(), nrm.z());
+            for(int k=0; k<3; ++k)
+              fprintf(fout, "  vertex %.6f %.6f %.6f\n", tri[t*3+k].x(), tri[t*3+k].y(), tri[t*3+k].z());
+            fprintf(fout, " endloop\nendfacet\n");
+          }
+        }
+      }
+    if (!mBinary)
+      fprintf(fout, "endsolid vlloaderbench\n");
+    bool ok = data.empty() || fwrite(&data[0], 1, data.size(), fout) == data.size();
+    fclose(fout);
+    return ok;
+  }
+protected:
+  bool mBinary;
+};
+
+class Gen3DS: public AssetGenerator
+{
+public:
+  Gen3DS(): AssetGenerator("3DS", "3ds") {}
+  std::string describe(int tier) const { return triangleCount(tier); }
+  bool generate(const std::string& path, int tier)
+  {
+    // 3DS indices are 16 bits: the grid is split in objects of at most Tile x Tile quads
+    const int Tile = 128;
+    const int n = MeshGridSize[tier];
+    std::vector<unsigned char> data;
+    size_t main_chunk = beginChunk(data, 0x4D4D);
+    size_t version_chunk = beginChunk(data, 0x0002);
+    appendU32(data, 3);
+    endChunk(data, version_chunk);
+    size_t editor_chunk = beginChunk(data, 0x3D3D);
+    int object_index = 0;
+    for(int tj=0; tj<n; tj+=Tile)
+      for(int ti=0; ti<n; ti+=Tile, ++object_index)
+      {
+        const int w = std::min(Tile, n - ti);
+        const int h = std::min(Tile, n - tj);
+        size_t object_chunk = beginChunk(data, 0x4000);
+        char name[32];
+        sprintf(name, "tile%d", object_index);
+        data.insert(data.end(), name, name + strlen(name) + 1);
+        size_t mesh_chunk = beginChunk(data, 0x4100);
+        size_t vertex_chunk = beginChunk(data, 0x4110);
+        appendU16(data, (unsigned short)( (w+1)*(h+1) ));
+        for(int j=0; j<=h; ++j)
+          for(int i=0; i<=w; ++i)
+          {
+            fvec3 v = gridVertex(ti+i, tj+j);
+            appendF32(data, v.x()); appendF32(data, v.y()); appendF32(data, v.z());
+          }
+        endChunk(data, vertex_chunk);
+        size_t face_chunk = beginChunk(data, 0x4120);
+        appendU16(data, (unsigned short)( 2*w*h ));
+        for(int j=0; j<h; ++j)
+          for(int i=0; i<w; ++i)
+          {
+            unsigned short a = (unsigned short)(j*(w+1) + i), b = a + 1, c = (unsigned short)(a + w + 1), d = c + 1;
+            appendU16(data, a); appendU16(data, b); appendU16(data, d); appendU16(data, 0);
+            appendU16(data, a); appendU16(data, d); appendU16(data, c); appendU16(data, 0);
+          }
+        endChunk(data, face_chunk);
+        endChunk(data, mesh_chunk);
+        endChunk(data, object_chunk);
+      }
+    endChunk(data, editor_chunk);
+    endChunk(data, main_chunk);
+    return writeFile(path, &data[0], data.size());
+  }
+protected:
+  static size_t beginChunk(std::vector<unsigned char>& data, unsigned short id)
+  {
+    size_t start = data.size();
+    appendU16(data, id);
+    appendU32(data, 0);
+    return start;
+  }
+  static void endChunk(std::vector<unsigned char>& data, size_t start)
+  {
+    unsigned int len = (unsigned int)(data.size() - start);
+    for(int i=0; i<4; ++i)
+      data[start + 2 + i] = (unsigned char)( (len >> (8*i)) & 0xFF );
+  }
+};
+
+class GenVLX: public AssetGenerator
+{
+public:
+  GenVLX(bool binary): AssetGenerator(binary ? "VLB" : "VLT", binary ? "vlb" : "vlt"), mBinary(binary) {}
+  std::string describe(int tier) const { return triangleCount(tier); }
+  bool generate(const std::string& path, int tier)
+  {
+    const int n = MeshGridSize[tier];
+    ref<Geometry> geom = makeGrid( vec3(0,0,0), (real)n, (real)n, n+1, n+1 );
+    geom->computeNormals();
+    ref<ResourceDatabase> db = new ResourceDatabase;
+    db->resources().push_back( geom );
+    return mBinary ? vlX::saveVLB( path.c_str(), db.get() ) : vlX::saveVLT( path.c_str(), db.get() );
+  }
+protected:
+  bool mBinary;
+};
+
+//-----------------------------------------------------------------------------
+// Images and volumes
+//-----------------------------------------------------------------------------
+class GenImage: public AssetGenerator
+{
+public:
+  GenImage(const char* format, const char* ext, EImageFormat img_format, EImageType img_type): AssetGenerator(format, ext), mImageFormat(img_format), mImageType(img_type) {}
+  std::string describe(int tier) const
+  {
+    char str[64];
+    sprintf(str, "%dx%d", ImageSize[tier], ImageSize[tier]);
+    return str;
+  }
+  bool generate(const std::string& path, int tier)
+  {
+    const int size = ImageSize[tier];
+    ref<Image> img = new Image( size, size, 0, 1, mImageFormat, mImageType );
+    // smooth gradients with some noise, so that the compressed formats are neither trivial nor incompressible
+    unsigned int state = 1;
+    unsigned char* px = img->pixels();
+    for(int i=0; i<img->requiredMemory(); ++i)
+    {
+      state = state * 1664525u + 1013904223u;
+      px[i] = (unsigned char)( ( (i / 4) % size + (i / (4*size)) ) / 2 + (state >> 29) );
+    }
+    return saveImage( img.get(), path.c_str() );
+  }
+protected:
+  EImageFormat mImageFormat;
+  EImageType mImageType;
+};
+
+class GenDDS: public AssetGenerator
+{
+public:
+  GenDDS(): AssetGenerator("DDS", "dds") {}
+  std::string describe(int tier) const
+  {
+    char str[64];
+    sprintf(str, "%dx%d DXT1", 2*ImageSize[tier], 2*ImageSize[tier]);
+    return str;
+  }
+  bool generate(const std::string& path, int tier)
+  {
+    const int size = 2*ImageSize[tier];
+    const int bytes = size * size / 2; // DXT1: 8 bytes per 4x4 block
+    std::vector<unsigned char> data;
+    data.insert(data.end(), "DDS ", "DDS " + 4);
+    appendU32(data, 124);                        // header size
+    appendU32(data, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000); // caps, height, width, pixel format, linear size
+    appendU32(data, size);
+    appendU32(data, size);
+    appendU32(data, bytes);
+    appendU32(data, 0);                          // depth
+    appendU32(data, 0);                          // mipmaps
+    for(int i=0; i<11; ++i)
+      appendU32(data, 0);
+    appendU32(data, 32);                         // pixel format size
+    appendU32(data, 0x4);                        // DDPF_FOURCC
+    data.insert(data.end(), "DXT1", "DXT1" + 4);
+    for(int i=0; i<5; ++i)
+      appendU32(data, 0);
+    appendU32(data, 0x1000);                     // DDSCAPS_TEXTURE
+    for(int i=0; i<4; ++i)
+      appendU32(data, 0);
+    unsigned int state = 1;
+    for(int i=0; i<bytes; ++i)
+    {
+      state = state * 1664525u + 1013904223u;
+      data.push_back( (unsigned char)(state >> 24) );
+    }
+    return writeFile(path, &data[0], data.size());
+  }
+};
+
+class GenMHD: public AssetGenerator
+{
+public:
+  GenMHD(): AssetGenerator("MHD", "mhd") {}
+  std::string describe(int tier) const
+  {
+    char str[64];
+    sprintf(str, "%d^3 ushort", VolumeSize[tier]);
+    return str;
+  }
+  std::vector<std::string> companionFiles(const std::string& path) const
+  {
+    return std::vector<std::string>( 1, rawPath(path) );
+  }
+  bool generate(const std::string& path, int tier)
+  {
+    const int size = VolumeSize[tier];
+    std::string raw = rawPath(path);
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout)
+      return false;
+    fprintf(fout, "ObjectType = Image\nNDims = 3\nBinaryData = True\nBinaryDataByteOrderMSB = False\nCompressedData = False\n");
+    fprintf(fout, "ElementSpacing = 1 1 1\nDimSize = %d %d %d\nElementType = MET_USHORT\n", size, size, size);
+    fprintf(fout, "ElementDataFile = %s\n", String(raw.c_str()).extractFileName().toStdString().c_str());
+    fclose(fout);
+
+    std::vector<unsigned short> voxels( (size_t)size * size * size );
+    for(int z=0, k=0; z<size; ++z)
+      for(int y=0; y<size; ++y)
+        for(int x=0; x<size; ++x, ++k)
+          voxels[k] = (unsigned short)( (x*x + y*y + z*z) & 0xFFFF );
+    return writeFile(raw, &voxels[0], voxels.size() * sizeof(unsigned short));
+  }
+protected:
+  static std::string rawPath(const std::string& path) { return path.substr(0, path.size() - 4) + ".raw"; }
+};
+
+//-----------------------------------------------------------------------------
+// Harness
+//-----------------------------------------------------------------------------
+struct Asset
+{
+  std::string format;
+  std::string description;
+  std::string path;
+  long long bytes;
+};
+
+struct LoadResult
+{
+  std::string status;
+  int runs;
+  double median_ms;
+  double min_ms;
+  double mb_per_s;
+  long long peak_ram;
+  long long allocations;
+};
+
+// Loads `asset` `runs` times from memory with its ResourceLoadWriter, bypassing the ResourceCache and the load callbacks.
+LoadResult measure(const Asset& asset, int runs)
+{
+  LoadResult result;
+  result.runs = 0;
+  result.median_ms = result.min_ms = result.mb_per_s = 0;
+  result.peak_ram = result.allocations = 0;
+
+  // the file is read in memory once so that only the parsing is measured
+  ref<DiskFile> disk_file = new DiskFile( asset.path.c_str() );
+  ref<MemoryFile> file = new MemoryFile;
+  file->copy( disk_file.get() );
+  file->setPath( disk_file->path() );
+
+  const ResourceLoadWriter* loader = defLoadWriterManager()->findLoader( file.get() );
+  if (!loader)
+  {
+    result.status = "no-loader";
+    return result;
+  }
+
+  // warm up caches and allocators
+  if ( !loader->loadResource( file.get() ) )
+  {
+    result.status = "failed";
+    return result;
+  }
+
+  std::vector<double> ms;
+  for(int i=0; i<runs; ++i)
+  {
+    MemoryTracker::resetPeaks();
+    const long long ram = MemoryTracker::ramBytes();
+    const long long allocations = MemoryTracker::allocationCount();
+    unsigned long long start = Time::currentMicroseconds();
+    ref<ResourceDatabase> db = loader->loadResource( file.get() );
+    ms.push_back( (Time::currentMicroseconds() - start) / 1000.0 );
+    result.allocations = std::max( result.allocations, MemoryTracker::allocationCount() - allocations );
+    // the resources are still alive: the peak covers both the temporary and the loaded data
+    result.peak_ram = std::max( result.peak_ram, MemoryTracker::peakBytes(MC_Buffer) + MemoryTracker::peakBytes(MC_Image) - ram );
+    if ( !db )
+    {
+      result.status = "failed";
+      return result;
+    }
+  }
+  std::sort( ms.begin(), ms.end() );
+
+  result.status = "ok";
+  result.runs = runs;
+  result.median_ms = ms[ ms.size() / 2 ];
+  result.min_ms = ms.front();
+  // throughput from the median, MB = 2^20 bytes
+  result.mb_per_s = result.median_ms > 0 ? asset.bytes / (result.median_ms * 1e-3) / (1024.0*1024.0) : 0;
+  return result;
+}
+
+long long fileSize(const std::string& path)
+{
+  ref<DiskFile> file = new DiskFile( path.c_str() );
+  return file->exists() ? file->size() : -1;
+}
+
+//-----------------------------------------------------------------------------
+void printHelp()
+{
+  printf("\nusage:\n");
+  printf("  vlloaderbench [-filter text] [-tiers N] [-runs N] [-workdir dir] [-regenerate] [-assets dir] [-list] [-csv file]\n");
+  printf("\noptions:\n");
+  printf("  -filter      runs only the formats whose name contains the given text\n");
+  printf("  -tiers       number of asset sizes to generate and load, from 1 (small) to 3 (large, default)\n");
+  printf("  -runs        number of measured loads of each asset (default 5)\n");
+  printf("  -workdir     existing directory where the reference assets are generated (default: current directory)\n");
+  printf("  -regenerate  rewrites the reference assets even if they are already present in the working directory\n");
+  printf("  -assets      also loads every loadable file found in the given directory, for example COLLADA scenes\n");
+  printf("               or the VL data directory, can be repeated\n");
+  printf("  -list        lists the generated formats\n");
+  printf("  -csv         also writes the results to the given CSV file\n");
+  printf("\nEach asset is read in memory and then loaded with its ResourceLoadWriter, bypassing the ResourceCache.\n");
+  printf("The time is the median and the minimum over the runs, the throughput is computed from the median and the file size.\n");
+  printf("The peak RAM is the highest amount of Buffer and Image memory allocated during a load, see MemoryTracker.\n");
+  printf("The allocations are counted only if Visualization Library is built with VL_COUNT_ALLOCATIONS.\n");
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, const char* argv[])
+{
+  VisualizationLibrary::init(true);
+
+  printf("vlloaderbench 1.0 - Visualization Library Loaders Throughput Benchmark\n\n");
+
+  std::string filter;
+  std::string csv_file;
+  std::string workdir;
+  std::vector<std::string> asset_dirs;
+  int tiers = 3;
+  int runs = 5;
+  bool regenerate = false;
+  bool list = false;
+
+  for(int i=1; i<argc; ++i)
+  {
+    if ( i+1 < argc && strcmp(argv[i], "-filter") == 0)
+      filter = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-tiers") == 0)
+      tiers = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-runs") == 0)
+      runs = atoi(argv[++i]);
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-workdir") == 0)
+      workdir = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-assets") == 0)
+      asset_dirs.push_back( argv[++i] );
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-csv") == 0)
+      csv_file = argv[++i];
+    else
+    if ( strcmp(argv[i], "-regenerate") == 0)
+      regenerate = true;
+    else
+    if ( strcmp(argv[i], "-list") == 0)
+      list = true;
+    else
+    {
+      printf("unexpected argument '%s'\n", argv[i]);
+      printHelp();
+      return 1;
+    }
+  }
+
+  if (tiers < 1 || tiers > 3 || runs < 1)
+  {
+    printHelp();
+    return 1;
+  }
+
+  // keeps the loaders' warnings out of the report
+  globalSettings()->setVerbosityLevel( VEL_VERBOSITY_ERROR );
+
+  if ( !workdir.empty() && !DiskDirectory( workdir.c_str() ).exists() )
+  {
+    printf("working directory '%s' does not exist\n", workdir.c_str());
+    return 1;
+  }
+
+  std::vector< ref<AssetGenerator> > generators;
+  generators.push_back( new GenOBJ );
+  generators.push_back( new GenPLY(false) );
+  generators.push_back( new GenPLY(true) );
+  generators.push_back( new GenSTL(false) );
+  generators.push_back( new GenSTL(true) );
+  generators.push_back( new Gen3DS );
+  generators.push_back( new GenVLX(false) );
+  generators.push_back( new GenVLX(true) );
+  generators.push_back( new GenImage("PNG", "png", IF_RGBA, IT_UNSIGNED_BYTE) );
+  generators.push_back( new GenImage("JPG", "jpg", IF_RGB, IT_UNSIGNED_BYTE) );
+  generators.push_back( new GenImage("TIFF", "tif", IF_RGBA, IT_UNSIGNED_BYTE) );
+  generators.push_back( new GenImage("DICOM", "dcm", IF_LUMINANCE, IT_UNSIGNED_SHORT) );
+  generators.push_back( new GenDDS );
+  generators.push_back( new GenMHD );
+
+  if (list)
+  {
+    for(size_t i=0; i<generators.size(); ++i)
+    {
+      printf("%-12s", generators[i]->format().c_str());
+      for(int tier=0; tier<3; ++tier)
+        printf(" %-16s", generators[i]->describe(tier).c_str());
+      printf("\n");
+    }
+    return 0;
+  }
+
+  // generate the reference assets
+  std::vector<Asset> assets;
+  std::vector<std::string> unsupported;
+  for(size_t i=0; i<generators.size(); ++i)
+  {
+    AssetGenerator* gen = generators[i].get();
+    if ( !filter.empty() && gen->format().find(filter) == std::string::npos )
+      continue;
+    for(int tier=0; tier<tiers; ++tier)
+    {
+      std::string name = gen->format();
+      std::replace( name.begin(), name.end(), ' ', '_' );
+      char path[1024];
+      sprintf(path, "%s%svlloaderbench_%s_%d.%s", workdir.c_str(), workdir.empty() ? "" : "/", name.c_str(), tier, gen->extension().c_str());
+
+      Asset asset;
+      asset.format = gen->format();
+      asset.description = gen->describe(tier);
+      asset.path = path;
+      if ( regenerate || fileSize(asset.path) <= 0 )
+      {
+        printf("generating %s\n", asset.path.c_str());
+        if ( !gen->generate(asset.path, tier) )
+        {
+          // for example the images whose writer is not compiled in
+          unsupported.push_back( gen->format() );
+          break;
+        }
+      }
+      asset.bytes = fileSize(asset.path);
+      std::vector<std::string> companions = gen->companionFiles(asset.path);
+      for(size_t j=0; j<companions.size(); ++j)
+        asset.bytes += fileSize(companions[j]);
+      assets.push_back(asset);
+    }
+  }
+
+  // reference files provided by the user
+  for(size_t i=0; i<asset_dirs.size(); ++i)
+  {
+    std::vector<String> files;
+    DiskDirectory( asset_dirs[i].c_str() ).listFilesRecursive(files);
+    std::sort( files.begin(), files.end() );
+    for(size_t j=0; j<files.size(); ++j)
+    {
+      if ( !defLoadWriterManager()->canLoad( files[j] ) )
+        continue;
+      Asset asset;
+      asset.format = files[j].extractFileExtension(false).toUpperCase().toStdString();
+      if ( !filter.empty() && asset.format.find(filter) == std::string::npos )
+        continue;
+      asset.description = files[j].extractFileName().toStdString();
+      asset.path = files[j].toStdString();
+      asset.bytes = fileSize(asset.path);
+      assets.push_back(asset);
+    }
+  }
+
+  printf("\n%-12s %-24s %10s %10s %10s %10s %12s %12s\n", "format", "asset", "MB", "median ms", "min ms", "MB/s", "peak RAM MB", "allocs");
+  std::vector<LoadResult> results;
+  for(size_t i=0; i<assets.size(); ++i)
+  {
+    const Asset& a = assets[i];
+    LoadResult r = measure(a, runs);
+    results.push_back(r);
+    const double mb = a.bytes / (1024.0*1024.0);
+    if ( r.status != "ok" )
+      printf("%-12s %-24s %10.2f skipped, %s\n", a.format.c_str(), a.description.c_str(), mb, r.status.c_str());
+    else
+    if ( MemoryTracker::isCountingAllocations() )
+      printf("%-12s %-24s %10.2f %10.2f %10.2f %10.1f %12.2f %12lld\n", a.format.c_str(), a.description.c_str(), mb, r.median_ms, r.min_ms, r.mb_per_s, r.peak_ram / (1024.0*1024.0), r.allocations);
+    else
+      printf("%-12s %-24s %10.2f %10.2f %10.2f %10.1f %12.2f %12s\n", a.format.c_str(), a.description.c_str(), mb, r.median_ms, r.min_ms, r.mb_per_s, r.peak_ram / (1024.0*1024.0), "-");
+  }
+  for(size_t i=0; i<unsupported.size(); ++i)
+    printf("%-12s skipped, could not write the reference asset\n", unsupported[i].c_str());
+
+  if ( !csv_file.empty() )
+  {
+    FILE* fout = fopen(csv_file.c_str(), "wt");
+    if (!fout)
+    {
+      printf("\ncould not write '%s'\n", csv_file.c_str());
+      return 1;
+    }
+    fprintf(fout, "format,asset,bytes,status,runs,median_ms,min_ms,mb_per_s,peak_ram_bytes,allocations\n");
+    for(size_t i=0; i<assets.size(); ++i)
+    {
+      const Asset& a = assets[i];
+      const LoadResult& r = results[i];
+      fprintf(fout, "\"%s\",\"%s\",%lld,%s,%d,%.3f,%.3f,%.3f,%lld,%lld\n", a.format.c_str(), a.description.c_str(), a.bytes, r.status.c_str(), r.runs, r.median_ms, r.min_ms, r.mb_per_s, r.peak_ram, r.allocations);
+    }
+    fclose(fout);
+    printf("\nresults written to '%s'\n", csv_file.c_str());
+  }
+
+  VisualizationLibrary::shutdown();
+  return 0;
+}
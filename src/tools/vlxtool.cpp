@@ -5,18 +5,51 @@
 #include <string.h>
 #include <string>
 #include <vector>
+#include <set>
+#include <fstream>
 #include <vlCore/VisualizationLibrary.hpp>
 #include <vlCore/Time.hpp>
 #include <vlCore/ResourceDatabase.hpp>
+#include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/DiskDirectory.hpp>
+#include <vlCore/DiskFile.hpp>
 #include <vlX/ioVLX.hpp>
 #include <vlGraphics/expandResourceDatabase.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/DoubleVertexRemover.hpp>
+#include <vlGraphics/VertexCacheOptimizer.hpp>
+#include <vlGraphics/SceneFlattener.hpp>
 
 using namespace vl;
 
+struct ConvertOptions
+{
+  ConvertOptions(): flatten(false), weld(false), vcache(false), quantize(false) {}
+
+  bool flatten;
+  bool weld;
+  bool vcache;
+  bool quantize;
+};
+
 void printHelp()
 {
   printf("\nusage:\n");
-  printf("  vlxtool -in file1 file file3 ... -out file_out\n");
+  printf("  vlxtool -in file1 file file3 ... -out file_out [mesh options]\n");
+  printf("  vlxtool -batch dir|job_list -ext vlb|vlt [-outdir dir] [-jobs N] [-force] [mesh options]\n");
+  printf("\nmesh options:\n");
+  printf("  -flatten   bakes the transforms and merges the meshes sharing the same effect into spatial clusters\n");
+  printf("  -weld      removes duplicated vertices\n");
+  printf("  -vcache    reorders triangles and vertices for the post-transform vertex cache\n");
+  printf("  -quantize  compresses positions to shorts, normals to bytes and texture coordinates to half floats\n");
+  printf("\nbatch options:\n");
+  printf("  -batch     converts every loadable file of a directory or every file listed in a job list,\n");
+  printf("             one input path per line optionally followed by a tab and the output path\n");
+  printf("  -ext       the output format when the output path is not specified\n");
+  printf("  -outdir    the output directory when the output path is not specified, defaults to the input directory\n");
+  printf("  -jobs      the number of files converted in parallel, each by its own vlxtool process\n");
+  printf("  -force     converts also the files whose output is newer than the input\n");
   printf("\nexamples:\n");
   printf("  >  vlxtool -in file1.obj file2.3ds file3.vlb -out file_out.vlt\n");
   printf("     Merges the contents of file1.obj, file2.3ds and file3.vlb into file_out.vlt:\n\n");
@@ -24,8 +57,256 @@ void printHelp()
   printf("     Converts a VLT file to its VLB representation:\n\n");
   printf("  >  vlxtool -in file.vlb -out file.vlt\n");
   printf("     Converts a VLB file to its VLT representation:\n\n");
+  printf("  >  vlxtool -batch models/ -ext vlb -outdir cache/ -jobs 8 -weld -vcache\n");
+  printf("     Converts in parallel the out of date models to VLB optimizing their meshes:\n\n");
+}
+
+//-----------------------------------------------------------------------------
+// Applies the requested optimizations to the Geometries of the database.
+void optimizeMeshes(ResourceDatabase* db, const ConvertOptions& opt)
+{
+  std::vector< ref<Geometry> > geoms;
+  std::vector< ref<Actor> > actors;
+  db->get<Geometry>(geoms);
+  db->get<Actor>(actors);
+
+  for(size_t i=0; i<geoms.size(); ++i)
+  {
+    Geometry* geom = geoms[i].get();
+
+    if (opt.weld)
+    {
+      DoubleVertexRemover dvr;
+      dvr.setUseHashing(true);
+      dvr.removeDoubles(geom);
+    }
+
+    if (opt.vcache)
+      VertexCacheOptimizer().optimize(geom);
+
+    if (opt.quantize)
+    {
+      // the positions are quantized only if the decode matrix can be applied to all the Actors using the Geometry
+      std::vector<Actor*> users;
+      bool exclusive = true;
+      for(size_t j=0; j<actors.size(); ++j)
+      {
+        bool uses = false;
+        bool others = false;
+        for(int lod=0; lod<VL_MAX_ACTOR_LOD; ++lod)
+        {
+          if (actors[j]->lod(lod) == geom)
+            uses = true;
+          else
+          if (actors[j]->lod(lod))
+            others = true;
+        }
+        if (uses)
+          users.push_back( actors[j].get() );
+        exclusive &= !(uses && others);
+      }
+
+      bool positions = exclusive && !users.empty();
+      mat4 decode = geom->quantize(positions);
+      for(size_t j=0; positions && j<users.size(); ++j)
+      {
+        ref<Transform> tr = new Transform(decode);
+        if (users[j]->transform())
+          users[j]->transform()->addChild(tr.get());
+        users[j]->setTransform(tr.get());
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+int convert(const std::vector<std::string>& in_files, const String& out_file, const ConvertOptions& opt)
+{
+  if ( !out_file.endsWith(".vlt") && !out_file.endsWith(".vlb") )
+  {
+    printf("FAILED: output file must be either a .vlt or .vlb\n");
+    return 1;
+  }
+
+  printf("Loading...\n");
+  ref<ResourceDatabase> db = new ResourceDatabase;
+  for(size_t i=0; i<in_files.size(); ++i)
+  {
+    Time timer; timer.start();
+    printf("\t%s ", in_files[i].c_str());
+    ref<ResourceDatabase> res = vl::loadResource(in_files[i].c_str(), true);
+    if (res)
+    {
+      printf("\t... %.2fs\n", timer.elapsed());
+      db->resources().insert(db->resources().end(), res->resources().begin(), res->resources().end());
+    }
+    else
+    {
+      printf("\t... FAILED\n");
+      return 1;
+    }
+  }
+
+  expandResourceDatabase(db.get());
+
+  if (opt.flatten)
+  {
+    Time timer; timer.start();
+    printf("Flattening...");
+    ref<SceneFlattener> flattener = new SceneFlattener;
+    flattener->flatten(db.get());
+    printf("\t%d actors into %d ... %.2fs\n", flattener->statsInputActors(), flattener->statsOutputActors(), timer.elapsed());
+  }
+
+  if (opt.weld || opt.vcache || opt.quantize)
+  {
+    Time timer; timer.start();
+    printf("Optimizing meshes...");
+    optimizeMeshes(db.get(), opt);
+    printf("\t... %.2fs\n", timer.elapsed());
+  }
+
+  Time timer; timer.start();
+  bool ok = false;
+  if (out_file.endsWith(".vlt"))
+  {
+    printf("Saving VLT...\n");
+    printf("\t%s ", out_file.toStdString().c_str());
+    ok = vlX::saveVLT(out_file, db.get());
+  }
+  else
+  {
+    printf("Saving VLB...\n");
+    printf("\t%s ", out_file.toStdString().c_str());
+    ok = vlX::saveVLB(out_file, db.get());
+  }
+  if (ok)
+    printf("\t... %.2fs\n", timer.elapsed());
+  else
+    printf("\t... FAILED\n");
+
+  return ok ? 0 : 1;
+}
+//-----------------------------------------------------------------------------
+// Returns true if the output exists and is newer than the input.
+bool isUpToDate(const String& in_file, const String& out_file)
+{
+  ref<DiskFile> in = new DiskFile(in_file);
+  ref<DiskFile> out = new DiskFile(out_file);
+  if ( !out->exists() )
+    return false;
+  long long in_time = in->lastModified();
+  long long out_time = out->lastModified();
+  return in_time != -1 && out_time != -1 && out_time >= in_time;
 }
+//-----------------------------------------------------------------------------
+int convertBatch(const char* argv0, const String& batch, const String& ext, const String& out_dir, int jobs, bool force, const ConvertOptions& opt)
+{
+  if ( !out_dir.empty() && !DiskDirectory(out_dir).exists() )
+  {
+    printf("FAILED: output directory '%s' does not exist.\n", out_dir.toStdString().c_str());
+    return 1;
+  }
 
+  // collect the input/output pairs
+  std::vector<String> inputs;
+  std::vector<String> outputs;
+  DiskDirectory dir(batch);
+  if (dir.exists())
+  {
+    std::vector<String> files;
+    dir.listFiles(files);
+    for(size_t i=0; i<files.size(); ++i)
+    {
+      if (defLoadWriterManager()->canLoad(files[i]))
+      {
+        inputs.push_back(files[i]);
+        outputs.push_back(String());
+      }
+    }
+  }
+  else
+  {
+    std::ifstream list(batch.toStdString().c_str());
+    if (!list)
+    {
+      printf("FAILED: could not open '%s'.\n", batch.toStdString().c_str());
+      return 1;
+    }
+    std::string line;
+    while(std::getline(list, line))
+    {
+      if (!line.empty() && line[line.size()-1] == '\r')
+        line.resize(line.size()-1);
+      if (line.empty() || line[0] == '#')
+        continue;
+      size_t tab = line.find('\t');
+      inputs.push_back( String::fromStdString(line.substr(0, tab)) );
+      outputs.push_back( tab == std::string::npos ? String() : String::fromStdString(line.substr(tab+1)) );
+    }
+  }
+
+  // derive the missing output paths and skip the up to date outputs
+  std::vector<std::string> commands;
+  for(size_t i=0; i<inputs.size(); ++i)
+  {
+    if (outputs[i].empty())
+    {
+      if (ext.empty())
+      {
+        printf("FAILED: missing -ext for '%s'.\n", inputs[i].toStdString().c_str());
+        return 1;
+      }
+      String name = inputs[i].extractFileName();
+      String in_ext = name.extractFileExtension();
+      if (!in_ext.empty())
+        name = name.left( -(in_ext.length() + 1) );
+      String dir_path = out_dir.empty() ? inputs[i].extractPath() : out_dir;
+      if (!dir_path.empty() && !dir_path.endsWith('/') && !dir_path.endsWith('\\'))
+        dir_path += '/';
+      outputs[i] = dir_path + name + "." + ext;
+    }
+
+    if (outputs[i] == inputs[i])
+      continue;
+
+    if (!force && isUpToDate(inputs[i], outputs[i]))
+    {
+      printf("up to date: %s\n", outputs[i].toStdString().c_str());
+      continue;
+    }
+
+    std::string cmd = std::string("\"") + argv0 + "\" -in \"" + inputs[i].toStdString() + "\" -out \"" + outputs[i].toStdString() + "\"";
+    if (opt.flatten)
+      cmd += " -flatten";
+    if (opt.weld)
+      cmd += " -weld";
+    if (opt.vcache)
+      cmd += " -vcache";
+    if (opt.quantize)
+      cmd += " -quantize";
+    commands.push_back(cmd);
+  }
+
+  printf("Converting %d of %d files...\n", (int)commands.size(), (int)inputs.size());
+
+  // every file is converted by its own process so that the loaders don't need to be thread safe
+  Time timer; timer.start();
+  int failed = 0;
+  int count = (int)commands.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(jobs) reduction(+:failed) if(jobs > 1)
+#endif
+  for(int i=0; i<count; ++i)
+  {
+    if ( system(commands[i].c_str()) != 0 )
+      failed += 1;
+  }
+  (void)jobs;
+
+  printf("Converted %d files, %d failed ... %.2fs\n", count - failed, failed, timer.elapsed());
+  return failed ? 1 : 0;
+}
+//-----------------------------------------------------------------------------
 int main(int argc, const char* argv[])
 {
   VisualizationLibrary::init(true);
@@ -35,6 +316,12 @@ int main(int argc, const char* argv[])
 
   std::vector<std::string> in_files;
   String out_file;
+  String batch;
+  String ext;
+  String out_dir;
+  int jobs = 1;
+  bool force = false;
+  ConvertOptions opt;
 
   bool input = false;
   bool output = false;
@@ -53,6 +340,33 @@ int main(int argc, const char* argv[])
       output = true;
     }
     else
+    if ( strcmp(argv[i], "-flatten") == 0)
+      opt.flatten = true;
+    else
+    if ( strcmp(argv[i], "-weld") == 0)
+      opt.weld = true;
+    else
+    if ( strcmp(argv[i], "-vcache") == 0)
+      opt.vcache = true;
+    else
+    if ( strcmp(argv[i], "-quantize") == 0)
+      opt.quantize = true;
+    else
+    if ( strcmp(argv[i], "-force") == 0)
+      force = true;
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-batch") == 0)
+      batch = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-ext") == 0)
+      ext = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-outdir") == 0)
+      out_dir = argv[++i];
+    else
+    if ( i+1 < argc && strcmp(argv[i], "-jobs") == 0)
+      jobs = atoi(argv[++i]);
+    else
     if (input)
     {
       in_files.push_back(argv[i]);
@@ -76,6 +390,16 @@ int main(int argc, const char* argv[])
     }
   }
 
+  if (!batch.empty())
+  {
+    if (!ext.empty() && ext != "vlb" && ext != "vlt")
+    {
+      printf("FAILED: -ext must be either vlt or vlb\n");
+      return 1;
+    }
+    return convertBatch(argv[0], batch, ext, out_dir, jobs < 1 ? 1 : jobs, force, opt);
+  }
+
   if (in_files.empty() || out_file.empty())
   {
     if (in_files.empty())
@@ -88,48 +412,5 @@ int main(int argc, const char* argv[])
     return 1;
   }
 
-  printf("Loading...\n");
-  ref<ResourceDatabase> db = new ResourceDatabase;
-  for(size_t i=0; i<in_files.size(); ++i)
-  {
-    Time timer; timer.start();
-    printf("\t%s ", in_files[i].c_str());
-    ref<ResourceDatabase> res = vl::loadResource(in_files[i].c_str(), true);
-    if (res)
-    {
-      printf("\t... %.2fs\n", timer.elapsed());
-      db->resources().insert(db->resources().end(), res->resources().begin(), res->resources().end());
-    }
-    else
-    {
-      printf("\t... FAILED\n");
-      return 1;
-    }
-  }
-
-  expandResourceDatabase(db.get());
-
-  Time timer; timer.start();
-  if (out_file.endsWith(".vlt"))
-  {
-    printf("Saving VLT...\n");
-    printf("\t%s ", out_file.toStdString().c_str());
-    vlX::saveVLT(out_file, db.get());
-    printf("\t... %.2fs\n", timer.elapsed());
-  }
-  else
-  if (out_file.endsWith(".vlb"))
-  {
-    printf("Saving VLB...\n");
-    printf("\t%s ", out_file.toStdString().c_str());
-    vlX::saveVLB(out_file, db.get());
-    printf("\t... %.2fs\n", timer.elapsed());
-  }
-  else
-  {
-    printf("FAILED: output file must be either a .vlt or .vlb\n");
-    return 1;
-  }
-
-  return 0;
+  return convert(in_files, out_file, opt);
 }
@@ -79,6 +79,9 @@ namespace vl
     /** Returns true if the given point is inside the AABB. */
     bool isInside(const vec3& p) const;
 
+    /** Returns the squared distance between the given point and the AABB, 0 if the point is inside. */
+    real squaredDistance(const vec3& p) const { return (clip(p) - p).lengthSquared(); }
+
     /** Returns the width of the AABB computed as max.x - min.x */
     real width() const;
 
@@ -161,20 +164,35 @@ namespace vl
       if ( mMin.z() > p.z() ) mMin.z() = p.z();
     }
 
-    /** Transforms an AABB by the given matrix and returns it into the \p out parameter. */
+    /** Transforms an AABB by the given matrix and returns it into the \p out parameter.
+        Equivalent to adding the 8 transformed corners, but each axis of the result is computed by summing
+        the smaller and the larger of the products of each matrix element with the min and max coordinates (Arvo's method). */
     void transformed(AABB& out, const mat4& mat) const
     {
       out.setNull();
       if ( !isNull() )
       {
-        out.addPoint( mat * vec3(minCorner().x(), minCorner().y(), minCorner().z()) );
-        out.addPoint( mat * vec3(minCorner().x(), maxCorner().y(), minCorner().z()) );
-        out.addPoint( mat * vec3(maxCorner().x(), maxCorner().y(), minCorner().z()) );
-        out.addPoint( mat * vec3(maxCorner().x(), minCorner().y(), minCorner().z()) );
-        out.addPoint( mat * vec3(minCorner().x(), minCorner().y(), maxCorner().z()) );
-        out.addPoint( mat * vec3(minCorner().x(), maxCorner().y(), maxCorner().z()) );
-        out.addPoint( mat * vec3(maxCorner().x(), maxCorner().y(), maxCorner().z()) );
-        out.addPoint( mat * vec3(maxCorner().x(), minCorner().y(), maxCorner().z()) );
+        for(unsigned i=0; i<3; ++i)
+        {
+          real lo = 0, hi = 0;
+          for(unsigned j=0; j<3; ++j)
+          {
+            real a = mat.e(i,j) * mMin[j];
+            real b = mat.e(i,j) * mMax[j];
+            if (a < b)
+            {
+              lo += a;
+              hi += b;
+            }
+            else
+            {
+              lo += b;
+              hi += a;
+            }
+          }
+          out.mMin[i] = lo + mat.e(i,3);
+          out.mMax[i] = hi + mat.e(i,3);
+        }
       }
     }
 
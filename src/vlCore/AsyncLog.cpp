@@ -0,0 +1,252 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/AsyncLog.hpp>
+
+#ifdef VL_ASYNC_LOG
+
+#include <vlCore/Time.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/Say.hpp>
+#include <chrono>
+#include <cstddef>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// AsyncLog
+//-----------------------------------------------------------------------------
+AsyncLog::AsyncLog(Log* target, int capacity): mTarget(target), mRepeatLimit(10), mRepeatWindow(5000000), mDroppedReported(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  VL_CHECK(target && target != this);
+
+  size_t size = 2;
+  while( (int)size < capacity )
+    size <<= 1;
+  mMask = size - 1;
+  mCells = new Cell[size];
+  // the cell at position i is free for the producer that reserves position i
+  for(size_t i=0; i<size; ++i)
+    mCells[i].mSequence.store(i, std::memory_order_relaxed);
+  mEnqueuePos.store(0);
+  mDequeuePos.store(0);
+
+  for(int i=0; i<RepeatSlots; ++i)
+    mRepeatSlots[i].store(0, std::memory_order_relaxed);
+
+  mDropped.store(0);
+  mSuppressed.store(0);
+  mQuit.store(false);
+
+  mThread = std::thread(&AsyncLog::run, this);
+}
+//-----------------------------------------------------------------------------
+AsyncLog::~AsyncLog()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    mQuit.store(true);
+  }
+  mWake.notify_one();
+  mThread.join();
+  delete [] mCells;
+}
+//-----------------------------------------------------------------------------
+void AsyncLog::setRepeatLimit(int max_repeats, double window_seconds)
+{
+  // the count is stored in 16 bits
+  mRepeatLimit = max_repeats < 0 ? 0 : (max_repeats > 0xFFFE ? 0xFFFE : max_repeats);
+  mRepeatWindow = window_seconds > 0.000001 ? (unsigned long long)(window_seconds * 1000000.0) : 1;
+}
+//-----------------------------------------------------------------------------
+void AsyncLog::printImplementation(ELogLevel level, const String& message)
+{
+  if (message.empty())
+    return;
+
+  std::string utf8;
+  message.toUTF8(utf8, false);
+
+  u32 hash = 0;
+  MurmurHash3_x86_32( utf8.c_str(), (int)utf8.size(), 0, &hash );
+  bool suppressed_now = false;
+  if ( !admit(hash, suppressed_now) )
+  {
+    mSuppressed.fetch_add(1, std::memory_order_relaxed);
+    if (!suppressed_now)
+      return;
+    // the first suppressed copy is replaced by a note
+    std::string note = String( Say("AsyncLog: the following message is repeated too often, further copies are suppressed for up to %.1n seconds:\n") << repeatWindow() ).toStdString();
+    utf8 = note + utf8;
+    level = LL_LogWarning;
+  }
+
+  if ( !enqueue(level, utf8) )
+    mDropped.fetch_add(1, std::memory_order_relaxed);
+
+  // bugs are usually followed by a crash or an abort
+  if (level == LL_LogBug)
+    flush();
+}
+//-----------------------------------------------------------------------------
+bool AsyncLog::admit(u32 hash, bool& suppressed_now)
+{
+  suppressed_now = false;
+  if (mRepeatLimit <= 0)
+    return true;
+
+  const unsigned long long window = ( Time::currentMicroseconds() / mRepeatWindow ) & 0xFFFF;
+  const unsigned long long limit = (unsigned long long)mRepeatLimit;
+  std::atomic<unsigned long long>& slot = mRepeatSlots[hash % RepeatSlots];
+  unsigned long long old = slot.load(std::memory_order_relaxed);
+  for(;;)
+  {
+    unsigned long long count = 1;
+    if ( (old >> 32) == hash && ((old >> 16) & 0xFFFF) == window )
+    {
+      count = (old & 0xFFFF) + 1;
+      // already being suppressed in this window
+      if (count > limit + 1)
+        return false;
+    }
+    const unsigned long long value = ((unsigned long long)hash << 32) | (window << 16) | count;
+    if ( slot.compare_exchange_weak(old, value, std::memory_order_relaxed) )
+    {
+      suppressed_now = count == limit + 1;
+      return !suppressed_now;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool AsyncLog::enqueue(ELogLevel level, std::string& utf8)
+{
+  // bounded MPMC queue by Dmitry Vyukov, used here with a single consumer
+  size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+  Cell* cell = NULL;
+  for(;;)
+  {
+    cell = &mCells[pos & mMask];
+    const size_t seq = cell->mSequence.load(std::memory_order_acquire);
+    const ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+    if (dif == 0)
+    {
+      if ( mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+        break;
+    }
+    else
+    if (dif < 0)
+      return false; // full
+    else
+      pos = mEnqueuePos.load(std::memory_order_relaxed);
+  }
+
+  cell->mLevel = level;
+  cell->mMessage.swap(utf8);
+  cell->mSequence.store(pos + 1, std::memory_order_release);
+
+  // cheap when the background thread is not waiting
+  mWake.notify_one();
+  return true;
+}
+//-----------------------------------------------------------------------------
+void AsyncLog::run()
+{
+  size_t pos = 0;
+  std::string message;
+  for(;;)
+  {
+    const bool quit = mQuit.load();
+
+    for(;;)
+    {
+      Cell& cell = mCells[pos & mMask];
+      if ( cell.mSequence.load(std::memory_order_acquire) != pos + 1 )
+        break;
+      const ELogLevel level = cell.mLevel;
+      message.clear();
+      message.swap(cell.mMessage);
+      // releases the cell to the producers
+      cell.mSequence.store(pos + mMask + 1, std::memory_order_release);
+      write(level, message);
+      ++pos;
+      mDequeuePos.store(pos, std::memory_order_release);
+    }
+
+    const long long dropped = mDropped.load(std::memory_order_relaxed);
+    if (dropped != mDroppedReported)
+    {
+      write( LL_LogWarning, String( Say("AsyncLog: %n messages dropped, the queue is full.\n") << dropped - mDroppedReported ).toStdString() );
+      mDroppedReported = dropped;
+    }
+
+    mFlushed.notify_all();
+
+    if (quit)
+      break;
+
+    // the producers do not lock the mutex when notifying: the timeout bounds the latency of a missed notification
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    if ( mCells[pos & mMask].mSequence.load(std::memory_order_acquire) != pos + 1 && !mQuit.load() )
+      mWake.wait_for( lock, std::chrono::milliseconds(20) );
+  }
+}
+//-----------------------------------------------------------------------------
+void AsyncLog::write(ELogLevel level, const std::string& utf8)
+{
+  String message = String::fromUTF8( utf8.c_str(), (int)utf8.size() );
+  if ( mTarget->isThreadSafe() )
+    mTarget->printImplementation(level, message);
+  else
+  {
+    ScopedMutex mutex(Log::logMutex());
+    mTarget->printImplementation(level, message);
+  }
+}
+//-----------------------------------------------------------------------------
+void AsyncLog::flush()
+{
+  // called while writing a message, e.g. by a failed VL_CHECK
+  if ( std::this_thread::get_id() == mThread.get_id() )
+    return;
+
+  const size_t target = mEnqueuePos.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(mWakeMutex);
+  while( mDequeuePos.load(std::memory_order_acquire) < target )
+  {
+    mWake.notify_one();
+    mFlushed.wait_for( lock, std::chrono::milliseconds(5) );
+  }
+}
+//-----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,149 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef AsyncLog_INCLUDE_ONCE
+#define AsyncLog_INCLUDE_ONCE
+
+#include <vlCore/Log.hpp>
+
+#ifdef VL_ASYNC_LOG
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // AsyncLog
+  //-----------------------------------------------------------------------------
+  /**
+   * A logger that queues the messages in a lock-free ring buffer and writes them to a target logger from a background thread,
+   * so that the threads emitting the messages never wait for console or file I/O.
+   *
+   * Usage:
+   * \code
+   * vl::setDefLogger( new vl::AsyncLog( vl::defLogger() ) );
+   * \endcode
+   *
+   * - Any number of threads can log concurrently: the queue is a bounded multiple-producer single-consumer ring buffer and
+   *   Log::logMutex() is not locked since isThreadSafe() returns true. The target logger is only called from the background thread.
+   * - When the queue is full the new messages are dropped and counted, a warning reporting their number is issued as soon as the queue has room.
+   * - Identical messages are rate limited: at most repeatLimit() copies per repeatWindow() are queued, a note is logged when a message starts being suppressed.
+   * - Call flush() to wait until all the messages queued so far have been written. Messages of level LL_LogBug are flushed immediately.
+   *
+   * \note Available only if VL is built with the CMake option VL_ASYNC_LOG (requires C++11).
+   */
+  class VLCORE_EXPORT AsyncLog: public Log
+  {
+    VL_INSTRUMENT_CLASS(vl::AsyncLog, Log)
+
+  public:
+    /** Constructor.
+      * \param target The logger to which the messages are written from the background thread.
+      * \param capacity The maximum number of messages in the queue, rounded up to a power of 2. */
+    AsyncLog(Log* target, int capacity=4096);
+
+    /** Writes all the pending messages and stops the background thread. */
+    ~AsyncLog();
+
+    Log* target() { return mTarget.get(); }
+
+    int capacity() const { return (int)mMask + 1; }
+
+    /** Allows at most \p max_repeats identical messages every \p window_seconds, 0 disables the rate limiting. Default: 10 every 5 seconds. */
+    void setRepeatLimit(int max_repeats, double window_seconds);
+
+    int repeatLimit() const { return mRepeatLimit; }
+
+    double repeatWindow() const { return mRepeatWindow / 1000000.0; }
+
+    /** Number of messages dropped so far because the queue was full. */
+    long long droppedMessages() const { return mDropped.load(std::memory_order_relaxed); }
+
+    /** Number of messages suppressed so far by the rate limiting. */
+    long long suppressedMessages() const { return mSuppressed.load(std::memory_order_relaxed); }
+
+    virtual bool isThreadSafe() const { return true; }
+
+    virtual void flush();
+
+  protected:
+    virtual void printImplementation(ELogLevel level, const String& message);
+
+    bool enqueue(ELogLevel level, std::string& utf8);
+    bool admit(u32 hash, bool& suppressed_now);
+    void run();
+    void write(ELogLevel level, const std::string& utf8);
+
+  private:
+    AsyncLog(const AsyncLog&);
+    AsyncLog& operator=(const AsyncLog&);
+
+  protected:
+    struct Cell
+    {
+      std::atomic<size_t> mSequence;
+      ELogLevel mLevel;
+      std::string mMessage;
+    };
+
+    ref<Log> mTarget;
+
+    // ring buffer
+    Cell* mCells;
+    size_t mMask;
+    std::atomic<size_t> mEnqueuePos;
+    std::atomic<size_t> mDequeuePos;
+
+    // rate limiting: each slot packs message hash (32 bits), time window (16 bits) and count (16 bits)
+    enum { RepeatSlots = 256 };
+    std::atomic<unsigned long long> mRepeatSlots[RepeatSlots];
+    int mRepeatLimit;
+    unsigned long long mRepeatWindow; // microseconds
+
+    std::atomic<long long> mDropped;
+    std::atomic<long long> mSuppressed;
+    long long mDroppedReported;
+
+    // background thread
+    std::thread mThread;
+    std::mutex mWakeMutex;
+    std::condition_variable mWake;
+    std::condition_variable mFlushed;
+    std::atomic<bool> mQuit;
+  };
+}
+
+#endif
+
+#endif
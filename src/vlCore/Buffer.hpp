@@ -33,6 +33,8 @@
 #define Buffer_INCLUDE_ONCE
 
 #include <vlCore/Object.hpp>
+#include <vlCore/BufferArena.hpp>
+#include <vlCore/MemoryTracker.hpp>
 #include <string.h>
 
 namespace vl
@@ -42,6 +44,14 @@ namespace vl
   //-----------------------------------------------------------------------------
   /**
    * Implements a buffer whose storage is in local memory.
+   *
+   * The storage can be allocated in three ways:
+   * - AutoAllocatedBuffer: the buffer allocates and frees its own memory from the heap (default).
+   * - UserAllocatedBuffer: the buffer uses a user-provided memory area, see setUserAllocatedBuffer().
+   * - ArenaAllocatedBuffer: the buffer allocates its memory from a BufferArena and never frees it individually,
+   *   the memory is reclaimed in bulk by BufferArena::reset(), see setArena().
+   *
+   * The heap storage of AutoAllocatedBuffer[s] is reported to MemoryTracker under memoryCategory().
   */
   class Buffer: public Object
   {
@@ -51,7 +61,8 @@ namespace vl
     typedef enum
     {
       UserAllocatedBuffer,
-      AutoAllocatedBuffer
+      AutoAllocatedBuffer,
+      ArenaAllocatedBuffer
     } EAllocationMode;
 
   public:
@@ -60,22 +71,26 @@ namespace vl
       VL_DEBUG_SET_OBJECT_NAME()
       mPtr = NULL;
       mByteCount = 0;
+      mCapacity = 0;
       mAlignment = VL_DEFAULT_BUFFER_BYTE_ALIGNMENT;
       mAllocationMode = AutoAllocatedBuffer;
+      mMemoryCategory = MC_Buffer;
     }
     Buffer(const Buffer& other): Object(other)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mPtr = NULL;
       mByteCount = 0;
+      mCapacity = 0;
       mAlignment = VL_DEFAULT_BUFFER_BYTE_ALIGNMENT;
       mAllocationMode = AutoAllocatedBuffer;
+      mMemoryCategory = MC_Buffer;
       // copy local data
       *this = other;
     }
     Buffer& operator=(const Buffer& other)
     {
-      if ( mAllocationMode == AutoAllocatedBuffer)
+      if ( mAllocationMode != UserAllocatedBuffer )
       {
         // same alignment
         mAlignment = other.mAlignment;
@@ -97,18 +112,37 @@ namespace vl
     // swaps the data
     void swap(Buffer& other)
     {
+      // the storage changes owner but the categories don't
+      if ( mMemoryCategory != other.mMemoryCategory )
+      {
+        long long this_bytes = heapBytes();
+        long long other_bytes = other.heapBytes();
+        int this_objects = this_bytes ? 1 : 0;
+        int other_objects = other_bytes ? 1 : 0;
+        MemoryTracker::track( mMemoryCategory, other_bytes - this_bytes, other_objects - this_objects );
+        MemoryTracker::track( other.mMemoryCategory, this_bytes - other_bytes, this_objects - other_objects );
+      }
       // temp
       unsigned char* tmp_ptr = mPtr;
       size_t tmp_byte_count = mByteCount;
+      size_t tmp_capacity = mCapacity;
       size_t tmp_alignment = mAlignment;
+      EAllocationMode tmp_allocation_mode = mAllocationMode;
       // this <- other
       mPtr = other.mPtr;
       mByteCount = other.mByteCount;
+      mCapacity = other.mCapacity;
       mAlignment = other.mAlignment;
+      mAllocationMode = other.mAllocationMode;
       // this -> other
       other.mPtr = tmp_ptr;
       other.mByteCount = tmp_byte_count;
+      other.mCapacity = tmp_capacity;
       other.mAlignment = tmp_alignment;
+      other.mAllocationMode = tmp_allocation_mode;
+      // the storage travels with its arena
+      mArena.swap(other.mArena);
+      mUserBufferOwner.swap(other.mUserBufferOwner);
     }
 
     ~Buffer()
@@ -119,17 +153,31 @@ namespace vl
     void clear()
     {
       if ( mAllocationMode == AutoAllocatedBuffer ) {
+        if ( mCapacity )
+          MemoryTracker::track( mMemoryCategory, -(long long)mCapacity, -1 );
         alignedFree(mPtr);
       }
       mPtr = NULL;
       mByteCount = 0;
-      mAllocationMode = AutoAllocatedBuffer;
+      mCapacity = 0;
+      mUserBufferOwner = NULL;
+      // arena-allocated memory is reclaimed by BufferArena::reset()
+      if ( mAllocationMode != ArenaAllocatedBuffer ) {
+        mAllocationMode = AutoAllocatedBuffer;
+      }
     }
 
-    // if alignment < 1 uses the last specified alignment or the default one
+    /**
+     * Changes the number of bytes used by the buffer preserving its content.
+     * If \p alignment < 1 uses the last specified alignment or the default one.
+     * The storage is reallocated only when \p byte_count exceeds capacity() or the alignment changes,
+     * and grows geometrically so that a sequence of growing resizes runs in amortized linear time.
+     * Shrinking never reallocates, use shrink() to release the unused capacity and resize(0) or clear()
+     * to release all the storage.
+     */
     void resize(size_t byte_count, size_t alignment = 0)
     {
-      VL_CHECK( mAllocationMode == AutoAllocatedBuffer );
+      VL_CHECK( mAllocationMode != UserAllocatedBuffer );
 
       if (byte_count == 0)
       {
@@ -138,62 +186,118 @@ namespace vl
       }
 
       alignment = alignment >= 1 ? alignment : mAlignment;
-      if ( byte_count != mByteCount || alignment != mAlignment)
+      if ( byte_count > mCapacity )
       {
-        mAlignment = alignment;
-        // allocate the new chunk
-        unsigned char* ptr = NULL;
-        if (byte_count)
-          ptr = (unsigned char*)alignedMalloc(byte_count, mAlignment);
-        if (mPtr)
-        {
-          if (byte_count)
-          {
-            size_t min = mByteCount < byte_count ? mByteCount : byte_count;
-            // copy the old content brutally
-            memcpy(ptr, mPtr, min);
-          }
-          // free the old pointer
-          alignedFree(mPtr);
-        }
-        // set the new pointer
-        mPtr = ptr;
-        // set the new reserved bytes
-        mByteCount = byte_count;
+        size_t capacity = mCapacity + mCapacity / 2;
+        reallocate( byte_count > capacity ? byte_count : capacity, alignment );
       }
+      else
+      if ( alignment != mAlignment )
+        reallocate( mCapacity, alignment );
+      mByteCount = byte_count;
+    }
+
+    //! Makes sure the buffer can hold at least \p byte_count bytes without reallocating, does not change bytesUsed().
+    void reserve(size_t byte_count)
+    {
+      VL_CHECK( mAllocationMode != UserAllocatedBuffer );
+      if ( byte_count > mCapacity )
+        reallocate( byte_count, mAlignment );
     }
 
+    //! Reallocates the storage to exactly bytesUsed() bytes, releasing the unused capacity.
+    void shrink()
+    {
+      VL_CHECK( mAllocationMode != UserAllocatedBuffer );
+      if ( mByteCount == 0 )
+        clear();
+      else
+      if ( mByteCount < mCapacity )
+        reallocate( mByteCount, mAlignment );
+    }
+
+    //! The number of bytes the buffer can hold without reallocating its storage.
+    size_t capacity() const { return mCapacity; }
+
     /**
      * Uses a user-allocated buffer as storage.
      * After calling this function any call to resize() is illegal.
      * Calling this function enables the UserAllocatedBuffer mode. Call
      * setAllocationMode( AutoAllocatedBuffer ) to revert to the default
      * behaviour.
+     * If \p owner is not NULL the buffer keeps a reference to it until the storage is released,
+     * this is used for example to keep alive the FileMapping whose pages are wrapped by the buffer.
      */
-    void setUserAllocatedBuffer(void* ptr, size_t bytes)
+    void setUserAllocatedBuffer(void* ptr, size_t bytes, Object* owner = NULL)
     {
+      // keep the owner alive across clear() in case it already owns the current storage
+      ref<Object> keep_owner = owner;
       clear();
+      mUserBufferOwner = owner;
       mPtr = (unsigned char*)ptr;
       mByteCount = bytes;
+      mCapacity = bytes;
       mAlignment = 0;
       mAllocationMode = UserAllocatedBuffer;
     }
 
+    /**
+     * Allocates the buffer storage from the given arena. Any previous content is discarded.
+     * After calling this function resize() carves its memory out of \p arena and clear() does
+     * not free anything: the memory is reclaimed in bulk by BufferArena::reset().
+     * Passing NULL reverts to the AutoAllocatedBuffer mode.
+     * \note Resizing an arena-allocated buffer leaves the previous storage unused inside the arena until it is reset.
+     */
+    void setArena(BufferArena* arena)
+    {
+      clear();
+      mArena = arena;
+      mAllocationMode = arena ? ArenaAllocatedBuffer : AutoAllocatedBuffer;
+      mAlignment = VL_DEFAULT_BUFFER_BYTE_ALIGNMENT;
+    }
+
+    //! The arena used in ArenaAllocatedBuffer mode, NULL otherwise.
+    BufferArena* arena() { return mArena.get(); }
+
+    //! The arena used in ArenaAllocatedBuffer mode, NULL otherwise.
+    const BufferArena* arena() const { return mArena.get(); }
+
+    //! \note Use setArena() to enable the ArenaAllocatedBuffer mode.
     void setAllocationMode( EAllocationMode mode )
     {
+      VL_CHECK( mode != ArenaAllocatedBuffer || mArena )
+      if ( mode == ArenaAllocatedBuffer && !mArena )
+        return;
       if ( mAllocationMode != mode )
       {
         clear();
+        if ( mode != ArenaAllocatedBuffer )
+          mArena = NULL;
         mAllocationMode = mode;
         // reset buffer data
         mPtr = 0;
         mByteCount = 0;
+        mCapacity = 0;
         mAlignment = 0;
       }
     }
 
     EAllocationMode allocationMode() const { return mAllocationMode; }
 
+    //! The MemoryTracker category the heap storage of the buffer is reported under, MC_Buffer by default.
+    void setMemoryCategory( EMemoryCategory category )
+    {
+      if ( mCapacity && mAllocationMode == AutoAllocatedBuffer )
+      {
+        MemoryTracker::track( mMemoryCategory, -(long long)mCapacity, -1 );
+        MemoryTracker::track( category, (long long)mCapacity, 1 );
+      }
+      mMemoryCategory = category;
+    }
+
+    //! The MemoryTracker category the heap storage of the buffer is reported under, MC_Buffer by default.
+    EMemoryCategory memoryCategory() const { return mMemoryCategory; }
+
     size_t bytesUsed() const { return mByteCount; }
 
     bool empty() const { return mByteCount == 0; }
@@ -261,11 +365,46 @@ namespace vl
       delete [] original_ptr;
     }
 
+  protected:
+    // moves the content to a new chunk of \p capacity bytes
+    void reallocate(size_t capacity, size_t alignment)
+    {
+      unsigned char* ptr = NULL;
+      if ( mAllocationMode == ArenaAllocatedBuffer )
+        ptr = (unsigned char*)mArena->allocate(capacity, alignment);
+      else
+      {
+        ptr = (unsigned char*)alignedMalloc(capacity, alignment);
+        MemoryTracker::track( mMemoryCategory, (long long)capacity - (long long)mCapacity, mCapacity ? 0 : 1 );
+      }
+      if (mPtr)
+      {
+        size_t min = mByteCount < capacity ? mByteCount : capacity;
+        // copy the old content brutally
+        memcpy(ptr, mPtr, min);
+        // free the old pointer, arena memory is reclaimed by BufferArena::reset()
+        if ( mAllocationMode == AutoAllocatedBuffer )
+          alignedFree(mPtr);
+      }
+      mPtr = ptr;
+      mCapacity = capacity;
+      mAlignment = alignment;
+      if ( mByteCount > capacity )
+        mByteCount = capacity;
+    }
+
+    // the bytes reported to MemoryTracker
+    long long heapBytes() const { return mAllocationMode == AutoAllocatedBuffer ? (long long)mCapacity : 0; }
+
   protected:
     unsigned char* mPtr;
     size_t mByteCount;
+    size_t mCapacity;
     size_t mAlignment;
     EAllocationMode mAllocationMode;
+    EMemoryCategory mMemoryCategory;
+    ref<BufferArena> mArena;
+    ref<Object> mUserBufferOwner;
   };
 
 }
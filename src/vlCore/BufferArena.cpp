@@ -0,0 +1,115 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/BufferArena.hpp>
+#include <vlCore/ScopedMutex.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+BufferArena::BufferArena(size_t block_size)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mCurrentBlock = 0;
+  mOffset = 0;
+  mBlockSize = block_size ? block_size : 1;
+  mUsedBytes = 0;
+  mReservedBytes = 0;
+  mAllocationCount = 0;
+  mMutex = NULL;
+}
+//-----------------------------------------------------------------------------
+BufferArena::~BufferArena()
+{
+  release();
+}
+//-----------------------------------------------------------------------------
+void* BufferArena::allocate(size_t bytes, size_t alignment)
+{
+  // alignment must be a power of two
+  if ( !alignment || (alignment & (alignment-1)) )
+    return NULL;
+
+  ScopedMutex lock(mMutex);
+
+  // find the first block, starting from the current one, with enough room left
+  for( ; mCurrentBlock < mBlocks.size(); ++mCurrentBlock, mOffset = 0 )
+  {
+    const Block& block = mBlocks[mCurrentBlock];
+    size_t addr = (size_t)(block.mPtr + mOffset);
+    size_t padding = (alignment - addr % alignment) % alignment;
+    if ( mOffset + padding + bytes <= block.mSize )
+    {
+      mOffset += padding + bytes;
+      mUsedBytes += padding + bytes;
+      ++mAllocationCount;
+      return block.mPtr + mOffset - bytes;
+    }
+  }
+
+  // allocate a new block, large enough for the request in the worst alignment case
+  Block block;
+  block.mSize = bytes + alignment - 1 > mBlockSize ? bytes + alignment - 1 : mBlockSize;
+  block.mPtr  = new unsigned char[block.mSize];
+  mBlocks.push_back(block);
+  mReservedBytes += block.mSize;
+  mCurrentBlock = mBlocks.size() - 1;
+
+  size_t addr = (size_t)block.mPtr;
+  size_t padding = (alignment - addr % alignment) % alignment;
+  mOffset = padding + bytes;
+  mUsedBytes += padding + bytes;
+  ++mAllocationCount;
+  return block.mPtr + padding;
+}
+//-----------------------------------------------------------------------------
+void BufferArena::reset()
+{
+  ScopedMutex lock(mMutex);
+  mCurrentBlock = 0;
+  mOffset = 0;
+  mUsedBytes = 0;
+  mAllocationCount = 0;
+}
+//-----------------------------------------------------------------------------
+void BufferArena::release()
+{
+  ScopedMutex lock(mMutex);
+  for(size_t i=0; i<mBlocks.size(); ++i)
+    delete [] mBlocks[i].mPtr;
+  mBlocks.clear();
+  mCurrentBlock = 0;
+  mOffset = 0;
+  mUsedBytes = 0;
+  mReservedBytes = 0;
+  mAllocationCount = 0;
+}
+//-----------------------------------------------------------------------------
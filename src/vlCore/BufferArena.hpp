@@ -0,0 +1,115 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef BufferArena_INCLUDE_ONCE
+#define BufferArena_INCLUDE_ONCE
+
+#include <vlCore/Object.hpp>
+#include <vector>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // BufferArena
+  //-----------------------------------------------------------------------------
+  /**
+   * A linear (bump) allocator used as storage for vl::Buffer objects in ArenaAllocatedBuffer mode.
+   *
+   * Allocations are carved sequentially out of large memory blocks and are never freed individually:
+   * reset() releases all of them at once while keeping the blocks around for reuse, release()
+   * returns the blocks to the system. This makes arenas ideal for transient geometry, such as per-frame
+   * or per-level data, that is created in bulk and discarded in bulk.
+   *
+   * \note Calling reset() or release() invalidates the storage of every Buffer allocated from the arena,
+   * such buffers must be cleared or resized before being used again.
+   * \note The arena is not thread-safe by default: install a mutex with setMutex() if buffers are resized from more than one thread.
+   * \sa Buffer::setArena(), vl::SmallObjectPool
+  */
+  class VLCORE_EXPORT BufferArena: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::BufferArena, Object)
+
+  public:
+    BufferArena(size_t block_size = 4*1024*1024);
+
+    ~BufferArena();
+
+    //! Returns \p bytes bytes aligned to \p alignment, which must be a power of two.
+    //! Returns NULL if \p alignment is not a power of two.
+    void* allocate(size_t bytes, size_t alignment);
+
+    //! Frees all the allocations at once, the memory blocks are kept and reused by subsequent allocations.
+    void reset();
+
+    //! Frees all the allocations and returns all the memory blocks to the system.
+    void release();
+
+    //! The minimum size of the blocks allocated by the arena. Larger requests get a dedicated block.
+    size_t blockSize() const { return mBlockSize; }
+
+    //! The number of bytes currently handed out by the arena, including alignment padding.
+    size_t usedBytes() const { return mUsedBytes; }
+
+    //! The number of bytes reserved by the arena's blocks.
+    size_t reservedBytes() const { return mReservedBytes; }
+
+    //! The number of allocations performed since the last reset() or release().
+    size_t allocationCount() const { return mAllocationCount; }
+
+    //! The mutex used to serialize allocations, NULL by default.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex used to serialize allocations, NULL by default.
+    IMutex* mutex() const { return mMutex; }
+
+  private:
+    BufferArena(const BufferArena&);
+    BufferArena& operator=(const BufferArena&);
+
+    struct Block
+    {
+      unsigned char* mPtr;
+      size_t mSize;
+    };
+
+  private:
+    std::vector<Block> mBlocks;
+    size_t mCurrentBlock;
+    size_t mOffset;
+    size_t mBlockSize;
+    size_t mUsedBytes;
+    size_t mReservedBytes;
+    size_t mAllocationCount;
+    IMutex* mMutex;
+  };
+}
+
+#endif
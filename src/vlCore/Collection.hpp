@@ -68,6 +68,20 @@ namespace vl
       return *this;
     }
 
+#if VL_HAS_MOVE_SEMANTICS
+    Collection(std::vector< ref<T> >&& vector)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+      mVector.swap(vector);
+    }
+
+    Collection& operator=(std::vector< ref<T> >&& vector)
+    {
+      mVector.swap(vector);
+      return *this;
+    }
+#endif
+
     operator std::vector< ref<T> >() const
     {
       return mVector;
@@ -103,6 +117,10 @@ namespace vl
 
     void swap(Collection& other) { mVector.swap(other.mVector); }
 
+    //! Exchanges the content of the Collection with the given vector without changing any reference count.
+    //! Use it to fill a Collection from a vector built elsewhere without copying it.
+    void swap(std::vector< ref<T> >& vector) { mVector.swap(vector); }
+
     // added functionalities
 
     void sort()
@@ -121,7 +139,11 @@ namespace vl
 
     void shrink()
     {
-      Collection<T>(mVector).swap(mVector);
+      // move the references into a vector of the exact size without touching the reference counts.
+      std::vector< ref<T> > tight( mVector.size() );
+      for( size_t i=0; i<mVector.size(); ++i )
+        tight[i].swap( mVector[i] );
+      mVector.swap( tight );
     }
 
     void push_back(const Collection<T>& objs )
@@ -0,0 +1,83 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/DirtyTracker.hpp>
+#include <vlCore/checks.hpp>
+
+#ifdef VL_ATOMIC_REF_COUNT
+  #include <atomic>
+#endif
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+namespace
+{
+#ifdef VL_ATOMIC_REF_COUNT
+  std::atomic<long long> gDirtyTick(0);
+  std::atomic<int> gContinuousSources(0);
+#else
+  long long gDirtyTick = 0;
+  int gContinuousSources = 0;
+#endif
+}
+//-----------------------------------------------------------------------------
+void DirtyTracker::markDirty()
+{
+#if defined(_OPENMP) && !defined(VL_ATOMIC_REF_COUNT)
+  #pragma omp atomic
+#endif
+  ++gDirtyTick;
+}
+//-----------------------------------------------------------------------------
+long long DirtyTracker::tick()
+{
+  return gDirtyTick;
+}
+//-----------------------------------------------------------------------------
+void DirtyTracker::addContinuousSource()
+{
+  ++gContinuousSources;
+}
+//-----------------------------------------------------------------------------
+void DirtyTracker::removeContinuousSource()
+{
+  VL_CHECK( gContinuousSources > 0 )
+  --gContinuousSources;
+  // the last frame of the animation has to be drawn as well
+  markDirty();
+}
+//-----------------------------------------------------------------------------
+int DirtyTracker::continuousSources()
+{
+  return gContinuousSources;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef DirtyTracker_INCLUDE_ONCE
+#define DirtyTracker_INCLUDE_ONCE
+
+#include <vlCore/link_config.hpp>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // DirtyTracker
+  //-----------------------------------------------------------------------------
+  /**
+   * Global scene change counter used to redraw an idle window only when something changed, see OpenGLContext::setUpdateOnDemand().
+   *
+   * Transform, Actor, Effect, Shader, Uniform, Camera and the ActorTree[s] call markDirty() whenever they are modified.
+   * Changes performed through other means, for example by modifying a RenderState or an Array directly, should be
+   * followed by an explicit markDirty().
+   *
+   * Animations that change the scene during the rendering itself, like MorphingCallback and ShaderAnimator, register
+   * as continuous sources with addContinuousSource() while they are running: as long as at least one is active the
+   * scene is always considered dirty.
+   *
+   * \note The counters are atomic if Visualization Library is built with VL_ATOMIC_REF_COUNT, otherwise an increment lost
+   * by concurrent calls only delays a redraw that another increment already requested.
+   */
+  class VLCORE_EXPORT DirtyTracker
+  {
+  public:
+    //! Flags the scene as changed.
+    static void markDirty();
+
+    //! Incremented by every markDirty(): the scene changed if the value differs from the one recorded after the last redraw.
+    static long long tick();
+
+    //! Registers an animation that requires a redraw every frame while it is running.
+    static void addContinuousSource();
+
+    //! Unregisters an animation registered with addContinuousSource().
+    static void removeContinuousSource();
+
+    //! The number of running continuous sources.
+    static int continuousSources();
+
+  private:
+    DirtyTracker() {}
+  };
+}
+
+#endif
@@ -47,18 +47,38 @@ using namespace vl;
 //-----------------------------------------------------------------------------
 // DiskDirectory
 //-----------------------------------------------------------------------------
-DiskDirectory::DiskDirectory( const String& name )
+DiskDirectory::DiskDirectory( const String& name ): mThreadCount(1)
 {
   setPath(name);
 }
 //-----------------------------------------------------------------------------
-DiskDirectory::DiskDirectory()
+DiskDirectory::DiskDirectory(): mThreadCount(1)
 {
 }
 //-----------------------------------------------------------------------------
 void DiskDirectory::listFilesRecursive(std::vector<String>& file_list) const
 {
   file_list.clear();
+#ifdef _OPENMP
+  if ( mThreadCount > 1 )
+  {
+    listFiles(file_list, true);
+    // each top level subdirectory is listed by one thread, the results are concatenated in order
+    std::vector<String> dir_list;
+    listSubDirs(dir_list);
+    std::vector< std::vector<String> > sub_lists( dir_list.size() );
+    const int count = (int)dir_list.size();
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(count > 1)
+    for(int i=0; i<count; ++i)
+    {
+      DiskDirectory sub_dir( dir_list[i] );
+      sub_dir.listFilesRecursive_internal( sub_lists[i] );
+    }
+    for(size_t i=0; i<sub_lists.size(); ++i)
+      file_list.insert( file_list.end(), sub_lists[i].begin(), sub_lists[i].end() );
+    return;
+  }
+#endif
   listFilesRecursive_internal(file_list);
 }
 //-----------------------------------------------------------------------------
@@ -43,6 +43,8 @@ namespace vl
   /**
    * A VirtualDirectory that operates on reguar disk directories.
    *
+   * When compiled with OpenMP listFilesRecursive() can list the top level subdirectories in parallel, see setThreadCount().
+   *
    * \sa
    * - MemoryDirectory
    * - ZippedDirectory
@@ -81,8 +83,17 @@ namespace vl
 
     bool exists() const;
 
+    //! The number of threads used by listFilesRecursive() to list the subdirectories, requires OpenMP (default = 1).
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    //! The number of threads used by listFilesRecursive() to list the subdirectories.
+    int threadCount() const { return mThreadCount; }
+
   protected:
     void listFilesRecursive_internal(std::vector<String>& file_list) const;
+
+  protected:
+    int mThreadCount;
   };
 }
 
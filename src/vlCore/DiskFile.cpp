@@ -169,6 +169,31 @@ long long DiskFile::size() const
   #endif
 }
 //-----------------------------------------------------------------------------
+long long DiskFile::lastModified() const
+{
+  #if defined(VL_PLATFORM_WINDOWS)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if ( !GetFileAttributesEx( (const wchar_t*)path().ptr(), GetFileExInfoStandard, &data ) )
+      return -1;
+    ULARGE_INTEGER time;
+    time.LowPart  = data.ftLastWriteTime.dwLowDateTime;
+    time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+    // 100ns intervals since 1601 to seconds since 1970
+    return (long long)( (time.QuadPart - 116444736000000000ULL) / 10000000ULL );
+  #elif defined(__GNUG__)
+    struct stat mybuf;
+    memset(&mybuf, 0, sizeof(struct stat));
+    std::vector<unsigned char> utf8;
+    path().toUTF8( utf8, false );
+    if (utf8.empty())
+      return -1;
+    if (stat((char*)&utf8[0], &mybuf) == -1)
+      return -1;
+    else
+      return (long long)mybuf.st_mtime;
+  #endif
+}
+//-----------------------------------------------------------------------------
 bool DiskFile::exists() const
 {
   if (path().empty())
@@ -86,6 +86,9 @@ namespace vl
     //! Returns the file size in bytes or -1 on error.
     virtual long long size() const;
 
+    //! Returns the last modification time of the file in seconds since the epoch or -1 on error.
+    long long lastModified() const;
+
     virtual bool exists() const;
 
     DiskFile& operator=(const DiskFile& other) { close(); super::operator=(other); return *this; }
@@ -31,6 +31,7 @@
 
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/DiskDirectory.hpp>
+#include <vlCore/MappedFile.hpp>
 #include <vlCore/GlobalSettings.hpp>
 
 using namespace vl;
@@ -78,15 +79,19 @@ ref<VirtualFile> FileSystem::locateFile(const String& full_path, const String& a
     // first look in the "." directory
     ref<DiskFile> disk_file = new DiskFile( paths[ipath] );
     if ( disk_file->exists() )
-      return disk_file;
+      return mMemoryMappedFiles ? new MappedFile( disk_file->path() ) : disk_file.get();
 
     // iterate backwards
     for( int idir=directories().size(); idir--; )
     {
       // returns the first one found
-      ref<VirtualFile> file  = directories()[idir]->file( paths[ipath] );
+      ref<VirtualFile> file  = directories()[idir]->lookupFile( paths[ipath] );
       if (file)
+      {
+        if ( mMemoryMappedFiles && file->as<DiskFile>() && !file->as<MappedFile>() )
+          return new MappedFile( file->path() );
         return file;
+      }
     }
   }
 
@@ -112,6 +117,18 @@ ref<VirtualDirectory> FileSystem::locateDirectory(const String& name) const
   return NULL;
 }
 //-----------------------------------------------------------------------------
+void FileSystem::setPathIndexing(bool enabled)
+{
+  for(size_t i=0; i<directories().size(); ++i)
+    directories()[i]->setPathIndexing(enabled);
+}
+//-----------------------------------------------------------------------------
+void FileSystem::invalidatePathIndices()
+{
+  for(size_t i=0; i<directories().size(); ++i)
+    directories()[i]->invalidatePathIndex();
+}
+//-----------------------------------------------------------------------------
 void FileSystem::listFilesRecursive(std::vector<String>& file_list ) const
 {
   file_list.clear();
@@ -45,6 +45,9 @@ namespace vl
    * Manages multiple VirtualDirectory objects.
    * Useful when you want to query more than one VirtualDirectory from a single point.
    *
+   * Loaders resolving many file references can enable setPathIndexing() so that locateFile() probes each directory
+   * through its path index instead of touching the disk, see VirtualDirectory::setPathIndexing().
+   *
    * \sa
    * - VirtualDirectory
    * - DiskDirectory
@@ -63,6 +66,7 @@ namespace vl
     FileSystem()
     {
       VL_DEBUG_SET_OBJECT_NAME()
+      mMemoryMappedFiles = false;
     }
 
     /** Looks for a VirtualFile on the disk and in the currently active FileSystem. */
@@ -86,8 +90,23 @@ namespace vl
     //! Returns the list of VirtualDirectory objects added to a FileSystem
     const std::vector< ref<VirtualDirectory> >& directories() const { return mDirectories; }
 
+    //! If \p true locateFile() returns a MappedFile instead of a DiskFile for the files found on disk,
+    //! allowing loaders like loadRAW() to use the mapped pages as storage without copying them. Disabled by default.
+    void setMemoryMappedFiles(bool enabled) { mMemoryMappedFiles = enabled; }
+
+    //! If \p true locateFile() returns a MappedFile instead of a DiskFile for the files found on disk.
+    bool memoryMappedFiles() const { return mMemoryMappedFiles; }
+
+    //! Calls VirtualDirectory::setPathIndexing() on all the directories added so far.
+    //! \note The "." directory probed first by locateFile() is never indexed.
+    void setPathIndexing(bool enabled);
+
+    //! Calls VirtualDirectory::invalidatePathIndex() on all the directories, for example when a file watcher reports a change.
+    void invalidatePathIndices();
+
   protected:
     std::vector< ref<VirtualDirectory> > mDirectories;
+    bool mMemoryMappedFiles;
   };
 
   //! Returns the default FileSystem used by VisualizationLibrary
@@ -0,0 +1,168 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlCore/FlatTransformHierarchy.hpp>
+#include <cstring>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+void FlatTransformHierarchy::clear()
+{
+  mTransforms.clear();
+  mLocal.clear();
+  mWorld.clear();
+  mParent.clear();
+  mType.clear();
+  mLevelStart.clear();
+}
+//-----------------------------------------------------------------------------
+void FlatTransformHierarchy::build(Transform* root)
+{
+  clear();
+  if (!root)
+    return;
+
+  // breadth first visit: the Transforms end up sorted by depth and each parent precedes its children
+  mTransforms.push_back(root);
+  mParent.push_back(-1);
+  mLevelStart.push_back(0);
+  int level_begin = 0;
+  while( level_begin < (int)mTransforms.size() )
+  {
+    const int level_end = (int)mTransforms.size();
+    for(int i=level_begin; i<level_end; ++i)
+    {
+      Transform* tr = mTransforms[i].get();
+      for(size_t j=0; j<tr->childrenCount(); ++j)
+      {
+        mTransforms.push_back( tr->children()[j] );
+        mParent.push_back(i);
+      }
+    }
+    mLevelStart.push_back(level_end);
+    level_begin = level_end;
+  }
+
+  mLocal.resize( mTransforms.size() );
+  mWorld.resize( mTransforms.size() );
+  mType.resize( mTransforms.size() );
+  for(size_t i=0; i<mTransforms.size(); ++i)
+  {
+    Transform* tr = mTransforms[i].get();
+    mWorld[i] = tr->worldMatrix();
+    if ( !(tr->classType() == Transform::Type()) )
+      mType[i] = FT_Custom;
+    else
+    if ( tr->assumeIdentityWorldMatrix() )
+      mType[i] = FT_Identity;
+    else
+    if ( !tr->parent() || tr->parent()->assumeIdentityWorldMatrix() )
+      mType[i] = FT_ParentIdentity;
+    else
+      mType[i] = FT_Default;
+  }
+}
+//-----------------------------------------------------------------------------
+void FlatTransformHierarchy::update(Camera* camera)
+{
+  const int count = size();
+  if (!count)
+    return;
+
+  // gather the local matrices
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+  for(int i=0; i<count; ++i)
+    mLocal[i] = static_cast<const Transform*>( mTransforms[i].get() )->localMatrix();
+
+  // the root's parent, if any, is not part of the hierarchy
+  Transform* root = mTransforms[0].get();
+  if ( mType[0] == FT_Custom )
+  {
+    root->computeWorldMatrix(camera);
+    mWorld[0] = root->worldMatrix();
+  }
+  else
+  if ( mType[0] == FT_Identity )
+    mWorld[0] = mat4();
+  else
+  if ( mType[0] == FT_ParentIdentity )
+    mWorld[0] = mLocal[0];
+  else
+    mWorld[0] = root->parent()->worldMatrix() * mLocal[0];
+
+  // level by level sweep, the entries of a level only depend on the previous one
+  for(int level=1; level<levelCount(); ++level)
+  {
+    const int begin = mLevelStart[level];
+    const int end   = mLevelStart[level+1];
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(mThreadCount) if(mThreadCount > 1 && end - begin > 1024)
+#endif
+    for(int i=begin; i<end; ++i)
+    {
+      switch( mType[i] )
+      {
+      case FT_Default:        mWorld[i] = mWorld[ mParent[i] ] * mLocal[i]; break;
+      case FT_ParentIdentity: mWorld[i] = mLocal[i]; break;
+      case FT_Identity:       mWorld[i] = mat4(); break;
+      default: break;
+      }
+    }
+
+    for(int i=begin; i<end; ++i)
+    {
+      if ( mType[i] == FT_Custom )
+      {
+        // the parent's world matrix must be up to date before calling computeWorldMatrix()
+        Transform* parent = mTransforms[ mParent[i] ].get();
+        if ( memcmp(parent->worldMatrix().ptr(), mWorld[ mParent[i] ].ptr(), sizeof(mat4)) != 0 )
+          parent->setWorldMatrix( mWorld[ mParent[i] ] );
+        mTransforms[i]->computeWorldMatrix(camera);
+        mWorld[i] = mTransforms[i]->worldMatrix();
+      }
+    }
+  }
+
+  // write back the world matrices that changed
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+  for(int i=0; i<count; ++i)
+  {
+    if ( memcmp(mTransforms[i]->worldMatrix().ptr(), mWorld[i].ptr(), sizeof(mat4)) != 0 )
+      mTransforms[i]->setWorldMatrix( mWorld[i] );
+  }
+}
+//-----------------------------------------------------------------------------
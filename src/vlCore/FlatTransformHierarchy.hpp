@@ -0,0 +1,125 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef FlatTransformHierarchy_INCLUDE_ONCE
+#define FlatTransformHierarchy_INCLUDE_ONCE
+
+#include <vlCore/Transform.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // FlatTransformHierarchy
+  //------------------------------------------------------------------------------
+  /** Data-oriented storage of a Transform hierarchy used to compute its world matrices with a linear, level-parallel sweep.
+    *
+    * build() lays out the local and world matrices of a hierarchy in contiguous arrays sorted by depth, each entry knowing the index
+    * of its parent. update() then gathers the local matrices from the Transforms, computes all the world matrices one level at a time
+    * with a plain loop over the level's array range, which is run in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP)
+    * and threadCount() is greater than 1, and finally writes back to each Transform its world matrix.
+    * The Transform objects act as handles: the application keeps modifying their local matrices as usual.
+    *
+    * Only the world matrices that actually changed are written back so that the worldMatrixUpdateTick() of the static Transforms
+    * is left untouched. Transforms of derived classes overriding Transform::computeWorldMatrix() (for example Billboard) are
+    * supported but are computed calling their computeWorldMatrix() serially.
+    *
+    * \note The layout is not updated automatically: call build() again after adding or removing Transforms from the hierarchy
+    * or changing their assumeIdentityWorldMatrix() flag.
+    * \sa Transform::computeWorldMatrixRecursive(), Transform::computeDirtyWorldMatrices() */
+  class VLCORE_EXPORT FlatTransformHierarchy: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::FlatTransformHierarchy, Object)
+
+  public:
+    /** Constructor. */
+    FlatTransformHierarchy(): mThreadCount(1)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    /** Lays out the hierarchy rooted at \p root, which can have a parent not belonging to the hierarchy. */
+    void build(Transform* root);
+
+    /** Removes all the Transforms. */
+    void clear();
+
+    /** Computes the world matrices of the whole hierarchy, the equivalent of calling \p root->computeWorldMatrixRecursive(camera). */
+    void update(Camera* camera=NULL);
+
+    /** The number of Transforms in the hierarchy. */
+    int size() const { return (int)mTransforms.size(); }
+
+    /** The number of levels (the depth of the hierarchy + 1). */
+    int levelCount() const { return mLevelStart.empty() ? 0 : (int)mLevelStart.size() - 1; }
+
+    /** The Transforms of the level \p level are those in the range [levelStart(level), levelStart(level+1)). */
+    int levelStart(int level) const { return mLevelStart[level]; }
+
+    /** The i-th Transform of the hierarchy in depth order. */
+    Transform* transform(int i) { return mTransforms[i].get(); }
+
+    /** The i-th Transform of the hierarchy in depth order. */
+    const Transform* transform(int i) const { return mTransforms[i].get(); }
+
+    /** The index of the parent of the i-th Transform, -1 for the root. */
+    int parentIndex(int i) const { return mParent[i]; }
+
+    /** The world matrix of the i-th Transform computed by the last update(). */
+    const mat4& worldMatrix(int i) const { return mWorld[i]; }
+
+    /** The number of threads used by update(). Has effect only if VL is compiled with OpenMP support. */
+    void setThreadCount(int count) { mThreadCount = count > 1 ? count : 1; }
+
+    /** The number of threads used by update(). Has effect only if VL is compiled with OpenMP support. */
+    int threadCount() const { return mThreadCount; }
+
+  protected:
+    enum
+    {
+      FT_Default,         // world = parent world * local
+      FT_Identity,        // assumeIdentityWorldMatrix()
+      FT_ParentIdentity,  // world = local
+      FT_Custom           // computeWorldMatrix() is overridden
+    };
+
+  protected:
+    std::vector< ref<Transform> > mTransforms;
+    std::vector<mat4> mLocal;
+    std::vector<mat4> mWorld;
+    std::vector<int> mParent;
+    std::vector<unsigned char> mType;
+    std::vector<int> mLevelStart;
+    int mThreadCount;
+  };
+}
+
+#endif
@@ -34,15 +34,48 @@
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
 #include "zlib.h"
+#include <algorithm>
 
 using namespace vl;
 
+namespace
+{
+  const int DICTIONARY_SIZE = 32*1024;
+
+  //! Compresses a block as a sequence of raw deflate blocks ending on a byte boundary (or as the final block if \p last).
+  bool deflateBlock(const unsigned char* data, size_t size, const unsigned char* dictionary, size_t dictionary_size, int level, bool last, std::vector<unsigned char>& out)
+  {
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if ( deflateInit2(&strm, level, Z_DEFLATED, -15/*raw deflate*/, 8/*mem level*/, Z_DEFAULT_STRATEGY) != Z_OK )
+      return false;
+    if ( dictionary_size )
+      deflateSetDictionary( &strm, dictionary, (uInt)dictionary_size );
+    // room for the sync flush marker and the final empty block
+    out.resize( deflateBound(&strm, (uLong)size) + 64 );
+    strm.next_in   = (Bytef*)data;
+    strm.avail_in  = (uInt)size;
+    strm.next_out  = &out[0];
+    strm.avail_out = (uInt)out.size();
+    int ret = deflate( &strm, last ? Z_FINISH : Z_SYNC_FLUSH );
+    bool ok = last ? ret == Z_STREAM_END : ret == Z_OK && strm.avail_out != 0;
+    out.resize( out.size() - strm.avail_out );
+    deflateEnd(&strm);
+    return ok;
+  }
+}
+
 //-----------------------------------------------------------------------------
 // GZipCodec
 //-----------------------------------------------------------------------------
 GZipCodec::GZipCodec(VirtualFile* stream): mStream(stream)
 {
   mCompressionLevel = 6;
+  mChunkSize = CHUNK_SIZE;
+  mThreadCount = 1;
+  mBlockSize = 256*1024;
+  mCRC32 = 0;
+  mMode = ZNone;
   mReadBytes = -1;
   mWrittenBytes = -1;
   mZStream = new z_stream_s;
@@ -54,6 +87,11 @@ GZipCodec::GZipCodec(VirtualFile* stream): mStream(stream)
 GZipCodec::GZipCodec(const String& gz_path): mStream(NULL)
 {
   mCompressionLevel = 6;
+  mChunkSize = CHUNK_SIZE;
+  mThreadCount = 1;
+  mBlockSize = 256*1024;
+  mCRC32 = 0;
+  mMode = ZNone;
   mReadBytes = -1;
   mWrittenBytes = -1;
   mZStream = new z_stream_s;
@@ -88,6 +126,11 @@ bool GZipCodec::open(EOpenMode mode)
   mWrittenBytes = 0;
   mUncompressedBufferPtr = 0;
   mUncompressedBuffer.clear();
+  mZipBufferIn.resize(mChunkSize);
+  mZipBufferOut.resize(mChunkSize);
+  mPendingInput.clear();
+  mDictionary.clear();
+  mCRC32 = 0;
   /* z_stream_s */
   memset(mZStream, 0, sizeof(z_stream_s));
   mZStream->zalloc   = Z_NULL;
@@ -104,7 +147,7 @@ bool GZipCodec::open(EOpenMode mode)
     }
   }
   else
-  if (mMode == ZCompress)
+  if (mMode == ZCompress && threadCount() == 1)
   {
     if (deflateInit2(mZStream, compressionLevel(), Z_DEFLATED, 15+16/*gz compression*/, 8/*mem level*/, Z_DEFAULT_STRATEGY) != Z_OK)
     {
@@ -128,6 +171,16 @@ bool GZipCodec::open(EOpenMode mode)
     return false;
   }
   mStreamSize = stream()->size();
+  if (mMode == ZCompress && threadCount() > 1)
+  {
+    // gzip header: deflate, no flags, no time stamp, unknown OS
+    const unsigned char header[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255 };
+    if ( stream()->write(header, sizeof(header)) != sizeof(header) )
+    {
+      Log::error("GZipCodec::open(): write failed.\n");
+      return false;
+    }
+  }
   return true;
 }
 //-----------------------------------------------------------------------------
@@ -136,33 +189,27 @@ void GZipCodec::close()
   if ( mMode == ZDecompress )
     inflateEnd(mZStream);
   else
-  if ( mMode == ZCompress )
+  if ( mMode == ZCompress && threadCount() > 1 )
   {
-    // flush data
-    unsigned char next_out[CHUNK_SIZE];
-    unsigned char dummy_buffer=0;
-    mZStream->avail_in = 0;
-    mZStream->next_in  = (Bytef*)&dummy_buffer;
-    do
+    // compress the remaining blocks and write the gzip trailer
+    if ( compressBlocks(true) )
     {
-      mZStream->avail_out = CHUNK_SIZE;
-      mZStream->next_out  = next_out;
-      int ret = deflate(mZStream, Z_FINISH);
-      if (ret == Z_STREAM_ERROR)
-      {
-        Log::error("GZStream::write(): Z_STREAM_ERROR.\n");
-        deflateEnd(mZStream);
-        memset(mZStream, 0, sizeof(z_stream_s));
-        break;
-      }
-      unsigned have = CHUNK_SIZE - mZStream->avail_out;
-      if (have>0)
+      unsigned char trailer[8];
+      unsigned int isize = (unsigned int)mWrittenBytes;
+      for(int i=0; i<4; ++i)
       {
-        long long written = stream()->write(next_out, have);
-        if (written < have)
-          Log::error("GZStream: write failed.\n");
+        trailer[i]   = (unsigned char)(mCRC32 >> (8*i));
+        trailer[4+i] = (unsigned char)(isize >> (8*i));
       }
-    } while (mZStream->avail_out == 0);
+      if ( stream()->write(trailer, 8) != 8 )
+        Log::error("GZStream: write failed.\n");
+    }
+  }
+  else
+  if ( mMode == ZCompress )
+  {
+    // flush data
+    deflatePending(true);
     deflateEnd(mZStream);
   }
   if (stream())
@@ -173,6 +220,8 @@ void GZipCodec::close()
   mWrittenBytes = -1;
   mUncompressedBufferPtr = 0;
   mUncompressedBuffer.clear();
+  mPendingInput.clear();
+  mDictionary.clear();
 }
 //-----------------------------------------------------------------------------
 ref<VirtualFile> GZipCodec::clone() const
@@ -187,6 +236,9 @@ GZipCodec& GZipCodec::operator=(const GZipCodec& other)
   close();
   super::operator=(other);
   mCompressionLevel = other.mCompressionLevel;
+  mChunkSize = other.mChunkSize;
+  mThreadCount = other.mThreadCount;
+  mBlockSize = other.mBlockSize;
   if (other.mStream)
     mStream = other.mStream->clone();
   return *this;
@@ -232,29 +284,157 @@ long long GZipCodec::read_Implementation(void* buffer, long long bytes_to_read)
 //-----------------------------------------------------------------------------
 long long GZipCodec::write_Implementation(const void* buffer, long long byte_count)
 {
-  unsigned char next_out[CHUNK_SIZE];
-  mZStream->avail_in = (uInt)byte_count;
-  mZStream->next_in  = (Bytef*)buffer;
+  if (mMode != ZCompress)
+  {
+    Log::error("GZStream::write(): stream not open in OM_WriteOnly mode.\n");
+    return 0;
+  }
+
+  if (threadCount() > 1)
+  {
+    // accumulate the data until there is a block for each thread
+    mPendingInput.insert( mPendingInput.end(), (const unsigned char*)buffer, (const unsigned char*)buffer + byte_count );
+    if ( (long long)mPendingInput.size() >= (long long)blockSize() * threadCount() && !compressBlocks(false) )
+      return 0;
+  }
+  else
+  if ( byte_count >= chunkSize() )
+  {
+    // big writes are compressed directly
+    if ( !deflatePending(false) )
+      return 0;
+    mZStream->avail_in = (uInt)byte_count;
+    mZStream->next_in  = (Bytef*)buffer;
+    do
+    {
+      mZStream->avail_out = (uInt)mZipBufferOut.size();
+      mZStream->next_out  = &mZipBufferOut[0];
+      int ret = deflate(mZStream, Z_NO_FLUSH);
+      if (ret == Z_STREAM_ERROR)
+      {
+        Log::error("GZStream::write(): Z_STREAM_ERROR.\n");
+        return 0;
+      }
+      unsigned have = (unsigned)mZipBufferOut.size() - mZStream->avail_out;
+      if (have>0)
+      {
+        long long written = stream()->write(&mZipBufferOut[0], have);
+        if (written < have)
+          Log::error("GZStream: write failed.\n");
+      }
+    } while (mZStream->avail_out == 0);
+  }
+  else
+  {
+    // small writes are batched to avoid calling deflate() for every few bytes
+    mPendingInput.insert( mPendingInput.end(), (const unsigned char*)buffer, (const unsigned char*)buffer + byte_count );
+    if ( (long long)mPendingInput.size() >= chunkSize() && !deflatePending(false) )
+      return 0;
+  }
+  mWrittenBytes += byte_count;
+  return byte_count;
+}
+//-----------------------------------------------------------------------------
+bool GZipCodec::deflatePending(bool finish)
+{
+  unsigned char dummy_buffer=0;
+  mZStream->avail_in = (uInt)mPendingInput.size();
+  mZStream->next_in  = mPendingInput.empty() ? (Bytef*)&dummy_buffer : (Bytef*)&mPendingInput[0];
   do
   {
-    mZStream->avail_out = CHUNK_SIZE;
-    mZStream->next_out  = next_out;
-    int ret = deflate(mZStream, Z_NO_FLUSH);
+    mZStream->avail_out = (uInt)mZipBufferOut.size();
+    mZStream->next_out  = &mZipBufferOut[0];
+    int ret = deflate(mZStream, finish ? Z_FINISH : Z_NO_FLUSH);
     if (ret == Z_STREAM_ERROR)
     {
       Log::error("GZStream::write(): Z_STREAM_ERROR.\n");
-      return 0;
+      mPendingInput.clear();
+      return false;
     }
-    unsigned have = CHUNK_SIZE - mZStream->avail_out;
+    unsigned have = (unsigned)mZipBufferOut.size() - mZStream->avail_out;
     if (have>0)
     {
-      long long written = stream()->write(next_out, have);
+      long long written = stream()->write(&mZipBufferOut[0], have);
       if (written < have)
         Log::error("GZStream: write failed.\n");
     }
   } while (mZStream->avail_out == 0);
-  mWrittenBytes += byte_count;
-  return byte_count;
+  mPendingInput.clear();
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool GZipCodec::compressBlocks(bool finish)
+{
+  // the blocks to compress, when not finishing the last partial block is kept for the next call
+  const long long block_size = blockSize();
+  long long pending = (long long)mPendingInput.size();
+  int block_count = (int)(finish ? (pending + block_size - 1) / block_size : pending / block_size);
+  if (finish && block_count == 0)
+    block_count = 1;
+  long long consumed = finish ? pending : block_count * block_size;
+
+  std::vector< std::vector<unsigned char> > out(block_count);
+  std::vector<unsigned int> crc(block_count);
+  int failed = 0;
+  const unsigned char* data = mPendingInput.empty() ? NULL : &mPendingInput[0];
+
+  #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) reduction(+:failed) if(block_count > 1)
+  for(int i=0; i<block_count; ++i)
+  {
+    long long start = i * block_size;
+    long long size  = std::min(block_size, consumed - start);
+    // each block is primed with the 32KB preceding it
+    const unsigned char* dict = NULL;
+    long long dict_size = 0;
+    if (i == 0)
+    {
+      dict = mDictionary.empty() ? NULL : &mDictionary[0];
+      dict_size = (long long)mDictionary.size();
+    }
+    else
+    {
+      dict_size = std::min(start, (long long)DICTIONARY_SIZE);
+      dict = data + start - dict_size;
+    }
+    crc[i] = (unsigned int)::crc32( 0, data ? data + start : Z_NULL, (uInt)size );
+    if ( !deflateBlock( data ? data + start : NULL, (size_t)size, dict, (size_t)dict_size, mCompressionLevel, finish && i == block_count-1, out[i]) )
+      ++failed;
+  }
+
+  if (failed)
+  {
+    Log::error("GZStream::write(): block compression failed.\n");
+    mPendingInput.clear();
+    return false;
+  }
+
+  for(int i=0; i<block_count; ++i)
+  {
+    long long start = i * block_size;
+    long long size  = std::min(block_size, consumed - start);
+    mCRC32 = (unsigned int)::crc32_combine( mCRC32, crc[i], (z_off_t)size );
+    if ( !out[i].empty() && stream()->write(&out[i][0], out[i].size()) < (long long)out[i].size() )
+      Log::error("GZStream: write failed.\n");
+  }
+
+  // keep the dictionary for the next block
+  if (consumed)
+  {
+    long long dict_size = std::min(consumed, (long long)DICTIONARY_SIZE);
+    if (dict_size < DICTIONARY_SIZE)
+    {
+      // short data, prepend what is left of the previous dictionary
+      std::vector<unsigned char> dict(mDictionary);
+      dict.insert(dict.end(), data + consumed - dict_size, data + consumed);
+      if ( (long long)dict.size() > DICTIONARY_SIZE )
+        dict.erase( dict.begin(), dict.end() - DICTIONARY_SIZE );
+      mDictionary.swap(dict);
+    }
+    else
+      mDictionary.assign(data + consumed - dict_size, data + consumed);
+  }
+  mPendingInput.erase( mPendingInput.begin(), mPendingInput.begin() + (size_t)consumed );
+  return true;
 }
 //-----------------------------------------------------------------------------
 long long GZipCodec::position_Implementation() const
@@ -305,16 +485,17 @@ bool GZipCodec::fillUncompressedBuffer()
   int have = 0;
   int ret  = 0;
   /*long long compressed_read_bytes = stream()->position();*/
-  long long bytes_to_read = CHUNK_SIZE < (mStreamSize - stream()->position())?
-                            CHUNK_SIZE : (mStreamSize - stream()->position());
-  mZStream->avail_in = (uInt)stream()->read(mZipBufferIn, bytes_to_read);
+  long long chunk_size = (long long)mZipBufferIn.size();
+  long long bytes_to_read = chunk_size < (mStreamSize - stream()->position())?
+                            chunk_size : (mStreamSize - stream()->position());
+  mZStream->avail_in = (uInt)stream()->read(&mZipBufferIn[0], bytes_to_read);
   if (mZStream->avail_in == 0)
     return true;
-  mZStream->next_in = mZipBufferIn;
+  mZStream->next_in = &mZipBufferIn[0];
   do
   {
-    mZStream->avail_out = CHUNK_SIZE;
-    mZStream->next_out  = mZipBufferOut;
+    mZStream->avail_out = (uInt)mZipBufferOut.size();
+    mZStream->next_out  = &mZipBufferOut[0];
     ret = inflate(mZStream, Z_NO_FLUSH);
     switch (ret)
     {
@@ -326,14 +507,21 @@ bool GZipCodec::fillUncompressedBuffer()
         Log::error("GZStream: error reading gzip stream.\n");
         return false;
     }
-    have = CHUNK_SIZE - mZStream->avail_out;
+    have = (int)mZipBufferOut.size() - mZStream->avail_out;
+    if (have)
+    {
+      int start = (int)mUncompressedBuffer.size();
+      mUncompressedBuffer.resize(start + have);
+      memcpy(&mUncompressedBuffer[0] + start, &mZipBufferOut[0], have);
+    }
+    // concatenated gzip members
+    if (ret == Z_STREAM_END)
+      inflateReset(mZStream);
+    else
     if (!have)
       break;
-    int start = (int)mUncompressedBuffer.size();
-    mUncompressedBuffer.resize(start + have);
-    memcpy(&mUncompressedBuffer[0] + start, mZipBufferOut, have);
   }
-  while ( mZStream->avail_out == 0 );
+  while ( mZStream->avail_out == 0 || (ret == Z_STREAM_END && mZStream->avail_in != 0) );
   return true;
 }
 //-----------------------------------------------------------------------------
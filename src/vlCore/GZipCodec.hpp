@@ -39,12 +39,18 @@ namespace vl
 {
   /**
    * The GZipCodec class is a VirtualFile that transparently encodes and decodes a stream of data using the GZip compression algorithm.
+   *
+   * When threadCount() is greater than 1 the data written is split in blocks of blockSize() bytes which are compressed
+   * independently (in parallel if OpenMP is enabled) and concatenated into a single standard GZip stream, the way pigz does.
+   * Each block is primed with the last 32KB of the previous one so that the compression ratio is almost unaffected.
+   * Concatenated GZip streams (multiple members) are also supported when reading, note however that uncompressedSize()
+   * only reports the size of the last member.
    */
   class VLCORE_EXPORT GZipCodec: public VirtualFile
   {
     VL_INSTRUMENT_CLASS(vl::GZipCodec, VirtualFile)
 
-    // Lower this if you need to limit the amount of data allocated to the stack, for example to 16K.
+    //! The default chunkSize().
     static const int CHUNK_SIZE = 128*1024;
 
   public:
@@ -85,6 +91,26 @@ namespace vl
 
     int compressionLevel() const { return mCompressionLevel; }
 
+    //! The size of the buffers used to read and write the compressed stream and to batch small writes, defaults to CHUNK_SIZE.
+    //! Takes effect at the next open().
+    void setChunkSize(int bytes) { mChunkSize = bytes < 1024 ? 1024 : bytes; }
+
+    //! The size of the buffers used to read and write the compressed stream and to batch small writes, defaults to CHUNK_SIZE.
+    int chunkSize() const { return mChunkSize; }
+
+    //! The number of threads used to compress the data during write operations, defaults to 1.
+    //! Values greater than 1 enable the block compression mode described above. Takes effect at the next open().
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    //! The number of threads used to compress the data during write operations, defaults to 1.
+    int threadCount() const { return mThreadCount; }
+
+    //! The size of the blocks compressed independently when threadCount() is greater than 1, defaults to 256KB.
+    void setBlockSize(int bytes) { mBlockSize = bytes < 64*1024 ? 64*1024 : bytes; }
+
+    //! The size of the blocks compressed independently when threadCount() is greater than 1, defaults to 256KB.
+    int blockSize() const { return mBlockSize; }
+
     //! Installs the VirtualFile representing the GZip file to be read or to be written.
     void setStream(VirtualFile* stream);
 
@@ -117,17 +143,25 @@ namespace vl
     void resetStream();
     bool seekSet_Implementation(long long pos);
     bool fillUncompressedBuffer();
+    bool deflatePending(bool finish);
+    bool compressBlocks(bool finish);
 
   protected:
     int mCompressionLevel;
+    int mChunkSize;
+    int mThreadCount;
+    int mBlockSize;
     ref<VirtualFile> mStream;
     long long mReadBytes;
     long long mWrittenBytes;
     bool mWarnOnSeek;
 
     z_stream_s* mZStream;
-    unsigned char mZipBufferIn[CHUNK_SIZE];
-    unsigned char mZipBufferOut[CHUNK_SIZE];
+    std::vector<unsigned char> mZipBufferIn;
+    std::vector<unsigned char> mZipBufferOut;
+    std::vector<unsigned char> mPendingInput;
+    std::vector<unsigned char> mDictionary;
+    unsigned int mCRC32;
     std::vector<char> mUncompressedBuffer;
     int mUncompressedBufferPtr;
     long long mStreamSize;
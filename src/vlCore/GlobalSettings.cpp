@@ -47,6 +47,7 @@ GlobalSettings::GlobalSettings()
     mVerbosityLevel  = vl::VEL_VERBOSITY_ERROR;
     mCheckOpenGLStates = false;
   #endif
+  mOpenGLErrorCheck = vl::GEC_GET_ERROR;
 
   // initialize from environment variables
 
@@ -107,5 +108,25 @@ GlobalSettings::GlobalSettings()
       fprintf(stderr,"VL_CHECK_GL_STATES variable has unknown value '%s'! Legal values: YES, NO.\n\n", val);
     }
   }
+
+  // opengl error checks
+
+  val = getenv("VL_GL_ERROR_CHECK");
+  if (val)
+  {
+    if ( String(val).toUpperCase() == "GET_ERROR" )
+      setOpenGLErrorCheck(vl::GEC_GET_ERROR);
+    else
+    if ( String(val).toUpperCase() == "DEBUG_OUTPUT" )
+      setOpenGLErrorCheck(vl::GEC_DEBUG_OUTPUT);
+    else
+    if ( String(val).toUpperCase() == "DEBUG_OUTPUT_TRAP" )
+      setOpenGLErrorCheck(vl::GEC_DEBUG_OUTPUT_TRAP);
+    else
+    {
+      // no log here yet.
+      fprintf(stderr,"VL_GL_ERROR_CHECK variable has unknown value '%s'! Legal values: GET_ERROR, DEBUG_OUTPUT, DEBUG_OUTPUT_TRAP.\n\n", val);
+    }
+  }
 }
 //-----------------------------------------------------------------------------
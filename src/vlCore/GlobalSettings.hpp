@@ -61,6 +61,15 @@ namespace vl
       * \note This can slow down the rendering. Enabled by default in DEBUG mode only. */
     bool checkOpenGLStates() const { return mCheckOpenGLStates; }
 
+    /** How VL_CHECK_OGL() detects the OpenGL errors in debug and VL_FORCE_CHECKS builds, applied when an OpenGLContext is initialized.
+      * With GEC_DEBUG_OUTPUT[_TRAP] the errors are reported by the OpenGL debug output without calling glGetError() after every
+      * OpenGL call, which makes checked builds run close to release speed. Falls back to GEC_GET_ERROR if neither
+      * GL_KHR_debug nor GL_ARB_debug_output are available. Defaults to GEC_GET_ERROR, see also vl::enableGLDebugOutput(). */
+    void setOpenGLErrorCheck(EOpenGLErrorCheck check) { mOpenGLErrorCheck = check; }
+
+    /** How VL_CHECK_OGL() detects the OpenGL errors, see setOpenGLErrorCheck(). */
+    EOpenGLErrorCheck openGLErrorCheck() const { return mOpenGLErrorCheck; }
+
     /** The verbosity level of VL. This applies to all the logs generated via vl::Log::*. */
     void setVerbosityLevel(EVerbosityLevel verb_level) { mVerbosityLevel = verb_level; }
 
@@ -76,6 +85,7 @@ namespace vl
   protected:
     EVerbosityLevel mVerbosityLevel;
     bool mCheckOpenGLStates;
+    EOpenGLErrorCheck mOpenGLErrorCheck;
     String mDefaultLogPath;
     String mDefaultDataPath;
   };
@@ -36,12 +36,15 @@
 #include <vlCore/VisualizationLibrary.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/VirtualFile.hpp>
+#include <vlCore/MappedFile.hpp>
 #include <vlCore/glsl_math.hpp>
 #include <vlCore/ResourceDatabase.hpp>
 #include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/SIMD.hpp>
 
 #include <map>
 #include <cmath>
+#include <algorithm>
 
 using namespace vl;
 
@@ -57,6 +60,7 @@ Image::Image()
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mPixels = new Buffer;
+  mPixels->setMemoryCategory(MC_Image);
   reset();
 }
 //-----------------------------------------------------------------------------
@@ -64,6 +68,7 @@ Image::Image( void* buffer_ptr, int buffer_bytes )
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mPixels = new Buffer;
+  mPixels->setMemoryCategory(MC_Image);
   reset();
   mPixels->setUserAllocatedBuffer( buffer_ptr, buffer_bytes );
 }
@@ -72,6 +77,7 @@ Image::Image( const Image& other ): Object( other )
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mPixels = new Buffer;
+  mPixels->setMemoryCategory(MC_Image);
   reset();
   *this = other;
 }
@@ -80,6 +86,7 @@ Image::Image( const String& path )
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mPixels = new Buffer;
+  mPixels->setMemoryCategory(MC_Image);
   reset();
 
   setObjectName(path.toStdString().c_str());
@@ -111,6 +118,7 @@ Image::Image( int x, int y, int z, int bytealign, EImageFormat format, EImageTyp
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mPixels = new Buffer;
+  mPixels->setMemoryCategory(MC_Image);
   setByteAlignment(bytealign);
 
   if (x && y && z)
@@ -159,21 +167,7 @@ bool Image::isValid() const
     case IT_INT:
     case IT_FLOAT:
     {
-      switch(format())
-      {
-        case IF_COMPRESSED_RGB_S3TC_DXT1:
-        case IF_COMPRESSED_RGBA_S3TC_DXT1:
-        case IF_COMPRESSED_RGBA_S3TC_DXT3:
-        case IF_COMPRESSED_RGBA_S3TC_DXT5:
-        {
-          break;
-        }
-
-        default:
-        {
-          okformat = true;
-        }
-      }
+      okformat = !isCompressedFormat(format());
     }
   }
 
@@ -186,22 +180,7 @@ bool Image::isValid() const
 
     case IT_IMPLICIT_TYPE:
     {
-      switch(format())
-      {
-        case IF_COMPRESSED_RGB_S3TC_DXT1:
-        case IF_COMPRESSED_RGBA_S3TC_DXT1:
-        case IF_COMPRESSED_RGBA_S3TC_DXT3:
-        case IF_COMPRESSED_RGBA_S3TC_DXT5:
-        {
-          okformat = true;
-          break;
-        }
-
-        default:
-        {
-          break;
-        }
-      }
+      okformat = isCompressedFormat(format()) != 0;
     }
   }
 
@@ -341,6 +320,26 @@ String Image::printFormat() const
   fo[IF_COMPRESSED_RGBA_S3TC_DXT1] = "IF_COMPRESSED_RGBA_S3TC_DXT1";
   fo[IF_COMPRESSED_RGBA_S3TC_DXT3] = "IF_COMPRESSED_RGBA_S3TC_DXT3";
   fo[IF_COMPRESSED_RGBA_S3TC_DXT5] = "IF_COMPRESSED_RGBA_S3TC_DXT5";
+  fo[IF_COMPRESSED_RED_RGTC1] = "IF_COMPRESSED_RED_RGTC1";
+  fo[IF_COMPRESSED_SIGNED_RED_RGTC1] = "IF_COMPRESSED_SIGNED_RED_RGTC1";
+  fo[IF_COMPRESSED_RG_RGTC2] = "IF_COMPRESSED_RG_RGTC2";
+  fo[IF_COMPRESSED_SIGNED_RG_RGTC2] = "IF_COMPRESSED_SIGNED_RG_RGTC2";
+  fo[IF_COMPRESSED_RGBA_BPTC_UNORM] = "IF_COMPRESSED_RGBA_BPTC_UNORM";
+  fo[IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM] = "IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM";
+  fo[IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT] = "IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT";
+  fo[IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT] = "IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT";
+  fo[IF_COMPRESSED_RGB8_ETC2] = "IF_COMPRESSED_RGB8_ETC2";
+  fo[IF_COMPRESSED_SRGB8_ETC2] = "IF_COMPRESSED_SRGB8_ETC2";
+  fo[IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2] = "IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2";
+  fo[IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2] = "IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2";
+  fo[IF_COMPRESSED_RGBA8_ETC2_EAC] = "IF_COMPRESSED_RGBA8_ETC2_EAC";
+  fo[IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC] = "IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC";
+  fo[IF_COMPRESSED_R11_EAC] = "IF_COMPRESSED_R11_EAC";
+  fo[IF_COMPRESSED_SIGNED_R11_EAC] = "IF_COMPRESSED_SIGNED_R11_EAC";
+  fo[IF_COMPRESSED_RG11_EAC] = "IF_COMPRESSED_RG11_EAC";
+  fo[IF_COMPRESSED_SIGNED_RG11_EAC] = "IF_COMPRESSED_SIGNED_RG11_EAC";
+  fo[IF_COMPRESSED_RGBA_ASTC_4x4] = "IF_COMPRESSED_RGBA_ASTC_4x4";
+  fo[IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4] = "IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4";
 
   VL_CHECK( fo[format()] != NULL );
 
@@ -437,6 +436,30 @@ int Image::bitsPerPixel(EImageType type, EImageFormat format)
     case IF_COMPRESSED_RGBA_S3TC_DXT1: return 4; // 8 bytes (64 bits) per block per 16 pixels
     case IF_COMPRESSED_RGBA_S3TC_DXT3: return 8; // 16 bytes (128 bits) per block per 16 pixels
     case IF_COMPRESSED_RGBA_S3TC_DXT5: return 8; // 16 bytes (128 bits) per block per 16 pixels
+
+    case IF_COMPRESSED_RED_RGTC1:
+    case IF_COMPRESSED_SIGNED_RED_RGTC1:
+    case IF_COMPRESSED_RGB8_ETC2:
+    case IF_COMPRESSED_SRGB8_ETC2:
+    case IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case IF_COMPRESSED_R11_EAC:
+    case IF_COMPRESSED_SIGNED_R11_EAC:
+      return 4; // 8 bytes (64 bits) per block per 16 pixels
+
+    case IF_COMPRESSED_RG_RGTC2:
+    case IF_COMPRESSED_SIGNED_RG_RGTC2:
+    case IF_COMPRESSED_RGBA_BPTC_UNORM:
+    case IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case IF_COMPRESSED_RGBA8_ETC2_EAC:
+    case IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case IF_COMPRESSED_RG11_EAC:
+    case IF_COMPRESSED_SIGNED_RG11_EAC:
+    case IF_COMPRESSED_RGBA_ASTC_4x4:
+    case IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4:
+      return 8; // 16 bytes (128 bits) per block per 16 pixels
     default:
       break;
   }
@@ -472,6 +495,32 @@ int Image::alphaBits() const
     case IF_COMPRESSED_RGBA_S3TC_DXT1: return 1; // 8 bytes (64 bits) per block per 16 pixels
     case IF_COMPRESSED_RGBA_S3TC_DXT3: return 4; // 16 bytes (64 bits for uncompressed alpha + 64 bits for RGB) per block per 16 pixels
     case IF_COMPRESSED_RGBA_S3TC_DXT5: return 4; // 16 bytes (64 bits for   compressed alpha + 64 bits for RGB) per block per 16 pixels
+
+    case IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+      return 1;
+
+    case IF_COMPRESSED_RGBA_BPTC_UNORM:
+    case IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+    case IF_COMPRESSED_RGBA8_ETC2_EAC:
+    case IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+    case IF_COMPRESSED_RGBA_ASTC_4x4:
+    case IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4:
+      return 8;
+
+    case IF_COMPRESSED_RED_RGTC1:
+    case IF_COMPRESSED_SIGNED_RED_RGTC1:
+    case IF_COMPRESSED_RG_RGTC2:
+    case IF_COMPRESSED_SIGNED_RG_RGTC2:
+    case IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+    case IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+    case IF_COMPRESSED_RGB8_ETC2:
+    case IF_COMPRESSED_SRGB8_ETC2:
+    case IF_COMPRESSED_R11_EAC:
+    case IF_COMPRESSED_SIGNED_R11_EAC:
+    case IF_COMPRESSED_RG11_EAC:
+    case IF_COMPRESSED_SIGNED_RG11_EAC:
+      return 0;
     default:
       break;
   }
@@ -520,6 +569,26 @@ int Image::isCompressedFormat(EImageFormat fmt)
   case IF_COMPRESSED_RGBA_S3TC_DXT1:
   case IF_COMPRESSED_RGBA_S3TC_DXT3:
   case IF_COMPRESSED_RGBA_S3TC_DXT5:
+  case IF_COMPRESSED_RED_RGTC1:
+  case IF_COMPRESSED_SIGNED_RED_RGTC1:
+  case IF_COMPRESSED_RG_RGTC2:
+  case IF_COMPRESSED_SIGNED_RG_RGTC2:
+  case IF_COMPRESSED_RGBA_BPTC_UNORM:
+  case IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+  case IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+  case IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+  case IF_COMPRESSED_RGB8_ETC2:
+  case IF_COMPRESSED_SRGB8_ETC2:
+  case IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+  case IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+  case IF_COMPRESSED_RGBA8_ETC2_EAC:
+  case IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+  case IF_COMPRESSED_R11_EAC:
+  case IF_COMPRESSED_SIGNED_R11_EAC:
+  case IF_COMPRESSED_RG11_EAC:
+  case IF_COMPRESSED_SIGNED_RG11_EAC:
+  case IF_COMPRESSED_RGBA_ASTC_4x4:
+  case IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4:
     return true;
 
   default:
@@ -599,7 +668,7 @@ void Image::allocate1D(int x, EImageFormat format, EImageType type)
   if ( ! requiredMemory() ) {
     Log::bug("Image::allocate1D() failed, probably your image settings are invalid.\n");
   } else {
-    if ( mPixels->allocationMode() == vl::Buffer::AutoAllocatedBuffer ) {
+    if ( mPixels->allocationMode() != vl::Buffer::UserAllocatedBuffer ) {
       mPixels->resize( requiredMemory() );
     }
   }
@@ -622,7 +691,7 @@ void Image::allocate2D(int x, int y, int bytealign, EImageFormat format, EImageT
   if ( ! requiredMemory() ) {
     Log::bug("Image::allocate2D() failed, probably your image settings are invalid.\n");
   } else {
-    if ( mPixels->allocationMode() == vl::Buffer::AutoAllocatedBuffer ) {
+    if ( mPixels->allocationMode() != vl::Buffer::UserAllocatedBuffer ) {
       mPixels->resize( requiredMemory() );
     }
   }
@@ -646,7 +715,7 @@ void Image::allocate3D(int x, int y, int z, int bytealign, EImageFormat format,
   if ( ! requiredMemory() ) {
     Log::bug("Image::allocate3D() failed, probably your image settings are invalid.\n");
   } else {
-    if ( mPixels->allocationMode() == vl::Buffer::AutoAllocatedBuffer ) {
+    if ( mPixels->allocationMode() != vl::Buffer::UserAllocatedBuffer ) {
       mPixels->resize( requiredMemory() );
     }
   }
@@ -667,7 +736,7 @@ void Image::allocateCubemap(int x, int y, int bytealign, EImageFormat format, EI
   if ( ! requiredMemory() ) {
     Log::bug("Image::allocateCubemap() failed, probably your image settings are invalid.\n");
   } else {
-    if ( mPixels->allocationMode() == vl::Buffer::AutoAllocatedBuffer ) {
+    if ( mPixels->allocationMode() != vl::Buffer::UserAllocatedBuffer ) {
       mPixels->resize( requiredMemory() );
     }
   }
@@ -688,7 +757,7 @@ void Image::reset(int x, int y, int z, int bytealign, EImageFormat format, EImag
 //-----------------------------------------------------------------------------
 void Image::reset()
 {
-  if ( mPixels->allocationMode() == vl::Buffer::AutoAllocatedBuffer ) {
+  if ( mPixels->allocationMode() != vl::Buffer::UserAllocatedBuffer ) {
     mPixels->clear();
   }
   mMipmaps.clear();
@@ -946,8 +1015,6 @@ void Image::flipVertically()
 
   VL_CHECK(pixels());
   int row_size = pitch();
-  std::vector<unsigned char> row1;
-  row1.resize(row_size);
 
   std::vector<unsigned char*> pxl;
 
@@ -972,15 +1039,18 @@ void Image::flipVertically()
       pxl.push_back( (unsigned char*)pixelsZSlice(zslice) );
   }
 
-  for(unsigned img=0; img<pxl.size(); img++)
+  // every row pair of every slice is swapped independently
+  const int half  = height()/2;
+  const int count = (int)pxl.size() * half;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(count * row_size > 65536)
+#endif
+  for(int k=0; k<count; ++k)
   {
-    for(int i=0; i<height()/2; ++i)
-    {
-      int j = height() - 1 - i;
-      memcpy(&row1[0], pxl[img]+i*row_size, row_size);
-      memcpy(pxl[img]+i*row_size, pxl[img]+j*row_size, row_size);
-      memcpy(pxl[img]+j*row_size,  &row1[0], row_size);
-    }
+    unsigned char* img = pxl[k / half];
+    int i = k % half;
+    int j = height() - 1 - i;
+    std::swap_ranges(img+i*row_size, img+(i+1)*row_size, img+j*row_size);
   }
 }
 //-----------------------------------------------------------------------------
@@ -1002,18 +1072,13 @@ int Image::requiredMemory(int width, int height, int depth, int bytealign, EImag
 
   // fix width and height to match compression scheme
 
-  switch(format)
+  // all the supported compressed formats use 4x4 blocks
+  if (isCompressedFormat(format))
   {
-    case IF_COMPRESSED_RGB_S3TC_DXT1:
-    case IF_COMPRESSED_RGBA_S3TC_DXT1:
-    case IF_COMPRESSED_RGBA_S3TC_DXT3:
-    case IF_COMPRESSED_RGBA_S3TC_DXT5:
-      if (width % 4)
-        width = width - width % 4 + 4;
-      if (height % 4)
-        height = height - height % 4 + 4;
-    default:
-      break;
+    if (width % 4)
+      width = width - width % 4 + 4;
+    if (height % 4)
+      height = height - height % 4 + 4;
   }
 
   // pitch
@@ -1028,21 +1093,13 @@ int Image::requiredMemory(int width, int height, int depth, int bytealign, EImag
   depth  = depth  ? depth  : 1;
   int req_mem = pitch * height * depth;
 
-  // minimum memory taken by a compressed block
-  if (req_mem < 8 && format == IF_COMPRESSED_RGB_S3TC_DXT1)
-    req_mem = 8;
-
-  if (req_mem < 8 && format == IF_COMPRESSED_RGBA_S3TC_DXT1)
-    req_mem = 8;
-
-  if (req_mem < 16 && format == IF_COMPRESSED_RGBA_S3TC_DXT3)
-    req_mem = 16;
-
-  if (req_mem < 16 && format == IF_COMPRESSED_RGBA_S3TC_DXT5)
-    req_mem = 16;
-
-  // todo: add other compression schemes
-  // ...
+  // minimum memory taken by a compressed block: 8 or 16 bytes
+  if (isCompressedFormat(format))
+  {
+    int block_size = bitsPerPixel(type, format) * 2;
+    if (req_mem < block_size)
+      req_mem = block_size;
+  }
 
   // cubemap
   if (is_cubemap)
@@ -1199,6 +1256,38 @@ bool vl::loadImagesFromDir(const String& dir_path, const String& ext, std::vecto
   return true;
 }
 //-----------------------------------------------------------------------------
+bool vl::loadImagesParallel(const std::vector<String>& paths, std::vector< ref<Image> >& images, int thread_count)
+{
+  images.clear();
+  images.resize( paths.size() );
+
+  // locate the files and perform the lazy registrations on the calling thread: the workers only read shared state
+  std::vector< ref<VirtualFile> > files( paths.size() );
+  for(size_t i=0; i<paths.size(); ++i)
+  {
+    files[i] = defFileSystem()->locateFile(paths[i]);
+    if ( !files[i] )
+      Log::error( Say("File '%s' not found.\n") << paths[i] );
+  }
+  defLoadWriterManager()->performLazyRegistrations();
+
+  const int count = (int)files.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(thread_count) if(thread_count > 1 && count > 1)
+#endif
+  for(int i=0; i<count; ++i)
+  {
+    if ( files[i] )
+      images[i] = loadImage( files[i].get() );
+  }
+  (void)thread_count;
+
+  for(size_t i=0; i<images.size(); ++i)
+    if ( !images[i] )
+      return false;
+  return true;
+}
+//-----------------------------------------------------------------------------
 ref<Image> vl::loadImage( const String& path )
 {
   ref<VirtualFile> file = defFileSystem()->locateFile(path);
@@ -1277,8 +1366,129 @@ ref<Image> vl::loadCubemap(const String& xp_file, const String& xn_file, const S
   return img;
 }
 //-----------------------------------------------------------------------------
-ref<Image> vl::loadRAW(VirtualFile* file, long long file_offset, int width, int height, int depth, int bytealign, EImageFormat format, EImageType type)
+namespace
+{
+  //! The size in bytes of the components whose byte order can be swapped, 0 for byte and packed types.
+  int swappableComponentSize(EImageType type)
+  {
+    switch(type)
+    {
+    case IT_UNSIGNED_SHORT:
+    case IT_SHORT:
+      return 2;
+    case IT_UNSIGNED_INT:
+    case IT_INT:
+    case IT_FLOAT:
+      return 4;
+    default:
+      return 0;
+    }
+  }
+
+  inline unsigned short swap16(unsigned short v) { return (unsigned short)((v >> 8) | (v << 8)); }
+
+  inline unsigned int swap32(unsigned int v) { return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24); }
+
+  //! Swaps the byte order of \p count elements, \p data is not required to be aligned.
+  void swapByteOrderChunk(unsigned char* data, long long count, int element_size)
+  {
+    long long i = 0;
+#if defined(VL_SIMD_SSE2)
+    // 16 bytes per iteration: swap the bytes of each 16 bits word, after swapping the words for the larger elements
+    const long long vec_count = count * element_size / 16;
+    for(long long v=0; v<vec_count; ++v)
+    {
+      __m128i* p = (__m128i*)(data + v*16);
+      __m128i x = _mm_loadu_si128(p);
+      if (element_size == 4)
+        x = _mm_shufflehi_epi16( _mm_shufflelo_epi16(x, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1) );
+      else
+      if (element_size == 8)
+        x = _mm_shufflehi_epi16( _mm_shufflelo_epi16(x, _MM_SHUFFLE(0,1,2,3)), _MM_SHUFFLE(0,1,2,3) );
+      x = _mm_or_si128( _mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8) );
+      _mm_storeu_si128(p, x);
+    }
+    i = vec_count * 16 / element_size;
+#endif
+    unsigned char* p = data + i*element_size;
+    for( ; i<count; ++i, p+=element_size)
+    {
+      if (element_size == 2)
+      {
+        unsigned short v;
+        memcpy(&v, p, 2);
+        v = swap16(v);
+        memcpy(p, &v, 2);
+      }
+      else
+      if (element_size == 4)
+      {
+        unsigned int v;
+        memcpy(&v, p, 4);
+        v = swap32(v);
+        memcpy(p, &v, 4);
+      }
+      else
+      {
+        unsigned int v[2];
+        memcpy(v, p, 8);
+        unsigned int lo = swap32(v[1]);
+        v[1] = swap32(v[0]);
+        v[0] = lo;
+        memcpy(p, v, 8);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void vl::swapByteOrder(void* data, long long element_count, int element_size)
 {
+  if (element_size != 2 && element_size != 4 && element_size != 8)
+  {
+    Log::bug( Say("swapByteOrder(): unsupported element size %n.\n") << element_size );
+    return;
+  }
+
+  // 1MB chunks keep the working set of each thread in cache
+  const long long chunk_elements = (1 << 20) / element_size;
+  const int chunk_count = (int)( (element_count + chunk_elements - 1) / chunk_elements );
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(chunk_count > 1)
+#endif
+  for(int c=0; c<chunk_count; ++c)
+  {
+    long long start = chunk_elements * c;
+    long long count = element_count - start < chunk_elements ? element_count - start : chunk_elements;
+    swapByteOrderChunk( (unsigned char*)data + start*element_size, count, element_size );
+  }
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadRAW(VirtualFile* file, long long file_offset, int width, int height, int depth, int bytealign, EImageFormat format, EImageType type, bool swap_byte_order)
+{
+  const int swap_size = swap_byte_order ? swappableComponentSize(type) : 0;
+  if (swap_byte_order && !swap_size && type != IT_UNSIGNED_BYTE && type != IT_BYTE)
+    Log::warning( Say("loadRAW('%s'): byte order swapping is not supported for packed image types.\n") << file->path() );
+
+  // zero-copy path: the image uses the mapped pages as storage
+  MappedFile* mapped = file->as<MappedFile>();
+  if ( mapped && ( mapped->isOpen() || mapped->open(OM_ReadOnly) ) )
+  {
+    long long offset = file_offset == -1 ? mapped->position() : file_offset;
+    ref<Image> img = new Image;
+    img->reset(width, height, depth, bytealign, format, type, false);
+    unsigned char* ptr = mapped->mappedPtr( offset, img->requiredMemory() );
+    if ( ptr )
+    {
+      img->imageBuffer()->setUserAllocatedBuffer( ptr, img->requiredMemory(), mapped->mapping() );
+      mapped->seekSet( offset + img->requiredMemory() );
+      // the mapped pages are private: swapping in place does not touch the file and avoids a second copy
+      if (swap_size)
+        swapByteOrder( img->pixels(), img->requiredMemory() / swap_size, swap_size );
+      return img;
+    }
+    // fall back to the copying path which reports the error
+  }
+
   ref<Image> img = new Image(width, height, depth, bytealign, format, type);
   if ( file->isOpen() || file->open(OM_ReadOnly) )
   {
@@ -1291,6 +1501,8 @@ ref<Image> vl::loadRAW(VirtualFile* file, long long file_offset, int width, int
     int count = (int)file->read( img->pixels(), img->requiredMemory() );
     if (count != img->requiredMemory())
       Log::error( Say("loadRAW('%s'): error reading RAW file.\n") << file->path() );
+    if (swap_size)
+      swapByteOrder( img->pixels(), img->requiredMemory() / swap_size, swap_size );
     return img;
   }
   else
@@ -1300,6 +1512,70 @@ ref<Image> vl::loadRAW(VirtualFile* file, long long file_offset, int width, int
   }
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  //! Normalizes \p dval to 0..1 and quantizes it for the destination type.
+  template<typename D>
+  inline D convertTypeValue(double dval, double dst_max)
+  {
+    dval = dval < 0.0 ? 0.0 :
+           dval > 1.0 ? 1.0 :
+           dval;
+    return (D)(dval*dst_max);
+  }
+
+  //! Converts \p count components per line, the switch on the types is resolved once by the caller.
+  //! Use 1.0 as \p src_max and \p dst_max for floating point types.
+  template<typename S, typename D>
+  void convertTypeLines(const unsigned char* src, int src_pitch, unsigned char* dst, int dst_pitch, int line_count, int count, double src_max, double dst_max)
+  {
+    // 8 bits sources are translated via a lookup table
+    D lut[256];
+    const bool use_lut = sizeof(S) == 1;
+    if (use_lut)
+    {
+      for(int k=0; k<256; ++k)
+        lut[k] = convertTypeValue<D>((S)(unsigned char)k / src_max, dst_max);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(line_count * count > 16384)
+#endif
+    for(int i=0; i<line_count; ++i)
+    {
+      const S* s = (const S*)(src + (size_t)src_pitch*i);
+      D* d = (D*)(dst + (size_t)dst_pitch*i);
+      if (use_lut)
+      {
+        for(int e=0; e<count; ++e)
+          d[e] = lut[(unsigned char)s[e]];
+      }
+      else
+      {
+        for(int e=0; e<count; ++e)
+          d[e] = convertTypeValue<D>(s[e] / src_max, dst_max);
+      }
+    }
+  }
+
+  template<typename S>
+  void convertTypeDispatch(const unsigned char* src, int src_pitch, unsigned char* dst, int dst_pitch, EImageType dst_type, int line_count, int count, double src_max)
+  {
+    switch(dst_type)
+    {
+      case IT_UNSIGNED_BYTE:  convertTypeLines<S, unsigned char>(src, src_pitch, dst, dst_pitch, line_count, count, src_max, 255.0);        break;
+      case IT_BYTE:           convertTypeLines<S, GLbyte>       (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 127.0);        break;
+      case IT_UNSIGNED_SHORT: convertTypeLines<S, GLushort>     (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 65535.0);      break;
+      case IT_SHORT:          convertTypeLines<S, GLshort>      (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 32767.0);      break;
+      case IT_UNSIGNED_INT:   convertTypeLines<S, unsigned int> (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 4294967295.0); break;
+      case IT_INT:            convertTypeLines<S, int>          (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 2147483647.0); break;
+      case IT_FLOAT:          convertTypeLines<S, float>        (src, src_pitch, dst, dst_pitch, line_count, count, src_max, 1.0);          break;
+      default:
+        break;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 ref<Image> vl::Image::convertType(EImageType new_type) const
 {
   switch(type())
@@ -1389,96 +1665,277 @@ ref<Image> vl::Image::convertType(EImageType new_type) const
   if (img->isCubemap())
     line_count *= 6;
 
-  for(int i=0; i<line_count; ++i)
+  const unsigned char* src = pixels();
+  unsigned char* dst = img->pixels();
+  const int count = img->width() * components;
+
+  switch(type())
   {
-    const void* srcLine = pixels()      + pitch()*i;
-    void* dstLine = img->pixels() + img->pitch()*i;
+    case IT_UNSIGNED_BYTE:  convertTypeDispatch<unsigned char>(src, pitch(), dst, img->pitch(), new_type, line_count, count, 255.0);        break;
+    case IT_BYTE:           convertTypeDispatch<GLbyte>       (src, pitch(), dst, img->pitch(), new_type, line_count, count, 127.0);        break;
+    case IT_UNSIGNED_SHORT: convertTypeDispatch<GLushort>     (src, pitch(), dst, img->pitch(), new_type, line_count, count, 65535.0);      break;
+    case IT_SHORT:          convertTypeDispatch<GLshort>      (src, pitch(), dst, img->pitch(), new_type, line_count, count, 32767.0);      break;
+    case IT_UNSIGNED_INT:   convertTypeDispatch<unsigned int> (src, pitch(), dst, img->pitch(), new_type, line_count, count, 4294967295.0); break;
+    case IT_INT:            convertTypeDispatch<int>          (src, pitch(), dst, img->pitch(), new_type, line_count, count, 2147483647.0); break;
+    case IT_FLOAT:          convertTypeDispatch<float>        (src, pitch(), dst, img->pitch(), new_type, line_count, count, 1.0);          break;
+    default:
+      return NULL;
+  }
 
-    const unsigned char* srcUByte  = (const unsigned char*)srcLine;
-    const GLbyte*        srcSByte  = (const GLbyte*)srcLine;
-    const GLushort*      srcUShort = (const GLushort*)srcLine;
-    const GLshort*       srcSShort = (const GLshort*)srcLine;
-    const unsigned int*  srcUInt   = (const unsigned int*)srcLine;
-    const int*           srcSInt   = (const int*)srcLine;
-    const float*         srcFloat  = (const float*)srcLine;
+  return img;
+}
+//-----------------------------------------------------------------------------
+namespace
+{
+  // I0, zero order modified Bessel function of the first kind
+  double besselI0(double x)
+  {
+    double sum = 1, term = 1;
+    for(int k=1; k<32; ++k)
+    {
+      term *= (x*0.5/k) * (x*0.5/k);
+      sum += term;
+    }
+    return sum;
+  }
 
-    unsigned char* dstUByte  = (unsigned char*)dstLine;
-    GLbyte*        dstSByte  = (GLbyte*)dstLine;
-    GLushort*      dstUShort = (GLushort*)dstLine;
-    GLshort*       dstSShort = (GLshort*)dstLine;
-    unsigned int*  dstUInt   = (unsigned int*)dstLine;
-    int*           dstSInt   = (int*)dstLine;
-    float*         dstFloat  = (float*)dstLine;
+  //! Returns the number of taps and fills \p taps with the normalized weights used to halve an axis.
+  //! The taps are centered between the source texels 2*i and 2*i+1.
+  int mipmapTaps(EMipmapFilter filter, float taps[6])
+  {
+    if (filter == MF_Box)
+    {
+      taps[0] = taps[1] = 0.5f;
+      return 2;
+    }
 
-    for(int j=0; j<img->width(); ++j)
+    // Kaiser-windowed sinc (alpha = 4), the taps are 0.25, 0.75 and 1.25 destination texels away from the center
+    const double alpha = 4.0;
+    const double support = 1.5;
+    double sum = 0;
+    for(int k=0; k<6; ++k)
+    {
+      double t = fabs(k - 2.5) * 0.5;
+      double sinc = sin(dPi*t) / (dPi*t);
+      double r = t / support;
+      double window = besselI0(alpha*sqrt(1.0 - r*r)) / besselI0(alpha);
+      taps[k] = (float)(sinc * window);
+      sum += taps[k];
+    }
+    for(int k=0; k<6; ++k)
+      taps[k] = (float)(taps[k] / sum);
+    return 6;
+  }
+
+  //! Halves one axis (0 = x, 1 = y, 2 = z) of a w*h*d volume of \p comps floats per texel.
+  void halveAxis(const float* src, float* dst, int w, int h, int d, int comps, int axis, const float* taps, int tap_count)
+  {
+    const int n = axis == 0 ? w : axis == 1 ? h : d;
+    const int n2 = n / 2;
+    // floats between two consecutive texels along the axis and number of independent runs
+    const int inner = axis == 0 ? comps : axis == 1 ? w*comps : w*h*comps;
+    const int outer = axis == 0 ? h*d   : axis == 1 ? d       : 1;
+    const int first = 1 - tap_count/2;
+    const int count = outer * n2;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(count * inner > 16384)
+#endif
+    for(int oi=0; oi<count; ++oi)
     {
-      for(int c=0; c<components; ++c)
+      const int o = oi / n2;
+      const int i = oi % n2;
+      float* out = dst + (size_t)oi * inner;
+      for(int e=0; e<inner; ++e)
+        out[e] = 0;
+      for(int k=0; k<tap_count; ++k)
       {
-        double dval = 0;
-        long long qint = 0;
+        int j = 2*i + first + k;
+        j = j < 0 ? 0 : j >= n ? n-1 : j;
+        const float* in = src + ((size_t)o * n + j) * inner;
+        const float t = taps[k];
+        for(int e=0; e<inner; ++e)
+          out[e] += t * in[e];
+      }
+    }
+  }
 
-        // convert dst format to double
+  template<typename T>
+  void mipmapToFloat(const unsigned char* pixels, int pitch, int rows, int row_floats, float* dst)
+  {
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(rows * row_floats > 16384)
+#endif
+    for(int r=0; r<rows; ++r)
+    {
+      const T* px = (const T*)(pixels + (size_t)pitch * r);
+      float* out = dst + (size_t)row_floats * r;
+      for(int e=0; e<row_floats; ++e)
+        out[e] = (float)px[e];
+    }
+  }
 
-        switch(type())
+  template<typename T>
+  void mipmapFromFloat(const float* src, int rows, int row_floats, unsigned char* pixels, int pitch, float max_val)
+  {
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(rows * row_floats > 16384)
+#endif
+    for(int r=0; r<rows; ++r)
+    {
+      const float* in = src + (size_t)row_floats * r;
+      T* px = (T*)(pixels + (size_t)pitch * r);
+      if (max_val)
+      {
+        // integer types: round and clamp the negative lobes of the Kaiser filter
+        for(int e=0; e<row_floats; ++e)
         {
-          case IT_UNSIGNED_BYTE:  qint = *srcUByte;  dval = qint/255.0; ++srcUByte; break;
-          case IT_BYTE:           qint = *srcSByte;  dval = qint/127.0; ++srcSByte; break;
-          case IT_UNSIGNED_SHORT: qint = *srcUShort; dval = qint/65535.0; ++srcUShort; break;
-          case IT_SHORT:          qint = *srcSShort; dval = qint/32767.0; ++srcSShort; break;
-          case IT_UNSIGNED_INT:   qint = *srcUInt;   dval = qint/4294967295.0; ++srcUInt; break;
-          case IT_INT:            qint = *srcSInt;   dval = qint/2147483647.0; ++srcSInt; break;
-          case IT_FLOAT:          dval = *srcFloat;  ++srcFloat; break;
-          default:
-            return NULL;
+          float v = in[e] + 0.5f;
+          px[e] = (T)(v < 0 ? 0 : v > max_val ? max_val : v);
         }
+      }
+      else
+      {
+        for(int e=0; e<row_floats; ++e)
+          px[e] = (T)in[e];
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool Image::generateMipmaps(EMipmapFilter filter)
+{
+  int comps = 0;
+  switch(format())
+  {
+    case IF_RGB:   comps = 3; break;
+    case IF_RGBA:  comps = 4; break;
+    case IF_BGR:   comps = 3; break;
+    case IF_BGRA:  comps = 4; break;
+    case IF_RG:    comps = 2; break;
+    case IF_RED:   comps = 1; break;
+    case IF_GREEN: comps = 1; break;
+    case IF_BLUE:  comps = 1; break;
+    case IF_ALPHA: comps = 1; break;
+    case IF_LUMINANCE: comps = 1; break;
+    case IF_LUMINANCE_ALPHA: comps = 2; break;
+    default:
+      Log::error("Image::generateMipmaps(): unsupported image format().\n");
+      return false;
+  }
 
-        // clamp 0.0 >= dval >= 1.0
-        dval = dval < 0.0 ? 0.0 :
-               dval > 1.0 ? 1.0 :
-               dval;
+  if (type() != IT_UNSIGNED_BYTE && type() != IT_UNSIGNED_SHORT && type() != IT_FLOAT)
+  {
+    Log::error("Image::generateMipmaps(): unsupported image type(). Types supported are IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT, IT_FLOAT.\n");
+    return false;
+  }
 
-        // convert double to dst format
+  const EImageDimension dim = dimension();
+  if (dim == ID_None || dim == ID_Error)
+  {
+    Log::error("Image::generateMipmaps(): invalid image.\n");
+    return false;
+  }
 
-        switch(img->type())
-        {
-          case IT_UNSIGNED_BYTE:  *dstUByte  = (unsigned char) (dval*255.0); ++dstUByte; break;
-          case IT_BYTE:           *dstSByte  = (GLbyte)  (dval*127.0); ++dstSByte; break;
-          case IT_UNSIGNED_SHORT: *dstUShort = (GLushort)(dval*65535.0); ++dstUShort; break;
-          case IT_SHORT:          *dstSShort = (GLshort) (dval*32767.0); ++dstSShort; break;
-          case IT_UNSIGNED_INT:   *dstUInt   = (unsigned int)  (dval*4294967295.0); ++dstUInt; break;
-          case IT_INT:            *dstSInt   = (int)   (dval*2147483647.0); ++dstSInt; break;
-          case IT_FLOAT:          *dstFloat  = (float)dval; ++dstFloat; break;
-          default:
-            return NULL;
-        }
-      }
+  float taps[6];
+  const int tap_count = mipmapTaps(filter, taps);
+
+  // cubemaps are filtered as a stack of 6 faces along z which is never halved
+  int w = width();
+  int h = height() ? height() : 1;
+  int d = isCubemap() ? 6 : depth() ? depth() : 1;
+
+  std::vector<float> level( (size_t)w*h*d*comps ), tmp;
+  switch(type())
+  {
+    case IT_UNSIGNED_BYTE:  mipmapToFloat<unsigned char> (pixels(), pitch(), h*d, w*comps, &level[0]); break;
+    case IT_UNSIGNED_SHORT: mipmapToFloat<unsigned short>(pixels(), pitch(), h*d, w*comps, &level[0]); break;
+    default:                mipmapToFloat<float>         (pixels(), pitch(), h*d, w*comps, &level[0]); break;
+  }
+
+  std::vector< ref<Image> > mipmaps;
+  while( w > 1 || (dim != ID_1D && h > 1) || (dim == ID_3D && d > 1) )
+  {
+    if (w > 1)
+    {
+      tmp.resize( (size_t)(w/2)*h*d*comps );
+      halveAxis(&level[0], &tmp[0], w, h, d, comps, 0, taps, tap_count);
+      level.swap(tmp);
+      w /= 2;
+    }
+    if (dim != ID_1D && h > 1)
+    {
+      tmp.resize( (size_t)w*(h/2)*d*comps );
+      halveAxis(&level[0], &tmp[0], w, h, d, comps, 1, taps, tap_count);
+      level.swap(tmp);
+      h /= 2;
+    }
+    if (dim == ID_3D && d > 1)
+    {
+      tmp.resize( (size_t)w*h*(d/2)*comps );
+      halveAxis(&level[0], &tmp[0], w, h, d, comps, 2, taps, tap_count);
+      level.swap(tmp);
+      d /= 2;
+    }
+
+    ref<Image> mip = new Image;
+    mip->setObjectName( objectName().c_str() );
+    switch(dim)
+    {
+      case ID_1D:      mip->allocate1D(w, format(), type()); break;
+      case ID_2D:      mip->allocate2D(w, h, byteAlignment(), format(), type()); break;
+      case ID_3D:      mip->allocate3D(w, h, d, byteAlignment(), format(), type()); break;
+      default:         mip->allocateCubemap(w, h, byteAlignment(), format(), type()); break;
     }
+
+    switch(type())
+    {
+      case IT_UNSIGNED_BYTE:  mipmapFromFloat<unsigned char> (&level[0], h*d, w*comps, mip->pixels(), mip->pitch(), 0xFF);   break;
+      case IT_UNSIGNED_SHORT: mipmapFromFloat<unsigned short>(&level[0], h*d, w*comps, mip->pixels(), mip->pitch(), 0xFFFF); break;
+      default:                mipmapFromFloat<float>         (&level[0], h*d, w*comps, mip->pixels(), mip->pitch(), 0);      break;
+    }
+
+    mipmaps.push_back(mip);
   }
 
-  return img;
+  setMipmaps(mipmaps);
+  return true;
 }
 //-----------------------------------------------------------------------------
 namespace {
   template<typename T>
   void equalizeTemplate(void* ptr, int pitch, int comps, int w, int h, T max_val)
   {
-    // find min/max
-    T vmin = *((T*)ptr);
-    T vmax = *((T*)ptr);
+    // find min/max of each row in parallel, then of the whole image
+    std::vector<T> row_min(h), row_max(h);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(h * w * comps > 65536)
+#endif
     for(int y=0; y<h; ++y)
     {
       T* px = (T*)((char*)ptr + pitch*y);
-      for(int x=0; x<w; ++x)
+      T rmin = px[0];
+      T rmax = px[0];
+      for(int x=0; x<w*comps; ++x)
       {
-        for(int i=0; i<comps; ++i)
-        {
-          if (vmin > px[x*comps+i]) vmin = px[x*comps+i];
-          if (vmax < px[x*comps+i]) vmax = px[x*comps+i];
-        }
+        if (rmin > px[x]) rmin = px[x];
+        if (rmax < px[x]) rmax = px[x];
       }
+      row_min[y] = rmin;
+      row_max[y] = rmax;
+    }
+    T vmin = *((T*)ptr);
+    T vmax = *((T*)ptr);
+    for(int y=0; y<h; ++y)
+    {
+      if (vmin > row_min[y]) vmin = row_min[y];
+      if (vmax < row_max[y]) vmax = row_max[y];
     }
     // equalize
     T range = vmax-vmin;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(h * w * comps > 65536)
+#endif
     for(int y=0; y<h; ++y)
     {
       T* px = (T*)((char*)ptr + pitch*y);
@@ -1596,6 +2053,9 @@ namespace {
   void contrastTemplate(void* ptr, int pitch, int w, int h, T max_val, float black, float white)
   {
     float range = white-black;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(h * w > 65536)
+#endif
     for(int y=0; y<h; ++y)
     {
       T* px = (T*)((char*)ptr + pitch*y);
@@ -1715,6 +2175,90 @@ namespace
         dst_px[dsto.b] = src_px[srco.l];
     }
   }
+
+  //! Computes for each destination component the source component it copies, -1 meaning its default value.
+  //! Mirrors convert() and returns false when the conversion is not a plain shuffle, i.e. rgb -> gray.
+  bool convertMap(const rgbal& srco, const rgbal& dsto, int map[4])
+  {
+    map[0] = map[1] = map[2] = map[3] = -1;
+
+    if (dsto.r != -1) map[dsto.r] = srco.r;
+    if (dsto.g != -1) map[dsto.g] = srco.g;
+    if (dsto.b != -1) map[dsto.b] = srco.b;
+    if (dsto.a != -1) map[dsto.a] = srco.a;
+    if (dsto.l != -1) map[dsto.l] = srco.l;
+
+    if (dsto.l != -1 && srco.r != -1 && srco.g != -1 && srco.b != -1)
+      return false;
+    else
+    if (dsto.l != -1 && srco.r != -1 && srco.g == -1 && srco.b == -1)
+      map[dsto.l] = srco.r;
+    else
+    if (dsto.l != -1 && srco.r == -1 && srco.g != -1 && srco.b == -1)
+      map[dsto.l] = srco.g;
+    else
+    if (dsto.l != -1 && srco.r == -1 && srco.g == -1 && srco.b != -1)
+      map[dsto.l] = srco.b;
+    else
+    if (srco.l != -1)
+    {
+      if (dsto.r != -1) map[dsto.r] = srco.l;
+      if (dsto.g != -1) map[dsto.g] = srco.l;
+      if (dsto.b != -1) map[dsto.b] = srco.l;
+    }
+    return true;
+  }
+
+  //! Shuffles a line of pixels with compile time component counts so that the inner loop gets unrolled.
+  template<typename T, int src_comp, int dst_comp>
+  void shuffleLine(const T* src, T* dst, int width, const int map[4], const T def[4])
+  {
+    for(int j=0; j<width; ++j, src+=src_comp, dst+=dst_comp)
+      for(int c=0; c<dst_comp; ++c)
+        dst[c] = map[c] != -1 ? src[map[c]] : def[c];
+  }
+
+  template<typename T>
+  void convertLines(const unsigned char* src, int src_pitch, int src_comp, unsigned char* dst, int dst_pitch, int dst_comp,
+                    int line_count, int width, T max_value, const rgbal& srco, const rgbal& dsto)
+  {
+    int map[4];
+    const bool shuffle = convertMap(srco, dsto, map);
+    T def[4] = { 0, 0, 0, 0 };
+    if (dsto.a != -1)
+      def[dsto.a] = max_value;
+    const int kernel = src_comp*10 + dst_comp;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) if(line_count * width > 16384)
+#endif
+    for(int i=0; i<line_count; ++i)
+    {
+      const T* s = (const T*)(src + (size_t)src_pitch*i);
+      T* d = (T*)(dst + (size_t)dst_pitch*i);
+
+      if (!shuffle)
+      {
+        for(int j=0; j<width; ++j, s+=src_comp, d+=dst_comp)
+          convert<T>(s, d, max_value, srco, dsto);
+        continue;
+      }
+
+      switch(kernel)
+      {
+        case 34: shuffleLine<T,3,4>(s, d, width, map, def); break; // RGB <-> RGBA/BGRA
+        case 43: shuffleLine<T,4,3>(s, d, width, map, def); break; // RGBA -> RGB/BGR
+        case 33: shuffleLine<T,3,3>(s, d, width, map, def); break; // RGB <-> BGR
+        case 44: shuffleLine<T,4,4>(s, d, width, map, def); break; // RGBA <-> BGRA
+        case 13: shuffleLine<T,1,3>(s, d, width, map, def); break; // luminance expansion
+        case 14: shuffleLine<T,1,4>(s, d, width, map, def); break; // luminance expansion
+        default:
+          for(int j=0; j<width; ++j, s+=src_comp, d+=dst_comp)
+            for(int c=0; c<dst_comp; ++c)
+              d[c] = map[c] != -1 ? s[map[c]] : def[c];
+      }
+    }
+  }
 }
 ref<Image> vl::Image::convertFormat(EImageFormat new_format) const
 {
@@ -1861,42 +2405,21 @@ ref<Image> vl::Image::convertFormat(EImageFormat new_format) const
   if (img->isCubemap())
     line_count *= 6;
 
-  for(int i=0; i<line_count; ++i)
-  {
-    const void* srcLine = pixels()      + pitch()*i;
-    void* dstLine = img->pixels() + img->pitch()*i;
-
-    const unsigned char* srcUByte  = (const unsigned char*)srcLine;
-    const GLbyte*        srcSByte  = (const GLbyte*)srcLine;
-    const GLushort*      srcUShort = (const GLushort*)srcLine;
-    const GLshort*       srcSShort = (const GLshort*)srcLine;
-    const unsigned int*  srcUInt   = (const unsigned int*)srcLine;
-    const int*           srcSInt   = (const int*)srcLine;
-    const float*         srcFloat  = (const float*)srcLine;
-
-    unsigned char* dstUByte  = (unsigned char*)dstLine;
-    GLbyte*        dstSByte  = (GLbyte*)dstLine;
-    GLushort*      dstUShort = (GLushort*)dstLine;
-    GLshort*       dstSShort = (GLshort*)dstLine;
-    unsigned int*  dstUInt   = (unsigned int*)dstLine;
-    int*           dstSInt   = (int*)dstLine;
-    float*         dstFloat  = (float*)dstLine;
+  const unsigned char* src = pixels();
+  unsigned char* dst = img->pixels();
+  const int w = img->width();
 
-    for(int j=0; j<img->width(); ++j)
-    {
-      switch(type())
-      {
-        case IT_UNSIGNED_BYTE:  convert<unsigned char> (srcUByte,  dstUByte,  255,         srco, dsto); srcUByte+=src_comp;  dstUByte+=dst_comp;  break;
-        case IT_BYTE:           convert<GLbyte>        (srcSByte,  dstSByte,  127,         srco, dsto); srcSByte+=src_comp;  dstSByte+=dst_comp;  break;
-        case IT_UNSIGNED_SHORT: convert<GLushort>      (srcUShort, dstUShort, 65535,       srco, dsto); srcUShort+=src_comp; dstUShort+=dst_comp; break;
-        case IT_SHORT:          convert<GLshort>       (srcSShort, dstSShort, 32767,       srco, dsto); srcSShort+=src_comp; dstSShort+=dst_comp; break;
-        case IT_UNSIGNED_INT:   convert<unsigned int>  (srcUInt,   dstUInt,   4294967295U, srco, dsto); srcUInt+=src_comp;   dstUInt+=dst_comp;   break;
-        case IT_INT:            convert<int>           (srcSInt,   dstSInt,   2147483647,  srco, dsto); srcSInt+=src_comp;   dstSInt+=dst_comp;   break;
-        case IT_FLOAT:          convert<float>         (srcFloat,  dstFloat,  1.0f,        srco, dsto); srcFloat+=src_comp;  dstFloat+=dst_comp;  break;
-        default:
-          return NULL;
-      }
-    }
+  switch(type())
+  {
+    case IT_UNSIGNED_BYTE:  convertLines<unsigned char>(src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 255,         srco, dsto); break;
+    case IT_BYTE:           convertLines<GLbyte>       (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 127,         srco, dsto); break;
+    case IT_UNSIGNED_SHORT: convertLines<GLushort>     (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 65535,       srco, dsto); break;
+    case IT_SHORT:          convertLines<GLshort>      (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 32767,       srco, dsto); break;
+    case IT_UNSIGNED_INT:   convertLines<unsigned int> (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 4294967295U, srco, dsto); break;
+    case IT_INT:            convertLines<int>          (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 2147483647,  srco, dsto); break;
+    case IT_FLOAT:          convertLines<float>        (src, pitch(), src_comp, dst, img->pitch(), dst_comp, line_count, w, 1.0f,        srco, dsto); break;
+    default:
+      return NULL;
   }
 
   return img;
@@ -158,7 +158,7 @@ namespace vl
     void setTags(KeyValues* tags) { mTags = tags; }
 
     //! The buffer used to store the image pixels.
-    void setImageBuffer(Buffer* buffer) { mPixels = buffer; }
+    void setImageBuffer(Buffer* buffer) { mPixels = buffer; if (buffer) buffer->setMemoryCategory(MC_Image); }
 
     //! The buffer used to store the image pixels.
     Buffer* imageBuffer() { return mPixels.get(); }
@@ -216,7 +216,7 @@ namespace vl
 
     EImageType type() const { return mType; }
 
-    int isCompressedFormat(EImageFormat fmt);
+    static int isCompressedFormat(EImageFormat fmt);
 
     void flipVertically();
 
@@ -273,6 +273,18 @@ namespace vl
      */
     ref<Image> convertFormat(EImageFormat new_format) const;
 
+    /**
+     * Generates the whole mipmap chain of the image down to 1x1 texels, replacing the current mipmaps().
+     * Each level is filtered from the previous one kept in floating point, so the rounding errors do not accumulate.
+     * Supports 1D, 2D, 3D images and cubemaps whose type() is IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT or IT_FLOAT and whose
+     * format() is an uncompressed color format. Returns false if the image format() or type() is not supported.
+     *
+     * The function only touches this image so it can be run by a background loader thread, and the result can be
+     * cached with saveImage() to a \p .ktx file so that subsequent loads skip the work entirely.
+     * Rows are filtered in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP).
+     */
+    bool generateMipmaps(EMipmapFilter filter=MF_Box);
+
     //! Equalizes the image. Returns false if the image format() or type() is not supported. This function supports both 3D images and cubemaps.
     bool equalize();
 
@@ -404,7 +416,13 @@ namespace vl
   //! \param file The file from which the data is read. This function also opens the file if it is not open already. Note that this function
   //! never closes the file so that you can read sequentially several raw image data from the same file.
   //! \param file_offset The offset in the file from where the data is read. If set to -1 the data is read from the current file position.
-  VLCORE_EXPORT ref<Image> loadRAW(VirtualFile* file, long long file_offset, int width, int height, int depth, int bytealign, EImageFormat format, EImageType type);
+  //! \param swap_byte_order If true the byte order of the 16, 32 and 64 bits components is reversed after loading, see swapByteOrder().
+  //! If \p file is a MappedFile the image uses the mapped pages as storage and the byte order is swapped in place on the private pages.
+  VLCORE_EXPORT ref<Image> loadRAW(VirtualFile* file, long long file_offset, int width, int height, int depth, int bytealign, EImageFormat format, EImageType type, bool swap_byte_order=false);
+
+  //! Reverses the byte order of \p element_count elements of \p element_size bytes (2, 4 or 8), using SSE2 when VL_SIMD is enabled
+  //! and splitting large buffers in chunks processed in parallel when VL_OPENMP is enabled.
+  VLCORE_EXPORT void swapByteOrder(void* data, long long element_count, int element_size);
 
   //! Loads an image from the specified file
   VLCORE_EXPORT ref<Image> loadImage(VirtualFile* file);
@@ -415,6 +433,16 @@ namespace vl
   //! Loads all the images with the specified extension from the given directory.
   VLCORE_EXPORT bool loadImagesFromDir(const String& dir_path, const String& ext, std::vector< ref<Image> >& images);
 
+  /** Loads the images at the given paths decoding them in parallel with up to \p thread_count OpenMP threads.
+   * On return \p images contains one entry per path, in the same order, set to NULL for the images that could not be loaded.
+   * Returns true if all the images have been loaded.
+   * The files are located and the lazy ResourceLoadWriter registrations are performed by the calling thread, each image is then
+   * decoded by a worker thread with its own decoder state, see loadImage(VirtualFile*). Falls back to sequential loading if
+   * VL_OPENMP is disabled.
+   * \note The shared ResourceCache and Log are only thread safe if a mutex has been installed, see ResourceCache::setMutex()
+   * and Log::setLogMutex(), and the reference counting must be thread safe, see VL_ATOMIC_REF_COUNT and Object::setRefCountMutex(). */
+  VLCORE_EXPORT bool loadImagesParallel(const std::vector<String>& paths, std::vector< ref<Image> >& images, int thread_count=4);
+
   //! Assembles the given 2D images in a single 2D image, all the images must be 2D images and have the same size, format() and type().
   VLCORE_EXPORT ref<Image> assemble3DImage(const std::vector< ref<Image> >& images);
 
@@ -0,0 +1,61 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlCore/ImageRowWriter.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+#if defined(VL_IO_2D_PNG)
+  #include <vlCore/plugins/ioPNG.hpp>
+#endif
+#if defined(VL_IO_2D_TIFF)
+  #include <vlCore/plugins/ioTIFF.hpp>
+#endif
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+ref<ImageRowWriter> vl::createImageRowWriter(const String& path)
+{
+  String ext = path.extractFileExtension().toLowerCase();
+#if defined(VL_IO_2D_PNG)
+  if (ext == "png")
+    return new PNGRowWriter;
+#endif
+#if defined(VL_IO_2D_TIFF)
+  if (ext == "tif" || ext == "tiff")
+    return new TIFFRowWriter;
+#endif
+  Log::error( Say("createImageRowWriter('%s'): unsupported file format.\n") << path );
+  return NULL;
+}
+//-----------------------------------------------------------------------------
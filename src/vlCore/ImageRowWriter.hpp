@@ -0,0 +1,84 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef ImageRowWriter_INCLUDE_ONCE
+#define ImageRowWriter_INCLUDE_ONCE
+
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/String.hpp>
+
+namespace vl
+{
+//-----------------------------------------------------------------------------
+// ImageRowWriter
+//-----------------------------------------------------------------------------
+  /**
+   * Writes an IF_RGBA / IT_UNSIGNED_BYTE image to a file one group of rows at a time, from the top row to the bottom one,
+   * so that images too big to fit in memory (see TileRenderer) never need to be assembled as a whole.
+   *
+   * Call open() with the final size of the image, then writeRows() until height() rows have been written, then close().
+   * Use createImageRowWriter() to pick the implementation matching a file extension.
+   */
+  class VLCORE_EXPORT ImageRowWriter: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::ImageRowWriter, Object)
+
+  public:
+    ImageRowWriter(): mWidth(0), mHeight(0), mRowsWritten(0) {}
+
+    //! Opens \p file for writing and writes the header of a \p width x \p height image.
+    virtual bool open(VirtualFile* file, int width, int height) = 0;
+
+    //! Writes \p count rows of width() RGBA8 pixels, \p pitch bytes apart, continuing from the last row written.
+    virtual bool writeRows(const unsigned char* rows, int count, int pitch) = 0;
+
+    //! Finalizes and closes the file, returns false if fewer than height() rows have been written.
+    virtual bool close() = 0;
+
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+    int rowsWritten() const { return mRowsWritten; }
+    VirtualFile* file() { return mFile.get(); }
+    const VirtualFile* file() const { return mFile.get(); }
+
+  protected:
+    ref<VirtualFile> mFile;
+    int mWidth;
+    int mHeight;
+    int mRowsWritten;
+  };
+
+  //! Returns the ImageRowWriter for the extension of \p path ("png", "tif" or "tiff") or NULL if the format is not supported or not enabled.
+  VLCORE_EXPORT ref<ImageRowWriter> createImageRowWriter(const String& path);
+}
+
+#endif
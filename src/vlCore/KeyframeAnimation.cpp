@@ -0,0 +1,189 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/KeyframeAnimation.hpp>
+#include <vlCore/Log.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+int KeyframeAnimation::addTrack(Transform* tr, const std::vector<float>& times, const std::vector<fvec3>& translations, const std::vector<fquat>& rotations, const std::vector<fvec3>& scalings)
+{
+  const size_t count = times.size();
+  if ( !tr || !count ||
+       ( !translations.empty() && translations.size() != count ) ||
+       ( !rotations.empty()    && rotations.size()    != count ) ||
+       ( !scalings.empty()     && scalings.size()     != count ) )
+  {
+    Log::error("KeyframeAnimation::addTrack(): invalid Transform or keyframe array sizes.\n");
+    return -1;
+  }
+
+  for(size_t i=1; i<count; ++i)
+  {
+    if ( times[i] < times[i-1] )
+    {
+      Log::error("KeyframeAnimation::addTrack(): keyframe times must be in increasing order.\n");
+      return -1;
+    }
+  }
+
+  const int first = (int)mTime.size();
+  fquat prev_q;
+  for(size_t i=0; i<count; ++i)
+  {
+    fvec3 t = translations.empty() ? fvec3(0,0,0) : translations[i];
+    fvec3 s = scalings.empty()     ? fvec3(1,1,1) : scalings[i];
+    fquat q(0,0,0,1);
+    if ( !rotations.empty() )
+      q = rotations[i];
+    q.normalize();
+    // keeps consecutive rotations on the same hemisphere so that evaluate() takes the shortest path without testing it
+    if ( i && q.dot(prev_q) < 0 )
+      q = -q;
+    prev_q = q;
+
+    mTime.push_back( times[i] );
+    mTx.push_back( t.x() ); mTy.push_back( t.y() ); mTz.push_back( t.z() );
+    mQx.push_back( q.x() ); mQy.push_back( q.y() ); mQz.push_back( q.z() ); mQw.push_back( q.w() );
+    mSx.push_back( s.x() ); mSy.push_back( s.y() ); mSz.push_back( s.z() );
+  }
+
+  mTransforms.push_back( tr );
+  mFirstKey.push_back( first );
+  mKeyCount.push_back( (int)count );
+  mCursor.push_back( first );
+  mEnabled.push_back( 1 );
+  mLooping.push_back( 0 );
+  mMatrix.push_back( tr->localMatrix() );
+  return trackCount() - 1;
+}
+//-----------------------------------------------------------------------------
+void KeyframeAnimation::clear()
+{
+  mTime.clear();
+  mTx.clear(); mTy.clear(); mTz.clear();
+  mQx.clear(); mQy.clear(); mQz.clear(); mQw.clear();
+  mSx.clear(); mSy.clear(); mSz.clear();
+  mTransforms.clear();
+  mFirstKey.clear();
+  mKeyCount.clear();
+  mCursor.clear();
+  mEnabled.clear();
+  mLooping.clear();
+  mMatrix.clear();
+}
+//-----------------------------------------------------------------------------
+void KeyframeAnimation::evaluate(float time)
+{
+  const int count = trackCount();
+  if (!count)
+    return;
+
+  const float* times = &mTime[0];
+
+  // interpolate all the tracks
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(mThreadCount) if(mThreadCount > 1 && count > 256)
+#endif
+  for(int i=0; i<count; ++i)
+  {
+    if ( !mEnabled[i] )
+      continue;
+
+    const int first = mFirstKey[i];
+    const int last  = first + mKeyCount[i] - 1;
+    const float start = times[first];
+    const float end   = times[last];
+    float t = time;
+    if ( mLooping[i] && end > start )
+    {
+      t = fmodf( t - start, end - start );
+      t = ( t < 0 ? t + (end - start) : t ) + start;
+    }
+
+    // find the segment [k, k+1] containing t, starting from the one used last time
+    int k = mCursor[i];
+    if ( t <= start )
+      k = first;
+    else
+    if ( t >= end )
+      k = last;
+    else
+    if ( !( k < last && times[k] <= t && t < times[k+1] ) )
+    {
+      if ( k+1 < last && times[k+1] <= t && t < times[k+2] )
+        ++k;
+      else
+        k = (int)( std::upper_bound( times + first, times + last + 1, t ) - times ) - 1;
+    }
+    mCursor[i] = k;
+
+    const int k1 = k < last ? k + 1 : k;
+    float w = times[k1] > times[k] ? ( t - times[k] ) / ( times[k1] - times[k] ) : 0.0f;
+    w = w < 0 ? 0 : ( w > 1 ? 1 : w );
+    const float u = 1.0f - w;
+
+    const float tx = mTx[k] * u + mTx[k1] * w;
+    const float ty = mTy[k] * u + mTy[k1] * w;
+    const float tz = mTz[k] * u + mTz[k1] * w;
+    const float sx = mSx[k] * u + mSx[k1] * w;
+    const float sy = mSy[k] * u + mSy[k1] * w;
+    const float sz = mSz[k] * u + mSz[k1] * w;
+    float qx = mQx[k] * u + mQx[k1] * w;
+    float qy = mQy[k] * u + mQy[k1] * w;
+    float qz = mQz[k] * u + mQz[k1] * w;
+    float qw = mQw[k] * u + mQw[k1] * w;
+    const float len2 = qx*qx + qy*qy + qz*qz + qw*qw;
+    const float inv = len2 > 0 ? 1.0f / sqrtf( len2 ) : 0;
+    qx *= inv; qy *= inv; qz *= inv; qw = len2 > 0 ? qw * inv : 1.0f;
+
+    // translation * rotation * scaling, see Quaternion::toMatrix4()
+    const float x2 = qx*qx, y2 = qy*qy, z2 = qz*qz;
+    const float xy = qx*qy, xz = qx*qz, yz = qy*qz;
+    const float wx = qw*qx, wy = qw*qy, wz = qw*qz;
+    mat4& m = mMatrix[i];
+    m.e(0,0) = (1 - 2*(y2 + z2)) * sx; m.e(0,1) = 2*(xy - wz) * sy;       m.e(0,2) = 2*(xz + wy) * sz;       m.e(0,3) = tx;
+    m.e(1,0) = 2*(xy + wz) * sx;       m.e(1,1) = (1 - 2*(x2 + z2)) * sy; m.e(1,2) = 2*(yz - wx) * sz;       m.e(1,3) = ty;
+    m.e(2,0) = 2*(xz - wy) * sx;       m.e(2,1) = 2*(yz + wx) * sy;       m.e(2,2) = (1 - 2*(x2 + y2)) * sz; m.e(2,3) = tz;
+    m.e(3,0) = 0;                      m.e(3,1) = 0;                      m.e(3,2) = 0;                      m.e(3,3) = 1;
+  }
+
+  // setLocalMatrix() flags the ancestors of each Transform, which is not thread safe
+  for(int i=0; i<count; ++i)
+  {
+    if ( mEnabled[i] )
+      mTransforms[i]->setLocalMatrix( mMatrix[i] );
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef KeyframeAnimation_INCLUDE_ONCE
+#define KeyframeAnimation_INCLUDE_ONCE
+
+#include <vlCore/Transform.hpp>
+#include <vlCore/Quaternion.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // KeyframeAnimation
+  //------------------------------------------------------------------------------
+  /** Evaluates in a single batched pass the keyframe tracks animating a large number of Transforms.
+    *
+    * Each track animates the local matrix of a Transform with a sequence of translation, rotation and scaling keyframes.
+    * Unlike a set of LinearInterpolator objects updated one by one from callbacks, all the keyframes are stored in structure-of-arrays form,
+    * one contiguous array per component, and evaluate() interpolates all the enabled tracks with a plain loop, which is run in parallel
+    * if VL is compiled with OpenMP support (CMake option VL_OPENMP) and threadCount() is greater than 1.
+    * The resulting matrices are then assigned with Transform::setLocalMatrix() which flags them for Transform::computeDirtyWorldMatrices().
+    *
+    * Translations and scalings are interpolated linearly, rotations with a normalized linear interpolation (see Quaternion::getNlerp()),
+    * the local matrix being translation * rotation * scaling. Playback is coherent: each track remembers the last keyframe used
+    * so that evaluating increasing times does not search the keyframes again.
+    * \sa Transform::computeDirtyWorldMatrices(), FlatTransformHierarchy */
+  class VLCORE_EXPORT KeyframeAnimation: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::KeyframeAnimation, Object)
+
+  public:
+    /** Constructor. */
+    KeyframeAnimation(): mThreadCount(1)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    /** Adds a track animating \p tr and returns its index, -1 on error.
+      * \param times The time of each keyframe in seconds, in increasing order.
+      * \param translations The translation of each keyframe, if empty the track does not translate.
+      * \param rotations The rotation of each keyframe, if empty the track does not rotate.
+      * \param scalings The scaling of each keyframe, if empty the track does not scale.
+      * The non empty arrays must have the same size as \p times. */
+    int addTrack(Transform* tr, const std::vector<float>& times, const std::vector<fvec3>& translations, const std::vector<fquat>& rotations, const std::vector<fvec3>& scalings);
+
+    /** Removes all the tracks. */
+    void clear();
+
+    /** Interpolates all the enabled tracks at \p time and updates the local matrix of their Transforms. */
+    void evaluate(float time);
+
+    /** The number of tracks. */
+    int trackCount() const { return (int)mTransforms.size(); }
+
+    /** The Transform animated by the given track. */
+    Transform* trackTransform(int track) { return mTransforms[track].get(); }
+
+    /** The Transform animated by the given track. */
+    const Transform* trackTransform(int track) const { return mTransforms[track].get(); }
+
+    /** The local matrix computed for the given track by the last evaluate(). */
+    const mat4& trackMatrix(int track) const { return mMatrix[track]; }
+
+    /** Disabled tracks are skipped by evaluate() and leave their Transform untouched (default = true). */
+    void setTrackEnabled(int track, bool enabled) { mEnabled[track] = enabled; }
+
+    /** Disabled tracks are skipped by evaluate() and leave their Transform untouched (default = true). */
+    bool trackEnabled(int track) const { return mEnabled[track] != 0; }
+
+    /** If \p true the track repeats its keyframes over time, otherwise it holds its first and last keyframes (default = false). */
+    void setTrackLooping(int track, bool looping) { mLooping[track] = looping; }
+
+    /** If \p true the track repeats its keyframes over time, otherwise it holds its first and last keyframes (default = false). */
+    bool trackLooping(int track) const { return mLooping[track] != 0; }
+
+    /** The total number of keyframes of all the tracks. */
+    int keyframeCount() const { return (int)mTime.size(); }
+
+    /** The number of threads used by evaluate(). Has effect only if VL is compiled with OpenMP support. */
+    void setThreadCount(int count) { mThreadCount = count > 1 ? count : 1; }
+
+    /** The number of threads used by evaluate(). Has effect only if VL is compiled with OpenMP support. */
+    int threadCount() const { return mThreadCount; }
+
+  protected:
+    // keyframes of all the tracks, one array per component
+    std::vector<float> mTime;
+    std::vector<float> mTx, mTy, mTz;
+    std::vector<float> mQx, mQy, mQz, mQw;
+    std::vector<float> mSx, mSy, mSz;
+
+    // tracks
+    std::vector< ref<Transform> > mTransforms;
+    std::vector<int> mFirstKey;
+    std::vector<int> mKeyCount;
+    std::vector<int> mCursor;
+    std::vector<unsigned char> mEnabled;
+    std::vector<unsigned char> mLooping;
+    std::vector<mat4> mMatrix;
+    int mThreadCount;
+  };
+}
+
+#endif
@@ -34,9 +34,27 @@
 #include <vlCore/Say.hpp>
 #include <vlCore/Time.hpp>
 #include <vlCore/GZipCodec.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/ResourceCache.hpp>
 
 using namespace vl;
 
+//-----------------------------------------------------------------------------
+void LoadWriterManager::performLazyRegistrations() const
+{
+  if ( mLazyRegistrations.empty() )
+    return;
+
+  // the registration functions call registerLoadWriter() which calls loadWriters() again
+  std::vector<LazyRegistration> registrations;
+  registrations.swap( mLazyRegistrations );
+
+  Time timer;
+  timer.start();
+  for(size_t i=0; i<registrations.size(); ++i)
+    registrations[i]( const_cast<LoadWriterManager*>(this) );
+  Log::debug( Say("LoadWriterManager: lazy registration of the load writers: %.3nms\n") << timer.elapsed() * 1000.0 );
+}
 //-----------------------------------------------------------------------------
 const ResourceLoadWriter* LoadWriterManager::findLoader(VirtualFile* file) const
 {
@@ -92,6 +110,14 @@ ref<ResourceDatabase> LoadWriterManager::loadResource(VirtualFile* file, bool qu
   if (loadwriter)
   {
     ref<ResourceDatabase> db;
+    // shared resources from a previous load
+    ResourceCache* cache = defResourceCache();
+    if (cache)
+    {
+      db = cache->find(file);
+      if (db)
+        return db;
+    }
     if (quick)
     {
       // caching the data in the memory provides a huge performance boost
@@ -108,6 +134,8 @@ ref<ResourceDatabase> LoadWriterManager::loadResource(VirtualFile* file, bool qu
     // load callbacks
     for(size_t i=0; db && i<loadCallbacks().size(); ++i)
       loadCallbacks()[i].get_writable()->operator()(db.get());
+    if (cache && db)
+      db = cache->insert(file, db.get());
     return db;
   }
   else
@@ -175,6 +203,156 @@ const ResourceLoadWriter* LoadWriterManager::findWriter(const String& path) cons
   return NULL;
 }
 //-----------------------------------------------------------------------------
+// ResourceLoadRequest
+//-----------------------------------------------------------------------------
+ResourceLoadRequest::ResourceLoadRequest()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mMutex = NULL;
+  mPriority = 0;
+  mState = Queued;
+  mQuick = true;
+  mDispatched = false;
+}
+//-----------------------------------------------------------------------------
+void ResourceLoadRequest::setPriority(int priority)
+{
+  ScopedMutex lock(mMutex);
+  mPriority = priority;
+}
+//-----------------------------------------------------------------------------
+int ResourceLoadRequest::priority() const
+{
+  ScopedMutex lock(mMutex);
+  return mPriority;
+}
+//-----------------------------------------------------------------------------
+ResourceLoadRequest::EState ResourceLoadRequest::state() const
+{
+  ScopedMutex lock(mMutex);
+  return mState;
+}
+//-----------------------------------------------------------------------------
+void ResourceLoadRequest::cancel()
+{
+  ScopedMutex lock(mMutex);
+  if (!mDispatched)
+    mState = Cancelled;
+}
+//-----------------------------------------------------------------------------
+// LoadWriterManager asynchronous loading
+//-----------------------------------------------------------------------------
+ref<ResourceLoadRequest> LoadWriterManager::loadResourceAsync(const String& path, int priority, LoadCompletionCallback* callback, bool quick)
+{
+  ref<ResourceLoadRequest> req = new ResourceLoadRequest;
+  req->mPath = path;
+  return enqueue(req.get(), priority, callback, quick);
+}
+//-----------------------------------------------------------------------------
+ref<ResourceLoadRequest> LoadWriterManager::loadResourceAsync(VirtualFile* file, int priority, LoadCompletionCallback* callback, bool quick)
+{
+  ref<ResourceLoadRequest> req = new ResourceLoadRequest;
+  req->mFile = file;
+  return enqueue(req.get(), priority, callback, quick);
+}
+//-----------------------------------------------------------------------------
+ref<ResourceLoadRequest> LoadWriterManager::enqueue(ResourceLoadRequest* req, int priority, LoadCompletionCallback* callback, bool quick)
+{
+  req->mCompletionCallback = callback;
+  req->mPriority = priority;
+  req->mQuick = quick;
+  req->mMutex = mMutex;
+  // never let the loading threads perform the lazy registrations
+  performLazyRegistrations();
+  ScopedMutex lock(mMutex);
+  mQueuedRequests.push_back(req);
+  return req;
+}
+//-----------------------------------------------------------------------------
+int LoadWriterManager::processLoadRequests(int max_count)
+{
+  int count = 0;
+  for( ; count < max_count; ++count )
+  {
+    ref<ResourceLoadRequest> req;
+    {
+      ScopedMutex lock(mMutex);
+      // pick the highest priority request, FIFO among equal priorities, dropping the cancelled ones
+      int best = -1;
+      for(size_t i=0; i<mQueuedRequests.size(); )
+      {
+        if (mQueuedRequests[i]->mState == ResourceLoadRequest::Cancelled)
+        {
+          mQueuedRequests.erase(mQueuedRequests.begin() + i);
+          continue;
+        }
+        if (best == -1 || mQueuedRequests[i]->mPriority > mQueuedRequests[best]->mPriority)
+          best = (int)i;
+        ++i;
+      }
+      if (best == -1)
+        break;
+      req = mQueuedRequests[best];
+      mQueuedRequests.erase(mQueuedRequests.begin() + best);
+      req->mState = ResourceLoadRequest::Loading;
+      ++mLoadingCount;
+    }
+
+    // the load callbacks are executed by this thread
+    ref<ResourceDatabase> db = req->mFile ? loadResource(req->mFile.get(), req->mQuick) : loadResource(req->mPath, req->mQuick);
+
+    {
+      ScopedMutex lock(mMutex);
+      --mLoadingCount;
+      if (req->mState != ResourceLoadRequest::Cancelled)
+      {
+        req->mResourceDatabase = db;
+        req->mState = db ? ResourceLoadRequest::Loaded : ResourceLoadRequest::Failed;
+        mCompletedRequests.push_back(req);
+      }
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+int LoadWriterManager::dispatchLoadRequests()
+{
+  if (mLoadOnDispatchCount > 0)
+    processLoadRequests(mLoadOnDispatchCount);
+
+  std::deque< ref<ResourceLoadRequest> > completed;
+  {
+    ScopedMutex lock(mMutex);
+    completed.swap(mCompletedRequests);
+  }
+
+  int count = 0;
+  for(size_t i=0; i<completed.size(); ++i)
+  {
+    ResourceLoadRequest* req = completed[i].get();
+    {
+      ScopedMutex lock(mMutex);
+      // cancelled after completion but before dispatch
+      if (req->mState == ResourceLoadRequest::Cancelled)
+      {
+        req->mResourceDatabase = NULL;
+        continue;
+      }
+      req->mDispatched = true;
+    }
+    if (req->completionCallback())
+      req->completionCallback()->operator()(req);
+    ++count;
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+int LoadWriterManager::pendingLoadCount() const
+{
+  ScopedMutex lock(mMutex);
+  return (int)mQueuedRequests.size() + mLoadingCount;
+}
+//-----------------------------------------------------------------------------
 void LoadWriterManager::registerLoadWriter(ResourceLoadWriter* load_writer)
 {
   ref<ResourceLoadWriter> lowr = load_writer;
@@ -37,6 +37,8 @@
 #include <vlCore/VirtualFile.hpp>
 #include <vlCore/MemoryFile.hpp>
 #include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/IMutex.hpp>
+#include <deque>
 
 namespace vl
 {
@@ -54,26 +56,130 @@ namespace vl
     virtual void operator()(ResourceDatabase* db) = 0;
   };
 
+  class ResourceLoadRequest;
+
+  /** Defines an operation to be executed when an asynchronous load completes, see also LoadWriterManager::loadResourceAsync().
+  The callback is executed by the thread calling LoadWriterManager::dispatchLoadRequests(), usually the one owning the OpenGL context,
+  so that it can safely create GPU resources. */
+  class LoadCompletionCallback: public Object
+  {
+  public:
+    virtual void operator()(ResourceLoadRequest* request) = 0;
+  };
+
+  /** A handle to a resource being loaded asynchronously, returned by LoadWriterManager::loadResourceAsync(). */
+  class VLCORE_EXPORT ResourceLoadRequest: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ResourceLoadRequest, Object)
+
+    friend class LoadWriterManager;
+
+  public:
+    typedef enum
+    {
+      Queued,    //!< Waiting to be picked up by LoadWriterManager::processLoadRequests().
+      Loading,   //!< Being loaded by LoadWriterManager::processLoadRequests().
+      Loaded,    //!< Loaded successfully, see resourceDatabase().
+      Failed,    //!< The resource could not be loaded.
+      Cancelled  //!< Cancelled with cancel() before completing.
+    } EState;
+
+  public:
+    ResourceLoadRequest();
+
+    //! The path of the resource, empty if the request was issued with a VirtualFile.
+    const String& path() const { return mPath; }
+
+    //! The file of the resource, NULL if the request was issued with a path.
+    VirtualFile* file() { return mFile.get(); }
+
+    //! Requests with higher priority are loaded first, can be changed while the request is queued.
+    void setPriority(int priority);
+
+    //! Requests with higher priority are loaded first, can be changed while the request is queued.
+    int priority() const;
+
+    //! The current state of the request.
+    EState state() const;
+
+    //! Returns true if the request has been loaded, has failed or has been cancelled.
+    bool isDone() const { EState s = state(); return s == Loaded || s == Failed || s == Cancelled; }
+
+    //! Cancels the request: a queued request is discarded, the result of a request being loaded or not yet dispatched is dropped.
+    //! The completion callback of a cancelled request is not executed.
+    void cancel();
+
+    //! The loaded resources, valid once the state is Loaded.
+    ResourceDatabase* resourceDatabase() { return mResourceDatabase.get(); }
+
+    //! The loaded resources, valid once the state is Loaded.
+    const ResourceDatabase* resourceDatabase() const { return mResourceDatabase.get(); }
+
+    //! The callback executed by LoadWriterManager::dispatchLoadRequests() once the request has been loaded or has failed.
+    LoadCompletionCallback* completionCallback() { return mCompletionCallback.get(); }
+
+  protected:
+    String mPath;
+    ref<VirtualFile> mFile;
+    ref<ResourceDatabase> mResourceDatabase;
+    ref<LoadCompletionCallback> mCompletionCallback;
+    IMutex* mMutex;
+    int mPriority;
+    EState mState;
+    bool mQuick;
+    bool mDispatched;
+  };
+
   /** The LoadWriterManager class loads and writes resources using the registered ResourceLoadWriter objects.
   You can install a LoadCallback to operate on loaded data or you can install a WriteCallback to operate on the data to be written,
-  using the methods loadCallbacks() and writeCallbacks(). */
+  using the methods loadCallbacks() and writeCallbacks().
+
+  Resources can also be loaded asynchronously with loadResourceAsync(), which queues a ResourceLoadRequest and returns it immediately.
+  The queued requests are loaded in order of priority by processLoadRequests(), meant to be called in a loop by one or more worker
+  threads, and are thread safe as long as a mutex has been installed with setMutex(). The LoadCallback[s] are executed by the loading
+  thread. dispatchLoadRequests() must be called regularly, usually once per frame by the thread owning the OpenGL context, and executes
+  the LoadCompletionCallback of the completed requests. If no worker thread is used dispatchLoadRequests() itself loads
+  loadOnDispatchCount() requests per call.
+  \note When loading from worker threads the ResourceLoadWriter[s], the FileSystem and the reference counting must be thread safe,
+  see VL_ATOMIC_REF_COUNT and Object::setRefCountMutex().
+
+  The registration of groups of ResourceLoadWriter[s] can be deferred with addLazyRegistration() until the first time the
+  load writers are needed, VisualizationLibrary::init() uses it to register the standard plugins. */
   class VLCORE_EXPORT LoadWriterManager: public Object
   {
     VL_INSTRUMENT_CLASS(vl::LoadWriterManager, Object)
 
+  public:
+    //! A function registering a group of ResourceLoadWriter[s] to the given LoadWriterManager, see addLazyRegistration().
+    typedef void (*LazyRegistration)(LoadWriterManager*);
+
   public:
     LoadWriterManager()
     {
       VL_DEBUG_SET_OBJECT_NAME()
+      mLoadingCount = 0;
+      mMutex = NULL;
+      mLoadOnDispatchCount = 1;
     }
 
     void registerLoadWriter(ResourceLoadWriter*);
 
+    //! Defers the given registration function until the registered ResourceLoadWriter objects are first needed,
+    //! i.e. by loadWriters(), findLoader(), findWriter(), loadResource() etc. The registrations are performed in order.
+    void addLazyRegistration(LazyRegistration registration) { mLazyRegistrations.push_back(registration); }
+
+    //! Performs the registrations deferred by addLazyRegistration(), called automatically when the load writers are first needed.
+    //! \note Also called by loadResourceAsync() so that the worker threads never perform it.
+    void performLazyRegistrations() const;
+
+    //! Returns true if some registrations deferred by addLazyRegistration() have not been performed yet.
+    bool lazyRegistrationsPending() const { return !mLazyRegistrations.empty(); }
+
     //! Returns the set of registered ResourceLoadWriter objects
-    std::vector< ref<ResourceLoadWriter> >& loadWriters() { return mLoadWriters; }
+    std::vector< ref<ResourceLoadWriter> >& loadWriters() { performLazyRegistrations(); return mLoadWriters; }
 
     //! Returns the set of registered ResourceLoadWriter objects
-    const std::vector< ref<ResourceLoadWriter> >& loadWriters() const { return mLoadWriters; }
+    const std::vector< ref<ResourceLoadWriter> >& loadWriters() const { performLazyRegistrations(); return mLoadWriters; }
 
     //! Returns the first ResourceLoadWriter of the specified type found.
     template<class T>
@@ -132,10 +238,49 @@ namespace vl
 
     std::vector< ref<WriteCallback> >& writeCallbacks() { return mWriteCallbacks; }
 
+    //! Queues the asynchronous loading of the resource specified by the given path, see processLoadRequests() and dispatchLoadRequests().
+    ref<ResourceLoadRequest> loadResourceAsync(const String& path, int priority=0, LoadCompletionCallback* callback=NULL, bool quick=true);
+
+    //! Queues the asynchronous loading of the resource specified by the given file, see processLoadRequests() and dispatchLoadRequests().
+    ref<ResourceLoadRequest> loadResourceAsync(VirtualFile* file, int priority=0, LoadCompletionCallback* callback=NULL, bool quick=true);
+
+    /** Loads up to \p max_count queued requests, highest priority first. Thread safe if a mutex has been installed with setMutex().
+     * Returns the number of requests loaded or failed. */
+    int processLoadRequests(int max_count=1);
+
+    /** Executes the LoadCompletionCallback of the completed requests, to be called regularly by the thread owning the OpenGL context.
+     * Loads loadOnDispatchCount() requests first. Returns the number of completed requests dispatched. */
+    int dispatchLoadRequests();
+
+    //! Returns the number of asynchronous requests queued or being loaded.
+    int pendingLoadCount() const;
+
+    //! The mutex protecting the request queues, required if processLoadRequests() is called by worker threads. See also vl::IMutex.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex protecting the request queues, required if processLoadRequests() is called by worker threads. See also vl::IMutex.
+    IMutex* mutex() const { return mMutex; }
+
+    //! The number of requests loaded by dispatchLoadRequests() itself, set it to 0 if processLoadRequests() is called by worker threads. Defaults to 1.
+    void setLoadOnDispatchCount(int count) { mLoadOnDispatchCount = count; }
+
+    //! The number of requests loaded by dispatchLoadRequests() itself, set it to 0 if processLoadRequests() is called by worker threads. Defaults to 1.
+    int loadOnDispatchCount() const { return mLoadOnDispatchCount; }
+
+  protected:
+    ref<ResourceLoadRequest> enqueue(ResourceLoadRequest* req, int priority, LoadCompletionCallback* callback, bool quick);
+
   protected:
     std::vector< ref<ResourceLoadWriter> > mLoadWriters;
+    mutable std::vector<LazyRegistration> mLazyRegistrations;
     std::vector< ref<LoadCallback> > mLoadCallbacks;
     std::vector< ref<WriteCallback> > mWriteCallbacks;
+    // shared with the loading threads, protected by mMutex
+    std::deque< ref<ResourceLoadRequest> > mQueuedRequests;
+    std::deque< ref<ResourceLoadRequest> > mCompletedRequests;
+    int mLoadingCount;
+    IMutex* mMutex;
+    int mLoadOnDispatchCount;
   };
 
   //! Returs the default LoadWriterManager used by Visualization Library.
@@ -50,6 +50,8 @@ namespace
     WORD color;
     ScopedColor(WORD c): color(c)
     {
+      if (!color)
+        return;
       HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
       GetConsoleScreenBufferInfo(
         hConsole,
@@ -59,21 +61,29 @@ namespace
     }
     ~ScopedColor()
     {
+      if (!color)
+        return;
       // restore the color
       HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
       SetConsoleTextAttribute(hConsole,screen_info.wAttributes);
     }
   };
-  #define SET_TEXT_COLOR_YELLOW() ScopedColor set_scoped_color(FOREGROUND_RED|FOREGROUND_GREEN|FOREGROUND_INTENSITY);
-  #define SET_TEXT_COLOR_RED()    ScopedColor set_scoped_color(FOREGROUND_RED|FOREGROUND_INTENSITY);
-  #define SET_TEXT_COLOR_PURPLE() ScopedColor set_scoped_color(FOREGROUND_RED|FOREGROUND_BLUE|FOREGROUND_INTENSITY);
-  #define SET_TEXT_COLOR_GREEN() ScopedColor set_scoped_color(FOREGROUND_GREEN|FOREGROUND_INTENSITY);
-  #define SET_TEXT_COLOR_BLUE() ScopedColor set_scoped_color(FOREGROUND_BLUE|FOREGROUND_INTENSITY);
+  typedef WORD TextColor;
+  #define TEXT_COLOR_NONE   0
+  #define TEXT_COLOR_YELLOW (FOREGROUND_RED|FOREGROUND_GREEN|FOREGROUND_INTENSITY)
+  #define TEXT_COLOR_RED    (FOREGROUND_RED|FOREGROUND_INTENSITY)
+  #define TEXT_COLOR_PURPLE (FOREGROUND_RED|FOREGROUND_BLUE|FOREGROUND_INTENSITY)
+  #define TEXT_COLOR_GREEN  (FOREGROUND_GREEN|FOREGROUND_INTENSITY)
+  #define TEXT_COLOR_BLUE   (FOREGROUND_BLUE|FOREGROUND_INTENSITY)
 #else
   struct ScopedColor
   {
-    ScopedColor(const char* color)
+    const char* color;
+    ScopedColor(const char* c): color(c)
     {
+      if (!color)
+        return;
+
       //30 black foreground
       //31 red foreground
       //32 green foreground
@@ -108,82 +118,105 @@ namespace
     }
     ~ScopedColor()
     {
+      if (!color)
+        return;
       // restore normal color
       printf("%s", "\033[0m");
     }
   };
-  #define SET_TEXT_COLOR_YELLOW() ScopedColor set_scoped_color("\033[1;33m");
-  #define SET_TEXT_COLOR_RED()    ScopedColor set_scoped_color("\033[31m");
-  #define SET_TEXT_COLOR_PURPLE() ScopedColor set_scoped_color("\033[1;31m");
-  #define SET_TEXT_COLOR_GREEN()  ScopedColor set_scoped_color("\033[1;32m");
-  #define SET_TEXT_COLOR_BLUE()  ScopedColor set_scoped_color("\033[1;34m");
+  typedef const char* TextColor;
+  #define TEXT_COLOR_NONE   NULL
+  #define TEXT_COLOR_YELLOW "\033[1;33m"
+  #define TEXT_COLOR_RED    "\033[31m"
+  #define TEXT_COLOR_PURPLE "\033[1;31m"
+  #define TEXT_COLOR_GREEN  "\033[1;32m"
+  #define TEXT_COLOR_BLUE   "\033[1;34m"
 #endif
+
+  TextColor levelColor(ELogLevel level)
+  {
+    switch(level)
+    {
+    case LL_LogNotify:  return TEXT_COLOR_GREEN;
+    case LL_LogBug:     return TEXT_COLOR_PURPLE;
+    case LL_LogError:   return TEXT_COLOR_RED;
+    case LL_LogWarning: return TEXT_COLOR_YELLOW;
+    case LL_LogDebug:   return TEXT_COLOR_BLUE;
+    default:            return TEXT_COLOR_NONE;
+    }
+  }
 }
 //-----------------------------------------------------------------------------
 // Log
 //-----------------------------------------------------------------------------
 void Log::notify(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
-
-  SET_TEXT_COLOR_GREEN()
-  if(defLogger() && globalSettings()->verbosityLevel() != vl::VEL_VERBOSITY_SILENT)
-    defLogger()->printImplementation(LL_LogNotify, log);
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogNotify))
+    output(LL_LogNotify, log);
 }
 //-----------------------------------------------------------------------------
 void Log::print(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
-
-  if(defLogger() && globalSettings()->verbosityLevel() != vl::VEL_VERBOSITY_SILENT)
-    defLogger()->printImplementation(LL_LogPrint, log);
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogPrint))
+    output(LL_LogPrint, log);
 }
 //-----------------------------------------------------------------------------
 void Log::debug(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
-
-  SET_TEXT_COLOR_BLUE()
-  if(defLogger() && globalSettings()->verbosityLevel() >= vl::VEL_VERBOSITY_DEBUG)
-    defLogger()->printImplementation(LL_LogDebug, log);
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogDebug))
+    output(LL_LogDebug, log);
 }
 //-----------------------------------------------------------------------------
 void Log::warning(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
-
-  SET_TEXT_COLOR_YELLOW()
-  if(defLogger() && globalSettings()->verbosityLevel() >= vl::VEL_VERBOSITY_ERROR)
-    defLogger()->printImplementation(LL_LogWarning, log);
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogWarning))
+    output(LL_LogWarning, log);
 }
 //-----------------------------------------------------------------------------
 void Log::error(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
-
-  SET_TEXT_COLOR_RED()
-  if(defLogger() && globalSettings()->verbosityLevel() >= vl::VEL_VERBOSITY_ERROR)
-    defLogger()->printImplementation(LL_LogError, log);
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogError))
+    output(LL_LogError, log);
 }
 //-----------------------------------------------------------------------------
 void Log::bug(const String& log)
 {
-  //! Synchronize log across threads.
-  ScopedMutex mutex(Log::logMutex());
+  if(defLogger() && globalSettings()->verbosityLevel() >= requiredVerbosity(LL_LogBug))
+    output(LL_LogBug, log);
+}
+//-----------------------------------------------------------------------------
+EVerbosityLevel Log::requiredVerbosity(ELogLevel level)
+{
+  switch(level)
+  {
+  case LL_LogDebug: return VEL_VERBOSITY_DEBUG;
+  // notify and print messages are generated unless the verbosity is VEL_VERBOSITY_SILENT
+  default:          return VEL_VERBOSITY_ERROR;
+  }
+}
+//-----------------------------------------------------------------------------
+void Log::output(ELogLevel level, const String& log)
+{
+  Log* logger = defLogger();
+  if (!logger)
+    return;
 
-  SET_TEXT_COLOR_PURPLE()
-  if(defLogger() && globalSettings()->verbosityLevel() >= vl::VEL_VERBOSITY_ERROR)
-    defLogger()->printImplementation(LL_LogBug, log);
+  if (logger->isThreadSafe())
+    logger->printImplementation(level, log);
+  else
+  {
+    //! Synchronize log across threads.
+    ScopedMutex mutex(Log::logMutex());
+    logger->printImplementation(level, log);
+  }
 }
 //------------------------------------------------------------------------------
 void vl::log_failed_check(const char* expr, const char* file, int line)
 {
   VL_LOG_ERROR << "Condition '" << expr << "' failed at " << file << ":" << line << "\n";
+  // the program is likely about to crash: make sure the message reaches its destination
+  if (defLogger())
+    defLogger()->flush();
   fflush(stdout);
   fflush(stderr);
 
@@ -197,6 +230,48 @@ void vl::log_failed_check(const char* expr, const char* file, int line)
 //-----------------------------------------------------------------------------
 IMutex* Log::mLogMutex = NULL;
 //-----------------------------------------------------------------------------
+// LogCategory
+//-----------------------------------------------------------------------------
+namespace
+{
+  // categories are usually global objects: a zero-initialized list head is safe to use during static initialization
+  LogCategory* gFirstLogCategory = NULL;
+}
+//-----------------------------------------------------------------------------
+LogCategory::LogCategory(const char* name): mName(name), mVerbosityLevel(-1)
+{
+  mNext = gFirstLogCategory;
+  gFirstLogCategory = this;
+}
+//-----------------------------------------------------------------------------
+LogCategory::~LogCategory()
+{
+  for(LogCategory** cat = &gFirstLogCategory; *cat; cat = &(*cat)->mNext)
+  {
+    if (*cat == this)
+    {
+      *cat = mNext;
+      break;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+EVerbosityLevel LogCategory::verbosityLevel() const
+{
+  if (mVerbosityLevel >= 0)
+    return (EVerbosityLevel)mVerbosityLevel;
+  else
+    return globalSettings() ? globalSettings()->verbosityLevel() : VEL_VERBOSITY_NORMAL;
+}
+//-----------------------------------------------------------------------------
+LogCategory* LogCategory::find(const char* name)
+{
+  for(LogCategory* cat = gFirstLogCategory; cat; cat = cat->mNext)
+    if ( strcmp(cat->name(), name) == 0 )
+      return cat;
+  return NULL;
+}
+//-----------------------------------------------------------------------------
 // StandardLog
 //-----------------------------------------------------------------------------
 void StandardLog::setLogFile(const String& file)
@@ -210,13 +285,16 @@ void StandardLog::setLogFile(const String& file)
     mFile.open(file.toStdString().c_str());
 }
 //-----------------------------------------------------------------------------
-void StandardLog::printImplementation(ELogLevel, const String& log)
+void StandardLog::printImplementation(ELogLevel level, const String& log)
 {
   if (log.empty())
     return;
 
   std::string stdstr = log.toStdString();
-  std::cout << stdstr << std::flush;
+  {
+    ScopedColor set_scoped_color( levelColor(level) );
+    std::cout << stdstr << std::flush;
+  }
 
   if (mFile.is_open())
     mFile << stdstr << std::flush;
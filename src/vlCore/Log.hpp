@@ -159,11 +159,20 @@ namespace vl
       return *this;
     }
 
+    /** Returns true if printImplementation() can be called concurrently by multiple threads, in which case
+      * the logMutex() is not locked when dispatching the messages to this logger. See also AsyncLog. */
+    virtual bool isThreadSafe() const { return false; }
+
+    /** Waits until all the messages received so far have been written out. Does nothing for synchronous loggers. */
+    virtual void flush() {}
+
   protected:
     virtual void printImplementation(ELogLevel level, const String& message) = 0;
 
     ELogLevel mLogLevel; // only used by operator<<()
 
+    friend class AsyncLog;
+
     // ---  static methods ---
 
   public:
@@ -199,10 +208,69 @@ namespace vl
       * \note Log generated only if verbosity level >= vl::VEL_VERBOSITY_ERROR */
     static void bug(const String& message);
 
+    /** Sends a message to the defLogger() without checking the verbosity level, used by the VL_LOG_CATEGORY_* macros. */
+    static void output(ELogLevel level, const String& message);
+
+    /** The minimum verbosity level at which messages of the given level are generated. */
+    static EVerbosityLevel requiredVerbosity(ELogLevel level);
+
   private:
     static IMutex* mLogMutex;
   };
 
+  //-----------------------------------------------------------------------------
+  // LogCategory
+  //-----------------------------------------------------------------------------
+  /**
+   * A named group of log messages with its own verbosity level, which by default follows the global one (see GlobalSettings::verbosityLevel()).
+   * Categories are meant to be declared as global objects and used with the VL_LOG_CATEGORY_* macros, for example:
+   * \code
+   * static vl::LogCategory gLogStreaming("Streaming");
+   * ...
+   * VL_LOG_CATEGORY_DEBUG( gLogStreaming, Say("Tile %n loaded\n") << tile_id );
+   * VL_LOG_CATEGORY_WARNING( gLogStreaming, "Tile cache full!\n" );
+   * ...
+   * // silence a noisy category or get more details just from it
+   * vl::LogCategory::find("Streaming")->setVerbosityLevel(vl::VEL_VERBOSITY_DEBUG);
+   * \endcode
+   * The message expression is evaluated only if the category is enabled for the given level.
+   * VL_LOG_CATEGORY_DEBUG() compiles to nothing in release builds (\p NDEBUG defined) unless VL_LOG_CATEGORY_DEBUG_IN_RELEASE is defined.
+   */
+  class VLCORE_EXPORT LogCategory
+  {
+  public:
+    /** Constructor. \p name must outlive the category, typically it is a string literal. */
+    LogCategory(const char* name);
+
+    ~LogCategory();
+
+    const char* name() const { return mName; }
+
+    /** Overrides the global verbosity level for this category. */
+    void setVerbosityLevel(EVerbosityLevel level) { mVerbosityLevel = level; }
+
+    /** Makes the category follow again the global verbosity level. */
+    void resetVerbosityLevel() { mVerbosityLevel = -1; }
+
+    /** The verbosity level of the category: its own if set with setVerbosityLevel(), the global one otherwise. */
+    EVerbosityLevel verbosityLevel() const;
+
+    /** Returns true if messages of the given level are generated for this category. */
+    bool enabled(ELogLevel level) const { return verbosityLevel() >= Log::requiredVerbosity(level); }
+
+    /** Returns the category with the given name or NULL. */
+    static LogCategory* find(const char* name);
+
+  private:
+    LogCategory(const LogCategory&);
+    LogCategory& operator=(const LogCategory&);
+
+  private:
+    const char* mName;
+    int mVerbosityLevel;
+    LogCategory* mNext;
+  };
+
   //-----------------------------------------------------------------------------
   // Default logger
   //-----------------------------------------------------------------------------
@@ -221,6 +289,19 @@ namespace vl
   #define VL_LOG_WARNING (VL_LOG << ::vl::LL_LogWarning)
   #define VL_LOG_DEBUG (VL_LOG << ::vl::LL_LogDebug)
 
+  // Log category macros, see LogCategory
+  #define VL_LOG_CATEGORY_MESSAGE(category, level, message) { if ( (category).enabled(level) ) ::vl::Log::output(level, message); }
+  #define VL_LOG_CATEGORY_NOTIFY(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogNotify, message)
+  #define VL_LOG_CATEGORY_PRINT(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogPrint, message)
+  #define VL_LOG_CATEGORY_BUG(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogBug, message)
+  #define VL_LOG_CATEGORY_ERROR(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogError, message)
+  #define VL_LOG_CATEGORY_WARNING(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogWarning, message)
+  #if defined(_DEBUG) || !defined(NDEBUG) || defined(VL_LOG_CATEGORY_DEBUG_IN_RELEASE)
+    #define VL_LOG_CATEGORY_DEBUG(category, message) VL_LOG_CATEGORY_MESSAGE(category, ::vl::LL_LogDebug, message)
+  #else
+    #define VL_LOG_CATEGORY_DEBUG(category, message) {}
+  #endif
+
   //-----------------------------------------------------------------------------
   // StandardLog
   //-----------------------------------------------------------------------------
@@ -0,0 +1,283 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/MappedFile.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <string.h>
+
+#if !defined(VL_PLATFORM_WINDOWS)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// FileMapping
+//-----------------------------------------------------------------------------
+FileMapping::FileMapping()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mPtr = NULL;
+  mSize = 0;
+  mMapped = false;
+}
+//-----------------------------------------------------------------------------
+FileMapping::~FileMapping()
+{
+  unmap();
+}
+//-----------------------------------------------------------------------------
+bool FileMapping::map(const String& path)
+{
+  unmap();
+
+#if defined(VL_PLATFORM_WINDOWS)
+  HANDLE file = CreateFile( (const wchar_t*)path.ptr(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    Log::error( Say("FileMapping::map(): error opening file '%s'\n") << path );
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if ( !GetFileSizeEx(file, &file_size) )
+  {
+    Log::error( Say("FileMapping::map(): could not read the size of file '%s'\n") << path );
+    CloseHandle(file);
+    return false;
+  }
+
+  if (file_size.QuadPart)
+  {
+    // copy-on-write mapping: written pages become private to the process
+    HANDLE mapping = CreateFileMapping( file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+    if (mapping)
+    {
+      mPtr = (unsigned char*)MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+      // the view keeps the mapping alive
+      CloseHandle(mapping);
+    }
+    if (!mPtr)
+    {
+      Log::error( Say("FileMapping::map(): could not map file '%s'\n") << path );
+      CloseHandle(file);
+      return false;
+    }
+  }
+  CloseHandle(file);
+  mSize = file_size.QuadPart;
+#else
+  // encode to utf8 for linux
+  std::vector<unsigned char> utf8;
+  path.toUTF8( utf8, false );
+  if (utf8.empty())
+    return false;
+
+  int fd = ::open( (char*)&utf8[0], O_RDONLY );
+  if (fd == -1)
+  {
+    Log::error( Say("FileMapping::map(): error opening file '%s'\n") << path );
+    return false;
+  }
+
+  struct stat st;
+  if ( fstat(fd, &st) == -1 )
+  {
+    Log::error( Say("FileMapping::map(): could not read the size of file '%s'\n") << path );
+    ::close(fd);
+    return false;
+  }
+
+  if (st.st_size)
+  {
+    // private mapping: written pages are copied on write and never reach the file
+    void* ptr = mmap( NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    if (ptr == MAP_FAILED)
+    {
+      Log::error( Say("FileMapping::map(): could not map file '%s'\n") << path );
+      ::close(fd);
+      return false;
+    }
+    mPtr = (unsigned char*)ptr;
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+  mSize = (long long)st.st_size;
+#endif
+
+  mMapped = true;
+  return true;
+}
+//-----------------------------------------------------------------------------
+void FileMapping::unmap()
+{
+  if (mPtr)
+  {
+  #if defined(VL_PLATFORM_WINDOWS)
+    UnmapViewOfFile(mPtr);
+  #else
+    munmap(mPtr, (size_t)mSize);
+  #endif
+  }
+  mPtr = NULL;
+  mSize = 0;
+  mMapped = false;
+}
+//-----------------------------------------------------------------------------
+// MappedFile
+//-----------------------------------------------------------------------------
+MappedFile::MappedFile(const String& path): DiskFile(path)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mPosition = 0;
+}
+//-----------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+  close();
+}
+//-----------------------------------------------------------------------------
+bool MappedFile::open(const String& path, EOpenMode mode)
+{
+  setPath(path);
+  return open(mode);
+}
+//-----------------------------------------------------------------------------
+bool MappedFile::open(EOpenMode mode)
+{
+  if ( isOpen() )
+  {
+    Log::error("MappedFile::open(): file already open.\n");
+    return false;
+  }
+
+  if (mode != OM_ReadOnly)
+  {
+    Log::error( Say("MappedFile::open(): '%s' can only be opened in OM_ReadOnly mode.\n") << path() );
+    return false;
+  }
+
+  ref<FileMapping> mapping = new FileMapping;
+  if ( !mapping->map( path() ) )
+    return false;
+
+  mMapping = mapping;
+  mPosition = 0;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool MappedFile::isOpen() const
+{
+  return mMapping.get() != NULL;
+}
+//-----------------------------------------------------------------------------
+void MappedFile::close()
+{
+  mMapping = NULL;
+  mPosition = 0;
+}
+//-----------------------------------------------------------------------------
+long long MappedFile::size() const
+{
+  return mMapping ? mMapping->size() : DiskFile::size();
+}
+//-----------------------------------------------------------------------------
+unsigned char* MappedFile::mappedPtr(long long offset, long long byte_count)
+{
+  if ( !mMapping || offset < 0 || byte_count < 0 || offset + byte_count > mMapping->size() )
+    return NULL;
+  return mMapping->ptr() + offset;
+}
+//-----------------------------------------------------------------------------
+const unsigned char* MappedFile::mappedPtr(long long offset, long long byte_count) const
+{
+  if ( !mMapping || offset < 0 || byte_count < 0 || offset + byte_count > mMapping->size() )
+    return NULL;
+  return mMapping->ptr() + offset;
+}
+//-----------------------------------------------------------------------------
+long long MappedFile::read_Implementation(void* buffer, long long byte_count)
+{
+  if (!mMapping)
+  {
+    Log::error("MappedFile::read_Implementation() called on closed file!\n");
+    return 0;
+  }
+
+  long long left = mMapping->size() - mPosition;
+  long long count = byte_count < left ? byte_count : left;
+  if (count <= 0)
+    return 0;
+  memcpy( buffer, mMapping->ptr() + mPosition, (size_t)count );
+  mPosition += count;
+  return count;
+}
+//-----------------------------------------------------------------------------
+long long MappedFile::write_Implementation(const void*, long long)
+{
+  Log::error( Say("MappedFile::write_Implementation(): '%s' is read-only.\n") << path() );
+  return 0;
+}
+//-----------------------------------------------------------------------------
+long long MappedFile::position_Implementation() const
+{
+  if (!mMapping)
+  {
+    Log::error("MappedFile::position_Implementation() called on closed file!\n");
+    return -1;
+  }
+  return mPosition;
+}
+//-----------------------------------------------------------------------------
+bool MappedFile::seekSet_Implementation(long long offset)
+{
+  if (!mMapping)
+  {
+    Log::error("MappedFile::seekSet_Implementation() called on closed file!\n");
+    return false;
+  }
+  if ( offset < 0 || offset > mMapping->size() )
+    return false;
+  mPosition = offset;
+  return true;
+}
+//-----------------------------------------------------------------------------
+ref<VirtualFile> MappedFile::clone() const
+{
+  ref<MappedFile> file = new MappedFile;
+  file->operator=(*this);
+  return file;
+}
+//-----------------------------------------------------------------------------
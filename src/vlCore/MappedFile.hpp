@@ -0,0 +1,165 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef MappedFile_INCLUDE_ONCE
+#define MappedFile_INCLUDE_ONCE
+
+#include <vlCore/DiskFile.hpp>
+
+namespace vl
+{
+//---------------------------------------------------------------------------
+// FileMapping
+//---------------------------------------------------------------------------
+  /**
+   * A read-only, copy-on-write memory mapping of a whole disk file.
+   *
+   * The mapped pages are private to the process: they can be modified without affecting the file on disk,
+   * which allows them to be used directly as Buffer or Image storage. The mapping stays valid as long as the
+   * FileMapping object is alive, independently of the MappedFile that created it.
+   *
+   * \sa MappedFile, Buffer::setUserAllocatedBuffer()
+  */
+  class VLCORE_EXPORT FileMapping: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::FileMapping, Object)
+
+  public:
+    FileMapping();
+
+    ~FileMapping();
+
+    //! Maps the whole file at the given path, returns false on error.
+    bool map(const String& path);
+
+    //! Releases the mapping.
+    void unmap();
+
+    //! Returns true if a file is currently mapped.
+    bool isMapped() const { return mMapped; }
+
+    //! The first byte of the mapping.
+    unsigned char* ptr() { return mPtr; }
+
+    //! The first byte of the mapping.
+    const unsigned char* ptr() const { return mPtr; }
+
+    //! The size in bytes of the mapping.
+    long long size() const { return mSize; }
+
+  private:
+    FileMapping(const FileMapping&);
+    FileMapping& operator=(const FileMapping&);
+
+  private:
+    unsigned char* mPtr;
+    long long mSize;
+    bool mMapped;
+  };
+
+//---------------------------------------------------------------------------
+// MappedFile
+//---------------------------------------------------------------------------
+  /**
+   * A read-only DiskFile that memory maps the file instead of reading it through the C runtime.
+   *
+   * Reads are served directly from the mapped pages and loaders can obtain a pointer to any range of the
+   * file with mappedPtr() to use it as storage without copying, as loadRAW() does when given a MappedFile.
+   * Use FileSystem::setMemoryMappedFiles() to have the default FileSystem return MappedFile objects.
+   *
+   * \sa
+   * - FileMapping
+   * - DiskFile
+   * - VirtualFile
+   * - FileSystem
+  */
+  class VLCORE_EXPORT MappedFile: public DiskFile
+  {
+    VL_INSTRUMENT_CLASS(vl::MappedFile, DiskFile)
+
+  protected:
+    MappedFile(const MappedFile& other): DiskFile(other), mPosition(0) {}
+
+  public:
+    MappedFile(const String& path = String());
+
+    ~MappedFile();
+
+    //! The specified path is relative to the parent directory. See setPhysicalPath().
+    bool open(const String& path, EOpenMode mode);
+
+    //! Only OM_ReadOnly is supported.
+    virtual bool open(EOpenMode mode);
+
+    virtual bool isOpen() const;
+
+    //! Closes the file. The mapping is released once no Buffer refers to it anymore.
+    virtual void close();
+
+    //! Returns the file size in bytes or -1 on error.
+    virtual long long size() const;
+
+    MappedFile& operator=(const MappedFile& other) { close(); super::operator=(other); return *this; }
+
+    virtual ref<VirtualFile> clone() const;
+
+    //! Returns a pointer to the \p byte_count bytes starting at \p offset, or NULL if the file is not open
+    //! or the range exceeds the file size. The pointer is valid as long as mapping() is alive.
+    unsigned char* mappedPtr(long long offset, long long byte_count);
+
+    //! Returns a pointer to the \p byte_count bytes starting at \p offset, or NULL if the file is not open
+    //! or the range exceeds the file size. The pointer is valid as long as mapping() is alive.
+    const unsigned char* mappedPtr(long long offset, long long byte_count) const;
+
+    //! The mapping of the currently open file, NULL if the file is not open.
+    //! Keep a reference to it to use the mapped pages after the file is closed.
+    FileMapping* mapping() { return mMapping.get(); }
+
+    //! The mapping of the currently open file, NULL if the file is not open.
+    const FileMapping* mapping() const { return mMapping.get(); }
+
+  protected:
+    virtual long long read_Implementation(void* buffer, long long byte_count);
+
+    virtual long long write_Implementation(const void* buffer, long long byte_count);
+
+    virtual long long position_Implementation() const;
+
+    virtual bool seekSet_Implementation(long long offset);
+
+  protected:
+    ref<FileMapping> mMapping;
+    long long mPosition;
+  };
+
+}
+
+#endif
@@ -34,6 +34,7 @@
 
 #include <vlCore/Vector4.hpp>
 #include <vlCore/Matrix3.hpp>
+#include <vlCore/SIMD.hpp>
 
 namespace vl
 {
@@ -667,6 +668,102 @@ namespace vl
   protected:
     Vector4<T_Scalar> mVec[4];
   };
+  //-----------------------------------------------------------------------------
+  // SIMD SPECIALIZATIONS
+  //-----------------------------------------------------------------------------
+  // The products are accumulated in the same order as the generic implementation
+  // so that the results do not depend on VL_SIMD.
+#if defined(VL_SIMD_SSE2) || defined(VL_SIMD_NEON)
+  template<>
+  inline Matrix4<float>& Matrix4<float>::multiply(Matrix4<float>& out, const Matrix4<float>& p, const Matrix4<float>& q)
+  {
+    VL_CHECK(out.ptr() != p.ptr() && out.ptr() != q.ptr());
+
+    const float* pp = p.ptr();
+    const float* qq = q.ptr();
+    float* oo = out.ptr();
+  #if defined(VL_SIMD_SSE2)
+    const __m128 p0 = _mm_loadu_ps(pp+0);
+    const __m128 p1 = _mm_loadu_ps(pp+4);
+    const __m128 p2 = _mm_loadu_ps(pp+8);
+    const __m128 p3 = _mm_loadu_ps(pp+12);
+    for(int j=0; j<4; ++j, qq+=4, oo+=4)
+    {
+      __m128 r = _mm_mul_ps(p0, _mm_set1_ps(qq[0]));
+      r = _mm_add_ps(r, _mm_mul_ps(p1, _mm_set1_ps(qq[1])));
+      r = _mm_add_ps(r, _mm_mul_ps(p2, _mm_set1_ps(qq[2])));
+      r = _mm_add_ps(r, _mm_mul_ps(p3, _mm_set1_ps(qq[3])));
+      _mm_storeu_ps(oo, r);
+    }
+  #else
+    const float32x4_t p0 = vld1q_f32(pp+0);
+    const float32x4_t p1 = vld1q_f32(pp+4);
+    const float32x4_t p2 = vld1q_f32(pp+8);
+    const float32x4_t p3 = vld1q_f32(pp+12);
+    for(int j=0; j<4; ++j, qq+=4, oo+=4)
+    {
+      float32x4_t r = vmulq_n_f32(p0, qq[0]);
+      r = vaddq_f32(r, vmulq_n_f32(p1, qq[1]));
+      r = vaddq_f32(r, vmulq_n_f32(p2, qq[2]));
+      r = vaddq_f32(r, vmulq_n_f32(p3, qq[3]));
+      vst1q_f32(oo, r);
+    }
+  #endif
+    return out;
+  }
+#endif
+  //-----------------------------------------------------------------------------
+#if defined(VL_SIMD_SSE2) || defined(VL_SIMD_NEON64)
+  template<>
+  inline Matrix4<double>& Matrix4<double>::multiply(Matrix4<double>& out, const Matrix4<double>& p, const Matrix4<double>& q)
+  {
+    VL_CHECK(out.ptr() != p.ptr() && out.ptr() != q.ptr());
+
+    const double* pp = p.ptr();
+    const double* qq = q.ptr();
+    double* oo = out.ptr();
+  #if defined(VL_SIMD_AVX)
+    const __m256d p0 = _mm256_loadu_pd(pp+0);
+    const __m256d p1 = _mm256_loadu_pd(pp+4);
+    const __m256d p2 = _mm256_loadu_pd(pp+8);
+    const __m256d p3 = _mm256_loadu_pd(pp+12);
+    for(int j=0; j<4; ++j, qq+=4, oo+=4)
+    {
+      __m256d r = _mm256_mul_pd(p0, _mm256_set1_pd(qq[0]));
+      r = _mm256_add_pd(r, _mm256_mul_pd(p1, _mm256_set1_pd(qq[1])));
+      r = _mm256_add_pd(r, _mm256_mul_pd(p2, _mm256_set1_pd(qq[2])));
+      r = _mm256_add_pd(r, _mm256_mul_pd(p3, _mm256_set1_pd(qq[3])));
+      _mm256_storeu_pd(oo, r);
+    }
+  #elif defined(VL_SIMD_SSE2)
+    // each column is processed as two halves: rows 0-1 and rows 2-3
+    for(int j=0; j<4; ++j, qq+=4, oo+=4)
+    {
+      for(int h=0; h<4; h+=2)
+      {
+        __m128d r = _mm_mul_pd(_mm_loadu_pd(pp+h+0), _mm_set1_pd(qq[0]));
+        r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(pp+h+4),  _mm_set1_pd(qq[1])));
+        r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(pp+h+8),  _mm_set1_pd(qq[2])));
+        r = _mm_add_pd(r, _mm_mul_pd(_mm_loadu_pd(pp+h+12), _mm_set1_pd(qq[3])));
+        _mm_storeu_pd(oo+h, r);
+      }
+    }
+  #else
+    for(int j=0; j<4; ++j, qq+=4, oo+=4)
+    {
+      for(int h=0; h<4; h+=2)
+      {
+        float64x2_t r = vmulq_n_f64(vld1q_f64(pp+h+0), qq[0]);
+        r = vaddq_f64(r, vmulq_n_f64(vld1q_f64(pp+h+4),  qq[1]));
+        r = vaddq_f64(r, vmulq_n_f64(vld1q_f64(pp+h+8),  qq[2]));
+        r = vaddq_f64(r, vmulq_n_f64(vld1q_f64(pp+h+12), qq[3]));
+        vst1q_f64(oo+h, r);
+      }
+    }
+  #endif
+    return out;
+  }
+#endif
   //-----------------------------------------------------------------------------
   // OPERATORS
   //-----------------------------------------------------------------------------
@@ -702,6 +799,30 @@ namespace vl
    );
   }
   //-----------------------------------------------------------------------------
+#if defined(VL_SIMD_SSE2) || defined(VL_SIMD_NEON)
+  //! Post multiplication: matrix * column vector, SIMD version
+  template<>
+  inline Vector4<float> operator*(const Matrix4<float>& m, const Vector4<float>& v)
+  {
+    Vector4<float> r;
+    const float* mm = m.ptr();
+  #if defined(VL_SIMD_SSE2)
+    __m128 t = _mm_mul_ps(_mm_loadu_ps(mm+0), _mm_set1_ps(v.x()));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(mm+4),  _mm_set1_ps(v.y())));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(mm+8),  _mm_set1_ps(v.z())));
+    t = _mm_add_ps(t, _mm_mul_ps(_mm_loadu_ps(mm+12), _mm_set1_ps(v.w())));
+    _mm_storeu_ps(r.ptr(), t);
+  #else
+    float32x4_t t = vmulq_n_f32(vld1q_f32(mm+0), v.x());
+    t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(mm+4),  v.y()));
+    t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(mm+8),  v.z()));
+    t = vaddq_f32(t, vmulq_n_f32(vld1q_f32(mm+12), v.w()));
+    vst1q_f32(r.ptr(), t);
+  #endif
+    return r;
+  }
+#endif
+  //-----------------------------------------------------------------------------
   //! Post multiplication: matrix * column vector
   //! The incoming vector is considered a Vector4<T_Scalar> with the component w = 1
   template<typename T_Scalar>
@@ -0,0 +1,181 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlCore/MemoryTracker.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+#ifdef VL_ATOMIC_REF_COUNT
+  #include <atomic>
+#endif
+
+#ifdef VL_COUNT_ALLOCATIONS
+  #include <new>
+  #include <cstdlib>
+#endif
+
+using namespace vl;
+
+namespace
+{
+#ifdef VL_ATOMIC_REF_COUNT
+  typedef std::atomic<long long> Counter;
+#else
+  typedef long long Counter;
+#endif
+
+  Counter gBytes[MC_MemoryCategoryCount];
+  Counter gPeakBytes[MC_MemoryCategoryCount];
+  Counter gObjects[MC_MemoryCategoryCount];
+#ifdef VL_COUNT_ALLOCATIONS
+  Counter gAllocations;
+#endif
+}
+//-----------------------------------------------------------------------------
+// global operator new and delete
+//-----------------------------------------------------------------------------
+#ifdef VL_COUNT_ALLOCATIONS
+  #if __cplusplus >= 201103L
+    #define VL_NEW_THROW
+    #define VL_NOTHROW noexcept
+  #else
+    #define VL_NEW_THROW throw(std::bad_alloc)
+    #define VL_NOTHROW throw()
+  #endif
+namespace
+{
+  void* countedAlloc(size_t bytes)
+  {
+    ++gAllocations;
+    return malloc( bytes ? bytes : 1 );
+  }
+}
+void* operator new(size_t bytes) VL_NEW_THROW
+{
+  void* ptr = countedAlloc(bytes);
+  if ( !ptr )
+    throw std::bad_alloc();
+  return ptr;
+}
+void* operator new[](size_t bytes) VL_NEW_THROW
+{
+  void* ptr = countedAlloc(bytes);
+  if ( !ptr )
+    throw std::bad_alloc();
+  return ptr;
+}
+void* operator new(size_t bytes, const std::nothrow_t&) VL_NOTHROW { return countedAlloc(bytes); }
+void* operator new[](size_t bytes, const std::nothrow_t&) VL_NOTHROW { return countedAlloc(bytes); }
+void operator delete(void* ptr) VL_NOTHROW { free(ptr); }
+void operator delete[](void* ptr) VL_NOTHROW { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) VL_NOTHROW { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) VL_NOTHROW { free(ptr); }
+#endif
+//-----------------------------------------------------------------------------
+// MemoryTracker
+//-----------------------------------------------------------------------------
+void MemoryTracker::track(EMemoryCategory category, long long bytes, int objects)
+{
+  VL_CHECK( category >= 0 && category < MC_MemoryCategoryCount )
+  long long total = gBytes[category] += bytes;
+  gObjects[category] += objects;
+#ifdef VL_ATOMIC_REF_COUNT
+  long long peak = gPeakBytes[category];
+  while( total > peak && ! gPeakBytes[category].compare_exchange_weak(peak, total) ) {}
+#else
+  if ( total > gPeakBytes[category] )
+    gPeakBytes[category] = total;
+#endif
+}
+//-----------------------------------------------------------------------------
+long long MemoryTracker::bytes(EMemoryCategory category)
+{
+  return gBytes[category];
+}
+//-----------------------------------------------------------------------------
+long long MemoryTracker::peakBytes(EMemoryCategory category)
+{
+  return gPeakBytes[category];
+}
+//-----------------------------------------------------------------------------
+long long MemoryTracker::objects(EMemoryCategory category)
+{
+  return gObjects[category];
+}
+//-----------------------------------------------------------------------------
+void MemoryTracker::resetPeaks()
+{
+  for(int i=0; i<MC_MemoryCategoryCount; ++i)
+    gPeakBytes[i] = (long long)gBytes[i];
+}
+//-----------------------------------------------------------------------------
+const char* MemoryTracker::categoryName(EMemoryCategory category)
+{
+  switch(category)
+  {
+  case MC_Buffer:       return "Buffer";
+  case MC_Image:        return "Image";
+  case MC_BufferObject: return "BufferObject";
+  case MC_Texture:      return "Texture";
+  case MC_DisplayList:  return "DisplayList";
+  default:              return "Unknown";
+  }
+}
+//-----------------------------------------------------------------------------
+long long MemoryTracker::allocationCount()
+{
+#ifdef VL_COUNT_ALLOCATIONS
+  return gAllocations;
+#else
+  return 0;
+#endif
+}
+//-----------------------------------------------------------------------------
+bool MemoryTracker::isCountingAllocations()
+{
+#ifdef VL_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+void MemoryTracker::print()
+{
+  for(int i=0; i<MC_MemoryCategoryCount; ++i)
+  {
+    EMemoryCategory cat = (EMemoryCategory)i;
+    Log::print( Say("%s: %n bytes, peak %n bytes, %n objects\n") << categoryName(cat) << bytes(cat) << peakBytes(cat) << objects(cat) );
+  }
+  Log::print( Say("RAM: %n bytes, GPU: %n bytes\n") << ramBytes() << gpuBytes() );
+}
+//-----------------------------------------------------------------------------
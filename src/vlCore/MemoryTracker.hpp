@@ -0,0 +1,96 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef MemoryTracker_INCLUDE_ONCE
+#define MemoryTracker_INCLUDE_ONCE
+
+#include <vlCore/link_config.hpp>
+#include <vlCore/vlnamespace.hpp>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // MemoryTracker
+  //-----------------------------------------------------------------------------
+  /**
+   * Keeps a running count of the bytes and of the objects allocated by Visualization Library in RAM and on the GPU, per EMemoryCategory.
+   *
+   * The counters are updated by the classes owning the memory:
+   * - MC_Buffer and MC_Image: Buffer, when allocating or releasing its heap storage (user-allocated and arena-allocated storage is not counted).
+   *   Image tags its buffer with MC_Image, see Buffer::setMemoryCategory().
+   * - MC_BufferObject: BufferObject and BufferObjectPool, when allocating or deleting OpenGL buffers.
+   * - MC_Texture: Texture, when creating or destroying the texture. The size is estimated from dimensions and format, a full mipmap chain adds a third.
+   * - MC_DisplayList: Renderable, when compiling or deleting its display list. Only the number of display lists is known.
+   *
+   * The counters are atomic if Visualization Library is built with VL_ATOMIC_REF_COUNT. ResidencyManager uses them to enforce its budgets.
+   */
+  class VLCORE_EXPORT MemoryTracker
+  {
+  public:
+    //! Adds \p bytes bytes (negative to subtract) and \p objects objects to the given category.
+    static void track(EMemoryCategory category, long long bytes, int objects=0);
+
+    //! The bytes currently allocated in the given category.
+    static long long bytes(EMemoryCategory category);
+
+    //! The highest value reached by bytes() since the start of the application or the last resetPeaks().
+    static long long peakBytes(EMemoryCategory category);
+
+    //! The number of objects currently owning memory in the given category.
+    static long long objects(EMemoryCategory category);
+
+    //! Bytes allocated in RAM: MC_Buffer + MC_Image.
+    static long long ramBytes() { return bytes(MC_Buffer) + bytes(MC_Image); }
+
+    //! Bytes allocated on the GPU: MC_BufferObject + MC_Texture.
+    static long long gpuBytes() { return bytes(MC_BufferObject) + bytes(MC_Texture); }
+
+    //! Sets peakBytes() to bytes() for all the categories.
+    static void resetPeaks();
+
+    //! Returns the name of a category, for example "Texture".
+    static const char* categoryName(EMemoryCategory category);
+
+    //! Prints a table of bytes, peaks and objects per category with Log::print().
+    static void print();
+
+    //! The number of calls to the global operator new since the start of the application, by any thread.
+    //! Always 0 unless Visualization Library is built with VL_COUNT_ALLOCATIONS, see isCountingAllocations().
+    //! Comparing the values before and after Rendering::render() tells if a frame allocates.
+    static long long allocationCount();
+
+    //! True if Visualization Library is built with VL_COUNT_ALLOCATIONS.
+    static bool isCountingAllocations();
+  };
+}
+
+#endif
@@ -44,12 +44,12 @@ using namespace vl;
 //------------------------------------------------------------------------------
 Object::~Object()
 {
-  if (mReferenceCount && !automaticDelete())
+  if (referenceCount() && !automaticDelete())
     Log::bug(Say(
     "Object '%s' is being deleted having still %n references! Pissible causes:\n"
     "- illegal use of the 'delete' operator on an Object. Use ref<> instead.\n"
     "- explicit call to Object::incReference().\n"
-    ) << mObjectName << mReferenceCount );
+    ) << mObjectName << referenceCount() );
 
 #if VL_DEBUG_LIVING_OBJECTS
   debug_living_objects()->erase(this);
@@ -41,6 +41,14 @@
   #include <set>
 #endif
 
+#ifdef VL_ATOMIC_REF_COUNT
+  #include <atomic>
+#endif
+
+#ifdef VL_OBJECT_POOL
+  #include <vlCore/SmallObjectPool.hpp>
+#endif
+
 namespace vl
 {
   //------------------------------------------------------------------------------
@@ -49,6 +57,8 @@ namespace vl
   /**
    * The ref<> class is used to reference-count an Object.
    * When the last ref<> that points to an Object is deallocated also the pointed Object is deallocated.
+   * With C++11 compilers ref<> is also movable so that reallocating or sorting a \p std::vector of ref<> and returning
+   * ref<> by value don't touch the reference counts, with C++98 compilers \p std::sort uses the non-counting swap().
    * @note IMPORTANT: assigning to a ref<> 'washes aways' the constness of an object.
    */
   template<class T>
@@ -75,6 +85,29 @@ namespace vl
       *this = other;
     }
 
+#if VL_HAS_MOVE_SEMANTICS
+    //! Move constructor: steals the reference of \p other without changing the reference count.
+    ref(ref&& other) VL_NOEXCEPT
+    {
+      mObject = other.mObject;
+      other.mObject = NULL;
+    }
+
+    //! Move operator: steals the reference of \p other without changing its reference count.
+    ref& operator=(ref&& other) VL_NOEXCEPT
+    {
+      if (this != &other)
+      {
+        T* old = mObject;
+        mObject = other.mObject;
+        other.mObject = NULL;
+        if (old)
+          old->decReference();
+      }
+      return *this;
+    }
+#endif
+
     ~ref()
     {
       if (mObject)
@@ -115,10 +148,11 @@ namespace vl
       return *this;
     }
 
-    void swap(ref& other)
+    //! Exchanges the pointed objects without changing their reference counts.
+    void swap(ref& other) VL_NOEXCEPT
     {
       T* tmp = other.mObject;
-      other = mObject;
+      other.mObject = mObject;
       mObject = tmp;
     }
 
@@ -147,6 +181,8 @@ namespace vl
   template<class T1, class T2> inline bool operator!=(const ref<T1> & o1, T2 * o2) { return o1.get() != o2; }
   template<class T1, class T2> inline bool operator==(T1 * o1, const ref<T2> & o2) { return o1 == o2.get(); }
   template<class T1, class T2> inline bool operator!=(T1 * o1, const ref<T2> & o2) { return o1 != o2.get(); }
+  // found by argument dependent lookup from std::sort, std::iter_swap etc.
+  template<class T> inline void swap(ref<T>& a, ref<T>& b) VL_NOEXCEPT { a.swap(b); }
 
   //------------------------------------------------------------------------------
   // Object
@@ -223,6 +259,7 @@ namespace vl
     void setObjectName(const std::string& name) { mObjectName = name; }
 
     //! The mutex used to protect the reference counting of an Object across multiple threads.
+    //! \note Not used when VL is built with VL_ATOMIC_REF_COUNT since the reference count is already thread-safe.
     void setRefCountMutex(IMutex* mutex) { mRefCountMutex = mutex; }
 
     //! The mutex used to protect the reference counting of an Object across multiple threads.
@@ -234,9 +271,30 @@ namespace vl
     //! Returns the number of references of an object.
     int referenceCount() const
     {
+    #ifdef VL_ATOMIC_REF_COUNT
+      return mReferenceCount.load( std::memory_order_relaxed );
+    #else
       return mReferenceCount;
+    #endif
     }
 
+#ifdef VL_ATOMIC_REF_COUNT
+    //! Increments the reference count of an object.
+    void incReference() const
+    {
+      // a new reference can only be made from an existing one, so no ordering is required.
+      mReferenceCount.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    //! Decrements the reference count of an object and deletes it if both automaticDelete() is \p true the count reaches 0.
+    void decReference()
+    {
+      VL_CHECK(referenceCount())
+      // acquire-release makes the writes done through the other references visible to the thread deleting the object.
+      if ( mReferenceCount.fetch_sub( 1, std::memory_order_acq_rel ) == 1 && automaticDelete() )
+        delete this;
+    }
+#else
     //! Increments the reference count of an object.
     void incReference() const
     {
@@ -270,6 +328,7 @@ namespace vl
       if (mutex)
         mutex->unlock();
     }
+#endif
 
     //! If set to true the Object is deleted when its reference count reaches 0
     void setAutomaticDelete(bool autodel_on) { mAutomaticDelete = autodel_on; }
@@ -285,6 +344,17 @@ namespace vl
     template<class T>
     const T* as() const { return cast<const T>(this); }
 
+#ifdef VL_OBJECT_POOL
+  public:
+    //! Objects are allocated from SmallObjectPool::defaultPool() when VL is built with VL_OBJECT_POOL.
+    static void* operator new(size_t bytes) { return SmallObjectPool::defaultPool()->allocate(bytes); }
+    //! Objects are allocated from SmallObjectPool::defaultPool() when VL is built with VL_OBJECT_POOL.
+    static void operator delete(void* ptr, size_t bytes) { SmallObjectPool::defaultPool()->deallocate(ptr, bytes); }
+    //! Placement new is still available to allocate Objects in user-provided storage.
+    static void* operator new(size_t, void* where) { return where; }
+    static void operator delete(void*, void*) {}
+#endif
+
 #ifdef VL_USER_DATA_OBJECT
   public:
     const Object* userData() const { return mUserData.get(); }
@@ -300,7 +370,11 @@ namespace vl
     std::string mObjectName;
 
     IMutex* mRefCountMutex;
+  #ifdef VL_ATOMIC_REF_COUNT
+    mutable std::atomic<int> mReferenceCount;
+  #else
     mutable int mReferenceCount;
+  #endif
     bool mAutomaticDelete;
 
   // debugging facilities
@@ -0,0 +1,172 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/ObjectInstrumentation.hpp>
+#include <vlCore/MemoryTracker.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace vl;
+
+namespace
+{
+#ifdef VL_ATOMIC_REF_COUNT
+  std::atomic<ClassInstanceCounter*> gCounters(NULL);
+#else
+  ClassInstanceCounter* gCounters = NULL;
+#endif
+
+  bool moreLiving(const ObjectInstrumentation::ClassStats& a, const ObjectInstrumentation::ClassStats& b)
+  {
+    if ( a.liveCount != b.liveCount )
+      return a.liveCount > b.liveCount;
+    return strcmp(a.className, b.className) < 0;
+  }
+
+  long long classBytes(const char* class_name)
+  {
+    if ( strcmp(class_name, "vl::Buffer") == 0 )
+      return MemoryTracker::bytes(MC_Buffer);
+    if ( strcmp(class_name, "vl::Image") == 0 )
+      return MemoryTracker::bytes(MC_Image);
+    if ( strcmp(class_name, "vl::BufferObject") == 0 )
+      return MemoryTracker::bytes(MC_BufferObject);
+    if ( strcmp(class_name, "vl::Texture") == 0 )
+      return MemoryTracker::bytes(MC_Texture);
+    return -1;
+  }
+}
+//-----------------------------------------------------------------------------
+// ClassInstanceCounter
+//-----------------------------------------------------------------------------
+ClassInstanceCounter::ClassInstanceCounter(const char* class_name): mClassName(class_name), mLive(0), mPeak(0), mCreated(0), mNext(NULL)
+{
+  ObjectInstrumentation::registerCounter(this);
+}
+//-----------------------------------------------------------------------------
+// ObjectInstrumentation
+//-----------------------------------------------------------------------------
+void ObjectInstrumentation::registerCounter(ClassInstanceCounter* counter)
+{
+#ifdef VL_ATOMIC_REF_COUNT
+  ClassInstanceCounter* head = gCounters;
+  do
+    counter->mNext = head;
+  while( ! gCounters.compare_exchange_weak(head, counter) );
+#else
+  counter->mNext = gCounters;
+  gCounters = counter;
+#endif
+}
+//-----------------------------------------------------------------------------
+bool ObjectInstrumentation::isEnabled()
+{
+#ifdef VL_OBJECT_INSTRUMENTATION
+  return true;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+long long ObjectInstrumentation::liveCount(const char* class_name)
+{
+  long long count = 0;
+  for(const ClassInstanceCounter* counter = gCounters; counter; counter = counter->mNext)
+    if ( strcmp(counter->className(), class_name) == 0 )
+      count += counter->liveCount();
+  return count;
+}
+//-----------------------------------------------------------------------------
+long long ObjectInstrumentation::createdCount(const char* class_name)
+{
+  long long count = 0;
+  for(const ClassInstanceCounter* counter = gCounters; counter; counter = counter->mNext)
+    if ( strcmp(counter->className(), class_name) == 0 )
+      count += counter->createdCount();
+  return count;
+}
+//-----------------------------------------------------------------------------
+void ObjectInstrumentation::collect(std::vector<ClassStats>& stats)
+{
+  stats.clear();
+  for(const ClassInstanceCounter* counter = gCounters; counter; counter = counter->mNext)
+  {
+    if ( counter->createdCount() == 0 )
+      continue;
+
+    // the instantiations of a template share the same name
+    size_t i = 0;
+    while( i < stats.size() && strcmp(stats[i].className, counter->className()) != 0 )
+      ++i;
+    if ( i == stats.size() )
+    {
+      stats.push_back( ClassStats() );
+      stats.back().className = counter->className();
+      stats.back().bytes = classBytes(counter->className());
+    }
+    stats[i].liveCount    += counter->liveCount();
+    stats[i].peakCount    += counter->peakCount();
+    stats[i].createdCount += counter->createdCount();
+  }
+  std::sort(stats.begin(), stats.end(), moreLiving);
+}
+//-----------------------------------------------------------------------------
+void ObjectInstrumentation::resetPeaks()
+{
+  for(ClassInstanceCounter* counter = gCounters; counter; counter = counter->mNext)
+    counter->mPeak = (long long)counter->mLive;
+}
+//-----------------------------------------------------------------------------
+void ObjectInstrumentation::print(int max_classes)
+{
+  if ( !isEnabled() )
+  {
+    Log::print("ObjectInstrumentation: not available, build Visualization Library with VL_OBJECT_INSTRUMENTATION.\n");
+    return;
+  }
+
+  std::vector<ClassStats> stats;
+  collect(stats);
+  int count = max_classes > 0 && max_classes < (int)stats.size() ? max_classes : (int)stats.size();
+  for(int i=0; i<count; ++i)
+  {
+    const ClassStats& s = stats[i];
+    if ( s.bytes >= 0 )
+      Log::print( Say("%s: %n living, peak %n, %n created, %n bytes\n") << s.className << s.liveCount << s.peakCount << s.createdCount << s.bytes );
+    else
+      Log::print( Say("%s: %n living, peak %n, %n created\n") << s.className << s.liveCount << s.peakCount << s.createdCount );
+  }
+  if ( count < (int)stats.size() )
+    Log::print( Say("... %n more classes\n") << (int)stats.size() - count );
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,166 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef ObjectInstrumentation_INCLUDE_ONCE
+#define ObjectInstrumentation_INCLUDE_ONCE
+
+#include <vlCore/link_config.hpp>
+#include <vlCore/config.hpp>
+#include <vector>
+#include <cstddef>
+
+#ifdef VL_ATOMIC_REF_COUNT
+  #include <atomic>
+#endif
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // ClassInstanceCounter
+  //-----------------------------------------------------------------------------
+  /**
+   * Live instance counter of an instrumented class, see ObjectInstrumentation.
+   *
+   * Every class tagged with VL_INSTRUMENT_CLASS owns one, returned by its static InstanceCounter() method,
+   * if Visualization Library is built with VL_OBJECT_INSTRUMENTATION. The counters are never destroyed so that
+   * Objects outliving the static destruction phase can still be accounted.
+   */
+  class VLCORE_EXPORT ClassInstanceCounter
+  {
+  public:
+#ifdef VL_ATOMIC_REF_COUNT
+    typedef std::atomic<long long> Counter;
+#else
+    typedef long long Counter;
+#endif
+
+    //! Constructor, registers the counter with ObjectInstrumentation. \p class_name must be a string literal.
+    ClassInstanceCounter(const char* class_name);
+
+    //! Called when an instance is constructed.
+    void created()
+    {
+      long long live = ++mLive;
+      ++mCreated;
+#ifdef VL_ATOMIC_REF_COUNT
+      long long peak = mPeak;
+      while( live > peak && ! mPeak.compare_exchange_weak(peak, live) ) {}
+#else
+      if ( live > mPeak )
+        mPeak = live;
+#endif
+    }
+
+    //! Called when an instance is destroyed.
+    void destroyed() { --mLive; }
+
+    //! The name of the class including the namespace.
+    const char* className() const { return mClassName; }
+
+    //! The number of living instances.
+    long long liveCount() const { return mLive; }
+
+    //! The highest number of living instances since the start of the program or the last ObjectInstrumentation::resetPeaks().
+    long long peakCount() const { return mPeak; }
+
+    //! The number of instances constructed since the start of the program.
+    long long createdCount() const { return mCreated; }
+
+  private:
+    ClassInstanceCounter(const ClassInstanceCounter&);
+    ClassInstanceCounter& operator=(const ClassInstanceCounter&);
+    friend class ObjectInstrumentation;
+
+  private:
+    const char* mClassName;
+    Counter mLive;
+    Counter mPeak;
+    Counter mCreated;
+    ClassInstanceCounter* mNext;
+  };
+
+  //-----------------------------------------------------------------------------
+  // ObjectInstrumentation
+  //-----------------------------------------------------------------------------
+  /**
+   * Per-class accounting of the living Objects, meant to find object explosions in production scenes.
+   *
+   * Enabled building Visualization Library with VL_OBJECT_INSTRUMENTATION: VL_INSTRUMENT_CLASS and its variants then
+   * add to each class a hidden member updating the class' ClassInstanceCounter upon construction and destruction.
+   * An Object is counted by its own class and by each of its instrumented base classes, so that the vl::Object entry
+   * reports the total number of Objects. Template classes share one entry per template.
+   *
+   * The Buffer, Image, BufferObject and Texture entries also report the bytes counted by MemoryTracker for the matching EMemoryCategory.
+   *
+   * When VL_OBJECT_INSTRUMENTATION is disabled isEnabled() returns \a false and all the counts are 0.
+   * The counters are atomic if Visualization Library is built with VL_ATOMIC_REF_COUNT.
+   */
+  class VLCORE_EXPORT ObjectInstrumentation
+  {
+  public:
+    //! The accounting of a class, see collect().
+    struct ClassStats
+    {
+      ClassStats(): className(NULL), liveCount(0), peakCount(0), createdCount(0), bytes(-1) {}
+
+      const char* className;
+      long long liveCount;
+      long long peakCount;
+      long long createdCount;
+      //! The bytes reported by MemoryTracker for Buffer, Image, BufferObject and Texture, -1 for the other classes.
+      long long bytes;
+    };
+
+  public:
+    //! Returns \a true if Visualization Library has been built with VL_OBJECT_INSTRUMENTATION.
+    static bool isEnabled();
+
+    //! The number of living instances of the given class and of its subclasses, for example "vl::Uniform".
+    static long long liveCount(const char* class_name);
+
+    //! The number of instances of the given class and of its subclasses constructed since the start of the program.
+    static long long createdCount(const char* class_name);
+
+    //! Fills \p stats with the classes having at least one living or constructed instance, sorted by decreasing live count.
+    static void collect(std::vector<ClassStats>& stats);
+
+    //! Sets the peak counts to the current live counts.
+    static void resetPeaks();
+
+    //! Prints the classes sorted by decreasing live count, at most \p max_classes of them if \p max_classes > 0.
+    static void print(int max_classes=0);
+
+    //! Used by ClassInstanceCounter.
+    static void registerCounter(ClassInstanceCounter* counter);
+  };
+}
+
+#endif
@@ -76,6 +76,58 @@
 
 #endif
 
+/* GL_KHR_parallel_shader_compile is more recent than the bundled Khronos headers */
+#ifndef GL_COMPLETION_STATUS_KHR
+  #define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+  #define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+
+/* ARB_texture_compression_bptc, ARB_ES3_compatibility and KHR_texture_compression_astc_ldr block formats */
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM_ARB
+  #define GL_COMPRESSED_RGBA_BPTC_UNORM_ARB         0x8E8C
+  #define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB   0x8E8D
+  #define GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB   0x8E8E
+  #define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB 0x8E8F
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+  #define GL_COMPRESSED_R11_EAC                        0x9270
+  #define GL_COMPRESSED_SIGNED_R11_EAC                 0x9271
+  #define GL_COMPRESSED_RG11_EAC                       0x9272
+  #define GL_COMPRESSED_SIGNED_RG11_EAC                0x9273
+  #define GL_COMPRESSED_RGB8_ETC2                      0x9274
+  #define GL_COMPRESSED_SRGB8_ETC2                     0x9275
+  #define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2  0x9276
+  #define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9277
+  #define GL_COMPRESSED_RGBA8_ETC2_EAC                 0x9278
+  #define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC          0x9279
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+  #define GL_COMPRESSED_RGBA_ASTC_4x4_KHR         0x93B0
+  #define GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR 0x93D0
+#endif
+
+/* GL_ARB_compute_shader and GL_ARB_shader_storage_buffer_object are more recent than the bundled Khronos headers */
+#ifndef GL_COMPUTE_SHADER
+  #define GL_COMPUTE_SHADER                    0x91B9
+  #define GL_MAX_COMPUTE_WORK_GROUP_COUNT      0x91BE
+  #define GL_MAX_COMPUTE_WORK_GROUP_SIZE       0x91BF
+  #define GL_DISPATCH_INDIRECT_BUFFER          0x90EE
+  #define GL_COMPUTE_SHADER_BIT                0x00000020
+#endif
+#if defined(VL_OPENGL) && !defined(GL_ARB_compute_shader)
+  #define GL_ARB_compute_shader 1
+  typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC) (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+  typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEINDIRECTPROC) (GLintptr indirect);
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+  #define GL_SHADER_STORAGE_BUFFER             0x90D2
+  #define GL_SHADER_STORAGE_BUFFER_BINDING     0x90D3
+  #define GL_SHADER_STORAGE_BUFFER_START       0x90D4
+  #define GL_SHADER_STORAGE_BUFFER_SIZE        0x90D5
+  #define GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS 0x90DD
+  #define GL_SHADER_STORAGE_BARRIER_BIT        0x00002000
+#endif
+
 /* Define NULL */
 #ifndef NULL
   #define NULL 0
@@ -0,0 +1,190 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/ResourceCache.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/CRC32CheckSum.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/Image.hpp>
+#include <vlCore/Buffer.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+ResourceCache::ResourceCache()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mKeyMode = PathAndTimeKey;
+  mMemoryBudget = 256*1024*1024;
+  mMemoryUsed = 0;
+  mHitCount = 0;
+  mMissCount = 0;
+  mMutex = NULL;
+}
+//-----------------------------------------------------------------------------
+String ResourceCache::computeKey(VirtualFile* file) const
+{
+  if ( file->path().empty() )
+    return String();
+
+  if ( keyMode() == ContentHashKey )
+  {
+    bool was_open = file->isOpen();
+    if ( !was_open && !file->open(OM_ReadOnly) )
+      return String();
+    long long pos = file->position();
+    file->seekSet(0);
+    CRC32CheckSum crc;
+    unsigned int crc32 = crc.compute(file);
+    long long size = file->size();
+    if (was_open)
+      file->seekSet(pos);
+    else
+      file->close();
+    return Say("crc32:%hn:%n") << crc32 << size;
+  }
+  else
+  {
+    const DiskFile* disk_file = file->as<DiskFile>();
+    long long time = disk_file ? disk_file->lastModified() : 0;
+    return Say("%s:%n:%n") << file->path() << time << file->size();
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> ResourceCache::find(VirtualFile* file)
+{
+  String key = computeKey(file);
+  if ( key.empty() )
+    return NULL;
+
+  ScopedMutex lock(mMutex);
+  std::map< String, std::list<Entry>::iterator >::iterator it = mEntries.find(key);
+  if ( it == mEntries.end() )
+  {
+    ++mMissCount;
+    return NULL;
+  }
+  ++mHitCount;
+  // move to the front of the LRU list
+  mLRU.splice( mLRU.begin(), mLRU, it->second );
+  return it->second->mResourceDatabase;
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> ResourceCache::insert(VirtualFile* file, ResourceDatabase* db)
+{
+  if ( !db )
+    return NULL;
+
+  String key = computeKey(file);
+  if ( key.empty() )
+    return db;
+
+  long long bytes = estimateMemory(db);
+
+  ScopedMutex lock(mMutex);
+  std::map< String, std::list<Entry>::iterator >::iterator it = mEntries.find(key);
+  if ( it != mEntries.end() )
+  {
+    mLRU.splice( mLRU.begin(), mLRU, it->second );
+    return it->second->mResourceDatabase;
+  }
+
+  Entry entry;
+  entry.mKey = key;
+  entry.mResourceDatabase = db;
+  entry.mBytes = bytes;
+  mLRU.push_front(entry);
+  mEntries[key] = mLRU.begin();
+  mMemoryUsed += bytes;
+  trim_Implementation();
+  return db;
+}
+//-----------------------------------------------------------------------------
+void ResourceCache::clear()
+{
+  ScopedMutex lock(mMutex);
+  mLRU.clear();
+  mEntries.clear();
+  mMemoryUsed = 0;
+}
+//-----------------------------------------------------------------------------
+void ResourceCache::trim()
+{
+  ScopedMutex lock(mMutex);
+  trim_Implementation();
+}
+//-----------------------------------------------------------------------------
+void ResourceCache::trim_Implementation()
+{
+  std::list<Entry>::iterator it = mLRU.end();
+  while( mMemoryUsed > mMemoryBudget && it != mLRU.begin() )
+  {
+    --it;
+    if ( inUse(*it) )
+      continue;
+    mMemoryUsed -= it->mBytes;
+    mEntries.erase(it->mKey);
+    it = mLRU.erase(it);
+  }
+}
+//-----------------------------------------------------------------------------
+bool ResourceCache::inUse(const Entry& entry)
+{
+  // loadImage() and similar functions return the resources without their ResourceDatabase
+  const ResourceDatabase* db = entry.mResourceDatabase.get();
+  if ( db->referenceCount() > 1 )
+    return true;
+  for(size_t i=0; i<db->resources().size(); ++i)
+    if ( db->resources()[i]->referenceCount() > 1 )
+      return true;
+  return false;
+}
+//-----------------------------------------------------------------------------
+long long ResourceCache::estimateMemory(const ResourceDatabase* db) const
+{
+  long long bytes = 0;
+  for(size_t i=0; i<db->resources().size(); ++i)
+  {
+    const Object* obj = db->resources()[i].get();
+    if ( const Image* img = obj->as<Image>() )
+    {
+      bytes += img->imageBuffer()->bytesUsed();
+      for(size_t j=0; j<img->mipmaps().size(); ++j)
+        bytes += img->mipmaps()[j]->imageBuffer()->bytesUsed();
+    }
+    else
+    if ( const Buffer* buf = obj->as<Buffer>() )
+      bytes += buf->bytesUsed();
+  }
+  return bytes;
+}
+//-----------------------------------------------------------------------------
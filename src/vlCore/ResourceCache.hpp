@@ -0,0 +1,155 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef ResourceCache_INCLUDE_ONCE
+#define ResourceCache_INCLUDE_ONCE
+
+#include <vlCore/ResourceDatabase.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/IMutex.hpp>
+#include <list>
+#include <map>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // ResourceCache
+  //-----------------------------------------------------------------------------
+  /**
+   * Caches the ResourceDatabase[s] loaded by LoadWriterManager::loadResource() so that loading the same file again,
+   * from another scene or when reloading a scene, returns the already decoded resources instead of decoding them again.
+   *
+   * Install it with setDefResourceCache(), the cache is disabled by default. The entries are keyed either by the resolved
+   * path of the file plus its modification time and size, or by a CRC32 of its content, see setKeyMode().
+   * The cached resources are shared by all the loads and should be treated as immutable: clone them before modifying them.
+   *
+   * When the estimated memory of the cached resources exceeds memoryBudget() the least recently used entries whose resources
+   * are not referenced outside of the cache are evicted. Resources still in use are kept since evicting them would not free
+   * any memory and would break the sharing.
+   *
+   * \sa LoadWriterManager, ResourceDatabase
+   */
+  class VLCORE_EXPORT ResourceCache: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ResourceCache, Object)
+
+  public:
+    typedef enum
+    {
+      PathAndTimeKey, //!< Resolved path, modification time and size of the file. Does not read the file.
+      ContentHashKey  //!< CRC32 and size of the file content, shares identical files stored under different paths.
+    } EKeyMode;
+
+  public:
+    ResourceCache();
+
+    //! Returns the cached resources loaded from \p file or NULL. Thread safe if a mutex has been installed with setMutex().
+    ref<ResourceDatabase> find(VirtualFile* file);
+
+    //! Caches the resources loaded from \p file and returns the cached instance, which is the one already cached if another
+    //! thread inserted the same file in the meantime. Thread safe if a mutex has been installed with setMutex().
+    ref<ResourceDatabase> insert(VirtualFile* file, ResourceDatabase* db);
+
+    //! Removes all the entries.
+    void clear();
+
+    //! Evicts the least recently used entries not in use until memoryUsed() <= memoryBudget().
+    void trim();
+
+    //! How the entries are keyed, defaults to PathAndTimeKey.
+    void setKeyMode(EKeyMode mode) { mKeyMode = mode; }
+
+    //! How the entries are keyed, defaults to PathAndTimeKey.
+    EKeyMode keyMode() const { return mKeyMode; }
+
+    //! The estimated memory above which entries are evicted, defaults to 256MB.
+    void setMemoryBudget(long long bytes) { mMemoryBudget = bytes; trim(); }
+
+    //! The estimated memory above which entries are evicted, defaults to 256MB.
+    long long memoryBudget() const { return mMemoryBudget; }
+
+    //! The estimated memory used by the cached resources, see estimateMemory().
+    long long memoryUsed() const { return mMemoryUsed; }
+
+    //! The number of cached entries.
+    int entryCount() const { return (int)mEntries.size(); }
+
+    //! The number of successful find() calls.
+    long long hitCount() const { return mHitCount; }
+
+    //! The number of unsuccessful find() calls.
+    long long missCount() const { return mMissCount; }
+
+    //! The mutex protecting the cache, required if resources are loaded by multiple threads. See also vl::IMutex.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex protecting the cache, required if resources are loaded by multiple threads. See also vl::IMutex.
+    IMutex* mutex() const { return mMutex; }
+
+    //! Estimates the memory used by the given resources, by default the bytes of the contained Image[s] and Buffer[s].
+    //! Reimplement it to account for other resource types.
+    virtual long long estimateMemory(const ResourceDatabase* db) const;
+
+  protected:
+    //! Returns the key of the file or an empty string if the file cannot be cached.
+    String computeKey(VirtualFile* file) const;
+
+    struct Entry
+    {
+      String mKey;
+      ref<ResourceDatabase> mResourceDatabase;
+      long long mBytes;
+    };
+
+    static bool inUse(const Entry& entry);
+
+    void trim_Implementation();
+
+  protected:
+    // front = most recently used
+    std::list<Entry> mLRU;
+    std::map< String, std::list<Entry>::iterator > mEntries;
+    EKeyMode mKeyMode;
+    long long mMemoryBudget;
+    long long mMemoryUsed;
+    long long mHitCount;
+    long long mMissCount;
+    IMutex* mMutex;
+  };
+
+  //! Returns the ResourceCache used by LoadWriterManager::loadResource(), NULL by default.
+  VLCORE_EXPORT ResourceCache* defResourceCache();
+
+  //! Sets the ResourceCache used by LoadWriterManager::loadResource(), NULL disables the caching.
+  VLCORE_EXPORT void setDefResourceCache(ResourceCache* cache);
+}
+
+#endif
@@ -29,3 +29,86 @@
 /*                                                                                    */
 /**************************************************************************************/
 
+
+#include <vlCore/ResourceDatabase.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// ResourceDatabase
+//-----------------------------------------------------------------------------
+void ResourceDatabase::rebuildTypeIndex() const
+{
+  mClassPositions.clear();
+  mTypeQueries.clear();
+  for(size_t i=0; i<mResources.size(); ++i)
+  {
+    if (mResources[i])
+      mClassPositions[ mResources[i]->classType().hash() ].push_back( (int)i );
+  }
+  mIndexedCount = mResources.size();
+  mTypeIndexDirty = false;
+}
+//-----------------------------------------------------------------------------
+const std::vector<int>& ResourceDatabase::positionsOfType(const TypeInfo& type) const
+{
+  if ( mTypeIndexDirty || mIndexedCount != mResources.size() )
+    rebuildTypeIndex();
+
+  std::map< u32, TypeQuery >::iterator it = mTypeQueries.find( type.hash() );
+  if ( it == mTypeQueries.end() )
+  {
+    // all the objects of the same concrete type give the same answer
+    TypeQuery& query = mTypeQueries[ type.hash() ];
+    query.mMerged = false;
+    for( std::map< u32, std::vector<int> >::const_iterator c = mClassPositions.begin(); c != mClassPositions.end(); ++c )
+    {
+      if ( mResources[ c->second[0] ]->isOfType(type) )
+        query.mClassTypes.push_back( c->first );
+    }
+    it = mTypeQueries.find( type.hash() );
+  }
+
+  TypeQuery& query = it->second;
+  if ( query.mClassTypes.size() == 1 )
+    return mClassPositions[ query.mClassTypes[0] ];
+
+  if ( !query.mMerged )
+  {
+    query.mPositions.clear();
+    for( size_t i=0; i<query.mClassTypes.size(); ++i )
+    {
+      const std::vector<int>& positions = mClassPositions[ query.mClassTypes[i] ];
+      query.mPositions.insert( query.mPositions.end(), positions.begin(), positions.end() );
+    }
+    std::sort( query.mPositions.begin(), query.mPositions.end() );
+    query.mMerged = true;
+  }
+  return query.mPositions;
+}
+//-----------------------------------------------------------------------------
+int ResourceDatabase::nextOfType(const TypeInfo& type, int cur_pos) const
+{
+  const std::vector<int>& positions = positionsOfType(type);
+  std::vector<int>::const_iterator it = std::lower_bound( positions.begin(), positions.end(), cur_pos );
+  return it != positions.end() ? *it : -1;
+}
+//-----------------------------------------------------------------------------
+void ResourceDatabase::erasePositions(const std::vector<int>& positions)
+{
+  // single compaction pass, 'positions' belongs to the index which is invalidated only at the end
+  size_t write = positions.front();
+  size_t next = 0;
+  for( size_t read = positions.front(); read < mResources.size(); ++read )
+  {
+    if ( next < positions.size() && (size_t)positions[next] == read )
+    {
+      ++next;
+      continue;
+    }
+    mResources[write++] = mResources[read];
+  }
+  mResources.resize( write );
+  mTypeIndexDirty = true;
+}
+//-----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include <vlCore/Object.hpp>
 #include <vlCore/String.hpp>
 #include <vector>
+#include <map>
 #include <algorithm>
 
 namespace vl
@@ -50,29 +51,25 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::ResourceDatabase, Object)
 
   public:
-    ResourceDatabase()
+    ResourceDatabase(): mIndexedCount(0), mTypeIndexDirty(true)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
 
     const std::vector< ref<Object> >& resources() const { return mResources; }
 
-    std::vector< ref<Object> >& resources() { return mResources; }
+    //! \note Marks the type index as dirty, use the const version when only reading the resources.
+    std::vector< ref<Object> >& resources() { mTypeIndexDirty = true; return mResources; }
 
     //! Starts to look for the next object of the specified type from the given position.
     template<class T>
     T* next(int& cur_pos) const
     {
-      for(unsigned i=cur_pos; i<mResources.size(); ++i)
-      {
-        ref<T> r = cast<T>(mResources[i].get());
-        if (r)
-        {
-          cur_pos = i+1;
-          return r.get();
-        }
-      }
-      return NULL;
+      int pos = nextOfType(T::Type(), cur_pos);
+      if (pos < 0)
+        return NULL;
+      cur_pos = pos+1;
+      return cast<T>(mResources[pos].get_writable());
     }
 
     //! Returns all the objects of the specified type in the given vector.
@@ -82,12 +79,10 @@ namespace vl
       if (clear_vector)
         resources.clear();
 
-      for( unsigned i=0; i<mResources.size(); ++i )
-      {
-        ref<T> r = cast<T>(mResources[i].get());
-        if (r)
-          resources.push_back(r);
-      }
+      const std::vector<int>& positions = positionsOfType(T::Type());
+      resources.reserve( resources.size() + positions.size() );
+      for( size_t i=0; i<positions.size(); ++i )
+        resources.push_back( cast<T>(mResources[positions[i]].get()) );
     }
 
     //! Returns all the objects of the specified type in the given vector and removes them from the ResourceDatabase.
@@ -97,75 +92,71 @@ namespace vl
       if (clear_vector)
         resources.clear();
 
-      size_t start = resources.size();
-
-      for( unsigned i=mResources.size(); i--; )
-      {
-        ref<T> r = cast<T>(mResources[i].get());
-        if (r)
-        {
-          resources.push_back(r);
-          mResources.erase(mResources.begin()+i);
-        }
-      }
-
-      std::reverse(resources.begin()+start, resources.end());
+      const std::vector<int>& positions = positionsOfType(T::Type());
+      if (positions.empty())
+        return;
+      resources.reserve( resources.size() + positions.size() );
+      for( size_t i=0; i<positions.size(); ++i )
+        resources.push_back( cast<T>(mResources[positions[i]].get()) );
+      erasePositions(positions);
     }
 
-    //! Don't use inside loops! Counts the number object of the specified type.
+    //! Counts the number object of the specified type.
     template<class T>
     size_t count() const
     {
-      size_t count=0;
-      for(unsigned i=0; i<mResources.size(); ++i)
-      {
-        const T* r = cast_const<T>(mResources[i].get());
-        if (r)
-          ++count;
-      }
-      return count;
+      return positionsOfType(T::Type()).size();
     }
 
-    //! Don't use inside loops! Returns the j-th object of the specified type (which is different from \p resources()[j]!).
+    //! Returns the j-th object of the specified type (which is different from \p resources()[j]!).
     template<class T>
     const T* get(int j) const
     {
-      int count=0;
-      for(unsigned i=0; i<mResources.size(); ++i)
-      {
-        const T* r = cast_const<T>(mResources[i].get());
-        if (r)
-        {
-          if (count == j)
-            return r;
-          else
-            ++count;
-        }
-      }
-      return NULL;
+      const std::vector<int>& positions = positionsOfType(T::Type());
+      if (j < 0 || j >= (int)positions.size())
+        return NULL;
+      return cast_const<T>(mResources[positions[j]].get());
     }
 
-    //! Don't use inside loops! Returns the j-th object of the specified type (which is different from \p resources()[j]!).
+    //! Returns the j-th object of the specified type (which is different from \p resources()[j]!).
     template<class T>
     T* get(int j)
     {
-      int count=0;
-      for(unsigned i=0; i<mResources.size(); ++i)
-      {
-        T* r = cast<T>(mResources[i].get());
-        if (r)
-        {
-          if (count == j)
-            return r;
-          else
-            ++count;
-        }
-      }
-      return NULL;
+      const std::vector<int>& positions = positionsOfType(T::Type());
+      if (j < 0 || j >= (int)positions.size())
+        return NULL;
+      return cast<T>(mResources[positions[j]].get());
     }
 
+  protected:
+    //! Returns the ascending positions in resources() of the objects of the given type or derived from it.
+    //! The returned vector is valid until the database is modified.
+    const std::vector<int>& positionsOfType(const TypeInfo& type) const;
+
+    //! Returns the position of the first object of the given type at or after \p cur_pos or -1.
+    int nextOfType(const TypeInfo& type, int cur_pos) const;
+
+    //! Removes the resources at the given ascending positions.
+    void erasePositions(const std::vector<int>& positions);
+
+    void rebuildTypeIndex() const;
+
   protected:
     std::vector< ref<Object> > mResources;
+
+    // Type index: resources() positions grouped by Object::classType() and, for every queried type, the concrete types
+    // deriving from it. Typed queries cost proportionally to their result instead of to the size of the database.
+    // The index is rebuilt lazily when the non-const resources() is used or the number of resources changes.
+    struct TypeQuery
+    {
+      std::vector<u32> mClassTypes; // concrete types matching the query
+      std::vector<int> mPositions;  // merged positions, valid if mMerged
+      bool mMerged;
+    };
+    mutable std::map< u32, std::vector<int> > mClassPositions;
+    mutable std::map< u32, TypeQuery > mTypeQueries;
+    mutable size_t mIndexedCount;
+    mutable bool mTypeIndexDirty;
   };
 
   //! Short version of defLoadWriterManager()->canLoad(path).
@@ -0,0 +1,70 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef VLSIMD_INCLUDE_ONCE
+#define VLSIMD_INCLUDE_ONCE
+
+#include <vlCore/config.hpp>
+
+/**
+ * \file SIMD.hpp
+ * Selects the SIMD instruction set used by the fmat4 / dmat4 specializations and by the batched transform kernels
+ * (see TransformKernels.hpp) according to the target architecture of the compiler:
+ * - \p VL_SIMD_AVX: AVX, when compiling with -mavx or /arch:AVX (used for double precision)
+ * - \p VL_SIMD_SSE2: SSE2, always available on x86-64
+ * - \p VL_SIMD_F16C: F16C half-float conversions, when compiling with -mf16c or /arch:AVX2 (see half.hpp)
+ * - \p VL_SIMD_NEON: ARM NEON, double precision only on AArch64 (\p VL_SIMD_NEON64)
+ *
+ * No instruction set is enabled if VL_SIMD is not defined, see config.hpp.
+ */
+
+#if defined(VL_SIMD)
+  #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define VL_SIMD_SSE2
+    #include <emmintrin.h>
+    #if defined(__AVX__)
+      #define VL_SIMD_AVX
+      #include <immintrin.h>
+    #endif
+    #if defined(__F16C__) || defined(__AVX2__)
+      #define VL_SIMD_F16C
+      #include <immintrin.h>
+    #endif
+  #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define VL_SIMD_NEON
+    #include <arm_neon.h>
+    #if defined(__aarch64__) || defined(_M_ARM64)
+      #define VL_SIMD_NEON64
+    #endif
+  #endif
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/SmallObjectPool.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/checks.hpp>
+#include <new>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+SmallObjectPool::SmallObjectPool(size_t chunk_size)
+{
+  for(size_t i=0; i<MaxObjectSize / Granularity; ++i)
+    mFreeLists[i] = NULL;
+  mChunkPtr  = NULL;
+  mChunkLeft = 0;
+  mChunkSize = chunk_size < MaxObjectSize ? MaxObjectSize : chunk_size;
+  mLiveAllocations = 0;
+  mOversizedAllocations = 0;
+  mMutex = NULL;
+}
+//-----------------------------------------------------------------------------
+SmallObjectPool::~SmallObjectPool()
+{
+  VL_CHECK(mLiveAllocations == 0)
+  for(size_t i=0; i<mChunks.size(); ++i)
+    ::operator delete(mChunks[i]);
+}
+//-----------------------------------------------------------------------------
+void* SmallObjectPool::allocate(size_t bytes)
+{
+  if (bytes > MaxObjectSize)
+  {
+    ScopedMutex lock(mMutex);
+    ++mOversizedAllocations;
+    return ::operator new(bytes);
+  }
+
+  size_t size_class = bytes ? (bytes - 1) / Granularity : 0;
+
+  ScopedMutex lock(mMutex);
+  if (!mFreeLists[size_class])
+    refill(size_class);
+  FreeBlock* block = mFreeLists[size_class];
+  mFreeLists[size_class] = block->mNext;
+  ++mLiveAllocations;
+  return block;
+}
+//-----------------------------------------------------------------------------
+void SmallObjectPool::deallocate(void* ptr, size_t bytes)
+{
+  if (!ptr)
+    return;
+
+  if (bytes > MaxObjectSize)
+  {
+    {
+      ScopedMutex lock(mMutex);
+      VL_CHECK(mOversizedAllocations)
+      --mOversizedAllocations;
+    }
+    ::operator delete(ptr);
+    return;
+  }
+
+  size_t size_class = bytes ? (bytes - 1) / Granularity : 0;
+
+  ScopedMutex lock(mMutex);
+  VL_CHECK(mLiveAllocations)
+  FreeBlock* block = (FreeBlock*)ptr;
+  block->mNext = mFreeLists[size_class];
+  mFreeLists[size_class] = block;
+  --mLiveAllocations;
+}
+//-----------------------------------------------------------------------------
+void SmallObjectPool::refill(size_t size_class)
+{
+  size_t block_size = (size_class + 1) * Granularity;
+
+  // carve a batch of blocks out of the current chunk, starting a new one when exhausted
+  if (mChunkLeft < block_size)
+  {
+    mChunkPtr  = (unsigned char*)::operator new(mChunkSize);
+    mChunkLeft = mChunkSize;
+    mChunks.push_back(mChunkPtr);
+  }
+
+  size_t count = mChunkLeft / block_size;
+  // don't hand a whole chunk to a single size class at once
+  size_t max_count = mChunkSize / MaxObjectSize;
+  count = count < max_count ? count : max_count;
+
+  for(size_t i=0; i<count; ++i)
+  {
+    FreeBlock* block = (FreeBlock*)mChunkPtr;
+    block->mNext = mFreeLists[size_class];
+    mFreeLists[size_class] = block;
+    mChunkPtr  += block_size;
+    mChunkLeft -= block_size;
+  }
+}
+//-----------------------------------------------------------------------------
+bool SmallObjectPool::purge()
+{
+  ScopedMutex lock(mMutex);
+  if (mLiveAllocations)
+    return false;
+  for(size_t i=0; i<mChunks.size(); ++i)
+    ::operator delete(mChunks[i]);
+  mChunks.clear();
+  for(size_t i=0; i<MaxObjectSize / Granularity; ++i)
+    mFreeLists[i] = NULL;
+  mChunkPtr  = NULL;
+  mChunkLeft = 0;
+  return true;
+}
+//-----------------------------------------------------------------------------
+SmallObjectPool* SmallObjectPool::defaultPool()
+{
+  // intentionally leaked: static Objects may be released after static destruction begins
+  static SmallObjectPool* pool = new SmallObjectPool;
+  return pool;
+}
+//-----------------------------------------------------------------------------
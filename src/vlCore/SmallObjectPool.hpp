@@ -0,0 +1,126 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef SmallObjectPool_INCLUDE_ONCE
+#define SmallObjectPool_INCLUDE_ONCE
+
+#include <vlCore/config.hpp>
+#include <vlCore/link_config.hpp>
+#include <vlCore/IMutex.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // SmallObjectPool
+  //-----------------------------------------------------------------------------
+  /**
+   * A size-class pool allocator for small, frequently allocated objects.
+   *
+   * Requests up to maxObjectSize() bytes are rounded up to a multiple of granularity() and
+   * served from per-size-class free lists carved out of large chunks, larger requests are
+   * forwarded to the global operator new. Memory is returned to the free lists on deallocation
+   * and given back to the system only by purge() or when the pool is destroyed.
+   *
+   * When VL is built with VL_OBJECT_POOL every vl::Object is allocated from defaultPool().
+   *
+   * \note The pool is not thread-safe by default: install a mutex with setMutex() if objects
+   * are created or destroyed from more than one thread.
+   * \sa vl::BufferArena
+  */
+  class VLCORE_EXPORT SmallObjectPool
+  {
+  public:
+    static const size_t Granularity   = 16;
+    static const size_t MaxObjectSize = 256;
+
+  public:
+    SmallObjectPool(size_t chunk_size = 64*1024);
+
+    ~SmallObjectPool();
+
+    //! Allocates \p bytes bytes, aligned to at least granularity() bytes.
+    void* allocate(size_t bytes);
+
+    //! Returns a block previously returned by allocate(); \p bytes must match the allocation size.
+    void deallocate(void* ptr, size_t bytes);
+
+    //! Frees all the chunks; legal only when liveAllocations() is 0, returns false otherwise.
+    bool purge();
+
+    //! The size of the memory chunks the size classes are carved from.
+    size_t chunkSize() const { return mChunkSize; }
+
+    //! The number of blocks currently allocated from the pool's size classes.
+    size_t liveAllocations() const { return mLiveAllocations; }
+
+    //! The number of allocations that were too large for the pool and were forwarded to operator new.
+    size_t oversizedAllocations() const { return mOversizedAllocations; }
+
+    //! The total number of bytes reserved by the pool's chunks.
+    size_t reservedBytes() const { return mChunks.size() * mChunkSize; }
+
+    //! The mutex used to serialize allocations, NULL by default.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex used to serialize allocations, NULL by default.
+    IMutex* mutex() const { return mMutex; }
+
+    static size_t granularity() { return Granularity; }
+
+    static size_t maxObjectSize() { return MaxObjectSize; }
+
+    //! The pool used by vl::Object when VL is built with VL_OBJECT_POOL.
+    //! The default pool is never destroyed so that objects outliving static destruction can still be released.
+    static SmallObjectPool* defaultPool();
+
+  private:
+    SmallObjectPool(const SmallObjectPool&);
+    SmallObjectPool& operator=(const SmallObjectPool&);
+
+    struct FreeBlock { FreeBlock* mNext; };
+
+    void refill(size_t size_class);
+
+  private:
+    FreeBlock* mFreeLists[MaxObjectSize / Granularity];
+    std::vector<unsigned char*> mChunks;
+    unsigned char* mChunkPtr;
+    size_t mChunkLeft;
+    size_t mChunkSize;
+    size_t mLiveAllocations;
+    size_t mOversizedAllocations;
+    IMutex* mMutex;
+  };
+}
+
+#endif
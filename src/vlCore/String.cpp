@@ -41,6 +41,41 @@
 
 using namespace vl;
 
+namespace
+{
+  // Encodes 'count' characters as UTF-8 appending them to 'out' without intermediate buffers.
+  void appendUTF8(std::string& out, const wchar_t* str, int count)
+  {
+    // Unicode            Byte1     Byte2     Byte3
+    // U+000000-U+00007F  0xxxxxxx
+    // U+000080-U+0007FF  110xxxxx  10xxxxxx
+    // U+000800-U+00FFFF  1110xxxx  10xxxxxx  10xxxxxx
+    size_t size = out.size();
+    out.resize(size + count*3);
+    char* p = &out[0] + size;
+    char* start = p;
+    for(int i=0; i<count; ++i)
+    {
+      unsigned int ch = (unsigned int)str[i];
+      if (ch < 0x80)
+        *p++ = (char)ch;
+      else
+      if (ch < 0x800)
+      {
+        *p++ = (char)(0xC0 | (ch>>6));
+        *p++ = (char)(0x80 | (ch&0x3F));
+      }
+      else
+      {
+        *p++ = (char)(0xE0 | (ch>>12));
+        *p++ = (char)(0x80 | ((ch>>6)&0x3F));
+        *p++ = (char)(0x80 | (ch&0x3F));
+      }
+    }
+    out.resize(size + (p-start));
+  }
+}
+
 //-----------------------------------------------------------------------------
 // String
 //-----------------------------------------------------------------------------
@@ -895,6 +930,7 @@ String String::fromAscii(const char* str, int size)
     size = (int)strlen(str);
   const unsigned char* ascii = (const unsigned char*)str;
   s.mString->clear();
+  s.mString->reserve(size);
   for(int i=0; i<size; ++i)
   {
     if( ascii[i] < 128 )
@@ -1012,6 +1048,8 @@ String String::fromUTF8(const char* str, int byte_count)
     for(byte_count=0; utf8[byte_count]; ) ++byte_count;
 
   s.mString->clear();
+  // the number of characters never exceeds the number of bytes
+  s.mString->reserve(byte_count-start);
   const int UTF8_1BYTE = 128;
   const int UTF8_2BYTE = 128+64;
   const int UTF8_3BYTE = 128+64+32;
@@ -1064,6 +1102,7 @@ String String::fromLatin1(const char* str, int character_count)
     for(character_count=0; latin1[character_count]; ) ++character_count;
 
   s.mString->clear();
+  s.mString->reserve(character_count);
   for(int i=0; i<character_count; ++i)
     s.mString->push_back( latin1_to_unicode[ latin1[i] ] );
   return s;
@@ -1147,10 +1186,7 @@ std::wstring String::toStdWString() const
   if (empty())
     return std::wstring();
 
-  std::wstring ws;
-  for(int i=0; i<length(); ++i)
-    ws += (*mString)[i];
-  return ws;
+  return std::wstring(ptr(), length());
 }
 //-----------------------------------------------------------------------------
 std::string String::toStdString() const
@@ -1159,15 +1195,7 @@ std::string String::toStdString() const
   if (empty())
     return std::string();
   std::string std_string;
-
-  std::vector<unsigned char> utf8;
-  toUTF8(utf8, false);
-  if (utf8.size()>1)
-  {
-    std_string.resize(utf8.size()-1);
-    memcpy(&std_string[0], &utf8[0], utf8.size()-1);
-  }
-
+  appendUTF8(std_string, ptr(), length());
   return std_string;
 }
 //-----------------------------------------------------------------------------
@@ -1205,14 +1233,16 @@ void String::toAscii(std::string& ascii, bool translate_non_ascii_chars) const
 //-----------------------------------------------------------------------------
 void String::toUTF8(std::string& str, bool include_utf8_signature) const
 {
-  std::vector<unsigned char> utf8;
-  toUTF8(utf8, include_utf8_signature);
   str.clear();
-  if (utf8.size())
-  {
-    for(int i=0; utf8[i]; ++i)
-      str.push_back(utf8[i]);
-  }
+  if (include_utf8_signature)
+    str.append("\xEF\xBB\xBF");
+  if (empty())
+    return;
+  // stops at the first 0 character
+  int count = 0;
+  while(count<length() && (*mString)[count])
+    ++count;
+  appendUTF8(str, ptr(), count);
 }
 //-----------------------------------------------------------------------------
 void String::toUTF8(std::vector<unsigned char>& utf8, bool include_utf8_signature) const
@@ -36,6 +36,7 @@
 #include <vlCore/Object.hpp>
 #include <vector>
 #include <string.h>
+#include <stdlib.h>
 
 #if defined(VL_PLATFORM_WINDOWS)
   #define VL_PLATFORM_DEFAULT_ENCODING SE_LATIN1
@@ -565,22 +566,68 @@ namespace vl
     void createData() const { if (!mString) mString = new StringData; }
 
   private:
+    //! 0-terminated wide character buffer with inline storage for short strings: names, paths
+    //! components and identifiers up to InlineCapacity characters require no heap allocation
+    //! besides the StringData object itself.
     class StringData: public Object
     {
     public:
-      void clear() { mWString.clear(); }
-      void push_back(wchar_t a) { mWString.push_back(a); }
-      const wchar_t& operator[](int i) const { return mWString[i]; }
-      wchar_t& operator[](int i) { return mWString[i]; }
-      int length() const { return (int)mWString.length(); }
-      void resize(int size) { mWString.resize(size); }
+      StringData(): mData(mInline), mLength(0), mCapacity(InlineCapacity) { mInline[0] = 0; }
+      StringData(const StringData& other): Object(other), mData(mInline), mLength(0), mCapacity(InlineCapacity)
+      {
+        reserve(other.mLength);
+        memcpy(mData, other.mData, sizeof(wchar_t)*(other.mLength+1));
+        mLength = other.mLength;
+      }
+      ~StringData() { if (mData != mInline) free(mData); }
+      void clear() { mLength = 0; mData[0] = 0; }
+      void push_back(wchar_t a)
+      {
+        if (mLength == mCapacity)
+          reserve(mCapacity*2);
+        mData[mLength++] = a;
+        mData[mLength] = 0;
+      }
+      const wchar_t& operator[](int i) const { return mData[i]; }
+      wchar_t& operator[](int i) { return mData[i]; }
+      int length() const { return mLength; }
+      void resize(int size)
+      {
+        reserve(size);
+        for(int i=mLength; i<size; ++i)
+          mData[i] = 0;
+        mLength = size;
+        mData[mLength] = 0;
+      }
+      void reserve(int capacity)
+      {
+        if (capacity <= mCapacity)
+          return;
+        wchar_t* data = (wchar_t*)malloc(sizeof(wchar_t)*(capacity+1));
+        memcpy(data, mData, sizeof(wchar_t)*(mLength+1));
+        if (mData != mInline)
+          free(mData);
+        mData = data;
+        mCapacity = capacity;
+      }
       void squeeze()
       {
-        std::wstring new_string = mWString;
-        mWString.swap( new_string );
+        if (mData == mInline || mLength == mCapacity)
+          return;
+        wchar_t* data = mLength <= InlineCapacity ? mInline : (wchar_t*)malloc(sizeof(wchar_t)*(mLength+1));
+        memcpy(data, mData, sizeof(wchar_t)*(mLength+1));
+        free(mData);
+        mData = data;
+        mCapacity = data == mInline ? (int)InlineCapacity : mLength;
       }
+    private:
+      StringData& operator=(const StringData&) { return *this; }
     protected:
-      std::wstring mWString;
+      enum { InlineCapacity = 23 };
+      wchar_t* mData;
+      int mLength;
+      int mCapacity;
+      wchar_t mInline[InlineCapacity+1];
     };
 
     mutable ref<StringData> mString;
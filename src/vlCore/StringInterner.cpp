@@ -0,0 +1,109 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/StringInterner.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/checks.hpp>
+#include <map>
+#include <vector>
+
+using namespace vl;
+
+namespace
+{
+  struct InternTable
+  {
+    InternTable(): mMutex(NULL) {}
+
+    std::map<std::string, int> mIDs;
+    // points to the keys of mIDs, which never move
+    std::vector<const std::string*> mStrings;
+    IMutex* mMutex;
+  };
+
+  InternTable& internTable()
+  {
+    static InternTable table;
+    return table;
+  }
+}
+//-----------------------------------------------------------------------------
+int StringInterner::intern(const std::string& str)
+{
+  InternTable& table = internTable();
+  ScopedMutex lock(table.mMutex);
+  std::map<std::string, int>::iterator it = table.mIDs.lower_bound(str);
+  if (it != table.mIDs.end() && it->first == str)
+    return it->second;
+  int id = (int)table.mStrings.size();
+  it = table.mIDs.insert(it, std::make_pair(str, id));
+  table.mStrings.push_back(&it->first);
+  return id;
+}
+//-----------------------------------------------------------------------------
+int StringInterner::intern(const char* str)
+{
+  return intern(std::string(str ? str : ""));
+}
+//-----------------------------------------------------------------------------
+int StringInterner::find(const char* str)
+{
+  InternTable& table = internTable();
+  ScopedMutex lock(table.mMutex);
+  std::map<std::string, int>::const_iterator it = table.mIDs.find(str ? str : "");
+  return it != table.mIDs.end() ? it->second : -1;
+}
+//-----------------------------------------------------------------------------
+const std::string& StringInterner::string(int id)
+{
+  InternTable& table = internTable();
+  ScopedMutex lock(table.mMutex);
+  VL_CHECK(id >= 0 && id < (int)table.mStrings.size())
+  return *table.mStrings[id];
+}
+//-----------------------------------------------------------------------------
+int StringInterner::count()
+{
+  InternTable& table = internTable();
+  ScopedMutex lock(table.mMutex);
+  return (int)table.mStrings.size();
+}
+//-----------------------------------------------------------------------------
+void StringInterner::setMutex(IMutex* mutex)
+{
+  internTable().mMutex = mutex;
+}
+//-----------------------------------------------------------------------------
+IMutex* StringInterner::mutex()
+{
+  return internTable().mMutex;
+}
+//-----------------------------------------------------------------------------
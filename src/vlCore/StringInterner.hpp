@@ -0,0 +1,80 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef StringInterner_INCLUDE_ONCE
+#define StringInterner_INCLUDE_ONCE
+
+#include <vlCore/link_config.hpp>
+#include <vlCore/IMutex.hpp>
+#include <string>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // StringInterner
+  //-----------------------------------------------------------------------------
+  /**
+   * Global string table mapping names to small, stable integer IDs: the first string interned is 0, the second is 1 and so on.
+   *
+   * IDs are never recycled during the lifetime of the application, so they can be used to index flat per-name tables and
+   * to replace string comparisons with integer comparisons. Uniform and UniformBlock names, GLSLProgram uniform and
+   * attribute location caches are all keyed by interned IDs.
+   *
+   * \note The table is not thread-safe by default: install a mutex with setMutex() if strings are interned from more than one thread.
+   * \sa Uniform::nameID(), UniformBlock::nameID()
+  */
+  class VLCORE_EXPORT StringInterner
+  {
+  public:
+    //! Returns the ID of the given string, adding it to the table if needed.
+    static int intern(const char* str);
+
+    //! Returns the ID of the given string, adding it to the table if needed.
+    static int intern(const std::string& str);
+
+    //! Returns the ID of the given string or -1 if it has never been interned.
+    static int find(const char* str);
+
+    //! Returns the string corresponding to the given ID.
+    static const std::string& string(int id);
+
+    //! The number of strings interned so far.
+    static int count();
+
+    //! The mutex protecting the table, required if strings are interned by more than one thread. See also vl::IMutex.
+    static void setMutex(IMutex* mutex);
+
+    //! The mutex protecting the table, required if strings are interned by more than one thread. See also vl::IMutex.
+    static IMutex* mutex();
+  };
+}
+
+#endif
@@ -32,9 +32,82 @@
 #include <vlCore/TextStream.hpp>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 
 using namespace vl;
 
+bool TextStream::readLineView(const char*& line, int& length)
+{
+  line = "";
+  length = 0;
+
+  if ( !inputFile()->isOpen() )
+    if(!inputFile()->open(OM_ReadOnly))
+      return false;
+
+  // characters pushed back by ungetToken() are read by the character based reader
+  if ( !mUngetBuffer.empty() )
+  {
+    bool ok = readLine(mLine);
+    line = mLine.c_str();
+    length = (int)mLine.size();
+    return ok;
+  }
+
+  mLine.clear();
+  bool ok = false;
+  for(;;)
+  {
+    if ( bufferEmpty() && !fillBuffer() )
+    {
+      mIsEndOfFile = true;
+      line = mLine.c_str();
+      length = (int)mLine.size();
+      return ok;
+    }
+    ok = true;
+
+    const char* begin = (const char*)&mBuffer[0] + mPtr;
+    const char* end   = (const char*)&mBuffer[0] + mSize;
+    const char* eol   = (const char*)memchr(begin, '\n', end - begin);
+    const char* cr    = (const char*)memchr(begin, '\r', (eol ? eol : end) - begin);
+    if (cr)
+      eol = cr;
+
+    if ( !eol )
+    {
+      // the line continues in the next chunk
+      mLine.append(begin, end);
+      mPtr = mSize;
+      continue;
+    }
+
+    mPtr += (int)(eol - begin) + 1;
+
+    if ( mLine.empty() && mPtr < mSize )
+    {
+      // the whole line and the following character are in the buffer: no copy needed
+      line = begin;
+      length = (int)(eol - begin);
+      char next = (char)mBuffer[mPtr];
+      if ( (next == '\r' || next == '\n') && next != *eol )
+        ++mPtr;
+      return true;
+    }
+
+    // reading the next character might refill the buffer so the line is copied first
+    mLine.append(begin, eol);
+    char first = *eol;
+    unsigned char next = 0;
+    if ( readToken(&next) && ( (next != '\r' && next != '\n') || next == first ) )
+      --mPtr;
+    line = mLine.c_str();
+    length = (int)mLine.size();
+    return true;
+  }
+}
+
 bool TextStream::readInt(int& i, bool hex)
 {
   bool ok = readStdString(mTmpStdStr);
@@ -43,6 +116,7 @@ bool TextStream::readInt(int& i, bool hex)
   if (hex)
     sscanf(mTmpStdStr.c_str(), "%x", &i);
   else
+  if ( !parseInt(mTmpStdStr.c_str(), mTmpStdStr.c_str() + mTmpStdStr.size(), i) )
     i = atoi(mTmpStdStr.c_str());
   return ok;
 }
@@ -52,7 +126,118 @@ bool TextStream::readDouble(double& d)
   bool ok = readStdString(mTmpStdStr);
   if (mTmpStdStr.empty())
     return false;
-  d = atof( mTmpStdStr.c_str() );
+  // atof() handles the special cases like "inf" and "nan"
+  if ( !parseDouble(mTmpStdStr.c_str(), mTmpStdStr.c_str() + mTmpStdStr.size(), d) )
+    d = atof( mTmpStdStr.c_str() );
   return ok;
 }
 
+const char* TextStream::parseDouble(const char* p, const char* end, double& value)
+{
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  bool negative = false;
+  if ( p < end && (*p == '-' || *p == '+') )
+  {
+    negative = *p == '-';
+    ++p;
+  }
+
+  // digits beyond the 18th do not affect a double and are dropped
+  const unsigned long long MAX_MANTISSA = 100000000000000000ULL;
+  unsigned long long mantissa = 0;
+  int exponent = 0;
+  bool digits = false;
+
+  for( ; p < end && *p >= '0' && *p <= '9'; ++p )
+  {
+    digits = true;
+    if ( mantissa < MAX_MANTISSA )
+      mantissa = mantissa * 10 + (*p - '0');
+    else
+      ++exponent;
+  }
+
+  if ( p < end && *p == '.' )
+  {
+    for( ++p; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+      digits = true;
+      if ( mantissa < MAX_MANTISSA )
+      {
+        mantissa = mantissa * 10 + (*p - '0');
+        --exponent;
+      }
+    }
+  }
+
+  if ( !digits )
+    return NULL;
+
+  if ( p < end && (*p == 'e' || *p == 'E') )
+  {
+    const char* q = p + 1;
+    bool negative_exp = false;
+    if ( q < end && (*q == '-' || *q == '+') )
+    {
+      negative_exp = *q == '-';
+      ++q;
+    }
+    // the exponent is valid only if followed by at least a digit
+    if ( q < end && *q >= '0' && *q <= '9' )
+    {
+      int exp = 0;
+      for( ; q < end && *q >= '0' && *q <= '9'; ++q )
+        if ( exp < 10000 )
+          exp = exp * 10 + (*q - '0');
+      exponent += negative_exp ? -exp : exp;
+      p = q;
+    }
+  }
+
+  double d = (double)mantissa;
+  if ( exponent && mantissa )
+  {
+    // exact when both the mantissa and the power of ten are exactly representable
+    if ( mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22 )
+      d = exponent < 0 ? d / pow10[-exponent] : d * pow10[exponent];
+    else
+    // 10^-exponent would overflow to inf and flush the denormals to zero: divide in two steps
+    if ( exponent < -308 )
+      d = d / pow(10.0, 308) / pow(10.0, -exponent - 308);
+    else
+      d = exponent < 0 ? d / pow(10.0, -exponent) : d * pow(10.0, exponent);
+  }
+
+  value = negative ? -d : d;
+  return p;
+}
+
+const char* TextStream::parseInt(const char* p, const char* end, int& value)
+{
+  bool negative = false;
+  if ( p < end && (*p == '-' || *p == '+') )
+  {
+    negative = *p == '-';
+    ++p;
+  }
+
+  if ( p == end || *p < '0' || *p > '9' )
+    return NULL;
+
+  // the negative side reaches -2147483648
+  const long long limit = negative ? 0x80000000LL : 0x7FFFFFFFLL;
+  long long i = 0;
+  for( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    if ( i <= limit )
+      i = i * 10 + (*p - '0');
+
+  if ( i > limit )
+    i = limit;
+  value = (int)(negative ? -i : i);
+  return p;
+}
+
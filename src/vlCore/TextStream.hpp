@@ -165,10 +165,41 @@ namespace vl
       return !line.empty();
     }
 
+    /** Reads a CR or LF or CR/LF or LF/CR terminated line without copying it whenever possible.
+     * On return \p line points to the \p length characters of the line, which are not zero terminated and remain valid
+     * only until the next read operation. The line is located searching the internal buffer with memchr(). */
+    bool readLineView(const char*& line, int& length);
+
     bool readInt(int& i, bool hex=false);
 
     bool readDouble(double& d);
 
+    //! Returns the first character in [p, end) which is not a space or a tab.
+    static const char* skipSpaces(const char* p, const char* end)
+    {
+      while( p < end && (*p == ' ' || *p == '\t') )
+        ++p;
+      return p;
+    }
+
+    /** Locale independent parsing of a decimal floating point number in the form [+-]digits[.digits][(e|E)[+-]digits] starting at \p p.
+     * Returns the pointer to the first character after the number or NULL if no number could be parsed, in which case \p value is not modified.
+     * Numbers with up to 15 significant digits and a decimal exponent between -22 and 22 are converted exactly. */
+    static const char* parseDouble(const char* p, const char* end, double& value);
+
+    //! Same as parseDouble() but for floats.
+    static const char* parseFloat(const char* p, const char* end, float& value)
+    {
+      double d = 0;
+      p = parseDouble(p, end, d);
+      if (p)
+        value = (float)d;
+      return p;
+    }
+
+    //! Parses an integer in the form [+-]digits starting at \p p, clamped to [-2147483648, 2147483647]. Returns the pointer to the first character after the number or NULL.
+    static const char* parseInt(const char* p, const char* end, int& value);
+
     bool readString(String& token)
     {
       token.clear();
@@ -192,7 +223,8 @@ namespace vl
     {
       token.clear();
       unsigned char ch = 0;
-      while ( readToken(&ch) )
+      // characters pushed back by ungetToken() are read one by one
+      while ( !mUngetBuffer.empty() && readToken(&ch) )
       {
         if ( ch == '\r' || ch == '\n' || ch == '\t' || ch == ' ' )
         {
@@ -204,7 +236,32 @@ namespace vl
         else
           token += ch;
       }
-      return !token.empty();
+      // scan the buffer directly
+      for(;;)
+      {
+        if ( bufferEmpty() && !fillBuffer() )
+        {
+          mIsEndOfFile = true;
+          return !token.empty();
+        }
+        const unsigned char* base = &mBuffer[0];
+        const unsigned char* ptr  = base + mPtr;
+        const unsigned char* end  = base + mSize;
+        if ( token.empty() )
+          while( ptr < end && (*ptr == '\r' || *ptr == '\n' || *ptr == '\t' || *ptr == ' ') )
+            ++ptr;
+        const unsigned char* start = ptr;
+        while( ptr < end && *ptr != '\r' && *ptr != '\n' && *ptr != '\t' && *ptr != ' ' )
+          ++ptr;
+        token.append( (const char*)start, ptr - start );
+        mPtr = (int)(ptr - base);
+        if ( ptr < end )
+        {
+          // eat the separator
+          ++mPtr;
+          return true;
+        }
+      }
     }
 
     bool readQuotedString(String& token)
@@ -234,6 +291,7 @@ namespace vl
   protected:
     String mTmpStr;
     std::string mTmpStdStr;
+    std::string mLine;
   };
 //-----------------------------------------------------------------------------
 }
@@ -141,6 +141,36 @@ real Time::currentTime()
   #endif
 }
 //-----------------------------------------------------------------------------
+unsigned long long Time::currentMicroseconds()
+{
+  if (gStartTime == 0)
+    initStartTime();
+
+  VL_CHECK(gStartTime);
+
+  #if defined(VL_PLATFORM_WINDOWS)
+    // Win32
+    LARGE_INTEGER Frequency;
+    LARGE_INTEGER PerformanceCount;
+    BOOL has_timer = QueryPerformanceFrequency( &Frequency );
+    if (has_timer)
+    {
+      QueryPerformanceCounter( &PerformanceCount );
+      unsigned long long ticks = PerformanceCount.QuadPart - gStartTime;
+      // split to avoid overflowing the multiplication
+      return (ticks / Frequency.QuadPart) * 1000000 + (ticks % Frequency.QuadPart) * 1000000 / Frequency.QuadPart;
+    }
+    else
+    {
+      return (unsigned long long)(GetTickCount() - gStartTime) * 1000;
+    }
+  #elif defined(__GNUG__)
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return (unsigned long long)tv.tv_sec * 1000000 + (unsigned long long)tv.tv_usec - gStartTime;
+  #endif
+}
+//-----------------------------------------------------------------------------
 void Time::sleep(unsigned int milliseconds)
 {
   #if defined(VL_PLATFORM_WINDOWS)
@@ -71,6 +71,9 @@ namespace vl
 
     static real currentTime();
 
+    //! Microseconds passed from the same origin of currentTime(), does not lose precision as the application runs.
+    static unsigned long long currentMicroseconds();
+
     static void sleep(unsigned int milliseconds);
 
     void start(int index=0) { mStart[index] = currentTime(); }
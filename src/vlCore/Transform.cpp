@@ -55,6 +55,21 @@ Transform::~Transform()
   }
 }
 //-----------------------------------------------------------------------------
+void Transform::computeDirtyWorldMatrices(Camera* camera)
+{
+  if ( mWorldMatrixDirty )
+  {
+    computeWorldMatrixRecursive(camera);
+  }
+  else
+  if ( mChildrenDirty )
+  {
+    mChildrenDirty = false;
+    for(size_t i=0; i<mChildren.size(); ++i)
+      mChildren[i]->computeDirtyWorldMatrices(camera);
+  }
+}
+//-----------------------------------------------------------------------------
 void Transform::translate(real x, real y, real z)
 {
   setLocalMatrix( mat4::getTranslation(x,y,z)*localMatrix() );
@@ -35,6 +35,7 @@
 #include <vlCore/vlnamespace.hpp>
 #include <vlCore/Object.hpp>
 #include <vlCore/Matrix4.hpp>
+#include <vlCore/DirtyTracker.hpp>
 #include <vector>
 #include <set>
 #include <algorithm>
@@ -61,6 +62,11 @@ namespace vl
     *
     * - Call computeWorldMatrix() / computeWorldMatrixRecursive() not at each frame but only if the local matrix has actually changed.
     *
+    * - For large hierarchies of which only a few Transforms are animated use computeDirtyWorldMatrices() instead of computeWorldMatrixRecursive()
+    *   (see also Rendering::setIncrementalTransformUpdate()): only the subtrees below the Transforms whose local matrix changed are visited and recomputed,
+    *   and since the other world matrices are left untouched their worldMatrixUpdateTick() does not change either, sparing the Actors
+    *   using them the recomputation of their bounds.
+    *
     * - Do not add a Transform hierarchy to vl::Rendering::transform() if such Transforms are not animated every frame.
     *
     * - Remember: VL does not require your Actors to have a Transform or such Transforms to be part of any hierarchy, it just expect that the
@@ -75,7 +81,7 @@ namespace vl
 
   public:
     /** Constructor. */
-    Transform(): mWorldMatrixUpdateTick(0), mAssumeIdentityWorldMatrix(false), mParent(NULL)
+    Transform(): mWorldMatrixUpdateTick(0), mAssumeIdentityWorldMatrix(false), mWorldMatrixDirty(true), mChildrenDirty(false), mParent(NULL)
     {
       VL_DEBUG_SET_OBJECT_NAME()
 
@@ -85,7 +91,7 @@ namespace vl
     }
 
     /** Constructor. The \p matrix parameter is used to set both the local and world matrix. */
-    Transform(const mat4& matrix): mWorldMatrixUpdateTick(0), mAssumeIdentityWorldMatrix(false), mParent(NULL)
+    Transform(const mat4& matrix): mWorldMatrixUpdateTick(0), mAssumeIdentityWorldMatrix(false), mWorldMatrixDirty(true), mChildrenDirty(false), mParent(NULL)
     {
       VL_DEBUG_SET_OBJECT_NAME()
 
@@ -139,6 +145,7 @@ namespace vl
     void setLocalMatrix(const mat4& m)
     {
       mLocalMatrix = m;
+      setWorldMatrixDirty();
     }
 
     /** The matrix representing the transform's local space. */
@@ -149,9 +156,11 @@ namespace vl
 
     /** The matrix representing the transform's local space.
         Use this non-const version to directly modify the local matrix.
-        Call computeWorldMatrix() after modifying the local matrix. */
+        Call computeWorldMatrix() after modifying the local matrix.
+        \note Since the matrix might be modified this flags the world matrix as dirty, see setWorldMatrixDirty(). */
     mat4& localMatrix()
     {
+      setWorldMatrixDirty();
       return mLocalMatrix;
     }
 
@@ -164,6 +173,17 @@ namespace vl
       ++mWorldMatrixUpdateTick;
     }
 
+    /** Like setWorldMatrix() but the worldMatrixUpdateTick() is incremented only if \p matrix differs from the current world matrix,
+      * so that the Actors using this Transform do not recompute their bounds needlessly. Used by computeWorldMatrix().
+      * Returns true if the world matrix changed. */
+    bool updateWorldMatrix(const mat4& matrix)
+    {
+      if ( matrix == mWorldMatrix )
+        return false;
+      setWorldMatrix(matrix);
+      return true;
+    }
+
     /** Returns the world matrix used for rendering. */
     const mat4& worldMatrix() const
     {
@@ -177,6 +197,7 @@ namespace vl
     {
       mLocalMatrix = matrix;
       setWorldMatrix(matrix);
+      DirtyTracker::markDirty();
     }
 
     /** Returns the internal update tick used to avoid unnecessary computations. The world matrix thick
@@ -191,41 +212,63 @@ namespace vl
       * Is usually used to save calculations for top Transforms with many sub-Transforms. */
     bool assumeIdentityWorldMatrix() { return mAssumeIdentityWorldMatrix; }
 
-    /** Computes the world matrix by concatenating the parent's world matrix with its own local matrix. */
+    /** Computes the world matrix by concatenating the parent's world matrix with its own local matrix.
+      * The worldMatrixUpdateTick() is incremented only if the world matrix actually changed, see updateWorldMatrix(). */
     virtual void computeWorldMatrix(Camera* /*camera*/ = NULL)
     {
       if( assumeIdentityWorldMatrix() )
       {
-        setWorldMatrix(mat4());
+        updateWorldMatrix(mat4());
       }
       else
       /* top Transforms are usually assumeIdentityWorldMatrix() == true for performance reasons */
       if( parent() && !parent()->assumeIdentityWorldMatrix() )
       {
-        setWorldMatrix( parent()->worldMatrix() * localMatrix() );
+        updateWorldMatrix( parent()->worldMatrix() * mLocalMatrix );
       }
       else
       {
-        setWorldMatrix( localMatrix() );
+        updateWorldMatrix( mLocalMatrix );
       }
     }
 
     /** Computes the world matrix by concatenating the parent's world matrix with its local matrix, recursively descending to the children. */
     void computeWorldMatrixRecursive(Camera* camera = NULL)
     {
+      mWorldMatrixDirty = false;
+      mChildrenDirty = false;
       computeWorldMatrix(camera);
       for(size_t i=0; i<mChildren.size(); ++i)
         mChildren[i]->computeWorldMatrixRecursive(camera);
     }
 
+    /** Like computeWorldMatrixRecursive() but only visits the subtrees containing Transforms flagged by setWorldMatrixDirty(),
+      * recomputing the world matrices of the flagged Transforms and of their descendants. The cost is proportional to the number
+      * of changed Transforms and to their depth instead of to the size of the hierarchy. */
+    void computeDirtyWorldMatrices(Camera* camera = NULL);
+
+    /** Flags the world matrix of this Transform and of its descendants as to be recomputed by the next computeDirtyWorldMatrices().
+      * Called automatically by setLocalMatrix(), by the non-const localMatrix() and by the functions adding children. */
+    void setWorldMatrixDirty()
+    {
+      DirtyTracker::markDirty();
+      mWorldMatrixDirty = true;
+      // the ancestors of a Transform with the flag set have always mChildrenDirty set
+      for(Transform* par = mParent; par && !par->mChildrenDirty; par = par->mParent)
+        par->mChildrenDirty = true;
+    }
+
+    /** Returns true if the world matrix is flagged to be recomputed by the next computeDirtyWorldMatrices(). */
+    bool worldMatrixDirty() const { return mWorldMatrixDirty; }
+
     /** Returns the matrix computed concatenating this Transform's local matrix with the local matrices of all its parents. */
     mat4 getComputedWorldMatrix()
     {
-      mat4 world = localMatrix();
+      mat4 world = mLocalMatrix;
       Transform* par = parent();
       while(par)
       {
-        world = par->localMatrix() * world;
+        world = par->mLocalMatrix * world;
         par = par->parent();
       }
       return world;
@@ -250,6 +293,7 @@ namespace vl
 
       mChildren.push_back(child);
       child->mParent = this;
+      child->setWorldMatrixDirty();
     }
 
     /** Adds \p count children transforms. */
@@ -266,6 +310,7 @@ namespace vl
         {
           VL_CHECK(children[i]->mParent == NULL);
           children[i]->mParent = this;
+          children[i]->setWorldMatrixDirty();
           (*ptr) = children[i];
         }
       }
@@ -285,6 +330,7 @@ namespace vl
           VL_CHECK(children[i]->mParent == NULL);
           ptr[i] = children[i];
           ptr[i]->mParent = this;
+          ptr[i]->setWorldMatrixDirty();
         }
       }
     }
@@ -310,6 +356,7 @@ namespace vl
       mChildren[index]->mParent = NULL;
       mChildren[index] = child;
       mChildren[index]->mParent = this;
+      mChildren[index]->setWorldMatrixDirty();
     }
 
     /** Returns the last child. */
@@ -432,6 +479,8 @@ namespace vl
     mat4 mWorldMatrix;
     long long mWorldMatrixUpdateTick;
     bool mAssumeIdentityWorldMatrix;
+    bool mWorldMatrixDirty;
+    bool mChildrenDirty;
     std::vector< ref<Transform> > mChildren;
     Transform* mParent;
   };
@@ -0,0 +1,203 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlCore/TransformKernels.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+void vl::transformPoints(const fmat4& m, const fvec3* in, fvec3* out, size_t count)
+{
+  const float* mm = m.ptr();
+#if defined(VL_SIMD_SSE2)
+  const __m128 c0 = _mm_loadu_ps(mm+0);
+  const __m128 c1 = _mm_loadu_ps(mm+4);
+  const __m128 c2 = _mm_loadu_ps(mm+8);
+  const __m128 c3 = _mm_loadu_ps(mm+12);
+  for(size_t i=0; i<count; ++i)
+  {
+    const float* p = in[i].ptr();
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+    r = _mm_add_ps(r, c3);
+    // stores exactly 3 floats so that out[i+1] is never overwritten before being read
+    float* o = out[i].ptr();
+    _mm_storel_pi((__m64*)o, r);
+    _mm_store_ss(o+2, _mm_movehl_ps(r, r));
+  }
+#elif defined(VL_SIMD_NEON)
+  const float32x4_t c0 = vld1q_f32(mm+0);
+  const float32x4_t c1 = vld1q_f32(mm+4);
+  const float32x4_t c2 = vld1q_f32(mm+8);
+  const float32x4_t c3 = vld1q_f32(mm+12);
+  for(size_t i=0; i<count; ++i)
+  {
+    const float* p = in[i].ptr();
+    float32x4_t r = vmulq_n_f32(c0, p[0]);
+    r = vaddq_f32(r, vmulq_n_f32(c1, p[1]));
+    r = vaddq_f32(r, vmulq_n_f32(c2, p[2]));
+    r = vaddq_f32(r, c3);
+    float* o = out[i].ptr();
+    vst1_f32(o, vget_low_f32(r));
+    o[2] = vgetq_lane_f32(r, 2);
+  }
+#else
+  for(size_t i=0; i<count; ++i)
+    out[i] = m * in[i];
+#endif
+}
+//-----------------------------------------------------------------------------
+void vl::transformPoints(const dmat4& m, const dvec3* in, dvec3* out, size_t count)
+{
+  const double* mm = m.ptr();
+#if defined(VL_SIMD_SSE2)
+  const __m128d c0 = _mm_loadu_pd(mm+0),  c0h = _mm_loadu_pd(mm+2);
+  const __m128d c1 = _mm_loadu_pd(mm+4),  c1h = _mm_loadu_pd(mm+6);
+  const __m128d c2 = _mm_loadu_pd(mm+8),  c2h = _mm_loadu_pd(mm+10);
+  const __m128d c3 = _mm_loadu_pd(mm+12), c3h = _mm_loadu_pd(mm+14);
+  for(size_t i=0; i<count; ++i)
+  {
+    const double* p = in[i].ptr();
+    const __m128d x = _mm_set1_pd(p[0]);
+    const __m128d y = _mm_set1_pd(p[1]);
+    const __m128d z = _mm_set1_pd(p[2]);
+    __m128d r  = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0,  x), _mm_mul_pd(c1,  y)), _mm_mul_pd(c2,  z)), c3);
+    __m128d rh = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0h, x), _mm_mul_pd(c1h, y)), _mm_mul_pd(c2h, z)), c3h);
+    double* o = out[i].ptr();
+    _mm_storeu_pd(o, r);
+    _mm_store_sd(o+2, rh);
+  }
+#elif defined(VL_SIMD_NEON64)
+  const float64x2_t c0 = vld1q_f64(mm+0),  c0h = vld1q_f64(mm+2);
+  const float64x2_t c1 = vld1q_f64(mm+4),  c1h = vld1q_f64(mm+6);
+  const float64x2_t c2 = vld1q_f64(mm+8),  c2h = vld1q_f64(mm+10);
+  const float64x2_t c3 = vld1q_f64(mm+12), c3h = vld1q_f64(mm+14);
+  for(size_t i=0; i<count; ++i)
+  {
+    const double* p = in[i].ptr();
+    float64x2_t r  = vaddq_f64(vaddq_f64(vaddq_f64(vmulq_n_f64(c0,  p[0]), vmulq_n_f64(c1,  p[1])), vmulq_n_f64(c2,  p[2])), c3);
+    float64x2_t rh = vaddq_f64(vaddq_f64(vaddq_f64(vmulq_n_f64(c0h, p[0]), vmulq_n_f64(c1h, p[1])), vmulq_n_f64(c2h, p[2])), c3h);
+    double* o = out[i].ptr();
+    vst1q_f64(o, r);
+    o[2] = vgetq_lane_f64(rh, 0);
+  }
+#else
+  for(size_t i=0; i<count; ++i)
+    out[i] = m * in[i];
+#endif
+}
+//-----------------------------------------------------------------------------
+void vl::transformPoints(const fmat4& m, const fvec4* in, fvec4* out, size_t count)
+{
+  // the fvec4 product is already specialized in Matrix4.hpp
+  for(size_t i=0; i<count; ++i)
+    out[i] = m * in[i];
+}
+//-----------------------------------------------------------------------------
+void vl::transformPoints(const dmat4& m, const dvec4* in, dvec4* out, size_t count)
+{
+  const double* mm = m.ptr();
+#if defined(VL_SIMD_AVX)
+  const __m256d c0 = _mm256_loadu_pd(mm+0);
+  const __m256d c1 = _mm256_loadu_pd(mm+4);
+  const __m256d c2 = _mm256_loadu_pd(mm+8);
+  const __m256d c3 = _mm256_loadu_pd(mm+12);
+  for(size_t i=0; i<count; ++i)
+  {
+    const double* p = in[i].ptr();
+    __m256d r = _mm256_mul_pd(c0, _mm256_set1_pd(p[0]));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c1, _mm256_set1_pd(p[1])));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c2, _mm256_set1_pd(p[2])));
+    r = _mm256_add_pd(r, _mm256_mul_pd(c3, _mm256_set1_pd(p[3])));
+    _mm256_storeu_pd(out[i].ptr(), r);
+  }
+#elif defined(VL_SIMD_SSE2)
+  const __m128d c0 = _mm_loadu_pd(mm+0),  c0h = _mm_loadu_pd(mm+2);
+  const __m128d c1 = _mm_loadu_pd(mm+4),  c1h = _mm_loadu_pd(mm+6);
+  const __m128d c2 = _mm_loadu_pd(mm+8),  c2h = _mm_loadu_pd(mm+10);
+  const __m128d c3 = _mm_loadu_pd(mm+12), c3h = _mm_loadu_pd(mm+14);
+  for(size_t i=0; i<count; ++i)
+  {
+    const double* p = in[i].ptr();
+    const __m128d x = _mm_set1_pd(p[0]);
+    const __m128d y = _mm_set1_pd(p[1]);
+    const __m128d z = _mm_set1_pd(p[2]);
+    const __m128d w = _mm_set1_pd(p[3]);
+    __m128d r  = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0,  x), _mm_mul_pd(c1,  y)), _mm_mul_pd(c2,  z)), _mm_mul_pd(c3,  w));
+    __m128d rh = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0h, x), _mm_mul_pd(c1h, y)), _mm_mul_pd(c2h, z)), _mm_mul_pd(c3h, w));
+    double* o = out[i].ptr();
+    _mm_storeu_pd(o, r);
+    _mm_storeu_pd(o+2, rh);
+  }
+#else
+  for(size_t i=0; i<count; ++i)
+    out[i] = m * in[i];
+#endif
+}
+//-----------------------------------------------------------------------------
+void vl::dotProducts(const fvec3& axis, const fvec3* in, float* out, size_t count)
+{
+  size_t i = 0;
+#if defined(VL_SIMD_SSE2)
+  // 4 points = 12 floats = 3 registers: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+  const float ax = axis.x(), ay = axis.y(), az = axis.z();
+  const __m128 a0 = _mm_setr_ps(ax, ay, az, ax);
+  const __m128 a1 = _mm_setr_ps(ay, az, ax, ay);
+  const __m128 a2 = _mm_setr_ps(az, ax, ay, az);
+  const float* p = reinterpret_cast<const float*>(in);
+  for(; i+4<=count; i+=4, p+=12)
+  {
+    const __m128 p0 = _mm_mul_ps(_mm_loadu_ps(p+0), a0);
+    const __m128 p1 = _mm_mul_ps(_mm_loadu_ps(p+4), a1);
+    const __m128 p2 = _mm_mul_ps(_mm_loadu_ps(p+8), a2);
+    // gathers the x, y and z products of the 4 points
+    const __m128 u = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2,1,3,2));
+    const __m128 x = _mm_shuffle_ps(p0, u,  _MM_SHUFFLE(2,0,3,0));
+    const __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0,0,1,1)), u,  _MM_SHUFFLE(3,1,2,0));
+    const __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1,1,2,2)), p2, _MM_SHUFFLE(3,0,2,0));
+    _mm_storeu_ps(out+i, _mm_add_ps(_mm_add_ps(x, y), z));
+  }
+#elif defined(VL_SIMD_NEON)
+  const float* p = reinterpret_cast<const float*>(in);
+  for(; i+4<=count; i+=4, p+=12)
+  {
+    float32x4x3_t v = vld3q_f32(p);
+    float32x4_t r = vmulq_n_f32(v.val[0], axis.x());
+    r = vaddq_f32(r, vmulq_n_f32(v.val[1], axis.y()));
+    r = vaddq_f32(r, vmulq_n_f32(v.val[2], axis.z()));
+    vst1q_f32(out+i, r);
+  }
+#endif
+  for(; i<count; ++i)
+    out[i] = dot(axis, in[i]);
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef TransformKernels_INCLUDE_ONCE
+#define TransformKernels_INCLUDE_ONCE
+
+#include <vlCore/Matrix4.hpp>
+
+namespace vl
+{
+  /** \file TransformKernels.hpp
+   * Batched transformation of arrays of points and vectors.
+   *
+   * The fmat4 and dmat4 versions use SSE2/AVX/NEON when VL_SIMD is enabled (see SIMD.hpp) and produce the same results
+   * as transforming each element with the Matrix4 operators, i.e. as vl::ArrayAbstract::transform() always did.
+   * \p in and \p out can point to the same array. */
+
+  //! out[i] = (m * vec4(in[i], 1)).xyz()
+  VLCORE_EXPORT void transformPoints(const fmat4& m, const fvec3* in, fvec3* out, size_t count);
+  //! out[i] = (m * vec4(in[i], 1)).xyz()
+  VLCORE_EXPORT void transformPoints(const dmat4& m, const dvec3* in, dvec3* out, size_t count);
+  //! out[i] = m * in[i]
+  VLCORE_EXPORT void transformPoints(const fmat4& m, const fvec4* in, fvec4* out, size_t count);
+  //! out[i] = m * in[i]
+  VLCORE_EXPORT void transformPoints(const dmat4& m, const dvec4* in, dvec4* out, size_t count);
+
+  //! out[i] = dot(axis, in[i]), for example to compute the eye space depth of a set of vertices.
+  VLCORE_EXPORT void dotProducts(const fvec3& axis, const fvec3* in, float* out, size_t count);
+}
+
+#endif
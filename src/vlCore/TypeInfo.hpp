@@ -77,6 +77,29 @@ namespace vl
 #define VL_GROUP(...) __VA_ARGS__
 #define VL_TO_STR(...) #__VA_ARGS__
 //---------------------------------------------------------------------------------------------------------------------
+// Adds to the instrumented classes the per-class live instance counting of vl::ObjectInstrumentation.
+#ifdef VL_OBJECT_INSTRUMENTATION
+  #include <vlCore/ObjectInstrumentation.hpp>
+#define VL_INSTRUMENT_INSTANCE_COUNTER                                                                                     \
+public:                                                                                                                    \
+  /** Returns the live instance counter of the class, see vl::ObjectInstrumentation. */                                    \
+  static ::vl::ClassInstanceCounter& InstanceCounter()                                                                     \
+  {                                                                                                                        \
+    static ::vl::ClassInstanceCounter counter(Name());                                                                     \
+    return counter;                                                                                                        \
+  }                                                                                                                        \
+private:                                                                                                                   \
+  struct InstanceCounterMember                                                                                             \
+  {                                                                                                                        \
+    InstanceCounterMember() { InstanceCounter().created(); }                                                               \
+    InstanceCounterMember(const InstanceCounterMember&) { InstanceCounter().created(); }                                   \
+    InstanceCounterMember& operator=(const InstanceCounterMember&) { return *this; }                                       \
+    ~InstanceCounterMember() { InstanceCounter().destroyed(); }                                                            \
+  } mInstanceCounterMember;
+#else
+  #define VL_INSTRUMENT_INSTANCE_COUNTER
+#endif
+//---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_BASE_CLASS(ClassName)                                                                                \
 public:                                                                                                                    \
   /* static functions */                                                                                                   \
@@ -96,6 +119,7 @@ public:
     return type == Type();                                                                                                 \
   }                                                                                                                        \
   /* virtual Object* createThisType() const { return new ClassName; }                                              */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_ABSTRACT_BASE_CLASS(ClassName)                                                                       \
@@ -117,6 +141,7 @@ public:
     return type == Type();                                                                                                 \
   }                                                                                                                        \
   /* virtual Object* createThisType() const = 0;                                                                   */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_CLASS(ClassName, BaseClass)                                                                          \
@@ -140,6 +165,7 @@ public:
     return type == Type() || super::isOfType(type);                                                                        \
   }                                                                                                                        \
   /* virtual Object* createThisType() const { return new ClassName; }                                              */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_ABSTRACT_CLASS(ClassName, BaseClass)                                                                 \
@@ -163,6 +189,7 @@ public:
     return type == Type() || super::isOfType(type);                                                                        \
   }                                                                                                                        \
   /* virtual Object* createThisType() const = 0;                                                                   */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_CLASS_2(ClassName, BaseClass1, BaseClass2)                                                           \
@@ -187,6 +214,7 @@ public:
     return type == Type() || super1::isOfType(type) || super2::isOfType(type);                                             \
   }                                                                                                                        \
   /* virtual Object* createThisType() const { return new ClassName; }                                              */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 #define VL_INSTRUMENT_ABSTRACT_CLASS_2(ClassName, BaseClass1, BaseClass2)                                                  \
@@ -211,6 +239,7 @@ public:
     return type == Type() || super1::isOfType(type) || super2::isOfType(type);                                             \
   }                                                                                                                        \
   /* virtual Object* createThisType() const = 0;                                                                   */      \
+  VL_INSTRUMENT_INSTANCE_COUNTER                                                                                           \
 private:
 //---------------------------------------------------------------------------------------------------------------------
 namespace vl
@@ -51,6 +51,7 @@ bool VirtualDirectory::setPath(const String& name)
   }
 
   mPath = root;
+  invalidatePathIndex();
   return true;
 }
 //-----------------------------------------------------------------------------
@@ -72,3 +73,25 @@ String VirtualDirectory::translatePath(const String& p) const
   }
 }
 //-----------------------------------------------------------------------------
+void VirtualDirectory::buildPathIndex() const
+{
+  std::vector<String> file_list;
+  listFilesRecursive(file_list);
+  mPathIndex.clear();
+  for(size_t i=0; i<file_list.size(); ++i)
+    mPathIndex.insert( file_list[i].normalizeSlashes() );
+  mPathIndexBuilt = true;
+}
+//-----------------------------------------------------------------------------
+ref<VirtualFile> VirtualDirectory::lookupFile(const String& name) const
+{
+  if ( mPathIndexing )
+  {
+    if ( !mPathIndexBuilt )
+      buildPathIndex();
+    if ( mPathIndex.find( translatePath(name) ) == mPathIndex.end() )
+      return NULL;
+  }
+  return file(name);
+}
+//-----------------------------------------------------------------------------
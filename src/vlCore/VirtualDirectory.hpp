@@ -37,6 +37,7 @@
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
 #include <vlCore/VirtualFile.hpp>
+#include <set>
 
 namespace vl
 {
@@ -60,11 +61,11 @@ namespace vl
 
   public:
     //! Constructor
-    VirtualDirectory(): mPath("/") {}
+    VirtualDirectory(): mPath("/"), mPathIndexing(false), mPathIndexBuilt(false) {}
 
     //! Constructor
     //! \param path Defines the path name of the virtual dirctory, must be a non empty string.
-    VirtualDirectory( const String& path ): mPath(path) {}
+    VirtualDirectory( const String& path ): mPath(path), mPathIndexing(false), mPathIndexBuilt(false) {}
 
     //! Changes the \p path \p name of a VirtualDirectory. Must not be an empty string.
     virtual bool setPath(const String& path);
@@ -96,11 +97,31 @@ namespace vl
 
     virtual ref<VirtualDirectory> subDir(const String& subdir_name) const  = 0;
 
+    //! If enabled lookupFile() checks an index of the files listed by listFilesRecursive() before calling file(), so that
+    //! looking up a missing file does not touch the underlying storage. The index is built on first use or by buildPathIndex()
+    //! and must be discarded with invalidatePathIndex() when files are added or removed. Disabled by default.
+    void setPathIndexing(bool enabled) { mPathIndexing = enabled; if (!enabled) invalidatePathIndex(); }
+
+    //! Whether lookupFile() uses the path index, see setPathIndexing().
+    bool pathIndexing() const { return mPathIndexing; }
+
+    //! Builds the path index now, see setPathIndexing(). Call it before looking up files from multiple threads.
+    void buildPathIndex() const;
+
+    //! Discards the path index, which is rebuilt by the next lookupFile(), see setPathIndexing().
+    void invalidatePathIndex() const { mPathIndex.clear(); mPathIndexBuilt = false; }
+
+    //! Equivalent to file() but if pathIndexing() is enabled the paths missing from the index return NULL without calling file().
+    ref<VirtualFile> lookupFile(const String& name) const;
+
   protected:
     String translatePath(const String& p) const;
 
   protected:
     String mPath;
+    mutable std::set<String> mPathIndex;
+    bool mPathIndexing;
+    mutable bool mPathIndexBuilt;
   };
 }
 
@@ -40,7 +40,11 @@
 
 namespace vl
 {
+  class FrameProfiler;
+
   //! Used to initialize/shutdown VisualizationLibrary and to access important global data.
+  //! The heavyweight subsystems are initialized on first use: the standard ResourceLoadWriter[s] are registered the first time
+  //! a resource is loaded or written (see LoadWriterManager::addLazyRegistration()) and FreeType the first time a Font is loaded.
   class VisualizationLibrary
   {
   public:
@@ -58,6 +62,10 @@ namespace vl
     //! Returns true if VLGraphics library is initialized and shutdown has not been called.
     VLMAIN_EXPORT static bool isGraphicsInitialized();
 
+    //! The CPU time breakdown of init(), one FrameProfiler frame with a scope per subsystem, see FrameProfiler::report().
+    //! Also logged by init() at vl::VEL_VERBOSITY_DEBUG. Released by shutdown().
+    VLMAIN_EXPORT static FrameProfiler* startupProfiler();
+
   private:
     VLMAIN_EXPORT static void initCore(bool log_info=true);
     VLMAIN_EXPORT static void shutdownCore();
@@ -32,13 +32,15 @@
 #include <vlCore/ZippedDirectory.hpp>
 #include <vlCore/VisualizationLibrary.hpp>
 #include <vlCore/FileSystem.hpp>
+#include <vlCore/MemoryFile.hpp>
+#include <vlCore/ScopedMutex.hpp>
 #include <set>
 
 using namespace vl;
 //-----------------------------------------------------------------------------
-ZippedDirectory::ZippedDirectory() {}
+ZippedDirectory::ZippedDirectory(): mCacheUsed(0), mCacheBudget(0), mMutex(NULL) {}
 //-----------------------------------------------------------------------------
-ZippedDirectory::ZippedDirectory(const String& zip_file)
+ZippedDirectory::ZippedDirectory(const String& zip_file): mCacheUsed(0), mCacheBudget(0), mMutex(NULL)
 {
   ref<VirtualFile> v_file = defFileSystem()->locateFile(zip_file);
   if (v_file)
@@ -47,7 +49,7 @@ ZippedDirectory::ZippedDirectory(const String& zip_file)
     Log::error( Say("ZippedDirectory() could not locate zip file '%s'.\n") << zip_file );
 }
 //-----------------------------------------------------------------------------
-ZippedDirectory::ZippedDirectory(VirtualFile* zip_file)
+ZippedDirectory::ZippedDirectory(VirtualFile* zip_file): mCacheUsed(0), mCacheBudget(0), mMutex(NULL)
 {
   if (zip_file)
     setSourceZipFile(zip_file);
@@ -84,6 +86,8 @@ bool ZippedDirectory::setPath(const String& name)
   }
   mFiles = file_map;
   mPath = root;
+  // the cache is keyed by path
+  clearCache();
   return true;
 }
 //-----------------------------------------------------------------------------
@@ -109,6 +113,7 @@ void ZippedDirectory::reset()
 {
   mSourceZipFile = NULL;
   mFiles.clear();
+  clearCache();
 }
 //-----------------------------------------------------------------------------
 bool ZippedDirectory::init()
@@ -247,7 +252,149 @@ bool ZippedDirectory::init()
 //-----------------------------------------------------------------------------
 ref<VirtualFile> ZippedDirectory::file(const String& name) const
 {
-  return zippedFile(name);
+  if ( !mCacheBudget )
+    return zippedFile(name);
+
+  String p = translatePath(name);
+  ref<Buffer> buffer = findCached(p);
+  if ( !buffer )
+  {
+    ref<ZippedFile> zfile = zippedFile(name);
+    if ( !zfile || zfile->size() > mCacheBudget )
+      return zfile;
+    buffer = new Buffer;
+    buffer->resize( (size_t)zfile->size() );
+    if ( !zfile->extract( (char*)buffer->ptr() ) )
+      return zfile;
+    insertCached(p, buffer.get());
+  }
+
+  ref<MemoryFile> mem_file = new MemoryFile;
+  mem_file->setBuffer( buffer.get() );
+  mem_file->setPath( p );
+  return mem_file;
+}
+//-----------------------------------------------------------------------------
+ref<Buffer> ZippedDirectory::findCached(const String& path) const
+{
+  ScopedMutex lock(mMutex);
+  std::map< String, std::list<CacheEntry>::iterator >::const_iterator it = mCacheEntries.find(path);
+  if ( it == mCacheEntries.end() )
+    return NULL;
+  mCacheLRU.splice( mCacheLRU.begin(), mCacheLRU, it->second );
+  return it->second->mBuffer;
+}
+//-----------------------------------------------------------------------------
+void ZippedDirectory::insertCached(const String& path, Buffer* buffer) const
+{
+  ScopedMutex lock(mMutex);
+  if ( mCacheEntries.find(path) != mCacheEntries.end() )
+    return;
+  CacheEntry entry;
+  entry.mPath = path;
+  entry.mBuffer = buffer;
+  mCacheLRU.push_front(entry);
+  mCacheEntries[path] = mCacheLRU.begin();
+  mCacheUsed += buffer->bytesUsed();
+  trimCache();
+}
+//-----------------------------------------------------------------------------
+void ZippedDirectory::trimCache() const
+{
+  // evicted buffers stay alive as long as a MemoryFile refers to them
+  while( mCacheUsed > mCacheBudget && !mCacheLRU.empty() )
+  {
+    mCacheUsed -= mCacheLRU.back().mBuffer->bytesUsed();
+    mCacheEntries.erase( mCacheLRU.back().mPath );
+    mCacheLRU.pop_back();
+  }
+}
+//-----------------------------------------------------------------------------
+void ZippedDirectory::setCacheBudget(long long bytes)
+{
+  ScopedMutex lock(mMutex);
+  mCacheBudget = bytes;
+  trimCache();
+}
+//-----------------------------------------------------------------------------
+void ZippedDirectory::clearCache()
+{
+  ScopedMutex lock(mMutex);
+  mCacheLRU.clear();
+  mCacheEntries.clear();
+  mCacheUsed = 0;
+}
+//-----------------------------------------------------------------------------
+int ZippedDirectory::prefetch(const std::vector<String>& names)
+{
+  if ( !mCacheBudget )
+    return 0;
+
+  // each ZippedFile returned by zippedFile() reads from its own clone of the source zip file
+  std::vector< String > paths;
+  std::vector< ref<ZippedFile> > files;
+  for(size_t i=0; i<names.size(); ++i)
+  {
+    String p = translatePath(names[i]);
+    if ( findCached(p) )
+      continue;
+    ref<ZippedFile> zfile = zippedFile(names[i]);
+    if ( !zfile || zfile->size() > mCacheBudget )
+      continue;
+    paths.push_back(p);
+    files.push_back(zfile);
+  }
+
+  std::vector< ref<Buffer> > buffers( files.size() );
+  for(size_t i=0; i<files.size(); ++i)
+  {
+    buffers[i] = new Buffer;
+    buffers[i]->resize( (size_t)files[i]->size() );
+  }
+
+  int count = (int)files.size();
+  #pragma omp parallel for schedule(dynamic)
+  for(int i=0; i<count; ++i)
+  {
+    if ( !files[i]->extract( (char*)buffers[i]->ptr() ) )
+      buffers[i] = NULL;
+  }
+
+  for(int i=0; i<count; ++i)
+  {
+    if ( buffers[i] )
+      insertCached(paths[i], buffers[i].get());
+  }
+
+  int cached = 0;
+  for(size_t i=0; i<names.size(); ++i)
+  {
+    if ( findCached( translatePath(names[i]) ) )
+      ++cached;
+  }
+  return cached;
+}
+//-----------------------------------------------------------------------------
+bool ZippedDirectory::buildSeekIndex(long long min_size, long long span)
+{
+  std::vector< ref<ZippedFile> > files;
+  for( std::map< String, ref<ZippedFile> >::const_iterator it = mFiles.begin(); it != mFiles.end(); ++it )
+  {
+    const ZippedFileInfo* info = it->second->zippedFileInfo();
+    if ( info && info->compressionMethod() == 8 && info->uncompressedSize() >= min_size )
+      files.push_back( zippedFile(it->first) );
+  }
+
+  int count = (int)files.size();
+  int failed = 0;
+  #pragma omp parallel for schedule(dynamic) reduction(+:failed)
+  for(int i=0; i<count; ++i)
+  {
+    if ( !files[i] || !files[i]->buildSeekIndex(span) )
+      ++failed;
+  }
+
+  return failed == 0;
 }
 //-----------------------------------------------------------------------------
 int ZippedDirectory::zippedFileCount() const
@@ -35,7 +35,10 @@
 #include <vlCore/VirtualDirectory.hpp>
 #include <vlCore/DiskFile.hpp>
 #include <vlCore/ZippedFile.hpp>
+#include <vlCore/Buffer.hpp>
+#include <vlCore/IMutex.hpp>
 #include <algorithm>
+#include <list>
 
 namespace vl
 {
@@ -45,6 +48,10 @@ namespace vl
   /**
    * A VirtualDirectory capable of reading files from a .zip file.
    *
+   * When a cache budget is set with setCacheBudget() the inflated files are kept in memory and file() returns a MemoryFile
+   * sharing the cached data, which makes a ZippedDirectory usable as a fast asset store. Use prefetch() to inflate
+   * a set of files in parallel and buildSeekIndex() to allow fast random access to big deflated files.
+   *
    * \sa
    * - VirtualDirectory
    * - DiskDirectory
@@ -77,6 +84,7 @@ namespace vl
     //! Sets the source zip file to NULL and disposes all the files contained in this directory.
     void reset();
 
+    //! Returns a MemoryFile sharing the cached content of the file if the cache is enabled, a ZippedFile otherwise.
     ref<VirtualFile> file(const String& name) const;
 
     //! Accepts absolute and relative paths
@@ -98,12 +106,57 @@ namespace vl
 
   bool isCorrupted();
 
+    /** Builds the seek index of every deflated file bigger than \p min_size, see ZippedFile::buildSeekIndex().
+     * The files are indexed in parallel if OpenMP is enabled. Returns false if any of the files could not be indexed. */
+    bool buildSeekIndex(long long min_size = 4*1024*1024, long long span = 1024*1024);
+
+    /** Inflates the given files in parallel (if OpenMP is enabled) and stores them in the cache.
+     * Returns the number of files that are in the cache after the call. Does nothing if the cache is disabled. */
+    int prefetch(const std::vector<String>& names);
+
+    //! The maximum number of bytes of inflated files kept in memory, 0 (default) disables the cache.
+    void setCacheBudget(long long bytes);
+
+    //! The maximum number of bytes of inflated files kept in memory, 0 (default) disables the cache.
+    long long cacheBudget() const { return mCacheBudget; }
+
+    //! The number of bytes of inflated files currently kept in memory.
+    long long cacheUsed() const { return mCacheUsed; }
+
+    //! Removes all the files from the cache.
+    void clearCache();
+
+    //! The mutex protecting the cache, required if file() is called by multiple threads. See also vl::IMutex.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex protecting the cache, required if file() is called by multiple threads. See also vl::IMutex.
+    IMutex* mutex() const { return mMutex; }
+
   protected:
     bool init();
 
+    ref<Buffer> findCached(const String& path) const;
+
+    void insertCached(const String& path, Buffer* buffer) const;
+
+    void trimCache() const;
+
+  protected:
+    struct CacheEntry
+    {
+      String mPath;
+      ref<Buffer> mBuffer;
+    };
+
   protected:
     std::map< String, ref<ZippedFile> > mFiles;
     ref<VirtualFile> mSourceZipFile;
+    // front = most recently used
+    mutable std::list<CacheEntry> mCacheLRU;
+    mutable std::map< String, std::list<CacheEntry>::iterator > mCacheEntries;
+    mutable long long mCacheUsed;
+    long long mCacheBudget;
+    IMutex* mMutex;
   };
 
 }
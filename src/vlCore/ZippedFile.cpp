@@ -469,6 +469,23 @@ void ZippedFile::resetStream()
 //-----------------------------------------------------------------------------
 bool ZippedFile::seekSet_Implementation(long long pos)
 {
+  // stored files are seeked directly in the source zip file
+  if ( zippedFileInfo()->compressionMethod() == 0 && isOpen() )
+  {
+    if ( !zippedFileInfo()->sourceZipFile()->seekSet( zippedFileInfo()->zippedFileOffset() + pos ) )
+      return false;
+    mReadBytes = pos;
+    return true;
+  }
+
+  // restart from the nearest checkpoint if it is closer than the current position
+  const ZippedFileSeekIndex::Point* point = zippedFileInfo()->seekIndex() ? zippedFileInfo()->seekIndex()->find(pos) : NULL;
+  if ( point && isOpen() && ( pos < position() || point->mUncompressedOffset > position() ) )
+  {
+    if ( !seekCheckpoint(point) )
+      resetStream();
+  }
+  else
   if (pos<position())
     resetStream();
 
@@ -481,6 +498,165 @@ bool ZippedFile::seekSet_Implementation(long long pos)
   return position() == pos;
 }
 //-----------------------------------------------------------------------------
+bool ZippedFile::seekCheckpoint(const ZippedFileSeekIndex::Point* point)
+{
+  VirtualFile* zip = zippedFileInfo()->sourceZipFile();
+
+  // restart the inflate state
+  if ( mZStream->next_in != Z_NULL )
+    inflateEnd(mZStream);
+  memset(mZStream, 0, sizeof(z_stream_s));
+  mUncompressedBufferPtr = 0;
+  mUncompressedBuffer.clear();
+  if ( inflateInit2(mZStream, -15) != Z_OK )
+    return false;
+  // makes close() release the inflate state
+  mZStream->next_in = mZipBufferIn;
+
+  // the checkpoint can start in the middle of a byte
+  long long compressed_offset = point->mCompressedOffset - (point->mBits ? 1 : 0);
+  if ( !zip->seekSet( zippedFileInfo()->zippedFileOffset() + compressed_offset ) )
+    return false;
+  if ( point->mBits )
+  {
+    unsigned char byte = 0;
+    if ( zip->read(&byte, 1) != 1 )
+      return false;
+    inflatePrime( mZStream, point->mBits, byte >> (8 - point->mBits) );
+  }
+  if ( !point->mWindow.empty() )
+    inflateSetDictionary( mZStream, &point->mWindow[0], (uInt)point->mWindow.size() );
+
+  mReadBytes = point->mUncompressedOffset;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool ZippedFile::buildSeekIndex(long long span)
+{
+  ZippedFileInfo* zfile_info = zippedFileInfo();
+
+  if ( !zfile_info || !zfile_info->seekIndex() || zfile_info->compressionMethod() != 8 )
+    return false;
+
+  if ( isOpen() )
+  {
+    Log::error("ZippedFile::buildSeekIndex(): the file is already open.\n");
+    return false;
+  }
+
+  ref<VirtualFile> zip = zfile_info->sourceZipFile();
+  if ( !zip || zip->isOpen() || !zip->open(OM_ReadOnly) )
+  {
+    Log::error("ZippedFile::buildSeekIndex(): could not open source zip stream.\n");
+    return false;
+  }
+
+  if ( !zip->seekSet( zfile_info->zippedFileOffset() ) )
+  {
+    zip->close();
+    return false;
+  }
+
+  const int WINDOW_SIZE = ZippedFileSeekIndex::WINDOW_SIZE;
+  std::vector<unsigned char> in(CHUNK_SIZE);
+  std::vector<unsigned char> window(WINDOW_SIZE);
+  std::vector<ZippedFileSeekIndex::Point> points;
+
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  if ( inflateInit2(&strm, -15) != Z_OK )
+  {
+    zip->close();
+    return false;
+  }
+
+  // adapted from zlib's zran.c example
+  long long total_in = 0, total_out = 0, last = 0;
+  long long compressed_left = zfile_info->compressedSize();
+  int ret = Z_OK;
+  do
+  {
+    if ( compressed_left == 0 )
+    {
+      // Z_BLOCK stops at the end of the last block, one more call reaches the end of the stream
+      if ( strm.avail_out == 0 )
+      {
+        strm.avail_out = WINDOW_SIZE;
+        strm.next_out  = &window[0];
+      }
+      ret = inflate(&strm, Z_BLOCK);
+      if ( ret != Z_STREAM_END )
+        ret = Z_DATA_ERROR;
+      break;
+    }
+
+    long long bytes = compressed_left < CHUNK_SIZE ? compressed_left : CHUNK_SIZE;
+    strm.avail_in = (uInt)zip->read(&in[0], bytes);
+    compressed_left -= strm.avail_in;
+    if ( strm.avail_in == 0 )
+    {
+      ret = Z_DATA_ERROR;
+      break;
+    }
+    strm.next_in = &in[0];
+
+    do
+    {
+      // the output is discarded, we only keep the last 32KB in a circular window
+      if ( strm.avail_out == 0 )
+      {
+        strm.avail_out = WINDOW_SIZE;
+        strm.next_out  = &window[0];
+      }
+
+      total_in  += strm.avail_in;
+      total_out += strm.avail_out;
+      ret = inflate(&strm, Z_BLOCK);
+      total_in  -= strm.avail_in;
+      total_out -= strm.avail_out;
+
+      if ( ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR )
+        break;
+      if ( ret == Z_STREAM_END )
+        break;
+
+      // at the end of a deflate block which is not the last one
+      if ( (strm.data_type & 128) && !(strm.data_type & 64) && (total_out == 0 || total_out - last >= span) )
+      {
+        points.push_back( ZippedFileSeekIndex::Point() );
+        ZippedFileSeekIndex::Point& point = points.back();
+        point.mUncompressedOffset = total_out;
+        point.mCompressedOffset = total_in;
+        point.mBits = strm.data_type & 7;
+        if ( total_out )
+        {
+          // unroll the circular window
+          unsigned left = strm.avail_out;
+          point.mWindow.resize(WINDOW_SIZE);
+          if ( left )
+            memcpy( &point.mWindow[0], &window[0] + WINDOW_SIZE - left, left );
+          if ( left < (unsigned)WINDOW_SIZE )
+            memcpy( &point.mWindow[0] + left, &window[0], WINDOW_SIZE - left );
+        }
+        last = total_out;
+      }
+    } while ( strm.avail_in != 0 );
+  } while ( ret != Z_STREAM_END && ret != Z_NEED_DICT && ret != Z_DATA_ERROR && ret != Z_MEM_ERROR );
+
+  inflateEnd(&strm);
+  zip->close();
+
+  if ( ret != Z_STREAM_END )
+  {
+    Log::error( Say("ZippedFile::buildSeekIndex(): error inflating '%s'.\n") << path() );
+    return false;
+  }
+
+  zfile_info->seekIndex()->mPoints.swap(points);
+  zfile_info->seekIndex()->mSpan = span;
+  return true;
+}
+//-----------------------------------------------------------------------------
 long long ZippedFile::read_Implementation(void* buffer, long long bytes_to_read)
 {
   if ( bytes_to_read < 1 )
@@ -37,6 +37,55 @@ struct z_stream_s;
 
 namespace vl
 {
+//---------------------------------------------------------------------------
+// ZippedFileSeekIndex
+//---------------------------------------------------------------------------
+  /**
+   * Inflate checkpoints allowing a deflated ZippedFile to seek without re-inflating from the beginning.
+   * Each checkpoint stores the state needed to restart inflation at a deflate block boundary: the
+   * uncompressed and compressed offsets, the pending bits and the last 32KB of uncompressed data.
+   * \sa ZippedFile::buildSeekIndex(), ZippedDirectory::buildSeekIndex()
+  */
+  class ZippedFileSeekIndex: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ZippedFileSeekIndex, Object)
+
+  public:
+    static const int WINDOW_SIZE = 32768;
+
+    struct Point
+    {
+      long long mUncompressedOffset;
+      long long mCompressedOffset;
+      int mBits;
+      std::vector<unsigned char> mWindow;
+    };
+
+  public:
+    ZippedFileSeekIndex(): mSpan(0) {}
+
+    //! Returns the last checkpoint at or before the given uncompressed offset, NULL if the index is empty.
+    const Point* find(long long uncompressed_offset) const
+    {
+      const Point* point = NULL;
+      for(size_t i=0; i<mPoints.size() && mPoints[i].mUncompressedOffset <= uncompressed_offset; ++i)
+        point = &mPoints[i];
+      return point;
+    }
+
+    bool empty() const { return mPoints.empty(); }
+
+    //! The minimum distance in uncompressed bytes between two checkpoints.
+    long long span() const { return mSpan; }
+
+    //! The memory used by the index.
+    long long memoryUsed() const { return (long long)mPoints.size() * (sizeof(Point) + WINDOW_SIZE); }
+
+  public:
+    std::vector<Point> mPoints;
+    long long mSpan;
+  };
+
 //---------------------------------------------------------------------------
 // ZippedFileInfo
 //---------------------------------------------------------------------------
@@ -68,6 +117,8 @@ namespace vl
       mMonth = 0;
       mYear = 0;
       mZippedFileOffset = 0;
+      // shared by all the copies of this info, see ZippedFile::operator=()
+      mSeekIndex = new ZippedFileSeekIndex;
     }
 
   public:
@@ -93,6 +144,10 @@ namespace vl
     VirtualFile* sourceZipFile() { return mSourceZipFile.get(); }
     void setSourceZipFile(VirtualFile* file) { mSourceZipFile = file; }
 
+    // inflate checkpoints used to seek, empty until ZippedFile::buildSeekIndex() is called
+    const ZippedFileSeekIndex* seekIndex() const { return mSeekIndex.get(); }
+    ZippedFileSeekIndex* seekIndex() { return mSeekIndex.get(); }
+
   public:
     unsigned short mVersionNeeded;
     unsigned short mGeneralPurposeFlag;
@@ -113,6 +168,8 @@ namespace vl
     unsigned int mZippedFileOffset;
     // source stream used to seek and read the compressed zip data
     ref<VirtualFile> mSourceZipFile;
+    // inflate checkpoints used to seek
+    ref<ZippedFileSeekIndex> mSeekIndex;
   };
 //---------------------------------------------------------------------------
 // ZippedFile
@@ -162,6 +219,12 @@ namespace vl
 
     bool extract(char* destination, bool check_sum = true);
 
+    /** Inflates the whole file once recording a checkpoint every \p span uncompressed bytes, after which seekSet() restarts
+     * inflation from the nearest checkpoint instead of from the beginning of the file. The index is shared by all the
+     * ZippedFile[s] referring to the same entry of a ZippedDirectory. The file must not be open.
+     * Returns false on error or if the file is not deflated. */
+    bool buildSeekIndex(long long span = 1024*1024);
+
     ZippedFile& operator=(const ZippedFile& other)
     {
       close();
@@ -190,6 +253,8 @@ namespace vl
 
     virtual bool seekSet_Implementation(long long);
 
+    bool seekCheckpoint(const ZippedFileSeekIndex::Point* point);
+
   protected:
     ref<ZippedFileInfo> mZippedFileInfo;
     long long mReadBytes;
@@ -33,6 +33,7 @@
 #define HalfFloat_INCLUDE_ONCE
 
 #include <vlCore/Matrix4.hpp>
+#include <vlCore/SIMD.hpp>
 
 namespace vl
 {
@@ -261,203 +262,167 @@ namespace vl
     //---------------------------------------------------------------------------
     static void convertDoubleToHalf(const double* d, half* h, int count)
     {
-      for(int i=0; i<count; ++i)
-        h[i] = convertFloatToHalf((float)d[i]);
+      // goes through a small float buffer to use the vectorized float conversion
+      float f[256];
+      for(int i=0; i<count; i+=256)
+      {
+        const int n = count-i < 256 ? count-i : 256;
+        for(int j=0; j<n; ++j)
+          f[j] = (float)d[i+j];
+        convertFloatToHalf(f, h+i, n);
+      }
     }
     //---------------------------------------------------------------------------
     static void convertHalfToDouble(const half* h, double* d, int count)
     {
-      for(int i=0; i<count; ++i)
-        d[i] = (double)convertHalfToFloat(h[i]);
+      float f[256];
+      for(int i=0; i<count; i+=256)
+      {
+        const int n = count-i < 256 ? count-i : 256;
+        convertHalfToFloat(h+i, f, n);
+        for(int j=0; j<n; ++j)
+          d[i+j] = (double)f[j];
+      }
     }
     //---------------------------------------------------------------------------
+    //! Rounds to the nearest even value like the F16C and NEON conversion instructions, so that the
+    //! scalar and the vectorized paths produce the same bits. NaNs are converted to quiet NaNs keeping the
+    //! top 10 bits of their payload, like vcvtps2ph.
     static half convertFloatToHalf(float f)
     {
       union { float f; unsigned int x; } val;
       val.f = f;
-      unsigned int sign = (unsigned short)(val.x>>31);
-      unsigned int mantissa = val.x & ((1 << 23)-1);
-      unsigned int exp = val.x & FLOAT_MAX_BIASED_EXP;
-      typedef unsigned short hfloat;
+      const unsigned int sign = val.x & 0x80000000u;
+      val.x ^= sign;
       half hf;
 
-      if (exp >= HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP)
+      if (val.x >= HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP)
       {
-        // check if the original single precision float number is a NaN
-        if (mantissa && (exp == FLOAT_MAX_BIASED_EXP))
-        {
-          // we have a single precision NaN
-          mantissa = (1<<23) - 1;
-        }
-        else
-        {
-          // 16-bit half-float representation stores number as Inf
-          mantissa = 0;
-        }
-        hf.bits = (((hfloat)sign) << 15) | (hfloat)(HALF_FLOAT_MAX_BIASED_EXP) | (hfloat)(mantissa >> 13);
+        // too big for an half-float: Inf or NaN
+        hf.bits = (unsigned short)(val.x > FLOAT_MAX_BIASED_EXP ? 0x7E00 | ((val.x >> 13) & 0x3FF) : 0x7C00);
       }
-      // check if exponent is <= -15
       else
-      if (exp <= HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP)
+      if (val.x < HALF_FLOAT_MIN_NORMAL_AS_SINGLE_FP)
       {
-        // store a denorm half-float value or zero
-        exp = (HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP - exp) >> 23;
-        mantissa >>= (14 + exp);
-        hf.bits = (((hfloat)sign) << 15) | (hfloat)(mantissa);
+        // denorm or zero: adding the magic value aligns the 10 mantissa bits at the bottom of
+        // the float and the floating point addition takes care of the rounding
+        union { float f; unsigned int x; } magic;
+        magic.x = HALF_FLOAT_DENORM_MAGIC;
+        val.f += magic.f;
+        hf.bits = (unsigned short)(val.x - magic.x);
       }
       else
       {
-        hf.bits = (((hfloat)sign)<<15) |
-                  (hfloat)((exp - HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) >> 13) |
-                  (hfloat)(mantissa >> 13);
+        // rebias the exponent and round to nearest even, the carry can propagate up to Inf
+        val.x += HALF_FLOAT_REBIAS_AND_ROUND + ((val.x >> 13) & 1);
+        hf.bits = (unsigned short)(val.x >> 13);
       }
+      hf.bits |= (unsigned short)(sign >> 16);
       return hf;
     }
     //---------------------------------------------------------------------------
     static float convertHalfToFloat(const half& h)
     {
-      unsigned short hf = h.bits;
-      unsigned int sign = (unsigned int) ( hf >> 15);
-      unsigned int mantissa = (unsigned int) (hf & (( 1 << 10) - 1) );
-      unsigned int exp = (unsigned int) (hf & HALF_FLOAT_MAX_BIASED_EXP);
+      union { float f; unsigned int x; } val;
+      val.x = (h.bits & 0x7FFFu) << 13;
+      const unsigned int exp = val.x & (HALF_FLOAT_MAX_BIASED_EXP << 13);
+      val.x += HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
 
-      if (exp == HALF_FLOAT_MAX_BIASED_EXP)
-      {
-        // we have a half-float NaN or Inf
-        // half-float NaNs will be converted to a single precision NaN
-        // half-float Infs will be converted to a single precision Inf
-        exp = FLOAT_MAX_BIASED_EXP;
-        if ( mantissa)
-          mantissa = (1 << 23 ) - 1;   // set all bits to indicate a NaN
-      }
-      else if (exp == 0x0)
+      if (exp == (HALF_FLOAT_MAX_BIASED_EXP << 13))
       {
-        // convert half-float zero/denorm to single precision value
-        if ( mantissa)
-        {
-          mantissa <<= 1;
-          exp = HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
-          // check for leading 1 in denorm mantissa
-          while ((mantissa & (1 << 10) ) == 0)
-          {
-            // for every leading 0, decrement single precision exponent by 1
-            // and shift half-float mantissa value to the left
-            mantissa <<= 1;
-            exp -= (1 << 23 );
-          }
-          // clamp the mantissa to 10-bits
-          mantissa &= (( 1 << 10) - 1);
-          // shift left to generate single-precision mantissa of 23-bits
-          mantissa <<= 13;
-        }
+        // Inf or NaN, NaNs keep their payload and become quiet NaNs
+        val.x += HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
+        if (val.x & ((1 << 23) - 1))
+          val.x |= 1 << 22;
       }
       else
+      if (exp == 0)
       {
-        // shift left to generate single-precision mantissa of 23-bits
-        mantissa <<= 13;
-        // generate single precision biased exponent value
-        exp = ( exp << 13) + HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
+        // zero or denorm: renormalize
+        union { float f; unsigned int x; } magic;
+        magic.x = HALF_FLOAT_MIN_NORMAL_AS_SINGLE_FP;
+        val.x += 1 << 23;
+        val.f -= magic.f;
       }
-      union { float f; unsigned int x; } val;
-      val.x = ( sign << 31) | exp | mantissa;
+      val.x |= (h.bits & 0x8000u) << 16;
       return val.f;
     }
     //---------------------------------------------------------------------------
+    //! Converts \p count floats 4 at a time using F16C, SSE2 or NEON according to SIMD.hpp, the result is the same as convertFloatToHalf(float).
     static void convertFloatToHalf(const float* f, half* h, int count)
     {
-      for(int i=0; i<count; ++i)
+      int i = 0;
+#if defined(VL_SIMD_F16C)
+      for( ; i+4<=count; i+=4)
+        _mm_storel_epi64( (__m128i*)(h+i), _mm_cvtps_ph( _mm_loadu_ps(f+i), _MM_FROUND_TO_NEAREST_INT ) );
+#elif defined(VL_SIMD_SSE2)
+      const __m128i sign_mask    = _mm_set1_epi32((int)0x80000000u);
+      const __m128i max_as_fp32  = _mm_set1_epi32((int)HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP);
+      const __m128i min_normal   = _mm_set1_epi32((int)HALF_FLOAT_MIN_NORMAL_AS_SINGLE_FP);
+      const __m128i denorm_magic = _mm_set1_epi32((int)HALF_FLOAT_DENORM_MAGIC);
+      const __m128i round_bias   = _mm_set1_epi32((int)HALF_FLOAT_REBIAS_AND_ROUND);
+      const __m128i inf_bits     = _mm_set1_epi32(0x7C00);
+      const __m128i qnan_bit     = _mm_set1_epi32(0x0200);
+      const __m128i payload_mask = _mm_set1_epi32(0x03FF);
+      for( ; i+4<=count; i+=4)
       {
-        union { float f; unsigned int x; } val;
-        val.f = f[i];
-        unsigned int sign = (unsigned short)(val.x>>31);
-        unsigned int mantissa = val.x & ((1 << 23)-1);
-        unsigned int exp = val.x & FLOAT_MAX_BIASED_EXP;
-        typedef unsigned short hfloat;
-        hfloat& hf = h[i].bits;
-
-        if (exp >= HALF_FLOAT_MAX_BIASED_EXP_AS_SINGLE_FP_EXP)
-        {
-          // check if the original single precision float number is a NaN
-          if (mantissa && (exp == FLOAT_MAX_BIASED_EXP))
-          {
-            // we have a single precision NaN
-            mantissa = (1<<23) - 1;
-          }
-          else
-          {
-            // 16-bit half-float representation stores number as Inf
-            mantissa = 0;
-          }
-          hf = (((hfloat)sign) << 15) | (hfloat)(HALF_FLOAT_MAX_BIASED_EXP) | (hfloat)(mantissa >> 13);
-        }
-        // check if exponent is <= -15
-        else
-        if (exp <= HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP)
-        {
-          // store a denorm half-float value or zero
-          exp = (HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP - exp) >> 23;
-          mantissa >>= (14 + exp);
-          hf = (((hfloat)sign) << 15) | (hfloat)(mantissa);
-        }
-        else
-        {
-          hf = (((hfloat)sign)<<15) |
-               (hfloat)((exp - HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP) >> 13) |
-               (hfloat)(mantissa >> 13);
-        }
+        // same as the scalar version, computes the three cases and selects the right one
+        __m128 v = _mm_loadu_ps(f+i);
+        __m128i sign = _mm_and_si128(_mm_castps_si128(v), sign_mask);
+        __m128i absv = _mm_xor_si128(_mm_castps_si128(v), sign);
+        __m128i is_nan = _mm_castps_si128( _mm_cmpunord_ps(_mm_castsi128_ps(absv), _mm_castsi128_ps(absv)) );
+        __m128i nan = _mm_or_si128(qnan_bit, _mm_and_si128(_mm_srli_epi32(absv, 13), payload_mask));
+        __m128i inf_nan = _mm_or_si128(inf_bits, _mm_and_si128(is_nan, nan));
+        __m128i is_regular = _mm_cmpgt_epi32(max_as_fp32, absv);
+        __m128i is_denorm = _mm_cmpgt_epi32(min_normal, absv);
+        __m128i denorm = _mm_sub_epi32( _mm_castps_si128( _mm_add_ps(_mm_castsi128_ps(absv), _mm_castsi128_ps(denorm_magic)) ), denorm_magic );
+        __m128i odd = _mm_srai_epi32(_mm_slli_epi32(absv, 18), 31);
+        __m128i normal = _mm_srli_epi32( _mm_sub_epi32(_mm_add_epi32(absv, round_bias), odd), 13 );
+        __m128i finite = _mm_or_si128( _mm_and_si128(is_denorm, denorm), _mm_andnot_si128(is_denorm, normal) );
+        __m128i bits = _mm_or_si128( _mm_and_si128(is_regular, finite), _mm_andnot_si128(is_regular, inf_nan) );
+        // the sign is shifted in arithmetically so that _mm_packs_epi32() does not saturate negative values
+        bits = _mm_or_si128(bits, _mm_srai_epi32(sign, 16));
+        _mm_storel_epi64( (__m128i*)(h+i), _mm_packs_epi32(bits, bits) );
       }
+#elif defined(VL_SIMD_NEON64)
+      for( ; i+4<=count; i+=4)
+        vst1_u16( &h[i].bits, vreinterpret_u16_f16( vcvt_f16_f32( vld1q_f32(f+i) ) ) );
+#endif
+      for( ; i<count; ++i)
+        h[i] = convertFloatToHalf(f[i]);
     }
     //---------------------------------------------------------------------------
+    //! Converts \p count half-floats 4 at a time using F16C, SSE2 or NEON according to SIMD.hpp, the result is the same as convertHalfToFloat(const half&).
     static void convertHalfToFloat(const half* h, float *f, int count)
     {
-      for(int i=0; i<count; ++i)
+      int i = 0;
+#if defined(VL_SIMD_F16C)
+      for( ; i+4<=count; i+=4)
+        _mm_storeu_ps( f+i, _mm_cvtph_ps( _mm_loadl_epi64((const __m128i*)(h+i)) ) );
+#elif defined(VL_SIMD_SSE2)
+      const __m128i exp_mant_mask = _mm_set1_epi32(0x7FFF);
+      const __m128i max_finite    = _mm_set1_epi32(0x7BFF);
+      const __m128i half_inf      = _mm_set1_epi32(0x7C00);
+      const __m128i fp32_inf      = _mm_set1_epi32((int)FLOAT_MAX_BIASED_EXP);
+      const __m128i fp32_qnan_bit = _mm_set1_epi32(1 << 22);
+      // 2^112 rebiases the exponent and renormalizes the denorms in one multiplication
+      const __m128  rebias        = _mm_castsi128_ps( _mm_set1_epi32((254 - 15) << 23) );
+      for( ; i+4<=count; i+=4)
       {
-        const unsigned short& hf = h[i].bits;
-        unsigned int sign = (unsigned int) ( hf >> 15);
-        unsigned int mantissa = (unsigned int) (hf & (( 1 << 10) - 1) );
-        unsigned int exp = (unsigned int) (hf & HALF_FLOAT_MAX_BIASED_EXP);
-
-        if (exp == HALF_FLOAT_MAX_BIASED_EXP)
-        {
-          // we have a half-float NaN or Inf
-          // half-float NaNs will be converted to a single precision NaN
-          // half-float Infs will be converted to a single precision Inf
-          exp = FLOAT_MAX_BIASED_EXP;
-          if ( mantissa)
-            mantissa = (1 << 23 ) - 1;   // set all bits to indicate a NaN
-        }
-        else if (exp == 0x0)
-        {
-          // convert half-float zero/denorm to single precision value
-          if ( mantissa)
-          {
-            mantissa <<= 1;
-            exp = HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
-            // check for leading 1 in denorm mantissa
-            while ((mantissa & (1 << 10) ) == 0)
-            {
-              // for every leading 0, decrement single precision exponent by 1
-              // and shift half-float mantissa value to the left
-              mantissa <<= 1;
-              exp -= (1 << 23 );
-            }
-            // clamp the mantissa to 10-bits
-            mantissa &= (( 1 << 10) - 1);
-            // shift left to generate single-precision mantissa of 23-bits
-            mantissa <<= 13;
-          }
-        }
-        else
-        {
-          // shift left to generate single-precision mantissa of 23-bits
-          mantissa <<= 13;
-          // generate single precision biased exponent value
-          exp = ( exp << 13) + HALF_FLOAT_MIN_BIASED_EXP_AS_SINGLE_FP_EXP;
-        }
-        union { float f; unsigned int x; } val;
-        val.x = ( sign << 31) | exp | mantissa;
-        f[i] = val.f;
+        __m128i hv = _mm_unpacklo_epi16( _mm_loadl_epi64((const __m128i*)(h+i)), _mm_setzero_si128() );
+        __m128i exp_mant = _mm_and_si128(hv, exp_mant_mask);
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(hv, exp_mant), 16);
+        __m128 scaled = _mm_mul_ps( _mm_castsi128_ps(_mm_slli_epi32(exp_mant, 13)), rebias );
+        __m128i inf_nan = _mm_and_si128( _mm_cmpgt_epi32(exp_mant, max_finite), fp32_inf );
+        inf_nan = _mm_or_si128( inf_nan, _mm_and_si128( _mm_cmpgt_epi32(exp_mant, half_inf), fp32_qnan_bit ) );
+        _mm_storeu_ps( f+i, _mm_or_ps( scaled, _mm_castsi128_ps(_mm_or_si128(sign, inf_nan)) ) );
       }
+#elif defined(VL_SIMD_NEON64)
+      for( ; i+4<=count; i+=4)
+        vst1q_f32( f+i, vcvt_f32_f16( vreinterpret_f16_u16( vld1_u16(&h[i].bits) ) ) );
+#endif
+      for( ; i<count; ++i)
+        f[i] = convertHalfToFloat(h[i]);
     }
     //---------------------------------------------------------------------------
   public:
@@ -475,6 +440,15 @@ namespace vl
     static const unsigned int  FLOAT_MAX_BIASED_EXP = (0xFF << 23);
     static const unsigned int  HALF_FLOAT_MAX_BIASED_EXP = (0x1F << 10);
 
+    // smallest normalized half-float, 2^-14, as a single precision float
+    static const unsigned int  HALF_FLOAT_MIN_NORMAL_AS_SINGLE_FP = 0x38800000;
+
+    // 0.5f, its ulp is the smallest half-float denorm
+    static const unsigned int  HALF_FLOAT_DENORM_MAGIC = 0x3F000000;
+
+    // rebiases the exponent from 127 to 15 and adds the rounding bias below the 10 bits mantissa
+    static const unsigned int  HALF_FLOAT_REBIAS_AND_ROUND = 0xC8000FFF;
+
   };
   //-----------------------------------------------------------------------------
   inline float operator/(float a, const half& b)
@@ -34,6 +34,7 @@
 #include <vlX/Registry.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/ResourceCache.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
 #include <vlCore/Time.hpp>
@@ -88,6 +89,21 @@ void vl::setDefLoadWriterManager(LoadWriterManager* lwm)
   gDefaultLoadWriterManager = lwm;
 }
 //-----------------------------------------------------------------------------
+// Default ResourceCache
+//-----------------------------------------------------------------------------
+namespace
+{
+  ref<ResourceCache> gDefaultResourceCache = NULL;
+}
+ResourceCache* vl::defResourceCache()
+{
+  return gDefaultResourceCache.get();
+}
+void vl::setDefResourceCache(ResourceCache* cache)
+{
+  gDefaultResourceCache = cache;
+}
+//-----------------------------------------------------------------------------
 // Default FileSystem
 //-----------------------------------------------------------------------------
 namespace
@@ -35,6 +35,7 @@
 #include <vlCore/VisualizationLibrary.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/VirtualFile.hpp>
+#include <vlCore/MappedFile.hpp>
 #include <vlCore/Image.hpp>
 #include <vlCore/TextStream.hpp>
 #include <stdio.h>
@@ -56,12 +57,12 @@ ref<Image> vl::loadDAT( const String& path )
   return loadDAT(file.get());
 }
 //-----------------------------------------------------------------------------
-ref<Image> vl::loadDAT(VirtualFile* file)
+bool vl::loadDATHeader(VirtualFile* file, String& raw_file, ivec3& size, EImageFormat& format, EImageType& type)
 {
   if (!file->open(OM_ReadOnly))
   {
     Log::error( Say("loadDAT: could not find DAT file '%s'.\n") << file->path() );
-    return NULL;
+    return false;
   }
 
   #define BUFFER_SIZE 1024
@@ -73,30 +74,28 @@ ref<Image> vl::loadDAT(VirtualFile* file)
   char typ[BUFFER_SIZE ];
   char fmt[BUFFER_SIZE ];
   float a=0,b=0,c=0;
-  int width=0, height=0, depth=0, bytealign=1;
-  EImageFormat format;
-  EImageType type;
+  int width=0, height=0, depth=0;
 
   // safe way, get a line first then sscanf the string
   stream->readLine(line);
   if ( sscanf(line.c_str(), "%s %s", buffer, filename) != 2 )
-    return NULL;
+    return false;
   // make sure it is zero terminated
   filename[BUFFER_SIZE-1] = 0;
   stream->readLine(line);
   if ( sscanf(line.c_str(), "%s %d %d %d", buffer, &width, &height, &depth) != 4 )
-    return NULL;
+    return false;
   stream->readLine(line);
   if ( sscanf(line.c_str(), "%s %f %f %f", buffer, &a,&b,&c) != 4 )
-    return NULL;
+    return false;
   stream->readLine(line);
   if ( sscanf(line.c_str(), "%s %s", buffer, typ) != 2 )
-    return NULL;
+    return false;
   // make sure it is zero terminated
   typ[BUFFER_SIZE-1] = 0;
   stream->readLine(line);
   if ( sscanf(line.c_str(), "%s %s", buffer, fmt) != 2 )
-    return NULL;
+    return false;
   // make sure it is zero terminated
   fmt[BUFFER_SIZE-1] = 0;
   file->close();
@@ -113,7 +112,7 @@ ref<Image> vl::loadDAT(VirtualFile* file)
   }
 
   // extract path
-  String raw_file = file->path().extractPath() + filename;
+  raw_file = file->path().extractPath() + filename;
 
   if (String(typ) == "UCHAR")
     type = IT_UNSIGNED_BYTE;
@@ -123,7 +122,7 @@ ref<Image> vl::loadDAT(VirtualFile* file)
   else
   {
     Log::error( Say("loadDAT('%s'): type '%s' not supported.\n") << file->path() << typ );
-    return NULL;
+    return false;
   }
 
   if (String(fmt) == "LUMINANCE")
@@ -140,13 +139,34 @@ ref<Image> vl::loadDAT(VirtualFile* file)
   else
   {
     Log::error( Say("loadDAT('%s'): format '%s' not supported.\n") << file->path() << fmt );
-    return NULL;
+    return false;
   }
 
+  size = ivec3(width, height, depth);
+  return true;
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadDAT(VirtualFile* file)
+{
+  String raw_file;
+  ivec3 size;
+  EImageFormat format;
+  EImageType type;
+  if ( !loadDATHeader(file, raw_file, size, format, type) )
+    return NULL;
+
+  int bytealign = 1;
   ref<VirtualFile> rawf = defFileSystem()->locateFile(raw_file);
   if (rawf)
   {
-    return loadRAW( rawf.get(), -1, width, height, depth, bytealign, format, type );
+    // map the voxels so that the image uses the file pages as storage instead of a copy
+    if ( rawf->as<DiskFile>() && !rawf->as<MappedFile>() )
+    {
+      ref<MappedFile> mapped = new MappedFile( rawf->path() );
+      if ( mapped->open( OM_ReadOnly ) )
+        rawf = mapped;
+    }
+    return loadRAW( rawf.get(), -1, size.x(), size.y(), size.z(), bytealign, format, type );
   }
   else
   {
@@ -46,6 +46,10 @@ namespace vl
   VLCORE_EXPORT ref<Image> loadDAT(const String& path);
   VLCORE_EXPORT bool isDAT(VirtualFile* file);
 
+  //! Parses the header of a DAT file without loading the raw data, useful to stream the raw file in portions.
+  //! \param raw_file Receives the path of the raw data file.
+  VLCORE_EXPORT bool loadDATHeader(VirtualFile* file, String& raw_file, ivec3& size, EImageFormat& format, EImageType& type);
+
   //---------------------------------------------------------------------------
   // LoadWriterDAT
   //---------------------------------------------------------------------------
@@ -40,7 +40,7 @@
 // mic fixme:
 // http://msdn.microsoft.com/en-us/library/bb943991(v=vs.85).aspx#dds_variants
 // - read and write float and half float images.
-// - support directx 10 dds and formats
+// - support directx 10 texture arrays and uncompressed formats
 // - support A8R8G8B8, A1R5G5B5, A4R4G4B4, R8G8B8, R5G6B5
 
 using namespace vl;
@@ -155,11 +155,78 @@ namespace
 
   #define IS_PALETTE8(pf) isFourCC("P8  ", pf.dwFourCC)
 
-  #define IS_DXT1(pf) isFourCC("DXT1", pf.dwFourCC)
-
-  #define IS_DXT3(pf) isFourCC("DXT3", pf.dwFourCC)
+  #define IS_DX10(pf) isFourCC("DX10", pf.dwFourCC)
+
+  // DXGI_FORMAT values of the block compressed formats
+  const unsigned int DXGI_FORMAT_BC1_UNORM      = 71;
+  const unsigned int DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+  const unsigned int DXGI_FORMAT_BC2_UNORM      = 74;
+  const unsigned int DXGI_FORMAT_BC2_UNORM_SRGB = 75;
+  const unsigned int DXGI_FORMAT_BC3_UNORM      = 77;
+  const unsigned int DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+  const unsigned int DXGI_FORMAT_BC4_UNORM      = 80;
+  const unsigned int DXGI_FORMAT_BC4_SNORM      = 81;
+  const unsigned int DXGI_FORMAT_BC5_UNORM      = 83;
+  const unsigned int DXGI_FORMAT_BC5_SNORM      = 84;
+  const unsigned int DXGI_FORMAT_BC6H_UF16      = 95;
+  const unsigned int DXGI_FORMAT_BC6H_SF16      = 96;
+  const unsigned int DXGI_FORMAT_BC7_UNORM      = 98;
+  const unsigned int DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+  // DDS_HEADER_DXT10.miscFlag
+  const unsigned int DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+  //! Returns the block compressed image format described by the FourCC code or by the DXGI format of a DX10 header.
+  bool blockCompressedFormat(unsigned int fourcc, unsigned int dxgi_format, bool hasalpha, EImageFormat& format)
+  {
+    if (isFourCC("DXT1", fourcc))
+      format = hasalpha ? IF_COMPRESSED_RGBA_S3TC_DXT1 : IF_COMPRESSED_RGB_S3TC_DXT1;
+    else
+    if (isFourCC("DXT3", fourcc))
+      format = IF_COMPRESSED_RGBA_S3TC_DXT3;
+    else
+    if (isFourCC("DXT5", fourcc))
+      format = IF_COMPRESSED_RGBA_S3TC_DXT5;
+    else
+    if (isFourCC("ATI1", fourcc) || isFourCC("BC4U", fourcc))
+      format = IF_COMPRESSED_RED_RGTC1;
+    else
+    if (isFourCC("BC4S", fourcc))
+      format = IF_COMPRESSED_SIGNED_RED_RGTC1;
+    else
+    if (isFourCC("ATI2", fourcc) || isFourCC("BC5U", fourcc))
+      format = IF_COMPRESSED_RG_RGTC2;
+    else
+    if (isFourCC("BC5S", fourcc))
+      format = IF_COMPRESSED_SIGNED_RG_RGTC2;
+    else
+    if (isFourCC("DX10", fourcc))
+    {
+      switch(dxgi_format)
+      {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB: format = IF_COMPRESSED_RGBA_S3TC_DXT1; break;
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB: format = IF_COMPRESSED_RGBA_S3TC_DXT3; break;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB: format = IF_COMPRESSED_RGBA_S3TC_DXT5; break;
+        case DXGI_FORMAT_BC4_UNORM:      format = IF_COMPRESSED_RED_RGTC1; break;
+        case DXGI_FORMAT_BC4_SNORM:      format = IF_COMPRESSED_SIGNED_RED_RGTC1; break;
+        case DXGI_FORMAT_BC5_UNORM:      format = IF_COMPRESSED_RG_RGTC2; break;
+        case DXGI_FORMAT_BC5_SNORM:      format = IF_COMPRESSED_SIGNED_RG_RGTC2; break;
+        case DXGI_FORMAT_BC6H_UF16:      format = IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; break;
+        case DXGI_FORMAT_BC6H_SF16:      format = IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT; break;
+        case DXGI_FORMAT_BC7_UNORM:      format = IF_COMPRESSED_RGBA_BPTC_UNORM; break;
+        case DXGI_FORMAT_BC7_UNORM_SRGB: format = IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; break;
+        default:
+          return false;
+      }
+    }
+    else
+      return false;
 
-  #define IS_DXT5(pf) isFourCC("DXT5", pf.dwFourCC)
+    return true;
+  }
 
   typedef struct
   {
@@ -197,6 +264,17 @@ namespace
 
   } DDSURFACEDESC2;
 
+  // DDS_HEADER_DXT10, follows DDSURFACEDESC2 when the FourCC code is "DX10"
+  typedef struct
+  {
+    unsigned int dxgiFormat;
+    unsigned int resourceDimension;
+    unsigned int miscFlag;
+    unsigned int arraySize;
+    unsigned int miscFlags2;
+
+  } DDSHEADERDXT10;
+
   enum
   {
     DDS_IMAGE_NULL = 0,
@@ -219,6 +297,10 @@ namespace
 //! - Grayscale + Alpha, 8 + 8 bit
 //! - 8 bit palettized (8 bit palette compression)
 //! - DXT1, DXT3, DXT5
+//! - BC4 and BC5 (ATI1/ATI2, BC4U/BC4S, BC5U/BC5S)
+//! - BC1-BC7 from DirectX 10 headers (DXGI formats), including BC6H and BC7
+//!
+//! Block compressed images keep their compressed format and are uploaded as-is by Texture::createTexture().
 //!
 //! \remarks
 //! DDS images and cubemaps will look flipped if created according to the DirectX conventions. \n
@@ -238,6 +320,7 @@ ref<Image> vl::loadDDS(const String& path)
 }
 
 VL_COMPILE_TIME_CHECK( sizeof(DDSURFACEDESC2) == 124 );
+VL_COMPILE_TIME_CHECK( sizeof(DDSHEADERDXT10) == 20 );
 
 ref<Image> vl::loadDDS(VirtualFile* file)
 {
@@ -274,11 +357,27 @@ ref<Image> vl::loadDDS(VirtualFile* file)
   if ((header.ddsCaps.dwCaps1 & DDSCAPS_TEXTURE) != DDSCAPS_TEXTURE)
     Log::warning( Say("DDS file '%s': missing DDSCAPS_TEXTURE flag.\n") << file->path() );
 
+  DDSHEADERDXT10 header10;
+  memset(&header10, 0, sizeof(header10));
+
+  if (IS_DX10(header.ddpfPixelFormat))
+  {
+    file->read(&header10, sizeof(header10));
+    if (header10.arraySize > 1)
+    {
+      Log::error( Say("DDS: texture arrays are not supported ('%s').\n") << file->path() );
+      file->close();
+      return NULL;
+    }
+    if (header10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+      header.ddsCaps.dwCaps2 |= DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_FACES;
+  }
+
   int image_type = header.dwDepth ? DDS_IMAGE_3D : DDS_IMAGE_2D;
 
   if (header.ddsCaps.dwCaps2 & DDSCAPS2_CUBEMAP)
   {
-    bool allfaces = (header.ddsCaps.dwCaps2 & DDSCAPS2_CUBEMAP_FACES) != DDSCAPS2_CUBEMAP_FACES;
+    bool allfaces = (header.ddsCaps.dwCaps2 & DDSCAPS2_CUBEMAP_FACES) == DDSCAPS2_CUBEMAP_FACES;
 
     if (!allfaces)
     {
@@ -321,6 +420,9 @@ ref<Image> vl::loadDDS(VirtualFile* file)
     header.ddpfPixelFormat.dwFlags |= DDPF_LUMINANCE;
   }
 
+  EImageFormat block_format = IF_RGBA;
+  bool block_compressed = blockCompressedFormat(header.ddpfPixelFormat.dwFourCC, header10.dxgiFormat, hasalpha != 0, block_format);
+
   int max_face = 1;
   if (image_type == DDS_IMAGE_CUBEMAP)
     max_face = 6;
@@ -517,75 +619,7 @@ ref<Image> vl::loadDDS(VirtualFile* file)
     }
   }
   else
-  if ( IS_DXT1(header.ddpfPixelFormat) )
-  {
-    EImageFormat DXT1 = hasalpha ? IF_COMPRESSED_RGBA_S3TC_DXT1 : IF_COMPRESSED_RGB_S3TC_DXT1;
-
-    for(int i=0, w = header.dwWidth, h = header.dwHeight, d = header.dwDepth; i<mipmaps; ++i, w/=2, h/=2, d/=2)
-    {
-      w = w == 0 ? 1 : w;
-      h = h == 0 ? 1 : h;
-      d = d == 0 ? 1 : d;
-
-      if (image_type == DDS_IMAGE_2D)
-        image[i]->allocate2D(w, h, 1, DXT1, IT_IMPLICIT_TYPE);
-      else
-      if (image_type == DDS_IMAGE_CUBEMAP)
-        image[i]->allocateCubemap(w, h, 1, DXT1, IT_IMPLICIT_TYPE);
-      else
-      if (image_type == DDS_IMAGE_3D)
-        image[i]->allocate3D(w, h, d, 1, DXT1, IT_IMPLICIT_TYPE);
-    }
-
-    for(int face=0; face<max_face; ++face)
-    {
-      for(int i=0, w = header.dwWidth, h = header.dwHeight, d = header.dwDepth; i<mipmaps; ++i, w/=2, h/=2, d/=2)
-      {
-        w = w == 0 ? 1 : w;
-        h = h == 0 ? 1 : h;
-        d = d == 0 ? 1 : d;
-
-        int req_mem = Image::requiredMemory( w, h, d, 1, DXT1, IT_IMPLICIT_TYPE, false );
-        int offset = req_mem*face;
-        file->read(image[i]->pixels() + offset, req_mem);
-      }
-    }
-  }
-  else
-  if ( IS_DXT3(header.ddpfPixelFormat) )
-  {
-    for(int i=0, w = header.dwWidth, h = header.dwHeight, d = header.dwDepth; i<mipmaps; ++i, w/=2, h/=2, d/=2)
-    {
-      w = w == 0 ? 1 : w;
-      h = h == 0 ? 1 : h;
-      d = d == 0 ? 1 : d;
-
-      if (image_type == DDS_IMAGE_2D)
-        image[i]->allocate2D(w, h, 1, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE);
-      else
-      if (image_type == DDS_IMAGE_CUBEMAP)
-        image[i]->allocateCubemap(w, h, 1, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE);
-      else
-      if (image_type == DDS_IMAGE_3D)
-        image[i]->allocate3D(w, h, d, 1, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE);
-    }
-
-    for(int face=0; face<max_face; ++face)
-    {
-      for(int i=0, w = header.dwWidth, h = header.dwHeight, d = header.dwDepth; i<mipmaps; ++i, w/=2, h/=2, d/=2)
-      {
-        w = w == 0 ? 1 : w;
-        h = h == 0 ? 1 : h;
-        d = d == 0 ? 1 : d;
-
-        int req_mem = Image::requiredMemory( w, h, d, 1, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE, false );
-        int offset = req_mem*face;
-        file->read(image[i]->pixels() + offset, req_mem);
-      }
-    }
-  }
-  else
-  if ( IS_DXT5(header.ddpfPixelFormat) )
+  if ( block_compressed )
   {
     for(int i=0, w = header.dwWidth, h = header.dwHeight, d = header.dwDepth; i<mipmaps; ++i, w/=2, h/=2, d/=2)
     {
@@ -594,13 +628,13 @@ ref<Image> vl::loadDDS(VirtualFile* file)
       d = d == 0 ? 1 : d;
 
       if (image_type == DDS_IMAGE_2D)
-        image[i]->allocate2D(w, h, 1, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE);
+        image[i]->allocate2D(w, h, 1, block_format, IT_IMPLICIT_TYPE);
       else
       if (image_type == DDS_IMAGE_CUBEMAP)
-        image[i]->allocateCubemap(w, h, 1, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE);
+        image[i]->allocateCubemap(w, h, 1, block_format, IT_IMPLICIT_TYPE);
       else
       if (image_type == DDS_IMAGE_3D)
-        image[i]->allocate3D(w, h, d, 1, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE);
+        image[i]->allocate3D(w, h, d, 1, block_format, IT_IMPLICIT_TYPE);
     }
 
     for(int face=0; face<max_face; ++face)
@@ -611,7 +645,7 @@ ref<Image> vl::loadDDS(VirtualFile* file)
         h = h == 0 ? 1 : h;
         d = d == 0 ? 1 : d;
 
-        int req_mem = Image::requiredMemory( w, h, d, 1, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE, false );
+        int req_mem = Image::requiredMemory( w, h, d, 1, block_format, IT_IMPLICIT_TYPE, false );
         int offset = req_mem*face;
         file->read(image[i]->pixels() + offset, req_mem);
       }
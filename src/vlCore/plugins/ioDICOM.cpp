@@ -32,6 +32,7 @@
 #include "ioDICOM.hpp"
 #include <vlCore/LoadWriterManager.hpp>
 #include <vlCore/FileSystem.hpp>
+#include <vlCore/VirtualDirectory.hpp>
 #include <vlCore/glsl_math.hpp>
 
 #include <gdcmReader.h>
@@ -45,6 +46,7 @@
 #include <gdcmImageWriter.h>
 
 #include <memory>
+#include <algorithm>
 
 using namespace vl;
 
@@ -92,67 +94,19 @@ static void to32bits(int bits_used, void* ptr, int px_count, bool reverse)
       px[i] = (unsigned int)( (float)px[i]/max1*max2 );
 }
 //-----------------------------------------------------------------------------
-ref<Image> vl::loadDICOM(const String& path)
+//! Reads the whole content of the already opened \p vfile and parses it, \p strstr must outlive \p reader.
+static bool readDICOM(VirtualFile* vfile, std::stringstream& strstr, gdcm::ImageReader& reader)
 {
-  ref<VirtualFile> file = defFileSystem()->locateFile(path);
-  if ( !file )
-  {
-    Log::error( Say("File '%s' not found.\n") << path );
-    return NULL;
-  }
-  else
-    return loadDICOM(file.get());
+  std::vector<char> buffer(128*1024);
+  long long count = 0;
+  while( (count=vfile->read(&buffer[0], buffer.size())) )
+    strstr.write(&buffer[0],(int)count);
+  reader.SetStream( strstr );
+  return reader.Read();
 }
 //-----------------------------------------------------------------------------
-//! The retuned image has attached also some tags (vl::Image::tags()) extracted from the DICOM file describing the image geometry.
-ref<Image> vl::loadDICOM(VirtualFile* vfile)
+static ref<KeyValues> dicomTags(const gdcm::Image& image, const gdcm::DataSet& ds)
 {
-  gdcm::ImageReader reader;
-
-  if (!vfile->open(OM_ReadOnly))
-  {
-    Log::error( Say("loadDICOM: cannot open file '%s'\n") << vfile->path() );
-    return NULL;
-  }
-
-  const int bufsize = 128*1024;
-  char buffer[bufsize];
-  long long count = 0;
-  std::stringstream strstr;
-  while( (count=vfile->read(buffer, bufsize)) )
-    strstr.write(buffer,(int)count);
-  std::istream* istr = &strstr;
-  reader.SetStream( *istr );
-  if( !reader.Read() )
-  {
-    std::cerr << "Could not read: " << vfile->path().toStdString() << std::endl;
-    vfile->close();
-    return NULL;
-  }
-
-  gdcm::File &file = reader.GetFile();
-  const gdcm::Image &image = reader.GetImage();
-
-  #if 0
-    printf("GDCM --- --- --- --- ---\n");
-    image.Print(std::cout);
-  #endif
-
-  unsigned int ndim = image.GetNumberOfDimensions();
-  const unsigned int *dims = image.GetDimensions();
-  gdcm::PixelFormat pf = image.GetPixelFormat();
-  const gdcm::PhotometricInterpretation &pi = image.GetPhotometricInterpretation();
-
-  /* for debugging purposes only
-  const double *origin = image.GetOrigin();
-  unsigned int planar_conf = image.GetPlanarConfiguration();
-  unsigned int rows = image.GetRows();
-  unsigned int cols = image.GetColumns();
-  unsigned int buflen = image.GetBufferLength();
-  int swap = image.GetNeedByteSwap();
-  int overlays = image.GetNumberOfOverlays();
-  */
-
   ref<KeyValues> tags = new KeyValues;
   tags->set("Origin")    = Say("%n %n %n") << image.GetOrigin()[0]  << image.GetOrigin()[1]  << image.GetOrigin()[2];
   tags->set("Spacing")   = Say("%n %n %n") << image.GetSpacing()[0] << image.GetSpacing()[1] << image.GetSpacing()[2];
@@ -161,9 +115,7 @@ ref<Image> vl::loadDICOM(VirtualFile* vfile)
   tags->set("DirectionCosines") = Say("%n %n %n %n %n %n")
                                   << image.GetDirectionCosines()[0] << image.GetDirectionCosines()[1] << image.GetDirectionCosines()[2]
                                   << image.GetDirectionCosines()[3] << image.GetDirectionCosines()[4] << image.GetDirectionCosines()[5];
-  tags->set("BitsStored") = Say("%n") << pf.GetBitsStored();
-
-  gdcm::DataSet& ds = file.GetDataSet();
+  tags->set("BitsStored") = Say("%n") << image.GetPixelFormat().GetBitsStored();
 
   {
     gdcm::Attribute<0x28,0x1050> win_center;
@@ -206,9 +158,68 @@ ref<Image> vl::loadDICOM(VirtualFile* vfile)
       tags->set("RescaleSlope") = Say("%n") << rescale_slope.GetValue();
     }
     else
-      tags->set("RescaleIRescaleSlopentercept") = Say("%n") << 1;
+      tags->set("RescaleSlope") = Say("%n") << 1;
+  }
+
+  return tags;
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadDICOM(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+  else
+    return loadDICOM(file.get());
+}
+//-----------------------------------------------------------------------------
+//! The retuned image has attached also some tags (vl::Image::tags()) extracted from the DICOM file describing the image geometry.
+ref<Image> vl::loadDICOM(VirtualFile* vfile)
+{
+  gdcm::ImageReader reader;
+  std::stringstream strstr;
+
+  if (!vfile->open(OM_ReadOnly))
+  {
+    Log::error( Say("loadDICOM: cannot open file '%s'\n") << vfile->path() );
+    return NULL;
   }
 
+  if( !readDICOM(vfile, strstr, reader) )
+  {
+    std::cerr << "Could not read: " << vfile->path().toStdString() << std::endl;
+    vfile->close();
+    return NULL;
+  }
+
+  gdcm::File &file = reader.GetFile();
+  const gdcm::Image &image = reader.GetImage();
+
+  #if 0
+    printf("GDCM --- --- --- --- ---\n");
+    image.Print(std::cout);
+  #endif
+
+  unsigned int ndim = image.GetNumberOfDimensions();
+  const unsigned int *dims = image.GetDimensions();
+  gdcm::PixelFormat pf = image.GetPixelFormat();
+  const gdcm::PhotometricInterpretation &pi = image.GetPhotometricInterpretation();
+
+  /* for debugging purposes only
+  const double *origin = image.GetOrigin();
+  unsigned int planar_conf = image.GetPlanarConfiguration();
+  unsigned int rows = image.GetRows();
+  unsigned int cols = image.GetColumns();
+  unsigned int buflen = image.GetBufferLength();
+  int swap = image.GetNeedByteSwap();
+  int overlays = image.GetNumberOfOverlays();
+  */
+
+  ref<KeyValues> tags = dicomTags(image, file.GetDataSet());
+
   #if 0
     printf("TAGS --- --- --- --- ---\n");
     tags->print();
@@ -369,6 +380,241 @@ ref<Image> vl::loadDICOM(VirtualFile* vfile)
   return img;
 }
 //---------------------------------------------------------------------------
+namespace
+{
+  struct DICOMSlice
+  {
+    DICOMSlice(): file(NULL), reader(NULL), stream(NULL), position(0), ok(false) {}
+
+    bool operator<(const DICOMSlice& other) const { return position < other.position; }
+
+    VirtualFile* file;
+    gdcm::ImageReader* reader;
+    std::stringstream* stream;
+    dvec3 origin;
+    double position;
+    bool ok;
+  };
+
+  void releaseSlice(DICOMSlice& slice)
+  {
+    delete slice.reader;
+    delete slice.stream;
+    slice.reader = NULL;
+    slice.stream = NULL;
+  }
+
+  void releaseSlices(std::vector<DICOMSlice>& slices)
+  {
+    for(size_t i=0; i<slices.size(); ++i)
+      releaseSlice(slices[i]);
+  }
+
+  template<typename T>
+  void rescaleSlice(const char* src, float* dst, int count, float slope, float intercept)
+  {
+    const T* px = (const T*)src;
+    for(int i=0; i<count; ++i)
+      dst[i] = px[i]*slope + intercept;
+  }
+}
+//---------------------------------------------------------------------------
+ref<Image> vl::loadDICOMSeries(const String& dir_path, bool rescale)
+{
+  ref<VirtualDirectory> dir = defFileSystem()->locateDirectory(dir_path);
+  if (!dir)
+  {
+    Log::error( Say("loadDICOMSeries: directory '%s' not found.\n") << dir_path );
+    return NULL;
+  }
+
+  std::vector<String> paths;
+  dir->listFiles(paths);
+  std::vector< ref<VirtualFile> > files;
+  for(size_t i=0; i<paths.size(); ++i)
+  {
+    ref<VirtualFile> file = dir->file(paths[i]);
+    if (file)
+      files.push_back(file);
+  }
+
+  ref<Image> img = loadDICOMSeries(files, rescale);
+  if (img)
+    img->setObjectName( dir_path.toStdString().c_str() );
+  return img;
+}
+//---------------------------------------------------------------------------
+ref<Image> vl::loadDICOMSeries(const std::vector< ref<VirtualFile> >& files, bool rescale)
+{
+  std::vector<DICOMSlice> slices(files.size());
+  for(size_t i=0; i<files.size(); ++i)
+    slices[i].file = files[i].get_writable();
+
+  // read and parse all the files, the pixels are decoded later directly into the volume
+
+  const int file_count = (int)slices.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for(int i=0; i<file_count; ++i)
+  {
+    DICOMSlice& slice = slices[i];
+    if (!slice.file->open(OM_ReadOnly))
+      continue;
+    slice.stream = new std::stringstream;
+    slice.reader = new gdcm::ImageReader;
+    slice.ok = readDICOM(slice.file, *slice.stream, *slice.reader);
+    slice.file->close();
+    if (slice.ok)
+    {
+      const gdcm::Image& image = slice.reader->GetImage();
+      const double* cosines = image.GetDirectionCosines();
+      dvec3 normal = cross( dvec3(cosines[0], cosines[1], cosines[2]), dvec3(cosines[3], cosines[4], cosines[5]) );
+      slice.origin = dvec3(image.GetOrigin()[0], image.GetOrigin()[1], image.GetOrigin()[2]);
+      slice.position = dot(slice.origin, normal);
+    }
+  }
+
+  std::vector<DICOMSlice> series;
+  for(size_t i=0; i<slices.size(); ++i)
+  {
+    if (slices[i].ok)
+      series.push_back(slices[i]);
+    else
+    {
+      Log::warning( Say("loadDICOMSeries: skipping '%s', not a DICOM image.\n") << slices[i].file->path() );
+      releaseSlice(slices[i]);
+    }
+  }
+
+  if (series.empty())
+  {
+    Log::error("loadDICOMSeries: no DICOM images found.\n");
+    return NULL;
+  }
+
+  std::stable_sort(series.begin(), series.end());
+
+  // all the slices must be single frame, monochrome and share size and pixel format
+
+  const gdcm::Image& first = series[0].reader->GetImage();
+  const gdcm::PixelFormat pf = first.GetPixelFormat();
+  const int w = first.GetDimensions()[0];
+  const int h = first.GetNumberOfDimensions() >= 2 ? first.GetDimensions()[1] : 1;
+  for(size_t i=0; i<series.size(); ++i)
+  {
+    const gdcm::Image& image = series[i].reader->GetImage();
+    const gdcm::PixelFormat& spf = image.GetPixelFormat();
+    const gdcm::PhotometricInterpretation& pi = image.GetPhotometricInterpretation();
+    bool monochrome = pi == gdcm::PhotometricInterpretation::MONOCHROME1 || pi == gdcm::PhotometricInterpretation::MONOCHROME2;
+    bool single_frame = image.GetNumberOfDimensions() < 3 || image.GetDimensions()[2] == 1;
+    int sh = image.GetNumberOfDimensions() >= 2 ? image.GetDimensions()[1] : 1;
+    if (!monochrome || !single_frame || spf.GetSamplesPerPixel() != 1)
+    {
+      Log::error( Say("loadDICOMSeries: '%s' is not a single frame monochrome image, use loadDICOM() instead.\n") << series[i].file->path() );
+      releaseSlices(series);
+      return NULL;
+    }
+    if ((int)image.GetDimensions()[0] != w || sh != h || spf.GetBitsAllocated() != pf.GetBitsAllocated() ||
+        spf.GetBitsStored() != pf.GetBitsStored() || spf.GetPixelRepresentation() != pf.GetPixelRepresentation())
+    {
+      Log::error( Say("loadDICOMSeries: '%s' differs in size or pixel format from the rest of the series.\n") << series[i].file->path() );
+      releaseSlices(series);
+      return NULL;
+    }
+  }
+
+  EImageType type = IT_FLOAT;
+  if (!rescale)
+  {
+    if (pf.GetBitsStored() <= 8)
+      type = IT_UNSIGNED_BYTE;
+    else
+    if (pf.GetBitsStored() <= 16)
+      type = IT_UNSIGNED_SHORT;
+    else
+      type = IT_UNSIGNED_INT;
+  }
+
+  const int slice_count = (int)series.size();
+
+  ref<KeyValues> tags = dicomTags(first, series[0].reader->GetFile().GetDataSet());
+  double dz = slice_count > 1 ? (series[slice_count-1].position - series[0].position) / (slice_count-1) : first.GetSpacing()[2];
+  tags->set("Origin")     = Say("%n %n %n") << series[0].origin.x() << series[0].origin.y() << series[0].origin.z();
+  tags->set("Spacing")    = Say("%n %n %n") << first.GetSpacing()[0] << first.GetSpacing()[1] << dz;
+  tags->set("SliceCount") = Say("%n") << slice_count;
+  if (rescale)
+  {
+    tags->set("RescaleIntercept") = Say("%n") << 0;
+    tags->set("RescaleSlope")     = Say("%n") << 1;
+  }
+
+  ref<Image> img = new Image(w, h, slice_count > 1 ? slice_count : 0, 1, IF_LUMINANCE, type);
+  const int slice_bytes = img->pitch() * h;
+  const int raw_bytes   = w * h * (pf.GetBitsAllocated() / 8);
+
+  // decode each slice into its place in the volume
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for(int z=0; z<slice_count; ++z)
+  {
+    DICOMSlice& slice = series[z];
+    const gdcm::Image& image = slice.reader->GetImage();
+    unsigned char* dst = img->pixels() + (size_t)slice_bytes * z;
+    slice.ok = image.GetBufferLength() == (unsigned long)raw_bytes;
+    if (slice.ok && rescale)
+    {
+      std::vector<char> raw(raw_bytes);
+      slice.ok = image.GetBuffer(&raw[0]);
+      const float slope     = (float)image.GetSlope();
+      const float intercept = (float)image.GetIntercept();
+      const bool is_signed  = pf.GetPixelRepresentation() == 1;
+      switch(pf.GetBitsAllocated() * (is_signed ? -1 : 1))
+      {
+        case  8:  rescaleSlice<unsigned char> (&raw[0], (float*)dst, w*h, slope, intercept); break;
+        case -8:  rescaleSlice<signed char>   (&raw[0], (float*)dst, w*h, slope, intercept); break;
+        case  16: rescaleSlice<unsigned short>(&raw[0], (float*)dst, w*h, slope, intercept); break;
+        case -16: rescaleSlice<short>         (&raw[0], (float*)dst, w*h, slope, intercept); break;
+        case  32: rescaleSlice<unsigned int>  (&raw[0], (float*)dst, w*h, slope, intercept); break;
+        case -32: rescaleSlice<int>           (&raw[0], (float*)dst, w*h, slope, intercept); break;
+        default:
+          slice.ok = false;
+      }
+    }
+    else
+    if (slice.ok)
+    {
+      slice.ok = raw_bytes == slice_bytes && image.GetBuffer((char*)dst);
+      bool reverse = image.GetPhotometricInterpretation() == gdcm::PhotometricInterpretation::MONOCHROME1;
+      if (slice.ok)
+      {
+        switch(type)
+        {
+          case IT_UNSIGNED_BYTE:  to8bits (pf.GetBitsStored(), dst, w*h, reverse); break;
+          case IT_UNSIGNED_SHORT: to16bits(pf.GetBitsStored(), dst, w*h, reverse); break;
+          default:                to32bits(pf.GetBitsStored(), dst, w*h, reverse); break;
+        }
+      }
+    }
+    releaseSlice(slice);
+  }
+
+  for(int z=0; z<slice_count; ++z)
+  {
+    if (!series[z].ok)
+    {
+      Log::error( Say("loadDICOMSeries: could not decode '%s'.\n") << series[z].file->path() );
+      return NULL;
+    }
+  }
+
+  img->setTags(tags.get());
+  img->flipVertically();
+  return img;
+}
+//---------------------------------------------------------------------------
 bool vl::isDICOM(VirtualFile* file)
 {
   file->open(OM_ReadOnly);
@@ -52,6 +52,18 @@ namespace vl
   //! Checks if the given file is a DICOM file.
   VLCORE_EXPORT bool isDICOM(VirtualFile* file);
 
+  /** Loads a series of single frame monochrome DICOM slices into a single 3D image.
+   * The slices are sorted by their position along the slice normal and decoded directly into the returned image,
+   * in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP).
+   * \param files The slices of the series, in any order. Files that are not DICOM images are skipped.
+   * \param rescale If \p false the voxels are stored like loadDICOM() does and the image tags() describe the rescale
+   * slope and intercept of the first slice. If \p true the voxels are converted to IT_FLOAT applying each slice's
+   * rescale slope and intercept, i.e. for CT series the image contains Hounsfield units.
+   * The returned image has the same tags() as loadDICOM() plus "SliceCount", with "Origin" and "Spacing" describing the whole volume. */
+  VLCORE_EXPORT ref<Image> loadDICOMSeries(const std::vector< ref<VirtualFile> >& files, bool rescale=false);
+  //! Loads all the DICOM files contained in the given directory as a single 3D image, see loadDICOMSeries(const std::vector< ref<VirtualFile> >&, bool).
+  VLCORE_EXPORT ref<Image> loadDICOMSeries(const String& dir_path, bool rescale=false);
+
   //---------------------------------------------------------------------------
   // LoadWriterDICOM
   //---------------------------------------------------------------------------
@@ -417,18 +417,16 @@ ref<Image> vl::loadJPG(VirtualFile* file)
   cinfo.err = jpeg_std_error(&jerr.pub);
   jerr.pub.error_exit = my_error_exit;
 
-  // fixme? "warning C4611: interaction between '_setjmp' and C++ object destruction is non-portable"
-
-#if 0
+  // The jump buffer lives on this stack frame so that concurrent decodes never share error state.
+  // Only C frames of libjpeg are unwound by longjmp(): 'img' is constructed above and is released normally.
   /* Establish the setjmp return context for my_error_exit to use. */
   if (setjmp(jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error.
      * We need to clean up the JPEG object, close the input file, and return. */
     jpeg_destroy_decompress(&cinfo);
     file->close();
-    return 0;
+    return NULL;
   }
-#endif
 
   /* Now we can initialize the JPEG decompression object. */
   jpeg_create_decompress(&cinfo);
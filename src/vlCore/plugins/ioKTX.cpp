@@ -0,0 +1,509 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include "ioKTX.hpp"
+#include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/VisualizationLibrary.hpp>
+#include <vlCore/FileSystem.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/Image.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// KTX loader
+//-----------------------------------------------------------------------------
+namespace
+{
+  const unsigned char KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+  const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+  const unsigned int KTX_ENDIANNESS = 0x04030201;
+
+  // KTX2 supercompressionScheme
+  const unsigned int KTX2_SUPERCOMPRESSION_NONE    = 0;
+  const unsigned int KTX2_SUPERCOMPRESSION_BASISLZ = 1;
+
+  // VkFormat -> image format/type
+  struct KTX2Format
+  {
+    unsigned int vkFormat;
+    EImageFormat format;
+    EImageType type;
+  };
+
+  const KTX2Format KTX2_FORMATS[] =
+  {
+    {   9, IF_RED,  IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8_UNORM
+    {  16, IF_RG,   IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8G8_UNORM
+    {  23, IF_RGB,  IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8G8B8_UNORM
+    {  29, IF_RGB,  IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8G8B8_SRGB
+    {  30, IF_BGR,  IT_UNSIGNED_BYTE  }, // VK_FORMAT_B8G8R8_UNORM
+    {  36, IF_BGR,  IT_UNSIGNED_BYTE  }, // VK_FORMAT_B8G8R8_SRGB
+    {  37, IF_RGBA, IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8G8B8A8_UNORM
+    {  43, IF_RGBA, IT_UNSIGNED_BYTE  }, // VK_FORMAT_R8G8B8A8_SRGB
+    {  44, IF_BGRA, IT_UNSIGNED_BYTE  }, // VK_FORMAT_B8G8R8A8_UNORM
+    {  50, IF_BGRA, IT_UNSIGNED_BYTE  }, // VK_FORMAT_B8G8R8A8_SRGB
+    {  70, IF_RED,  IT_UNSIGNED_SHORT }, // VK_FORMAT_R16_UNORM
+    {  77, IF_RG,   IT_UNSIGNED_SHORT }, // VK_FORMAT_R16G16_UNORM
+    {  84, IF_RGB,  IT_UNSIGNED_SHORT }, // VK_FORMAT_R16G16B16_UNORM
+    {  91, IF_RGBA, IT_UNSIGNED_SHORT }, // VK_FORMAT_R16G16B16A16_UNORM
+    { 100, IF_RED,  IT_FLOAT          }, // VK_FORMAT_R32_SFLOAT
+    { 103, IF_RG,   IT_FLOAT          }, // VK_FORMAT_R32G32_SFLOAT
+    { 106, IF_RGB,  IT_FLOAT          }, // VK_FORMAT_R32G32B32_SFLOAT
+    { 109, IF_RGBA, IT_FLOAT          }, // VK_FORMAT_R32G32B32A32_SFLOAT
+
+    // block compressed formats, sRGB variants without an sRGB image format are loaded as linear
+    { 131, IF_COMPRESSED_RGB_S3TC_DXT1,  IT_IMPLICIT_TYPE }, // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+    { 132, IF_COMPRESSED_RGB_S3TC_DXT1,  IT_IMPLICIT_TYPE }, // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+    { 133, IF_COMPRESSED_RGBA_S3TC_DXT1, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    { 134, IF_COMPRESSED_RGBA_S3TC_DXT1, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    { 135, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC2_UNORM_BLOCK
+    { 136, IF_COMPRESSED_RGBA_S3TC_DXT3, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC2_SRGB_BLOCK
+    { 137, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC3_UNORM_BLOCK
+    { 138, IF_COMPRESSED_RGBA_S3TC_DXT5, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC3_SRGB_BLOCK
+    { 139, IF_COMPRESSED_RED_RGTC1,        IT_IMPLICIT_TYPE }, // VK_FORMAT_BC4_UNORM_BLOCK
+    { 140, IF_COMPRESSED_SIGNED_RED_RGTC1, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC4_SNORM_BLOCK
+    { 141, IF_COMPRESSED_RG_RGTC2,         IT_IMPLICIT_TYPE }, // VK_FORMAT_BC5_UNORM_BLOCK
+    { 142, IF_COMPRESSED_SIGNED_RG_RGTC2,  IT_IMPLICIT_TYPE }, // VK_FORMAT_BC5_SNORM_BLOCK
+    { 143, IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, IT_IMPLICIT_TYPE }, // VK_FORMAT_BC6H_UFLOAT_BLOCK
+    { 144, IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,   IT_IMPLICIT_TYPE }, // VK_FORMAT_BC6H_SFLOAT_BLOCK
+    { 145, IF_COMPRESSED_RGBA_BPTC_UNORM,         IT_IMPLICIT_TYPE }, // VK_FORMAT_BC7_UNORM_BLOCK
+    { 146, IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,   IT_IMPLICIT_TYPE }, // VK_FORMAT_BC7_SRGB_BLOCK
+    { 147, IF_COMPRESSED_RGB8_ETC2,                      IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+    { 148, IF_COMPRESSED_SRGB8_ETC2,                     IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+    { 149, IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,  IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK
+    { 150, IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2, IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK
+    { 151, IF_COMPRESSED_RGBA8_ETC2_EAC,                 IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+    { 152, IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,          IT_IMPLICIT_TYPE }, // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+    { 153, IF_COMPRESSED_R11_EAC,                        IT_IMPLICIT_TYPE }, // VK_FORMAT_EAC_R11_UNORM_BLOCK
+    { 154, IF_COMPRESSED_SIGNED_R11_EAC,                 IT_IMPLICIT_TYPE }, // VK_FORMAT_EAC_R11_SNORM_BLOCK
+    { 155, IF_COMPRESSED_RG11_EAC,                       IT_IMPLICIT_TYPE }, // VK_FORMAT_EAC_R11G11_UNORM_BLOCK
+    { 156, IF_COMPRESSED_SIGNED_RG11_EAC,                IT_IMPLICIT_TYPE }, // VK_FORMAT_EAC_R11G11_SNORM_BLOCK
+    { 157, IF_COMPRESSED_RGBA_ASTC_4x4,                  IT_IMPLICIT_TYPE }, // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+    { 158, IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4,          IT_IMPLICIT_TYPE }, // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+
+    { 0, IF_RGBA, IT_UNSIGNED_BYTE }
+  };
+
+  //! Uncompressed formats and types accepted from KTX 1.1 files.
+  bool isPlainFormat(unsigned int format, unsigned int type)
+  {
+    switch(format)
+    {
+      case IF_RED: case IF_RG: case IF_RGB: case IF_BGR: case IF_RGBA: case IF_BGRA:
+      case IF_ALPHA: case IF_LUMINANCE: case IF_LUMINANCE_ALPHA:
+        break;
+      default:
+        return false;
+    }
+
+    switch(type)
+    {
+      case IT_UNSIGNED_BYTE: case IT_BYTE: case IT_UNSIGNED_SHORT: case IT_SHORT:
+      case IT_UNSIGNED_INT: case IT_INT: case IT_FLOAT:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  //! Allocates one image per mipmap level, cubemap faces are stored contiguously as in vl::Image.
+  void allocateLevels(std::vector< ref<Image> >& levels, int level_count, int w, int h, int d, bool cubemap, int bytealign, EImageFormat format, EImageType type, const String& name)
+  {
+    for(int i=0; i<level_count; ++i)
+    {
+      // 0 height/depth mean a 1D/2D image, the other sizes stop at 1
+      int mw = w >> i ? w >> i : 1;
+      int mh = h >> i ? h >> i : (h ? 1 : 0);
+      int md = d >> i ? d >> i : (d ? 1 : 0);
+
+      ref<Image> img = new Image;
+      img->setObjectName(name.toStdString().c_str());
+
+      if (cubemap)
+        img->allocateCubemap(mw, mh, bytealign, format, type);
+      else
+      if (md)
+        img->allocate3D(mw, mh, md, bytealign, format, type);
+      else
+      if (mh)
+        img->allocate2D(mw, mh, bytealign, format, type);
+      else
+        img->allocate1D(mw, format, type);
+
+      levels.push_back(img);
+    }
+  }
+
+  //! Reads one face of a mipmap level, byte swapping the components if needed.
+  bool readFace(VirtualFile* file, unsigned char* ptr, int bytes, int type_size, bool little_endian)
+  {
+    if (little_endian || type_size <= 1)
+      return file->read(ptr, bytes) == bytes;
+    else
+    if (type_size == 2)
+      return file->readUInt16((unsigned short*)ptr, bytes/2, false) == bytes/2;
+    else
+      return file->readUInt32((unsigned int*)ptr, bytes/4, false) == bytes/4;
+  }
+
+  ref<Image> assembleLevels(std::vector< ref<Image> >& levels)
+  {
+    VL_CHECK(levels.size());
+    ref<Image> img = levels[0];
+    levels.erase(levels.begin());
+    img->setMipmaps(levels);
+    return img;
+  }
+
+  ref<Image> loadKTX1(VirtualFile* file)
+  {
+    bool le = file->readUInt32() == KTX_ENDIANNESS;
+
+    unsigned int gl_type                  = file->readUInt32(le);
+    unsigned int gl_type_size             = file->readUInt32(le);
+    unsigned int gl_format                = file->readUInt32(le);
+    unsigned int gl_internal_format       = file->readUInt32(le);
+    /*unsigned int gl_base_internal_format=*/ file->readUInt32(le);
+    int width                             = file->readUInt32(le);
+    int height                            = file->readUInt32(le);
+    int depth                             = file->readUInt32(le);
+    unsigned int array_elements           = file->readUInt32(le);
+    unsigned int faces                    = file->readUInt32(le);
+    int mipmaps                           = file->readUInt32(le);
+    unsigned int key_value_bytes          = file->readUInt32(le);
+
+    if (array_elements > 0)
+    {
+      Log::error( Say("KTX: texture arrays are not supported ('%s').\n") << file->path() );
+      return NULL;
+    }
+
+    if ( (faces != 1 && faces != 6) || width <= 0 )
+    {
+      Log::error( Say("KTX file '%s': corrupted header.\n") << file->path() );
+      return NULL;
+    }
+
+    EImageFormat format;
+    EImageType type;
+    int bytealign;
+    if (gl_type == 0)
+    {
+      format = (EImageFormat)gl_internal_format;
+      type = IT_IMPLICIT_TYPE;
+      bytealign = 1;
+      if (!Image::isCompressedFormat(format))
+      {
+        Log::error( Say("KTX: unsupported compressed format 0x%hn in '%s'.\n") << gl_internal_format << file->path() );
+        return NULL;
+      }
+    }
+    else
+    {
+      format = (EImageFormat)gl_format;
+      type = (EImageType)gl_type;
+      bytealign = 4; // KTX 1.1 rows follow GL_UNPACK_ALIGNMENT = 4
+      if (!isPlainFormat(gl_format, gl_type))
+      {
+        Log::error( Say("KTX: unsupported format 0x%hn/0x%hn in '%s'.\n") << gl_format << gl_type << file->path() );
+        return NULL;
+      }
+    }
+
+    file->seekCur(key_value_bytes);
+
+    mipmaps = mipmaps ? mipmaps : 1; // 0 means "generate them at load time"
+    std::vector< ref<Image> > levels;
+    allocateLevels(levels, mipmaps, width, height, depth, faces == 6, bytealign, format, type, file->path());
+
+    for(int i=0; i<mipmaps; ++i)
+    {
+      int face_bytes = levels[i]->requiredMemory() / faces;
+      unsigned int image_size = file->readUInt32(le);
+      // for non-array cubemaps imageSize is the size of one face
+      if ((int)image_size != face_bytes)
+      {
+        Log::error( Say("KTX: unexpected size of mipmap level %n in '%s'.\n") << i << file->path() );
+        return NULL;
+      }
+
+      for(unsigned int face=0; face<faces; ++face)
+      {
+        if ( !readFace(file, levels[i]->pixels() + face_bytes*face, face_bytes, gl_type_size, le) )
+        {
+          Log::error( Say("KTX: unexpected end of file in '%s'.\n") << file->path() );
+          return NULL;
+        }
+        file->seekCur(3 - ((face_bytes + 3) % 4)); // cubePadding
+      }
+      file->seekCur(3 - ((image_size + 3) % 4)); // mipPadding
+    }
+
+    return assembleLevels(levels);
+  }
+
+  ref<Image> loadKTX2(VirtualFile* file)
+  {
+    unsigned int vk_format     = file->readUInt32();
+    /*unsigned int type_size =*/ file->readUInt32();
+    int width                  = file->readUInt32();
+    int height                 = file->readUInt32();
+    int depth                  = file->readUInt32();
+    unsigned int layers        = file->readUInt32();
+    unsigned int faces         = file->readUInt32();
+    int mipmaps                = file->readUInt32();
+    unsigned int supercompression = file->readUInt32();
+
+    // dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength, sgdByteOffset, sgdByteLength
+    file->seekCur(4*4 + 8*2);
+
+    if (supercompression == KTX2_SUPERCOMPRESSION_BASISLZ || vk_format == 0)
+    {
+      Log::error( Say("KTX2: '%s' contains Basis Universal data, transcoding it requires the Basis Universal transcoder which is not available.\n") << file->path() );
+      return NULL;
+    }
+
+    if (supercompression != KTX2_SUPERCOMPRESSION_NONE)
+    {
+      Log::error( Say("KTX2: unsupported supercompression scheme %n in '%s'.\n") << supercompression << file->path() );
+      return NULL;
+    }
+
+    if (layers > 1)
+    {
+      Log::error( Say("KTX2: texture arrays are not supported ('%s').\n") << file->path() );
+      return NULL;
+    }
+
+    if ( (faces != 1 && faces != 6) || width <= 0 )
+    {
+      Log::error( Say("KTX2 file '%s': corrupted header.\n") << file->path() );
+      return NULL;
+    }
+
+    const KTX2Format* fmt = KTX2_FORMATS;
+    while(fmt->vkFormat && fmt->vkFormat != vk_format)
+      ++fmt;
+    if (!fmt->vkFormat)
+    {
+      Log::error( Say("KTX2: unsupported VkFormat %n in '%s'.\n") << vk_format << file->path() );
+      return NULL;
+    }
+
+    mipmaps = mipmaps ? mipmaps : 1;
+    std::vector<unsigned long long> level_offset(mipmaps), level_length(mipmaps);
+    for(int i=0; i<mipmaps; ++i)
+    {
+      level_offset[i] = file->readUInt64();
+      level_length[i] = file->readUInt64();
+      /*uncompressedByteLength =*/ file->readUInt64();
+    }
+
+    // KTX2 rows are tightly packed
+    std::vector< ref<Image> > levels;
+    allocateLevels(levels, mipmaps, width, height, depth, faces == 6, 1, fmt->format, fmt->type, file->path());
+
+    for(int i=0; i<mipmaps; ++i)
+    {
+      int bytes = levels[i]->requiredMemory();
+      if ( level_length[i] != (unsigned long long)bytes || !file->seekSet(level_offset[i]) || file->read(levels[i]->pixels(), bytes) != bytes )
+      {
+        Log::error( Say("KTX2: could not read mipmap level %n of '%s'.\n") << i << file->path() );
+        return NULL;
+      }
+    }
+
+    return assembleLevels(levels);
+  }
+}
+//-----------------------------------------------------------------------------
+//! Loads a KTX 1.1 or KTX 2.0 file.
+//! Can load 1D, 2D, 3D textures and cubemaps with their mipmaps. \n
+//!
+//! Supports the following formats:
+//! - uncompressed 8, 16, 32 bit integer and 32 bit float formats
+//! - block compressed formats: S3TC (BC1-BC3), RGTC (BC4, BC5), BPTC (BC6H, BC7), ETC2/EAC, ASTC 4x4
+//!
+//! Compressed images keep their format and are uploaded as they are by Texture::createTexture().
+//!
+//! \remarks
+//! Texture arrays, Zstandard/ZLIB supercompression and Basis Universal (ETC1S/UASTC) payloads are not supported.
+ref<Image> vl::loadKTX(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+
+  return loadKTX(file.get());
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadKTX(VirtualFile* file)
+{
+  if ( !file->open(OM_ReadOnly) )
+  {
+    Log::error( Say("KTX: could not open file '%s'.\n") << file->path() );
+    return NULL;
+  }
+
+  unsigned char identifier[12];
+  memset(identifier, 0, sizeof(identifier));
+  file->read(identifier, 12);
+
+  ref<Image> img;
+  if (memcmp(identifier, KTX1_IDENTIFIER, 12) == 0)
+    img = loadKTX1(file);
+  else
+  if (memcmp(identifier, KTX2_IDENTIFIER, 12) == 0)
+    img = loadKTX2(file);
+  else
+    Log::error( Say("KTX: '%s' is not a KTX file.\n") << file->path() );
+
+  file->close();
+  return img;
+}
+//-----------------------------------------------------------------------------
+bool vl::isKTX(VirtualFile* file)
+{
+  if (!file->open(OM_ReadOnly))
+    return false;
+
+  unsigned char identifier[12];
+  memset(identifier, 0, sizeof(identifier));
+  file->read(identifier, 12);
+  file->close();
+
+  return memcmp(identifier, KTX1_IDENTIFIER, 12) == 0 || memcmp(identifier, KTX2_IDENTIFIER, 12) == 0;
+}
+//-----------------------------------------------------------------------------
+bool vl::saveKTX(const Image* src, const String& path)
+{
+  ref<DiskFile> file = new DiskFile(path);
+  return saveKTX(src, file.get());
+}
+//-----------------------------------------------------------------------------
+//! Saves an image and its mipmaps as a KTX 1.1 file.
+//! Supports 1D, 2D, 3D images and cubemaps in all the formats read by loadKTX() except for texture arrays.
+bool vl::saveKTX(const Image* src, VirtualFile* fout)
+{
+  const bool compressed = Image::isCompressedFormat(src->format()) != 0;
+  unsigned int type_size = 0;
+  switch(src->type())
+  {
+    case IT_IMPLICIT_TYPE:
+    case IT_UNSIGNED_BYTE:
+    case IT_BYTE:           type_size = 1; break;
+    case IT_UNSIGNED_SHORT:
+    case IT_SHORT:          type_size = 2; break;
+    case IT_UNSIGNED_INT:
+    case IT_INT:
+    case IT_FLOAT:          type_size = 4; break;
+    default:
+      break;
+  }
+
+  if ( !type_size || (!compressed && !isPlainFormat(src->format(), src->type())) || src->dimension() == ID_None || src->dimension() == ID_Error )
+  {
+    Log::error( Say("saveKTX('%s'): unsupported image format or type.\n") << fout->path() );
+    return false;
+  }
+
+  for(size_t i=0; i<src->mipmaps().size(); ++i)
+  {
+    if (src->mipmaps()[i]->format() != src->format() || src->mipmaps()[i]->type() != src->type())
+    {
+      Log::error( Say("saveKTX('%s'): the mipmaps must have the same format and type of the image.\n") << fout->path() );
+      return false;
+    }
+  }
+
+  if(!fout->open(OM_WriteOnly))
+  {
+    Log::error( Say("KTX: could not write to '%s'.\n") << fout->path() );
+    return false;
+  }
+
+  const unsigned int faces = src->isCubemap() ? 6 : 1;
+  const unsigned int base_format = src->format() == IF_BGR ? IF_RGB : src->format() == IF_BGRA ? IF_RGBA : src->format();
+
+  fout->write(KTX1_IDENTIFIER, 12);
+  fout->writeUInt32(KTX_ENDIANNESS);
+  fout->writeUInt32(compressed ? 0 : src->type());
+  fout->writeUInt32(type_size);
+  fout->writeUInt32(compressed ? 0 : src->format());
+  fout->writeUInt32(compressed ? (unsigned int)src->format() : base_format);
+  fout->writeUInt32(compressed ? (unsigned int)IF_RGBA : base_format);
+  fout->writeUInt32(src->width());
+  fout->writeUInt32(src->height());
+  fout->writeUInt32(src->dimension() == ID_3D ? src->depth() : 0);
+  fout->writeUInt32(0); // numberOfArrayElements
+  fout->writeUInt32(faces);
+  fout->writeUInt32(1 + (unsigned int)src->mipmaps().size());
+  fout->writeUInt32(0); // bytesOfKeyValueData
+
+  const unsigned char padding[4] = { 0, 0, 0, 0 };
+  for(int i=0; i<1+(int)src->mipmaps().size(); ++i)
+  {
+    const Image* level = i ? src->mipmaps()[i-1].get() : src;
+
+    if (compressed)
+    {
+      int face_bytes = level->requiredMemory() / faces;
+      fout->writeUInt32(face_bytes);
+      fout->write(level->pixels(), level->requiredMemory());
+    }
+    else
+    {
+      // KTX 1.1 rows follow GL_UNPACK_ALIGNMENT = 4
+      int rows = (level->height() ? level->height() : 1) * (level->dimension() == ID_3D ? level->depth() : 1);
+      int row_bytes = (level->width() * level->bitsPerPixel() + 7) / 8;
+      int row_padding = 3 - ((row_bytes + 3) % 4);
+      fout->writeUInt32( (row_bytes + row_padding) * rows );
+      for(unsigned int face=0; face<faces; ++face)
+      {
+        for(int r=0; r<rows; ++r)
+        {
+          fout->write(level->pixels() + (size_t)level->pitch() * (face*rows + r), row_bytes);
+          fout->write(padding, row_padding);
+        }
+      }
+    }
+  }
+
+  fout->close();
+  return true;
+}
+//-----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include <vlCore/VisualizationLibrary.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/VirtualFile.hpp>
+#include <vlCore/MappedFile.hpp>
 #include <vlCore/Image.hpp>
 #include <vlCore/TextStream.hpp>
 
@@ -53,12 +54,12 @@ ref<Image> vl::loadMHD( const String& path )
   return loadMHD(file.get());
 }
 //-----------------------------------------------------------------------------
-ref<Image> vl::loadMHD(VirtualFile* file)
+bool vl::loadMHDHeader(VirtualFile* file, String& raw_file, ivec3& size, EImageFormat& format, EImageType& type, KeyValues* tags)
 {
   if ( ! file->open( OM_ReadOnly ) )
   {
     Log::error( Say( "%s: could not find MHD file '%s'.\n" ) << __FUNCTION__ << file->path() );
-    return NULL;
+    return false;
   }
 
   ref<TextStream> stream = new TextStream(file);
@@ -82,10 +83,9 @@ ref<Image> vl::loadMHD(VirtualFile* file)
   ivec3 offset;
   fvec3 center_of_rotation;
   fvec3 element_spacing;
-  int width=0, height=0, depth=0, bytealign=1;
-  EImageFormat format = vl::IF_LUMINANCE;
-  EImageType type = vl::IT_SHORT;
-  String raw_file;
+  int width=0, height=0, depth=0;
+  format = vl::IF_LUMINANCE;
+  type = vl::IT_SHORT;
 
   for( std::map<String, String>::const_iterator it = keyvals->keyValueMap().begin(); it != keyvals->keyValueMap().end(); ++it )
   {
@@ -95,32 +95,38 @@ ref<Image> vl::loadMHD(VirtualFile* file)
     if ( key == "ObjectType" ) {
       if ( val != "Image" ) {
         Log::error( Say("%s: ObjectType must be Image ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "NDims" ) {
       if ( val != "3" ) {
         Log::error( Say("%s: NDims must be 3 ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
       ndims = 3;
     } else
     if ( key == "BinaryData" ) {
       if ( val != "True" ) {
         Log::error( Say("%s: BinaryData must be True ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
-    if ( key == "BinaryDataByteOrderMSB" ) {
-      if ( val != "False" ) {
-        Log::error( Say("%s: BinaryDataByteOrderMSB must be False ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+    if ( key == "BinaryDataByteOrderMSB" || key == "ElementByteOrderMSB" ) {
+      if ( val != "False" && val != "True" ) {
+        Log::error( Say("%s: %s must be True or False ('%s').\n") << __FUNCTION__ << key << file->path() );
+        return false;
+      }
+    } else
+    if ( key == "HeaderSize" ) {
+      if ( val.toInt() < -1 ) {
+        Log::error( Say("%s: invalid HeaderSize value, must be -1 or a positive int ('%s').\n") << __FUNCTION__ << file->path() );
+        return false;
       }
     } else
     if ( key == "CompressedData" ) {
       if ( val != "False" ) {
         Log::error( Say("%s: CompressedData must be False ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "TransformMatrix" ) {
@@ -132,45 +138,101 @@ ref<Image> vl::loadMHD(VirtualFile* file)
     if ( key == "Offset" ) {
       if ( sscanf( val.toStdString().c_str(), "%d %d %d", &offset.x(), &offset.y(), &offset.z() ) != 3 ) {
         Log::error( Say("%s: invalid Offset value, must be three ints ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "CenterOfRotation" ) {
       if ( sscanf( val.toStdString().c_str(), "%f %f %f", &center_of_rotation.x(), &center_of_rotation.y(), &center_of_rotation.z() ) != 3 ) {
         Log::error( Say("%s: invalid CenterOfRotation value, must be three floats ('%s') (%n).\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "ElementSpacing" ) {
       if ( sscanf( val.toStdString().c_str(), "%f %f %f", &element_spacing.x(), &element_spacing.y(), &element_spacing.z() ) != 3 ) {
         Log::error( Say("%s: invalid ElementSpacing value, must be three floats ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "DimSize" ) {
       if ( sscanf( val.toStdString().c_str(), "%d %d %d", &width, &height, &depth ) != 3 ) {
         Log::error( Say("%s: invalid DimSize value, must be three ints ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+        return false;
       }
     } else
     if ( key == "AnatomicalOrientation" ) {
       // TODO: ???
     } else
     if ( key == "ElementType" ) {
-      if ( val != "MET_SHORT" ) {
-        Log::error( Say("%s: invalid ElementType value, only MET_SHORT is supported ('%s').\n") << __FUNCTION__ << file->path() );
-        return NULL;
+      if ( val == "MET_SHORT" ) {
+        type = vl::IT_SHORT;
+      } else
+      if ( val == "MET_USHORT" ) {
+        type = vl::IT_UNSIGNED_SHORT;
+      } else
+      if ( val == "MET_UCHAR" ) {
+        type = vl::IT_UNSIGNED_BYTE;
+      } else
+      if ( val == "MET_CHAR" ) {
+        type = vl::IT_BYTE;
+      } else
+      if ( val == "MET_INT" ) {
+        type = vl::IT_INT;
+      } else
+      if ( val == "MET_UINT" ) {
+        type = vl::IT_UNSIGNED_INT;
+      } else
+      if ( val == "MET_FLOAT" ) {
+        type = vl::IT_FLOAT;
+      } else {
+        Log::error( Say("%s: invalid ElementType value, only MET_CHAR, MET_UCHAR, MET_SHORT, MET_USHORT, MET_INT, MET_UINT and MET_FLOAT are supported ('%s').\n") << __FUNCTION__ << file->path() );
+        return false;
       }
     } else
     if ( key == "ElementDataFile" ) {
       raw_file = file->path().extractPath() + val;
     }
   }
+  file->close();
+
+  size = ivec3( width, height, depth );
+  if ( tags ) {
+    tags->keyValueMap() = keyvals->keyValueMap();
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadMHD(VirtualFile* file)
+{
+  String raw_file;
+  ivec3 size;
+  EImageFormat format;
+  EImageType type;
+  vl::ref<KeyValues> keyvals = new KeyValues;
+  if ( ! loadMHDHeader( file, raw_file, size, format, type, keyvals.get() ) )
+    return NULL;
 
+  int bytealign = 1;
   ref<VirtualFile> rawf = defFileSystem()->locateFile( raw_file );
   if (rawf)
   {
-    vl::ref<Image> img = loadRAW( rawf.get(), 0, width, height, depth, bytealign, format, type );
+    // map the voxels so that the image uses the file pages as storage instead of a copy
+    if ( rawf->as<DiskFile>() && !rawf->as<MappedFile>() )
+    {
+      ref<MappedFile> mapped = new MappedFile( rawf->path() );
+      if ( mapped->open( OM_ReadOnly ) )
+        rawf = mapped;
+    }
+
+    const bool msb = ( keyvals->has("BinaryDataByteOrderMSB") && keyvals->value("BinaryDataByteOrderMSB") == "True" ) ||
+                     ( keyvals->has("ElementByteOrderMSB") && keyvals->value("ElementByteOrderMSB") == "True" );
+    long long offset = keyvals->has("HeaderSize") ? keyvals->value("HeaderSize").toInt() : 0;
+    // HeaderSize = -1: the voxels are at the end of the file
+    if ( offset == -1 )
+      offset = rawf->size() - Image::requiredMemory3D( size.x(), size.y(), size.z(), bytealign, format, type );
+
+    vl::ref<Image> img = loadRAW( rawf.get(), offset, size.x(), size.y(), size.z(), bytealign, format, type, msb );
+    if ( !img )
+      return NULL;
     img->setTags( keyvals.get() );
     return img;
   }
@@ -46,6 +46,11 @@ namespace vl
   VLCORE_EXPORT ref<Image> loadMHD(const String& path);
   VLCORE_EXPORT bool isMHD(VirtualFile* file);
 
+  //! Parses the header of an MHD file without loading the raw data, useful to stream the raw file in portions.
+  //! \param raw_file Receives the path of the raw data file.
+  //! \param tags If not NULL receives all the key/value pairs of the header.
+  VLCORE_EXPORT bool loadMHDHeader(VirtualFile* file, String& raw_file, ivec3& size, EImageFormat& format, EImageType& type, KeyValues* tags=NULL);
+
   //---------------------------------------------------------------------------
   // LoadWriterMHD
   //---------------------------------------------------------------------------
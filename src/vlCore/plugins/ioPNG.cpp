@@ -114,9 +114,12 @@ ref<Image> vl::loadPNG(VirtualFile* file)
   VL_CHECK(info_ptr)
   VL_CHECK(endinfo)
 
-  // fixme? "warning C4611: interaction between '_setjmp' and C++ object destruction is non-portable"
+  // C++ objects are created before setjmp() so that longjmp() only ever unwinds C frames of libpng.
+  // The jump buffer is owned by png_ptr, so concurrent decodes never share error state.
+  ref<Image> img = new Image;
+  img->setObjectName(file->path().toStdString().c_str());
+  std::vector<png_bytep> row_p;
 
-#if 0
   if (setjmp(png_jmpbuf(png_ptr)))
   {
     /* Free all of the memory associated with the png_ptr and info_ptr */
@@ -125,7 +128,6 @@ ref<Image> vl::loadPNG(VirtualFile* file)
     /* If we get here, we had a problem reading the file */
     return NULL;
   }
-#endif
 
   unsigned char header[8];
   int count = (int)file->read(header,8);
@@ -148,9 +150,6 @@ ref<Image> vl::loadPNG(VirtualFile* file)
 
   png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type, NULL/*&interlace_type*/, NULL/*int_p_NULL*/, NULL/*int_p_NULL*/);
 
-  ref<Image> img = new Image;
-  img->setObjectName(file->path().toStdString().c_str());
-
   if (bit_depth == 16)
   {
     switch(color_type)
@@ -361,7 +360,6 @@ ref<Image> vl::loadPNG(VirtualFile* file)
    /* At this point you have read the entire image */
 
    // initialize row pointers
-   std::vector<png_bytep> row_p;
    row_p.resize(height);
    for(unsigned i=0; i<height; ++i)
      row_p[height - 1 - i] = (png_bytep)img->pixels()+img->pitch()*i;
@@ -506,3 +504,80 @@ bool vl::savePNG(const Image* src, VirtualFile* fout, int compression)
   return true;
 }
 //-----------------------------------------------------------------------------
+// PNGRowWriter
+//-----------------------------------------------------------------------------
+bool PNGRowWriter::open(VirtualFile* fout, int width, int height)
+{
+  close();
+
+  if (!fout || width <= 0 || height <= 0)
+    return false;
+
+  if(!fout->open(OM_WriteOnly))
+  {
+    Log::error( Say("PNG: could not write to '%s'.\n") << fout->path() );
+    return false;
+  }
+
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, vl_error_fn, vl_warning_fn);
+  png_infop info = png ? png_create_info_struct(png) : NULL;
+  if (!info)
+  {
+    png_destroy_write_struct(&png, NULL);
+    fout->close();
+    return false;
+  }
+
+  png_set_write_fn(png,fout,png_write_vfile,png_flush_vfile);
+  png_set_compression_level(png, mCompression);
+  png_set_IHDR( png, info, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+                PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+
+  mPNG  = png;
+  mInfo = info;
+  mFile = fout;
+  mWidth  = width;
+  mHeight = height;
+  mRowsWritten = 0;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool PNGRowWriter::writeRows(const unsigned char* rows, int count, int pitch)
+{
+  if (!mPNG || mRowsWritten + count > mHeight)
+    return false;
+
+  png_structp png = (png_structp)mPNG;
+  for(int i=0; i<count; ++i)
+    png_write_row(png, (png_bytep)(rows + (size_t)pitch*i));
+  mRowsWritten += count;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool PNGRowWriter::close()
+{
+  if (!mPNG)
+    return false;
+
+  bool complete = mRowsWritten == mHeight;
+  if (complete)
+    png_write_end((png_structp)mPNG, NULL);
+  else
+    Log::error( Say("PNGRowWriter: '%s' closed after %n rows out of %n.\n") << mFile->path() << mRowsWritten << mHeight );
+
+  destroyEncoder();
+  mFile->close();
+  mFile = NULL;
+  return complete;
+}
+//-----------------------------------------------------------------------------
+void PNGRowWriter::destroyEncoder()
+{
+  png_structp png  = (png_structp)mPNG;
+  png_infop   info = (png_infop)mInfo;
+  png_destroy_write_struct(&png, &info);
+  mPNG  = NULL;
+  mInfo = NULL;
+}
+//-----------------------------------------------------------------------------
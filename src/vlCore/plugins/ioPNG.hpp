@@ -35,6 +35,7 @@
 #include <vlCore/ResourceLoadWriter.hpp>
 #include <vlCore/ResourceDatabase.hpp>
 #include <vlCore/Image.hpp>
+#include <vlCore/ImageRowWriter.hpp>
 
 namespace vl
 {
@@ -105,6 +106,37 @@ namespace vl
   protected:
     int mCompression;
   };
+
+  //---------------------------------------------------------------------------
+  // PNGRowWriter
+  //---------------------------------------------------------------------------
+  /**
+   * An ImageRowWriter streaming RGBA rows into a PNG file through libpng, only one row at a time is held by the encoder.
+   */
+  class VLCORE_EXPORT PNGRowWriter: public ImageRowWriter
+  {
+    VL_INSTRUMENT_CLASS(vl::PNGRowWriter, ImageRowWriter)
+
+  public:
+    PNGRowWriter(int compression = 6): mPNG(NULL), mInfo(NULL), mCompression(compression) {}
+    ~PNGRowWriter() { close(); }
+
+    bool open(VirtualFile* file, int width, int height);
+    bool writeRows(const unsigned char* rows, int count, int pitch);
+    bool close();
+
+    int compression() const { return mCompression; }
+    //! Sets the compression level used by the following open(). Should be between 0 and 9
+    void setCompression(int compression) { mCompression = compression; }
+
+  protected:
+    void destroyEncoder();
+
+  protected:
+    void* mPNG;
+    void* mInfo;
+    int mCompression;
+  };
 }
 
 #endif
@@ -36,6 +36,7 @@
 #include <vlCore/VirtualFile.hpp>
 #include <vlCore/Image.hpp>
 #include "tiffio.h"
+#include <algorithm>
 
 // mic fixme: read and write 16 bits images.
 
@@ -165,6 +166,264 @@ ref<Image> vl::loadTIFF(VirtualFile* file)
   return img;
 }
 //-----------------------------------------------------------------------------
+ref<Image> vl::loadTIFFVolume(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+  else
+    return loadTIFFVolume(file.get());
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::loadTIFFVolume(VirtualFile* file)
+{
+  TIFFReader reader;
+  if (!reader.open(file))
+    return NULL;
+
+  const int page_count = reader.pageCount();
+  const int w = reader.width();
+  const int h = reader.height();
+  const EImageFormat format = reader.format();
+  const EImageType type = reader.type();
+  for(int z=1; z<page_count; ++z)
+  {
+    if (!reader.setPage(z))
+      return NULL;
+    if (reader.width() != w || reader.height() != h || reader.format() != format || reader.type() != type)
+    {
+      Log::error( Say("loadTIFFVolume('%s'): page %n differs in size or format from the first page.\n") << file->path() << z );
+      return NULL;
+    }
+  }
+  reader.close();
+
+  ref<Image> img = new Image;
+  img->allocate3D(w, h, page_count, 1, format, type);
+
+  std::vector<char> page_ok(page_count, 0);
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    // a libtiff handle cannot be shared between threads, each one reads its own clone of the file
+    TIFFReader page_reader;
+    ref<VirtualFile> page_file = file->clone();
+    const bool opened = page_reader.open(page_file.get());
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for(int z=0; z<page_count; ++z)
+      page_ok[z] = opened && page_reader.setPage(z) && page_reader.readRegion(0, 0, w, h, img->pixelsZSlice(z), img->pitch());
+  }
+
+  if ( std::find(page_ok.begin(), page_ok.end(), 0) != page_ok.end() )
+  {
+    Log::error( Say("loadTIFFVolume('%s'): could not decode all the pages.\n") << file->path() );
+    return NULL;
+  }
+  return img;
+}
+//-----------------------------------------------------------------------------
+// TIFFReader
+//-----------------------------------------------------------------------------
+bool TIFFReader::open(VirtualFile* file)
+{
+  close();
+
+  if ( !file || !file->open(OM_ReadOnly) )
+  {
+    Log::error( Say("TIFFReader: could not open '%s'.\n") << (file ? file->path() : String()) );
+    return false;
+  }
+
+  TIFFSetErrorHandler(tiff_error);
+  TIFFSetWarningHandler(tiff_warning);
+
+  mTIFF = TIFFClientOpen("tiffread", "r", reinterpret_cast<thandle_t>(file),
+                tiff_io_read_func,
+                tiff_io_write_func,
+                tiff_io_seek_func,
+                tiff_io_close_func,
+                tiff_io_size_func,
+                tiff_io_map_func,
+                tiff_io_unmap_func);
+  if (!mTIFF)
+  {
+    Log::error( Say("TIFFReader: '%s' is not a valid TIFF file.\n") << file->path() );
+    file->close();
+    return false;
+  }
+  mFile = file;
+
+  // the directory offsets let setPage() jump to any page without walking the directory chain
+  do
+    mPageOffsets.push_back( TIFFCurrentDirOffset(mTIFF) );
+  while( TIFFReadDirectory(mTIFF) );
+
+  return setPage(0);
+}
+//-----------------------------------------------------------------------------
+void TIFFReader::close()
+{
+  // also closes mFile, see tiff_io_close_func()
+  if (mTIFF)
+    TIFFClose(mTIFF);
+  mTIFF = NULL;
+  mFile = NULL;
+  mPageOffsets.clear();
+  mBlock.clear();
+  mPage = -1;
+  mWidth = mHeight = 0;
+}
+//-----------------------------------------------------------------------------
+bool TIFFReader::setPage(int page)
+{
+  if ( !mTIFF || page < 0 || page >= pageCount() )
+  {
+    Log::error( Say("TIFFReader::setPage(): invalid page %n.\n") << page );
+    return false;
+  }
+  if (page == mPage)
+    return true;
+
+  mPage = -1;
+  if ( !TIFFSetSubDirectory(mTIFF, mPageOffsets[page]) )
+  {
+    Log::error( Say("TIFFReader::setPage(): could not read the directory of page %n.\n") << page );
+    return false;
+  }
+
+  uint32 w = 0, h = 0;
+  uint16 spp = 1, bps = 1, sample_format = SAMPLEFORMAT_UINT, planar = PLANARCONFIG_CONTIG, photometric = PHOTOMETRIC_MINISWHITE;
+  TIFFGetField(mTIFF, TIFFTAG_IMAGEWIDTH, &w);
+  TIFFGetField(mTIFF, TIFFTAG_IMAGELENGTH, &h);
+  TIFFGetField(mTIFF, TIFFTAG_PHOTOMETRIC, &photometric);
+  TIFFGetFieldDefaulted(mTIFF, TIFFTAG_SAMPLESPERPIXEL, &spp);
+  TIFFGetFieldDefaulted(mTIFF, TIFFTAG_BITSPERSAMPLE, &bps);
+  TIFFGetFieldDefaulted(mTIFF, TIFFTAG_SAMPLEFORMAT, &sample_format);
+  TIFFGetFieldDefaulted(mTIFF, TIFFTAG_PLANARCONFIG, &planar);
+  mWidth  = (int)w;
+  mHeight = (int)h;
+
+  // interleaved grayscale and RGB samples are returned as they are, everything else is converted to RGBA by libtiff
+  mNative = ( planar == PLANARCONFIG_CONTIG || spp == 1 ) &&
+            ( ( photometric == PHOTOMETRIC_MINISBLACK && spp <= 2 ) || ( photometric == PHOTOMETRIC_RGB && ( spp == 3 || spp == 4 ) ) ) &&
+            ( ( sample_format == SAMPLEFORMAT_UINT && ( bps == 8 || bps == 16 ) ) || ( sample_format == SAMPLEFORMAT_IEEEFP && bps == 32 ) );
+  if (mNative)
+  {
+    const EImageFormat formats[] = { IF_LUMINANCE, IF_LUMINANCE_ALPHA, IF_RGB, IF_RGBA };
+    mFormat = formats[spp-1];
+    mType = bps == 8 ? IT_UNSIGNED_BYTE : bps == 16 ? IT_UNSIGNED_SHORT : IT_FLOAT;
+    mPixelBytes = spp * bps / 8;
+  }
+  else
+  {
+    mFormat = IF_RGBA;
+    mType = IT_UNSIGNED_BYTE;
+    mPixelBytes = 4;
+  }
+
+  mTiled = TIFFIsTiled(mTIFF) != 0;
+  if (mTiled)
+  {
+    uint32 tile_w = 0, tile_h = 0;
+    TIFFGetField(mTIFF, TIFFTAG_TILEWIDTH, &tile_w);
+    TIFFGetField(mTIFF, TIFFTAG_TILELENGTH, &tile_h);
+    mBlockWidth  = (int)tile_w;
+    mBlockHeight = (int)tile_h;
+  }
+  else
+  {
+    uint32 rows_per_strip = h;
+    TIFFGetFieldDefaulted(mTIFF, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+    mBlockWidth  = mWidth;
+    mBlockHeight = rows_per_strip < h ? (int)rows_per_strip : (int)h;
+  }
+
+  if (mWidth <= 0 || mHeight <= 0 || mBlockWidth <= 0 || mBlockHeight <= 0)
+  {
+    Log::error( Say("TIFFReader::setPage(): page %n has an invalid size.\n") << page );
+    return false;
+  }
+
+  const size_t block_bytes = mNative ? (size_t)(mTiled ? TIFFTileSize(mTIFF) : TIFFStripSize(mTIFF)) : (size_t)mBlockWidth * mBlockHeight * 4;
+  mBlock.resize( std::max(block_bytes, (size_t)mBlockWidth * mBlockHeight * mPixelBytes) );
+  mPage = page;
+  return true;
+}
+//-----------------------------------------------------------------------------
+ref<Image> TIFFReader::readRegion(int x, int y, int w, int h)
+{
+  if (mPage < 0)
+    return NULL;
+  ref<Image> img = new Image;
+  img->allocate2D(w, h, 1, mFormat, mType);
+  if ( !readRegion(x, y, w, h, img->pixels(), img->pitch()) )
+    return NULL;
+  return img;
+}
+//-----------------------------------------------------------------------------
+bool TIFFReader::readRegion(int x, int y, int w, int h, void* pixels, int pitch)
+{
+  if (mPage < 0)
+  {
+    Log::error("TIFFReader::readRegion(): no page selected.\n");
+    return false;
+  }
+  if ( x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > mWidth || y + h > mHeight )
+  {
+    Log::error("TIFFReader::readRegion(): the region exceeds the page.\n");
+    return false;
+  }
+
+  // the rows of the region counted from the top of the page, as they are stored in the file
+  const int row_begin = mHeight - y - h;
+  const int row_end   = mHeight - y;
+  unsigned char* dst = (unsigned char*)pixels;
+
+  for(int block_y = row_begin / mBlockHeight * mBlockHeight; block_y < row_end; block_y += mBlockHeight)
+  {
+    const int block_rows = std::min(mBlockHeight, mHeight - block_y);
+    for(int block_x = x / mBlockWidth * mBlockWidth; block_x < x + w; block_x += mBlockWidth)
+    {
+      bool ok;
+      if (mNative)
+        ok = mTiled ? TIFFReadEncodedTile ( mTIFF, TIFFComputeTile(mTIFF, block_x, block_y, 0, 0), &mBlock[0], (tsize_t)-1 ) != -1
+                    : TIFFReadEncodedStrip( mTIFF, TIFFComputeStrip(mTIFF, block_y, 0), &mBlock[0], (tsize_t)-1 ) != -1;
+      else
+        ok = mTiled ? TIFFReadRGBATile ( mTIFF, block_x, block_y, (uint32*)&mBlock[0] ) != 0
+                    : TIFFReadRGBAStrip( mTIFF, block_y, (uint32*)&mBlock[0] ) != 0;
+      if (!ok)
+      {
+        Log::error( Say("TIFFReader::readRegion(): could not decode page %n.\n") << mPage );
+        return false;
+      }
+
+      const int x0 = std::max(x, block_x);
+      const int x1 = std::min(x + w, block_x + mBlockWidth);
+      const int r0 = std::max(row_begin, block_y);
+      const int r1 = std::min(row_end, block_y + block_rows);
+      for(int row = r0; row < r1; ++row)
+      {
+        // the RGBA blocks are decoded by libtiff bottom to top, partial tiles as if they were complete
+        int block_row = row - block_y;
+        if (!mNative)
+          block_row = (mTiled ? mBlockHeight : block_rows) - 1 - block_row;
+        const unsigned char* src = &mBlock[0] + ( (size_t)block_row * mBlockWidth + (x0 - block_x) ) * mPixelBytes;
+        // the region is stored bottom to top as well
+        unsigned char* out = dst + (size_t)(row_end - 1 - row) * pitch + (size_t)(x0 - x) * mPixelBytes;
+        memcpy( out, src, (size_t)(x1 - x0) * mPixelBytes );
+      }
+    }
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
 bool vl::isTIFF(VirtualFile* file)
 {
   if (!file->open(OM_ReadOnly))
@@ -381,3 +640,126 @@ bool vl::saveTIFF(const Image* src, VirtualFile* fout)
   return true;
 }
 //-----------------------------------------------------------------------------
+// TIFFRowWriter
+//-----------------------------------------------------------------------------
+namespace
+{
+  void tiff_write_entry(VirtualFile* fout, unsigned short tag, unsigned short type, unsigned long count, unsigned long value)
+  {
+    const int SHORT = 3;
+    fout->writeUInt16(tag);
+    fout->writeUInt16(type);
+    fout->writeUInt32(count);
+    if (type == SHORT && count == 1)
+    {
+      fout->writeUInt16((unsigned short)value);
+      fout->writeUInt16(0);
+    }
+    else
+      fout->writeUInt32(value);
+  }
+}
+//-----------------------------------------------------------------------------
+bool TIFFRowWriter::open(VirtualFile* fout, int width, int height)
+{
+  close();
+
+  if (!fout || width <= 0 || height <= 0)
+    return false;
+
+  const unsigned short dir_count = 14;
+  const unsigned long data_offset = 10 + dir_count*12 + 4 + 16 + 8;
+  const unsigned long long strip_size = (unsigned long long)width * height * 4;
+  if (strip_size + data_offset > 0xFFFFFFFFULL)
+  {
+    Log::error( Say("TIFFRowWriter: a %nx%n image exceeds the 4GB limit of the TIFF format.\n") << width << height );
+    return false;
+  }
+
+  if (!fout->open(OM_WriteOnly))
+  {
+    Log::error( Say("TIFF: could not open '%s' for writing.\n") << fout->path() );
+    return false;
+  }
+
+  const int SHORT     = 3;
+  const int LONG      = 4;
+  const int RATIONAL  = 5;
+
+  // little endian
+  unsigned char little_endian[] = { 'I', 'I' };
+  fout->write(little_endian, 2);
+  fout->writeUInt16(42);
+  fout->writeUInt32(8);
+
+  fout->writeUInt16(dir_count);
+  tiff_write_entry(fout, 256, LONG,     1, width);                             // width
+  tiff_write_entry(fout, 257, LONG,     1, height);                            // height
+  tiff_write_entry(fout, 258, SHORT,    4, 10 + dir_count*12 + 4 + 16);        // bits per sample
+  tiff_write_entry(fout, 259, SHORT,    1, 1);                                 // no compression
+  tiff_write_entry(fout, 262, SHORT,    1, 2);                                 // RGB
+  tiff_write_entry(fout, 273, LONG,     1, data_offset);                       // strip offset
+  tiff_write_entry(fout, 277, SHORT,    1, 4);                                 // samples per pixel
+  tiff_write_entry(fout, 278, LONG,     1, height);                            // rows per strip
+  tiff_write_entry(fout, 279, LONG,     1, (unsigned long)strip_size);         // strip byte count
+  tiff_write_entry(fout, 282, RATIONAL, 1, 10 + dir_count*12 + 4 + 0);         // x resolution
+  tiff_write_entry(fout, 283, RATIONAL, 1, 10 + dir_count*12 + 4 + 8);         // y resolution
+  tiff_write_entry(fout, 284, SHORT,    1, 1);                                 // planar configuration
+  tiff_write_entry(fout, 296, SHORT,    1, 2);                                 // resolution unit
+  tiff_write_entry(fout, 338, SHORT,    1, 0);                                 // extra samples
+
+  // next ifd offset
+  fout->writeUInt32(0);
+
+  // resolutions
+  fout->writeUInt32(72);
+  fout->writeUInt32(1);
+  fout->writeUInt32(72);
+  fout->writeUInt32(1);
+
+  // bits per sample
+  for(int i=0; i<4; ++i)
+    fout->writeUInt16(8);
+
+  mFile = fout;
+  mWidth  = width;
+  mHeight = height;
+  mRowsWritten = 0;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool TIFFRowWriter::writeRows(const unsigned char* rows, int count, int pitch)
+{
+  if (!mFile || mRowsWritten + count > mHeight)
+    return false;
+
+  const long long row_bytes = (long long)mWidth * 4;
+  if (pitch == row_bytes)
+  {
+    if (mFile->write(rows, row_bytes*count) != row_bytes*count)
+      return false;
+  }
+  else
+  {
+    for(int i=0; i<count; ++i)
+      if (mFile->write(rows + (size_t)pitch*i, row_bytes) != row_bytes)
+        return false;
+  }
+  mRowsWritten += count;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool TIFFRowWriter::close()
+{
+  if (!mFile)
+    return false;
+
+  bool complete = mRowsWritten == mHeight;
+  if (!complete)
+    Log::error( Say("TIFFRowWriter: '%s' closed after %n rows out of %n.\n") << mFile->path() << mRowsWritten << mHeight );
+
+  mFile->close();
+  mFile = NULL;
+  return complete;
+}
+//-----------------------------------------------------------------------------
@@ -35,6 +35,10 @@
 #include <vlCore/ResourceLoadWriter.hpp>
 #include <vlCore/ResourceDatabase.hpp>
 #include <vlCore/Image.hpp>
+#include <vlCore/ImageRowWriter.hpp>
+#include <vector>
+
+struct tiff;
 
 namespace vl
 {
@@ -48,6 +52,12 @@ namespace vl
   VLCORE_EXPORT bool saveTIFF(const Image* src, const String& path);
   VLCORE_EXPORT bool saveTIFF(const Image* src, VirtualFile* file);
 
+  /** Loads all the pages of a multi-page TIFF as the slices of a 3D image, see TIFFReader for the supported formats.
+   * All the pages must have the same size and format. The pages are decoded in parallel, each thread reading a clone() of
+   * \p file, if VL is compiled with OpenMP support (CMake option VL_OPENMP). */
+  VLCORE_EXPORT ref<Image> loadTIFFVolume(VirtualFile* file);
+  VLCORE_EXPORT ref<Image> loadTIFFVolume(const String& path);
+
   //---------------------------------------------------------------------------
   // LoadWriterTIFF
   //---------------------------------------------------------------------------
@@ -98,6 +108,103 @@ namespace vl
       return ok;
     }
   };
+
+  //---------------------------------------------------------------------------
+  // TIFFReader
+  //---------------------------------------------------------------------------
+  /**
+   * Reads rectangular regions of the pages of a TIFF file decoding only the strips or tiles they overlap,
+   * so that images too big to fit in memory can be processed piece by piece.
+   *
+   * 8 and 16 bits unsigned and 32 bits float images with 1 to 4 interleaved samples (grayscale, grayscale + alpha, RGB, RGBA)
+   * are returned with their own format and type, all the other images are converted by libtiff to IF_RGBA / IT_UNSIGNED_BYTE.
+   * Like loadTIFF() the rows are returned bottom to top, i.e. row 0 of an Image is the last row of the page; the orientation tag is ignored.
+   * \note Only baseline TIFF files are supported, which are limited to 4GB.
+   */
+  class VLCORE_EXPORT TIFFReader: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TIFFReader, Object)
+
+  public:
+    TIFFReader(): mTIFF(NULL), mPage(-1), mWidth(0), mHeight(0), mBlockWidth(0), mBlockHeight(0), mPixelBytes(0),
+      mTiled(false), mNative(false), mFormat(IF_RGBA), mType(IT_UNSIGNED_BYTE) {}
+    ~TIFFReader() { close(); }
+
+    //! Opens the file, reads the offsets of all its pages and selects the first one.
+    bool open(VirtualFile* file);
+
+    //! Closes the file.
+    void close();
+
+    //! The number of pages of the file.
+    int pageCount() const { return (int)mPageOffsets.size(); }
+
+    //! Selects the page read by readRegion(), jumping directly to its directory.
+    bool setPage(int page);
+
+    //! The currently selected page.
+    int page() const { return mPage; }
+
+    //! The width of the current page.
+    int width() const { return mWidth; }
+    //! The height of the current page.
+    int height() const { return mHeight; }
+
+    //! The format of the images returned by readRegion() for the current page.
+    EImageFormat format() const { return mFormat; }
+    //! The type of the images returned by readRegion() for the current page.
+    EImageType type() const { return mType; }
+
+    //! Whether the current page is divided in tiles rather than in strips.
+    bool isTiled() const { return mTiled; }
+    //! The width of the tiles of the current page, the page width if the page is divided in strips.
+    int blockWidth() const { return mBlockWidth; }
+    //! The height of the tiles or strips of the current page: regions aligned to it avoid decoding the same block twice.
+    int blockHeight() const { return mBlockHeight; }
+
+    //! Reads the region of the current page of size \p w x \p h whose bottom left corner is \p x, \p y. Returns NULL on failure.
+    ref<Image> readRegion(int x, int y, int w, int h);
+
+    //! Reads a region of the current page into \p pixels, whose rows are \p pitch bytes apart, in the format() and type() of the page.
+    bool readRegion(int x, int y, int w, int h, void* pixels, int pitch);
+
+  protected:
+    ref<VirtualFile> mFile;
+    ::tiff* mTIFF;
+    std::vector<unsigned int> mPageOffsets;
+    std::vector<unsigned char> mBlock;
+    int mPage;
+    int mWidth;
+    int mHeight;
+    int mBlockWidth;
+    int mBlockHeight;
+    int mPixelBytes;
+    bool mTiled;
+    bool mNative;
+    EImageFormat mFormat;
+    EImageType mType;
+  };
+
+  //---------------------------------------------------------------------------
+  // TIFFRowWriter
+  //---------------------------------------------------------------------------
+  /**
+   * An ImageRowWriter streaming RGBA rows into an uncompressed TIFF file, the same layout written by saveTIFF().
+   * Since the strip is not compressed its size is known in advance and the rows go straight to the file.
+   * \note Baseline TIFF files are limited to 4GB, that is about 32768 x 32768 RGBA pixels, use a PNGRowWriter for bigger images.
+   */
+  class VLCORE_EXPORT TIFFRowWriter: public ImageRowWriter
+  {
+    VL_INSTRUMENT_CLASS(vl::TIFFRowWriter, ImageRowWriter)
+
+  public:
+    TIFFRowWriter() {}
+    ~TIFFRowWriter() { close(); }
+
+    bool open(VirtualFile* file, int width, int height);
+    bool writeRows(const unsigned char* rows, int count, int pitch);
+    bool close();
+  };
 }
 
 #endif
@@ -164,6 +164,28 @@ namespace vl
     TF_COMPRESSED_RED_GREEN_RGTC2_EXT        = GL_COMPRESSED_RED_GREEN_RGTC2_EXT,
     TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT = GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT,
 
+    // ARB_texture_compression_bptc
+    TF_COMPRESSED_RGBA_BPTC_UNORM         = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB,
+    TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM   = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB,
+    TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT   = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB,
+    TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB,
+
+    // ARB_ES3_compatibility (ETC2/EAC)
+    TF_COMPRESSED_RGB8_ETC2                      = GL_COMPRESSED_RGB8_ETC2,
+    TF_COMPRESSED_SRGB8_ETC2                     = GL_COMPRESSED_SRGB8_ETC2,
+    TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2  = GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 = GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    TF_COMPRESSED_RGBA8_ETC2_EAC                 = GL_COMPRESSED_RGBA8_ETC2_EAC,
+    TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC          = GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+    TF_COMPRESSED_R11_EAC                        = GL_COMPRESSED_R11_EAC,
+    TF_COMPRESSED_SIGNED_R11_EAC                 = GL_COMPRESSED_SIGNED_R11_EAC,
+    TF_COMPRESSED_RG11_EAC                       = GL_COMPRESSED_RG11_EAC,
+    TF_COMPRESSED_SIGNED_RG11_EAC                = GL_COMPRESSED_SIGNED_RG11_EAC,
+
+    // KHR_texture_compression_astc_ldr
+    TF_COMPRESSED_RGBA_ASTC_4x4_KHR         = GL_COMPRESSED_RGBA_ASTC_4x4_KHR,
+    TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR = GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR,
+
     // EXT_texture_integer
     TF_RGBA32UI_EXT = GL_RGBA32UI_EXT,
     TF_RGB32UI_EXT = GL_RGB32UI_EXT,
@@ -309,6 +331,32 @@ namespace vl
     IF_COMPRESSED_RGBA_S3TC_DXT3 = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
     IF_COMPRESSED_RGBA_S3TC_DXT5 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
 
+    // RGTC (BC4/BC5) and BPTC (BC6H/BC7)
+    IF_COMPRESSED_RED_RGTC1               = GL_COMPRESSED_RED_RGTC1,
+    IF_COMPRESSED_SIGNED_RED_RGTC1        = GL_COMPRESSED_SIGNED_RED_RGTC1,
+    IF_COMPRESSED_RG_RGTC2                = GL_COMPRESSED_RG_RGTC2,
+    IF_COMPRESSED_SIGNED_RG_RGTC2         = GL_COMPRESSED_SIGNED_RG_RGTC2,
+    IF_COMPRESSED_RGBA_BPTC_UNORM         = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB,
+    IF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM   = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB,
+    IF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT   = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB,
+    IF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB,
+
+    // ETC2/EAC
+    IF_COMPRESSED_RGB8_ETC2                      = GL_COMPRESSED_RGB8_ETC2,
+    IF_COMPRESSED_SRGB8_ETC2                     = GL_COMPRESSED_SRGB8_ETC2,
+    IF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2  = GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    IF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 = GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    IF_COMPRESSED_RGBA8_ETC2_EAC                 = GL_COMPRESSED_RGBA8_ETC2_EAC,
+    IF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC          = GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+    IF_COMPRESSED_R11_EAC                        = GL_COMPRESSED_R11_EAC,
+    IF_COMPRESSED_SIGNED_R11_EAC                 = GL_COMPRESSED_SIGNED_R11_EAC,
+    IF_COMPRESSED_RG11_EAC                       = GL_COMPRESSED_RG11_EAC,
+    IF_COMPRESSED_SIGNED_RG11_EAC                = GL_COMPRESSED_SIGNED_RG11_EAC,
+
+    // ASTC (only the 4x4 block footprint is supported)
+    IF_COMPRESSED_RGBA_ASTC_4x4         = GL_COMPRESSED_RGBA_ASTC_4x4_KHR,
+    IF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 = GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR,
+
     // GL 3.0 (EXT_texture_integer)
     IF_RED_INTEGER   = GL_RED_INTEGER,
     IF_GREEN_INTEGER = GL_GREEN_INTEGER,
@@ -948,6 +996,13 @@ namespace vl
     ID_Error
   } EImageDimension;
 
+  //! Downsampling filters used by Image::generateMipmaps()
+  typedef enum
+  {
+    MF_Box,    //!< Each texel is the average of the 2x2 (2x2x2 for 3D images) texels it covers: fastest.
+    MF_Kaiser  //!< Kaiser-windowed sinc over 6 texels per axis: sharper and with less aliasing than MF_Box.
+  } EMipmapFilter;
+
   typedef enum
   {
     ST_RenderStates = 1,
@@ -1096,7 +1151,13 @@ namespace vl
     RS_TextureMatrix15 = RS_TextureMatrix + 15,
     /* ... */
 
-    RS_RenderStateCount = RS_TextureMatrix + VL_MAX_LEGACY_TEXTURE_UNITS,
+    RS_ShaderStorageBuffer = RS_TextureMatrix + VL_MAX_LEGACY_TEXTURE_UNITS,
+    /* ... */
+
+    RS_ImageUnit = RS_ShaderStorageBuffer + VL_MAX_SHADER_STORAGE_BUFFER_BINDINGS,
+    /* ... */
+
+    RS_RenderStateCount = RS_ImageUnit + VL_MAX_IMAGE_UNITS,
 
     RS_NONE,
 
@@ -1291,7 +1352,8 @@ namespace vl
     ST_TESS_CONTROL_SHADER    = GL_TESS_CONTROL_SHADER, //!< A shader that is intended to run on the programmable tessellation processor in the control stage.
     ST_TESS_EVALUATION_SHADER = GL_TESS_EVALUATION_SHADER, //!< A shader that is intended to run on the programmable tessellation processor in the evaluation stage.
     ST_GEOMETRY_SHADER        = GL_GEOMETRY_SHADER, //!< A shader that is intended to run on the programmable geometry processor.
-    ST_FRAGMENT_SHADER        = GL_FRAGMENT_SHADER //!< A shader that is intended to run on the programmable fragment processor.
+    ST_FRAGMENT_SHADER        = GL_FRAGMENT_SHADER, //!< A shader that is intended to run on the programmable fragment processor.
+    ST_COMPUTE_SHADER         = GL_COMPUTE_SHADER //!< A shader that is intended to run on the programmable compute processor, outside of the rendering pipeline.
   } EShaderType;
 
   typedef enum
@@ -1310,6 +1372,13 @@ namespace vl
     VEL_VERBOSITY_DEBUG   //!<< Outputs extra information messages useful for debugging, plus all normal and error messages.
   } EVerbosityLevel;
 
+  //! How the OpenGL errors are detected, see GlobalSettings::setOpenGLErrorCheck().
+  typedef enum {
+    GEC_GET_ERROR,        //!<< VL_CHECK_OGL() calls glGetError(), which synchronizes with the driver every time.
+    GEC_DEBUG_OUTPUT,     //!<< The errors are reported asynchronously by GL_KHR_debug / GL_ARB_debug_output, VL_CHECK_OGL() only records its location.
+    GEC_DEBUG_OUTPUT_TRAP //!<< Like GEC_DEBUG_OUTPUT but the errors are reported synchronously and trapped inside the failing OpenGL call.
+  } EOpenGLErrorCheck;
+
   typedef enum
   {
     LL_LogNotify,
@@ -1340,6 +1409,15 @@ namespace vl
                  //!< shader attribute variable declared with 64-bit double precision components, data format must be \a double.
   } EVertexAttribInterpretation;
 
+  //! Normal compression schemes used by Geometry::quantize()
+  typedef enum
+  {
+    NQ_None,       //!< Normals are left untouched.
+    NQ_Byte3,      //!< Normals are stored as 3 normalized signed bytes (ArrayByte3), usable also by the fixed function pipeline.
+    NQ_Short3,     //!< Normals are stored as 3 normalized signed shorts (ArrayShort3), usable also by the fixed function pipeline.
+    NQ_Octahedral  //!< Normals are octahedron-encoded into 2 normalized signed shorts (ArrayShort2), they must be decoded by a GLSL vertex shader.
+  } ENormalQuantization;
+
   //! Default vertex attribute bindings
   typedef enum
   {
@@ -1377,6 +1455,8 @@ namespace vl
     VA_Bitangent         = VA_TexCoord7, // bitangent vectors (normal mapping)
     VA_NextPosition      = VA_TexCoord8, // next frame vertex position for vertex blending
     VA_NextNormal        = VA_TexCoord9, // next frame normal position for vertex blending
+    VA_JointWeights      = VA_TexCoord9, // joint weights for skinning (vl_VertexJointWeights)
+    VA_JointIndices      = VA_TexCoord10, // joint indices for skinning (vl_VertexJointIndices)
   } EVertexAttribBinding;
 
   //! Uniform types, see also vl::UniformInfo, vl::GLSLProgram, vl::Uniform, http://www.opengl.org/sdk/docs/man4/xhtml/glGetActiveUniform.xml
@@ -1533,6 +1613,31 @@ namespace vl
     BUM_DiscardRamBufferAndForceUpdate = BUF_DiscardRamBuffer | BUF_ForceUpdate
   } EBufferObjectUpdateMode;
 
+  //! Memory categories reported by MemoryTracker.
+  typedef enum
+  {
+    //! Heap storage of Buffer, including the local storage of BufferObject and ArrayAbstract.
+    MC_Buffer,
+    //! Heap storage of the pixels of Image.
+    MC_Image,
+    //! GPU storage of BufferObject and of the pages of BufferObjectPool.
+    MC_BufferObject,
+    //! GPU storage of Texture, estimated from the size and format of the texture.
+    MC_Texture,
+    //! Display lists compiled by Renderable, only their number is known.
+    MC_DisplayList,
+
+    MC_MemoryCategoryCount
+  } EMemoryCategory;
+
+  //! The region where a ParticleEmitter spawns its particles.
+  typedef enum
+  {
+    PES_Point,  //!< All the particles start at the emitter position.
+    PES_Box,    //!< The particles start uniformly distributed in a box whose half size is the emitter extent.
+    PES_Sphere  //!< The particles start uniformly distributed in a sphere whose radius is the x of the emitter extent.
+  } EParticleEmitterShape;
+
   typedef enum
   {
     SCM_OwnShaders, //!< A local copy of the Shaders will be created but the contained render states will be shared.
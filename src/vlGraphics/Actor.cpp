@@ -31,6 +31,10 @@
 
 #include <vlGraphics/Actor.hpp>
 
+#ifdef VL_ATOMIC_REF_COUNT
+  #include <atomic>
+#endif
+
 using namespace vl;
 
 //-----------------------------------------------------------------------------
@@ -81,6 +85,20 @@ void Actor::deleteOcclusionQuery()
   }
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+#ifdef VL_ATOMIC_REF_COUNT
+  std::atomic<long long> gBoundsEpoch(0);
+#else
+  long long gBoundsEpoch = 0;
+#endif
+}
+//-----------------------------------------------------------------------------
+long long Actor::nextBoundsEpoch()
+{
+  return ++gBoundsEpoch;
+}
+//-----------------------------------------------------------------------------
 bool Actor::boundsDirty() const
 {
   // (1) renderable dirty or we're not up to date with the renderable.
@@ -92,10 +110,10 @@ bool Actor::boundsDirty() const
   return dirty;
 }
 //-----------------------------------------------------------------------------
-void Actor::computeBounds()
+bool Actor::computeBounds()
 {
   if ( ! lod(0) ) {
-    return;
+    return false;
   }
 
   bool geom_update = lod(0)->boundsDirty() || lod(0)->boundsUpdateTick() != mBoundsUpdateTick;
@@ -114,6 +132,13 @@ void Actor::computeBounds()
     mSphere = mAABB.isNull() ? Sphere() : mAABB;
     mBoundsUpdateTick = lod(0)->boundsUpdateTick();
   }
+  else
+  {
+    return false;
+  }
+
+  mBoundsUpdateEpoch = gBoundsEpoch;
+  return true;
 }
 //-----------------------------------------------------------------------------
 void Actor::setUniform(Uniform* uniform) { gocUniformSet()->setUniform(uniform); }
@@ -141,7 +141,8 @@ namespace vl
     */
     Actor(Renderable* renderable = NULL, Effect* effect = NULL, Transform* transform = NULL, int block = 0, int rank = 0):
       mEffect(effect), mTransform(transform), mRenderBlock(block), mRenderRank(rank),
-      mTransformUpdateTick(-1), mBoundsUpdateTick(-1), mEnableMask(0xFFFFFFFF), mOcclusionQuery(0), mOcclusionQueryTick(0xFFFFFFFF), mIsOccludee(true), mEnabled(true)
+      mTransformUpdateTick(-1), mBoundsUpdateTick(-1), mBoundsUpdateEpoch(-1), mEnableMask(0xFFFFFFFF), mOcclusionQuery(0), mOcclusionQueryTick(0xFFFFFFFF), mIsOccludee(true), mOcclusionQueryPending(false), mOccluded(false), mEnabled(true),
+      mLODCacheOwner(NULL), mLODCacheEffect(NULL), mLODCacheTransformTick(-1), mLODCacheBoundsTick(-1), mCachedEffectLOD(0), mCachedGeometryLOD(0)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mActorEventCallbacks.setAutomaticDelete(false);
@@ -159,6 +160,7 @@ namespace vl
     void setLod(int lod_index, Renderable* renderable)
     {
       mRenderables[lod_index] = renderable;
+      DirtyTracker::markDirty();
 
       // schedule update of the Actor's bounds.
       if (lod_index == 0)
@@ -184,6 +186,7 @@ namespace vl
       mTransform = transform;
       mTransformUpdateTick = -1;
       mBoundsUpdateTick    = -1;
+      DirtyTracker::markDirty();
     }
 
     /** Returns the Transform bound tho an Actor */
@@ -193,7 +196,7 @@ namespace vl
     const Transform* transform() const { return mTransform.get(); }
 
     /** Binds an Effect to an Actor */
-    void setEffect(Effect* effect) { mEffect = effect; }
+    void setEffect(Effect* effect) { mEffect = effect; DirtyTracker::markDirty(); }
 
     /** Returns the Effect bound to an Actor */
     Effect* effect() { return mEffect.get(); }
@@ -213,8 +216,15 @@ namespace vl
     /** Returns the bounding sphere (\p guaranteed to be up to date) that contains this Actor. \sa boundingSphere() */
     const Sphere& boundingSphereSafe() { computeBounds(); return mSphere; }
 
-    /** Computes the bounding box and bounding sphere of an Actor if boundsDirty(). */
-    void computeBounds();
+    /** Computes the bounding box and bounding sphere of an Actor if boundsDirty(). Returns true if the bounds have been recomputed. */
+    bool computeBounds();
+
+    /** For internal use only. Starts a new bounds epoch and returns it: the Actor[s] whose bounds are recomputed from now on
+      * report it as their boundsUpdateEpoch(). Called by Rendering::updateTransforms(), see Rendering::statsBoundsUpdates(). */
+    static long long nextBoundsEpoch();
+
+    /** For internal use only. The bounds epoch during which computeBounds() last recomputed the bounds, see nextBoundsEpoch(). */
+    long long boundsUpdateEpoch() const { return mBoundsUpdateEpoch; }
 
     /** Returns whether the Actor's bounding box and sphere are up to date. */
     bool boundsDirty() const;
@@ -228,7 +238,7 @@ namespace vl
 
     \sa setRenderBlock(), Effect::setRenderRank()
     */
-    void setRenderRank(int rank) { mRenderRank = rank; }
+    void setRenderRank(int rank) { mRenderRank = rank; DirtyTracker::markDirty(); }
 
     /**
     Modifies the rendering block of an Actor.
@@ -240,7 +250,7 @@ namespace vl
 
     \sa setRenderRank(), Effect::setRenderRank()
     */
-    void setRenderBlock(int block) { mRenderBlock = block; }
+    void setRenderBlock(int block) { mRenderBlock = block; DirtyTracker::markDirty(); }
 
     /** Returns the rendering rank of an Actor. */
     int renderRank() const { return mRenderRank; }
@@ -249,7 +259,7 @@ namespace vl
     int renderBlock() const { return mRenderBlock; }
 
     /** Installs the LODEvaluator used to compute the current LOD at rendering time. */
-    void setLODEvaluator(LODEvaluator* lod_evaluator) { mLODEvaluator = lod_evaluator; }
+    void setLODEvaluator(LODEvaluator* lod_evaluator) { mLODEvaluator = lod_evaluator; invalidateLODCache(); }
 
     /** Returns the installed LODEvaluator (if any) or NULL. */
     LODEvaluator* lodEvaluator() { return mLODEvaluator.get(); }
@@ -262,7 +272,7 @@ namespace vl
     /** The enable mask of an Actor is usually used to defines whether the actor should be rendered or not
       * depending on the Rendering::enableMask() but it can also be used for user-specific tasks (set to 0xFFFFFFFF by default).
       * \see Actor::enableMask(), Actor::isEnabled(), ActorTreeAbstract::isEnabled(), SceneManager::enableMask(), Rendering::enableMask(), Rendering::effectOverrideMask(), Renderer::enableMask(), Renderer::shaderOverrideMask(). */
-    void setEnableMask(unsigned int mask) { mEnableMask = mask; }
+    void setEnableMask(unsigned int mask) { mEnableMask = mask; DirtyTracker::markDirty(); }
 
     /** The enable mask of an Actor is usually used to defines whether the actor should be rendered or not
       * depending on the Rendering::enableMask() but it can also be used for user-specific tasks (set to 0xFFFFFFFF by default).
@@ -271,7 +281,7 @@ namespace vl
 
     //! Whether an Actor should be considered for rendering, picking, scene bounding box calculation etc.
     //! \see Actor::enableMask(), Actor::isEnabled(), ActorTreeAbstract::isEnabled(), SceneManager::enableMask(), Rendering::enableMask(), Rendering::effectOverrideMask(), Renderer::enableMask(), Renderer::shaderOverrideMask().
-    void setEnabled(bool enabled) { mEnabled = enabled; }
+    void setEnabled(bool enabled) { mEnabled = enabled; DirtyTracker::markDirty(); }
     //! Whether an Actor should be considered for rendering, picking, scene bounding box calculation etc.
     //! \see Actor::enableMask(), Actor::isEnabled(), ActorTreeAbstract::isEnabled(), SceneManager::enableMask(), Rendering::enableMask(), Rendering::effectOverrideMask(), Renderer::enableMask(), Renderer::shaderOverrideMask().
     bool isEnabled() const { return mEnabled; }
@@ -444,6 +454,44 @@ namespace vl
     /** For internal use only. */
     unsigned occlusionQueryTick() const { return mOcclusionQueryTick; }
 
+    /** For internal use only. Whether an occlusion query has been issued whose result has not been retrieved yet. */
+    void setOcclusionQueryPending(bool pending) { mOcclusionQueryPending = pending; }
+
+    /** For internal use only. Whether an occlusion query has been issued whose result has not been retrieved yet. */
+    bool occlusionQueryPending() const { return mOcclusionQueryPending; }
+
+    /** For internal use only. The last known result of the occlusion query. */
+    void setOccluded(bool occluded) { mOccluded = occluded; }
+
+    /** For internal use only. The last known result of the occlusion query. */
+    bool isOccluded() const { return mOccluded; }
+
+    /** For internal use only. Stores the LODs evaluated by \p owner using \p effect, see Rendering::setLODCacheEnabled(). */
+    void setCachedLODs(const Object* owner, const Effect* effect, int effect_lod, int geometry_lod)
+    {
+      mLODCacheOwner = owner;
+      mLODCacheEffect = effect;
+      mLODCacheTransformTick = mTransformUpdateTick;
+      mLODCacheBoundsTick = mBoundsUpdateTick;
+      mCachedEffectLOD = effect_lod;
+      mCachedGeometryLOD = geometry_lod;
+    }
+
+    /** For internal use only. Returns the LODs stored by \p owner with setCachedLODs() if they were evaluated using \p effect
+      * and the Actor did not move since then, otherwise returns false. */
+    bool cachedLODs(const Object* owner, const Effect* effect, int& effect_lod, int& geometry_lod) const
+    {
+      if ( mLODCacheOwner != owner || mLODCacheEffect != effect || mLODCacheTransformTick != mTransformUpdateTick || mLODCacheBoundsTick != mBoundsUpdateTick )
+        return false;
+      effect_lod = mCachedEffectLOD;
+      geometry_lod = mCachedGeometryLOD;
+      return true;
+    }
+
+    /** Discards the LODs cached by Rendering::setLODCacheEnabled() so that they are evaluated at the next rendering.
+      * Call it after changing the LODEvaluator of the Actor's Effect or the parameters of a LODEvaluator. */
+    void invalidateLODCache() { mLODCacheOwner = NULL; }
+
 #ifdef VL_USER_DATA_ACTOR
   public:
     const Object* actorUserData() const { return mActorUserData.get(); }
@@ -468,11 +516,21 @@ namespace vl
     int mRenderRank;
     long long mTransformUpdateTick;
     long long mBoundsUpdateTick;
+    long long mBoundsUpdateEpoch;
     unsigned int mEnableMask;
     GLuint mOcclusionQuery;
     unsigned mOcclusionQueryTick;
     bool mIsOccludee;
+    bool mOcclusionQueryPending;
+    bool mOccluded;
     bool mEnabled;
+    // LODs cached by Rendering::setLODCacheEnabled()
+    const Object* mLODCacheOwner;
+    const Effect* mLODCacheEffect;
+    long long mLODCacheTransformTick;
+    long long mLODCacheBoundsTick;
+    int mCachedEffectLOD;
+    int mCachedGeometryLOD;
   };
   //---------------------------------------------------------------------------
   /** Defined as a simple subclass of Collection<Actor>, see Collection for more information. */
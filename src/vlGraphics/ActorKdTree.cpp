@@ -31,6 +31,7 @@
 
 #include <vlGraphics/ActorKdTree.hpp>
 #include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
 #include <algorithm>
 
 using namespace vl;
@@ -64,6 +65,13 @@ namespace
     VL_CHECK(a2->lod(0))
     return a1->boundingBox().minCorner().z() < a2->boundingBox().minCorner().z();
   }
+  //-----------------------------------------------------------------------------
+  real surfaceArea(const AABB& aabb)
+  {
+    if (aabb.isNull())
+      return 0;
+    return 2 * ( aabb.width() * aabb.height() + aabb.height() * aabb.depth() + aabb.depth() * aabb.width() );
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -106,6 +114,11 @@ void ActorKdTree::buildKdTree(ActorCollection& acts, int max_depth, float minimu
   int counter = 0;
   prepareActors(acts);
   compileTree_internal(acts, counter, max_depth, minimum_volume);
+
+  mUseSAH = false;
+  mMaxDepth = max_depth;
+  mMinimumVolume = minimum_volume;
+  resetRefitInfo();
 }
 //-----------------------------------------------------------------------------
 void ActorKdTree::rebuildKdTree(int max_depth, float minimum_volume)
@@ -115,6 +128,254 @@ void ActorKdTree::rebuildKdTree(int max_depth, float minimum_volume)
   buildKdTree(acts, max_depth, minimum_volume);
 }
 //-----------------------------------------------------------------------------
+void ActorKdTree::buildKdTreeSAH(ActorCollection& acts, int max_depth, int max_leaf_actors, int thread_count)
+{
+  prepareActors(acts);
+
+  // the first levels are built serially and generate the subtrees to be built in parallel
+  int job_depth = 0;
+#ifdef _OPENMP
+  for(int n = 1; n < thread_count; n *= 2)
+    ++job_depth;
+  if (job_depth)
+    ++job_depth;
+#endif
+
+  std::vector<BuildJob> jobs;
+  compileTreeSAH_internal(acts, 0, max_depth, max_leaf_actors, job_depth ? &jobs : NULL, job_depth);
+
+  const int job_count = (int)jobs.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(thread_count) if(thread_count > 1)
+#endif
+  for(int i=0; i<job_count; ++i)
+    jobs[i].mNode->compileTreeSAH_internal(*jobs[i].mActors, job_depth, max_depth, max_leaf_actors, NULL, 0);
+
+  mUseSAH = true;
+  mMaxDepth = max_depth;
+  mMaxLeafActors = max_leaf_actors;
+  mThreadCount = thread_count;
+  resetRefitInfo();
+}
+//-----------------------------------------------------------------------------
+void ActorKdTree::compileTreeSAH_internal(ActorCollection& acts, int depth, int max_depth, int max_leaf_actors, std::vector<BuildJob>* jobs, int job_depth)
+{
+  if (jobs && depth == job_depth)
+  {
+    BuildJob job;
+    job.mNode = this;
+    job.mActors = new ActorCollection;
+    *job.mActors = acts;
+    jobs->push_back(job);
+    return;
+  }
+
+  mChildN = NULL;
+  mChildP = NULL;
+  actors()->clear();
+  mAABB.setNull();
+  mPlane = Plane();
+
+  if (acts.size() == 0)
+    return;
+
+  computeLocalAABB(acts);
+
+  if ( acts.size() <= max_leaf_actors || depth >= max_depth || !findBestPlaneSAH(mPlane, acts) )
+  {
+    mActors = acts;
+    return;
+  }
+
+  ActorCollection actorsN;
+  ActorCollection actorsP;
+  actorsN.reserve(acts.size());
+  actorsP.reserve(acts.size());
+
+  for(int i=0; i<(int)acts.size(); ++i)
+  {
+    switch( mPlane.classify(acts[i]->boundingBox()) )
+    {
+    case  0: actors()->push_back(acts[i].get()); break;
+    case -1: actorsN.  push_back(acts[i].get()); break;
+    case +1: actorsP.  push_back(acts[i].get()); break;
+    }
+  }
+
+  if (actorsN.size())
+  {
+    setChildN(new ActorKdTree);
+    childN()->compileTreeSAH_internal(actorsN, depth+1, max_depth, max_leaf_actors, jobs, job_depth);
+  }
+
+  if (actorsP.size())
+  {
+    setChildP(new ActorKdTree);
+    childP()->compileTreeSAH_internal(actorsP, depth+1, max_depth, max_leaf_actors, jobs, job_depth);
+  }
+}
+//-----------------------------------------------------------------------------
+bool ActorKdTree::findBestPlaneSAH(Plane& plane, const ActorCollection& acts)
+{
+  const int Bins = 16;
+  const int count = (int)acts.size();
+  const real parent_area = surfaceArea(mAABB);
+  if (parent_area <= 0)
+    return false;
+
+  // cost of a leaf: all the Actors are tested
+  real best_cost = (real)count;
+  bool found = false;
+
+  for(int axis=0; axis<3; ++axis)
+  {
+    const real lo  = mAABB.minCorner()[axis];
+    const real ext = mAABB.maxCorner()[axis] - lo;
+    if (ext <= 0)
+      continue;
+
+    int  cnt_min[Bins] = { 0 };
+    int  cnt_max[Bins] = { 0 };
+    AABB box_min[Bins];
+    AABB box_max[Bins];
+    for(int i=0; i<count; ++i)
+    {
+      const AABB& aabb = acts[i]->boundingBox();
+      int bmin = vl::clamp( (int)( (aabb.minCorner()[axis] - lo) / ext * Bins ), 0, Bins-1 );
+      int bmax = vl::clamp( (int)( (aabb.maxCorner()[axis] - lo) / ext * Bins ), 0, Bins-1 );
+      cnt_min[bmin]++;
+      box_min[bmin] += aabb;
+      cnt_max[bmax]++;
+      box_max[bmax] += aabb;
+    }
+
+    // Actors entirely on the negative side of the k-th bin boundary: the ones whose max falls in a bin < k.
+    int  n_cnt[Bins];
+    AABB n_box[Bins];
+    n_cnt[0] = cnt_max[0];
+    n_box[0] = box_max[0];
+    for(int k=1; k<Bins; ++k)
+    {
+      n_cnt[k] = n_cnt[k-1] + cnt_max[k];
+      n_box[k] = n_box[k-1] + box_max[k];
+    }
+
+    // Actors entirely on the positive side of the k-th bin boundary: the ones whose min falls in a bin >= k.
+    int  p_cnt = 0;
+    AABB p_box;
+    for(int k=Bins-1; k>0; --k)
+    {
+      p_cnt += cnt_min[k];
+      p_box += box_min[k];
+
+      const int nN = n_cnt[k-1];
+      const int nP = p_cnt;
+      if (nN == 0 && nP == 0)
+        continue;
+      const int nC = count - nN - nP;
+      // traversal + straddling Actors kept in the node + children weighted by the probability of being visited
+      real cost = 1 + nC + ( surfaceArea(n_box[k-1]) * nN + surfaceArea(p_box) * nP ) / parent_area;
+      if (cost < best_cost)
+      {
+        vec3 normal;
+        normal[axis] = 1;
+        plane = Plane(lo + ext * k / Bins, normal);
+        best_cost = cost;
+        found = true;
+      }
+    }
+  }
+
+  return found;
+}
+//-----------------------------------------------------------------------------
+void ActorKdTree::refitNode()
+{
+  AABB aabb;
+  for(int i=0; i<actors()->size(); ++i)
+    aabb += actors()->at(i)->boundingBox();
+  if (mChildN)
+    aabb += mChildN->aabb();
+  if (mChildP)
+    aabb += mChildP->aabb();
+  mAABB = aabb;
+}
+//-----------------------------------------------------------------------------
+real ActorKdTree::sumNodeAreas() const
+{
+  real area = surfaceArea(mAABB);
+  if (mChildN)
+    area += mChildN->sumNodeAreas();
+  if (mChildP)
+    area += mChildP->sumNodeAreas();
+  return area;
+}
+//-----------------------------------------------------------------------------
+void ActorKdTree::resetRefitInfo()
+{
+  mActorNodeMap.clear();
+  mActorNodeMapDirty = true;
+  mBuildArea = mCurrentArea = sumNodeAreas();
+}
+//-----------------------------------------------------------------------------
+void ActorKdTree::buildActorNodeMap(ActorKdTree* node)
+{
+  for(int i=0; i<node->actors()->size(); ++i)
+    mActorNodeMap[ node->actors()->at(i) ] = node;
+  if (node->childN())
+    buildActorNodeMap(node->childN());
+  if (node->childP())
+    buildActorNodeMap(node->childP());
+}
+//-----------------------------------------------------------------------------
+bool ActorKdTree::refit(ActorCollection& moved_actors)
+{
+  for(int i=0; i<moved_actors.size(); ++i)
+  {
+    Actor* actor = moved_actors[i].get();
+    actor->computeBounds();
+
+    // locate the node containing the Actor, the map is regenerated if the tree has been modified in the meantime.
+    std::map< const Actor*, ActorKdTree* >::iterator it = mActorNodeMap.find(actor);
+    if ( mActorNodeMapDirty || it == mActorNodeMap.end() || it->second->actors()->find(actor) == -1 )
+    {
+      mActorNodeMap.clear();
+      buildActorNodeMap(this);
+      mActorNodeMapDirty = false;
+      it = mActorNodeMap.find(actor);
+      if ( it == mActorNodeMap.end() )
+      {
+        Log::warning("ActorKdTree::refit(): Actor not found in the tree.\n");
+        continue;
+      }
+    }
+
+    // update the bounding boxes up to this node, stop as soon as one does not change.
+    for(ActorKdTree* node = it->second; node; node = node == this ? NULL : static_cast<ActorKdTree*>(node->parent()))
+    {
+      AABB old_aabb = node->aabb();
+      node->refitNode();
+      if (node->aabb() == old_aabb)
+        break;
+      mCurrentArea += surfaceArea(node->aabb()) - surfaceArea(old_aabb);
+    }
+  }
+
+  if ( mRebuildThreshold > 0 && mBuildArea > 0 && mCurrentArea > mBuildArea * mRebuildThreshold )
+  {
+    Log::debug( Say("ActorKdTree::refit(): tree degraded by %.2nx, rebuilding.\n") << degradation() );
+    ActorCollection acts;
+    extractActors(acts);
+    if (mUseSAH)
+      buildKdTreeSAH(acts, mMaxDepth, mMaxLeafActors, mThreadCount);
+    else
+      buildKdTree(acts, mMaxDepth, mMinimumVolume);
+    return true;
+  }
+
+  return false;
+}
+//-----------------------------------------------------------------------------
 void ActorKdTree::compileTree_internal(ActorCollection& acts, int& counter, int max_depth, float minimum_volume)
 {
   mChildN = NULL;
@@ -269,6 +530,7 @@ bool ActorKdTree::findBestPlane(Plane& plane, int& counter, ActorCollection& act
 ActorKdTree* ActorKdTree::insertActor(Actor* actor)
 {
   VL_CHECK(actor->lod(0))
+  mActorNodeMapDirty = true;
   if (childN() == 0 && childP() == 0)
     actors()->push_back(actor);
   else
@@ -38,6 +38,7 @@
 #include <vlCore/Plane.hpp>
 #include <vlCore/Collection.hpp>
 #include <vlGraphics/ActorTreeAbstract.hpp>
+#include <map>
 
 namespace vl
 {
@@ -59,7 +60,8 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::ActorKdTree, ActorTreeAbstract)
 
   public:
-    ActorKdTree()
+    ActorKdTree(): mBuildArea(0), mCurrentArea(0), mRebuildThreshold(2.0f), mActorNodeMapDirty(true),
+                   mUseSAH(false), mMaxDepth(100), mMinimumVolume(0), mMaxLeafActors(4), mThreadCount(1)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -80,6 +82,38 @@ namespace vl
   //! \note This method calls prepareActors() before computing the KdTree.
   void rebuildKdTree(int max_depth=100, float minimum_volume=0);
 
+  /**
+   * Builds a ActorKdTree with the given list of Actors choosing the splitting planes using a binned surface area heuristic.
+   * This produces trees that are culled faster than the ones generated by buildKdTree(), especially when the Actors are unevenly
+   * distributed, at the price of a slightly longer build time.
+   * \param actors The Actors to be inserted in the tree.
+   * \param max_depth The maximum depth of the tree.
+   * \param max_leaf_actors Nodes with this number of Actors or less are not split further.
+   * \param thread_count The number of threads used to build independent subtrees in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP).
+   * \note This method calls prepareActors() before computing the KdTree.
+   */
+  void buildKdTreeSAH(ActorCollection& actors, int max_depth=100, int max_leaf_actors=4, int thread_count=1);
+
+  /**
+   * Updates bottom-up the bounding boxes of the nodes containing the given Actors, which must have been moved since the last build or refit.
+   * Unlike rebuildKdTree() the tree topology is not changed, so the cost is proportional to the number of moved Actors and not to the size of the tree.
+   * Since refitting degrades the quality of the tree, when the sum of the surface areas of the nodes exceeds rebuildThreshold() times the one
+   * right after the last build, the tree is automatically rebuilt with the same method and parameters used the last time.
+   * \note Must be called on the root node of the tree.
+   * \return true if the tree has been rebuilt.
+   */
+  bool refit(ActorCollection& moved_actors);
+
+  //! Ratio between the current sum of the surface areas of the nodes and the one right after the last build above which refit() rebuilds the tree.
+  //! Set to 0 to disable automatic rebuilding. Defaults to 2.
+  void setRebuildThreshold(float threshold) { mRebuildThreshold = threshold; }
+
+  //! Ratio between the current sum of the surface areas of the nodes and the one right after the last build above which refit() rebuilds the tree.
+  float rebuildThreshold() const { return mRebuildThreshold; }
+
+  //! The current sum of the surface areas of the nodes divided by the one right after the last build, 1 means no degradation.
+  float degradation() const { return mBuildArea > 0 ? (float)(mCurrentArea / mBuildArea) : 1.0f; }
+
   //! Returns the splitting plane used to divide its two child nodes
   const Plane& plane() const { return mPlane; }
 
@@ -145,10 +179,41 @@ namespace vl
     //!
     void computeLocalAABB(const ActorCollection& actors);
 
+    struct BuildJob
+    {
+      ActorKdTree* mNode;
+      ref<ActorCollection> mActors;
+    };
+    //! Finds the splitting plane minimizing the surface area heuristic cost, returns false if no split is better than a leaf.
+    bool findBestPlaneSAH(Plane& plane, const ActorCollection& actors);
+    //! If \p jobs is not NULL the nodes at depth \p job_depth are not built but appended to \p jobs to be built in parallel.
+    void compileTreeSAH_internal(ActorCollection& acts, int depth, int max_depth, int max_leaf_actors, std::vector<BuildJob>* jobs, int job_depth);
+    //! Recomputes the bounding box of this node only, from its Actors and its children bounding boxes.
+    void refitNode();
+    //! Sum of the surface areas of this node and of all its descendants.
+    real sumNodeAreas() const;
+    //! Resets the refit()/degradation() bookkeeping after a build.
+    void resetRefitInfo();
+    void buildActorNodeMap(ActorKdTree* node);
+
   protected:
     Plane mPlane;
     ref<ActorKdTree> mChildN;
     ref<ActorKdTree> mChildP;
+
+  private:
+    // used by the root node only, see refit()
+    std::map< const Actor*, ActorKdTree* > mActorNodeMap;
+    real mBuildArea;
+    real mCurrentArea;
+    float mRebuildThreshold;
+    bool mActorNodeMapDirty;
+    // parameters of the last build
+    bool mUseSAH;
+    int mMaxDepth;
+    float mMinimumVolume;
+    int mMaxLeafActors;
+    int mThreadCount;
   };
 
 }
@@ -31,6 +31,8 @@
 
 #include <vlGraphics/ActorTreeAbstract.hpp>
 #include <vlGraphics/Camera.hpp>
+#include <algorithm>
+#include <limits>
 
 using namespace vl;
 
@@ -40,6 +42,7 @@ ActorTreeAbstract::ActorTreeAbstract()
   VL_DEBUG_SET_OBJECT_NAME()
   mActors.setAutomaticDelete(false);
   mParent = NULL;
+  mLastCulledPlane = -1;
   mEnabled = true;
 }
 //-----------------------------------------------------------------------------
@@ -75,31 +78,283 @@ void ActorTreeAbstract::extractActors(ActorCollection& list)
   }
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  //! Collects the bounding spheres of up to BatchSize Actors in SoA layout to be culled at once.
+  class SphereBatch
+  {
+  public:
+    static const int BatchSize = 64;
+
+    SphereBatch(): mCount(0) {}
+
+    //! Returns true if the batch is full and must be flushed.
+    bool add(Actor* actor)
+    {
+      const Sphere& sphere = actor->boundingSphere();
+      mActors[mCount]  = actor;
+      mCenterX[mCount] = (float)sphere.center().x();
+      mCenterY[mCount] = (float)sphere.center().y();
+      mCenterZ[mCount] = (float)sphere.center().z();
+      mRadius[mCount]  = sphere.isNull() ? -1.0f : (float)sphere.radius();
+      return ++mCount == BatchSize;
+    }
+
+    //! Culls the collected Actors, appends the visible ones to \p list in order and empties the batch.
+    void flush(ActorCollection& list, const Frustum& frustum)
+    {
+      if (!mCount)
+        return;
+      frustum.cullSpheres(mCount, mCenterX, mCenterY, mCenterZ, mRadius, mVisible);
+      for(int i=0; i<mCount; ++i)
+        if ( mVisible[i >> 5] & (1u << (i & 31)) )
+          list.push_back(mActors[i]);
+      mCount = 0;
+    }
+
+  private:
+    Actor* mActors[BatchSize];
+    float mCenterX[BatchSize];
+    float mCenterY[BatchSize];
+    float mCenterZ[BatchSize];
+    float mRadius[BatchSize];
+    u32 mVisible[BatchSize / 32];
+    int mCount;
+  };
+}
+//-----------------------------------------------------------------------------
 void ActorTreeAbstract::extractVisibleActors(ActorCollection& list, const Camera* camera, unsigned enable_mask)
 {
+  // coherent culling with plane masking
+  if ( camera && camera->frustum().planes().size() <= 32 )
+  {
+    const unsigned plane_count = (unsigned)camera->frustum().planes().size();
+    extractVisibleActors( list, camera->frustum(), enable_mask, plane_count == 32 ? 0xFFFFFFFF : (1u << plane_count) - 1 );
+    return;
+  }
+
   // If enabled try and cull the whole node
   if ( ! isEnabled() || ( camera && camera->frustum().cull( aabb() ) ) ) {
     return;
   }
 
-  // Cull / extract this node's Actors
+  // Cull / extract this node's Actors, the bounding spheres are culled in batches using Frustum::cullSpheres()
+  SphereBatch batch;
   for( int i = 0; i < actors()->size(); ++i )
   {
-    if ( actors()->at(i)->isEnabled() && ( enable_mask & actors()->at(i)->enableMask() ) )
+    Actor* actor = actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
     {
-      actors()->at(i)->computeBounds();
-      if ( camera && camera->frustum().cull( actors()->at(i)->boundingSphere() ) ) {
-        continue;
-      } else {
-        list.push_back(actors()->at(i));
+      actor->computeBounds();
+      if ( !camera ) {
+        list.push_back(actor);
+      } else if ( batch.add(actor) ) {
+        batch.flush(list, camera->frustum());
       }
     }
   }
+  if ( camera ) {
+    batch.flush(list, camera->frustum());
+  }
 
   // Descend to child nodes
   for( int i = 0; i < childrenCount(); ++i ) {
     if ( child(i) ) {
-      child(i)->extractVisibleActors( list, camera );
+      child(i)->extractVisibleActors( list, camera, enable_mask );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractVisibleActors(ActorCollection& list, const Frustum& frustum, unsigned enable_mask, u32 plane_mask)
+{
+  // If enabled try and cull the whole node against the planes it is not already known to be inside of
+  if ( ! isEnabled() || ( plane_mask && frustum.cull( aabb(), plane_mask, mLastCulledPlane ) ) ) {
+    return;
+  }
+
+  // Cull / extract this node's Actors, if the node is entirely inside the frustum no test is needed
+  SphereBatch batch;
+  for( int i = 0; i < actors()->size(); ++i )
+  {
+    Actor* actor = actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
+    {
+      actor->computeBounds();
+      if ( !plane_mask ) {
+        list.push_back(actor);
+      } else if ( batch.add(actor) ) {
+        batch.flush(list, frustum);
+      }
+    }
+  }
+  batch.flush(list, frustum);
+
+  // Descend to child nodes
+  for( int i = 0; i < childrenCount(); ++i ) {
+    if ( child(i) ) {
+      child(i)->extractVisibleActors( list, frustum, enable_mask, plane_mask );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractMultiViewVisibleActors(ActorCollection& list, std::vector<u32>& view_masks, const std::vector<const Camera*>& cameras, unsigned enable_mask, u32 view_mask)
+{
+  if ( ! isEnabled() ) {
+    return;
+  }
+
+  // drop the views that cannot see this node
+  const int view_count = (int)cameras.size() < 32 ? (int)cameras.size() : 32;
+  u32 node_mask = 0;
+  for( int iview = 0; iview < view_count; ++iview ) {
+    if ( ( view_mask & (1u << iview) ) && ! cameras[iview]->frustum().cull( aabb() ) ) {
+      node_mask |= 1u << iview;
+    }
+  }
+  if ( ! node_mask ) {
+    return;
+  }
+
+  for( int i = 0; i < actors()->size(); ++i )
+  {
+    Actor* actor = actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
+    {
+      actor->computeBounds();
+      u32 actor_mask = 0;
+      for( int iview = 0; iview < view_count; ++iview ) {
+        if ( ( node_mask & (1u << iview) ) && ! cameras[iview]->frustum().cull( actor->boundingSphere() ) ) {
+          actor_mask |= 1u << iview;
+        }
+      }
+      if ( actor_mask ) {
+        list.push_back(actor);
+        view_masks.push_back(actor_mask);
+      }
+    }
+  }
+
+  // Descend to child nodes
+  for( int i = 0; i < childrenCount(); ++i ) {
+    if ( child(i) ) {
+      child(i)->extractMultiViewVisibleActors( list, view_masks, cameras, enable_mask, node_mask );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractActorsInBox(ActorCollection& list, const AABB& box, unsigned enable_mask)
+{
+  if ( ! isEnabled() || ( ! aabb().isNull() && ! aabb().intersects( box ) ) ) {
+    return;
+  }
+
+  for( int i = 0; i < actors()->size(); ++i )
+  {
+    Actor* actor = actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
+    {
+      actor->computeBounds();
+      if ( ! actor->boundingBox().isNull() && actor->boundingBox().intersects( box ) ) {
+        list.push_back(actor);
+      }
+    }
+  }
+
+  for( int i = 0; i < childrenCount(); ++i ) {
+    if ( child(i) ) {
+      child(i)->extractActorsInBox( list, box, enable_mask );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractActorsInSphere(ActorCollection& list, const Sphere& sphere, unsigned enable_mask)
+{
+  const real radius2 = sphere.radius() * sphere.radius();
+  if ( ! isEnabled() || ( ! aabb().isNull() && aabb().squaredDistance( sphere.center() ) > radius2 ) ) {
+    return;
+  }
+
+  for( int i = 0; i < actors()->size(); ++i )
+  {
+    Actor* actor = actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
+    {
+      actor->computeBounds();
+      if ( ! actor->boundingBox().isNull() && actor->boundingBox().squaredDistance( sphere.center() ) <= radius2 ) {
+        list.push_back(actor);
+      }
+    }
+  }
+
+  for( int i = 0; i < childrenCount(); ++i ) {
+    if ( child(i) ) {
+      child(i)->extractActorsInSphere( list, sphere, enable_mask );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractNearestActors(ActorCollection& list, const vec3& point, int k, unsigned enable_mask, real max_distance)
+{
+  if ( k <= 0 ) {
+    return;
+  }
+
+  NearestHeap heap;
+  heap.reserve( k );
+  extractNearestActors( heap, point, k, enable_mask, max_distance < 0 ? std::numeric_limits<real>::max() : max_distance * max_distance );
+
+  // sort_heap() leaves the nearest Actor first
+  std::sort_heap( heap.begin(), heap.end() );
+  for( size_t i = 0; i < heap.size(); ++i ) {
+    list.push_back( heap[i].second );
+  }
+}
+//-----------------------------------------------------------------------------
+void ActorTreeAbstract::extractNearestActors(NearestHeap& heap, const vec3& point, int k, unsigned enable_mask, real max_dist2)
+{
+  // a null aabb() means the node bounds have not been computed and the node cannot be skipped
+  if ( ! isEnabled() || ( ! aabb().isNull() && aabb().squaredDistance( point ) > ( (int)heap.size() == k ? heap.front().first : max_dist2 ) ) ) {
+    return;
+  }
+
+  for( int i = 0; i < actors()->size(); ++i )
+  {
+    Actor* actor = actors()->at(i);
+    if ( ! actor->isEnabled() || ! ( enable_mask & actor->enableMask() ) ) {
+      continue;
+    }
+    actor->computeBounds();
+    if ( actor->boundingBox().isNull() ) {
+      continue;
+    }
+    const real dist2 = actor->boundingBox().squaredDistance( point );
+    if ( (int)heap.size() < k )
+    {
+      if ( dist2 <= max_dist2 )
+      {
+        heap.push_back( std::make_pair( dist2, actor ) );
+        std::push_heap( heap.begin(), heap.end() );
+      }
+    }
+    else
+    if ( dist2 < heap.front().first )
+    {
+      std::pop_heap( heap.begin(), heap.end() );
+      heap.back() = std::make_pair( dist2, actor );
+      std::push_heap( heap.begin(), heap.end() );
+    }
+  }
+
+  // visit the nearest child first so that the farthest is more likely to be skipped
+  int first = 0;
+  if ( childrenCount() == 2 && child(0) && child(1) && ! child(0)->aabb().isNull() && ! child(1)->aabb().isNull() ) {
+    first = child(1)->aabb().squaredDistance( point ) < child(0)->aabb().squaredDistance( point ) ? 1 : 0;
+  }
+  for( int i = 0; i < childrenCount(); ++i )
+  {
+    ActorTreeAbstract* node = child( ( i + first ) % childrenCount() );
+    if ( node ) {
+      node->extractNearestActors( heap, point, k, enable_mask, max_dist2 );
     }
   }
 }
@@ -110,6 +365,7 @@ ActorTreeAbstract* ActorTreeAbstract::eraseActor(Actor* actor)
   if (pos != -1)
   {
     actors()->eraseAt(pos);
+    DirtyTracker::markDirty();
     return this;
   }
   else
@@ -126,12 +382,14 @@ Actor* ActorTreeAbstract::addActor(Renderable* renderable, Effect* eff, Transfor
 {
   ref<Actor> act = new Actor(renderable,eff,tr);
   actors()->push_back( act.get() );
+  DirtyTracker::markDirty();
   return act.get();
 }
 //-----------------------------------------------------------------------------
 Actor* ActorTreeAbstract::addActor(Actor* actor)
 {
   actors()->push_back(actor);
+  DirtyTracker::markDirty();
   return actor;
 }
 //-----------------------------------------------------------------------------
@@ -34,10 +34,14 @@
 
 #include <vlGraphics/Actor.hpp>
 #include <vlCore/AABB.hpp>
+#include <vlCore/Sphere.hpp>
 #include <set>
+#include <vector>
 
 namespace vl
 {
+  class Frustum;
+
   /** The ActorTreeAbstract class implements the interface of a generic tree containing Actors in its nodes.
    *
    * The interface of ActorTreeAbstract allows you to:
@@ -98,6 +102,42 @@ namespace vl
      */
     void extractVisibleActors(ActorCollection& list, const Camera* camera, unsigned enable_mask=0xFFFFFFFF);
 
+    /**
+     * Coherent version of extractVisibleActors() used when a Camera is given: each node is tested only against the
+     * frustum planes in \p plane_mask that its parent was not entirely inside of, testing first the plane that culled it
+     * last time. The Actors of the nodes entirely inside the frustum are extracted without further testing.
+     */
+    void extractVisibleActors(ActorCollection& list, const Frustum& frustum, unsigned enable_mask, u32 plane_mask);
+
+    /**
+     * Multi-view version of extractVisibleActors(): each node is tested against the frusta of the cameras in \p view_mask
+     * that did not cull its parent, and the traversal stops as soon as no camera sees the node.
+     * For each Actor appended to \p list the bitmask of the cameras it is visible from is appended to \p view_masks.
+     * \see SceneManager::extractMultiViewVisibleActors()
+     */
+    void extractMultiViewVisibleActors(ActorCollection& list, std::vector<u32>& view_masks, const std::vector<const Camera*>& cameras, unsigned enable_mask, u32 view_mask);
+
+    /**
+     * Appends to \p list the enabled Actors whose bounding box intersects the given box.
+     * The nodes whose aabb() does not intersect \p box are skipped together with their children, the Actors are tested using the
+     * same bounding boxes used by extractVisibleActors(). Actors with a null bounding box are never returned.
+     */
+    void extractActorsInBox(ActorCollection& list, const AABB& box, unsigned enable_mask=0xFFFFFFFF);
+
+    /**
+     * Appends to \p list the enabled Actors whose bounding box intersects the given sphere.
+     * \see extractActorsInBox()
+     */
+    void extractActorsInSphere(ActorCollection& list, const Sphere& sphere, unsigned enable_mask=0xFFFFFFFF);
+
+    /**
+     * Appends to \p list the \p k enabled Actors whose bounding box is nearest to \p point, sorted by increasing distance.
+     * If \p max_distance is not negative the Actors farther than \p max_distance are ignored.
+     * The nodes are visited nearest first and skipped as soon as their aabb() is farther than the k-th Actor found so far.
+     * Actors with a null bounding box are never returned.
+     */
+    void extractNearestActors(ActorCollection& list, const vec3& point, int k, unsigned enable_mask=0xFFFFFFFF, real max_distance=-1);
+
     /**
      * Removes the given Actor from the ActorTreeAbstract.
      */
@@ -128,10 +168,16 @@ namespace vl
     //! \see Actor::enableMask(), Actor::isEnabled(), ActorTreeAbstract::isEnabled(), SceneManager::enableMask(), Rendering::enableMask(), Rendering::effectOverrideMask(), Renderer::enableMask(), Renderer::shaderOverrideMask().
     bool isEnabled() const { return mEnabled; }
 
+  protected:
+    // max-heap of the k nearest Actors found so far, keyed by squared distance
+    typedef std::vector< std::pair<real, Actor*> > NearestHeap;
+    void extractNearestActors(NearestHeap& heap, const vec3& point, int k, unsigned enable_mask, real max_dist2);
+
   protected:
     ActorTreeAbstract* mParent;
     ActorCollection mActors;
     AABB mAABB;
+    int mLastCulledPlane;
     bool mEnabled;
   };
 }
@@ -35,6 +35,7 @@
 #include <vlGraphics/link_config.hpp>
 #include <vlGraphics/Geometry.hpp>
 #include <vlCore/Time.hpp>
+#include <vlCore/MurmurHash3.hpp>
 
 namespace vl
 {
@@ -234,8 +235,51 @@ namespace vl
         }
       };
 
+      /** Maps every vertex to the first vertex sharing its exact position. */
+      static void weldVertices( const ArrayAbstract* verts, std::vector<u32>& weld ) {
+        const u32 vert_count = (u32)verts->size();
+        weld.resize( vert_count );
+        std::vector<fvec3> pos( vert_count );
+        for( u32 i = 0; i < vert_count; ++i ) {
+          pos[ i ] = (fvec3)verts->getAsVec3( i );
+          // -0 and +0 must weld together
+          for( int j = 0; j < 3; ++j ) {
+            if ( pos[ i ][ j ] == 0 ) {
+              pos[ i ][ j ] = 0;
+            }
+          }
+        }
+        u32 table_size = 64;
+        while( table_size < vert_count * 2 ) {
+          table_size <<= 1;
+        }
+        const u32 mask = table_size - 1;
+        std::vector<u32> table( table_size, 0xFFFFFFFF );
+        for( u32 i = 0; i < vert_count; ++i ) {
+          u32 h = 0;
+          MurmurHash3_x86_32( pos[ i ].ptr(), sizeof( fvec3 ), 0, &h );
+          for( u32 slot = h & mask; ; slot = ( slot + 1 ) & mask ) {
+            if ( table[ slot ] == 0xFFFFFFFF ) {
+              table[ slot ] = weld[ i ] = i;
+              break;
+            }
+            if ( pos[ table[ slot ] ] == pos[ i ] ) {
+              weld[ i ] = table[ slot ];
+              break;
+            }
+          }
+        }
+      }
+
   public:
-    static ref< Geometry > extract( Geometry* geom ) {
+    /** Returns a new Geometry sharing the vertex and normal arrays of \p geom whose draw calls are
+      * the PT_TRIANGLES_ADJACENCY version of the triangles of \p geom. Border edges are marked by an
+      * adjacent vertex equal to the first vertex of the edge.
+      * If \p weld_vertices is \p true vertices sharing the same position are considered the same vertex,
+      * so that meshes with split normals or texture coordinates are still seen as connected. In this case
+      * the generated indices refer to the first vertex of each position, which is only important if the
+      * adjacency geometry uses attributes other than the position. */
+    static ref< Geometry > extract( Geometry* geom, bool weld_vertices = false ) {
 
       #ifndef NDEBUG
         float t0 = Time::currentTime();
@@ -245,6 +289,11 @@ namespace vl
       geom_adj->setVertexArray( geom->vertexArray() );
       geom_adj->setNormalArray( geom->normalArray() );
 
+      std::vector<u32> weld;
+      if ( weld_vertices && geom->vertexArray() ) {
+        weldVertices( geom->vertexArray(), weld );
+      }
+
       int total_triangles = 0;
       for( int idc = 0; idc < geom->drawCalls().size(); ++idc ) {
         int triangle_count = 0;
@@ -266,6 +315,11 @@ namespace vl
           u32 a = trit.a();
           u32 b = trit.b();
           u32 c = trit.c();
+          if ( ! weld.empty() ) {
+            a = weld[ a ];
+            b = weld[ b ];
+            c = weld[ c ];
+          }
           STriangle triangle( a, b, c );
           edge_map.put( triangle.edge[0].id(), triangle.edge[0] );
           edge_map.put( triangle.edge[1].id(), triangle.edge[1] );
@@ -284,6 +338,11 @@ namespace vl
           u32 a = trit.a();
           u32 b = trit.b();
           u32 c = trit.c();
+          if ( ! weld.empty() ) {
+            a = weld[ a ];
+            b = weld[ b ];
+            c = weld[ c ];
+          }
 
           // NOTE: degenerate edges are important for border detection.
 
@@ -142,6 +142,8 @@ namespace vl
      * Called by updateEvent() right before rendering()->render() and swapping opengl front/back buffers.
      * \note Since updateScene() is called by updateEvent() this function is called only if somebody
      * requests a OpenGLContext::update() or if OpenGLContext::continuousUpdate() is set to \p true.
+     * \note When OpenGLContext::updateOnDemand() is enabled the changes performed here do not trigger a new frame:
+     * applets animating their scene in updateScene() should register as a continuous source, see DirtyTracker.
      */
 	  virtual void updateScene() {}
 
@@ -34,6 +34,7 @@
 
 #include <vlGraphics/BufferObject.hpp>
 #include <vlCore/half.hpp>
+#include <vlCore/TransformKernels.hpp>
 #include <vector>
 
 namespace vl
@@ -54,6 +55,12 @@ namespace vl
    * - vl::ArrayUByte1, vl::ArrayUByte2, vl::ArrayUByte3, vl::ArrayUByte4
    * - vl::ArrayShort1, vl::ArrayShort2, vl::ArrayShort3, vl::ArrayShort4
    * - vl::ArrayUShort1, vl::ArrayUShort2, vl::ArrayUShort3, vl::ArrayUShort4
+   *
+   * \par Copy-on-write
+   * cowClone() returns an array sharing the BufferObject, that is both the local storage and the GPU buffer, of this
+   * one. The shared storage is duplicated by the first array that modifies it through the non-const ptr(), at(),
+   * operator[](), begin(), end(), resize(), clear() etc. methods, see detach(). Writing through bufferObject()
+   * directly bypasses this mechanism: call detach() first.
    */
   class ArrayAbstract: public Object
   {
@@ -65,10 +72,15 @@ namespace vl
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mBufferObject = new BufferObject;
+      mBufferObject->setPool( defBufferObjectPool() );
       mBufferObjectDirty = true;
+      mBufferObjectDirtyTick = 0;
       mBufferObjectUsage = vl::BU_STATIC_DRAW;
       mInterpretation = VAI_NORMAL;
       mNormalize = false;
+      mInterleavedOffset = 0;
+      mInterleavedStride = 0;
+      mCopyOnWrite = false;
     }
 
     //! Copies only the local data and not the BufferObject related fields
@@ -76,34 +88,93 @@ namespace vl
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mBufferObject = new BufferObject;
+      mBufferObject->setPool( defBufferObjectPool() );
       mBufferObjectDirty = true;
+      mBufferObjectDirtyTick = 0;
       mBufferObjectUsage = vl::BU_STATIC_DRAW;
       mInterpretation = VAI_NORMAL;
       mNormalize = false;
+      mInterleavedOffset = 0;
+      mInterleavedStride = 0;
+      mCopyOnWrite = false;
       operator=(other);
     }
 
     //! Copies only the local data and not the BufferObject related fields
     void operator=(const ArrayAbstract& other)
     {
-      bufferObject()->resize( other.bufferObject()->bytesUsed() );
-      memcpy( ptr(), other.ptr(), bytesUsed() );
+      // nothing to copy if the storage is shared, see cowClone()
+      if ( mBufferObject != other.mBufferObject )
+      {
+        detach(false);
+        bufferObject()->resize( other.bufferObject()->bytesUsed() );
+        memcpy( ptr(), other.ptr(), bytesUsed() );
+      }
       mInterpretation = other.mInterpretation;
       mNormalize = other.mNormalize;
+      ++mBufferObjectDirtyTick;
     }
 
     virtual ref<ArrayAbstract> clone() const = 0;
 
+    //! Returns a copy-on-write clone of the array: the two arrays share the same BufferObject until one of them is modified, see detach().
+    virtual ref<ArrayAbstract> cowClone() const = 0;
+
+    //! Makes this array share the BufferObject of \p other, both the local storage and the GPU buffer, until either of them
+    //! is modified. Also copies the interpretation, normalize and usage settings.
+    void shareBufferObject(const ArrayAbstract& other)
+    {
+      if ( mBufferObject == other.mBufferObject )
+        return;
+      mBufferObject = const_cast<BufferObject*>( other.mBufferObject.get() );
+      mCopyOnWrite = true;
+      other.mCopyOnWrite = true;
+      // an array sourced from an interleaved buffer has no GPU copy of its own
+      mBufferObjectDirty = other.mBufferObjectDirty || !other.mBufferObject->handle();
+      ++mBufferObjectDirtyTick;
+      mBufferObjectUsage = other.mBufferObjectUsage;
+      mInterpretation = other.mInterpretation;
+      mNormalize = other.mNormalize;
+    }
+
+    //! Returns true if the BufferObject is currently shared with another array, see cowClone().
+    bool isShared() const { return mCopyOnWrite && mBufferObject->referenceCount() > 1; }
+
+    //! If the BufferObject is shared with another array (see cowClone()) gives this array a private copy of the local storage,
+    //! downloading it from the GPU if it was discarded, and marks the array as dirty so that it gets its own GPU buffer.
+    //! Called automatically by the non-const accessors, there is no need to call it unless you write through bufferObject().
+    //! \param copy_data If false the new local storage is left empty, use it when the array is about to be overwritten.
+    void detach(bool copy_data=true)
+    {
+      if ( !mCopyOnWrite )
+        return;
+      mCopyOnWrite = false;
+      if ( mBufferObject->referenceCount() == 1 )
+        return;
+      ref<BufferObject> bo = new BufferObject;
+      bo->setPool( defBufferObjectPool() );
+      if ( copy_data )
+      {
+        if ( mBufferObject->bytesUsed() == 0 && mBufferObject->handle() )
+          mBufferObject->downloadBufferObject();
+        bo->resize( mBufferObject->bytesUsed() );
+        if ( bo->bytesUsed() )
+          memcpy( bo->ptr(), mBufferObject->ptr(), bo->bytesUsed() );
+      }
+      mBufferObject = bo;
+      setBufferObjectDirty(true);
+    }
+
     const BufferObject* bufferObject() const { return mBufferObject.get(); }
     BufferObject* bufferObject() { return mBufferObject.get(); }
 
-    void clear() { if (bufferObject()) bufferObject()->clear(); }
+    void clear() { detach(false); if (bufferObject()) bufferObject()->clear(); }
 
     //! Returns the pointer to the first element of the local buffer. Equivalent to bufferObject()->ptr()
     const unsigned char* ptr() const { return bufferObject() ? bufferObject()->ptr() : NULL; }
 
     //! Returns the pointer to the first element of the local buffer. Equivalent to bufferObject()->ptr()
-    unsigned char* ptr() { return bufferObject() ? bufferObject()->ptr() : NULL; }
+    unsigned char* ptr() { if (mCopyOnWrite) detach(); return bufferObject() ? bufferObject()->ptr() : NULL; }
 
     //! Returns the amount of memory in bytes used by an array. Equivalent to bufferObject()->bytesUsed().
     virtual size_t bytesUsed() const { return bufferObject() ? bufferObject()->bytesUsed() : 0; }
@@ -149,7 +220,11 @@ namespace vl
     //! Wether the BufferObject should be updated or not using the local storage. Initially set to true.
     //! IMPORTANT: To automatically update the buffer object of a Renderable, Geometry etc. you also need to call Renderable::setBufferObjectDirty().
     //! IMPORTANT: To immediately update the buffer object manually call the updateBufferObject() method of this class.
-    void setBufferObjectDirty(bool dirty=true) { mBufferObjectDirty = dirty; }
+    void setBufferObjectDirty(bool dirty=true) { mBufferObjectDirty = dirty; if (dirty) ++mBufferObjectDirtyTick; }
+
+    //! Incremented every time setBufferObjectDirty(true) is called, that is, every time the local storage is flagged as modified.
+    //! Used to detect when the data derived from the array, like the Geometry::triangleBVH(), must be recomputed.
+    long long bufferObjectDirtyTick() const { return mBufferObjectDirtyTick; }
 
     //! BU_STATIC_DRAW by default
     EBufferObjectUsage usage() const { return mBufferObjectUsage; }
@@ -181,12 +256,39 @@ namespace vl
     //! How the data is interpreted by the OpenGL, see EVertexAttribInterpretation.
     EVertexAttribInterpretation interpretation() const { return mInterpretation; }
 
+    //! Makes the OpenGL source this array from \p buffer_object, starting at \p offset bytes and with \p stride bytes between
+    //! consecutive vectors, see Geometry::interleave(). The local storage of the array is not affected and remains the one
+    //! to be used to read and write the array. Pass NULL to source the array again from its own bufferObject().
+    void setInterleavedView(BufferObject* buffer_object, int offset, int stride)
+    {
+      mInterleavedBufferObject = buffer_object;
+      mInterleavedOffset = buffer_object ? offset : 0;
+      mInterleavedStride = buffer_object ? stride : 0;
+    }
+
+    //! The interleaved BufferObject this array is sourced from, NULL by default, see setInterleavedView().
+    const BufferObject* interleavedBufferObject() const { return mInterleavedBufferObject.get(); }
+
+    //! The interleaved BufferObject this array is sourced from, NULL by default, see setInterleavedView().
+    BufferObject* interleavedBufferObject() { return mInterleavedBufferObject.get(); }
+
+    //! The offset in bytes of the first vector within interleavedBufferObject(), see setInterleavedView().
+    int interleavedOffset() const { return mInterleavedOffset; }
+
+    //! The distance in bytes between two consecutive vectors within interleavedBufferObject(), see setInterleavedView().
+    int interleavedStride() const { return mInterleavedStride; }
+
   protected:
     ref<BufferObject> mBufferObject;
+    ref<BufferObject> mInterleavedBufferObject;
+    int mInterleavedOffset;
+    int mInterleavedStride;
     EBufferObjectUsage mBufferObjectUsage;
+    long long mBufferObjectDirtyTick;
     bool mBufferObjectDirty;
     EVertexAttribInterpretation mInterpretation;
     bool mNormalize;
+    mutable bool mCopyOnWrite;
   };
 //-----------------------------------------------------------------------------
 // Array
@@ -228,9 +330,18 @@ namespace vl
 
     // ---
 
-    void clear() { resize(0); bufferObject()->deleteBufferObject(); }
+    void clear() { detach(false); resize(0); bufferObject()->deleteBufferObject(); }
+
+    void resize(size_t dim) { detach(); bufferObject()->resize(dim*bytesPerVector()); }
+
+    //! Makes room for \p dim vectors without reallocating the local storage, see Buffer::reserve().
+    void reserve(size_t dim) { detach(); bufferObject()->reserve(dim*bytesPerVector()); }
 
-    void resize(size_t dim) { bufferObject()->resize(dim*bytesPerVector()); }
+    //! The number of vectors the local storage can hold without reallocating, see Buffer::capacity().
+    size_t capacity() const { return bufferObject() ? bufferObject()->capacity() / bytesPerVector() : 0; }
+
+    //! Releases the unused capacity of the local storage, see Buffer::shrink().
+    void shrink() { detach(); bufferObject()->shrink(); }
 
     size_t size() const { return bytesUsed() / bytesPerVector(); }
 
@@ -275,6 +386,13 @@ namespace vl
       return arr;
     }
 
+    virtual ref<ArrayAbstract> cowClone() const
+    {
+      ref<ArrayAbstract> arr = createArray();
+      arr->shareBufferObject(*this);
+      return arr;
+    }
+
     // ---
 
     Sphere computeBoundingSphere() const
@@ -321,19 +439,7 @@ namespace vl
 
     void transform(const mat4& m)
     {
-      for(size_t i=0; i<size(); ++i)
-      {
-        vec4 v(0,0,0,1);
-        T_Scalar* pv = reinterpret_cast<T_Scalar*>(&at(i));
-        // read
-        for( size_t j=0; j<T_GL_Size; ++j )
-          v.ptr()[j] = (real)pv[j];
-        // transform
-        v = m * v;
-        // write
-        for( size_t j=0; j<T_GL_Size; ++j )
-          pv[j] = (T_Scalar)v.ptr()[j];
-      }
+      transformElements(m, begin());
     }
 
     void normalize()
@@ -400,6 +506,31 @@ namespace vl
       else
         memcpy(ptr(),&vector[0],sizeof(vector[0])*vector.size());
     }
+
+  private:
+    // the arrays whose scalar type matches the precision of mat4 use the batched kernels of TransformKernels.hpp
+    void transformElements(const fmat4& m, fvec3* v) { transformPoints(m, v, v, size()); }
+    void transformElements(const fmat4& m, fvec4* v) { transformPoints(m, v, v, size()); }
+    void transformElements(const dmat4& m, dvec3* v) { transformPoints(m, v, v, size()); }
+    void transformElements(const dmat4& m, dvec4* v) { transformPoints(m, v, v, size()); }
+
+    template<typename T>
+    void transformElements(const mat4& m, T*)
+    {
+      for(size_t i=0; i<size(); ++i)
+      {
+        vec4 v(0,0,0,1);
+        T_Scalar* pv = reinterpret_cast<T_Scalar*>(&at(i));
+        // read
+        for( size_t j=0; j<T_GL_Size; ++j )
+          v.ptr()[j] = (real)pv[j];
+        // transform
+        v = m * v;
+        // write
+        for( size_t j=0; j<T_GL_Size; ++j )
+          pv[j] = (T_Scalar)v.ptr()[j];
+      }
+    }
   };
 //-----------------------------------------------------------------------------
 // Array typedefs
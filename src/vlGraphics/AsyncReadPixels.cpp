@@ -0,0 +1,244 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/AsyncReadPixels.hpp>
+#include <vlGraphics/ReadPixels.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// AsyncReadPixels
+//-----------------------------------------------------------------------------
+AsyncReadPixels::AsyncReadPixels(int x, int y, int width, int height, EReadDrawBuffer read_buffer, int ring_size):
+  mX ( x ),
+  mY ( y ),
+  mWidth ( width ),
+  mHeight ( height ),
+  mReadBuffer ( read_buffer ),
+  mFormat ( IF_RGBA ),
+  mType ( IT_UNSIGNED_BYTE ),
+  mNextSlot ( 0 ),
+  mOldestSlot ( 0 ),
+  mReadsIssued ( 0 ),
+  mReadsDropped ( 0 ),
+  mDropWhenFull ( false )
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mSlots.resize( ring_size > 0 ? ring_size : 1 );
+}
+//-----------------------------------------------------------------------------
+AsyncReadPixels::~AsyncReadPixels()
+{
+  // the buffer objects are released by their own destructors, the fences must be released here.
+#if defined(VL_OPENGL)
+  for( size_t i=0; i<mSlots.size(); ++i )
+  {
+    if ( mSlots[i].mFence )
+      glDeleteSync( mSlots[i].mFence );
+  }
+#endif
+}
+//-----------------------------------------------------------------------------
+void AsyncReadPixels::setRingSize(int size)
+{
+  flush();
+  releaseBuffers();
+  mSlots.clear();
+  mSlots.resize( size > 0 ? size : 1 );
+}
+//-----------------------------------------------------------------------------
+int AsyncReadPixels::pendingReads() const
+{
+  int count = 0;
+#if defined(VL_OPENGL)
+  for( size_t i=0; i<mSlots.size(); ++i )
+  {
+    if ( mSlots[i].mFence )
+      ++count;
+  }
+#endif
+  return count;
+}
+//-----------------------------------------------------------------------------
+void AsyncReadPixels::releaseBuffers()
+{
+#if defined(VL_OPENGL)
+  for( size_t i=0; i<mSlots.size(); ++i )
+  {
+    if ( mSlots[i].mFence )
+    {
+      glDeleteSync( mSlots[i].mFence ); VL_CHECK_OGL();
+      mSlots[i].mFence = NULL;
+    }
+    if ( mSlots[i].mBuffer )
+      mSlots[i].mBuffer->deleteBufferObject();
+  }
+#endif
+  mNextSlot = mOldestSlot = 0;
+}
+//-----------------------------------------------------------------------------
+void AsyncReadPixels::readPixels()
+{
+  if ( mWidth <= 0 || mHeight <= 0 )
+    return;
+
+#if defined(VL_OPENGL)
+  bool supports_async = Has_PBO && glFenceSync && glClientWaitSync && glDeleteSync;
+#else
+  bool supports_async = false;
+#endif
+
+  if ( !supports_async )
+  {
+    // synchronous fallback
+    Slot& slot = mSlots[0];
+    if ( !slot.mImage || slot.mImage->referenceCount() > 1 )
+      slot.mImage = new Image;
+    slot.mImage->setFormat( mFormat );
+    slot.mImage->setType( mType );
+    vl::readPixels( slot.mImage.get(), mX, mY, mWidth, mHeight, mReadBuffer, false );
+    deliverImage( slot.mImage.get(), mReadsIssued++ );
+    return;
+  }
+
+#if defined(VL_OPENGL)
+  // never wait for the GPU unless all the buffers are in flight
+  deliver(false);
+
+  Slot& slot = mSlots[mNextSlot];
+  if ( slot.mFence )
+  {
+    if ( mDropWhenFull )
+    {
+      ++mReadsDropped;
+      return;
+    }
+    // the next slot is the oldest in flight
+    if ( !deliverSlot(slot, true) )
+      return;
+    mOldestSlot = (mOldestSlot + 1) % (int)mSlots.size();
+  }
+
+  int bytes = Image::requiredMemory2D( mWidth, mHeight, 1, mFormat, mType );
+  if ( !slot.mBuffer )
+    slot.mBuffer = new BufferObject;
+  if ( slot.mBuffer->byteCountBufferObject() != bytes )
+    slot.mBuffer->setBufferData( bytes, NULL, BU_STREAM_READ );
+
+  glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT ); VL_CHECK_OGL();
+  glPixelStorei( GL_PACK_ALIGNMENT,   1 );
+  glPixelStorei( GL_PACK_ROW_LENGTH,  0 );
+  glPixelStorei( GL_PACK_SKIP_PIXELS, 0 );
+  glPixelStorei( GL_PACK_SKIP_ROWS,   0 );
+  glPixelStorei( GL_PACK_SWAP_BYTES,  0 );
+  glPixelStorei( GL_PACK_LSB_FIRST,   0 );
+
+  int prev = 0;
+  glGetIntegerv( GL_READ_BUFFER, &prev ); VL_CHECK_OGL();
+  glReadBuffer( mReadBuffer ); VL_CHECK_OGL();
+
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.mBuffer->handle() ); VL_CHECK_OGL();
+  glReadPixels( mX, mY, mWidth, mHeight, mFormat, mType, 0 ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 ); VL_CHECK_OGL();
+  slot.mFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ); VL_CHECK_OGL();
+
+  glReadBuffer( prev ); VL_CHECK_OGL();
+  glPopClientAttrib(); VL_CHECK_OGL();
+
+  slot.mFrame  = mReadsIssued++;
+  slot.mWidth  = mWidth;
+  slot.mHeight = mHeight;
+  slot.mFormat = mFormat;
+  slot.mType   = mType;
+
+  mNextSlot = (mNextSlot + 1) % (int)mSlots.size();
+#endif
+}
+//-----------------------------------------------------------------------------
+void AsyncReadPixels::deliver(bool wait)
+{
+#if defined(VL_OPENGL)
+  // reads complete in order: stop at the first one still in flight
+  for( size_t i=0; i<mSlots.size(); ++i )
+  {
+    Slot& slot = mSlots[mOldestSlot];
+    if ( !slot.mFence || !deliverSlot(slot, wait) )
+      return;
+    mOldestSlot = (mOldestSlot + 1) % (int)mSlots.size();
+  }
+#else
+  (void)wait;
+#endif
+}
+//-----------------------------------------------------------------------------
+bool AsyncReadPixels::deliverSlot(Slot& slot, bool wait)
+{
+#if defined(VL_OPENGL)
+  GLenum status = glClientWaitSync( slot.mFence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 0xFFFFFFFFFFFFFFFFull : 0 ); VL_CHECK_OGL();
+  if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+    return false;
+
+  glDeleteSync( slot.mFence ); VL_CHECK_OGL();
+  slot.mFence = NULL;
+
+  // recycle the Image unless the callback kept it
+  if ( !slot.mImage || slot.mImage->referenceCount() > 1 )
+    slot.mImage = new Image;
+  if ( slot.mImage->width() != slot.mWidth || slot.mImage->height() != slot.mHeight || slot.mImage->dimension() != ID_2D ||
+       slot.mImage->format() != slot.mFormat || slot.mImage->type() != slot.mType || slot.mImage->pixels() == NULL )
+    slot.mImage->allocate2D( slot.mWidth, slot.mHeight, 1, slot.mFormat, slot.mType );
+
+  const void* data = slot.mBuffer->mapBufferObject(BA_READ_ONLY);
+  if (!data)
+  {
+    Log::error("AsyncReadPixels::deliverSlot(): could not map the readback buffer.\n");
+    return true;
+  }
+  memcpy( slot.mImage->pixels(), data, slot.mImage->requiredMemory() );
+  slot.mBuffer->unmapBufferObject();
+
+  deliverImage( slot.mImage.get(), slot.mFrame );
+#else
+  (void)slot;
+  (void)wait;
+#endif
+  return true;
+}
+//-----------------------------------------------------------------------------
+void AsyncReadPixels::deliverImage(Image* image, unsigned long frame)
+{
+  if ( mCallback )
+    mCallback->onPixelsRead( this, image, frame );
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,198 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef AsyncReadPixels_INCLUDE_ONCE
+#define AsyncReadPixels_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <vlCore/Image.hpp>
+#include <vector>
+
+namespace vl
+{
+  class AsyncReadPixels;
+  //-----------------------------------------------------------------------------
+  // ReadbackCallback
+  //-----------------------------------------------------------------------------
+  //! Receives the Images read back by an AsyncReadPixels.
+  class ReadbackCallback: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::ReadbackCallback, Object)
+
+  public:
+    /** Called by the rendering thread with the pixels read during the \p frame-th readback issued by \p reader.
+      * The Image is recycled by the next readback of the same slot unless the callback keeps a reference to it. */
+    virtual void onPixelsRead(AsyncReadPixels* reader, Image* image, unsigned long frame) = 0;
+  };
+  //-----------------------------------------------------------------------------
+  // AsyncReadPixels
+  //-----------------------------------------------------------------------------
+  /**
+   * A RenderEventCallback that reads a rectangular pixel area without stalling the pipeline.
+   *
+   * Unlike ReadPixels, every event issues a glReadPixels() into the next of ringSize() pixel pack buffer objects
+   * and fences it. Completed reads are mapped and delivered to the ReadbackCallback one or more frames later, in order,
+   * when the GPU has finished with them, so that continuous captures (thumbnails, video frames) keep the GPU busy.
+   *
+   * If all the buffers are still in flight the oldest read is waited for (see setDropWhenFull() to skip the new read instead).
+   * Call flush() to wait for and deliver all the pending reads, for example before destroying the OpenGL context.
+   *
+   * When sync objects or pixel buffer objects are not available the pixels are read synchronously and delivered immediately.
+   *
+   * \note The pixels are tightly packed (1 byte alignment) and the Image might seem flipped upside down, as with vl::readPixels().
+   * \sa ReadPixels, ReadbackCallback, RenderEventCallback
+  */
+  class VLGRAPHICS_EXPORT AsyncReadPixels: public RenderEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::AsyncReadPixels, RenderEventCallback)
+
+  public:
+    AsyncReadPixels(int x=0, int y=0, int width=0, int height=0, EReadDrawBuffer read_buffer=RDB_BACK_LEFT, int ring_size=3);
+
+    ~AsyncReadPixels();
+
+    virtual bool onRenderingStarted(const RenderingAbstract*) { readPixels(); return true; }
+
+    virtual bool onRenderingFinished(const RenderingAbstract*) { readPixels(); return true; }
+
+    virtual bool onRendererStarted(const RendererAbstract*) { readPixels(); return true; }
+
+    virtual bool onRendererFinished(const RendererAbstract*) { readPixels(); return true; }
+
+    void setup(int x, int y, int width, int height, EReadDrawBuffer read_buffer)
+    {
+      mX = x;
+      mY = y;
+      mWidth  = width;
+      mHeight = height;
+      mReadBuffer = read_buffer;
+    }
+
+    void setX(int x) { mX = x; }
+    void setY(int y) { mY = y; }
+    void setWidth(int width) { mWidth = width; }
+    void setHeight(int height) { mHeight = height; }
+    void setReadBuffer(EReadDrawBuffer buffer) { mReadBuffer = buffer; }
+
+    int x() const { return mX; }
+    int y() const { return mY; }
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+    EReadDrawBuffer readBuffer() const { return mReadBuffer; }
+
+    //! The format and type of the delivered Images, IF_RGBA and IT_UNSIGNED_BYTE by default.
+    void setFormat(EImageFormat format, EImageType type) { mFormat = format; mType = type; }
+    EImageFormat format() const { return mFormat; }
+    EImageType type() const { return mType; }
+
+    //! The number of pixel pack buffers cycled, that is the maximum number of reads in flight. Flushes the pending reads.
+    void setRingSize(int size);
+    int ringSize() const { return (int)mSlots.size(); }
+
+    //! The callback receiving the Images.
+    void setCallback(ReadbackCallback* callback) { mCallback = callback; }
+    ReadbackCallback* callback() { return mCallback.get(); }
+    const ReadbackCallback* callback() const { return mCallback.get(); }
+
+    //! If true, when all the buffers are in flight the new read is skipped instead of waiting for the oldest one. Default is false.
+    void setDropWhenFull(bool drop) { mDropWhenFull = drop; }
+    bool dropWhenFull() const { return mDropWhenFull; }
+
+    //! Number of reads issued so far.
+    unsigned long readsIssued() const { return mReadsIssued; }
+
+    //! Number of reads skipped because all the buffers were in flight, see setDropWhenFull().
+    unsigned long readsDropped() const { return mReadsDropped; }
+
+    //! Number of reads currently in flight.
+    int pendingReads() const;
+
+    //! Issues a new read, delivering the completed ones first. Called by the rendering events.
+    void readPixels();
+
+    //! Delivers the completed reads without waiting for the GPU.
+    void deliverCompleted() { deliver(false); }
+
+    //! Waits for all the pending reads and delivers them. Requires the OpenGL context to be current.
+    void flush() { deliver(true); }
+
+    //! Releases the buffer objects and the fences discarding the pending reads. Requires the OpenGL context to be current.
+    void releaseBuffers();
+
+  protected:
+    struct Slot
+    {
+      Slot(): mFrame(0), mWidth(0), mHeight(0), mFormat(IF_RGBA), mType(IT_UNSIGNED_BYTE)
+      {
+      #if defined(VL_OPENGL)
+        mFence = NULL;
+      #endif
+      }
+
+      ref<BufferObject> mBuffer;
+      ref<Image> mImage;
+    #if defined(VL_OPENGL)
+      GLsync mFence;
+    #endif
+      unsigned long mFrame;
+      int mWidth;
+      int mHeight;
+      EImageFormat mFormat;
+      EImageType mType;
+    };
+
+    //! Delivers the pending reads in order, stops at the first one not yet completed unless \p wait is true.
+    void deliver(bool wait);
+    //! Waits for the given slot if \p wait is true, then maps it and delivers its Image. Returns false if not yet completed.
+    bool deliverSlot(Slot& slot, bool wait);
+    void deliverImage(Image* image, unsigned long frame);
+
+  protected:
+    int mX;
+    int mY;
+    int mWidth;
+    int mHeight;
+    EReadDrawBuffer mReadBuffer;
+    EImageFormat mFormat;
+    EImageType mType;
+    ref<ReadbackCallback> mCallback;
+    std::vector<Slot> mSlots;
+    int mNextSlot;    // the slot written by the next read
+    int mOldestSlot;  // the oldest slot in flight
+    unsigned long mReadsIssued;
+    unsigned long mReadsDropped;
+    bool mDropWhenFull;
+  };
+}
+
+#endif
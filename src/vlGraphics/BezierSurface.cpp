@@ -30,6 +30,10 @@
 /**************************************************************************************/
 
 #include <vlGraphics/BezierSurface.hpp>
+#include <vlGraphics/PatchParameter.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/Shader.hpp>
 
 using namespace vl;
 
@@ -86,6 +90,12 @@ void BezierPatch::resize(int x, int y)
 //-----------------------------------------------------------------------------
 void BezierSurface::updateBezierSurface(bool gen_tex_coords)
 {
+  if ( tessellationEnabled() )
+  {
+    updateControlPoints();
+    return;
+  }
+
   int patch_count = 0;
   for(unsigned ipatch=0; ipatch<patches().size(); ++ipatch)
     patch_count += ((patches()[ipatch]->x()-1)/3)*((patches()[ipatch]->y()-1)/3);
@@ -112,7 +122,7 @@ void BezierSurface::updateBezierSurface(bool gen_tex_coords)
   }
 
   ref<DrawElementsUInt> de = drawCalls().size() == 1 ? cast<DrawElementsUInt>(drawCalls().at(0)) : NULL;
-  if (!de)
+  if (!de || de->primitiveType() != PT_QUADS)
   {
     drawCalls().clear();
     de = new DrawElementsUInt(PT_QUADS);
@@ -185,3 +195,96 @@ void BezierSurface::updateBezierSurface(bool gen_tex_coords)
 #endif
 }
 //-----------------------------------------------------------------------------
+void BezierSurface::updateControlPoints()
+{
+  // the control points of all the patches, shared points are stored once
+  int point_count = 0;
+  int patch_count = 0;
+  for(unsigned ipatch=0; ipatch<patches().size(); ++ipatch)
+  {
+    point_count += patches()[ipatch]->x() * patches()[ipatch]->y();
+    patch_count += ((patches()[ipatch]->x()-1)/3)*((patches()[ipatch]->y()-1)/3);
+  }
+
+  ref<ArrayFloat3> vert_array = cast<ArrayFloat3>(vertexArray());
+  if (!vert_array)
+  {
+    vert_array = new ArrayFloat3;
+    setVertexArray(vert_array.get());
+  }
+  vert_array->resize(point_count);
+  vert_array->setBufferObjectDirty();
+
+  // generated by the tessellation evaluation shader
+  setTexCoordArray(0, NULL);
+  setNormalArray(NULL);
+
+  ref<DrawElementsUInt> de = drawCalls().size() == 1 ? cast<DrawElementsUInt>(drawCalls().at(0)) : NULL;
+  if (!de || de->primitiveType() != PT_PATCHES)
+  {
+    drawCalls().clear();
+    de = new DrawElementsUInt(PT_PATCHES);
+    ref<PatchParameter> patch_param = new PatchParameter;
+    patch_param->setPatchVertices(16);
+    de->setPatchParameter(patch_param.get());
+    drawCalls().push_back(de.get());
+  }
+  de->indexBuffer()->resize(16*patch_count);
+  de->indexBuffer()->setBufferObjectDirty();
+
+  int ivert = 0;
+  int iindex = 0;
+  for(unsigned ipatch=0; ipatch<patches().size(); ++ipatch)
+  {
+    const BezierPatch* p = patches()[ipatch].get();
+    for(size_t i=0; i<p->points().size(); ++i)
+      vert_array->at(ivert + (int)i) = (fvec3)p->points()[i];
+
+    // the 4x4 control points of each bicubic patch, x varying fastest as in the CPU evaluation
+    for(int ix=0; ix<p->x()-3; ix+=3)
+    for(int iy=0; iy<p->y()-3; iy+=3)
+      for(int j=0; j<4; ++j)
+        for(int i=0; i<4; ++i)
+          de->indexBuffer()->at(iindex++) = ivert + (ix+i) + p->x()*(iy+j);
+
+    ivert += (int)p->points().size();
+  }
+}
+//-----------------------------------------------------------------------------
+ref<GLSLProgram> BezierSurface::createTessellationProgram()
+{
+  ref<GLSLProgram> glsl = new GLSLProgram;
+  glsl->setObjectName("BezierSurface");
+  glsl->attachShader( new GLSLVertexShader("/glsl/bezier_surface.vs") );
+  glsl->attachShader( new GLSLTessControlShader("/glsl/bezier_surface.tcs") );
+  glsl->attachShader( new GLSLTessEvaluationShader("/glsl/bezier_surface.tes") );
+  glsl->attachShader( new GLSLFragmentShader("/glsl/bezier_surface.fs") );
+  return glsl;
+}
+//-----------------------------------------------------------------------------
+void BezierSurface::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
+{
+  // the tessellation control shader needs the viewport size to compute the screen-space tessellation levels
+  const GLSLProgram* glsl = shader ? shader->glslProgram() : NULL;
+  if ( tessellationEnabled() && glsl && glsl->handle() )
+  {
+    int location = glsl->getUniformLocation("vl_BezierViewport");
+    if ( location != -1 && camera->viewport() )
+    {
+      glUniform2f( location, (float)camera->viewport()->width(), (float)camera->viewport()->height() ); VL_CHECK_OGL();
+    }
+    location = glsl->getUniformLocation("vl_BezierPixelsPerEdge");
+    if ( location != -1 )
+    {
+      glUniform1f( location, tessellationPixelsPerEdge() ); VL_CHECK_OGL();
+    }
+    location = glsl->getUniformLocation("vl_BezierMaxLevel");
+    if ( location != -1 )
+    {
+      glUniform1f( location, maxTessellationLevel() ); VL_CHECK_OGL();
+    }
+  }
+
+  Geometry::render_Implementation(actor, shader, camera, gl_context);
+}
+//-----------------------------------------------------------------------------
@@ -36,6 +36,8 @@
 
 namespace vl
 {
+  class GLSLProgram;
+
   /** Defines one or more concatenated bicubic Bézier patches to be used with the BezierSurface class.
     See also:
     - \ref pagGuideBezierSurfaces "Bézier Patches and Surfaces Tutorial" for a practical example on how to use the BezierSurface class.
@@ -87,6 +89,14 @@ namespace vl
 
     "Bézier surfaces were first described in 1972 by the French engineer Pierre Bézier who used them to design automobile bodies. Bézier surfaces can be of any degree, but bicubic Bézier surfaces generally provide enough degrees of freedom for most applications."</i>
 
+    \par GPU tessellation
+    If tessellationEnabled() is true updateBezierSurface() only uploads the control points, each bicubic patch being drawn as a 16 vertices
+    PT_PATCHES primitive, and the surface is evaluated by the tessellation shaders of the GLSLProgram returned by createTessellationProgram().
+    The tessellation level of each patch edge is computed every frame so that the projected segments are about tessellationPixelsPerEdge()
+    pixels long, patches outside the view frustum are discarded. Moving the control points only requires calling updateBezierSurface() again,
+    which rewrites the control points without re-evaluating the surface. Texture coordinates and normals are computed by the shaders.
+    Requires OpenGL 4.0 or GL_ARB_tessellation_shader.
+
     See also:
     - \ref pagGuideBezierSurfaces "Bézier Patches and Surfaces Tutorial" for a practical example on how to use the BezierSurface class.
     - BezierPatch
@@ -97,7 +107,7 @@ namespace vl
 
   public:
     //! Constructor
-    BezierSurface(): mDetail(16)
+    BezierSurface(): mDetail(16), mTessellationPixelsPerEdge(8.0f), mMaxTessellationLevel(64.0f), mTessellationEnabled(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -117,11 +127,43 @@ namespace vl
     //! Note that this method does not recompte the normals of the mesh, this means that if you are using the OpenGL lighting or other
     //! techniques requiring vertex normals you should call computeNormals() right after calling this function.
     //! \param gen_tex_coords If set to \p true the function will also generate normalized (0..1) texture coordinates.
+    //! If tessellationEnabled() is true only the control points are updated and \p gen_tex_coords is ignored.
     void updateBezierSurface(bool gen_tex_coords=true);
 
+    //! If true the surface is evaluated by the tessellation shaders, see createTessellationProgram(). Call updateBezierSurface() after changing it.
+    void setTessellationEnabled(bool enabled) { mTessellationEnabled = enabled; }
+
+    //! If true the surface is evaluated by the tessellation shaders, see createTessellationProgram(). Call updateBezierSurface() after changing it.
+    bool tessellationEnabled() const { return mTessellationEnabled; }
+
+    //! The target length in pixels of the segments generated by the GPU tessellation (default is 8).
+    void setTessellationPixelsPerEdge(float pixels) { mTessellationPixelsPerEdge = pixels; }
+
+    //! The target length in pixels of the segments generated by the GPU tessellation (default is 8).
+    float tessellationPixelsPerEdge() const { return mTessellationPixelsPerEdge; }
+
+    //! The maximum tessellation level of a patch edge, clamped by the implementation to \p GL_MAX_TESS_GEN_LEVEL (default is 64).
+    void setMaxTessellationLevel(float level) { mMaxTessellationLevel = level; }
+
+    //! The maximum tessellation level of a patch edge, clamped by the implementation to \p GL_MAX_TESS_GEN_LEVEL (default is 64).
+    float maxTessellationLevel() const { return mMaxTessellationLevel; }
+
+    /** Returns a new GLSLProgram evaluating the Bézier patches when tessellationEnabled() is true, made of the \p "/glsl/bezier_surface.*" shaders.
+      * The fragment shader applies a simple headlight shading to the \p "surface_color" uniform and can be replaced by any fragment shader
+      * using the \p tesPosition (eye space), \p tesNormal (eye space) and \p tesTexCoord inputs. */
+    static ref<GLSLProgram> createTessellationProgram();
+
+  protected:
+    virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+
+    void updateControlPoints();
+
   protected:
     std::vector< ref<BezierPatch> > mPatches;
     unsigned mDetail;
+    float mTessellationPixelsPerEdge;
+    float mMaxTessellationLevel;
+    bool mTessellationEnabled;
   };
 }
 
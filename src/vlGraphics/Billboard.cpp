@@ -45,7 +45,7 @@ Billboard::Billboard()
 //-----------------------------------------------------------------------------
 vec3 Billboard::position()
 {
-  return localMatrix().getT();
+  return mLocalMatrix.getT();
 }
 //-----------------------------------------------------------------------------
 void Billboard::setPosition(const vec3& pos)
@@ -98,6 +98,8 @@ void Billboard::computeWorldMatrix(Camera* camera)
     }
 
     setWorldMatrix( world_mat );
+    // the orientation depends on the camera: keep being updated by computeDirtyWorldMatrices()
+    setWorldMatrixDirty();
   }
 }
 //-----------------------------------------------------------------------------
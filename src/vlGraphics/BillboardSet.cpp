@@ -0,0 +1,135 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/BillboardSet.hpp>
+#include <vlGraphics/DrawElements.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+BillboardSet::BillboardSet()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mAxis = fvec3(0,1,0);
+  mType = BT_SphericalBillboard;
+}
+//-----------------------------------------------------------------------------
+int BillboardSet::addBillboard(const fvec3& pos, float size)
+{
+  mBillboards.push_back( fvec4(pos, size) );
+  return (int)mBillboards.size() - 1;
+}
+//-----------------------------------------------------------------------------
+void BillboardSet::updateBillboardSet()
+{
+  const size_t count = mBillboards.size();
+
+  ref<ArrayFloat3> vert_array = cast<ArrayFloat3>(vertexArray());
+  if (!vert_array)
+  {
+    vert_array = new ArrayFloat3;
+    setVertexArray(vert_array.get());
+  }
+  vert_array->resize(count*4);
+  vert_array->setBufferObjectDirty();
+
+  ref<ArrayFloat3> texc_array = cast<ArrayFloat3>(texCoordArray(0));
+  if (!texc_array)
+  {
+    texc_array = new ArrayFloat3;
+    setTexCoordArray(0, texc_array.get());
+  }
+  texc_array->resize(count*4);
+  texc_array->setBufferObjectDirty();
+
+  ref<ArrayFloat3> norm_array = cast<ArrayFloat3>(normalArray());
+  if (!norm_array)
+  {
+    norm_array = new ArrayFloat3;
+    setNormalArray(norm_array.get());
+  }
+  norm_array->resize(count*4);
+  norm_array->setBufferObjectDirty();
+
+  ref<DrawElementsUInt> de = drawCalls().size() == 1 ? cast<DrawElementsUInt>(drawCalls().at(0)) : NULL;
+  if (!de)
+  {
+    drawCalls().clear();
+    de = new DrawElementsUInt(PT_TRIANGLES);
+    drawCalls().push_back(de.get());
+  }
+  de->indexBuffer()->resize(count*6);
+  de->indexBuffer()->setBufferObjectDirty();
+
+  // a zero axis selects the spherical orientation in the vertex shader
+  const fvec3 axis = type() == BT_AxisAlignedBillboard ? mAxis : fvec3(0,0,0);
+  const float corner[] = { 0,0, 1,0, 1,1, 0,1 };
+
+  fvec3* verts = vert_array->begin();
+  fvec3* texcs = texc_array->begin();
+  fvec3* norms = norm_array->begin();
+  DrawElementsUInt::index_type* idx = de->indexBuffer()->begin();
+  for(size_t i=0; i<count; ++i)
+  {
+    const fvec3 pos  = mBillboards[i].xyz();
+    const float size = mBillboards[i].w();
+    const DrawElementsUInt::index_type base = (DrawElementsUInt::index_type)(i*4);
+    for(int j=0; j<4; ++j)
+    {
+      *verts++ = pos;
+      *texcs++ = fvec3(corner[j*2], corner[j*2+1], size);
+      *norms++ = axis;
+    }
+    *idx++ = base+0; *idx++ = base+1; *idx++ = base+2;
+    *idx++ = base+2; *idx++ = base+3; *idx++ = base+0;
+  }
+
+  setBufferObjectDirty(true);
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+void BillboardSet::computeBounds_Implementation()
+{
+  AABB aabb;
+  for(size_t i=0; i<mBillboards.size(); ++i)
+  {
+    // the half diagonal of the quad bounds every possible orientation
+    const real r = mBillboards[i].w() * (real)0.70710678118654752440;
+    const vec3 pos = (vec3)mBillboards[i].xyz();
+    aabb += pos - vec3(r,r,r);
+    aabb += pos + vec3(r,r,r);
+  }
+
+  setBoundingBox( aabb );
+  setBoundingSphere( aabb.isNull() ? Sphere() : Sphere(aabb) );
+}
+//-----------------------------------------------------------------------------
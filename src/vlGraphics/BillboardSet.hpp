@@ -0,0 +1,119 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef BillboardSet_INCLUDE_ONCE
+#define BillboardSet_INCLUDE_ONCE
+
+#include <vlGraphics/Geometry.hpp>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // BillboardSet
+  //-----------------------------------------------------------------------------
+  /**
+   * A Geometry rendering any number of camera aligned quads with a single draw call.
+   *
+   * Unlike Billboard, which is a Transform recomputed on the CPU every frame and requires one Actor per billboard,
+   * a BillboardSet stores the position and size of all its billboards in a single set of vertex arrays and the
+   * orientation is computed by the vertex shader \p /glsl/billboard.vs. The arrays are generated once by
+   * updateBillboardSet() and need to be updated only when the billboards change.
+   *
+   * The layout of the generated arrays is the following, every billboard is made of 4 vertices and 2 triangles:
+   * - vertex array: the billboard center, the same for the 4 vertices.
+   * - texture coordinate array 0: <tt>(u, v, size)</tt>, \p u and \p v are the normalized corner coordinates.
+   * - normal array: the rotation axis for BT_AxisAlignedBillboard, zero for BT_SphericalBillboard.
+   *
+   * Both types behave as their Billboard counterpart: spherical billboards face the eye keeping the camera up vector,
+   * axis aligned billboards rotate around axis() only. Example:
+   * \code
+   * ref<BillboardSet> trees = new BillboardSet;
+   * trees->setType(BT_AxisAlignedBillboard);
+   * for(int i=0; i<100000; ++i)
+   *   trees->addBillboard( fvec3(x, y, z), size );
+   * trees->updateBillboardSet();
+   * effect->shader()->gocGLSLProgram()->attachShader( new GLSLVertexShader("/glsl/billboard.vs") );
+   * \endcode
+   * \note Since the 4 vertices of a billboard share the same position CPU side ray picking sees degenerate triangles.
+   * \sa Billboard
+   */
+  class VLGRAPHICS_EXPORT BillboardSet: public Geometry
+  {
+    VL_INSTRUMENT_CLASS(vl::BillboardSet, Geometry)
+
+  public:
+    //! Constructor
+    BillboardSet();
+
+    //! Adds a billboard and returns its index. Call updateBillboardSet() to update the geometry.
+    int addBillboard(const fvec3& pos, float size);
+    //! Changes the position and size of the given billboard. Call updateBillboardSet() to update the geometry.
+    void setBillboard(int i, const fvec3& pos, float size) { mBillboards[i] = fvec4(pos, size); }
+    //! The position of the given billboard.
+    fvec3 billboardPosition(int i) const { return mBillboards[i].xyz(); }
+    //! The size of the given billboard.
+    float billboardSize(int i) const { return mBillboards[i].w(); }
+    //! The number of billboards.
+    int billboardCount() const { return (int)mBillboards.size(); }
+    //! Removes all the billboards. Call updateBillboardSet() to update the geometry.
+    void clearBillboards() { mBillboards.clear(); }
+
+    //! The position (xyz) and size (w) of all the billboards. Call updateBillboardSet() after modifying it.
+    std::vector<fvec4>& billboards() { return mBillboards; }
+    //! The position (xyz) and size (w) of all the billboards.
+    const std::vector<fvec4>& billboards() const { return mBillboards; }
+
+    //! The rotation axis in object space. Used only for axis aligned billboards.
+    void setAxis(const fvec3& axis) { mAxis = axis; mAxis.normalize(); }
+    //! The rotation axis in object space. Used only for axis aligned billboards.
+    const fvec3& axis() const { return mAxis; }
+    //! The type of the billboards.
+    void setType(EBillboardType type) { mType = type; }
+    //! The type of the billboards.
+    EBillboardType type() const { return mType; }
+
+    //! Generates the vertex arrays and the draw call based on the current billboards, type and axis.
+    void updateBillboardSet();
+
+  protected:
+    //! Computes the bounds taking into account the size of the billboards.
+    virtual void computeBounds_Implementation();
+
+  protected:
+    std::vector<fvec4> mBillboards;
+    fvec3 mAxis;
+    EBillboardType mType;
+  };
+  //-----------------------------------------------------------------------------
+}
+
+#endif
@@ -41,6 +41,7 @@
 #include <vlCore/Vector4.hpp>
 #include <vlCore/Sphere.hpp>
 #include <vlCore/AABB.hpp>
+#include <vlGraphics/BufferObjectPool.hpp>
 
 namespace vl
 {
@@ -51,6 +52,9 @@ namespace vl
    * The BufferObject class is a Buffer that can upload its data on the GPU memory.
    * \remarks
    * BufferObject is the storage used by ArrayAbstract and subclasses like ArrayFloat3, ArrayUByte4 etc.
+   *
+   * A BufferObject bound to a BufferObjectPool with setPool() stores its data in a range of one of the large OpenGL buffers
+   * of the pool: in this case byteOffsetBufferObject() returns the offset of the data within handle().
   */
   class BufferObject: public Buffer
   {
@@ -63,6 +67,10 @@ namespace vl
       mHandle = 0;
       mUsage = BU_STATIC_DRAW;
       mByteCountBufferObject = 0;
+      mByteOffsetBufferObject = 0;
+      mPooled = false;
+      mRingSize = 1;
+      mRingIndex = 0;
     }
 
     BufferObject(const BufferObject& other): Buffer(other)
@@ -71,6 +79,10 @@ namespace vl
       mHandle = 0;
       mUsage = BU_STATIC_DRAW;
       mByteCountBufferObject = 0;
+      mByteOffsetBufferObject = 0;
+      mPooled = false;
+      mRingSize = 1;
+      mRingIndex = 0;
       // copy local data
       *this = other;
     }
@@ -100,6 +112,22 @@ namespace vl
       other.mHandle = tmp_handle;
       other.mUsage = tmp_usage;
       other.mByteCountBufferObject = tmp_bytes;
+      // swap the streaming ring
+      std::swap(mRingSize, other.mRingSize);
+      // swap the pool ranges
+      std::swap(mByteOffsetBufferObject, other.mByteOffsetBufferObject);
+      std::swap(mPooled, other.mPooled);
+      mPool.swap(other.mPool);
+      if (mPooled)
+        mPool->setOwner(this);
+      if (other.mPooled)
+        other.mPool->setOwner(&other);
+      std::swap(mRingIndex, other.mRingIndex);
+      mRingHandles.swap(other.mRingHandles);
+      mRingBytes.swap(other.mRingBytes);
+#if defined(VL_OPENGL)
+      mRingFences.swap(other.mRingFences);
+#endif
     }
 
     ~BufferObject()
@@ -113,6 +141,24 @@ namespace vl
 
     GLsizeiptr byteCountBufferObject() const { return mByteCountBufferObject; }
 
+    //! The offset in bytes of the data within handle(), always 0 unless the buffer is sub-allocated from a BufferObjectPool.
+    GLintptr byteOffsetBufferObject() const { return mByteOffsetBufferObject; }
+
+    //! Binds the BufferObject to a BufferObjectPool (NULL by default), the current OpenGL buffer is deleted.
+    //! The following setBufferData() calls sub-allocate the buffer from the pool whenever possible, see BufferObjectPool.
+    void setPool(BufferObjectPool* pool)
+    {
+      deleteBufferObject();
+      mPool = pool;
+    }
+
+    //! The BufferObjectPool the buffer is bound to, see setPool().
+    BufferObjectPool* pool() { return mPool.get(); }
+    const BufferObjectPool* pool() const { return mPool.get(); }
+
+    //! Returns true if the storage of the buffer is currently a range of a BufferObjectPool page.
+    bool isPooled() const { return mPooled; }
+
     void createBufferObject()
     {
       VL_CHECK_OGL();
@@ -121,6 +167,7 @@ namespace vl
       {
         VL_CHECK(mByteCountBufferObject == 0)
         VL_glGenBuffers( 1, &mHandle ); VL_CHECK_OGL();
+        MemoryTracker::track( MC_BufferObject, 0, 1 );
         mByteCountBufferObject = 0;
         VL_CHECK(handle())
       }
@@ -131,9 +178,41 @@ namespace vl
       // mic fixme: it would be nice to re-enable these
       // VL_CHECK_OGL();
       VL_CHECK(Has_BufferObject || handle() == 0)
+      if (mPooled)
+      {
+        // the current handle is a page of the pool
+        mPool->release(this);
+      }
+      else
+      if (Has_BufferObject && !mRingHandles.empty())
+      {
+        // the current handle is one of the ring buffers
+        for(size_t i=0; i<mRingHandles.size(); ++i)
+        {
+          if (mRingHandles[i])
+          {
+            VL_glDeleteBuffers( 1, &mRingHandles[i] );
+            MemoryTracker::track( MC_BufferObject, -(long long)mRingBytes[i], -1 );
+          }
+#if defined(VL_OPENGL)
+          if (mRingFences[i])
+            glDeleteSync( mRingFences[i] );
+#endif
+        }
+        mRingHandles.clear();
+        mRingBytes.clear();
+#if defined(VL_OPENGL)
+        mRingFences.clear();
+#endif
+        mRingIndex = 0;
+        mHandle = 0;
+        mByteCountBufferObject = 0;
+      }
+      else
       if (Has_BufferObject && handle() != 0)
       {
         VL_glDeleteBuffers( 1, &mHandle ); // VL_CHECK_OGL();
+        MemoryTracker::track( MC_BufferObject, -(long long)mByteCountBufferObject, -1 );
         mHandle = 0;
         mByteCountBufferObject = 0;
       }
@@ -155,7 +234,10 @@ namespace vl
     // @note Discarding the local storage might delete data used by other Arrays.
     void setBufferData( EBufferObjectUsage usage, bool discard_local_storage=false )
     {
-      setBufferData( (int)bytesUsed(), ptr(), usage );
+      if ( isStreaming() )
+        setStreamingBufferData( (int)bytesUsed(), ptr() );
+      else
+        setBufferData( (int)bytesUsed(), ptr(), usage );
       mUsage = usage;
       if (discard_local_storage)
         clear();
@@ -171,11 +253,22 @@ namespace vl
       VL_CHECK(Has_BufferObject)
       if ( Has_BufferObject )
       {
+        if ( mPool && !isStreaming() )
+        {
+          if ( mPool->allocate( this, byte_count, usage ) )
+          {
+            if ( data )
+              setBufferSubData( 0, byte_count, data );
+            mUsage = usage;
+            return;
+          }
+        }
         createBufferObject();
         // we use the GL_ARRAY_BUFFER slot to send the data for no special reason
         VL_glBindBuffer( GL_ARRAY_BUFFER, handle() ); VL_CHECK_OGL();
         VL_glBufferData( GL_ARRAY_BUFFER, byte_count, data, usage ); VL_CHECK_OGL();
         VL_glBindBuffer( GL_ARRAY_BUFFER, 0 ); VL_CHECK_OGL();
+        MemoryTracker::track( MC_BufferObject, (long long)byte_count - (long long)mByteCountBufferObject );
         mByteCountBufferObject = byte_count;
         mUsage = usage;
       }
@@ -205,13 +298,14 @@ namespace vl
       {
         // we use the GL_ARRAY_BUFFER slot to send the data for no special reason
         VL_glBindBuffer( GL_ARRAY_BUFFER, handle() ); VL_CHECK_OGL();
-        VL_glBufferSubData( GL_ARRAY_BUFFER, offset, byte_count, data ); VL_CHECK_OGL();
+        VL_glBufferSubData( GL_ARRAY_BUFFER, byteOffsetBufferObject() + offset, byte_count, data ); VL_CHECK_OGL();
         VL_glBindBuffer( GL_ARRAY_BUFFER, 0 ); VL_CHECK_OGL();
       }
     }
 
     // Maps a BufferObject so that it can be read or written by the CPU.
     // @note You can map only one BufferObject at a time and you must unmap it before using the BufferObject again or mapping another one.
+    // @note A pooled BufferObject maps the whole page, the returned pointer points to the start of its own range.
     void* mapBufferObject(EBufferObjectAccess access)
     {
       VL_CHECK_OGL();
@@ -222,6 +316,8 @@ namespace vl
         VL_glBindBuffer( GL_ARRAY_BUFFER, handle() ); VL_CHECK_OGL();
         void* ptr = VL_glMapBuffer( GL_ARRAY_BUFFER, access ); VL_CHECK_OGL();
         VL_glBindBuffer( GL_ARRAY_BUFFER, 0 ); VL_CHECK_OGL();
+        if ( ptr )
+          ptr = (char*)ptr + byteOffsetBufferObject();
         return ptr;
       }
       else
@@ -255,6 +351,101 @@ namespace vl
         return false;
     }
 
+    //! Enables the streaming mode if \p ring_size > 1 (default = 1, streaming disabled).
+    //! In streaming mode the BufferObject cycles through \p ring_size GPU buffers: each update writes into the next buffer
+    //! of the ring with an unsynchronized glMapBufferRange() while the GPU may still be reading the previous ones. A fence is
+    //! inserted every time a buffer is retired and waited upon only when the ring wraps around to it, which with the default
+    //! triple buffering normally never blocks. handle() always returns the buffer written last.
+    //! Changing the ring size deletes the current GPU buffers.
+    //! @note Requires OpenGL 3.2 or GL_ARB_sync and GL_ARB_map_buffer_range, otherwise the regular setBufferData() path is used.
+    //! @note Streaming buffers are never sub-allocated from a BufferObjectPool.
+    void setStreamingRingSize(int ring_size)
+    {
+      deleteBufferObject();
+      mRingSize = ring_size < 1 ? 1 : ring_size;
+    }
+
+    //! The number of GPU buffers the streaming mode cycles through, see setStreamingRingSize().
+    int streamingRingSize() const { return mRingSize; }
+
+    //! Returns true if setStreamingRingSize() was called with a value greater than 1.
+    bool isStreaming() const { return mRingSize > 1; }
+
+    // Advances the streaming ring to the next buffer, makes sure the GPU finished using it, and maps it for writing.
+    // The buffer is resized to \p byte_count if necessary. Call unmapBufferObject() when done writing.
+    // @note Only valid if isStreaming() is true, returns NULL if the streaming path is not supported.
+    void* mapStreamingBufferObject( GLsizeiptr byte_count )
+    {
+      VL_CHECK_OGL();
+      VL_CHECK(isStreaming())
+#if defined(VL_OPENGL)
+      if ( Has_BufferObject && byte_count > 0 && glMapBufferRange && glFenceSync && glClientWaitSync && glDeleteSync )
+      {
+        if ( mRingHandles.empty() )
+        {
+          mRingHandles.resize(mRingSize, 0);
+          mRingBytes.resize(mRingSize, 0);
+          mRingFences.resize(mRingSize, NULL);
+          mRingIndex = mRingSize - 1;
+        }
+        else
+        {
+          // retire the current buffer: the commands issued so far are the only ones that can read it
+          VL_CHECK(mRingFences[mRingIndex] == NULL)
+          mRingFences[mRingIndex] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ); VL_CHECK_OGL();
+        }
+
+        mRingIndex = (mRingIndex + 1) % mRingSize;
+
+        if ( ! mRingHandles[mRingIndex] ) {
+          VL_glGenBuffers( 1, &mRingHandles[mRingIndex] ); VL_CHECK_OGL();
+          MemoryTracker::track( MC_BufferObject, 0, 1 );
+        }
+
+        // wait for the GPU to finish using the buffer we are about to overwrite
+        if ( mRingFences[mRingIndex] )
+        {
+          GLenum wait = GL_TIMEOUT_EXPIRED;
+          while( wait == GL_TIMEOUT_EXPIRED )
+            wait = glClientWaitSync( mRingFences[mRingIndex], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 /*1 second*/ );
+          VL_CHECK(wait != GL_WAIT_FAILED)
+          glDeleteSync( mRingFences[mRingIndex] ); VL_CHECK_OGL();
+          mRingFences[mRingIndex] = NULL;
+        }
+
+        mHandle = mRingHandles[mRingIndex];
+        VL_glBindBuffer( GL_ARRAY_BUFFER, handle() ); VL_CHECK_OGL();
+        if ( mRingBytes[mRingIndex] != byte_count )
+        {
+          VL_glBufferData( GL_ARRAY_BUFFER, byte_count, NULL, BU_STREAM_DRAW ); VL_CHECK_OGL();
+          MemoryTracker::track( MC_BufferObject, (long long)byte_count - (long long)mRingBytes[mRingIndex] );
+          mRingBytes[mRingIndex] = byte_count;
+        }
+        void* ptr = glMapBufferRange( GL_ARRAY_BUFFER, 0, byte_count, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT ); VL_CHECK_OGL();
+        VL_glBindBuffer( GL_ARRAY_BUFFER, 0 ); VL_CHECK_OGL();
+        mByteCountBufferObject = byte_count;
+        return ptr;
+      }
+#endif
+      return NULL;
+    }
+
+    // Writes \p byte_count bytes into the next buffer of the streaming ring, see setStreamingRingSize().
+    // Falls back to setBufferData() if the streaming path is not supported.
+    void setStreamingBufferData( GLsizeiptr byte_count, const GLvoid* data )
+    {
+      if ( byte_count > 0 && data )
+      {
+        if ( void* ptr = mapStreamingBufferObject( byte_count ) )
+        {
+          memcpy( ptr, data, byte_count );
+          unmapBufferObject();
+          return;
+        }
+      }
+      setBufferData( byte_count, data, BU_STREAM_DRAW );
+    }
+
     //! BufferObject usage flag as specified by setBufferData().
     EBufferObjectUsage usage() const { return mUsage; }
 
@@ -262,6 +453,21 @@ namespace vl
     unsigned int mHandle;
     GLsizeiptr mByteCountBufferObject;
     EBufferObjectUsage mUsage;
+
+    // pool range
+    friend class BufferObjectPool;
+    ref<BufferObjectPool> mPool;
+    GLintptr mByteOffsetBufferObject;
+    bool mPooled;
+
+    // streaming ring
+    int mRingSize;
+    int mRingIndex;
+    std::vector<unsigned int> mRingHandles;
+    std::vector<GLsizeiptr> mRingBytes;
+#if defined(VL_OPENGL)
+    std::vector<GLsync> mRingFences;
+#endif
   };
 }
 
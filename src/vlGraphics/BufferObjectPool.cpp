@@ -0,0 +1,309 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/BufferObjectPool.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <algorithm>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// BufferObjectPool
+//-----------------------------------------------------------------------------
+BufferObjectPool::BufferObjectPool()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mPageSize = 4*1024*1024;
+  mMaxAllocationSize = 1024*1024;
+  mAlignment = 16;
+  mUsage = BU_STATIC_DRAW;
+}
+//-----------------------------------------------------------------------------
+BufferObjectPool::~BufferObjectPool()
+{
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+BufferObjectPool::Page* BufferObjectPool::findPage(unsigned int handle)
+{
+  for(size_t i=0; i<mPages.size(); ++i)
+    if ( mPages[i].mHandle == handle )
+      return &mPages[i];
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+bool BufferObjectPool::allocate(BufferObject* bo, GLsizeiptr byte_count, EBufferObjectUsage usage)
+{
+  VL_CHECK_OGL();
+  VL_CHECK( bo && bo->pool() == this )
+  VL_CHECK( mAlignment > 0 && (mAlignment & (mAlignment-1)) == 0 )
+
+  const GLsizeiptr size = (byte_count + mAlignment - 1) & ~(GLsizeiptr)(mAlignment - 1);
+
+  // keep the current range if it has the right size
+  if ( bo->mPooled )
+  {
+    Page* page = findPage( bo->mHandle );
+    VL_CHECK( page )
+    std::map<GLintptr, Block>::const_iterator it = page->mBlocks.find( bo->mByteOffsetBufferObject );
+    VL_CHECK( it != page->mBlocks.end() && it->second.mOwner == bo )
+    if ( it->second.mSize == size && usage == mUsage )
+    {
+      bo->mByteCountBufferObject = byte_count;
+      return true;
+    }
+  }
+
+  // drop the current storage, pooled or not
+  bo->deleteBufferObject();
+
+  if ( ! Has_BufferObject || usage != mUsage || byte_count <= 0 || byte_count > mMaxAllocationSize )
+    return false;
+
+  // first fit
+  Page* page = NULL;
+  GLintptr offset = 0;
+  for(size_t i=0; i<mPages.size() && !page; ++i)
+  {
+    for(std::map<GLintptr, GLsizeiptr>::iterator it = mPages[i].mFree.begin(); it != mPages[i].mFree.end(); ++it)
+    {
+      if ( it->second >= size )
+      {
+        page = &mPages[i];
+        offset = it->first;
+        GLsizeiptr left = it->second - size;
+        page->mFree.erase(it);
+        if ( left )
+          page->mFree[offset + size] = left;
+        break;
+      }
+    }
+  }
+
+  // no room left: allocate a new page
+  if ( ! page )
+  {
+    mPages.push_back( Page() );
+    page = &mPages.back();
+    page->mSize = std::max( mPageSize, size );
+    VL_glGenBuffers( 1, &page->mHandle ); VL_CHECK_OGL();
+    VL_glBindBuffer( GL_ARRAY_BUFFER, page->mHandle ); VL_CHECK_OGL();
+    VL_glBufferData( GL_ARRAY_BUFFER, page->mSize, NULL, mUsage ); VL_CHECK_OGL();
+    VL_glBindBuffer( GL_ARRAY_BUFFER, 0 ); VL_CHECK_OGL();
+    MemoryTracker::track( MC_BufferObject, page->mSize, 1 );
+    if ( page->mSize > size )
+      page->mFree[size] = page->mSize - size;
+    offset = 0;
+  }
+
+  page->mBlocks[offset] = Block( size, bo );
+  bo->mHandle = page->mHandle;
+  bo->mByteOffsetBufferObject = offset;
+  bo->mByteCountBufferObject = byte_count;
+  bo->mPooled = true;
+  return true;
+}
+//-----------------------------------------------------------------------------
+void BufferObjectPool::release(BufferObject* bo)
+{
+  VL_CHECK( bo && bo->mPooled )
+  Page* page = findPage( bo->mHandle );
+  VL_CHECK( page )
+  if ( page )
+  {
+    std::map<GLintptr, Block>::iterator it = page->mBlocks.find( bo->mByteOffsetBufferObject );
+    VL_CHECK( it != page->mBlocks.end() && it->second.mOwner == bo )
+    if ( it != page->mBlocks.end() )
+    {
+      GLintptr offset = it->first;
+      GLsizeiptr size = it->second.mSize;
+      page->mBlocks.erase(it);
+
+      // merge with the following free range
+      std::map<GLintptr, GLsizeiptr>::iterator next = page->mFree.find( offset + size );
+      if ( next != page->mFree.end() )
+      {
+        size += next->second;
+        page->mFree.erase(next);
+      }
+
+      // merge with the preceding free range
+      std::map<GLintptr, GLsizeiptr>::iterator prev = page->mFree.lower_bound( offset );
+      if ( prev != page->mFree.begin() && (--prev)->first + prev->second == offset )
+        prev->second += size;
+      else
+        page->mFree[offset] = size;
+    }
+  }
+
+  bo->mHandle = 0;
+  bo->mByteOffsetBufferObject = 0;
+  bo->mByteCountBufferObject = 0;
+  bo->mPooled = false;
+}
+//-----------------------------------------------------------------------------
+void BufferObjectPool::setOwner(BufferObject* bo)
+{
+  VL_CHECK( bo && bo->mPooled )
+  Page* page = findPage( bo->mHandle );
+  VL_CHECK( page )
+  if ( page )
+  {
+    std::map<GLintptr, Block>::iterator it = page->mBlocks.find( bo->mByteOffsetBufferObject );
+    VL_CHECK( it != page->mBlocks.end() )
+    if ( it != page->mBlocks.end() )
+      it->second.mOwner = bo;
+  }
+}
+//-----------------------------------------------------------------------------
+bool BufferObjectPool::compactPage(Page& page)
+{
+  // nothing to do if the only free range is at the end of the page
+  if ( page.mFree.empty() || ( page.mFree.size() == 1 && page.mFree.begin()->first + page.mFree.begin()->second == page.mSize ) )
+    return false;
+
+#if defined(VL_OPENGL)
+  if ( ! glCopyBufferSubData )
+    return false;
+
+  // copy the ranges one after the other into a new buffer, created before deleting the old one so that the handles differ
+  unsigned int handle = 0;
+  VL_glGenBuffers( 1, &handle ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_COPY_WRITE_BUFFER, handle ); VL_CHECK_OGL();
+  VL_glBufferData( GL_COPY_WRITE_BUFFER, page.mSize, NULL, mUsage ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_COPY_READ_BUFFER, page.mHandle ); VL_CHECK_OGL();
+
+  std::map<GLintptr, Block> blocks;
+  GLintptr cursor = 0;
+  for(std::map<GLintptr, Block>::const_iterator it = page.mBlocks.begin(); it != page.mBlocks.end(); ++it)
+  {
+    glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, it->first, cursor, it->second.mSize ); VL_CHECK_OGL();
+    blocks[cursor] = it->second;
+    it->second.mOwner->mHandle = handle;
+    it->second.mOwner->mByteOffsetBufferObject = cursor;
+    cursor += it->second.mSize;
+  }
+
+  VL_glBindBuffer( GL_COPY_READ_BUFFER, 0 ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_COPY_WRITE_BUFFER, 0 ); VL_CHECK_OGL();
+  VL_glDeleteBuffers( 1, &page.mHandle ); VL_CHECK_OGL();
+
+  page.mHandle = handle;
+  page.mBlocks.swap( blocks );
+  page.mFree.clear();
+  if ( cursor < page.mSize )
+    page.mFree[cursor] = page.mSize - cursor;
+  return true;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+int BufferObjectPool::defragment(int max_pages)
+{
+  VL_CHECK_OGL();
+  int compacted = 0;
+  for(size_t i=0; i<mPages.size(); )
+  {
+    if ( mPages[i].mBlocks.empty() )
+    {
+      VL_glDeleteBuffers( 1, &mPages[i].mHandle ); VL_CHECK_OGL();
+      MemoryTracker::track( MC_BufferObject, -mPages[i].mSize, -1 );
+      mPages.erase( mPages.begin() + i );
+      continue;
+    }
+    if ( ( max_pages < 0 || compacted < max_pages ) && compactPage( mPages[i] ) )
+      ++compacted;
+    ++i;
+  }
+  return compacted;
+}
+//-----------------------------------------------------------------------------
+void BufferObjectPool::releaseOpenGLResources()
+{
+  for(size_t i=0; i<mPages.size(); ++i)
+  {
+    for(std::map<GLintptr, Block>::const_iterator it = mPages[i].mBlocks.begin(); it != mPages[i].mBlocks.end(); ++it)
+    {
+      BufferObject* bo = it->second.mOwner;
+      bo->mHandle = 0;
+      bo->mByteOffsetBufferObject = 0;
+      bo->mByteCountBufferObject = 0;
+      bo->mPooled = false;
+    }
+    if ( Has_BufferObject && mPages[i].mHandle )
+    {
+      VL_glDeleteBuffers( 1, &mPages[i].mHandle );
+      MemoryTracker::track( MC_BufferObject, -mPages[i].mSize, -1 );
+    }
+  }
+  mPages.clear();
+}
+//-----------------------------------------------------------------------------
+int BufferObjectPool::allocationCount() const
+{
+  size_t count = 0;
+  for(size_t i=0; i<mPages.size(); ++i)
+    count += mPages[i].mBlocks.size();
+  return (int)count;
+}
+//-----------------------------------------------------------------------------
+GLsizeiptr BufferObjectPool::allocatedBytes() const
+{
+  GLsizeiptr bytes = 0;
+  for(size_t i=0; i<mPages.size(); ++i)
+    for(std::map<GLintptr, Block>::const_iterator it = mPages[i].mBlocks.begin(); it != mPages[i].mBlocks.end(); ++it)
+      bytes += it->second.mSize;
+  return bytes;
+}
+//-----------------------------------------------------------------------------
+GLsizeiptr BufferObjectPool::reservedBytes() const
+{
+  GLsizeiptr bytes = 0;
+  for(size_t i=0; i<mPages.size(); ++i)
+    bytes += mPages[i].mSize;
+  return bytes;
+}
+//-----------------------------------------------------------------------------
+int BufferObjectPool::holeCount() const
+{
+  int holes = 0;
+  for(size_t i=0; i<mPages.size(); ++i)
+  {
+    const Page& page = mPages[i];
+    for(std::map<GLintptr, GLsizeiptr>::const_iterator it = page.mFree.begin(); it != page.mFree.end(); ++it)
+      if ( it->first + it->second != page.mSize )
+        ++holes;
+  }
+  return holes;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,174 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef BufferObjectPool_INCLUDE_ONCE
+#define BufferObjectPool_INCLUDE_ONCE
+
+#include <vlCore/Object.hpp>
+#include <vlCore/vlnamespace.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  class BufferObject;
+//-----------------------------------------------------------------------------
+// BufferObjectPool
+//-----------------------------------------------------------------------------
+  /**
+   * Sub-allocates the storage of many small BufferObject[s] out of a few large OpenGL buffers ("pages").
+   *
+   * A BufferObject bound to a pool with BufferObject::setPool() does not create its own OpenGL buffer: BufferObject::setBufferData()
+   * reserves a range of one of the pages and BufferObject::handle() returns the handle of the page, while BufferObject::byteOffsetBufferObject()
+   * returns the offset of the range within it. The offset is taken into account by the vertex array setup of OpenGLContext, by
+   * DrawElements, DrawRangeElements, MultiDrawElements and by ShaderStorageBuffer, so that pooled arrays can be used like any other.
+   * Scenes made of many small geometries this way create a handful of OpenGL buffers instead of one per array.
+   *
+   * Only the buffers whose usage matches usage() and whose size does not exceed maxAllocationSize() are pooled, the others,
+   * for example the dynamic index buffers updated by DepthSortCallback, silently fall back to their own OpenGL buffer.
+   *
+   * Releasing the ranges of deleted or resized buffers fragments the pages over time: call defragment() when the application is
+   * idle to compact them with glCopyBufferSubData() and to destroy the pages left empty.
+   *
+   * Every ArrayAbstract created while a default pool is installed with setDefBufferObjectPool() is bound to it.
+   *
+   * \code
+   * vl::setDefBufferObjectPool( new vl::BufferObjectPool );
+   * // ... create and upload the geometry ...
+   * // when idle:
+   * vl::defBufferObjectPool()->defragment();
+   * \endcode
+   *
+   * \remarks
+   * The OpenGL context must be current when allocating, releasing and defragmenting ranges. Ranges start at multiples of
+   * alignment(): when pooled buffers are bound as shader storage buffers alignment() must be a multiple of
+   * GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+   */
+  class VLGRAPHICS_EXPORT BufferObjectPool: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::BufferObjectPool, Object)
+
+    friend class BufferObject;
+
+  public:
+    BufferObjectPool();
+    ~BufferObjectPool();
+
+    //! The size in bytes of the OpenGL buffers allocated by the pool. Default is 4MB.
+    void setPageSize(GLsizeiptr bytes) { mPageSize = bytes; }
+    GLsizeiptr pageSize() const { return mPageSize; }
+
+    //! Buffers bigger than this are not pooled. Default is 1MB.
+    void setMaxAllocationSize(GLsizeiptr bytes) { mMaxAllocationSize = bytes; }
+    GLsizeiptr maxAllocationSize() const { return mMaxAllocationSize; }
+
+    //! The ranges start at a multiple of this value, which must be a power of 2. Default is 16.
+    void setAlignment(int alignment) { mAlignment = alignment; }
+    int alignment() const { return mAlignment; }
+
+    //! Only the buffers with this usage are pooled. Default is BU_STATIC_DRAW.
+    void setUsage(EBufferObjectUsage usage) { mUsage = usage; }
+    EBufferObjectUsage usage() const { return mUsage; }
+
+    //! Compacts up to \p max_pages fragmented pages (all if -1) and destroys the empty ones. Returns the number of pages compacted.
+    //! Meant to be called when the application is idle, for example once per frame with \p max_pages = 1.
+    //! @note Requires OpenGL 3.1 or GL_ARB_copy_buffer, otherwise only the empty pages are destroyed.
+    int defragment(int max_pages=-1);
+
+    //! Destroys all the pages. The pooled buffers are left without OpenGL storage and must be uploaded again.
+    void releaseOpenGLResources();
+
+    //! Number of OpenGL buffers currently allocated by the pool.
+    int pageCount() const { return (int)mPages.size(); }
+
+    //! Number of BufferObject[s] currently sub-allocated from the pool.
+    int allocationCount() const;
+
+    //! Bytes reserved by the sub-allocated ranges, including the alignment padding.
+    GLsizeiptr allocatedBytes() const;
+
+    //! Bytes of OpenGL memory allocated by the pool.
+    GLsizeiptr reservedBytes() const;
+
+    //! Number of free ranges between the allocated ones, 0 when all the pages are compact.
+    int holeCount() const;
+
+  protected:
+    //! Reserves a range of \p byte_count bytes for \p bo, reusing its current range if it has the same size. Returns false if the
+    //! buffer cannot be pooled, in which case \p bo is left without storage.
+    bool allocate(BufferObject* bo, GLsizeiptr byte_count, EBufferObjectUsage usage);
+
+    //! Gives back the range used by \p bo.
+    void release(BufferObject* bo);
+
+    //! Makes \p bo the owner of the range it references, used by BufferObject::swap().
+    void setOwner(BufferObject* bo);
+
+    struct Block
+    {
+      Block(): mSize(0), mOwner(NULL) {}
+      Block(GLsizeiptr size, BufferObject* owner): mSize(size), mOwner(owner) {}
+      GLsizeiptr mSize;
+      BufferObject* mOwner;
+    };
+
+    struct Page
+    {
+      Page(): mHandle(0), mSize(0) {}
+      unsigned int mHandle;
+      GLsizeiptr mSize;
+      // offset -> allocated range
+      std::map<GLintptr, Block> mBlocks;
+      // offset -> size of the free ranges, adjacent free ranges are always merged
+      std::map<GLintptr, GLsizeiptr> mFree;
+    };
+
+    Page* findPage(unsigned int handle);
+    bool compactPage(Page& page);
+
+  protected:
+    std::vector<Page> mPages;
+    GLsizeiptr mPageSize;
+    GLsizeiptr mMaxAllocationSize;
+    int mAlignment;
+    EBufferObjectUsage mUsage;
+  };
+
+  //! Returns the BufferObjectPool every new ArrayAbstract is bound to, NULL by default.
+  VLGRAPHICS_EXPORT BufferObjectPool* defBufferObjectPool();
+
+  //! Sets the BufferObjectPool every new ArrayAbstract is bound to, NULL disables pooling.
+  VLGRAPHICS_EXPORT void setDefBufferObjectPool(BufferObjectPool*);
+}
+
+#endif
@@ -39,6 +39,7 @@
 #include <vlGraphics/Viewport.hpp>
 #include <vlGraphics/Frustum.hpp>
 #include <vlCore/Ray.hpp>
+#include <vlCore/DirtyTracker.hpp>
 
 namespace vl
 {
@@ -135,7 +136,7 @@ namespace vl
     Frustum& frustum() { return mFrustum; }
 
     /** The viewport bound to a camera. */
-    void setViewport(Viewport* viewport) { mViewport = viewport; }
+    void setViewport(Viewport* viewport) { mViewport = viewport; DirtyTracker::markDirty(); }
 
     /** The viewport bound to a camera. */
     Viewport* viewport() { return mViewport.get(); }
@@ -154,7 +155,7 @@ namespace vl
 
     /** Sets the Camera's view matrix (inverse of the modeling matrix). The modelingMatrix() is also set as the inverse of the viewMatrix().
         @remarks The modelingMatrix() bring points from camera space to world space, where the viewMatrix() brings points from world space to camera space. */
-    void setViewMatrix(const mat4& mat) { mViewMatrix = mat; mViewMatrix.getInverse(mModelingMatrix); }
+    void setViewMatrix(const mat4& mat) { mViewMatrix = mat; mViewMatrix.getInverse(mModelingMatrix); DirtyTracker::markDirty(); }
 
     /** Returns the Camera's view matrix (inverse of the modeling matrix). This is what you would pass to OpenGL with "glMatrixMode(GL_MODELVIEW); glLoadMatrix(camera.viewMatrix().ptr());"
         @remarks The modelingMatrix() bring points from camera space to world space, where the viewMatrix() brings points from world space to camera space. */
@@ -162,14 +163,14 @@ namespace vl
 
     /** Sets the Camera's modelingMatrix() (inverse of the view matrix). The view matrix is also set as the inverse of the modelingMatrix().
         @remarks The modelingMatrix() bring points from camera space to world space, where the viewMatrix() brings points from world space to camera space. */
-    void setModelingMatrix(const mat4& mat) { mModelingMatrix = mat; mModelingMatrix.getInverse(mViewMatrix); }
+    void setModelingMatrix(const mat4& mat) { mModelingMatrix = mat; mModelingMatrix.getInverse(mViewMatrix); DirtyTracker::markDirty(); }
 
     /** Returns the Camera's modelingMatrix() (inverse of the view matrix).
         @remarks The modelingMatrix() bring points from camera space to world space, where the viewMatrix() brings points from world space to camera space. */
     const mat4& modelingMatrix() const { return mModelingMatrix; }
 
     /** The Camera's projection matrix. */
-    void setProjectionMatrix(const mat4& mat, EProjectionMatrixType proj_type) { mProjectionMatrix = mat; mProjectionType = proj_type; }
+    void setProjectionMatrix(const mat4& mat, EProjectionMatrixType proj_type) { mProjectionMatrix = mat; mProjectionType = proj_type; DirtyTracker::markDirty(); }
 
     /** The Camera's projection matrix. */
     const mat4& projectionMatrix() const { return mProjectionMatrix; }
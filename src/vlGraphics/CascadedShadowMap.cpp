@@ -0,0 +1,529 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/CascadedShadowMap.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cmath>
+
+using namespace vl;
+
+namespace
+{
+  const char* CascadeVertexShader =
+    "in vec4 vl_VertexPosition;\n"
+    "uniform mat4 vl_WorldMatrix;\n"
+    "uniform mat4 vl_CascadeViewProjectionMatrix[8];\n"
+    "uniform int vl_CascadeLayers[8];\n"
+    "void main()\n"
+    "{\n"
+    "  int layer = vl_CascadeLayers[gl_InstanceID];\n"
+    "  gl_Position = vl_CascadeViewProjectionMatrix[layer] * (vl_WorldMatrix * vl_VertexPosition);\n"
+    "#ifdef VL_LAYERED\n"
+    "  gl_Layer = layer;\n"
+    "#endif\n"
+    "}\n";
+
+  const char* CascadeFragmentShader =
+    "#version 150\n"
+    "void main() { }\n";
+}
+//-----------------------------------------------------------------------------
+// CascadedShadowMap::CasterRenderable
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::CasterRenderable::set(Renderable* renderable, int location, bool instanced)
+{
+  mRenderable = renderable;
+  mLocation = location;
+  mInstanced = instanced;
+  mLayers.clear();
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::CasterRenderable::computeBounds_Implementation()
+{
+  if (!mRenderable)
+    return;
+  setBoundingBox( mRenderable->boundingBox() );
+  setBoundingSphere( mRenderable->boundingSphere() );
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::CasterRenderable::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
+{
+  if ( mLayers.empty() )
+    return;
+
+  if ( !mInstanced || mLayers.size() == 1 )
+  {
+    // one draw per cascade
+    for(size_t i=0; i<mLayers.size(); ++i)
+    {
+      glUniform1iv( mLocation, 1, &mLayers[i] ); VL_CHECK_OGL();
+      mRenderable->render(actor, shader, camera, gl_context);
+    }
+    return;
+  }
+
+  // one instance per cascade
+  glUniform1iv( mLocation, (GLsizei)mLayers.size(), &mLayers[0] ); VL_CHECK_OGL();
+  const Collection<DrawCall>& dcs = static_cast<Geometry*>(mRenderable)->drawCalls();
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = const_cast<DrawCall*>(dcs.at(i))->as<DrawElementsBase>())
+      de->setInstances( (int)mLayers.size() );
+    else
+    if (DrawArrays* da = const_cast<DrawCall*>(dcs.at(i))->as<DrawArrays>())
+      da->setInstances( (int)mLayers.size() );
+  }
+
+  mRenderable->render(actor, shader, camera, gl_context);
+
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = const_cast<DrawCall*>(dcs.at(i))->as<DrawElementsBase>())
+      de->setInstances(1);
+    else
+    if (DrawArrays* da = const_cast<DrawCall*>(dcs.at(i))->as<DrawArrays>())
+      da->setInstances(1);
+  }
+}
+//-----------------------------------------------------------------------------
+// CascadedShadowMap
+//-----------------------------------------------------------------------------
+CascadedShadowMap::CascadedShadowMap()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mOpenGLContext = NULL;
+  mLightDirection = vec3(0,-1,0);
+  mMaxDistance = 0;
+  mSplitLambda = 0.75f;
+  mCacheMargin = 0.25f;
+  mCascadeCount = 4;
+  mShadowMapSize = 2048;
+  mCachedCascades = 1;
+  mCasterMask = 0xFFFFFFFF;
+  mEnabled = true;
+  mLayeredRenderingEnabled = true;
+  mLayered = false;
+  mStatsRenderedCascades = 0;
+  mStatsShadowCasters = 0;
+  mStatsShadowInstances = 0;
+  for(int i=0; i<=MaxCascades; ++i)
+    mSplits[i] = 0;
+  for(int i=0; i<MaxCascades; ++i)
+    mCascades[i].mCamera = new Camera;
+
+  mRenderQueue = new RenderQueue;
+  mRenderCamera = new Camera;
+  mRenderer = new Renderer;
+  mClearViewport = new Viewport;
+  mClearViewport->setClearFlags(CF_CLEAR_DEPTH);
+
+  // position-only, two-sided, with depth bias
+  mPolygonOffset = new PolygonOffset(2.0f, 4.0f);
+  mShader = new Shader;
+  mShader->enable(EN_DEPTH_TEST);
+  mShader->enable(EN_POLYGON_OFFSET_FILL);
+  mShader->setRenderState( mPolygonOffset.get() );
+
+  mCascadeMatrices    = new Uniform("vl_CascadeViewProjectionMatrix");
+  mShadowMatrices     = new Uniform("vl_ShadowMatrix");
+  mShadowSplits       = new Uniform("vl_ShadowSplits");
+  mShadowCascadeCount = new Uniform("vl_ShadowCascadeCount");
+  fmat4 matrices[MaxCascades];
+  float splits[MaxCascades] = { 0 };
+  mCascadeMatrices->setUniform(MaxCascades, matrices);
+  mShadowMatrices->setUniform(MaxCascades, matrices);
+  mShadowSplits->setUniform(MaxCascades, splits);
+  mShadowCascadeCount->setUniformI(0);
+  mShader->setUniform( mCascadeMatrices.get() );
+
+  mShadowMap = new Texture;
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::setCascadeCount(int count)
+{
+  mCascadeCount = clamp(count, 1, (int)MaxCascades);
+  // the shadow map is reallocated at the next render()
+  if ( mShadowMap->handle() && mShadowMap->depth() != mCascadeCount )
+    releaseOpenGLResources();
+  invalidateCache();
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::setShadowMapSize(int size)
+{
+  mShadowMapSize = size < 1 ? 1 : size;
+  if ( mShadowMap->handle() && mShadowMap->width() != mShadowMapSize )
+    releaseOpenGLResources();
+  invalidateCache();
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::invalidateCache()
+{
+  for(int i=0; i<MaxCascades; ++i)
+    mCascades[i].mValid = false;
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::setupShader(Shader* shader, int unit)
+{
+  VL_CHECK(shader)
+  shader->gocTextureSampler(unit)->setTexture( mShadowMap.get() );
+  shader->gocUniform("vl_ShadowMap")->setUniformI(unit);
+  // shared among all the shaders, updated by render()
+  shader->setUniform( mShadowMatrices.get() );
+  shader->setUniform( mShadowSplits.get() );
+  shader->setUniform( mShadowCascadeCount.get() );
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::releaseOpenGLResources()
+{
+  mShadowMap->destroyTexture();
+  mLayeredFBO = NULL;
+  mLayerFBOs.clear();
+  invalidateCache();
+}
+//-----------------------------------------------------------------------------
+bool CascadedShadowMap::prepareResources(OpenGLContext* gl_context)
+{
+  if ( !Has_GLSL || !Has_FBO || !Has_Texture_Array )
+  {
+    Log::error("CascadedShadowMap::render(): GLSL, framebuffer objects and texture arrays are required!\n");
+    return false;
+  }
+
+  if ( mOpenGLContext != gl_context )
+  {
+    releaseOpenGLResources();
+    mOpenGLContext = gl_context;
+  }
+
+  // shadow pass program, recompiled when the layered rendering support changes
+  bool layered = mLayeredRenderingEnabled && Has_Primitive_Instancing && gl_context->isExtensionSupported("GL_ARB_shader_viewport_layer_array");
+  if ( !mShader->glslProgram() || layered != mLayered )
+  {
+    mLayered = layered;
+    String header = mLayered ? "#version 150\n#extension GL_ARB_shader_viewport_layer_array : require\n#define VL_LAYERED\n" : "#version 150\n";
+    ref<GLSLProgram> glsl = new GLSLProgram;
+    glsl->attachShader( new GLSLVertexShader( header + CascadeVertexShader ) );
+    glsl->attachShader( new GLSLFragmentShader( CascadeFragmentShader ) );
+    mShader->setRenderState( glsl.get() );
+    if ( !glsl->linkProgram() )
+    {
+      Log::error("CascadedShadowMap::render(): could not link the shadow pass GLSL program!\n");
+      return false;
+    }
+  }
+
+  // depth texture array with one layer per cascade
+  if ( !mShadowMap->handle() )
+  {
+    mShadowMap->createTexture2DArray( mShadowMapSize, mShadowMapSize, mCascadeCount, TF_DEPTH_COMPONENT32F );
+    if ( !mShadowMap->handle() )
+      return false;
+    mShadowMap->getTexParameter()->setMinFilter(TPF_LINEAR);
+    mShadowMap->getTexParameter()->setMagFilter(TPF_LINEAR);
+    mShadowMap->getTexParameter()->setWrapS(TPW_CLAMP_TO_EDGE);
+    mShadowMap->getTexParameter()->setWrapT(TPW_CLAMP_TO_EDGE);
+    mShadowMap->getTexParameter()->setCompareMode(TCM_COMPARE_REF_DEPTH_TO_TEXTURE);
+    mShadowMap->getTexParameter()->setCompareFunc(TCF_LEQUAL);
+
+    mLayeredFBO = gl_context->createFramebufferObject( mShadowMapSize, mShadowMapSize );
+    mLayeredFBO->setDrawBuffer(RDB_NONE);
+    mLayeredFBO->setReadBuffer(RDB_NONE);
+    mLayeredFBO->addDepthAttachment( new FBOTextureAttachment( mShadowMap.get(), 0 ) );
+
+    mLayerFBOs.resize(mCascadeCount);
+    for(int i=0; i<mCascadeCount; ++i)
+    {
+      mLayerFBOs[i] = gl_context->createFramebufferObject( mShadowMapSize, mShadowMapSize );
+      mLayerFBOs[i]->setDrawBuffer(RDB_NONE);
+      mLayerFBOs[i]->setReadBuffer(RDB_NONE);
+      mLayerFBOs[i]->addDepthAttachment( new FBOTextureLayerAttachment( mShadowMap.get(), 0, i ) );
+    }
+
+    mRenderCamera->viewport()->set( 0, 0, mShadowMapSize, mShadowMapSize );
+    mClearViewport->set( 0, 0, mShadowMapSize, mShadowMapSize );
+    invalidateCache();
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool CascadedShadowMap::isInstanceable(const Renderable* renderable) const
+{
+  const Geometry* geom = renderable->as<Geometry>();
+  if ( !mLayered || !geom || geom->isDisplayListEnabled() || geom->drawCalls().empty() )
+    return false;
+
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    const DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->instances() != 1 || !( dc->as<DrawElementsBase>() || dc->as<DrawArrays>() ) )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::fitCascade(Cascade& cascade, const vec3& center, real radius, real back_distance)
+{
+  const vec3& dir = mLightDirection;
+  vec3 up = fabs(dir.y()) < 0.99 ? vec3(0,1,0) : vec3(1,0,0);
+  vec3 right = cross(dir, up).normalize();
+  up = cross(right, dir).normalize();
+
+  // snap the box to the shadow map texels along the light-space x and y axes
+  real texel = 2 * radius / mShadowMapSize;
+  real x = floor( dot(center, right) / texel ) * texel;
+  real y = floor( dot(center, up) / texel ) * texel;
+  vec3 snapped = right * x + up * y + dir * dot(center, dir);
+
+  cascade.mCamera->setViewMatrix( mat4::getLookAt( snapped, snapped + dir, up ) );
+  cascade.mCamera->setProjectionMatrix( mat4::getOrtho( -radius, radius, -radius, radius, -back_distance, radius ), PMT_OrthographicProjection );
+  cascade.mCamera->computeFrustumPlanes();
+  cascade.mCenter = center;
+  cascade.mRadius = radius;
+  cascade.mBackDistance = back_distance;
+  cascade.mLightDirection = dir;
+  cascade.mValid = true;
+}
+//-----------------------------------------------------------------------------
+void CascadedShadowMap::render(Collection<SceneManager>* scene_managers, const Camera* camera, OpenGLContext* gl_context, real frame_clock)
+{
+  VL_CHECK(camera)
+  VL_CHECK(gl_context)
+
+  mStatsRenderedCascades = 0;
+  mStatsShadowCasters = 0;
+  mStatsShadowInstances = 0;
+
+  if ( !prepareResources(gl_context) )
+    return;
+
+  // split distances
+
+  real z_far = mMaxDistance > 0 ? min(mMaxDistance, camera->farPlane()) : camera->farPlane();
+  real z_near = max( camera->nearPlane(), z_far * (real)0.0001 );
+  for(int i=0; i<=mCascadeCount; ++i)
+  {
+    real t = (real)i / mCascadeCount;
+    mSplits[i] = mSplitLambda * z_near * pow(z_far / z_near, t) + (1 - mSplitLambda) * ( z_near + (z_far - z_near) * t );
+  }
+
+  // view-space rays through the viewport corners, parametrized by the view-space z
+  mat4 inv_proj = camera->projectionMatrix().getInverse();
+  vec3 ray_orig[4], ray_dir[4];
+  for(int c=0; c<4; ++c)
+  {
+    real ndc_x = c & 1 ? 1 : -1;
+    real ndc_y = c & 2 ? 1 : -1;
+    vec4 n = inv_proj * vec4(ndc_x, ndc_y, -1, 1);
+    vec4 f = inv_proj * vec4(ndc_x, ndc_y, +1, 1);
+    vec3 pn = n.xyz() / n.w();
+    vec3 pf = f.xyz() / f.w();
+    ray_dir[c] = (pf - pn) / (pf.z() - pn.z());
+    ray_orig[c] = pn - ray_dir[c] * pn.z();
+  }
+  const mat4& cam_matrix = camera->modelingMatrix();
+
+  for(int i=0; i<scene_managers->size(); ++i)
+  {
+    if ( scene_managers->at(i)->boundsDirty() )
+      scene_managers->at(i)->computeBounds();
+  }
+
+  for(int ic=0; ic<mCascadeCount; ++ic)
+  {
+    Cascade& cascade = mCascades[ic];
+
+    // bounding sphere of the slice, centered on the view axis
+    real d0 = mSplits[ic];
+    real d1 = mSplits[ic+1];
+    real a2 = 0, b2 = 0;
+    vec3 corners[8];
+    for(int c=0; c<4; ++c)
+    {
+      corners[c+0] = ray_orig[c] - ray_dir[c] * d0;
+      corners[c+4] = ray_orig[c] - ray_dir[c] * d1;
+      a2 = max( a2, corners[c+0].xy().lengthSquared() );
+      b2 = max( b2, corners[c+4].xy().lengthSquared() );
+    }
+    real zc = clamp( (d0 + d1) / 2 + (b2 - a2) / (2 * (d1 - d0)), d0, d1 );
+    vec3 view_center(0, 0, -zc);
+    real radius = 0;
+    for(int c=0; c<8; ++c)
+      radius = max( radius, (corners[c] - view_center).length() );
+    // quantized so that the texel snapping stays stable
+    radius = ceil(radius * 16) / 16;
+    vec3 center = cam_matrix * view_center;
+
+    // distance toward the light covering all the potential casters
+    real back_distance = radius;
+    for(int i=0; i<scene_managers->size(); ++i)
+    {
+      const Sphere& sphere = scene_managers->at(i)->boundingSphere();
+      if ( !sphere.isNull() )
+        back_distance = max( back_distance, dot(center - sphere.center(), mLightDirection) + sphere.radius() );
+    }
+
+    bool cached = ic >= mCascadeCount - mCachedCascades;
+    if ( !cached )
+    {
+      fitCascade(cascade, center, radius, back_distance);
+      cascade.mDirty = true;
+    }
+    else
+    if ( !cascade.mValid || cascade.mLightDirection != mLightDirection || (center - cascade.mCenter).length() + radius > cascade.mRadius || back_distance > cascade.mBackDistance )
+    {
+      fitCascade(cascade, center, radius * (1 + mCacheMargin), back_distance * (1 + mCacheMargin));
+      cascade.mDirty = true;
+    }
+    else
+      cascade.mDirty = false;
+
+    // cull the casters
+
+    cascade.mActors.clear();
+    for(int i=0; i<scene_managers->size(); ++i)
+    {
+      SceneManager* scene_manager = scene_managers->at(i);
+      if ( scene_manager->cullingEnabled() )
+      {
+        if ( !cascade.mCamera->frustum().cull( scene_manager->boundingSphere() ) )
+          scene_manager->extractVisibleActors( cascade.mActors, cascade.mCamera.get() );
+      }
+      else
+        scene_manager->extractVisibleActors( cascade.mActors, NULL );
+    }
+
+    std::vector<CasterRecord> casters;
+    casters.reserve( cascade.mActors.size() );
+    for(int i=0; i<cascade.mActors.size(); ++i)
+    {
+      Actor* actor = cascade.mActors.at(i);
+      if ( !( actor->enableMask() & mCasterMask ) || !actor->lod(0) )
+        continue;
+      CasterRecord rec;
+      rec.mActor = actor;
+      rec.mRenderable = actor->lod(0);
+      rec.mTransformTick = actor->transform() ? actor->transform()->worldMatrixUpdateTick() : -1;
+      rec.mBoundsTick = rec.mRenderable->boundsUpdateTick();
+      casters.push_back(rec);
+    }
+    if ( casters != cascade.mCasters )
+      cascade.mDirty = true;
+    cascade.mCasters.swap(casters);
+  }
+
+  // collect the casters of the cascades to be rendered, each one with the list of its cascades
+
+  int location = mShader->glslProgram()->getUniformLocation("vl_CascadeLayers");
+  fmat4 cascade_matrices[MaxCascades];
+  fmat4 shadow_matrices[MaxCascades];
+  float splits[MaxCascades] = { 0 };
+  const mat4 bias = mat4::getTranslation(0.5, 0.5, 0.5) * mat4::getScaling(0.5, 0.5, 0.5);
+  for(int ic=0; ic<mCascadeCount; ++ic)
+  {
+    mat4 view_proj = mCascades[ic].mCamera->projectionMatrix() * mCascades[ic].mCamera->viewMatrix();
+    cascade_matrices[ic] = (fmat4)view_proj;
+    shadow_matrices[ic] = (fmat4)( bias * view_proj );
+    splits[ic] = (float)mSplits[ic+1];
+  }
+  mCascadeMatrices->setUniform(MaxCascades, cascade_matrices);
+  mShadowMatrices->setUniform(MaxCascades, shadow_matrices);
+  mShadowSplits->setUniform(MaxCascades, splits);
+  mShadowCascadeCount->setUniformI(mCascadeCount);
+
+  // layered: all the cascades at once, otherwise one cascade per pass
+  int passes = mLayered ? 1 : mCascadeCount;
+  for(int pass=0; pass<passes; ++pass)
+  {
+    mRenderQueue->clear();
+    mCasterIndex.clear();
+    int caster_count = 0;
+    for(int ic=0; ic<mCascadeCount; ++ic)
+    {
+      Cascade& cascade = mCascades[ic];
+      if ( !cascade.mDirty || ( !mLayered && ic != pass ) )
+        continue;
+      ++mStatsRenderedCascades;
+
+      for(size_t i=0; i<cascade.mCasters.size(); ++i)
+      {
+        const CasterRecord& rec = cascade.mCasters[i];
+        std::map<Actor*, int>::iterator it = mCasterIndex.find(rec.mActor);
+        if ( it == mCasterIndex.end() )
+        {
+          if ( caster_count == (int)mCasterRenderables.size() )
+            mCasterRenderables.push_back( new CasterRenderable );
+          CasterRenderable* caster = mCasterRenderables[caster_count].get();
+          caster->set( rec.mRenderable, location, isInstanceable(rec.mRenderable) );
+          it = mCasterIndex.insert( std::make_pair(rec.mActor, caster_count++) ).first;
+
+          RenderToken* tok = mRenderQueue->newToken(false);
+          tok->mNextPass = NULL;
+          tok->mActor = rec.mActor;
+          tok->mRenderable = caster;
+          tok->mShader = mShader.get();
+          tok->mEffectRenderRank = 0;
+          tok->mCameraDistance = 0;
+        }
+        mCasterRenderables[it->second]->mLayers.push_back(ic);
+        ++mStatsShadowInstances;
+      }
+
+      // clear the layers being rendered
+      mLayerFBOs[ic]->activate();
+      mClearViewport->activate();
+    }
+    mStatsShadowCasters += caster_count;
+
+    if ( mRenderQueue->size() )
+    {
+      mRenderer->setFramebuffer( mLayered ? mLayeredFBO.get() : mLayerFBOs[pass].get() );
+      mRenderer->setClearFlags(CF_DO_NOT_CLEAR);
+      mRenderer->render( mRenderQueue.get(), mRenderCamera.get(), frame_clock );
+    }
+
+    // release the references to the rendered Renderable[s]
+    for(int i=0; i<caster_count; ++i)
+      mCasterRenderables[i]->set(NULL, -1, false);
+  }
+
+  for(int ic=0; ic<mCascadeCount; ++ic)
+    mCascades[ic].mDirty = false;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,256 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef CascadedShadowMap_INCLUDE_ONCE
+#define CascadedShadowMap_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/Uniform.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // CascadedShadowMap
+  //------------------------------------------------------------------------------
+  /** Renders the cascaded shadow map of a directional light for the camera of a Rendering.
+    *
+    * Install it with Rendering::setCascadedShadowMap(). Every frame the view frustum, up to maxDistance(), is split in
+    * cascadeCount() slices (see setSplitLambda()). Each cascade is an orthographic light-space box enclosing the bounding
+    * sphere of its slice, snapped to the shadow map texels so that the shadows do not shimmer when the camera moves.
+    * The shadow casters of each cascade are culled with the SceneManager[s] of the Rendering and all the cascades are
+    * drawn in a single pass into the layers of a depth texture array: each caster is drawn once, instanced once per
+    * cascade it falls into, with the layer selected in the vertex shader (GL_ARB_shader_viewport_layer_array).
+    * Without that extension each cascade is rendered in a separate pass.
+    *
+    * The last cachedCascades() cascades are fit with an extra cacheMargin() and are rendered only when the light
+    * direction changes, when their slice leaves the cached box or when their casters change (added, removed, moved
+    * or with updated bounds), so that the far cascades of static scenes are not re-rendered every frame.
+    *
+    * setupShader() binds the shadow map and the cascade uniforms to the Shader[s] of the shadow receivers, whose
+    * fragment shader can then include \p /glsl/std/shadow_cascades.glsl (GLSL 1.50):
+    * \code
+    * #pragma VL include /glsl/std/shadow_cascades.glsl
+    * ...
+    * float lit = vl_shadowFactor(world_pos, view_depth); // 0 = in shadow, 1 = lit
+    * \endcode
+    *
+    * Only the Actor[s] whose enable mask matches casterMask() cast shadows, using their LOD #0 Renderable and a
+    * position-only shader computing \p vl_WorldMatrix * \p vl_VertexPosition: Actor[s] whose shaders displace the
+    * vertices or discard fragments are not supported.
+    * \sa Rendering::setCascadedShadowMap() */
+  class VLGRAPHICS_EXPORT CascadedShadowMap: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::CascadedShadowMap, Object)
+
+  public:
+    //! The maximum number of cascades.
+    static const int MaxCascades = 8;
+
+  public:
+    CascadedShadowMap();
+
+    //! Enables or disables the shadow map rendering (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! The direction of the light rays in world coordinates (default = 0,-1,0).
+    void setLightDirection(const vec3& dir) { mLightDirection = dir; mLightDirection.normalize(); }
+    const vec3& lightDirection() const { return mLightDirection; }
+
+    //! Number of cascades, from 1 to MaxCascades (default = 4).
+    void setCascadeCount(int count);
+    int cascadeCount() const { return mCascadeCount; }
+
+    //! Width and height in pixels of each cascade (default = 2048).
+    void setShadowMapSize(int size);
+    int shadowMapSize() const { return mShadowMapSize; }
+
+    //! Distance from the camera covered by the cascades, 0 means up to the camera far plane (default = 0).
+    void setMaxDistance(real distance) { mMaxDistance = distance; }
+    real maxDistance() const { return mMaxDistance; }
+
+    //! Blends between uniform (0) and logarithmic (1) split distances (default = 0.75).
+    void setSplitLambda(float lambda) { mSplitLambda = lambda; }
+    float splitLambda() const { return mSplitLambda; }
+
+    //! Number of far cascades which are cached and re-rendered only when needed (default = 1).
+    void setCachedCascades(int count) { mCachedCascades = count; invalidateCache(); }
+    int cachedCascades() const { return mCachedCascades; }
+
+    //! Extra size, relative to the slice bounding sphere, of the cached cascades (default = 0.25).
+    void setCacheMargin(float margin) { mCacheMargin = margin; invalidateCache(); }
+    float cacheMargin() const { return mCacheMargin; }
+
+    //! Forces the re-rendering of the cached cascades at the next frame.
+    void invalidateCache();
+
+    //! Only the Actor[s] whose enable mask matches this mask cast shadows (default = 0xFFFFFFFF).
+    void setCasterMask(unsigned int mask) { mCasterMask = mask; }
+    unsigned int casterMask() const { return mCasterMask; }
+
+    //! Slope-scaled and constant depth bias applied while rendering the shadow map (default = 2, 4).
+    void setDepthBias(float factor, float units) { mPolygonOffset->set(factor, units); }
+
+    //! Enables the single pass layered rendering when supported (default = true).
+    void setLayeredRenderingEnabled(bool enabled) { mLayeredRenderingEnabled = enabled; }
+    bool layeredRenderingEnabled() const { return mLayeredRenderingEnabled; }
+
+    /** Binds the shadow map to the texture unit \p unit of \p shader and adds to it the uniforms used by
+      * \p /glsl/std/shadow_cascades.glsl. */
+    void setupShader(Shader* shader, int unit);
+
+    /** Fits the cascades to \p camera, culls the casters of \p scene_managers and renders the cascades which need it.
+      * Called by Rendering::render() after the Camera has been set up. */
+    void render(Collection<SceneManager>* scene_managers, const Camera* camera, OpenGLContext* gl_context, real frame_clock);
+
+    //! The depth texture array containing one layer per cascade.
+    Texture* shadowMap() { return mShadowMap.get(); }
+
+    //! The camera used to render the given cascade during the last render().
+    const Camera* cascadeCamera(int cascade) const { return mCascades[cascade].mCamera.get(); }
+
+    //! The view-space distance at which the given cascade ends.
+    real splitDistance(int cascade) const { return mSplits[cascade+1]; }
+
+    //! Number of cascades rendered by the last render().
+    int statsRenderedCascades() const { return mStatsRenderedCascades; }
+    //! Number of casters drawn by the last render().
+    int statsShadowCasters() const { return mStatsShadowCasters; }
+    //! Number of caster instances drawn by the last render(), that is casters times cascades.
+    int statsShadowInstances() const { return mStatsShadowInstances; }
+
+    //! Releases the shadow map and the framebuffer objects.
+    void releaseOpenGLResources();
+
+  protected:
+    //! Renders a caster once per cascade it falls into.
+    class CasterRenderable: public Renderable
+    {
+    public:
+      CasterRenderable(): mRenderable(NULL), mLocation(-1), mInstanced(false) {}
+
+      void set(Renderable* renderable, int location, bool instanced);
+
+    public:
+      std::vector<int> mLayers;
+
+    protected:
+      virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+      virtual void deleteBufferObject() {}
+      virtual void computeBounds_Implementation();
+      virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+
+    protected:
+      Renderable* mRenderable;
+      int mLocation;
+      bool mInstanced;
+    };
+
+    struct CasterRecord
+    {
+      CasterRecord(): mActor(NULL), mRenderable(NULL), mTransformTick(-1), mBoundsTick(-1) {}
+      bool operator==(const CasterRecord& other) const
+      {
+        return mActor == other.mActor && mRenderable == other.mRenderable && mTransformTick == other.mTransformTick && mBoundsTick == other.mBoundsTick;
+      }
+
+      Actor* mActor;
+      Renderable* mRenderable;
+      long long mTransformTick;
+      long long mBoundsTick;
+    };
+
+    struct Cascade
+    {
+      Cascade(): mRadius(0), mBackDistance(0), mValid(false), mDirty(true) {}
+
+      ref<Camera> mCamera;
+      vec3 mCenter;
+      real mRadius;
+      real mBackDistance;
+      vec3 mLightDirection;
+      ActorCollection mActors;
+      std::vector<CasterRecord> mCasters;
+      bool mValid;
+      bool mDirty;
+    };
+
+  protected:
+    bool prepareResources(OpenGLContext* gl_context);
+    void fitCascade(Cascade& cascade, const vec3& center, real radius, real back_distance);
+    bool isInstanceable(const Renderable* renderable) const;
+
+  protected:
+    ref<Renderer> mRenderer;
+    ref<Camera> mRenderCamera;
+    ref<Shader> mShader;
+    ref<PolygonOffset> mPolygonOffset;
+    ref<RenderQueue> mRenderQueue;
+    std::vector< ref<CasterRenderable> > mCasterRenderables;
+    std::map< Actor*, int > mCasterIndex;
+    Cascade mCascades[MaxCascades];
+    real mSplits[MaxCascades+1];
+    ref<Texture> mShadowMap;
+    ref<FramebufferObject> mLayeredFBO;
+    std::vector< ref<FramebufferObject> > mLayerFBOs;
+    ref<Viewport> mClearViewport;
+    ref<Uniform> mCascadeMatrices;
+    ref<Uniform> mShadowMatrices;
+    ref<Uniform> mShadowSplits;
+    ref<Uniform> mShadowCascadeCount;
+    OpenGLContext* mOpenGLContext;
+    vec3 mLightDirection;
+    real mMaxDistance;
+    float mSplitLambda;
+    float mCacheMargin;
+    int mCascadeCount;
+    int mShadowMapSize;
+    int mCachedCascades;
+    unsigned int mCasterMask;
+    bool mEnabled;
+    bool mLayeredRenderingEnabled;
+    bool mLayered;
+    int mStatsRenderedCascades;
+    int mStatsShadowCasters;
+    int mStatsShadowInstances;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -31,6 +31,7 @@
 
 #include <vlGraphics/Clear.hpp>
 #include <vlGraphics/Camera.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
 #include <vlCore/Vector4.hpp>
 #include <vlCore/Log.hpp>
 
@@ -48,7 +49,7 @@ Clear::Clear(): mClearColorMode(CCM_Float), mClearDepthValue(1.0f), mClearStenci
   mScissorBox[3] = -1;
 }
 //-----------------------------------------------------------------------------
-void Clear::render_Implementation(const Actor*, const Shader*, const Camera* camera, OpenGLContext*) const
+void Clear::render_Implementation(const Actor*, const Shader*, const Camera* camera, OpenGLContext* gl_context) const
 {
   // build buffer bit mask
   GLbitfield mask = 0;
@@ -67,10 +68,9 @@ void Clear::render_Implementation(const Actor*, const Shader*, const Camera* cam
   {
     int viewport[] = { camera->viewport()->x(), camera->viewport()->y(), camera->viewport()->width(), camera->viewport()->height() };
 
-    // save scissor settings
-    GLboolean scissor_on = glIsEnabled(GL_SCISSOR_TEST);
-    int scissor_box_save[4] = {0,0,-1,-1};
-    glGetIntegerv(GL_SCISSOR_BOX, scissor_box_save);
+    // the scissor settings to be restored are shadowed by the OpenGLContext
+    const bool scissor_on = gl_context->isScissorEnabled();
+    const RectI scissor_box_save = gl_context->scissorBox();
 
     int scissor_box[4] = {0,0,-1,-1};
 
@@ -136,7 +136,7 @@ void Clear::render_Implementation(const Actor*, const Shader*, const Camera* cam
     // restore scissor settings
     if (!scissor_on)
       glDisable(GL_SCISSOR_TEST);
-    glScissor(scissor_box_save[0], scissor_box_save[1], scissor_box_save[2], scissor_box_save[3]); VL_CHECK_OGL()
+    glScissor(scissor_box_save.x(), scissor_box_save.y(), scissor_box_save.width(), scissor_box_save.height()); VL_CHECK_OGL()
   }
 }
 //-----------------------------------------------------------------------------
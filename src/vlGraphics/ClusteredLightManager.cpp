@@ -0,0 +1,328 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/ClusteredLightManager.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cmath>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+ClusteredLightManager::ClusteredLightManager()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mGridSize = ivec3(16, 9, 24);
+  mMaxLightsPerCluster = 256;
+  mThreadCount = 1;
+  mEnabled = true;
+  mBoundsNear = 0;
+  mBoundsFar  = 0;
+  mSliceScale = 0;
+  mStatsVisibleLights    = 0;
+  mStatsLightIndices     = 0;
+  mStatsMaxClusterLights = 0;
+
+  mLightBuffer   = new BufferObject;
+  mClusterBuffer = new BufferObject;
+  mIndexBuffer   = new BufferObject;
+  mLightTexture   = new Texture;
+  mClusterTexture = new Texture;
+  mIndexTexture   = new Texture;
+
+  mGridUniform     = new Uniform("vl_ClusterGrid");
+  mDepthUniform    = new Uniform("vl_ClusterDepth");
+  mViewportUniform = new Uniform("vl_ClusterViewport");
+  mGridUniform->setUniform(mGridSize);
+  mDepthUniform->setUniform(fvec2(1, 0));
+  mViewportUniform->setUniform(fvec4(0, 0, 1, 1));
+}
+//-----------------------------------------------------------------------------
+void ClusteredLightManager::setGridSize(int x, int y, int z)
+{
+  mGridSize = ivec3( x < 1 ? 1 : x, y < 1 ? 1 : y, z < 1 ? 1 : z );
+  mGridUniform->setUniform(mGridSize);
+  // force the recomputation of the cluster bounds
+  mClusterMin.clear();
+  mClusterMax.clear();
+}
+//-----------------------------------------------------------------------------
+void ClusteredLightManager::setupShader(Shader* shader, int first_unit)
+{
+  VL_CHECK(shader)
+  shader->gocTextureSampler(first_unit+0)->setTexture( mLightTexture.get() );
+  shader->gocTextureSampler(first_unit+1)->setTexture( mClusterTexture.get() );
+  shader->gocTextureSampler(first_unit+2)->setTexture( mIndexTexture.get() );
+  shader->gocUniform("vl_ClusterLights")->setUniformI(first_unit+0);
+  shader->gocUniform("vl_ClusterRanges")->setUniformI(first_unit+1);
+  shader->gocUniform("vl_ClusterIndices")->setUniformI(first_unit+2);
+  // shared among all the shaders, updated by update()
+  shader->setUniform( mGridUniform.get() );
+  shader->setUniform( mDepthUniform.get() );
+  shader->setUniform( mViewportUniform.get() );
+}
+//-----------------------------------------------------------------------------
+int ClusteredLightManager::depthSlice(float depth) const
+{
+  if (depth <= mBoundsNear)
+    return 0;
+  int slice = (int)( ::log(depth / mBoundsNear) * mSliceScale );
+  return slice < mGridSize.z() ? slice : mGridSize.z() - 1;
+}
+//-----------------------------------------------------------------------------
+void ClusteredLightManager::computeClusterBounds(const Camera* camera, float z_near, float z_far)
+{
+  fmat4 proj = (fmat4)camera->projectionMatrix();
+  int cluster_count = mGridSize.x() * mGridSize.y() * mGridSize.z();
+  if ( (int)mClusterMin.size() == cluster_count && proj == mBoundsProjection && z_near == mBoundsNear && z_far == mBoundsFar )
+    return;
+
+  mBoundsProjection = proj;
+  mBoundsNear = z_near;
+  mBoundsFar  = z_far;
+  mSliceScale = mGridSize.z() / ::log(z_far / z_near);
+  mClusterMin.resize(cluster_count);
+  mClusterMax.resize(cluster_count);
+
+  // view-space rays through the tile corners
+  fmat4 inv_proj = proj.getInverse();
+  const int nx = mGridSize.x();
+  const int ny = mGridSize.y();
+  std::vector<fvec3> ray_orig( (nx+1)*(ny+1) );
+  std::vector<fvec3> ray_dir( (nx+1)*(ny+1) );
+  for(int y=0; y<=ny; ++y)
+  {
+    for(int x=0; x<=nx; ++x)
+    {
+      float ndc_x = -1.0f + 2.0f * x / nx;
+      float ndc_y = -1.0f + 2.0f * y / ny;
+      fvec4 n = inv_proj * fvec4(ndc_x, ndc_y, -1, 1);
+      fvec4 f = inv_proj * fvec4(ndc_x, ndc_y, +1, 1);
+      fvec3 pn = n.xyz() / n.w();
+      fvec3 pf = f.xyz() / f.w();
+      // parametrize the ray by the view-space z
+      fvec3 dir = (pf - pn) / (pf.z() - pn.z());
+      ray_orig[y*(nx+1)+x] = pn - dir * pn.z();
+      ray_dir [y*(nx+1)+x] = dir;
+    }
+  }
+
+  for(int z=0; z<mGridSize.z(); ++z)
+  {
+    float slice_z[] = {
+      -z_near * (float)::pow(z_far / z_near, (float)(z+0) / mGridSize.z()),
+      -z_near * (float)::pow(z_far / z_near, (float)(z+1) / mGridSize.z())
+    };
+    for(int y=0; y<ny; ++y)
+    {
+      for(int x=0; x<nx; ++x)
+      {
+        int cluster = (z*ny + y)*nx + x;
+        fvec3& bmin = mClusterMin[cluster];
+        fvec3& bmax = mClusterMax[cluster];
+        bmin = fvec3(+1e30f, +1e30f, +1e30f);
+        bmax = fvec3(-1e30f, -1e30f, -1e30f);
+        for(int c=0; c<4; ++c)
+        {
+          int ray = (y + c/2)*(nx+1) + x + c%2;
+          for(int d=0; d<2; ++d)
+          {
+            fvec3 p = ray_orig[ray] + ray_dir[ray] * slice_z[d];
+            bmin = min(bmin, p);
+            bmax = max(bmax, p);
+          }
+        }
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ClusteredLightManager::update(const Camera* camera)
+{
+  VL_CHECK(camera)
+  VL_CHECK(camera->viewport())
+
+  if (!Has_GLSL || !Has_Texture_Buffer)
+  {
+    Log::error("ClusteredLightManager::update(): texture buffers not supported!\n");
+    return;
+  }
+
+  const int nx = mGridSize.x();
+  const int ny = mGridSize.y();
+  const int nz = mGridSize.z();
+  const int cluster_count = nx * ny * nz;
+
+  // the slices span the camera depth range, a zero near plane (orthographic cameras) is clamped
+  float z_far  = (float)camera->farPlane();
+  float z_near = max( (float)camera->nearPlane(), z_far * 0.0001f );
+  computeClusterBounds(camera, z_near, z_far);
+
+  // transform the visible lights in view space and bin them by depth slice
+
+  const mat4& view = camera->viewMatrix();
+  mLightData.clear();
+  mSliceLights.resize(nz);
+  for(int z=0; z<nz; ++z)
+    mSliceLights[z].clear();
+  for(size_t i=0; i<mLights.size(); ++i)
+  {
+    const PointLight& light = mLights[i];
+    if ( !light.mEnabled || light.mRadius <= 0 || camera->frustum().cull( Sphere(light.mPosition, light.mRadius) ) )
+      continue;
+    fvec3 pos = (fvec3)( view * light.mPosition );
+    float depth = -pos.z();
+    if ( depth + light.mRadius < z_near || depth - light.mRadius > z_far )
+      continue;
+    int index = (int)mLightData.size() / 2;
+    mLightData.push_back( fvec4(pos, light.mRadius) );
+    mLightData.push_back( fvec4(light.mColor, 0) );
+    int z0 = depthSlice( depth - light.mRadius );
+    int z1 = depthSlice( depth + light.mRadius );
+    for(int z=z0; z<=z1; ++z)
+      mSliceLights[z].push_back(index);
+  }
+  mStatsVisibleLights = (int)mLightData.size() / 2;
+
+  // assign the lights to the clusters, each slice is independent
+
+  mClusterLights.resize(cluster_count);
+  const fmat4& proj = mBoundsProjection;
+  const float ratio = z_far / z_near;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+  for(int z=0; z<nz; ++z)
+  {
+    const float slice_near = z_near * ::pow(ratio, (float)(z+0) / nz);
+    const float slice_far  = z_near * ::pow(ratio, (float)(z+1) / nz);
+    for(int i=z*nx*ny; i<(z+1)*nx*ny; ++i)
+      mClusterLights[i].clear();
+
+    const std::vector<int>& slice_lights = mSliceLights[z];
+    for(size_t l=0; l<slice_lights.size(); ++l)
+    {
+      const fvec4& light = mLightData[ slice_lights[l]*2 ];
+      const fvec3 center = light.xyz();
+      const float radius = light.w();
+
+      // screen-space extent of the part of the light's bounding box within the slice
+      float d0 = max(slice_near, -center.z() - radius);
+      float d1 = min(slice_far,  -center.z() + radius);
+      float x0 = +1e30f, x1 = -1e30f, y0 = +1e30f, y1 = -1e30f;
+      for(int c=0; c<8; ++c)
+      {
+        fvec4 clip = proj * fvec4( center.x() + (c&1 ? radius : -radius),
+                                   center.y() + (c&2 ? radius : -radius),
+                                   c&4 ? -d1 : -d0, 1 );
+        float ndc_x = clip.x() / clip.w();
+        float ndc_y = clip.y() / clip.w();
+        x0 = min(x0, ndc_x); x1 = max(x1, ndc_x);
+        y0 = min(y0, ndc_y); y1 = max(y1, ndc_y);
+      }
+      if ( x1 < -1 || x0 > 1 || y1 < -1 || y0 > 1 )
+        continue;
+      int tx0 = clamp( (int)::floor( (x0*0.5f + 0.5f) * nx ), 0, nx-1 );
+      int tx1 = clamp( (int)::floor( (x1*0.5f + 0.5f) * nx ), 0, nx-1 );
+      int ty0 = clamp( (int)::floor( (y0*0.5f + 0.5f) * ny ), 0, ny-1 );
+      int ty1 = clamp( (int)::floor( (y1*0.5f + 0.5f) * ny ), 0, ny-1 );
+
+      // exact sphere vs cluster box test
+      const float radius2 = radius * radius;
+      for(int ty=ty0; ty<=ty1; ++ty)
+      {
+        for(int tx=tx0; tx<=tx1; ++tx)
+        {
+          int cluster = (z*ny + ty)*nx + tx;
+          const fvec3& bmin = mClusterMin[cluster];
+          const fvec3& bmax = mClusterMax[cluster];
+          float dist2 = 0;
+          for(int k=0; k<3; ++k)
+          {
+            float d = max( max(bmin[k] - center[k], center[k] - bmax[k]), 0.0f );
+            dist2 += d * d;
+          }
+          if (dist2 <= radius2)
+            mClusterLights[cluster].push_back( slice_lights[l] );
+        }
+      }
+    }
+  }
+
+  // compact the cluster lists into a single index list
+
+  mClusterData.resize(cluster_count * 2);
+  mIndexData.clear();
+  mStatsMaxClusterLights = 0;
+  for(int i=0; i<cluster_count; ++i)
+  {
+    const std::vector<unsigned int>& lights = mClusterLights[i];
+    int count = min( (int)lights.size(), mMaxLightsPerCluster );
+    mStatsMaxClusterLights = max( mStatsMaxClusterLights, (int)lights.size() );
+    mClusterData[i*2+0] = (unsigned int)mIndexData.size();
+    mClusterData[i*2+1] = (unsigned int)count;
+    mIndexData.insert( mIndexData.end(), lights.begin(), lights.begin() + count );
+  }
+  mStatsLightIndices = (int)mIndexData.size();
+
+  // upload: texture buffers cannot be empty
+
+  if (mLightData.empty())
+    mLightData.resize(2);
+  if (mIndexData.empty())
+    mIndexData.resize(1);
+  mLightBuffer->setBufferData( sizeof(fvec4) * mLightData.size(), &mLightData[0], BU_DYNAMIC_DRAW );
+  mClusterBuffer->setBufferData( sizeof(unsigned int) * mClusterData.size(), &mClusterData[0], BU_DYNAMIC_DRAW );
+  mIndexBuffer->setBufferData( sizeof(unsigned int) * mIndexData.size(), &mIndexData[0], BU_DYNAMIC_DRAW );
+  if (!mLightTexture->handle())
+  {
+    mLightTexture->createTextureBuffer( TF_RGBA32F, mLightBuffer.get() );
+    mClusterTexture->createTextureBuffer( TF_RG32UI, mClusterBuffer.get() );
+    mIndexTexture->createTextureBuffer( TF_R32UI, mIndexBuffer.get() );
+  }
+
+  const Viewport* viewport = camera->viewport();
+  mDepthUniform->setUniform( fvec2(z_near, mSliceScale) );
+  mViewportUniform->setUniform( fvec4( (float)viewport->x(), (float)viewport->y(), (float)viewport->width(), (float)viewport->height() ) );
+}
+//-----------------------------------------------------------------------------
+void ClusteredLightManager::releaseOpenGLResources()
+{
+  mLightTexture->destroyTexture();
+  mClusterTexture->destroyTexture();
+  mIndexTexture->destroyTexture();
+  mLightBuffer->deleteBufferObject();
+  mClusterBuffer->deleteBufferObject();
+  mIndexBuffer->deleteBufferObject();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,188 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef ClusteredLightManager_INCLUDE_ONCE
+#define ClusteredLightManager_INCLUDE_ONCE
+
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/Uniform.hpp>
+#include <vector>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // ClusteredLightManager
+  //------------------------------------------------------------------------------
+  /** Manages thousands of point lights for clustered forward shading, lifting the 8 lights limit of the Light render state.
+    *
+    * Install it with Rendering::setClusteredLightManager(). Once per frame, after the Camera has been set up, update()
+    * transforms the visible lights in view space and assigns them to a gridSize() grid of view-space clusters: the
+    * viewport is split in \p x * \p y tiles and the depth range between the Camera's near and far planes in \p z
+    * exponentially distributed slices. The assignment runs on the CPU, one slice per thread when OpenMP is available.
+    *
+    * The lights, the per-cluster light ranges and the light index list are uploaded as texture buffers. setupShader()
+    * binds them, together with the grid uniforms, to a Shader. The GLSL side is provided by
+    * \p /glsl/std/clustered_lighting.glsl which must be included in the fragment shader after the \p #version
+    * directive (GLSL 1.40 or later):
+    * \code
+    * #pragma VL include /glsl/std/clustered_lighting.glsl
+    * ...
+    * uvec2 range = vl_clusterLightRange(view_pos); // view_pos = view-space position of the fragment
+    * for(uint i=range.x; i<range.x+range.y; ++i)
+    * {
+    *   int light = vl_clusterLight(i);
+    *   vec4 pos_radius = vl_clusterLightPositionRadius(light);
+    *   vec3 color = vl_clusterLightColor(light);
+    *   ...
+    * }
+    * \endcode
+    * or simply \p vl_clusteredDiffuse(view_pos, view_normal) which accumulates the diffuse contribution of the lights
+    * affecting the fragment with the same smooth distance falloff used to compute the light radii.
+    *
+    * \note Light positions are in world coordinates, colors are premultiplied by the light intensity and the radius is
+    * the distance at which the light contribution falls to zero.
+    * \sa Rendering::setClusteredLightManager(), Light */
+  class VLGRAPHICS_EXPORT ClusteredLightManager: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ClusteredLightManager, Object)
+
+  public:
+    //! A point light managed by a ClusteredLightManager.
+    struct PointLight
+    {
+      PointLight(): mColor(1,1,1), mRadius(1), mEnabled(true) {}
+      PointLight(const vec3& position, const fvec3& color, float radius): mPosition(position), mColor(color), mRadius(radius), mEnabled(true) {}
+
+      vec3 mPosition;
+      fvec3 mColor;
+      float mRadius;
+      bool mEnabled;
+    };
+
+  public:
+    ClusteredLightManager();
+
+    //! Enables or disables the update of the clusters (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! The managed lights, can be edited directly. Changes are picked up by the next update().
+    std::vector<PointLight>& lights() { return mLights; }
+    const std::vector<PointLight>& lights() const { return mLights; }
+
+    //! Adds a point light and returns its index in lights().
+    int addLight(const vec3& position, const fvec3& color, float radius)
+    {
+      mLights.push_back( PointLight(position, color, radius) );
+      return (int)mLights.size() - 1;
+    }
+
+    //! The number of tiles along the viewport width and height and of depth slices (default = 16 x 9 x 24).
+    void setGridSize(int x, int y, int z);
+    const ivec3& gridSize() const { return mGridSize; }
+
+    //! Lights exceeding this number in a cluster are dropped from it (default = 256).
+    void setMaxLightsPerCluster(int max_lights) { mMaxLightsPerCluster = max_lights < 1 ? 1 : max_lights; }
+    int maxLightsPerCluster() const { return mMaxLightsPerCluster; }
+
+    //! Number of threads used to assign the lights to the clusters when OpenMP is available (default = 1).
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+    int threadCount() const { return mThreadCount; }
+
+    /** Binds the light textures to the texture units \p first_unit, \p first_unit+1 and \p first_unit+2 of \p shader
+      * and adds to it the uniforms used by \p /glsl/std/clustered_lighting.glsl. */
+    void setupShader(Shader* shader, int first_unit);
+
+    /** Assigns the lights to the clusters of \p camera and uploads the result to the GPU.
+      * Called by Rendering::render() after the Camera has been set up. */
+    void update(const Camera* camera);
+
+    //! Texture buffer containing 2 RGBA32F texels per visible light: view-space position and radius, color.
+    Texture* lightTexture() { return mLightTexture.get(); }
+    //! Texture buffer containing one RG32UI texel per cluster: offset in the index list and light count.
+    Texture* clusterTexture() { return mClusterTexture.get(); }
+    //! Texture buffer containing the R32UI light index list.
+    Texture* indexTexture() { return mIndexTexture.get(); }
+
+    //! Number of lights intersecting the view frustum during the last update().
+    int statsVisibleLights() const { return mStatsVisibleLights; }
+    //! Total number of light indices assigned to the clusters during the last update().
+    int statsLightIndices() const { return mStatsLightIndices; }
+    //! Highest light count of a cluster during the last update(), before clamping to maxLightsPerCluster().
+    int statsMaxClusterLights() const { return mStatsMaxClusterLights; }
+
+    //! Releases the buffer objects and textures.
+    void releaseOpenGLResources();
+
+  protected:
+    void computeClusterBounds(const Camera* camera, float z_near, float z_far);
+    int depthSlice(float depth) const;
+
+  protected:
+    std::vector<PointLight> mLights;
+    ivec3 mGridSize;
+    int mMaxLightsPerCluster;
+    int mThreadCount;
+    bool mEnabled;
+    // view-space cluster bounds, recomputed when the projection changes
+    std::vector<fvec3> mClusterMin;
+    std::vector<fvec3> mClusterMax;
+    fmat4 mBoundsProjection;
+    float mBoundsNear;
+    float mBoundsFar;
+    float mSliceScale;
+    // per-frame assignment
+    std::vector<fvec4> mLightData;
+    std::vector< std::vector<int> > mSliceLights;
+    std::vector< std::vector<unsigned int> > mClusterLights;
+    std::vector<unsigned int> mClusterData;
+    std::vector<unsigned int> mIndexData;
+    // GPU resources
+    ref<BufferObject> mLightBuffer;
+    ref<BufferObject> mClusterBuffer;
+    ref<BufferObject> mIndexBuffer;
+    ref<Texture> mLightTexture;
+    ref<Texture> mClusterTexture;
+    ref<Texture> mIndexTexture;
+    ref<Uniform> mGridUniform;
+    ref<Uniform> mDepthUniform;
+    ref<Uniform> mViewportUniform;
+    int mStatsVisibleLights;
+    int mStatsLightIndices;
+    int mStatsMaxClusterLights;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
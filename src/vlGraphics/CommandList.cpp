@@ -0,0 +1,144 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/CommandList.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+namespace
+{
+  //-----------------------------------------------------------------------------
+  class UpdateArrayCommand: public CommandList::Command
+  {
+  public:
+    UpdateArrayCommand(ArrayAbstract* array, size_t offset, const void* data, size_t byte_count): mArray(array), mOffset(offset)
+    {
+      mData.resize(byte_count);
+      if (byte_count)
+        memcpy(&mData[0], data, byte_count);
+    }
+
+    virtual void execute(OpenGLContext*)
+    {
+      // the update must not leak into the arrays sharing the storage copy-on-write
+      mArray->detach();
+      BufferObject* bo = mArray->bufferObject();
+      if (mOffset + mData.size() > bo->bytesUsed())
+      {
+        Log::error( Say("CommandList: array update out of bounds (%n + %n > %n bytes).\n") << mOffset << mData.size() << bo->bytesUsed() );
+        return;
+      }
+      if (mData.empty())
+        return;
+      memcpy(bo->ptr() + mOffset, &mData[0], mData.size());
+      // update the GPU copy in place if it already exists and is big enough, otherwise let the Renderable upload it
+      if (Has_BufferObject && bo->handle() && mOffset + mData.size() <= (size_t)bo->byteCountBufferObject())
+        bo->setBufferSubData( (GLintptr)mOffset, (GLsizeiptr)mData.size(), &mData[0] );
+      else
+        mArray->setBufferObjectDirty(true);
+    }
+
+  protected:
+    ref<ArrayAbstract> mArray;
+    size_t mOffset;
+    std::vector<unsigned char> mData;
+  };
+  //-----------------------------------------------------------------------------
+  class CreateTextureCommand: public CommandList::Command
+  {
+  public:
+    CreateTextureCommand(Texture* texture): mTexture(texture) {}
+
+    virtual void execute(OpenGLContext*)
+    {
+      if (!mTexture->createTexture())
+        Log::error("CommandList: Texture::createTexture() failed.\n");
+    }
+
+  protected:
+    ref<Texture> mTexture;
+  };
+  //-----------------------------------------------------------------------------
+  class SetMipLevelCommand: public CommandList::Command
+  {
+  public:
+    SetMipLevelCommand(Texture* texture, int mip_level, const Image* image, bool gen_mipmaps):
+      mTexture(texture), mImage(image), mMipLevel(mip_level), mGenMipmaps(gen_mipmaps) {}
+
+    virtual void execute(OpenGLContext*)
+    {
+      if (!mTexture->setMipLevel(mMipLevel, mImage.get(), mGenMipmaps))
+        Log::error( Say("CommandList: Texture::setMipLevel(%n) failed.\n") << mMipLevel );
+    }
+
+  protected:
+    ref<Texture> mTexture;
+    ref<Image> mImage;
+    int mMipLevel;
+    bool mGenMipmaps;
+  };
+}
+//-----------------------------------------------------------------------------
+// CommandList
+//-----------------------------------------------------------------------------
+void CommandList::updateArray(ArrayAbstract* array, size_t offset, const void* data, size_t byte_count)
+{
+  VL_CHECK(array)
+  VL_CHECK(data || !byte_count)
+  mCommands.push_back( new UpdateArrayCommand(array, offset, data, byte_count) );
+}
+//-----------------------------------------------------------------------------
+void CommandList::createTexture(Texture* texture)
+{
+  VL_CHECK(texture)
+  mCommands.push_back( new CreateTextureCommand(texture) );
+}
+//-----------------------------------------------------------------------------
+void CommandList::setMipLevel(Texture* texture, int mip_level, const Image* image, bool gen_mipmaps)
+{
+  VL_CHECK(texture)
+  VL_CHECK(image)
+  mCommands.push_back( new SetMipLevelCommand(texture, mip_level, image, gen_mipmaps) );
+}
+//-----------------------------------------------------------------------------
+void CommandList::executeCommands(OpenGLContext* gl_context)
+{
+  for(size_t i=0; i<mCommands.size(); ++i)
+  {
+    mCommands[i]->execute(gl_context);
+    VL_CHECK_OGL()
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,124 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef CommandList_INCLUDE_ONCE
+#define CommandList_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Array.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vector>
+
+namespace vl
+{
+  class OpenGLContext;
+
+  //-----------------------------------------------------------------------------
+  // CommandList
+  //-----------------------------------------------------------------------------
+  /**
+   * A list of deferred commands recorded by a worker thread and replayed by the thread owning the OpenGL context.
+   *
+   * A CommandList does not issue any OpenGL call while being recorded, so each worker thread can fill its own CommandList
+   * concurrently with the others and with the rendering. Once recorded the list is handed over to a Renderer with
+   * Renderer::submitCommandList(): during the next Renderer::renderRaw() the Renderer first executes the commands, ie.
+   * the buffer updates and texture uploads, in the order in which they were recorded and then renders the recorded
+   * RenderQueue[s] after its own RenderQueue.
+   *
+   * A CommandList must not be modified once submitted: the Renderer releases it after replaying it, so a worker thread
+   * should record a new CommandList for each submission.
+   * Custom commands can be recorded by subclassing CommandList::Command.
+   * \sa Renderer::submitCommandList(), Renderer::setCommandListMutex()
+   */
+  class VLGRAPHICS_EXPORT CommandList: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::CommandList, Object)
+
+  public:
+    //! A deferred command executed by the thread owning the OpenGL context.
+    class Command: public Object
+    {
+    public:
+      //! Executes the command, called with the OpenGL context current.
+      virtual void execute(OpenGLContext* gl_context) = 0;
+    };
+
+  public:
+    CommandList()
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    /** Records a write of \p byte_count bytes at the byte offset \p offset of the array's local storage.
+     * The data is copied, so it can be released as soon as this function returns. When replayed the local storage is
+     * updated and, if the array's BufferObject has already been created, the GPU copy is updated with glBufferSubData(),
+     * otherwise the array is flagged as dirty. */
+    void updateArray(ArrayAbstract* array, size_t offset, const void* data, size_t byte_count);
+
+    /** Records the creation of a texture previously set up with one of the Texture::prepareTexture*() functions,
+     * ie. Texture::createTexture() is called when replayed. */
+    void createTexture(Texture* texture);
+
+    /** Records the upload of an image to the given mip level of a texture, see Texture::setMipLevel().
+     * The image is typically loaded and decoded by the worker thread. */
+    void setMipLevel(Texture* texture, int mip_level, const Image* image, bool gen_mipmaps=false);
+
+    /** Records a RenderQueue prepared by the worker thread, rendered by Renderer::renderRaw() after its own RenderQueue.
+     * The RenderQueue should be already sorted, the Renderer does not sort it. */
+    void addRenderQueue(RenderQueue* render_queue) { mRenderQueues.push_back(render_queue); }
+
+    //! Records a custom command.
+    void addCommand(Command* command) { mCommands.push_back(command); }
+
+    //! The recorded commands.
+    const std::vector< ref<Command> >& commands() const { return mCommands; }
+
+    //! The recorded RenderQueue[s].
+    const std::vector< ref<RenderQueue> >& renderQueues() const { return mRenderQueues; }
+
+    //! Removes all the recorded commands and RenderQueue[s].
+    void clear() { mCommands.clear(); mRenderQueues.clear(); }
+
+    //! Returns true if no command and no RenderQueue has been recorded.
+    bool empty() const { return mCommands.empty() && mRenderQueues.empty(); }
+
+    //! Executes the recorded commands in recording order. Must be called from the thread owning the OpenGL context.
+    void executeCommands(OpenGLContext* gl_context);
+
+  protected:
+    std::vector< ref<Command> > mCommands;
+    std::vector< ref<RenderQueue> > mRenderQueues;
+  };
+}
+
+#endif
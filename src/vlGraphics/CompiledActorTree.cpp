@@ -0,0 +1,309 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/CompiledActorTree.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <cfloat>
+#include <cmath>
+
+using namespace vl;
+
+namespace
+{
+  // the planes of a frustum in a float friendly layout
+  struct FlatPlanes
+  {
+    FlatPlanes(const Frustum& frustum)
+    {
+      mCount = (int)frustum.planes().size();
+      VL_CHECK(mCount <= 32)
+      for(int i=0; i<mCount; ++i)
+      {
+        mNX[i] = (float)frustum.plane(i).normal().x();
+        mNY[i] = (float)frustum.plane(i).normal().y();
+        mNZ[i] = (float)frustum.plane(i).normal().z();
+        mD[i]  = (float)frustum.plane(i).origin();
+      }
+    }
+
+    //! Same semantic as Frustum::cull(const AABB&, u32&, int&) without the last plane hint.
+    bool cull(float min_x, float min_y, float min_z, float max_x, float max_y, float max_z, u32& plane_mask) const
+    {
+      for(int i=0; i<mCount; ++i)
+      {
+        if ( !(plane_mask & (1u << i)) )
+          continue;
+        // nearest and farthest corners along the plane's normal
+        float near_d = (mNX[i] >= 0 ? min_x : max_x) * mNX[i] + (mNY[i] >= 0 ? min_y : max_y) * mNY[i] + (mNZ[i] >= 0 ? min_z : max_z) * mNZ[i] - mD[i];
+        if ( near_d >= 0 )
+          return true;
+        float far_d = (mNX[i] >= 0 ? max_x : min_x) * mNX[i] + (mNY[i] >= 0 ? max_y : min_y) * mNY[i] + (mNZ[i] >= 0 ? max_z : min_z) * mNZ[i] - mD[i];
+        if ( far_d < 0 )
+          plane_mask &= ~(1u << i);
+      }
+      return false;
+    }
+
+    float mNX[32], mNY[32], mNZ[32], mD[32];
+    int mCount;
+  };
+
+  inline bool rayHitsBox(const float* origin, const float* inv_dir, const float* const* box, int i)
+  {
+    float t_near = -FLT_MAX;
+    float t_far  =  FLT_MAX;
+    for(int k=0; k<3; ++k)
+    {
+      const float bmin = box[k][i];
+      const float bmax = box[k+3][i];
+      if ( inv_dir[k] == FLT_MAX )
+      {
+        // ray parallel to the slab
+        if ( origin[k] < bmin || origin[k] > bmax )
+          return false;
+        continue;
+      }
+      float t0 = (bmin - origin[k]) * inv_dir[k];
+      float t1 = (bmax - origin[k]) * inv_dir[k];
+      if ( t0 > t1 )
+      {
+        float tmp = t0; t0 = t1; t1 = tmp;
+      }
+      if ( t0 > t_near ) t_near = t0;
+      if ( t1 < t_far  ) t_far  = t1;
+      if ( t_near > t_far || t_far < 0 )
+        return false;
+    }
+    return true;
+  }
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::clear()
+{
+  for(int i=0; i<6; ++i)
+  {
+    mNodeBox[i].clear();
+    mActorBox[i].clear();
+  }
+  mNodeSkip.clear();
+  mNodeActors.clear();
+  mNodeEnabled.clear();
+  mActors.clear();
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::compile(ActorTreeAbstract* tree)
+{
+  clear();
+  if ( tree )
+    compileNode(tree);
+  // sentinel marking the end of the Actors of the last node
+  mNodeActors.push_back( mActors.size() );
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::appendBox(std::vector<float>* soa, const AABB& aabb)
+{
+  // null boxes are never culled, like in Frustum::cull()
+  if ( aabb.isNull() )
+  {
+    for(int i=0; i<3; ++i)
+    {
+      soa[i].push_back(-FLT_MAX);
+      soa[i+3].push_back(FLT_MAX);
+    }
+    return;
+  }
+  soa[0].push_back( (float)aabb.minCorner().x() );
+  soa[1].push_back( (float)aabb.minCorner().y() );
+  soa[2].push_back( (float)aabb.minCorner().z() );
+  soa[3].push_back( (float)aabb.maxCorner().x() );
+  soa[4].push_back( (float)aabb.maxCorner().y() );
+  soa[5].push_back( (float)aabb.maxCorner().z() );
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::compileNode(ActorTreeAbstract* node)
+{
+  const int index = (int)mNodeSkip.size();
+  mNodeSkip.push_back(0);
+  mNodeActors.push_back( mActors.size() );
+  mNodeEnabled.push_back( node->isEnabled() ? 1 : 0 );
+  appendBox( mNodeBox, node->aabb() );
+
+  for(int i=0; i<node->actors()->size(); ++i)
+  {
+    Actor* actor = node->actors()->at(i);
+    actor->computeBounds();
+    mActors.push_back(actor);
+    appendBox( mActorBox, actor->boundingBox() );
+  }
+
+  for(int i=0; i<node->childrenCount(); ++i)
+  {
+    if ( node->child(i) )
+      compileNode( node->child(i) );
+  }
+
+  mNodeSkip[index] = (int)mNodeSkip.size();
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::extractActors(ActorCollection& list) const
+{
+  for(int i=0; i<mActors.size(); ++i)
+    list.push_back( const_cast<Actor*>(mActors.at(i)) );
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::extractActorRange(ActorCollection& list, int begin, int end, const Frustum* frustum, unsigned enable_mask) const
+{
+  // cull in batches of 256 Actors
+  u32 visible[8];
+  for(int start=begin; start<end; start+=256)
+  {
+    const int count = end - start < 256 ? end - start : 256;
+    if ( frustum )
+    {
+      frustum->cullAABBs( count, &mActorBox[0][start], &mActorBox[1][start], &mActorBox[2][start],
+                                 &mActorBox[3][start], &mActorBox[4][start], &mActorBox[5][start], visible );
+    }
+    for(int i=0; i<count; ++i)
+    {
+      if ( frustum && !(visible[i >> 5] & (1u << (i & 31))) )
+        continue;
+      Actor* actor = const_cast<Actor*>(mActors.at(start + i));
+      if ( actor->isEnabled() && (enable_mask & actor->enableMask()) )
+        list.push_back(actor);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::extractVisibleActors(ActorCollection& list, const Camera* camera, unsigned enable_mask) const
+{
+  const int node_count = nodeCount();
+  if ( !node_count )
+    return;
+
+  if ( !camera || camera->frustum().planes().size() > 32 )
+  {
+    // no hierarchical culling, only the enable flags and the Actors are checked
+    const Frustum* frustum = camera ? &camera->frustum() : NULL;
+    for(int i=0; i<node_count; )
+    {
+      if ( !mNodeEnabled[i] )
+      {
+        i = mNodeSkip[i];
+        continue;
+      }
+      extractActorRange( list, mNodeActors[i], mNodeActors[i+1], frustum, enable_mask );
+      ++i;
+    }
+    return;
+  }
+
+  const Frustum& frustum = camera->frustum();
+  FlatPlanes planes(frustum);
+
+  // the planes a node is known to be inside of are not tested for its descendants: the stack
+  // holds the masks to be restored when leaving the subtrees that narrowed down the mask.
+  std::vector< std::pair<int, u32> > stack;
+  u32 mask = planes.mCount == 32 ? 0xFFFFFFFF : (1u << planes.mCount) - 1;
+
+  for(int i=0; i<node_count; )
+  {
+    while( !stack.empty() && stack.back().first <= i )
+    {
+      mask = stack.back().second;
+      stack.pop_back();
+    }
+
+    if ( !mNodeEnabled[i] )
+    {
+      i = mNodeSkip[i];
+      continue;
+    }
+
+    u32 node_mask = mask;
+    if ( node_mask && planes.cull( mNodeBox[0][i], mNodeBox[1][i], mNodeBox[2][i], mNodeBox[3][i], mNodeBox[4][i], mNodeBox[5][i], node_mask ) )
+    {
+      i = mNodeSkip[i];
+      continue;
+    }
+
+    // if the node is entirely inside the frustum its Actors are not culled
+    extractActorRange( list, mNodeActors[i], mNodeActors[i+1], node_mask ? &frustum : NULL, enable_mask );
+
+    if ( node_mask != mask )
+    {
+      stack.push_back( std::make_pair(mNodeSkip[i], mask) );
+      mask = node_mask;
+    }
+    ++i;
+  }
+}
+//-----------------------------------------------------------------------------
+void CompiledActorTree::extractActors(const Ray& ray, ActorCollection& list, unsigned enable_mask) const
+{
+  const int node_count = nodeCount();
+  if ( !node_count )
+    return;
+
+  float origin[3], inv_dir[3];
+  for(int k=0; k<3; ++k)
+  {
+    origin[k] = (float)ray.origin()[k];
+    const float d = (float)ray.direction()[k];
+    inv_dir[k] = fabs(d) > FLT_MIN ? 1.0f / d : FLT_MAX;
+  }
+
+  const float* node_box[6]  = { &mNodeBox[0][0],  &mNodeBox[1][0],  &mNodeBox[2][0],  &mNodeBox[3][0],  &mNodeBox[4][0],  &mNodeBox[5][0] };
+  const float* actor_box[6] = { NULL, NULL, NULL, NULL, NULL, NULL };
+  if ( mActors.size() )
+  {
+    for(int k=0; k<6; ++k)
+      actor_box[k] = &mActorBox[k][0];
+  }
+
+  for(int i=0; i<node_count; )
+  {
+    if ( !mNodeEnabled[i] || !rayHitsBox(origin, inv_dir, node_box, i) )
+    {
+      i = mNodeSkip[i];
+      continue;
+    }
+
+    for(int j=mNodeActors[i]; j<mNodeActors[i+1]; ++j)
+    {
+      Actor* actor = const_cast<Actor*>(mActors.at(j));
+      if ( actor->isEnabled() && (enable_mask & actor->enableMask()) && rayHitsBox(origin, inv_dir, actor_box, j) )
+        list.push_back(actor);
+    }
+    ++i;
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef CompiledActorTree_INCLUDE_ONCE
+#define CompiledActorTree_INCLUDE_ONCE
+
+#include <vlGraphics/ActorTreeAbstract.hpp>
+#include <vlCore/Ray.hpp>
+
+namespace vl
+{
+  class Frustum;
+
+  /**
+   * A read-only, cache friendly snapshot of an ActorTreeAbstract hierarchy (typically an ActorKdTree) used for fast culling and ray queries.
+   *
+   * The nodes are stored in a contiguous array in depth-first order, each node knowing the index of the first node following its subtree,
+   * so that a whole subtree is skipped with a single jump instead of chasing reference-counted child pointers.
+   * The bounding boxes of the nodes and of the Actors are stored in SoA form and the Actors of a node are an index range into a single array,
+   * which allows culling them in batches with Frustum::cullAABBs().
+   *
+   * The snapshot does not track the source tree: call compile() again after the tree, its ActorTreeAbstract::isEnabled() flags
+   * or the bounds of its Actors change. The Actors' isEnabled() and enableMask() are instead evaluated at extraction time.
+   *
+   * \sa
+   * - ActorKdTree
+   * - ActorTree
+   * - SceneManagerActorKdTree
+   * - RayIntersector
+   */
+  class VLGRAPHICS_EXPORT CompiledActorTree: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::CompiledActorTree, Object)
+
+  public:
+    //! Constructor.
+    CompiledActorTree()
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Constructor, compiles the given tree.
+    CompiledActorTree(ActorTreeAbstract* tree)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+      compile(tree);
+    }
+
+    //! Builds the flat representation of the given tree discarding the previous one.
+    //! \note The bounding boxes of the nodes must be up to date, see ActorTreeAbstract::computeAABB().
+    void compile(ActorTreeAbstract* tree);
+
+    //! Discards the compiled data.
+    void clear();
+
+    //! The number of compiled nodes.
+    int nodeCount() const { return (int)mNodeSkip.size(); }
+
+    //! The number of compiled Actors.
+    int actorCount() const { return mActors.size(); }
+
+    //! Appends all the Actors without performing any culling or enable mask check.
+    void extractActors(ActorCollection& list) const;
+
+    //! Appends the enabled Actors that are visible from the given camera, equivalent to ActorTreeAbstract::extractVisibleActors().
+    //! If \p camera is NULL no culling is performed.
+    void extractVisibleActors(ActorCollection& list, const Camera* camera, unsigned enable_mask=0xFFFFFFFF) const;
+
+    //! Appends the enabled Actors whose bounding box is intersected by the given ray.
+    void extractActors(const Ray& ray, ActorCollection& list, unsigned enable_mask=0xFFFFFFFF) const;
+
+  protected:
+    void compileNode(ActorTreeAbstract* node);
+    void appendBox(std::vector<float>* soa, const AABB& aabb);
+    void extractActorRange(ActorCollection& list, int begin, int end, const Frustum* frustum, unsigned enable_mask) const;
+
+  protected:
+    // per node
+    std::vector<float> mNodeBox[6]; // min x, y, z, max x, y, z
+    std::vector<int> mNodeSkip;     // index of the first node following the subtree
+    std::vector<int> mNodeActors;   // index of the first Actor of the node, the node's Actors end where the next node's begin
+    std::vector<unsigned char> mNodeEnabled;
+    // per Actor
+    std::vector<float> mActorBox[6];
+    ActorCollection mActors;
+  };
+}
+
+#endif
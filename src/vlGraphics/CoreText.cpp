@@ -58,7 +58,7 @@ using namespace vl;
 // - Avoid using doubles and floats if possible, use integer and Rect rather floats and AABBs.
 
 //-----------------------------------------------------------------------------
-void CoreText::render_Implementation(const Actor* actor, const Shader*, const Camera* camera, OpenGLContext* gl_context) const
+void CoreText::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
 {
   gl_context->bindVAS(NULL, false, false);
 
@@ -90,9 +90,8 @@ void CoreText::render_Implementation(const Actor* actor, const Shader*, const Ca
 
   // Pass #1
 
-  // disable z-writing
-  GLboolean depth_mask=0;
-  glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+  // disable z-writing, the write masks are shadowed by the OpenGLContext to avoid glGet*() stalls
+  const bool depth_mask = gl_context->currentDepthMask();
   glDepthMask(GL_FALSE);
 
   // background
@@ -105,19 +104,44 @@ void CoreText::render_Implementation(const Actor* actor, const Shader*, const Ca
 
   // to have the most correct results we should render the text twice one for color and stencil, the other for the z-buffer
 
-  // shadow render
-  if (shadowEnabled())
-    renderText( actor, camera, shadowColor(), shadowVector() );
-  // outline render
-  if (outlineEnabled())
+  // signed distance field fonts compute shadow, outline and text in a single pass
+  const GLSLProgram* sdf_program = font()->signedDistanceField() && Has_GL_Version_3_0 ? mFont->signedDistanceFieldProgram() : NULL;
+  if (sdf_program)
   {
-    renderText( actor, camera, outlineColor(), fvec2(-1,0) );
-    renderText( actor, camera, outlineColor(), fvec2(+1,0) );
-    renderText( actor, camera, outlineColor(), fvec2(0,-1) );
-    renderText( actor, camera, outlineColor(), fvec2(0,+1) );
+    gl_context->useGLSLProgram(sdf_program);
+
+    const fvec4 outline_color = outlineEnabled() ? outlineColor() : fvec4(0,0,0,0);
+    const fvec4 shadow_color  = shadowEnabled()  ? shadowColor()  : fvec4(0,0,0,0);
+    // 1 pixel outline, in distance field units
+    const float outline_width = 1.0f / (2.0f * font()->signedDistanceFieldSpread());
+
+    glUniform1i( sdf_program->getUniformLocation("vl_SDFTexture"), 0 );
+    glUniform1f( sdf_program->getUniformLocation("vl_SDFOutlineWidth"), outline_width );
+    glUniform4fv( sdf_program->getUniformLocation("vl_SDFOutlineColor"), 1, outline_color.ptr() );
+    glUniform2fv( sdf_program->getUniformLocation("vl_SDFShadowOffset"), 1, shadowVector().ptr() );
+    glUniform4fv( sdf_program->getUniformLocation("vl_SDFShadowColor"), 1, shadow_color.ptr() );
+
+    renderText( actor, camera, color(), fvec2(0,0) );
+
+    // restore the Shader's GLSLProgram
+    gl_context->useGLSLProgram( shader ? shader->glslProgram() : NULL );
+  }
+  else
+  {
+    // shadow render
+    if (shadowEnabled())
+      renderText( actor, camera, shadowColor(), shadowVector() );
+    // outline render
+    if (outlineEnabled())
+    {
+      renderText( actor, camera, outlineColor(), fvec2(-1,0) );
+      renderText( actor, camera, outlineColor(), fvec2(+1,0) );
+      renderText( actor, camera, outlineColor(), fvec2(0,-1) );
+      renderText( actor, camera, outlineColor(), fvec2(0,+1) );
+    }
+    // text render
+    renderText( actor, camera, color(), fvec2(0,0) );
   }
-  // text render
-  renderText( actor, camera, color(), fvec2(0,0) );
 
   // Pass #2
   // fills the z-buffer (not the stencil buffer): approximated to the text bbox
@@ -128,16 +152,12 @@ void CoreText::render_Implementation(const Actor* actor, const Shader*, const Ca
   if (depth_mask)
   {
     // disables writing to the color buffer
-    GLboolean color_mask[4];
-    glGetBooleanv(GL_COLOR_WRITEMASK, color_mask);
+    const ubvec4 color_mask = gl_context->currentColorMask();
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
     // disable writing to the stencil buffer
-    int stencil_front_mask=0;
-    glGetIntegerv(GL_STENCIL_WRITEMASK, &stencil_front_mask);
-    int stencil_back_mask=0;
-    if (Has_GL_Version_2_0)
-      glGetIntegerv(GL_STENCIL_BACK_WRITEMASK, &stencil_back_mask);
+    unsigned int stencil_front_mask = 0, stencil_back_mask = 0;
+    gl_context->currentStencilMask(stencil_front_mask, stencil_back_mask);
     glStencilMask(0);
 
     // background
@@ -147,7 +167,7 @@ void CoreText::render_Implementation(const Actor* actor, const Shader*, const Ca
     renderBorder( actor, camera );
 
     // restores color writing
-    glColorMask(color_mask[0],color_mask[1],color_mask[2],color_mask[3]);
+    glColorMask(color_mask.r(),color_mask.g(),color_mask.b(),color_mask.a());
 
     // restore the stencil masks
     glStencilMask(stencil_front_mask);
@@ -156,23 +176,14 @@ void CoreText::render_Implementation(const Actor* actor, const Shader*, const Ca
   }
 }
 //-----------------------------------------------------------------------------
-void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const fvec2& offset) const
+void CoreText::updateGlyphLayout() const
 {
-  if(!mFont)
-  {
-    Log::error("CoreText::renderText() error: no Font assigned to the CoreText object.\n");
-    VL_TRAP()
+  if ( ! mGlyphLayoutDirty && mGlyphLayoutFont == mFont.get() && mGlyphLayoutFontVersion == mFont->glyphCacheVersion() )
     return;
-  }
 
-  if (!font()->mFT_Face)
-  {
-    Log::error("CoreText::renderText() error: invalid FT_Face: probably you tried to load an unsupported font format.\n");
-    VL_TRAP()
-    return;
-  }
-
-  // mic fixme: these should be pre-computed when the text is set!!!
+  mGlyphVerts.clear();
+  mGlyphTexCoords.clear();
+  mGlyphBatches.clear();
 
   AABB rbbox = rawboundingRect( text() ); // for text alignment
   VL_CHECK(rbbox.maxCorner().z() == 0)
@@ -182,36 +193,19 @@ void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const
   VL_CHECK(bbox.maxCorner().z() == 0)
   VL_CHECK(bbox.minCorner().z() == 0)
 
-  // basic render states
-
-  // mic fixme: detect GLSLProgram and use VertexAttribPointer if present.
+  // glyph quads grouped by atlas texture
+  std::map< unsigned int, std::vector<fvec2> > verts;
+  std::map< unsigned int, std::vector<fvec2> > texcs;
 
-  float texc[] = { 0,0,0,0,0,0,0,0 };
-  VL_glActiveTexture( GL_TEXTURE0 );
-  VL_glClientActiveTexture( GL_TEXTURE0 );
-  glEnable(GL_TEXTURE_2D);
-  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-  glTexCoordPointer(2, GL_FLOAT, 0, texc);
-
-  // color
-  glColor4fv(color.ptr());
-
-  // Constant normal
-  glNormal3fv( fvec3(0,0,1).ptr() );
+  fvec2 pen(0,0);
+  fvec2 vect[4];
 
-  fvec3 vect[4];
-  glEnableClientState( GL_VERTEX_ARRAY );
-  glVertexPointer(3, GL_FLOAT, 0, vect[0].ptr());
+  // transparent margin around the glyph images
+  const float gm = (float)mFont->glyphMargin();
 
   FT_Long use_kerning = FT_HAS_KERNING( font()->mFT_Face );
   FT_UInt previous = 0;
 
-  fvec2 pen(0,0);
-
-  // mic fixme:
-  // - lines split and lines dimensions (linebox) should be precomputed on text set!
-  // - or convert this function to generate a pre-computed rendering-list!
-
   // split the text in different lines
 
   VL_CHECK(text().length())
@@ -315,73 +309,38 @@ void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const
 
       if (glyph->textureHandle())
       {
-        glBindTexture( GL_TEXTURE_2D, glyph->textureHandle() );
-
-        texc[0] = glyph->s0();
-        texc[1] = glyph->t1();
-        texc[2] = glyph->s1();
-        texc[3] = glyph->t1();
-        texc[4] = glyph->s1();
-        texc[5] = glyph->t0();
-        texc[6] = glyph->s0();
-        texc[7] = glyph->t0();
-
         int left = layout() == RightToLeftText ? -glyph->left() : +glyph->left();
 
-        vect[0].x() = pen.x() + glyph->width()*0 + left -1;
-        vect[0].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() -1;
+        // quad layout
 
-        vect[1].x() = pen.x() + glyph->width()*1 + left +1;
-        vect[1].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() -1;
+        vect[0].x() = pen.x() + glyph->width()*0 + left - gm;
+        vect[0].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() - gm;
 
-        vect[2].x() = pen.x() + glyph->width()*1 + left +1;
-        vect[2].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() +1;
+        vect[1].x() = pen.x() + glyph->width()*1 + left + gm;
+        vect[1].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() - gm;
 
-        vect[3].x() = pen.x() + glyph->width()*0 + left -1;
-        vect[3].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() +1;
+        vect[2].x() = pen.x() + glyph->width()*1 + left + gm;
+        vect[2].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() + gm;
 
-        if (layout() == RightToLeftText)
-        {
-          vect[0].x() -= glyph->width()-1 +2;
-          vect[1].x() -= glyph->width()-1 +2;
-          vect[2].x() -= glyph->width()-1 +2;
-          vect[3].x() -= glyph->width()-1 +2;
-        }
+        vect[3].x() = pen.x() + glyph->width()*0 + left - gm;
+        vect[3].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() + gm;
 
-        vect[0].y() -= mFont->mHeight;
-        vect[1].y() -= mFont->mHeight;
-        vect[2].y() -= mFont->mHeight;
-        vect[3].y() -= mFont->mHeight;
-
-        // normalize coordinate orgin to the bottom/left corner
-        vect[0] -= (fvec3)bbox.minCorner();
-        vect[1] -= (fvec3)bbox.minCorner();
-        vect[2] -= (fvec3)bbox.minCorner();
-        vect[3] -= (fvec3)bbox.minCorner();
-
-        // margin & horz_text_align
-        vect[0].x() += margin() + horz_text_align;
-        vect[0].y() += margin();
-        vect[1].x() += margin() + horz_text_align;
-        vect[1].y() += margin();
-        vect[2].x() += margin() + horz_text_align;
-        vect[2].y() += margin();
-        vect[3].x() += margin() + horz_text_align;
-        vect[3].y() += margin();
-
-        // apply offset for outline rendering
-        vect[0].x() += offset.x();
-        vect[0].y() += offset.y();
-        vect[1].x() += offset.x();
-        vect[1].y() += offset.y();
-        vect[2].x() += offset.x();
-        vect[2].y() += offset.y();
-        vect[3].x() += offset.x();
-        vect[3].y() += offset.y();
-
-        // text pivot
         for(int i=0; i<4; ++i)
         {
+          if (layout() == RightToLeftText)
+            vect[i].x() -= glyph->width()-1 + 2*gm;
+
+          vect[i].y() -= mFont->mHeight;
+
+          // normalize coordinate orgin to the bottom/left corner
+          vect[i].x() -= (float)bbox.minCorner().x();
+          vect[i].y() -= (float)bbox.minCorner().y();
+
+          // margin & horz_text_align
+          vect[i].x() += margin() + horz_text_align;
+          vect[i].y() += margin();
+
+          // text pivot
           if (textOrigin() & AlignHCenter)
           {
             VL_CHECK( !(textOrigin() & AlignRight) )
@@ -411,15 +370,14 @@ void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const
           }
         }
 
-        glDrawArrays(GL_QUADS, 0, 4);
+        std::vector<fvec2>& batch_verts = verts[glyph->textureHandle()];
+        std::vector<fvec2>& batch_texcs = texcs[glyph->textureHandle()];
 
-        #if (0)
-          glDisable(GL_TEXTURE_2D);
-          glColor3fv(vec3(1,0,0).ptr());
-          glDrawArrays(GL_LINE_LOOP, 0, 4);
-          glColor4fv(color.ptr());
-          glEnable(GL_TEXTURE_2D);
-        #endif
+        batch_verts.insert( batch_verts.end(), vect, vect+4 );
+        batch_texcs.push_back( fvec2(glyph->s0(), glyph->t1()) );
+        batch_texcs.push_back( fvec2(glyph->s1(), glyph->t1()) );
+        batch_texcs.push_back( fvec2(glyph->s1(), glyph->t0()) );
+        batch_texcs.push_back( fvec2(glyph->s0(), glyph->t0()) );
       }
 
       if (just_space && lines[iline][c] == ' ' && iline != lines.size()-1)
@@ -454,9 +412,86 @@ void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const
     }
   }
 
+  // concatenate the batches in a single vertex array
+  std::map< unsigned int, std::vector<fvec2> >::const_iterator it = verts.begin();
+  for( ; it != verts.end(); ++it )
+  {
+    const std::vector<fvec2>& batch_texcs = texcs[it->first];
+    mGlyphBatches.push_back( GlyphBatch(it->first, (int)mGlyphVerts.size(), (int)it->second.size()) );
+    mGlyphVerts.insert( mGlyphVerts.end(), it->second.begin(), it->second.end() );
+    mGlyphTexCoords.insert( mGlyphTexCoords.end(), batch_texcs.begin(), batch_texcs.end() );
+  }
+
+  mGlyphLayoutDirty = false;
+  mGlyphLayoutFont = mFont.get();
+  mGlyphLayoutFontVersion = mFont->glyphCacheVersion();
+}
+//-----------------------------------------------------------------------------
+void CoreText::renderText(const Actor*, const Camera*, const fvec4& color, const fvec2& offset) const
+{
+  if(!mFont)
+  {
+    Log::error("CoreText::renderText() error: no Font assigned to the CoreText object.\n");
+    VL_TRAP()
+    return;
+  }
+
+  if (!font()->mFT_Face)
+  {
+    Log::error("CoreText::renderText() error: invalid FT_Face: probably you tried to load an unsupported font format.\n");
+    VL_TRAP()
+    return;
+  }
+
+  updateGlyphLayout();
+
+  if (mGlyphBatches.empty())
+    return;
+
+  // apply offset for outline rendering
+  const bool has_offset = offset.x() != 0 || offset.y() != 0;
+  if (has_offset)
+  {
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glTranslatef(offset.x(), offset.y(), 0);
+  }
+
+  // basic render states
+
+  // mic fixme: detect GLSLProgram and use VertexAttribPointer if present.
+
+  VL_glActiveTexture( GL_TEXTURE0 );
+  VL_glClientActiveTexture( GL_TEXTURE0 );
+  glEnable(GL_TEXTURE_2D);
+  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+  glTexCoordPointer(2, GL_FLOAT, 0, mGlyphTexCoords[0].ptr());
+
+  // color
+  glColor4fv(color.ptr());
+
+  // Constant normal
+  glNormal3fv( fvec3(0,0,1).ptr() );
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glVertexPointer(2, GL_FLOAT, 0, mGlyphVerts[0].ptr());
+
+  // one draw call per atlas texture
+  for(size_t i=0; i<mGlyphBatches.size(); ++i)
+  {
+    glBindTexture( GL_TEXTURE_2D, mGlyphBatches[i].mTexture );
+    glDrawArrays( GL_QUADS, mGlyphBatches[i].mStart, mGlyphBatches[i].mCount );
+  }
+
   glDisableClientState( GL_VERTEX_ARRAY );
   glDisableClientState( GL_TEXTURE_COORD_ARRAY );
 
+  if (has_offset)
+  {
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+  }
+
   VL_CHECK_OGL();
 
   glDisable(GL_TEXTURE_2D);
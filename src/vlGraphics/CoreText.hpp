@@ -51,7 +51,8 @@ namespace vl
   public:
     CoreText(): mColor(1,1,1,1), mBorderColor(0,0,0,1), mBackgroundColor(1,1,1,1), mOutlineColor(0,0,0,1), mShadowColor(0,0,0,0.5f), mShadowVector(2,-2),
       mTextOrigin(AlignBottom|AlignLeft), mMargin(5), mLayout(LeftToRightText), mTextAlignment(TextAlignLeft),
-      mBorderEnabled(false), mBackgroundEnabled(false), mOutlineEnabled(false), mShadowEnabled(false), mKerningEnabled(true)
+      mBorderEnabled(false), mBackgroundEnabled(false), mOutlineEnabled(false), mShadowEnabled(false), mKerningEnabled(true),
+      mGlyphLayoutDirty(true), mGlyphLayoutFont(NULL), mGlyphLayoutFontVersion(0)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -59,7 +60,7 @@ namespace vl
     //! The text to be rendered.
     const String& text() const { return mText; }
     //! The text to be rendered.
-    void setText(const String& text) { mText = text; }
+    void setText(const String& text) { mText = text; mGlyphLayoutDirty = true; }
 
     //! The color of the text.
     const fvec4& color() const { return mColor; }
@@ -69,7 +70,7 @@ namespace vl
     //! The margin to be left around the text.
     int margin() const { return mMargin; }
     //! The margin to be left around the text.
-    void setMargin(int margin) { mMargin = margin; }
+    void setMargin(int margin) { mMargin = margin; mGlyphLayoutDirty = true; }
 
     //! The font to be used to render the text.
     const Font* font() const { return mFont.get(); }
@@ -81,22 +82,22 @@ namespace vl
     //! Text layout: left to right, right to left.
     ETextLayout layout() const { return mLayout; }
     //! Text layout: left to right, right to left.
-    void setLayout(ETextLayout layout) { mLayout = layout; }
+    void setLayout(ETextLayout layout) { mLayout = layout; mGlyphLayoutDirty = true; }
 
     //! Text alignment: left, right, center, justify.
     ETextAlign textAlignment() const { return mTextAlignment; }
     //! Text alignment: left, right, center, justify.
-    void setTextAlignment(ETextAlign align) { mTextAlignment = align; }
+    void setTextAlignment(ETextAlign align) { mTextAlignment = align; mGlyphLayoutDirty = true; }
 
     //! The origin of the text (pivot point for offsetting and rotations).
     int  textOrigin() const { return mTextOrigin; }
     //! The origin of the text (pivot point for offsetting and rotations).
-    void setTextOrigin(int align) { mTextOrigin = align; }
+    void setTextOrigin(int align) { mTextOrigin = align; mGlyphLayoutDirty = true; }
 
     //! If enabled text rendering uses kerning information for better quality results (slower).
     bool kerningEnabled() const { return mKerningEnabled; }
     //! If enabled text rendering uses kerning information for better quality results (slower).
-    void setKerningEnabled(bool kerning) { mKerningEnabled = kerning; }
+    void setKerningEnabled(bool kerning) { mKerningEnabled = kerning; mGlyphLayoutDirty = true; }
 
     //! If true draws a rectangular border around the text.
     bool borderEnabled() const { return mBorderEnabled; }
@@ -159,6 +160,17 @@ namespace vl
     virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
     void computeBounds_Implementation() { setBoundingBox(AABB()); setBoundingSphere(Sphere()); }
 
+    //! A range of glyph quads sharing the same atlas texture.
+    struct GlyphBatch
+    {
+      GlyphBatch(unsigned int texture, int start, int count): mTexture(texture), mStart(start), mCount(count) {}
+      unsigned int mTexture;
+      int mStart;
+      int mCount;
+    };
+
+    //! Lays out the glyph quads in a single vertex array, only if the text, font or layout parameters changed.
+    void updateGlyphLayout() const;
     void renderText(const Actor*, const Camera* camera, const fvec4& color, const fvec2& offset) const;
     void renderBackground(const Actor* actor, const Camera* camera) const;
     void renderBorder(const Actor* actor, const Camera* camera) const;
@@ -182,6 +194,13 @@ namespace vl
     bool mOutlineEnabled;
     bool mShadowEnabled;
     bool mKerningEnabled;
+    // cached glyph layout
+    mutable std::vector<fvec2> mGlyphVerts;
+    mutable std::vector<fvec2> mGlyphTexCoords;
+    mutable std::vector<GlyphBatch> mGlyphBatches;
+    mutable bool mGlyphLayoutDirty;
+    mutable const Font* mGlyphLayoutFont;
+    mutable unsigned int mGlyphLayoutFontVersion;
   };
 }
 
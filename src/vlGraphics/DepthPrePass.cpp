@@ -0,0 +1,178 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/DepthPrePass.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/OpenGL.hpp>
+
+using namespace vl;
+
+namespace
+{
+  const char* DepthVertexShader =
+    "#version 150\n"
+    "in vec4 vl_VertexPosition;\n"
+    "uniform mat4 vl_ModelViewProjectionMatrix;\n"
+    "invariant gl_Position;\n"
+    "void main(void)\n"
+    "{\n"
+    "  gl_Position = vl_ModelViewProjectionMatrix * vl_VertexPosition;\n"
+    "}\n";
+
+  const char* DepthFragmentShader =
+    "#version 150\n"
+    "void main(void)\n"
+    "{\n"
+    "}\n";
+}
+
+//-----------------------------------------------------------------------------
+DepthPrePass::DepthPrePass(): mEnabled(true), mEnableMask(0xFFFFFFFF), mStatsPrePassObjects(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+
+  mDepthShader = new Shader;
+  mDepthShader->setObjectName("DepthPrePass");
+  mDepthShader->enable(EN_DEPTH_TEST);
+  mDepthShader->gocColorMask()->set(false, false, false, false);
+
+  mMainDepthFunc = new DepthFunc(FU_EQUAL);
+  mMainDepthMask = new DepthMask(false);
+
+  mRenderer = new Renderer;
+  mRenderer->shaderOverrideMask()[0xFFFFFFFF] = mDepthShader;
+
+  mPrePassQueue = new RenderQueue;
+  mMainQueue = new RenderQueue;
+  mSorter = new RenderQueueSorterOcclusion;
+}
+//-----------------------------------------------------------------------------
+bool DepthPrePass::isCompatible(const RenderToken* tok) const
+{
+  if ( !( tok->mActor->enableMask() & mEnableMask ) )
+    return false;
+
+  const Shader* shader = tok->mShader;
+  if ( !shader->isEnabled(EN_DEPTH_TEST) || shader->isBlendingEnabled() || shader->isEnabled(EN_ALPHA_TEST) ||
+       shader->isEnabled(EN_POLYGON_OFFSET_FILL) || shader->scissor() || shader->getColorMask() )
+    return false;
+
+  if ( shader->getDepthMask() && !shader->getDepthMask()->depthMask() )
+    return false;
+
+  const DepthFunc* depth_func = shader->getDepthFunc();
+  if ( depth_func && depth_func->depthFunc() != FU_LESS && depth_func->depthFunc() != FU_LEQUAL )
+    return false;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+Shader* DepthPrePass::mainShader(Shader* shader)
+{
+  ref<Shader>& main_shader = mUsedMainShaders[shader];
+  if ( main_shader )
+    return main_shader.get();
+
+  // reuse the Shader created the previous frames, refreshed as the original might have changed
+  std::map< const Shader*, ref<Shader> >::iterator it = mMainShaders.find(shader);
+  main_shader = it != mMainShaders.end() ? it->second : new Shader;
+
+  // share the enables and uniforms, copy the render states replacing the depth function and mask
+  main_shader->setEnableSet( shader->getEnableSet() );
+  main_shader->setUniformSet( shader->getUniformSet() );
+  main_shader->eraseAllRenderStates();
+  if ( shader->getRenderStateSet() )
+  {
+    for( size_t i=0; i<shader->getRenderStateSet()->renderStatesCount(); ++i )
+    {
+      RenderStateSlot& slot = shader->getRenderStateSet()->renderStates()[i];
+      if ( slot.type() != RS_DepthFunc && slot.type() != RS_DepthMask )
+        main_shader->setRenderState( slot.mRS.get(), slot.mIndex );
+    }
+  }
+  main_shader->setRenderState( mMainDepthFunc.get() );
+  main_shader->setRenderState( mMainDepthMask.get() );
+
+  return main_shader.get();
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* DepthPrePass::render(const RenderQueue* render_queue, Renderer* renderer, Camera* camera, real frame_clock)
+{
+  mStatsPrePassObjects = 0;
+  mPrePassQueue->clear();
+  mMainQueue->clear();
+  mUsedMainShaders.clear();
+
+  // the depth-only program, linked the first time a GLSL capable context is seen
+  if ( Has_GLSL && !mDepthShader->glslProgram() )
+  {
+    GLSLProgram* program = mDepthShader->gocGLSLProgram();
+    program->setObjectName("DepthPrePass");
+    program->attachShader( new GLSLVertexShader(DepthVertexShader) );
+    program->attachShader( new GLSLFragmentShader(DepthFragmentShader) );
+  }
+  if ( mDepthShader->glslProgram() && !mDepthShader->glslProgram()->linked() )
+    mDepthShader->getGLSLProgram()->linkProgram();
+
+  // split the queue: the main queue keeps the original order
+
+  for(int i=0; i<render_queue->size(); ++i)
+  {
+    const RenderToken* tok = render_queue->at(i);
+    RenderToken* main_tok = mMainQueue->newToken(false);
+    *main_tok = *tok;
+
+    if ( !isCompatible(tok) )
+      continue;
+
+    RenderToken* pre_tok = mPrePassQueue->newToken(false);
+    *pre_tok = *tok;
+    pre_tok->mNextPass = NULL;
+
+    main_tok->mShader = mainShader( const_cast<Shader*>(tok->mShader) );
+  }
+
+  mMainShaders.swap( mUsedMainShaders );
+  mStatsPrePassObjects = mPrePassQueue->size();
+
+  // depth pre-pass, front-to-back, performing the clearing of the renderer
+
+  mPrePassQueue->sort( mSorter.get(), camera );
+  mRenderer->setFramebuffer( renderer->framebuffer() );
+  mRenderer->setClearFlags( renderer->clearFlags() );
+  mRenderer->setEnableMask( renderer->enableMask() );
+  mRenderer->setProfiler( renderer->profiler() );
+  mRenderer->render( mPrePassQueue.get(), camera, frame_clock );
+
+  return mMainQueue.get();
+}
+//-----------------------------------------------------------------------------
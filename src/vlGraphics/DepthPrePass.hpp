@@ -0,0 +1,115 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef DepthPrePass_INCLUDE_ONCE
+#define DepthPrePass_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/RenderQueueSorter.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <map>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // DepthPrePass
+  //------------------------------------------------------------------------------
+  /** Renders the depth of the opaque objects of a Rendering before the Rendering's Renderer[s] run, so that the expensive
+    * fragment shaders are executed only once per pixel.
+    *
+    * Install it with Rendering::setDepthPrePass(). The pre-pass renders the compatible RenderToken[s] front-to-back with
+    * the depthShader(), a trivial depth-only Shader installed as shader override (see Renderer::shaderOverrideMask()) of an
+    * internal Renderer targeting the same Framebuffer and performing the clearing of the first Renderer of the Rendering.
+    * The Renderer[s] then draw the compatible RenderToken[s] with the depth test set to depthFunc() and depth writes disabled,
+    * the other RenderToken[s] are drawn unchanged.
+    *
+    * A RenderToken is compatible if its Actor enable mask matches enableMask() and its first pass Shader enables the depth
+    * test, does not enable blending, alpha test or polygon offset, has no Scissor, ColorMask or disabled DepthMask,
+    * and its DepthFunc, if any, is \p FU_LESS or \p FU_LEQUAL.
+    *
+    * \note The depthShader() computes \p gl_Position as \p vl_ModelViewProjectionMatrix * \p vl_VertexPosition. The Actor[s]
+    * whose shaders displace the vertices or discard fragments must be excluded with enableMask(). With \p FU_EQUAL
+    * (the default) the position must be computed by the same expression in the Actor's own shader, otherwise set
+    * depthFunc() to \p FU_LEQUAL.
+    * \sa Rendering::setDepthPrePass(), RenderQueueSorterStandard::setFrontToBack() */
+  class VLGRAPHICS_EXPORT DepthPrePass: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::DepthPrePass, Object)
+
+  public:
+    DepthPrePass();
+
+    //! Enables or disables the depth pre-pass (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! Only the Actor[s] whose enable mask matches this mask take part to the depth pre-pass (default = 0xFFFFFFFF).
+    void setEnableMask(unsigned int mask) { mEnableMask = mask; }
+    unsigned int enableMask() const { return mEnableMask; }
+
+    //! The depth function used by the Renderer[s] for the pre-rendered objects (default = FU_EQUAL).
+    void setDepthFunc(EFunction func) { mMainDepthFunc->set(func); }
+    EFunction depthFunc() const { return mMainDepthFunc->depthFunc(); }
+
+    //! The depth-only Shader used to render the pre-pass.
+    Shader* depthShader() { return mDepthShader.get(); }
+
+    //! Number of RenderToken[s] rendered by the last pre-pass.
+    int statsPrePassObjects() const { return mStatsPrePassObjects; }
+
+    /** Renders the depth pre-pass of \p render_queue using the Framebuffer and the clear flags of \p renderer and returns
+      * the queue to be rendered by the Renderer[s] in place of \p render_queue. Called by Rendering::render(). */
+    const RenderQueue* render(const RenderQueue* render_queue, Renderer* renderer, Camera* camera, real frame_clock);
+
+  protected:
+    bool isCompatible(const RenderToken* tok) const;
+    Shader* mainShader(Shader* shader);
+
+  protected:
+    ref<Renderer> mRenderer;
+    ref<Shader> mDepthShader;
+    ref<DepthFunc> mMainDepthFunc;
+    ref<DepthMask> mMainDepthMask;
+    ref<RenderQueue> mPrePassQueue;
+    ref<RenderQueue> mMainQueue;
+    ref<RenderQueueSorterOcclusion> mSorter;
+    std::map< const Shader*, ref<Shader> > mMainShaders;
+    std::map< const Shader*, ref<Shader> > mUsedMainShaders;
+    bool mEnabled;
+    unsigned int mEnableMask;
+    int mStatsPrePassObjects;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
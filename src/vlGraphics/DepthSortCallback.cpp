@@ -0,0 +1,311 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/DepthSortCallback.hpp>
+#include <vlCore/glsl_math.hpp>
+#include <vlCore/TransformKernels.hpp>
+#include <cstring>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+DepthSortCallback::DepthSortCallback()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mCacheRenderable = NULL;
+  mSortMode = SM_SortBackToFront;
+  mSortTolerance = 0;
+  mClusterSize = 0;
+  mThreadCount = 1;
+}
+//-----------------------------------------------------------------------------
+void DepthSortCallback::onActorRenderStarted(Actor* actor, real /*frame_clock*/, const Camera* cam, Renderable* renderable, const Shader*, int pass)
+{
+  // need to sort only for the first pass
+  if (pass > 0)
+    return;
+
+  // this works well with LOD
+  Geometry* geometry = renderable->as<Geometry>();
+
+  if (!geometry)
+    return;
+
+  const ArrayAbstract* verts = geometry->vertexArray();
+
+  if (!verts)
+    return;
+
+  mat4 m = cam->viewMatrix();
+  if (actor && actor->transform())
+    m = m * actor->transform()->worldMatrix();
+
+  // the eye-space Z of a vertex is the dot product of its object space position with the third row of the
+  // modelview matrix plus a constant, which does not affect the order: only the row direction matters.
+  fvec3 view_z( (float)m.e(2,0), (float)m.e(2,1), (float)m.e(2,2) );
+  fvec3 direction = view_z;
+  float length = 0;
+  direction.normalize(&length);
+  if (length == 0)
+    return;
+
+  if (renderable == mCacheRenderable)
+  {
+    if ( sortTolerance() <= 0 )
+    {
+      if (direction == mCacheDirection)
+        return;
+    }
+    else
+    if ( dot(direction, mCacheDirection) >= cos( sortTolerance() * dDEG_TO_RAD ) )
+      return;
+  }
+  mCacheRenderable = renderable;
+  mCacheDirection = direction;
+
+  // computes eye-space vertex depths, clusters use their precomputed centers instead
+  if (clusterSize() == 0)
+  {
+    const int count = (int)verts->size();
+    mEyeSpaceZ.resize( count );
+    const ArrayFloat3* verts3f = verts->as<ArrayFloat3>();
+    if (verts3f)
+    {
+      const fvec3* v = verts3f->begin();
+      // blocks of vertices processed by the batched kernel, a multiple of 4 to keep the SIMD path busy
+      const int block = 4096;
+#ifdef _OPENMP
+      #pragma omp parallel for num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+      for(int i=0; i<count; i+=block)
+        dotProducts(view_z, v+i, &mEyeSpaceZ[i], std::min(block, count-i));
+    }
+    else
+    {
+#ifdef _OPENMP
+      #pragma omp parallel for num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+      for(int i=0; i<count; ++i)
+      {
+        vec3 v = verts->getAsVec3(i);
+        mEyeSpaceZ[i] = (float)(view_z.x()*v.x() + view_z.y()*v.y() + view_z.z()*v.z());
+      }
+    }
+  }
+
+  geometry->setBufferObjectDirty(true);
+  geometry->setDisplayListDirty(true);
+
+  for(int idraw=0; idraw<geometry->drawCalls().size(); ++idraw)
+  {
+    DrawCall* dc = geometry->drawCalls().at(idraw);
+    if (dc->classType() == DrawElementsUInt::Type())
+      sort(dc->as<DrawElementsUInt>(), idraw, verts, view_z);
+    else
+    if (dc->classType() == DrawElementsUShort::Type())
+      sort(dc->as<DrawElementsUShort>(), idraw, verts, view_z);
+    else
+    if (dc->classType() == DrawElementsUByte::Type())
+      sort(dc->as<DrawElementsUByte>(), idraw, verts, view_z);
+  }
+}
+//-----------------------------------------------------------------------------
+template<typename deT>
+void DepthSortCallback::sort(deT* polys, int idraw, const ArrayAbstract* verts, const fvec3& view_z)
+{
+  typedef typename deT::index_type index_type;
+
+  int prim_size = 0;
+  switch(polys->primitiveType())
+  {
+    case PT_POINTS:    prim_size = 1; break;
+    case PT_LINES:     prim_size = 2; break;
+    case PT_TRIANGLES: prim_size = 3; break;
+    case PT_QUADS:     prim_size = 4; break;
+    default:
+      return;
+  }
+
+  index_type* indices = (index_type*)polys->indexBuffer()->ptr();
+  const size_t index_count = polys->indexBuffer()->size();
+  const int prim_count = (int)(index_count / prim_size);
+  const size_t prim_bytes = prim_size * sizeof(index_type);
+  if (prim_count < 2)
+    return;
+
+  if (clusterSize() > 0)
+  {
+    // the clusters are defined on the index buffer as found at the first sorting
+    if ((int)mClusterCaches.size() <= idraw)
+      mClusterCaches.resize(idraw+1);
+    ClusterCache& cache = mClusterCaches[idraw];
+    const int cluster_count = (prim_count + clusterSize() - 1) / clusterSize();
+    if (cache.mDrawCall != polys || cache.mIndexCount != index_count)
+    {
+      cache.mDrawCall = polys;
+      cache.mIndexCount = index_count;
+      cache.mOriginalIndices.assign( (const unsigned char*)indices, (const unsigned char*)indices + prim_count * prim_bytes );
+      cache.mCenters.resize( cluster_count );
+      for(int c=0; c<cluster_count; ++c)
+      {
+        const int first = c * prim_size * clusterSize();
+        const int last  = vl::min( first + prim_size * clusterSize(), prim_count * prim_size );
+        vec3 center;
+        for(int i=first; i<last; ++i)
+          center += verts->getAsVec3( indices[i] );
+        cache.mCenters[c] = (fvec3)( center / (real)(last - first) );
+      }
+    }
+
+    mPrimitiveZ.resize( cluster_count );
+    for(int c=0; c<cluster_count; ++c)
+      mPrimitiveZ[c] = dot( view_z, cache.mCenters[c] );
+
+    radixSort();
+
+    // concatenates the clusters in depth order
+    const unsigned char* src = &cache.mOriginalIndices[0];
+    unsigned char* dst = (unsigned char*)indices;
+    for(int i=0; i<cluster_count; ++i)
+    {
+      const int first = mOrder[i] * clusterSize();
+      const int count = vl::min( clusterSize(), prim_count - first );
+      memcpy( dst, src + first * prim_bytes, count * prim_bytes );
+      dst += count * prim_bytes;
+    }
+  }
+  else
+  {
+    // compute zetas
+    mPrimitiveZ.resize( prim_count );
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+    for(int p=0; p<prim_count; ++p)
+    {
+      const index_type* prim = indices + p * prim_size;
+      float z = 0;
+      for(int k=0; k<prim_size; ++k)
+        z += mEyeSpaceZ[ prim[k] ];
+      mPrimitiveZ[p] = z;
+    }
+
+    radixSort();
+
+    // regenerate the sorted indices
+    mSortedIndices.resize( prim_count * prim_bytes );
+    index_type* sorted = (index_type*)&mSortedIndices[0];
+#ifdef _OPENMP
+    #pragma omp parallel for num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
+    for(int i=0; i<prim_count; ++i)
+    {
+      const index_type* src = indices + mOrder[i] * prim_size;
+      index_type* dst = sorted + i * prim_size;
+      for(int k=0; k<prim_size; ++k)
+        dst[k] = src[k];
+    }
+    memcpy( indices, sorted, prim_count * prim_bytes );
+  }
+
+  updateIndexBuffer( polys->indexBuffer() );
+}
+//-----------------------------------------------------------------------------
+void DepthSortCallback::radixSort()
+{
+  const int count = (int)mPrimitiveZ.size();
+  mKeys.resize( count );
+  mOrder.resize( count );
+  mOrderTmp.resize( count );
+
+  float zmin = mPrimitiveZ[0];
+  float zmax = mPrimitiveZ[0];
+  for(int i=1; i<count; ++i)
+  {
+    zmin = vl::min( zmin, mPrimitiveZ[i] );
+    zmax = vl::max( zmax, mPrimitiveZ[i] );
+  }
+
+  // quantize the depths to 16 bits, back to front means the most negative Z first
+  const float scale = zmax > zmin ? 65535.0f / (zmax - zmin) : 0.0f;
+  const bool back_to_front = sortMode() == SM_SortBackToFront;
+  unsigned int histogram[2][256];
+  memset( histogram, 0, sizeof(histogram) );
+  for(int i=0; i<count; ++i)
+  {
+    unsigned short key = (unsigned short)( (mPrimitiveZ[i] - zmin) * scale );
+    if (!back_to_front)
+      key = 65535 - key;
+    mKeys[i] = key;
+    ++histogram[0][ key & 0xFF ];
+    ++histogram[1][ key >> 8 ];
+  }
+
+  // exclusive prefix sums
+  unsigned int offset[2] = { 0, 0 };
+  for(int b=0; b<256; ++b)
+  {
+    for(int pass=0; pass<2; ++pass)
+    {
+      unsigned int n = histogram[pass][b];
+      histogram[pass][b] = offset[pass];
+      offset[pass] += n;
+    }
+  }
+
+  // two stable passes: primitives with the same key keep their previous order, which is frame coherent
+  for(int i=0; i<count; ++i)
+    mOrderTmp[ histogram[0][ mKeys[i] & 0xFF ]++ ] = i;
+  for(int i=0; i<count; ++i)
+  {
+    unsigned int p = mOrderTmp[i];
+    mOrder[ histogram[1][ mKeys[p] >> 8 ]++ ] = p;
+  }
+}
+//-----------------------------------------------------------------------------
+void DepthSortCallback::updateIndexBuffer(ArrayAbstract* index_buffer)
+{
+  if (Has_BufferObject)
+  {
+    if (index_buffer->bufferObject()->handle())
+    {
+      if (index_buffer->bufferObject()->usage() != vl::BU_DYNAMIC_DRAW)
+      {
+        index_buffer->bufferObject()->setBufferData(vl::BU_DYNAMIC_DRAW);
+        index_buffer->setBufferObjectDirty(false);
+      }
+      else
+        index_buffer->setBufferObjectDirty(true);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include <vlGraphics/Actor.hpp>
 #include <vlGraphics/Geometry.hpp>
 #include <vlGraphics/Camera.hpp>
+#include <vector>
 
 namespace vl
 {
@@ -51,6 +52,12 @@ namespace vl
    * Furthermore the use of DrawElements* and the primitive types PT_POINTS, PT_LINES, PT_TRIANGLES, PT_QUADS grants
    * the maximum flexibility.
    *
+   * The primitives are sorted by their eye-space Z, which only depends on the view direction expressed in object space:
+   * translating the camera or the Actor does not change the order, so the sorting is performed only when that direction
+   * changes by more than sortTolerance(). The Z values are computed in parallel when threadCount() is greater than 1 and
+   * the primitives are sorted using a radix sort on their quantized Z, which is linear in the number of primitives.
+   * For very large meshes setClusterSize() allows to sort fixed size chunks of primitives instead of single primitives.
+   *
    * \note
    *
    * - This callback works well with different LODs.
@@ -67,299 +74,91 @@ namespace vl
    *   then the polygons, lines or points of A will always be rendered before the ones specified by B. If you need the
    *   two sets of polygons to be correctly sorted with respect to one another you will need to merge them in one single
    *   draw call.
+   * - If the vertices or the indices of the Geometry are modified call invalidateCache().
    *
    * \sa \ref pagGuidePolygonDepthSorting
    */
-  class DepthSortCallback: public ActorEventCallback
+  class VLGRAPHICS_EXPORT DepthSortCallback: public ActorEventCallback
   {
     VL_INSTRUMENT_CLASS(vl::DepthSortCallback, ActorEventCallback)
 
-    template<typename T>
-    class Point
-    {
-    public:
-      T A;
-    };
-    template<typename T>
-    class Line
-    {
-    public:
-      T A,B;
-    };
-    template<typename T>
-    class Triangle
-    {
-    public:
-      T A,B,C;
-    };
-    template<typename T>
-    class Quad
+    // the original indices and the object space centers of the clusters of a draw call
+    class ClusterCache
     {
     public:
-      T A,B,C,D;
-    };
-    typedef Point<unsigned int>      PointUInt;
-    typedef Line<unsigned int>       LineUInt;
-    typedef Triangle<unsigned int>   TriangleUInt;
-    typedef Quad<unsigned int>       QuadUInt;
-
-    typedef Point<unsigned short>    PointUShort;
-    typedef Line<unsigned short>     LineUShort;
-    typedef Triangle<unsigned short> TriangleUShort;
-    typedef Quad<unsigned short>     QuadUShort;
-
-    typedef Point<unsigned char>     PointUByte;
-    typedef Line<unsigned char>      LineUByte;
-    typedef Triangle<unsigned char>  TriangleUByte;
-    typedef Quad<unsigned char>      QuadUByte;
-
-    class PrimitiveZ
-    {
-    public:
-      PrimitiveZ(int tri=0, float z=0.0f): mPrimitiveIndex(tri), mZ(z) {}
-      unsigned int mPrimitiveIndex;
-      float mZ;
-    };
-    class Sorter_Back_To_Front
-    {
-    public:
-      bool operator()(const PrimitiveZ& t1, const PrimitiveZ& t2) const { return t1.mZ < t2.mZ; }
-    };
-    class Sorter_Front_To_Back
-    {
-    public:
-      bool operator()(const PrimitiveZ& t1, const PrimitiveZ& t2) const { return t1.mZ > t2.mZ; }
+      ClusterCache(): mDrawCall(NULL), mIndexCount(0) {}
+      const DrawCall* mDrawCall;
+      size_t mIndexCount;
+      std::vector<unsigned char> mOriginalIndices;
+      std::vector<fvec3> mCenters;
     };
 
   public:
     //! Constructor.
-    DepthSortCallback()
-    {
-      VL_DEBUG_SET_OBJECT_NAME()
-      setSortMode(SM_SortBackToFront);
-    }
+    DepthSortCallback();
 
     void onActorDelete(Actor*) {}
 
     //! Performs the actual sorting
-    virtual void onActorRenderStarted(Actor* actor, real /*frame_clock*/, const Camera* cam, Renderable* renderable, const Shader*, int pass)
-    {
-      // need to sort only for the first pass
-      if (pass > 0)
-        return;
-
-      vl::mat4 matrix = cam->viewMatrix();
-      if (actor && actor->transform())
-        matrix *= actor->transform()->worldMatrix();
-
-      if (matrix == mCacheMatrix)
-        return;
-      else
-        mCacheMatrix = matrix;
-
-      // this works well with LOD
-      Geometry* geometry = renderable->as<Geometry>();
-
-      if (!geometry)
-        return;
-
-      const ArrayAbstract* verts = geometry->vertexArray();
-
-      if (!verts)
-        return;
-
-      // computes eye-space vertex positions
-      mat4 m;
-      if (actor->transform())
-        m = cam->viewMatrix() * actor->transform()->worldMatrix();
-      else
-        m = cam->viewMatrix();
-      mEyeSpaceVerts.resize( verts->size() );
-      // would be nice to optimize this with SEE2
-      for(size_t i=0; i<verts->size(); ++i)
-        mEyeSpaceVerts[i] = m * verts->getAsVec3(i);
-
-      geometry->setBufferObjectDirty(true);
-      geometry->setDisplayListDirty(true);
-
-      for(int idraw=0; idraw<geometry->drawCalls().size(); ++idraw)
-      {
-        DrawCall* dc = geometry->drawCalls().at(idraw);
-        if (dc->classType() == DrawElementsUInt::Type())
-          sort<unsigned int, DrawElementsUInt>(dc->as<DrawElementsUInt>(), mSortedPointsUInt, mSortedLinesUInt, mSortedTrianglesUInt, mSortedQuadsUInt);
-        else
-        if (dc->classType() == DrawElementsUShort::Type())
-          sort<unsigned short, DrawElementsUShort>(dc->as<DrawElementsUShort>(), mSortedPointsUShort, mSortedLinesUShort, mSortedTrianglesUShort, mSortedQuadsUShort);
-        else
-        if (dc->classType() == DrawElementsUByte::Type())
-          sort<unsigned char, DrawElementsUByte>(dc->as<DrawElementsUByte>(), mSortedPointsUByte, mSortedLinesUByte, mSortedTrianglesUByte, mSortedQuadsUByte);
-      }
-    }
-
-    template<typename T, typename deT>
-    void sort(deT* polys, std::vector<Point<T> >& sorted_points, std::vector<Line<T> >& sorted_lines, std::vector<Triangle<T> >& sorted_triangles, std::vector<Quad<T> >& sorted_quads)
-    {
-      if (polys->primitiveType() == PT_QUADS)
-      {
-        // compute zetas
-        mPrimitiveZ.resize( polys->indexBuffer()->size() / 4 );
-        if (mPrimitiveZ.empty())
-          return;
-
-        const typename deT::index_type* it  = polys->indexBuffer()->begin();
-        const typename deT::index_type* end = polys->indexBuffer()->end();
-        for(unsigned iz=0; it != end; it+=4, ++iz)
-        {
-          mPrimitiveZ[iz].mZ = (float)(mEyeSpaceVerts[it[0]].z() + mEyeSpaceVerts[it[1]].z() + mEyeSpaceVerts[it[2]].z() + mEyeSpaceVerts[it[3]].z());
-          mPrimitiveZ[iz].mPrimitiveIndex = iz;
-        }
-
-        // sort based on mPrimitiveZ
-        if (sortMode() == SM_SortBackToFront)
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Back_To_Front() );
-        else
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Front_To_Back() );
-
-        // regenerate the sorted indices
-        sorted_quads.resize( polys->indexBuffer()->size() / 4 );
-        Quad<T>* tris = (Quad<T>*)polys->indexBuffer()->ptr();
-        for(unsigned int i=0; i<mPrimitiveZ.size(); ++i)
-          sorted_quads[i] = tris[ mPrimitiveZ[i].mPrimitiveIndex ];
-        memcpy(&tris[0], &sorted_quads[0], sizeof(sorted_quads[0])*sorted_quads.size() );
-      }
-      else
-      if (polys->primitiveType() == PT_TRIANGLES)
-      {
-        // compute zetas
-        mPrimitiveZ.resize( polys->indexBuffer()->size() / 3 );
-        if (mPrimitiveZ.empty())
-          return;
-
-        const typename deT::index_type* it  = polys->indexBuffer()->begin();
-        const typename deT::index_type* end = polys->indexBuffer()->end();
-        for(unsigned iz=0; it != end; it+=3, ++iz)
-        {
-          mPrimitiveZ[iz].mZ = (float)(mEyeSpaceVerts[it[0]].z() + mEyeSpaceVerts[it[1]].z() + mEyeSpaceVerts[it[2]].z());
-          mPrimitiveZ[iz].mPrimitiveIndex = iz;
-        }
-
-        // sort based on mPrimitiveZ
-        if (sortMode() == SM_SortBackToFront)
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Back_To_Front() );
-        else
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Front_To_Back() );
+    virtual void onActorRenderStarted(Actor* actor, real frame_clock, const Camera* cam, Renderable* renderable, const Shader*, int pass);
 
-        // regenerate the sorted indices
-        sorted_triangles.resize( polys->indexBuffer()->size() / 3 );
-        Triangle<T>* tris = (Triangle<T>*)polys->indexBuffer()->ptr();
-        for(unsigned int i=0; i<mPrimitiveZ.size(); ++i)
-          sorted_triangles[i] = tris[ mPrimitiveZ[i].mPrimitiveIndex ];
-        memcpy(&tris[0], &sorted_triangles[0], sizeof(sorted_triangles[0])*sorted_triangles.size() );
-      }
-      else
-      if (polys->primitiveType() == PT_LINES)
-      {
-        // compute zetas
-        mPrimitiveZ.resize( polys->indexBuffer()->size() / 2 );
-        if (mPrimitiveZ.empty())
-          return;
-
-        const typename deT::index_type* it  = polys->indexBuffer()->begin();
-        const typename deT::index_type* end = polys->indexBuffer()->end();
-        for(unsigned iz=0; it != end; it+=2, ++iz)
-        {
-          mPrimitiveZ[iz].mZ = (float)(mEyeSpaceVerts[it[0]].z() + mEyeSpaceVerts[it[1]].z());
-          mPrimitiveZ[iz].mPrimitiveIndex = iz;
-        }
+    ESortMode sortMode() const { return mSortMode; }
+    void setSortMode(ESortMode sort_mode) { if (sort_mode != mSortMode) invalidateCache(); mSortMode = sort_mode; }
 
-        // sort based on mPrimitiveZ
-        if (sortMode() == SM_SortBackToFront)
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Back_To_Front() );
-        else
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Front_To_Back() );
+    /** The angle in degrees by which the view direction, expressed in object space, must change before the primitives are sorted again.
+      * Small camera rotations reuse the previous order, camera and Actor translations never require a new sorting. Defaults to 0. */
+    void setSortTolerance(real degrees) { mSortTolerance = degrees; }
 
-        // regenerate the sorted indices
-        sorted_lines.resize( polys->indexBuffer()->size() / 2 );
-        Line<T>* tris = (Line<T>*)polys->indexBuffer()->ptr();
-        for(unsigned int i=0; i<mPrimitiveZ.size(); ++i)
-          sorted_lines[i] = tris[ mPrimitiveZ[i].mPrimitiveIndex ];
-        memcpy(&tris[0], &sorted_lines[0], sizeof(sorted_lines[0])*sorted_lines.size() );
-      }
-      else
-      if (polys->primitiveType() == PT_POINTS)
-      {
-        // compute zetas
-        mPrimitiveZ.resize( polys->indexBuffer()->size() );
-        if (mPrimitiveZ.empty())
-          return;
+    /** The angle in degrees by which the view direction must change before the primitives are sorted again, see setSortTolerance(). */
+    real sortTolerance() const { return mSortTolerance; }
 
-        const typename deT::index_type* it  = polys->indexBuffer()->begin();
-        const typename deT::index_type* end = polys->indexBuffer()->end();
-        for(unsigned iz=0; it != end; ++it, ++iz)
-        {
-          mPrimitiveZ[iz].mZ = (float)mEyeSpaceVerts[it[0]].z();
-          mPrimitiveZ[iz].mPrimitiveIndex = iz;
-        }
+    /** When greater than 0 the primitives of each draw call are sorted in clusters of \p primitives consecutive primitives as laid out
+      * in the index buffer when the first sorting is performed, keeping their inner order. Each cluster is sorted by its center, which
+      * is computed once, so that no per-vertex computation is required at each sorting. Useful for very large meshes whose index buffer
+      * is laid out in spatially coherent chunks. Defaults to 0, i.e. per-primitive sorting. */
+    void setClusterSize(int primitives) { if (primitives != mClusterSize) mClusterCaches.clear(); mClusterSize = primitives < 0 ? 0 : primitives; invalidateCache(); }
 
-        // sort based on mPrimitiveZ
-        if (sortMode() == SM_SortBackToFront)
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Back_To_Front() );
-        else
-          std::sort( mPrimitiveZ.begin(), mPrimitiveZ.end(), Sorter_Front_To_Back() );
+    /** The number of primitives per cluster, see setClusterSize(). */
+    int clusterSize() const { return mClusterSize; }
 
-        // regenerate the sorted indices
-        sorted_points.resize( polys->indexBuffer()->size() );
-        Point<T>* tris = (Point<T>*)polys->indexBuffer()->ptr();
-        for(unsigned int i=0; i<mPrimitiveZ.size(); ++i)
-          sorted_points[i] = tris[ mPrimitiveZ[i].mPrimitiveIndex ];
-        memcpy(&tris[0], &sorted_points[0], sizeof(sorted_points[0])*sorted_points.size() );
-      }
+    /** The number of threads used to compute the depth of the vertices and of the primitives.
+      * Requires VL to be compiled with OpenMP support (CMake option VL_OPENMP), otherwise the value is ignored. Defaults to 1. */
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
 
-      if (Has_BufferObject)
-      {
-        if (polys->indexBuffer()->bufferObject()->handle())
-        {
-          if (polys->indexBuffer()->bufferObject()->usage() != vl::BU_DYNAMIC_DRAW)
-          {
-            polys->indexBuffer()->bufferObject()->setBufferData(vl::BU_DYNAMIC_DRAW);
-            polys->indexBuffer()->setBufferObjectDirty(false);
-          }
-          else
-            polys->indexBuffer()->setBufferObjectDirty(true);
-        }
-      }
-    }
-
-    ESortMode sortMode() const { return mSortMode; }
-    void setSortMode(ESortMode sort_mode) { mSortMode = sort_mode; }
+    /** The number of threads used to compute the depth of the vertices and of the primitives, see setThreadCount(). */
+    int threadCount() const { return mThreadCount; }
 
     /**
-     * Forces sorting at the next rendering.
+     * Forces sorting at the next rendering. Must be called also when the vertices or the indices of the Geometry are modified.
      */
-    void invalidateCache() { mCacheMatrix = vl::mat4(); }
+    void invalidateCache() { mCacheRenderable = NULL; mClusterCaches.clear(); }
 
   protected:
-    std::vector<vec3> mEyeSpaceVerts;
-    std::vector<PrimitiveZ> mPrimitiveZ;
+    template<typename deT>
+    void sort(deT* polys, int idraw, const ArrayAbstract* verts, const fvec3& view_z);
 
-    std::vector<PointUInt> mSortedPointsUInt;
-    std::vector<LineUInt> mSortedLinesUInt;
-    std::vector<TriangleUInt> mSortedTrianglesUInt;
-    std::vector<QuadUInt> mSortedQuadsUInt;
+    // computes the order of the values in mPrimitiveZ into mOrder
+    void radixSort();
 
-    std::vector<PointUShort> mSortedPointsUShort;
-    std::vector<LineUShort> mSortedLinesUShort;
-    std::vector<TriangleUShort> mSortedTrianglesUShort;
-    std::vector<QuadUShort> mSortedQuadsUShort;
+    // schedules the upload of a sorted index buffer
+    void updateIndexBuffer(ArrayAbstract* index_buffer);
 
-    std::vector<PointUByte> mSortedPointsUByte;
-    std::vector<LineUByte> mSortedLinesUByte;
-    std::vector<TriangleUByte> mSortedTrianglesUByte;
-    std::vector<QuadUByte> mSortedQuadsUByte;
+  protected:
+    std::vector<float> mEyeSpaceZ;
+    std::vector<float> mPrimitiveZ;
+    std::vector<unsigned short> mKeys;
+    std::vector<unsigned int> mOrder;
+    std::vector<unsigned int> mOrderTmp;
+    std::vector<unsigned char> mSortedIndices;
+    std::vector<ClusterCache> mClusterCaches;
 
-    vl::mat4 mCacheMatrix;
+    const Renderable* mCacheRenderable;
+    fvec3 mCacheDirection;
 
     ESortMode mSortMode;
+    real mSortTolerance;
+    int mClusterSize;
+    int mThreadCount;
   };
 }
 
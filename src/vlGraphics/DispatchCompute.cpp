@@ -0,0 +1,120 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/DispatchCompute.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// DispatchCompute
+//-----------------------------------------------------------------------------
+DispatchCompute::DispatchCompute(int groups_x, int groups_y, int groups_z)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mShader = new Shader;
+  mIndirectOffset = 0;
+  setGroupCount( groups_x, groups_y, groups_z );
+  mMemoryBarriers = GL_ALL_BARRIER_BITS;
+  mDispatchCount = 0;
+}
+//-----------------------------------------------------------------------------
+bool DispatchCompute::onRenderingStarted(const RenderingAbstract* rendering_abstract)
+{
+  const Rendering* rendering = rendering_abstract->as<Rendering>();
+  if ( !rendering || rendering->renderers().empty() || !rendering->renderers()[0]->framebuffer() )
+    return false;
+  OpenGLContext* ctx = const_cast<OpenGLContext*>( rendering->renderers()[0]->framebuffer()->openglContext() );
+  return dispatch( ctx, rendering->camera() );
+}
+//-----------------------------------------------------------------------------
+bool DispatchCompute::onRendererStarted(const RendererAbstract* renderer)
+{
+  if ( !renderer->framebuffer() )
+    return false;
+  OpenGLContext* ctx = const_cast<OpenGLContext*>( renderer->framebuffer()->openglContext() );
+  return dispatch( ctx, NULL );
+}
+//-----------------------------------------------------------------------------
+bool DispatchCompute::dispatch(OpenGLContext* ctx, const Camera* camera)
+{
+  VL_CHECK_OGL()
+
+  if ( !Has_Compute_Shader )
+  {
+    Log::error("DispatchCompute::dispatch(): compute shaders not supported.\n");
+    return false;
+  }
+
+  GLSLProgram* glsl = mShader ? mShader->glslProgram() : NULL;
+  if ( !ctx || !glsl || !glsl->shaderCount() )
+    return false;
+
+  // false also while a parallel link is pending
+  if ( !glsl->linkProgram() )
+    return false;
+
+  if ( !mIndirectBuffer && ( mGroupCount[0] <= 0 || mGroupCount[1] <= 0 || mGroupCount[2] <= 0 ) )
+    return false;
+
+  // program, buffers and images
+  ctx->applyRenderStates( mShader->getRenderStateSet(), camera ); VL_CHECK_OGL()
+
+  // uniforms
+  glsl->applyUniformSet( glsl->getUniformSet() );
+  if ( mShader->getUniformSet() )
+    glsl->applyUniformSet( mShader->getUniformSet() );
+
+  if ( mIndirectBuffer )
+  {
+    glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, mIndirectBuffer->handle() ); VL_CHECK_OGL()
+    glDispatchComputeIndirect( mIndirectOffset ); VL_CHECK_OGL()
+    glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 ); VL_CHECK_OGL()
+  }
+  else
+  {
+    glDispatchCompute( mGroupCount[0], mGroupCount[1], mGroupCount[2] ); VL_CHECK_OGL()
+  }
+  ++mDispatchCount;
+
+  if ( mMemoryBarriers )
+  {
+    glMemoryBarrier( mMemoryBarriers ); VL_CHECK_OGL()
+  }
+
+  // back to the default states, as expected by the Renderer[s] and by the end of the rendering
+  ctx->applyRenderStates( NULL, NULL ); VL_CHECK_OGL()
+  return true;
+}
+//-----------------------------------------------------------------------------
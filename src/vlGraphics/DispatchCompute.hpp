@@ -0,0 +1,123 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef DispatchCompute_INCLUDE_ONCE
+#define DispatchCompute_INCLUDE_ONCE
+
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/GLSL.hpp>
+
+namespace vl
+{
+  class OpenGLContext;
+  //-----------------------------------------------------------------------------
+  // DispatchCompute
+  //-----------------------------------------------------------------------------
+  /**
+   * A RenderEventCallback that launches a compute shader, for example to cull, skin or simulate on the GPU the data drawn by the following Renderer[s].
+   *
+   * The Shader returned by shader() holds everything the dispatch needs: the GLSLProgram with its GLSLComputeShader, the
+   * ShaderStorageBuffer[s], ImageUnit[s] and TextureSampler[s] it accesses and the Uniform[s] it reads. They are applied through
+   * OpenGLContext::applyRenderStates() like the ones of any other Shader, so the render state tracking of the context stays valid,
+   * and are reset to their defaults after the dispatch.
+   *
+   * The work is launched either with groupCountX() x groupCountY() x groupCountZ() work groups or, if an indirect buffer is set,
+   * with the group counts stored in the BufferObject (for example written by a previous compute pass).
+   * After the dispatch glMemoryBarrier() is called with memoryBarriers() so that the following draws and dispatches see its writes.
+   *
+   * The callback can be installed in Rendering::onStartedCallbacks() or Renderer::onStartedCallbacks() and the like, or used as a
+   * standalone pass by calling dispatch(). Requires OpenGL 4.3 or GL_ARB_compute_shader, see Has_Compute_Shader.
+   *
+   * \code
+   * ref<DispatchCompute> particles = new DispatchCompute;
+   * particles->shader()->gocGLSLProgram()->attachShader( new GLSLComputeShader("/glsl/particles.cs") );
+   * particles->shader()->gocShaderStorageBuffer(0)->setBufferObject( positions->bufferObject() );
+   * particles->setGroupCount( (particle_count + 255) / 256 );
+   * particles->setMemoryBarriers( GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT );
+   * rendering->onStartedCallbacks()->push_back( particles.get() );
+   * \endcode
+   *
+   * \sa GLSLComputeShader, ShaderStorageBuffer, ImageUnit, RenderEventCallback
+   */
+  class VLGRAPHICS_EXPORT DispatchCompute: public RenderEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::DispatchCompute, RenderEventCallback)
+
+  public:
+    DispatchCompute(int groups_x=1, int groups_y=1, int groups_z=1);
+
+    virtual bool onRenderingStarted(const RenderingAbstract* rendering);
+    virtual bool onRenderingFinished(const RenderingAbstract* rendering) { return onRenderingStarted(rendering); }
+    virtual bool onRendererStarted(const RendererAbstract* renderer);
+    virtual bool onRendererFinished(const RendererAbstract* renderer) { return onRendererStarted(renderer); }
+
+    //! Applies shader() and launches the compute work on \p ctx, which must be current. Returns false if nothing was dispatched.
+    //! \p camera is passed to the render states and can be NULL.
+    bool dispatch(OpenGLContext* ctx, const Camera* camera=NULL);
+
+    //! The program, buffers, images, textures and uniforms used by the dispatch.
+    void setShader(Shader* shader) { mShader = shader; }
+    Shader* shader() { return mShader.get(); }
+    const Shader* shader() const { return mShader.get(); }
+
+    //! The number of work groups launched along each dimension.
+    void setGroupCount(int x, int y=1, int z=1) { mGroupCount[0] = x; mGroupCount[1] = y; mGroupCount[2] = z; }
+    int groupCountX() const { return mGroupCount[0]; }
+    int groupCountY() const { return mGroupCount[1]; }
+    int groupCountZ() const { return mGroupCount[2]; }
+
+    //! If not NULL the group counts are read by the GPU from three consecutive uints at byte \p offset of \p buffer.
+    void setIndirectBuffer(BufferObject* buffer, GLintptr offset=0) { mIndirectBuffer = buffer; mIndirectOffset = offset; }
+    BufferObject* indirectBuffer() { return mIndirectBuffer.get(); }
+    const BufferObject* indirectBuffer() const { return mIndirectBuffer.get(); }
+    GLintptr indirectOffset() const { return mIndirectOffset; }
+
+    //! The glMemoryBarrier() bits issued after the dispatch, GL_ALL_BARRIER_BITS by default, 0 disables the barrier.
+    //! Narrow it to the way the results are consumed, for example GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT.
+    void setMemoryBarriers(GLbitfield barriers) { mMemoryBarriers = barriers; }
+    GLbitfield memoryBarriers() const { return mMemoryBarriers; }
+
+    //! Number of dispatches issued so far.
+    unsigned long dispatchCount() const { return mDispatchCount; }
+
+  protected:
+    ref<Shader> mShader;
+    ref<BufferObject> mIndirectBuffer;
+    GLintptr mIndirectOffset;
+    int mGroupCount[3];
+    GLbitfield mMemoryBarriers;
+    unsigned long mDispatchCount;
+  };
+}
+
+#endif
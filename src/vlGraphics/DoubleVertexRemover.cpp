@@ -31,6 +31,9 @@
 
 #include <vlGraphics/DoubleVertexRemover.hpp>
 #include <vlCore/Time.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <cstring>
+#include <cmath>
 
 using namespace vl;
 
@@ -207,19 +210,9 @@ ref<ArrayAbstract> VertexMapper::regenerate(ArrayAbstract* data, const std::vect
   return NULL;
 }
 //-----------------------------------------------------------------------------
-void DoubleVertexRemover::removeDoubles(Geometry* geom)
+void DoubleVertexRemover::computeMapSort(Geometry* geom)
 {
-  Time timer;
-  timer.start();
-
-  mMapNewToOld.clear();
-  mMapOldToNew.clear();
-
-  u32 vert_count = (u32)(geom->vertexArray() ? geom->vertexArray()->size() : 0);
-
-  VL_CHECK(vert_count);
-  if (!vert_count)
-    return;
+  u32 vert_count = (u32)geom->vertexArray()->size();
 
   std::vector<u32> verti;
   verti.resize(vert_count);
@@ -250,6 +243,106 @@ void DoubleVertexRemover::removeDoubles(Geometry* geom)
     mMapOldToNew[verti[j]] = (u32)mMapNewToOld.size();
     mMapNewToOld.push_back(verti[unique_vert_idx]);
   }
+}
+//-----------------------------------------------------------------------------
+void DoubleVertexRemover::computeMapHash(Geometry* geom)
+{
+  const u32 vert_count = (u32)geom->vertexArray()->size();
+
+  // collect the attributes and compute the key layout
+  std::vector< const ArrayAbstract* > attribs;
+  std::vector< size_t > attrib_bytes;
+  size_t key_size = 0;
+  const bool snap_positions = mPositionEpsilon > 0;
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    const ArrayAbstract* arr = geom->vertexAttribArray(i);
+    if (!arr)
+      continue;
+    VL_CHECK(arr->size() == vert_count)
+    attribs.push_back(arr);
+    // snapped positions are stored as 3 grid coordinates
+    size_t bytes = (i == VA_Position && snap_positions) ? sizeof(i64) * 3 : arr->bytesUsed() / arr->size();
+    attrib_bytes.push_back(bytes);
+    key_size += bytes;
+  }
+
+  // pack and hash the vertex keys, each vertex is independent so this can run in parallel.
+  std::vector<unsigned char> keys( key_size * vert_count );
+  std::vector<u32> hashes( vert_count );
+  const real inv_epsilon = snap_positions ? 1 / mPositionEpsilon : 0;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(vert_count > 64*1024)
+#endif
+  for(int ivert=0; ivert<(int)vert_count; ++ivert)
+  {
+    unsigned char* key = &keys[ key_size * ivert ];
+    for(size_t iattr=0; iattr<attribs.size(); ++iattr)
+    {
+      const ArrayAbstract* arr = attribs[iattr];
+      if (arr == geom->vertexArray() && snap_positions)
+      {
+        vec3 v = arr->getAsVec3(ivert) * inv_epsilon;
+        i64 cell[] = { (i64)::floor(v.x() + (real)0.5), (i64)::floor(v.y() + (real)0.5), (i64)::floor(v.z() + (real)0.5) };
+        memcpy(key, cell, sizeof(cell));
+      }
+      else
+        memcpy(key, arr->ptr() + attrib_bytes[iattr] * ivert, attrib_bytes[iattr]);
+      key += attrib_bytes[iattr];
+    }
+    MurmurHash3_x86_32(&keys[ key_size * ivert ], (int)key_size, 0, &hashes[ivert]);
+  }
+
+  // weld using an open addressing hash table sized to the next power of two greater than twice the vertex count.
+  u32 table_size = 1;
+  while(table_size < vert_count * 2)
+    table_size <<= 1;
+  const u32 mask = table_size - 1;
+  std::vector<u32> table( table_size, 0xFFFFFFFF );
+
+  mMapOldToNew.resize(vert_count);
+  mMapNewToOld.reserve(vert_count);
+  for(u32 ivert=0; ivert<vert_count; ++ivert)
+  {
+    const unsigned char* key = &keys[ key_size * ivert ];
+    for(u32 slot = hashes[ivert] & mask; ; slot = (slot + 1) & mask)
+    {
+      u32 inew = table[slot];
+      if (inew == 0xFFFFFFFF)
+      {
+        table[slot] = (u32)mMapNewToOld.size();
+        mMapOldToNew[ivert] = (u32)mMapNewToOld.size();
+        mMapNewToOld.push_back(ivert);
+        break;
+      }
+      u32 iold = mMapNewToOld[inew];
+      if (hashes[iold] == hashes[ivert] && memcmp(&keys[ key_size * iold ], key, key_size) == 0)
+      {
+        mMapOldToNew[ivert] = inew;
+        break;
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void DoubleVertexRemover::removeDoubles(Geometry* geom)
+{
+  Time timer;
+  timer.start();
+
+  mMapNewToOld.clear();
+  mMapOldToNew.clear();
+
+  u32 vert_count = (u32)(geom->vertexArray() ? geom->vertexArray()->size() : 0);
+
+  VL_CHECK(vert_count);
+  if (!vert_count)
+    return;
+
+  if (useHashing())
+    computeMapHash(geom);
+  else
+    computeMapSort(geom);
 
   // regenerate vertices
 
@@ -273,6 +366,6 @@ void DoubleVertexRemover::removeDoubles(Geometry* geom)
       de->indexBuffer()->at(i) = mMapOldToNew[it.index()];
   }
 
-  Log::debug( Say("DoubleVertexRemover : time=%.2ns, verts=%n/%n, saved=%n, ratio=%.2n\n") << timer.elapsed() << mMapNewToOld.size() << verti.size() << verti.size() - mMapNewToOld.size() << (float)mMapNewToOld.size()/verti.size() );
+  Log::debug( Say("DoubleVertexRemover : time=%.2ns, verts=%n/%n, saved=%n, ratio=%.2n\n") << timer.elapsed() << mMapNewToOld.size() << vert_count << vert_count - mMapNewToOld.size() << (float)mMapNewToOld.size()/vert_count );
 }
 //-----------------------------------------------------------------------------
@@ -60,19 +60,42 @@ namespace vl
   //-----------------------------------------------------------------------------
   //! Removes from a Geometry the vertices with the same attributes.
   //! As a result also all the DrawArrays prensent in the Geometry are substituted with DrawElements.
+  //!
+  //! By default the vertices are sorted comparing their attributes one by one, which runs in O(n*log(n)) virtual calls.
+  //! When hashing is enabled (see setUseHashing()) each vertex is packed into a key containing the raw bytes of all
+  //! its attributes which is hashed with MurmurHash3 and welded using a hash table in linear time. In this mode the
+  //! attributes are compared bitwise and the new vertices keep the order of their first occurrence.
   class VLGRAPHICS_EXPORT DoubleVertexRemover: public VertexMapper
   {
     VL_INSTRUMENT_CLASS(vl::DoubleVertexRemover, VertexMapper)
 
   public:
-    DoubleVertexRemover() {}
+    DoubleVertexRemover(): mPositionEpsilon(0), mUseHashing(false) {}
     void removeDoubles(Geometry* geom);
     const std::vector<u32>& mapNewToOld() const { return mMapNewToOld; }
     const std::vector<u32>& mapOldToNew() const { return mMapOldToNew; }
 
+    //! Enables the linear time hash-based welding, recommended for very large meshes. Defaults to false.
+    void setUseHashing(bool use_hashing) { mUseHashing = use_hashing; }
+    //! Whether the linear time hash-based welding is enabled.
+    bool useHashing() const { return mUseHashing; }
+
+    //! When greater than 0 the vertex positions are snapped to a grid of the given cell size before being compared,
+    //! welding also vertices that are only approximately coincident. Two positions closer than \p epsilon
+    //! but falling in different cells are not welded. Used only when useHashing() is true. Defaults to 0.
+    void setPositionEpsilon(real epsilon) { mPositionEpsilon = epsilon; }
+    //! The cell size of the grid used to snap the vertex positions, see setPositionEpsilon().
+    real positionEpsilon() const { return mPositionEpsilon; }
+
+  protected:
+    void computeMapSort(Geometry* geom);
+    void computeMapHash(Geometry* geom);
+
   protected:
     std::vector<u32> mMapNewToOld;
     std::vector<u32> mMapOldToNew;
+    real mPositionEpsilon;
+    bool mUseHashing;
   };
 }
 
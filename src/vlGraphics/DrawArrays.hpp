@@ -104,7 +104,7 @@ namespace vl
         glDrawArrays( primitiveType(), (int)start(), (int)count() );
 
       #ifndef NDEBUG
-        unsigned int glerr = glGetError();
+        unsigned int glerr = Is_GL_Debug_Output_Active ? GL_NO_ERROR : glGetError();
         if (glerr != GL_NO_ERROR)
         {
           String msg( getGLErrorString(glerr) );
@@ -116,6 +116,11 @@ namespace vl
       #endif
     }
 
+    virtual void countRenderStats(RenderStats& stats) const
+    {
+      stats.countDrawCall( primitiveType(), (u32)count(), instances() );
+    }
+
     //! sets the starting vertex for the rendering.
     void setStart(int start) { mStart = start; }
 
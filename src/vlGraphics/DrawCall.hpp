@@ -36,6 +36,7 @@
 #include <vlGraphics/TriangleIterator.hpp>
 #include <vlGraphics/IndexIterator.hpp>
 #include <vlGraphics/PatchParameter.hpp>
+#include <vlGraphics/RenderStats.hpp>
 
 namespace vl 
 {
@@ -112,15 +113,29 @@ namespace vl
     /** Executes the draw call. */
     virtual void render(bool use_bo = true) const = 0;
 
+    /** Adds the draw calls, primitives and buffer binds issued by render() to the given RenderStats.
+      * Called by Geometry after each render(), the default implementation only counts one draw call. */
+    virtual void countRenderStats(RenderStats& stats) const { stats.countDrawCall(primitiveType(), 0, instances()); }
+
     /** Returns a clone of the draw call. */
     virtual ref<DrawCall> clone() const = 0;
 
+    /** Returns a clone of the draw call sharing its index buffer copy-on-write, see ArrayAbstract::cowClone().
+      * The default implementation returns clone(). */
+    virtual ref<DrawCall> cowClone() const { return clone(); }
+
     /** Updates the index buffer's BufferObject if marked as dirty. */
     virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) = 0;
 
     /** Deletes the index buffer's BufferObject. */
     virtual void deleteBufferObject() = 0;
 
+    /** The index buffer of indexed draw calls like DrawElements, DrawRangeElements and MultiDrawElements, NULL for the others. */
+    virtual ArrayAbstract* indexArray() { return NULL; }
+
+    /** The index buffer of indexed draw calls like DrawElements, DrawRangeElements and MultiDrawElements, NULL for the others. */
+    virtual const ArrayAbstract* indexArray() const { return NULL; }
+
     /** Enables/disables the draw call. */
     void setEnabled(bool enable) { mEnabled = enable; }
 
@@ -185,6 +185,15 @@ namespace vl
       return de;
     }
 
+    //! Returns a clone of this DrawCall sharing the index buffer copy-on-write
+    virtual ref<DrawCall> cowClone() const
+    {
+      ref<DrawElements> de = new DrawElements;
+      de->setIndexBuffer( indexBuffer()->cowClone()->template as<arr_type>() );
+      *de = *this;
+      return de;
+    }
+
     //! The number of indices to render, default is -1 which means 'till the end of the indexBuffer() from offset()'.
     void setCount(i32 count) { mCount = count; }
 
@@ -217,6 +226,18 @@ namespace vl
       indexBuffer()->bufferObject()->deleteBufferObject();
     }
 
+    virtual ArrayAbstract* indexArray() { return indexBuffer(); }
+
+    virtual const ArrayAbstract* indexArray() const { return indexBuffer(); }
+
+    virtual void countRenderStats(RenderStats& stats) const
+    {
+      // the index buffer is always bound, see render()
+      u32 count = mCount >= 0 ? (u32)mCount : (u32)indexBuffer()->size() - mOffset / sizeof(index_type);
+      stats.countDrawCall( primitiveType(), count, instances() );
+      ++stats.mBufferBinds;
+    }
+
     virtual void render(bool use_bo) const
     {
       VL_CHECK_OGL()
@@ -269,7 +290,8 @@ namespace vl
       if (use_bo && indexBuffer()->bufferObject()->handle())
       {
         VL_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer()->bufferObject()->handle()); VL_CHECK_OGL()
-        ptr = 0;
+        // non zero if the index buffer is sub-allocated from a BufferObjectPool
+        ptr = (const char*)0 + indexBuffer()->bufferObject()->byteOffsetBufferObject();
       }
       else
       {
@@ -333,7 +355,7 @@ namespace vl
       }
 
       #ifndef NDEBUG
-        unsigned int glerr = glGetError();
+        unsigned int glerr = Is_GL_Debug_Output_Active ? GL_NO_ERROR : glGetError();
         if (glerr != GL_NO_ERROR)
         {
           String msg( getGLErrorString(glerr) );
@@ -186,6 +186,14 @@ namespace vl
       return de;
     }
 
+    virtual ref<DrawCall> cowClone() const
+    {
+      ref<DrawRangeElements> de = new DrawRangeElements;
+      de->setIndexBuffer( indexBuffer()->cowClone()->template as<arr_type>() );
+      *de = *this;
+      return de;
+    }
+
     //! The number of indices to render, default is -1 which means 'till the end of the indexBuffer() from offset()'.
     void setCount(i32 count) { mCount = count; }
 
@@ -218,6 +226,18 @@ namespace vl
       indexBuffer()->bufferObject()->deleteBufferObject();
     }
 
+    virtual ArrayAbstract* indexArray() { return indexBuffer(); }
+
+    virtual const ArrayAbstract* indexArray() const { return indexBuffer(); }
+
+    virtual void countRenderStats(RenderStats& stats) const
+    {
+      // the index buffer is always bound, see render()
+      u32 count = mCount >= 0 ? (u32)mCount : (u32)indexBuffer()->size() - mOffset / sizeof(index_type);
+      stats.countDrawCall( primitiveType(), count, 1 );
+      ++stats.mBufferBinds;
+    }
+
     virtual void render(bool use_bo) const
     {
       VL_CHECK_OGL()
@@ -243,7 +263,8 @@ namespace vl
       if (use_bo && indexBuffer()->bufferObject()->handle())
       {
         VL_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer()->bufferObject()->handle()); VL_CHECK_OGL()
-        ptr = 0;
+        // non zero if the index buffer is sub-allocated from a BufferObjectPool
+        ptr = (const char*)0 + indexBuffer()->bufferObject()->byteOffsetBufferObject();
       }
       else
       {
@@ -0,0 +1,367 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/DynamicResolution.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <math.h>
+
+using namespace vl;
+
+namespace
+{
+  // at most this many frames are timed at the same time
+  const size_t MaxPendingQueries = 4;
+
+  const char* UpscaleVertexShader =
+    "#version 150\n"
+    "void main(void)\n"
+    "{\n"
+    "  // full screen triangle\n"
+    "  gl_Position = vec4( gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0 );\n"
+    "}\n";
+
+  const char* SharpenFragmentShader =
+    "#version 150\n"
+    "uniform sampler2D vl_DRColor;\n"
+    "uniform vec4 vl_DRViewport;   // x, y, width, height of the destination\n"
+    "uniform vec4 vl_DRSource;     // width and height of the scene, 1 / texture width and height\n"
+    "uniform float vl_DRSharpness;\n"
+    "out vec4 vl_FragColor;\n"
+    "vec4 fetch(vec2 uv)\n"
+    "{\n"
+    "  // never sample outside of the area the scene was rendered to\n"
+    "  return texture( vl_DRColor, clamp( uv, vl_DRSource.zw * 0.5, (vl_DRSource.xy - 0.5) * vl_DRSource.zw ) );\n"
+    "}\n"
+    "void main(void)\n"
+    "{\n"
+    "  vec2 uv = (gl_FragCoord.xy - vl_DRViewport.xy) / vl_DRViewport.zw * vl_DRSource.xy * vl_DRSource.zw;\n"
+    "  vec4 center = fetch( uv );\n"
+    "  vec4 around = fetch( uv + vec2( vl_DRSource.z, 0.0 ) ) + fetch( uv - vec2( vl_DRSource.z, 0.0 ) ) +\n"
+    "                fetch( uv + vec2( 0.0, vl_DRSource.w ) ) + fetch( uv - vec2( 0.0, vl_DRSource.w ) );\n"
+    "  // unsharp mask\n"
+    "  vl_FragColor = clamp( center + vl_DRSharpness * ( center - around * 0.25 ), 0.0, 1.0 );\n"
+    "}\n";
+}
+
+//-----------------------------------------------------------------------------
+// DynamicResolution
+//-----------------------------------------------------------------------------
+DynamicResolution::DynamicResolution()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mActiveQuery = 0;
+  mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+  mTargetWidth = 0;
+  mTargetHeight = 0;
+  mRenderWidth = 0;
+  mRenderHeight = 0;
+  mTargetFrameTime = 16.0f;
+  mMinScale = 0.5f;
+  mMaxScale = 1.0f;
+  mScale = 1.0f;
+  mResponse = 0.25f;
+  mTolerance = 0.05f;
+  mSharpness = 0.5f;
+  mLastGPUTime = -1.0f;
+  mUpscaleFilter = UF_Bilinear;
+  mEnabled = true;
+  mSceneActive = false;
+}
+//-----------------------------------------------------------------------------
+DynamicResolution::~DynamicResolution()
+{
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::setScaleRange(float min_scale, float max_scale)
+{
+  mMinScale = min_scale > 0.01f ? min_scale : 0.01f;
+  mMaxScale = max_scale > mMinScale ? max_scale : mMinScale;
+  setScale( mScale );
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::setScale(float scale)
+{
+  mScale = scale < mMinScale ? mMinScale : ( scale > mMaxScale ? mMaxScale : scale );
+}
+//-----------------------------------------------------------------------------
+bool DynamicResolution::prepareTargets(OpenGLContext* ctx, int width, int height)
+{
+  // room for the largest scale, so that changing the scale never reallocates
+  const float max_scale = mMaxScale > 1.0f ? mMaxScale : 1.0f;
+  const int target_width  = (int)ceil( width  * max_scale );
+  const int target_height = (int)ceil( height * max_scale );
+
+  if ( mFramebuffer && mPool && mPool->openglContext() == ctx && mTargetWidth == target_width && mTargetHeight == target_height )
+    return true;
+
+  releaseTargets();
+
+  mPool = ctx->renderTargetPool();
+  mFramebuffer  = mPool->acquireFramebuffer( target_width, target_height );
+  mColorTexture = mPool->acquireTexture( target_width, target_height, TF_RGBA8 );
+  mDepthBuffer  = mPool->acquireDepthStencilBuffer( target_width, target_height, DSBT_DEPTH24_STENCIL8 );
+  if ( !mFramebuffer || !mColorTexture || !mDepthBuffer )
+  {
+    releaseTargets();
+    return false;
+  }
+  mTargetWidth  = target_width;
+  mTargetHeight = target_height;
+
+  // resampled with bilinear filtering
+  glBindTexture( GL_TEXTURE_2D, mColorTexture->handle() ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+
+  mFramebuffer->setDrawBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->setReadBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->addTextureAttachment( AP_COLOR_ATTACHMENT0, new FBOTexture2DAttachment( mColorTexture.get(), 0, T2DT_TEXTURE_2D ) );
+  mFramebuffer->addDepthStencilAttachment( mDepthBuffer.get() );
+  return true;
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::releaseTargets()
+{
+  // the targets are gone if the pool has been cleared together with its OpenGLContext
+  if ( mPool )
+  {
+    if ( mFramebuffer && mPool->isAcquired( mFramebuffer.get() ) )
+      mPool->release( mFramebuffer.get() );
+    if ( mColorTexture && mPool->isAcquired( mColorTexture.get() ) )
+      mPool->release( mColorTexture.get() );
+    if ( mDepthBuffer && mPool->isAcquired( mDepthBuffer.get() ) )
+      mPool->release( mDepthBuffer.get() );
+  }
+  mFramebuffer  = NULL;
+  mColorTexture = NULL;
+  mDepthBuffer  = NULL;
+  mPool = NULL;
+  mTargetWidth  = 0;
+  mTargetHeight = 0;
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::beginScene(Rendering* rendering)
+{
+  mSceneActive = false;
+  if ( !mEnabled || !Has_FBO )
+    return;
+
+  Viewport* viewport = rendering->camera()->viewport();
+  OpenGLContext* ctx = rendering->renderers()[0]->framebuffer()->openglContext();
+  if ( viewport->width() <= 0 || viewport->height() <= 0 || !prepareTargets( ctx, viewport->width(), viewport->height() ) )
+    return;
+
+  collectGPUTimes();
+
+  mRenderWidth  = (int)( viewport->width()  * mScale + 0.5f );
+  mRenderHeight = (int)( viewport->height() * mScale + 0.5f );
+  mRenderWidth  = mRenderWidth  < 1 ? 1 : ( mRenderWidth  > mTargetWidth  ? mTargetWidth  : mRenderWidth  );
+  mRenderHeight = mRenderHeight < 1 ? 1 : ( mRenderHeight > mTargetHeight ? mTargetHeight : mRenderHeight );
+
+  // redirect the Renderer[s] into the scaled area of the offscreen framebuffer
+  mViewport[0] = viewport->x();
+  mViewport[1] = viewport->y();
+  mViewport[2] = viewport->width();
+  mViewport[3] = viewport->height();
+  viewport->set( 0, 0, mRenderWidth, mRenderHeight );
+
+  mSavedFramebuffers.resize( rendering->renderers().size() );
+  for( int i=0; i<rendering->renderers().size(); ++i )
+  {
+    Renderer* renderer = rendering->renderers()[i].get();
+    mSavedFramebuffers[i] = renderer ? renderer->framebuffer() : NULL;
+    if ( renderer )
+      renderer->setFramebuffer( mFramebuffer.get() );
+  }
+
+#if defined(VL_OPENGL)
+  if ( Has_Timer_Query && mPendingQueries.size() < MaxPendingQueries )
+  {
+    if ( mQueries.empty() )
+    {
+      GLuint query = 0;
+      glGenQueries( 1, &query ); VL_CHECK_OGL();
+      mQueries.push_back( query );
+    }
+    mActiveQuery = mQueries.back();
+    mQueries.pop_back();
+    glBeginQuery( GL_TIME_ELAPSED, mActiveQuery ); VL_CHECK_OGL();
+  }
+#endif
+
+  mSceneActive = true;
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::endScene(Rendering* rendering)
+{
+  if ( !mSceneActive )
+    return;
+  mSceneActive = false;
+
+#if defined(VL_OPENGL)
+  if ( mActiveQuery )
+  {
+    glEndQuery( GL_TIME_ELAPSED ); VL_CHECK_OGL();
+    PendingQuery pending;
+    pending.mQuery = mActiveQuery;
+    pending.mScale = mScale;
+    mPendingQueries.push_back( pending );
+    mActiveQuery = 0;
+  }
+#endif
+
+  for( int i=0; i<rendering->renderers().size() && i<(int)mSavedFramebuffers.size(); ++i )
+  {
+    if ( rendering->renderers()[i] )
+      rendering->renderers()[i]->setFramebuffer( mSavedFramebuffers[i].get() );
+  }
+  mSavedFramebuffers.clear();
+
+  rendering->camera()->viewport()->set( mViewport[0], mViewport[1], mViewport[2], mViewport[3] );
+
+  Framebuffer* dst = rendering->renderers()[0]->framebuffer();
+  if ( mUpscaleFilter != UF_Sharpen || !sharpenUpscale( dst ) )
+    blitUpscale( dst );
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::blitUpscale(Framebuffer* dst)
+{
+  // bind the source first: the debug completeness check of FramebufferObject looks at the draw framebuffer
+  mFramebuffer->bindFramebuffer( FBB_READ_FRAMEBUFFER ); VL_CHECK_OGL();
+  dst->activate( FBB_DRAW_FRAMEBUFFER ); VL_CHECK_OGL();
+  VL_glBlitFramebuffer( 0, 0, mRenderWidth, mRenderHeight,
+                        mViewport[0], mViewport[1], mViewport[0] + mViewport[2], mViewport[1] + mViewport[3],
+                        GL_COLOR_BUFFER_BIT, GL_LINEAR ); VL_CHECK_OGL();
+}
+//-----------------------------------------------------------------------------
+bool DynamicResolution::sharpenUpscale(Framebuffer* dst)
+{
+#if defined(VL_OPENGL)
+  if ( !Has_GLSL || !Has_GL_Version_3_2 )
+    return false;
+
+  if ( !mSharpenProgram )
+  {
+    mSharpenProgram = new GLSLProgram;
+    mSharpenProgram->setObjectName("DynamicResolution");
+    mSharpenProgram->attachShader( new GLSLVertexShader(UpscaleVertexShader) );
+    mSharpenProgram->attachShader( new GLSLFragmentShader(SharpenFragmentShader) );
+  }
+  if ( !mSharpenProgram->linked() && !mSharpenProgram->linkProgram() )
+  {
+    Log::error("DynamicResolution::sharpenUpscale(): could not link the upscale program, falling back to bilinear.\n");
+    mUpscaleFilter = UF_Bilinear;
+    return false;
+  }
+
+  OpenGLContext* gl_context = dst->openglContext();
+  dst->activate( FBB_FRAMEBUFFER ); VL_CHECK_OGL();
+  glViewport( mViewport[0], mViewport[1], mViewport[2], mViewport[3] ); VL_CHECK_OGL();
+
+  gl_context->useGLSLProgram( mSharpenProgram.get() );
+  glUniform1i( mSharpenProgram->getUniformLocation("vl_DRColor"), 0 ); VL_CHECK_OGL();
+  glUniform4f( mSharpenProgram->getUniformLocation("vl_DRViewport"), (float)mViewport[0], (float)mViewport[1], (float)mViewport[2], (float)mViewport[3] ); VL_CHECK_OGL();
+  glUniform4f( mSharpenProgram->getUniformLocation("vl_DRSource"), (float)mRenderWidth, (float)mRenderHeight, 1.0f / mTargetWidth, 1.0f / mTargetHeight ); VL_CHECK_OGL();
+  glUniform1f( mSharpenProgram->getUniformLocation("vl_DRSharpness"), mSharpness ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, mColorTexture->handle() ); VL_CHECK_OGL();
+
+  glDrawArrays( GL_TRIANGLES, 0, 3 ); VL_CHECK_OGL();
+
+  // restore the default states
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+  gl_context->useGLSLProgram( NULL );
+  return true;
+#else
+  (void)dst;
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::collectGPUTimes()
+{
+#if defined(VL_OPENGL)
+  // the queries complete in order: stop at the first one not yet available
+  size_t done = 0;
+  for( ; done < mPendingQueries.size(); ++done )
+  {
+    GLuint available = 0;
+    glGetQueryObjectuiv( mPendingQueries[done].mQuery, GL_QUERY_RESULT_AVAILABLE, &available ); VL_CHECK_OGL();
+    if ( !available )
+      break;
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v( mPendingQueries[done].mQuery, GL_QUERY_RESULT, &elapsed ); VL_CHECK_OGL();
+    mQueries.push_back( mPendingQueries[done].mQuery );
+    mLastGPUTime = (float)( elapsed / 1000000.0 );
+    updateScale( mPendingQueries[done].mScale );
+  }
+  mPendingQueries.erase( mPendingQueries.begin(), mPendingQueries.begin() + done );
+#endif
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::updateScale(float measured_scale)
+{
+  if ( mLastGPUTime <= 0 || mTargetFrameTime <= 0 )
+    return;
+
+  const float ratio = mTargetFrameTime / mLastGPUTime;
+  if ( fabs( ratio - 1.0f ) <= mTolerance )
+    return;
+
+  // the cost is proportional to the number of pixels, i.e. to the square of the scale
+  const float ideal = measured_scale * sqrtf( ratio );
+  setScale( mScale + ( ideal - mScale ) * mResponse );
+}
+//-----------------------------------------------------------------------------
+void DynamicResolution::releaseOpenGLResources()
+{
+  releaseTargets();
+  mSavedFramebuffers.clear();
+  mSharpenProgram = NULL;
+#if defined(VL_OPENGL)
+  for( size_t i=0; i<mPendingQueries.size(); ++i )
+    mQueries.push_back( mPendingQueries[i].mQuery );
+  mPendingQueries.clear();
+  if ( Has_Timer_Query && !mQueries.empty() )
+    glDeleteQueries( (GLsizei)mQueries.size(), &mQueries[0] );
+#endif
+  mQueries.clear();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,182 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef DynamicResolution_INCLUDE_ONCE
+#define DynamicResolution_INCLUDE_ONCE
+
+#include <vlGraphics/RenderTargetPool.hpp>
+#include <vector>
+
+namespace vl
+{
+  class Rendering;
+  class GLSLProgram;
+  //------------------------------------------------------------------------------
+  // DynamicResolution
+  //------------------------------------------------------------------------------
+  /** Renders the 3D scene of a Rendering at a resolution adjusted each frame to meet a target GPU frame time,
+    * then upscales it into the camera's Viewport.
+    *
+    * Install it with Rendering::setDynamicResolution(). While enabled the Renderer[s] of the Rendering draw into an
+    * offscreen FramebufferObject, taken from the OpenGLContext::renderTargetPool(), whose used area is
+    * scale() times the Viewport in each dimension. The GPU time of the Renderer[s] is measured with \p GL_TIME_ELAPSED
+    * queries read back without stalling, usually one or two frames later, and the scale of the next frames is moved
+    * towards \p scale * sqrt(targetFrameTime() / gpu_time), since the fill cost grows with the pixel count.
+    *
+    * The upscale is either a bilinear blit or a bilinear resample followed by a sharpening filter, see setUpscaleFilter().
+    * Overlays such as Text and VectorGraphics should be rendered by another Rendering (for example in a RenderingTree)
+    * targeting the same Framebuffer after this one, so that they are drawn at native resolution.
+    *
+    * \note Requires framebuffer objects with blit support, the sharpening filter requires GLSL 1.50 and falls back to the
+    * bilinear blit otherwise. Without \p GL_TIME_ELAPSED queries (see Has_Timer_Query) the scale stays at its current value.
+    * \sa Rendering::setDynamicResolution(), RenderTargetPool, FrameProfiler */
+  class VLGRAPHICS_EXPORT DynamicResolution: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::DynamicResolution, Object)
+
+  public:
+    //! Upscaling filters, see setUpscaleFilter().
+    typedef enum
+    {
+      UF_Bilinear, //!< Bilinear blit with \p glBlitFramebuffer().
+      UF_Sharpen   //!< Bilinear resample followed by a sharpening filter, see setSharpness().
+    } EUpscaleFilter;
+
+  public:
+    DynamicResolution();
+    ~DynamicResolution();
+
+    //! Enables or disables the dynamic resolution, when disabled the Rendering draws directly at native resolution (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! The GPU time in milliseconds the Renderer[s] should take (default = 16.0).
+    void setTargetFrameTime(float ms) { mTargetFrameTime = ms; }
+    float targetFrameTime() const { return mTargetFrameTime; }
+
+    //! The range of the resolution scale, relative to the Viewport dimensions (default = 0.5, 1.0).
+    //! A maximum greater than 1 allows supersampling when the GPU has headroom.
+    void setScaleRange(float min_scale, float max_scale);
+    float minScale() const { return mMinScale; }
+    float maxScale() const { return mMaxScale; }
+
+    //! Sets the current resolution scale, clamped to the scale range.
+    void setScale(float scale);
+    //! The resolution scale used for the next frame.
+    float scale() const { return mScale; }
+
+    //! Fraction of the distance to the ideal scale covered each frame, lower values react slower but oscillate less (default = 0.25).
+    void setResponse(float response) { mResponse = response; }
+    float response() const { return mResponse; }
+
+    //! The scale is not changed if the GPU time is within this fraction of the target (default = 0.05).
+    void setTolerance(float tolerance) { mTolerance = tolerance; }
+    float tolerance() const { return mTolerance; }
+
+    //! The filter used to upscale the scene into the Viewport (default = UF_Bilinear).
+    void setUpscaleFilter(EUpscaleFilter filter) { mUpscaleFilter = filter; }
+    EUpscaleFilter upscaleFilter() const { return mUpscaleFilter; }
+
+    //! Strength of the UF_Sharpen filter, 0 is plain bilinear (default = 0.5).
+    void setSharpness(float sharpness) { mSharpness = sharpness; }
+    float sharpness() const { return mSharpness; }
+
+    //! The last GPU time measured in milliseconds, or -1 if none available yet.
+    float lastGPUTime() const { return mLastGPUTime; }
+
+    //! Width of the scene rendered during the last frame.
+    int renderWidth() const { return mRenderWidth; }
+    //! Height of the scene rendered during the last frame.
+    int renderHeight() const { return mRenderHeight; }
+
+    //! The offscreen FramebufferObject the scene is rendered to, NULL before the first frame.
+    FramebufferObject* framebuffer() { return mFramebuffer.get(); }
+    //! The color texture of framebuffer().
+    Texture* colorTexture() { return mColorTexture.get(); }
+
+    //! Redirects the Renderer[s] of the rendering into the offscreen framebuffer and starts the GPU timing. Called by Rendering::render().
+    void beginScene(Rendering* rendering);
+
+    //! Restores the Renderer[s] and the Viewport, upscales the scene and updates the scale. Called by Rendering::render().
+    void endScene(Rendering* rendering);
+
+    //! Releases the queries, the upscale program and gives back the render targets to the pool. Requires the OpenGL context to be current.
+    void releaseOpenGLResources();
+
+  protected:
+    //! Acquires the render targets able to hold maxScale() times the given dimensions.
+    bool prepareTargets(OpenGLContext* ctx, int width, int height);
+    void releaseTargets();
+    //! Reads the completed timer queries and adjusts the scale.
+    void collectGPUTimes();
+    //! Moves the scale towards the one meeting the target given the last GPU time, measured at \p measured_scale.
+    void updateScale(float measured_scale);
+    void blitUpscale(Framebuffer* dst);
+    bool sharpenUpscale(Framebuffer* dst);
+
+    struct PendingQuery
+    {
+      GLuint mQuery;
+      //! The scale the measured frame was rendered with.
+      float mScale;
+    };
+
+  protected:
+    ref<RenderTargetPool> mPool;
+    ref<FramebufferObject> mFramebuffer;
+    ref<Texture> mColorTexture;
+    ref<FBODepthStencilBufferAttachment> mDepthBuffer;
+    ref<GLSLProgram> mSharpenProgram;
+    std::vector< ref<Framebuffer> > mSavedFramebuffers;
+    std::vector<GLuint> mQueries;
+    std::vector<PendingQuery> mPendingQueries;
+    GLuint mActiveQuery;
+    int mViewport[4];
+    int mTargetWidth;
+    int mTargetHeight;
+    int mRenderWidth;
+    int mRenderHeight;
+    float mTargetFrameTime;
+    float mMinScale;
+    float mMaxScale;
+    float mScale;
+    float mResponse;
+    float mTolerance;
+    float mSharpness;
+    float mLastGPUTime;
+    EUpscaleFilter mUpscaleFilter;
+    bool mEnabled;
+    bool mSceneActive;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -36,77 +36,281 @@
 #include <vlCore/Log.hpp>
 #include <vlGraphics/Array.hpp>
 #include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/TriangleVisitor.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <cmath>
 
 using namespace vl;
 
 //-----------------------------------------------------------------------------
-void EdgeExtractor::addEdge(std::set<EdgeExtractor::Edge>& edges, const EdgeExtractor::Edge& e, const fvec3& n)
+namespace
 {
-  std::set<EdgeExtractor::Edge>::iterator it = edges.find(e);
-  if (it != edges.end())
+  // Open-addressing table mapping an ordered pair of welded vertex ids to the first and last
+  // triangle sharing it. Slots are kept in insertion order so the output is deterministic.
+  class EdgeTable
   {
-    VL_CHECK(!it->normal1().isNull())
-    if (mWarnNonManifold && !it->normal2().isNull())
-      vl::Log::error("EdgeExtractor: non-manifold mesh detected!\n");
-      EdgeExtractor::Edge edge = e;
-      edge.setNormal1(it->normal1());
-      edge.setNormal2(n);
-      edges.erase( it );
-      edges.insert(edge);
-  }
-  else
+  public:
+    struct Slot
+    {
+      u64 mKey;
+      u32 mFirst;
+      u32 mLast;
+      u32 mCount;
+    };
+
+    EdgeTable(): mMask(0) {}
+
+    void reserve(size_t edge_count)
+    {
+      size_t size = 64;
+      while(size < edge_count * 2)
+        size <<= 1;
+      mIndex.assign(size, 0xFFFFFFFF);
+      mMask = (u32)(size - 1);
+      mSlots.clear();
+      mSlots.reserve(edge_count);
+    }
+
+    void insert(u64 key, u32 first, u32 last, u32 count)
+    {
+      if ((mSlots.size()+1) * 2 > mIndex.size())
+        rehash();
+      for(u32 islot = hash(key) & mMask; ; islot = (islot + 1) & mMask)
+      {
+        u32 i = mIndex[islot];
+        if (i == 0xFFFFFFFF)
+        {
+          Slot slot = { key, first, last, count };
+          mIndex[islot] = (u32)mSlots.size();
+          mSlots.push_back(slot);
+          return;
+        }
+        if (mSlots[i].mKey == key)
+        {
+          mSlots[i].mLast   = last;
+          mSlots[i].mCount += count;
+          return;
+        }
+      }
+    }
+
+    const std::vector<Slot>& slots() const { return mSlots; }
+
+  protected:
+    static u32 hash(u64 key)
+    {
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= key >> 33;
+      key *= 0xc4ceb9fe1a85ec53ULL;
+      key ^= key >> 33;
+      return (u32)key;
+    }
+
+    void rehash()
+    {
+      mIndex.assign(mIndex.empty() ? 64 : mIndex.size() * 2, 0xFFFFFFFF);
+      mMask = (u32)(mIndex.size() - 1);
+      for(u32 i=0; i<(u32)mSlots.size(); ++i)
+      {
+        u32 islot = hash(mSlots[i].mKey) & mMask;
+        while(mIndex[islot] != 0xFFFFFFFF)
+          islot = (islot + 1) & mMask;
+        mIndex[islot] = i;
+      }
+    }
+
+  protected:
+    std::vector<Slot> mSlots;
+    std::vector<u32> mIndex;
+    u32 mMask;
+  };
+
+  inline u64 edgeKey(u32 a, u32 b)
   {
-    VL_CHECK(!n.isNull());
-    EdgeExtractor::Edge edge = e;
-    edge.setNormal1(n);
-    edges.insert(edge);
+    return a < b ? ((u64)a << 32) | b : ((u64)b << 32) | a;
   }
+
+  //! Triangle visitor collecting the non degenerate triangles remapped through the vertex welding table, see forEachTriangle().
+  struct WeldedTriangleCollector
+  {
+    WeldedTriangleCollector(const u32* weld, std::vector<u32>& tris): mWeld(weld), mTris(tris) {}
+
+    void operator()(int a, int b, int c)
+    {
+      if (a == b || b == c || c == a)
+        return;
+      mTris.push_back(mWeld[a]);
+      mTris.push_back(mWeld[b]);
+      mTris.push_back(mWeld[c]);
+    }
+
+    const u32* mWeld;
+    std::vector<u32>& mTris;
+  };
 }
 //-----------------------------------------------------------------------------
 //! Extracts the edges from the given Geometry and appends them to edges().
+//! Vertices sharing the same position are treated as the same vertex, the new edges are appended
+//! in the order in which they are first found while iterating the triangles of the draw calls.
 void EdgeExtractor::extractEdges(Geometry* geom)
 {
   ArrayAbstract* verts = geom->vertexArray();
 
-  // mic fixme:
-  // here the bottle-neck seems to be the continuous allocation/deallocation and insertion/search time,
-  // maybe a memory-pool-managed hash table would help?
   if (!verts)
   {
     vl::Log::error("EdgeExtractor::extractEdges(geom): 'geom' must have a vertex array of type ArrayFloat3.\n");
     return;
   }
 
-  std::set<Edge> edges;
+  const int vert_count = (int)verts->size();
+  if (!vert_count)
+    return;
+
+  // fetch positions
+
+  std::vector<vec3> pos_storage;
+  const vec3* verts_data = vec3Data(verts, pos_storage);
+  std::vector<fvec3> pos(vert_count);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(vert_count > 10000)
+#endif
+  for(int i=0; i<vert_count; ++i)
+  {
+    pos[i] = (fvec3)verts_data[i];
+    // -0 and +0 must weld together
+    for(int j=0; j<3; ++j)
+      if (pos[i][j] == 0)
+        pos[i][j] = 0;
+  }
+
+  // weld vertices with the same position: each vertex maps to the first vertex with its position
+
+  std::vector<u32> weld(vert_count);
+  {
+    u32 table_size = 64;
+    while(table_size < (u32)vert_count * 2)
+      table_size <<= 1;
+    const u32 mask = table_size - 1;
+    std::vector<u32> table(table_size, 0xFFFFFFFF);
+    for(int i=0; i<vert_count; ++i)
+    {
+      u32 h = 0;
+      MurmurHash3_x86_32(pos[i].ptr(), sizeof(fvec3), 0, &h);
+      for(u32 slot = h & mask; ; slot = (slot + 1) & mask)
+      {
+        if (table[slot] == 0xFFFFFFFF)
+        {
+          table[slot] = weld[i] = i;
+          break;
+        }
+        if (pos[table[slot]] == pos[i])
+        {
+          weld[i] = table[slot];
+          break;
+        }
+      }
+    }
+  }
+
+  // collect the triangles of all the draw calls
+
+  std::vector<u32> tris;
+  WeldedTriangleCollector collector(&weld[0], tris);
+  for(int idc=0; idc<geom->drawCalls().size(); ++idc)
+    forEachTriangle(geom->drawCalls().at(idc), collector);
+
+  const int tri_count = (int)tris.size() / 3;
+  if (!tri_count)
+    return;
+
+  // compute the triangle normals, null normals mark triangles to be ignored
+
+  std::vector<fvec3> normals(tri_count);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(tri_count > 10000)
+#endif
+  for(int i=0; i<tri_count; ++i)
+  {
+    const fvec3& v0 = pos[ tris[i*3+0] ];
+    fvec3 v1 = pos[ tris[i*3+1] ] - v0;
+    fvec3 v2 = pos[ tris[i*3+2] ] - v0;
+    normals[i] = cross(v1,v2).normalize();
+  }
+
+  // build one edge table per chunk of triangles, then merge them in order
 
-  // iterate all primitives
-  for(int iprim=0; iprim<geom->drawCalls().size(); ++iprim)
+  const int chunk_size = 1 << 18;
+  const int chunk_count = (tri_count + chunk_size - 1) / chunk_size;
+  std::vector<EdgeTable> tables(chunk_count);
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) if(chunk_count > 1)
+#endif
+  for(int ichunk=0; ichunk<chunk_count; ++ichunk)
   {
-    DrawCall* prim = geom->drawCalls().at(iprim);
-    // iterate triangles (if present)
-    for(TriangleIterator trit = prim->triangleIterator(); trit.hasNext(); trit.next())
+    const int start = ichunk * chunk_size;
+    const int end   = vl::min(start + chunk_size, tri_count);
+    EdgeTable& table = tables[ichunk];
+    table.reserve( (end - start) * 3 / 2 );
+    for(int i=start; i<end; ++i)
     {
-      size_t a = trit.a();
-      size_t b = trit.b();
-      size_t c = trit.c();
-      if (a == b || b == c || c == a)
-        continue;
-      // compute normal
-      fvec3 v0 = (fvec3)verts->getAsVec3(a);
-      fvec3 v1 = (fvec3)verts->getAsVec3(b) - v0;
-      fvec3 v2 = (fvec3)verts->getAsVec3(c) - v0;
-      fvec3 n = cross(v1,v2).normalize();
-      if (n.isNull())
+      if (normals[i].isNull())
         continue;
-      addEdge(edges, Edge( (fvec3)verts->getAsVec3(a), (fvec3)verts->getAsVec3(b) ), n );
-      addEdge(edges, Edge( (fvec3)verts->getAsVec3(b), (fvec3)verts->getAsVec3(c) ), n );
-      addEdge(edges, Edge( (fvec3)verts->getAsVec3(c), (fvec3)verts->getAsVec3(a) ), n );
+      const u32 a = tris[i*3+0];
+      const u32 b = tris[i*3+1];
+      const u32 c = tris[i*3+2];
+      table.insert( edgeKey(a,b), i, i, 1 );
+      table.insert( edgeKey(b,c), i, i, 1 );
+      table.insert( edgeKey(c,a), i, i, 1 );
+    }
+  }
+
+  EdgeTable merged_table;
+  if (chunk_count > 1)
+  {
+    merged_table.reserve( tables[0].slots().size() * chunk_count );
+    for(int ichunk=0; ichunk<chunk_count; ++ichunk)
+    {
+      const std::vector<EdgeTable::Slot>& slots = tables[ichunk].slots();
+      for(size_t i=0; i<slots.size(); ++i)
+        merged_table.insert( slots[i].mKey, slots[i].mFirst, slots[i].mLast, slots[i].mCount );
+      tables[ichunk] = EdgeTable();
     }
   }
+  const std::vector<EdgeTable::Slot>& slots = chunk_count > 1 ? merged_table.slots() : tables[0].slots();
+
+  // generate the edges
 
-  for(std::set<Edge>::iterator it = edges.begin(); it != edges.end(); ++it)
+  const size_t first_edge = mEdges.size();
+  mEdges.resize( first_edge + slots.size() );
+  bool non_manifold = false;
+  for(size_t i=0; i<slots.size(); ++i)
+  {
+    const EdgeTable::Slot& slot = slots[i];
+    Edge& edge = mEdges[first_edge + i];
+    edge = Edge( pos[(u32)(slot.mKey >> 32)], pos[(u32)slot.mKey] );
+    edge.setNormal1( normals[slot.mFirst] );
+    if (slot.mCount > 1)
+      edge.setNormal2( normals[slot.mLast] );
+    non_manifold |= slot.mCount > 2;
+  }
+
+  if (mWarnNonManifold && non_manifold)
+    vl::Log::error("EdgeExtractor: non-manifold mesh detected!\n");
+
+  if (first_edge < mEdges.size())
+    updateCreases( &mEdges[first_edge], mEdges.size() - first_edge, creaseAngle() );
+}
+//-----------------------------------------------------------------------------
+void EdgeExtractor::updateCreases(Edge* edges, size_t count, float crease_angle)
+{
+  const int edge_count = (int)count;
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(edge_count > 10000)
+#endif
+  for(int i=0; i<edge_count; ++i)
   {
-    Edge e = *it;
+    Edge& e = edges[i];
     // boundary edge
     if (e.normal2().isNull())
       e.setIsCrease(true);
@@ -117,10 +321,8 @@ void EdgeExtractor::extractEdges(Geometry* geom)
       cos1 = vl::clamp(cos1,-1.0f,+1.0f);
       // return value in the interval [0,pi] radians
       float a1 = acos(cos1) / fPi * 180.0f;
-      if( a1 > creaseAngle() )
-        e.setIsCrease(true);
+      e.setIsCrease( a1 > crease_angle );
     }
-    mEdges.push_back(e);
   }
 }
 //-----------------------------------------------------------------------------
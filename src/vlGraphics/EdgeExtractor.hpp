@@ -36,7 +36,6 @@
 #include <vlCore/Vector3.hpp>
 #include <vlGraphics/link_config.hpp>
 #include <vector>
-#include <set>
 
 namespace vl
 {
@@ -61,6 +60,8 @@ namespace vl
 
   \par Usage
   - Extract the edges from one or more Geometry objects using one of the extractEdges() methods.
+    Vertices sharing the same position are welded together and the edges are appended in the order in which they are first found.
+  - If only the crease angle changes use updateCreases() instead of extracting the edges again.
   - Assign the Geometry returned by generateEdgeGeometry() to a new Actor. This geometry will contain the edges previously extracted ready to be rendered.
   - Assign a new EdgeUpdateCallback to the previously created Actor, using the Actor::renderEventCallbacks() method.
   - Initialize the previously created EdgeUpdateCallback edges with the edges extracted by the EdgeExtractor,
@@ -156,12 +157,24 @@ namespace vl
     //! The minimum angle (in degrees) considered to generate crease-edges
     void setCreaseAngle(float a) { mCreaseAngle = a; }
 
+    //! Recomputes the Edge::isCrease() flag of edges() using the current creaseAngle().
+    //! Use this instead of re-extracting the edges when only the crease angle changed.
+    void updateCreases() { updateCreases(mEdges, creaseAngle()); }
+
+    //! Recomputes the Edge::isCrease() flag of the given edges: boundary edges are always creases,
+    //! the other edges are creases if their normals form an angle greater than \p crease_angle degrees.
+    static void updateCreases(std::vector<Edge>& edges, float crease_angle)
+    {
+      if (!edges.empty())
+        updateCreases(&edges[0], edges.size(), crease_angle);
+    }
+
+    //! Recomputes the Edge::isCrease() flag of the \p count edges pointed by \p edges.
+    static void updateCreases(Edge* edges, size_t count, float crease_angle);
+
     bool warnNonManifold() const { return mWarnNonManifold; }
     void setWarnNonManifold(bool warn_on) { mWarnNonManifold = warn_on; }
 
-  protected:
-    void addEdge(std::set<EdgeExtractor::Edge>& edges, const EdgeExtractor::Edge& e, const fvec3& n);
-
   protected:
     std::vector<Edge> mEdges;
     float mCreaseAngle;
@@ -33,9 +33,83 @@
 #include <vlGraphics/EdgeRenderer.hpp>
 #include <vlGraphics/RenderQueue.hpp>
 #include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/AdjacencyExtractor.hpp>
+#include <vlGraphics/GLSL.hpp>
 
 using namespace vl;
 
+namespace
+{
+  const char* GPUEdgeVertexShader =
+    "#version 150 compatibility\n"
+    "void main(void)\n"
+    "{\n"
+    "  gl_Position = gl_Vertex;\n"
+    "}\n";
+
+  // Emits the silhouette, crease and border edges of each triangle. Edges shared by two triangles are
+  // emitted only by the triangle whose opposite vertex is the lesser, so that they are drawn once.
+  const char* GPUEdgeGeometryShader =
+    "#version 150 compatibility\n"
+    "layout(triangles_adjacency) in;\n"
+    "layout(line_strip, max_vertices = 6) out;\n"
+    "uniform float vl_EdgeCreaseCos;\n"
+    "uniform bool vl_EdgeShowCreases;\n"
+    "bool lessThanVec(vec3 a, vec3 b)\n"
+    "{\n"
+    "  if (a.x != b.x) return a.x < b.x;\n"
+    "  if (a.y != b.y) return a.y < b.y;\n"
+    "  return a.z < b.z;\n"
+    "}\n"
+    "void main(void)\n"
+    "{\n"
+    "  vec3 p[6];\n"
+    "  for(int i=0; i<6; ++i)\n"
+    "    p[i] = (gl_ModelViewMatrix * gl_in[i].gl_Position).xyz;\n"
+    "  vec3 n = cross(p[2]-p[0], p[4]-p[0]);\n"
+    "  if (dot(n,n) == 0.0)\n"
+    "    return;\n"
+    "  n = normalize(n);\n"
+    "  bool ortho = gl_ProjectionMatrix[2][3] == 0.0;\n"
+    "  for(int i=0; i<6; i+=2)\n"
+    "  {\n"
+    "    int ib = (i+2) % 6;\n"
+    "    vec3 a = p[i];\n"
+    "    vec3 b = p[ib];\n"
+    "    vec3 d = p[i+1];\n"
+    "    vec3 m = cross(a-b, d-b);\n"
+    "    bool emit_edge;\n"
+    "    // border edge: no adjacent triangle or a degenerate one\n"
+    "    if (gl_in[i+1].gl_Position == gl_in[i].gl_Position || dot(m,m) == 0.0)\n"
+    "      emit_edge = vl_EdgeShowCreases;\n"
+    "    else\n"
+    "    {\n"
+    "      if ( ! lessThanVec(gl_in[(i+4) % 6].gl_Position.xyz, gl_in[i+1].gl_Position.xyz) )\n"
+    "        continue;\n"
+    "      m = normalize(m);\n"
+    "      vec3 v = ortho ? vec3(0.0, 0.0, 1.0) : normalize(a+b);\n"
+    "      emit_edge = dot(n,v) * dot(m,v) < 0.0 || (vl_EdgeShowCreases && dot(n,m) < vl_EdgeCreaseCos);\n"
+    "    }\n"
+    "    if (emit_edge)\n"
+    "    {\n"
+    "      gl_Position = gl_ProjectionMatrix * vec4(a, 1.0);\n"
+    "      EmitVertex();\n"
+    "      gl_Position = gl_ProjectionMatrix * vec4(b, 1.0);\n"
+    "      EmitVertex();\n"
+    "      EndPrimitive();\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+
+  const char* GPUEdgeFragmentShader =
+    "#version 150 compatibility\n"
+    "uniform vec4 vl_EdgeColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "  gl_FragColor = vl_EdgeColor;\n"
+    "}\n";
+}
+
 //-----------------------------------------------------------------------------
 const RenderQueue* EdgeRenderer::render(const RenderQueue* render_queue, Camera* camera, real frame_clock)
 {
@@ -190,14 +264,25 @@ void EdgeRenderer::renderSolids(Camera* camera, real frame_clock)
     }
 
     // note: the color is not important here
-    wfinfo->mEdgeCallback->setShowCreases(showCreases());
-    wfinfo->mEdgeCallback->onActorRenderStarted( actor.get(), frame_clock, camera, wfinfo->mGeometry.get(), NULL, 0 );
+    if (wfinfo->mEdgeCallback)
+    {
+      wfinfo->mEdgeCallback->setShowCreases(showCreases());
+      wfinfo->mEdgeCallback->onActorRenderStarted( actor.get(), frame_clock, camera, wfinfo->mGeometry.get(), NULL, 0 );
+    }
     actor->lod(0)->render( actor.get(), NULL, camera, framebuffer()->openglContext() );
   }
 }
 //-----------------------------------------------------------------------------
 void EdgeRenderer::renderLines(Camera* camera)
 {
+  const GLSLProgram* gpu_program = gpuEdgesEnabled() && isGPUEdgeRenderingSupported() ? gpuEdgeProgram() : NULL;
+  if (gpu_program)
+  {
+    framebuffer()->openglContext()->useGLSLProgram(gpu_program);
+    glUniform1f( gpu_program->getUniformLocation("vl_EdgeCreaseCos"), (float)cos( creaseAngle() * dDEG_TO_RAD ) );
+    glUniform1i( gpu_program->getUniformLocation("vl_EdgeShowCreases"), showCreases() ? 1 : 0 );
+  }
+
   // transform
   const Transform* cur_transform = NULL;
   camera->applyViewMatrix();
@@ -236,62 +321,120 @@ void EdgeRenderer::renderLines(Camera* camera)
     }
 
     // note: no rendering callbacks here
-    glColor4fv( wfinfo->mColor.ptr() );
-    wfinfo->mGeometry->render( actor.get(), NULL, camera, framebuffer()->openglContext() );
+    if (gpu_program)
+    {
+      if (wfinfo->mAdjacencyGeometry)
+      {
+        glUniform4fv( gpu_program->getUniformLocation("vl_EdgeColor"), 1, wfinfo->mColor.ptr() );
+        wfinfo->mAdjacencyGeometry->render( actor.get(), NULL, camera, framebuffer()->openglContext() );
+      }
+    }
+    else
+    if (wfinfo->mGeometry)
+    {
+      glColor4fv( wfinfo->mColor.ptr() );
+      wfinfo->mGeometry->render( actor.get(), NULL, camera, framebuffer()->openglContext() );
+    }
   }
+
+  if (gpu_program)
+    framebuffer()->openglContext()->useGLSLProgram(NULL);
 }
 //-----------------------------------------------------------------------------
-EdgeRenderer::WFInfo* EdgeRenderer::declareActor(Actor* act, const fvec4& color)
+void EdgeRenderer::updateCreases(WFInfo* info)
 {
-  std::map< ref<Actor>, ref<WFInfo> >::iterator it = mActorCache.find( act );
-  if (it!=mActorCache.end())
+  if (info->mEdgeCallback && info->mCreaseAngle != creaseAngle())
   {
-    it->second->mColor = color;
-    return it->second.get();
+    EdgeExtractor::updateCreases( info->mEdgeCallback->edges(), creaseAngle() );
+    info->mCreaseAngle = creaseAngle();
+  }
+}
+//-----------------------------------------------------------------------------
+ref<EdgeRenderer::WFInfo> EdgeRenderer::createWFInfo(Actor* act)
+{
+  ref<WFInfo> info = new WFInfo;
+  if (gpuEdgesEnabled() && isGPUEdgeRenderingSupported())
+  {
+    Geometry* geom = cast<Geometry>(act->lod(0));
+    if (!geom || !geom->vertexArray())
+      return NULL;
+    // the adjacency geometry shares the vertex array of the actor's geometry
+    info->mAdjacencyGeometry = AdjacencyExtractor::extract(geom, true);
+    if (!info->mAdjacencyGeometry)
+      return NULL;
+    info->mAdjacencyGeometry->setBufferObjectEnabled( geom->isBufferObjectEnabled() );
   }
   else
   {
-    ref<WFInfo> info = new WFInfo;
     EdgeExtractor ee;
     ee.setCreaseAngle( creaseAngle() );
-    if (ee.extractEdges(act))
-    {
-      info->mGeometry = ee.generateEdgeGeometry();
-      info->mEdgeCallback = new EdgeUpdateCallback(ee.edges());
-      if (info->mGeometry)
-      {
-        info->mColor = color;
-        mActorCache[act] = info;
-        return info.get();
-      }
-    }
+    if (!ee.extractEdges(act))
+      return NULL;
+    info->mGeometry = ee.generateEdgeGeometry();
+    if (!info->mGeometry)
+      return NULL;
+    info->mEdgeCallback = new EdgeUpdateCallback(ee.edges());
+    info->mCreaseAngle = creaseAngle();
   }
-  return NULL;
+  return info;
+}
+//-----------------------------------------------------------------------------
+EdgeRenderer::WFInfo* EdgeRenderer::declareActor(Actor* act, const fvec4& color)
+{
+  WFInfo* info = declareActor(act);
+  if (info)
+    info->mColor = color;
+  return info;
 }
 //-----------------------------------------------------------------------------
 EdgeRenderer::WFInfo* EdgeRenderer::declareActor(Actor* act)
 {
   std::map< ref<Actor>, ref<WFInfo> >::iterator it = mActorCache.find( act );
   if (it!=mActorCache.end())
+  {
+    updateCreases(it->second.get());
     return it->second.get();
+  }
   else
   {
-    ref<WFInfo> info = new WFInfo;
-    EdgeExtractor ee;
-    ee.setCreaseAngle( creaseAngle() );
-    if (ee.extractEdges(act))
+    ref<WFInfo> info = createWFInfo(act);
+    if (info)
     {
-      info->mGeometry = ee.generateEdgeGeometry();
-      info->mEdgeCallback = new EdgeUpdateCallback(ee.edges());
-      if (info->mGeometry)
-      {
-        info->mColor = mDefaultLineColor;
-        mActorCache[act] = info;
-        return info.get();
-      }
+      info->mColor = mDefaultLineColor;
+      mActorCache[act] = info;
     }
+    return info.get();
+  }
+}
+//-----------------------------------------------------------------------------
+void EdgeRenderer::setGPUEdgesEnabled(bool enabled)
+{
+  if (enabled != mGPUEdgesEnabled)
+  {
+    mGPUEdgesEnabled = enabled;
+    clearCache();
   }
-  return NULL;
 }
 //-----------------------------------------------------------------------------
+bool EdgeRenderer::isGPUEdgeRenderingSupported()
+{
+  return Has_GL_Version_3_2 || Has_GL_Version_4_0;
+}
+//-----------------------------------------------------------------------------
+GLSLProgram* EdgeRenderer::gpuEdgeProgram()
+{
+  if (!mGPUEdgeProgram)
+  {
+    mGPUEdgeProgram = new GLSLProgram;
+    mGPUEdgeProgram->setObjectName("EdgeRenderer::gpuEdgeProgram");
+    mGPUEdgeProgram->attachShader( new GLSLVertexShader(GPUEdgeVertexShader) );
+    mGPUEdgeProgram->attachShader( new GLSLGeometryShader(GPUEdgeGeometryShader) );
+    mGPUEdgeProgram->attachShader( new GLSLFragmentShader(GPUEdgeFragmentShader) );
+  }
 
+  if ( !mGPUEdgeProgram->linked() && !mGPUEdgeProgram->linkProgram() )
+    return NULL;
+
+  return mGPUEdgeProgram.get();
+}
+//-----------------------------------------------------------------------------
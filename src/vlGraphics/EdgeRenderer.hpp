@@ -35,6 +35,7 @@
 #include <vlGraphics/Renderer.hpp>
 #include <vlGraphics/EdgeExtractor.hpp>
 #include <vlGraphics/EdgeUpdateCallback.hpp>
+#include <vlGraphics/GLSL.hpp>
 
 namespace vl
 {
@@ -48,6 +49,14 @@ namespace vl
   keep the cache as clean and up to date as possible.
   The color used to render the edges can be set globally using the setDefaultLineColor() method or by Actor using the declareActor() method.
 
+  \par GPU edges
+  If setGPUEdgesEnabled() is \p true and the OpenGL context supports geometry shaders (see isGPUEdgeRenderingSupported())
+  the EdgeRenderer caches only a PT_TRIANGLES_ADJACENCY version of the Actor's Geometry, generated by AdjacencyExtractor,
+  and a geometry shader computes the silhouette, crease and border edges every frame. The adjacency geometry shares the
+  vertex array of the original Geometry so that changes to the vertex positions are picked up without re-extracting the
+  edges, only changes to the topology of the mesh require setActorDirty(). If geometry shaders are not supported the
+  edges are extracted on the CPU as usual.
+
   \sa
   - \ref pagGuideEdgeRendering "Edge Enhancement and Wireframe Rendering Tutorial"
   - vl::EdgeExtractor
@@ -59,14 +68,18 @@ namespace vl
     class WFInfo: public Object
     {
     public:
-      WFInfo(): mColor( vl::black ) {}
+      WFInfo(): mColor( vl::black ), mCreaseAngle(0) {}
       fvec4 mColor;
+      //! The crease angle used to compute the crease flags of mEdgeCallback's edges.
+      float mCreaseAngle;
       ref<Geometry> mGeometry;
       ref<EdgeUpdateCallback> mEdgeCallback;
+      //! Used instead of mGeometry and mEdgeCallback when GPU edges are enabled.
+      ref<Geometry> mAdjacencyGeometry;
     };
 
   public:
-    EdgeRenderer(): mLineWidth(1.0f), mPolygonOffsetFactor(1.0f), mPolygonOffsetUnits(1.0f), mCreaseAngle(44.0f), mShowHiddenLines(true), mShowCreases(true), mSmoothLines(true)
+    EdgeRenderer(): mLineWidth(1.0f), mPolygonOffsetFactor(1.0f), mPolygonOffsetUnits(1.0f), mCreaseAngle(44.0f), mShowHiddenLines(true), mShowCreases(true), mSmoothLines(true), mGPUEdgesEnabled(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -99,6 +112,7 @@ namespace vl
     bool showCreases() const { return mShowCreases; }
 
     //! The minimum angle (in degrees) considered to generate crease-edges (default is 44 degrees).
+    //! Changing the crease angle does not require the edges to be extracted again, only their crease flags are updated.
     void setCreaseAngle(float degrees) { mCreaseAngle = degrees; }
     //! The minimum angle (in degrees) considered to generate crease-edges (default is 44 degrees).
     float creaseAngle() const { return mCreaseAngle; }
@@ -118,6 +132,18 @@ namespace vl
     //! Defines the default color of the rendered edges. You can also define a per-Actor color using the declareActor() method.
     const fvec4& defaultLineColor() const { return mDefaultLineColor; }
 
+    //! If \p true the silhouette and crease edges are computed on the GPU by a geometry shader, see isGPUEdgeRenderingSupported().
+    //! Changing this setting clears the cache.
+    void setGPUEdgesEnabled(bool enabled);
+    //! If \p true the silhouette and crease edges are computed on the GPU by a geometry shader, see isGPUEdgeRenderingSupported().
+    bool gpuEdgesEnabled() const { return mGPUEdgesEnabled; }
+
+    //! Whether the current OpenGL context supports GPU edge rendering, ie. geometry shaders and adjacency primitives.
+    static bool isGPUEdgeRenderingSupported();
+
+    //! The GLSLProgram used to render the GPU edges, linked on first use. Returns NULL if the program could not be linked.
+    GLSLProgram* gpuEdgeProgram();
+
     //! Defines the \p factor parameter used to render the lines over the polygons. See also http://www.opengl.org/sdk/docs/man/xhtml/glPolygonOffset.xml for more information.
     void setPolygonOffsetFactor(float factor) { mPolygonOffsetFactor = factor; }
     //! Defines the \p factor parameter used to render the lines over the polygons. See also http://www.opengl.org/sdk/docs/man/xhtml/glPolygonOffset.xml for more information.
@@ -130,6 +156,8 @@ namespace vl
   protected:
     void renderSolids(Camera* camera, real frame_clock);
     void renderLines(Camera* camera);
+    void updateCreases(WFInfo* info);
+    ref<WFInfo> createWFInfo(Actor* act);
 
   protected:
     std::map< ref<Actor>, ref<WFInfo> > mActorCache;
@@ -142,6 +170,8 @@ namespace vl
     bool mShowHiddenLines;
     bool mShowCreases;
     bool mSmoothLines;
+    bool mGPUEdgesEnabled;
+    ref<GLSLProgram> mGPUEdgeProgram;
   };
 
 }
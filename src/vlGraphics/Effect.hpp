@@ -161,7 +161,7 @@ namespace vl
       * To know more about rendering order please see \ref pagGuideRenderOrder "Rendering Order".
       *
       * \sa Actor::setRenderRank(), Actor::setRenderBlock() */
-    void setRenderRank(int rank) { mRenderRank = rank; }
+    void setRenderRank(int rank) { mRenderRank = rank; DirtyTracker::markDirty(); }
 
     /** Returns the rendering rank of an Effect. */
     int renderRank() const { return mRenderRank; }
@@ -185,6 +185,7 @@ namespace vl
     {
       VL_CHECK(lodi<VL_MAX_EFFECT_LOD)
       lod(lodi) = new ShaderPasses(shader1,shader2,shader3,shader4);
+      DirtyTracker::markDirty();
     }
 
     /** Installs the LODEvaluator used to compute the current LOD at rendering time. */
@@ -197,7 +198,7 @@ namespace vl
     const LODEvaluator* lodEvaluator() const { return mLODEvaluator.get(); }
 
     /** The enable mask of an Actor's Effect defines whether the actor should be rendered or not depending on the Rendering::enableMask(). */
-    void setEnableMask(unsigned int mask) { mEnableMask = mask; }
+    void setEnableMask(unsigned int mask) { mEnableMask = mask; DirtyTracker::markDirty(); }
 
     /** The enable mask of an Actor's Effect defines whether the actor should be rendered or not depending on the Rendering::enableMask(). */
     unsigned int enableMask() const { return mEnableMask; }
@@ -49,14 +49,14 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::EnableSet, Object)
 
   public:
-    EnableSet(): mBlendingEnabled(false)
+    EnableSet(): mEnableMask(0), mBlendingEnabled(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       // these two are enabled by default
-      mEnables.push_back(EN_DITHER);
+      enable(EN_DITHER);
       // only OpenGL ES 2 does not support GL_MULTISAMPLE
 #if !defined(VL_OPENGL_ES2)
-      mEnables.push_back(EN_MULTISAMPLE);
+      enable(EN_MULTISAMPLE);
 #endif
     }
 
@@ -66,6 +66,7 @@ namespace vl
     {
       if (capability == EN_BLEND)
         mBlendingEnabled = true;
+      mEnableMask |= (u64)1 << capability;
       for(unsigned i=0; i<mEnables.size(); ++i)
         if (mEnables[i] == capability)
           return;
@@ -76,6 +77,7 @@ namespace vl
     {
       if (capability == EN_BLEND)
         mBlendingEnabled = false;
+      mEnableMask &= ~((u64)1 << capability);
       for(unsigned i=0; i<mEnables.size(); ++i)
       {
         if (mEnables[i] == capability)
@@ -90,18 +92,20 @@ namespace vl
 
     int isEnabled(EEnable capability) const
     {
-      for(unsigned i=0; i<mEnables.size(); ++i)
-        if (mEnables[i] == capability)
-          return true;
-      return false;
+      return (mEnableMask & ((u64)1 << capability)) != 0;
     }
 
-    void disableAll() { mEnables.clear(); mBlendingEnabled=false; }
+    //! Bitmask of the enabled capabilities where bit \p i is set if the EEnable \p i is enabled.
+    //! Used by OpenGLContext::applyEnables() to compute the minimal set of glEnable()/glDisable() calls.
+    u64 enableMask() const { return mEnableMask; }
+
+    void disableAll() { mEnables.clear(); mEnableMask = 0; mBlendingEnabled=false; }
 
     bool isBlendingEnabled() const { return mBlendingEnabled; }
 
   protected:
     std::vector<EEnable> mEnables;
+    u64 mEnableMask;
     bool mBlendingEnabled;
   };
 }
@@ -36,6 +36,7 @@
 #include <vlCore/Say.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/Image.hpp>
+#include <cmath>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -66,16 +67,140 @@ const char* get_ft_error_message(int error)
   return ft_errors[i].err_msg;
 }
 
+//-----------------------------------------------------------------------------
+namespace
+{
+  const float EDT_INF = 1e20f;
+
+  // 1D squared Euclidean distance transform, see Felzenszwalb & Huttenlocher "Distance Transforms of Sampled Functions".
+  void edt1D(const float* f, float* d, int* v, float* z, int n)
+  {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -EDT_INF;
+    z[1] = +EDT_INF;
+    for(int q=1; q<n; ++q)
+    {
+      float s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+      while(s <= z[k])
+      {
+        --k;
+        s = ((f[q] + q*q) - (f[v[k]] + v[k]*v[k])) / (2*q - 2*v[k]);
+      }
+      ++k;
+      v[k] = q;
+      z[k] = s;
+      z[k+1] = +EDT_INF;
+    }
+    k = 0;
+    for(int q=0; q<n; ++q)
+    {
+      while(z[k+1] < q)
+        ++k;
+      d[q] = (q-v[k])*(q-v[k]) + f[v[k]];
+    }
+  }
+
+  // 2D squared Euclidean distance transform of a w x h grid: 0 for feature pixels, EDT_INF elsewhere.
+  void edt2D(std::vector<float>& grid, int w, int h)
+  {
+    const int n = w > h ? w : h;
+    std::vector<float> f(n), d(n), z(n+1);
+    std::vector<int> v(n);
+    // columns
+    for(int x=0; x<w; ++x)
+    {
+      for(int y=0; y<h; ++y)
+        f[y] = grid[x + y*w];
+      edt1D(&f[0], &d[0], &v[0], &z[0], h);
+      for(int y=0; y<h; ++y)
+        grid[x + y*w] = d[y];
+    }
+    // rows
+    for(int y=0; y<h; ++y)
+    {
+      edt1D(&grid[y*w], &d[0], &v[0], &z[0], w);
+      for(int x=0; x<w; ++x)
+        grid[x + y*w] = d[x];
+    }
+  }
+
+  // converts the coverage stored in the alpha channel of an RGBA image into a signed distance field:
+  // 0.5 on the outline, growing inside the glyph, reaching 0 and 1 at 'spread' pixels from the outline.
+  void makeSignedDistanceField(Image* img, int spread)
+  {
+    const int w = img->width();
+    const int h = img->height();
+    std::vector<float> outside(w*h), inside(w*h);
+    for(int y=0; y<h; ++y)
+    {
+      const unsigned char* px = img->pixels() + y*img->pitch();
+      for(int x=0; x<w; ++x)
+      {
+        bool in = px[x*4+3] >= 128;
+        outside[x + y*w] = in ? 0 : EDT_INF;
+        inside [x + y*w] = in ? EDT_INF : 0;
+      }
+    }
+    edt2D(outside, w, h);
+    edt2D(inside,  w, h);
+    for(int y=0; y<h; ++y)
+    {
+      unsigned char* px = img->pixels() + y*img->pitch();
+      for(int x=0; x<w; ++x)
+      {
+        // positive outside the glyph
+        float dist = ::sqrt(outside[x + y*w]) - ::sqrt(inside[x + y*w]);
+        float val = 0.5f - dist / (2.0f*spread);
+        val = val < 0 ? 0 : (val > 1 ? 1 : val);
+        px[x*4+3] = (unsigned char)(val * 255.0f + 0.5f);
+      }
+    }
+  }
+
+  const char* SDFVertexShader =
+    "#version 130\n"
+    "void main(void)\n"
+    "{\n"
+    "  gl_Position    = ftransform();\n"
+    "  gl_TexCoord[0] = gl_MultiTexCoord0;\n"
+    "  gl_FrontColor  = gl_Color;\n"
+    "}\n";
+
+  const char* SDFFragmentShader =
+    "#version 130\n"
+    "uniform sampler2D vl_SDFTexture;\n"
+    "uniform float vl_SDFOutlineWidth;  // in distance units\n"
+    "uniform vec4  vl_SDFOutlineColor;  // alpha = 0 to disable\n"
+    "uniform vec2  vl_SDFShadowOffset;  // in texels\n"
+    "uniform vec4  vl_SDFShadowColor;   // alpha = 0 to disable\n"
+    "vec4 over(vec4 a, vec4 b)\n"
+    "{\n"
+    "  float alpha = a.a + b.a * (1.0 - a.a);\n"
+    "  return vec4( (a.rgb * a.a + b.rgb * b.a * (1.0 - a.a)) / max(alpha, 0.0001), alpha );\n"
+    "}\n"
+    "void main(void)\n"
+    "{\n"
+    "  vec2  uv = gl_TexCoord[0].st;\n"
+    "  float d  = texture(vl_SDFTexture, uv).a;\n"
+    "  float aa = max(fwidth(d) * 0.5, 0.001);\n"
+    "  float edge = vl_SDFOutlineColor.a > 0.0 ? 0.5 - vl_SDFOutlineWidth : 0.5;\n"
+    "  vec4 color = vec4(gl_Color.rgb, gl_Color.a * smoothstep(0.5 - aa, 0.5 + aa, d));\n"
+    "  color = over( color, vec4(vl_SDFOutlineColor.rgb, vl_SDFOutlineColor.a * smoothstep(edge - aa, edge + aa, d)) );\n"
+    "  if (vl_SDFShadowColor.a > 0.0)\n"
+    "  {\n"
+    "    float ds = texture(vl_SDFTexture, uv - vl_SDFShadowOffset / vec2(textureSize(vl_SDFTexture, 0))).a;\n"
+    "    color = over( color, vec4(vl_SDFShadowColor.rgb, vl_SDFShadowColor.a * smoothstep(edge - aa, edge + aa, ds)) );\n"
+    "  }\n"
+    "  gl_FragColor = color;\n"
+    "}\n";
+}
 //-----------------------------------------------------------------------------
 // Glyph
 //-----------------------------------------------------------------------------
 Glyph::~Glyph()
 {
-  if (mTextureHandle)
-  {
-    glDeleteTextures(1, &mTextureHandle);
-    mTextureHandle = 0;
-  }
+  // the texture is an atlas owned by the Font
 }
 //-----------------------------------------------------------------------------
 // Font
@@ -88,6 +213,14 @@ Font::Font(FontManager* fm)
   mFT_Face = NULL;
   mSmooth  = false;
   mFreeTypeLoadForceAutoHint = true;
+  mAtlasSize = 0;
+  mAtlasX = 0;
+  mAtlasY = 0;
+  mAtlasRowHeight = 0;
+  mGlyphCacheVersion = 0;
+  mSignedDistanceFieldSpread = 6;
+  mSignedDistanceField = false;
+  mSize = 0;
   setSize(14);
 }
 //-----------------------------------------------------------------------------
@@ -99,12 +232,21 @@ Font::Font(FontManager* fm, const String& font_file, int size)
   mFT_Face = NULL;
   mSmooth  = false;
   mFreeTypeLoadForceAutoHint = true;
+  mAtlasSize = 0;
+  mAtlasX = 0;
+  mAtlasY = 0;
+  mAtlasRowHeight = 0;
+  mGlyphCacheVersion = 0;
+  mSignedDistanceFieldSpread = 6;
+  mSignedDistanceField = false;
+  mSize = 0;
   loadFont(font_file);
   setSize(size);
 }
 //-----------------------------------------------------------------------------
 Font::~Font()
 {
+  clearGlyphs();
   releaseFreeTypeData();
 }
 //-----------------------------------------------------------------------------
@@ -131,10 +273,155 @@ void Font::setSize(int size)
   {
     mSize = size;
     // removes all the cached glyphs
-    mGlyphMap.clear();
+    clearGlyphs();
+  }
+}
+//-----------------------------------------------------------------------------
+void Font::setSignedDistanceField(bool enable)
+{
+  if (mSignedDistanceField != enable)
+  {
+    mSignedDistanceField = enable;
+    clearGlyphs();
   }
 }
 //-----------------------------------------------------------------------------
+void Font::setSignedDistanceFieldSpread(int spread)
+{
+  spread = spread < 1 ? 1 : spread;
+  if (mSignedDistanceFieldSpread != spread)
+  {
+    mSignedDistanceFieldSpread = spread;
+    if (mSignedDistanceField)
+      clearGlyphs();
+  }
+}
+//-----------------------------------------------------------------------------
+GLSLProgram* Font::signedDistanceFieldProgram()
+{
+  if (!mSignedDistanceFieldProgram)
+  {
+    mSignedDistanceFieldProgram = new GLSLProgram;
+    mSignedDistanceFieldProgram->setObjectName("Font::signedDistanceFieldProgram");
+    mSignedDistanceFieldProgram->attachShader( new GLSLVertexShader(SDFVertexShader) );
+    mSignedDistanceFieldProgram->attachShader( new GLSLFragmentShader(SDFFragmentShader) );
+  }
+
+  if ( !mSignedDistanceFieldProgram->linked() && !mSignedDistanceFieldProgram->linkProgram() )
+    return NULL;
+
+  return mSignedDistanceFieldProgram.get();
+}
+//-----------------------------------------------------------------------------
+void Font::clearGlyphs()
+{
+  mGlyphPages.clear();
+  mGlyphMap.clear();
+  if (!mAtlasTextures.empty())
+  {
+    glDeleteTextures( (GLsizei)mAtlasTextures.size(), &mAtlasTextures[0] );
+    mAtlasTextures.clear();
+  }
+  mAtlasSize = 0;
+  mAtlasX = 0;
+  mAtlasY = 0;
+  mAtlasRowHeight = 0;
+  ++mGlyphCacheVersion;
+}
+//-----------------------------------------------------------------------------
+bool Font::allocateAtlasRect(int w, int h, unsigned int& texture, int& x, int& y, int& atlas_size)
+{
+  // simple shelf packing: glyphs are placed left to right in rows as tall as their tallest glyph
+  if ( ! mAtlasTextures.empty() )
+  {
+    if ( mAtlasX + w > mAtlasSize )
+    {
+      mAtlasX = 0;
+      mAtlasY += mAtlasRowHeight;
+      mAtlasRowHeight = 0;
+    }
+    if ( mAtlasY + h > mAtlasSize || w > mAtlasSize )
+      mAtlasSize = 0; // start a new atlas
+  }
+
+  if ( mAtlasTextures.empty() || mAtlasSize == 0 )
+  {
+    int max_tex_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_tex_size);
+
+    // large enough for a few hundred glyphs of this size
+    int size = 256;
+    while( (size < mSize * 16 || size < w || size < h) && size*2 <= max_tex_size )
+      size *= 2;
+
+    if ( size < w || size < h )
+    {
+      Log::error( Say("Font::allocateAtlasRect() error (%s): glyph too big (%nx%n) for the maximum texture size (%n).\n") << filePath() << w << h << max_tex_size );
+      return false;
+    }
+
+    unsigned int texhdl = 0;
+    glGenTextures( 1, &texhdl );
+    VL_glActiveTexture(GL_TEXTURE0);
+    glBindTexture( GL_TEXTURE_2D, texhdl );
+
+    // init to all transparent white
+    std::vector<unsigned char> pixels( size*size*4 );
+    for(size_t i=0; i<pixels.size(); i+=4)
+    {
+      pixels[i+0] = 0xFF;
+      pixels[i+1] = 0xFF;
+      pixels[i+2] = 0xFF;
+      pixels[i+3] = 0x0;
+    }
+    // signed distance fields only need one channel
+    GLint internal_format = signedDistanceField() ? GL_ALPHA8 : GL_RGBA;
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0] ); VL_CHECK_OGL();
+
+    // signed distance fields require linear filtering
+    if ( smooth() || signedDistanceField() )
+    {
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+    }
+    else
+    {
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+    }
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
+
+    // sets anisotropy to the maximum supported
+    if (Has_GL_EXT_texture_filter_anisotropic)
+    {
+      float max_anisotropy;
+      glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+      glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_anisotropy);
+    }
+
+    VL_CHECK_OGL();
+    glBindTexture( GL_TEXTURE_2D, 0 );
+
+    mAtlasTextures.push_back(texhdl);
+    mAtlasSize = size;
+    mAtlasX = 0;
+    mAtlasY = 0;
+    mAtlasRowHeight = 0;
+  }
+
+  texture = mAtlasTextures.back();
+  x = mAtlasX;
+  y = mAtlasY;
+  atlas_size = mAtlasSize;
+
+  mAtlasX += w;
+  if (h > mAtlasRowHeight)
+    mAtlasRowHeight = h;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
 void Font::loadFont(const String& path)
 {
   if(path == mFilePath)
@@ -142,7 +429,7 @@ void Font::loadFont(const String& path)
 
   mFilePath = path;
   // removes all the cached glyphs
-  mGlyphMap.clear();
+  clearGlyphs();
 
   // remove FreeType font face object
   if (mFT_Face)
@@ -180,9 +467,24 @@ void Font::loadFont(const String& path)
   }
 }
 //-----------------------------------------------------------------------------
+ref<Glyph>& Font::glyphSlot(int character)
+{
+  if (character >= 0 && character < 0x10000)
+  {
+    if (mGlyphPages.empty())
+      mGlyphPages.resize(256);
+    std::vector< ref<Glyph> >& page = mGlyphPages[character >> 8];
+    if (page.empty())
+      page.resize(256);
+    return page[character & 0xFF];
+  }
+  else
+    return mGlyphMap[character];
+}
+//-----------------------------------------------------------------------------
 Glyph* Font::glyph(int character)
 {
-  ref<Glyph>& glyph = mGlyphMap[character];
+  ref<Glyph>& glyph = glyphSlot(character);
 
   if (glyph.get() == NULL)
   {
@@ -331,48 +633,23 @@ Glyph* Font::glyph(int character)
       VL_CHECK( mFT_Face->glyph->bitmap.palette_mode == 0 )
       VL_CHECK( mFT_Face->glyph->bitmap.pitch > 0 )
 
-      unsigned int texhdl;
-      glGenTextures( 1, &texhdl );
-      glyph->setTextureHandle(texhdl);
-      VL_glActiveTexture(GL_TEXTURE0);
-      glBindTexture( GL_TEXTURE_2D, glyph->textureHandle() );
+      // the glyph image is placed in the atlas leaving a transparent margin, wide enough for the distance field if needed
+      const int margin = glyphMargin();
+      const int w = glyph->width()  + margin*2;
+      const int h = glyph->height() + margin*2;
 
-      int texsize[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 0 };
-      int max_tex_size = 0;
-      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_tex_size);
-
-      int w=0, h=0, margin = 1;
+      unsigned int texhdl = 0;
+      int atlas_x = 0, atlas_y = 0, atlas_size = 0;
+      if ( ! allocateAtlasRect(w, h, texhdl, atlas_x, atlas_y, atlas_size) )
+        return glyph.get();
 
-      for(int i=0; texsize[i]; ++i)
-      {
-        if ( (texsize[i] >= glyph->width() + margin*2 && texsize[i] >= glyph->height() + margin*2) || texsize[i+1] > max_tex_size )
-        {
-          w = texsize[i];
-          h = texsize[i];
-          break;
-        }
-      }
-      VL_CHECK(w)
-      VL_CHECK(h)
+      glyph->setTextureHandle(texhdl);
 
-#if(1)
       // tex coords DO include the border
-      glyph->setS0( 0 );
-      glyph->setT0( 1 );
-      glyph->setS1((margin*2 + glyph->width() ) /(float)(w-1) );
-      glyph->setT1( 1 -(margin*2 + glyph->height() ) /(float)(h-1) );
-
-      // tex coords DO NOT include the border
-      //glyph->setS0((float)margin /(float)(w-1));
-      //glyph->setT0( 1 -(float)margin /(float)(h-1));
-      //glyph->setS1(((float)margin + glyph->width() ) /(float)(w-1));
-      //glyph->setT1( 1 -((float)margin + glyph->height() ) /(float)(h-1));
-#else
-      glyph->setS0((float)margin /(float)w);
-      glyph->setT0( 1 -(float)margin /(float)h);
-      glyph->setS1(((float)margin + glyph->width() ) /(float)w);
-      glyph->setT1( 1 -((float)margin + glyph->height() ) /(float)h);
-#endif
+      glyph->setS0( (float)atlas_x / atlas_size );
+      glyph->setT0( (float)(atlas_y + h) / atlas_size );
+      glyph->setS1( (float)(atlas_x + w) / atlas_size );
+      glyph->setT1( (float)atlas_y / atlas_size );
 
       ref<Image> img = new Image;
       img->allocate2D(w, h, 1, IF_RGBA, IT_UNSIGNED_BYTE);
@@ -392,54 +669,26 @@ Glyph* Font::glyph(int character)
       {
         for(int x=0; x<glyph->width(); x++)
         {
-          int offset_1 = (x+margin) * 4 + (w-1-y-margin) * img->pitch();
+          int offset_1 = (x+margin) * 4 + (h-1-y-margin) * img->pitch();
           int offset_2 = 0;
           if (mFT_Face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
             offset_2 = x / 8 + y * ::abs(mFT_Face->glyph->bitmap.pitch);
           else
             offset_2 = x + y * mFT_Face->glyph->bitmap.pitch;
 
-#if (1)
           if (mFT_Face->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO)
             img->pixels()[ offset_1+3 ] = (mFT_Face->glyph->bitmap.buffer[ offset_2 ] >> (7-x%8)) & 0x1 ? 0xFF : 0x0;
           else
             img->pixels()[ offset_1+3 ] = mFT_Face->glyph->bitmap.buffer[ offset_2 ];
-#else
-          // debug code
-          img->pixels()[ offset_1+0 ] = face->glyph->bitmap.buffer[ offset_2 ]; // 0xFF;
-          img->pixels()[ offset_1+1 ] = face->glyph->bitmap.buffer[ offset_2 ]; // 0xFF;
-          img->pixels()[ offset_1+2 ] = face->glyph->bitmap.buffer[ offset_2 ]; // 0xFF;
-          img->pixels()[ offset_1+3 ] = 0xFF; // face->glyph->bitmap.buffer[ offset_2 ];
-#endif
         }
       }
 
-      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img->width(), img->height(), 0, img->format(), img->type(), img->pixels() ); VL_CHECK_OGL();
-
-      if ( smooth() )
-      {
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-      }
-      else
-      {
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP );
-        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP );
-      }
-
-      // sets anisotropy to the maximum supported
-      if (Has_GL_EXT_texture_filter_anisotropic)
-      {
-        float max_anisotropy;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_anisotropy);
-      }
+      if ( signedDistanceField() )
+        makeSignedDistanceField( img.get(), mSignedDistanceFieldSpread );
 
-      VL_CHECK_OGL();
+      VL_glActiveTexture(GL_TEXTURE0);
+      glBindTexture( GL_TEXTURE_2D, texhdl );
+      glTexSubImage2D(GL_TEXTURE_2D, 0, atlas_x, atlas_y, w, h, img->format(), img->type(), img->pixels() ); VL_CHECK_OGL();
       glBindTexture( GL_TEXTURE_2D, 0 );
     }
 
@@ -452,15 +701,10 @@ Glyph* Font::glyph(int character)
 void Font::setSmooth(bool smooth)
 {
   mSmooth = smooth;
-  std::map<int, ref<Glyph> >::iterator it = mGlyphMap.begin();
-  for(; it != mGlyphMap.end(); ++it )
+  for(size_t i=0; i<mAtlasTextures.size(); ++i)
   {
-    const ref<Glyph>& glyph = it->second;
-    if (glyph->textureHandle() == 0)
-      continue;
-
-    glBindTexture( GL_TEXTURE_2D, glyph->textureHandle() );
-    if (smooth)
+    glBindTexture( GL_TEXTURE_2D, mAtlasTextures[i] );
+    if (smooth || signedDistanceField())
     {
       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
       glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
@@ -36,6 +36,7 @@
 #include <vlCore/Object.hpp>
 #include <vlCore/Vector4.hpp>
 #include <vlCore/String.hpp>
+#include <vlGraphics/GLSL.hpp>
 #include <map>
 
 //-----------------------------------------------------------------------------
@@ -51,6 +52,9 @@ namespace vl
   //-----------------------------------------------------------------------------
   /**
    * The Glyph associated to a character of a given Font.
+   *
+   * The glyph image is stored in one of the atlas textures owned by its Font: textureHandle() is shared by
+   * many glyphs and s0(), t0(), s1(), t1() define the glyph rectangle, including a 1 pixel transparent margin.
   */
   class Glyph: public Object
   {
@@ -68,7 +72,9 @@ namespace vl
 
     ~Glyph();
 
+    //! The atlas texture containing the glyph image, owned by the Font.
     unsigned int textureHandle() const { return mTextureHandle; }
+    //! The atlas texture containing the glyph image, owned by the Font.
     void setTextureHandle(unsigned int handle) { mTextureHandle = handle; }
 
     int width() const { return mWidth; }
@@ -123,6 +129,15 @@ namespace vl
   //-----------------------------------------------------------------------------
   /**
    * A font to be used with a Text renderable.
+   *
+   * The glyphs are rendered on demand and packed in a few shared atlas textures, so that a Text can draw all its
+   * characters with a single texture binding. The atlas textures are released whenever the glyphs are discarded,
+   * i.e. when the font file or size changes, see glyphCacheVersion().
+   *
+   * In signed distance field mode, see setSignedDistanceField(), the atlases store the distance from the glyph
+   * outline instead of its coverage. A single signed distance field Font rasterized once at a reasonably large size()
+   * can be used to render crisp text at any scale (see Text::setMatrix()), and Text computes the outline and the
+   * shadow in the fragment shader instead of rendering extra passes. See also FontManager::acquireSignedDistanceFieldFont().
   */
   class VLGRAPHICS_EXPORT Font: public Object
   {
@@ -178,6 +193,37 @@ namespace vl
     //! Whether the font rendering should use linear filtering or not.
     bool smooth() const { return mSmooth; }
 
+    //! If enabled the glyphs are stored as signed distance fields, requires OpenGL 3.0 to be rendered by Text and CoreText.
+    //! Changing this discards all the cached glyphs.
+    void setSignedDistanceField(bool enable);
+
+    //! If enabled the glyphs are stored as signed distance fields.
+    bool signedDistanceField() const { return mSignedDistanceField; }
+
+    //! The maximum distance in pixels encoded by the signed distance field (default = 6), also the size of the glyph margin.
+    //! It limits the outline width and shadow offset that can be rendered. Changing this discards all the cached glyphs.
+    void setSignedDistanceFieldSpread(int spread);
+
+    //! The maximum distance in pixels encoded by the signed distance field (default = 6).
+    int signedDistanceFieldSpread() const { return mSignedDistanceFieldSpread; }
+
+    //! The transparent margin in pixels around each glyph image: 1 or signedDistanceFieldSpread() in signed distance field mode.
+    int glyphMargin() const { return mSignedDistanceField ? mSignedDistanceFieldSpread : 1; }
+
+    //! The GLSLProgram used by Text and CoreText to render signed distance field glyphs.
+    //! \note Created on demand, an OpenGL context must be current.
+    GLSLProgram* signedDistanceFieldProgram();
+
+    //! Incremented every time the cached glyphs and atlas textures are discarded, used by Text and CoreText to invalidate their cached geometry.
+    unsigned int glyphCacheVersion() const { return mGlyphCacheVersion; }
+
+    //! The atlas textures currently allocated.
+    const std::vector<unsigned int>& atlasTextures() const { return mAtlasTextures; }
+
+    //! Releases all the cached glyphs and their atlas textures.
+    //! \note An OpenGL context must be current if any atlas texture has been created.
+    void clearGlyphs();
+
     //! Releases the FreeType's FT_Face used by a Font.
     void releaseFreeTypeData();
 
@@ -198,9 +244,19 @@ namespace vl
     //! There isn't a "best" option for all the fonts, the results can be better or worse depending on the particular font loaded.
     void setFreeTypLoadForceAutoHint(bool enable) { mFreeTypeLoadForceAutoHint = enable; }
 
+  protected:
+    //! Finds space for a \p w x \p h image in the atlas textures, creating a new atlas texture if needed.
+    bool allocateAtlasRect(int w, int h, unsigned int& texture, int& x, int& y, int& atlas_size);
+
+    //! Returns the cache slot of the given character, see mGlyphPages.
+    ref<Glyph>& glyphSlot(int character);
+
   protected:
     FontManager* mFontManager;
     String mFilePath;
+    // the glyphs of the Basic Multilingual Plane are looked up in 256 pages of 256 entries allocated on first use,
+    // the other characters in mGlyphMap
+    std::vector< std::vector< ref<Glyph> > > mGlyphPages;
     std::map< int, ref<Glyph> > mGlyphMap;
     FT_Face mFT_Face;
     std::vector<char> mMemoryFile;
@@ -208,6 +264,15 @@ namespace vl
     float mHeight;
     bool mSmooth;
     bool mFreeTypeLoadForceAutoHint;
+    std::vector<unsigned int> mAtlasTextures;
+    int mAtlasSize;
+    int mAtlasX;
+    int mAtlasY;
+    int mAtlasRowHeight;
+    unsigned int mGlyphCacheVersion;
+    ref<GLSLProgram> mSignedDistanceFieldProgram;
+    int mSignedDistanceFieldSpread;
+    bool mSignedDistanceField;
   };
   //-----------------------------------------------------------------------------
 }
@@ -41,18 +41,23 @@ using namespace vl;
 //-----------------------------------------------------------------------------
 FontManager::FontManager(void* free_type_library)
 {
+  // FreeType is initialized on first use by freeTypeLibrary()
   mFreeTypeLibrary = free_type_library;
-  if (!free_type_library)
+  mFreeTypeFailed = false;
+}
+//-----------------------------------------------------------------------------
+void FontManager::initFreeType()
+{
+  FT_Library freetype = NULL;
+  FT_Error error = FT_Init_FreeType( &freetype );
+  if ( error )
   {
-    FT_Library freetype = NULL;
-    FT_Error error = FT_Init_FreeType( &freetype );
-    mFreeTypeLibrary = freetype;
-    if ( error )
-    {
-      Log::error("FontManager::FontManager(): an error occurred during FreeType library initialization!\n");
-      VL_TRAP()
-    }
+    Log::error("FontManager::initFreeType(): an error occurred during FreeType library initialization!\n");
+    mFreeTypeFailed = true;
+    VL_TRAP()
+    return;
   }
+  mFreeTypeLibrary = freetype;
 }
 //-----------------------------------------------------------------------------
 FontManager::~FontManager()
@@ -69,7 +74,7 @@ Font* FontManager::acquireFont(const String& path, int size, bool smooth)
 {
   ref<Font> font;
   for(unsigned i=0; !font && i<mFonts.size(); ++i)
-    if (fonts()[i]->filePath() == path && fonts()[i]->size() == size && fonts()[i]->smooth() == smooth)
+    if (fonts()[i]->filePath() == path && fonts()[i]->size() == size && fonts()[i]->smooth() == smooth && !fonts()[i]->signedDistanceField())
       font = fonts()[i];
 
   if (!font)
@@ -84,6 +89,25 @@ Font* FontManager::acquireFont(const String& path, int size, bool smooth)
   return font.get();
 }
 //-----------------------------------------------------------------------------
+Font* FontManager::acquireSignedDistanceFieldFont(const String& path, int raster_size)
+{
+  ref<Font> font;
+  for(unsigned i=0; !font && i<mFonts.size(); ++i)
+    if (fonts()[i]->filePath() == path && fonts()[i]->signedDistanceField())
+      font = fonts()[i];
+
+  if (!font)
+  {
+    font = new Font(this);
+    font->loadFont(path);
+    font->setSize(raster_size);
+    font->setSignedDistanceField(true);
+    mFonts.push_back( font );
+  }
+
+  return font.get();
+}
+//-----------------------------------------------------------------------------
 void FontManager::releaseFont(Font* font)
 {
   std::vector< ref<Font> >::iterator it = std::find(mFonts.begin(), mFonts.end(), font);
@@ -48,6 +48,7 @@ namespace vl
 
   public:
     //! Constructor: uses the given FT_Library handle otherwise will initialize and use its own FT_Library.
+    //! The own FT_Library is initialized on first use, see freeTypeLibrary().
     FontManager(void* free_type_library=NULL);
 
     //! Destructor: releases all fonts and disposes the FT_Library if not NULL.
@@ -58,6 +59,10 @@ namespace vl
     //! Creates or returns an already created Font.
     Font* acquireFont(const String& font, int size, bool smooth=false);
 
+    //! Creates or returns an already created signed distance field Font, see Font::setSignedDistanceField().
+    //! A single signed distance field Font serves all text sizes, \p raster_size is used only when the Font is first created.
+    Font* acquireSignedDistanceFieldFont(const String& font, int raster_size=48);
+
     //! Returns the list of Fonts created till now.
     const std::vector< ref<Font> >& fonts() const { return mFonts; }
 
@@ -67,19 +72,28 @@ namespace vl
     //! Releases all Fonts and associated resources and memory.
     void releaseAllFonts();
 
-    //! Returns the FT_Library handle.
+    //! Returns the FT_Library handle, NULL if FreeType has not been initialized yet.
     const void* freeTypeLibrary() const { return mFreeTypeLibrary; }
 
-    //! Returns the FT_Library handle.
-    void* freeTypeLibrary() { return mFreeTypeLibrary; }
+    //! Returns the FT_Library handle, initializing FreeType the first time it is called.
+    void* freeTypeLibrary()
+    {
+      if (!mFreeTypeLibrary && !mFreeTypeFailed)
+        initFreeType();
+      return mFreeTypeLibrary;
+    }
 
     //! Sets the FT_Library to the given one and returns the former one.
     //! It is the user responsibility to dispose the returned one (if non-NULL).
     void* setFreeTypeLibrary(void* ftlib) { void* ret = mFreeTypeLibrary; mFreeTypeLibrary = ftlib; return ret; }
 
+  protected:
+    void initFreeType();
+
   protected:
     std::vector< ref<Font> > mFonts;
     void* mFreeTypeLibrary;
+    bool mFreeTypeFailed;
   };
 
   //! Returns the default FontManager used by Visualization Library.
@@ -0,0 +1,295 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/FrameProfiler.hpp>
+#include <vlGraphics/CoreText.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/Time.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cstdio>
+
+using namespace vl;
+
+namespace
+{
+  // GPU frames waiting for their timer queries before the profiler forces the read back
+  const size_t MaxPendingFrames = 8;
+
+  std::string jsonEscape(const std::string& str)
+  {
+    std::string out;
+    for(size_t i=0; i<str.size(); ++i)
+    {
+      if (str[i] == '"' || str[i] == '\\')
+        out += '\\';
+      if ( (unsigned char)str[i] >= 0x20 )
+        out += str[i];
+    }
+    return out;
+  }
+}
+
+//-----------------------------------------------------------------------------
+FrameProfiler::FrameProfiler(): mFrameStart(0), mFrameIndex(0), mHistorySize(300),
+  mFrameOpen(false), mEnabled(true), mGPUTiming(true), mEffectScopes(false)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+}
+//-----------------------------------------------------------------------------
+FrameProfiler::~FrameProfiler()
+{
+  if ( Has_Timer_Query && !mAllQueries.empty() )
+    glDeleteQueries( (GLsizei)mAllQueries.size(), &mAllQueries[0] );
+}
+//-----------------------------------------------------------------------------
+GLuint FrameProfiler::acquireQuery()
+{
+  if ( mFreeQueries.empty() )
+  {
+    GLuint query = 0;
+    glGenQueries(1, &query); VL_CHECK_OGL();
+    mAllQueries.push_back(query);
+    return query;
+  }
+  GLuint query = mFreeQueries.back();
+  mFreeQueries.pop_back();
+  return query;
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::beginFrame()
+{
+  if ( !mEnabled )
+    return;
+
+  if ( mFrameOpen )
+    endFrame();
+
+  mCurrent.mFrame.mIndex = mFrameIndex++;
+  mCurrent.mFrame.mScopes.clear();
+  mCurrent.mGPUScopes.clear();
+  mStack.clear();
+  mGPUStack.clear();
+  mFrameStart = Time::currentMicroseconds();
+  mCurrent.mFrame.mStart = mFrameStart / 1000.0;
+  mFrameOpen = true;
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::endFrame()
+{
+  if ( !mFrameOpen )
+    return;
+
+  // close the scopes left open
+  while( !mStack.empty() )
+    endScope();
+
+  mCurrent.mFrame.mDuration = (Time::currentMicroseconds() - mFrameStart) / 1000.0;
+  mFrameOpen = false;
+
+  if ( mCurrent.mGPUScopes.empty() )
+    pushFrame( mCurrent.mFrame );
+  else
+    mPendingFrames.push_back( mCurrent );
+
+  collectGPUTimings( mPendingFrames.size() > MaxPendingFrames );
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::beginScope(const char* name, bool gpu)
+{
+  if ( !mFrameOpen )
+    return;
+
+  Scope scope;
+  scope.mName = name;
+  scope.mDepth = (int)mStack.size();
+  scope.mStart = (Time::currentMicroseconds() - mFrameStart) / 1000.0;
+  scope.mDuration = 0;
+  scope.mGPUStart = -1;
+  scope.mGPUDuration = -1;
+  mStack.push_back( (int)mCurrent.mFrame.mScopes.size() );
+  mCurrent.mFrame.mScopes.push_back( scope );
+
+  if ( gpu && mGPUTiming && Has_Timer_Query )
+  {
+    GPUScope gpu_scope;
+    gpu_scope.mScope = mStack.back();
+    gpu_scope.mBeginQuery = acquireQuery();
+    gpu_scope.mEndQuery = 0;
+    glQueryCounter( gpu_scope.mBeginQuery, GL_TIMESTAMP ); VL_CHECK_OGL();
+    mGPUStack.push_back( (int)mCurrent.mGPUScopes.size() );
+    mCurrent.mGPUScopes.push_back( gpu_scope );
+  }
+  else
+    mGPUStack.push_back( -1 );
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::endScope()
+{
+  if ( !mFrameOpen || mStack.empty() )
+    return;
+
+  Scope& scope = mCurrent.mFrame.mScopes[ mStack.back() ];
+  scope.mDuration = (Time::currentMicroseconds() - mFrameStart) / 1000.0 - scope.mStart;
+  mStack.pop_back();
+
+  if ( mGPUStack.back() >= 0 )
+  {
+    GPUScope& gpu_scope = mCurrent.mGPUScopes[ mGPUStack.back() ];
+    gpu_scope.mEndQuery = acquireQuery();
+    glQueryCounter( gpu_scope.mEndQuery, GL_TIMESTAMP ); VL_CHECK_OGL();
+  }
+  mGPUStack.pop_back();
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::collectGPUTimings(bool wait)
+{
+  // the queries complete in order: stop at the first frame whose last query is not available
+  while( !mPendingFrames.empty() )
+  {
+    PendingFrame& pending = mPendingFrames.front();
+    if ( !wait )
+    {
+      GLuint available = GL_FALSE;
+      glGetQueryObjectuiv( pending.mGPUScopes.back().mEndQuery, GL_QUERY_RESULT_AVAILABLE, &available ); VL_CHECK_OGL();
+      if ( !available )
+        break;
+    }
+
+    GLuint64 first = 0;
+    for(size_t i=0; i<pending.mGPUScopes.size(); ++i)
+    {
+      const GPUScope& gpu_scope = pending.mGPUScopes[i];
+      GLuint64 begin_ns = 0, end_ns = 0;
+      glGetQueryObjectui64v( gpu_scope.mBeginQuery, GL_QUERY_RESULT, &begin_ns );
+      glGetQueryObjectui64v( gpu_scope.mEndQuery, GL_QUERY_RESULT, &end_ns ); VL_CHECK_OGL();
+      if ( i == 0 )
+        first = begin_ns;
+      Scope& scope = pending.mFrame.mScopes[ gpu_scope.mScope ];
+      scope.mGPUStart = (double)(long long)(begin_ns - first) / 1000000.0;
+      scope.mGPUDuration = (double)(long long)(end_ns - begin_ns) / 1000000.0;
+      mFreeQueries.push_back( gpu_scope.mBeginQuery );
+      mFreeQueries.push_back( gpu_scope.mEndQuery );
+    }
+
+    pushFrame( pending.mFrame );
+    mPendingFrames.pop_front();
+    wait = false;
+  }
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::pushFrame(const Frame& frame)
+{
+  mFrames.push_back( frame );
+  while( (int)mFrames.size() > mHistorySize )
+    mFrames.pop_front();
+}
+//-----------------------------------------------------------------------------
+String FrameProfiler::report() const
+{
+  const Frame* frame = lastFrame();
+  if ( !frame )
+    return String();
+
+  String text = Say("frame %n: %.2nms\n") << frame->mIndex << frame->mDuration;
+  for(size_t i=0; i<frame->mScopes.size(); ++i)
+  {
+    const Scope& scope = frame->mScopes[i];
+    String line;
+    line.resize( (scope.mDepth + 1) * 2 );
+    line.fill(' ');
+    line += String::fromStdString( scope.mName );
+    line += Say(" cpu %.2nms") << scope.mDuration;
+    if ( scope.mGPUDuration >= 0 )
+      line += Say(" gpu %.2nms") << scope.mGPUDuration;
+    text += line + "\n";
+  }
+  return text;
+}
+//-----------------------------------------------------------------------------
+void FrameProfiler::updateText(CoreText* text) const
+{
+  text->setText( report() );
+}
+//-----------------------------------------------------------------------------
+bool FrameProfiler::exportChromeTrace(VirtualFile* file) const
+{
+  std::string json = "{\"traceEvents\":[\n";
+  json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+  json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+  char buffer[256];
+  for(size_t iframe=0; iframe<mFrames.size(); ++iframe)
+  {
+    const Frame& frame = mFrames[iframe];
+    // timestamps and durations are in microseconds
+    const double origin = frame.mStart * 1000.0;
+    sprintf(buffer, ",\n{\"name\":\"frame %lld\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", frame.mIndex, origin, frame.mDuration * 1000.0);
+    json += buffer;
+
+    // the GPU timeline is aligned to the start of the first GPU scope
+    double gpu_origin = -1;
+    for(size_t i=0; i<frame.mScopes.size(); ++i)
+    {
+      const Scope& scope = frame.mScopes[i];
+      json += ",\n{\"name\":\"" + jsonEscape(scope.mName) + "\"";
+      sprintf(buffer, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", origin + scope.mStart * 1000.0, scope.mDuration * 1000.0);
+      json += buffer;
+      if ( scope.mGPUDuration >= 0 )
+      {
+        if ( gpu_origin < 0 )
+          gpu_origin = origin + scope.mStart * 1000.0;
+        json += ",\n{\"name\":\"" + jsonEscape(scope.mName) + "\"";
+        sprintf(buffer, ",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}", gpu_origin + scope.mGPUStart * 1000.0, scope.mGPUDuration * 1000.0);
+        json += buffer;
+      }
+    }
+  }
+  json += "\n]}\n";
+
+  if ( !file->open(OM_WriteOnly) )
+  {
+    Log::error( Say("FrameProfiler::exportChromeTrace(): could not open '%s' for writing.\n") << file->path() );
+    return false;
+  }
+  bool ok = file->write( json.c_str(), json.size() ) == (long long)json.size();
+  file->close();
+  if ( !ok )
+    Log::error( Say("FrameProfiler::exportChromeTrace(): write error: %s\n") << file->path() );
+  return ok;
+}
+//-----------------------------------------------------------------------------
+bool FrameProfiler::exportChromeTrace(const String& path) const
+{
+  ref<DiskFile> file = new DiskFile(path);
+  return exportChromeTrace( file.get() );
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,220 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef FrameProfiler_INCLUDE_ONCE
+#define FrameProfiler_INCLUDE_ONCE
+
+#include <vlGraphics/OpenGL.hpp>
+#include <vlCore/String.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <deque>
+#include <vector>
+#include <string>
+
+namespace vl
+{
+  class CoreText;
+
+  //------------------------------------------------------------------------------
+  // FrameProfiler
+  //------------------------------------------------------------------------------
+  /** Collects the CPU and GPU timings of named, nested scopes, frame by frame.
+    *
+    * Install a FrameProfiler on a Rendering with Rendering::setProfiler() to time its culling, render queue filling and
+    * sorting and each Renderer, optionally broken down by Effect (see setEffectScopes()). User code can add its own
+    * scopes with beginScope() / endScope() or ScopedProfile.
+    *
+    * Wrap the work of a frame between beginFrame() and endFrame(): if a Rendering is rendered outside of a frame it is
+    * profiled as a frame on its own.
+    *
+    * The GPU timings are measured with \p GL_TIMESTAMP queries which are read back asynchronously, usually a couple of
+    * frames later, so that the profiling never stalls the pipeline. For this reason the completed frames returned by
+    * frames() and lastFrame() lag behind the current frame when GPU scopes are used. The GPU scopes must be opened and
+    * closed with the OpenGL context current and require Has_Timer_Query, otherwise only their CPU time is measured.
+    *
+    * The frames can be displayed with updateText() and exported in the Chrome trace event format with exportChromeTrace(),
+    * which can be loaded in chrome://tracing or https://ui.perfetto.dev.
+    */
+  class VLGRAPHICS_EXPORT FrameProfiler: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::FrameProfiler, Object)
+
+  public:
+    //! The timings of a scope, all the times are expressed in milliseconds.
+    struct Scope
+    {
+      std::string mName;
+      //! Nesting level, 0 for the outermost scopes.
+      int mDepth;
+      //! CPU start time relative to the start of the frame.
+      double mStart;
+      //! CPU duration.
+      double mDuration;
+      //! GPU start time relative to the first GPU timestamp of the frame, -1 if not measured.
+      double mGPUStart;
+      //! GPU duration, -1 if not measured.
+      double mGPUDuration;
+    };
+
+    //! A completed frame, see frames().
+    struct Frame
+    {
+      long long mIndex;
+      //! CPU start time in milliseconds since the application started.
+      double mStart;
+      //! CPU duration in milliseconds.
+      double mDuration;
+      std::vector<Scope> mScopes;
+    };
+
+    //! RAII helper opening a scope in its constructor and closing it in its destructor. Does nothing if the profiler is NULL.
+    class ScopedProfile
+    {
+    public:
+      ScopedProfile(FrameProfiler* profiler, const char* name, bool gpu=false): mProfiler(profiler)
+      {
+        if (mProfiler)
+          mProfiler->beginScope(name, gpu);
+      }
+      ~ScopedProfile()
+      {
+        if (mProfiler)
+          mProfiler->endScope();
+      }
+    private:
+      FrameProfiler* mProfiler;
+    };
+
+  public:
+    FrameProfiler();
+
+    ~FrameProfiler();
+
+    //! Starts a new frame, closing the current one if still open.
+    void beginFrame();
+
+    //! Closes the current frame and collects the GPU timings of the previous frames that are available.
+    void endFrame();
+
+    //! Whether a frame is being profiled.
+    bool isFrameOpen() const { return mFrameOpen; }
+
+    //! Opens a nested scope, if \p gpu is true and GPU timing is enabled its GPU time is measured as well.
+    void beginScope(const char* name, bool gpu=false);
+
+    //! Closes the innermost open scope.
+    void endScope();
+
+    //! The completed frames, from the oldest to the most recent, at most historySize().
+    const std::deque<Frame>& frames() const { return mFrames; }
+
+    //! The most recent completed frame or NULL.
+    const Frame* lastFrame() const { return mFrames.empty() ? NULL : &mFrames.back(); }
+
+    //! Discards all the completed frames.
+    void clear() { mFrames.clear(); }
+
+    //! Maximum number of completed frames kept in frames() (default = 300).
+    void setHistorySize(int size) { mHistorySize = size < 1 ? 1 : size; }
+
+    //! Maximum number of completed frames kept in frames() (default = 300).
+    int historySize() const { return mHistorySize; }
+
+    //! Enables or disables the profiling, when disabled all the calls are ignored (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+
+    //! Enables or disables the profiling, when disabled all the calls are ignored (default = true).
+    bool isEnabled() const { return mEnabled; }
+
+    //! Enables the GPU timer queries (default = true).
+    void setGPUTiming(bool enabled) { mGPUTiming = enabled; }
+
+    //! Enables the GPU timer queries (default = true).
+    bool gpuTiming() const { return mGPUTiming; }
+
+    //! If true Renderer[s] open a GPU scope for each run of consecutive tokens using the same Effect (default = false).
+    //! The scopes are named after Effect::objectName().
+    void setEffectScopes(bool enabled) { mEffectScopes = enabled; }
+
+    //! If true Renderer[s] open a GPU scope for each run of consecutive tokens using the same Effect (default = false).
+    bool effectScopes() const { return mEffectScopes; }
+
+    //! Returns a human readable report of the last completed frame, one indented line per scope.
+    String report() const;
+
+    //! Sets the text of the given CoreText to report(), for use as an on-screen overlay.
+    void updateText(CoreText* text) const;
+
+    //! Writes the completed frames in the Chrome trace event JSON format, CPU and GPU scopes on two different tracks.
+    bool exportChromeTrace(VirtualFile* file) const;
+
+    //! Writes the completed frames in the Chrome trace event JSON format to the given file.
+    bool exportChromeTrace(const String& path) const;
+
+  protected:
+    struct GPUScope
+    {
+      int mScope;
+      GLuint mBeginQuery;
+      GLuint mEndQuery;
+    };
+
+    struct PendingFrame
+    {
+      Frame mFrame;
+      std::vector<GPUScope> mGPUScopes;
+    };
+
+    GLuint acquireQuery();
+    void collectGPUTimings(bool wait);
+    void pushFrame(const Frame& frame);
+
+  protected:
+    std::deque<Frame> mFrames;
+    std::deque<PendingFrame> mPendingFrames;
+    PendingFrame mCurrent;
+    std::vector<int> mStack;
+    std::vector<int> mGPUStack;
+    std::vector<GLuint> mFreeQueries;
+    std::vector<GLuint> mAllQueries;
+    unsigned long long mFrameStart;
+    long long mFrameIndex;
+    int mHistorySize;
+    bool mFrameOpen;
+    bool mEnabled;
+    bool mGPUTiming;
+    bool mEffectScopes;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
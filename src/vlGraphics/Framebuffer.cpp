@@ -33,94 +33,65 @@
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
 
-#include <map>
-#include <set>
-
 using namespace vl;
 
 //-----------------------------------------------------------------------------
 // Framebuffer
 //-----------------------------------------------------------------------------
-bool Framebuffer::checkDrawBuffers() const
+namespace
 {
-  std::map<int, const char*> fbo_attachments;
-  
-  fbo_attachments[GL_NONE]        = "GL_NONE"; 
-  fbo_attachments[GL_BACK_LEFT]   = "GL_BACK_LEFT";
-  fbo_attachments[GL_BACK_RIGHT]  = "GL_BACK_RIGHT";
-  fbo_attachments[GL_FRONT_LEFT]  = "GL_FRONT_LEFT";
-  fbo_attachments[GL_FRONT_RIGHT] = "GL_FRONT_RIGHT";
-  fbo_attachments[GL_AUX0] = "GL_AUX0";
-  fbo_attachments[GL_AUX1] = "GL_AUX1";
-  fbo_attachments[GL_AUX2] = "GL_AUX2";
-  fbo_attachments[GL_AUX3] = "GL_AUX3";
-  fbo_attachments[GL_COLOR_ATTACHMENT0]  = "GL_COLOR_ATTACHMENT0"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT1]  = "GL_COLOR_ATTACHMENT1"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT2]  = "GL_COLOR_ATTACHMENT2"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT3]  = "GL_COLOR_ATTACHMENT3"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT4]  = "GL_COLOR_ATTACHMENT4"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT5]  = "GL_COLOR_ATTACHMENT5"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT6]  = "GL_COLOR_ATTACHMENT6"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT7]  = "GL_COLOR_ATTACHMENT7"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT8]  = "GL_COLOR_ATTACHMENT8"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT9]  = "GL_COLOR_ATTACHMENT9"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT10] = "GL_COLOR_ATTACHMENT10"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT11] = "GL_COLOR_ATTACHMENT11"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT12] = "GL_COLOR_ATTACHMENT12"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT13] = "GL_COLOR_ATTACHMENT13"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT14] = "GL_COLOR_ATTACHMENT14"; 
-  fbo_attachments[GL_COLOR_ATTACHMENT15] = "GL_COLOR_ATTACHMENT15"; 
+  // called for every activation in debug builds: no allocations
+  const char* drawBufferName(GLenum buffer)
+  {
+    static const char* color_attachments[] = {
+      "GL_COLOR_ATTACHMENT0", "GL_COLOR_ATTACHMENT1", "GL_COLOR_ATTACHMENT2", "GL_COLOR_ATTACHMENT3",
+      "GL_COLOR_ATTACHMENT4", "GL_COLOR_ATTACHMENT5", "GL_COLOR_ATTACHMENT6", "GL_COLOR_ATTACHMENT7",
+      "GL_COLOR_ATTACHMENT8", "GL_COLOR_ATTACHMENT9", "GL_COLOR_ATTACHMENT10", "GL_COLOR_ATTACHMENT11",
+      "GL_COLOR_ATTACHMENT12", "GL_COLOR_ATTACHMENT13", "GL_COLOR_ATTACHMENT14", "GL_COLOR_ATTACHMENT15"
+    };
+    static const char* aux_buffers[] = { "GL_AUX0", "GL_AUX1", "GL_AUX2", "GL_AUX3" };
 
+    if ( buffer >= GL_COLOR_ATTACHMENT0 && buffer <= GL_COLOR_ATTACHMENT15 )
+      return color_attachments[buffer - GL_COLOR_ATTACHMENT0];
+    if ( buffer >= GL_AUX0 && buffer <= GL_AUX3 )
+      return aux_buffers[buffer - GL_AUX0];
+    switch( buffer )
+    {
+    case GL_NONE:        return "GL_NONE";
+    case GL_BACK_LEFT:   return "GL_BACK_LEFT";
+    case GL_BACK_RIGHT:  return "GL_BACK_RIGHT";
+    case GL_FRONT_LEFT:  return "GL_FRONT_LEFT";
+    case GL_FRONT_RIGHT: return "GL_FRONT_RIGHT";
+    default:             return "unknown";
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool Framebuffer::checkDrawBuffers() const
+{
   int fbo = 0;
   if (Has_GL_EXT_framebuffer_object||Has_GL_ARB_framebuffer_object)
     glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
 
-  if (fbo)
+  for(unsigned i=0; i<mDrawBuffers.size(); ++i)
   {
-    std::set<GLenum> legal;
-    legal.insert(GL_NONE);
-    legal.insert(GL_COLOR_ATTACHMENT0);
-    legal.insert(GL_COLOR_ATTACHMENT1);
-    legal.insert(GL_COLOR_ATTACHMENT2);
-    legal.insert(GL_COLOR_ATTACHMENT3);
-    legal.insert(GL_COLOR_ATTACHMENT4);
-    legal.insert(GL_COLOR_ATTACHMENT5);
-    legal.insert(GL_COLOR_ATTACHMENT6);
-    legal.insert(GL_COLOR_ATTACHMENT7);
-    legal.insert(GL_COLOR_ATTACHMENT8);
-    legal.insert(GL_COLOR_ATTACHMENT9);
-    legal.insert(GL_COLOR_ATTACHMENT10);
-    legal.insert(GL_COLOR_ATTACHMENT11);
-    legal.insert(GL_COLOR_ATTACHMENT12);
-    legal.insert(GL_COLOR_ATTACHMENT13);
-    legal.insert(GL_COLOR_ATTACHMENT14);
-    legal.insert(GL_COLOR_ATTACHMENT15);
-    for(unsigned i=0; i<mDrawBuffers.size(); ++i)
+    GLenum buffer = mDrawBuffers[i];
+    if (fbo)
     {
-      if(legal.find(mDrawBuffers[i]) == legal.end())
+      bool legal = buffer == GL_NONE || ( buffer >= GL_COLOR_ATTACHMENT0 && buffer <= GL_COLOR_ATTACHMENT15 );
+      if (!legal)
       {
-        Log::error(Say("FBO bound but Framebuffer::setDrawBuffers() called with non FBO compatible draw buffer '%s'.\n") << fbo_attachments[mDrawBuffers[i]]);
+        Log::error(Say("FBO bound but Framebuffer::setDrawBuffers() called with non FBO compatible draw buffer '%s'.\n") << drawBufferName(buffer));
         return false;
       }
     }
-  }
-  else
-  {
-    std::set<GLenum> legal;
-    legal.insert(GL_NONE);
-    legal.insert(GL_BACK_LEFT);
-    legal.insert(GL_BACK_RIGHT);
-    legal.insert(GL_FRONT_LEFT);
-    legal.insert(GL_FRONT_RIGHT);
-    legal.insert(GL_AUX0);
-    legal.insert(GL_AUX1);
-    legal.insert(GL_AUX2);
-    legal.insert(GL_AUX3);
-    for(unsigned i=0; i<mDrawBuffers.size(); ++i)
+    else
     {
-      if(legal.find(mDrawBuffers[i]) == legal.end())
+      bool legal = buffer == GL_NONE || buffer == GL_BACK_LEFT || buffer == GL_BACK_RIGHT || buffer == GL_FRONT_LEFT || buffer == GL_FRONT_RIGHT ||
+                   ( buffer >= GL_AUX0 && buffer <= GL_AUX3 );
+      if (!legal)
       {
-        Log::error(Say("FBO not bound or not supported but Framebuffer::setDrawBuffers() called with FBO specific draw buffer '%s'.\n") << fbo_attachments[mDrawBuffers[i]]);
+        Log::error(Say("FBO not bound or not supported but Framebuffer::setDrawBuffers() called with FBO specific draw buffer '%s'.\n") << drawBufferName(buffer));
         return false;
       }
     }
@@ -156,6 +127,46 @@ void Framebuffer::bindDrawBuffers() const
   }
 }
 //-----------------------------------------------------------------------------
+void Framebuffer::invalidate(int buffer_mask) const
+{
+  if ( !Has_Framebuffer_Invalidation || !buffer_mask )
+    return;
+
+  VL_CHECK_OGL()
+
+  // up to RDB_COLOR_ATTACHMENT15 plus depth and stencil
+  GLenum attachments[16 + 2];
+  GLsizei count = 0;
+
+  if ( handle() == 0 )
+  {
+    // the default framebuffer names its buffers GL_COLOR, GL_DEPTH and GL_STENCIL
+    if ( buffer_mask & BB_COLOR_BUFFER_BIT )
+      attachments[count++] = 0x1800;
+    if ( buffer_mask & BB_DEPTH_BUFFER_BIT )
+      attachments[count++] = 0x1801;
+    if ( buffer_mask & BB_STENCIL_BUFFER_BIT )
+      attachments[count++] = 0x1802;
+  }
+  else
+  {
+    if ( buffer_mask & BB_COLOR_BUFFER_BIT )
+    {
+      for( size_t i=0; i<mDrawBuffers.size() && count<16; ++i )
+        if ( mDrawBuffers[i] != RDB_NONE )
+          attachments[count++] = mDrawBuffers[i];
+    }
+    if ( buffer_mask & BB_DEPTH_BUFFER_BIT )
+      attachments[count++] = GL_DEPTH_ATTACHMENT;
+    if ( buffer_mask & BB_STENCIL_BUFFER_BIT )
+      attachments[count++] = GL_STENCIL_ATTACHMENT;
+  }
+
+  invalidateFramebuffer( GL_FRAMEBUFFER, count, attachments );
+
+  VL_CHECK_OGL()
+}
+//-----------------------------------------------------------------------------
 void Framebuffer::bindReadBuffer()
 {
   VL_CHECK_OGL();
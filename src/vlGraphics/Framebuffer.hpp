@@ -124,6 +124,14 @@ namespace vl
     /** Returns \p true if the draw buffers bound to this render target are legal for this render target type. */
     bool checkDrawBuffers() const;
 
+    /**
+      * Tells the driver that the current contents of the buffers in \p buffer_mask (a combination of EBufferBits) are no longer needed.
+      * For the color buffer only the draw buffers are invalidated. The framebuffer must be active.
+      * On tile-based GPUs invalidating before a pass saves the tile load and invalidating after a pass saves the tile store.
+      * Does nothing if Has_Framebuffer_Invalidation is false. See also vl::invalidateFramebuffer() and Renderer::setInvalidateOnFinish().
+      */
+    void invalidate(int buffer_mask) const;
+
     /** Specifies the color buffer to be drawn into. */
     void setDrawBuffer(EReadDrawBuffer draw_buffer)
     {
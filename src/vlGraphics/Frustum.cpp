@@ -0,0 +1,227 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/Frustum.hpp>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define VL_FRUSTUM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define VL_FRUSTUM_NEON
+#endif
+
+using namespace vl;
+
+namespace
+{
+  //! Single precision copy of the frustum planes, stored on the stack for the usual frusta.
+  class FloatPlanes
+  {
+  public:
+    FloatPlanes(const std::vector<Plane>& planes): mCount((int)planes.size())
+    {
+      if (mCount > MaxStackPlanes)
+        mHeap.resize(mCount * 4);
+      mData = mCount > MaxStackPlanes ? &mHeap[0] : mStack;
+      for(int i=0; i<mCount; ++i)
+      {
+        mData[i*4+0] = (float)planes[i].normal().x();
+        mData[i*4+1] = (float)planes[i].normal().y();
+        mData[i*4+2] = (float)planes[i].normal().z();
+        mData[i*4+3] = (float)planes[i].origin();
+      }
+    }
+
+    int count() const { return mCount; }
+    float nx(int i) const { return mData[i*4+0]; }
+    float ny(int i) const { return mData[i*4+1]; }
+    float nz(int i) const { return mData[i*4+2]; }
+    float origin(int i) const { return mData[i*4+3]; }
+
+  private:
+    static const int MaxStackPlanes = 8;
+    float mStack[MaxStackPlanes*4];
+    std::vector<float> mHeap;
+    float* mData;
+    int mCount;
+  };
+
+  inline void setVisible(u32* visible, int i) { visible[i >> 5] |= 1u << (i & 31); }
+}
+//-----------------------------------------------------------------------------
+int Frustum::cullSpheres(int count, const float* cx, const float* cy, const float* cz, const float* radius, u32* visible) const
+{
+  memset(visible, 0, sizeof(u32) * ((count + 31) / 32));
+
+  const FloatPlanes fp(planes());
+  int visible_count = 0;
+  int i = 0;
+
+#if defined(VL_FRUSTUM_SSE)
+  const __m128 zero = _mm_setzero_ps();
+  for( ; i+4 <= count; i += 4 )
+  {
+    __m128 x = _mm_loadu_ps(cx + i);
+    __m128 y = _mm_loadu_ps(cy + i);
+    __m128 z = _mm_loadu_ps(cz + i);
+    __m128 r = _mm_loadu_ps(radius + i);
+    __m128 culled = zero;
+    for(int p=0; p<fp.count(); ++p)
+    {
+      __m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps(x, _mm_set1_ps(fp.nx(p))), _mm_mul_ps(y, _mm_set1_ps(fp.ny(p))) ), _mm_mul_ps(z, _mm_set1_ps(fp.nz(p))) );
+      d = _mm_sub_ps(d, _mm_set1_ps(fp.origin(p)));
+      culled = _mm_or_ps( culled, _mm_cmpgt_ps(d, r) );
+    }
+    // null spheres are always visible
+    culled = _mm_and_ps( culled, _mm_cmpge_ps(r, zero) );
+    u32 mask = ~(u32)_mm_movemask_ps(culled) & 0xF;
+    visible[i >> 5] |= mask << (i & 31);
+    visible_count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+  }
+#elif defined(VL_FRUSTUM_NEON)
+  const float32x4_t zero = vdupq_n_f32(0);
+  for( ; i+4 <= count; i += 4 )
+  {
+    float32x4_t x = vld1q_f32(cx + i);
+    float32x4_t y = vld1q_f32(cy + i);
+    float32x4_t z = vld1q_f32(cz + i);
+    float32x4_t r = vld1q_f32(radius + i);
+    uint32x4_t culled = vdupq_n_u32(0);
+    for(int p=0; p<fp.count(); ++p)
+    {
+      float32x4_t d = vmulq_n_f32(x, fp.nx(p));
+      d = vmlaq_n_f32(d, y, fp.ny(p));
+      d = vmlaq_n_f32(d, z, fp.nz(p));
+      d = vsubq_f32(d, vdupq_n_f32(fp.origin(p)));
+      culled = vorrq_u32( culled, vcgtq_f32(d, r) );
+    }
+    // null spheres are always visible
+    culled = vandq_u32( culled, vcgeq_f32(r, zero) );
+    u32 mask = (vgetq_lane_u32(culled, 0) ? 0 : 1) | (vgetq_lane_u32(culled, 1) ? 0 : 2) | (vgetq_lane_u32(culled, 2) ? 0 : 4) | (vgetq_lane_u32(culled, 3) ? 0 : 8);
+    visible[i >> 5] |= mask << (i & 31);
+    visible_count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+  }
+#endif
+
+  for( ; i < count; ++i )
+  {
+    bool culled = false;
+    for(int p=0; !culled && p<fp.count(); ++p)
+      culled = fp.nx(p)*cx[i] + fp.ny(p)*cy[i] + fp.nz(p)*cz[i] - fp.origin(p) > radius[i];
+    if ( !culled || radius[i] < 0 )
+    {
+      setVisible(visible, i);
+      ++visible_count;
+    }
+  }
+
+  return visible_count;
+}
+//-----------------------------------------------------------------------------
+int Frustum::cullAABBs(int count, const float* min_x, const float* min_y, const float* min_z,
+                                  const float* max_x, const float* max_y, const float* max_z, u32* visible) const
+{
+  memset(visible, 0, sizeof(u32) * ((count + 31) / 32));
+
+  const FloatPlanes fp(planes());
+
+  // for each plane test the corner farthest along the negative normal, see Plane::isOutside().
+  std::vector<const float*> corner_buf;
+  const float* corner_stack[8*3];
+  const float** corner = corner_stack;
+  if (fp.count() > 8)
+  {
+    corner_buf.resize(fp.count() * 3);
+    corner = &corner_buf[0];
+  }
+  for(int p=0; p<fp.count(); ++p)
+  {
+    corner[p*3+0] = fp.nx(p) >= 0 ? min_x : max_x;
+    corner[p*3+1] = fp.ny(p) >= 0 ? min_y : max_y;
+    corner[p*3+2] = fp.nz(p) >= 0 ? min_z : max_z;
+  }
+
+  int visible_count = 0;
+  int i = 0;
+
+#if defined(VL_FRUSTUM_SSE)
+  for( ; i+4 <= count; i += 4 )
+  {
+    __m128 culled = _mm_setzero_ps();
+    for(int p=0; p<fp.count(); ++p)
+    {
+      __m128 x = _mm_loadu_ps(corner[p*3+0] + i);
+      __m128 y = _mm_loadu_ps(corner[p*3+1] + i);
+      __m128 z = _mm_loadu_ps(corner[p*3+2] + i);
+      __m128 d = _mm_add_ps( _mm_add_ps( _mm_mul_ps(x, _mm_set1_ps(fp.nx(p))), _mm_mul_ps(y, _mm_set1_ps(fp.ny(p))) ), _mm_mul_ps(z, _mm_set1_ps(fp.nz(p))) );
+      d = _mm_sub_ps(d, _mm_set1_ps(fp.origin(p)));
+      culled = _mm_or_ps( culled, _mm_cmpge_ps(d, _mm_setzero_ps()) );
+    }
+    u32 mask = ~(u32)_mm_movemask_ps(culled) & 0xF;
+    visible[i >> 5] |= mask << (i & 31);
+    visible_count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+  }
+#elif defined(VL_FRUSTUM_NEON)
+  for( ; i+4 <= count; i += 4 )
+  {
+    uint32x4_t culled = vdupq_n_u32(0);
+    for(int p=0; p<fp.count(); ++p)
+    {
+      float32x4_t d = vmulq_n_f32(vld1q_f32(corner[p*3+0] + i), fp.nx(p));
+      d = vmlaq_n_f32(d, vld1q_f32(corner[p*3+1] + i), fp.ny(p));
+      d = vmlaq_n_f32(d, vld1q_f32(corner[p*3+2] + i), fp.nz(p));
+      d = vsubq_f32(d, vdupq_n_f32(fp.origin(p)));
+      culled = vorrq_u32( culled, vcgeq_f32(d, vdupq_n_f32(0)) );
+    }
+    u32 mask = (vgetq_lane_u32(culled, 0) ? 0 : 1) | (vgetq_lane_u32(culled, 1) ? 0 : 2) | (vgetq_lane_u32(culled, 2) ? 0 : 4) | (vgetq_lane_u32(culled, 3) ? 0 : 8);
+    visible[i >> 5] |= mask << (i & 31);
+    visible_count += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + (mask >> 3);
+  }
+#endif
+
+  for( ; i < count; ++i )
+  {
+    bool culled = false;
+    for(int p=0; !culled && p<fp.count(); ++p)
+      culled = fp.nx(p)*corner[p*3+0][i] + fp.ny(p)*corner[p*3+1][i] + fp.nz(p)*corner[p*3+2][i] - fp.origin(p) >= 0;
+    if ( !culled )
+    {
+      setVisible(visible, i);
+      ++visible_count;
+    }
+  }
+
+  return visible_count;
+}
+//-----------------------------------------------------------------------------
@@ -32,6 +32,7 @@
 #ifndef Frustum_INCLUDE_ONCE
 #define Frustum_INCLUDE_ONCE
 
+#include <vlGraphics/link_config.hpp>
 #include <vlCore/Plane.hpp>
 #include <vlCore/AABB.hpp>
 #include <vlCore/Sphere.hpp>
@@ -46,7 +47,7 @@ namespace vl
    *
    * \sa Camera, Viewport
   */
-  class Frustum: public Object
+  class VLGRAPHICS_EXPORT Frustum: public Object
   {
     VL_INSTRUMENT_CLASS(vl::Frustum, Object)
 
@@ -82,6 +83,42 @@ namespace vl
       return false;
     }
 
+    /** Coherent hierarchical culling of an AABB: only the planes whose bit is set in \p plane_mask are tested and
+      * the plane \p last_plane, which is usually the plane that culled the same box the previous frame, is tested first.
+      * On return the bits of the planes the box lies entirely inside of are cleared from \p plane_mask so that they can be
+      * skipped for the boxes contained in it. When the box is culled \p last_plane is set to the culling plane.
+      * \note Supports up to 32 planes. */
+    bool cull(const AABB& aabb, u32& plane_mask, int& last_plane) const
+    {
+      VL_CHECK(planes().size() <= 32)
+      if (aabb.isNull())
+        return false;
+      if ( last_plane >= 0 && last_plane < (int)planes().size() && (plane_mask & (1u << last_plane)) && plane(last_plane).isOutside(aabb) )
+        return true;
+      for(unsigned i=0; i<planes().size(); ++i)
+      {
+        if ( !(plane_mask & (1u << i)) )
+          continue;
+        const vec3& n = plane(i).normal();
+        // farthest and nearest corners along the plane's normal
+        vec3 far_pt( n.x() >= 0 ? aabb.maxCorner().x() : aabb.minCorner().x(),
+                     n.y() >= 0 ? aabb.maxCorner().y() : aabb.minCorner().y(),
+                     n.z() >= 0 ? aabb.maxCorner().z() : aabb.minCorner().z() );
+        if ( plane(i).distance(far_pt) < 0 )
+        {
+          // fully inside
+          plane_mask &= ~(1u << i);
+          continue;
+        }
+        if ( (int)i != last_plane && plane(i).isOutside(aabb) )
+        {
+          last_plane = i;
+          return true;
+        }
+      }
+      return false;
+    }
+
     bool cull(const std::vector<fvec3>& points) const
     {
       for(unsigned i=0; i<planes().size(); ++i)
@@ -96,6 +133,19 @@ namespace vl
       return false;
     }
 
+    /** Culls \p count spheres at once given in SoA layout.
+      * Sets bit (i % 32) of \p visible[i / 32] if the i-th sphere is visible and clears it otherwise,
+      * \p visible must be at least (count + 31) / 32 elements long. A negative radius marks a null sphere which is always visible.
+      * Uses SSE or NEON when available, four spheres at a time.
+      * \returns The number of visible spheres. */
+    int cullSpheres(int count, const float* center_x, const float* center_y, const float* center_z, const float* radius, u32* visible) const;
+
+    /** Culls \p count non-null AABBs at once given in SoA layout, see cullSpheres() for the meaning of \p visible.
+      * Uses SSE or NEON when available, four boxes at a time.
+      * \returns The number of visible boxes. */
+    int cullAABBs(int count, const float* min_x, const float* min_y, const float* min_z,
+                             const float* max_x, const float* max_y, const float* max_z, u32* visible) const;
+
   protected:
     std::vector<Plane> mPlanes;
   };
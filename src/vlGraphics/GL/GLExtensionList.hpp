@@ -488,3 +488,11 @@ VL_EXTENSION(GL_AMD_sample_positions)
 VL_EXTENSION(GL_EXT_x11_sync_object)
 VL_EXTENSION(WGL_NV_DX_interop)
 VL_EXTENSION(GL_AMD_multi_draw_indirect)
+VL_EXTENSION(GL_ARB_parallel_shader_compile)
+VL_EXTENSION(GL_KHR_parallel_shader_compile)
+VL_EXTENSION(GL_ARB_shader_image_load_store)
+VL_EXTENSION(GL_ARB_compute_shader)
+VL_EXTENSION(GL_ARB_shader_storage_buffer_object)
+VL_EXTENSION(GL_KHR_debug)
+VL_EXTENSION(GL_ARB_invalidate_subdata)
+VL_EXTENSION(GL_ARB_texture_storage)
@@ -2799,6 +2799,25 @@ VL_GL_FUNCTION( PFNGLMULTIDRAWARRAYSINDIRECTAMDPROC, glMultiDrawArraysIndirectAM
 VL_GL_FUNCTION( PFNGLMULTIDRAWELEMENTSINDIRECTAMDPROC, glMultiDrawElementsIndirectAMD )
 #endif
 
+// GL_ARB_shader_image_load_store
+#ifdef GL_ARB_shader_image_load_store
+VL_GL_FUNCTION( PFNGLBINDIMAGETEXTUREPROC, glBindImageTexture )
+VL_GL_FUNCTION( PFNGLMEMORYBARRIERPROC, glMemoryBarrier )
+#endif
+
+// GL_ARB_compute_shader
+#ifdef GL_ARB_compute_shader
+VL_GL_FUNCTION( PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute )
+VL_GL_FUNCTION( PFNGLDISPATCHCOMPUTEINDIRECTPROC, glDispatchComputeIndirect )
+#endif
+
+// GL_ARB_texture_storage
+#ifdef GL_ARB_texture_storage
+VL_GL_FUNCTION( PFNGLTEXSTORAGE1DPROC, glTexStorage1D )
+VL_GL_FUNCTION( PFNGLTEXSTORAGE2DPROC, glTexStorage2D )
+VL_GL_FUNCTION( PFNGLTEXSTORAGE3DPROC, glTexStorage3D )
+#endif
+
 // *** GLX EXTENSIONS ***
 
 // GLX_VERSION_1_3
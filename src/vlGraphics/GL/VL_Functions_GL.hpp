@@ -557,9 +557,36 @@ namespace vl
       VL_UNSUPPORTED_FUNC();
   }
 
+  //-----------------------------------------------------------------------------
+
+  inline void VL_glBeginConditionalRender(GLuint id, GLenum mode)
+  {
+    if (glBeginConditionalRender)
+      glBeginConditionalRender(id, mode);
+    else
+    if (glBeginConditionalRenderNV)
+      glBeginConditionalRenderNV(id, mode);
+    else
+      VL_UNSUPPORTED_FUNC();
+  }
+
+  inline void VL_glEndConditionalRender()
+  {
+    if (glEndConditionalRender)
+      glEndConditionalRender();
+    else
+    if (glEndConditionalRenderNV)
+      glEndConditionalRenderNV();
+    else
+      VL_UNSUPPORTED_FUNC();
+  }
+
   inline void VL_glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
   {
-    // even if this extension is signed ad ARB it does not appear in the GL 3.0 specs
+    // core since GL 3.2, even if this extension is signed ad ARB it does not appear in the GL 3.0 specs
+    if (glFramebufferTexture)
+      glFramebufferTexture(target,attachment,texture,level);
+    else
     if (glFramebufferTextureARB)
       glFramebufferTextureARB(target,attachment,texture,level);
     else
@@ -683,6 +710,17 @@ namespace vl
       VL_UNSUPPORTED_FUNC();
   }
 
+  inline void VL_glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode)
+  {
+    if (glTransformFeedbackVaryings)
+      glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+    else
+    if (glTransformFeedbackVaryingsEXT)
+      glTransformFeedbackVaryingsEXT(program, count, (const GLchar**)varyings, bufferMode);
+    else
+      VL_UNSUPPORTED_FUNC();
+  }
+
   inline void VL_glUniform1uiv(GLint location, GLsizei count, const GLuint *value)
   {
     if (glUniform1uiv)
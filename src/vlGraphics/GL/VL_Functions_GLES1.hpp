@@ -363,6 +363,16 @@ namespace vl
     else
       VL_TRAP();
   }
+
+  inline void VL_glBeginConditionalRender(GLuint id, GLenum mode)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
+
+  inline void VL_glEndConditionalRender()
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
   
   inline void VL_glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
   {
@@ -438,6 +448,11 @@ namespace vl
     VL_UNSUPPORTED_FUNC()
   }
 
+  inline void VL_glTransformFeedbackVaryings(GLuint program, GLsizei count, const char* const* varyings, GLenum bufferMode)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
+
   inline void VL_glUniform1uiv(GLint location, GLsizei count, const GLuint *value)
   {
     VL_UNSUPPORTED_FUNC()
@@ -1109,6 +1124,19 @@ namespace vl
   {
     VL_UNSUPPORTED_FUNC()
   }
+  inline void glBindBufferRange (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
+  inline GLuint glGetUniformBlockIndex (GLuint program, const GLchar *uniformBlockName)
+  {
+    VL_UNSUPPORTED_FUNC()
+    return (GLuint)-1;
+  }
+  inline void glUniformBlockBinding (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
 
   inline void glGenerateMipmap (GLenum target)
   {
@@ -1192,4 +1220,4 @@ namespace vl
 
 #pragma warning( default: 4100 ) // unreferenced formal parameter
 
-#endif
\ No newline at end of file
+#endif
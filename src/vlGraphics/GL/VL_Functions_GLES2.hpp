@@ -353,6 +353,16 @@ namespace vl
     glGenerateMipmap(target);
   }
 
+  inline void VL_glBeginConditionalRender(GLuint id, GLenum mode)
+  {
+    VL_UNSUPPORTED_FUNC();
+  }
+
+  inline void VL_glEndConditionalRender()
+  {
+    VL_UNSUPPORTED_FUNC();
+  }
+
   inline void VL_glFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
   {
     VL_UNSUPPORTED_FUNC();
@@ -452,6 +462,11 @@ namespace vl
     VL_UNSUPPORTED_FUNC();
   }
 
+  inline void VL_glTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode)
+  {
+    VL_UNSUPPORTED_FUNC();
+  }
+
   inline void VL_glUniform1uiv(GLint location, GLsizei count, const GLuint *value)
   {
     VL_UNSUPPORTED_FUNC();
@@ -927,6 +942,19 @@ namespace vl
   {
     VL_UNSUPPORTED_FUNC()
   }
+  inline void glBindBufferRange (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
+  inline GLuint glGetUniformBlockIndex (GLuint program, const GLchar *uniformBlockName)
+  {
+    VL_UNSUPPORTED_FUNC()
+    return (GLuint)-1;
+  }
+  inline void glUniformBlockBinding (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+  {
+    VL_UNSUPPORTED_FUNC()
+  }
   inline int gluBuild2DMipmaps ( GLenum target,  GLint components, GLint width,  GLint height,  GLenum format, GLenum type,  const void *data)
   {
     VL_UNSUPPORTED_FUNC()
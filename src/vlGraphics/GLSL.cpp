@@ -36,6 +36,7 @@
 #include <vlCore/VirtualFile.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
+#include <vlCore/StringInterner.hpp>
 
 using namespace vl;
 
@@ -48,6 +49,7 @@ GLSLShader::GLSLShader()
   mType = ST_VERTEX_SHADER;
   mHandle = 0;
   mCompiled = false;
+  mCompilePending = false;
 }
 //-----------------------------------------------------------------------------
 GLSLShader::GLSLShader(EShaderType type, const String& source)
@@ -56,6 +58,7 @@ GLSLShader::GLSLShader(EShaderType type, const String& source)
   mType = type;
   mHandle = 0;
   mCompiled = false;
+  mCompilePending = false;
   setSource(source);
 }
 //-----------------------------------------------------------------------------
@@ -153,6 +156,7 @@ void GLSLShader::setSource( const String& source_or_path )
   {
     mSource = new_src;
     mCompiled = false;
+    mCompilePending = false;
   }
 }
 //-----------------------------------------------------------------------------
@@ -176,18 +180,9 @@ bool GLSLShader::compile()
 
   if ( ! mCompiled )
   {
-    // make sure shader object exists
-
-    createShader();
-
-    // assign sources
-
-    const char* source[] = { mSource.c_str() };
-    glShaderSource(handle(), 1, source, NULL);
-
-    // compile the shader
-
-    glCompileShader( handle() );
+    // start the compilation unless compileAsync() already did
+    compileAsync();
+    mCompilePending = false;
 
     if ( compileStatus() )
     {
@@ -211,6 +206,38 @@ bool GLSLShader::compile()
   return mCompiled;
 }
 //-----------------------------------------------------------------------------
+void GLSLShader::compileAsync()
+{
+  VL_CHECK_OGL();
+  if( ! Has_GLSL || mCompiled || mCompilePending || mSource.empty() ) {
+    return;
+  }
+
+  // make sure shader object exists
+
+  createShader();
+
+  // assign sources
+
+  const char* source[] = { mSource.c_str() };
+  glShaderSource(handle(), 1, source, NULL);
+
+  glCompileShader( handle() ); VL_CHECK_OGL();
+
+  mCompilePending = true;
+}
+//-----------------------------------------------------------------------------
+bool GLSLShader::isCompileComplete() const
+{
+  if ( ! mCompilePending || ! Has_Parallel_Shader_Compile ) {
+    return true;
+  }
+
+  int status = GL_TRUE;
+  glGetShaderiv( handle(), GL_COMPLETION_STATUS_KHR, &status ); VL_CHECK_OGL();
+  return status == GL_TRUE;
+}
+//-----------------------------------------------------------------------------
 bool GLSLShader::compileStatus() const
 {
   VL_CHECK_OGL();
@@ -256,6 +283,7 @@ void GLSLShader::createShader()
   {
     mHandle = glCreateShader(mType);
     mCompiled = false;
+    mCompilePending = false;
   }
   VL_CHECK(handle());
   VL_CHECK_OGL();
@@ -272,18 +300,45 @@ void GLSLShader::deleteShader()
     glDeleteShader(handle()); // VL_CHECK_OGL();
     mHandle = 0;
     mCompiled = false;
+    mCompilePending = false;
   }
 }
 //------------------------------------------------------------------------------
 // GLSLProgram
 //------------------------------------------------------------------------------
+namespace
+{
+  ref<ProgramBinaryCache> DefaultProgramBinaryCache;
+}
+//------------------------------------------------------------------------------
+void GLSLProgram::setDefaultProgramBinaryCache(ProgramBinaryCache* cache)
+{
+  DefaultProgramBinaryCache = cache;
+}
+//------------------------------------------------------------------------------
+ProgramBinaryCache* GLSLProgram::defaultProgramBinaryCache()
+{
+  return DefaultProgramBinaryCache.get();
+}
+//------------------------------------------------------------------------------
 GLSLProgram::GLSLProgram()
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mScheduleLink = true;
   mHandle = 0;
+  mParallelLinkEnabled = false;
+  mLinkPending = false;
+  mLinkedFromCache = false;
   mProgramBinaryRetrievableHint = false;
   mProgramSeparable = false;
+  mTransformFeedbackInterleaved = true;
+  mUniformUploadsIssued = 0;
+  mUniformUploadsSkipped = 0;
+  mUniformDeltaBinding = true;
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  mRenderContext = NULL;
+  mRenderContextConflict = false;
+#endif
 
   resetBindingLocations();
 }
@@ -296,11 +351,17 @@ GLSLProgram::~GLSLProgram()
 //-----------------------------------------------------------------------------
 void GLSLProgram::resetBindingLocations()
 {
+  // uniform and attribute locations cache
+  mUniformSlots.clear();
+  mUniformBlockSlots.clear();
+  mAttribLocations.clear();
+
   // standard uniform binding
   m_vl_ModelViewMatrix = -1;
   m_vl_ProjectionMatrix = -1;
   m_vl_ModelViewProjectionMatrix = -1;
   m_vl_NormalMatrix = -1;
+  m_vl_CameraMatrices = -1;
 
   // vertex attrib binding
   m_vl_VertexPosition = -1;
@@ -347,10 +408,31 @@ void GLSLProgram::deleteProgram()
     glDeleteProgram(handle()); // VL_CHECK_OGL();
     mHandle = 0;
   }
+  mLinkPending = false;
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  mRenderContext = NULL;
+#endif
   resetBindingLocations();
   scheduleRelinking();
 }
 //-----------------------------------------------------------------------------
+#ifdef VL_MULTI_CONTEXT_RENDERING
+bool GLSLProgram::claimRenderContext(const OpenGLContext* ctx) const
+{
+  if ( mRenderContext.load(std::memory_order_relaxed) == ctx )
+    return true;
+
+  const OpenGLContext* owner = NULL;
+  if ( mRenderContext.compare_exchange_strong(owner, ctx) || owner == ctx )
+    return true;
+
+  if ( ! mRenderContextConflict.exchange(true) )
+    Log::error( Say("GLSLProgram '%s' is rendered concurrently by two OpenGLContexts: their uniforms would overwrite each other, "
+                    "each context must use its own GLSLProgram. See MultiContextRendering.\n") << objectName() );
+  return false;
+}
+#endif
+//-----------------------------------------------------------------------------
 bool GLSLProgram::attachShader(GLSLShader* shader)
 {
   VL_CHECK_OGL();
@@ -380,6 +462,16 @@ bool GLSLProgram::attachShader(GLSLShader* shader)
   shader->createShader();
   glAttachShader( handle(), shader->handle() ); VL_CHECK_OGL();
 
+  // compilation is deferred to linkProgram() if the program might be loaded from the binary cache
+  if ( activeProgramBinaryCache() && Has_GL_ARB_get_program_binary ) {
+    return true;
+  }
+
+  if ( mParallelLinkEnabled && Has_Parallel_Shader_Compile ) {
+    shader->compileAsync();
+    return true;
+  }
+
   return shader->compile();
 }
 //-----------------------------------------------------------------------------
@@ -451,10 +543,19 @@ bool GLSLProgram::linkProgram(bool force_relink)
     return false;
   }
 
+  if ( mLinkPending && ! force_relink ) {
+    // poll the parallel link started by a previous call
+    return isLinkComplete() ? finishLink() : false;
+  }
+
   if ( linked() && ! force_relink ) {
     return true;
   }
 
+  // a new link supersedes the pending one
+  mLinkPending = false;
+  mLinkedFromCache = false;
+
   resetBindingLocations();
 
   if (shaderCount() == 0) {
@@ -465,6 +566,27 @@ bool GLSLProgram::linkProgram(bool force_relink)
 
   createProgram();
 
+  // try the program binary cache first
+
+  ProgramBinaryCache* cache = activeProgramBinaryCache();
+  if ( cache && cache->load( this ) ) {
+    mLinkedFromCache = true;
+    return true;
+  }
+
+  // compile the shaders, in parallel if supported
+
+  bool parallel = mParallelLinkEnabled && Has_Parallel_Shader_Compile;
+  for( size_t i = 0; i < mShaders.size(); ++i ) {
+    if ( parallel ) {
+      mShaders[i]->compileAsync();
+    } else
+    if ( ! mShaders[i]->compile() ) {
+      Log::bug("GLSLProgram::linkProgram() failed: shader compilation failed! (" + String(objectName()) + ")\n");
+      return false;
+    }
+  }
+
   // pre-link operations
   preLink();
 
@@ -472,6 +594,25 @@ bool GLSLProgram::linkProgram(bool force_relink)
 
   glLinkProgram(handle()); VL_CHECK_OGL();
 
+  if ( parallel ) {
+    mLinkPending = true;
+    return false;
+  }
+
+  return finishLink();
+}
+//-----------------------------------------------------------------------------
+bool GLSLProgram::finishLink()
+{
+  mLinkPending = false;
+
+  // collect the results of the shaders compiled in parallel so that their errors are logged
+  for( size_t i = 0; i < mShaders.size(); ++i ) {
+    if ( mShaders[i]->compilePending() ) {
+      mShaders[i]->compile();
+    }
+  }
+
   mScheduleLink = ! linkStatus();
 
   // check link error
@@ -491,9 +632,25 @@ bool GLSLProgram::linkProgram(bool force_relink)
     }
   #endif
 
+  ProgramBinaryCache* cache = activeProgramBinaryCache();
+  if ( cache ) {
+    cache->store( this );
+  }
+
   return true;
 }
 //-----------------------------------------------------------------------------
+bool GLSLProgram::isLinkComplete() const
+{
+  if ( ! mLinkPending || ! Has_Parallel_Shader_Compile ) {
+    return true;
+  }
+
+  int status = GL_TRUE;
+  glGetProgramiv( handle(), GL_COMPLETION_STATUS_KHR, &status ); VL_CHECK_OGL();
+  return status == GL_TRUE;
+}
+//-----------------------------------------------------------------------------
 void GLSLProgram::preLink()
 {
   VL_CHECK_OGL();
@@ -509,11 +666,22 @@ void GLSLProgram::preLink()
     }
   }
 
+  // transform feedback varyings
+
+  if ( Has_Transform_Feedback && ! mTransformFeedbackVaryings.empty() )
+  {
+    std::vector<const char*> varyings;
+    for(size_t i=0; i<mTransformFeedbackVaryings.size(); ++i)
+      varyings.push_back( mTransformFeedbackVaryings[i].c_str() );
+    VL_glTransformFeedbackVaryings( handle(), (GLsizei)varyings.size(), &varyings[0], mTransformFeedbackInterleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS ); VL_CHECK_OGL();
+  }
+
   // OpenGL 4 program parameters
 
   if( Has_GL_ARB_get_program_binary )
   {
-    VL_glProgramParameteri(handle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, programBinaryRetrievableHint()?GL_TRUE:GL_FALSE); VL_CHECK_OGL();
+    bool retrievable = programBinaryRetrievableHint() || activeProgramBinaryCache();
+    VL_glProgramParameteri(handle(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable?GL_TRUE:GL_FALSE); VL_CHECK_OGL();
   }
 
   if ( Has_GL_ARB_separate_shader_objects )
@@ -539,12 +707,20 @@ void GLSLProgram::preLink()
   glBindAttribLocation( handle(), vl::VA_TexCoord8, "vl_VertexTexCoord8" ); VL_CHECK_OGL();
   glBindAttribLocation( handle(), vl::VA_TexCoord9, "vl_VertexTexCoord9" ); VL_CHECK_OGL();
   glBindAttribLocation( handle(), vl::VA_TexCoord10, "vl_VertexTexCoord10" ); VL_CHECK_OGL();
+  // skinning attributes, aliasing the last texture coordinates
+  glBindAttribLocation( handle(), vl::VA_JointWeights, "vl_VertexJointWeights" ); VL_CHECK_OGL();
+  glBindAttribLocation( handle(), vl::VA_JointIndices, "vl_VertexJointIndices" ); VL_CHECK_OGL();
 }
 //-----------------------------------------------------------------------------
 void GLSLProgram::postLink()
 {
   VL_CHECK_OGL();
 
+  // locations are lazily re-queried by applyUniformSet()
+  mUniformSlots.clear();
+  mUniformBlockSlots.clear();
+  mAttribLocations.clear();
+
   // track standard vl uniforms
 
   m_vl_WorldMatrix               = glGetUniformLocation(handle(), "vl_WorldMatrix");
@@ -552,6 +728,7 @@ void GLSLProgram::postLink()
   m_vl_ProjectionMatrix          = glGetUniformLocation(handle(), "vl_ProjectionMatrix");
   m_vl_ModelViewProjectionMatrix = glGetUniformLocation(handle(), "vl_ModelViewProjectionMatrix");
   m_vl_NormalMatrix              = glGetUniformLocation(handle(), "vl_NormalMatrix");
+  m_vl_CameraMatrices            = getUniformBlockIndex("vl_CameraMatrices");
 
   // track vertex attribute bindings
 
@@ -645,11 +822,12 @@ void GLSLProgram::apply(int /*index*/, const Camera*, OpenGLContext* ctx) const
   VL_CHECK_OGL();
   if(Has_GLSL)
   {
-    ctx->useGLSLProgram(this);
+    // while a parallel link is pending use the fallback program, if any
+    ctx->useGLSLProgram( activeProgram() );
   }
 }
 //-----------------------------------------------------------------------------
-bool GLSLProgram::applyUniformSet(const UniformSet* uniforms) const
+bool GLSLProgram::applyUniformSet(const UniformSet* uniforms, OpenGLContext* ctx) const
 {
   uniforms = uniforms ? uniforms : getUniformSet();
 
@@ -671,44 +849,34 @@ bool GLSLProgram::applyUniformSet(const UniformSet* uniforms) const
   int current_glsl_program = -1;
   glGetIntegerv(GL_CURRENT_PROGRAM, &current_glsl_program); VL_CHECK_OGL();
   VL_CHECK(current_glsl_program == (int)handle())
+  if (ctx)
+    ctx->countGLQuery("GL_CURRENT_PROGRAM");
 #endif
 
   for(size_t i=0, count=uniforms->uniforms().size(); i<count; ++i)
   {
     const Uniform* uniform = uniforms->uniforms()[i].get();
 
-    #if 0
-      const UniformInfo* uinfo = activeUniformInfo(uniform->name().c_str());
-      int location = uinfo ? uinfo->Location : -1;
+    UniformSlot& slot = uniformSlot(uniform);
+    int location = slot.mLocation;
+    if (location == -1) {
+      continue;
+    }
 
-      #ifndef NDEBUG
-      if (location == -1)
-      {
-        std::map<std::string, ref<UniformInfo> >::const_iterator it = activeUniforms().begin();
-        Log::warning("\nActive uniforms:\n");
-        for( ; it != activeUniforms().end(); ++it )
-          Log::warning( Say("\t%s\n") << it->first.c_str() );
-
-        // Check the following:
-        // (1) Is the uniform variable declared but not used in your GLSL program?
-        // (2) Double-check the spelling of the uniform variable name.
-        vl::Log::warning( vl::Say(
-          "warning:\n"
-          "GLSLProgram::applyUniformSet(): uniform '%s' not found!\n"
-          "Is the uniform variable declared but not used in your GLSL program?\n"
-          "Also double-check the spelling of the uniform variable name.\n") << uniform->name() );
-        continue;
-      }
-      #endif
-    #else
-      int location = glGetUniformLocation(handle(), uniform->name().c_str());
-      if (location == -1) {
+    // delta binding: skip the upload if this very value is already stored in the program
+    if ( mUniformDeltaBinding )
+    {
+      if ( slot.mUniform == uniform && slot.mVersion == uniform->version() ) {
+        ++mUniformUploadsSkipped;
         continue;
       }
-    #endif
+      // note: keeping a reference to the uniform prevents a different one from being allocated at the same address
+      slot.mUniform = uniform;
+      slot.mVersion = uniform->version();
+    }
+    ++mUniformUploadsIssued;
 
     // finally transmits the uniform
-    // note: we don't perform delta binding per-uniform variable at the moment!
 
     VL_CHECK_OGL();
     switch(uniform->mType)
@@ -768,10 +936,103 @@ bool GLSLProgram::applyUniformSet(const UniformSet* uniforms) const
     }
   }
 
+  // uniform blocks
+  for(size_t i=0, count=uniforms->uniformBlocks().size(); i<count; ++i)
+  {
+    applyUniformBlock( uniforms->uniformBlocks()[i].get() );
+  }
+
+  VL_CHECK_OGL();
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool GLSLProgram::applyUniformBlock(const UniformBlock* block) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK( Has_Uniform_Buffer_Object )
+  if ( ! Has_Uniform_Buffer_Object || ! block || ! linked() )
+    return false;
+
+  int id = block->nameID();
+  if ( id >= (int)mUniformBlockSlots.size() ) {
+    mUniformBlockSlots.resize( id + 1 );
+  }
+  UniformBlockSlot& slot = mUniformBlockSlots[id];
+  if ( slot.mIndex == -2 ) {
+    slot.mIndex = getUniformBlockIndex( block->name().c_str() );
+  }
+  if ( slot.mIndex == -1 ) {
+    return false;
+  }
+
+  // the binding point assigned to a block is part of the program state
+  if ( slot.mBindingPoint != block->bindingPoint() )
+  {
+    glUniformBlockBinding( handle(), slot.mIndex, block->bindingPoint() ); VL_CHECK_OGL();
+    slot.mBindingPoint = block->bindingPoint();
+  }
+
+  block->bind();
+
   VL_CHECK_OGL();
   return true;
 }
 //-----------------------------------------------------------------------------
+GLSLProgram::UniformSlot& GLSLProgram::uniformSlot(int name_id, const char* name) const
+{
+  if ( name_id >= (int)mUniformSlots.size() ) {
+    mUniformSlots.resize( name_id + 1 );
+  }
+  UniformSlot& slot = mUniformSlots[name_id];
+  if ( slot.mLocation == -2 ) {
+    slot.mLocation = glGetUniformLocation( handle(), name ); VL_CHECK_OGL();
+  }
+  return slot;
+}
+//-----------------------------------------------------------------------------
+int GLSLProgram::getUniformLocation(const char* name) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK( Has_GLSL )
+  VL_CHECK( handle() )
+  if( ! Has_GLSL || ! linked() ) {
+    return -1;
+  }
+  return uniformSlot( StringInterner::intern(name), name ).mLocation;
+}
+//-----------------------------------------------------------------------------
+int GLSLProgram::getUniformLocation(int name_id) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK( Has_GLSL )
+  VL_CHECK( handle() )
+  if( ! Has_GLSL || ! linked() ) {
+    return -1;
+  }
+  if ( name_id < (int)mUniformSlots.size() && mUniformSlots[name_id].mLocation != -2 ) {
+    return mUniformSlots[name_id].mLocation;
+  }
+  return uniformSlot( name_id, StringInterner::string(name_id).c_str() ).mLocation;
+}
+//-----------------------------------------------------------------------------
+int GLSLProgram::getAttribLocation(const char* name) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK( Has_GLSL )
+  VL_CHECK( handle() )
+  if( ! Has_GLSL || ! linked() ) {
+    return -1;
+  }
+  int id = StringInterner::intern(name);
+  if ( id >= (int)mAttribLocations.size() ) {
+    mAttribLocations.resize( id + 1, -2 );
+  }
+  if ( mAttribLocations[id] == -2 ) {
+    mAttribLocations[id] = glGetAttribLocation( handle(), name ); VL_CHECK_OGL();
+  }
+  return mAttribLocations[id];
+}
+//-----------------------------------------------------------------------------
 void GLSLProgram::bindFragDataLocation(int color_number, const char* name)
 {
   scheduleRelinking();
@@ -784,6 +1045,13 @@ void GLSLProgram::unbindFragDataLocation(const char* name)
   mFragDataLocation.erase(name);
 }
 //-----------------------------------------------------------------------------
+void GLSLProgram::setTransformFeedbackVaryings(const std::vector<std::string>& varyings, bool interleaved)
+{
+  scheduleRelinking();
+  mTransformFeedbackVaryings = varyings;
+  mTransformFeedbackInterleaved = interleaved;
+}
+//-----------------------------------------------------------------------------
 int GLSLProgram::fragDataLocation(const char* name) const
 {
   std::map<std::string, int>::const_iterator it = mFragDataLocation.find(name);
@@ -836,26 +1104,8 @@ bool GLSLProgram::programBinary(GLenum binary_format, const void* binary, int le
 
   if (handle())
   {
-    // pre-link operations
-    preLink();
-
-    // load glsl program and link
-    VL_glProgramBinary(handle(), binary_format, binary, length); VL_CHECK_OGL();
-    mScheduleLink = !linkStatus();
-
     // log error
-    if(linked())
-    {
-      // post-link operations
-      postLink();
-
-      #ifndef NDEBUG
-        String log = infoLog();
-        if (!log.empty())
-          Log::warning( Say("%s\n%s\n\n") << objectName().c_str() << log );
-      #endif
-    }
-    else
+    if( ! loadProgramBinary(binary_format, binary, length) )
     {
       Log::bug("GLSLProgram::programBinary() failed! (" + String(objectName()) + ")\n");
       Log::bug( Say("Info log:\n%s\n") << infoLog() );
@@ -871,6 +1121,35 @@ bool GLSLProgram::programBinary(GLenum binary_format, const void* binary, int le
   }
 }
 //-----------------------------------------------------------------------------
+bool GLSLProgram::loadProgramBinary(GLenum binary_format, const void* binary, int length)
+{
+  VL_CHECK(handle())
+
+  mLinkPending = false;
+
+  // pre-link operations
+  preLink();
+
+  // load glsl program and link
+  VL_glProgramBinary(handle(), binary_format, binary, length); VL_CHECK_OGL();
+  mScheduleLink = !linkStatus();
+
+  if( ! linked() ) {
+    return false;
+  }
+
+  // post-link operations
+  postLink();
+
+  #ifndef NDEBUG
+    String log = infoLog();
+    if (!log.empty())
+      Log::warning( Say("%s\n%s\n\n") << objectName().c_str() << log );
+  #endif
+
+  return true;
+}
+//-----------------------------------------------------------------------------
 bool GLSLProgram::reload() {
   bool ok = true;
   for( size_t i = 0; i < mShaders.size(); ++i ) {
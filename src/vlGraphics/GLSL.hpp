@@ -35,16 +35,23 @@
 #include <vlGraphics/UniformSet.hpp>
 #include <vlCore/glsl_math.hpp>
 #include <vlGraphics/RenderState.hpp>
+#include <vlGraphics/ProgramBinaryCache.hpp>
 #include <vlCore/String.hpp>
 
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  #include <atomic>
+#endif
+
 namespace vl
 {
   class Uniform;
+  class Camera;
+  class Transform;
 
   //------------------------------------------------------------------------------
   // GLSLShader
   //------------------------------------------------------------------------------
-  /** For internal use only. Base class for GLSLVertexShader, GLSLFragmentShader, GLSLGeometryShader, GLSLTessEvaluationShader and GLSLTessControlShader.
+  /** For internal use only. Base class for GLSLVertexShader, GLSLFragmentShader, GLSLGeometryShader, GLSLTessEvaluationShader, GLSLTessControlShader and GLSLComputeShader.
    *
    * \sa GLSLVertexShader, GLSLFragmentShader, GLSLGeometryShader, GLSLTessControlShader, GLSLTessEvaluationShader, GLSLProgram, Effect */
   class VLGRAPHICS_EXPORT GLSLShader: public Object
@@ -87,6 +94,17 @@ namespace vl
     //! This function also create the shader if handle() == 0 using the OpenGL function glCreateShader(), see also http://www.opengl.org/sdk/docs/man/xhtml/glCreateShader.xml
     bool compile();
 
+    //! Starts compiling the shader without waiting for the result, which is collected later by compile().
+    //! Useful only when GL_KHR_parallel_shader_compile is supported, see GLSLProgram::setParallelLinkEnabled().
+    void compileAsync();
+
+    //! Returns true if no compilation started by compileAsync() is still running. Never blocks.
+    //! Without GL_KHR_parallel_shader_compile it always returns true.
+    bool isCompileComplete() const;
+
+    //! Returns true if compileAsync() has been called and its result has not been collected by compile() yet.
+    bool compilePending() const { return mCompilePending; }
+
     //! Returns true if the shader has been succesfully compiled.
     //! The check is done using the OpenGL function glGetShaderiv(), see also http://www.opengl.org/sdk/docs/man/xhtml/glGetShader.xml for more information.
     bool compileStatus() const;
@@ -109,6 +127,7 @@ namespace vl
     String mPath;
     unsigned int mHandle;
     bool mCompiled;
+    bool mCompilePending;
   };
   //------------------------------------------------------------------------------
   /** Wraps a GLSL vertex shader to be bound to a GLSLProgram: the shader this shader will run on the programmable vertex processor.
@@ -202,6 +221,26 @@ namespace vl
     }
   };
   //------------------------------------------------------------------------------
+  /** Wraps a GLSL compute shader to be bound to a GLSLProgram: this shader runs outside of the rendering pipeline and is launched with DispatchCompute.
+   *
+   * A GLSLProgram containing a compute shader cannot contain any other shader type. Requires OpenGL 4.3 or GL_ARB_compute_shader, see Has_Compute_Shader.
+   *
+   * \sa DispatchCompute, ShaderStorageBuffer, ImageUnit, GLSLProgram */
+  class GLSLComputeShader: public GLSLShader
+  {
+    VL_INSTRUMENT_CLASS(vl::GLSLComputeShader, GLSLShader)
+
+  public:
+    //! \param source Compute shader's source code or path to a text file containing the shader's source code.
+    GLSLComputeShader(const String& source=String()): GLSLShader(ST_COMPUTE_SHADER, source)
+    {
+      #ifndef NDEBUG
+        if (mObjectName.empty())
+          mObjectName = className();
+      #endif
+    }
+  };
+  //------------------------------------------------------------------------------
   // GLSLProgram
   //------------------------------------------------------------------------------
   /**
@@ -236,6 +275,8 @@ namespace vl
 
     // applyUniform
     friend class Renderer;
+    // loadProgramBinary
+    friend class ProgramBinaryCache;
   public:
     //! Constructor.
     GLSLProgram();
@@ -276,6 +317,8 @@ namespace vl
     void apply(int index, const Camera*, OpenGLContext* ctx) const;
 
     //! Links the GLSLProgram calling glLinkProgram(handle()) only if the program needs to be linked.
+    //! If a ProgramBinaryCache is installed the program is first looked up in the cache and the shaders are compiled only on a miss.
+    //! If setParallelLinkEnabled() is on the function only starts compiling and linking and returns false until linkPending() becomes false.
     //! \sa
     //! - http://www.opengl.org/sdk/docs/man/xhtml/glLinkProgram.xml
     //! - scheduleRelinking()
@@ -290,6 +333,66 @@ namespace vl
     //! Schedules a relink of the GLSL program.
     void scheduleRelinking() { mScheduleLink = true; }
 
+    // --------------- parallel compilation ---------------
+
+    //! If enabled and GL_KHR_parallel_shader_compile (or the ARB version) is supported linkProgram() does not block: it starts
+    //! compiling and linking the program and returns false, subsequent calls poll the driver and complete the link once it is done.
+    //! Meanwhile the Renderer uses fallbackProgram() or, if none is available, skips the objects using this program.
+    //! The automatic resource initialization of Rendering calls linkProgram() at every frame until the program is linked.
+    void setParallelLinkEnabled(bool enabled) { mParallelLinkEnabled = enabled; }
+
+    //! Whether linkProgram() is allowed to link the program in the background, see setParallelLinkEnabled().
+    bool parallelLinkEnabled() const { return mParallelLinkEnabled; }
+
+    //! Returns true if linkProgram() started a parallel link which has not been completed yet.
+    bool linkPending() const { return mLinkPending; }
+
+    //! Returns true if the driver finished the pending parallel link (or if there is none). Never blocks.
+    bool isLinkComplete() const;
+
+    //! The program used in place of this one while its link is pending, typically a cheap shared program. If NULL the objects using this program are not rendered.
+    void setFallbackProgram(GLSLProgram* program) { mFallbackProgram = program; }
+
+    //! The program used in place of this one while its link is pending, see setFallbackProgram().
+    GLSLProgram* fallbackProgram() { return mFallbackProgram.get(); }
+
+    //! The program used in place of this one while its link is pending, see setFallbackProgram().
+    const GLSLProgram* fallbackProgram() const { return mFallbackProgram.get(); }
+
+    //! The program to be used for rendering: this one unless its link is pending, in which case the fallbackProgram() if linked, or NULL.
+    const GLSLProgram* activeProgram() const
+    {
+      if ( ! mLinkPending )
+        return this;
+      return mFallbackProgram && mFallbackProgram->linked() ? mFallbackProgram.get() : NULL;
+    }
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+    //! For internal use only. Binds the program to \p ctx the first time it is rendered by a context rendered concurrently with the
+    //! other contexts of its share group, see OpenGLContext::concurrentRendering(). Returns false if it is bound to another context.
+    bool claimRenderContext(const OpenGLContext* ctx) const;
+#endif
+
+    // --------------- program binary cache ---------------
+
+    //! The cache used by linkProgram() to load the program binary instead of compiling it. Overrides defaultProgramBinaryCache().
+    void setProgramBinaryCache(ProgramBinaryCache* cache) { mProgramBinaryCache = cache; }
+
+    //! The cache used by linkProgram() to load the program binary instead of compiling it. Overrides defaultProgramBinaryCache().
+    ProgramBinaryCache* programBinaryCache() { return mProgramBinaryCache.get(); }
+
+    //! The cache used by linkProgram() to load the program binary instead of compiling it. Overrides defaultProgramBinaryCache().
+    const ProgramBinaryCache* programBinaryCache() const { return mProgramBinaryCache.get(); }
+
+    //! The cache used by all the programs that don't specify one with setProgramBinaryCache().
+    static void setDefaultProgramBinaryCache(ProgramBinaryCache* cache);
+
+    //! The cache used by all the programs that don't specify one with setProgramBinaryCache().
+    static ProgramBinaryCache* defaultProgramBinaryCache();
+
+    //! Returns true if the program has been loaded from the program binary cache by the last linkProgram().
+    bool linkedFromCache() const { return mLinkedFromCache; }
+
     /**
      * Attaches the GLSLShader to this GLSLProgram
      * \note
@@ -316,19 +419,9 @@ namespace vl
     void bindAttribLocation(unsigned int index, const char* name);
 
     //! Eqivalento to glGetAttribLocation(handle(), name).
+    //! The locations are cached by interned name until the program is relinked, see StringInterner.
     //! \note The program must be linked before calling this function.
-    int getAttribLocation(const char* name) const
-    {
-      VL_CHECK_OGL();
-      VL_CHECK( Has_GLSL )
-      VL_CHECK( handle() )
-      if( ! Has_GLSL || ! linked() ) {
-        return -1;
-      }
-      int location = glGetAttribLocation( handle(), name );
-      VL_CHECK_OGL();
-      return location;
-    }
+    int getAttribLocation(const char* name) const;
 
     //! Returns the number of GLSLShader objects bound to this GLSLProgram
     int shaderCount() const { return (int)mShaders.size(); }
@@ -352,6 +445,20 @@ namespace vl
 
     const std::map<std::string, int>& fragDataLocations() const { return mFragDataLocation; }
 
+    // --------------- transform feedback ---------------
+
+    /** Specifies the varyings to be captured by transform feedback, see also http://www.opengl.org/sdk/docs/man/xhtml/glTransformFeedbackVaryings.xml for more information.
+      * \param varyings The names of the captured varyings.
+      * \param interleaved If \p true all the varyings are written into a single buffer (GL_INTERLEAVED_ATTRIBS), otherwise each varying is written into its own buffer (GL_SEPARATE_ATTRIBS).
+      * \note The new varyings take effect after the GLSL program is relinked, which is automatically scheduled by this function. */
+    void setTransformFeedbackVaryings(const std::vector<std::string>& varyings, bool interleaved);
+
+    //! The varyings captured by transform feedback, see setTransformFeedbackVaryings().
+    const std::vector<std::string>& transformFeedbackVaryings() const { return mTransformFeedbackVaryings; }
+
+    //! Whether the varyings are captured into a single interleaved buffer, see setTransformFeedbackVaryings().
+    bool transformFeedbackInterleaved() const { return mTransformFeedbackInterleaved; }
+
     // --------------- geometry shader ---------------
 
     // --------------- GLSL 4.x ---------------
@@ -396,25 +503,58 @@ namespace vl
      * This function expects the GLSLProgram to be already bound, see OpenGLContext::useGLSLProgram().
      *
      * @param uniforms If NULL uses GLSLProgram::getUniformSet()
+     * @param ctx The OpenGLContext the uniforms are applied to, if not NULL the debug checks are reported by OpenGLContext::countGLQuery().
     */
-    bool applyUniformSet(const UniformSet* uniforms = NULL) const;
+    bool applyUniformSet(const UniformSet* uniforms = NULL, OpenGLContext* ctx = NULL) const;
 
     /**
-    * Returns the binding index of the given uniform.
+     * Binds the given UniformBlock's buffer object to the corresponding uniform block of this program, if used.
+     * This function expects the GLSLProgram to be already bound, see OpenGLContext::useGLSLProgram().
+     * Returns false if the program does not declare a uniform block with the given name.
+     * \note UniformBlocks contained in a UniformSet are automatically applied by applyUniformSet().
     */
-    int getUniformLocation(const char* name) const
+    bool applyUniformBlock(const UniformBlock* block) const;
+
+    //! Returns the index of the given uniform block as returned by glGetUniformBlockIndex() or -1 if the program does not use such block.
+    int getUniformBlockIndex(const char* name) const
     {
       VL_CHECK_OGL();
-      VL_CHECK( Has_GLSL )
-      VL_CHECK( handle() )
-      if( ! Has_GLSL || ! linked() ) {
+      if( ! Has_Uniform_Buffer_Object || ! linked() ) {
         return -1;
       }
-      int location = glGetUniformLocation( handle(), name );
-      VL_CHECK_OGL();
-      return location;
+      GLuint index = glGetUniformBlockIndex( handle(), name ); VL_CHECK_OGL();
+      return index == GL_INVALID_INDEX ? -1 : (int)index;
     }
 
+    //! If enabled (default) applyUniformSet() skips the glUniform* call of a Uniform which has already been uploaded to this program
+    //! and whose value did not change since then (see Uniform::version()).
+    //! Disable it if you also set the values of the uniforms of this program directly with glUniform*().
+    void setUniformDeltaBindingEnabled(bool enabled) { mUniformDeltaBinding = enabled; mUniformSlots.clear(); }
+
+    //! Whether applyUniformSet() skips redundant uniform uploads, see setUniformDeltaBindingEnabled().
+    bool uniformDeltaBindingEnabled() const { return mUniformDeltaBinding; }
+
+    //! Number of glUniform* calls issued by applyUniformSet() since the last resetUniformUploadCounters().
+    unsigned long uniformUploadsIssued() const { return mUniformUploadsIssued; }
+
+    //! Number of glUniform* calls skipped by applyUniformSet() since the last resetUniformUploadCounters() because the uniform value did not change.
+    unsigned long uniformUploadsSkipped() const { return mUniformUploadsSkipped; }
+
+    //! Resets uniformUploadsIssued() and uniformUploadsSkipped() to 0.
+    void resetUniformUploadCounters() { mUniformUploadsIssued = mUniformUploadsSkipped = 0; }
+
+    /**
+    * Returns the binding index of the given uniform.
+    * The locations are cached by interned name until the program is relinked, see StringInterner.
+    */
+    int getUniformLocation(const char* name) const;
+
+    /**
+    * Returns the binding index of the uniform with the given interned name, see StringInterner::intern().
+    * Once the location is cached this only indexes a vector, which makes it suitable for per-token checks.
+    */
+    int getUniformLocation(int name_id) const;
+
     // --------------- uniform variables: getters ---------------
 
     // general uniform getters: use these to access to all the types supported by your GLSL implementation,
@@ -501,6 +641,10 @@ namespace vl
     //! Returns the binding location of the vl_ModelViewProjectionMatrix uniform variable or -1 if no such variable is used by the GLSLProgram.
     int vl_ModelViewProjectionMatrix() const  { return m_vl_ModelViewProjectionMatrix; }
 
+    //! Returns the index of the vl_CameraMatrices uniform block or -1 if no such block is used by the GLSLProgram.
+    //! See ProjViewTransfCallback for the layout of the block.
+    int vl_CameraMatrices() const { return m_vl_CameraMatrices; }
+
     //! Returns the binding location of the vl_NormalMatrix uniform variable or -1 if no such variable is used by the GLSLProgram
     //! vl_NormalMatrix is simply transpose( inverse( vl_ModelViewMatrix ) ) which usually allows to transform normals without having
     //! to renormalized them one by one by `undoing` the scaling that might be present in vl_ModelViewMatrix.
@@ -528,20 +672,91 @@ namespace vl
   private:
     void preLink();
     void postLink();
+    bool finishLink();
+    bool loadProgramBinary(GLenum binary_format, const void* binary, int length);
+    ProgramBinaryCache* activeProgramBinaryCache() const { return mProgramBinaryCache ? mProgramBinaryCache.get_writable() : defaultProgramBinaryCache(); }
     void operator=(const GLSLProgram&) { }
     void resetBindingLocations();
 
+    //! Per-uniform-name state: the location of the uniform and the Uniform/version last uploaded to it.
+    struct UniformSlot
+    {
+      UniformSlot(): mLocation(-2), mVersion(0) {}
+
+      int mLocation; // -2 means not yet queried
+      ref<Uniform> mUniform;
+      unsigned int mVersion;
+    };
+
+    //! Returns the UniformSlot of the given uniform querying its location if needed, see Uniform::nameID().
+    UniformSlot& uniformSlot(const Uniform* uniform) const { return uniformSlot( uniform->nameID(), uniform->name().c_str() ); }
+
+    //! Returns the UniformSlot of the uniform with the given interned name querying its location if needed, see StringInterner.
+    UniformSlot& uniformSlot(int name_id, const char* name) const;
+
+    //! Per-uniform-block-name state: the block index and the binding point currently assigned to it.
+    struct UniformBlockSlot
+    {
+      UniformBlockSlot(): mIndex(-2), mBindingPoint(-1) {}
+
+      int mIndex; // -2 means not yet queried
+      int mBindingPoint;
+    };
+
+    //! For internal use only. The state last applied to a GLSLProgram by a Renderer, used by Renderer::renderRaw()
+    //! to update matrices and uniform sets only when they change without having to look up any table.
+    //! mRenderer is non-NULL only while a Renderer is rendering with this program.
+    struct RendererState
+    {
+      RendererState(): mRenderer(NULL), mCamera(NULL), mTransform(NULL), mGLSLProgUniformSet(NULL), mShaderUniformSet(NULL), mActorUniformSet(NULL) {}
+
+      const void* mRenderer;
+      const Camera* mCamera;
+      const Transform* mTransform;
+      const UniformSet* mGLSLProgUniformSet;
+      const UniformSet* mShaderUniformSet;
+      const UniformSet* mActorUniformSet;
+    };
+
   protected:
     std::vector< ref<GLSLShader> > mShaders;
     std::map<std::string, int> mFragDataLocation;
+    std::vector<std::string> mTransformFeedbackVaryings;
+    bool mTransformFeedbackInterleaved;
     ref<UniformSet> mUniformSet;
     unsigned int mHandle;
     bool mScheduleLink;
 
+    // parallel compilation and binary cache
+    ref<GLSLProgram> mFallbackProgram;
+    ref<ProgramBinaryCache> mProgramBinaryCache;
+    bool mParallelLinkEnabled;
+    bool mLinkPending;
+    bool mLinkedFromCache;
+
+    // see Renderer::renderRaw()
+    mutable RendererState mRendererState;
+
+    // uniform locations and last uploaded values indexed by Uniform::nameID(). Cleared on (re)link.
+    mutable std::vector<UniformSlot> mUniformSlots;
+    // uniform block indices and binding points indexed by UniformBlock::nameID(). Cleared on (re)link.
+    mutable std::vector<UniformBlockSlot> mUniformBlockSlots;
+    // vertex attribute locations indexed by interned name, -2 means not yet queried. Cleared on (re)link.
+    mutable std::vector<int> mAttribLocations;
+    mutable unsigned long mUniformUploadsIssued;
+    mutable unsigned long mUniformUploadsSkipped;
+    bool mUniformDeltaBinding;
+
     // glProgramParameter
     bool mProgramBinaryRetrievableHint;
     bool mProgramSeparable;
 
+#ifdef VL_MULTI_CONTEXT_RENDERING
+    // see claimRenderContext(), released by deleteProgram()
+    mutable std::atomic<const OpenGLContext*> mRenderContext;
+    mutable std::atomic<bool> mRenderContextConflict;
+#endif
+
     // VL standard uniforms
 
     int m_vl_WorldMatrix;
@@ -549,6 +764,7 @@ namespace vl
     int m_vl_ProjectionMatrix;
     int m_vl_ModelViewProjectionMatrix;
     int m_vl_NormalMatrix;
+    int m_vl_CameraMatrices;
 
     // VL standard vertex attributes
 
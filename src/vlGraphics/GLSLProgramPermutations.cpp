@@ -0,0 +1,158 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/GLSLProgramPermutations.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cstdio>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// GLSLProgramPermutations
+//-----------------------------------------------------------------------------
+GLSLProgramPermutations::GLSLProgramPermutations()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mParallelLinkEnabled = false;
+}
+//-----------------------------------------------------------------------------
+void GLSLProgramPermutations::addShader(GLSLShader* shader)
+{
+  mBaseShaders.push_back(shader);
+  clearVariants();
+}
+//-----------------------------------------------------------------------------
+int GLSLProgramPermutations::addFeature(const char* name)
+{
+  int index = featureIndex(name);
+  if (index != -1)
+    return index;
+
+  if (mFeatures.size() == 64)
+  {
+    Log::error( Say("GLSLProgramPermutations::addFeature('%s'): too many features, at most 64 are supported.\n") << name );
+    return -1;
+  }
+
+  mFeatures.push_back(name);
+  return (int)mFeatures.size() - 1;
+}
+//-----------------------------------------------------------------------------
+int GLSLProgramPermutations::featureIndex(const char* name) const
+{
+  for(size_t i=0; i<mFeatures.size(); ++i)
+    if (mFeatures[i] == name)
+      return (int)i;
+  return -1;
+}
+//-----------------------------------------------------------------------------
+u64 GLSLProgramPermutations::key(const char* feature_list) const
+{
+  std::vector<String> names;
+  String(feature_list).split(" ,", names, true);
+
+  u64 k = 0;
+  for(size_t i=0; i<names.size(); ++i)
+  {
+    int index = featureIndex( names[i].toStdString().c_str() );
+    if (index == -1)
+      Log::error( Say("GLSLProgramPermutations::key(): unknown feature '%s'.\n") << names[i] );
+    else
+      k |= 1ULL << index;
+  }
+  return k;
+}
+//-----------------------------------------------------------------------------
+std::string GLSLProgramPermutations::insertDefines(const std::string& source, const std::string& defines)
+{
+  // #version must be the first directive of a shader, so the defines go right after it.
+  size_t version = source.find("#version");
+  if (version == std::string::npos)
+    return defines + source;
+
+  size_t eol = source.find('\n', version);
+  if (eol == std::string::npos)
+    return source + '\n' + defines;
+
+  return source.substr(0, eol + 1) + defines + source.substr(eol + 1);
+}
+//-----------------------------------------------------------------------------
+GLSLShader* GLSLProgramPermutations::variantShader(const GLSLShader* base, u64 key)
+{
+  // only define the features that the stage actually references so that variants share as many shaders as possible
+  std::string defines, names;
+  for(size_t i=0; i<mFeatures.size(); ++i)
+  {
+    if ( (key & (1ULL << i)) && base->source().find(mFeatures[i]) != std::string::npos )
+    {
+      defines += "#define " + mFeatures[i] + " 1\n";
+      names += names.empty() ? mFeatures[i] : " " + mFeatures[i];
+    }
+  }
+
+  std::string source = defines.empty() ? base->source() : insertDefines(base->source(), defines);
+
+  ref<GLSLShader>& shader = mShaders[ std::make_pair((int)base->type(), source) ];
+  if ( ! shader )
+  {
+    shader = new GLSLShader( base->type(), source );
+    shader->setObjectName( base->objectName() + " [" + names + "]" );
+  }
+  return shader.get();
+}
+//-----------------------------------------------------------------------------
+GLSLProgram* GLSLProgramPermutations::variant(u64 key)
+{
+  ref<GLSLProgram>& program = mVariants[key];
+  if ( program )
+    return program.get();
+
+  program = new GLSLProgram;
+  char name[32];
+  sprintf(name, " [%llx]", key);
+  program->setObjectName( objectName() + name );
+  program->setProgramBinaryCache( mProgramBinaryCache.get() );
+  program->setParallelLinkEnabled( mParallelLinkEnabled );
+  program->setFallbackProgram( mFallbackProgram.get() );
+
+  for(size_t i=0; i<mBaseShaders.size(); ++i)
+    program->attachShader( variantShader( mBaseShaders[i].get(), key ) );
+
+  return program.get();
+}
+//-----------------------------------------------------------------------------
+void GLSLProgramPermutations::clearVariants()
+{
+  mVariants.clear();
+  mShaders.clear();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,157 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef GLSLProgramPermutations_INCLUDE_ONCE
+#define GLSLProgramPermutations_INCLUDE_ONCE
+
+#include <vlGraphics/GLSL.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // GLSLProgramPermutations
+  //-----------------------------------------------------------------------------
+  /** Generates on demand the variants of a GLSL program that differ only by a set of compile-time feature flags.
+   *
+   * The base shaders contain the code of all the features guarded by `#ifdef FEATURE_NAME`. Each feature declared with
+   * addFeature() is identified by a bit, and variant() returns the GLSLProgram whose shaders are compiled with
+   * `#define FEATURE_NAME 1` inserted after the `#version` directive for every bit set in the key. Materials then
+   * select their program by key instead of maintaining their own copies of the sources:
+   *
+   * \code
+   * ref<GLSLProgramPermutations> perm = new GLSLProgramPermutations;
+   * perm->addShader( new GLSLVertexShader("/glsl/material.vs") );
+   * perm->addShader( new GLSLFragmentShader("/glsl/material.fs") );
+   * int normal_map = perm->addFeature("HAS_NORMAL_MAP");
+   * int skinning   = perm->addFeature("HAS_SKINNING");
+   * shader->setRenderState( perm->variant( (1ULL << normal_map) | (1ULL << skinning) ) );
+   * \endcode
+   *
+   * Variants are created once and cached by key. Shader objects are deduplicated per stage: a feature whose name does not
+   * appear in a stage's source is not defined for that stage, so all the variants differing only by that feature share the
+   * same compiled shader. The variants inherit the programBinaryCache(), parallelLinkEnabled() and fallbackProgram()
+   * settings, and since the cache key includes the preprocessed sources each variant gets its own cache entry.
+   * \sa GLSLProgram, ProgramBinaryCache */
+  class VLGRAPHICS_EXPORT GLSLProgramPermutations: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::GLSLProgramPermutations, Object)
+
+  public:
+    GLSLProgramPermutations();
+
+    //! Adds a base shader whose type and source are used to generate the variants. Invalidates the variants created so far.
+    void addShader(GLSLShader* shader);
+
+    //! The number of base shaders.
+    int shaderCount() const { return (int)mBaseShaders.size(); }
+
+    //! The i-th base shader.
+    GLSLShader* shader(int i) { return mBaseShaders[i].get(); }
+
+    //! The i-th base shader.
+    const GLSLShader* shader(int i) const { return mBaseShaders[i].get(); }
+
+    //! Declares a feature flag, i.e. a preprocessor symbol, and returns its bit index in the variant keys, at most 64 features are allowed.
+    //! Declaring the same feature twice returns the same index. Returns -1 on error.
+    int addFeature(const char* name);
+
+    //! Returns the bit index of the given feature or -1 if it has not been declared.
+    int featureIndex(const char* name) const;
+
+    //! The declared features, in bit order.
+    const std::vector<std::string>& features() const { return mFeatures; }
+
+    //! Returns the key corresponding to a space or comma separated list of feature names, e.g. "HAS_NORMAL_MAP HAS_SKINNING".
+    //! Unknown names are reported and ignored.
+    u64 key(const char* feature_list) const;
+
+    //! Returns the variant for the given key, creating it if needed. The program is linked lazily like any other GLSLProgram.
+    GLSLProgram* variant(u64 key);
+
+    //! Equivalent to variant(key(feature_list)).
+    GLSLProgram* variant(const char* feature_list) { return variant( key(feature_list) ); }
+
+    //! The number of variants created so far.
+    int variantCount() const { return (int)mVariants.size(); }
+
+    //! The number of distinct shader objects created so far for all the variants.
+    int variantShaderCount() const { return (int)mShaders.size(); }
+
+    //! Releases all the variants and their shaders. Variants still referenced elsewhere remain valid but are no longer cached.
+    void clearVariants();
+
+    //! Inserts the given text right after the `#version` directive of the source, or at the beginning if there is none.
+    static std::string insertDefines(const std::string& source, const std::string& defines);
+
+    // --- settings inherited by the variants ---
+
+    //! Program binary cache assigned to the variants, see GLSLProgram::setProgramBinaryCache().
+    void setProgramBinaryCache(ProgramBinaryCache* cache) { mProgramBinaryCache = cache; }
+
+    //! Program binary cache assigned to the variants, see GLSLProgram::setProgramBinaryCache().
+    ProgramBinaryCache* programBinaryCache() { return mProgramBinaryCache.get(); }
+
+    //! Program binary cache assigned to the variants, see GLSLProgram::setProgramBinaryCache().
+    const ProgramBinaryCache* programBinaryCache() const { return mProgramBinaryCache.get(); }
+
+    //! Whether the variants are linked in parallel, see GLSLProgram::setParallelLinkEnabled().
+    void setParallelLinkEnabled(bool enabled) { mParallelLinkEnabled = enabled; }
+
+    //! Whether the variants are linked in parallel, see GLSLProgram::setParallelLinkEnabled().
+    bool parallelLinkEnabled() const { return mParallelLinkEnabled; }
+
+    //! Program used by the variants while they are being linked, see GLSLProgram::setFallbackProgram().
+    void setFallbackProgram(GLSLProgram* program) { mFallbackProgram = program; }
+
+    //! Program used by the variants while they are being linked, see GLSLProgram::setFallbackProgram().
+    GLSLProgram* fallbackProgram() { return mFallbackProgram.get(); }
+
+    //! Program used by the variants while they are being linked, see GLSLProgram::setFallbackProgram().
+    const GLSLProgram* fallbackProgram() const { return mFallbackProgram.get(); }
+
+  protected:
+    GLSLShader* variantShader(const GLSLShader* base, u64 key);
+
+  protected:
+    std::vector< ref<GLSLShader> > mBaseShaders;
+    std::vector<std::string> mFeatures;
+    std::map< u64, ref<GLSLProgram> > mVariants;
+    // distinct variant shaders indexed by stage type and final source
+    std::map< std::pair<int, std::string>, ref<GLSLShader> > mShaders;
+    ref<ProgramBinaryCache> mProgramBinaryCache;
+    ref<GLSLProgram> mFallbackProgram;
+    bool mParallelLinkEnabled;
+  };
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include <vlGraphics/DoubleVertexRemover.hpp>
 #include <vlGraphics/MultiDrawElements.hpp>
 #include <vlGraphics/DrawRangeElements.hpp>
+#include <vlGraphics/TriangleVisitor.hpp>
 #include <cmath>
 #include <algorithm>
 
@@ -52,6 +53,15 @@ Geometry::~Geometry()
 {
 }
 //-----------------------------------------------------------------------------
+const TriangleBVH* Geometry::triangleBVH() const
+{
+  if (!mTriangleBVH)
+    mTriangleBVH = new TriangleBVH;
+  if (!mTriangleBVH->isUpToDate(this))
+    mTriangleBVH->build(this);
+  return mTriangleBVH.get();
+}
+//-----------------------------------------------------------------------------
 void Geometry::computeBounds_Implementation()
 {
   const ArrayAbstract* coords = vertexArray();
@@ -124,6 +134,37 @@ Geometry& Geometry::deepCopyFrom(const Geometry& other)
   return *this;
 }
 //-----------------------------------------------------------------------------
+ref<Geometry> Geometry::cowCopy() const
+{
+  ref<Geometry> geom = new Geometry;
+  geom->cowCopyFrom(*this);
+  return geom;
+}
+//-----------------------------------------------------------------------------
+Geometry& Geometry::cowCopyFrom(const Geometry& other)
+{
+  // copy the base class Renderable
+  super::operator=(other);
+
+  // share generic vertex attribs
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    if ( other.mVertexAttribArrays[i].get() ) {
+      mVertexAttribArrays[i] = other.mVertexAttribArrays[i]->cowClone().get();
+    } else {
+      mVertexAttribArrays[i] = NULL;
+    }
+  }
+
+  // primitives
+  mDrawCalls.clear();
+  for(int i=0; i<other.mDrawCalls.size(); ++i) {
+    mDrawCalls.push_back( other.mDrawCalls[i]->cowClone().get() );
+  }
+
+  return *this;
+}
+//-----------------------------------------------------------------------------
 ref<Geometry> Geometry::shallowCopy() const
 {
   ref<Geometry> geom = new Geometry;
@@ -227,7 +268,8 @@ void Geometry::setTexCoordArray(int tex_unit, ArrayAbstract* data)
   VL_CHECK( !data || (data->glType() == GL_FLOAT  ||
                       data->glType() == GL_DOUBLE ||
                       data->glType() == GL_SHORT  ||
-                      data->glType() == GL_INT) );
+                      data->glType() == GL_INT    ||
+                      data->glType() == GL_HALF_FLOAT) );
 
   VL_CHECK( tex_unit < VA_MaxTexCoordCount );
 
@@ -266,6 +308,63 @@ bool Geometry::flipNormals()
   return false;
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  // Below this number of triangles the threading overhead is not worth it.
+  const int ParallelTriangleThreshold = 16*1024;
+
+  // Flattens the triangles of one or more DrawCalls and builds a vertex -> triangle adjacency table so that
+  // per-triangle quantities can be computed in parallel and then gathered per-vertex without write conflicts.
+  // Since each vertex lists its triangles in the original order the results are identical to a serial scatter.
+  class TriangleAdjacency
+  {
+  public:
+    void addTriangles(const DrawCall* dc)
+    {
+      forEachTriangle(dc, *this);
+    }
+
+    //! Triangle visitor, see forEachTriangle().
+    void operator()(int a, int b, int c)
+    {
+      mTriangles.push_back( a );
+      mTriangles.push_back( b );
+      mTriangles.push_back( c );
+    }
+
+    void buildAdjacency(u32 vert_count)
+    {
+      mOffsets.assign(vert_count + 1, 0);
+      for(size_t i=0; i<mTriangles.size(); ++i)
+      {
+        VL_CHECK( mTriangles[i] < vert_count )
+        ++mOffsets[ mTriangles[i] + 1 ];
+      }
+      for(u32 i=0; i<vert_count; ++i)
+        mOffsets[i+1] += mOffsets[i];
+
+      mFaces.resize( mTriangles.size() );
+      std::vector<u32> cursor( mOffsets.begin(), mOffsets.end() - 1 );
+      for(size_t i=0; i<mTriangles.size(); ++i)
+        mFaces[ cursor[ mTriangles[i] ]++ ] = (u32)(i / 3);
+    }
+
+    int triangleCount() const { return (int)mTriangles.size() / 3; }
+
+    const u32* triangle(int i) const { return &mTriangles[i*3]; }
+
+    //! The triangles using vertex \p v are faces()[ offsets()[v] ] ... faces()[ offsets()[v+1]-1 ].
+    const std::vector<u32>& offsets() const { return mOffsets; }
+
+    const std::vector<u32>& faces() const { return mFaces; }
+
+  private:
+    std::vector<u32> mTriangles;
+    std::vector<u32> mOffsets;
+    std::vector<u32> mFaces;
+  };
+}
+//-----------------------------------------------------------------------------
 void Geometry::computeNormals(bool verbose)
 {
   // Retrieve vertex position array
@@ -282,65 +381,77 @@ void Geometry::computeNormals(bool verbose)
   // Install the normal array
   setNormalArray( norm3f.get() );
 
-  // zero the normals
-  for(u32 i=0; i<norm3f->size(); ++i)
-    (*norm3f)[i] = 0;
-
-  // iterate all draw calls
+  TriangleAdjacency adjacency;
   for(int prim=0; prim<(int)drawCalls().size(); prim++)
+    adjacency.addTriangles( mDrawCalls[prim].get() );
+  adjacency.buildAdjacency( (u32)posarr->size() );
+
+  std::vector<vec3> pos_storage;
+  const vec3* pos = vec3Data(posarr, pos_storage);
+
+  // compute the face normals: the verbose checks are performed serially to keep the log readable.
+  const int tri_count = adjacency.triangleCount();
+  std::vector<fvec3> face_normals( tri_count );
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(!verbose && tri_count > ParallelTriangleThreshold)
+#endif
+  for(int itri=0; itri<tri_count; ++itri)
   {
-    // iterate all triangles, if present
-    for(TriangleIterator trit = mDrawCalls[prim]->triangleIterator(); trit.hasNext(); trit.next())
-    {
-      u32 a = trit.a();
-      u32 b = trit.b();
-      u32 c = trit.c();
-
-      if (verbose)
-      if (a == b || b == c || c == a)
-      {
-        Log::warning( Say("Geometry::computeNormals(): skipping degenerate triangle %n %n %n\n") << a << b << c );
-        continue;
-      }
+    const u32* tri = adjacency.triangle(itri);
+    u32 a = tri[0];
+    u32 b = tri[1];
+    u32 c = tri[2];
 
-      VL_CHECK( a < posarr->size() )
-      VL_CHECK( b < posarr->size() )
-      VL_CHECK( c < posarr->size() )
+    if (verbose)
+    if (a == b || b == c || c == a)
+    {
+      Log::warning( Say("Geometry::computeNormals(): skipping degenerate triangle %n %n %n\n") << a << b << c );
+      continue;
+    }
 
-      vec3 n, v0, v1, v2;
+    vec3 n, v0, v1, v2;
 
-      v0 = posarr->getAsVec3(a);
-      v1 = posarr->getAsVec3(b);
-      v2 = posarr->getAsVec3(c);
+    v0 = pos[a];
+    v1 = pos[b];
+    v2 = pos[c];
 
-      if (verbose)
-      if (v0 == v1 || v1 == v2 || v2 == v0)
-      {
-        Log::warning("Geometry::computeNormals(): skipping degenerate triangle (same vertex coodinate).\n");
-        continue;
-      }
+    if (verbose)
+    if (v0 == v1 || v1 == v2 || v2 == v0)
+    {
+      Log::warning("Geometry::computeNormals(): skipping degenerate triangle (same vertex coodinate).\n");
+      continue;
+    }
 
-      v1 -= v0;
-      v2 -= v0;
+    v1 -= v0;
+    v2 -= v0;
 
-      n = cross(v1, v2);
-      n.normalize();
-      if (verbose)
-      if ( fabs(1.0f - n.length()) > 0.1f )
-      {
-        Log::warning("Geometry::computeNormals(): skipping degenerate triangle (normalization failed).\n");
-        continue;
-      }
-
-      (*norm3f)[a] += (fvec3)n;
-      (*norm3f)[b] += (fvec3)n;
-      (*norm3f)[c] += (fvec3)n;
+    n = cross(v1, v2);
+    n.normalize();
+    if (verbose)
+    if ( fabs(1.0f - n.length()) > 0.1f )
+    {
+      Log::warning("Geometry::computeNormals(): skipping degenerate triangle (normalization failed).\n");
+      continue;
     }
+
+    face_normals[itri] = (fvec3)n;
   }
 
-  // normalize the normals
-  for(int i=0; i<(int)norm3f->size(); ++i)
-    (*norm3f)[i].normalize();
+  // gather and normalize the vertex normals
+  const std::vector<u32>& offsets = adjacency.offsets();
+  const std::vector<u32>& faces = adjacency.faces();
+  const int vert_count = (int)norm3f->size();
+  fvec3* normals = norm3f->begin();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(tri_count > ParallelTriangleThreshold)
+#endif
+  for(int i=0; i<vert_count; ++i)
+  {
+    fvec3 n(0,0,0);
+    for(u32 j=offsets[i]; j<offsets[i+1]; ++j)
+      n += face_normals[ faces[j] ];
+    normals[i] = n.normalize();
+  }
 }
 //-----------------------------------------------------------------------------
 void Geometry::deleteBufferObject()
@@ -353,10 +464,14 @@ void Geometry::deleteBufferObject()
   }
 
   for(int i=0; i<VA_MaxAttribCount; ++i) {
-    if ( mVertexAttribArrays[i]->bufferObject() ) {
+    if ( mVertexAttribArrays[i] && mVertexAttribArrays[i]->bufferObject() ) {
       mVertexAttribArrays[i]->bufferObject()->deleteBufferObject();
     }
   }
+
+  if ( mInterleavedBufferObject ) {
+    mInterleavedBufferObject->deleteBufferObject();
+  }
 }
 //-----------------------------------------------------------------------------
 void Geometry::updateDirtyBufferObject(EBufferObjectUpdateMode mode)
@@ -366,9 +481,27 @@ void Geometry::updateDirtyBufferObject(EBufferObjectUpdateMode mode)
 
   bool force_update = (mode & BUF_ForceUpdate) != 0;
 
-  for(int i=0; i<VA_MaxAttribCount; ++i) {
-    if ( mVertexAttribArrays[i].get() && mVertexAttribArrays[i]->bufferObject() && (mVertexAttribArrays[i]->isBufferObjectDirty() || force_update) ) {
-      mVertexAttribArrays[i]->updateBufferObject(mode);
+  if ( mInterleavedBufferObject )
+  {
+    // the arrays are sourced from the interleaved buffer: rebuild and upload it instead of the individual arrays
+    bool dirty = force_update;
+    for(int i=0; i<VA_MaxAttribCount && !dirty; ++i)
+      dirty = mVertexAttribArrays[i] && mVertexAttribArrays[i]->isBufferObjectDirty();
+
+    if ( dirty && interleave() )
+    {
+      mInterleavedBufferObject->setBufferData( BU_STATIC_DRAW, (mode & BUF_DiscardRamBuffer) != 0 );
+      for(int i=0; i<VA_MaxAttribCount; ++i)
+        if ( mVertexAttribArrays[i] )
+          mVertexAttribArrays[i]->setBufferObjectDirty(false);
+    }
+  }
+  else
+  {
+    for(int i=0; i<VA_MaxAttribCount; ++i) {
+      if ( mVertexAttribArrays[i].get() && mVertexAttribArrays[i]->bufferObject() && (mVertexAttribArrays[i]->isBufferObjectDirty() || force_update) ) {
+        mVertexAttribArrays[i]->updateBufferObject(mode);
+      }
     }
   }
 
@@ -376,6 +509,93 @@ void Geometry::updateDirtyBufferObject(EBufferObjectUpdateMode mode)
     drawCalls().at(i)->updateDirtyBufferObject(mode);
 }
 //-----------------------------------------------------------------------------
+bool Geometry::interleave()
+{
+  // compute the layout of the interleaved vertex
+  size_t vert_count = 0;
+  int stride = 0;
+  int offsets[VA_MaxAttribCount];
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    offsets[i] = -1;
+    const ArrayAbstract* arr = mVertexAttribArrays[i].get();
+    if ( !arr || !arr->size() )
+      continue;
+
+    if ( vert_count && arr->size() != vert_count )
+    {
+      Log::error( Say("Geometry::interleave(): vertex attribute #%n has %n elements instead of %n.\n") << i << arr->size() << vert_count );
+      return false;
+    }
+    vert_count = arr->size();
+
+    // the same array can be bound to more than one slot
+    for(int j=0; j<i; ++j)
+    {
+      if ( mVertexAttribArrays[j].get() == arr )
+      {
+        offsets[i] = offsets[j];
+        break;
+      }
+    }
+    if ( offsets[i] != -1 )
+      continue;
+
+    offsets[i] = stride;
+    int bytes_per_vector = (int)(arr->bytesUsed() / arr->size());
+    stride += (bytes_per_vector + 3) & ~3;
+  }
+
+  if ( !vert_count )
+    return false;
+
+  if ( !mInterleavedBufferObject )
+    mInterleavedBufferObject = new BufferObject;
+  mInterleavedBufferObject->resize( vert_count * stride );
+  memset( mInterleavedBufferObject->ptr(), 0, mInterleavedBufferObject->bytesUsed() );
+
+  // fill the interleaved buffer
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    ArrayAbstract* arr = mVertexAttribArrays[i].get();
+    if ( offsets[i] == -1 )
+    {
+      if ( arr )
+        arr->setInterleavedView(NULL, 0, 0);
+      continue;
+    }
+
+    arr->setInterleavedView( mInterleavedBufferObject.get(), offsets[i], stride );
+
+    int bytes_per_vector = (int)(arr->bytesUsed() / arr->size());
+    const unsigned char* src = arr->ptr();
+    unsigned char* dst = mInterleavedBufferObject->ptr() + offsets[i];
+    for(size_t v=0; v<vert_count; ++v, src += bytes_per_vector, dst += stride)
+      memcpy( dst, src, bytes_per_vector );
+  }
+
+  setBufferObjectDirty(true);
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Geometry::deinterleave()
+{
+  if ( !mInterleavedBufferObject )
+    return;
+
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    if ( mVertexAttribArrays[i] )
+    {
+      mVertexAttribArrays[i]->setInterleavedView(NULL, 0, 0);
+      mVertexAttribArrays[i]->setBufferObjectDirty(true);
+    }
+  }
+
+  mInterleavedBufferObject = NULL;
+  setBufferObjectDirty(true);
+}
+//-----------------------------------------------------------------------------
 void Geometry::render_Implementation(const Actor*, const Shader*, const Camera*, OpenGLContext* gl_ctx) const
 {
   VL_CHECK_OGL()
@@ -390,6 +610,7 @@ void Geometry::render_Implementation(const Actor*, const Shader*, const Camera*,
   for( int i = 0; i < (int)drawCalls().size(); i++ ) {
     if ( drawCalls().at(i)->isEnabled() ) {
       drawCalls().at(i)->render( vbo_on );
+      drawCalls().at(i)->countRenderStats( gl_ctx->renderStats() );
     }
   }
 
@@ -412,6 +633,131 @@ void Geometry::transform(const mat4& m, bool normalize)
   }
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  inline bool isFloatArray(const ArrayAbstract* arr)
+  {
+    return arr && (arr->glType() == GL_FLOAT || arr->glType() == GL_DOUBLE);
+  }
+
+  inline GLshort toSNorm16(real v)
+  {
+    v = v < -1 ? -1 : (v > 1 ? 1 : v);
+    return (GLshort)::floor(v * 32767 + (real)0.5);
+  }
+
+  inline GLbyte toSNorm8(real v)
+  {
+    v = v < -1 ? -1 : (v > 1 ? 1 : v);
+    return (GLbyte)::floor(v * 127 + (real)0.5);
+  }
+}
+//-----------------------------------------------------------------------------
+mat4 Geometry::quantize(bool positions, ENormalQuantization normals, bool texcoords)
+{
+  mat4 decode_matrix;
+  if (!vertexArray() || vertexArray()->size() == 0)
+    return decode_matrix;
+
+  // the interleaved buffer references the old arrays, it will be rebuilt at the end
+  bool was_interleaved = isInterleaved();
+  if (was_interleaved)
+    deinterleave();
+
+  const size_t count = vertexArray()->size();
+
+  if (positions && isFloatArray(vertexArray()) && vertexArray()->glSize() == 3)
+  {
+    AABB aabb = vertexArray()->computeBoundingBox();
+    vec3 center = aabb.center();
+    real half_extent = vl::max( vl::max(aabb.width(), aabb.height()), aabb.depth() ) / 2;
+    real scale = half_extent > 0 ? half_extent / 32767 : 1;
+
+    ref<ArrayShort3> qpos = new ArrayShort3;
+    qpos->resize(count);
+    for(size_t i=0; i<count; ++i)
+    {
+      vec3 v = (vertexArray()->getAsVec3(i) - center) / scale;
+      qpos->at(i) = svec3( (GLshort)::floor(v.x() + (real)0.5), (GLshort)::floor(v.y() + (real)0.5), (GLshort)::floor(v.z() + (real)0.5) );
+    }
+    setVertexArray(qpos.get());
+
+    decode_matrix = mat4::getTranslation(center) * mat4::getScaling(scale, scale, scale);
+  }
+
+  if (normals != NQ_None && isFloatArray(normalArray()) && normalArray()->glSize() == 3 && normalArray()->size() == count)
+  {
+    ref<ArrayAbstract> qnorm;
+    if (normals == NQ_Byte3)
+    {
+      ref<ArrayByte3> arr = new ArrayByte3;
+      arr->resize(count);
+      for(size_t i=0; i<count; ++i)
+      {
+        vec3 n = normalArray()->getAsVec3(i).normalize();
+        arr->at(i) = bvec3( toSNorm8(n.x()), toSNorm8(n.y()), toSNorm8(n.z()) );
+      }
+      qnorm = arr;
+    }
+    else
+    if (normals == NQ_Short3)
+    {
+      ref<ArrayShort3> arr = new ArrayShort3;
+      arr->resize(count);
+      for(size_t i=0; i<count; ++i)
+      {
+        vec3 n = normalArray()->getAsVec3(i).normalize();
+        arr->at(i) = svec3( toSNorm16(n.x()), toSNorm16(n.y()), toSNorm16(n.z()) );
+      }
+      qnorm = arr;
+    }
+    else
+    {
+      VL_CHECK(normals == NQ_Octahedral)
+      ref<ArrayShort2> arr = new ArrayShort2;
+      arr->resize(count);
+      for(size_t i=0; i<count; ++i)
+      {
+        vec3 n = normalArray()->getAsVec3(i);
+        real l1 = ::fabs(n.x()) + ::fabs(n.y()) + ::fabs(n.z());
+        real x = l1 > 0 ? n.x() / l1 : 0;
+        real y = l1 > 0 ? n.y() / l1 : 0;
+        if (n.z() < 0)
+        {
+          real ox = x;
+          x = (1 - ::fabs(y))  * (ox >= 0 ? 1 : -1);
+          y = (1 - ::fabs(ox)) * (y  >= 0 ? 1 : -1);
+        }
+        arr->at(i) = svec2( toSNorm16(x), toSNorm16(y) );
+      }
+      qnorm = arr;
+    }
+    qnorm->setNormalize(true);
+    // octahedral normals have 2 components and cannot go through setNormalArray()'s glNormalPointer() checks
+    setVertexAttribArray(VA_Normal, qnorm.get());
+  }
+
+  if (texcoords)
+  {
+    for(int tex_unit=0; tex_unit<VA_MaxTexCoordCount; ++tex_unit)
+    {
+      ArrayFloat2* tex = cast<ArrayFloat2>(texCoordArray(tex_unit));
+      if (!tex)
+        continue;
+      ref<ArrayHFloat2> htex = new ArrayHFloat2;
+      htex->resize(tex->size());
+      if (tex->size())
+        half::convertFloatToHalf(tex->begin()->ptr(), htex->begin()->ptr(), (int)tex->size() * 2);
+      setTexCoordArray(tex_unit, htex.get());
+    }
+  }
+
+  if (was_interleaved)
+    interleave();
+
+  return decode_matrix;
+}
+//-----------------------------------------------------------------------------
 void Geometry::setVertexAttribArray(int attrib_location, const ArrayAbstract* info)
 {
   mVertexAttribArrays[attrib_location] = info;
@@ -602,6 +948,64 @@ void Geometry::mergeDrawCallsWithMultiDrawElements(EPrimitiveType primitive_type
   drawCalls().push_back( de_multi.get() );
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  // Triangle visitors, see forEachTriangle().
+
+  struct TriangleCounter
+  {
+    void operator()(int, int, int) {}
+  };
+
+  struct TriangleCopier
+  {
+    TriangleCopier(u32* ptr): mPtr(ptr) {}
+
+    void operator()(int a, int b, int c)
+    {
+      VL_CHECK( a >= 0 && b >= 0 && c >= 0 );
+      mPtr[0] = a;
+      mPtr[1] = b;
+      mPtr[2] = c;
+      mPtr += 3;
+    }
+
+    u32* mPtr;
+  };
+
+  // Copies the triangles flipping the ones whose winding disagrees with the average of their vertex normals.
+  struct TriangleWindingFixer
+  {
+    TriangleWindingFixer(u32* ptr, const vec3* pos, const vec3* norm): mPtr(ptr), mPos(pos), mNorm(norm) {}
+
+    void operator()(int a, int b, int c)
+    {
+      vec3 p0 = mPos[a];
+      vec3 p1 = (mPos[b] - p0).normalize();
+      vec3 p2 = (mPos[c] - p0).normalize();
+      vec3 n1 = vl::cross(p1, p2);
+      vec3 n2 = (mNorm[a] + mNorm[b] + mNorm[c]).normalize();
+
+      mPtr[0] = a;
+      if (dot(n1, n2) > 0)
+      {
+        mPtr[1] = b;
+        mPtr[2] = c;
+      }
+      else
+      {
+        mPtr[1] = c;
+        mPtr[2] = b;
+      }
+      mPtr += 3;
+    }
+
+    u32* mPtr;
+    const vec3* mPos;
+    const vec3* mNorm;
+  };
+}
+//-----------------------------------------------------------------------------
 void Geometry::mergeDrawCallsWithTriangles(EPrimitiveType primitive_type)
 {
   u32 triangle_count = 0;
@@ -626,7 +1030,8 @@ void Geometry::mergeDrawCallsWithTriangles(EPrimitiveType primitive_type)
 
     if (primitive_type == PT_UNKNOWN || dc.primitiveType() == primitive_type || dc.primitiveType() == PT_TRIANGLES)
     {
-      triangle_count += dc.countTriangles();
+      TriangleCounter counter;
+      triangle_count += forEachTriangle(&dc, counter);
       // insert at the head to preserve the primitive rendering order
       mergendo_calls.insert( mergendo_calls.begin(), drawCalls().at(i) );
       drawCalls().eraseAt(i);
@@ -652,23 +1057,10 @@ void Geometry::mergeDrawCallsWithTriangles(EPrimitiveType primitive_type)
   ref<DrawElementsUInt> de = new DrawElementsUInt;
   ArrayUInt1& index_buffer = *de->indexBuffer();
   index_buffer.resize( triangle_count * 3 );
-  u32 idx = 0;
+  TriangleCopier copier( index_buffer.begin() );
   for(u32 i=0; i<mergendo_calls.size(); ++i)
-  {
-    for(TriangleIterator it = mergendo_calls[i]->triangleIterator(); it.hasNext(); it.next(), idx+=3)
-    {
-      VL_CHECK( idx+2 < index_buffer.size() );
-
-      index_buffer[idx+0] = it.a();
-      index_buffer[idx+1] = it.b();
-      index_buffer[idx+2] = it.c();
-
-      // some sanity checks since we are here...
-      // VL_CHECK( it.a() < (int)posarr->size() && it.b() < (int)posarr->size() && it.c() < (int)posarr->size() );
-      VL_CHECK( it.a() >= 0 && it.b() >= 0 && it.c() >= 0 );
-    }
-  }
-  VL_CHECK( idx == index_buffer.size() );
+    forEachTriangle(mergendo_calls[i].get(), copier);
+  VL_CHECK( copier.mPtr == index_buffer.end() );
   drawCalls().push_back(de.get());
 }
 //-----------------------------------------------------------------------------
@@ -702,7 +1094,8 @@ void Geometry::fixTriangleWinding()
       continue;
     }
 
-    triangle_count += dc.countTriangles();
+    TriangleCounter counter;
+    triangle_count += forEachTriangle(&dc, counter);
     // insert at the head to preserve the primitive rendering order
     mergendo_calls.insert( mergendo_calls.begin(), drawCalls().at(i) );
     drawCalls().eraseAt(i);
@@ -710,47 +1103,21 @@ void Geometry::fixTriangleWinding()
   // preseve rendering order
   std::reverse(mergendo_calls.begin(), mergendo_calls.end());
 
+  std::vector<vec3> pos_storage, norm_storage;
+  const vec3* pos = vec3Data(posarr, pos_storage);
+  const vec3* norm = vec3Data(normarr, norm_storage);
+
   ref<DrawElementsUInt> de = new DrawElementsUInt;
   ArrayUInt1& index_buffer = *de->indexBuffer();
   index_buffer.resize( triangle_count * 3 );
-  u32 idx = 0;
-  for(u32 i=0; i<mergendo_calls.size(); ++i)
+  if (triangle_count)
   {
-    for(TriangleIterator it = mergendo_calls[i]->triangleIterator(); it.hasNext(); it.next(), idx+=3)
-    {
-      VL_CHECK( idx+2 < index_buffer.size() );
-
-      vec3 p0 = posarr->getAsVec3(it.a());
-      vec3 p1 = posarr->getAsVec3(it.b());
-      vec3 p2 = posarr->getAsVec3(it.c());
-      p1 = (p1 - p0).normalize();
-      p2 = (p2 - p0).normalize();
-      vec3 n1 = vl::cross(p1, p2);
-
-      vec3 v0 = normarr->getAsVec3(it.a());
-      vec3 v1 = normarr->getAsVec3(it.b());
-      vec3 v2 = normarr->getAsVec3(it.c());
-      vec3 n2 = (v0+v1+v2).normalize();
-
-      if (dot(n1, n2) > 0)
-      {
-        index_buffer[idx+0] = it.a();
-        index_buffer[idx+1] = it.b();
-        index_buffer[idx+2] = it.c();
-      }
-      else
-      {
-        index_buffer[idx+0] = it.a();
-        index_buffer[idx+1] = it.c();
-        index_buffer[idx+2] = it.b();
-      }
-
-      // some sanity checks since we are here...
-      VL_CHECK( it.a() < (int)posarr->size() && it.b() < (int)posarr->size() && it.c() < (int)posarr->size() );
-      VL_CHECK( it.a() >= 0 && it.b() >= 0 && it.c() >= 0 );
-    }
+    VL_CHECK(pos && norm)
+    TriangleWindingFixer fixer( index_buffer.begin(), pos, norm );
+    for(u32 i=0; i<mergendo_calls.size(); ++i)
+      forEachTriangle(mergendo_calls[i].get(), fixer);
+    VL_CHECK( fixer.mPtr == index_buffer.end() );
   }
-  VL_CHECK( idx == index_buffer.size() );
   drawCalls().push_back(de.get());
 }
 //-----------------------------------------------------------------------------
@@ -803,18 +1170,14 @@ void Geometry::triangulateDrawCalls()
       continue;
     }
 
-    u32 tri_count = dc->countTriangles();
+    TriangleCounter counter;
+    u32 tri_count = forEachTriangle(dc, counter);
 
     ref<DrawElementsUInt> triangles = new DrawElementsUInt(PT_TRIANGLES, dc->instances());
     triangles->indexBuffer()->resize( tri_count*3 );
-    unsigned int* ptr = triangles->indexBuffer()->begin();
-    for( TriangleIterator it = dc->triangleIterator(); it.hasNext(); ++it, ptr+=3 )
-    {
-      ptr[0] = it.a();
-      ptr[1] = it.b();
-      ptr[2] = it.c();
-    }
-    VL_CHECK( ptr == triangles->indexBuffer()->end() )
+    TriangleCopier copier( triangles->indexBuffer()->begin() );
+    forEachTriangle(dc, copier);
+    VL_CHECK( copier.mPtr == triangles->indexBuffer()->end() )
     // substitute the draw call
     drawCalls()[idraw] = triangles;
   }
@@ -1199,18 +1562,20 @@ void Geometry::computeTangentSpace(
   fvec3 *tangent,
   fvec3 *bitangent )
 {
-  std::vector<fvec3> tan1;
-  std::vector<fvec3> tan2;
-  tan1.resize(vert_count);
-  tan2.resize(vert_count);
-
-  for ( TriangleIterator trit = prim->triangleIterator(); trit.hasNext(); trit.next() )
+  TriangleAdjacency adjacency;
+  adjacency.addTriangles(prim);
+  adjacency.buildAdjacency(vert_count);
+
+  // per-triangle tangent and bitangent directions
+  const int tri_count = adjacency.triangleCount();
+  std::vector<fvec3> face_sdir( tri_count );
+  std::vector<fvec3> face_tdir( tri_count );
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(tri_count > ParallelTriangleThreshold)
+#endif
+  for (int itri=0; itri<tri_count; ++itri)
   {
-    int tri[] = { trit.a(), trit.b(), trit.c() };
-
-    VL_CHECK(tri[0] < (int)vert_count );
-    VL_CHECK(tri[1] < (int)vert_count );
-    VL_CHECK(tri[2] < (int)vert_count );
+    const u32* tri = adjacency.triangle(itri);
 
     const fvec3& v1 = vertex[tri[0]];
     const fvec3& v2 = vertex[tri[1]];
@@ -1233,22 +1598,27 @@ void Geometry::computeTangentSpace(
     float t2 = w3.y() - w1.y();
 
     float r = 1.0F / (s1 * t2 - s2 * t1);
-    fvec3 sdir((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
-    fvec3 tdir((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
-
-    tan1[tri[0]] += sdir;
-    tan1[tri[1]] += sdir;
-    tan1[tri[2]] += sdir;
-
-    tan2[tri[0]] += tdir;
-    tan2[tri[1]] += tdir;
-    tan2[tri[2]] += tdir;
+    face_sdir[itri] = fvec3((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+    face_tdir[itri] = fvec3((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
   }
 
-  for ( u32 a = 0; a < vert_count; a++)
+  // gather per-vertex and orthogonalize
+  const std::vector<u32>& offsets = adjacency.offsets();
+  const std::vector<u32>& faces = adjacency.faces();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(tri_count > ParallelTriangleThreshold)
+#endif
+  for ( int a = 0; a < (int)vert_count; a++)
   {
+    fvec3 t(0,0,0);
+    fvec3 t2(0,0,0);
+    for(u32 j=offsets[a]; j<offsets[a+1]; ++j)
+    {
+      t  += face_sdir[ faces[j] ];
+      t2 += face_tdir[ faces[j] ];
+    }
+
     const fvec3& n = normal[a];
-    const fvec3& t = tan1[a];
 
     // Gram-Schmidt orthogonalize
     tangent[a] = (t - n * dot(n, t)).normalize();
@@ -1256,7 +1626,7 @@ void Geometry::computeTangentSpace(
     if ( bitangent )
     {
       // Calculate handedness
-      float w = (dot(cross(n, t), tan2[a]) < 0.0F) ? -1.0F : 1.0F;
+      float w = (dot(cross(n, t), t2) < 0.0F) ? -1.0F : 1.0F;
       bitangent[a] = cross( n, tangent[a] ) * w;
     }
   }
@@ -43,6 +43,7 @@
 #include <vlCore/Colors.hpp>
 #include <vlGraphics/DrawElements.hpp>
 #include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/TriangleBVH.hpp>
 #include <vlCore/Collection.hpp>
 
 namespace vl
@@ -98,6 +99,18 @@ namespace vl
      * @sa shallowCopy() */
     Geometry& deepCopyFrom(const Geometry&);
 
+    /**
+     * Performs a copy-on-write copy of a Geometry: like deepCopy() the new Geometry has its own arrays and DrawCall[s]
+     * but they share the local storage and the GPU buffers with the original ones until either copy modifies them,
+     * at which point only the modified array is duplicated, see ArrayAbstract::cowClone().
+     * @sa deepCopy(), shallowCopy() */
+    ref<Geometry> cowCopy() const;
+
+    /**
+     * Performs a copy-on-write copy of the specified Geometry.
+     * @sa cowCopy() */
+    Geometry& cowCopyFrom(const Geometry&);
+
     //! Returns the list of DrawCall objects bound to a Geometry
     Collection<DrawCall>& drawCalls() { return mDrawCalls; }
 
@@ -216,6 +229,40 @@ namespace vl
     //! Where 'map_new_to_old[i] == j' means that the i-th new vertex attribute should take it's value from the old j-th vertex attribute.
     void regenerateVertices(const std::vector<u32>& map_new_to_old);
 
+    //! Packs all the vertex attributes into a single interleaved BufferObject, one vertex after the other, with each
+    //! attribute 4-byte aligned. Each array keeps its own local storage, which remains the one to be edited, and is sourced by
+    //! the OpenGL from the interleaved buffer through ArrayAbstract::setInterleavedView(). The interleaved buffer is
+    //! automatically rebuilt by updateDirtyBufferObject() whenever one of the arrays is marked dirty.
+    //! \returns false if the geometry has no vertex attributes or if the arrays do not have all the same number of elements.
+    bool interleave();
+
+    //! Reverts the effect of interleave() sourcing again each array from its own BufferObject.
+    void deinterleave();
+
+    //! Returns true if interleave() has been called and the vertex attributes are sourced from interleavedBufferObject().
+    bool isInterleaved() const { return mInterleavedBufferObject.get() != NULL; }
+
+    //! The interleaved BufferObject created by interleave(), NULL if the Geometry is not interleaved.
+    const BufferObject* interleavedBufferObject() const { return mInterleavedBufferObject.get(); }
+
+    //! Compresses the vertex attributes to reduce memory footprint and vertex fetch bandwidth:
+    //! - the position array is converted to an ArrayShort3 whose values are relative to the center of the bounding box
+    //!   and uniformly scaled to fit the [-32767, 32767] range,
+    //! - the normal array is converted according to \p normals, see ENormalQuantization,
+    //! - the ArrayFloat2 texture coordinate arrays are converted to ArrayHFloat2.
+    //! Only float and double arrays are converted, the others are left untouched.
+    //! \returns The matrix that transforms the quantized positions back to their original values, which can be
+    //! concatenated to the Actor's Transform or applied in the vertex shader. The identity matrix is returned if
+    //! the positions are not quantized.
+    //! \note Since the scaling is uniform the decode matrix can be directly used to transform the normals as well.
+    //! \note NQ_Octahedral normals are not compatible with the fixed function pipeline and can be decoded in GLSL with:
+    //! <pre>
+    //! vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    //! if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+    //! n = normalize(n);
+    //! </pre>
+    mat4 quantize(bool positions=true, ENormalQuantization normals=NQ_Byte3, bool texcoords=true);
+
     //! Assigns a random color to each vertex of each DrawCall object. If a vertex is shared among more than one DrawCall object its color is undefined.
     void colorizePrimitives();
 
@@ -285,6 +332,15 @@ namespace vl
 
     ArrayAbstract* vertexAttribArray(int attrib_location);
 
+    /** The TriangleBVH of the triangles of this Geometry, used by the RayIntersector to accelerate the intersection tests on large meshes.
+      * The BVH is built the first time it is requested and rebuilt when the vertex array is replaced or flagged with
+      * ArrayAbstract::setBufferObjectDirty() or when a DrawCall is added, removed or replaced.
+      * \note Call invalidateTriangleBVH() after modifying the index buffers of the draw calls. */
+    const TriangleBVH* triangleBVH() const;
+
+    //! Discards the triangleBVH() so that it is rebuilt the next time it is requested.
+    void invalidateTriangleBVH() { mTriangleBVH = NULL; }
+
   protected:
     virtual void computeBounds_Implementation();
 
@@ -295,6 +351,12 @@ namespace vl
 
     // vertex attributes
     ref<ArrayAbstract> mVertexAttribArrays[VA_MaxAttribCount];
+
+    // interleaved vertex attributes, see interleave()
+    ref<BufferObject> mInterleavedBufferObject;
+
+    // picking acceleration, see triangleBVH()
+    mutable ref<TriangleBVH> mTriangleBVH;
   };
   //------------------------------------------------------------------------------
 }
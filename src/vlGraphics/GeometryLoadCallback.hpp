@@ -34,6 +34,7 @@
 
 #include <vlGraphics/Geometry.hpp>
 #include <vlGraphics/TriangleStripGenerator.hpp>
+#include <vlGraphics/VertexCacheOptimizer.hpp>
 #include <vlGraphics/DoubleVertexRemover.hpp>
 #include <vlCore/LoadWriterManager.hpp>
 
@@ -57,6 +58,7 @@ namespace vl
       mDiscardOriginalNormals = false;
       mRemoveDoubles          = false;
       mSortVertices           = false;
+      mOptimizeVertexCache    = false;
       mStripfy                = false;
       mConvertToDrawArrays    = false;
     }
@@ -77,11 +79,18 @@ namespace vl
           geom[i]->computeNormals();
 
         if (removeDoubles())
-          DoubleVertexRemover().removeDoubles(geom[i].get());
+        {
+          DoubleVertexRemover dvr;
+          dvr.setUseHashing(true);
+          dvr.removeDoubles(geom[i].get());
+        }
 
         if (sortVertices())
           geom[i]->sortVertices();
 
+        if (optimizeVertexCache())
+          VertexCacheOptimizer().optimize(geom[i].get());
+
         if (stripfy())
           TriangleStripGenerator().stripfy(geom[i].get(), 22, true, false, true);
 
@@ -119,6 +128,11 @@ namespace vl
     //! Sorts the mesh's vertices for better performances
     bool sortVertices() const { return mSortVertices; }
 
+    //! Reorders triangles and vertices for post-transform vertex cache and vertex fetch locality, see VertexCacheOptimizer.
+    void setOptimizeVertexCache(bool on) { mOptimizeVertexCache = on; }
+    //! Reorders triangles and vertices for post-transform vertex cache and vertex fetch locality, see VertexCacheOptimizer.
+    bool optimizeVertexCache() const { return mOptimizeVertexCache; }
+
     //! Convert mesh into a set of triangle strips if possible
     void setStripfy(bool on) { mStripfy = on; }
     //! Convert mesh into a set of triangle strips if possible
@@ -159,6 +173,7 @@ namespace vl
     bool mComputeNormals;
     bool mRemoveDoubles;
     bool mSortVertices;
+    bool mOptimizeVertexCache;
     bool mStripfy;
     bool mConvertToDrawArrays;
     bool mUseDisplayLists;
@@ -47,6 +47,7 @@ GhostCameraManipulator::GhostCameraManipulator()
   mYDegrees = 0;
   mLastTime = 0;
   mPosition = vec3(0,0,0);
+  mMoving = false;
 
   setKeysForward(Key_W);
   setKeysBackward(Key_S);
@@ -56,6 +57,12 @@ GhostCameraManipulator::GhostCameraManipulator()
   setKeysDown(Key_S, Key_Shift);
 }
 //-----------------------------------------------------------------------------
+GhostCameraManipulator::~GhostCameraManipulator()
+{
+  if (mMoving)
+    DirtyTracker::removeContinuousSource();
+}
+//-----------------------------------------------------------------------------
 void GhostCameraManipulator::mouseMoveEvent(int x, int y)
 {
   if ( camera() == NULL )
@@ -67,6 +74,7 @@ void GhostCameraManipulator::mouseMoveEvent(int x, int y)
   int cy = openglContext()->framebuffer()->height() - camera()->viewport()->height()/2 - camera()->viewport()->y();
   mXDegrees -= (y - cy) * mRotationSpeed;
   mYDegrees -= (x - cx) * mRotationSpeed;
+  DirtyTracker::markDirty();
   openglContext()->ignoreNextMouseMoveEvent();
   openglContext()->setMousePosition(cx, cy);
 }
@@ -122,6 +130,15 @@ void GhostCameraManipulator::updateEvent()
   dir -= camera()->modelingMatrix().getZ() * direction.z();
   dir.normalize();
   mPosition += dir * (real)(dt * mMovementSpeed);
+
+  // keeps redrawing while a movement key is pressed, see OpenGLContext::setUpdateOnDemand()
+  bool moving = !direction.isNull();
+  if (moving && !mMoving)
+    DirtyTracker::addContinuousSource();
+  else
+  if (!moving && mMoving)
+    DirtyTracker::removeContinuousSource();
+  mMoving = moving;
 }
 //-----------------------------------------------------------------------------
 void GhostCameraManipulator::setCamera(Camera* camera) { mCamera = camera; }
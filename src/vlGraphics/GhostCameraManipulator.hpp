@@ -60,6 +60,9 @@ namespace vl
     /** Constructor. */
     GhostCameraManipulator();
 
+    /** Destructor. */
+    ~GhostCameraManipulator();
+
     // ---  UIEventListener ---
 
     virtual void mouseMoveEvent(int x, int y);
@@ -82,7 +85,7 @@ namespace vl
 
     virtual void mouseWheelEvent(int) {}
 
-    virtual void keyPressEvent(unsigned short, EKey) {}
+    virtual void keyPressEvent(unsigned short, EKey) { DirtyTracker::markDirty(); }
 
     virtual void keyReleaseEvent(unsigned short, EKey) {}
 
@@ -154,6 +157,7 @@ namespace vl
     real mMovementSpeed;
     real mXDegrees;
     real mYDegrees;
+    bool mMoving;
     EKey mKeysForward[2];
     EKey mKeysBackward[2];
     EKey mKeysUp[2];
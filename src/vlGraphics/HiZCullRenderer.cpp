@@ -0,0 +1,342 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/HiZCullRenderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+HiZCullRenderer::HiZCullRenderer()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+
+  mStatsTotalObjects = 0;
+  mStatsOccludedObjects = 0;
+
+  mCulledRenderQueue = new RenderQueue;
+  mDepthBuffer = new BufferObject;
+  mReadbackWidth = 0;
+  mReadbackHeight = 0;
+#if defined(VL_OPENGL)
+  mReadbackFence = NULL;
+#endif
+}
+//-----------------------------------------------------------------------------
+HiZCullRenderer::~HiZCullRenderer()
+{
+  releaseBufferObjects();
+}
+//-----------------------------------------------------------------------------
+const Framebuffer* HiZCullRenderer::framebuffer() const
+{
+  if (mWrappedRenderer)
+    return mWrappedRenderer->framebuffer();
+  else
+    return NULL;
+}
+//-----------------------------------------------------------------------------
+Framebuffer* HiZCullRenderer::framebuffer()
+{
+  if (mWrappedRenderer)
+    return mWrappedRenderer->framebuffer();
+  else
+    return NULL;
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* HiZCullRenderer::render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock)
+{
+  // skip if renderer is disabled
+  if (enableMask() == 0)
+    return in_render_queue;
+
+  // enter/exit behavior contract
+
+  class InOutContract 
+  {
+    RendererAbstract* mRenderer;
+
+  public:
+    InOutContract(RendererAbstract* renderer): mRenderer(renderer)
+    {
+      // increment the render tick.
+      mRenderer->incrementRenderTick();
+
+      // dispatch the renderer-started event.
+      mRenderer->dispatchOnRendererStarted();
+
+      // check user-generated errors.
+      VL_CHECK_OGL()
+    }
+
+    ~InOutContract()
+    {
+      // dispatch the renderer-finished event
+      mRenderer->dispatchOnRendererFinished();
+
+      // check user-generated errors.
+      VL_CHECK_OGL()
+    }
+  } contract(this);
+
+  // --------------- rendering --------------- 
+
+  if (!mWrappedRenderer)
+  {
+    Log::error("HiZCullRenderer::render(): no Renderer is wrapped!\n");
+    VL_TRAP();
+    return in_render_queue;
+  }
+
+  // (1)
+  // build the depth pyramid from a previous frame, if available.
+  updatePyramid();
+
+  // (2)
+  // cull the occludees against the depth pyramid.
+  mStatsOccludedObjects = 0;
+  mStatsTotalObjects    = in_render_queue->size();
+  mCulledRenderQueue->clear();
+  vec3 eye = camera->modelingMatrix().getT();
+  for( int i=0; i<in_render_queue->size(); ++i)
+  {
+    const Actor* actor = in_render_queue->at(i)->mActor;
+
+    if ( ! mWrappedRenderer->isEnabled(actor) )
+      continue;
+
+    if ( actor->isOccludee() && !actor->boundingBox().isInside(eye) && isOccluded(actor->boundingBox()) )
+    {
+      mStatsOccludedObjects++;
+      continue;
+    }
+
+    RenderToken* tok = mCulledRenderQueue->newToken(false);
+    *tok = *in_render_queue->at(i);
+  }
+
+  // (3)
+  // render only non occluded objects.
+  mWrappedRenderer->render( mCulledRenderQueue.get(), camera, frame_clock );
+
+  // (4)
+  // capture the depth buffer to be used the next frames.
+  readbackDepth( camera );
+
+  // return only the visible, non occluded, objects.
+  return mCulledRenderQueue.get();
+}
+//-----------------------------------------------------------------------------
+bool HiZCullRenderer::isOccluded(const AABB& aabb) const
+{
+  if ( mPyramid.empty() || aabb.isNull() )
+    return false;
+
+  const vec3& a = aabb.minCorner();
+  const vec3& b = aabb.maxCorner();
+  const vec3 corners[] = 
+  {
+    vec3(a.x(), a.y(), a.z()), vec3(b.x(), a.y(), a.z()), vec3(b.x(), b.y(), a.z()), vec3(a.x(), b.y(), a.z()),
+    vec3(a.x(), a.y(), b.z()), vec3(b.x(), a.y(), b.z()), vec3(b.x(), b.y(), b.z()), vec3(a.x(), b.y(), b.z())
+  };
+
+  // compute the window space rectangle and the nearest depth of the box
+  const int width  = mPyramidWidth[0];
+  const int height = mPyramidHeight[0];
+  real x0 = (real)width, y0 = (real)height, x1 = 0, y1 = 0, min_z = 1;
+  for(int i=0; i<8; ++i)
+  {
+    vec4 p = mPyramidViewProj * vec4(corners[i], 1);
+    // the box crosses the near plane
+    if ( p.w() <= 0 )
+      return false;
+    real inv_w = 1 / p.w();
+    real x = ( p.x() * inv_w * (real)0.5 + (real)0.5 ) * width;
+    real y = ( p.y() * inv_w * (real)0.5 + (real)0.5 ) * height;
+    real z =   p.z() * inv_w * (real)0.5 + (real)0.5;
+    x0 = vl::min(x0, x);
+    y0 = vl::min(y0, y);
+    x1 = vl::max(x1, x);
+    y1 = vl::max(y1, y);
+    min_z = vl::min(min_z, z);
+  }
+
+  if ( min_z <= 0 )
+    return false;
+
+  // outside the captured viewport: we have no information
+  if ( x1 < 0 || y1 < 0 || x0 >= width || y0 >= height )
+    return false;
+
+  int ix0 = vl::clamp( (int)x0, 0, width  - 1 );
+  int iy0 = vl::clamp( (int)y0, 0, height - 1 );
+  int ix1 = vl::clamp( (int)x1, 0, width  - 1 );
+  int iy1 = vl::clamp( (int)y1, 0, height - 1 );
+
+  // select the level where the rectangle covers at most 2x2 texels
+  int level = 0;
+  while( level+1 < (int)mPyramid.size() && ( (ix1 >> level) - (ix0 >> level) > 1 || (iy1 >> level) - (iy0 >> level) > 1 ) )
+    ++level;
+
+  const std::vector<float>& depth = mPyramid[level];
+  const int level_width  = mPyramidWidth[level];
+  const int level_height = mPyramidHeight[level];
+  float max_depth = 0;
+  for(int y = iy0 >> level; y <= vl::min(iy1 >> level, level_height-1); ++y)
+    for(int x = ix0 >> level; x <= vl::min(ix1 >> level, level_width-1); ++x)
+      max_depth = vl::max( max_depth, depth[ y*level_width + x ] );
+
+  return min_z > max_depth;
+}
+//-----------------------------------------------------------------------------
+void HiZCullRenderer::updatePyramid()
+{
+#if defined(VL_OPENGL)
+  if ( !mReadbackFence )
+    return;
+
+  // never wait for the GPU: try again the next frame.
+  GLenum status = glClientWaitSync( mReadbackFence, 0, 0 ); VL_CHECK_OGL();
+  if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+    return;
+
+  glDeleteSync( mReadbackFence ); VL_CHECK_OGL();
+  mReadbackFence = NULL;
+
+  const float* data = (const float*)mDepthBuffer->mapBufferObject(BA_READ_ONLY);
+  if (!data)
+  {
+    Log::error("HiZCullRenderer::updatePyramid(): could not map the depth readback buffer.\n");
+    invalidate();
+    return;
+  }
+
+  // level 0
+  mPyramid.resize(1);
+  mPyramidWidth.resize(1);
+  mPyramidHeight.resize(1);
+  mPyramid[0].assign( data, data + mReadbackWidth * mReadbackHeight );
+  mPyramidWidth[0]  = mReadbackWidth;
+  mPyramidHeight[0] = mReadbackHeight;
+  mPyramidViewProj  = mReadbackViewProj;
+
+  mDepthBuffer->unmapBufferObject();
+
+  // max-reduce down to 1x1, odd borders are folded in the last texel
+  while( mPyramidWidth.back() > 1 || mPyramidHeight.back() > 1 )
+  {
+    const int src_w = mPyramidWidth.back();
+    const int src_h = mPyramidHeight.back();
+    const int dst_w = vl::max(1, src_w / 2);
+    const int dst_h = vl::max(1, src_h / 2);
+    mPyramid.push_back( std::vector<float>( dst_w * dst_h ) );
+    mPyramidWidth.push_back( dst_w );
+    mPyramidHeight.push_back( dst_h );
+    const std::vector<float>& src = mPyramid[mPyramid.size()-2];
+    std::vector<float>& dst = mPyramid.back();
+    for(int y=0; y<dst_h; ++y)
+    {
+      const int sy0 = y * 2;
+      const int sy1 = y == dst_h-1 ? src_h-1 : sy0+1;
+      for(int x=0; x<dst_w; ++x)
+      {
+        const int sx0 = x * 2;
+        const int sx1 = x == dst_w-1 ? src_w-1 : sx0+1;
+        float m = 0;
+        for(int sy=sy0; sy<=sy1; ++sy)
+          for(int sx=sx0; sx<=sx1; ++sx)
+            m = vl::max( m, src[ sy*src_w + sx ] );
+        dst[ y*dst_w + x ] = m;
+      }
+    }
+  }
+#endif
+}
+//-----------------------------------------------------------------------------
+void HiZCullRenderer::readbackDepth(const Camera* camera)
+{
+#if defined(VL_OPENGL)
+  // wait for the previous readback to be consumed.
+  if ( mReadbackFence )
+    return;
+
+  if ( !Has_PBO || !glFenceSync || !glClientWaitSync || !glDeleteSync )
+    return;
+
+  const Viewport* viewport = camera->viewport();
+  const int w = viewport->width();
+  const int h = viewport->height();
+  if ( w <= 0 || h <= 0 )
+    return;
+
+  GLsizeiptr bytes = w * h * sizeof(float);
+  if ( mDepthBuffer->byteCountBufferObject() != bytes )
+    mDepthBuffer->setBufferData( bytes, NULL, BU_STREAM_READ );
+
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, mDepthBuffer->handle() ); VL_CHECK_OGL();
+  glReadPixels( viewport->x(), viewport->y(), w, h, GL_DEPTH_COMPONENT, GL_FLOAT, 0 ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 ); VL_CHECK_OGL();
+  mReadbackFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ); VL_CHECK_OGL();
+
+  mReadbackWidth  = w;
+  mReadbackHeight = h;
+  mReadbackViewProj = camera->projectionMatrix() * camera->viewMatrix();
+#else
+  (void)camera;
+#endif
+}
+//-----------------------------------------------------------------------------
+void HiZCullRenderer::invalidate()
+{
+#if defined(VL_OPENGL)
+  if ( mReadbackFence )
+  {
+    glDeleteSync( mReadbackFence ); VL_CHECK_OGL();
+    mReadbackFence = NULL;
+  }
+#endif
+  mPyramid.clear();
+  mPyramidWidth.clear();
+  mPyramidHeight.clear();
+}
+//-----------------------------------------------------------------------------
+void HiZCullRenderer::releaseBufferObjects()
+{
+  invalidate();
+  mDepthBuffer->deleteBufferObject();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,135 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef HiZCullRenderer_INCLUDE_ONCE
+#define HiZCullRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <vector>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // HiZCullRenderer
+  //------------------------------------------------------------------------------
+  /** Wraps a Renderer performing occlusion culling against a hierarchical depth buffer (Hi-Z) built from the depth of the previous frame.
+    *
+    * After each frame the depth buffer of the camera's viewport is asynchronously read back into a pixel buffer object.
+    * As soon as the transfer has completed, which is checked with a fence without ever blocking, a max-depth mipmap pyramid
+    * is built from it. The world space bounding box of each occludee Actor is then projected using the view-projection
+    * matrix of the frame the depth was captured from and tested against the smallest pyramid level covering it with at most
+    * 2x2 texels: the Actor is culled if its nearest point is farther than the farthest depth stored in those texels.
+    *
+    * Unlike OcclusionCullRenderer no per-Actor query nor GPU/CPU synchronization is required, which makes this renderer
+    * suitable for scenes with a very large number of Actors. Since the occlusion information is one or more frames late,
+    * objects can pop in with one frame delay when the camera or the occluders move fast.
+    *
+    * \note Requires OpenGL 3.2 or ARB_sync and pixel buffer objects. If not available no culling is performed.
+    * \sa OcclusionCullRenderer */
+  class VLGRAPHICS_EXPORT HiZCullRenderer: public Renderer
+  {
+    VL_INSTRUMENT_CLASS(vl::HiZCullRenderer, Renderer)
+
+  public:
+    /** Constructor. */
+    HiZCullRenderer();
+
+    /** Destructor. */
+    ~HiZCullRenderer();
+
+    /** Renders using the wrapped renderer but also performing Hi-Z occlusion culling. */
+    virtual const RenderQueue* render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
+
+    /** The renderer to be wrapped by this occlusion culling renderer */
+    void setWrappedRenderer(Renderer* renderer) { mWrappedRenderer = renderer; }
+
+    /** The renderer to be wrapped by this occlusion culling renderer */
+    const Renderer* wrappedRenderer() const { return mWrappedRenderer.get(); }
+
+    /** The renderer to be wrapped by this occlusion culling renderer */
+    Renderer* wrappedRenderer() { return mWrappedRenderer.get(); }
+
+    /** Returns the wrapped Renderer's Framebuffer */
+    const Framebuffer* framebuffer() const;
+
+    /** Returns the wrapped Renderer's Framebuffer */
+    Framebuffer* framebuffer();
+
+    /** Returns the total number or objects candidate for rendering before occlusion culling. */
+    int statsTotalObjects() const { return mStatsTotalObjects; }
+
+    /** Returns the number or objects not rendered due to the occlusion culling. */
+    int statsOccludedObjects() const { return mStatsOccludedObjects; }
+
+    /** Tests the given world space bounding box against the current depth pyramid.
+      * Returns false if no depth pyramid is available or if the box might be visible. */
+    bool isOccluded(const AABB& aabb) const;
+
+    /** Discards the current depth pyramid and any pending depth readback, for example after a camera cut. */
+    void invalidate();
+
+    /** Releases the pixel buffer object used for the depth readback. Must be called with the OpenGL context current. */
+    void releaseBufferObjects();
+
+  protected:
+    /** Builds the depth pyramid if the depth readback issued during a previous frame has completed. */
+    void updatePyramid();
+
+    /** Starts the asynchronous readback of the depth buffer of the given camera's viewport. */
+    void readbackDepth(const Camera* camera);
+
+  protected:
+    ref<Renderer> mWrappedRenderer;
+    ref<RenderQueue> mCulledRenderQueue;
+    int mStatsTotalObjects;
+    int mStatsOccludedObjects;
+
+  private:
+    // depth readback in flight
+    ref<BufferObject> mDepthBuffer;
+    mat4 mReadbackViewProj;
+    int mReadbackWidth;
+    int mReadbackHeight;
+#if defined(VL_OPENGL)
+    GLsync mReadbackFence;
+#endif
+    // max-depth pyramid, level 0 is the full resolution depth
+    std::vector< std::vector<float> > mPyramid;
+    std::vector<int> mPyramidWidth;
+    std::vector<int> mPyramidHeight;
+    mat4 mPyramidViewProj;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
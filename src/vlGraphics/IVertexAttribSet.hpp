@@ -41,9 +41,21 @@ namespace vl
   // IVertexAttribSet
   //------------------------------------------------------------------------------
   /** Abstract interface to manipulate OpenGL's vertex attribute arrays. */
-  class IVertexAttribSet
+  class VLGRAPHICS_EXPORT IVertexAttribSet
   {
   public:
+    IVertexAttribSet();
+
+    //! The copy gets its own vertexAttribSetUID().
+    IVertexAttribSet(const IVertexAttribSet&);
+
+    //! Keeps the vertexAttribSetUID() of this object.
+    IVertexAttribSet& operator=(const IVertexAttribSet&) { return *this; }
+
+    /** Identifies this object for its whole lifetime, unlike its address which can be reused by a new object once it is destroyed.
+      * Used by the Vertex Array Object cache of OpenGLContext, see OpenGLContext::setVAOEnabled(). */
+    long long vertexAttribSetUID() const { return mVertexAttribSetUID; }
+
     /** Conventional vertex array. */
     virtual void setVertexArray(ArrayAbstract* data) = 0;
     /** Conventional vertex array. */
@@ -92,6 +104,9 @@ namespace vl
     virtual const ArrayAbstract* vertexAttribArray(int attrib_location) const = 0;
     /** Returns a generic vertex attribute's info. */
     virtual ArrayAbstract* vertexAttribArray(int attrib_location) = 0;
+
+  private:
+    long long mVertexAttribSetUID;
   };
 }
 
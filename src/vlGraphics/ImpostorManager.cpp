@@ -0,0 +1,430 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/ImpostorManager.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// ImpostorManager::NodeSceneManager
+//-----------------------------------------------------------------------------
+//! Exposes a single node of the tree to the capture Rendering.
+class ImpostorManager::NodeSceneManager: public SceneManager
+{
+public:
+  NodeSceneManager(): mNode(NULL) {}
+
+  void setNode(ActorTreeAbstract* node) { mNode = node; }
+
+  virtual void extractActors(ActorCollection& list)
+  {
+    if ( mNode )
+      mNode->extractActors(list);
+  }
+
+  virtual void extractVisibleActors(ActorCollection& list, const Camera* camera)
+  {
+    if ( mNode )
+      mNode->extractVisibleActors(list, camera, enableMask());
+  }
+
+protected:
+  ActorTreeAbstract* mNode;
+};
+//-----------------------------------------------------------------------------
+namespace
+{
+  int countActors(const ActorTreeAbstract* node)
+  {
+    int count = node->actors()->size();
+    for( int i = 0; i < node->childrenCount(); ++i ) {
+      if ( node->child(i) ) {
+        count += countActors( node->child(i) );
+      }
+    }
+    return count;
+  }
+
+  // the impostor plane passes through the center of the node and faces the capture direction
+  void impostorBasis(const vec3& dir, vec3& right, vec3& up)
+  {
+    up = fabs(dir.y()) < 0.99 ? vec3(0,1,0) : vec3(1,0,0);
+    right = cross(up, dir).normalize();
+    up = cross(dir, right).normalize();
+  }
+}
+//-----------------------------------------------------------------------------
+// ImpostorManager
+//-----------------------------------------------------------------------------
+ImpostorManager::ImpostorManager()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mOpenGLContext = NULL;
+  mCamera = NULL;
+  mPixelsPerUnit = 0;
+  mPerspective = true;
+  mPixelThreshold = 96;
+  mAngleThreshold = 8;
+  mMinActors = 16;
+  mMaxCapturesPerFrame = 4;
+  mTileSize = 128;
+  mAtlasSize = 2048;
+  mFrame = 1;
+  mStatsImpostors = 0;
+  mStatsReplacedActors = 0;
+  mStatsCaptures = 0;
+
+  mAtlas = new Texture;
+
+  // unlit, alpha tested, shared by all the impostors
+  mImpostorEffect = new Effect;
+  mImpostorEffect->shader()->enable(EN_DEPTH_TEST);
+  mImpostorEffect->shader()->enable(EN_ALPHA_TEST);
+  mImpostorEffect->shader()->gocAlphaFunc()->set(FU_GEQUAL, 0.5f);
+  mImpostorEffect->shader()->gocTextureSampler(0)->setTexture( mAtlas.get() );
+
+  mNodeSceneManager = new NodeSceneManager;
+  mCaptureRendering = new Rendering;
+  mCaptureRendering->sceneManagers()->push_back( mNodeSceneManager.get() );
+  mCaptureRendering->camera()->viewport()->setClearColor( fvec4(0,0,0,0) );
+  mCaptureRendering->camera()->viewport()->setClearFlags( CF_CLEAR_COLOR_DEPTH );
+  mCaptureRendering->camera()->viewport()->setScissorEnabled( true );
+}
+//-----------------------------------------------------------------------------
+ImpostorManager::~ImpostorManager()
+{
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::setTileSize(int size)
+{
+  mTileSize = size < 8 ? 8 : size;
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::setAtlasSize(int size)
+{
+  mAtlasSize = size < 8 ? 8 : size;
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+int ImpostorManager::impostorCount() const
+{
+  int count = 0;
+  for( size_t i = 0; i < mTileOwners.size(); ++i ) {
+    if ( mTileOwners[i] ) {
+      ++count;
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::invalidate()
+{
+  for( std::map<const ActorTreeAbstract*, Impostor>::iterator it = mImpostors.begin(); it != mImpostors.end(); ++it ) {
+    it->second.mValid = false;
+  }
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::clear()
+{
+  mImpostors.clear();
+  mRequests.clear();
+  std::fill( mTileOwners.begin(), mTileOwners.end(), (const ActorTreeAbstract*)NULL );
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::releaseOpenGLResources()
+{
+  mAtlas->destroyTexture();
+  mFBO = NULL;
+  mTileOwners.clear();
+  for( std::map<const ActorTreeAbstract*, Impostor>::iterator it = mImpostors.begin(); it != mImpostors.end(); ++it ) {
+    it->second.mTile = -1;
+  }
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::extractVisibleActors(ActorTreeAbstract* tree, ActorCollection& list, const Camera* camera, unsigned enable_mask)
+{
+  mStatsImpostors = 0;
+  mStatsReplacedActors = 0;
+
+  if ( !camera || ( mCamera && mCamera != camera ) || !isEnabled() )
+  {
+    tree->extractVisibleActors(list, camera, enable_mask);
+    return;
+  }
+
+  mEye = camera->modelingMatrix().getT();
+  mPixelsPerUnit = camera->projectionMatrix().e(1,1) * camera->viewport()->height() * 0.5f;
+  mPerspective = camera->projectionMatrixType() != PMT_OrthographicProjection;
+
+  extractNode(tree, list, camera, enable_mask, true);
+}
+//-----------------------------------------------------------------------------
+void ImpostorManager::extractNode(ActorTreeAbstract* node, ActorCollection& list, const Camera* camera, unsigned enable_mask, bool request)
+{
+  if ( ! node->isEnabled() || camera->frustum().cull( node->aabb() ) ) {
+    return;
+  }
+
+  // replace the node with its impostor if it is small enough on screen
+  const AABB& aabb = node->aabb();
+  if ( ! aabb.isNull() )
+  {
+    vec3 center = aabb.center();
+    real radius = ( aabb.maxCorner() - aabb.minCorner() ).length() * 0.5f;
+    vec3 to_eye = mEye - center;
+    real distance = to_eye.length();
+    real pixels = 2 * radius * mPixelsPerUnit;
+    if ( mPerspective )
+      pixels = distance > 0 ? pixels / distance : 0;
+
+    if ( distance > radius && pixels <= mPixelThreshold )
+    {
+      Impostor& imp = mImpostors[node];
+      if ( imp.mActorCount < 0 ) {
+        imp.mActorCount = countActors(node);
+      }
+
+      if ( imp.mActorCount >= mMinActors )
+      {
+        vec3 dir = to_eye / distance;
+        bool stale = imp.mTile < 0 || ! imp.mValid || dot(dir, imp.mDirection) < cos( mAngleThreshold * dDEG_TO_RAD );
+        if ( stale && request && imp.mRequestFrame != mFrame )
+        {
+          Request req;
+          req.mNode = node;
+          req.mDirection = dir;
+          req.mPixels = (float)pixels;
+          req.mEnableMask = enable_mask;
+          req.mRefresh = imp.mTile >= 0;
+          mRequests.push_back(req);
+          imp.mRequestFrame = mFrame;
+        }
+
+        // a stale impostor is still used until it is captured again
+        if ( imp.mTile >= 0 )
+        {
+          imp.mLastUsedFrame = mFrame;
+          list.push_back( imp.mActor.get() );
+          ++mStatsImpostors;
+          mStatsReplacedActors += imp.mActorCount;
+          return;
+        }
+
+        // the nested nodes are not captured while this one waits for its impostor
+        request = false;
+      }
+    }
+  }
+
+  // regular extraction
+  for( int i = 0; i < node->actors()->size(); ++i )
+  {
+    Actor* actor = node->actors()->at(i);
+    if ( actor->isEnabled() && ( enable_mask & actor->enableMask() ) )
+    {
+      actor->computeBounds();
+      if ( ! camera->frustum().cull( actor->boundingBox() ) ) {
+        list.push_back(actor);
+      }
+    }
+  }
+
+  for( int i = 0; i < node->childrenCount(); ++i ) {
+    if ( node->child(i) ) {
+      extractNode( node->child(i), list, camera, enable_mask, request );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool ImpostorManager::onRenderingFinished(const RenderingAbstract* rendering)
+{
+  mStatsCaptures = 0;
+
+  const Rendering* rend = rendering->as<Rendering>();
+  if ( !mRequests.empty() && rend && !rend->renderers().empty() && rend->renderers()[0]->framebuffer() )
+  {
+    Framebuffer* framebuffer = const_cast<Framebuffer*>( rend->renderers()[0]->framebuffer() );
+    if ( prepareResources( framebuffer->openglContext() ) )
+    {
+      std::sort( mRequests.begin(), mRequests.end() );
+      for( size_t i = 0; i < mRequests.size() && mStatsCaptures < mMaxCapturesPerFrame; ++i )
+      {
+        if ( capture( mRequests[i], rend->frameClock() ) )
+          ++mStatsCaptures;
+      }
+      // restore the framebuffer of the Rendering for the next callbacks
+      if ( mStatsCaptures )
+        framebuffer->activate();
+    }
+  }
+
+  // the requests not served will be issued again if the nodes are still visible
+  mRequests.clear();
+  ++mFrame;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool ImpostorManager::prepareResources(OpenGLContext* gl_context)
+{
+  if ( !Has_FBO )
+    return false;
+
+  if ( mOpenGLContext != gl_context )
+  {
+    releaseOpenGLResources();
+    mOpenGLContext = gl_context;
+  }
+
+  if ( !mAtlas->handle() )
+  {
+    if ( !mAtlas->createTexture2D( mAtlasSize, mAtlasSize, TF_RGBA8 ) )
+    {
+      Log::error("ImpostorManager: could not create the impostor atlas!\n");
+      return false;
+    }
+    mAtlas->getTexParameter()->setMinFilter(TPF_LINEAR);
+    mAtlas->getTexParameter()->setMagFilter(TPF_LINEAR);
+    mAtlas->getTexParameter()->setWrapS(TPW_CLAMP_TO_EDGE);
+    mAtlas->getTexParameter()->setWrapT(TPW_CLAMP_TO_EDGE);
+
+    mFBO = gl_context->createFramebufferObject( mAtlasSize, mAtlasSize, RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT0 );
+    mFBO->addTextureAttachment( AP_COLOR_ATTACHMENT0, new FBOTexture2DAttachment( mAtlas.get(), 0, T2DT_TEXTURE_2D ) );
+    mFBO->addDepthAttachment( new FBODepthBufferAttachment( DBF_DEPTH_COMPONENT24 ) );
+    mCaptureRendering->renderer()->setFramebuffer( mFBO.get() );
+
+    int tiles = mAtlasSize / mTileSize;
+    mTileOwners.assign( tiles * tiles, (const ActorTreeAbstract*)NULL );
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+int ImpostorManager::allocateTile()
+{
+  // a free tile or else the least recently used one, not rendered during the last two frames
+  int lru = -1;
+  unsigned long lru_frame = mFrame - 1;
+  for( int i = 0; i < (int)mTileOwners.size(); ++i )
+  {
+    if ( !mTileOwners[i] )
+      return i;
+    unsigned long used = mImpostors[ mTileOwners[i] ].mLastUsedFrame;
+    if ( used < lru_frame )
+    {
+      lru = i;
+      lru_frame = used;
+    }
+  }
+
+  if ( lru >= 0 )
+    mImpostors[ mTileOwners[lru] ].mTile = -1;
+  return lru;
+}
+//-----------------------------------------------------------------------------
+bool ImpostorManager::capture(const Request& request, real frame_clock)
+{
+  Impostor& imp = mImpostors[request.mNode];
+  if ( imp.mTile < 0 )
+  {
+    imp.mTile = allocateTile();
+    if ( imp.mTile < 0 )
+      return false;
+    mTileOwners[imp.mTile] = request.mNode;
+  }
+
+  const AABB& aabb = request.mNode->aabb();
+  vec3 center = aabb.center();
+  real radius = ( aabb.maxCorner() - aabb.minCorner() ).length() * 0.5f;
+  vec3 right, up;
+  impostorBasis( request.mDirection, right, up );
+
+  // orthographic view of the bounding sphere along the direction the node is seen from
+  const int tiles_per_row = mAtlasSize / mTileSize;
+  const int x = ( imp.mTile % tiles_per_row ) * mTileSize;
+  const int y = ( imp.mTile / tiles_per_row ) * mTileSize;
+  Camera* camera = mCaptureRendering->camera();
+  camera->viewport()->set( x, y, mTileSize, mTileSize );
+  camera->setViewMatrix( mat4::getLookAt( center + request.mDirection * radius * 2, center, up ) );
+  camera->setProjectionMatrix( mat4::getOrtho( -radius, radius, -radius, radius, radius, radius * 3 ), PMT_OrthographicProjection );
+
+  mNodeSceneManager->setNode( request.mNode );
+  mNodeSceneManager->setEnableMask( request.mEnableMask );
+  mCaptureRendering->setFrameClock( frame_clock );
+  mCaptureRendering->render();
+  mNodeSceneManager->setNode( NULL );
+
+  // the quad textured with the tile, inset by half a texel
+  if ( !imp.mActor )
+  {
+    imp.mGeometry = new Geometry;
+    ref<ArrayFloat3> verts = new ArrayFloat3;
+    ref<ArrayFloat2> texcoords = new ArrayFloat2;
+    verts->resize(4);
+    texcoords->resize(4);
+    imp.mGeometry->setVertexArray( verts.get() );
+    imp.mGeometry->setTexCoordArray( 0, texcoords.get() );
+    imp.mGeometry->drawCalls().push_back( new DrawArrays( PT_TRIANGLE_STRIP, 0, 4 ) );
+    imp.mActor = new Actor( imp.mGeometry.get(), mImpostorEffect.get(), NULL );
+    imp.mActor->setObjectName("Impostor");
+  }
+
+  ArrayFloat3* verts = imp.mGeometry->vertexArray()->as<ArrayFloat3>();
+  ArrayFloat2* texcoords = imp.mGeometry->texCoordArray(0)->as<ArrayFloat2>();
+  const float half_texel = 0.5f / mAtlasSize;
+  const float s0 = (float)x / mAtlasSize + half_texel;
+  const float t0 = (float)y / mAtlasSize + half_texel;
+  const float s1 = (float)(x + mTileSize) / mAtlasSize - half_texel;
+  const float t1 = (float)(y + mTileSize) / mAtlasSize - half_texel;
+  verts->at(0) = (fvec3)( center - right * radius - up * radius ); texcoords->at(0) = fvec2(s0, t0);
+  verts->at(1) = (fvec3)( center + right * radius - up * radius ); texcoords->at(1) = fvec2(s1, t0);
+  verts->at(2) = (fvec3)( center - right * radius + up * radius ); texcoords->at(2) = fvec2(s0, t1);
+  verts->at(3) = (fvec3)( center + right * radius + up * radius ); texcoords->at(3) = fvec2(s1, t1);
+  verts->setBufferObjectDirty();
+  texcoords->setBufferObjectDirty();
+  imp.mGeometry->setBufferObjectDirty();
+  imp.mGeometry->setBoundsDirty(true);
+
+  imp.mDirection = request.mDirection;
+  imp.mValid = true;
+  return true;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,212 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef ImpostorManager_INCLUDE_ONCE
+#define ImpostorManager_INCLUDE_ONCE
+
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <vlGraphics/ActorTreeAbstract.hpp>
+#include <vlGraphics/link_config.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  class Rendering;
+  class Camera;
+  class Geometry;
+  class Effect;
+  class Texture;
+  class FramebufferObject;
+  class OpenGLContext;
+  //-----------------------------------------------------------------------------
+  // ImpostorManager
+  //-----------------------------------------------------------------------------
+  /**
+   * Replaces the distant nodes of an ActorKdTree with cached impostors, capping the number of Actor[s] drawn for arbitrarily large scenes.
+   *
+   * During SceneManagerActorKdTree::extractVisibleActors() each visible node whose bounding sphere covers at most pixelThreshold() pixels
+   * and which contains at least minActors() Actor[s] is replaced by a single textured quad facing the camera, and its subtree is skipped.
+   * The quad shows the node rendered from the direction it was seen from when the impostor was captured, and is refreshed when the view
+   * direction changes by more than angleThreshold() degrees. The impostors are stored as tiles of a single texture atlas,
+   * the least recently used ones are recycled when the atlas is full.
+   *
+   * The nodes needing a new or refreshed impostor are captured by onRenderingFinished(), at most maxCapturesPerFrame() per frame,
+   * the nodes without an impostor keep being rendered normally until then. Nodes nested in a node waiting for its impostor are not captured.
+   *
+   * \code
+   * ref<ImpostorManager> impostors = new ImpostorManager;
+   * scene_manager->setImpostorManager( impostors.get() );
+   * rendering->onFinishedCallbacks()->push_back( impostors.get() );
+   * \endcode
+   *
+   * \remarks
+   * - The impostors are captured with the lighting of the Actor[s] Effect[s] and rendered unlit with alpha testing, using the fixed function pipeline.
+   * - The nodes are referenced by address: call clear() after rebuilding or modifying the tree and invalidate() after changing the appearance of its Actor[s].
+   * - Use setCamera() to prevent other passes extracting from the same scene manager, like CascadedShadowMap, from seeing the impostors.
+   *
+   * \sa SceneManagerActorKdTree, ActorKdTree
+   */
+  class VLGRAPHICS_EXPORT ImpostorManager: public RenderEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::ImpostorManager, RenderEventCallback)
+
+  public:
+    ImpostorManager();
+    virtual ~ImpostorManager();
+
+    virtual bool onRenderingStarted(const RenderingAbstract*) { return true; }
+    virtual bool onRenderingFinished(const RenderingAbstract* rendering);
+    virtual bool onRendererStarted(const RendererAbstract*) { return true; }
+    virtual bool onRendererFinished(const RendererAbstract*) { return true; }
+
+    /** Appends to \p list the visible Actor[s] of \p tree replacing the distant nodes with their impostors and records the impostors to be captured.
+      * Called by SceneManagerActorKdTree::extractVisibleActors(). */
+    void extractVisibleActors(ActorTreeAbstract* tree, ActorCollection& list, const Camera* camera, unsigned enable_mask);
+
+    //! Nodes whose bounding sphere covers at most this many pixels are replaced by an impostor (default = 96).
+    void setPixelThreshold(float pixels) { mPixelThreshold = pixels; }
+    float pixelThreshold() const { return mPixelThreshold; }
+
+    //! Nodes containing less than this number of Actor[s], children included, are never replaced (default = 16).
+    void setMinActors(int count) { mMinActors = count; }
+    int minActors() const { return mMinActors; }
+
+    //! An impostor is refreshed when the direction it is seen from differs by more than this angle in degrees from the captured one (default = 8).
+    void setAngleThreshold(float degrees) { mAngleThreshold = degrees; }
+    float angleThreshold() const { return mAngleThreshold; }
+
+    //! The maximum number of impostors captured by each onRenderingFinished() (default = 4).
+    void setMaxCapturesPerFrame(int count) { mMaxCapturesPerFrame = count; }
+    int maxCapturesPerFrame() const { return mMaxCapturesPerFrame; }
+
+    //! Width and height in pixels of each impostor (default = 128). Releases the atlas.
+    void setTileSize(int size);
+    int tileSize() const { return mTileSize; }
+
+    //! Width and height in pixels of the texture atlas (default = 2048). Releases the atlas.
+    void setAtlasSize(int size);
+    int atlasSize() const { return mAtlasSize; }
+
+    //! If not NULL only the extractions for this camera use the impostors (default = NULL).
+    void setCamera(const Camera* camera) { mCamera = camera; }
+    const Camera* camera() const { return mCamera; }
+
+    //! The texture atlas containing the impostors, its OpenGL texture is created by the first capture.
+    Texture* atlas() { return mAtlas.get(); }
+
+    //! The Effect used to render the impostors.
+    Effect* impostorEffect() { return mImpostorEffect.get(); }
+
+    //! Number of nodes currently having an impostor.
+    int impostorCount() const;
+
+    //! Forces the recapture of all the impostors, for example after the Actor[s] of the tree have changed appearance.
+    void invalidate();
+
+    //! Forgets all the nodes and impostors, to be called after the tree has been rebuilt or modified.
+    void clear();
+
+    //! Releases the atlas and its framebuffer object, the impostors will be captured again.
+    void releaseOpenGLResources();
+
+    //! Number of impostors rendered in place of their nodes during the last extractVisibleActors().
+    int statsImpostors() const { return mStatsImpostors; }
+    //! Number of Actor[s] replaced by impostors during the last extractVisibleActors().
+    int statsReplacedActors() const { return mStatsReplacedActors; }
+    //! Number of impostors captured by the last onRenderingFinished().
+    int statsCaptures() const { return mStatsCaptures; }
+
+  protected:
+    struct Impostor
+    {
+      Impostor(): mTile(-1), mActorCount(-1), mLastUsedFrame(0), mRequestFrame(0), mValid(false) {}
+      ref<Actor> mActor;
+      ref<Geometry> mGeometry;
+      vec3 mDirection;
+      int mTile;
+      int mActorCount;
+      unsigned long mLastUsedFrame;
+      unsigned long mRequestFrame;
+      bool mValid;
+    };
+
+    struct Request
+    {
+      ActorTreeAbstract* mNode;
+      vec3 mDirection;
+      float mPixels;
+      unsigned mEnableMask;
+      bool mRefresh;
+      bool operator<(const Request& other) const
+      {
+        // new impostors first, then the biggest ones
+        if ( mRefresh != other.mRefresh )
+          return !mRefresh;
+        return mPixels > other.mPixels;
+      }
+    };
+
+    class NodeSceneManager;
+
+    void extractNode(ActorTreeAbstract* node, ActorCollection& list, const Camera* camera, unsigned enable_mask, bool request);
+    bool prepareResources(OpenGLContext* gl_context);
+    int allocateTile();
+    bool capture(const Request& request, real frame_clock);
+
+  protected:
+    std::map<const ActorTreeAbstract*, Impostor> mImpostors;
+    std::vector<const ActorTreeAbstract*> mTileOwners;
+    std::vector<Request> mRequests;
+    ref<Texture> mAtlas;
+    ref<FramebufferObject> mFBO;
+    ref<Effect> mImpostorEffect;
+    ref<Rendering> mCaptureRendering;
+    ref<NodeSceneManager> mNodeSceneManager;
+    OpenGLContext* mOpenGLContext;
+    const Camera* mCamera;
+    vec3 mEye;
+    real mPixelsPerUnit;
+    bool mPerspective;
+    float mPixelThreshold;
+    float mAngleThreshold;
+    int mMinActors;
+    int mMaxCapturesPerFrame;
+    int mTileSize;
+    int mAtlasSize;
+    unsigned long mFrame;
+    int mStatsImpostors;
+    int mStatsReplacedActors;
+    int mStatsCaptures;
+  };
+}
+
+#endif
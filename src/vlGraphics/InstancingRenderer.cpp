@@ -0,0 +1,218 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/InstancingRenderer.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/StringInterner.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// InstancingRenderer::InstancedGeometry
+//-----------------------------------------------------------------------------
+void InstancingRenderer::InstancedGeometry::set(Geometry* geom, int instances)
+{
+  mGeometry = geom;
+  mInstances = instances;
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+void InstancingRenderer::InstancedGeometry::computeBounds_Implementation()
+{
+  if (!mGeometry)
+    return;
+  setBoundingBox( mGeometry->boundingBox() );
+  setBoundingSphere( mGeometry->boundingSphere() );
+}
+//-----------------------------------------------------------------------------
+void InstancingRenderer::InstancedGeometry::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
+{
+  Collection<DrawCall>& dcs = mGeometry->drawCalls();
+
+  // temporarily set the number of instances of the draw calls
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = dcs.at(i)->as<DrawElementsBase>())
+      de->setInstances(mInstances);
+    else
+    if (DrawArrays* da = dcs.at(i)->as<DrawArrays>())
+      da->setInstances(mInstances);
+  }
+
+  mGeometry->render(actor, shader, camera, gl_context);
+
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = dcs.at(i)->as<DrawElementsBase>())
+      de->setInstances(1);
+    else
+    if (DrawArrays* da = dcs.at(i)->as<DrawArrays>())
+      da->setInstances(1);
+  }
+}
+//-----------------------------------------------------------------------------
+// InstancingRenderer
+//-----------------------------------------------------------------------------
+InstancingRenderer::InstancingRenderer(): mInstancedDrawCount(0), mMaxInstances(64), mMinInstances(2), mStatsInstancedObjects(0), mStatsInstancedDraws(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mInstancedRenderQueue = new RenderQueue;
+  mInstanceWorldMatrixID = StringInterner::intern("vl_InstanceWorldMatrix");
+}
+//-----------------------------------------------------------------------------
+InstancingRenderer::InstancedDraw& InstancingRenderer::nextInstancedDraw()
+{
+  if ( mInstancedDrawCount == (int)mInstancedDraws.size() )
+  {
+    InstancedDraw draw;
+    draw.mRenderable = new InstancedGeometry;
+    draw.mActor = new Actor( draw.mRenderable.get() );
+    draw.mWorldMatrices = draw.mActor->gocUniform("vl_InstanceWorldMatrix");
+    mInstancedDraws.push_back(draw);
+  }
+  return mInstancedDraws[mInstancedDrawCount++];
+}
+//-----------------------------------------------------------------------------
+bool InstancingRenderer::isInstanceable(const RenderToken* tok)
+{
+  if ( tok->mNextPass || tok->mShader->isBlendingEnabled() )
+    return false;
+
+  const GLSLProgram* glsl = tok->mShader->glslProgram();
+  if ( !glsl || !glsl->handle() || !glsl->linked() )
+    return false;
+
+  // the location is cached by the program until it is relinked
+  if ( glsl->getUniformLocation( mInstanceWorldMatrixID ) == -1 )
+    return false;
+
+  const Actor* actor = tok->mActor;
+  if ( !isEnabled(actor) || actor->scissor() || !actor->actorEventCallbacks()->empty() ||
+       ( actor->getUniformSet() && !actor->getUniformSet()->empty() ) )
+    return false;
+
+  for( std::map< unsigned int, ref<Shader> >::const_iterator eom_it = mShaderOverrideMask.begin(); eom_it != mShaderOverrideMask.end(); ++eom_it )
+  {
+    if ( eom_it->first & actor->enableMask() )
+      return false;
+  }
+
+  const Geometry* geom = tok->mRenderable->as<Geometry>();
+  if ( !geom || geom->isDisplayListEnabled() || geom->drawCalls().empty() )
+    return false;
+
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    const DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->instances() != 1 || !( dc->as<DrawElementsBase>() || dc->as<DrawArrays>() ) )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void InstancingRenderer::addInstancedDraw(const RenderQueue* in_render_queue, int first, int count)
+{
+  const RenderToken* tok = in_render_queue->at(first);
+
+  mMatrices.resize(count);
+  for(int j=0; j<count; ++j)
+  {
+    const Transform* tr = in_render_queue->at(first + j)->mActor->transform();
+    mMatrices[j] = tr ? (fmat4)tr->worldMatrix() : fmat4();
+  }
+
+  InstancedDraw& draw = nextInstancedDraw();
+  draw.mWorldMatrices->setUniform( count, &mMatrices[0] );
+  draw.mRenderable->set( static_cast<Geometry*>(tok->mRenderable), count );
+  draw.mActor->setEffect( tok->mActor->effect() );
+  draw.mActor->setEnableMask( tok->mActor->enableMask() );
+  draw.mActor->setRenderBlock( tok->mActor->renderBlock() );
+  draw.mActor->setRenderRank( tok->mActor->renderRank() );
+
+  RenderToken* out_tok = mInstancedRenderQueue->newToken(false);
+  *out_tok = *tok;
+  out_tok->mActor = draw.mActor.get();
+  out_tok->mRenderable = draw.mRenderable.get();
+
+  mStatsInstancedObjects += count;
+  ++mStatsInstancedDraws;
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* InstancingRenderer::render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock)
+{
+  mStatsInstancedObjects = 0;
+  mStatsInstancedDraws = 0;
+  mInstancedDrawCount = 0;
+  mInstancedRenderQueue->clear();
+
+  for(int i=0; i<in_render_queue->size(); )
+  {
+    const RenderToken* tok = in_render_queue->at(i);
+
+    // count the consecutive instanceable tokens sharing the same Geometry and Shader
+    int count = 0;
+    while( count < mMaxInstances && i + count < in_render_queue->size() )
+    {
+      const RenderToken* tok_j = in_render_queue->at(i + count);
+      if ( tok_j->mShader != tok->mShader || tok_j->mRenderable != tok->mRenderable || !isInstanceable(tok_j) )
+        break;
+      ++count;
+    }
+
+    if ( count > 0 )
+    {
+      // the shader reads its world matrix from vl_InstanceWorldMatrix: the runs too short to be batched are drawn as single instances
+      const int instances = count >= mMinInstances ? count : 1;
+      for(int j=0; j<count; j+=instances)
+        addInstancedDraw( in_render_queue, i + j, instances );
+      i += count;
+      continue;
+    }
+
+    // pass over the token as it is
+    RenderToken* out_tok = mInstancedRenderQueue->newToken(false);
+    *out_tok = *tok;
+    ++i;
+  }
+
+  Renderer::render( mInstancedRenderQueue.get(), camera, frame_clock );
+
+  // release the references to the instanced Geometry[s]
+  for(int i=0; i<mInstancedDrawCount; ++i)
+    mInstancedDraws[i].mRenderable->set(NULL, 1);
+
+  return in_render_queue;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,144 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef InstancingRenderer_INCLUDE_ONCE
+#define InstancingRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Geometry.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // InstancingRenderer
+  //------------------------------------------------------------------------------
+  /** A Renderer that automatically draws consecutive RenderToken[s] sharing the same Geometry and Shader
+    * as a single instanced draw call.
+    *
+    * Only the Shader[s] whose GLSLProgram declares the uniform array \p vl_InstanceWorldMatrix are considered.
+    * The world matrices of the instances are sent in \p vl_InstanceWorldMatrix while the instanced draw is rendered
+    * with no Transform, that is, \p vl_ModelViewMatrix contains the view matrix only. A typical vertex shader looks like:
+    * \code
+    * uniform mat4 vl_InstanceWorldMatrix[64]; // must be at least maxInstances() long
+    * ...
+    * gl_Position = vl_ProjectionMatrix * vl_ModelViewMatrix * vl_InstanceWorldMatrix[gl_InstanceID] * vl_VertexPosition;
+    * \endcode
+    *
+    * A RenderToken is instanced only if it is a single pass token, its Shader does not enable blending, its Geometry
+    * has no display list and only non-instanced DrawElements or DrawArrays draw calls, and its Actor has no Scissor,
+    * no ActorEventCallback, no Actor uniforms and is not subject to the shaderOverrideMask(). The instanceable RenderToken[s]
+    * that cannot be batched, such as the runs shorter than minInstances(), are drawn as single instances so that
+    * \p vl_InstanceWorldMatrix is always set. The other RenderToken[s] are rendered as they are: if their GLSLProgram declares
+    * \p vl_InstanceWorldMatrix their Actor must provide it, for example as an Actor uniform set to the identity matrix.
+    * \sa Renderer, DrawElementsBase::setInstances(), DrawArrays::setInstances() */
+  class VLGRAPHICS_EXPORT InstancingRenderer: public Renderer
+  {
+    VL_INSTRUMENT_CLASS(vl::InstancingRenderer, Renderer)
+
+  public:
+    InstancingRenderer();
+
+    /** Renders \p in_render_queue drawing the compatible RenderToken[s] with instancing. Returns \p in_render_queue. */
+    virtual const RenderQueue* render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
+
+    /** Maximum number of instances per draw call, must not exceed the size of \p vl_InstanceWorldMatrix (default = 64). */
+    void setMaxInstances(int count) { mMaxInstances = count; }
+
+    /** Maximum number of instances per draw call, must not exceed the size of \p vl_InstanceWorldMatrix (default = 64). */
+    int maxInstances() const { return mMaxInstances; }
+
+    /** Minimum number of consecutive compatible tokens drawn with a single instanced draw (default = 2),
+      * shorter runs are drawn one instance per draw call. */
+    void setMinInstances(int count) { mMinInstances = count; }
+
+    /** Minimum number of consecutive compatible tokens drawn with a single instanced draw (default = 2),
+      * shorter runs are drawn one instance per draw call. */
+    int minInstances() const { return mMinInstances; }
+
+    /** Number of RenderToken[s] rendered with instancing during the last rendering. */
+    int statsInstancedObjects() const { return mStatsInstancedObjects; }
+
+    /** Number of instanced draws issued during the last rendering. */
+    int statsInstancedDraws() const { return mStatsInstancedDraws; }
+
+  protected:
+    /** Returns true if the given RenderToken can be drawn as an instance. */
+    bool isInstanceable(const RenderToken* tok);
+
+    //! Renders a Geometry with a given number of instances.
+    class InstancedGeometry: public Renderable
+    {
+    public:
+      InstancedGeometry(): mGeometry(NULL), mInstances(1) {}
+
+      void set(Geometry* geom, int instances);
+
+    protected:
+      virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+      virtual void deleteBufferObject() {}
+      virtual void computeBounds_Implementation();
+      virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+
+    protected:
+      Geometry* mGeometry;
+      int mInstances;
+    };
+
+    //! The Actor, UniformSet and Renderable used to render one instanced draw, pooled across frames.
+    struct InstancedDraw
+    {
+      ref<Actor> mActor;
+      ref<Uniform> mWorldMatrices;
+      ref<InstancedGeometry> mRenderable;
+    };
+
+    InstancedDraw& nextInstancedDraw();
+
+    //! Adds to the output queue an instanced draw of the \p count tokens starting at \p first.
+    void addInstancedDraw(const RenderQueue* in_render_queue, int first, int count);
+
+  protected:
+    ref<RenderQueue> mInstancedRenderQueue;
+    std::vector<InstancedDraw> mInstancedDraws;
+    int mInstancedDrawCount;
+    std::vector<fmat4> mMatrices;
+    int mInstanceWorldMatrixID;
+    int mMaxInstances;
+    int mMinInstances;
+    int mStatsInstancedObjects;
+    int mStatsInstancedDraws;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,230 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/MeshletBuilder.hpp>
+#include <vlCore/Log.hpp>
+#include <cmath>
+#include <cstring>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// MeshletSet
+//-----------------------------------------------------------------------------
+int MeshletSet::setVisibleMeshlets(const std::vector<bool>& visible)
+{
+  VL_CHECK( visible.size() == mMeshlets.size() )
+
+  if ( visible == mVisible )
+    return mVisibleCount;
+  mVisible = visible;
+
+  // compact the indices of the visible meshlets
+  size_t index_count = 0;
+  mVisibleCount = 0;
+  for(size_t i=0; i<mMeshlets.size(); ++i)
+  {
+    if ( visible[i] )
+    {
+      index_count += mMeshlets[i].mIndexCount;
+      ++mVisibleCount;
+    }
+  }
+
+  ArrayUInt1* index_buffer = mDrawCall->indexBuffer();
+  index_buffer->resize( index_count );
+  GLuint* ptr = index_buffer->begin();
+  for(size_t i=0; i<mMeshlets.size(); ++i)
+  {
+    if ( visible[i] && mMeshlets[i].mIndexCount )
+    {
+      memcpy( ptr, &mIndices[ mMeshlets[i].mFirstIndex ], mMeshlets[i].mIndexCount * sizeof(GLuint) );
+      ptr += mMeshlets[i].mIndexCount;
+    }
+  }
+
+  // the index buffer changes frequently
+  if ( Has_BufferObject && index_buffer->bufferObject()->handle() && index_buffer->bufferObject()->usage() != BU_DYNAMIC_DRAW )
+  {
+    index_buffer->bufferObject()->setBufferData(BU_DYNAMIC_DRAW);
+    index_buffer->setBufferObjectDirty(false);
+  }
+  else
+    index_buffer->setBufferObjectDirty(true);
+
+  mDrawCall->setEnabled( index_count != 0 );
+
+  return mVisibleCount;
+}
+//-----------------------------------------------------------------------------
+// MeshletBuilder
+//-----------------------------------------------------------------------------
+void MeshletBuilder::computeBounds(Meshlet& meshlet, const ArrayAbstract* posarr, const GLuint* indices) const
+{
+  // bounding sphere centered in the bounding box of the vertices
+  AABB aabb;
+  for(u32 i=0; i<meshlet.mIndexCount; ++i)
+    aabb.addPoint( posarr->getAsVec3(indices[i]) );
+  vec3 center = aabb.center();
+  real radius2 = 0;
+  for(u32 i=0; i<meshlet.mIndexCount; ++i)
+  {
+    real d2 = (posarr->getAsVec3(indices[i]) - center).lengthSquared();
+    radius2 = d2 > radius2 ? d2 : radius2;
+  }
+  meshlet.mCenter = (fvec3)center;
+  meshlet.mRadius = (float)::sqrt(radius2);
+
+  // normal cone: average normal and the minimum dot product between it and the triangle normals
+  std::vector<vec3> normals;
+  vec3 axis;
+  for(u32 i=0; i<meshlet.mIndexCount; i+=3)
+  {
+    vec3 a = posarr->getAsVec3(indices[i+0]);
+    vec3 b = posarr->getAsVec3(indices[i+1]);
+    vec3 c = posarr->getAsVec3(indices[i+2]);
+    vec3 n = cross(b - a, c - a);
+    if ( n.lengthSquared() == 0 )
+      continue;
+    n.normalize();
+    normals.push_back( n );
+    axis += n;
+  }
+
+  meshlet.mConeAxis = fvec3(0, 0, 0);
+  meshlet.mConeCutoff = 1;
+  if ( normals.empty() || axis.lengthSquared() == 0 )
+    return;
+  axis.normalize();
+  real min_dp = 1;
+  for(size_t i=0; i<normals.size(); ++i)
+  {
+    real dp = dot(normals[i], axis);
+    min_dp = dp < min_dp ? dp : min_dp;
+  }
+  meshlet.mConeAxis = (fvec3)axis;
+  // cones wider than ~85 degrees are almost never culled
+  if ( min_dp > (real)0.1 )
+    meshlet.mConeCutoff = (float)::sqrt(1 - min_dp * min_dp);
+}
+//-----------------------------------------------------------------------------
+ref<MeshletSet> MeshletBuilder::build(Geometry* geom)
+{
+  const ArrayAbstract* posarr = geom->vertexArray();
+  if ( !posarr || posarr->size() == 0 )
+    return NULL;
+
+  // collect and remove the triangle draw calls
+
+  std::vector<GLuint> triangles;
+  for(int i=geom->drawCalls().size(); i--; )
+  {
+    DrawCall* dc = geom->drawCalls().at(i);
+    switch(dc->primitiveType())
+    {
+    case PT_TRIANGLES:
+    case PT_TRIANGLE_STRIP:
+    case PT_TRIANGLE_FAN:
+    case PT_QUADS:
+    case PT_QUAD_STRIP:
+    case PT_POLYGON:
+      break;
+    default:
+      continue;
+    }
+    if ( !dc->isEnabled() || dc->instances() != 1 )
+      continue;
+
+    std::vector<GLuint> dc_triangles;
+    for(TriangleIterator it = dc->triangleIterator(); it.hasNext(); it.next())
+    {
+      dc_triangles.push_back( it.a() );
+      dc_triangles.push_back( it.b() );
+      dc_triangles.push_back( it.c() );
+    }
+    // preserve the rendering order
+    triangles.insert( triangles.begin(), dc_triangles.begin(), dc_triangles.end() );
+    geom->drawCalls().eraseAt(i);
+  }
+
+  if ( triangles.empty() )
+    return NULL;
+
+  // greedily fill the meshlets in triangle order
+
+  ref<MeshletSet> set = new MeshletSet;
+  std::vector<int> vertex_meshlet( posarr->size(), -1 );
+  Meshlet meshlet;
+  meshlet.mFirstIndex = 0;
+  meshlet.mIndexCount = 0;
+  int vertex_count = 0;
+  for(size_t i=0; i<triangles.size(); i+=3)
+  {
+    const int id = (int)set->meshlets().size();
+    int new_vertices = 0;
+    for(int j=0; j<3; ++j)
+      new_vertices += vertex_meshlet[ triangles[i+j] ] != id ? 1 : 0;
+
+    if ( vertex_count + new_vertices > mMaxVertices || (int)meshlet.mIndexCount / 3 + 1 > mMaxTriangles )
+    {
+      computeBounds( meshlet, posarr, &triangles[meshlet.mFirstIndex] );
+      set->meshlets().push_back( meshlet );
+      meshlet.mFirstIndex = (u32)i;
+      meshlet.mIndexCount = 0;
+      vertex_count = 0;
+    }
+
+    const int cur = (int)set->meshlets().size();
+    for(int j=0; j<3; ++j)
+    {
+      if ( vertex_meshlet[ triangles[i+j] ] != cur )
+      {
+        vertex_meshlet[ triangles[i+j] ] = cur;
+        ++vertex_count;
+      }
+    }
+    meshlet.mIndexCount += 3;
+  }
+  computeBounds( meshlet, posarr, &triangles[meshlet.mFirstIndex] );
+  set->meshlets().push_back( meshlet );
+
+  // initially all the meshlets are visible
+
+  set->indices().swap( triangles );
+  set->setVisibleMeshlets( std::vector<bool>(set->meshlets().size(), true) );
+  geom->drawCalls().push_back( set->drawCall() );
+
+  Log::debug( Say("MeshletBuilder: %n triangles split into %n meshlets.\n") << set->indices().size() / 3 << set->meshlets().size() );
+
+  return set;
+}
+//-----------------------------------------------------------------------------
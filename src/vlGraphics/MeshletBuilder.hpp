@@ -0,0 +1,144 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef MeshletBuilder_INCLUDE_ONCE
+#define MeshletBuilder_INCLUDE_ONCE
+
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vector>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // Meshlet
+  //------------------------------------------------------------------------------
+  //! A small cluster of triangles stored contiguously in the indices of a MeshletSet, with its object space bounds.
+  struct Meshlet
+  {
+    //! Center of the bounding sphere.
+    fvec3 mCenter;
+    //! Radius of the bounding sphere.
+    float mRadius;
+    //! Average normal of the triangles.
+    fvec3 mConeAxis;
+    //! Sine of the maximum angle between the cone axis and the triangle normals, 1 if the meshlet cannot be backface culled.
+    float mConeCutoff;
+    //! First index of the meshlet in MeshletSet::indices().
+    u32 mFirstIndex;
+    //! Number of indices of the meshlet, i.e. 3 times the number of triangles.
+    u32 mIndexCount;
+  };
+  //------------------------------------------------------------------------------
+  // MeshletSet
+  //------------------------------------------------------------------------------
+  //! The meshlets of a Geometry along with the DrawElementsUInt used to render them, see MeshletBuilder.
+  //! The index buffer of the draw call contains the compacted indices of the visible meshlets only.
+  class VLGRAPHICS_EXPORT MeshletSet: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::MeshletSet, Object)
+
+  public:
+    MeshletSet(): mVisibleCount(0) { mDrawCall = new DrawElementsUInt(PT_TRIANGLES); }
+
+    //! The meshlets, in the order they are laid out in indices().
+    std::vector<Meshlet>& meshlets() { return mMeshlets; }
+
+    //! The meshlets, in the order they are laid out in indices().
+    const std::vector<Meshlet>& meshlets() const { return mMeshlets; }
+
+    //! The triangle indices of all the meshlets.
+    std::vector<GLuint>& indices() { return mIndices; }
+
+    //! The triangle indices of all the meshlets.
+    const std::vector<GLuint>& indices() const { return mIndices; }
+
+    //! The draw call rendering the visible meshlets, by default all of them.
+    DrawElementsUInt* drawCall() { return mDrawCall.get(); }
+
+    //! The draw call rendering the visible meshlets, by default all of them.
+    const DrawElementsUInt* drawCall() const { return mDrawCall.get(); }
+
+    //! Fills the index buffer of drawCall() with the meshlets whose entry in \p visible is true.
+    //! The index buffer is updated only if the set of visible meshlets changed. Returns the number of visible meshlets.
+    int setVisibleMeshlets(const std::vector<bool>& visible);
+
+  protected:
+    std::vector<Meshlet> mMeshlets;
+    std::vector<GLuint> mIndices;
+    std::vector<bool> mVisible;
+    int mVisibleCount;
+    ref<DrawElementsUInt> mDrawCall;
+  };
+  //------------------------------------------------------------------------------
+  // MeshletBuilder
+  //------------------------------------------------------------------------------
+  /** Splits the triangles of a Geometry into meshlets, small clusters of triangles referencing a bounded number of vertices,
+    * which can be culled individually against the view frustum and by their normal cone, see MeshletCullCallback.
+    *
+    * The triangles are assigned to the meshlets greedily in the order they are specified, so running VertexCacheOptimizer
+    * first produces more compact meshlets. All the triangle draw calls of the Geometry are replaced by the draw call of the
+    * returned MeshletSet, while the other draw calls are left untouched.
+    */
+  class VLGRAPHICS_EXPORT MeshletBuilder: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::MeshletBuilder, Object)
+
+  public:
+    MeshletBuilder(): mMaxVertices(64), mMaxTriangles(124) {}
+
+    //! Builds the meshlets of the given Geometry, returns NULL if it has no triangles.
+    ref<MeshletSet> build(Geometry* geom);
+
+    //! Maximum number of distinct vertices referenced by a meshlet (default = 64).
+    void setMaxVertices(int count) { mMaxVertices = count < 3 ? 3 : count; }
+
+    //! Maximum number of distinct vertices referenced by a meshlet (default = 64).
+    int maxVertices() const { return mMaxVertices; }
+
+    //! Maximum number of triangles of a meshlet (default = 124).
+    void setMaxTriangles(int count) { mMaxTriangles = count < 1 ? 1 : count; }
+
+    //! Maximum number of triangles of a meshlet (default = 124).
+    int maxTriangles() const { return mMaxTriangles; }
+
+  protected:
+    void computeBounds(Meshlet& meshlet, const ArrayAbstract* posarr, const GLuint* indices) const;
+
+  protected:
+    int mMaxVertices;
+    int mMaxTriangles;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,80 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/MeshletCullCallback.hpp>
+#include <cmath>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+void MeshletCullCallback::onActorRenderStarted(Actor* actor, real /*frame_clock*/, const Camera* cam, Renderable* /*renderable*/, const Shader*, int pass)
+{
+  // the culling is done only once per frame
+  if ( pass > 0 || !mMeshletSet )
+    return;
+
+  const std::vector<Meshlet>& meshlets = mMeshletSet->meshlets();
+  mVisible.resize( meshlets.size() );
+
+  mat4 world;
+  if ( actor->transform() )
+    world = actor->transform()->worldMatrix();
+
+  // largest scaling factor of the world matrix, used to transform the bounding spheres
+  real scale = world.getX().length();
+  scale = world.getY().length() > scale ? world.getY().length() : scale;
+  scale = world.getZ().length() > scale ? world.getZ().length() : scale;
+
+  // camera position in object space
+  const vec3 eye = world.getInverse() * cam->modelingMatrix().getT();
+
+  for(size_t i=0; i<meshlets.size(); ++i)
+  {
+    const Meshlet& m = meshlets[i];
+    const vec3 center = (vec3)m.mCenter;
+    bool visible = true;
+
+    if ( mBackfaceCulling && m.mConeCutoff < 1 )
+    {
+      vec3 d = center - eye;
+      visible = dot( d, (vec3)m.mConeAxis ) < m.mConeCutoff * d.length() + m.mRadius;
+    }
+
+    if ( visible && mFrustumCulling )
+      visible = !cam->frustum().cull( Sphere( world * center, m.mRadius * scale ) );
+
+    mVisible[i] = visible;
+  }
+
+  mStatsVisibleMeshlets = mMeshletSet->setVisibleMeshlets( mVisible );
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,101 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef MeshletCullCallback_INCLUDE_ONCE
+#define MeshletCullCallback_INCLUDE_ONCE
+
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/MeshletBuilder.hpp>
+#include <vector>
+
+namespace vl
+{
+  /**
+   * MeshletCullCallback culls the meshlets of a MeshletSet on the CPU before its Actor is rendered.
+   *
+   * Each meshlet is tested against the view frustum using its bounding sphere and, if backface culling is enabled,
+   * against its normal cone: a meshlet is skipped when all its triangles face away from the camera. The indices of the
+   * visible meshlets are compacted into the index buffer of the MeshletSet's draw call, which is uploaded again only
+   * when the set of visible meshlets changes.
+   *
+   * Usage:
+   * \code
+   * ref<MeshletSet> meshlets = MeshletBuilder().build( geometry.get() );
+   * actor->actorEventCallbacks()->push_back( new MeshletCullCallback( meshlets.get() ) );
+   * \endcode
+   *
+   * \remarks
+   * - The normal cone test assumes that the Actor's Transform does not contain a non-uniform scaling.
+   * - The normal cone test must be disabled when the triangles are rendered double sided, see setBackfaceCulling().
+   * - Like DepthSortCallback the culling modifies the draw call shared by all the Actor[s] using the Geometry, so the
+   *   MeshletSet should not be shared by Actor[s] rendered in the same frame with different Camera[s] or Transform[s].
+   */
+  class VLGRAPHICS_EXPORT MeshletCullCallback: public ActorEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::MeshletCullCallback, ActorEventCallback)
+
+  public:
+    MeshletCullCallback(MeshletSet* meshlets = NULL): mMeshletSet(meshlets), mFrustumCulling(true), mBackfaceCulling(true), mStatsVisibleMeshlets(0) {}
+
+    void onActorDelete(Actor*) {}
+
+    //! Culls the meshlets and updates the draw call of the MeshletSet.
+    virtual void onActorRenderStarted(Actor* actor, real frame_clock, const Camera* cam, Renderable* renderable, const Shader*, int pass);
+
+    void setMeshletSet(MeshletSet* meshlets) { mMeshletSet = meshlets; }
+    MeshletSet* meshletSet() { return mMeshletSet.get(); }
+    const MeshletSet* meshletSet() const { return mMeshletSet.get(); }
+
+    //! Enables the culling of the meshlets outside the view frustum (default = true).
+    void setFrustumCulling(bool enable) { mFrustumCulling = enable; }
+    //! Enables the culling of the meshlets outside the view frustum (default = true).
+    bool frustumCulling() const { return mFrustumCulling; }
+
+    //! Enables the culling of the meshlets whose normal cone faces away from the camera (default = true).
+    void setBackfaceCulling(bool enable) { mBackfaceCulling = enable; }
+    //! Enables the culling of the meshlets whose normal cone faces away from the camera (default = true).
+    bool backfaceCulling() const { return mBackfaceCulling; }
+
+    //! Number of meshlets rendered during the last rendering.
+    int statsVisibleMeshlets() const { return mStatsVisibleMeshlets; }
+
+  protected:
+    ref<MeshletSet> mMeshletSet;
+    std::vector<bool> mVisible;
+    bool mFrustumCulling;
+    bool mBackfaceCulling;
+    int mStatsVisibleMeshlets;
+  };
+}
+
+#endif
@@ -43,9 +43,12 @@ MorphingCallback::MorphingCallback()
   VL_DEBUG_SET_OBJECT_NAME()
 
   mGeometry = new Geometry;
+  mAnimationStarted = false;
   setAnimation(0,0,0);
   resetGLSLBindings();
   setGLSLVertexBlendEnabled(false);
+  setTextureBufferVertexBlendEnabled(false);
+  mFramesTexture = new Texture;
 
   mAnim_t = 0.0f;
   mFrame1 = -1;
@@ -55,6 +58,8 @@ MorphingCallback::MorphingCallback()
 //-----------------------------------------------------------------------------
 MorphingCallback::~MorphingCallback()
 {
+  if ( mAnimationStarted )
+    DirtyTracker::removeContinuousSource();
 }
 //-----------------------------------------------------------------------------
 void MorphingCallback::onActorRenderStarted(Actor*, real frame_clock, const Camera*, Renderable*, const Shader* shader, int pass)
@@ -68,7 +73,7 @@ void MorphingCallback::onActorRenderStarted(Actor*, real frame_clock, const Came
 
   mElapsedTime = frame_clock - mAnimationStartTime;
   // 30 fps update using the CPU vertex blending or continuous update if using the GPU
-  bool do_update = mLastUpdate == -1 || (mElapsedTime - mLastUpdate) > 1.0f/30.0f || glslVertexBlendEnabled();
+  bool do_update = mLastUpdate == -1 || (mElapsedTime - mLastUpdate) > 1.0f/30.0f || glslVertexBlendEnabled() || textureBufferVertexBlendEnabled();
   if ( do_update )
   {
     mLastUpdate = mElapsedTime;
@@ -94,6 +99,36 @@ void MorphingCallback::onActorRenderStarted(Actor*, real frame_clock, const Came
 
   // from here you can change uniforms or query uniform binding location
 
+  if ( textureBufferVertexBlendEnabled() && glslprogram )
+  {
+    // all the frames live in the shared texture buffer: the vertex/normal arrays are always the ones of the
+    // first frame (shared by all the instances) so that the lazy vertex array setup has nothing to rebind.
+    if ( ! mFramesTexture->handle() && ! createFramesTexture() )
+      return;
+
+    if ( mGeometry->vertexArray() != mVertexFrames[0].get() )
+      mGeometry->setVertexArray( mVertexFrames[0].get() );
+
+    if ( mGeometry->normalArray() != mNormalFrames[0].get() )
+      mGeometry->setNormalArray( mNormalFrames[0].get() );
+
+    if (mFrame1_Binding == -1)
+      mFrame1_Binding = glslprogram->getUniformLocation("vl_MorphFrame1");
+
+    if (mFrame2_Binding == -1)
+      mFrame2_Binding = glslprogram->getUniformLocation("vl_MorphFrame2");
+
+    if (mAnim_t_Binding  == -1)
+      mAnim_t_Binding = glslprogram->getUniformLocation("anim_t");
+
+    // texel offset of the two frames
+    const int frame_texels = 2 * (int)mVertexFrames[0]->size();
+    glUniform1i(mFrame1_Binding, mFrame1 * frame_texels);
+    glUniform1i(mFrame2_Binding, mFrame2 * frame_texels);
+    // frame interpolation ratio
+    glUniform1fv(mAnim_t_Binding, 1, &mAnim_t);
+  }
+  else
   if ( glslVertexBlendEnabled() && glslprogram )
   {
     // memo:
@@ -268,11 +303,14 @@ void MorphingCallback::setAnimation(int start, int end, float period)
   mAnimationStart   = start;
   mAnimationEnd     = end;
   mAnimationPeriod  = period;
-  mAnimationStarted = false;
+  stopAnimation();
 }
 //-----------------------------------------------------------------------------
 void MorphingCallback::startAnimation(real start_time)
 {
+  // a running animation redraws every frame, see OpenGLContext::setUpdateOnDemand()
+  if ( ! mAnimationStarted )
+    DirtyTracker::addContinuousSource();
   mAnimationStarted = true;
   mFrame1 = -1;
   mFrame2 = -1;
@@ -283,6 +321,8 @@ void MorphingCallback::startAnimation(real start_time)
 //-----------------------------------------------------------------------------
 void MorphingCallback::stopAnimation()
 {
+  if ( mAnimationStarted )
+    DirtyTracker::removeContinuousSource();
   mAnimationStarted = false;
 }
 //-----------------------------------------------------------------------------
@@ -296,6 +336,9 @@ void MorphingCallback::initFrom(MorphingCallback* morph_cb)
   mVertexFrames = morph_cb->mVertexFrames;
   mNormalFrames = morph_cb->mNormalFrames;
 
+  // share the frames texture buffer
+  mFramesTexture = morph_cb->mFramesTexture;
+
   #if 0
     // Geometry sharing method: works only wiht GLSL
 
@@ -324,5 +367,66 @@ void MorphingCallback::resetGLSLBindings()
   mVertex2_Binding = -1;
   mNormal2_Binding = -1;
   mAnim_t_Binding  = -1;
+  mFrame1_Binding  = -1;
+  mFrame2_Binding  = -1;
+}
+//-----------------------------------------------------------------------------
+bool MorphingCallback::createFramesTexture()
+{
+  if (mFramesTexture->handle())
+    return true;
+
+  if (!Has_Texture_Buffer)
+  {
+    Log::error("MorphingCallback::createFramesTexture(): texture buffers not supported.\n");
+    return false;
+  }
+
+  if (mVertexFrames.empty() || mVertexFrames.size() != mNormalFrames.size())
+  {
+    Log::error("MorphingCallback::createFramesTexture(): no valid vertex/normal frames available.\n");
+    return false;
+  }
+
+  const size_t vert_count = mVertexFrames[0]->size();
+  const size_t texel_count = 2 * vert_count * mVertexFrames.size();
+
+  GLint max_texels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels); VL_CHECK_OGL();
+  if ( texel_count > (size_t)max_texels )
+  {
+    Log::error( Say("MorphingCallback::createFramesTexture(): %n texels exceed GL_MAX_TEXTURE_BUFFER_SIZE (%n).\n") << texel_count << max_texels );
+    return false;
+  }
+
+  // pack position and normal of every vertex of every frame
+  ref<ArrayFloat4> frames = new ArrayFloat4;
+  frames->resize( texel_count );
+  for(size_t f=0; f<mVertexFrames.size(); ++f)
+  {
+    if ( mVertexFrames[f]->size() != vert_count || mNormalFrames[f]->size() != vert_count )
+    {
+      Log::error("MorphingCallback::createFramesTexture(): all the frames must have the same vertex count.\n");
+      return false;
+    }
+
+    fvec4* ptr = frames->begin() + 2 * vert_count * f;
+    for(size_t i=0; i<vert_count; ++i, ptr+=2)
+    {
+      ptr[0] = fvec4( mVertexFrames[f]->at(i), 1.0f );
+      ptr[1] = fvec4( mNormalFrames[f]->at(i), 0.0f );
+    }
+  }
+
+  // one upload: the texture keeps a reference to the buffer object, the RAM copy is not needed anymore
+  frames->bufferObject()->setBufferData( BU_STATIC_DRAW, true );
+
+  if ( ! mFramesTexture->createTextureBuffer( TF_RGBA32F, frames->bufferObject() ) )
+  {
+    Log::error("MorphingCallback::createFramesTexture(): texture buffer creation failed.\n");
+    return false;
+  }
+
+  return true;
 }
 //-----------------------------------------------------------------------------
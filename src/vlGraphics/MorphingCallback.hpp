@@ -34,13 +34,35 @@
 
 #include <vlGraphics/Actor.hpp>
 #include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/Texture.hpp>
 
 namespace vl
 {
   class ResourceDatabase;
 
   /** The MorphingCallback class implements a simple morphing animation mechanism using the
-      GPU acceleration where available. */
+      GPU acceleration where available.
+   *
+   * Three blending paths are available:
+   * - CPU blending (default): the current and next frames are blended into private vertex and normal arrays at 30 fps.
+   * - GLSL vertex blending, see setGLSLVertexBlendEnabled(): the current and next frames are bound as vertex attributes
+   *   and blended by the vertex shader (see \p /glsl/vertex_blend.vs). Since every instance is at a different stage of
+   *   the animation the vertex attribute pointers have to be re-specified for every actor.
+   * - Texture buffer vertex blending, see setTextureBufferVertexBlendEnabled(): all the frames are uploaded once in a single
+   *   RGBA32F texture buffer shared by all the MorphingCallbacks initialized with initFrom(). The vertex shader fetches
+   *   the two frames by \p gl_VertexID and the only per-actor state are three uniforms (see \p /glsl/vertex_blend_tbo.vs).
+   *   The vertex and normal arrays bound to the Geometry are always those of the first frame and are the same for every
+   *   instance, thus no buffer rebinding takes place between actors.
+   *
+   * Texture buffer setup example:
+   * \code
+   * morph_cb->setTextureBufferVertexBlendEnabled(true);
+   * shader->gocTextureSampler(0)->setTexture( morph_cb->framesTexture() );
+   * shader->gocUniform("vl_MorphFrames")->setUniformI(0);
+   * shader->gocGLSLProgram()->attachShader( new vl::GLSLVertexShader("/glsl/vertex_blend_tbo.vs") );
+   * \endcode
+   * The texture buffer requires OpenGL 3.1 or GL_ARB_texture_buffer_object and contains <tt>2 * vertex_count * frame_count</tt>
+   * texels, which must not exceed \p GL_MAX_TEXTURE_BUFFER_SIZE. */
   class VLGRAPHICS_EXPORT MorphingCallback: public ActorEventCallback
   {
     VL_INSTRUMENT_CLASS(vl::MorphingCallback, ActorEventCallback)
@@ -83,6 +105,23 @@ namespace vl
     bool glslVertexBlendEnabled() const { return mGLSLVertexBlendEnabled; }
     void setGLSLVertexBlendEnabled(bool enable) { mGLSLVertexBlendEnabled = enable; }
 
+    /** If enabled the frames are blended by the vertex shader fetching them from framesTexture(). Takes precedence over glslVertexBlendEnabled(). */
+    void setTextureBufferVertexBlendEnabled(bool enable) { mTextureBufferVertexBlendEnabled = enable; }
+    /** If enabled the frames are blended by the vertex shader fetching them from framesTexture(). Takes precedence over glslVertexBlendEnabled(). */
+    bool textureBufferVertexBlendEnabled() const { return mTextureBufferVertexBlendEnabled; }
+
+    /** The texture buffer containing all the vertex and normal frames, shared with all the MorphingCallbacks initialized with initFrom().
+     * Texel <tt>2*(frame*vertex_count+i)</tt> contains the position of the vertex \p i and the following texel its normal.
+     * The returned texture can be bound to a TextureSampler right away, its OpenGL texture object is created by createFramesTexture(). */
+    Texture* framesTexture() { return mFramesTexture.get(); }
+    /** The texture buffer containing all the vertex and normal frames, see framesTexture(). */
+    const Texture* framesTexture() const { return mFramesTexture.get(); }
+
+    /** Uploads all the frames in framesTexture(). Called automatically on the first rendering if needed, call it explicitly
+     * after init() to avoid the first frame being rendered without frame data.
+     * \note An OpenGL context must be active when calling this function. */
+    bool createFramesTexture();
+
     Geometry* geometry() { return mGeometry.get(); }
     const Geometry* geometry() const { return mGeometry.get(); }
 
@@ -110,6 +149,11 @@ namespace vl
     int mNormal2_Binding;
     int mAnim_t_Binding;
     float mAnim_t;
+
+    bool mTextureBufferVertexBlendEnabled;
+    ref<Texture> mFramesTexture;
+    int mFrame1_Binding;
+    int mFrame2_Binding;
   };
   //-----------------------------------------------------------------------------
 }
@@ -0,0 +1,345 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/MultiContextRendering.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+#endif
+
+using namespace vl;
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // MultiContextMutex
+  //------------------------------------------------------------------------------
+  // The mutex serializing the resource initialization of the render threads, see Rendering::setResourceMutex().
+  class MultiContextMutex: public IMutex
+  {
+  public:
+    virtual ~MultiContextMutex() {}
+    virtual void lock() { mMutex.lock(); }
+    virtual void unlock() { mMutex.unlock(); }
+    virtual int isLocked() const { return -1; }
+
+  protected:
+    std::mutex mMutex;
+  };
+
+  //------------------------------------------------------------------------------
+  // MultiContextWorker
+  //------------------------------------------------------------------------------
+  // The render thread of one of the contexts of a MultiContextRendering.
+  class MultiContextWorker
+  {
+  public:
+    typedef enum { Job_None, Job_Render, Job_Present } EJob;
+
+    MultiContextWorker(MultiContextRendering* rendering, int index): mRendering(rendering), mIndex(index), mJob(Job_None), mQuit(false)
+    {
+      mThread = std::thread(&MultiContextWorker::run, this);
+    }
+
+    ~MultiContextWorker()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+      }
+      mWake.notify_one();
+      mThread.join();
+    }
+
+    //! Starts the given job.
+    void start(EJob job)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = job;
+      }
+      mWake.notify_one();
+    }
+
+    //! Waits until the job has been completed.
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while( mJob != Job_None )
+        mDone.wait(lock);
+    }
+
+  protected:
+    void run()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      for(;;)
+      {
+        while( mJob == Job_None && !mQuit )
+          mWake.wait(lock);
+        if ( mJob == Job_None )
+          return;
+
+        EJob job = mJob;
+        lock.unlock();
+        if ( job == Job_Render )
+          mRendering->renderContext(mIndex, true);
+        else
+          mRendering->presentContext(mIndex, true);
+        lock.lock();
+
+        mJob = Job_None;
+        mDone.notify_all();
+      }
+    }
+
+  protected:
+    MultiContextRendering* mRendering;
+    int mIndex;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    EJob mJob;
+    bool mQuit;
+  };
+}
+#endif
+
+//------------------------------------------------------------------------------
+MultiContextRendering::MultiContextRendering(): mResourceMutex(NULL), mSwapBuffers(true), mSwapBarrier(true)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mRenderings = new Collection<Rendering>;
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  mResourceMutex = new MultiContextMutex;
+#endif
+}
+//------------------------------------------------------------------------------
+MultiContextRendering::~MultiContextRendering()
+{
+  stopThreads();
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  delete static_cast<MultiContextMutex*>(mResourceMutex);
+#endif
+}
+//------------------------------------------------------------------------------
+void MultiContextRendering::stopThreads()
+{
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  for(size_t i=0; i<mWorkers.size(); ++i)
+    delete mWorkers[i];
+#endif
+  mWorkers.clear();
+}
+//------------------------------------------------------------------------------
+void MultiContextRendering::setupContexts()
+{
+  mContexts.clear();
+  for(size_t i=0; i<mContextRenderings.size(); ++i)
+    mContextRenderings[i].clear();
+
+  for(int i=0; i<renderings()->size(); ++i)
+  {
+    Rendering* rendering = renderings()->at(i);
+    if ( !rendering || rendering->enableMask() == 0 )
+      continue;
+
+    OpenGLContext* context = NULL;
+    if ( !rendering->renderers().empty() && rendering->renderers()[0] && rendering->renderers()[0]->framebuffer() )
+      context = rendering->renderers()[0]->framebuffer()->openglContext();
+    if ( !context )
+    {
+      vl::Log::error( Say("MultiContextRendering::render(): Rendering #%n has no OpenGLContext!\n") << i );
+      continue;
+    }
+
+    size_t index = 0;
+    while( index < mContexts.size() && mContexts[index] != context )
+      ++index;
+    if ( index == mContexts.size() )
+    {
+      mContexts.push_back( context );
+      if ( mContextRenderings.size() < mContexts.size() )
+        mContextRenderings.resize( mContexts.size() );
+    }
+    mContextRenderings[index].push_back( rendering );
+  }
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  // one render thread per context
+  while( mWorkers.size() > mContexts.size() )
+  {
+    delete mWorkers.back();
+    mWorkers.pop_back();
+  }
+  while( mWorkers.size() < mContexts.size() )
+    mWorkers.push_back( new MultiContextWorker( this, (int)mWorkers.size() ) );
+#endif
+}
+//------------------------------------------------------------------------------
+void MultiContextRendering::render()
+{
+  if ( enableMask() == 0 )
+    return;
+
+  dispatchOnRenderingStarted();
+
+  setupContexts();
+
+  // transforms, cameras and bounds are updated serially since the Rendering[s] might share their Transform hierarchy and Actor[s]
+
+  for(size_t i=0; i<mContexts.size(); ++i)
+  {
+    for(size_t j=0; j<mContextRenderings[i].size(); ++j)
+    {
+      Rendering* rendering = mContextRenderings[i][j];
+      rendering->setFrameClock( frameClock() );
+      if ( rendering->canPrepareFrame() )
+        rendering->updateTransforms();
+    }
+  }
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  for(size_t i=0; i<mContexts.size(); ++i)
+  {
+    for(size_t j=0; j<mContextRenderings[i].size(); ++j)
+    {
+      if ( mContextRenderings[i][j]->canPrepareFrame() )
+        mContextRenderings[i][j]->updateBounds();
+    }
+  }
+#endif
+
+  const bool present = swapBuffers();
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+  // the contexts are made current by their render threads
+  for(size_t i=0; i<mContexts.size(); ++i)
+    mContexts[i]->doneCurrent();
+
+  // the resources shared by the contexts are initialized one thread at a time
+  std::vector<Rendering*> locked;
+  for(size_t i=0; i<mContexts.size(); ++i)
+  {
+    for(size_t j=0; j<mContextRenderings[i].size(); ++j)
+    {
+      if ( mContextRenderings[i][j]->resourceMutex() == NULL )
+      {
+        mContextRenderings[i][j]->setResourceMutex( mResourceMutex );
+        locked.push_back( mContextRenderings[i][j] );
+      }
+    }
+  }
+
+  for(size_t i=0; i<mContexts.size(); ++i)
+    mContexts[i]->setConcurrentRendering( mContexts.size() > 1 );
+
+  for(size_t i=0; i<mWorkers.size(); ++i)
+    mWorkers[i]->start( MultiContextWorker::Job_Render );
+  for(size_t i=0; i<mWorkers.size(); ++i)
+    mWorkers[i]->wait();
+
+  for(size_t i=0; i<mContexts.size(); ++i)
+    mContexts[i]->setConcurrentRendering( false );
+
+  // swap barrier: all the contexts have completed the frame
+  if ( present && swapBarrier() )
+  {
+    for(size_t i=0; i<mWorkers.size(); ++i)
+      mWorkers[i]->start( MultiContextWorker::Job_Present );
+    for(size_t i=0; i<mWorkers.size(); ++i)
+      mWorkers[i]->wait();
+  }
+
+  for(size_t i=0; i<locked.size(); ++i)
+    locked[i]->setResourceMutex( NULL );
+#else
+  for(size_t i=0; i<mContexts.size(); ++i)
+    renderContext( (int)i, false );
+
+  if ( present )
+  {
+    for(size_t i=0; i<mContexts.size(); ++i)
+      presentContext( (int)i, false );
+  }
+#endif
+
+  dispatchOnRenderingFinished();
+}
+//------------------------------------------------------------------------------
+void MultiContextRendering::renderContext(int i, bool threaded)
+{
+  OpenGLContext* context = mContexts[i];
+  const std::vector<Rendering*>& context_renderings = mContextRenderings[i];
+
+  // Rendering::render() makes the context current
+  for(size_t j=0; j<context_renderings.size(); ++j)
+  {
+    if ( context_renderings[j]->canPrepareFrame() )
+      context_renderings[j]->prepareFrame();
+    context_renderings[j]->render();
+  }
+
+  if ( !threaded )
+    return;
+
+  if ( swapBuffers() && swapBarrier() )
+  {
+    // the context is presented by presentContext() once all the contexts are done
+    context->makeCurrent();
+    glFinish();
+    return;
+  }
+
+  if ( swapBuffers() )
+    presentContext(i, true);
+  else
+    context->doneCurrent();
+}
+//------------------------------------------------------------------------------
+void MultiContextRendering::presentContext(int i, bool threaded)
+{
+  OpenGLContext* context = mContexts[i];
+  context->makeCurrent();
+  context->swapBuffers();
+  if ( threaded )
+    context->doneCurrent();
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef MultiContextRendering_INCLUDE_ONCE
+#define MultiContextRendering_INCLUDE_ONCE
+
+#include <vlGraphics/RenderingAbstract.hpp>
+#include <vlCore/Collection.hpp>
+#include <vlCore/IMutex.hpp>
+#include <vector>
+
+namespace vl
+{
+  class Rendering;
+  class OpenGLContext;
+  class MultiContextWorker;
+
+  //-----------------------------------------------------------------------------
+  // MultiContextRendering
+  //-----------------------------------------------------------------------------
+  /** Renders a set of Rendering[s] targeting different OpenGLContext[s] concurrently, one render thread per context, for
+   * example the displays of a video wall driven by several GPUs.
+   *
+   * Each call to render() performs the following steps:
+   * -# The Transform[s] and Camera[s] of the Rendering[s] and the bounds of the Actor[s] of their SceneManager[s] are updated by the
+   *    calling thread, since they might share their Transform hierarchy and their Actor[s].
+   * -# The render thread of each context makes the context current, culls, fills and sorts the queues of its Rendering[s] and renders them.
+   *    Rendering[s] sharing the same context are rendered by the same thread in the order they appear in renderings().
+   *    The Shader animation and the initialization of the resources of the render queues are performed one thread at a time,
+   *    see Rendering::setResourceMutex().
+   * -# If swapBuffers() is enabled every thread presents its context. With the swap barrier enabled (see setSwapBarrier()) the
+   *    threads first wait for their GPU to complete the frame and then for each other, so that all the displays are updated together.
+   * -# The contexts are released (see OpenGLContext::doneCurrent()) and render() returns.
+   *
+   * The render threads run only within render() and do not modify the scene, which must be treated as read only while it is rendered:
+   * - The scene must not be modified by the RenderEventCallback[s] and ActorEventCallback[s] of the child Rendering[s] and of their Renderer[s].
+   * - The contexts must belong to the same share group, since a BufferObject or a Texture has only one OpenGL name.
+   *   Contexts living on GPUs that cannot share their objects must render separate copies of the Renderable[s] and Effect[s], for
+   *   example made with Geometry::deepCopy(), while the RAM side of the scene such as the Transform hierarchy can still be shared.
+   * - Each context must use its own GLSLProgram[s], and thus its own Shader[s], since the uniform values of a program are shared
+   *   by the share group. A GLSLProgram is bound to the first context rendering it and is skipped by the others, which log an
+   *   error, see GLSLProgram::claimRenderContext().
+   * - The LOD cache of the Rendering[s] is not used, see Rendering::setLODCacheEnabled().
+   * - The Geometry[s] must have up to date buffer objects before the frame is rendered, see Renderable::updateDirtyBufferObject().
+   * - The child Rendering[s] must not share their Camera[s] and must not be pipelined (see Rendering::setPipelined()).
+   * - The reference counts of the shared objects are modified concurrently: build VL with VL_ATOMIC_REF_COUNT.
+   * - render() releases the context current to the calling thread with OpenGLContext::doneCurrent(), the contexts must not be current
+   *   to any other thread. This requires a GUI binding implementing doneCurrent(), such as vlEGL::EGLHeadlessContext, vlGLFW::GLFWWindow
+   *   or vlWin32::Win32Context. The contexts are released by the render threads before render() returns.
+   *
+   * If VL is built without VL_MULTI_CONTEXT_RENDERING the contexts are rendered and presented one after the other by the calling thread.
+   * \sa RenderingTree, Rendering::setResourceMutex() */
+  class VLGRAPHICS_EXPORT MultiContextRendering: public RenderingAbstract
+  {
+    VL_INSTRUMENT_CLASS(vl::MultiContextRendering, RenderingAbstract)
+
+  private:
+    MultiContextRendering(const MultiContextRendering&): RenderingAbstract() {}
+    void operator=(const MultiContextRendering&) {}
+
+  public:
+    //! Constructor.
+    MultiContextRendering();
+
+    //! Destructor: stops the render threads.
+    ~MultiContextRendering();
+
+    //! Renders all the Rendering[s] concurrently, one thread per OpenGLContext.
+    //! \note
+    //! If enableMask() == 0 then no rendering is performed and no RenderEventCallback is called.
+    virtual void render();
+
+    //! The Rendering[s] to be rendered, the context of a Rendering is the one of the framebuffer of its first Renderer.
+    Collection<Rendering>* renderings() { return mRenderings.get(); }
+
+    //! The Rendering[s] to be rendered, the context of a Rendering is the one of the framebuffer of its first Renderer.
+    const Collection<Rendering>* renderings() const { return mRenderings.get(); }
+
+    /** Whether render() presents the contexts with OpenGLContext::swapBuffers() after rendering them (default is true). */
+    void setSwapBuffers(bool swap) { mSwapBuffers = swap; }
+
+    /** Whether render() presents the contexts with OpenGLContext::swapBuffers() after rendering them (default is true). */
+    bool swapBuffers() const { return mSwapBuffers; }
+
+    /** If true (default) the buffers of the contexts are swapped only after all of them have completed the frame (see glFinish()),
+      * so that the displays are updated together. Has no effect if swapBuffers() is disabled. This is a CPU side barrier: the swaps
+      * are issued together but each display presents at its own vertical retrace unless the displays are genlocked. */
+    void setSwapBarrier(bool barrier) { mSwapBarrier = barrier; }
+
+    /** Whether the buffers are swapped only after all the contexts have completed the frame, see setSwapBarrier(). */
+    bool swapBarrier() const { return mSwapBarrier; }
+
+    /** Stops the render threads, which are started again by the next render(). */
+    void stopThreads();
+
+    /** The number of render threads currently running, one per OpenGLContext. Always 0 if VL is built without VL_MULTI_CONTEXT_RENDERING. */
+    int threadCount() const { return (int)mWorkers.size(); }
+
+  protected:
+    //! Renders the Rendering[s] of the i-th context, executed by its render thread if \p threaded is true.
+    void renderContext(int i, bool threaded);
+    //! Swaps the buffers of the i-th context, executed by its render thread if \p threaded is true.
+    void presentContext(int i, bool threaded);
+    //! Assigns the Rendering[s] to their contexts and starts or stops the render threads.
+    void setupContexts();
+
+    friend class MultiContextWorker;
+
+  protected:
+    ref< Collection<Rendering> > mRenderings;
+    // the contexts rendered in the current frame and the Rendering[s] of each context
+    std::vector<OpenGLContext*> mContexts;
+    std::vector< std::vector<Rendering*> > mContextRenderings;
+    std::vector<MultiContextWorker*> mWorkers;
+    IMutex* mResourceMutex;
+    bool mSwapBuffers;
+    bool mSwapBarrier;
+  };
+}
+
+#endif
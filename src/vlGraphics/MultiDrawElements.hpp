@@ -183,6 +183,14 @@ namespace vl
       return de;
     }
 
+    virtual ref<DrawCall> cowClone() const
+    {
+      ref<MultiDrawElements> de = new MultiDrawElements;
+      de->setIndexBuffer( indexBuffer()->cowClone()->template as<arr_type>() );
+      *de = *this;
+      return de;
+    }
+
     void setIndexBuffer(arr_type* index_buffer) { mIndexBuffer = index_buffer; }
 
     arr_type* indexBuffer() { return mIndexBuffer.get(); }
@@ -200,6 +208,19 @@ namespace vl
       indexBuffer()->bufferObject()->deleteBufferObject();
     }
 
+    virtual ArrayAbstract* indexArray() { return indexBuffer(); }
+
+    virtual const ArrayAbstract* indexArray() const { return indexBuffer(); }
+
+    virtual void countRenderStats(RenderStats& stats) const
+    {
+      // a single glMultiDrawElements call, the index buffer is always bound, see render()
+      stats.countDrawCall( primitiveType(), 0, 1 );
+      for(size_t i=0; i<mCountVector.size(); ++i)
+        stats.countPrimitives( primitiveType(), (u32)mCountVector[i], 1 );
+      ++stats.mBufferBinds;
+    }
+
     virtual void render(bool use_bo) const
     {
       VL_CHECK_OGL()
@@ -226,6 +247,14 @@ namespace vl
         VL_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer()->bufferObject()->handle()); VL_CHECK_OGL()
         VL_CHECK(!mBufferObjectPointerVector.empty())
         indices_ptr = (const GLvoid**)&mBufferObjectPointerVector[0];
+        // the index buffer is sub-allocated from a BufferObjectPool
+        if (GLintptr bo_offset = indexBuffer()->bufferObject()->byteOffsetBufferObject())
+        {
+          mPooledPointerVector.resize( mBufferObjectPointerVector.size() );
+          for(size_t i=0; i<mBufferObjectPointerVector.size(); ++i)
+            mPooledPointerVector[i] = (const index_type*)((const char*)mBufferObjectPointerVector[i] + bo_offset);
+          indices_ptr = (const GLvoid**)&mPooledPointerVector[0];
+        }
       }
       else
       {
@@ -316,6 +345,7 @@ namespace vl
     ref< arr_type > mIndexBuffer;
     std::vector<const index_type*> mPointerVector;
     std::vector<const index_type*> mBufferObjectPointerVector;
+    mutable std::vector<const index_type*> mPooledPointerVector;
   };
   //------------------------------------------------------------------------------
   // typedefs
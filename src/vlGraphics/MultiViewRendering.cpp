@@ -0,0 +1,279 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/MultiViewRendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//------------------------------------------------------------------------------
+MultiViewRendering::MultiViewRendering(): mStatsSharedActors(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+}
+//------------------------------------------------------------------------------
+void MultiViewRendering::render()
+{
+  if ( views().empty() )
+  {
+    Rendering::render();
+    return;
+  }
+
+  if ( views().size() > 32 )
+  {
+    vl::Log::error("MultiViewRendering::render(): at most 32 views are supported!\n");
+    VL_TRAP();
+    return;
+  }
+
+  // if rendering is disabled skip all.
+
+  if ( enableMask() == 0 )
+    return;
+
+  // enter/exit behavior contract
+
+  class InOutContract
+  {
+    MultiViewRendering* mRendering;
+    OpenGLContext* mOpenGLContext;
+
+  public:
+    InOutContract(MultiViewRendering* rendering): mRendering(rendering)
+    {
+      VL_CHECK(mRendering->renderers().size());
+      VL_CHECK(mRendering->renderers()[0]->framebuffer());
+      VL_CHECK(mRendering->renderers()[0]->framebuffer()->openglContext());
+
+      mOpenGLContext = mRendering->renderers()[0]->framebuffer()->openglContext();
+      mOpenGLContext->makeCurrent();
+      VL_CHECK_OGL();
+      mOpenGLContext->resetContextStates(RCS_RenderingStarted);
+      mRendering->dispatchOnRenderingStarted();
+      VL_CHECK_OGL()
+    }
+
+    ~InOutContract()
+    {
+      mRendering->dispatchOnRenderingFinished();
+      mRendering->actorQueue()->resize(0);
+      VL_CHECK_OGL()
+      mOpenGLContext->resetContextStates(RCS_RenderingFinished);
+    }
+  };
+
+  if ( renderers().empty() || !renderers()[0]->framebuffer() || !renderers()[0]->framebuffer()->openglContext() )
+  {
+    vl::Log::error("MultiViewRendering::render(): no valid Renderer specified for this Rendering!\n");
+    VL_TRAP();
+    return;
+  }
+
+  InOutContract contract(this);
+
+  if ( sceneManagers()->empty() || !camera() )
+    return;
+
+  FrameProfiler* profiler = mProfiler.get();
+  const bool profiler_frame = profiler && !profiler->isFrameOpen();
+  if (profiler_frame)
+    profiler->beginFrame();
+  if (profiler)
+    profiler->beginScope("MultiViewRendering::render");
+
+  // transform and camera
+
+  updateTransforms();
+
+  // view camera transforms and frusta
+
+  const int view_count = views().size();
+  mViewCameras.resize( view_count );
+  for(int iview=0; iview<view_count; ++iview)
+  {
+    Camera* view_camera = views().at(iview);
+    if (view_camera->boundTransform())
+      view_camera->setModelingMatrix( view_camera->boundTransform()->worldMatrix() );
+    view_camera->computeFrustumPlanes();
+    mViewCameras[iview] = view_camera;
+  }
+
+  // culling: a single traversal of each SceneManager for all the views
+
+  const u32 all_views = view_count == 32 ? 0xFFFFFFFF : (1u << view_count) - 1;
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "cull");
+    actorQueue()->clear();
+    mViewMasks.clear();
+    for(int i = 0; i < sceneManagers()->size(); ++i )
+      extractMultiViewVisibleActors( sceneManagers()->at(i), all_views );
+  }
+
+  // render queue filling, shared by all the views
+
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "fillRenderQueue");
+    renderQueue()->clear();
+    fillRenderQueue( actorQueue(), renderQueue(), camera(), true );
+    fillViewRenderQueues();
+  }
+
+  // sort each view's queue from its own point of view
+
+  if (renderQueueSorter())
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "sort");
+    for(int iview=0; iview<view_count; ++iview)
+    {
+      if (coherentRenderQueue())
+        mViewRenderQueues[iview]->sortCoherent( renderQueueSorter(), views().at(iview) );
+      else
+        mViewRenderQueues[iview]->sort( renderQueueSorter(), views().at(iview) );
+    }
+  }
+
+  // asynchronous texture uploads
+
+  if (textureStreamer())
+    textureStreamer()->update();
+
+  // render each view through the renderers chain
+
+  for(int iview=0; iview<view_count; ++iview)
+  {
+    if (profiler)
+      profiler->beginScope( ("View #" + String::fromInt(iview)).toStdString().c_str(), true );
+
+    const RenderQueue* render_queue = mViewRenderQueues[iview].get();
+    for(int i=0; i<renderers().size(); ++i)
+    {
+      if ( !renderers()[i] )
+        continue;
+
+      if ( !renderers()[i]->framebuffer() || !renderers()[i]->framebuffer()->openglContext() )
+      {
+        vl::Log::error( Say("MultiViewRendering::render(): invalid Framebuffer for Renderer #%n!\n") << i );
+        VL_TRAP();
+        continue;
+      }
+
+      if (profiler)
+        renderers()[i]->setProfiler(profiler);
+      render_queue = renderers()[i]->render( render_queue, views().at(iview), frameClock() );
+    }
+
+    if (profiler)
+      profiler->endScope();
+  }
+
+  if (profiler)
+    profiler->endScope();
+  if (profiler_frame)
+    profiler->endFrame();
+
+  VL_CHECK_OGL()
+}
+//------------------------------------------------------------------------------
+void MultiViewRendering::extractMultiViewVisibleActors( SceneManager* scene_manager, u32 all_views )
+{
+  if ( !isEnabled( scene_manager->enableMask() ) )
+    return;
+
+  if ( cullingEnabled() && scene_manager->cullingEnabled() )
+  {
+    if ( scene_manager->boundsDirty() ) {
+      scene_manager->computeBounds();
+    }
+
+    // the views that can see the whole scene manager
+    u32 view_mask = 0;
+    for(size_t iview=0; iview<mViewCameras.size(); ++iview)
+    {
+      const Frustum& frustum = mViewCameras[iview]->frustum();
+      if ( !frustum.cull( scene_manager->boundingSphere() ) && !frustum.cull( scene_manager->boundingBox() ) )
+        view_mask |= 1u << iview;
+    }
+
+    if ( view_mask )
+      scene_manager->extractMultiViewVisibleActors( *actorQueue(), mViewMasks, mViewCameras, view_mask );
+  }
+  else
+  {
+    scene_manager->extractVisibleActors( *actorQueue(), NULL );
+    mViewMasks.resize( actorQueue()->size(), all_views );
+  }
+}
+//------------------------------------------------------------------------------
+void MultiViewRendering::fillViewRenderQueues()
+{
+  const int view_count = views().size();
+  while( (int)mViewRenderQueues.size() < view_count )
+    mViewRenderQueues.push_back( new RenderQueue );
+  for(int iview=0; iview<view_count; ++iview)
+    mViewRenderQueues[iview]->clear();
+
+  mStatsVisibleActors.assign( view_count, 0 );
+  mStatsSharedActors = actorQueue()->size();
+  for(int i=0; i<actorQueue()->size(); ++i)
+  {
+    for(int iview=0; iview<view_count; ++iview)
+    {
+      if ( mViewMasks[i] & (1u << iview) )
+        ++mStatsVisibleActors[iview];
+    }
+  }
+
+  // the tokens are created in the order of the actor queue: walk both to find the view mask of each token
+  int iactor = 0;
+  for(int itok=0; itok<renderQueue()->size(); ++itok)
+  {
+    const RenderToken* tok = renderQueue()->at(itok);
+    while( actorQueue()->at(iactor) != tok->mActor )
+      ++iactor;
+    VL_CHECK( iactor < actorQueue()->size() )
+
+    const u32 mask = mViewMasks[iactor];
+    for(int iview=0; iview<view_count; ++iview)
+    {
+      if ( mask & (1u << iview) )
+      {
+        // the copy shares the multipass chain of the original token
+        RenderToken* view_tok = mViewRenderQueues[iview]->newToken(false);
+        *view_tok = *tok;
+      }
+    }
+  }
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef MultiViewRendering_INCLUDE_ONCE
+#define MultiViewRendering_INCLUDE_ONCE
+
+#include <vlGraphics/Rendering.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // MultiViewRendering
+  //------------------------------------------------------------------------------
+  /** A Rendering that draws the same scene from several cameras, for example the 4 views of a modeling application,
+    * sharing the work that does not depend on the point of view.
+    *
+    * The SceneManager[s] are culled once against the frusta of all the views() (see SceneManager::extractMultiViewVisibleActors()),
+    * producing for each visible Actor the bitmask of the views it is visible from. The render queue is then filled once:
+    * bounds, Effect override, LOD evaluation, shader animation and resource initialization are performed only once per Actor,
+    * using camera() as the reference camera. Each view finally receives its own copy of the RenderToken[s] it can see,
+    * which is sorted and rendered with the view's camera by the installed Renderer[s].
+    *
+    * Each view camera should have its own Viewport. At most 32 views are supported. If no view is installed the
+    * scene is rendered from camera() as a regular Rendering. The near/far clipping planes optimization and the
+    * dynamic resolution are not supported by this class and are ignored.
+    * \sa Rendering, SceneManager::extractMultiViewVisibleActors() */
+  class VLGRAPHICS_EXPORT MultiViewRendering: public Rendering
+  {
+    VL_INSTRUMENT_CLASS(vl::MultiViewRendering, Rendering)
+
+  public:
+    MultiViewRendering();
+
+    /** Executes the rendering of all the views. */
+    virtual void render();
+
+    /** The cameras of the views to be rendered, at most 32. */
+    Collection<Camera>& views() { return mViews; }
+
+    /** The cameras of the views to be rendered, at most 32. */
+    const Collection<Camera>& views() const { return mViews; }
+
+    /** Number of Actor[s] visible from the given view during the last rendering. */
+    int statsVisibleActors(int view) const { return view < (int)mStatsVisibleActors.size() ? mStatsVisibleActors[view] : 0; }
+
+    /** Number of Actor[s] visible from at least one view during the last rendering. */
+    int statsSharedActors() const { return mStatsSharedActors; }
+
+  protected:
+    void extractMultiViewVisibleActors( SceneManager* scene_manager, u32 all_views );
+    void fillViewRenderQueues();
+
+  protected:
+    Collection<Camera> mViews;
+    std::vector<const Camera*> mViewCameras;
+    std::vector<u32> mViewMasks;
+    std::vector< ref<RenderQueue> > mViewRenderQueues;
+    std::vector<int> mStatsVisibleActors;
+    int mStatsSharedActors;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -46,6 +46,11 @@ OcclusionCullRenderer::OcclusionCullRenderer()
 
   mStatsTotalObjects = 0;
   mStatsOccludedObjects = 0;
+  mStatsIssuedQueries = 0;
+  mStatsConditionalObjects = 0;
+  mQueryInterval = 1;
+  mWaitQueryResults = true;
+  mConditionalRendering = false;
 
   mCulledRenderQueue = new RenderQueue;
   mOcclusionThreshold      = 0;
@@ -119,7 +124,9 @@ const RenderQueue* OcclusionCullRenderer::render(const RenderQueue* in_render_qu
   
   // (3)
   // perform occlusion query on all objects.
+  framebuffer()->openglContext()->beginRenderRaw();
   render_pass2( in_render_queue, camera );
+  framebuffer()->openglContext()->endRenderRaw();
   
   // return only the visible, non occluded, objects.
   return mCulledRenderQueue.get();
@@ -149,16 +156,23 @@ Framebuffer* OcclusionCullRenderer::framebuffer()
 void OcclusionCullRenderer::render_pass1(const RenderQueue* in_render_queue )
 {
   // reset occluded objects statistics
-  mStatsOccludedObjects = 0;
-  mStatsTotalObjects    = in_render_queue->size();
+  mStatsOccludedObjects    = 0;
+  mStatsConditionalObjects = 0;
+  mStatsTotalObjects       = in_render_queue->size();
 
   // reset visible objects.
   mCulledRenderQueue->clear();
 
+  // the occlusion information is meaningful only if generated by the same renderer
+  const bool same_renderer = mPrevWrapRenderer == mWrappedRenderer.get();
+
+  // let the GPU discard the occluded objects, no query result is read back
+  const bool conditional = mConditionalRendering && Has_Conditional_Render;
+
   // iterate incoming render tokens and output only visible ones
   for( int i=0; i<in_render_queue->size(); ++i)
   {
-    const Actor* actor = in_render_queue->at(i)->mActor;
+    Actor* actor = in_render_queue->at(i)->mActor;
 
     if ( ! mWrappedRenderer->isEnabled(actor) )
       continue;
@@ -166,21 +180,51 @@ void OcclusionCullRenderer::render_pass1(const RenderQueue* in_render_queue )
     bool occluded = false;
     VL_CHECK(Has_Occlusion_Query)
 
-    if ( actor->occlusionQuery() && 
-         actor->occlusionQueryTick() == mWrappedRenderer->renderTick() && 
-         mPrevWrapRenderer == mWrappedRenderer.get() )
+    if ( conditional )
     {
-      #if 0
+      RenderToken* tok = mCulledRenderQueue->newToken(false);
+      *tok = *in_render_queue->at(i);
+      // the query issued during the previous frame, if any, decides whether the object is rendered
+      if ( actor->occlusionQuery() && actor->occlusionQueryPending() && same_renderer )
+      {
+        tok->mConditionalQuery = actor->occlusionQuery();
+        mStatsConditionalObjects++;
+      }
+      actor->setOcclusionQueryPending(false);
+      continue;
+    }
+
+    if ( waitQueryResults() )
+    {
+      if ( actor->occlusionQuery() && 
+           actor->occlusionQueryTick() == mWrappedRenderer->renderTick() && 
+           same_renderer )
+      {
+        // query the occlusion status: note that this might flush the pipeline
+        GLint pixels = 0;
+        glGetQueryObjectiv(actor->occlusionQuery(), GL_QUERY_RESULT, &pixels); VL_CHECK_OGL();
+        if (pixels <= occlusionThreshold())
+          occluded = true;
+        actor->setOcclusionQueryPending(false);
+        actor->setOccluded(occluded);
+      }
+    }
+    else
+    {
+      if ( actor->occlusionQuery() && actor->occlusionQueryPending() )
+      {
+        // never wait: if the result is not ready yet keep using the last known visibility
         GLint ready = GL_FALSE;
         glGetQueryObjectiv(actor->occlusionQuery(), GL_QUERY_RESULT_AVAILABLE, &ready); VL_CHECK_OGL();
-        if (ready == GL_FALSE)
-          vl::Log::error("Occlusion culling query not yet available.\n");
-      #endif
-      // query the occlusion status: note that this might flush the pipeline
-      GLint pixels = 0;
-      glGetQueryObjectiv(actor->occlusionQuery(), GL_QUERY_RESULT, &pixels); VL_CHECK_OGL();
-      if (pixels <= occlusionThreshold())
-        occluded = true;
+        if (ready)
+        {
+          GLint pixels = 0;
+          glGetQueryObjectiv(actor->occlusionQuery(), GL_QUERY_RESULT, &pixels); VL_CHECK_OGL();
+          actor->setOcclusionQueryPending(false);
+          actor->setOccluded(pixels <= occlusionThreshold());
+        }
+      }
+      occluded = same_renderer && actor->isOccluded();
     }
 
     if (occluded == false)
@@ -206,8 +250,85 @@ void OcclusionCullRenderer::render_pass2(const RenderQueue* non_occluded_render_
   GLint buffer = 0;
   glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &buffer);
   VL_CHECK(buffer == 0);
+  framebuffer()->openglContext()->countGLQuery("GL_ARRAY_BUFFER_BINDING");
 #endif
 
+  mStatsIssuedQueries = 0;
+
+  // camera/eye position for later usage
+
+  vec3 eye = camera->modelingMatrix().getT();
+
+  // --------------- select the Actors to be queried ---------------
+
+  mQueryTokens.clear();
+  const unsigned render_tick = mWrappedRenderer->renderTick();
+  for( int i=0; i<non_occluded_render_queue->size(); ++i)
+  {
+    const RenderToken* tok = non_occluded_render_queue->at(i);
+    Actor* actor = tok->mActor;
+
+    if ( ! mWrappedRenderer->isEnabled(actor) )
+      continue;
+
+    // no query can be performed from inside the bounding box or for non occludees: these are always visible.
+    if ( !actor->isOccludee() || actor->boundingBox().isInside(eye) )
+    {
+      actor->setOccluded(false);
+      continue;
+    }
+
+    if ( !waitQueryResults() && !(mConditionalRendering && Has_Conditional_Render) )
+    {
+      // the previous query of this Actor is still in flight
+      if ( actor->occlusionQueryPending() )
+        continue;
+
+      // visible Actors are re-queried only once every mQueryInterval frames, spread by their address.
+      if ( !actor->isOccluded() && mQueryInterval > 1 && (render_tick + (unsigned)((size_t)actor >> 4)) % mQueryInterval != 0 )
+        continue;
+    }
+
+    mQueryTokens.push_back(tok);
+  }
+
+  if (mQueryTokens.empty())
+    return;
+
+  // --------------- compute the world space bounding boxes ---------------
+
+  // all the boxes are transformed on the CPU and sourced from a single vertex array so that the
+  // modelview matrix and the vertex pointer are set only once for all the queries.
+  const unsigned quads[] = { 3,2,1,0, 2,6,5,1, 3,7,6,2, 7,3,0,4, 4,0,1,5, 6,7,4,5 };
+  mBoxVerts.resize( mQueryTokens.size() * 8 );
+  mBoxIndices.resize( mQueryTokens.size() * 24 );
+  for( size_t i=0; i<mQueryTokens.size(); ++i )
+  {
+    const RenderToken* tok = mQueryTokens[i];
+    const AABB& aabb = tok->mRenderable->boundingBox();
+    const vec3& a = aabb.minCorner();
+    const vec3& b = aabb.maxCorner();
+    vec3 corners[] = 
+    {
+      vec3(a.x(), a.y(), a.z()), vec3(b.x(), a.y(), a.z()), vec3(b.x(), b.y(), a.z()), vec3(a.x(), b.y(), a.z()),
+      vec3(a.x(), a.y(), b.z()), vec3(b.x(), a.y(), b.z()), vec3(b.x(), b.y(), b.z()), vec3(a.x(), b.y(), b.z())
+    };
+    fvec3* verts = &mBoxVerts[i*8];
+    if ( tok->mActor->transform() )
+    {
+      const mat4& world = tok->mActor->transform()->worldMatrix();
+      for(int j=0; j<8; ++j)
+        verts[j] = (fvec3)(world * corners[j]);
+    }
+    else
+    {
+      for(int j=0; j<8; ++j)
+        verts[j] = (fvec3)corners[j];
+    }
+    for(int j=0; j<24; ++j)
+      mBoxIndices[i*24+j] = (GLuint)(i*8) + quads[j];
+  }
+
   // --------------- render target activation --------------- 
 
   /* keep the currently active render target */
@@ -235,33 +356,25 @@ void OcclusionCullRenderer::render_pass2(const RenderQueue* non_occluded_render_
 
   OpenGLContext* opengl_context = framebuffer()->openglContext();
   GLSLProgram*   glsl_program   = mOcclusionShader->glslProgram();
-  Transform*     cur_transform  = NULL;
 
   opengl_context->resetRenderStates();
   opengl_context->resetEnables();
   opengl_context->applyRenderStates( mOcclusionShader->getRenderStateSet(), camera );
   opengl_context->applyEnables( mOcclusionShader->getEnableSet() );
-  projViewTransfCallback()->updateMatrices( true, true, glsl_program, camera, cur_transform );
-
-  // camera/eye position for later usage
-
-  vec3 eye = camera->modelingMatrix().getT();
+  // the boxes are already in world space
+  projViewTransfCallback()->updateMatrices( true, true, glsl_program, camera, NULL );
 
   // --------------- rendering ---------------
 
-  // iterate over render tokens
-
   // glColor3f(1.0f, 0.0f, 1.0f); // for debugging only
   glEnableClientState(GL_VERTEX_ARRAY); VL_CHECK_OGL();
+  glVertexPointer(3, GL_FLOAT, 0, &mBoxVerts[0]); VL_CHECK_OGL();
 
-  for( int i=0; i<non_occluded_render_queue->size(); ++i)
+  for( size_t i=0; i<mQueryTokens.size(); ++i)
   {
-    const RenderToken* tok = non_occluded_render_queue->at(i);
+    const RenderToken* tok = mQueryTokens[i];
     Actor* actor = tok->mActor;
 
-    if ( ! mWrappedRenderer->isEnabled(actor) )
-      continue;
-
     // --------------- Actor's scissor ---------------
 
     const Scissor* scissor = actor->scissor() ? actor->scissor() : tok->mShader->scissor();
@@ -284,44 +397,18 @@ void OcclusionCullRenderer::render_pass2(const RenderQueue* non_occluded_render_
       }
     }
 
-    if ( !actor->boundingBox().isInside(eye) )
-    {
-      VL_CHECK(Has_Occlusion_Query)
-
-      // if occludee -> perform occlusion test to be used for the next frame
-      if (actor->isOccludee())
-      {
-
-        if (tok->mActor->transform() != cur_transform)
-        {
-          cur_transform = tok->mActor->transform();
-          projViewTransfCallback()->updateMatrices( false, true, glsl_program, camera, cur_transform );
-        }
+    VL_CHECK(Has_Occlusion_Query)
 
-        // register occlusion query tick
-        actor->setOcclusionQueryTick( mWrappedRenderer->renderTick() );
+    // register occlusion query tick
+    actor->setOcclusionQueryTick( mWrappedRenderer->renderTick() );
+    actor->setOcclusionQueryPending(true);
 
-        // compute Renderable AABB geometry (we are using the currently active Transform)
-        const AABB& aabb = tok->mRenderable->boundingBox();
-        const float verts[] = 
-        {
-          (float)aabb.minCorner().x(), (float)aabb.minCorner().y(), (float)aabb.minCorner().z(),
-          (float)aabb.maxCorner().x(), (float)aabb.minCorner().y(), (float)aabb.minCorner().z(),
-          (float)aabb.maxCorner().x(), (float)aabb.maxCorner().y(), (float)aabb.minCorner().z(),
-          (float)aabb.minCorner().x(), (float)aabb.maxCorner().y(), (float)aabb.minCorner().z(),
-          (float)aabb.minCorner().x(), (float)aabb.minCorner().y(), (float)aabb.maxCorner().z(),
-          (float)aabb.maxCorner().x(), (float)aabb.minCorner().y(), (float)aabb.maxCorner().z(),
-          (float)aabb.maxCorner().x(), (float)aabb.maxCorner().y(), (float)aabb.maxCorner().z(),
-          (float)aabb.minCorner().x(), (float)aabb.maxCorner().y(), (float)aabb.maxCorner().z()
-        };
-        const unsigned quads[] = { 3,2,1,0, 2,6,5,1, 3,7,6,2, 7,3,0,4, 4,0,1,5, 6,7,4,5 };
-        glVertexPointer(3, GL_FLOAT, 0, verts); VL_CHECK_OGL();
-        actor->createOcclusionQuery(); VL_CHECK_OGL();
-        glBeginQuery(GL_SAMPLES_PASSED, actor->occlusionQuery()); VL_CHECK_OGL();
-        glDrawElements(GL_QUADS, 6*4, GL_UNSIGNED_INT, quads); VL_CHECK_OGL();
-        glEndQuery(GL_SAMPLES_PASSED); VL_CHECK_OGL();
-      }
-    }
+    // perform occlusion test to be used for the next frame
+    actor->createOcclusionQuery(); VL_CHECK_OGL();
+    glBeginQuery(GL_SAMPLES_PASSED, actor->occlusionQuery()); VL_CHECK_OGL();
+    glDrawElements(GL_QUADS, 6*4, GL_UNSIGNED_INT, &mBoxIndices[i*24]); VL_CHECK_OGL();
+    glEndQuery(GL_SAMPLES_PASSED); VL_CHECK_OGL();
+    ++mStatsIssuedQueries;
   }
 
   glDisableClientState(GL_VERTEX_ARRAY); VL_CHECK_OGL();
@@ -33,9 +33,12 @@
 #define OcclusionCullRenderer_INCLUDE_ONCE
 
 #include <vlGraphics/Renderer.hpp>
+#include <vector>
 
 namespace vl
 {
+  class RenderToken;
+
   //------------------------------------------------------------------------------
   // OcclusionCullRenderer
   //------------------------------------------------------------------------------
@@ -67,6 +70,33 @@ namespace vl
     /** The number of pixels visible for an actor to be considered occluded (default = 0) */
     int occlusionThreshold() const { return mOcclusionThreshold; }
 
+    /** If true (default) the results of the queries issued during the previous frame are waited for, which might stall the pipeline.
+      * If false the query results are retrieved only when already available (GL_QUERY_RESULT_AVAILABLE) and in the meantime each
+      * Actor keeps its last known visibility, that is, the occlusion information might be a few frames late.
+      * No new query is issued for an Actor until the result of its previous query has been retrieved. */
+    void setWaitQueryResults(bool wait) { mWaitQueryResults = wait; }
+
+    /** If true (default) the results of the queries issued during the previous frame are waited for, see setWaitQueryResults(). */
+    bool waitQueryResults() const { return mWaitQueryResults; }
+
+    /** If true the Actors are not culled on the CPU and no query result is read back: each occludee queried during the previous frame
+      * is rendered inside glBeginConditionalRender(query, GL_QUERY_NO_WAIT) so that the GPU itself discards it if its bounding box was
+      * not visible, or renders it if the result is not available yet. Every occludee is re-queried each frame and occlusionThreshold(),
+      * waitQueryResults() and queryInterval() are ignored. The returned RenderQueue contains all the Actors and statsOccludedObjects()
+      * is always 0, see statsConditionalObjects().
+      * Falls back to the query read back path if Has_Conditional_Render is false. Defaults to false. */
+    void setConditionalRendering(bool enable) { mConditionalRendering = enable; }
+
+    /** If true the occluded Actors are discarded by the GPU using conditional rendering, see setConditionalRendering(). */
+    bool conditionalRendering() const { return mConditionalRendering; }
+
+    /** When waitQueryResults() is false, visible Actors are re-queried only once every \p frames frames while occluded ones are re-queried
+      * as soon as their previous result is available. The queries of the visible Actors are spread among the frames. Defaults to 1. */
+    void setQueryInterval(int frames) { mQueryInterval = frames < 1 ? 1 : frames; }
+
+    /** When waitQueryResults() is false, visible Actors are re-queried only once every queryInterval() frames, see setQueryInterval(). */
+    int queryInterval() const { return mQueryInterval; }
+
     /** Returns the wrapped Renderer's Framebuffer */
     const Framebuffer* framebuffer() const;
 
@@ -79,6 +109,12 @@ namespace vl
     /** Returns the number or objects not rendered due to the occlusion culling. */
     int statsOccludedObjects() const { return mStatsOccludedObjects; }
 
+    /** Returns the number of occlusion queries issued during the last frame. */
+    int statsIssuedQueries() const { return mStatsIssuedQueries; }
+
+    /** Returns the number of objects rendered inside a conditional rendering block during the last frame, see setConditionalRendering(). */
+    int statsConditionalObjects() const { return mStatsConditionalObjects; }
+
     /** The Shader used to render the bounding boxes during the occlusion culling query.
       * For example if you have problems with the zbuffer percision you can access the Shader to modify
       * the polygon offset settings. */
@@ -109,6 +145,17 @@ namespace vl
     Renderer* mPrevWrapRenderer;
     int mStatsTotalObjects;
     int mStatsOccludedObjects;
+    int mStatsIssuedQueries;
+    int mStatsConditionalObjects;
+    int mQueryInterval;
+    bool mWaitQueryResults;
+    bool mConditionalRendering;
+
+  private:
+    // per-frame bounding box geometry of the queried Actors
+    std::vector<fvec3> mBoxVerts;
+    std::vector<GLuint> mBoxIndices;
+    std::vector<const RenderToken*> mQueryTokens;
   };
   //------------------------------------------------------------------------------
 }
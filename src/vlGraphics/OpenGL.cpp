@@ -43,6 +43,9 @@
 namespace vl
 {
   bool Is_OpenGL_Initialized = false;
+  bool Is_GL_Debug_Output_Active = false;
+  const char* GL_Last_Check_File = "";
+  int GL_Last_Check_Line = 0;
   bool Is_OpenGL_Core_Profile = false;
   bool Is_OpenGL_Forward_Compatible = false;
 
@@ -59,6 +62,8 @@ namespace vl
   bool Has_GL_Version_3_3 = false;
   bool Has_GL_Version_4_0 = false;
   bool Has_GL_Version_4_1 = false;
+  bool Has_GL_Version_4_2 = false;
+  bool Has_GL_Version_4_3 = false;
 
   bool Has_Fixed_Function_Pipeline = false;
 
@@ -92,12 +97,26 @@ namespace vl
   bool Has_Multitexture = false;
   bool Has_Primitive_Restart = false;
   bool Has_Occlusion_Query = false;
+  bool Has_Timer_Query = false;
   bool Has_Transform_Feedback = false;
   bool Has_glGenerateMipmaps = false;
   bool Has_GL_GENERATE_MIPMAP = false;
   bool Has_Point_Sprite = false;
   bool Has_Base_Vertex = false;
   bool Has_Primitive_Instancing = false;
+  bool Has_Uniform_Buffer_Object = false;
+  bool Has_Parallel_Shader_Compile = false;
+  bool Has_Compute_Shader = false;
+  bool Has_Shader_Storage_Buffer = false;
+  bool Has_Image_Load_Store = false;
+  bool Has_Texture_Storage = false;
+  bool Has_Sampler_Objects = false;
+  bool Has_Conditional_Render = false;
+  bool Has_Framebuffer_Invalidation = false;
+
+  // glInvalidateFramebuffer() is GL 4.3 / GLES 3.0 and not in the function lists
+  typedef void (APIENTRY *InvalidateFramebufferProc)( GLenum target, GLsizei count, const GLenum* attachments );
+  static InvalidateFramebufferProc gInvalidateFramebuffer = NULL;
 
   #define VL_EXTENSION(extension) bool Has_##extension = false;
   #include <vlGraphics/GL/GLExtensionList.hpp>
@@ -403,6 +422,8 @@ bool vl::initializeOpenGL()
   Has_GL_Version_3_3 = (vmaj == 3 && vmin >= 3) || (vmaj > 3 && Has_Fixed_Function_Pipeline);
   Has_GL_Version_4_0 = (vmaj == 4 && vmin >= 0) || (vmaj > 4 && Has_Fixed_Function_Pipeline);
   Has_GL_Version_4_1 = (vmaj == 4 && vmin >= 1) || (vmaj > 4 && Has_Fixed_Function_Pipeline);
+  Has_GL_Version_4_2 = (vmaj == 4 && vmin >= 2) || (vmaj > 4 && Has_Fixed_Function_Pipeline);
+  Has_GL_Version_4_3 = (vmaj == 4 && vmin >= 3) || (vmaj > 4 && Has_Fixed_Function_Pipeline);
 
   // - - - Extension strings init - - -
 
@@ -469,12 +490,42 @@ bool vl::initializeOpenGL()
   Has_Multitexture = Has_GL_ARB_multitexture || Has_GL_Version_1_3 || Has_GL_Version_3_0 || Has_GL_Version_4_0 || Has_GLES;
   Has_Primitive_Restart = Has_GL_Version_3_1 || Has_GL_Version_4_0;
   Has_Occlusion_Query = Has_GL_ARB_occlusion_query || Has_GL_Version_1_5 || Has_GL_Version_3_0 || Has_GL_Version_4_0;
+  Has_Timer_Query = Has_GL_ARB_timer_query || Has_GL_Version_3_3 || Has_GL_Version_4_0;
   Has_Transform_Feedback = Has_GL_NV_transform_feedback || Has_GL_EXT_transform_feedback || Has_GL_Version_3_0 || Has_GL_Version_4_0;
   Has_glGenerateMipmaps = Has_GL_ARB_framebuffer_object || Has_GL_Version_3_0 || Has_GL_Version_4_0 || Has_GLES_Version_2_0;
   Has_GL_GENERATE_MIPMAP = (Has_GL_SGIS_generate_mipmap && Has_Fixed_Function_Pipeline) || Has_GL_Version_1_4 || Has_GLES_Version_1_1;
   Has_Point_Sprite = Has_GL_NV_point_sprite || Has_GL_ARB_point_sprite || Has_GLSL || Has_GLES_Version_1_1;
   Has_Base_Vertex = Has_GL_Version_3_2 || Has_GL_Version_4_0 || Has_GL_ARB_draw_elements_base_vertex;
   Has_Primitive_Instancing = Has_GL_Version_3_1 || Has_GL_Version_4_0 || Has_GL_ARB_draw_instanced || Has_GL_EXT_draw_instanced;
+  Has_Uniform_Buffer_Object = Has_GL_ARB_uniform_buffer_object || Has_GL_Version_3_1 || Has_GL_Version_4_0;
+  Has_Parallel_Shader_Compile = Has_GL_KHR_parallel_shader_compile || Has_GL_ARB_parallel_shader_compile;
+  Has_Compute_Shader = ( Has_GL_ARB_compute_shader || Has_GL_Version_4_3 ) && glDispatchCompute && glDispatchComputeIndirect;
+  Has_Image_Load_Store = ( Has_GL_ARB_shader_image_load_store || Has_GL_Version_4_2 ) && glBindImageTexture && glMemoryBarrier;
+  Has_Shader_Storage_Buffer = ( Has_GL_ARB_shader_storage_buffer_object || Has_GL_Version_4_3 ) && glMemoryBarrier;
+#if defined(VL_OPENGL)
+  Has_Texture_Storage = ( Has_GL_ARB_texture_storage || Has_GL_Version_4_2 ) && glTexStorage1D && glTexStorage2D && glTexStorage3D;
+  Has_Sampler_Objects = ( Has_GL_ARB_sampler_objects || Has_GL_Version_3_3 ) && glGenSamplers && glDeleteSamplers && glBindSampler && glSamplerParameteri;
+  Has_Conditional_Render = ( ( Has_GL_Version_3_0 || Has_GL_Version_4_0 ) && glBeginConditionalRender && glEndConditionalRender ) ||
+                           ( Has_GL_NV_conditional_render && glBeginConditionalRenderNV && glEndConditionalRenderNV );
+#else
+  Has_Texture_Storage = false;
+  Has_Sampler_Objects = false;
+  Has_Conditional_Render = false;
+#endif
+
+  gInvalidateFramebuffer = NULL;
+#if defined(VL_OPENGL)
+  if ( Has_GL_ARB_invalidate_subdata || Has_GL_Version_4_3 )
+    gInvalidateFramebuffer = (InvalidateFramebufferProc)getGLProcAddress("glInvalidateFramebuffer");
+  Has_Framebuffer_Invalidation = gInvalidateFramebuffer != NULL;
+#elif defined(VL_OPENGL_ES2)
+  // a GLES 2 build can still run on a "OpenGL ES 3.x" context
+  if ( strncmp( version_string, "OpenGL ES ", 10 ) == 0 && version_string[10] >= '3' )
+    gInvalidateFramebuffer = (InvalidateFramebufferProc)getGLProcAddress("glInvalidateFramebuffer");
+  Has_Framebuffer_Invalidation = gInvalidateFramebuffer != NULL || ( Has_GL_EXT_discard_framebuffer && glDiscardFramebufferEXT );
+#elif defined(VL_OPENGL_ES1)
+  Has_Framebuffer_Invalidation = Has_GL_EXT_discard_framebuffer && glDiscardFramebufferEXT;
+#endif
 
   // - - - Resolve supported enables - - -
 
@@ -567,6 +618,8 @@ bool vl::initializeOpenGL()
     #define PRINT_INFO(STRING) printf(#STRING" = %d\n", STRING?1:0)
     PRINT_INFO(Is_OpenGL_Core_Profile);
     PRINT_INFO(Is_OpenGL_Forward_Compatible);
+    PRINT_INFO(Has_GL_Version_4_3);
+    PRINT_INFO(Has_GL_Version_4_2);
     PRINT_INFO(Has_GL_Version_4_1);
     PRINT_INFO(Has_GL_Version_4_0);
     PRINT_INFO(Has_GL_Version_3_3);
@@ -620,6 +673,94 @@ int vl::glcheck(const char* file, int line)
   return glerr;
 }
 //------------------------------------------------------------------------------
+// GL_KHR_debug / GL_ARB_debug_output error reporting
+//------------------------------------------------------------------------------
+#if defined(VL_OPENGL)
+namespace vl
+{
+  // GL_KHR_debug is not in the function list, its entry points have the same signature as the GL_ARB_debug_output ones
+  typedef void (APIENTRY *DebugMessageCallbackProc)( GLDEBUGPROCARB callback, const void* user_param );
+
+  static const GLenum VL_GL_DEBUG_OUTPUT = 0x92E0;
+
+  static bool gGLDebugOutputTrap = false;
+
+  static void APIENTRY glDebugOutputCallback( GLenum /*source*/, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/, const GLchar* message, GLvoid* /*user_param*/ )
+  {
+    if ( type == GL_DEBUG_TYPE_ERROR_ARB )
+    {
+      Log::bug( Say("OpenGL error 0x%hn after [%s:%n]: %s\n") << id << GL_Last_Check_File << GL_Last_Check_Line << message );
+      if ( gGLDebugOutputTrap )
+        VL_TRAP()
+    }
+    else
+    if ( severity == GL_DEBUG_SEVERITY_HIGH_ARB )
+      Log::warning( Say("OpenGL debug output after [%s:%n]: %s\n") << GL_Last_Check_File << GL_Last_Check_Line << message );
+  }
+
+  static DebugMessageCallbackProc getDebugMessageCallback()
+  {
+    if ( Has_GL_Version_4_3 || Has_GL_KHR_debug )
+      return (DebugMessageCallbackProc)getGLProcAddress("glDebugMessageCallback");
+    else
+    if ( Has_GL_ARB_debug_output )
+      return (DebugMessageCallbackProc)glDebugMessageCallbackARB;
+    else
+      return NULL;
+  }
+}
+#endif
+//------------------------------------------------------------------------------
+bool vl::enableGLDebugOutput( bool trap )
+{
+#if defined(VL_OPENGL)
+  DebugMessageCallbackProc debug_message_callback = getDebugMessageCallback();
+  if ( !debug_message_callback )
+    return false;
+
+  // errors pending from before are still reported by glGetError()
+  glcheck( __FILE__, __LINE__ );
+
+  gGLDebugOutputTrap = trap;
+  debug_message_callback( glDebugOutputCallback, NULL );
+  // GL_KHR_debug output must be enabled explicitly on non-debug contexts
+  if ( Has_GL_Version_4_3 || Has_GL_KHR_debug )
+    glEnable( VL_GL_DEBUG_OUTPUT );
+  if ( trap )
+    glEnable( GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB );
+  else
+    glDisable( GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB );
+
+  return Is_GL_Debug_Output_Active = glGetError() == GL_NO_ERROR;
+#else
+  (void)trap;
+  return false;
+#endif
+}
+//------------------------------------------------------------------------------
+void vl::disableGLDebugOutput()
+{
+#if defined(VL_OPENGL)
+  DebugMessageCallbackProc debug_message_callback = getDebugMessageCallback();
+  if ( debug_message_callback )
+    debug_message_callback( NULL, NULL );
+#endif
+  Is_GL_Debug_Output_Active = false;
+}
+//------------------------------------------------------------------------------
+void vl::invalidateFramebuffer( GLenum target, GLsizei count, const GLenum* attachments )
+{
+  if ( !Has_Framebuffer_Invalidation || count == 0 )
+    return;
+
+  if ( gInvalidateFramebuffer )
+    gInvalidateFramebuffer( target, count, attachments );
+#if defined(VL_OPENGL_ES1) || defined(VL_OPENGL_ES2)
+  else
+    glDiscardFramebufferEXT( target, count, attachments );
+#endif
+}
+//------------------------------------------------------------------------------
 // vl::getGLProcAddress() implementation based on GLEW's
 //------------------------------------------------------------------------------
 #if defined(VL_OPENGL_ES1) || defined(VL_OPENGL_ES2)
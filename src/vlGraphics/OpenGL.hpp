@@ -79,6 +79,8 @@ namespace vl
   VLGRAPHICS_EXPORT extern bool Has_GL_Version_3_3;
   VLGRAPHICS_EXPORT extern bool Has_GL_Version_4_0;
   VLGRAPHICS_EXPORT extern bool Has_GL_Version_4_1;
+  VLGRAPHICS_EXPORT extern bool Has_GL_Version_4_2;
+  VLGRAPHICS_EXPORT extern bool Has_GL_Version_4_3;
 
   // Helper variables
 
@@ -104,12 +106,26 @@ namespace vl
   VLGRAPHICS_EXPORT extern bool Has_Multitexture;
   VLGRAPHICS_EXPORT extern bool Has_Primitive_Restart;
   VLGRAPHICS_EXPORT extern bool Has_Occlusion_Query;
+  VLGRAPHICS_EXPORT extern bool Has_Timer_Query;
   VLGRAPHICS_EXPORT extern bool Has_Transform_Feedback;
   VLGRAPHICS_EXPORT extern bool Has_glGenerateMipmaps;
   VLGRAPHICS_EXPORT extern bool Has_GL_GENERATE_MIPMAP;
   VLGRAPHICS_EXPORT extern bool Has_Point_Sprite;
   VLGRAPHICS_EXPORT extern bool Has_Base_Vertex;
   VLGRAPHICS_EXPORT extern bool Has_Primitive_Instancing;
+  VLGRAPHICS_EXPORT extern bool Has_Uniform_Buffer_Object;
+  VLGRAPHICS_EXPORT extern bool Has_Parallel_Shader_Compile;
+  VLGRAPHICS_EXPORT extern bool Has_Compute_Shader;
+  VLGRAPHICS_EXPORT extern bool Has_Shader_Storage_Buffer;
+  VLGRAPHICS_EXPORT extern bool Has_Image_Load_Store;
+  //! glTexStorage*() is available (GL 4.2 or GL_ARB_texture_storage), see Texture::setImmutableStorage().
+  VLGRAPHICS_EXPORT extern bool Has_Texture_Storage;
+  //! Sampler objects are available (GL 3.3 or GL_ARB_sampler_objects), see OpenGLContext::setSamplerObjectsEnabled().
+  VLGRAPHICS_EXPORT extern bool Has_Sampler_Objects;
+  //! glBeginConditionalRender() is available (GL 3.0 or GL_NV_conditional_render), see OcclusionCullRenderer::setConditionalRendering().
+  VLGRAPHICS_EXPORT extern bool Has_Conditional_Render;
+  //! glInvalidateFramebuffer() or glDiscardFramebufferEXT() is available, see vl::invalidateFramebuffer().
+  VLGRAPHICS_EXPORT extern bool Has_Framebuffer_Invalidation;
 
   #define VL_EXTENSION(extension) VLGRAPHICS_EXPORT extern bool Has_##extension;
   #include <vlGraphics/GL/GLExtensionList.hpp>
@@ -152,8 +168,31 @@ namespace vl
 
   VLGRAPHICS_EXPORT int glcheck( const char* file, int line );
 
+  //! Routes the OpenGL errors of the current context through GL_KHR_debug or GL_ARB_debug_output: the debug message callback
+  //! logs them with Log::bug() together with the last VL_CHECK_OGL() location and VL_CHECK_OGL() stops calling glGetError().
+  //! If \p trap is true the messages are generated synchronously and VL_TRAP() is called inside the failing OpenGL call,
+  //! otherwise the driver is free to report them asynchronously, which is faster.
+  //! Returns false if neither extension is available, see also GlobalSettings::setOpenGLErrorCheck().
+  VLGRAPHICS_EXPORT bool enableGLDebugOutput( bool trap );
+
+  //! Removes the debug message callback installed by enableGLDebugOutput() from the current context, VL_CHECK_OGL() goes back to glGetError().
+  VLGRAPHICS_EXPORT void disableGLDebugOutput();
+
+  //! Tells the driver that the contents of the given \p attachments of the framebuffer bound to \p target are no longer needed using
+  //! glInvalidateFramebuffer() (GL 4.3, GL_ARB_invalidate_subdata, GLES 3.0) or glDiscardFramebufferEXT() (GL_EXT_discard_framebuffer).
+  //! On tile-based GPUs this saves the store of the tile memory to the framebuffer and the load back at the next pass.
+  //! Does nothing if Has_Framebuffer_Invalidation is false, see also Framebuffer::invalidate().
+  VLGRAPHICS_EXPORT void invalidateFramebuffer( GLenum target, GLsizei count, const GLenum* attachments );
+
+  //! True if the OpenGL errors are reported by the debug output, see enableGLDebugOutput().
+  VLGRAPHICS_EXPORT extern bool Is_GL_Debug_Output_Active;
+
+  //! Location of the last VL_CHECK_OGL() executed while the debug output is active, used to give a context to the reported errors.
+  VLGRAPHICS_EXPORT extern const char* GL_Last_Check_File;
+  VLGRAPHICS_EXPORT extern int GL_Last_Check_Line;
+
   #if defined( _DEBUG ) || !defined( NDEBUG ) || VL_FORCE_CHECKS == 1
-    #define VL_CHECK_OGL( ) { if ( ::vl::glcheck( __FILE__, __LINE__ ) ) { VL_TRAP( ) } }
+    #define VL_CHECK_OGL( ) { if ( ::vl::Is_GL_Debug_Output_Active ) { ::vl::GL_Last_Check_File = __FILE__; ::vl::GL_Last_Check_Line = __LINE__; } else if ( ::vl::glcheck( __FILE__, __LINE__ ) ) { VL_TRAP( ) } }
   #else
     #define VL_CHECK_OGL( );
   #endif
@@ -34,6 +34,7 @@
 #include <vlGraphics/OpenGL.hpp>
 #include <vlGraphics/IVertexAttribSet.hpp>
 #include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Texture.hpp>
 #include <vlGraphics/GLSL.hpp>
 #include <vlGraphics/Light.hpp>
 #include <vlGraphics/ClipPlane.hpp>
@@ -52,6 +53,13 @@ OpenGLContext* UIEventListener::openglContext() { return mOpenGLContext; }
 //-----------------------------------------------------------------------------
 // OpenGLContext
 //-----------------------------------------------------------------------------
+namespace
+{
+  // unique across all the contexts since a deleted context can be reallocated at the same address,
+  // see OpenGLContext::samplerObject()
+  unsigned int gSamplerGeneration = 0;
+}
+//-----------------------------------------------------------------------------
 OpenGLContext::OpenGLContext(int w, int h)
 {
   VL_DEBUG_SET_OBJECT_NAME()
@@ -59,12 +67,22 @@ OpenGLContext::OpenGLContext(int w, int h)
   mRightFramebuffer = new Framebuffer(this, w, h, RDB_BACK_RIGHT, RDB_BACK_RIGHT);
 
   mDefaultVAO = 0;
+  mCurrentVAO = 0;
+  mVAOEnabled = false;
+  mVAOCacheTick = 0;
+
+  mSamplerGeneration = ++gSamplerGeneration;
+  mSamplerObjectsEnabled = false;
+  memset( mSamplerBinding, 0, sizeof(mSamplerBinding) );
 
   // set to unknown texture target
   memset( mTexUnitBinding, 0, sizeof(mTexUnitBinding) );
 
-  mCurrentEnableSet = new NaryQuickMap<EEnable, EEnable, EN_EnableCount>;
-  mNewEnableSet = new NaryQuickMap<EEnable, EEnable, EN_EnableCount>;
+  mCurrentEnableMask = 0;
+  mRenderRawDepth = 0;
+  mConcurrentRendering = false;
+  mScissorEnabled = false;
+  mScissorBox = RectI(0,0,0,0);
 
   mCurrentRenderStateSet = new NaryQuickMap<ERenderState, RenderStateSlot, RS_RenderStateCount>;
   mNewRenderStateSet = new NaryQuickMap<ERenderState, RenderStateSlot, RS_RenderStateCount>;
@@ -85,6 +103,13 @@ OpenGLContext::OpenGLContext(int w, int h)
 
   mMouseVisible = true;
   mContinuousUpdate = true;
+  mUpdateOnDemand = false;
+  mUpdateTick = -1;
+  mInputEventCoalescing = false;
+  mPendingMouseMove = false;
+  mPendingMouseX = 0;
+  mPendingMouseY = 0;
+  mPendingMouseWheel = 0;
   mIgnoreNextMouseMoveEvent = false;
   mFullscreen = false;
 }
@@ -121,12 +146,26 @@ void OpenGLContext::destroyFramebufferObject(FramebufferObject* fbort)
   }
 }
 //-----------------------------------------------------------------------------
+RenderTargetPool* OpenGLContext::renderTargetPool()
+{
+  if ( !mRenderTargetPool )
+    mRenderTargetPool = new RenderTargetPool(this);
+  return mRenderTargetPool.get();
+}
+//-----------------------------------------------------------------------------
 void OpenGLContext::destroyAllOpenGLResources()
 {
   if ( mIsInitialized ) {
     mIsInitialized = false;
     makeCurrent();
+    if ( mRenderTargetPool )
+    {
+      mRenderTargetPool->clear();
+      mRenderTargetPool = NULL;
+    }
     destroyAllFramebufferObjects();
+    deleteVAOCache();
+    deleteSamplerObjects();
     mLeftFramebuffer->mOpenGLContext = NULL;
     mRightFramebuffer->mOpenGLContext = NULL;
     mLeftFramebuffer = NULL;
@@ -135,8 +174,7 @@ void OpenGLContext::destroyAllOpenGLResources()
     {
       mDefaultRenderStates[i].mRS = NULL;
     }
-    mCurrentEnableSet = NULL;
-    mNewEnableSet = NULL;
+    mCurrentEnableMask = 0;
     mCurrentRenderStateSet = NULL;
     mNewRenderStateSet = NULL;
     mGLSLProgram = NULL;
@@ -247,7 +285,15 @@ bool OpenGLContext::initGLContext(bool log)
 
   mExtensions = getOpenGLExtensions();
 
-  if (log)
+  // report the errors through the debug output instead of polling glGetError()
+  if ( globalSettings()->openGLErrorCheck() != GEC_GET_ERROR )
+  {
+    if ( !enableGLDebugOutput( globalSettings()->openGLErrorCheck() == GEC_DEBUG_OUTPUT_TRAP ) )
+      Log::warning("OpenGLContext::initGLContext(): GL_KHR_debug and GL_ARB_debug_output not supported, using glGetError().\n");
+  }
+
+  // the OpenGL info is logged only at debug verbosity, querying and formatting it slows down the startup
+  if (log && globalSettings()->verbosityLevel() >= vl::VEL_VERBOSITY_DEBUG)
     logOpenGLInfo();
 
   VL_CHECK_OGL();
@@ -286,6 +332,7 @@ bool OpenGLContext::initGLContext(bool log)
     glGenVertexArrays( 1, &mDefaultVAO ); VL_CHECK_OGL();
     glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
   }
+  mCurrentVAO = mDefaultVAO;
 
   VL_CHECK_OGL();
 
@@ -506,43 +553,52 @@ void OpenGLContext::logOpenGLInfo()
 void OpenGLContext::applyEnables( const EnableSet* new_enables )
 {
   VL_CHECK_OGL()
+  VL_COMPILE_TIME_CHECK( EN_EnableCount <= 64 )
 
-  mNewEnableSet->clear();
+  u64 new_mask = new_enables ? new_enables->enableMask() : 0;
 
-  if (new_enables)
+  // visit only the capabilities whose state changed
+  u64 delta = new_mask ^ mCurrentEnableMask;
+  for( int capability=0; delta; ++capability, delta >>= 1 )
   {
-    for( size_t i=0; i<new_enables->enables().size(); ++i )
+    if ( !(delta & 1) )
+      continue;
+
+    ++mRenderStats.mEnableChanges;
+
+    if ( new_mask & ((u64)1 << capability) )
     {
-      const EEnable& capability = new_enables->enables()[i];
-      mNewEnableSet->append(capability);
-      if(!mCurrentEnableSet->hasKey(capability))
-      {
-        glEnable( Translate_Enable[capability] );
-        #ifndef NDEBUG
-          if (glGetError() != GL_NO_ERROR)
-          {
-            Log::error( Say("An unsupported capability has been enabled: %s.\n") << Translate_Enable_String[capability]);
-          }
-        #endif
-      }
+      glEnable( Translate_Enable[capability] );
+      #ifndef NDEBUG
+        if (!Is_GL_Debug_Output_Active && glGetError() != GL_NO_ERROR)
+        {
+          Log::error( Say("An unsupported capability has been enabled: %s.\n") << Translate_Enable_String[capability]);
+        }
+      #endif
     }
-  }
-
-  for(EEnable* capability = mCurrentEnableSet->begin(); capability != mCurrentEnableSet->end(); ++capability)
-  {
-    if (!mNewEnableSet->hasKey(*capability))
+    else
     {
-      glDisable( Translate_Enable[*capability] );
+      glDisable( Translate_Enable[capability] );
       #ifndef NDEBUG
-        if (glGetError() != GL_NO_ERROR)
+        if (!Is_GL_Debug_Output_Active && glGetError() != GL_NO_ERROR)
         {
-          Log::error( Say("An unsupported capability has been disabled: %s.\n") << Translate_Enable_String[*capability]);
+          Log::error( Say("An unsupported capability has been disabled: %s.\n") << Translate_Enable_String[capability]);
         }
       #endif
     }
   }
 
-  std::swap(mNewEnableSet, mCurrentEnableSet);
+  mCurrentEnableMask = new_mask;
+}
+//------------------------------------------------------------------------------
+namespace
+{
+  inline void countRenderState( RenderStats& stats, ERenderState type )
+  {
+    ++stats.mRenderStateChanges;
+    if ( type >= RS_TextureSampler && type < RS_TexGen )
+      ++stats.mTextureBinds;
+  }
 }
 //------------------------------------------------------------------------------
 // MIC FIXME: `camera` can also be taken away
@@ -558,10 +614,11 @@ void OpenGLContext::applyRenderStates( const RenderStateSet* new_rs, const Camer
     {
       const RenderStateSlot& rs = new_rs->renderStates()[i];
       mNewRenderStateSet->append(rs.type(), rs);
-      if ( ! mCurrentRenderStateSet->hasKey(rs.type()) || rs.mRS.get() != mCurrentRenderStateSet->valueFromKey( rs.type() ).mRS.get() )
+      if ( ! mCurrentRenderStateSet->hasKey(rs.type()) || ! rs.isEquivalent( mCurrentRenderStateSet->valueFromKey( rs.type() ) ) )
       {
         VL_CHECK(rs.mRS.get());
         rs.apply(camera, this); VL_CHECK_OGL()
+        countRenderState( mRenderStats, rs.type() );
       }
     }
   }
@@ -571,12 +628,54 @@ void OpenGLContext::applyRenderStates( const RenderStateSet* new_rs, const Camer
     if ( ! mNewRenderStateSet->hasKey( rs->type() ) )
     {
       mDefaultRenderStates[rs->type()].apply(NULL, this); VL_CHECK_OGL()
+      countRenderState( mRenderStats, rs->type() );
     }
   }
 
   std::swap(mNewRenderStateSet, mCurrentRenderStateSet);
 }
 //------------------------------------------------------------------------------
+const RenderState* OpenGLContext::currentRenderState(ERenderState type) const
+{
+  if ( mCurrentRenderStateSet->hasKey(type) )
+    return mCurrentRenderStateSet->valueFromKey(type).mRS.get();
+  else
+    return mDefaultRenderStates[type].mRS.get();
+}
+//------------------------------------------------------------------------------
+bool OpenGLContext::currentDepthMask() const
+{
+  const RenderState* rs = currentRenderState(RS_DepthMask);
+  return rs ? rs->as<DepthMask>()->depthMask() : true;
+}
+//------------------------------------------------------------------------------
+ubvec4 OpenGLContext::currentColorMask() const
+{
+  const RenderState* rs = currentRenderState(RS_ColorMask);
+  if (!rs)
+    return ubvec4(1,1,1,1);
+  const ColorMask* mask = rs->as<ColorMask>();
+  return ubvec4(mask->red(), mask->green(), mask->blue(), mask->alpha());
+}
+//------------------------------------------------------------------------------
+void OpenGLContext::currentStencilMask(unsigned int& front, unsigned int& back) const
+{
+  const RenderState* rs = currentRenderState(RS_StencilMask);
+  front = rs ? rs->as<StencilMask>()->mask_Front() : ~(unsigned int)0;
+  back  = rs ? rs->as<StencilMask>()->mask_Back()  : ~(unsigned int)0;
+}
+//------------------------------------------------------------------------------
+void OpenGLContext::countGLQuery(const char* query)
+{
+  if (mRenderRawDepth == 0)
+    return;
+  ++mRenderStats.mGLQueries;
+#ifndef NDEBUG
+  if ( mReportedGLQueries.insert(query).second )
+    Log::debug( Say("OpenGLContext: synchronous glGet(%s) issued while rendering.\n") << query );
+#endif
+}
+//------------------------------------------------------------------------------
 void OpenGLContext::setupDefaultRenderStates()
 {
   if ( Has_Fixed_Function_Pipeline )
@@ -655,6 +754,18 @@ void OpenGLContext::setupDefaultRenderStates()
     mDefaultRenderStates[RS_TextureSampler + i] = RenderStateSlot(new TextureSampler, i);
   }
 
+  if ( Has_Shader_Storage_Buffer )
+  {
+    for(int i=0; i<VL_MAX_SHADER_STORAGE_BUFFER_BINDINGS; ++i)
+      mDefaultRenderStates[RS_ShaderStorageBuffer + i] = RenderStateSlot(new ShaderStorageBuffer, i);
+  }
+
+  if ( Has_Image_Load_Store )
+  {
+    for(int i=0; i<VL_MAX_IMAGE_UNITS; ++i)
+      mDefaultRenderStates[RS_ImageUnit + i] = RenderStateSlot(new ImageUnit, i);
+  }
+
   if( Has_Fixed_Function_Pipeline )
   {
     for(int i=0; i<textureCoordCount(); ++i)
@@ -689,7 +800,7 @@ void OpenGLContext::resetRenderStates()
 //-----------------------------------------------------------------------------
 void OpenGLContext::resetEnables()
 {
-  mCurrentEnableSet->clear();
+  mCurrentEnableMask = 0;
 }
 //------------------------------------------------------------------------------
 bool OpenGLContext::isCleanState(bool verbose)
@@ -1230,15 +1341,10 @@ bool OpenGLContext::areUniformsColliding(const UniformSet* u1, const UniformSet*
   if (!u1 || !u2)
     return false;
 
-  // compile the map
-  std::set<std::string> name_set;
-  for( size_t i=0; i<u1->uniforms().size(); ++i )
-    name_set.insert( u1->uniforms()[i]->name() );
-
   bool ok = false;
-  // check the map
+  // u1's name index makes the check linear in the size of u2
   for( size_t j=0; j<u2->uniforms().size(); ++j )
-    if ( name_set.find( u2->uniforms()[j]->name() ) != name_set.end() )
+    if ( u1->getUniformByNameID( u2->uniforms()[j]->nameID() ) )
     {
       vl::Log::error( Say("Uniform name collision detected: %s\n") << u2->uniforms()[j]->name() );
       ok = true;
@@ -1282,9 +1388,14 @@ void OpenGLContext::resetContextStates(EResetContextStates start_or_finish)
     resetEnables();
     resetRenderStates();
 
+    // the VAOs of the IVertexAttribSet[s] not rendered for a while are deleted
+    if ( ( ++mVAOCacheTick & 63 ) == 0 && ! mVAOCache.empty() )
+      evictVAOCache( 64 );
+
     // default VAO needed for OpenGL Core profiles
     if ( Is_OpenGL_Core_Profile && mDefaultVAO && glGenVertexArrays && glBindVertexArray ) {
        glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
+       mCurrentVAO = mDefaultVAO;
     }
 
     // reset Vertex Attrib Set tables and also calls "glBindBuffer(GL_ARRAY_BUFFER, 0)"
@@ -1292,9 +1403,32 @@ void OpenGLContext::resetContextStates(EResetContextStates start_or_finish)
   }
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  // Computes the buffer object, pointer (or offset) and stride used to source the given array
+  inline void getArrayPointer(const ArrayAbstract* arr, bool use_bo, int& buf_obj, const unsigned char*& ptr, int& stride)
+  {
+    const BufferObject* bo = arr->interleavedBufferObject() ? arr->interleavedBufferObject() : arr->bufferObject();
+    int offset = arr->interleavedBufferObject() ? arr->interleavedOffset() : 0;
+    stride = arr->interleavedBufferObject() ? arr->interleavedStride() : 0;
+    if ( use_bo && bo->handle() )
+    {
+      buf_obj = bo->handle();
+      // the offset of the data within the buffer is non zero if it's sub-allocated from a BufferObjectPool
+      ptr = (const unsigned char*)0 + bo->byteOffsetBufferObject() + offset;
+    }
+    else
+    {
+      buf_obj = 0;
+      ptr = bo->ptr() ? bo->ptr() + offset : NULL;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   int buf_obj = 0;
   const unsigned char* ptr = 0;
+  int stride = 0;
   bool enabled = false;
 
   // ----- vertex array -----
@@ -1304,17 +1438,8 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   {
     if (enabled)
     {
-      if ( use_bo && vas->vertexArray()->bufferObject()->handle() )
-      {
-        buf_obj = vas->vertexArray()->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = vas->vertexArray()->bufferObject()->ptr();
-      }
-      if ( mVertexArray.mPtr != ptr || mVertexArray.mBufferObject != buf_obj )
+      getArrayPointer( vas->vertexArray(), use_bo, buf_obj, ptr, stride );
+      if ( mVertexArray.mPtr != ptr || mVertexArray.mBufferObject != buf_obj || mVertexArray.mStride != stride )
       {
         if (!mVertexArray.mEnabled)
         {
@@ -1325,9 +1450,11 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
         // In the future we'll want to eliminate all direct calls to glBindBuffer and similar an
         // go through the OpenGLContext that will lazily do everything.
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glVertexPointer((int)vas->vertexArray()->glSize(), vas->vertexArray()->glType(), /*stride*/0, ptr); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glVertexPointer((int)vas->vertexArray()->glSize(), vas->vertexArray()->glType(), stride, ptr); VL_CHECK_OGL();
         mVertexArray.mPtr = ptr;
         mVertexArray.mBufferObject = buf_obj;
+        mVertexArray.mStride = stride;
       }
     }
     else
@@ -1346,26 +1473,19 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   {
     if (enabled)
     {
-      if ( use_bo && vas->normalArray()->bufferObject()->handle() )
-      {
-        buf_obj = vas->normalArray()->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = vas->normalArray()->bufferObject()->ptr();
-      }
-      if ( mNormalArray.mPtr != ptr || mNormalArray.mBufferObject != buf_obj )
+      getArrayPointer( vas->normalArray(), use_bo, buf_obj, ptr, stride );
+      if ( mNormalArray.mPtr != ptr || mNormalArray.mBufferObject != buf_obj || mNormalArray.mStride != stride )
       {
         if (!mNormalArray.mEnabled)
         {
           glEnableClientState(GL_NORMAL_ARRAY); VL_CHECK_OGL();
         }
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glNormalPointer(vas->normalArray()->glType(), /*stride*/0, ptr); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glNormalPointer(vas->normalArray()->glType(), stride, ptr); VL_CHECK_OGL();
         mNormalArray.mPtr = ptr;
         mNormalArray.mBufferObject = buf_obj;
+        mNormalArray.mStride = stride;
       }
     }
     else
@@ -1388,26 +1508,19 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   {
     if (enabled)
     {
-      if ( use_bo && vas->colorArray()->bufferObject()->handle() )
-      {
-        buf_obj = vas->colorArray()->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = vas->colorArray()->bufferObject()->ptr();
-      }
-      if ( mColorArray.mPtr != ptr || mColorArray.mBufferObject != buf_obj )
+      getArrayPointer( vas->colorArray(), use_bo, buf_obj, ptr, stride );
+      if ( mColorArray.mPtr != ptr || mColorArray.mBufferObject != buf_obj || mColorArray.mStride != stride )
       {
         if (!mColorArray.mEnabled)
         {
           glEnableClientState(GL_COLOR_ARRAY); VL_CHECK_OGL();
         }
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glColorPointer((int)vas->colorArray()->glSize(), vas->colorArray()->glType(), /*stride*/0, ptr); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glColorPointer((int)vas->colorArray()->glSize(), vas->colorArray()->glType(), stride, ptr); VL_CHECK_OGL();
         mColorArray.mPtr = ptr;
         mColorArray.mBufferObject = buf_obj;
+        mColorArray.mStride = stride;
       }
     }
     else
@@ -1430,26 +1543,19 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   {
     if (enabled)
     {
-      if ( use_bo && vas->secondaryColorArray()->bufferObject()->handle() )
-      {
-        buf_obj = vas->secondaryColorArray()->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = vas->secondaryColorArray()->bufferObject()->ptr();
-      }
-      if ( mSecondaryColorArray.mPtr != ptr || mSecondaryColorArray.mBufferObject != buf_obj )
+      getArrayPointer( vas->secondaryColorArray(), use_bo, buf_obj, ptr, stride );
+      if ( mSecondaryColorArray.mPtr != ptr || mSecondaryColorArray.mBufferObject != buf_obj || mSecondaryColorArray.mStride != stride )
       {
         if (!mSecondaryColorArray.mEnabled)
         {
           glEnableClientState(GL_SECONDARY_COLOR_ARRAY); VL_CHECK_OGL();
         }
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glSecondaryColorPointer((int)vas->secondaryColorArray()->glSize(), vas->secondaryColorArray()->glType(), /*stride*/0, ptr); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glSecondaryColorPointer((int)vas->secondaryColorArray()->glSize(), vas->secondaryColorArray()->glType(), stride, ptr); VL_CHECK_OGL();
         mSecondaryColorArray.mPtr = ptr;
         mSecondaryColorArray.mBufferObject = buf_obj;
+        mSecondaryColorArray.mStride = stride;
       }
     }
     else
@@ -1472,26 +1578,19 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
   {
     if (enabled)
     {
-      if ( use_bo && vas->fogCoordArray()->bufferObject()->handle() )
-      {
-        buf_obj = vas->fogCoordArray()->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = vas->fogCoordArray()->bufferObject()->ptr();
-      }
-      if ( mFogArray.mPtr != ptr || mFogArray.mBufferObject != buf_obj )
+      getArrayPointer( vas->fogCoordArray(), use_bo, buf_obj, ptr, stride );
+      if ( mFogArray.mPtr != ptr || mFogArray.mBufferObject != buf_obj || mFogArray.mStride != stride )
       {
         if (!mFogArray.mEnabled)
         {
           glEnableClientState(GL_FOG_COORD_ARRAY); VL_CHECK_OGL();
         }
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glFogCoordPointer(vas->fogCoordArray()->glType(), /*stride*/0, ptr); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glFogCoordPointer(vas->fogCoordArray()->glType(), stride, ptr); VL_CHECK_OGL();
         mFogArray.mPtr = ptr;
         mFogArray.mBufferObject = buf_obj;
+        mFogArray.mStride = stride;
       }
     }
     else
@@ -1525,23 +1624,16 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
         mTexCoordArray[tex_coord_i].mEnabled = 1;
       }
 
-      if ( use_bo && texarr->bufferObject()->handle() )
-      {
-        buf_obj = texarr->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = texarr->bufferObject()->ptr();
-      }
-      if ( mTexCoordArray[tex_coord_i].mPtr != ptr || mTexCoordArray[tex_coord_i].mBufferObject != buf_obj )
+      getArrayPointer( texarr, use_bo, buf_obj, ptr, stride );
+      if ( mTexCoordArray[tex_coord_i].mPtr != ptr || mTexCoordArray[tex_coord_i].mBufferObject != buf_obj || mTexCoordArray[tex_coord_i].mStride != stride )
       {
         mTexCoordArray[tex_coord_i].mPtr = ptr;
         mTexCoordArray[tex_coord_i].mBufferObject = buf_obj;
+        mTexCoordArray[tex_coord_i].mStride = stride;
 
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
-        glTexCoordPointer((int)texarr->glSize(), texarr->glType(), 0/*texarr->stride()*/, ptr/*+ texarr->offset()*/); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
+        glTexCoordPointer((int)texarr->glSize(), texarr->glType(), stride, ptr); VL_CHECK_OGL();
       }
     }
   }
@@ -1550,6 +1642,7 @@ void OpenGLContext::bindVAS_Fixed(const IVertexAttribSet* vas, bool use_bo) {
 void OpenGLContext::bindVAS_Attribs(const IVertexAttribSet* vas, bool use_bo) {
   int buf_obj = 0;
   const unsigned char* ptr = 0;
+  int stride = 0;
 
   for(int idx=0; idx<vertexAttribCount(); ++idx)
   {
@@ -1587,46 +1680,248 @@ void OpenGLContext::bindVAS_Attribs(const IVertexAttribSet* vas, bool use_bo) {
         glGetVertexAttribiv( idx, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled); VL_CHECK(enabled);
       #endif
 
-      if ( use_bo && arr->bufferObject()->handle() )
-      {
-        buf_obj = arr->bufferObject()->handle();
-        ptr = 0;
-      }
-      else
-      {
-        buf_obj = 0;
-        ptr = arr->bufferObject()->ptr();
-      }
-      if ( mVertexAttrib[idx].mPtr != ptr || mVertexAttrib[idx].mBufferObject != buf_obj )
+      getArrayPointer( arr, use_bo, buf_obj, ptr, stride );
+      if ( mVertexAttrib[idx].mPtr != ptr || mVertexAttrib[idx].mBufferObject != buf_obj || mVertexAttrib[idx].mStride != stride )
       {
         mVertexAttrib[idx].mPtr = ptr;
         mVertexAttrib[idx].mBufferObject = buf_obj;
+        mVertexAttrib[idx].mStride = stride;
         VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
+        ++mRenderStats.mBufferBinds;
 
         if ( arr->interpretation() == VAI_NORMAL )
         {
-          VL_glVertexAttribPointer( idx, (int)arr->glSize(), arr->glType(), arr->normalize(), /*stride*/0, ptr ); VL_CHECK_OGL();
+          VL_glVertexAttribPointer( idx, (int)arr->glSize(), arr->glType(), arr->normalize(), stride, ptr ); VL_CHECK_OGL();
         }
         else
         if ( arr->interpretation() == VAI_INTEGER )
         {
-          VL_glVertexAttribIPointer( idx, (int)arr->glSize(), arr->glType(), /*stride*/0, ptr ); VL_CHECK_OGL();
+          VL_glVertexAttribIPointer( idx, (int)arr->glSize(), arr->glType(), stride, ptr ); VL_CHECK_OGL();
         }
         else
         if ( arr->interpretation() == VAI_DOUBLE )
         {
-          VL_glVertexAttribLPointer( idx, (int)arr->glSize(), arr->glType(), /*stride*/0, ptr ); VL_CHECK_OGL();
+          VL_glVertexAttribLPointer( idx, (int)arr->glSize(), arr->glType(), stride, ptr ); VL_CHECK_OGL();
         }
       }
     }
   }
 }
 //-----------------------------------------------------------------------------
+void OpenGLContext::setVAOEnabled(bool enable)
+{
+  if ( enable && !( glGenVertexArrays && glBindVertexArray && glDeleteVertexArrays ) )
+  {
+    Log::error("OpenGLContext::setVAOEnabled(): Vertex Array Objects not supported.\n");
+    enable = false;
+  }
+  if ( mVAOEnabled != enable )
+  {
+    mVAOEnabled = enable;
+    mCurVAS = NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+void OpenGLContext::deleteVAOCache()
+{
+  if ( mVAOCache.empty() )
+    return;
+
+  if ( mCurrentVAO != mDefaultVAO ) {
+    glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
+    mCurrentVAO = mDefaultVAO;
+  }
+
+  for( std::map<long long, VAOInfo>::iterator it = mVAOCache.begin(); it != mVAOCache.end(); ++it ) {
+    glDeleteVertexArrays( 1, &it->second.mVAO ); VL_CHECK_OGL();
+  }
+
+  mVAOCache.clear();
+  mCurVAS = NULL;
+}
+//-----------------------------------------------------------------------------
+void OpenGLContext::evictVAOCache(unsigned int max_unused)
+{
+  for( std::map<long long, VAOInfo>::iterator it = mVAOCache.begin(); it != mVAOCache.end(); )
+  {
+    if ( mVAOCacheTick - it->second.mLastUsed > max_unused )
+    {
+      if ( mCurrentVAO == it->second.mVAO ) {
+        glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
+        mCurrentVAO = mDefaultVAO;
+        mCurVAS = NULL;
+      }
+      glDeleteVertexArrays( 1, &it->second.mVAO ); VL_CHECK_OGL();
+      mVAOCache.erase( it++ );
+    }
+    else
+      ++it;
+  }
+}
+//-----------------------------------------------------------------------------
+void OpenGLContext::setSamplerObjectsEnabled(bool enable)
+{
+  if ( enable && !Has_Sampler_Objects )
+  {
+    Log::error("OpenGLContext::setSamplerObjectsEnabled(): sampler objects not supported.\n");
+    enable = false;
+  }
+  mSamplerObjectsEnabled = enable;
+}
+//-----------------------------------------------------------------------------
+unsigned int OpenGLContext::samplerObject(const TexParameter* tp)
+{
+  VL_CHECK(Has_Sampler_Objects)
+
+  if ( tp->mSamplerContext == this && tp->mSamplerGeneration == mSamplerGeneration )
+    return tp->mSampler;
+
+  SamplerKey key;
+  memset( &key, 0, sizeof(key) ); // memcmp() compares the padding too
+  key.mState[0] = tp->minFilter();
+  key.mState[1] = tp->magFilter();
+  key.mState[2] = tp->wrapS();
+  key.mState[3] = tp->wrapT();
+  key.mState[4] = tp->wrapR();
+  key.mState[5] = tp->compareMode();
+  key.mState[6] = tp->compareFunc();
+  memcpy( key.mBorder, tp->borderColor().ptr(), sizeof(key.mBorder) );
+  key.mAnisotropy = tp->anisotropy();
+
+  unsigned int& sampler = mSamplerObjects[key];
+  if ( ! sampler )
+  {
+#if defined(VL_OPENGL)
+    glGenSamplers( 1, &sampler ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_MIN_FILTER, tp->minFilter() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_MAG_FILTER, tp->magFilter() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_S, tp->wrapS() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_T, tp->wrapT() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_WRAP_R, tp->wrapR() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_COMPARE_MODE, tp->compareMode() ); VL_CHECK_OGL();
+    glSamplerParameteri( sampler, GL_TEXTURE_COMPARE_FUNC, tp->compareFunc() ); VL_CHECK_OGL();
+    glSamplerParameterfv( sampler, GL_TEXTURE_BORDER_COLOR, key.mBorder ); VL_CHECK_OGL();
+    if ( Has_GL_EXT_texture_filter_anisotropic ) {
+      glSamplerParameterf( sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, key.mAnisotropy ); VL_CHECK_OGL();
+    }
+#endif
+  }
+
+  tp->mSamplerContext = this;
+  tp->mSamplerGeneration = mSamplerGeneration;
+  tp->mSampler = sampler;
+  return sampler;
+}
+//-----------------------------------------------------------------------------
+void OpenGLContext::deleteSamplerObjects()
+{
+  // invalidates the sampler objects cached by the TexParameters
+  mSamplerGeneration = ++gSamplerGeneration;
+
+  if ( mSamplerObjects.empty() )
+    return;
+
+#if defined(VL_OPENGL)
+  for( int i=0; i<VL_MAX_TEXTURE_IMAGE_UNITS; ++i ) {
+    if ( mSamplerBinding[i] ) {
+      glBindSampler( i, 0 ); VL_CHECK_OGL();
+      mSamplerBinding[i] = 0;
+    }
+  }
+
+  for( std::map<SamplerKey, unsigned int>::iterator it = mSamplerObjects.begin(); it != mSamplerObjects.end(); ++it ) {
+    glDeleteSamplers( 1, &it->second ); VL_CHECK_OGL();
+  }
+#endif
+
+  mSamplerObjects.clear();
+}
+//-----------------------------------------------------------------------------
+void OpenGLContext::bindVAS_VAO(const IVertexAttribSet* vas, bool use_bo)
+{
+  VAOInfo& vao = mVAOCache[vas->vertexAttribSetUID()];
+  vao.mLastUsed = mVAOCacheTick;
+
+  if ( ! vao.mVAO ) {
+    glGenVertexArrays( 1, &vao.mVAO ); VL_CHECK_OGL();
+  }
+
+  if ( mCurrentVAO != vao.mVAO ) {
+    glBindVertexArray( vao.mVAO ); VL_CHECK_OGL();
+    mCurrentVAO = vao.mVAO;
+  }
+
+  // update only the attributes that changed since the VAO was last set up
+  for(int idx=0; idx<vertexAttribCount(); ++idx)
+  {
+    const ArrayAbstract* arr = vas->vertexAttribArray(idx);
+    VAOAttribInfo& attr = vao.mAttrib[idx];
+
+    if ( ! arr )
+    {
+      if ( attr.mArray ) {
+        VL_glDisableVertexAttribArray( idx ); VL_CHECK_OGL();
+        attr = VAOAttribInfo();
+        // restore constant vertex attrib
+        glVertexAttrib4fv( idx, mVertexAttribValue[idx].ptr() ); VL_CHECK_OGL();
+      }
+      continue;
+    }
+
+    int buf_obj = 0;
+    const unsigned char* ptr = 0;
+    int stride = 0;
+    getArrayPointer( arr, use_bo, buf_obj, ptr, stride );
+
+    if ( attr.mArray == arr && attr.mBufferObject == buf_obj && attr.mPtr == ptr && attr.mStride == stride &&
+         attr.mSize == (int)arr->glSize() && attr.mType == arr->glType() &&
+         attr.mInterpretation == arr->interpretation() && attr.mNormalize == arr->normalize() )
+      continue;
+
+    if ( ! attr.mArray ) {
+      VL_glEnableVertexAttribArray( idx ); VL_CHECK_OGL();
+    }
+
+    attr.mArray = arr;
+    attr.mBufferObject = buf_obj;
+    attr.mPtr = ptr;
+    attr.mStride = stride;
+    attr.mSize = (int)arr->glSize();
+    attr.mType = arr->glType();
+    attr.mInterpretation = arr->interpretation();
+    attr.mNormalize = arr->normalize();
+
+    VL_glBindBuffer(GL_ARRAY_BUFFER, buf_obj); VL_CHECK_OGL();
+    ++mRenderStats.mBufferBinds;
+
+    if ( arr->interpretation() == VAI_NORMAL )
+    {
+      VL_glVertexAttribPointer( idx, (int)arr->glSize(), arr->glType(), arr->normalize(), stride, ptr ); VL_CHECK_OGL();
+    }
+    else
+    if ( arr->interpretation() == VAI_INTEGER )
+    {
+      VL_glVertexAttribIPointer( idx, (int)arr->glSize(), arr->glType(), stride, ptr ); VL_CHECK_OGL();
+    }
+    else
+    if ( arr->interpretation() == VAI_DOUBLE )
+    {
+      VL_glVertexAttribLPointer( idx, (int)arr->glSize(), arr->glType(), stride, ptr ); VL_CHECK_OGL();
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void OpenGLContext::bindVAS_Reset()
 {
   mCurVAS = NULL;
   mGLSLUpdated = true;
 
+  // the tracked vertex array states below refer to the default VAO
+  if ( mCurrentVAO != mDefaultVAO ) {
+    glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
+    mCurrentVAO = mDefaultVAO;
+  }
+
   for(int i=0; i<mVertexAttribCount; ++i) {
     VL_glDisableVertexAttribArray(i); VL_CHECK_OGL();
   }
@@ -1707,17 +2002,27 @@ void OpenGLContext::bindVAS(const IVertexAttribSet* vas, bool use_bo, bool force
 
     if (vas)
     {
+      ++mRenderStats.mVertexAttribSetBinds;
+
       if ( mGLSLProgram && mGLSLProgram->vl_VertexPosition() != -1 ) {
         // disable fixed function arrays if enabled
         if ( mVertexArray.mEnabled ) {
           bindVAS_Reset();
         }
-        bindVAS_Attribs( vas, use_bo );
+        if ( mVAOEnabled ) {
+          bindVAS_VAO( vas, use_bo );
+        } else {
+          if ( mCurrentVAO != mDefaultVAO ) {
+            glBindVertexArray( mDefaultVAO ); VL_CHECK_OGL();
+            mCurrentVAO = mDefaultVAO;
+          }
+          bindVAS_Attribs( vas, use_bo );
+        }
       } else
       if( Has_Fixed_Function_Pipeline )
       {
         // disable generic vertex attrib arrays if enabled
-        if ( mVertexAttrib[VA_Position].mEnabled ) {
+        if ( mVertexAttrib[VA_Position].mEnabled || mCurrentVAO != mDefaultVAO ) {
           bindVAS_Reset();
         }
         bindVAS_Fixed( vas, use_bo );
@@ -1744,6 +2049,7 @@ void OpenGLContext::bindVAS(const IVertexAttribSet* vas, bool use_bo, bool force
 void OpenGLContext::useGLSLProgram(const GLSLProgram* glsl)
 {
   mGLSLUpdated = true;
+  ++mRenderStats.mGLSLProgramSwitches;
 
   if ( glsl )
   {
@@ -33,12 +33,17 @@
 #define OpenGLContext_INCLUDE_ONCE
 
 #include <vlCore/Object.hpp>
+#include <vlCore/DirtyTracker.hpp>
 #include <vlGraphics/UIEventListener.hpp>
 #include <vlGraphics/FramebufferObject.hpp> // Framebuffer and FramebufferObject
+#include <vlGraphics/RenderTargetPool.hpp>
 #include <vlGraphics/RenderState.hpp>
 #include <vlGraphics/NaryQuickMap.hpp>
 #include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/SharedContext.hpp>
+#include <vlGraphics/RenderStats.hpp>
 #include <vector>
+#include <map>
 #include <set>
 
 namespace vl
@@ -48,6 +53,7 @@ namespace vl
   class UniformSet;
   class IVertexAttribSet;
   class ArrayAbstract;
+  class TexParameter;
 
   //-----------------------------------------------------------------------------
   // OpenGLContextFormat
@@ -162,6 +168,14 @@ namespace vl
     //! Sets the OpenGL context as current for the calling thread.
     virtual void makeCurrent() = 0;
 
+    //! Releases the OpenGL context current for the calling thread, so that another thread can make it current.
+    //! Used by MultiContextRendering to move the contexts to their render threads. The default implementation does nothing.
+    virtual void doneCurrent() {}
+
+    //! Creates an auxiliary windowless OpenGL context sharing its resources with this one, to be made current on a worker thread.
+    //! Must be called from the GUI thread after the context has been initialized. Returns NULL if the GUI binding does not support it.
+    virtual ref<SharedContext> createSharedContext() { return NULL; }
+
     //! Initializes the supported OpenGL extensions.
     bool initGLContext(bool log=true);
 
@@ -221,6 +235,9 @@ namespace vl
     //! Removes all FramebufferObjects belonging to an OpenGLContext.
     void destroyAllFramebufferObjects();
 
+    //! The pool of transient render targets recycled across the passes of a frame, created on first use. See RenderTargetPool.
+    RenderTargetPool* renderTargetPool();
+
     //! Removes all OpenGL resources handled by the OpenGLContext.
     void destroyAllOpenGLResources();
 
@@ -284,6 +301,58 @@ namespace vl
     //! If the OpenGL context is a widget this function returns whether its area is continuously updated at each frame.
     bool continuousUpdate() const { return mContinuousUpdate; }
 
+    //! If enabled the continuous update (see setContinuousUpdate()) redraws the widget only when updateNeeded() returns true,
+    //! that is when the scene changed since the last dispatchUpdateEvent() or a continuous source is running, see DirtyTracker.
+    //! Explicit calls to update() and the repaints requested by the windowing system always redraw. Defaults to false.
+    void setUpdateOnDemand(bool on_demand) { mUpdateOnDemand = on_demand; }
+
+    //! Whether the continuous update redraws only when needed, see setUpdateOnDemand().
+    bool updateOnDemand() const { return mUpdateOnDemand; }
+
+    //! If enabled the mouse move and mouse wheel events are not dispatched as they arrive but coalesced until flushInputEvents():
+    //! the listeners receive only the last mouse position and the sum of the wheel rotations. The pending events are flushed by
+    //! dispatchUpdateEvent() and before any other input event, so that the order of the events is preserved, and by the GUI
+    //! bindings supporting coalescing when their event queue is empty. Defaults to false, enabled by Qt4Widget, Qt5Widget,
+    //! SDLWindow and Win32Window.
+    void setInputEventCoalescing(bool enable) { mInputEventCoalescing = enable; if (!enable) flushInputEvents(); }
+
+    //! Whether the mouse move and mouse wheel events are coalesced, see setInputEventCoalescing().
+    bool inputEventCoalescing() const { return mInputEventCoalescing; }
+
+    //! Dispatches the mouse move and mouse wheel events coalesced since the last call, see setInputEventCoalescing().
+    void flushInputEvents()
+    {
+      if (mPendingMouseMove)
+      {
+        mPendingMouseMove = false;
+        makeCurrent();
+        std::vector< ref<UIEventListener> > temp_clients = eventListeners();
+        for( unsigned i=0; i<temp_clients.size(); ++i )
+          if ( temp_clients[i]->isEnabled() )
+            temp_clients[i]->mouseMoveEvent(mPendingMouseX, mPendingMouseY);
+      }
+      if (mPendingMouseWheel)
+      {
+        int n = mPendingMouseWheel;
+        mPendingMouseWheel = 0;
+        makeCurrent();
+        std::vector< ref<UIEventListener> > temp_clients = eventListeners();
+        for( unsigned i=0; i<temp_clients.size(); ++i )
+          if ( temp_clients[i]->isEnabled() )
+            temp_clients[i]->mouseWheelEvent(n);
+      }
+    }
+
+    //! Returns true if some mouse move or mouse wheel events are waiting for flushInputEvents().
+    bool inputEventsPending() const { return mPendingMouseMove || mPendingMouseWheel != 0; }
+
+    //! Used by the GUI bindings during the continuous update: returns \p true if updateOnDemand() is disabled, if DirtyTracker::tick()
+    //! changed since the last dispatchUpdateEvent() or if DirtyTracker::continuousSources() is not zero.
+    bool updateNeeded() const
+    {
+      return !mUpdateOnDemand || mUpdateTick != DirtyTracker::tick() || DirtyTracker::continuousSources() != 0;
+    }
+
     //! Adds an UIEventListener to be notified of OpenGLContext related events.
     //! This method triggers immediately an UIEventListener::addedListenerEvent() and if the OpenGLContext is initialized also an UIEventListener::initEvent().
     //! \note An \p UIEventListener can be associated only to one OpenGLContext at a time.
@@ -339,6 +408,13 @@ namespace vl
       if (mIgnoreNextMouseMoveEvent)
         mIgnoreNextMouseMoveEvent = false;
       else
+      if (mInputEventCoalescing)
+      {
+        mPendingMouseMove = true;
+        mPendingMouseX = x;
+        mPendingMouseY = y;
+      }
+      else
       {
         std::vector< ref<UIEventListener> > temp_clients = eventListeners();
         for( unsigned i=0; i<temp_clients.size(); ++i )
@@ -350,6 +426,7 @@ namespace vl
     //! Dispatches the UIEventListener::mouseUpEvent() notification to the subscribed UIEventListener objects.
     void dispatchMouseUpEvent(EMouseButton button, int x, int y)
     {
+      flushInputEvents();
       makeCurrent();
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
       for( unsigned i=0; i<temp_clients.size(); ++i )
@@ -360,6 +437,7 @@ namespace vl
     //! Dispatches the UIEventListener::mouseDownEvent() notification to the subscribed UIEventListener objects.
     void dispatchMouseDownEvent(EMouseButton button, int x, int y)
     {
+      flushInputEvents();
       makeCurrent();
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
       for( unsigned i=0; i<temp_clients.size(); ++i )
@@ -370,6 +448,11 @@ namespace vl
     //! Dispatches the UIEventListener::mouseWheelEvent() notification to the subscribed UIEventListener objects.
     void dispatchMouseWheelEvent(int n)
     {
+      if (mInputEventCoalescing)
+      {
+        mPendingMouseWheel += n;
+        return;
+      }
       makeCurrent();
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
       for( unsigned i=0; i<temp_clients.size(); ++i )
@@ -380,6 +463,7 @@ namespace vl
     //! Dispatches the UIEventListener::keyPressEvent() notification to the subscribed UIEventListener objects.
     void dispatchKeyPressEvent(unsigned short unicode_ch, EKey key)
     {
+      flushInputEvents();
       makeCurrent();
       keyPress(key);
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
@@ -391,6 +475,7 @@ namespace vl
     //! Dispatches the UIEventListener::keyReleaseEvent() notification to the subscribed UIEventListener objects.
     void dispatchKeyReleaseEvent(unsigned short unicode_ch, EKey key)
     {
+      flushInputEvents();
       makeCurrent();
       keyRelease(key);
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
@@ -404,6 +489,8 @@ namespace vl
     //! This event must be issued just before the actual GL context is destroyed.
     void dispatchDestroyEvent()
     {
+      mPendingMouseMove = false;
+      mPendingMouseWheel = 0;
       makeCurrent();
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
       for( unsigned i=0; i<temp_clients.size(); ++i )
@@ -416,11 +503,14 @@ namespace vl
     //! Dispatches the UIEventListener::updateEvent() notification to the subscribed UIEventListener objects.
     void dispatchUpdateEvent()
     {
+      flushInputEvents();
       makeCurrent();
       std::vector< ref<UIEventListener> > temp_clients = eventListeners();
       for( unsigned i=0; i<temp_clients.size(); ++i )
         if ( temp_clients[i]->isEnabled() )
           temp_clients[i]->updateEvent();
+      // the changes performed while updating are part of this frame, see updateNeeded()
+      mUpdateTick = DirtyTracker::tick();
     }
 
     //! Dispatches the UIEventListener::visibilityEvent() notification to the subscribed UIEventListener objects.
@@ -499,6 +589,20 @@ namespace vl
     void bindVAS_Attribs(const IVertexAttribSet* vas, bool use_vbo);
     void bindVAS_Fixed(const IVertexAttribSet* vas, bool use_vbo);
     void bindVAS_Reset();
+    void bindVAS_VAO(const IVertexAttribSet* vas, bool use_vbo);
+
+    //! If enabled the generic vertex attributes of each IVertexAttribSet are stored in a dedicated Vertex Array Object
+    //! which is then activated with a single call, otherwise the attributes are bound one by one on the default VAO (default = false).
+    //! Requires OpenGL 3.0 or GL_ARB_vertex_array_object and only affects the GLSL vertex attribute path, fixed function arrays are unaffected.
+    //! A cached VAO is updated when any of the arrays, buffer object handles or formats of its IVertexAttribSet change and
+    //! is deleted when it has not been used for 64 renderings, for example because its IVertexAttribSet was destroyed.
+    void setVAOEnabled(bool enable);
+
+    //! Whether a Vertex Array Object is used for each IVertexAttribSet, see setVAOEnabled().
+    bool isVAOEnabled() const { return mVAOEnabled; }
+
+    //! Deletes all the Vertex Array Objects created by the IVertexAttribSet VAO cache, see setVAOEnabled().
+    void deleteVAOCache();
 
     //! Applies an EnableSet to an OpenGLContext - Typically for internal use only.
     void applyEnables( const EnableSet* cur );
@@ -543,6 +647,37 @@ namespace vl
       return mTexUnitBinding[unit_i];
     }
 
+    //! Declares that the sampler object \p sampler is currently bound to the texture unit \p unit_i. - For internal use only.
+    void setSamplerBinding(int unit_i, unsigned int sampler)
+    {
+      VL_CHECK(unit_i < VL_MAX_TEXTURE_IMAGE_UNITS);
+      mSamplerBinding[unit_i] = sampler;
+    }
+
+    //! Returns the sampler object currently bound to the specified texture unit, 0 if none. - For internal use only.
+    unsigned int samplerBinding(int unit_i) const
+    {
+      VL_CHECK(unit_i < VL_MAX_TEXTURE_IMAGE_UNITS);
+      return mSamplerBinding[unit_i];
+    }
+
+    //! If enabled TextureSampler binds to each texture unit a sampler object carrying the sampling state of its TexParameter (default = false).
+    //! Sampler objects are shared among all the TexParameter with the same state, so that switching between textures that sample
+    //! the same way does not require any glTexParameter() call. Requires OpenGL 3.3 or GL_ARB_sampler_objects, see Has_Sampler_Objects.
+    void setSamplerObjectsEnabled(bool enable);
+
+    //! Whether sampler objects are used by TextureSampler, see setSamplerObjectsEnabled().
+    bool samplerObjectsEnabled() const { return mSamplerObjectsEnabled; }
+
+    //! Returns the shared sampler object matching the state of the given TexParameter, creating it if needed. - For internal use only.
+    unsigned int samplerObject(const TexParameter* tex_param);
+
+    //! The number of sampler objects currently created by this OpenGLContext.
+    int samplerObjectCount() const { return (int)mSamplerObjects.size(); }
+
+    //! Deletes all the sampler objects created by this OpenGLContext, see setSamplerObjectsEnabled().
+    void deleteSamplerObjects();
+
     const GLSLProgram* glslProgram() const { return mGLSLProgram.get(); }
     GLSLProgram* glslProgram() { return mGLSLProgram.get(); }
 
@@ -570,6 +705,54 @@ namespace vl
     //! - <i>In general all OpenGL render states should be set to their default values.</i>
     bool isCleanState(bool verbose);
 
+    //! The counters of the OpenGL work issued with this context, see RenderStats. Reset them with renderStats().reset().
+    RenderStats& renderStats() { return mRenderStats; }
+
+    //! The counters of the OpenGL work issued with this context, see RenderStats.
+    const RenderStats& renderStats() const { return mRenderStats; }
+
+    // --- shadowed states ---
+
+    //! Returns the RenderState of the given type set by applyRenderStates() or, if none is active, the default one (can be NULL).
+    //! Code that temporarily changes a state while rendering should read it from here instead of using glGet*(),
+    //! which stalls the pipeline on many drivers and on every remote or virtualized OpenGL implementation.
+    const RenderState* currentRenderState(ERenderState type) const;
+
+    //! The depth write mask currently set, see currentRenderState().
+    bool currentDepthMask() const;
+
+    //! The color write mask currently set, see currentRenderState().
+    ubvec4 currentColorMask() const;
+
+    //! The front and back stencil write masks currently set, see currentRenderState().
+    void currentStencilMask(unsigned int& front, unsigned int& back) const;
+
+    //! Declares the scissor test state and box currently set by the Renderer - For internal use only.
+    void setScissorState(bool enabled, const RectI& box) { mScissorEnabled = enabled; mScissorBox = box; }
+
+    //! Whether the scissor test is enabled, as declared by the Renderer with setScissorState().
+    bool isScissorEnabled() const { return mScissorEnabled; }
+
+    //! The scissor box, as declared by the Renderer with setScissorState().
+    const RectI& scissorBox() const { return mScissorBox; }
+
+    //! Declares that a Renderer started executing its render queues - For internal use only, see countGLQuery().
+    void beginRenderRaw() { ++mRenderRawDepth; }
+
+    //! Declares that a Renderer finished executing its render queues - For internal use only, see countGLQuery().
+    void endRenderRaw() { VL_CHECK(mRenderRawDepth > 0); --mRenderRawDepth; }
+
+    //! Declares that the context is rendered by a thread of MultiContextRendering concurrently with other contexts of its
+    //! share group - For internal use only. Such a context cannot share its GLSLProgram[s], see GLSLProgram::claimRenderContext().
+    void setConcurrentRendering(bool concurrent) { mConcurrentRendering = concurrent; }
+
+    //! Whether the context is rendered concurrently with other contexts of its share group, see setConcurrentRendering().
+    bool concurrentRendering() const { return mConcurrentRendering; }
+
+    //! Counts in RenderStats::mGLQueries a glGet*() state query issued while a Renderer is rendering.
+    //! Debug builds also report the first occurrence of each \p query, which should be a string literal.
+    void countGLQuery(const char* query);
+
   public:
     // constant color
     const fvec3& normal() const { return mNormal; }
@@ -577,10 +760,15 @@ namespace vl
     const fvec3& secondaryColor() const { return mSecondaryColor; }
     const fvec4& vertexAttribValue(int i) const { VL_CHECK(i<VA_MaxAttribCount); return mVertexAttribValue[i]; }
 
+  protected:
+    //! Deletes the cached VAOs not used during the last \p max_unused renderings, see setVAOEnabled().
+    void evictVAOCache(unsigned int max_unused);
+
   protected:
     ref<Framebuffer> mLeftFramebuffer;
     ref<Framebuffer> mRightFramebuffer;
     std::vector< ref<FramebufferObject> > mFramebufferObject;
+    ref<RenderTargetPool> mRenderTargetPool;
     std::vector< ref<UIEventListener> > mEventListeners;
     std::set<EKey> mKeyboard;
     OpenGLContextFormat mGLContextInfo;
@@ -589,6 +777,13 @@ namespace vl
     int mTextureCoordCount;
     bool mMouseVisible;
     bool mContinuousUpdate;
+    bool mUpdateOnDemand;
+    long long mUpdateTick;
+    bool mInputEventCoalescing;
+    bool mPendingMouseMove;
+    int mPendingMouseX;
+    int mPendingMouseY;
+    int mPendingMouseWheel;
     bool mIgnoreNextMouseMoveEvent;
     bool mFullscreen;
     bool mHasDoubleBuffer;
@@ -600,9 +795,17 @@ namespace vl
     // default render states
     RenderStateSlot mDefaultRenderStates[RS_RenderStateCount];
 
-    // applyEnables()
-    ref< NaryQuickMap<EEnable, EEnable, EN_EnableCount> > mCurrentEnableSet;
-    ref< NaryQuickMap<EEnable, EEnable, EN_EnableCount> > mNewEnableSet;
+    // applyEnables(): bit i is set if the EEnable i is currently enabled
+    u64 mCurrentEnableMask;
+
+    RenderStats mRenderStats;
+    int mRenderRawDepth;
+    bool mConcurrentRendering;
+    std::set<const char*> mReportedGLQueries;
+
+    // setScissorState()
+    bool mScissorEnabled;
+    RectI mScissorBox;
 
     // applyRenderStates()
     ref< NaryQuickMap<ERenderState, RenderStateSlot, RS_RenderStateCount> > mCurrentRenderStateSet;
@@ -618,12 +821,42 @@ namespace vl
   private:
     struct VertexArrayInfo
     {
-      VertexArrayInfo(): mBufferObject(0), mPtr(0), mEnabled(false) {}
+      VertexArrayInfo(): mBufferObject(0), mPtr(0), mStride(0), mEnabled(false) {}
       int   mBufferObject;
       const unsigned char* mPtr;
+      int mStride;
       bool mEnabled;
     };
 
+    struct VAOAttribInfo
+    {
+      VAOAttribInfo(): mArray(NULL), mBufferObject(0), mPtr(0), mStride(0), mSize(0), mType(0), mInterpretation(VAI_NORMAL), mNormalize(false) {}
+      const ArrayAbstract* mArray;
+      int mBufferObject;
+      const unsigned char* mPtr;
+      int mStride;
+      int mSize;
+      GLenum mType;
+      EVertexAttribInterpretation mInterpretation;
+      bool mNormalize;
+    };
+
+    struct VAOInfo
+    {
+      VAOInfo(): mVAO(0), mLastUsed(0) {}
+      GLuint mVAO;
+      unsigned int mLastUsed;
+      VAOAttribInfo mAttrib[VA_MaxAttribCount];
+    };
+
+    struct SamplerKey
+    {
+      bool operator<(const SamplerKey& other) const { return memcmp(this, &other, sizeof(SamplerKey)) < 0; }
+      int mState[7]; // min, mag, wrap s/t/r, compare mode/func
+      float mBorder[4];
+      float mAnisotropy;
+    };
+
   protected:
     // --- VertexAttribSet Management ---
     const IVertexAttribSet* mCurVAS;
@@ -642,6 +875,19 @@ namespace vl
     fvec4 mVertexAttribValue[VA_MaxAttribCount];
     GLuint mDefaultVAO;
 
+    // --- Vertex Array Object cache ---
+    // keyed on IVertexAttribSet::vertexAttribSetUID() since the address of a destroyed IVertexAttribSet can be reused
+    std::map<long long, VAOInfo> mVAOCache;
+    unsigned int mVAOCacheTick;
+    GLuint mCurrentVAO;
+    bool mVAOEnabled;
+
+    // --- Sampler Objects ---
+    std::map<SamplerKey, unsigned int> mSamplerObjects;
+    unsigned int mSamplerBinding[VL_MAX_TEXTURE_IMAGE_UNITS];
+    unsigned int mSamplerGeneration;
+    bool mSamplerObjectsEnabled;
+
   private:
     void setupDefaultRenderStates();
   };
@@ -0,0 +1,588 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/PagedTerrain.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+
+using namespace vl;
+
+namespace
+{
+  bool lessRecentlyUsed(const std::pair<unsigned, int>& a, const std::pair<unsigned, int>& b) { return a.first < b.first; }
+}
+//-----------------------------------------------------------------------------
+// TerrainTileFiles
+//-----------------------------------------------------------------------------
+ref<Image> TerrainTileFiles::load(const String& pattern, int level, int x, int z)
+{
+  if (pattern.empty())
+    return NULL;
+
+  String path = pattern;
+  path.replace( "{level}", String::fromInt(level) );
+  path.replace( "{x}", String::fromInt(x) );
+  path.replace( "{z}", String::fromInt(z) );
+
+  if (directory())
+  {
+    ref<VirtualFile> file = directory()->file(path);
+    return file ? loadImage(file.get()) : ref<Image>(NULL);
+  }
+  else
+    return loadImage(path);
+}
+//-----------------------------------------------------------------------------
+ref<Image> TerrainTileFiles::loadHeightmap(int level, int x, int z)
+{
+  return load(heightmapPattern(), level, x, z);
+}
+//-----------------------------------------------------------------------------
+ref<Image> TerrainTileFiles::loadTexture(int level, int x, int z)
+{
+  return load(texturePattern(), level, x, z);
+}
+//-----------------------------------------------------------------------------
+// PagedTerrain
+//-----------------------------------------------------------------------------
+PagedTerrain::PagedTerrain():
+  mLoadMutex(NULL), mSkirtDepth(-1), mMaxPixelError(2.0f), mLevelCount(1), mTileCacheSize(512),
+  mMaxLoadsPerFrame(2), mMaxUploadsPerFrame(8), mTileResolution(0), mFrame(0), mStatsCachedTiles(0), mStatsPendingTiles(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::init()
+{
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.clear();
+    mLoadedTiles.clear();
+  }
+  mTiles.clear();
+  mSelected.clear();
+  mTileResolution = 0;
+  mGLSL = NULL;
+  mDetailTex = NULL;
+
+  if (width() <= 0 || height() <= 0 || depth() <= 0 || levelCount() < 1 || !tileSource())
+  {
+    Log::error(
+        Say("PagedTerrain initialization failed: invalid parameters.\n"
+             "width = %n\n"
+             "height = %n\n"
+             "depth = %n\n"
+             "level count = %n\n"
+             "tile source = %s\n")
+        << width() << height() << depth() << levelCount() << (tileSource() ? "yes" : "NULL")
+      );
+    return;
+  }
+
+  if (useGLSL())
+  {
+    if(fragmentShader().empty() || vertexShader().empty())
+    {
+      Log::error("PagedTerrain: vertex shader or fragment shader not defined.\n");
+      return;
+    }
+    mGLSL = new GLSLProgram;
+    mGLSL->attachShader( new GLSLVertexShader( String::loadText(vertexShader()) ) );
+    mGLSL->attachShader( new GLSLFragmentShader( String::loadText(fragmentShader()) ) );
+    ref<Uniform> terrain_tex = new Uniform("terrain_tex");
+    terrain_tex->setUniformI(0);
+    mGLSL->setUniform(terrain_tex.get());
+    if (!detailTexture().empty())
+    {
+      ref<Uniform> detail_tex = new Uniform("detail_tex");
+      detail_tex->setUniformI(1);
+      mGLSL->setUniform(detail_tex.get());
+    }
+  }
+
+  if (!detailTexture().empty())
+  {
+    ref<Image> detail_img = loadImage(detailTexture());
+    if (!detail_img)
+    {
+      Log::error("PagedTerrain initialization failed: could not load the detail texture.\n");
+      return;
+    }
+    mDetailTex = new Texture(detail_img.get(), detailTextureFormat(), true);
+    mDetailTex->getTexParameter()->setMagFilter(TPF_LINEAR);
+    mDetailTex->getTexParameter()->setMinFilter(TPF_LINEAR_MIPMAP_LINEAR);
+    mDetailTex->getTexParameter()->setWrapS(TPW_REPEAT);
+    mDetailTex->getTexParameter()->setWrapT(TPW_REPEAT);
+    if (Has_GL_EXT_texture_filter_anisotropic)
+    {
+      float max = 1.0f;
+      glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max);
+      mDetailTex->getTexParameter()->setAnisotropy(max);
+    }
+  }
+
+  computeBounds();
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::computeBounds()
+{
+  AABB aabb;
+  aabb.setMinCorner( origin() + vec3((real)(-width()/2), 0, (real)(-depth()/2)) );
+  aabb.setMaxCorner( origin() + vec3((real)(+width()/2), (real)height(), (real)(+depth()/2)) );
+  setBoundingBox(aabb);
+  setBoundingSphere(aabb);
+  setBoundsDirty(false);
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::extractActors(ActorCollection& list)
+{
+  for(int i=0; i<mSelected.size(); ++i)
+    list.push_back( mSelected[i].get() );
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::extractVisibleActors(ActorCollection& list, const Camera* camera)
+{
+  // without a camera no LOD selection can be made
+  if (!camera || !camera->viewport())
+  {
+    extractActors(list);
+    return;
+  }
+
+  ++mFrame;
+
+  // synchronous loading
+  if (!mLoadMutex)
+    processLoadRequests( maxLoadsPerFrame() );
+
+  finalizeLoadedTiles();
+
+  mSelected.clear();
+  if ( tileSource() && levelCount() > 0 )
+  {
+    // converts a length at unit distance to pixels
+    real proj_factor = camera->projectionMatrix().e(1,1) * camera->viewport()->height() * (real)0.5;
+    selectTile( 0, 0, 0, mSelected, camera, proj_factor, cullingEnabled() );
+  }
+
+  cancelUnusedRequests();
+  evictTiles();
+
+  for(int i=0; i<mSelected.size(); ++i)
+  {
+    if ( isEnabled(mSelected[i].get()) )
+      list.push_back( mSelected[i].get() );
+  }
+}
+//-----------------------------------------------------------------------------
+AABB PagedTerrain::tileBounds(int level, int x, int z) const
+{
+  const real tile_w = (real)(width() / (1 << level));
+  const real tile_d = (real)(depth() / (1 << level));
+  const vec3 corner = origin() + vec3((real)(-width()/2) + x * tile_w, 0, (real)(-depth()/2) + z * tile_d);
+
+  real min_y = 0;
+  real max_y = (real)height();
+  std::map< TileKey, ref<Tile> >::const_iterator it = mTiles.find( TileKey(level, x, z) );
+  if ( it != mTiles.end() && it->second->mState == TS_Ready )
+  {
+    min_y = it->second->mMinY;
+    max_y = it->second->mMaxY;
+  }
+
+  AABB aabb;
+  aabb.setMinCorner( corner + vec3(0, min_y, 0) );
+  aabb.setMaxCorner( corner + vec3(tile_w, max_y, tile_d) );
+  return aabb;
+}
+//-----------------------------------------------------------------------------
+PagedTerrain::Tile* PagedTerrain::acquireTile(int level, int x, int z)
+{
+  ref<Tile>& tile = mTiles[ TileKey(level, x, z) ];
+  if (!tile)
+  {
+    tile = new Tile(level, x, z);
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.push_back( tile.get() );
+  }
+  tile->mLastUsedFrame = mFrame;
+  return tile.get();
+}
+//-----------------------------------------------------------------------------
+bool PagedTerrain::isTileReady(int level, int x, int z)
+{
+  return acquireTile(level, x, z)->mState == TS_Ready;
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::selectTile(int level, int x, int z, ActorCollection& list, const Camera* camera, real proj_factor, bool cull)
+{
+  AABB aabb = tileBounds(level, x, z);
+  if ( cull && camera->frustum().cull(aabb) )
+    return;
+
+  Tile* tile = acquireTile(level, x, z);
+  if ( tile->mState != TS_Ready )
+    return;
+
+  // screen-space size of the sample spacing of the tile
+  const vec3 eye = camera->modelingMatrix().getT();
+  const vec3 nearest = aabb.clip(eye);
+  const real distance = std::max( (nearest - eye).length(), (real)1e-6 );
+  const real spacing = (real)( std::max(width(), depth()) / (1 << level) / mTileResolution );
+  const real pixel_error = spacing * proj_factor / distance;
+
+  if ( level + 1 < levelCount() && pixel_error > maxPixelError() )
+  {
+    // refine only if all the visible children are available, otherwise keep requesting them
+    bool children_ready = true;
+    for(int i=0; i<4; ++i)
+    {
+      const int cx = x*2 + (i & 1);
+      const int cz = z*2 + (i >> 1);
+      if ( cull && camera->frustum().cull( tileBounds(level+1, cx, cz) ) )
+        continue;
+      children_ready &= isTileReady(level+1, cx, cz);
+    }
+    if (children_ready)
+    {
+      for(int i=0; i<4; ++i)
+        selectTile( level+1, x*2 + (i & 1), z*2 + (i >> 1), list, camera, proj_factor, cull );
+      return;
+    }
+  }
+
+  // morphs towards the parent tile as the error approaches the one at which the parent is selected
+  if ( tile->mMorphFactor )
+  {
+    float morph = level == 0 ? 1.0f : (float)( (pixel_error - maxPixelError() * 0.5f) / (maxPixelError() * 0.5f) );
+    tile->mMorphFactor->setUniformF( clamp(morph, 0.0f, 1.0f) );
+  }
+
+  list.push_back( tile->mActor.get() );
+}
+//-----------------------------------------------------------------------------
+bool PagedTerrain::hasLoadRequests() const
+{
+  ScopedMutex lock(mLoadMutex);
+  return !mLoadQueue.empty();
+}
+//-----------------------------------------------------------------------------
+int PagedTerrain::processLoadRequests(int max_count)
+{
+  int count = 0;
+  for( ; count<max_count; ++count)
+  {
+    Tile* tile = NULL;
+    {
+      ScopedMutex lock(mLoadMutex);
+      if (mLoadQueue.empty())
+        break;
+      tile = mLoadQueue.front();
+      mLoadQueue.pop_front();
+      tile->mState = TS_Loading;
+    }
+
+    // no lock needed: the rendering thread does not touch the tiles being loaded
+    loadTile(tile);
+
+    {
+      ScopedMutex lock(mLoadMutex);
+      tile->mState = tile->mGeometry ? TS_Loaded : TS_Failed;
+      if (tile->mGeometry)
+        mLoadedTiles.push_back(tile);
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::loadTile(Tile* tile)
+{
+  ref<Image> hmap = tileSource()->loadHeightmap(tile->mLevel, tile->mX, tile->mZ);
+  if (!hmap)
+  {
+    Log::warning( Say("PagedTerrain: heightmap of tile %n (%n, %n) not available.\n") << tile->mLevel << tile->mX << tile->mZ );
+    return;
+  }
+
+  const int n = hmap->width() - 1;
+  if ( n < 2 || hmap->height() != hmap->width() || (n & (n-1)) != 0 )
+  {
+    Log::error( Say("PagedTerrain: heightmap of tile %n (%n, %n) must be 2^n+1 x 2^n+1 samples.\n") << tile->mLevel << tile->mX << tile->mZ );
+    return;
+  }
+
+  tile->mTexture = tileSource()->loadTexture(tile->mLevel, tile->mX, tile->mZ);
+  tile->mResolution = n;
+
+  const int side = n + 1;
+  const int grid_count = side * side;
+  const float tile_w = (float)( width() / (1 << tile->mLevel) );
+  const float tile_d = (float)( depth() / (1 << tile->mLevel) );
+  const float skirt = (float)( skirtDepth() < 0 ? height() * 0.01 : skirtDepth() );
+
+  // heights
+  std::vector<float> h(grid_count);
+  for(int j=0; j<side; ++j)
+    for(int i=0; i<side; ++i)
+      h[i + j*side] = hmap->sample(i, j).r() * (float)height();
+
+  ref<Geometry> geom = new Geometry;
+  ref<ArrayFloat3> verts  = new ArrayFloat3;
+  ref<ArrayFloat2> tex_uv = new ArrayFloat2;
+  ref<ArrayFloat2> det_uv = new ArrayFloat2;
+  ref<ArrayFloat1> coarse = new ArrayFloat1;
+  const int vert_count = grid_count + 4 * side;
+  verts->resize(vert_count);
+  tex_uv->resize(vert_count);
+  det_uv->resize(vert_count);
+  coarse->resize(vert_count);
+
+  // half texel inset to prevent seams between the tile textures
+  const float tex_w = tile->mTexture ? (float)tile->mTexture->width()  : 1.0f;
+  const float tex_h = tile->mTexture ? (float)tile->mTexture->height() : 1.0f;
+  const float det_scale = (float)(detailRepetitionMode() > 0 ? detailRepetitionMode() : 1) / (1 << tile->mLevel);
+
+  float min_y = h[0];
+  float max_y = h[0];
+  for(int j=0; j<side; ++j)
+  {
+    for(int i=0; i<side; ++i)
+    {
+      const int idx = i + j*side;
+      const float u = (float)i / n;
+      const float v = (float)j / n;
+      verts->at(idx) = fvec3( (u - 0.5f) * tile_w, h[idx], (v - 0.5f) * tile_d );
+      tex_uv->at(idx) = fvec2( (0.5f + u * (tex_w - 1)) / tex_w, (0.5f + v * (tex_h - 1)) / tex_h );
+      det_uv->at(idx) = fvec2( (tile->mX + u) * det_scale, (tile->mZ + v) * det_scale );
+
+      // the height of the vertex in the parent tile, which has half the resolution
+      float hc;
+      const bool odd_i = (i & 1) != 0, odd_j = (j & 1) != 0;
+      if ( odd_i && odd_j )
+        hc = ( h[idx-1-side] + h[idx+1-side] + h[idx-1+side] + h[idx+1+side] ) * 0.25f;
+      else if ( odd_i )
+        hc = ( h[idx-1] + h[idx+1] ) * 0.5f;
+      else if ( odd_j )
+        hc = ( h[idx-side] + h[idx+side] ) * 0.5f;
+      else
+        hc = h[idx];
+      coarse->at(idx) = hc;
+
+      min_y = std::min(min_y, h[idx]);
+      max_y = std::max(max_y, h[idx]);
+    }
+  }
+
+  // grid triangles, same winding as makeGrid()
+  ref<DrawElementsUInt> tris = new DrawElementsUInt(PT_TRIANGLES);
+  std::vector<GLuint> indices;
+  indices.reserve( n*n*6 + 4*n*12 );
+  for(int j=0; j<n; ++j)
+  {
+    for(int i=0; i<n; ++i)
+    {
+      GLuint a = i+0 + side*(j+1), b = i+1 + side*(j+1), c = i+1 + side*j, d = i+0 + side*j;
+      indices.push_back(a); indices.push_back(b); indices.push_back(c);
+      indices.push_back(c); indices.push_back(d); indices.push_back(a);
+    }
+  }
+  tris->indexBuffer()->resize( indices.size() );
+  memcpy( tris->indexBuffer()->ptr(), &indices[0], indices.size() * sizeof(GLuint) );
+
+  geom->setVertexArray(verts.get());
+  geom->setTexCoordArray(0, tex_uv.get());
+  geom->setTexCoordArray(1, det_uv.get());
+  geom->setTexCoordArray(2, coarse.get());
+  geom->drawCalls().push_back(tris.get());
+  geom->computeNormals();
+
+  // skirts: the border vertices are duplicated and lowered, the strips are double sided
+  ArrayFloat3* norms = geom->normalArray()->as<ArrayFloat3>();
+  for(int e=0; e<4; ++e)
+  {
+    for(int k=0; k<side; ++k)
+    {
+      const int border = e == 0 ? k : e == 1 ? k + n*side : e == 2 ? k*side : n + k*side;
+      const int skirt_idx = grid_count + e*side + k;
+      verts->at(skirt_idx)  = verts->at(border) - fvec3(0, skirt, 0);
+      tex_uv->at(skirt_idx) = tex_uv->at(border);
+      det_uv->at(skirt_idx) = det_uv->at(border);
+      coarse->at(skirt_idx) = coarse->at(border) - skirt;
+      if (norms)
+        norms->at(skirt_idx) = norms->at(border);
+      if (k > 0)
+      {
+        GLuint a = border, b = skirt_idx, c = skirt_idx - 1;
+        GLuint d = e == 0 ? k-1 : e == 1 ? k-1 + n*side : e == 2 ? (k-1)*side : n + (k-1)*side;
+        GLuint quad[] = { a, b, c, c, d, a,  a, c, b, c, a, d };
+        indices.insert(indices.end(), quad, quad + 12);
+      }
+    }
+  }
+  tris->indexBuffer()->resize( indices.size() );
+  memcpy( tris->indexBuffer()->ptr(), &indices[0], indices.size() * sizeof(GLuint) );
+
+  tile->mMinY = min_y - skirt;
+  tile->mMaxY = max_y;
+  tile->mGeometry = geom;
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::finalizeLoadedTiles()
+{
+  std::vector<Tile*> tiles;
+  {
+    ScopedMutex lock(mLoadMutex);
+    const int count = std::min( (int)mLoadedTiles.size(), maxUploadsPerFrame() );
+    tiles.assign( mLoadedTiles.begin(), mLoadedTiles.begin() + count );
+    mLoadedTiles.erase( mLoadedTiles.begin(), mLoadedTiles.begin() + count );
+  }
+
+  for(size_t i=0; i<tiles.size(); ++i)
+  {
+    Tile* tile = tiles[i];
+
+    ref<Effect> fx = new Effect;
+    fx->shader()->enable(EN_DEPTH_TEST);
+    fx->shader()->enable(EN_CULL_FACE);
+    if (mGLSL)
+      fx->shader()->setRenderState( mGLSL.get() );
+
+    if (tile->mTexture)
+    {
+      ref<Texture> texture = new Texture( tile->mTexture.get(), terrainTextureFormat(), false );
+      texture->getTexParameter()->setMagFilter(TPF_LINEAR);
+      texture->getTexParameter()->setMinFilter(TPF_LINEAR);
+      texture->getTexParameter()->setWrapS(TPW_CLAMP_TO_EDGE);
+      texture->getTexParameter()->setWrapT(TPW_CLAMP_TO_EDGE);
+      fx->shader()->gocTextureSampler(0)->setTexture( texture.get() );
+      // the image is not needed anymore
+      tile->mTexture = NULL;
+    }
+
+    if (mDetailTex)
+    {
+      fx->shader()->gocTextureSampler(1)->setTexture( mDetailTex.get() );
+      if (!mGLSL)
+        fx->shader()->gocTexEnv(1)->setMode(TEM_MODULATE);
+    }
+
+    const real tile_w = (real)( width() / (1 << tile->mLevel) );
+    const real tile_d = (real)( depth() / (1 << tile->mLevel) );
+    vec3 center = origin() + vec3( (real)(-width()/2) + (tile->mX + (real)0.5) * tile_w, 0, (real)(-depth()/2) + (tile->mZ + (real)0.5) * tile_d );
+    ref<Transform> tr = new Transform;
+    tr->setLocalAndWorldMatrix( mat4::getTranslation(center) );
+
+    tile->mActor = new Actor( tile->mGeometry.get(), fx.get(), tr.get() );
+    if (mGLSL)
+    {
+      tile->mMorphFactor = new Uniform("morph_factor");
+      tile->mMorphFactor->setUniformF(1.0f);
+      tile->mActor->setUniform( tile->mMorphFactor.get() );
+    }
+
+    if (tile->mLevel == 0)
+      mTileResolution = tile->mResolution;
+
+    tile->mState = TS_Ready;
+  }
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::cancelUnusedRequests()
+{
+  std::vector<Tile*> cancelled;
+  {
+    ScopedMutex lock(mLoadMutex);
+    std::deque<Tile*> queue;
+    for(size_t i=0; i<mLoadQueue.size(); ++i)
+    {
+      if ( mLoadQueue[i]->mLastUsedFrame == mFrame )
+        queue.push_back( mLoadQueue[i] );
+      else
+        cancelled.push_back( mLoadQueue[i] );
+    }
+    // coarser tiles first, they are needed to display the finer ones
+    for(int level=0, k=0; k<(int)queue.size(); ++level)
+    {
+      for(size_t i=0; i<queue.size(); ++i)
+      {
+        if ( queue[i]->mLevel == level )
+          mLoadQueue[k++] = queue[i];
+      }
+    }
+    mLoadQueue.resize( queue.size() );
+    mStatsPendingTiles = (int)mLoadQueue.size();
+  }
+
+  for(size_t i=0; i<cancelled.size(); ++i)
+    mTiles.erase( TileKey(cancelled[i]->mLevel, cancelled[i]->mX, cancelled[i]->mZ) );
+}
+//-----------------------------------------------------------------------------
+void PagedTerrain::evictTiles()
+{
+  // only the tiles not being loaded can be evicted
+  std::vector< std::pair<unsigned, int> > candidates;
+  std::vector<Tile*> tiles;
+  int resident = 0;
+  for( std::map< TileKey, ref<Tile> >::iterator it = mTiles.begin(); it != mTiles.end(); ++it )
+  {
+    Tile* tile = it->second.get();
+    if ( tile->mState == TS_Ready || tile->mState == TS_Failed )
+    {
+      ++resident;
+      if ( tile->mLastUsedFrame != mFrame && tile->mLevel > 0 )
+      {
+        candidates.push_back( std::make_pair(tile->mLastUsedFrame, (int)tiles.size()) );
+        tiles.push_back(tile);
+      }
+    }
+  }
+
+  if ( resident > tileCacheSize() )
+  {
+    std::sort( candidates.begin(), candidates.end(), lessRecentlyUsed );
+    for(size_t i=0; i<candidates.size() && resident > tileCacheSize(); ++i, --resident)
+    {
+      Tile* tile = tiles[ candidates[i].second ];
+      mTiles.erase( TileKey(tile->mLevel, tile->mX, tile->mZ) );
+    }
+  }
+
+  mStatsCachedTiles = resident;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,282 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef PagedTerrain_INCLUDE_ONCE
+#define PagedTerrain_INCLUDE_ONCE
+
+#include <vlGraphics/Terrain.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlCore/VirtualDirectory.hpp>
+#include <vlCore/IMutex.hpp>
+#include <map>
+#include <deque>
+
+namespace vl
+{
+  class GLSLProgram;
+
+  //-----------------------------------------------------------------------------
+  // TerrainTileSource
+  //-----------------------------------------------------------------------------
+  /**
+   * Provides the tiles of a PagedTerrain.
+   *
+   * The terrain is a quadtree of tiles: level 0 is a single tile covering the whole terrain, level \p L has 2^L x 2^L tiles,
+   * tile (x, z) covering the area [x, x+1] x [z, z+1] in units of the level's tile size, z growing like the rows of the heightmap.
+   * All the heightmap tiles must have the same size of the form 2^n+1 x 2^n+1, the border samples being shared with the neighbouring tiles.
+   *
+   * \note When PagedTerrain::processLoadRequests() is called from a worker thread the load functions are called from that thread.
+   */
+  class VLGRAPHICS_EXPORT TerrainTileSource: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::TerrainTileSource, Object)
+
+  public:
+    //! Returns the heightmap of the given tile, NULL if not available.
+    virtual ref<Image> loadHeightmap(int level, int x, int z) = 0;
+
+    //! Returns the texture of the given tile, NULL if not available.
+    virtual ref<Image> loadTexture(int /*level*/, int /*x*/, int /*z*/) { return NULL; }
+  };
+
+  //-----------------------------------------------------------------------------
+  // TerrainTileFiles
+  //-----------------------------------------------------------------------------
+  /**
+   * A TerrainTileSource loading the tiles from image files whose paths are generated replacing the strings
+   * \p "{level}", \p "{x}" and \p "{z}" of a pattern, for example \p "/terrain/height_{level}_{x}_{z}.png".
+   * The files are looked up in directory() if one is set, otherwise using the default FileSystem.
+   */
+  class VLGRAPHICS_EXPORT TerrainTileFiles: public TerrainTileSource
+  {
+    VL_INSTRUMENT_CLASS(vl::TerrainTileFiles, TerrainTileSource)
+
+  public:
+    TerrainTileFiles(const String& heightmap_pattern=String(), const String& texture_pattern=String()):
+      mHeightmapPattern(heightmap_pattern), mTexturePattern(texture_pattern)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual ref<Image> loadHeightmap(int level, int x, int z);
+
+    virtual ref<Image> loadTexture(int level, int x, int z);
+
+    //! The path pattern of the heightmap tiles.
+    void setHeightmapPattern(const String& pattern) { mHeightmapPattern = pattern; }
+    //! The path pattern of the heightmap tiles.
+    const String& heightmapPattern() const { return mHeightmapPattern; }
+
+    //! The path pattern of the texture tiles, if empty no texture is used.
+    void setTexturePattern(const String& pattern) { mTexturePattern = pattern; }
+    //! The path pattern of the texture tiles, if empty no texture is used.
+    const String& texturePattern() const { return mTexturePattern; }
+
+    //! The directory containing the tiles, if NULL the default FileSystem is used.
+    void setDirectory(VirtualDirectory* dir) { mDirectory = dir; }
+    //! The directory containing the tiles, if NULL the default FileSystem is used.
+    VirtualDirectory* directory() { return mDirectory.get(); }
+
+  protected:
+    ref<Image> load(const String& pattern, int level, int x, int z);
+
+  protected:
+    String mHeightmapPattern;
+    String mTexturePattern;
+    ref<VirtualDirectory> mDirectory;
+  };
+
+  //-----------------------------------------------------------------------------
+  // PagedTerrain
+  //-----------------------------------------------------------------------------
+  /**
+   * A Terrain whose tiles are streamed from a TerrainTileSource and selected every frame according to a screen-space error metric,
+   * allowing terrains much larger than the available memory.
+   *
+   * The quadtree defined by the TerrainTileSource is refined where the projected sample spacing of a tile exceeds maxPixelError(),
+   * as long as the higher resolution tiles are available, otherwise the coarser tile is rendered while the missing ones are loaded.
+   * Thus only level 0 must be loaded before something is displayed. Cracks between tiles of different levels are hidden by skirts.
+   *
+   * The width(), depth(), height(), origin(), detailTexture(), detailRepetitionCount() and the texture formats are the same as in Terrain,
+   * terrainTexture() and heightmapTexture() are ignored. The detail texture is repeated detailRepetitionCount() times over the whole terrain.
+   *
+   * \par Loading
+   * Missing tiles are queued and loaded by processLoadRequests(), which only touches CPU data. Without a loadMutex() the terrain calls it
+   * by itself during the Actor extraction loading up to maxLoadsPerFrame() tiles per frame. For asynchronous loading install a mutex with
+   * setLoadMutex() and call processLoadRequests() from one or more worker threads: the rendering thread then only creates the
+   * OpenGL resources of up to maxUploadsPerFrame() loaded tiles per frame.
+   * When more than tileCacheSize() tiles are in memory the ones not used by the current frame are evicted, least recently used first.
+   * \note No thread must be running processLoadRequests() while init() is called or the PagedTerrain is destroyed.
+   *
+   * \par Geomorphing
+   * If useGLSL() is true the vertex and fragment shaders given with setVertexShader() and setFragmentShader() are used for all the tiles,
+   * which bind the tile texture to unit 0 (uniform \p "terrain_tex") and the detail texture to unit 1 (uniform \p "detail_tex").
+   * Each vertex provides in texture coordinate 2 the height it would have in the parent tile, and each tile Actor has a float uniform
+   * \p "morph_factor" going from 0 to 1 as the tile's screen-space error goes from maxPixelError()/2 to maxPixelError(), so that a vertex shader
+   * computing \p "mix(gl_MultiTexCoord2.x, gl_Vertex.y, morph_factor)" smoothly morphs the tiles into their parent before being switched.
+   */
+  class VLGRAPHICS_EXPORT PagedTerrain: public Terrain
+  {
+    VL_INSTRUMENT_CLASS(vl::PagedTerrain, Terrain)
+
+  public:
+    PagedTerrain();
+
+    //! Validates the parameters, discards all the loaded tiles and prepares the resources shared by the tiles.
+    //! Must be called with an active OpenGL context after setting the parameters and when they change.
+    void init();
+
+    virtual void extractVisibleActors(ActorCollection& list, const Camera* camera);
+
+    //! Appends the tiles selected by the last extractVisibleActors().
+    virtual void extractActors(ActorCollection& list);
+
+    virtual void computeBounds();
+
+    /** Loads up to \p max_count queued tiles, coarser tiles first. Can be called from any thread if a loadMutex() is installed.
+      * \return The number of tiles loaded. */
+    int processLoadRequests(int max_count);
+
+    //! Returns true if there are tiles waiting to be loaded.
+    bool hasLoadRequests() const;
+
+    //! The source of the tiles.
+    void setTileSource(TerrainTileSource* source) { mTileSource = source; }
+    //! The source of the tiles.
+    TerrainTileSource* tileSource() { return mTileSource.get(); }
+
+    //! The number of levels of the quadtree provided by the tileSource().
+    void setLevelCount(int count) { mLevelCount = count; }
+    //! The number of levels of the quadtree provided by the tileSource().
+    int levelCount() const { return mLevelCount; }
+
+    //! The maximum projected distance in pixels between two samples of a tile before it is refined (default is 2).
+    void setMaxPixelError(float pixels) { mMaxPixelError = pixels; }
+    //! The maximum projected distance in pixels between two samples of a tile before it is refined (default is 2).
+    float maxPixelError() const { return mMaxPixelError; }
+
+    //! The depth of the skirts hiding the cracks between the tiles, a negative value means 1% of height() (default is -1).
+    void setSkirtDepth(real depth) { mSkirtDepth = depth; }
+    //! The depth of the skirts hiding the cracks between the tiles, a negative value means 1% of height() (default is -1).
+    real skirtDepth() const { return mSkirtDepth; }
+
+    //! The maximum number of tiles kept in memory (default is 512).
+    void setTileCacheSize(int count) { mTileCacheSize = count; }
+    //! The maximum number of tiles kept in memory (default is 512).
+    int tileCacheSize() const { return mTileCacheSize; }
+
+    //! The maximum number of tiles loaded per frame when no loadMutex() is installed (default is 2).
+    void setMaxLoadsPerFrame(int count) { mMaxLoadsPerFrame = count; }
+    //! The maximum number of tiles loaded per frame when no loadMutex() is installed (default is 2).
+    int maxLoadsPerFrame() const { return mMaxLoadsPerFrame; }
+
+    //! The maximum number of loaded tiles whose rendering resources are created per frame (default is 8).
+    void setMaxUploadsPerFrame(int count) { mMaxUploadsPerFrame = count; }
+    //! The maximum number of loaded tiles whose rendering resources are created per frame (default is 8).
+    int maxUploadsPerFrame() const { return mMaxUploadsPerFrame; }
+
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    void setLoadMutex(IMutex* mutex) { mLoadMutex = mutex; }
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    IMutex* loadMutex() { return mLoadMutex; }
+
+    //! The number of tiles selected by the last extractVisibleActors().
+    int statsSelectedTiles() const { return (int)mSelected.size(); }
+    //! The number of tiles currently in memory.
+    int statsCachedTiles() const { return mStatsCachedTiles; }
+    //! The number of tiles waiting to be loaded.
+    int statsPendingTiles() const { return mStatsPendingTiles; }
+
+  protected:
+    enum ETileState { TS_Queued, TS_Loading, TS_Loaded, TS_Ready, TS_Failed };
+
+    class Tile: public Object
+    {
+    public:
+      Tile(int level, int x, int z): mLevel(level), mX(x), mZ(z), mState(TS_Queued), mLastUsedFrame(0), mMinY(0), mMaxY(0), mResolution(0) {}
+      int mLevel, mX, mZ;
+      ETileState mState;
+      unsigned mLastUsedFrame;
+      // filled by the loader
+      ref<Geometry> mGeometry;
+      ref<Image> mTexture;
+      real mMinY, mMaxY;
+      int mResolution;
+      // created by the rendering thread
+      ref<Actor> mActor;
+      ref<Uniform> mMorphFactor;
+    };
+
+    struct TileKey
+    {
+      TileKey(int level, int x, int z): mLevel(level), mX(x), mZ(z) {}
+      bool operator<(const TileKey& other) const
+      {
+        if (mLevel != other.mLevel) return mLevel < other.mLevel;
+        if (mX != other.mX) return mX < other.mX;
+        return mZ < other.mZ;
+      }
+      int mLevel, mX, mZ;
+    };
+
+    Tile* acquireTile(int level, int x, int z);
+    bool isTileReady(int level, int x, int z);
+    AABB tileBounds(int level, int x, int z) const;
+    void selectTile(int level, int x, int z, ActorCollection& list, const Camera* camera, real proj_factor, bool cull);
+    void loadTile(Tile* tile);
+    void finalizeLoadedTiles();
+    void cancelUnusedRequests();
+    void evictTiles();
+
+  protected:
+    ref<TerrainTileSource> mTileSource;
+    std::map< TileKey, ref<Tile> > mTiles;
+    std::deque<Tile*> mLoadQueue;   // protected by mLoadMutex
+    std::vector<Tile*> mLoadedTiles; // protected by mLoadMutex
+    ActorCollection mSelected;
+    ref<GLSLProgram> mGLSL;
+    ref<Texture> mDetailTex;
+    IMutex* mLoadMutex;
+    real mSkirtDepth;
+    float mMaxPixelError;
+    int mLevelCount;
+    int mTileCacheSize;
+    int mMaxLoadsPerFrame;
+    int mMaxUploadsPerFrame;
+    int mTileResolution;
+    unsigned mFrame;
+    int mStatsCachedTiles;
+    int mStatsPendingTiles;
+  };
+}
+
+#endif
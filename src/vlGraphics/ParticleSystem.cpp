@@ -0,0 +1,282 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/ParticleSystem.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Time.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cmath>
+
+using namespace vl;
+
+namespace
+{
+  // must match the structure declared by the particle shaders
+  struct GPUParticle
+  {
+    fvec4 mPosition;
+    fvec4 mVelocity;
+    fvec4 mColorBegin;
+    fvec4 mColorEnd;
+    fvec4 mSize;
+  };
+
+  const int ParticleWorkGroupSize = 64;
+}
+//------------------------------------------------------------------------------
+// ParticleEmitter
+//------------------------------------------------------------------------------
+ParticleEmitter::ParticleEmitter():
+  mColorBegin(1,1,1,1), mColorEnd(1,1,1,0), mExtent(0,0,0), mVelocity(0,1,0), mLifetime(1,2), mShape(PES_Point),
+  mVelocitySpread(0.5f), mRate(100), mSizeBegin(0.1f), mSizeEnd(0.1f), mAccumulator(0), mBurstCount(0), mEnabled(true)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+}
+//------------------------------------------------------------------------------
+int ParticleEmitter::takeSpawnCount(float dt)
+{
+  int count = mBurstCount;
+  mBurstCount = 0;
+  if ( mEnabled && mRate > 0 && dt > 0 )
+  {
+    mAccumulator += mRate * dt;
+    const int whole = (int)mAccumulator;
+    mAccumulator -= whole;
+    count += whole;
+  }
+  return count;
+}
+//------------------------------------------------------------------------------
+// ParticleSystem
+//------------------------------------------------------------------------------
+ParticleSystem::ParticleSystem(int capacity):
+  mGravity(0, -9.81f, 0), mDamping(0), mMaxTimeStep(0.1f), mCapacity(capacity), mAutoUpdate(true),
+  mLastUpdateTime(-1), mCursor(0), mSeed(0), mResetPending(false)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mEmitters = new Collection<ParticleEmitter>;
+  mParticleBuffer = new BufferObject;
+  // the particles are generated every frame, a display list would freeze them
+  setDisplayListEnabled(false);
+}
+//------------------------------------------------------------------------------
+ParticleSystem::~ParticleSystem()
+{
+  deleteBufferObject();
+}
+//------------------------------------------------------------------------------
+bool ParticleSystem::isSupported()
+{
+  return Has_Compute_Shader && Has_Shader_Storage_Buffer;
+}
+//------------------------------------------------------------------------------
+ref<Effect> ParticleSystem::createEffect()
+{
+  ref<Effect> fx = new Effect;
+  fx->shader()->enable(EN_DEPTH_TEST);
+  fx->shader()->enable(EN_BLEND);
+  fx->shader()->gocBlendFunc()->set(BF_SRC_ALPHA, BF_ONE);
+  fx->shader()->gocDepthMask()->set(false);
+  fx->shader()->gocGLSLProgram()->attachShader( new GLSLVertexShader("/glsl/particles.vs") );
+  fx->shader()->gocGLSLProgram()->attachShader( new GLSLFragmentShader("/glsl/particles.fs") );
+  return fx;
+}
+//------------------------------------------------------------------------------
+void ParticleSystem::deleteBufferObject()
+{
+  if ( mParticleBuffer )
+    mParticleBuffer->deleteBufferObject();
+}
+//------------------------------------------------------------------------------
+void ParticleSystem::computeBounds_Implementation()
+{
+  // the particles are on the GPU: bounds the space they can reach within their lifetime
+  AABB aabb;
+  for(int i=0; i<mEmitters->size(); ++i)
+  {
+    const ParticleEmitter* em = mEmitters->at(i);
+    const real life = std::max( em->lifetime().x(), em->lifetime().y() );
+    const fvec3 extent = em->shape() == PES_Sphere ? fvec3(em->extent().x(), em->extent().x(), em->extent().x()) :
+                         em->shape() == PES_Box    ? em->extent() : fvec3(0, 0, 0);
+    const vec3 reach = (vec3)extent + vec3(1,1,1) * ( ( em->velocity().length() + em->velocitySpread() ) * life +
+                       mGravity.length() * life * life * (real)0.5 + std::max( em->sizeBegin(), em->sizeEnd() ) );
+    aabb.addPoint( (vec3)em->position() - reach );
+    aabb.addPoint( (vec3)em->position() + reach );
+  }
+  setBoundingBox( aabb );
+  setBoundingSphere( aabb.isNull() ? Sphere() : Sphere(aabb) );
+}
+//------------------------------------------------------------------------------
+bool ParticleSystem::init() const
+{
+  if ( ! isSupported() )
+  {
+    Log::error("ParticleSystem requires OpenGL 4.3 or GL_ARB_compute_shader and GL_ARB_shader_storage_buffer_object.\n");
+    return false;
+  }
+
+  if ( ! mSpawnProgram )
+  {
+    mSpawnProgram = new GLSLProgram;
+    mSpawnProgram->setObjectName("ParticleSystem::spawnProgram");
+    mSpawnProgram->attachShader( new GLSLComputeShader("/glsl/particles_spawn.cs") );
+    mUpdateProgram = new GLSLProgram;
+    mUpdateProgram->setObjectName("ParticleSystem::updateProgram");
+    mUpdateProgram->attachShader( new GLSLComputeShader("/glsl/particles_update.cs") );
+  }
+
+  if ( ! mSpawnProgram->linked() && ! mSpawnProgram->linkProgram() )
+    return false;
+  if ( ! mUpdateProgram->linked() && ! mUpdateProgram->linkProgram() )
+    return false;
+
+  // (re)allocate the particles, all dead
+  const GLsizeiptr byte_count = (GLsizeiptr)mCapacity * sizeof(GPUParticle);
+  if ( mCapacity > 0 && ( mResetPending || mParticleBuffer->byteCountBufferObject() != byte_count ) )
+  {
+    std::vector<GPUParticle> particles( mCapacity );
+    mParticleBuffer->setBufferData( byte_count, &particles[0], BU_DYNAMIC_COPY );
+    mCursor = 0;
+    mResetPending = false;
+  }
+
+  return mParticleBuffer->handle() != 0;
+}
+//------------------------------------------------------------------------------
+void ParticleSystem::spawn(ParticleEmitter* em, int count) const
+{
+  // the exceeding particles would overwrite the ones just spawned
+  count = std::min( count, mCapacity );
+
+  const fvec3 extent = em->extent();
+  glUniform1ui( mSpawnProgram->getUniformLocation("vl_PSCapacity"), (GLuint)mCapacity ); VL_CHECK_OGL();
+  glUniform1ui( mSpawnProgram->getUniformLocation("vl_PSFirst"), mCursor ); VL_CHECK_OGL();
+  glUniform1ui( mSpawnProgram->getUniformLocation("vl_PSCount"), (GLuint)count ); VL_CHECK_OGL();
+  glUniform1ui( mSpawnProgram->getUniformLocation("vl_PSSeed"), mSeed++ ); VL_CHECK_OGL();
+  glUniform1i( mSpawnProgram->getUniformLocation("vl_PSShape"), (int)em->shape() ); VL_CHECK_OGL();
+  glUniform3fv( mSpawnProgram->getUniformLocation("vl_PSPosition"), 1, em->position().ptr() ); VL_CHECK_OGL();
+  glUniform3fv( mSpawnProgram->getUniformLocation("vl_PSExtent"), 1, extent.ptr() ); VL_CHECK_OGL();
+  glUniform3fv( mSpawnProgram->getUniformLocation("vl_PSVelocity"), 1, em->velocity().ptr() ); VL_CHECK_OGL();
+  glUniform1f( mSpawnProgram->getUniformLocation("vl_PSVelocitySpread"), em->velocitySpread() ); VL_CHECK_OGL();
+  glUniform2fv( mSpawnProgram->getUniformLocation("vl_PSLifetime"), 1, em->lifetime().ptr() ); VL_CHECK_OGL();
+  glUniform2f( mSpawnProgram->getUniformLocation("vl_PSSize"), em->sizeBegin(), em->sizeEnd() ); VL_CHECK_OGL();
+  glUniform4fv( mSpawnProgram->getUniformLocation("vl_PSColorBegin"), 1, em->colorBegin().ptr() ); VL_CHECK_OGL();
+  glUniform4fv( mSpawnProgram->getUniformLocation("vl_PSColorEnd"), 1, em->colorEnd().ptr() ); VL_CHECK_OGL();
+  glDispatchCompute( (count + ParticleWorkGroupSize - 1) / ParticleWorkGroupSize, 1, 1 ); VL_CHECK_OGL();
+
+  mCursor = (mCursor + count) % mCapacity;
+}
+//------------------------------------------------------------------------------
+bool ParticleSystem::update(OpenGLContext* gl_context, float dt) const
+{
+  VL_CHECK_OGL();
+
+  if ( mCapacity <= 0 || ! init() )
+    return false;
+
+  glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, mParticleBuffer->handle() ); VL_CHECK_OGL();
+
+  // new particles, each emitter with its own parameters
+  bool spawned = false;
+  for(int i=0; i<mEmitters->size(); ++i)
+  {
+    ParticleEmitter* em = (*mEmitters)[i].get();
+    const int count = em->takeSpawnCount(dt);
+    if ( count <= 0 )
+      continue;
+    if ( ! spawned )
+      gl_context->useGLSLProgram( mSpawnProgram.get() );
+    spawn( em, count );
+    spawned = true;
+  }
+  if ( spawned )
+  {
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT ); VL_CHECK_OGL();
+  }
+
+  // aging and motion
+  if ( dt > 0 )
+  {
+    gl_context->useGLSLProgram( mUpdateProgram.get() );
+    glUniform1ui( mUpdateProgram->getUniformLocation("vl_PSCapacity"), (GLuint)mCapacity ); VL_CHECK_OGL();
+    glUniform1f( mUpdateProgram->getUniformLocation("vl_PSTimeStep"), dt ); VL_CHECK_OGL();
+    glUniform3fv( mUpdateProgram->getUniformLocation("vl_PSGravity"), 1, mGravity.ptr() ); VL_CHECK_OGL();
+    glUniform1f( mUpdateProgram->getUniformLocation("vl_PSDamping"), mDamping ); VL_CHECK_OGL();
+    glDispatchCompute( (mCapacity + ParticleWorkGroupSize - 1) / ParticleWorkGroupSize, 1, 1 ); VL_CHECK_OGL();
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT ); VL_CHECK_OGL();
+  }
+
+  return true;
+}
+//------------------------------------------------------------------------------
+void ParticleSystem::render_Implementation(const Actor*, const Shader* shader, const Camera*, OpenGLContext* gl_context) const
+{
+  VL_CHECK_OGL();
+
+  if ( mCapacity <= 0 )
+    return;
+
+  // preserve the binding point used by the particles
+  GLint prev_buffer = 0, prev_start = 0, prev_size = 0;
+  glGetIntegeri_v( GL_SHADER_STORAGE_BUFFER_BINDING, 0, &prev_buffer ); VL_CHECK_OGL();
+  glGetIntegeri_v( GL_SHADER_STORAGE_BUFFER_START, 0, &prev_start ); VL_CHECK_OGL();
+  glGetIntegeri_v( GL_SHADER_STORAGE_BUFFER_SIZE, 0, &prev_size ); VL_CHECK_OGL();
+  gl_context->countGLQuery("GL_SHADER_STORAGE_BUFFER_BINDING");
+
+  if ( mAutoUpdate )
+  {
+    const double now = Time::currentTime();
+    const float dt = mLastUpdateTime < 0 ? 0.0f : (float)std::min( now - mLastUpdateTime, (double)mMaxTimeStep );
+    mLastUpdateTime = now;
+    update( gl_context, dt );
+    // restore the Shader's GLSLProgram
+    gl_context->useGLSLProgram( shader ? shader->glslProgram() : NULL );
+  }
+
+  if ( mParticleBuffer->handle() )
+  {
+    // one quad per particle, the vertex shader reads the particles from the buffer and collapses the dead ones
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, mParticleBuffer->handle() ); VL_CHECK_OGL();
+    gl_context->bindVAS( NULL, false, false );
+    glDrawArraysInstanced( GL_TRIANGLE_STRIP, 0, 4, mCapacity ); VL_CHECK_OGL();
+  }
+
+  if ( prev_buffer && prev_size > 0 )
+    glBindBufferRange( GL_SHADER_STORAGE_BUFFER, 0, prev_buffer, prev_start, prev_size );
+  else
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, prev_buffer );
+  VL_CHECK_OGL();
+  // glBindBufferBase() also binds the generic GL_SHADER_STORAGE_BUFFER binding point
+  VL_glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 ); VL_CHECK_OGL();
+}
+//------------------------------------------------------------------------------
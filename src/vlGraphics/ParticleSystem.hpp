@@ -0,0 +1,236 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef ParticleSystem_INCLUDE_ONCE
+#define ParticleSystem_INCLUDE_ONCE
+
+#include <vlGraphics/Renderable.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlCore/Collection.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // ParticleEmitter
+  //------------------------------------------------------------------------------
+  /**
+   * Describes where, how often and with which properties the particles of a ParticleSystem are born.
+   *
+   * Each particle starts in the region given by shape(), position() and extent() with velocity() plus a random vector
+   * of length up to velocitySpread(), lives a random time between the x and y of lifetime() and, during its life,
+   * goes from sizeBegin() to sizeEnd() and from colorBegin() to colorEnd().
+   * All the values are in the world coordinates of the particle system.
+   */
+  class VLGRAPHICS_EXPORT ParticleEmitter: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ParticleEmitter, Object)
+
+  public:
+    ParticleEmitter();
+
+    //! Returns the number of particles to spawn after \p dt seconds: rate() x \p dt (the fractional part is accumulated) plus the pending burst().
+    int takeSpawnCount(float dt);
+
+    //! Spawns \p count particles at the next update in addition to the ones given by rate().
+    void burst(int count) { mBurstCount += count; }
+
+    //! Whether the emitter spawns particles, the particles already born continue their life in any case.
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! The number of particles spawned per second.
+    void setRate(float particles_per_second) { mRate = particles_per_second; }
+    float rate() const { return mRate; }
+
+    //! The region where the particles are born.
+    void setShape(EParticleEmitterShape shape) { mShape = shape; }
+    EParticleEmitterShape shape() const { return mShape; }
+
+    //! The center of the region where the particles are born.
+    void setPosition(const fvec3& position) { mPosition = position; }
+    const fvec3& position() const { return mPosition; }
+
+    //! The half size of the PES_Box region, the x is the radius of the PES_Sphere region.
+    void setExtent(const fvec3& extent) { mExtent = extent; }
+    const fvec3& extent() const { return mExtent; }
+
+    //! The initial velocity of the particles in units per second.
+    void setVelocity(const fvec3& velocity) { mVelocity = velocity; }
+    const fvec3& velocity() const { return mVelocity; }
+
+    //! The maximum length of the random vector added to velocity().
+    void setVelocitySpread(float spread) { mVelocitySpread = spread; }
+    float velocitySpread() const { return mVelocitySpread; }
+
+    //! The minimum (x) and maximum (y) life of the particles in seconds.
+    void setLifetime(float min_seconds, float max_seconds) { mLifetime = fvec2(min_seconds, max_seconds); }
+    const fvec2& lifetime() const { return mLifetime; }
+
+    //! The size of the particles when they are born.
+    void setSizeBegin(float size) { mSizeBegin = size; }
+    float sizeBegin() const { return mSizeBegin; }
+
+    //! The size of the particles when they die.
+    void setSizeEnd(float size) { mSizeEnd = size; }
+    float sizeEnd() const { return mSizeEnd; }
+
+    //! The color of the particles when they are born.
+    void setColorBegin(const fvec4& color) { mColorBegin = color; }
+    const fvec4& colorBegin() const { return mColorBegin; }
+
+    //! The color of the particles when they die.
+    void setColorEnd(const fvec4& color) { mColorEnd = color; }
+    const fvec4& colorEnd() const { return mColorEnd; }
+
+  protected:
+    fvec4 mColorBegin;
+    fvec4 mColorEnd;
+    fvec3 mPosition;
+    fvec3 mExtent;
+    fvec3 mVelocity;
+    fvec2 mLifetime;
+    EParticleEmitterShape mShape;
+    float mVelocitySpread;
+    float mRate;
+    float mSizeBegin;
+    float mSizeEnd;
+    float mAccumulator;
+    int mBurstCount;
+    bool mEnabled;
+  };
+
+  //------------------------------------------------------------------------------
+  // ParticleSystem
+  //------------------------------------------------------------------------------
+  /**
+   * A Renderable simulating and drawing up to capacity() particles entirely on the GPU.
+   *
+   * The particles live in a shader storage buffer, see particleBuffer(), bound to the binding point 0 as an array of structures
+   * \p "{ vec4 position; vec4 velocity; vec4 color_begin; vec4 color_end; vec4 size; }", where \p position.w is the age,
+   * \p velocity.w the lifetime (0 for dead particles) and \p size.xy the begin and end sizes, see \p "/glsl/particles.vs".
+   * At every update a compute shader spawns the new particles of each ParticleEmitter, reusing the buffer as a ring, and another one
+   * ages and moves all of them under gravity() and damping(). The particles never travel to the CPU.
+   *
+   * The bounds are estimated from the emitters and gravity(), call setBoundsDirty() after changing the emitters.
+   *
+   * The particles are drawn as camera facing quads with one instance per particle, using the GLSLProgram of the Actor's Shader:
+   * createEffect() returns a ready to use Effect with additive blending. Since the particles are simulated in world coordinates
+   * the Actor should have no Transform.
+   *
+   * If autoUpdate() is true (the default) the simulation advances by the elapsed real time every time the particle system is rendered,
+   * otherwise call update() with the desired time step, for example from a RenderEventCallback.
+   * The binding point 0 of GL_SHADER_STORAGE_BUFFER is restored after the rendering.
+   *
+   * Requires OpenGL 4.3 or GL_ARB_compute_shader and GL_ARB_shader_storage_buffer_object.
+   * \sa ParticleEmitter, DispatchCompute
+   */
+  class VLGRAPHICS_EXPORT ParticleSystem: public Renderable
+  {
+    VL_INSTRUMENT_CLASS(vl::ParticleSystem, Renderable)
+
+  public:
+    ParticleSystem(int capacity=65536);
+
+    ~ParticleSystem();
+
+    //! Returns true if the current OpenGL context supports ParticleSystem.
+    static bool isSupported();
+
+    //! Returns a new Effect drawing the particles as soft round sprites with additive blending and no depth writes.
+    static ref<Effect> createEffect();
+
+    //! The emitters spawning the particles.
+    Collection<ParticleEmitter>* emitters() { return mEmitters.get(); }
+    const Collection<ParticleEmitter>* emitters() const { return mEmitters.get(); }
+
+    //! The maximum number of particles alive at the same time, when exceeded the oldest particles are replaced. Defaults to 65536.
+    void setCapacity(int capacity) { mCapacity = capacity; }
+    int capacity() const { return mCapacity; }
+
+    //! The acceleration applied to all the particles in units per second squared, defaults to (0, -9.81, 0).
+    void setGravity(const fvec3& gravity) { mGravity = gravity; setBoundsDirty(true); }
+    const fvec3& gravity() const { return mGravity; }
+
+    //! The fraction of velocity lost per second, defaults to 0.
+    void setDamping(float damping) { mDamping = damping; }
+    float damping() const { return mDamping; }
+
+    //! If true the simulation advances by the elapsed real time at every rendering, see update().
+    void setAutoUpdate(bool enabled) { mAutoUpdate = enabled; }
+    bool autoUpdate() const { return mAutoUpdate; }
+
+    //! The maximum time step of the automatic update, longer pauses are clamped. Defaults to 0.1 seconds.
+    void setMaxTimeStep(float seconds) { mMaxTimeStep = seconds; }
+    float maxTimeStep() const { return mMaxTimeStep; }
+
+    //! Spawns the new particles and advances the simulation by \p dt seconds, \p gl_context must be active.
+    //! \note The simulation GLSLProgram is left active, see OpenGLContext::useGLSLProgram(), and particleBuffer() bound to the binding point 0.
+    bool update(OpenGLContext* gl_context, float dt) const;
+
+    //! Kills all the particles at the next update.
+    void reset() { mResetPending = true; }
+
+    //! The shader storage buffer containing the particles, allocated at the first update.
+    const BufferObject* particleBuffer() const { return mParticleBuffer.get(); }
+
+    virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+
+    virtual void deleteBufferObject();
+
+  protected:
+    virtual void computeBounds_Implementation();
+    virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+    bool init() const;
+    void spawn(ParticleEmitter* emitter, int count) const;
+
+  protected:
+    // the emitters accumulate the particles to spawn while rendering
+    mutable ref< Collection<ParticleEmitter> > mEmitters;
+    fvec3 mGravity;
+    float mDamping;
+    float mMaxTimeStep;
+    int mCapacity;
+    bool mAutoUpdate;
+    // the simulation state changes while rendering
+    mutable ref<BufferObject> mParticleBuffer;
+    mutable ref<GLSLProgram> mSpawnProgram;
+    mutable ref<GLSLProgram> mUpdateProgram;
+    mutable double mLastUpdateTime;
+    mutable unsigned int mCursor;
+    mutable unsigned int mSeed;
+    mutable bool mResetPending;
+  };
+}
+
+#endif
@@ -0,0 +1,379 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/PickingRendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+namespace
+{
+  const char* PickVertexShader =
+    "#version 150\n"
+    "in vec4 vl_VertexPosition;\n"
+    "uniform mat4 vl_ModelViewProjectionMatrix;\n"
+    "void main(void)\n"
+    "{\n"
+    "  gl_Position = vl_ModelViewProjectionMatrix * vl_VertexPosition;\n"
+    "}\n";
+
+  const char* PickFragmentShader =
+    "#version 150\n"
+    "uniform uint vl_PickID;\n"
+    "out uvec2 vl_PickOutput;\n"
+    "void main(void)\n"
+    "{\n"
+    "  vl_PickOutput = uvec2(vl_PickID, uint(gl_PrimitiveID));\n"
+    "}\n";
+}
+
+//-----------------------------------------------------------------------------
+PickingRendering::PickingRendering()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+
+  mPickRadius = 2;
+  mPickX = 0;
+  mPickY = 0;
+  mPickRequested = false;
+  mPickResultAvailable = false;
+
+  mReadbackBuffer = new BufferObject;
+  mReadbackX = mReadbackY = mReadbackWidth = mReadbackHeight = 0;
+  mReadbackPickX = mReadbackPickY = 0;
+#if defined(VL_OPENGL)
+  mReadbackFence = NULL;
+#endif
+
+  mPickIDCallback = new PickIDCallback(this);
+  mPickRendererCallback = new PickRendererCallback(this);
+
+  // the ID buffer is cleared to 0, that is, no Actor
+  camera()->viewport()->setClearColorMode(CCM_UInt);
+  camera()->viewport()->setClearColorUInt(0, 0, 0, 0);
+
+  mPickProgram = new GLSLProgram;
+  mPickProgram->setObjectName("PickingRendering");
+  mPickProgram->attachShader( new GLSLVertexShader(PickVertexShader) );
+  mPickProgram->attachShader( new GLSLFragmentShader(PickFragmentShader) );
+  mPickProgram->bindFragDataLocation(0, "vl_PickOutput");
+
+  mPickEffect = new Effect;
+  mPickEffect->shader()->enable(EN_DEPTH_TEST);
+  mPickEffect->shader()->setRenderState(mPickProgram.get());
+
+  // overrides the Effect of every Actor
+  effectOverrideMask()[0xFFFFFFFF] = mPickEffect;
+}
+//-----------------------------------------------------------------------------
+PickingRendering::~PickingRendering()
+{
+#if defined(VL_OPENGL)
+  if ( mReadbackFence )
+  {
+    glDeleteSync( mReadbackFence );
+    mReadbackFence = NULL;
+  }
+#endif
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::initFramebuffer(OpenGLContext* gl_context)
+{
+  VL_CHECK(gl_context);
+
+  ref<FramebufferObject> fbo = gl_context->createFramebufferObject(1, 1, RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT0);
+  fbo->addColorAttachment( AP_COLOR_ATTACHMENT0, new FBOColorBufferAttachment(CBF_RG32UI) );
+  fbo->addDepthAttachment( new FBODepthBufferAttachment(DBF_DEPTH_COMPONENT24) );
+  renderer()->setFramebuffer( fbo.get() );
+}
+//-----------------------------------------------------------------------------
+bool PickingRendering::pickPending() const
+{
+#if defined(VL_OPENGL)
+  return mPickRequested || mReadbackFence != NULL;
+#else
+  return mPickRequested;
+#endif
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::render()
+{
+  // collect the result of a previous pick, if ready.
+  resolvePick();
+
+  if ( !mPickRequested || enableMask() == 0 )
+    return;
+
+#if defined(VL_OPENGL)
+  // wait for the previous readback to complete, the request is kept for the following frames.
+  if ( mReadbackFence )
+    return;
+
+  if ( !sourceCamera() || !sourceCamera()->viewport() || !renderer() || !cast<FramebufferObject>(renderer()->framebuffer()) )
+  {
+    Log::error("PickingRendering::render(): no source camera or no framebuffer object, see setSourceCamera() and initFramebuffer().\n");
+    VL_TRAP();
+    mPickRequested = false;
+    return;
+  }
+
+  // requires integer color buffers, gl_PrimitiveID in the fragment shader and sync objects.
+  if ( !(Has_GL_Version_3_2||Has_GL_Version_4_0) || !Has_PBO || !glFenceSync )
+  {
+    Log::error("PickingRendering::render(): OpenGL 3.2 required.\n");
+    mPickRequested = false;
+    mPickResult = PickResult();
+    mPickResult.mX = mPickX;
+    mPickResult.mY = mPickY;
+    mPickResultAvailable = true;
+    return;
+  }
+
+  // follow the source camera
+  const Viewport* src_viewport = sourceCamera()->viewport();
+  const int w = src_viewport->width();
+  const int h = src_viewport->height();
+  if ( w <= 0 || h <= 0 )
+    return;
+
+  camera()->viewport()->set( 0, 0, w, h );
+  camera()->setFOV( sourceCamera()->fov() );
+  camera()->setNearPlane( sourceCamera()->nearPlane() );
+  camera()->setFarPlane( sourceCamera()->farPlane() );
+  camera()->setProjectionMatrix( sourceCamera()->projectionMatrix(), sourceCamera()->projectionMatrixType() );
+  camera()->setModelingMatrix( sourceCamera()->modelingMatrix() );
+
+  Framebuffer* fbo = renderer()->framebuffer();
+  if ( fbo->width() != w || fbo->height() != h )
+  {
+    fbo->setWidth( w );
+    fbo->setHeight( h );
+  }
+
+  // the IDs are assigned once the render queue has been filled.
+  if ( renderer()->onStartedCallbacks()->find( mPickRendererCallback.get() ) == -1 )
+    renderer()->onStartedCallbacks()->push_back( mPickRendererCallback.get() );
+  if ( renderer()->onFinishedCallbacks()->find( mPickRendererCallback.get() ) == -1 )
+    renderer()->onFinishedCallbacks()->push_back( mPickRendererCallback.get() );
+
+  mReadbackPickX = mPickX - src_viewport->x();
+  mReadbackPickY = mPickY - src_viewport->y();
+  mPickRequested = false;
+
+  Rendering::render();
+#else
+  mPickRequested = false;
+#endif
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::setCustomPickEffect(Effect* effect, Effect* pick_effect)
+{
+  VL_CHECK(effect)
+  if ( pick_effect )
+    mCustomPickEffects[effect] = pick_effect;
+  else
+    mCustomPickEffects.erase(effect);
+}
+//-----------------------------------------------------------------------------
+Effect* PickingRendering::customPickEffect(Effect* effect)
+{
+  std::map< ref<Effect>, ref<Effect> >::iterator it = mCustomPickEffects.find(effect);
+  return it != mCustomPickEffects.end() ? it->second.get() : mPickEffect.get();
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::beginPickIDs()
+{
+  mPickIDs.clear();
+  mPickActors.clear();
+  for( int i=0; i<renderQueue()->size(); ++i )
+  {
+    RenderToken* tok = renderQueue()->at(i);
+    Actor* actor = tok->mActor;
+
+    // the render queue has been filled with pickEffect(): replace it with the custom pick Effect of the Actor, if any.
+    if ( !mCustomPickEffects.empty() )
+    {
+      std::map< ref<Effect>, ref<Effect> >::iterator it = mCustomPickEffects.find( actor->effect() );
+      if ( it != mCustomPickEffects.end() )
+        tok->mShader = it->second->shader();
+    }
+
+    if ( mPickIDs.find(actor) != mPickIDs.end() )
+      continue;
+    mPickActors.push_back( actor );
+    mPickIDs[actor] = (unsigned int)mPickActors.size();
+    actor->actorEventCallbacks()->push_back( mPickIDCallback.get() );
+  }
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::PickIDCallback::onActorRenderStarted(Actor* actor, real, const Camera*, Renderable*, const Shader* shader, int)
+{
+  // our own program or a custom pick Effect's one, see setCustomPickEffect()
+  const GLSLProgram* glsl = shader->glslProgram();
+  if ( !glsl || ( glsl != mOwner->mPickProgram.get() && mOwner->mCustomPickEffects.empty() ) )
+    return;
+
+  std::map<const Actor*, unsigned int>::const_iterator it = mOwner->mPickIDs.find(actor);
+  if ( it == mOwner->mPickIDs.end() )
+    return;
+
+  int location = glsl->getUniformLocation("vl_PickID");
+  if ( location != -1 )
+  {
+    GLuint id = it->second;
+    VL_glUniform1uiv( location, 1, &id ); VL_CHECK_OGL();
+  }
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::endPickIDs()
+{
+  for( size_t i=0; i<mPickActors.size(); ++i )
+    mPickActors[i]->actorEventCallbacks()->erase( mPickIDCallback.get() );
+  mPickIDs.clear();
+
+#if defined(VL_OPENGL)
+  const int w = camera()->viewport()->width();
+  const int h = camera()->viewport()->height();
+
+  // clip the region around the cursor to the viewport
+  int x0 = vl::max( mReadbackPickX - mPickRadius, 0 );
+  int y0 = vl::max( mReadbackPickY - mPickRadius, 0 );
+  int x1 = vl::min( mReadbackPickX + mPickRadius, w - 1 );
+  int y1 = vl::min( mReadbackPickY + mPickRadius, h - 1 );
+  if ( x1 < x0 || y1 < y0 )
+  {
+    // outside the viewport: nothing can be picked
+    mPickResult = PickResult();
+    mPickResult.mX = mReadbackPickX;
+    mPickResult.mY = mReadbackPickY;
+    mPickResultAvailable = true;
+    mPickActors.clear();
+    return;
+  }
+
+  mReadbackX = x0;
+  mReadbackY = y0;
+  mReadbackWidth  = x1 - x0 + 1;
+  mReadbackHeight = y1 - y0 + 1;
+
+  GLsizeiptr bytes = mReadbackWidth * mReadbackHeight * 2 * sizeof(GLuint);
+  if ( mReadbackBuffer->byteCountBufferObject() != bytes )
+    mReadbackBuffer->setBufferData( bytes, NULL, BU_STREAM_READ );
+
+  renderer()->framebuffer()->bindFramebuffer( FBB_READ_FRAMEBUFFER );
+  glReadBuffer( GL_COLOR_ATTACHMENT0 ); VL_CHECK_OGL();
+  glPixelStorei( GL_PACK_ALIGNMENT, 4 ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, mReadbackBuffer->handle() ); VL_CHECK_OGL();
+  glReadPixels( mReadbackX, mReadbackY, mReadbackWidth, mReadbackHeight, GL_RG_INTEGER, GL_UNSIGNED_INT, 0 ); VL_CHECK_OGL();
+  VL_glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 ); VL_CHECK_OGL();
+  mReadbackFence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ); VL_CHECK_OGL();
+
+  // the IDs refer to this frame's Actors, keep them alive until the readback is resolved.
+  mReadbackActors.swap( mPickActors );
+#endif
+  mPickActors.clear();
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::resolvePick()
+{
+#if defined(VL_OPENGL)
+  if ( !mReadbackFence )
+    return;
+
+  // never wait for the GPU: try again the next frame.
+  GLenum status = glClientWaitSync( mReadbackFence, 0, 0 ); VL_CHECK_OGL();
+  if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+    return;
+
+  glDeleteSync( mReadbackFence ); VL_CHECK_OGL();
+  mReadbackFence = NULL;
+
+  mPickResult = PickResult();
+  mPickResult.mX = mReadbackPickX + ( sourceCamera() && sourceCamera()->viewport() ? sourceCamera()->viewport()->x() : 0 );
+  mPickResult.mY = mReadbackPickY + ( sourceCamera() && sourceCamera()->viewport() ? sourceCamera()->viewport()->y() : 0 );
+  mPickResultAvailable = true;
+
+  const GLuint* data = (const GLuint*)mReadbackBuffer->mapBufferObject(BA_READ_ONLY);
+  if (!data)
+  {
+    Log::error("PickingRendering::resolvePick(): could not map the readback buffer.\n");
+    mReadbackActors.clear();
+    return;
+  }
+
+  // select the covered pixel closest to the cursor
+  int best_dist = -1;
+  for( int y=0; y<mReadbackHeight; ++y )
+  {
+    for( int x=0; x<mReadbackWidth; ++x )
+    {
+      const GLuint* texel = data + ( y*mReadbackWidth + x ) * 2;
+      if ( texel[0] == 0 || texel[0] > mReadbackActors.size() )
+        continue;
+      int dx = mReadbackX + x - mReadbackPickX;
+      int dy = mReadbackY + y - mReadbackPickY;
+      int dist = dx*dx + dy*dy;
+      if ( best_dist == -1 || dist < best_dist )
+      {
+        best_dist = dist;
+        mPickResult.mActor = mReadbackActors[ texel[0] - 1 ];
+        mPickResult.mPrimitiveID = (int)texel[1];
+      }
+    }
+  }
+
+  mReadbackBuffer->unmapBufferObject();
+  mReadbackActors.clear();
+#endif
+}
+//-----------------------------------------------------------------------------
+void PickingRendering::releaseBufferObjects()
+{
+#if defined(VL_OPENGL)
+  if ( mReadbackFence )
+  {
+    glDeleteSync( mReadbackFence ); VL_CHECK_OGL();
+    mReadbackFence = NULL;
+  }
+#endif
+  mReadbackActors.clear();
+  mReadbackBuffer->deleteBufferObject();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,222 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef PickingRendering_INCLUDE_ONCE
+#define PickingRendering_INCLUDE_ONCE
+
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <map>
+#include <vector>
+
+namespace vl
+{
+  class OpenGLContext;
+  class GLSLProgram;
+  //-----------------------------------------------------------------------------
+  // PickingRendering
+  //-----------------------------------------------------------------------------
+  /** A Rendering that performs GPU picking by rendering Actor and primitive IDs to an integer framebuffer object.
+    *
+    * When a pick is requested with requestPick() the scene is rendered from the point of view of the sourceCamera()
+    * using a single override Effect (see Rendering::effectOverrideMask()) whose GLSL program writes to a \p GL_RG32UI
+    * color attachment the ID of the Actor being rendered in the red channel and \p gl_PrimitiveID in the green channel.
+    * A small region around the cursor is then copied into a pixel buffer object and fenced; the copy is mapped only
+    * once the GPU has completed it, without ever stalling, so that the result is usually available at the following frame.
+    * The picked Actor is the one covering the pixel closest to the cursor within pickRadius().
+    *
+    * Unlike RayIntersector the cost of a pick does not depend on the geometric complexity of the scene and the result
+    * matches exactly what is rasterized, including per-pixel depth testing.
+    *
+    * Usage:
+    * - add the same SceneManager[s] used by the main Rendering to sceneManagers()
+    * - call initFramebuffer() once with the OpenGLContext used for the rendering
+    * - call setSourceCamera() with the main camera and add the PickingRendering after the main Rendering in a RenderingTree
+    * - call requestPick() on mouse events and check pickResultAvailable() and pickResult() at the following frames.
+    *
+    * \note
+    * - The primitive ID is the index of the primitive within the draw call that rendered it, i.e. the triangle index for
+    *   a Geometry using a single triangle DrawCall.
+    * - Actor vertex programs, such as skinning or displacement, are overridden too and are not taken into account
+    *   unless a matching pick Effect is provided with setCustomPickEffect().
+    * - Requires OpenGL 3.2, if not available requestPick() produces empty results.
+    * \sa RayIntersector */
+  class VLGRAPHICS_EXPORT PickingRendering: public Rendering
+  {
+    VL_INSTRUMENT_CLASS(vl::PickingRendering, Rendering)
+
+  public:
+    /** The result of a pick. */
+    class PickResult
+    {
+    public:
+      PickResult(): mPrimitiveID(-1), mX(0), mY(0) {}
+
+      /** The Actor under the cursor or NULL if nothing was picked. */
+      ref<Actor> mActor;
+      /** The index of the picked primitive within its draw call or -1 if nothing was picked. */
+      int mPrimitiveID;
+      /** The coordinates that were passed to requestPick(). */
+      int mX, mY;
+    };
+
+  public:
+    /** Constructor. */
+    PickingRendering();
+
+    /** Destructor. */
+    ~PickingRendering();
+
+    /** Renders the picking IDs if a pick has been requested and collects the result of previous picks. */
+    virtual void render();
+
+    /** Creates the framebuffer object with an integer color attachment and a depth attachment used by the picking
+      * and installs it as the Framebuffer of renderer(). The framebuffer object is resized automatically to match
+      * the viewport of the sourceCamera(). */
+    void initFramebuffer(OpenGLContext* gl_context);
+
+    /** The Camera whose view, projection and viewport size are used to render the picking IDs. */
+    void setSourceCamera(Camera* camera) { mSourceCamera = camera; }
+
+    /** The Camera whose view, projection and viewport size are used to render the picking IDs. */
+    Camera* sourceCamera() { return mSourceCamera.get(); }
+
+    /** The Camera whose view, projection and viewport size are used to render the picking IDs. */
+    const Camera* sourceCamera() const { return mSourceCamera.get(); }
+
+    /** Requests a pick at the given framebuffer coordinates (origin at the bottom left) of the sourceCamera()'s viewport.
+      * The scene is rendered at the next render() and the result becomes available as soon as the GPU completes the readback.
+      * A new request replaces a pending one that has not been rendered yet. */
+    void requestPick(int x, int y) { mPickRequested = true; mPickX = x; mPickY = y; }
+
+    /** Returns true if a pick has been requested but its result is not yet available. */
+    bool pickPending() const;
+
+    /** The radius in pixels of the region around the cursor that is searched for an Actor. Defaults to 2. */
+    void setPickRadius(int radius) { mPickRadius = radius < 0 ? 0 : radius; }
+
+    /** The radius in pixels of the region around the cursor that is searched for an Actor. Defaults to 2. */
+    int pickRadius() const { return mPickRadius; }
+
+    /** Returns true if the result of a pick is available, see pickResult(). */
+    bool pickResultAvailable() const { return mPickResultAvailable; }
+
+    /** The result of the last pick completed, valid only if pickResultAvailable() is true. */
+    const PickResult& pickResult() const { return mPickResult; }
+
+    /** Marks the current pick result as consumed, pickResultAvailable() returns false until the next pick completes. */
+    void clearPickResult() { mPickResultAvailable = false; mPickResult = PickResult(); }
+
+    /** The override Effect used to render the picking IDs, which can be used to adjust its render states. */
+    Effect* pickEffect() { return mPickEffect.get(); }
+
+    /** The override Effect used to render the picking IDs, which can be used to adjust its render states. */
+    const Effect* pickEffect() const { return mPickEffect.get(); }
+
+    /** Renders the Actors using \p effect with \p pick_effect instead of pickEffect(), NULL removes the association.
+      * This allows Actors whose shape is generated by their own shaders, such as geometry shader impostors, to be picked exactly.
+      * The GLSL program of \p pick_effect must declare \p "uniform uint vl_PickID" and write \p uvec2(vl_PickID, primitive_id)
+      * to the \p vl_PickOutput output bound to the fragment data location 0. */
+    void setCustomPickEffect(Effect* effect, Effect* pick_effect);
+
+    /** The Effect used to render the picking IDs of the Actors using \p effect, pickEffect() if none was set with setCustomPickEffect(). */
+    Effect* customPickEffect(Effect* effect);
+
+    /** Discards any pick in flight and releases the pixel buffer object used for the readback. Must be called with the OpenGL context current. */
+    void releaseBufferObjects();
+
+  protected:
+    /** Assigns an ID to each Actor in the render queue and installs the callback uploading it. */
+    void beginPickIDs();
+
+    /** Removes the ID callbacks and starts the asynchronous readback of the region around the cursor. */
+    void endPickIDs();
+
+    /** Resolves the pick result if the readback issued during a previous frame has completed. */
+    void resolvePick();
+
+    // uploads the ID of each Actor being rendered
+    class PickIDCallback: public ActorEventCallback
+    {
+    public:
+      PickIDCallback(PickingRendering* owner): mOwner(owner) {}
+      virtual void onActorRenderStarted(Actor* actor, real frame_clock, const Camera* cam, Renderable* renderable, const Shader* shader, int pass);
+      virtual void onActorDelete(Actor*) {}
+    private:
+      PickingRendering* mOwner;
+    };
+
+    // brackets the rendering of the renderer() to assign the IDs and start the readback
+    class PickRendererCallback: public RenderEventCallback
+    {
+    public:
+      PickRendererCallback(PickingRendering* owner): mOwner(owner) {}
+      virtual bool onRenderingStarted(const RenderingAbstract*) { return false; }
+      virtual bool onRenderingFinished(const RenderingAbstract*) { return false; }
+      virtual bool onRendererStarted(const RendererAbstract*) { mOwner->beginPickIDs(); return false; }
+      virtual bool onRendererFinished(const RendererAbstract*) { mOwner->endPickIDs(); return false; }
+    private:
+      PickingRendering* mOwner;
+    };
+
+  protected:
+    ref<Camera> mSourceCamera;
+    ref<Effect> mPickEffect;
+    ref<GLSLProgram> mPickProgram;
+    ref<PickIDCallback> mPickIDCallback;
+    ref<PickRendererCallback> mPickRendererCallback;
+    std::map<const Actor*, unsigned int> mPickIDs;
+    std::vector< ref<Actor> > mPickActors;
+    std::map< ref<Effect>, ref<Effect> > mCustomPickEffects;
+    PickResult mPickResult;
+    int mPickRadius;
+    int mPickX;
+    int mPickY;
+    bool mPickRequested;
+    bool mPickResultAvailable;
+
+  private:
+    // readback in flight
+    ref<BufferObject> mReadbackBuffer;
+    std::vector< ref<Actor> > mReadbackActors;
+    int mReadbackX, mReadbackY, mReadbackWidth, mReadbackHeight;
+    int mReadbackPickX, mReadbackPickY;
+#if defined(VL_OPENGL)
+    GLsync mReadbackFence;
+#endif
+  };
+  //-----------------------------------------------------------------------------
+}
+
+#endif
@@ -31,39 +31,111 @@
 
 #include <vlGraphics/PolygonSimplifier.hpp>
 #include <vlGraphics/DoubleVertexRemover.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/ScreenErrorLODEvaluator.hpp>
 #include <vlCore/Time.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
-#include <set>
+#include <map>
 
 using namespace vl;
 
 //-----------------------------------------------------------------------------
 namespace
 {
-  class VertexPtrWrapper
+  //! Binary min-heap of vertices ordered by collapse cost, stored in a contiguous array.
+  //! The heap position of each vertex is tracked by its original index so that arbitrary vertices can be removed in O(log n).
+  class VertexHeap
   {
   public:
-    VertexPtrWrapper(PolygonSimplifier::Vertex* ptr=NULL): mVertex(ptr) {}
+    typedef PolygonSimplifier::Vertex Vertex;
 
-    bool operator==(const VertexPtrWrapper& other) const
+    void reset(size_t vert_count)
     {
-      return mVertex == other.mVertex;
+      mHeap.clear();
+      mHeap.reserve(vert_count);
+      mPosition.assign(vert_count, -1);
     }
 
-    bool operator!=(const VertexPtrWrapper& other) const
+    int size() const { return (int)mHeap.size(); }
+
+    Vertex* top() const { return mHeap[0]; }
+
+    //! Does nothing if the vertex is already in the heap.
+    void insert(Vertex* v)
     {
-      return mVertex == other.mVertex;
+      if (mPosition[v->originalIndex()] != -1)
+        return;
+      mHeap.push_back(v);
+      mPosition[v->originalIndex()] = (int)mHeap.size() - 1;
+      siftUp( (int)mHeap.size() - 1 );
     }
 
-    bool operator<(const VertexPtrWrapper& other) const
+    //! Does nothing if the vertex is not in the heap.
+    void erase(Vertex* v)
     {
-      if ( mVertex->collapseCost() != other.mVertex->collapseCost() )
-        return mVertex->collapseCost() < other.mVertex->collapseCost();
+      int i = mPosition[v->originalIndex()];
+      if (i == -1)
+        return;
+      mPosition[v->originalIndex()] = -1;
+      Vertex* last = mHeap.back();
+      mHeap.pop_back();
+      if (i < (int)mHeap.size())
+      {
+        mHeap[i] = last;
+        mPosition[last->originalIndex()] = i;
+        siftUp(i);
+        siftDown( mPosition[last->originalIndex()] );
+      }
+    }
+
+  private:
+    // same ordering as the previous std::set based implementation: the pointer breaks the ties.
+    static bool less(const Vertex* a, const Vertex* b)
+    {
+      if ( a->collapseCost() != b->collapseCost() )
+        return a->collapseCost() < b->collapseCost();
       else
-        return mVertex < other.mVertex;
+        return a < b;
     }
-    PolygonSimplifier::Vertex* mVertex;
+
+    void siftUp(int i)
+    {
+      Vertex* v = mHeap[i];
+      while(i > 0)
+      {
+        int parent = (i - 1) / 2;
+        if ( !less(v, mHeap[parent]) )
+          break;
+        mHeap[i] = mHeap[parent];
+        mPosition[mHeap[i]->originalIndex()] = i;
+        i = parent;
+      }
+      mHeap[i] = v;
+      mPosition[v->originalIndex()] = i;
+    }
+
+    void siftDown(int i)
+    {
+      Vertex* v = mHeap[i];
+      const int count = (int)mHeap.size();
+      for(int child = 2*i + 1; child < count; child = 2*i + 1)
+      {
+        if ( child + 1 < count && less(mHeap[child + 1], mHeap[child]) )
+          ++child;
+        if ( !less(mHeap[child], v) )
+          break;
+        mHeap[i] = mHeap[child];
+        mPosition[mHeap[i]->originalIndex()] = i;
+        i = child;
+      }
+      mHeap[i] = v;
+      mPosition[v->originalIndex()] = i;
+    }
+
+  private:
+    std::vector<Vertex*> mHeap;
+    std::vector<int> mPosition;
   };
 }
 //-----------------------------------------------------------------------------
@@ -149,9 +221,12 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
   Time timer;
   timer.start();
 
-  // sort simplification targets 1.0 -> 0.0
-  std::sort(mTargets.begin(), mTargets.end());
-  std::reverse(mTargets.begin(), mTargets.end());
+  // collect the simplification targets and sort them 1.0 -> 0.0
+  std::vector<u32> targets = mTargets;
+  for(size_t i=0; i<mTargetRatios.size(); ++i)
+    targets.push_back( (u32)(mTargetRatios[i] * in_verts.size()) );
+  std::sort(targets.begin(), targets.end());
+  std::reverse(targets.begin(), targets.end());
 
   mSimplifiedVertices.clear();
   mSimplifiedTriangles.clear();
@@ -265,18 +340,19 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
   if (verbose())
     Log::print(Say("database setup = %.3n\n") << timer.elapsed() );
 
-  std::set<VertexPtrWrapper> vertex_set;
+  VertexHeap vertex_heap;
+  vertex_heap.reset( in_verts.size() );
   for(int ivert=0; ivert<(int)mSimplifiedVertices.size(); ++ivert)
     if ( !mSimplifiedVertices[ivert]->mProtected )
-      vertex_set.insert( mSimplifiedVertices[ivert] );
+      vertex_heap.insert( mSimplifiedVertices[ivert] );
 
   if (verbose())
     Log::print(Say("heap setup = %.3n\n") << timer.elapsed() );
 
   // loop through the simplification targets
-  for(size_t itarget=0, remove_order=0; itarget<mTargets.size(); ++itarget)
+  for(size_t itarget=0, remove_order=0; itarget<targets.size(); ++itarget)
   {
-    const int target_vertex_count = mTargets[itarget];
+    const int target_vertex_count = targets[itarget];
 
     if (target_vertex_count < 3)
     {
@@ -287,12 +363,11 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
     timer.start(1);
 
     std::vector< PolygonSimplifier::Vertex* > adj_verts;
-    for( ; (int)vertex_set.size()>target_vertex_count; ++remove_order )
+    for( ; vertex_heap.size()>target_vertex_count; ++remove_order )
     {
-      std::set<VertexPtrWrapper>::iterator it = vertex_set.begin();
-      PolygonSimplifier::Vertex* v = it->mVertex;
+      PolygonSimplifier::Vertex* v = vertex_heap.top();
       v->mRemoveOrder = (int)remove_order;
-      vertex_set.erase(it);
+      vertex_heap.erase(v);
 
       // remove the adjacent vertices to v and v->collapseVert()
       adj_verts.clear();
@@ -303,14 +378,14 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
 
         adj_verts.push_back( v->adjacentVertex(i) );
         adj_verts.back()->mAlreadyProcessed = true;
-        vertex_set.erase( v->adjacentVertex(i) );
+        vertex_heap.erase( v->adjacentVertex(i) );
       }
       for(int i=0; i<v->collapseVertex()->adjacentVerticesCount(); ++i)
       {
         if ( !v->collapseVertex()->adjacentVertex(i)->mAlreadyProcessed )
         {
           adj_verts.push_back( v->collapseVertex()->adjacentVertex(i) );
-          vertex_set.erase( v->collapseVertex()->adjacentVertex(i) );
+          vertex_heap.erase( v->collapseVertex()->adjacentVertex(i) );
         }
       }
 
@@ -335,13 +410,14 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
         VL_CHECK( adj_verts[i]->collapseVertex() != v )
         VL_CHECK( !adj_verts[i]->collapseVertex()->removed() )
 
-        vertex_set.insert( adj_verts[i] );
+        vertex_heap.insert( adj_verts[i] );
       }
     }
 
     if (verbose())
       Log::print(Say("simplification = %.3ns (%.3ns)\n") << timer.elapsed() << timer.elapsed(1) );
 
+    mOutputErrors.push_back( computeOutputError(in_verts) );
     outputSimplifiedGeometry();
   }
 
@@ -355,6 +431,23 @@ void PolygonSimplifier::simplify(const std::vector<fvec3>& in_verts, const std::
   }
 }
 //-----------------------------------------------------------------------------
+float PolygonSimplifier::computeOutputError(const std::vector<fvec3>& in_verts) const
+{
+  float max_dist2 = 0;
+  for(int i=0; i<(int)mSimplifiedVertices.size(); ++i)
+  {
+    // follow the collapses up to the surviving vertex
+    const Vertex* v = mSimplifiedVertices[i];
+    while( v->mRemoved && v->mCollapseVertex )
+      v = v->mCollapseVertex;
+    if ( v->mRemoved )
+      continue;
+    float dist2 = (in_verts[ mSimplifiedVertices[i]->mOriginalIndex ] - v->mPosition).lengthSquared();
+    max_dist2 = dist2 > max_dist2 ? dist2 : max_dist2;
+  }
+  return ::sqrt(max_dist2);
+}
+//-----------------------------------------------------------------------------
 void PolygonSimplifier::outputSimplifiedGeometry()
 {
   // count vertices required
@@ -405,6 +498,65 @@ void PolygonSimplifier::outputSimplifiedGeometry()
   mOutput.back()->drawCalls().push_back( de.get() );
 }
 //-----------------------------------------------------------------------------
+void PolygonSimplifier::generateLODs(ActorCollection* actors, const std::vector<float>& ratios, int thread_count, bool install_evaluators)
+{
+  // collect the unique geometries
+  std::vector< ref<Geometry> > geoms;
+  std::map< Geometry*, int > geom_index;
+  for(int i=0; i<actors->size(); ++i)
+  {
+    Geometry* geom = cast<Geometry>( actors->at(i)->lod(0) );
+    if ( geom && geom_index.find(geom) == geom_index.end() )
+    {
+      geom_index[geom] = (int)geoms.size();
+      geoms.push_back(geom);
+    }
+  }
+
+  // each Geometry is simplified independently by its own PolygonSimplifier
+  std::vector< std::vector< ref<Geometry> > > lods( geoms.size() );
+  std::vector< std::vector<float> > errors( geoms.size() );
+  const int geom_count = (int)geoms.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(thread_count) if(thread_count > 1)
+#else
+  (void)thread_count;
+#endif
+  for(int i=0; i<geom_count; ++i)
+  {
+    PolygonSimplifier simplifier;
+    simplifier.setVerbose(false);
+    simplifier.setIntput( geoms[i].get() );
+    simplifier.targetRatios() = ratios;
+    simplifier.simplify();
+    lods[i] = simplifier.output();
+    errors[i] = simplifier.outputErrors();
+  }
+
+  // install the LODs
+  for(int i=0; i<actors->size(); ++i)
+  {
+    Actor* actor = actors->at(i);
+    Geometry* geom = cast<Geometry>( actor->lod(0) );
+    if (!geom)
+      continue;
+    std::vector< ref<Geometry> >& geom_lods = lods[ geom_index[geom] ];
+    for(int ilod=0; ilod<(int)geom_lods.size() && ilod+1<VL_MAX_ACTOR_LOD; ++ilod)
+      actor->setLod( ilod+1, geom_lods[ilod].get() );
+
+    if (install_evaluators)
+    {
+      // the evaluator keeps per-Actor state so it cannot be shared
+      ref<ScreenErrorLODEvaluator> evaluator = new ScreenErrorLODEvaluator;
+      const std::vector<float>& geom_errors = errors[ geom_index[geom] ];
+      evaluator->geometricErrors().push_back( 0 );
+      for(int ilod=0; ilod<(int)geom_errors.size() && ilod+1<VL_MAX_ACTOR_LOD; ++ilod)
+        evaluator->geometricErrors().push_back( geom_errors[ilod] );
+      actor->setLODEvaluator( evaluator.get() );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 void PolygonSimplifier::clearTrianglesAndVertices()
 {
   mSimplifiedVertices.clear();
@@ -42,6 +42,7 @@
 namespace vl
 {
   class Geometry;
+  class ActorCollection;
 //-----------------------------------------------------------------------------
 // PolygonSimplifier
 //-----------------------------------------------------------------------------
@@ -327,12 +328,23 @@ namespace vl
     Geometry* input() { return mInput.get(); }
     const Geometry* input() const { return mInput.get(); }
 
+    //! The simplification targets expressed as vertex counts. Each target generates a new Geometry in output().
     std::vector< u32 >& targets() { return mTargets; }
     const std::vector< u32 >& targets() const { return mTargets; }
 
+    //! The simplification targets expressed as a fraction of the input vertex count, ie 0.5 generates a Geometry with half the vertices.
+    //! They are added to targets() at the beginning of each simplify() and all the targets are generated in a single run.
+    std::vector< float >& targetRatios() { return mTargetRatios; }
+    const std::vector< float >& targetRatios() const { return mTargetRatios; }
+
     std::vector< ref<Geometry> >& output() { return mOutput; }
     const std::vector< ref<Geometry> >& output() const { return mOutput; }
 
+    //! The geometric error of each output() Geometry, that is the maximum distance between an input vertex and the
+    //! simplified vertex it has been collapsed into, expressed in the same units of the input vertices.
+    std::vector< float >& outputErrors() { return mOutputErrors; }
+    const std::vector< float >& outputErrors() const { return mOutputErrors; }
+
     void setProtectedVertices(const std::vector<int>& protected_verts) { mProtectedVerts = protected_verts; }
 
     int simplifiedVerticesCount() const { return (int)mSimplifiedVertices.size(); }
@@ -352,15 +364,26 @@ namespace vl
     bool quick() const { return mQuick; }
     void setQuick(bool quick) { mQuick = quick; }
 
+    //! Simplifies the LOD 0 Geometry of each Actor once for each of the given \p ratios and installs the results as LOD 1, 2 etc.
+    //! via Actor::setLod() in decreasing order of detail. Geometries shared among several Actors are simplified only once.
+    //! Independent Geometries are simplified in parallel using \p thread_count threads if VL is compiled with OpenMP support (CMake option VL_OPENMP).
+    //! If \p install_evaluators is true each Actor also gets its own ScreenErrorLODEvaluator initialized with the outputErrors() of its LODs,
+    //! otherwise remember to install an LODEvaluator on the Actors to select the LOD to be rendered.
+    //! \note Only the first VL_MAX_ACTOR_LOD-1 ratios are used.
+    static void generateLODs(ActorCollection* actors, const std::vector<float>& ratios, int thread_count=1, bool install_evaluators=false);
+
   protected:
     void outputSimplifiedGeometry();
+    float computeOutputError(const std::vector<fvec3>& in_verts) const;
     inline void collapse(Vertex* v);
     inline void computeCollapseInfo(Vertex* v);
 
   protected:
     ref<Geometry> mInput;
     std::vector< ref<Geometry> > mOutput;
+    std::vector< float > mOutputErrors;
     std::vector< u32 > mTargets;
+    std::vector< float > mTargetRatios;
     std::vector<Vertex*> mSimplifiedVertices;
     std::vector<Triangle*> mSimplifiedTriangles;
     std::vector<int> mProtectedVerts;
@@ -0,0 +1,325 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/PostAntialiasing.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+namespace
+{
+  const char* FilterVertexShader =
+    "#version 150\n"
+    "void main(void)\n"
+    "{\n"
+    "  // full screen triangle\n"
+    "  gl_Position = vec4( gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0 );\n"
+    "}\n";
+
+  // FXAA: edge detection on the luma, edge end search and blending across the edge
+  const char* FilterFragmentShader =
+    "#version 150\n"
+    "uniform sampler2D vl_AAColor;\n"
+    "uniform vec4 vl_AAViewport;   // x, y, width, height of the scene\n"
+    "uniform vec2 vl_AATexel;      // 1 / texture width and height\n"
+    "uniform vec3 vl_AAParams;     // edge threshold, minimum edge threshold, subpixel quality\n"
+    "out vec4 vl_FragColor;\n"
+    "const int SearchSteps = 10;\n"
+    "const float StepSize[SearchSteps] = float[]( 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 2.0, 4.0, 8.0 );\n"
+    "vec4 fetch(vec2 uv)\n"
+    "{\n"
+    "  // never sample outside of the area the scene was rendered to\n"
+    "  return texture( vl_AAColor, clamp( uv, (vl_AAViewport.xy + 0.5) * vl_AATexel, (vl_AAViewport.xy + vl_AAViewport.zw - 0.5) * vl_AATexel ) );\n"
+    "}\n"
+    "float luma(vec2 uv) { return dot( fetch(uv).rgb, vec3(0.299, 0.587, 0.114) ); }\n"
+    "void main(void)\n"
+    "{\n"
+    "  vec2 uv = gl_FragCoord.xy * vl_AATexel;\n"
+    "  vec4 center = fetch( uv );\n"
+    "  float lumaM = dot( center.rgb, vec3(0.299, 0.587, 0.114) );\n"
+    "  float lumaN = luma( uv + vec2( 0.0,  vl_AATexel.y ) );\n"
+    "  float lumaS = luma( uv + vec2( 0.0, -vl_AATexel.y ) );\n"
+    "  float lumaE = luma( uv + vec2(  vl_AATexel.x, 0.0 ) );\n"
+    "  float lumaW = luma( uv + vec2( -vl_AATexel.x, 0.0 ) );\n"
+    "  float lumaMin = min( lumaM, min( min( lumaN, lumaS ), min( lumaE, lumaW ) ) );\n"
+    "  float lumaMax = max( lumaM, max( max( lumaN, lumaS ), max( lumaE, lumaW ) ) );\n"
+    "  float range = lumaMax - lumaMin;\n"
+    "  if ( range < max( vl_AAParams.y, lumaMax * vl_AAParams.x ) )\n"
+    "  {\n"
+    "    vl_FragColor = center;\n"
+    "    return;\n"
+    "  }\n"
+    "  float lumaNE = luma( uv + vl_AATexel );\n"
+    "  float lumaSW = luma( uv - vl_AATexel );\n"
+    "  float lumaNW = luma( uv + vec2( -vl_AATexel.x, vl_AATexel.y ) );\n"
+    "  float lumaSE = luma( uv + vec2( vl_AATexel.x, -vl_AATexel.y ) );\n"
+    "  // edge orientation\n"
+    "  float edgeH = abs( lumaNW + lumaNE - 2.0 * lumaN ) + 2.0 * abs( lumaW + lumaE - 2.0 * lumaM ) + abs( lumaSW + lumaSE - 2.0 * lumaS );\n"
+    "  float edgeV = abs( lumaNW + lumaSW - 2.0 * lumaW ) + 2.0 * abs( lumaN + lumaS - 2.0 * lumaM ) + abs( lumaNE + lumaSE - 2.0 * lumaE );\n"
+    "  bool horizontal = edgeH >= edgeV;\n"
+    "  // the side of the edge with the steepest gradient\n"
+    "  float luma1 = horizontal ? lumaS : lumaW;\n"
+    "  float luma2 = horizontal ? lumaN : lumaE;\n"
+    "  float gradient1 = abs( luma1 - lumaM );\n"
+    "  float gradient2 = abs( luma2 - lumaM );\n"
+    "  float step = horizontal ? vl_AATexel.y : vl_AATexel.x;\n"
+    "  float lumaEdge;\n"
+    "  if ( gradient1 >= gradient2 )\n"
+    "  {\n"
+    "    step = -step;\n"
+    "    lumaEdge = 0.5 * ( luma1 + lumaM );\n"
+    "  }\n"
+    "  else\n"
+    "    lumaEdge = 0.5 * ( luma2 + lumaM );\n"
+    "  float gradient = 0.25 * max( gradient1, gradient2 );\n"
+    "  // search the ends of the edge in both directions, halfway between the pixel and its neighbour across the edge\n"
+    "  vec2 dir = horizontal ? vec2( vl_AATexel.x, 0.0 ) : vec2( 0.0, vl_AATexel.y );\n"
+    "  vec2 uv_edge = uv + ( horizontal ? vec2( 0.0, step * 0.5 ) : vec2( step * 0.5, 0.0 ) );\n"
+    "  vec2 uv1 = uv_edge - dir;\n"
+    "  vec2 uv2 = uv_edge + dir;\n"
+    "  float end1 = luma( uv1 ) - lumaEdge;\n"
+    "  float end2 = luma( uv2 ) - lumaEdge;\n"
+    "  bool done1 = abs( end1 ) >= gradient;\n"
+    "  bool done2 = abs( end2 ) >= gradient;\n"
+    "  for( int i=1; i<SearchSteps && !( done1 && done2 ); ++i )\n"
+    "  {\n"
+    "    if ( !done1 )\n"
+    "    {\n"
+    "      uv1 -= dir * StepSize[i];\n"
+    "      end1 = luma( uv1 ) - lumaEdge;\n"
+    "      done1 = abs( end1 ) >= gradient;\n"
+    "    }\n"
+    "    if ( !done2 )\n"
+    "    {\n"
+    "      uv2 += dir * StepSize[i];\n"
+    "      end2 = luma( uv2 ) - lumaEdge;\n"
+    "      done2 = abs( end2 ) >= gradient;\n"
+    "    }\n"
+    "  }\n"
+    "  float dist1 = horizontal ? uv.x - uv1.x : uv.y - uv1.y;\n"
+    "  float dist2 = horizontal ? uv2.x - uv.x : uv2.y - uv.y;\n"
+    "  float end = dist1 < dist2 ? end1 : end2;\n"
+    "  // blend only if the luma at the closest end varies consistently with the center\n"
+    "  float offset = ( ( end < 0.0 ) != ( lumaM < lumaEdge ) ) ? 0.5 - min( dist1, dist2 ) / ( dist1 + dist2 ) : 0.0;\n"
+    "  // details smaller than a pixel\n"
+    "  float average = ( 2.0 * ( lumaN + lumaS + lumaE + lumaW ) + lumaNE + lumaNW + lumaSE + lumaSW ) / 12.0;\n"
+    "  float subpixel = clamp( abs( average - lumaM ) / range, 0.0, 1.0 );\n"
+    "  subpixel = ( -2.0 * subpixel + 3.0 ) * subpixel * subpixel;\n"
+    "  offset = max( offset, subpixel * subpixel * vl_AAParams.z );\n"
+    "  vl_FragColor = fetch( uv + ( horizontal ? vec2( 0.0, offset * step ) : vec2( offset * step, 0.0 ) ) );\n"
+    "}\n";
+}
+
+//-----------------------------------------------------------------------------
+// PostAntialiasing
+//-----------------------------------------------------------------------------
+PostAntialiasing::PostAntialiasing()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mViewport[0] = mViewport[1] = mViewport[2] = mViewport[3] = 0;
+  mTargetWidth = 0;
+  mTargetHeight = 0;
+  mEdgeThreshold = 0.125f;
+  mEdgeThresholdMin = 0.0312f;
+  mSubpixelQuality = 0.75f;
+  mEnabled = true;
+  mSceneActive = false;
+}
+//-----------------------------------------------------------------------------
+PostAntialiasing::~PostAntialiasing()
+{
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+bool PostAntialiasing::prepareTargets(OpenGLContext* ctx, int width, int height)
+{
+  if ( mFramebuffer && mPool && mPool->openglContext() == ctx && mTargetWidth == width && mTargetHeight == height )
+    return true;
+
+  releaseTargets();
+
+  mPool = ctx->renderTargetPool();
+  mFramebuffer  = mPool->acquireFramebuffer( width, height );
+  mColorTexture = mPool->acquireTexture( width, height, TF_RGBA8 );
+  mDepthBuffer  = mPool->acquireDepthStencilBuffer( width, height, DSBT_DEPTH24_STENCIL8 );
+  if ( !mFramebuffer || !mColorTexture || !mDepthBuffer )
+  {
+    releaseTargets();
+    return false;
+  }
+  mTargetWidth  = width;
+  mTargetHeight = height;
+
+  // the filter samples between the pixels
+  glBindTexture( GL_TEXTURE_2D, mColorTexture->handle() ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE ); VL_CHECK_OGL();
+  glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+
+  mFramebuffer->setDrawBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->setReadBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->addTextureAttachment( AP_COLOR_ATTACHMENT0, new FBOTexture2DAttachment( mColorTexture.get(), 0, T2DT_TEXTURE_2D ) );
+  mFramebuffer->addDepthStencilAttachment( mDepthBuffer.get() );
+  return true;
+}
+//-----------------------------------------------------------------------------
+void PostAntialiasing::releaseTargets()
+{
+  // the targets are gone if the pool has been cleared together with its OpenGLContext
+  if ( mPool )
+  {
+    if ( mFramebuffer && mPool->isAcquired( mFramebuffer.get() ) )
+      mPool->release( mFramebuffer.get() );
+    if ( mColorTexture && mPool->isAcquired( mColorTexture.get() ) )
+      mPool->release( mColorTexture.get() );
+    if ( mDepthBuffer && mPool->isAcquired( mDepthBuffer.get() ) )
+      mPool->release( mDepthBuffer.get() );
+  }
+  mFramebuffer  = NULL;
+  mColorTexture = NULL;
+  mDepthBuffer  = NULL;
+  mPool = NULL;
+  mTargetWidth  = 0;
+  mTargetHeight = 0;
+}
+//-----------------------------------------------------------------------------
+void PostAntialiasing::beginScene(Rendering* rendering)
+{
+  mSceneActive = false;
+  if ( !mEnabled || !Has_FBO || !Has_GLSL || !Has_GL_Version_3_2 )
+    return;
+
+  // the targets match the current framebuffer, the offscreen one of DynamicResolution if active
+  Framebuffer* framebuffer = rendering->renderers()[0]->framebuffer();
+  Viewport* viewport = rendering->camera()->viewport();
+  if ( viewport->width() <= 0 || viewport->height() <= 0 || framebuffer->width() <= 0 || framebuffer->height() <= 0 ||
+       !prepareTargets( framebuffer->openglContext(), framebuffer->width(), framebuffer->height() ) )
+    return;
+
+  mViewport[0] = viewport->x();
+  mViewport[1] = viewport->y();
+  mViewport[2] = viewport->width();
+  mViewport[3] = viewport->height();
+
+  mSavedFramebuffers.resize( rendering->renderers().size() );
+  for( int i=0; i<rendering->renderers().size(); ++i )
+  {
+    Renderer* renderer = rendering->renderers()[i].get();
+    mSavedFramebuffers[i] = renderer ? renderer->framebuffer() : NULL;
+    if ( renderer )
+      renderer->setFramebuffer( mFramebuffer.get() );
+  }
+
+  mSceneActive = true;
+}
+//-----------------------------------------------------------------------------
+void PostAntialiasing::endScene(Rendering* rendering)
+{
+  if ( !mSceneActive )
+    return;
+  mSceneActive = false;
+
+  for( int i=0; i<rendering->renderers().size() && i<(int)mSavedFramebuffers.size(); ++i )
+  {
+    if ( rendering->renderers()[i] )
+      rendering->renderers()[i]->setFramebuffer( mSavedFramebuffers[i].get() );
+  }
+  mSavedFramebuffers.clear();
+
+  Framebuffer* dst = rendering->renderers()[0]->framebuffer();
+  if ( !filterScene( dst ) )
+    blitScene( dst );
+}
+//-----------------------------------------------------------------------------
+void PostAntialiasing::blitScene(Framebuffer* dst)
+{
+  // bind the source first: the debug completeness check of FramebufferObject looks at the draw framebuffer
+  mFramebuffer->bindFramebuffer( FBB_READ_FRAMEBUFFER ); VL_CHECK_OGL();
+  dst->activate( FBB_DRAW_FRAMEBUFFER ); VL_CHECK_OGL();
+  const int x1 = mViewport[0] + mViewport[2];
+  const int y1 = mViewport[1] + mViewport[3];
+  VL_glBlitFramebuffer( mViewport[0], mViewport[1], x1, y1, mViewport[0], mViewport[1], x1, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST ); VL_CHECK_OGL();
+}
+//-----------------------------------------------------------------------------
+bool PostAntialiasing::filterScene(Framebuffer* dst)
+{
+#if defined(VL_OPENGL)
+  if ( !mProgram )
+  {
+    mProgram = new GLSLProgram;
+    mProgram->setObjectName("PostAntialiasing");
+    mProgram->attachShader( new GLSLVertexShader(FilterVertexShader) );
+    mProgram->attachShader( new GLSLFragmentShader(FilterFragmentShader) );
+  }
+  if ( !mProgram->linked() && !mProgram->linkProgram() )
+  {
+    Log::error("PostAntialiasing::filterScene(): could not link the filter program, antialiasing disabled.\n");
+    mEnabled = false;
+    return false;
+  }
+
+  OpenGLContext* gl_context = dst->openglContext();
+  dst->activate( FBB_FRAMEBUFFER ); VL_CHECK_OGL();
+  glViewport( mViewport[0], mViewport[1], mViewport[2], mViewport[3] ); VL_CHECK_OGL();
+
+  gl_context->useGLSLProgram( mProgram.get() );
+  glUniform1i( mProgram->getUniformLocation("vl_AAColor"), 0 ); VL_CHECK_OGL();
+  glUniform4f( mProgram->getUniformLocation("vl_AAViewport"), (float)mViewport[0], (float)mViewport[1], (float)mViewport[2], (float)mViewport[3] ); VL_CHECK_OGL();
+  glUniform2f( mProgram->getUniformLocation("vl_AATexel"), 1.0f / mTargetWidth, 1.0f / mTargetHeight ); VL_CHECK_OGL();
+  glUniform3f( mProgram->getUniformLocation("vl_AAParams"), mEdgeThreshold, mEdgeThresholdMin, mSubpixelQuality ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, mColorTexture->handle() ); VL_CHECK_OGL();
+
+  glDrawArrays( GL_TRIANGLES, 0, 3 ); VL_CHECK_OGL();
+
+  // restore the default states
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+  gl_context->useGLSLProgram( NULL );
+  return true;
+#else
+  (void)dst;
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+void PostAntialiasing::releaseOpenGLResources()
+{
+  releaseTargets();
+  mSavedFramebuffers.clear();
+  mProgram = NULL;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef PostAntialiasing_INCLUDE_ONCE
+#define PostAntialiasing_INCLUDE_ONCE
+
+#include <vlGraphics/RenderTargetPool.hpp>
+#include <vector>
+
+namespace vl
+{
+  class Rendering;
+  class GLSLProgram;
+  //------------------------------------------------------------------------------
+  // PostAntialiasing
+  //------------------------------------------------------------------------------
+  /** Smooths the edges of the 3D scene of a Rendering with a post-process filter (FXAA) run on a single-sample color buffer,
+    * a cheaper alternative to multisampled framebuffers in both memory and fill rate.
+    *
+    * Install it with Rendering::setPostAntialiasing(). While enabled the Renderer[s] of the Rendering draw into an offscreen
+    * FramebufferObject taken from the OpenGLContext::renderTargetPool(), with a single-sample RGBA8 color texture and a
+    * depth/stencil renderbuffer as large as the Framebuffer they were targeting. After the Renderer[s] the filter reads
+    * the Viewport area of the color texture and writes the antialiased image into the same area of the original Framebuffer.
+    *
+    * The filter detects the edges from the luma contrast of each pixel with its neighbours, searches the ends of each edge
+    * along its direction and blends the pixel with its neighbour across the edge according to its position along it,
+    * see setEdgeThreshold(), setEdgeThresholdMin() and setSubpixelQuality().
+    *
+    * When a DynamicResolution is installed as well the filter runs at the rendering resolution, before the upscale: the
+    * offscreen targets have the size of the DynamicResolution::framebuffer() so that changing the scale never reallocates them.
+    * Overlays such as Text and VectorGraphics should be rendered by another Rendering so that they are not filtered.
+    *
+    * \note Requires framebuffer objects with blit support and GLSL 1.50, otherwise the Rendering draws without antialiasing.
+    * \sa Rendering::setPostAntialiasing(), DynamicResolution, RenderTargetPool */
+  class VLGRAPHICS_EXPORT PostAntialiasing: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::PostAntialiasing, Object)
+
+  public:
+    PostAntialiasing();
+    ~PostAntialiasing();
+
+    //! Enables or disables the antialiasing, when disabled the Rendering draws directly into its Framebuffer (default = true).
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! Minimum luma contrast, relative to the brightest pixel of the neighbourhood, of the edges to be smoothed (default = 0.125).
+    //! Lower values smooth more edges and blur more textures.
+    void setEdgeThreshold(float threshold) { mEdgeThreshold = threshold; }
+    float edgeThreshold() const { return mEdgeThreshold; }
+
+    //! Minimum absolute luma contrast of the edges to be smoothed, avoids processing the dark areas (default = 0.0312).
+    void setEdgeThresholdMin(float threshold) { mEdgeThresholdMin = threshold; }
+    float edgeThresholdMin() const { return mEdgeThresholdMin; }
+
+    //! Amount of blending of the details smaller than a pixel, 0 disables it and 1 is the softest (default = 0.75).
+    void setSubpixelQuality(float quality) { mSubpixelQuality = quality; }
+    float subpixelQuality() const { return mSubpixelQuality; }
+
+    //! The offscreen FramebufferObject the scene is rendered to, NULL before the first frame.
+    FramebufferObject* framebuffer() { return mFramebuffer.get(); }
+    //! The color texture of framebuffer().
+    Texture* colorTexture() { return mColorTexture.get(); }
+
+    //! Redirects the Renderer[s] of the rendering into the offscreen framebuffer. Called by Rendering::render().
+    void beginScene(Rendering* rendering);
+
+    //! Restores the Renderer[s] and filters the scene into their Framebuffer. Called by Rendering::render().
+    void endScene(Rendering* rendering);
+
+    //! Releases the filter program and gives back the render targets to the pool. Requires the OpenGL context to be current.
+    void releaseOpenGLResources();
+
+  protected:
+    //! Acquires the render targets with the given dimensions.
+    bool prepareTargets(OpenGLContext* ctx, int width, int height);
+    void releaseTargets();
+    //! Copies the scene unfiltered, used if the filter program is not available.
+    void blitScene(Framebuffer* dst);
+    bool filterScene(Framebuffer* dst);
+
+  protected:
+    ref<RenderTargetPool> mPool;
+    ref<FramebufferObject> mFramebuffer;
+    ref<Texture> mColorTexture;
+    ref<FBODepthStencilBufferAttachment> mDepthBuffer;
+    ref<GLSLProgram> mProgram;
+    std::vector< ref<Framebuffer> > mSavedFramebuffers;
+    int mViewport[4];
+    int mTargetWidth;
+    int mTargetHeight;
+    float mEdgeThreshold;
+    float mEdgeThresholdMin;
+    float mSubpixelQuality;
+    bool mEnabled;
+    bool mSceneActive;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
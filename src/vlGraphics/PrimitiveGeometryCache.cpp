@@ -0,0 +1,114 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/PrimitiveGeometryCache.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// PrimitiveGeometryCache
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::find(const Key& key) const
+{
+  std::map< Key, ref<Geometry> >::const_iterator it = mGeometries.find(key);
+  return it != mGeometries.end() ? it->second.get_writable() : NULL;
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::insert(const Key& key, Geometry* geom)
+{
+  mGeometries[key] = geom;
+  return geom;
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::box(bool tex_coords)
+{
+  Key key(PT_Box, tex_coords);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeBox( vec3(0,0,0), 1, 1, 1, tex_coords ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::cone(int phi, bool bottom)
+{
+  Key key(PT_Cone, phi, bottom);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeCone( vec3(0,0,0), 1, 1, phi, bottom ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::pyramid()
+{
+  Key key(PT_Pyramid);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makePyramid( vec3(0,0,0), 1, 1 ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::icosahedron()
+{
+  Key key(PT_Icosahedron);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeIcosahedron( vec3(0,0,0), 1 ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::icosphere(int detail, bool remove_doubles)
+{
+  Key key(PT_Icosphere, detail, remove_doubles);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeIcosphere( vec3(0,0,0), 1, detail, remove_doubles ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::uvSphere(int phi, int theta)
+{
+  Key key(PT_UVSphere, phi, theta);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeUVSphere( vec3(0,0,0), 1, phi, theta ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::cylinder(int phi, int theta, bool top, bool bottom)
+{
+  Key key(PT_Cylinder, phi, theta, top, bottom);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeCylinder( vec3(0,0,0), 1, 1, phi, theta, top, bottom ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::torus(real thickness, int phi, int theta, float tex_coords)
+{
+  Key key(PT_Torus, phi, theta, 0, 0, (float)thickness, tex_coords);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeTorus( vec3(0,0,0), 1, thickness, phi, theta, tex_coords ).get() );
+}
+//-----------------------------------------------------------------------------
+Geometry* PrimitiveGeometryCache::teapot(int detail)
+{
+  Key key(PT_Teapot, detail);
+  Geometry* geom = find(key);
+  return geom ? geom : insert( key, makeTeapot( vec3(0,0,0), 1, detail ).get() );
+}
+//-----------------------------------------------------------------------------
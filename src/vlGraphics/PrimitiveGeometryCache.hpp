@@ -0,0 +1,149 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef PrimitiveGeometryCache_INCLUDE_ONCE
+#define PrimitiveGeometryCache_INCLUDE_ONCE
+
+#include <vlGraphics/GeometryPrimitives.hpp>
+#include <map>
+
+namespace vl
+{
+//-----------------------------------------------------------------------------
+// PrimitiveGeometryCache
+//-----------------------------------------------------------------------------
+  /**
+   * Shares a single unit-size Geometry among all the users of the same primitive with the same parameters.
+   *
+   * Each primitive is created once, centered at the origin with unit diameter, side and height, by the corresponding
+   * make*() function of GeometryPrimitives.hpp, and the same Geometry, with its BufferObject[s], is returned by every
+   * following request with the same parameters. Size and position are given by the Actor's Transform, for example
+   * <tt>mat4::getTranslation(pos) * mat4::getScaling(diameter, diameter, diameter)</tt>, so that thousands of objects
+   * share a handful of vertex arrays and consecutive objects can be batched by InstancingRenderer.
+   *
+   * \code
+   * ref<Actor> act = new Actor( vl::defPrimitiveGeometryCache()->icosphere(2), fx.get(), tr.get() );
+   * \endcode
+   *
+   * \remarks
+   * - The returned geometries are shared: modify a copy (see Geometry::deepCopy()) rather than the cached instance.
+   * - When the scaling is non uniform or different from 1 the normals must be renormalized, with EN_NORMALIZE or in the vertex shader.
+   *
+   * \sa defPrimitiveGeometryCache(), InstancingRenderer
+   */
+  class VLGRAPHICS_EXPORT PrimitiveGeometryCache: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::PrimitiveGeometryCache, Object)
+
+  public:
+    PrimitiveGeometryCache()
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Unit box, see makeBox().
+    Geometry* box(bool tex_coords=true);
+
+    //! Cone with unit diameter and height, see makeCone().
+    Geometry* cone(int phi=20, bool bottom=true);
+
+    //! Pyramid with unit side and height, see makePyramid().
+    Geometry* pyramid();
+
+    //! Icosahedron with unit diameter, see makeIcosahedron().
+    Geometry* icosahedron();
+
+    //! Icosphere with unit diameter, see makeIcosphere().
+    Geometry* icosphere(int detail=2, bool remove_doubles=true);
+
+    //! UV sphere with unit diameter, see makeUVSphere().
+    Geometry* uvSphere(int phi=20, int theta=20);
+
+    //! Cylinder with unit diameter and height, see makeCylinder().
+    Geometry* cylinder(int phi=20, int theta=2, bool top=true, bool bottom=true);
+
+    //! Torus with unit diameter, \p thickness is relative to the diameter, see makeTorus().
+    Geometry* torus(real thickness=0.2f, int phi=10, int theta=10, float tex_coords=0.0f);
+
+    //! Teapot with unit diameter, see makeTeapot().
+    Geometry* teapot(int detail=8);
+
+    //! Releases all the cached geometries, the ones still referenced by an Actor stay alive.
+    void clear() { mGeometries.clear(); }
+
+    //! Number of geometries currently cached.
+    int geometryCount() const { return (int)mGeometries.size(); }
+
+  protected:
+    typedef enum { PT_Box, PT_Cone, PT_Pyramid, PT_Icosahedron, PT_Icosphere, PT_UVSphere, PT_Cylinder, PT_Torus, PT_Teapot } EPrimitiveType;
+
+    //! The primitive type and its parameters, unused parameters are 0.
+    struct Key
+    {
+      Key(EPrimitiveType type, int p0=0, int p1=0, int p2=0, int p3=0, float f0=0, float f1=0): mType(type)
+      {
+        mParams[0] = p0; mParams[1] = p1; mParams[2] = p2; mParams[3] = p3;
+        mReals[0] = f0; mReals[1] = f1;
+      }
+
+      bool operator<(const Key& other) const
+      {
+        if (mType != other.mType)
+          return mType < other.mType;
+        for(int i=0; i<4; ++i)
+          if (mParams[i] != other.mParams[i])
+            return mParams[i] < other.mParams[i];
+        if (mReals[0] != other.mReals[0])
+          return mReals[0] < other.mReals[0];
+        return mReals[1] < other.mReals[1];
+      }
+
+      EPrimitiveType mType;
+      int mParams[4];
+      float mReals[2];
+    };
+
+    Geometry* find(const Key& key) const;
+    Geometry* insert(const Key& key, Geometry* geom);
+
+  protected:
+    std::map< Key, ref<Geometry> > mGeometries;
+  };
+
+  //! Returns the default PrimitiveGeometryCache installed by VisualizationLibrary::init().
+  VLGRAPHICS_EXPORT PrimitiveGeometryCache* defPrimitiveGeometryCache();
+
+  //! Installs the default PrimitiveGeometryCache.
+  VLGRAPHICS_EXPORT void setDefPrimitiveGeometryCache(PrimitiveGeometryCache* cache);
+}
+
+#endif
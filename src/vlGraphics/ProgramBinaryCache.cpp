@@ -0,0 +1,185 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/ProgramBinaryCache.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cstdio>
+
+using namespace vl;
+
+namespace
+{
+  const unsigned int ProgramBinaryMagic   = 0x42504C56; // "VLPB"
+  const unsigned int ProgramBinaryVersion = 1;
+
+  void appendString(std::string& buffer, const char* str)
+  {
+    // the terminator separates consecutive strings
+    buffer.append( str ? str : "" );
+    buffer.push_back( '\0' );
+  }
+}
+//-----------------------------------------------------------------------------
+// ProgramBinaryCache
+//-----------------------------------------------------------------------------
+ProgramBinaryCache::ProgramBinaryCache(const String& directory): mDirectory(directory)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mHits = mMisses = mStores = 0;
+}
+//-----------------------------------------------------------------------------
+void ProgramBinaryCache::computeKey(const GLSLProgram* program, u64 key[2])
+{
+  std::string buffer;
+
+  // driver
+  appendString( buffer, (const char*)glGetString(GL_VENDOR) );
+  appendString( buffer, (const char*)glGetString(GL_RENDERER) );
+  appendString( buffer, (const char*)glGetString(GL_VERSION) );
+
+  // preprocessed shader sources
+  for( int i=0; i<program->shaderCount(); ++i )
+  {
+    buffer.append( String::fromInt( program->shader(i)->type() ).toStdString() );
+    appendString( buffer, program->shader(i)->source().c_str() );
+  }
+
+  // link settings
+  for( std::map<std::string, int>::const_iterator it = program->fragDataLocations().begin(); it != program->fragDataLocations().end(); ++it )
+  {
+    appendString( buffer, it->first.c_str() );
+    buffer.append( String::fromInt( it->second ).toStdString() );
+  }
+  for( size_t i=0; i<program->transformFeedbackVaryings().size(); ++i )
+    appendString( buffer, program->transformFeedbackVaryings()[i].c_str() );
+  buffer.push_back( program->transformFeedbackInterleaved() ? 'I' : 'S' );
+  buffer.push_back( program->programSeparable() ? 'S' : 'N' );
+
+  MurmurHash3_x64_128( buffer.data(), (int)buffer.size(), 0, key );
+}
+//-----------------------------------------------------------------------------
+String ProgramBinaryCache::filePath(const u64 key[2]) const
+{
+  char name[64];
+  sprintf( name, "%016llx%016llx.vlpb", key[0], key[1] );
+  if ( mDirectory.empty() || mDirectory.endsWith('/') || mDirectory.endsWith('\\') )
+    return mDirectory + name;
+  else
+    return mDirectory + "/" + name;
+}
+//-----------------------------------------------------------------------------
+bool ProgramBinaryCache::load(GLSLProgram* program)
+{
+  if ( ! Has_GL_ARB_get_program_binary )
+    return false;
+
+  u64 key[2];
+  computeKey( program, key );
+
+  ref<DiskFile> file = new DiskFile( filePath(key) );
+  if ( ! file->exists() || ! file->open(OM_ReadOnly) )
+  {
+    ++mMisses;
+    return false;
+  }
+
+  unsigned int header[4];
+  u64 file_key[2] = { 0, 0 };
+  bool ok = file->read( header, sizeof(header) ) == sizeof(header) &&
+            file->read( file_key, sizeof(file_key) ) == sizeof(file_key) &&
+            header[0] == ProgramBinaryMagic && header[1] == ProgramBinaryVersion &&
+            file_key[0] == key[0] && file_key[1] == key[1];
+
+  // an unknown binary format would raise GL_INVALID_ENUM
+  if ( ok )
+  {
+    GLint format_count = 0;
+    glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &format_count ); VL_CHECK_OGL();
+    std::vector<GLint> formats( format_count + 1, 0 );
+    glGetIntegerv( GL_PROGRAM_BINARY_FORMATS, &formats[0] ); VL_CHECK_OGL();
+    ok = std::find( formats.begin(), formats.begin() + format_count, (GLint)header[2] ) != formats.begin() + format_count;
+  }
+
+  std::vector<unsigned char> binary;
+  if ( ok )
+  {
+    binary.resize( header[3] );
+    ok = ! binary.empty() && file->read( &binary[0], (long long)binary.size() ) == (long long)binary.size();
+  }
+  file->close();
+
+  // the driver may reject binaries produced by a different build even if the version strings match.
+  if ( ! ok || ! program->loadProgramBinary( (GLenum)header[2], &binary[0], (int)binary.size() ) )
+  {
+    ++mMisses;
+    return false;
+  }
+
+  ++mHits;
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool ProgramBinaryCache::store(const GLSLProgram* program)
+{
+  if ( ! Has_GL_ARB_get_program_binary || ! program->linked() )
+    return false;
+
+  GLenum format = 0;
+  std::vector<unsigned char> binary;
+  if ( ! program->getProgramBinary( format, binary ) || binary.empty() )
+    return false;
+
+  u64 key[2];
+  computeKey( program, key );
+
+  ref<DiskFile> file = new DiskFile( filePath(key) );
+  if ( ! file->open(OM_WriteOnly) )
+  {
+    Log::error( Say("ProgramBinaryCache::store(): could not write '%s'.\n") << file->path() );
+    return false;
+  }
+
+  unsigned int header[4] = { ProgramBinaryMagic, ProgramBinaryVersion, (unsigned int)format, (unsigned int)binary.size() };
+  bool ok = file->write( header, sizeof(header) ) == sizeof(header) &&
+            file->write( key, sizeof(u64)*2 ) == sizeof(u64)*2 &&
+            file->write( &binary[0], (long long)binary.size() ) == (long long)binary.size();
+  file->close();
+
+  if ( ok )
+    ++mStores;
+  return ok;
+}
+//-----------------------------------------------------------------------------
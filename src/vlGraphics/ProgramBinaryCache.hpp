@@ -0,0 +1,102 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef ProgramBinaryCache_INCLUDE_ONCE
+#define ProgramBinaryCache_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlCore/Object.hpp>
+#include <vlCore/String.hpp>
+
+namespace vl
+{
+  class GLSLProgram;
+
+  //-----------------------------------------------------------------------------
+  // ProgramBinaryCache
+  //-----------------------------------------------------------------------------
+  /** On-disk cache of linked GLSL program binaries based on GL_ARB_get_program_binary.
+   *
+   * Each binary is stored in its own file named after a 128 bits hash of the preprocessed sources of the
+   * program's shaders, of its link settings (fragment data locations, transform feedback varyings, separability)
+   * and of the driver's GL_VENDOR, GL_RENDERER and GL_VERSION strings, so that a driver update invalidates the cache.
+   * Binaries rejected by the driver are silently recompiled and overwritten.
+   *
+   * Install a cache on a single program with GLSLProgram::setProgramBinaryCache() or on all programs with
+   * GLSLProgram::setDefaultProgramBinaryCache(). GLSLProgram::linkProgram() will then first try to load the program
+   * from the cache, compiling the shaders only on a cache miss.
+   * \note The cache directory must already exist. */
+  class VLGRAPHICS_EXPORT ProgramBinaryCache: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::ProgramBinaryCache, Object)
+
+  public:
+    ProgramBinaryCache(const String& directory=String());
+
+    //! The directory where the program binaries are stored.
+    void setDirectory(const String& directory) { mDirectory = directory; }
+
+    //! The directory where the program binaries are stored.
+    const String& directory() const { return mDirectory; }
+
+    //! Loads and links the given program from the cache. Returns false if the program is not in the cache or if the driver rejected the binary.
+    bool load(GLSLProgram* program);
+
+    //! Stores the binary of the given linked program in the cache. Returns true on success.
+    bool store(const GLSLProgram* program);
+
+    //! Computes the cache key of the given program, see the class description.
+    static void computeKey(const GLSLProgram* program, u64 key[2]);
+
+    //! The path of the file storing the binary of the program with the given key.
+    String filePath(const u64 key[2]) const;
+
+    //! Number of programs successfully loaded from the cache.
+    unsigned long hits() const { return mHits; }
+
+    //! Number of programs not found in the cache or rejected by the driver.
+    unsigned long misses() const { return mMisses; }
+
+    //! Number of program binaries written to the cache.
+    unsigned long stores() const { return mStores; }
+
+    //! Resets hits(), misses() and stores() to 0.
+    void resetCounters() { mHits = mMisses = mStores = 0; }
+
+  protected:
+    String mDirectory;
+    unsigned long mHits;
+    unsigned long mMisses;
+    unsigned long mStores;
+  };
+}
+
+#endif
@@ -39,6 +39,33 @@ using namespace vl;
 //------------------------------------------------------------------------------
 // ProjViewTransfCallbackStandard
 //------------------------------------------------------------------------------
+ProjViewTransfCallback::ProjViewTransfCallback()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mCameraUniformBlock = new UniformBlock("vl_CameraMatrices", 0);
+  mCameraUniformBlock->gocUniform("vl_ProjectionMatrix")->setUniform( fmat4() );
+  mCameraUniformBlock->gocUniform("vl_ViewMatrix")->setUniform( fmat4() );
+  mCameraUniformBlock->gocUniform("vl_InverseViewMatrix")->setUniform( fmat4() );
+  // make sure the first update is not skipped
+  mBlockProjectionMatrix.e(3,3) = 0;
+}
+//------------------------------------------------------------------------------
+void ProjViewTransfCallback::updateCameraUniformBlock(const Camera* camera)
+{
+  if ( mBlockProjectionMatrix != camera->projectionMatrix() )
+  {
+    mBlockProjectionMatrix = camera->projectionMatrix();
+    mCameraUniformBlock->uniforms()[0]->setUniform( (fmat4)mBlockProjectionMatrix );
+  }
+
+  if ( mBlockViewMatrix != camera->viewMatrix() )
+  {
+    mBlockViewMatrix = camera->viewMatrix();
+    mCameraUniformBlock->uniforms()[1]->setUniform( (fmat4)mBlockViewMatrix );
+    mCameraUniformBlock->uniforms()[2]->setUniform( (fmat4)camera->modelingMatrix() );
+  }
+}
+//------------------------------------------------------------------------------
 void ProjViewTransfCallback::updateMatrices(bool cam_changed, bool transf_changed, const GLSLProgram* glsl_program, const Camera* camera, const Transform* transform)
 {
   VL_CHECK_OGL();
@@ -49,6 +76,13 @@ void ProjViewTransfCallback::updateMatrices(bool cam_changed, bool transf_change
   // projection matrix
   if ( cam_changed )
   {
+    // camera uniform block: uploaded only if the camera changed, shared by all the programs
+    if ( glsl_program && glsl_program->vl_CameraMatrices() != -1 )
+    {
+      updateCameraUniformBlock( camera );
+      glsl_program->applyUniformBlock( mCameraUniformBlock.get() );
+    }
+
     if ( glsl_program && glsl_program->vl_ProjectionMatrix() != -1 )
     {
 #if VL_PIPELINE_PRECISION == 1
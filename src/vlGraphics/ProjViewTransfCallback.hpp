@@ -34,6 +34,8 @@
 
 #include <vlGraphics/link_config.hpp>
 #include <vlCore/Object.hpp>
+#include <vlCore/Matrix4.hpp>
+#include <vlGraphics/UniformBlock.hpp>
 
 namespace vl
 {
@@ -51,19 +53,40 @@ namespace vl
   * but only the vl_* ones.
   * Reimplement the updateMatrices() method to update any other camera/transform matrix you might need such as the ones defined in
   * http://www.opengl.org/registry/doc/GLSLangSpec.Full.1.10.59.pdf pag 45.
+  *
+  * GLSL programs can also receive the camera matrices through the following uniform block bound to binding point #0:
+  * \code
+  * layout(std140) uniform vl_CameraMatrices
+  * {
+  *   mat4 vl_ProjectionMatrix;
+  *   mat4 vl_ViewMatrix;
+  *   mat4 vl_InverseViewMatrix;
+  * };
+  * \endcode
+  * The block is a single uniform buffer object shared by all the programs and is uploaded only when the camera matrices change,
+  * so switching program does not require re-sending the camera matrices. See also cameraUniformBlock().
   */
   class VLGRAPHICS_EXPORT ProjViewTransfCallback: public Object
   {
     VL_INSTRUMENT_CLASS(vl::ProjViewTransfCallback, Object)
 
   public:
-    ProjViewTransfCallback()
-    {
-      VL_DEBUG_SET_OBJECT_NAME()
-    }
+    ProjViewTransfCallback();
 
     //! Update matrices of the current GLSLProgram, if glsl_program == NULL then fixed function pipeline is active.
     virtual void updateMatrices(bool cam_changed, bool transf_changed, const GLSLProgram* glsl_program, const Camera* camera, const Transform* transform);
+
+    //! The UniformBlock storing the \p vl_CameraMatrices uniform block.
+    const UniformBlock* cameraUniformBlock() const { return mCameraUniformBlock.get(); }
+
+  protected:
+    //! Updates cameraUniformBlock() if the camera matrices changed since the last call.
+    void updateCameraUniformBlock(const Camera* camera);
+
+  protected:
+    ref<UniformBlock> mCameraUniformBlock;
+    mat4 mBlockProjectionMatrix;
+    mat4 mBlockViewMatrix;
   };
 }
 
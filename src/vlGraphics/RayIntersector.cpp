@@ -31,6 +31,8 @@
 
 #include <vlGraphics/RayIntersector.hpp>
 #include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/CompiledActorTree.hpp>
+#include <vlGraphics/TriangleVisitor.hpp>
 
 using namespace vl;
 
@@ -43,6 +45,14 @@ void RayIntersector::intersect(const Ray& ray, SceneManager* scene_manager)
   intersect();
 }
 //-----------------------------------------------------------------------------
+void RayIntersector::intersect(const Ray& ray, const CompiledActorTree* tree)
+{
+  actors()->clear();
+  tree->extractActors( ray, *actors() );
+  setRay(ray);
+  intersect();
+}
+//-----------------------------------------------------------------------------
 void RayIntersector::intersect()
 {
   mIntersections.clear();
@@ -64,32 +74,83 @@ void RayIntersector::intersect(Actor* act)
     intersectGeometry(act, geom);
 }
 //-----------------------------------------------------------------------------
+bool RayIntersector::intersectGeometryBVH(Actor* act, Geometry* geom)
+{
+  // the ray is brought in object space, the distances along it do not change
+  Ray ray = mRay;
+  if (act->transform())
+  {
+    real det = 0;
+    mat4 inverse = act->transform()->worldMatrix().getInverse(&det);
+    if (det == 0)
+      return false;
+    ray.setOrigin( inverse * mRay.origin() );
+    ray.setDirection( inverse.get3x3() * mRay.direction() );
+  }
+
+  const TriangleBVH* bvh = geom->triangleBVH();
+  mHits.clear();
+  bvh->intersect(ray, mHits);
+  for(size_t i=0; i<mHits.size(); ++i)
+  {
+    const int tri = mHits[i].mTriangle;
+    const int* idx = bvh->triangle(tri);
+    ref<RayIntersectionGeometry> record = new vl::RayIntersectionGeometry;
+    record->setIntersectionPoint( mRay.origin() + mRay.direction() * mHits[i].mDistance );
+    record->setTriangleIndex( bvh->triangleIndex(tri) );
+    record->setTriangle( idx[0], idx[1], idx[2] );
+    record->setActor(act);
+    record->setGeometry(geom);
+    record->setPrimitives( geom->drawCalls().at( bvh->drawCallIndex(tri) ) );
+    record->setDistance( mHits[i].mDistance );
+    mIntersections.push_back(record);
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+struct RayIntersector::TriangleTester
+{
+  TriangleTester(RayIntersector* ri, const vec3* pos, const mat4* matrix, Actor* act, Geometry* geom, DrawCall* prim):
+    mRayIntersector(ri), mPos(pos), mMatrix(matrix), mActor(act), mGeometry(geom), mPrim(prim), mTriangleIndex(0) {}
+
+  void operator()(int ia, int ib, int ic)
+  {
+    vec3 a = mPos[ia];
+    vec3 b = mPos[ib];
+    vec3 c = mPos[ic];
+    if (mMatrix)
+    {
+      a = *mMatrix * a;
+      b = *mMatrix * b;
+      c = *mMatrix * c;
+    }
+    mRayIntersector->intersectTriangle(a, b, c, ia, ib, ic, mActor, mGeometry, mPrim, mTriangleIndex++);
+  }
+
+  RayIntersector* mRayIntersector;
+  const vec3* mPos;
+  const mat4* mMatrix;
+  Actor* mActor;
+  Geometry* mGeometry;
+  DrawCall* mPrim;
+  int mTriangleIndex;
+};
+//-----------------------------------------------------------------------------
 void RayIntersector::intersectGeometry(Actor* act, Geometry* geom)
 {
   ArrayAbstract* posarr = geom->vertexArray();
-  if (posarr)
+  if ( posarr && mTriangleBVHMinVertexCount >= 0 && (int)posarr->size() >= mTriangleBVHMinVertexCount && intersectGeometryBVH(act, geom) )
+    return;
+
+  std::vector<vec3> pos_storage;
+  const vec3* pos = vec3Data(posarr, pos_storage);
+  if (pos)
   {
     mat4 matrix = act->transform() ? act->transform()->worldMatrix() : mat4();
     for(int i=0; i<geom->drawCalls().size(); ++i)
     {
-      DrawCall* prim = geom->drawCalls().at(i);
-      int itri = 0;
-      for(TriangleIterator trit = prim->triangleIterator(); trit.hasNext(); trit.next(), ++itri)
-      {
-        int ia = trit.a();
-        int ib = trit.b();
-        int ic = trit.c();
-        vec3 a = posarr->getAsVec3(ia);
-        vec3 b = posarr->getAsVec3(ib);
-        vec3 c = posarr->getAsVec3(ic);
-        if (act->transform())
-        {
-          a = matrix * a;
-          b = matrix * b;
-          c = matrix * c;
-        }
-        intersectTriangle(a, b, c, ia, ib, ic, act, geom, prim, itri);
-      }
+      TriangleTester tester( this, pos, act->transform() ? &matrix : NULL, act, geom, geom->drawCalls().at(i) );
+      forEachTriangle( geom->drawCalls().at(i), tester );
     }
   }
 }
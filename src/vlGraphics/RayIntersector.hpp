@@ -42,6 +42,7 @@
 namespace vl
 {
   class SceneManager;
+  class CompiledActorTree;
   //-----------------------------------------------------------------------------
   // RayIntersection
   //-----------------------------------------------------------------------------
@@ -135,7 +136,7 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::RayIntersector, Object)
 
   public:
-    RayIntersector()
+    RayIntersector(): mTriangleBVHMinVertexCount(1024)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mActors = new ActorCollection;
@@ -159,6 +160,13 @@ namespace vl
     //! The intersection points detected by the last intersect() call sorted according to their distance (the first one is the closest).
     const std::vector< ref<RayIntersection> >& intersections() const { return mIntersections; }
 
+    /** The Geometry objects with at least this many vertices are intersected using their Geometry::triangleBVH(), which is built the first
+      * time and kept until the Geometry changes. The smaller ones are intersected testing all their triangles.
+      * Set it to -1 to never use the BVH. Default is 1024. */
+    void setTriangleBVHMinVertexCount(int count) { mTriangleBVHMinVertexCount = count; }
+    //! See setTriangleBVHMinVertexCount().
+    int triangleBVHMinVertexCount() const { return mTriangleBVHMinVertexCount; }
+
     /** Executes the intersection test.
      * \note Before calling this function the transforms and the bounding volumes of the Actor[s] to be intersected must be updated, in this order.
      * \note All the intersections are mande on the Actor's LOD level #0.
@@ -176,21 +184,33 @@ namespace vl
       */
     void intersect(const Ray& ray, SceneManager* scene_manager);
 
+    /** Computes the intersections between the given ray and the Actor[s] contained in the given compiled tree.
+      * Only the Actors whose bounding box is hit by the ray are tested, the others are discarded
+      * with a traversal of the tree instead of per-Actor tests.
+      */
+    void intersect(const Ray& ray, const CompiledActorTree* tree);
+
   protected:
     static bool sorter(const ref<RayIntersection>& a, const ref<RayIntersection>& b) { return a->distance() < b->distance(); }
 
     void intersect(Actor* act);
     void intersectGeometry(Actor* act, Geometry* geom);
+    bool intersectGeometryBVH(Actor* act, Geometry* geom);
 
     // T should be either fvec3-4 or dvec3-4
     template<class T>
     void intersectTriangle(const T& a, const T& b, const T& c, int ia, int ib, int ic, Actor*, Geometry* geom, DrawCall* prim, int prim_idx);
 
+    // triangle visitor used by intersectGeometry(), see forEachTriangle()
+    struct TriangleTester;
+
   protected:
     Frustum mFrustum;
     std::vector< ref<RayIntersection> > mIntersections;
     ref<ActorCollection> mActors;
     Ray mRay;
+    std::vector<TriangleBVH::Hit> mHits;
+    int mTriangleBVHMinVertexCount;
   };
 }
 
@@ -0,0 +1,266 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/RenderQueue.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// RenderQueue
+//-----------------------------------------------------------------------------
+void RenderQueue::computeCameraDistances(const RenderQueueSorter* sorter, const Camera* camera)
+{
+  if (sorter->mightNeedZCameraDistance())
+  {
+    for(int i=0; i<size(); ++i)
+    {
+      RenderToken* tok = at(i);
+      vec3 center = tok->mRenderable->boundingBox().isNull() ? vec3(0,0,0) : tok->mRenderable->boundingBox().center();
+      if ( sorter->confirmZCameraDistanceCompute(tok) )
+      {
+        if (tok->mActor->transform())
+          // tok->mCameraDistance = ( camera->viewMatrix() * (tok->mActor->transform()->worldMatrix() * center) ).lengthSquared();
+          tok->mCameraDistance = -( camera->viewMatrix() * (tok->mActor->transform()->worldMatrix() * center) ).z();
+        else
+          // tok->mCameraDistance = ( camera->viewMatrix() * /* I* */ center ).lengthSquared();
+          tok->mCameraDistance = -( camera->viewMatrix() * /* I* */ center ).z();
+      }
+      else
+        tok->mCameraDistance = 0;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void RenderQueue::sort(RenderQueueSorter* sorter, Camera* camera)
+{
+  VL_CHECK( sorter )
+
+  computeCameraDistances(sorter, camera);
+
+  if ( sorter->hasSortKey() && computeSortKeys(sorter) )
+    radixSort();
+  else
+    std::sort( mList.begin(), mList.begin() + size(), Sorter( sorter ) );
+}
+//-----------------------------------------------------------------------------
+bool RenderQueue::computeSortKeys(const RenderQueueSorter* sorter)
+{
+  // camera distance range of the depth sorted tokens
+  real min_dist = 0;
+  real max_dist = 0;
+  bool first = true;
+  for(int i=0; i<size(); ++i)
+  {
+    const RenderToken* tok = at(i);
+    if ( sorter->confirmZCameraDistanceCompute(tok) )
+    {
+      if (first || tok->mCameraDistance < min_dist)
+        min_dist = tok->mCameraDistance;
+      if (first || tok->mCameraDistance > max_dist)
+        max_dist = tok->mCameraDistance;
+      first = false;
+    }
+  }
+  real inv_range = max_dist > min_dist ? 1 / (max_dist - min_dist) : 0;
+
+  mSortKeys.resize( size() );
+  for(int i=0; i<size(); ++i)
+  {
+    RenderToken* tok = at(i);
+    float depth = 0;
+    if ( sorter->confirmZCameraDistanceCompute(tok) )
+      depth = (float)( (tok->mCameraDistance - min_dist) * inv_range );
+    mSortKeys[i].mToken = tok;
+    if ( !sorter->sortKey(tok, depth, mSortKeys[i].mKey) )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void RenderQueue::radixSort()
+{
+  const int count = size();
+  if (count < 2)
+    return;
+
+  // LSD radix sort, 8 passes of 8 bits: all the histograms are computed in a single pass over the keys.
+  int histo[8][256];
+  memset(histo, 0, sizeof(histo));
+  for(int i=0; i<count; ++i)
+  {
+    u64 key = mSortKeys[i].mKey;
+    for(int pass=0; pass<8; ++pass, key >>= 8)
+      ++histo[pass][key & 0xFF];
+  }
+
+  mSortKeysTmp.resize( count );
+  SortKey* src = &mSortKeys[0];
+  SortKey* dst = &mSortKeysTmp[0];
+  for(int pass=0; pass<8; ++pass)
+  {
+    int* h = histo[pass];
+    const int shift = pass * 8;
+
+    // skip the pass if all the keys share the same digit
+    if ( h[ (src[0].mKey >> shift) & 0xFF ] == count )
+      continue;
+
+    // exclusive prefix sum
+    int offset = 0;
+    for(int d=0; d<256; ++d)
+    {
+      int c = h[d];
+      h[d] = offset;
+      offset += c;
+    }
+
+    for(int i=0; i<count; ++i)
+      dst[ h[ (src[i].mKey >> shift) & 0xFF ]++ ] = src[i];
+
+    std::swap(src, dst);
+  }
+
+  for(int i=0; i<count; ++i)
+    mList[i] = src[i].mToken;
+}
+//-----------------------------------------------------------------------------
+void RenderQueue::sortCoherent(RenderQueueSorter* sorter, Camera* camera)
+{
+  VL_CHECK( sorter )
+
+  computeCameraDistances(sorter, camera);
+
+  // a different sorter invalidates the remembered order
+  if (sorter != mCoherentSorter)
+  {
+    mCoherentHistory.clear();
+    mCoherentSorter = sorter;
+  }
+
+  const int count = size();
+  const int prev_count = (int)mCoherentHistory.size();
+
+  // match the tokens with the ones of the previous frame: first by fill position, which is enough
+  // when the visible set did not change, then by identity.
+
+  mCoherentItems.resize( count );
+  bool lookup_ready = false;
+  int unknown = 0;
+  for(int i=0; i<count; ++i)
+  {
+    CoherentItem& item = mCoherentItems[i];
+    item.mToken = at(i);
+    item.mFillIndex = i;
+    item.mRank = -1;
+    if ( i < prev_count && mCoherentHistory[i].matches(item.mToken) )
+      item.mRank = mCoherentHistory[i].mRank;
+    else
+    if ( prev_count )
+    {
+      if (!lookup_ready)
+      {
+        mCoherentLookup = mCoherentHistory;
+        std::sort( mCoherentLookup.begin(), mCoherentLookup.end() );
+        lookup_ready = true;
+      }
+      std::vector<CoherentEntry>::const_iterator it = std::lower_bound( mCoherentLookup.begin(), mCoherentLookup.end(), CoherentEntry(item.mToken, -1) );
+      if ( it != mCoherentLookup.end() && it->matches(item.mToken) )
+        item.mRank = it->mRank;
+    }
+    if (item.mRank < 0)
+      ++unknown;
+  }
+
+  mCoherentSorted.resize( count );
+  if (count)
+  {
+    CoherentSorter cmp(sorter);
+    CoherentItem* items = &mCoherentSorted[0];
+
+    if ( unknown * 2 > count )
+    {
+      // too little coherence: sort from scratch
+      std::copy( mCoherentItems.begin(), mCoherentItems.end(), mCoherentSorted.begin() );
+      std::sort( items, items + count, cmp );
+    }
+    else
+    {
+      // counting sort by previous rank, unknown tokens go last
+      mCoherentOffsets.assign( prev_count + 1, 0 );
+      for(int i=0; i<count; ++i)
+        ++mCoherentOffsets[ mCoherentItems[i].mRank < 0 ? prev_count : mCoherentItems[i].mRank ];
+      int offset = 0;
+      for(int r=0; r<=prev_count; ++r)
+      {
+        int c = mCoherentOffsets[r];
+        mCoherentOffsets[r] = offset;
+        offset += c;
+      }
+      for(int i=0; i<count; ++i)
+        items[ mCoherentOffsets[ mCoherentItems[i].mRank < 0 ? prev_count : mCoherentItems[i].mRank ]++ ] = mCoherentItems[i];
+
+      // insertion sort of the known tokens: linear on already sorted input, bail out to std::sort if too many moves are needed
+      const int known = count - unknown;
+      long long budget = 8 * (long long)known + 64;
+      for(int i=1; i<known && budget >= 0; ++i)
+      {
+        CoherentItem item = items[i];
+        int j = i;
+        for( ; j>0 && cmp(item, items[j-1]); --j, --budget)
+          items[j] = items[j-1];
+        items[j] = item;
+      }
+      if (budget < 0)
+        std::sort( items, items + known, cmp );
+
+      // sort the new tokens and merge them in
+      if (unknown)
+      {
+        std::sort( items + known, items + count, cmp );
+        std::inplace_merge( items, items + known, items + count, cmp );
+      }
+    }
+  }
+
+  // remember the order for the next frame and reorder the token list
+  mCoherentHistory.resize( count );
+  for(int r=0; r<count; ++r)
+  {
+    const CoherentItem& item = mCoherentSorted[r];
+    mCoherentHistory[item.mFillIndex] = CoherentEntry(item.mToken, r);
+    mList[r] = item.mToken;
+  }
+}
+//-----------------------------------------------------------------------------
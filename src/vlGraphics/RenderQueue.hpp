@@ -32,6 +32,7 @@
 #ifndef RenderQueue_INCLUDE_ONCE
 #define RenderQueue_INCLUDE_ONCE
 
+#include <vlGraphics/link_config.hpp>
 #include <vlGraphics/RenderQueueSorter.hpp>
 
 namespace vl
@@ -42,44 +43,55 @@ namespace vl
   /**
    * The RenderQueue class collects a list of RenderToken objects to be sorted and rendered.
   */
-  class RenderQueue: public Object
+  class VLGRAPHICS_EXPORT RenderQueue: public Object
   {
     VL_INSTRUMENT_CLASS(vl::RenderQueue, Object)
 
   public:
-    RenderQueue(): mSize(0), mSizeMP(0)
+    RenderQueue(): mSize(0), mSizeMP(0), mTokenCount(0), mCoherentSorter(NULL)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mList.reserve(100);
       mListMP.reserve(100);
     }
 
-    const RenderToken* at(int i) const { return mList[i].get(); }
+    ~RenderQueue()
+    {
+      for(size_t i=0; i<mTokenChunks.size(); ++i)
+        delete [] mTokenChunks[i];
+    }
 
-    RenderToken* at(int i) { return mList[i].get(); }
+    const RenderToken* at(int i) const { return mList[i]; }
+
+    RenderToken* at(int i) { return mList[i]; }
 
     RenderToken* newToken(bool multipass)
     {
+      RenderToken* tok = allocToken();
       if (multipass)
       {
+        if ( mSizeMP == (int)mListMP.size() )
+          mListMP.push_back( tok );
+        else
+          mListMP[mSizeMP] = tok;
         ++mSizeMP;
-        if ( mSizeMP > (int)mListMP.size() )
-          mListMP.push_back( new RenderToken );
-        return mListMP[mSizeMP-1].get();
       }
       else
       {
+        if ( mSize == (int)mList.size() )
+          mList.push_back( tok );
+        else
+          mList[mSize] = tok;
         ++mSize;
-        if ( mSize > (int)mList.size() )
-          mList.push_back( new RenderToken );
-        return mList[mSize-1].get();
       }
+      return tok;
     }
 
     void clear()
     {
       mSize   = 0;
       mSizeMP = 0;
+      mTokenCount = 0;
     }
 
     bool empty()
@@ -92,57 +104,124 @@ namespace vl
       return mSize;
     }
 
-    void sort(RenderQueueSorter* sorter, Camera* camera)
-    {
-      if (sorter->mightNeedZCameraDistance())
-      {
-        for(int i=0; i<size(); ++i)
-        {
-          RenderToken* tok = at(i);
-          vec3 center = tok->mRenderable->boundingBox().isNull() ? vec3(0,0,0) : tok->mRenderable->boundingBox().center();
-          if ( sorter->confirmZCameraDistanceNeed(tok) )
-          {
-            if (tok->mActor->transform())
-              // tok->mCameraDistance = ( camera->viewMatrix() * (tok->mActor->transform()->worldMatrix() * center) ).lengthSquared();
-              tok->mCameraDistance = -( camera->viewMatrix() * (tok->mActor->transform()->worldMatrix() * center) ).z();
-            else
-              // tok->mCameraDistance = ( camera->viewMatrix() * /* I* */ center ).lengthSquared();
-              tok->mCameraDistance = -( camera->viewMatrix() * /* I* */ center ).z();
-          }
-          else
-            tok->mCameraDistance = 0;
-        }
-      }
+    //! Sorts the RenderTokens using the given RenderQueueSorter.
+    //! If RenderQueueSorter::hasSortKey() returns true the tokens are sorted by their 64 bits key using a radix sort,
+    //! otherwise std::sort() is used with RenderQueueSorter::operator() as comparator.
+    void sort(RenderQueueSorter* sorter, Camera* camera);
 
-      VL_CHECK( sorter )
-      std::sort( mList.begin(), mList.begin() + size(), Sorter( sorter ) );
-    }
+    //! Sorts the RenderTokens reusing the order computed by the previous call to sortCoherent().
+    //! The tokens that were present in the previous frame are placed in their previous order and fixed up with
+    //! an insertion sort, the new ones are sorted separately and merged in. The cost is near-linear when the set of
+    //! visible objects and their order change little from frame to frame, and degrades gracefully to sort() otherwise.
+    //! The result is always the same ordering produced by RenderQueueSorter::operator().
+    //! \sa Rendering::setCoherentRenderQueue()
+    void sortCoherent(RenderQueueSorter* sorter, Camera* camera);
+
+    //! Forgets the order remembered by sortCoherent(), the next call will sort the queue from scratch.
+    void resetCoherentOrder() { mCoherentHistory.clear(); mCoherentSorter = NULL; }
 
   private:
+    // RenderQueue owns the RenderToken[s] and returns pointers into them, see newToken().
+    RenderQueue(const RenderQueue&): Object() {}
+    RenderQueue& operator=(const RenderQueue&) { return *this; }
+
+    // Returns a reset RenderToken from the pool. Tokens are allocated in fixed size chunks
+    // so that their addresses, used by RenderToken::mNextPass, are stable until clear().
+    RenderToken* allocToken()
+    {
+      const int chunk = mTokenCount / TokenChunkSize;
+      if ( chunk == (int)mTokenChunks.size() )
+        mTokenChunks.push_back( new RenderToken[TokenChunkSize] );
+      RenderToken* tok = &mTokenChunks[chunk][mTokenCount % TokenChunkSize];
+      *tok = RenderToken();
+      ++mTokenCount;
+      return tok;
+    }
+
     class Sorter
     {
     public:
       Sorter(const RenderQueueSorter* sorter): mRenderQueueSorter(sorter) {}
-      bool operator()(const ref<RenderToken>& a, const ref<RenderToken>& b) const
+      bool operator()(const RenderToken* a, const RenderToken* b) const
       {
         VL_CHECK(a && b);
-        return mRenderQueueSorter->operator()(a.get(), b.get());
+        return mRenderQueueSorter->operator()(a, b);
+      }
+    protected:
+      const RenderQueueSorter* mRenderQueueSorter;
+    };
+
+    struct SortKey
+    {
+      u64 mKey;
+      RenderToken* mToken;
+    };
+
+    bool computeSortKeys(const RenderQueueSorter* sorter);
+    void radixSort();
+    void computeCameraDistances(const RenderQueueSorter* sorter, const Camera* camera);
+
+    // identity of a first-pass token across frames and its position in the sorted queue
+    struct CoherentEntry
+    {
+      CoherentEntry(): mActor(NULL), mShader(NULL), mRenderable(NULL), mRank(-1) {}
+      CoherentEntry(const RenderToken* tok, int rank): mActor(tok->mActor), mShader(tok->mShader), mRenderable(tok->mRenderable), mRank(rank) {}
+      bool matches(const RenderToken* tok) const { return mActor == tok->mActor && mShader == tok->mShader && mRenderable == tok->mRenderable; }
+      bool operator<(const CoherentEntry& other) const
+      {
+        if (mActor != other.mActor)
+          return mActor < other.mActor;
+        else
+        if (mShader != other.mShader)
+          return mShader < other.mShader;
+        else
+          return mRenderable < other.mRenderable;
+      }
+      const Actor* mActor;
+      const Shader* mShader;
+      const Renderable* mRenderable;
+      int mRank;
+    };
+
+    struct CoherentItem
+    {
+      RenderToken* mToken;
+      int mFillIndex;
+      int mRank;
+    };
+
+    class CoherentSorter
+    {
+    public:
+      CoherentSorter(const RenderQueueSorter* sorter): mRenderQueueSorter(sorter) {}
+      bool operator()(const CoherentItem& a, const CoherentItem& b) const
+      {
+        return mRenderQueueSorter->operator()(a.mToken, b.mToken);
       }
     protected:
       const RenderQueueSorter* mRenderQueueSorter;
     };
 
   protected:
-    // mic fixme: would be nice not to allocate these dinamically.
-    // Necessary because:
-    // 1- RenderToken.mNextPass: the pointer should be stable across std::vector reallocations.
-    //    Maybe we can use indices?
-    // 2- The sorting sorts only pointers instead of whole structures.
+    // The sorting sorts only pointers into the token pool instead of whole structures.
     // Note: we need two lists because the sorting must still respect the multipassing order.
-    std::vector< ref<RenderToken> > mList;
-    std::vector< ref<RenderToken> > mListMP;
+    enum { TokenChunkSize = 256 };
+    std::vector<RenderToken*> mTokenChunks;
+    std::vector<RenderToken*> mList;
+    std::vector<RenderToken*> mListMP;
     int mSize;
     int mSizeMP;
+    int mTokenCount;
+    // radix sort buffers, kept across frames to avoid reallocations.
+    std::vector<SortKey> mSortKeys;
+    std::vector<SortKey> mSortKeysTmp;
+    // sortCoherent() state: mCoherentHistory is indexed by fill order and is kept across frames.
+    std::vector<CoherentEntry> mCoherentHistory;
+    std::vector<CoherentEntry> mCoherentLookup;
+    std::vector<CoherentItem> mCoherentItems;
+    std::vector<CoherentItem> mCoherentSorted;
+    std::vector<int> mCoherentOffsets;
+    const RenderQueueSorter* mCoherentSorter;
   };
   //------------------------------------------------------------------------------
   typedef std::map< float, ref<RenderQueue> > TRenderQueueMap;
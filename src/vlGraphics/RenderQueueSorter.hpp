@@ -33,6 +33,7 @@
 #define RenderQueueSorter_INCLUDE_ONCE
 
 #include <vlGraphics/RenderToken.hpp>
+#include <cmath>
 
 namespace vl
 {
@@ -54,6 +55,21 @@ namespace vl
     virtual bool operator()(const RenderToken* a, const RenderToken* b) const = 0;
     virtual bool confirmZCameraDistanceNeed(const RenderToken*) const = 0;
     virtual bool mightNeedZCameraDistance() const = 0;
+
+    //! Returns true if RenderToken::mCameraDistance must be computed for the given token, by default confirmZCameraDistanceNeed().
+    //! Reimplemented by the sorters using the camera distance for purposes other than back-to-front depth sorting.
+    virtual bool confirmZCameraDistanceCompute(const RenderToken* a) const { return confirmZCameraDistanceNeed(a); }
+
+    //! Returns true if the sorter can express its ordering as a 64 bits key, see sortKey().
+    //! When this returns true RenderQueue::sort() computes one key per RenderToken and radix-sorts them
+    //! instead of calling operator() for every comparison.
+    virtual bool hasSortKey() const { return false; }
+
+    //! Computes the 64 bits key of the given RenderToken, tokens are rendered in ascending key order.
+    //! \p depth is the RenderToken::mCameraDistance of the token normalized in the range [0,1] across all the
+    //! tokens for which confirmZCameraDistanceCompute() returns true, 0 for the others.
+    //! Returns \p false if the token cannot be encoded, in which case the whole queue is sorted using operator().
+    virtual bool sortKey(const RenderToken*, float /*depth*/, u64& /*key*/) const { return false; }
   };
   //------------------------------------------------------------------------------
   // RenderQueueSorterByShader
@@ -145,17 +161,23 @@ namespace vl
   //! -# Solid objects first, translucent objects last
   //! -# Sort translucent objects back-to-front
   //! -# Sort solid objects by Shader
+  //! -# Sort solid objects coarsely front-to-back, if frontToBack() is enabled
   //! -# Sort solid objects by Renderable
   class RenderQueueSorterStandard: public RenderQueueSorter
   {
     VL_INSTRUMENT_CLASS(vl::RenderQueueSorterStandard, RenderQueueSorter)
 
   public:
-    RenderQueueSorterStandard(): mDepthSortMode(AlphaDepthSort)
+    RenderQueueSorterStandard(): mDepthSortMode(AlphaDepthSort), mFrontToBack(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
 
+    virtual bool confirmZCameraDistanceCompute(const RenderToken* a) const
+    {
+      return mFrontToBack || confirmZCameraDistanceNeed(a);
+    }
+
     virtual bool mightNeedZCameraDistance() const { return true; }
     virtual bool confirmZCameraDistanceNeed(const RenderToken* a) const
     {
@@ -206,6 +228,10 @@ namespace vl
       // shader sorting
       if (a->mShader != b->mShader)
         return a->mShader < b->mShader;
+      else
+      // coarse front-to-back sorting within the same Shader
+      if (mFrontToBack && depthBucket(a->mCameraDistance) != depthBucket(b->mCameraDistance))
+        return depthBucket(a->mCameraDistance) < depthBucket(b->mCameraDistance);
       // renderable sorting
       else
         return a->mRenderable < b->mRenderable;
@@ -214,8 +240,103 @@ namespace vl
     EDepthSortMode depthSortMode() const { return mDepthSortMode; }
     void setDepthSortMode(EDepthSortMode mode) { mDepthSortMode = mode; }
 
+    //! If true the solid objects sharing the same Shader are sorted front-to-back in coarse distance buckets, so that the
+    //! early depth test can reject the hidden fragments while the objects sharing the same Renderable remain mostly adjacent.
+    //! Disabled by default.
+    void setFrontToBack(bool enabled) { mFrontToBack = enabled; }
+    //! If true the solid objects sharing the same Shader are sorted front-to-back in coarse distance buckets, see setFrontToBack().
+    bool frontToBack() const { return mFrontToBack; }
+
+  protected:
+    //! Quarter-octave logarithmic bucket of a camera distance.
+    static int depthBucket(real distance)
+    {
+      if (distance <= 0)
+        return -0x7FFFFFFF;
+      int exponent = 0;
+      real mantissa = frexp(distance, &exponent);
+      return exponent * 4 + (int)((mantissa - (real)0.5) * 8);
+    }
+
   public:
     EDepthSortMode mDepthSortMode;
+    bool mFrontToBack;
+  };
+  //------------------------------------------------------------------------------
+  // RenderQueueSorterRadix
+  //------------------------------------------------------------------------------
+  //! Implements the same ordering of RenderQueueSorterStandard using 64 bits sort keys and a radix sort.
+  //! The key is laid out as follows (most significant bits first):
+  //! - 8 bits: Actor render block
+  //! - 8 bits: Effect render rank
+  //! - 8 bits: Actor render rank
+  //! - 1 bit: translucent (blending enabled and depth sort mode != AlwaysDepthSort)
+  //! - 39 bits: if the token is depth sorted 24 bits of far-to-near depth followed by 15 bits of Shader hash,
+  //!   otherwise 13 bits of GLSLProgram hash, 13 bits of Shader hash and 13 bits of Renderable hash,
+  //!   or if frontToBack() is enabled 11 bits of GLSLProgram hash, 11 bits of Shader hash, 6 bits of near-to-far depth
+  //!   and 11 bits of Renderable hash.
+  //!
+  //! Render blocks and ranks must be in the range [-128,127], if any token falls outside of this range the
+  //! RenderQueue is sorted using RenderQueueSorterStandard::operator().
+  //! Hash collisions only reduce the quality of the state-sorting, never the correctness of the user defined ordering.
+  class RenderQueueSorterRadix: public RenderQueueSorterStandard
+  {
+    VL_INSTRUMENT_CLASS(vl::RenderQueueSorterRadix, RenderQueueSorterStandard)
+
+  public:
+    RenderQueueSorterRadix()
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual bool hasSortKey() const { return true; }
+
+    virtual bool sortKey(const RenderToken* a, float depth, u64& key) const
+    {
+      int block  = a->mActor->renderBlock() + 128;
+      int erank  = a->mEffectRenderRank + 128;
+      int arank  = a->mActor->renderRank() + 128;
+      if ( (block|erank|arank) & ~0xFF )
+        return false;
+
+      key  = (u64)block << 56;
+      key |= (u64)erank << 48;
+      key |= (u64)arank << 40;
+
+      if ( mDepthSortMode != AlwaysDepthSort && a->mShader->isBlendingEnabled() )
+        key |= (u64)1 << 39;
+
+      if ( confirmZCameraDistanceNeed(a) )
+      {
+        // render first far objects then the close ones
+        u64 z = (u64)(depth * 0xFFFFFF) & 0xFFFFFF;
+        key |= (0xFFFFFF - z) << 15;
+        key |= hashPointer(a->mShader, 15);
+      }
+      else
+      if ( mFrontToBack )
+      {
+        key |= hashPointer(a->mShader->glslProgram(), 11) << 28;
+        key |= hashPointer(a->mShader, 11) << 17;
+        key |= ((u64)(depth * 0x3F) & 0x3F) << 11;
+        key |= hashPointer(a->mRenderable, 11);
+      }
+      else
+      {
+        key |= hashPointer(a->mShader->glslProgram(), 13) << 26;
+        key |= hashPointer(a->mShader, 13) << 13;
+        key |= hashPointer(a->mRenderable, 13);
+      }
+
+      return true;
+    }
+
+  protected:
+    //! Fibonacci hashing of a pointer to \p bits bits.
+    static u64 hashPointer(const void* ptr, int bits)
+    {
+      return ((u64)(size_t)ptr * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+    }
   };
   //------------------------------------------------------------------------------
   // RenderQueueSorterOcclusion
@@ -62,6 +62,11 @@ namespace vl
     virtual void apply(int index, const Camera* camera, OpenGLContext* ctx) const = 0;
 
     virtual ref<RenderState> clone() const = 0;
+
+    /** Returns true if applying \p other instead of this RenderState would produce the same OpenGL state.
+     * Used by OpenGLContext::applyRenderStates() to skip redundant state changes across different RenderStateSet[s].
+     * The default implementation only compares the pointers, states that depend on the Camera must not override it. */
+    virtual bool isEquivalent(const RenderState* other) const { return other == this; }
   };
   //------------------------------------------------------------------------------
   // RenderStateIndexed
@@ -100,6 +105,11 @@ namespace vl
 
     virtual void apply(const Camera* camera, OpenGLContext* ctx) const { mRS->apply( mIndex, camera, ctx ); }
 
+    bool isEquivalent(const RenderStateSlot& other) const
+    {
+      return mIndex == other.mIndex && ( mRS.get() == other.mRS.get() || ( mRS && other.mRS && mRS->isEquivalent( other.mRS.get() ) ) );
+    }
+
     ERenderState type() const
     {
       if (mIndex > 0)
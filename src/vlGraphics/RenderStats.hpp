@@ -0,0 +1,155 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef RenderStats_INCLUDE_ONCE
+#define RenderStats_INCLUDE_ONCE
+
+#include <vlCore/vlnamespace.hpp>
+#include <vlCore/std_types.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // RenderStats
+  //------------------------------------------------------------------------------
+  /** Counts the OpenGL work issued by the rendering: draw calls, primitives, state changes, GLSL program switches, uniform
+    * and buffer uploads, texture binds and the glGet*() queries issued while rendering.
+    *
+    * Each OpenGLContext owns a RenderStats (see OpenGLContext::renderStats()) which is updated by the Renderer[s], by the
+    * OpenGLContext state-setting functions and by the DrawCall[s] rendered by Geometry. The counters are never reset
+    * automatically: call reset() at the beginning of a frame and read them at its end, or take the difference of two
+    * snapshots. Updating the counters costs a handful of integer increments per state change and per draw call so they
+    * are always enabled.
+    *
+    * \note The triangle count of the DrawCall[s] using primitive restart is estimated without scanning the indices. */
+  class RenderStats
+  {
+  public:
+    RenderStats() { reset(); }
+
+    //! Sets all the counters to zero.
+    void reset()
+    {
+      mDrawCalls = 0;
+      mVertices = 0;
+      mTriangles = 0;
+      mActors = 0;
+      mRenderStateChanges = 0;
+      mEnableChanges = 0;
+      mGLSLProgramSwitches = 0;
+      mUniformSetUploads = 0;
+      mUniformUploads = 0;
+      mVertexAttribSetBinds = 0;
+      mBufferBinds = 0;
+      mTextureBinds = 0;
+      mGLQueries = 0;
+    }
+
+    //! Adds the counters of \p other to this one.
+    RenderStats& operator+=(const RenderStats& other)
+    {
+      mDrawCalls += other.mDrawCalls;
+      mVertices += other.mVertices;
+      mTriangles += other.mTriangles;
+      mActors += other.mActors;
+      mRenderStateChanges += other.mRenderStateChanges;
+      mEnableChanges += other.mEnableChanges;
+      mGLSLProgramSwitches += other.mGLSLProgramSwitches;
+      mUniformSetUploads += other.mUniformSetUploads;
+      mUniformUploads += other.mUniformUploads;
+      mVertexAttribSetBinds += other.mVertexAttribSetBinds;
+      mBufferBinds += other.mBufferBinds;
+      mTextureBinds += other.mTextureBinds;
+      mGLQueries += other.mGLQueries;
+      return *this;
+    }
+
+    //! Counts a draw call rendering \p vertex_count vertices of the given type \p instances times.
+    void countDrawCall(EPrimitiveType type, u32 vertex_count, int instances)
+    {
+      ++mDrawCalls;
+      countPrimitives(type, vertex_count, instances);
+    }
+
+    //! Counts the vertices and triangles rendered by \p vertex_count vertices of the given type, without counting a draw call.
+    void countPrimitives(EPrimitiveType type, u32 vertex_count, int instances)
+    {
+      u64 n = vertex_count;
+      u64 triangles = 0;
+      switch(type)
+      {
+      case PT_TRIANGLES:                triangles = n / 3; break;
+      case PT_TRIANGLE_STRIP:
+      case PT_TRIANGLE_FAN:
+      case PT_POLYGON:                  triangles = n > 2 ? n - 2 : 0; break;
+      case PT_QUADS:                    triangles = n / 4 * 2; break;
+      case PT_QUAD_STRIP:               triangles = n > 3 ? (n - 2) / 2 * 2 : 0; break;
+      case PT_TRIANGLES_ADJACENCY:      triangles = n / 6; break;
+      case PT_TRIANGLE_STRIP_ADJACENCY: triangles = n > 5 ? (n - 4) / 2 : 0; break;
+      default: break;
+      }
+      mVertices  += n * instances;
+      mTriangles += triangles * instances;
+    }
+
+  public:
+    //! Number of glDraw* calls.
+    u64 mDrawCalls;
+    //! Number of vertices submitted, instances included.
+    u64 mVertices;
+    //! Number of triangles submitted, instances included.
+    u64 mTriangles;
+    //! Number of Actor passes rendered by the Renderer[s].
+    u64 mActors;
+    //! Number of RenderState[s] applied, including the ones restored to their default value.
+    u64 mRenderStateChanges;
+    //! Number of glEnable/glDisable calls.
+    u64 mEnableChanges;
+    //! Number of glUseProgram calls.
+    u64 mGLSLProgramSwitches;
+    //! Number of UniformSet[s] applied by the Renderer[s].
+    u64 mUniformSetUploads;
+    //! Number of Uniform[s] applied by the Renderer[s].
+    u64 mUniformUploads;
+    //! Number of times a different vertex attribute set (ie. Geometry) has been bound.
+    u64 mVertexAttribSetBinds;
+    //! Number of vertex and index buffer binds.
+    u64 mBufferBinds;
+    //! Number of TextureSampler[s] applied.
+    u64 mTextureBinds;
+    //! Number of synchronous glGet*() queries issued while a Renderer was rendering, see OpenGLContext::countGLQuery().
+    u64 mGLQueries;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
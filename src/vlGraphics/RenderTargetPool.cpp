@@ -0,0 +1,281 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/RenderTargetPool.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// RenderTargetPool
+//-----------------------------------------------------------------------------
+RenderTargetPool::RenderTargetPool(OpenGLContext* ctx): mOpenGLContext(ctx)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mFrame = 0;
+  mAllocations = 0;
+  mReuses = 0;
+  mMaxIdleFrames = 2;
+}
+//-----------------------------------------------------------------------------
+RenderTargetPool::~RenderTargetPool()
+{
+  clear();
+}
+//-----------------------------------------------------------------------------
+Object* RenderTargetPool::acquireFree(const Key& key)
+{
+  EntryMap::iterator it = mEntries.find(key);
+  if ( it == mEntries.end() )
+    return NULL;
+
+  std::vector<Entry>& entries = it->second;
+  for( size_t i=0; i<entries.size(); ++i )
+  {
+    if ( !entries[i].mAcquired )
+    {
+      entries[i].mAcquired = true;
+      entries[i].mLastUsedFrame = mFrame;
+      mAcquired.insert( std::make_pair(entries[i].mTarget.get(), key) );
+      ++mReuses;
+      return entries[i].mTarget.get();
+    }
+  }
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::addAcquired(const Key& key, Object* target)
+{
+  Entry entry;
+  entry.mTarget = target;
+  entry.mLastUsedFrame = mFrame;
+  entry.mAcquired = true;
+  mEntries[key].push_back(entry);
+  mAcquired.insert( std::make_pair(target, key) );
+  ++mAllocations;
+}
+//-----------------------------------------------------------------------------
+FBOColorBufferAttachment* RenderTargetPool::acquireColorBuffer(int width, int height, EColorBufferFormat format, int samples)
+{
+  Key key(ColorBuffer, width, height, format, samples);
+  if ( Object* target = acquireFree(key) )
+    return static_cast<FBOColorBufferAttachment*>(target);
+
+  // explicit dimensions: the storage is allocated once, whatever FramebufferObject the attachment is bound to
+  ref<FBOColorBufferAttachment> buffer = new FBOColorBufferAttachment(format);
+  buffer->setWidth(width);
+  buffer->setHeight(height);
+  buffer->setSamples(samples);
+  addAcquired(key, buffer.get());
+  return buffer.get();
+}
+//-----------------------------------------------------------------------------
+FBODepthBufferAttachment* RenderTargetPool::acquireDepthBuffer(int width, int height, EDepthBufferFormat format, int samples)
+{
+  Key key(DepthBuffer, width, height, format, samples);
+  if ( Object* target = acquireFree(key) )
+    return static_cast<FBODepthBufferAttachment*>(target);
+
+  ref<FBODepthBufferAttachment> buffer = new FBODepthBufferAttachment(format);
+  buffer->setWidth(width);
+  buffer->setHeight(height);
+  buffer->setSamples(samples);
+  addAcquired(key, buffer.get());
+  return buffer.get();
+}
+//-----------------------------------------------------------------------------
+FBODepthStencilBufferAttachment* RenderTargetPool::acquireDepthStencilBuffer(int width, int height, EDepthStencilBufferFormat format, int samples)
+{
+  Key key(DepthStencilBuffer, width, height, format, samples);
+  if ( Object* target = acquireFree(key) )
+    return static_cast<FBODepthStencilBufferAttachment*>(target);
+
+  ref<FBODepthStencilBufferAttachment> buffer = new FBODepthStencilBufferAttachment(format);
+  buffer->setWidth(width);
+  buffer->setHeight(height);
+  buffer->setSamples(samples);
+  addAcquired(key, buffer.get());
+  return buffer.get();
+}
+//-----------------------------------------------------------------------------
+Texture* RenderTargetPool::acquireTexture(int width, int height, ETextureFormat format, int samples)
+{
+  Key key(Texture2D, width, height, format, samples);
+  if ( Object* target = acquireFree(key) )
+    return static_cast<Texture*>(target);
+
+  mOpenGLContext->makeCurrent();
+  ref<Texture> texture;
+  if ( samples > 0 )
+  {
+    texture = new Texture;
+    if ( !texture->createTexture2DMultisample(width, height, format, samples, true) )
+    {
+      Log::error( Say("RenderTargetPool::acquireTexture(): could not create a %nx%n texture with %n samples.\n") << width << height << samples );
+      return NULL;
+    }
+  }
+  else
+    texture = new Texture(width, height, format, false);
+
+  addAcquired(key, texture.get());
+  return texture.get();
+}
+//-----------------------------------------------------------------------------
+FramebufferObject* RenderTargetPool::acquireFramebuffer(int width, int height)
+{
+  Key key(Framebuffer, width, height, 0, 0);
+  if ( Object* target = acquireFree(key) )
+    return static_cast<FramebufferObject*>(target);
+
+  ref<FramebufferObject> fbo = mOpenGLContext->createFramebufferObject(width, height);
+  addAcquired(key, fbo.get());
+  return fbo.get();
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::release(Object* target)
+{
+  std::map< const Object*, Key >::iterator it = mAcquired.find(target);
+  if ( it == mAcquired.end() )
+  {
+    Log::error("RenderTargetPool::release(): the target was not acquired from this pool.\n");
+    return;
+  }
+
+  std::vector<Entry>& entries = mEntries[it->second];
+  for( size_t i=0; i<entries.size(); ++i )
+  {
+    if ( entries[i].mTarget.get() == target )
+    {
+      entries[i].mAcquired = false;
+      entries[i].mLastUsedFrame = mFrame;
+      break;
+    }
+  }
+
+  // a recycled framebuffer comes without attachments
+  if ( it->second.mKind == Framebuffer )
+    static_cast<FramebufferObject*>(target)->removeAllAttachments();
+
+  mAcquired.erase(it);
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::newFrame()
+{
+  ++mFrame;
+
+  for( EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); )
+  {
+    std::vector<Entry>& entries = it->second;
+    for( size_t i=0; i<entries.size(); )
+    {
+      if ( !entries[i].mAcquired && mFrame - entries[i].mLastUsedFrame > (unsigned long)mMaxIdleFrames )
+      {
+        destroyTarget( it->first, entries[i].mTarget.get() );
+        entries.erase( entries.begin() + i );
+      }
+      else
+        ++i;
+    }
+
+    if ( entries.empty() )
+      mEntries.erase(it++);
+    else
+      ++it;
+  }
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::purge()
+{
+  for( EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); )
+  {
+    std::vector<Entry>& entries = it->second;
+    for( size_t i=0; i<entries.size(); )
+    {
+      if ( !entries[i].mAcquired )
+      {
+        destroyTarget( it->first, entries[i].mTarget.get() );
+        entries.erase( entries.begin() + i );
+      }
+      else
+        ++i;
+    }
+
+    if ( entries.empty() )
+      mEntries.erase(it++);
+    else
+      ++it;
+  }
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::clear()
+{
+  for( EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); ++it )
+    for( size_t i=0; i<it->second.size(); ++i )
+      destroyTarget( it->first, it->second[i].mTarget.get() );
+  mEntries.clear();
+  mAcquired.clear();
+}
+//-----------------------------------------------------------------------------
+void RenderTargetPool::destroyTarget(const Key& key, Object* target)
+{
+  switch( key.mKind )
+  {
+  case ColorBuffer:
+  case DepthBuffer:
+  case DepthStencilBuffer:
+    // breaks the reference cycle with the framebuffers, the renderbuffer is deleted with the attachment
+    static_cast<FBOAbstractAttachment*>(target)->unbindFromAllFBO();
+    break;
+  case Texture2D:
+    static_cast<Texture*>(target)->destroyTexture();
+    break;
+  case Framebuffer:
+  {
+    FramebufferObject* fbo = static_cast<FramebufferObject*>(target);
+    fbo->removeAllAttachments();
+    if ( fbo->openglContext() )
+      fbo->openglContext()->destroyFramebufferObject(fbo);
+    break;
+  }
+  }
+}
+//-----------------------------------------------------------------------------
+int RenderTargetPool::targetCount() const
+{
+  int count = 0;
+  for( EntryMap::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it )
+    count += (int)it->second.size();
+  return count;
+}
+//-----------------------------------------------------------------------------
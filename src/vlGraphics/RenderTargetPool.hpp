@@ -0,0 +1,182 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef RenderTargetPool_INCLUDE_ONCE
+#define RenderTargetPool_INCLUDE_ONCE
+
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  class OpenGLContext;
+//-----------------------------------------------------------------------------
+// RenderTargetPool
+//-----------------------------------------------------------------------------
+  /**
+   * Hands out transient render targets (renderbuffer attachments, textures and FramebufferObject[s]) by size, format and sample count,
+   * recycling them instead of allocating new ones for every pass of a post-processing chain.
+   *
+   * A target acquired with one of the \p acquire*() functions is reserved until it is given back with release(). Releasing the
+   * targets of a pass as soon as the following passes stop reading them lets the later passes of the same frame alias the same
+   * memory: a pass acquiring a target with the same size, format and sample count receives the released one.
+   *
+   * Call newFrame() once per frame: the free targets not acquired for more than maxIdleFrames() frames are destroyed, so
+   * that after a resize the targets of the old size are dropped instead of accumulating.
+   *
+   * \code
+   * RenderTargetPool* pool = openglContext()->renderTargetPool();
+   * pool->newFrame();
+   * FramebufferObject* fbo = pool->acquireFramebuffer(w, h);
+   * Texture* blur_h = pool->acquireTexture(w, h, TF_RGBA8);
+   * fbo->addTextureAttachment( AP_COLOR_ATTACHMENT0, new FBOTexture2DAttachment(blur_h, 0, T2DT_TEXTURE_2D) );
+   * // ... render the first pass, then the second pass reading blur_h ...
+   * pool->release(blur_h);
+   * pool->release(fbo);
+   * \endcode
+   *
+   * The pool belongs to an OpenGLContext (see OpenGLContext::renderTargetPool()) whose context must be current when acquiring,
+   * releasing and destroying the targets.
+   */
+  class VLGRAPHICS_EXPORT RenderTargetPool: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::RenderTargetPool, Object)
+
+  public:
+    RenderTargetPool(OpenGLContext* ctx);
+    ~RenderTargetPool();
+
+    OpenGLContext* openglContext() { return mOpenGLContext; }
+    const OpenGLContext* openglContext() const { return mOpenGLContext; }
+
+    //! Returns a color renderbuffer with the given size, format and sample count.
+    FBOColorBufferAttachment* acquireColorBuffer(int width, int height, EColorBufferFormat format, int samples=0);
+
+    //! Returns a depth renderbuffer with the given size, format and sample count.
+    FBODepthBufferAttachment* acquireDepthBuffer(int width, int height, EDepthBufferFormat format, int samples=0);
+
+    //! Returns a combined depth/stencil renderbuffer with the given size, format and sample count.
+    FBODepthStencilBufferAttachment* acquireDepthStencilBuffer(int width, int height, EDepthStencilBufferFormat format, int samples=0);
+
+    //! Returns a 2D texture, multisample if \p samples > 0, to be attached with FBOTexture2DAttachment and sampled by the following passes.
+    Texture* acquireTexture(int width, int height, ETextureFormat format, int samples=0);
+
+    //! Returns a FramebufferObject of the given size without attachments, the attachments are removed by release().
+    FramebufferObject* acquireFramebuffer(int width, int height);
+
+    //! Gives back a target acquired from this pool so that it can be reused. The target must not be used anymore.
+    //! Renderbuffers and textures stay attached to their FramebufferObject[s], which are usually released together with them.
+    void release(Object* target);
+
+    //! Returns true if the given target has been acquired from this pool and not yet released.
+    bool isAcquired(const Object* target) const { return mAcquired.find(target) != mAcquired.end(); }
+
+    //! Advances the frame counter and destroys the free targets idle for more than maxIdleFrames() frames.
+    void newFrame();
+
+    //! Destroys all the free targets. The acquired ones are kept.
+    void purge();
+
+    //! Destroys all the targets, including the acquired ones. Called by OpenGLContext::destroyAllOpenGLResources().
+    void clear();
+
+    //! Number of frames a free target is kept before being destroyed. Default is 2.
+    void setMaxIdleFrames(int frames) { mMaxIdleFrames = frames; }
+    int maxIdleFrames() const { return mMaxIdleFrames; }
+
+    //! The value of the frame counter advanced by newFrame().
+    unsigned long frame() const { return mFrame; }
+
+    //! Number of targets currently owned by the pool, acquired or free.
+    int targetCount() const;
+
+    //! Number of targets currently acquired.
+    int acquiredCount() const { return (int)mAcquired.size(); }
+
+    //! Number of targets created so far.
+    unsigned long allocations() const { return mAllocations; }
+
+    //! Number of acquisitions served by a recycled target.
+    unsigned long reuses() const { return mReuses; }
+
+  protected:
+    enum ETargetKind { ColorBuffer, DepthBuffer, DepthStencilBuffer, Texture2D, Framebuffer };
+
+    struct Key
+    {
+      Key(ETargetKind kind, int width, int height, int format, int samples): mKind(kind), mWidth(width), mHeight(height), mFormat(format), mSamples(samples) {}
+
+      bool operator<(const Key& other) const
+      {
+        if (mKind != other.mKind) return mKind < other.mKind;
+        if (mWidth != other.mWidth) return mWidth < other.mWidth;
+        if (mHeight != other.mHeight) return mHeight < other.mHeight;
+        if (mFormat != other.mFormat) return mFormat < other.mFormat;
+        return mSamples < other.mSamples;
+      }
+
+      ETargetKind mKind;
+      int mWidth;
+      int mHeight;
+      int mFormat;
+      int mSamples;
+    };
+
+    struct Entry
+    {
+      Entry(): mLastUsedFrame(0), mAcquired(false) {}
+      ref<Object> mTarget;
+      unsigned long mLastUsedFrame;
+      bool mAcquired;
+    };
+
+    typedef std::map< Key, std::vector<Entry> > EntryMap;
+
+    //! Returns a free target with the given key, or NULL.
+    Object* acquireFree(const Key& key);
+    //! Registers a newly created target as acquired.
+    void addAcquired(const Key& key, Object* target);
+    void destroyTarget(const Key& key, Object* target);
+
+  protected:
+    OpenGLContext* mOpenGLContext;
+    EntryMap mEntries;
+    std::map< const Object*, Key > mAcquired;
+    unsigned long mFrame;
+    unsigned long mAllocations;
+    unsigned long mReuses;
+    int mMaxIdleFrames;
+  };
+}
+
+#endif
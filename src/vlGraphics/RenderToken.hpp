@@ -43,16 +43,13 @@ namespace vl
   //------------------------------------------------------------------------------
   // RenderToken
   //------------------------------------------------------------------------------
-  //! Internally used by the rendering engine
-  class RenderToken: public Object
+  //! Internally used by the rendering engine.
+  //! RenderToken[s] are plain structures pooled and owned by the RenderQueue, see RenderQueue::newToken().
+  class RenderToken
   {
-    VL_INSTRUMENT_CLASS(vl::RenderToken, Object)
-
   public:
-    RenderToken(): mNextPass(NULL), mActor(NULL), mShader(NULL), mEffectRenderRank(0), mCameraDistance(0.0)
-    {
-      VL_DEBUG_SET_OBJECT_NAME()
-    }
+    RenderToken(): mNextPass(NULL), mActor(NULL), mRenderable(NULL), mShader(NULL), mEffectRenderRank(0), mCameraDistance(0.0), mConditionalQuery(0) {}
+
     const RenderToken* mNextPass;
 
     Actor* mActor; // Actor is non-const as it can be updated by the ActorEventCallback
@@ -61,6 +58,8 @@ namespace vl
     int mEffectRenderRank;
     // Z distance from the camera. Used for object Z-sorting.
     real mCameraDistance;
+    // if not 0 the Actor is rendered inside glBeginConditionalRender() using this query, see OcclusionCullRenderer::setConditionalRendering().
+    GLuint mConditionalQuery;
   };
   //------------------------------------------------------------------------------
 }
@@ -37,6 +37,7 @@
 #include <vlCore/AABB.hpp>
 #include <vlCore/Sphere.hpp>
 #include <vlCore/Log.hpp>
+#include <vlCore/MemoryTracker.hpp>
 #include <vlGraphics/OpenGL.hpp>
 
 namespace vl
@@ -85,6 +86,7 @@ namespace vl
           if ( !displayList() )
           {
             setDisplayList( glGenLists(1) ); VL_CHECK_OGL();
+            MemoryTracker::track( MC_DisplayList, 0, 1 );
           }
           VL_CHECK( displayList() );
           glNewList( displayList(), GL_COMPILE_AND_EXECUTE ); VL_CHECK_OGL();
@@ -221,7 +223,10 @@ namespace vl
     void deleteDisplayList()
     {
       if (displayList())
+      {
         glDeleteLists(displayList(), 1);
+        MemoryTracker::track( MC_DisplayList, 0, -1 );
+      }
       mDisplayList = 0;
     }
 
@@ -36,6 +36,7 @@
 #include <vlGraphics/GLSL.hpp>
 #include <vlGraphics/RenderQueue.hpp>
 #include <vlCore/Log.hpp>
+#include <vlCore/ScopedMutex.hpp>
 
 using namespace vl;
 
@@ -50,47 +51,48 @@ Renderer::Renderer()
 
   mDummyEnables  = new EnableSet;
   mDummyStateSet = new RenderStateSet;
+
+  mCommandListMutex = NULL;
+
+  mInvalidateOnStart  = 0;
+  mInvalidateOnFinish = 0;
 }
 //------------------------------------------------------------------------------
-namespace
+void Renderer::submitCommandList(CommandList* command_list)
 {
-  struct GLSLProgState
-  {
-  public:
-    GLSLProgState(): mCamera(NULL), mTransform(NULL), mGLSLProgUniformSet(NULL), mShaderUniformSet(NULL), mActorUniformSet(NULL) {}
-
-    bool operator<(const GLSLProgState& other) const
-    {
-      if ( mCamera != other.mCamera )
-        return mCamera < other.mCamera;
-      else
-      if ( mTransform != other.mTransform )
-        return mTransform < other.mTransform;
-      else
-      if ( mGLSLProgUniformSet != other.mGLSLProgUniformSet )
-        return mGLSLProgUniformSet < other.mGLSLProgUniformSet;
-      else
-      if ( mShaderUniformSet != other.mShaderUniformSet )
-        return mShaderUniformSet < other.mShaderUniformSet;
-      else
-        return mActorUniformSet < other.mActorUniformSet;
-    }
-
-    const Camera* mCamera;
-    const Transform* mTransform;
-    const UniformSet* mGLSLProgUniformSet;
-    const UniformSet* mShaderUniformSet;
-    const UniformSet* mActorUniformSet;
-  };
+  ScopedMutex lock(mCommandListMutex);
+  mSubmittedCommandLists.push_back(command_list);
 }
 //------------------------------------------------------------------------------
 const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera* camera, real frame_clock) {
 
-  // FIXME: use a small & simple hash-map<int, GLSLProgState> allocated on the stack
-  // mapping the GLSL program ID to the corresponding GLSLProgState.
-  std::map<const GLSLProgram*, GLSLProgState> glslprogram_map;
+  // the per-program states are stored directly in the GLSLPrograms (see GLSLProgram::RendererState):
+  // a program whose state is not claimed by this renderer is seen for the first time in this rendering.
+  // The claimed states are released at the end of the rendering.
+  mFixedFunctionState = GLSLProgram::RendererState();
+  mClaimedGLSLPrograms.clear();
 
   OpenGLContext* opengl_context = framebuffer()->openglContext();
+  RenderStats& stats = opengl_context->renderStats();
+  opengl_context->beginRenderRaw();
+
+  // --------------- command lists ---------------
+
+  // take the submitted command lists so that workers can keep submitting while we render
+  {
+    ScopedMutex lock(mCommandListMutex);
+    mReplayedCommandLists.swap(mSubmittedCommandLists);
+  }
+
+  // buffer updates and texture uploads happen before any rendering
+  mRenderQueues.clear();
+  mRenderQueues.push_back(render_queue);
+  for(size_t i=0; i<mReplayedCommandLists.size(); ++i)
+  {
+    mReplayedCommandLists[i]->executeCommands(opengl_context);
+    for(size_t j=0; j<mReplayedCommandLists[i]->renderQueues().size(); ++j)
+      mRenderQueues.push_back( mReplayedCommandLists[i]->renderQueues()[j].get() );
+  }
 
   // --------------- default scissor ---------------
 
@@ -105,18 +107,33 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
   glEnable(GL_SCISSOR_TEST);
   glScissor(camera->viewport()->x(), camera->viewport()->y(), camera->viewport()->width(), camera->viewport()->height());
   */
+  opengl_context->setScissorState( camera->viewport()->isScissorEnabled(), camera->viewport()->rect() );
 
   // --------------- rendering ---------------
 
-  for(int itok=0; itok < render_queue->size(); ++itok)
+  // per-Effect GPU scopes
+  FrameProfiler* profiler = mProfiler && mProfiler->isFrameOpen() && mProfiler->effectScopes() ? mProfiler.get() : NULL;
+  const Effect* cur_effect = NULL;
+
+  for(size_t iqueue=0; iqueue < mRenderQueues.size(); ++iqueue)
+  for(int itok=0; itok < mRenderQueues[iqueue]->size(); ++itok)
   {
-    const RenderToken* tok = render_queue->at(itok); VL_CHECK(tok);
+    const RenderToken* tok = mRenderQueues[iqueue]->at(itok); VL_CHECK(tok);
     Actor* actor = tok->mActor; VL_CHECK(actor);
 
     if ( ! isEnabled( actor ) ) {
       continue;
     }
 
+    if ( profiler && cur_effect != actor->effect() )
+    {
+      if ( cur_effect ) {
+        profiler->endScope();
+      }
+      cur_effect = actor->effect();
+      profiler->beginScope( cur_effect->objectName().c_str(), true );
+    }
+
     // --------------- Actor's scissor ---------------
 
     // MIC FIXME:
@@ -132,15 +149,26 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       if (cur_scissor)
       {
         cur_scissor->enable(camera->viewport());
+        RectI box = camera->viewport()->rect().intersected(cur_scissor->scissorRect());
+        opengl_context->setScissorState( true, box.isNull() ? RectI(0,0,0,0) : box );
       }
       else
       {
         // scissor the viewport by default: needed for points and lines with size > 1.0 as they are not clipped against the viewport.
         VL_CHECK(glIsEnabled(GL_SCISSOR_TEST))
         glScissor(camera->viewport()->x(), camera->viewport()->y(), camera->viewport()->width(), camera->viewport()->height());
+        opengl_context->setScissorState( true, camera->viewport()->rect() );
       }
     }
 
+    // --------------- conditional rendering ---------------
+
+    // the GPU discards all the passes of the Actor if its occlusion query of the previous frame passed no samples.
+    const GLuint conditional_query = tok->mConditionalQuery;
+    if ( conditional_query ) {
+      VL_glBeginConditionalRender( conditional_query, GL_QUERY_NO_WAIT ); VL_CHECK_OGL()
+    }
+
     // multipassing
     for( int ipass=0; tok != NULL; tok = tok->mNextPass, ++ipass )
     {
@@ -163,6 +191,17 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
         }
       }
 
+      // skip the pass while its GLSLProgram is being linked in parallel and no fallback is available
+
+      if ( shader->glslProgram() && ! shader->glslProgram()->activeProgram() )
+        continue;
+
+#ifdef VL_MULTI_CONTEXT_RENDERING
+      // the uniforms of a GLSLProgram are shared by its share group: contexts rendered concurrently need their own programs
+      if ( shader->glslProgram() && opengl_context->concurrentRendering() && ! shader->glslProgram()->activeProgram()->claimRenderContext( opengl_context ) )
+        continue;
+#endif
+
       // shader's render states
 
       if ( cur_render_state_set != shader->getRenderStateSet() )
@@ -182,7 +221,7 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       }
 
       #ifndef NDEBUG
-        if (glGetError() != GL_NO_ERROR)
+        if (!Is_GL_Debug_Output_Active && glGetError() != GL_NO_ERROR)
         {
           Log::error("An unsupported OpenGL glEnable/glDisable capability has been enabled!\n");
           VL_TRAP()
@@ -209,18 +248,19 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       const UniformSet*  cur_actor_uniform_set     = NULL;
 
       // make sure we update these things only if there is a valid GLSLProgram
-      if ( shader->glslProgram() && shader->glslProgram()->handle() && shader->glslProgram()->linked() )
+      const GLSLProgram* active_glsl_program = shader->glslProgram() ? shader->glslProgram()->activeProgram() : NULL;
+      if ( active_glsl_program && active_glsl_program->handle() && active_glsl_program->linked() )
       {
-        cur_glsl_program = shader->glslProgram();
+        cur_glsl_program = active_glsl_program;
 
         // consider them NULL if they are empty
-        if (cur_glsl_program->getUniformSet() && !cur_glsl_program->getUniformSet()->uniforms().empty())
+        if (cur_glsl_program->getUniformSet() && !cur_glsl_program->getUniformSet()->empty())
           cur_glsl_prog_uniform_set = cur_glsl_program->getUniformSet();
 
-        if (shader->getUniformSet() && !shader->getUniformSet()->uniforms().empty())
+        if (shader->getUniformSet() && !shader->getUniformSet()->empty())
           cur_shader_uniform_set = shader->getUniformSet();
 
-        if (actor->getUniformSet() && !actor->getUniformSet()->uniforms().empty())
+        if (actor->getUniformSet() && !actor->getUniformSet()->empty())
           cur_actor_uniform_set = actor->getUniformSet();
       }
 
@@ -229,19 +269,21 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       bool update_pu = false; // update glsl-program uniforms
       bool update_su = false; // update shader uniforms
       bool update_au = false; // update actor uniforms
-      GLSLProgState* glsl_state = NULL;
 
       // retrieve the state of this GLSLProgram (including the NULL one)
-      std::map<const GLSLProgram*, GLSLProgState>::iterator glsl_state_it = glslprogram_map.find(cur_glsl_program);
+      GLSLProgram::RendererState* glsl_state = cur_glsl_program ? &cur_glsl_program->mRendererState : &mFixedFunctionState;
 
-      if ( glsl_state_it == glslprogram_map.end() )
+      if ( glsl_state->mRenderer != this )
       {
         //
         // this is the first time we see this GLSL program so we update everything we can
         //
 
-        // create a new glsl-state entry
-        glsl_state = &glslprogram_map[cur_glsl_program];
+        // claim the glsl-state entry
+        glsl_state->mRenderer = this;
+        if ( cur_glsl_program ) {
+          mClaimedGLSLPrograms.push_back( cur_glsl_program );
+        }
         update_cm = true;
         update_tr = true;
         update_pu = cur_glsl_prog_uniform_set != NULL;
@@ -254,7 +296,6 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
         // we already know this GLSLProgram so we update only what has changed since last time
         //
 
-        glsl_state = &glsl_state_it->second;
         // check for differences
         update_cm = glsl_state->mCamera             != camera;
         update_tr = glsl_state->mTransform          != cur_transform;
@@ -292,9 +333,11 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       // glsl program uniform set
       if ( update_pu )
       {
-        VL_CHECK( cur_glsl_prog_uniform_set && cur_glsl_prog_uniform_set->uniforms().size() );
+        VL_CHECK( cur_glsl_prog_uniform_set && !cur_glsl_prog_uniform_set->empty() );
         VL_CHECK( shader->getRenderStateSet()->glslProgram() && shader->getRenderStateSet()->glslProgram()->handle() )
-        cur_glsl_program->applyUniformSet( cur_glsl_prog_uniform_set );
+        cur_glsl_program->applyUniformSet( cur_glsl_prog_uniform_set, opengl_context );
+        ++stats.mUniformSetUploads;
+        stats.mUniformUploads += cur_glsl_prog_uniform_set->uniforms().size();
       }
 
       VL_CHECK_OGL()
@@ -302,9 +345,11 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       // shader uniform set
       if ( update_su )
       {
-        VL_CHECK( cur_shader_uniform_set && cur_shader_uniform_set->uniforms().size() );
+        VL_CHECK( cur_shader_uniform_set && !cur_shader_uniform_set->empty() );
         VL_CHECK( shader->getRenderStateSet()->glslProgram() && shader->getRenderStateSet()->glslProgram()->handle() )
-        cur_glsl_program->applyUniformSet( cur_shader_uniform_set );
+        cur_glsl_program->applyUniformSet( cur_shader_uniform_set, opengl_context );
+        ++stats.mUniformSetUploads;
+        stats.mUniformUploads += cur_shader_uniform_set->uniforms().size();
       }
 
       VL_CHECK_OGL()
@@ -312,9 +357,11 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       // actor uniform set
       if ( update_au )
       {
-        VL_CHECK( cur_actor_uniform_set && cur_actor_uniform_set->uniforms().size() );
+        VL_CHECK( cur_actor_uniform_set && !cur_actor_uniform_set->empty() );
         VL_CHECK( shader->getRenderStateSet()->glslProgram() && shader->getRenderStateSet()->glslProgram()->handle() )
-        cur_glsl_program->applyUniformSet( cur_actor_uniform_set );
+        cur_glsl_program->applyUniformSet( cur_actor_uniform_set, opengl_context );
+        ++stats.mUniformSetUploads;
+        stats.mUniformUploads += cur_actor_uniform_set->uniforms().size();
       }
 
       VL_CHECK_OGL()
@@ -331,6 +378,7 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
 
       // also compiles display lists and updates BufferObjects if necessary
       tok->mRenderable->render( actor, shader, camera, opengl_context );
+      ++stats.mActors;
 
       VL_CHECK_OGL()
 
@@ -338,7 +386,25 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
       if (shader != tok->mShader)
         break;
     }
+
+    if ( conditional_query ) {
+      VL_glEndConditionalRender(); VL_CHECK_OGL()
+    }
+  }
+
+  if ( profiler && cur_effect ) {
+    profiler->endScope();
+  }
+
+  // release the replayed command lists
+  mRenderQueues.clear();
+  mReplayedCommandLists.clear();
+
+  // release the glsl-states claimed during this rendering
+  for( size_t i = 0; i < mClaimedGLSLPrograms.size(); ++i ) {
+    mClaimedGLSLPrograms[i]->mRendererState = GLSLProgram::RendererState();
   }
+  mClaimedGLSLPrograms.clear();
 
   // clear enables
   opengl_context->applyEnables( mDummyEnables.get() ); VL_CHECK_OGL();
@@ -354,10 +420,13 @@ const RenderQueue* Renderer::renderRaw(const RenderQueue* render_queue, Camera*
 
   // disable scissor test
   glDisable( GL_SCISSOR_TEST ); VL_CHECK_OGL();
+  opengl_context->setScissorState( false, RectI(0,0,0,0) );
 
   // disable all vertex arrays, note this also calls "glBindBuffer(GL_ARRAY_BUFFER, 0)"
   opengl_context->bindVAS( NULL, false, false ); VL_CHECK_OGL();
 
+  opengl_context->endRenderRaw();
+
   return render_queue;
 }
 //------------------------------------------------------------------------------
@@ -376,7 +445,6 @@ const RenderQueue* Renderer::render(const RenderQueue* render_queue, Camera* cam
   class InOutContract
   {
     Renderer* mRenderer;
-    std::vector<RenderStateSlot> mOriginalDefaultRS;
   public:
     InOutContract(Renderer* renderer, Camera* camera): mRenderer(renderer)
     {
@@ -388,17 +456,40 @@ const RenderQueue* Renderer::render(const RenderQueue* render_queue, Camera* cam
       mRenderer->framebuffer()->activate();
 
       // viewport setup.
-      camera->viewport()->setClearFlags( mRenderer->clearFlags() );
-      camera->viewport()->activate();
+      Viewport* viewport = camera->viewport();
+      viewport->setClearFlags( mRenderer->clearFlags() );
+
+      // load policy: prefer a full framebuffer clear, invalidate what is not cleared.
+      int invalidate_mask = mRenderer->invalidateOnStart();
+      const int clear_mask = mRenderer->clearFlags();
+      const Framebuffer* fb = mRenderer->framebuffer();
+      bool full_clear = false;
+      if ( clear_mask )
+      {
+        bool covers_framebuffer = viewport->x() <= 0 && viewport->y() <= 0 &&
+                                  viewport->x() + viewport->width()  >= fb->width() &&
+                                  viewport->y() + viewport->height() >= fb->height();
+        full_clear = covers_framebuffer || ( clear_mask & ~invalidate_mask ) == 0;
+        if ( full_clear )
+          invalidate_mask &= ~clear_mask;
+      }
+      mRenderer->framebuffer()->invalidate( invalidate_mask );
+
+      bool scissor_enabled = viewport->isScissorEnabled();
+      if ( full_clear )
+        viewport->setScissorEnabled( false );
+      viewport->activate();
+      viewport->setScissorEnabled( scissor_enabled );
 
       OpenGLContext* gl_context = renderer->framebuffer()->openglContext();
 
       // default render states override
+      mRenderer->mOriginalDefaultRenderStates.clear();
       for(size_t i=0; i<renderer->overriddenDefaultRenderStates().size(); ++i)
       {
         // save overridden default render state to be restored later
         ERenderState type = renderer->overriddenDefaultRenderStates()[i].type();
-        mOriginalDefaultRS.push_back(gl_context->defaultRenderState(type));
+        mRenderer->mOriginalDefaultRenderStates.push_back(gl_context->defaultRenderState(type));
         // set new default render state
         gl_context->setDefaultRenderState(renderer->overriddenDefaultRenderStates()[i]);
       }
@@ -415,13 +506,21 @@ const RenderQueue* Renderer::render(const RenderQueue* render_queue, Camera* cam
       // dispatch the renderer-finished event
       mRenderer->dispatchOnRendererFinished();
 
+      // store policy: the callbacks might have bound another framebuffer.
+      if ( mRenderer->invalidateOnFinish() )
+      {
+        mRenderer->framebuffer()->activate();
+        mRenderer->framebuffer()->invalidate( mRenderer->invalidateOnFinish() );
+      }
+
       OpenGLContext* gl_context = mRenderer->framebuffer()->openglContext();
 
       // restore default render states
-      for(size_t i=0; i<mOriginalDefaultRS.size(); ++i)
+      for(size_t i=0; i<mRenderer->mOriginalDefaultRenderStates.size(); ++i)
       {
-        gl_context->setDefaultRenderState(mOriginalDefaultRS[i]);
+        gl_context->setDefaultRenderState(mRenderer->mOriginalDefaultRenderStates[i]);
       }
+      mRenderer->mOriginalDefaultRenderStates.clear();
 
       VL_CHECK( !globalSettings()->checkOpenGLStates() || mRenderer->framebuffer()->openglContext()->isCleanState(true) );
 
@@ -35,7 +35,11 @@
 #include <vlGraphics/RendererAbstract.hpp>
 #include <vlGraphics/ProjViewTransfCallback.hpp>
 #include <vlGraphics/Shader.hpp>
+#include <vlGraphics/GLSL.hpp>
 #include <vlGraphics/Actor.hpp>
+#include <vlGraphics/CommandList.hpp>
+#include <vlGraphics/FrameProfiler.hpp>
+#include <vlCore/IMutex.hpp>
 #include <map>
 
 namespace vl
@@ -60,7 +64,9 @@ namespace vl
 
     /** Used by render() to loop through the render queue.
       * Does not activate the framebuffer, does not activate the viewport, does not clear the viewport, does not
-      * setup the override states, does not issue the OnRendererStarted/Finished callbacks. */
+      * setup the override states, does not issue the OnRendererStarted/Finished callbacks.
+      * Replays the CommandList[s] submitted with submitCommandList() before rendering: their commands are executed first,
+      * then \p in_render_queue is rendered followed by the RenderQueue[s] recorded in the CommandList[s]. */
     const RenderQueue* renderRaw(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
 
     void setProjViewTransfCallback(ProjViewTransfCallback* callback) { mProjViewTransfCallback = callback; }
@@ -92,6 +98,19 @@ namespace vl
     bool isEnabled(unsigned int mask) { return (mask & mEnableMask) != 0; }
     bool isEnabled(const Actor* actor) { return actor->isEnabled() && (actor->enableMask() & mEnableMask) != 0; }
 
+    /** Submits a CommandList recorded by a worker thread, replayed and released by the next renderRaw().
+      * CommandList[s] are replayed in submission order. This function can be called by any thread
+      * as long as a mutex has been installed with setCommandListMutex(). */
+    void submitCommandList(CommandList* command_list);
+
+    /** The mutex protecting the submitted CommandList[s], required if submitCommandList() is called by threads
+      * other than the one rendering. See also vl::IMutex. */
+    void setCommandListMutex(IMutex* mutex) { mCommandListMutex = mutex; }
+
+    /** The mutex protecting the submitted CommandList[s], required if submitCommandList() is called by threads
+      * other than the one rendering. See also vl::IMutex. */
+    IMutex* commandListMutex() { return mCommandListMutex; }
+
     /** The Framebuffer on which the rendering is performed. */
     void setFramebuffer(Framebuffer* framebuffer) { mFramebuffer = framebuffer; }
 
@@ -101,8 +120,32 @@ namespace vl
     /** The Framebuffer on which the rendering is performed. */
     Framebuffer* framebuffer() { return mFramebuffer.get(); }
 
+    /** The buffers (a combination of EBufferBits) whose previous contents are not needed by this renderer, invalidated with
+      * Framebuffer::invalidate() when the rendering starts so that tile-based GPUs do not load them into the tile memory.
+      * If every buffer cleared by the viewport is listed here the clear is extended to the whole framebuffer, as full clears
+      * are recognized by the drivers as a load-free pass start, and such buffers are not invalidated. Defaults to 0. */
+    void setInvalidateOnStart(int buffer_mask) { mInvalidateOnStart = buffer_mask; }
+
+    /** The buffers invalidated when the rendering starts, see setInvalidateOnStart(). */
+    int invalidateOnStart() const { return mInvalidateOnStart; }
+
+    /** The buffers (a combination of EBufferBits) whose contents are not needed after this renderer, typically the depth and
+      * stencil buffers of the last pass rendering to a Framebuffer, invalidated with Framebuffer::invalidate() when the rendering
+      * finishes so that tile-based GPUs do not store them back to memory. Defaults to 0. */
+    void setInvalidateOnFinish(int buffer_mask) { mInvalidateOnFinish = buffer_mask; }
+
+    /** The buffers invalidated when the rendering finishes, see setInvalidateOnFinish(). */
+    int invalidateOnFinish() const { return mInvalidateOnFinish; }
+
+    /** The FrameProfiler used to time the Effect[s] if FrameProfiler::effectScopes() is enabled, see also Rendering::setProfiler(). */
+    void setProfiler(FrameProfiler* profiler) { mProfiler = profiler; }
+
+    /** The FrameProfiler used to time the Effect[s] if FrameProfiler::effectScopes() is enabled, see also Rendering::setProfiler(). */
+    FrameProfiler* profiler() { return mProfiler.get(); }
+
   protected:
     ref<Framebuffer> mFramebuffer;
+    ref<FrameProfiler> mProfiler;
 
     // used to reset the OpenGL states & enables at the end of the rendering.
     vl::ref<EnableSet> mDummyEnables;
@@ -111,8 +154,26 @@ namespace vl
     std::map<unsigned int, ref<Shader> > mShaderOverrideMask;
 
     std::vector<RenderStateSlot> mOverriddenDefaultRenderStates;
+    // render(): the default render states replaced by mOverriddenDefaultRenderStates, restored at the end of the rendering
+    std::vector<RenderStateSlot> mOriginalDefaultRenderStates;
 
     ref<ProjViewTransfCallback> mProjViewTransfCallback;
+
+    // submitted command lists, protected by mCommandListMutex
+    std::vector< ref<CommandList> > mSubmittedCommandLists;
+    IMutex* mCommandListMutex;
+
+    int mInvalidateOnStart;
+    int mInvalidateOnFinish;
+
+  private:
+    // renderRaw(): state of the fixed function pipeline (ie. the NULL GLSLProgram) and list of the GLSLPrograms
+    // whose GLSLProgram::RendererState has been claimed during the current rendering.
+    GLSLProgram::RendererState mFixedFunctionState;
+    std::vector<const GLSLProgram*> mClaimedGLSLPrograms;
+    // renderRaw(): the command lists being replayed and the render queues to be rendered
+    std::vector< ref<CommandList> > mReplayedCommandLists;
+    std::vector<const RenderQueue*> mRenderQueues;
   };
   //------------------------------------------------------------------------------
 }
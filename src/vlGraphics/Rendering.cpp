@@ -37,16 +37,116 @@
 #include <vlGraphics/GLSL.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef VL_PIPELINED_RENDERING
+  #include <thread>
+  #include <mutex>
+  #include <condition_variable>
+#endif
 
 using namespace vl;
 
+#ifdef VL_PIPELINED_RENDERING
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // RenderingWorker
+  //------------------------------------------------------------------------------
+  // The thread preparing the next frame of a pipelined Rendering, see Rendering::setPipelined().
+  class RenderingWorker
+  {
+  public:
+    RenderingWorker(Rendering* rendering): mRendering(rendering), mPending(false), mQuit(false)
+    {
+      mThread = std::thread(&RenderingWorker::run, this);
+    }
+
+    ~RenderingWorker()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQuit = true;
+      }
+      mWake.notify_one();
+      mThread.join();
+    }
+
+    //! Starts preparing the next frame.
+    void start()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending = true;
+      }
+      mWake.notify_one();
+    }
+
+    //! Waits until the next frame has been prepared.
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      while( mPending )
+        mDone.wait(lock);
+    }
+
+  protected:
+    void run()
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      for(;;)
+      {
+        while( !mPending && !mQuit )
+          mWake.wait(lock);
+        if ( !mPending )
+          return;
+
+        lock.unlock();
+        mRendering->preparePipelinedFrame();
+        lock.lock();
+
+        mPending = false;
+        mDone.notify_all();
+      }
+    }
+
+  protected:
+    Rendering* mRendering;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    bool mPending;
+    bool mQuit;
+  };
+}
+#endif
+
 //------------------------------------------------------------------------------
 Rendering::Rendering():
   mAutomaticResourceInit(true),
   mCullingEnabled(true),
   mEvaluateLOD(true),
   mShaderAnimationEnabled(true),
-  mNearFarClippingPlanesOptimized(false)
+  mIncrementalTransformUpdate(false),
+  mNearFarClippingPlanesOptimized(false),
+  mCoherentRenderQueue(false),
+  mThreadCount(1),
+  mStatsBoundsUpdates(0),
+  mBoundsEpoch(0),
+  mLODCacheEnabled(false),
+  mLODCameraValid(false),
+  mLODCameraThreshold(0),
+  mLODRefreshFraction(0),
+  mLODRefreshFrame(0),
+  mStatsLODEvaluations(0),
+  mPipelined(false),
+  mPipelineReady(false),
+  mPrepared(false),
+  mResourceMutex(NULL),
+  mWorker(NULL)
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mRenderQueueSorter  = new RenderQueueSorterStandard;
@@ -56,6 +156,18 @@ Rendering::Rendering():
   mCamera             = new Camera;
   mTransform          = new Transform;
   mRenderers.push_back( new Renderer );
+  mPipelineActors     = new ActorCollection;
+  mPipelineQueue      = new RenderQueue;
+  mPipelineCamera     = new Camera;
+  mPipelineViewport   = new Viewport;
+  mRenderCamera       = new Camera;
+}
+//------------------------------------------------------------------------------
+Rendering::~Rendering()
+{
+#ifdef VL_PIPELINED_RENDERING
+  delete mWorker;
+#endif
 }
 //------------------------------------------------------------------------------
 Rendering& Rendering::operator=(const Rendering& other)
@@ -67,7 +179,14 @@ Rendering& Rendering::operator=(const Rendering& other)
   mCullingEnabled    = other.mCullingEnabled;
   mEvaluateLOD              = other.mEvaluateLOD;
   mShaderAnimationEnabled   = other.mShaderAnimationEnabled;
+  mIncrementalTransformUpdate = other.mIncrementalTransformUpdate;
   mNearFarClippingPlanesOptimized = other.mNearFarClippingPlanesOptimized;
+  mCoherentRenderQueue      = other.mCoherentRenderQueue;
+  mThreadCount              = other.mThreadCount;
+  mLODCacheEnabled          = other.mLODCacheEnabled;
+  mLODCameraThreshold       = other.mLODCameraThreshold;
+  mLODRefreshFraction       = other.mLODRefreshFraction;
+  mLODCameraValid           = false;
 
   mRenderQueueSorter   = other.mRenderQueueSorter;
   /*mActorQueue        = other.mActorQueue;*/
@@ -76,6 +195,14 @@ Rendering& Rendering::operator=(const Rendering& other)
   mRenderers           = other.mRenderers;
   mCamera              = other.mCamera;
   mTransform           = other.mTransform;
+  mTextureStreamer     = other.mTextureStreamer;
+  mProfiler            = other.mProfiler;
+  mDynamicResolution   = other.mDynamicResolution;
+  mPostAntialiasing    = other.mPostAntialiasing;
+  mDepthPrePass        = other.mDepthPrePass;
+  mClusteredLightManager = other.mClusteredLightManager;
+  mCascadedShadowMap   = other.mCascadedShadowMap;
+  mResourceMutex       = other.mResourceMutex;
 
   return *this;
 }
@@ -90,6 +217,10 @@ void Rendering::render()
   if ( enableMask() == 0 )
     return;
 
+  // the queue might have been prepared in advance by a RenderingTree, see prepareFrame()
+  const bool prepared = mPrepared;
+  mPrepared = false;
+
   // enter/exit behavior contract
 
   class InOutContract
@@ -169,83 +300,117 @@ void Rendering::render()
   if (!camera()->viewport())
     return;
 
-  // transform
+  // profiling: if the user did not open a frame this rendering is a frame on its own
 
-  if (transform() != NULL)
-    transform()->computeWorldMatrixRecursive( camera() );
+  FrameProfiler* profiler = mProfiler.get();
+  const bool profiler_frame = profiler && !profiler->isFrameOpen();
+  if (profiler_frame)
+    profiler->beginFrame();
+  if (profiler)
+    profiler->beginScope("Rendering::render");
 
-  // camera transform update (can be redundant)
+  // transform and camera update
 
-  if (camera()->boundTransform())
-    camera()->setModelingMatrix( camera()->boundTransform()->worldMatrix() );
+  if ( ! prepared )
+    updateTransforms();
 
   VL_CHECK_OGL()
 
-  // culling & actor queue filling
+  // culling, render queue filling and sorting
 
-  camera()->computeFrustumPlanes();
+  // the resources shared with Rendering[s] submitting from other threads are initialized one thread at a time
+  if (mResourceMutex)
+    mResourceMutex->lock();
 
-  // if near/far clipping planes optimization is enabled don't perform far-culling
-  if (nearFarClippingPlanesOptimized())
+  Camera* render_camera = camera();
+  if ( pipelined() )
   {
-    // perform only near culling with plane at distance 0
-    camera()->frustum().planes().resize(5);
-    camera()->frustum().planes()[4] = Plane( camera()->modelingMatrix().getT(),
-                                             camera()->modelingMatrix().getZ());
-  }
-
-  actorQueue()->clear();
-  for(int i = 0; i < sceneManagers()->size(); ++i )
-  {
-    if ( isEnabled( sceneManagers()->at(i)->enableMask() ) )
+    // first frame: the queue is prepared synchronously
+    if ( ! mPipelineReady )
     {
-      if ( cullingEnabled() && sceneManagers()->at(i)->cullingEnabled() )
-      {
-        if ( sceneManagers()->at(i)->boundsDirty() ) {
-          sceneManagers()->at(i)->computeBounds();
-        }
-
-        // try to cull the scene with both bsphere and bbox
-        if ( camera()->frustum().cull( sceneManagers()->at(i)->boundingSphere() ) ||
-             camera()->frustum().cull( sceneManagers()->at(i)->boundingBox() ) ) {
-          continue;
-        } else {
-          sceneManagers()->at(i)->extractVisibleActors( *actorQueue(), camera() );
-        }
-      }
-      else {
-        sceneManagers()->at(i)->extractVisibleActors( *actorQueue(), NULL );
-      }
+      FrameProfiler::ScopedProfile scope(profiler, "pipeline fill");
+      takeCameraSnapshot();
+      preparePipelinedFrame();
+      mPipelineReady = true;
     }
+
+    // the queue prepared during the previous frame is rendered now, the worker will refill the other one
+    ref<ActorCollection> actors = mActorQueue;
+    mActorQueue = mPipelineActors;
+    mPipelineActors = actors;
+    ref<RenderQueue> queue = mRenderQueue;
+    mRenderQueue = mPipelineQueue;
+    mPipelineQueue = queue;
+    ref<Camera> cam = mRenderCamera;
+    mRenderCamera = mPipelineCamera;
+    mPipelineCamera = cam;
+    mKeepAlive.swap( mPipelineKeepAlive );
+
+    // the queue is rendered with the camera it was culled with, in the current viewport
+    render_camera = mRenderCamera.get();
+    render_camera->setViewport( camera()->viewport() );
+    takeCameraSnapshot();
+
+    initRenderQueueShaders( render_camera, profiler );
   }
+  else
+  if ( prepared )
+    initRenderQueueShaders( render_camera, profiler );
+  else
+    cullAndSort( camera(), actorQueue(), renderQueue(), true, profiler );
 
-  // collect near/far clipping planes optimization information
-  if (nearFarClippingPlanesOptimized())
-  {
-    Sphere world_bounding_sphere;
-    for(int i=0; i<actorQueue()->size(); ++i)
-      world_bounding_sphere += actorQueue()->at(i)->boundingSphere();
+  // asynchronous texture uploads
 
-    // compute the optimized
-    camera()->computeNearFarOptimizedProjMatrix(world_bounding_sphere);
+  if (textureStreamer())
+    textureStreamer()->update();
 
-    // recompute frustum planes to account for new near/far values
-    camera()->computeFrustumPlanes();
-  }
+  if (mResourceMutex)
+    mResourceMutex->unlock();
 
-  // render queue filling
+  // shadow maps: rendered before the scene into their own framebuffers
 
-  renderQueue()->clear();
-  fillRenderQueue( actorQueue() );
+  if (mCascadedShadowMap && mCascadedShadowMap->isEnabled() && renderers()[0] && renderers()[0]->framebuffer())
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "cascaded shadow map", true);
+    mCascadedShadowMap->render( sceneManagers(), render_camera, renderers()[0]->framebuffer()->openglContext(), frameClock() );
+  }
 
-  // sort the rendering queue according to this renderer sorting algorithm
+  // pipelined mode: the worker prepares the next frame while the current one is submitted
 
-  if (renderQueueSorter())
-    renderQueue()->sort( renderQueueSorter(), camera() );
+  if ( pipelined() && mWorker )
+    mWorker->start();
 
   // --- RENDER THE QUEUE: loop through the renderers, feeding the output of one as input for the next ---
 
+  DynamicResolution* dynamic_resolution = mDynamicResolution.get();
+  if (dynamic_resolution)
+    dynamic_resolution->beginScene(this);
+
+  // nested in the dynamic resolution so that the filter runs before the upscale
+  PostAntialiasing* post_antialiasing = mPostAntialiasing.get();
+  if (post_antialiasing)
+    post_antialiasing->beginScene(this);
+
+  // light clusters: after beginScene() since the viewport might have been scaled
+  if (mClusteredLightManager && mClusteredLightManager->isEnabled())
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "clustered lights");
+    mClusteredLightManager->update( render_camera );
+  }
+
   const RenderQueue* render_queue = renderQueue();
+
+  // depth pre-pass: clears in place of the first renderer
+  DepthPrePass* depth_pre_pass = mDepthPrePass && mDepthPrePass->isEnabled() && renderers()[0] ? mDepthPrePass.get() : NULL;
+  EClearFlags clear_flags = CF_DO_NOT_CLEAR;
+  if (depth_pre_pass)
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "depth pre-pass", true);
+    render_queue = depth_pre_pass->render( render_queue, renderers()[0].get(), render_camera, frameClock() );
+    clear_flags = renderers()[0]->clearFlags();
+    renderers()[0]->setClearFlags(CF_DO_NOT_CLEAR);
+  }
+
   for(int i=0; i<renderers().size(); ++i)
   {
     if (renderers()[i])
@@ -265,43 +430,333 @@ void Rendering::render()
       }
 
       // loop the rendering
-      render_queue = renderers()[i]->render( render_queue, camera(), frameClock() );
+      if (profiler)
+      {
+        renderers()[i]->setProfiler(profiler);
+        profiler->beginScope( ("Renderer #" + String::fromInt(i)).toStdString().c_str(), true );
+      }
+      render_queue = renderers()[i]->render( render_queue, render_camera, frameClock() );
+      if (profiler)
+        profiler->endScope();
     }
   }
 
+  if (depth_pre_pass)
+    renderers()[0]->setClearFlags(clear_flags);
+
+  if (post_antialiasing)
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "antialiasing", true);
+    post_antialiasing->endScene(this);
+  }
+
+  if (dynamic_resolution)
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "upscale", true);
+    dynamic_resolution->endScene(this);
+  }
+
+  if ( pipelined() )
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "pipeline wait");
+    if ( mWorker )
+      mWorker->wait();
+    else
+      preparePipelinedFrame();
+    // the Shaders and Renderables of the rendered queue can be released
+    mKeepAlive.clear();
+  }
+
+  if (profiler)
+    profiler->endScope();
+  if (profiler_frame)
+    profiler->endFrame();
+
   VL_CHECK_OGL()
 }
 //------------------------------------------------------------------------------
-void Rendering::fillRenderQueue( ActorCollection* actor_list )
+void Rendering::cullAndSort( Camera* camera, ActorCollection* actors, RenderQueue* render_queue, bool init_resources, FrameProfiler* profiler )
 {
-  if (actor_list == NULL)
-    return;
+  // culling & actor queue filling
 
-  if (actor_list->empty())
-    return;
+  if (profiler)
+    profiler->beginScope("cull");
 
-  if (camera() == NULL)
-    return;
+  camera->computeFrustumPlanes();
 
-  if (enableMask() == 0)
+  // if near/far clipping planes optimization is enabled don't perform far-culling
+  if (nearFarClippingPlanesOptimized())
+  {
+    // perform only near culling with plane at distance 0
+    camera->frustum().planes().resize(5);
+    camera->frustum().planes()[4] = Plane( camera->modelingMatrix().getT(),
+                                           camera->modelingMatrix().getZ());
+  }
+
+  actors->clear();
+  const int scene_manager_count = sceneManagers()->size();
+#ifdef _OPENMP
+  if ( threadCount() > 1 && scene_manager_count > 1 )
+  {
+    // each SceneManager is culled in its own list, the lists are then merged in order.
+    mSceneManagerActors.resize( scene_manager_count );
+    for(int i = 0; i < scene_manager_count; ++i )
+    {
+      if ( !mSceneManagerActors[i] )
+        mSceneManagerActors[i] = new ActorCollection;
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount)
+    for(int i = 0; i < scene_manager_count; ++i )
+      extractVisibleActors( sceneManagers()->at(i), *mSceneManagerActors[i], camera );
+
+    for(int i = 0; i < scene_manager_count; ++i )
+    {
+      actors->push_back( *mSceneManagerActors[i] );
+      mSceneManagerActors[i]->clear();
+    }
+  }
+  else
+#endif
+  {
+    for(int i = 0; i < scene_manager_count; ++i )
+      extractVisibleActors( sceneManagers()->at(i), *actors, camera );
+  }
+
+  // collect near/far clipping planes optimization information
+  if (nearFarClippingPlanesOptimized())
+  {
+    Sphere world_bounding_sphere;
+    for(int i=0; i<actors->size(); ++i)
+      world_bounding_sphere += actors->at(i)->boundingSphere();
+
+    // compute the optimized
+    camera->computeNearFarOptimizedProjMatrix(world_bounding_sphere);
+
+    // recompute frustum planes to account for new near/far values
+    camera->computeFrustumPlanes();
+  }
+
+  if (profiler)
+    profiler->endScope();
+
+  // render queue filling
+
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "fillRenderQueue");
+    render_queue->clear();
+    fillRenderQueue( actors, render_queue, camera, init_resources );
+  }
+
+  // sort the rendering queue according to this renderer sorting algorithm
+
+  if (renderQueueSorter())
+  {
+    FrameProfiler::ScopedProfile scope(profiler, "sort");
+    if (coherentRenderQueue())
+      render_queue->sortCoherent( renderQueueSorter(), camera );
+    else
+      render_queue->sort( renderQueueSorter(), camera );
+  }
+}
+//------------------------------------------------------------------------------
+void Rendering::updateTransforms()
+{
+  // the bounds recomputed from now on are counted by statsBoundsUpdates()
+  mBoundsEpoch = Actor::nextBoundsEpoch();
+
+  // transform
+
+  if (transform() != NULL)
+  {
+    if ( incrementalTransformUpdate() )
+      transform()->computeDirtyWorldMatrices( camera() );
+    else
+      transform()->computeWorldMatrixRecursive( camera() );
+  }
+
+  // camera transform update (can be redundant)
+
+  if (camera()->boundTransform())
+    camera()->setModelingMatrix( camera()->boundTransform()->worldMatrix() );
+}
+//------------------------------------------------------------------------------
+void Rendering::updateBounds()
+{
+  ActorCollection actors;
+  for(int i=0; i<sceneManagers()->size(); ++i)
+  {
+    SceneManager* scene_manager = sceneManagers()->at(i);
+    if ( ! isEnabled( scene_manager->enableMask() ) )
+      continue;
+
+    if ( scene_manager->boundsDirty() )
+      scene_manager->computeBounds();
+
+    actors.clear();
+    scene_manager->extractActors( actors );
+    for(int j=0; j<actors.size(); ++j)
+      actors.at(j)->computeBounds();
+  }
+}
+//------------------------------------------------------------------------------
+bool Rendering::canPrepareFrame() const
+{
+  return enableMask() != 0 && ! pipelined() && ! sceneManagers()->empty() && camera() && camera()->viewport();
+}
+//------------------------------------------------------------------------------
+void Rendering::prepareFrame()
+{
+  cullAndSort( camera(), actorQueue(), renderQueue(), false, NULL );
+  mPrepared = true;
+}
+//------------------------------------------------------------------------------
+void Rendering::initRenderQueueShaders( Camera* camera, FrameProfiler* profiler )
+{
+  FrameProfiler::ScopedProfile scope(profiler, "initResources");
+  for(int i=0; i<renderQueue()->size(); ++i)
+    for(const RenderToken* tok = renderQueue()->at(i); tok; tok = tok->mNextPass)
+      mInitShaders.push_back( std::make_pair( const_cast<Shader*>(tok->mShader), (int)mInitShaders.size() ) );
+  initCollectedShaders( camera );
+}
+//------------------------------------------------------------------------------
+void Rendering::takeCameraSnapshot()
+{
+  // the worker culls with its own copy of the camera and of its viewport
+  *mPipelineViewport = *camera()->viewport();
+  *mPipelineCamera = *camera();
+  mPipelineCamera->setViewport( mPipelineViewport.get() );
+}
+//------------------------------------------------------------------------------
+void Rendering::preparePipelinedFrame()
+{
+  cullAndSort( mPipelineCamera.get(), mPipelineActors.get(), mPipelineQueue.get(), false, NULL );
+
+  // the Actors are kept alive by mPipelineActors, the Shaders and Renderables by mPipelineKeepAlive until they are rendered
+  mPipelineKeepAlive.clear();
+  for(int i=0; i<mPipelineQueue->size(); ++i)
+  {
+    for(const RenderToken* tok = mPipelineQueue->at(i); tok; tok = tok->mNextPass)
+    {
+      mPipelineKeepAlive.push_back( tok->mShader );
+      mPipelineKeepAlive.push_back( tok->mRenderable );
+    }
+  }
+}
+//------------------------------------------------------------------------------
+void Rendering::setPipelined(bool pipelined)
+{
+  if (pipelined == mPipelined)
     return;
 
-  RenderQueue* list = renderQueue();
-  std::set<Shader*> shader_set;
+  mPipelined = pipelined;
+  resetPipeline();
 
-  // iterate actor list
+#ifdef VL_PIPELINED_RENDERING
+  if (pipelined)
+    mWorker = new RenderingWorker(this);
+  else
+  {
+    delete mWorker;
+    mWorker = NULL;
+  }
+#endif
+}
+//------------------------------------------------------------------------------
+void Rendering::resetPipeline()
+{
+  mPipelineReady = false;
+  mPipelineActors->clear();
+  mPipelineQueue->clear();
+  mPipelineKeepAlive.clear();
+}
+//------------------------------------------------------------------------------
+void Rendering::extractVisibleActors( SceneManager* scene_manager, ActorCollection& actors, Camera* camera )
+{
+  if ( isEnabled( scene_manager->enableMask() ) )
+  {
+    if ( cullingEnabled() && scene_manager->cullingEnabled() )
+    {
+      if ( scene_manager->boundsDirty() ) {
+        scene_manager->computeBounds();
+      }
 
-  for(int iactor=0; iactor < actor_list->size(); iactor++)
+      // try to cull the scene with both bsphere and bbox
+      if ( camera->frustum().cull( scene_manager->boundingSphere() ) ||
+           camera->frustum().cull( scene_manager->boundingBox() ) ) {
+        return;
+      } else {
+        scene_manager->extractVisibleActors( actors, camera );
+      }
+    }
+    else {
+      scene_manager->extractVisibleActors( actors, NULL );
+    }
+  }
+}
+//------------------------------------------------------------------------------
+bool Rendering::lodCameraChanged( const Camera* camera )
+{
+  vec3 position = camera->modelingMatrix().getT();
+  const Viewport* viewport = camera->viewport();
+  int vp[] = { viewport ? viewport->x() : 0, viewport ? viewport->y() : 0, viewport ? viewport->width() : 0, viewport ? viewport->height() : 0 };
+
+  bool changed = ! mLODCameraValid ||
+                 ( position - mLODCameraPosition ).lengthSquared() > mLODCameraThreshold * mLODCameraThreshold ||
+                 camera->projectionMatrix() != mLODProjection ||
+                 memcmp( vp, mLODViewport, sizeof(vp) ) != 0;
+
+  if ( changed )
+  {
+    mLODCameraValid = true;
+    mLODCameraPosition = position;
+    mLODProjection = camera->projectionMatrix();
+    memcpy( mLODViewport, vp, sizeof(vp) );
+  }
+
+  return changed;
+}
+//------------------------------------------------------------------------------
+void Rendering::prepareActors( ActorCollection* actor_list, Camera* camera )
+{
+  const int actor_count = actor_list->size();
+  mPreparedActors.resize( actor_count );
+
+  // with the LOD cache the LODs are evaluated for all the Actor[s] only when the camera changed, otherwise only for the
+  // Actor[s] without valid cached LODs and for those whose turn it is to be refreshed.
+  // the Actor[s] might be shared with the Rendering[s] of other contexts rendered concurrently, see MultiContextRendering
+  const OpenGLContext* context = !renderers().empty() && renderers()[0] && renderers()[0]->framebuffer() ? renderers()[0]->framebuffer()->openglContext() : NULL;
+  const bool lod_cache = mLODCacheEnabled && ! ( context && context->concurrentRendering() );
+  const bool evaluate_all = ! lod_cache || lodCameraChanged( camera );
+  unsigned int refresh_period = 0, refresh_slot = 0;
+  if ( lod_cache && mLODRefreshFraction > 0 )
+  {
+    refresh_period = mLODRefreshFraction >= 1 ? 1 : (unsigned int)ceil( 1.0f / mLODRefreshFraction );
+    refresh_slot = mLODRefreshFrame++ % refresh_period;
+  }
+  int lod_evaluations = 0;
+  int bounds_updates = 0;
+  const long long bounds_epoch = mBoundsEpoch;
+
+  // this loop touches no OpenGL state and only per-Actor data: it can be run in parallel.
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(mThreadCount) if(mThreadCount > 1) reduction(+:lod_evaluations,bounds_updates)
+#endif
+  for(int iactor=0; iactor < actor_count; iactor++)
   {
     Actor* actor = actor_list->at(iactor);
+    PreparedActor& prep = mPreparedActors[iactor];
+    prep.mEffect = NULL;
 
     VL_CHECK(actor->lod(0))
 
     if ( ! isEnabled(actor) )
       continue;
 
-    // update the Actor's bounds
+    // update the Actor's bounds, which might have been already updated by the culling
     actor->computeBounds();
+    if ( actor->boundsUpdateEpoch() >= bounds_epoch )
+      ++bounds_updates;
 
     Effect* effect = actor->effect();
     VL_CHECK(effect)
@@ -324,11 +779,57 @@ void Rendering::fillRenderQueue( ActorCollection* actor_list )
 
     // --------------- LOD evaluation ---------------
 
-    int effect_lod = effect->evaluateLOD( actor, camera() );
+    prep.mEffect = effect;
+
+    // the round-robin slot depends on the Actor's address so that it does not change with the visible set
+    bool refresh = evaluate_all || ( refresh_period && ( (unsigned int)((size_t)actor >> 4) % refresh_period ) == refresh_slot );
+    if ( refresh || ! actor->cachedLODs( this, effect, prep.mEffectLOD, prep.mGeometryLOD ) )
+    {
+      prep.mEffectLOD = effect->evaluateLOD( actor, camera );
+      prep.mGeometryLOD = evaluateLOD() ? actor->evaluateLOD( camera ) : 0;
+      ++lod_evaluations;
+      if ( lod_cache )
+        actor->setCachedLODs( this, effect, prep.mEffectLOD, prep.mGeometryLOD );
+    }
+    else
+    if ( ! evaluateLOD() )
+      prep.mGeometryLOD = 0;
+  }
+
+  mStatsLODEvaluations = lod_evaluations;
+  mStatsBoundsUpdates = bounds_updates;
+}
+//------------------------------------------------------------------------------
+void Rendering::fillRenderQueue( ActorCollection* actor_list, RenderQueue* list, Camera* camera, bool init_resources )
+{
+  if (actor_list == NULL)
+    return;
+
+  if (actor_list->empty())
+    return;
+
+  if (camera == NULL)
+    return;
 
-    int geometry_lod = 0;
-    if ( evaluateLOD() )
-      geometry_lod = actor->evaluateLOD( camera() );
+  if (enableMask() == 0)
+    return;
+
+  // bounds, effect override and LOD evaluation
+
+  prepareActors( actor_list, camera );
+
+  // iterate actor list
+
+  for(int iactor=0; iactor < actor_list->size(); iactor++)
+  {
+    Actor* actor = actor_list->at(iactor);
+    Effect* effect = mPreparedActors[iactor].mEffect;
+
+    if ( ! effect )
+      continue;
+
+    int effect_lod = mPreparedActors[iactor].mEffectLOD;
+    int geometry_lod = mPreparedActors[iactor].mGeometryLOD;
 
     // --------------- M U L T I   P A S S I N G ---------------
 
@@ -356,57 +857,92 @@ void Rendering::fillRenderQueue( ActorCollection* actor_list )
       // set the shader used (multipassing shader or effect->shader())
       tok->mShader = shader;
 
-      if ( shaderAnimationEnabled() )
+      if ( init_resources )
+        mInitShaders.push_back( std::make_pair( shader, (int)mInitShaders.size() ) );
+
+      tok->mEffectRenderRank = effect->renderRank();
+    }
+  }
+
+  if ( init_resources )
+    initCollectedShaders( camera );
+}
+//------------------------------------------------------------------------------
+namespace
+{
+  bool lessShaderOrder( const std::pair<Shader*, int>& a, const std::pair<Shader*, int>& b ) { return a.second < b.second; }
+  bool equalShader( const std::pair<Shader*, int>& a, const std::pair<Shader*, int>& b ) { return a.first == b.first; }
+}
+//------------------------------------------------------------------------------
+void Rendering::initCollectedShaders( Camera* camera )
+{
+  // remove the duplicates keeping the first occurrence, then restore the render queue order.
+  // Sorting a vector reused across frames instead of filling a std::set keeps the frames free of allocations.
+  std::sort( mInitShaders.begin(), mInitShaders.end() );
+  mInitShaders.erase( std::unique( mInitShaders.begin(), mInitShaders.end(), equalShader ), mInitShaders.end() );
+  std::sort( mInitShaders.begin(), mInitShaders.end(), lessShaderOrder );
+
+  for( size_t i=0; i<mInitShaders.size(); ++i )
+    initShader( mInitShaders[i].first, camera );
+
+  mInitShaders.clear();
+}
+//------------------------------------------------------------------------------
+void Rendering::initShader( Shader* shader, Camera* camera )
+{
+  if ( shaderAnimationEnabled() )
+  {
+    VL_CHECK(frameClock() >= 0)
+    if( frameClock() >= 0 )
+    {
+      // note that the condition is != as opposed to <
+      if ( shader->lastUpdateTime() != frameClock() && shader->shaderAnimator() && shader->shaderAnimator()->isEnabled() )
       {
-        VL_CHECK(frameClock() >= 0)
-        if( frameClock() >= 0 )
-        {
-          // note that the condition is != as opposed to <
-          if ( shader->lastUpdateTime() != frameClock() && shader->shaderAnimator() && shader->shaderAnimator()->isEnabled() )
-          {
-            // update
-            shader->shaderAnimator()->updateShader( shader, camera(), frameClock() );
+        // update
+        shader->shaderAnimator()->updateShader( shader, camera, frameClock() );
 
-            // note that we update this after
-            shader->setLastUpdateTime( frameClock() );
-          }
-        }
+        // note that we update this after
+        shader->setLastUpdateTime( frameClock() );
       }
+    }
+  }
 
-      if ( automaticResourceInit() && shader_set.find(shader) == shader_set.end() )
-      {
-        shader_set.insert(shader);
+  if ( automaticResourceInit() )
+  {
+    // link GLSLProgram
+    if ( shader->glslProgram() && ! shader->glslProgram()->linked() )
+    {
+      // polls the link if it is running in parallel
+      shader->glslProgram()->linkProgram();
+      // VL_CHECK( shader->glslProgram()->linked() );
 
-        // link GLSLProgram
-        if ( shader->glslProgram() && ! shader->glslProgram()->linked() )
-        {
-          shader->glslProgram()->linkProgram();
-          // VL_CHECK( shader->glslProgram()->linked() );
-        }
+      GLSLProgram* fallback = shader->glslProgram()->fallbackProgram();
+      if ( shader->glslProgram()->linkPending() && fallback && ! fallback->linked() )
+        fallback->linkProgram();
+    }
 
-        // lazy texture creation
-        if ( shader->gocRenderStateSet() )
+    // lazy texture creation
+    if ( shader->getRenderStateSet() )
+    {
+      size_t count = shader->getRenderStateSet()->renderStatesCount();
+      RenderStateSlot* states = shader->getRenderStateSet()->renderStates();
+      for( size_t i=0; i<count; ++i )
+      {
+        if (states[i].mRS->type() == RS_TextureSampler)
         {
-          size_t count = shader->gocRenderStateSet()->renderStatesCount();
-          RenderStateSlot* states = shader->gocRenderStateSet()->renderStates();
-          for( size_t i=0; i<count; ++i )
+          TextureSampler* tex_unit = static_cast<TextureSampler*>( states[i].mRS.get() );
+          VL_CHECK(tex_unit);
+          if (tex_unit)
           {
-            if (states[i].mRS->type() == RS_TextureSampler)
-            {
-              TextureSampler* tex_unit = static_cast<TextureSampler*>( states[i].mRS.get() );
-              VL_CHECK(tex_unit);
-              if (tex_unit)
-              {
-                if (tex_unit->texture() && tex_unit->texture()->setupParams() && ! tex_unit->texture()->handle() ) {
-                  tex_unit->texture()->createTexture();
-                }
-              }
+            if (tex_unit->texture() && tex_unit->texture()->setupParams() && ! tex_unit->texture()->handle() ) {
+              if ( textureStreamer() )
+                textureStreamer()->request( tex_unit );
+              else
+                tex_unit->texture()->createTexture();
             }
           }
         }
       }
-
-      tok->mEffectRenderRank = effect->renderRank();
     }
   }
 }
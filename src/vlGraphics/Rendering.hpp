@@ -40,11 +40,22 @@
 #include <vlGraphics/Framebuffer.hpp>
 #include <vlGraphics/Camera.hpp>
 #include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/TextureStreamer.hpp>
+#include <vlGraphics/FrameProfiler.hpp>
+#include <vlGraphics/DynamicResolution.hpp>
+#include <vlGraphics/PostAntialiasing.hpp>
+#include <vlGraphics/DepthPrePass.hpp>
+#include <vlGraphics/ClusteredLightManager.hpp>
+#include <vlGraphics/CascadedShadowMap.hpp>
 #include <vlCore/Transform.hpp>
 #include <vlCore/Collection.hpp>
+#include <vlCore/IMutex.hpp>
+#include <set>
 
 namespace vl
 {
+  class RenderingWorker;
+
   /** The Rendering class collects all the information to perform the rendering of a scene.
   The Rendering class performs the following steps:
   -# activates the appropriate OpenGLContext
@@ -65,7 +76,11 @@ namespace vl
   - Renderer
   - Actor
   - Effect
-  - Transform */
+  - Transform
+
+  \par Pipelined rendering
+  When pipelined() is enabled the culling, the render queue filling and the sorting of the next frame are performed by a
+  worker thread while the calling thread submits the current frame to OpenGL, see setPipelined(). */
   class VLGRAPHICS_EXPORT Rendering: public RenderingAbstract
   {
     VL_INSTRUMENT_CLASS(vl::Rendering, RenderingAbstract)
@@ -75,7 +90,10 @@ namespace vl
     Rendering();
 
     /** Copy constructor. */
-    Rendering(const Rendering& other): RenderingAbstract(other) { *this = other; }
+    Rendering(const Rendering& other): RenderingAbstract(other), mPipelined(false), mPipelineReady(false), mPrepared(false), mWorker(NULL) { *this = other; }
+
+    /** Destructor. */
+    ~Rendering();
 
     /** Assignment operator. */
     Rendering& operator=(const Rendering& other);
@@ -151,12 +169,51 @@ namespace vl
       * about how and when using it see the documentation of Transform. */
     Transform* transform() { return mTransform.get(); }
 
+    /** If true the transform() hierarchy is updated using Transform::computeDirtyWorldMatrices() instead of Transform::computeWorldMatrixRecursive(),
+      * recomputing only the world matrices of the subtrees whose local matrices changed since the last frame (default is false).
+      * \note World matrices set directly with Transform::setWorldMatrix() are not propagated to the children of the Transform. */
+    void setIncrementalTransformUpdate(bool incremental) { mIncrementalTransformUpdate = incremental; }
+
+    /** If true the transform() hierarchy is updated using Transform::computeDirtyWorldMatrices() instead of Transform::computeWorldMatrixRecursive(). */
+    bool incrementalTransformUpdate() const { return mIncrementalTransformUpdate; }
+
+    /** The number of Actor[s] rendered by the last render() whose bounds were recomputed by Actor::computeBounds() since the
+      * transforms were updated, whether by the culling or by this Rendering. Static Actors should not contribute to it. */
+    int statsBoundsUpdates() const { return mStatsBoundsUpdates; }
+
     /** Whether the Level-Of-Detail should be evaluated or not. When disabled lod #0 is used. */
     void setEvaluateLOD(bool evaluate_lod) { mEvaluateLOD = evaluate_lod; }
 
     /** Whether the Level-Of-Detail should be evaluated or not. When disabled lod #0 is used. */
     bool evaluateLOD() const { return mEvaluateLOD; }
 
+    /** If enabled the Effect and geometry LODs of each Actor are cached on the Actor and evaluated again only when the camera moves
+      * farther than lodCameraThreshold() from where the LODs were last evaluated, the projection or the viewport change, the Actor
+      * moves, its Effect changes or it is due for a periodic refresh, see setLODRefreshFraction(). Disabled by default.
+      * \note The LODs are not evaluated again when only the LODEvaluator parameters change, see Actor::invalidateLODCache().
+      * \note The cache is not used while the Rendering is rendered concurrently with others by a MultiContextRendering, since
+      * the Actor[s] can be shared. */
+    void setLODCacheEnabled(bool enabled) { mLODCacheEnabled = enabled; mLODCameraValid = false; }
+
+    /** Whether the LODs are cached on the Actor[s], see setLODCacheEnabled(). */
+    bool lodCacheEnabled() const { return mLODCacheEnabled; }
+
+    /** The distance the camera must move for all the cached LODs to be evaluated again (default = 0, any movement). */
+    void setLODCameraThreshold(real distance) { mLODCameraThreshold = distance; }
+
+    /** The distance the camera must move for all the cached LODs to be evaluated again, see setLODCacheEnabled(). */
+    real lodCameraThreshold() const { return mLODCameraThreshold; }
+
+    /** The fraction of the visible Actor[s] whose cached LODs are evaluated again at every frame in round-robin even if nothing moved,
+      * for example 0.1 refreshes every Actor once every 10 frames (default = 0, no periodic refresh). */
+    void setLODRefreshFraction(float fraction) { mLODRefreshFraction = fraction; }
+
+    /** The fraction of the visible Actor[s] whose cached LODs are evaluated again at every frame, see setLODCacheEnabled(). */
+    float lodRefreshFraction() const { return mLODRefreshFraction; }
+
+    /** The number of Actor LODs evaluated during the last render(), equal to the number of visible Actor[s] when setLODCacheEnabled() is false. */
+    int statsLODEvaluations() const { return mStatsLODEvaluations; }
+
     /** Whether Shader::shaderAnimator()->updateShader() should be called or not.
     \note
     Only Shader[s] belonging to visible Actor[s] are animated. */
@@ -181,6 +238,17 @@ namespace vl
     /** Whether OpenGL resources such as textures and GLSL programs should be automatically initialized before the rendering takes place. */
     bool automaticResourceInit() const { return mAutomaticResourceInit; }
 
+    /** If not NULL the textures created by the automatic resource initialization are handed over to the TextureStreamer instead of
+      * being created synchronously, and TextureStreamer::update() is called at every rendering before the Renderer[s] are executed.
+      * See also setAutomaticResourceInit(). */
+    void setTextureStreamer(TextureStreamer* streamer) { mTextureStreamer = streamer; }
+
+    /** If not NULL the textures created by the automatic resource initialization are streamed by the given TextureStreamer, see setTextureStreamer(). */
+    TextureStreamer* textureStreamer() { return mTextureStreamer.get(); }
+
+    /** If not NULL the textures created by the automatic resource initialization are streamed by the given TextureStreamer, see setTextureStreamer(). */
+    const TextureStreamer* textureStreamer() const { return mTextureStreamer.get(); }
+
     /** Returns whether near/far planes optimization is enabled. */
     bool nearFarClippingPlanesOptimized() const { return mNearFarClippingPlanesOptimized; }
 
@@ -202,15 +270,174 @@ namespace vl
         See also vl::Actor::enableMask() and vl::Renderer::shaderOverrideMask(). */
     std::map<unsigned int, ref<Effect> >& effectOverrideMask() { return mEffectOverrideMask; }
 
+    /** Enables/disables the coherent render queue mode. When enabled the RenderQueue remembers the order of the previous
+      * frame and the new frame is sorted starting from it using RenderQueue::sortCoherent(), which is near-linear when the
+      * visible set and the camera change little from frame to frame, for example in static scenes.
+      * The resulting order is the same as when this mode is disabled. Disabled by default. */
+    void setCoherentRenderQueue(bool enabled)
+    {
+      mCoherentRenderQueue = enabled;
+      if (!enabled)
+      {
+        mRenderQueue->resetCoherentOrder();
+        mPipelineQueue->resetCoherentOrder();
+      }
+    }
+
+    /** Whether the coherent render queue mode is enabled, see setCoherentRenderQueue(). */
+    bool coherentRenderQueue() const { return mCoherentRenderQueue; }
+
+    /** The number of threads used to cull the SceneManager[s] and to prepare the Actor[s] (bounds and LOD evaluation)
+      * before the render queue is filled. The OpenGL submission is always performed by the calling thread.
+      * Requires VL to be compiled with OpenMP support (CMake option VL_OPENMP), otherwise the value is ignored. Defaults to 1.
+      * \note When using more than one thread the Actor[s] shared among different SceneManager[s] and the Renderable[s] shared
+      * among different Actor[s] are accessed concurrently: install a reference-count mutex (see Object::setRefCountMutex())
+      * on shared Actor[s] and make sure shared Renderable[s] have up to date bounds (see Renderable::computeBounds()). */
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    /** The number of threads used to cull the SceneManager[s] and to prepare the Actor[s], see setThreadCount(). */
+    int threadCount() const { return mThreadCount; }
+
+    /** If not NULL render() records the CPU time of its culling, render queue filling and sorting and the CPU and GPU time
+      * of each Renderer in the given FrameProfiler, which is also installed on the Renderer[s] (see Renderer::setProfiler()).
+      * If no frame is open in the profiler each call to render() is profiled as a frame on its own. */
+    void setProfiler(FrameProfiler* profiler) { mProfiler = profiler; }
+
+    /** The FrameProfiler used to time this Rendering, see setProfiler(). */
+    FrameProfiler* profiler() { return mProfiler.get(); }
+
+    /** The FrameProfiler used to time this Rendering, see setProfiler(). */
+    const FrameProfiler* profiler() const { return mProfiler.get(); }
+
+    /** If not NULL and enabled the Renderer[s] draw into an offscreen framebuffer at a resolution driven by the GPU frame time,
+      * which is then upscaled into the camera's Viewport. See DynamicResolution. */
+    void setDynamicResolution(DynamicResolution* dynamic_resolution) { mDynamicResolution = dynamic_resolution; }
+
+    /** The DynamicResolution used by this Rendering, see setDynamicResolution(). */
+    DynamicResolution* dynamicResolution() { return mDynamicResolution.get(); }
+
+    /** The DynamicResolution used by this Rendering, see setDynamicResolution(). */
+    const DynamicResolution* dynamicResolution() const { return mDynamicResolution.get(); }
+
+    /** If not NULL and enabled the Renderer[s] draw into a single-sample offscreen framebuffer which is then antialiased
+      * into their Framebuffer by a post-process filter, before the upscale of the DynamicResolution if any. See PostAntialiasing. */
+    void setPostAntialiasing(PostAntialiasing* post_antialiasing) { mPostAntialiasing = post_antialiasing; }
+
+    /** The PostAntialiasing used by this Rendering, see setPostAntialiasing(). */
+    PostAntialiasing* postAntialiasing() { return mPostAntialiasing.get(); }
+
+    /** The PostAntialiasing used by this Rendering, see setPostAntialiasing(). */
+    const PostAntialiasing* postAntialiasing() const { return mPostAntialiasing.get(); }
+
+    /** If not NULL and enabled the depth of the opaque objects is rendered by a depth-only pre-pass before the Renderer[s],
+      * which then shade only the visible fragments. See DepthPrePass. */
+    void setDepthPrePass(DepthPrePass* depth_pre_pass) { mDepthPrePass = depth_pre_pass; }
+
+    /** The DepthPrePass used by this Rendering, see setDepthPrePass(). */
+    DepthPrePass* depthPrePass() { return mDepthPrePass.get(); }
+
+    /** The DepthPrePass used by this Rendering, see setDepthPrePass(). */
+    const DepthPrePass* depthPrePass() const { return mDepthPrePass.get(); }
+
+    /** If not NULL and enabled the lights of the ClusteredLightManager are assigned to the clusters of camera() once per
+      * frame, before the Renderer[s] are executed. See ClusteredLightManager. */
+    void setClusteredLightManager(ClusteredLightManager* manager) { mClusteredLightManager = manager; }
+
+    /** The ClusteredLightManager used by this Rendering, see setClusteredLightManager(). */
+    ClusteredLightManager* clusteredLightManager() { return mClusteredLightManager.get(); }
+
+    /** The ClusteredLightManager used by this Rendering, see setClusteredLightManager(). */
+    const ClusteredLightManager* clusteredLightManager() const { return mClusteredLightManager.get(); }
+
+    /** If not NULL and enabled the CascadedShadowMap is fit to camera() and rendered, using the sceneManagers() to
+      * cull the shadow casters, before the Renderer[s] are executed. See CascadedShadowMap. */
+    void setCascadedShadowMap(CascadedShadowMap* shadow_map) { mCascadedShadowMap = shadow_map; }
+
+    /** The CascadedShadowMap used by this Rendering, see setCascadedShadowMap(). */
+    CascadedShadowMap* cascadedShadowMap() { return mCascadedShadowMap.get(); }
+
+    /** The CascadedShadowMap used by this Rendering, see setCascadedShadowMap(). */
+    const CascadedShadowMap* cascadedShadowMap() const { return mCascadedShadowMap.get(); }
+
+    /** The Actor[s] that passed the culling in the render() in progress, valid while dispatching onFinishedCallbacks(), empty otherwise. */
+    const ActorCollection* visibleActors() const { return mActorQueue.get(); }
+
+    /** Enables the pipelined mode (disabled by default). render() renders the RenderQueue prepared during the previous render()
+      * while a worker thread culls the SceneManager[s], fills and sorts the RenderQueue of the next frame, hiding most of
+      * the CPU cost of the culling and sorting behind the OpenGL submission at the price of one frame of latency:
+      * - The queue of the next frame is prepared using a snapshot of camera() taken at the beginning of render() and the
+      *   world matrices of transform() computed by updateTransforms(), and is rendered by the next render() using that
+      *   snapshot of the camera. The world matrices are not copied: the Transform[s] must not be modified until render() returns.
+      * - The worker runs only within render(): the scene can be freely modified between two render() calls. The Actor[s],
+      *   Shader[s] and Renderable[s] of the prepared queue are kept alive until they are rendered. Changes to the scene
+      *   (new Actor[s], new Effect[s] etc.) become visible with one frame of delay.
+      * - The shader animation and the automatic resource initialization (see setAutomaticResourceInit()) are performed by
+      *   the calling thread just before the queue is rendered.
+      * - While the worker runs the ActorEventCallback[s] and RenderEventCallback[s] of the Renderer[s] are executed concurrently
+      *   with the culling: they must not modify the scene, the bounds of the Actor[s] or the Transform[s]. The reference counts of
+      *   the visible Actor[s] are modified by the worker: install a reference-count mutex (see Object::setRefCountMutex()) on the
+      *   Actor[s] referenced by such callbacks or build VL with VL_ATOMIC_REF_COUNT.
+      * - The CascadedShadowMap, if any, is rendered before the worker is started.
+      *
+      * The first frame after enabling the mode, or after resetPipeline(), is prepared and rendered synchronously.
+      * If VL is built without VL_PIPELINED_RENDERING the next frame is prepared after the submission of the current one,
+      * with the same one frame latency but no overlap. */
+    void setPipelined(bool pipelined);
+
+    /** Whether the pipelined mode is enabled, see setPipelined(). */
+    bool pipelined() const { return mPipelined; }
+
+    /** Discards the RenderQueue prepared for the next frame in pipelined mode, for example after a camera cut, so that the
+      * next render() prepares and renders the frame synchronously. */
+    void resetPipeline();
+
+    /** The mutex locked by render() while the shaders are animated and the resources of the render queue are initialized (see
+      * setAutomaticResourceInit()) and while the texture streamer is updated. Used when Rendering[s] sharing their Effect[s] and
+      * Renderable[s] are rendered concurrently on different OpenGL contexts, see MultiContextRendering. NULL by default. */
+    void setResourceMutex(IMutex* mutex) { mResourceMutex = mutex; }
+
+    /** The mutex locked by render() while the resources of the render queue are initialized, see setResourceMutex(). */
+    IMutex* resourceMutex() const { return mResourceMutex; }
+
   protected:
     // mic fixme: it would be nice to have a mechanism to request the visible actors at will and to
     // compile and save the render-queue for later renderings to be reused without recomputing the culling.
     // The user could be able to install actor-list or render-queue and use the flags READ|WRITE|TERMINATE
     // to define wether the list should be used for reading, filled, cleaned up after rendering.
-    void fillRenderQueue( ActorCollection* actor_list );
+    void fillRenderQueue( ActorCollection* actor_list, RenderQueue* render_queue, Camera* camera, bool init_resources );
+    void extractVisibleActors( SceneManager* scene_manager, ActorCollection& actors, Camera* camera );
+    void prepareActors( ActorCollection* actor_list, Camera* camera );
+    //! Returns true if all the cached LODs must be evaluated again for \p camera, and if so records its position, projection and viewport.
+    bool lodCameraChanged( const Camera* camera );
+    //! Culls the scene managers, fills and sorts the given queue. \p profiler is NULL when running in the pipeline worker.
+    void cullAndSort( Camera* camera, ActorCollection* actors, RenderQueue* render_queue, bool init_resources, FrameProfiler* profiler );
+    //! Shader animation and automatic resource initialization, performed by the rendering thread.
+    void initShader( Shader* shader, Camera* camera );
+    //! Calls initShader() once for each of the Shader[s] collected in mInitShaders, in the order they were collected.
+    void initCollectedShaders( Camera* camera );
+    //! Calls initShader() for all the Shader[s] of the RenderQueue prepared ahead of render().
+    void initRenderQueueShaders( Camera* camera, FrameProfiler* profiler );
+    //! Updates the world matrices of transform() and the modeling matrix of camera().
+    void updateTransforms();
+    //! Updates the bounds of the scene managers and of all their Actor[s], so that culling and rendering only read them.
+    //! Used by MultiContextRendering before its render threads share the scene.
+    void updateBounds();
+    //! Whether prepareFrame() can be used for the next render(): the Rendering is enabled, not pipelined and has a camera and a scene.
+    bool canPrepareFrame() const;
+    //! Culls, fills and sorts the queue of the next render() ahead of time, see RenderingTree::setThreadCount(). Can be called
+    //! from a thread other than the rendering one, after updateTransforms().
+    void prepareFrame();
+    //! Pipelined mode: copies camera() into the camera used by the worker.
+    void takeCameraSnapshot();
+    //! Pipelined mode: prepares the queue of the next frame, executed by the worker thread.
+    void preparePipelinedFrame();
     RenderQueue* renderQueue() { return mRenderQueue.get(); }
     ActorCollection* actorQueue() { return mActorQueue.get(); }
 
+    friend class RenderingWorker;
+    friend class RenderingTree;
+    friend class MultiContextRendering;
+
   protected:
     ref<RenderQueueSorter> mRenderQueueSorter;
     ref<ActorCollection> mActorQueue;
@@ -218,6 +445,13 @@ namespace vl
     Collection<Renderer> mRenderers;
     ref<Camera> mCamera;
     ref<Transform> mTransform;
+    ref<TextureStreamer> mTextureStreamer;
+    ref<FrameProfiler> mProfiler;
+    ref<DynamicResolution> mDynamicResolution;
+    ref<PostAntialiasing> mPostAntialiasing;
+    ref<DepthPrePass> mDepthPrePass;
+    ref<ClusteredLightManager> mClusteredLightManager;
+    ref<CascadedShadowMap> mCascadedShadowMap;
     ref<Collection<SceneManager> > mSceneManagers;
     std::map<unsigned int, ref<Effect> > mEffectOverrideMask;
 
@@ -225,7 +459,51 @@ namespace vl
     bool mCullingEnabled;
     bool mEvaluateLOD;
     bool mShaderAnimationEnabled;
+    bool mIncrementalTransformUpdate;
     bool mNearFarClippingPlanesOptimized;
+    bool mCoherentRenderQueue;
+    int mThreadCount;
+    int mStatsBoundsUpdates;
+    // see Actor::nextBoundsEpoch()
+    long long mBoundsEpoch;
+
+    // LOD cache, see setLODCacheEnabled()
+    bool mLODCacheEnabled;
+    bool mLODCameraValid;
+    real mLODCameraThreshold;
+    float mLODRefreshFraction;
+    unsigned int mLODRefreshFrame;
+    int mStatsLODEvaluations;
+    vec3 mLODCameraPosition;
+    mat4 mLODProjection;
+    int mLODViewport[4];
+
+    // per-frame data used by fillRenderQueue(), computed by prepareActors()
+    struct PreparedActor
+    {
+      Effect* mEffect; // NULL if the Actor should not be rendered
+      int mEffectLOD;
+      int mGeometryLOD;
+    };
+    std::vector<PreparedActor> mPreparedActors;
+    std::vector< ref<ActorCollection> > mSceneManagerActors;
+    // Shaders to be initialized and their position in the render queue, reused across frames
+    std::vector< std::pair<Shader*, int> > mInitShaders;
+
+    // pipelined mode: the queue being prepared for the next frame, the camera snapshot it is culled with,
+    // the Shaders and Renderables it references. mRenderCamera and mKeepAlive belong to the queue being rendered.
+    bool mPipelined;
+    bool mPipelineReady;
+    bool mPrepared;
+    ref<ActorCollection> mPipelineActors;
+    ref<RenderQueue> mPipelineQueue;
+    ref<Camera> mPipelineCamera;
+    ref<Viewport> mPipelineViewport;
+    ref<Camera> mRenderCamera;
+    std::vector< ref<Object> > mPipelineKeepAlive;
+    std::vector< ref<Object> > mKeepAlive;
+    IMutex* mResourceMutex;
+    RenderingWorker* mWorker;
   };
 }
 
@@ -30,11 +30,12 @@
 /**************************************************************************************/
 
 #include <vlGraphics/RenderingTree.hpp>
+#include <vlGraphics/Rendering.hpp>
 
 using namespace vl;
 
 //------------------------------------------------------------------------------
-RenderingTree::RenderingTree()
+RenderingTree::RenderingTree(): mThreadCount(1)
 {
   mSubRendering       = new Collection<RenderingAbstract>;
 }
@@ -43,6 +44,7 @@ RenderingTree& RenderingTree::operator=(const RenderingTree& other)
 {
   super::operator=(other);
   *mSubRendering = *other.mSubRendering;
+  mThreadCount = other.mThreadCount;
   return *this;
 }
 //------------------------------------------------------------------------------
@@ -52,6 +54,12 @@ void RenderingTree::render()
     return;
 
   dispatchOnRenderingStarted();
+
+#ifdef _OPENMP
+  if ( threadCount() > 1 )
+    prepareSubRenderings();
+#endif
+
   for(int i=0; i<subRenderings()->size(); ++i)
   {
     // dispatch update time
@@ -62,3 +70,30 @@ void RenderingTree::render()
   dispatchOnRenderingFinished();
 }
 //------------------------------------------------------------------------------
+void RenderingTree::prepareSubRenderings()
+{
+  // transforms and cameras are updated serially since the children might share their Transform hierarchy
+
+  mPrepareList.clear();
+  for(int i=0; i<subRenderings()->size(); ++i)
+  {
+    Rendering* rendering = subRenderings()->at(i)->as<Rendering>();
+    if ( rendering && rendering->canPrepareFrame() )
+    {
+      rendering->updateTransforms();
+      mPrepareList.push_back( rendering );
+    }
+  }
+
+  // culling, render queue filling and sorting: no OpenGL calls are performed here
+
+  const int count = (int)mPrepareList.size();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(count > 1)
+#endif
+  for(int i=0; i<count; ++i)
+    mPrepareList[i]->prepareFrame();
+
+  mPrepareList.clear();
+}
+//------------------------------------------------------------------------------
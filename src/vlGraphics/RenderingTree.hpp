@@ -33,9 +33,12 @@
 #define RenderingTree_INCLUDE_ONCE
 
 #include <vlGraphics/RenderingAbstract.hpp>
+#include <vector>
 
 namespace vl
 {
+  class Rendering;
+
   //! The RenderingTree class organizes a set of renderings into an N-ary tree.
   //! To enable the RenderingTree set the enableMask() to a value != 0, otherwise the RenderingTree will be disabled.
   class VLGRAPHICS_EXPORT RenderingTree: public RenderingAbstract
@@ -57,13 +60,33 @@ namespace vl
     //! If enableMask() == 0 then no rendering is performed and no RenderEventCallback is called.
     virtual void render();
 
+    /** The number of threads used to cull, fill and sort the render queues of the child Rendering[s] in parallel before they are
+      * rendered one after the other by the calling thread. The Transform[s] and Camera[s] of the children are updated first by the
+      * calling thread. Pipelined child Rendering[s] (see Rendering::setPipelined()) and children that are not a Rendering are rendered
+      * as usual. Requires VL to be compiled with OpenMP support (CMake option VL_OPENMP), otherwise the value is ignored. Defaults to 1.
+      * \note
+      * - The child Rendering[s] must not share their Camera.
+      * - Since the queues are prepared before any child is rendered, the onRenderingStarted() callbacks of the children are dispatched
+      *   after their culling: scene updates should be performed in the callbacks of the RenderingTree itself.
+      * - The SceneManager[s] and Actor[s] shared among the children are accessed concurrently, see Rendering::setThreadCount(). */
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    /** The number of threads used to prepare the child Rendering[s] in parallel, see setThreadCount(). */
+    int threadCount() const { return mThreadCount; }
+
     //! The sub-Rendering (or child-Rendering) objects of a Rendering. A sub-Rendering is rendered before it's parent and after its children.
     Collection<RenderingAbstract>* subRenderings() { return mSubRendering.get(); }
     //! The sub-Rendering (or child-Rendering) objects of a Rendering. A sub-Rendering is rendered before it's parent and after its children.
     const Collection<RenderingAbstract>* subRenderings() const { return mSubRendering.get(); }
 
+  protected:
+    //! Updates the transforms of the child Rendering[s] and prepares their queues in parallel.
+    void prepareSubRenderings();
+
   protected:
     ref< Collection<RenderingAbstract> > mSubRendering;
+    std::vector<Rendering*> mPrepareList;
+    int mThreadCount;
   };
 }
 
@@ -0,0 +1,271 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/ResidencyManager.hpp>
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <algorithm>
+
+using namespace vl;
+
+namespace
+{
+  struct Candidate
+  {
+    Candidate(): mObject(NULL), mLastUsedFrame(0), mIsTexture(false) {}
+    Candidate(Object* obj, unsigned long frame, bool is_texture): mObject(obj), mLastUsedFrame(frame), mIsTexture(is_texture) {}
+    bool operator<(const Candidate& other) const { return mLastUsedFrame < other.mLastUsedFrame; }
+    Object* mObject;
+    unsigned long mLastUsedFrame;
+    bool mIsTexture;
+  };
+}
+//-----------------------------------------------------------------------------
+ResidencyManager::ResidencyManager()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mGPUBudget = 0;
+  mRAMBudget = 0;
+  mMinIdleFrames = 2;
+  mFrame = 0;
+  mGeometryEvictions = 0;
+  mTextureEvictions = 0;
+  mRAMDiscards = 0;
+}
+//-----------------------------------------------------------------------------
+bool ResidencyManager::onRenderingFinished(const RenderingAbstract* rendering)
+{
+  const Rendering* rend = rendering->as<Rendering>();
+  if (rend && rend->visibleActors())
+  {
+    const ActorCollection* actors = rend->visibleActors();
+    for(int i=0; i<actors->size(); ++i)
+      touch( actors->at(i) );
+  }
+
+  enforceBudgets();
+
+  ++mFrame;
+  return true;
+}
+//-----------------------------------------------------------------------------
+void ResidencyManager::touchResource(Object* resource, bool is_texture)
+{
+  Entry& entry = mEntries[resource];
+  if (!entry.mResource)
+  {
+    entry.mResource = resource;
+    entry.mIsTexture = is_texture;
+  }
+  entry.mLastUsedFrame = mFrame;
+}
+//-----------------------------------------------------------------------------
+void ResidencyManager::touch(const Actor* actor)
+{
+  for(int i=0; i<VL_MAX_ACTOR_LOD; ++i)
+  {
+    Geometry* geom = const_cast<Geometry*>( actor->lod(i) ? actor->lod(i)->as<Geometry>() : NULL );
+    if (geom)
+      touchResource(geom, false);
+  }
+
+  const Effect* fx = actor->effect();
+  if (!fx)
+    return;
+
+  for(int ilod=0; ilod<VL_MAX_EFFECT_LOD; ++ilod)
+  {
+    const ShaderPasses* passes = fx->lod(ilod).get();
+    if (!passes)
+      continue;
+    for(int ipass=0; ipass<passes->size(); ++ipass)
+    {
+      const Shader* shader = passes->at(ipass);
+      if (!shader->getRenderStateSet())
+        continue;
+      const RenderStateSlot* slots = shader->getRenderStateSet()->renderStates();
+      for(size_t irs=0; irs<shader->getRenderStateSet()->renderStatesCount(); ++irs)
+      {
+        if (slots[irs].mRS->type() != RS_TextureSampler)
+          continue;
+        Texture* tex = const_cast<Texture*>( slots[irs].mRS->as<TextureSampler>()->texture() );
+        if (tex)
+          touchResource(tex, true);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ResidencyManager::enforceBudgets()
+{
+  std::vector<Candidate> candidates;
+  candidates.reserve(mEntries.size());
+  for(std::map<Object*, Entry>::iterator it = mEntries.begin(); it != mEntries.end(); )
+  {
+    // forget the resources nobody else is using anymore
+    if (it->second.mResource->referenceCount() == 1)
+      mEntries.erase(it++);
+    else
+    {
+      candidates.push_back( Candidate(it->first, it->second.mLastUsedFrame, it->second.mIsTexture) );
+      ++it;
+    }
+  }
+
+  // least recently used first
+  std::stable_sort(candidates.begin(), candidates.end());
+
+  if (mGPUBudget > 0)
+  {
+    long long gpu_bytes = MemoryTracker::gpuBytes();
+    for(size_t i=0; i<candidates.size() && gpu_bytes > mGPUBudget; ++i)
+    {
+      if (mFrame - candidates[i].mLastUsedFrame < (unsigned long)mMinIdleFrames)
+        break;
+      if (candidates[i].mIsTexture)
+        gpu_bytes -= evictTexture( candidates[i].mObject->as<Texture>() );
+      else
+        gpu_bytes -= evictGeometry( candidates[i].mObject->as<Geometry>() );
+    }
+  }
+
+  if (mRAMBudget > 0)
+  {
+    long long ram_bytes = MemoryTracker::ramBytes();
+    for(size_t i=candidates.size(); i-- && ram_bytes > mRAMBudget; )
+    {
+      if (!candidates[i].mIsTexture)
+        ram_bytes -= discardRAM( candidates[i].mObject->as<Geometry>() );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void ResidencyManager::collectBufferObjects(Geometry* geom, std::vector<BufferObject*>& buffers, std::vector<ArrayAbstract*>& arrays)
+{
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    ArrayAbstract* arr = geom->vertexAttribArray(i);
+    if (arr && arr->bufferObject())
+    {
+      arrays.push_back(arr);
+      buffers.push_back(arr->bufferObject());
+    }
+  }
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    ArrayAbstract* arr = geom->drawCalls().at(i)->indexArray();
+    if (arr && arr->bufferObject())
+    {
+      arrays.push_back(arr);
+      buffers.push_back(arr->bufferObject());
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+long long ResidencyManager::evictGeometry(Geometry* geom)
+{
+  if (geom->isDisplayListEnabled() || !geom->isBufferObjectEnabled())
+    return 0;
+
+  std::vector<BufferObject*> buffers;
+  std::vector<ArrayAbstract*> arrays;
+  collectBufferObjects(geom, buffers, arrays);
+
+  long long freed = 0;
+  for(size_t i=0; i<buffers.size(); ++i)
+  {
+    if (!buffers[i]->handle())
+      continue;
+    // the RAM copy is needed to upload the data again
+    if (buffers[i]->bytesUsed() == 0)
+      buffers[i]->downloadBufferObject();
+    freed += buffers[i]->byteCountBufferObject();
+  }
+  if (geom->interleavedBufferObject())
+    freed += geom->interleavedBufferObject()->byteCountBufferObject();
+
+  if (freed == 0)
+    return 0;
+
+  geom->deleteBufferObject();
+  for(size_t i=0; i<arrays.size(); ++i)
+    arrays[i]->setBufferObjectDirty(true);
+  geom->setBufferObjectDirty(true);
+
+  ++mGeometryEvictions;
+  return freed;
+}
+//-----------------------------------------------------------------------------
+long long ResidencyManager::evictTexture(Texture* tex)
+{
+  if (!tex->handle() || !tex->managed())
+    return 0;
+
+  // only the textures that Rendering can recreate on demand
+  ref<Texture::SetupParams> setup_params = tex->setupParams();
+  if (!setup_params || (setup_params->imagePath().empty() && !setup_params->image()))
+    return 0;
+
+  long long freed = tex->estimatedMemoryUsage();
+  tex->destroyTexture();
+  tex->setSetupParams(setup_params.get());
+
+  ++mTextureEvictions;
+  return freed;
+}
+//-----------------------------------------------------------------------------
+long long ResidencyManager::discardRAM(Geometry* geom)
+{
+  // interleaved geometries rebuild their buffer from the arrays
+  if (geom->isDisplayListEnabled() || !geom->isBufferObjectEnabled() || geom->isInterleaved() || geom->isBufferObjectDirty())
+    return 0;
+
+  std::vector<BufferObject*> buffers;
+  std::vector<ArrayAbstract*> arrays;
+  collectBufferObjects(geom, buffers, arrays);
+
+  long long freed = 0;
+  for(size_t i=0; i<buffers.size(); ++i)
+  {
+    if (!buffers[i]->handle() || buffers[i]->bytesUsed() == 0 || arrays[i]->isBufferObjectDirty() || buffers[i]->streamingRingSize() > 1)
+      continue;
+    freed += buffers[i]->capacity();
+    buffers[i]->clear();
+    ++mRAMDiscards;
+  }
+  return freed;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,164 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef ResidencyManager_INCLUDE_ONCE
+#define ResidencyManager_INCLUDE_ONCE
+
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <vlGraphics/link_config.hpp>
+#include <vlCore/MemoryTracker.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  class Actor;
+  class Geometry;
+  class Texture;
+  class BufferObject;
+  class ArrayAbstract;
+  //-----------------------------------------------------------------------------
+  // ResidencyManager
+  //-----------------------------------------------------------------------------
+  /**
+   * Keeps the memory reported by MemoryTracker within a GPU and a RAM budget by evicting the least recently rendered resources.
+   *
+   * Installed in Rendering::onFinishedCallbacks(), at the end of every rendering the manager records the Geometry[s] and Texture[s]
+   * used by the visible Actor[s] (see Rendering::visibleActors()) and then enforces the budgets:
+   *
+   * - GPU budget: the resources not rendered for at least minIdleFrames() frames are evicted, least recently rendered first, until
+   *   MemoryTracker::gpuBytes() is within gpuBudget().
+   *   - A Geometry's BufferObject[s] are deleted and its arrays are marked dirty so that they are uploaded again from RAM the next time
+   *     it is rendered. Arrays whose RAM copy was discarded are downloaded first. Geometries using display lists are never evicted.
+   *   - A Texture is destroyed keeping its Texture::SetupParams, so that Rendering recreates it on demand reloading the image from
+   *     Texture::SetupParams::imagePath() (or the image itself if still set). Textures that cannot be reloaded are never evicted.
+   * - RAM budget: while MemoryTracker::ramBytes() exceeds ramBudget() the RAM copies of the arrays of the Geometry[s] resident on the GPU
+   *   are discarded, most recently rendered first since they are the least likely to be evicted and need them again, as if they had
+   *   been uploaded with BUM_DiscardRamBuffer. Interleaved geometries keep their RAM copies.
+   *
+   * A budget of 0 (the default) disables it. The memory of evicted buffers sub-allocated from a BufferObjectPool is returned to the
+   * OpenGL driver only by BufferObjectPool::defragment().
+   *
+   * \code
+   * ref<ResidencyManager> residency = new ResidencyManager;
+   * residency->setGPUBudget( 512*1024*1024 );
+   * residency->setRAMBudget( 1024*1024*1024 );
+   * rendering->onFinishedCallbacks()->push_back( residency.get() );
+   * \endcode
+   *
+   * \remarks
+   * The manager keeps a reference to the resources it tracks and forgets them as soon as it holds the only one.
+   * Discarding the RAM copy of an array makes it unavailable to the CPU, for example to recompute the bounds or for picking.
+   *
+   * \sa MemoryTracker, BufferObjectPool
+   */
+  class VLGRAPHICS_EXPORT ResidencyManager: public RenderEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::ResidencyManager, RenderEventCallback)
+
+  public:
+    ResidencyManager();
+
+    virtual bool onRenderingStarted(const RenderingAbstract*) { return true; }
+    virtual bool onRenderingFinished(const RenderingAbstract* rendering);
+    virtual bool onRendererStarted(const RendererAbstract*) { return true; }
+    virtual bool onRendererFinished(const RendererAbstract*) { return true; }
+
+    //! The maximum number of bytes of GPU memory, see MemoryTracker::gpuBytes(). 0 (default) means no limit.
+    void setGPUBudget(long long bytes) { mGPUBudget = bytes; }
+    long long gpuBudget() const { return mGPUBudget; }
+
+    //! The maximum number of bytes of RAM, see MemoryTracker::ramBytes(). 0 (default) means no limit.
+    void setRAMBudget(long long bytes) { mRAMBudget = bytes; }
+    long long ramBudget() const { return mRAMBudget; }
+
+    //! The resources rendered in the last \p frames frames are never evicted. Default is 2.
+    void setMinIdleFrames(int frames) { mMinIdleFrames = frames; }
+    int minIdleFrames() const { return mMinIdleFrames; }
+
+    //! Records that the Geometry[s] and Texture[s] used by \p actor have been rendered in the current frame.
+    //! Called by onRenderingFinished() for the visible actors, call it for the actors rendered by other means.
+    void touch(const Actor* actor);
+
+    //! Evicts resources until the budgets are met. Called by onRenderingFinished().
+    void enforceBudgets();
+
+    //! The frame counter, incremented by onRenderingFinished().
+    unsigned long frame() const { return mFrame; }
+    void setFrame(unsigned long frame) { mFrame = frame; }
+
+    //! Number of resources currently tracked.
+    int trackedCount() const { return (int)mEntries.size(); }
+
+    //! Number of Geometry evictions so far.
+    unsigned long geometryEvictions() const { return mGeometryEvictions; }
+
+    //! Number of Texture evictions so far.
+    unsigned long textureEvictions() const { return mTextureEvictions; }
+
+    //! Number of BufferObject[s] whose RAM copy has been discarded so far.
+    unsigned long ramDiscards() const { return mRAMDiscards; }
+
+    //! Forgets all the tracked resources.
+    void clear() { mEntries.clear(); }
+
+  protected:
+    struct Entry
+    {
+      Entry(): mLastUsedFrame(0), mIsTexture(false) {}
+      ref<Object> mResource;
+      unsigned long mLastUsedFrame;
+      bool mIsTexture;
+    };
+
+    void touchResource(Object* resource, bool is_texture);
+    void collectBufferObjects(Geometry* geom, std::vector<BufferObject*>& buffers, std::vector<ArrayAbstract*>& arrays);
+    //! Returns the GPU bytes released.
+    long long evictGeometry(Geometry* geom);
+    //! Returns the GPU bytes released.
+    long long evictTexture(Texture* tex);
+    //! Returns the RAM bytes released.
+    long long discardRAM(Geometry* geom);
+
+  protected:
+    std::map<Object*, Entry> mEntries;
+    long long mGPUBudget;
+    long long mRAMBudget;
+    int mMinIdleFrames;
+    unsigned long mFrame;
+    unsigned long mGeometryEvictions;
+    unsigned long mTextureEvictions;
+    unsigned long mRAMDiscards;
+  };
+}
+
+#endif
@@ -0,0 +1,332 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/SceneFlattener.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlCore/Log.hpp>
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+using namespace vl;
+
+namespace
+{
+  int compareLayout(const Geometry* a, const Geometry* b)
+  {
+    for(int i=0; i<VA_MaxAttribCount; ++i)
+    {
+      const ArrayAbstract* aa = a->vertexAttribArray(i);
+      const ArrayAbstract* bb = b->vertexAttribArray(i);
+      if ( (aa == NULL) != (bb == NULL) )
+        return aa == NULL ? -1 : 1;
+      if ( aa == NULL )
+        continue;
+      if ( aa->glType() != bb->glType() )
+        return aa->glType() < bb->glType() ? -1 : 1;
+      if ( aa->glSize() != bb->glSize() )
+        return aa->glSize() < bb->glSize() ? -1 : 1;
+      if ( aa->normalize() != bb->normalize() )
+        return aa->normalize() < bb->normalize() ? -1 : 1;
+      if ( aa->interpretation() != bb->interpretation() )
+        return aa->interpretation() < bb->interpretation() ? -1 : 1;
+    }
+    return 0;
+  }
+
+  // sorts the items by the coordinate of their center along the given axis
+  struct CenterLess
+  {
+    CenterLess(int axis): mAxis(axis) {}
+    template<class T_Item>
+    bool operator()(const T_Item& a, const T_Item& b) const { return a.mCenter[mAxis] < b.mCenter[mAxis]; }
+    int mAxis;
+  };
+}
+
+//-----------------------------------------------------------------------------
+bool SceneFlattener::isFlattenable(const Actor* actor) const
+{
+  if ( !actor->effect() || actor->lodEvaluator() || actor->scissor() || !actor->actorEventCallbacks()->empty() ||
+       ( actor->getUniformSet() && !actor->getUniformSet()->empty() ) )
+    return false;
+
+  for(int i=1; i<VL_MAX_ACTOR_LOD; ++i)
+  {
+    if ( actor->lod(i) )
+      return false;
+  }
+
+  const Geometry* geom = actor->lod(0) ? actor->lod(0)->as<Geometry>() : NULL;
+  if ( !geom || !geom->vertexArray() || geom->vertexArray()->size() == 0 || geom->drawCalls().empty() )
+    return false;
+
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    const ArrayAbstract* arr = geom->vertexAttribArray(i);
+    if ( arr && arr->size() != geom->vertexArray()->size() )
+      return false;
+  }
+
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    const DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->instances() != 1 || dc->primitiveRestartEnabled() || dc->primitiveType() == PT_PATCHES )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool SceneFlattener::groupLess(const Item& a, const Item& b)
+{
+  if ( a.mActor->effect() != b.mActor->effect() )
+    return a.mActor->effect() < b.mActor->effect();
+  if ( a.mActor->renderBlock() != b.mActor->renderBlock() )
+    return a.mActor->renderBlock() < b.mActor->renderBlock();
+  if ( a.mActor->renderRank() != b.mActor->renderRank() )
+    return a.mActor->renderRank() < b.mActor->renderRank();
+  if ( a.mActor->enableMask() != b.mActor->enableMask() )
+    return a.mActor->enableMask() < b.mActor->enableMask();
+  if ( a.mActor->isOccludee() != b.mActor->isOccludee() )
+    return a.mActor->isOccludee() < b.mActor->isOccludee();
+  return compareLayout(a.mGeometry, b.mGeometry) < 0;
+}
+//-----------------------------------------------------------------------------
+ref<Actor> SceneFlattener::merge(const Item* items, size_t count) const
+{
+  // bake the world matrices
+
+  std::vector< ref<Geometry> > geoms;
+  std::vector<size_t> first_vertex;
+  size_t vertex_count = 0;
+  for(size_t i=0; i<count; ++i)
+  {
+    ref<Geometry> geom = items[i].mGeometry->deepCopy();
+    if ( !items[i].mWorldMatrix.isIdentity() )
+      geom->transform( items[i].mWorldMatrix );
+    geoms.push_back( geom );
+    first_vertex.push_back( vertex_count );
+    vertex_count += items[i].mVertexCount;
+  }
+
+  // concatenate the vertex attributes
+
+  ref<Geometry> merged = new Geometry;
+  for(int iattr=0; iattr<VA_MaxAttribCount; ++iattr)
+  {
+    const ArrayAbstract* src0 = geoms[0]->vertexAttribArray(iattr);
+    if (!src0)
+      continue;
+
+    ref<ArrayAbstract> dst = src0->clone();
+    const size_t bpv = src0->bytesUsed() / src0->size();
+    dst->bufferObject()->resize( vertex_count * bpv );
+    for(size_t i=0; i<geoms.size(); ++i)
+    {
+      const ArrayAbstract* src = geoms[i]->vertexAttribArray(iattr);
+      memcpy( dst->ptr() + first_vertex[i] * bpv, src->ptr(), src->bytesUsed() );
+    }
+    merged->setVertexAttribArray(iattr, dst.get());
+  }
+
+  // rebase the draw calls
+
+  std::set<EPrimitiveType> primitive_types;
+  for(size_t i=0; i<geoms.size(); ++i)
+  {
+    const Collection<DrawCall>& dcs = geoms[i]->drawCalls();
+    for(int idc=0; idc<dcs.size(); ++idc)
+    {
+      if ( !dcs.at(idc)->isEnabled() )
+        continue;
+      ref<DrawElementsUInt> de = new DrawElementsUInt( dcs.at(idc)->primitiveType() );
+      de->indexBuffer()->resize( dcs.at(idc)->countIndices() );
+      GLuint* index = de->indexBuffer()->begin();
+      for(IndexIterator iit = dcs.at(idc)->indexIterator(); iit.hasNext(); iit.next(), ++index)
+        *index = (GLuint)(first_vertex[i] + iit.index());
+      VL_CHECK( index == de->indexBuffer()->end() )
+      merged->drawCalls().push_back( de.get() );
+      primitive_types.insert( de->primitiveType() );
+    }
+  }
+
+  // merge the draw calls: triangles into a single triangle list, the other primitives by type
+
+  merged->mergeDrawCallsWithTriangles(PT_UNKNOWN);
+  for(std::set<EPrimitiveType>::const_iterator it = primitive_types.begin(); it != primitive_types.end(); ++it)
+  {
+    int same_type = 0;
+    for(int idc=0; idc<merged->drawCalls().size(); ++idc)
+      same_type += merged->drawCalls().at(idc)->primitiveType() == *it ? 1 : 0;
+    if ( same_type < 2 )
+      continue;
+    if ( mUsePrimitiveRestart )
+      merged->mergeDrawCallsWithPrimitiveRestart(*it);
+    else
+      merged->mergeDrawCallsWithMultiDrawElements(*it);
+  }
+
+  merged->computeBounds();
+
+  Actor* actor0 = items[0].mActor;
+  ref<Actor> actor = new Actor( merged.get(), actor0->effect(), NULL, actor0->renderBlock(), actor0->renderRank() );
+  actor->setEnableMask( actor0->enableMask() );
+  actor->setOccludee( actor0->isOccludee() );
+  return actor;
+}
+//-----------------------------------------------------------------------------
+void SceneFlattener::cluster(std::vector<Item>& items, size_t first, size_t last, std::vector< ref<Actor> >& out) const
+{
+  size_t vertex_count = 0;
+  AABB centers;
+  for(size_t i=first; i<last; ++i)
+  {
+    vertex_count += items[i].mVertexCount;
+    centers.addPoint( items[i].mCenter );
+  }
+
+  if ( last - first == 1 )
+  {
+    out.push_back( items[first].mActor );
+    return;
+  }
+
+  if ( vertex_count <= (size_t)mMaxClusterVertices )
+  {
+    out.push_back( merge( &items[first], last - first ) );
+    return;
+  }
+
+  // split at the median along the longest axis
+  int axis = 0;
+  if ( centers.height() > centers.width() )
+    axis = 1;
+  if ( centers.depth() > (axis == 0 ? centers.width() : centers.height()) )
+    axis = 2;
+  size_t mid = first + (last - first) / 2;
+  std::nth_element( items.begin() + first, items.begin() + mid, items.begin() + last, CenterLess(axis) );
+  cluster( items, first, mid, out );
+  cluster( items, mid, last, out );
+}
+//-----------------------------------------------------------------------------
+std::vector< ref<Actor> > SceneFlattener::flatten(const std::vector< ref<Actor> >& actors)
+{
+  std::vector< ref<Actor> > out;
+  std::vector< ref<Actor> > passed;
+  std::vector<Item> items;
+  for(size_t i=0; i<actors.size(); ++i)
+  {
+    Actor* actor = actors[i].get_writable();
+    if ( !isFlattenable(actor) )
+    {
+      passed.push_back( actor );
+      continue;
+    }
+    Item item;
+    item.mActor = actor;
+    item.mGeometry = actor->lod(0)->as<Geometry>();
+    item.mWorldMatrix = actor->transform() ? actor->transform()->getComputedWorldMatrix() : mat4();
+    item.mCenter = item.mWorldMatrix * item.mGeometry->boundingBox().center();
+    item.mVertexCount = item.mGeometry->vertexArray()->size();
+    items.push_back( item );
+  }
+
+  std::stable_sort( items.begin(), items.end(), groupLess );
+  for(size_t first=0; first<items.size(); )
+  {
+    size_t last = first + 1;
+    while( last < items.size() && !groupLess(items[first], items[last]) )
+      ++last;
+
+    if ( (int)(last - first) < mMinClusterActors )
+    {
+      for(size_t i=first; i<last; ++i)
+        passed.push_back( items[i].mActor );
+    }
+    else
+      cluster( items, first, last, out );
+
+    first = last;
+  }
+
+  out.insert( out.end(), passed.begin(), passed.end() );
+
+  mStatsInputActors = (int)actors.size();
+  mStatsOutputActors = (int)out.size();
+  Log::debug( Say("SceneFlattener: %n actors flattened into %n.\n") << mStatsInputActors << mStatsOutputActors );
+
+  return out;
+}
+//-----------------------------------------------------------------------------
+void SceneFlattener::flatten(ResourceDatabase* db)
+{
+  std::vector< ref<Actor> > actors;
+  db->get<Actor>(actors);
+  std::vector< ref<Actor> > flattened = flatten(actors);
+
+  std::set<const Object*> kept;
+  for(size_t i=0; i<flattened.size(); ++i)
+  {
+    kept.insert( flattened[i].get() );
+    for(int lod=0; lod<VL_MAX_ACTOR_LOD; ++lod)
+      if ( flattened[i]->lod(lod) )
+        kept.insert( flattened[i]->lod(lod) );
+  }
+
+  std::set<const Object*> removed;
+  for(size_t i=0; i<actors.size(); ++i)
+  {
+    if ( kept.find(actors[i].get()) != kept.end() )
+      continue;
+    removed.insert( actors[i].get() );
+    if ( kept.find(actors[i]->lod(0)) == kept.end() )
+      removed.insert( actors[i]->lod(0) );
+  }
+
+  std::vector< ref<Object> > resources;
+  for(size_t i=0; i<db->resources().size(); ++i)
+  {
+    if ( removed.find(db->resources()[i].get()) == removed.end() )
+      resources.push_back( db->resources()[i] );
+  }
+  for(size_t i=0; i<flattened.size(); ++i)
+  {
+    if ( std::find(actors.begin(), actors.end(), flattened[i]) == actors.end() )
+    {
+      resources.push_back( flattened[i]->lod(0) );
+      resources.push_back( flattened[i] );
+    }
+  }
+  db->resources().swap( resources );
+}
+//-----------------------------------------------------------------------------
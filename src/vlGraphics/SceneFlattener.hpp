@@ -0,0 +1,127 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef SceneFlattener_INCLUDE_ONCE
+#define SceneFlattener_INCLUDE_ONCE
+
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlCore/ResourceDatabase.hpp>
+#include <vector>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // SceneFlattener
+  //------------------------------------------------------------------------------
+  /** Reduces the number of Actor[s] and draw calls of a static scene by merging its Geometry[s].
+    *
+    * The Geometry of each flattenable Actor is copied and pre-transformed by the world matrix of the Actor's Transform
+    * (see Geometry::transform()). The copies sharing the same Effect, render block, render rank, enable mask and vertex
+    * attribute layout are then spatially clustered, splitting them at the median along the longest axis until each cluster
+    * contains at most maxClusterVertices() vertices, so that the resulting Actor[s] can still be culled effectively.
+    * The Geometry[s] of each cluster are concatenated into one Geometry rendered by a new Actor with no Transform, whose
+    * triangle primitives are merged into a single PT_TRIANGLES draw call (see Geometry::mergeDrawCallsWithTriangles())
+    * while the other primitive types are merged using either Geometry::mergeDrawCallsWithMultiDrawElements() or
+    * Geometry::mergeDrawCallsWithPrimitiveRestart().
+    *
+    * An Actor is flattened only if:
+    * - its only LOD is a Geometry with a vertex array, which is not instanced and does not use primitive restart
+    * - it has no LODEvaluator, no Scissor, no ActorEventCallback and no Actor uniforms
+    *
+    * The Transform[s] are assumed to be static: animating them after flattening has no effect on the merged Actor[s].
+    * \sa StaticBatchRenderer, expandResourceDatabase() */
+  class VLGRAPHICS_EXPORT SceneFlattener: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::SceneFlattener, Object)
+
+  public:
+    SceneFlattener(): mMaxClusterVertices(65536), mMinClusterActors(2), mUsePrimitiveRestart(false), mStatsInputActors(0), mStatsOutputActors(0) {}
+
+    /** Flattens the given Actor[s], returns the merged Actor[s] followed by the Actor[s] that could not be flattened. */
+    std::vector< ref<Actor> > flatten(const std::vector< ref<Actor> >& actors);
+
+    /** Replaces the Actor[s] contained in the given ResourceDatabase with their flattened version.
+      * The Geometry[s] no longer referenced by any Actor are removed from the database while the Transform[s] are kept
+      * since they might still be part of a hierarchy. */
+    void flatten(ResourceDatabase* db);
+
+    /** Maximum number of vertices of a merged Geometry (default = 65536). */
+    void setMaxClusterVertices(int count) { mMaxClusterVertices = count; }
+
+    /** Maximum number of vertices of a merged Geometry (default = 65536). */
+    int maxClusterVertices() const { return mMaxClusterVertices; }
+
+    /** Groups with less than this number of Actor[s] are left untouched (default = 2). */
+    void setMinClusterActors(int count) { mMinClusterActors = count; }
+
+    /** Groups with less than this number of Actor[s] are left untouched (default = 2). */
+    int minClusterActors() const { return mMinClusterActors; }
+
+    /** If true non triangle primitives are merged using primitive restart instead of MultiDrawElements (default = false). */
+    void setUsePrimitiveRestart(bool use) { mUsePrimitiveRestart = use; }
+
+    /** If true non triangle primitives are merged using primitive restart instead of MultiDrawElements (default = false). */
+    bool usePrimitiveRestart() const { return mUsePrimitiveRestart; }
+
+    /** Number of Actor[s] passed to the last flatten(). */
+    int statsInputActors() const { return mStatsInputActors; }
+
+    /** Number of Actor[s] returned by the last flatten(). */
+    int statsOutputActors() const { return mStatsOutputActors; }
+
+  protected:
+    struct Item
+    {
+      Actor* mActor;
+      Geometry* mGeometry;
+      mat4 mWorldMatrix;
+      vec3 mCenter;
+      size_t mVertexCount;
+    };
+
+    bool isFlattenable(const Actor* actor) const;
+    static bool groupLess(const Item& a, const Item& b);
+    void cluster(std::vector<Item>& items, size_t first, size_t last, std::vector< ref<Actor> >& out) const;
+    ref<Actor> merge(const Item* items, size_t count) const;
+
+  protected:
+    int mMaxClusterVertices;
+    int mMinClusterActors;
+    bool mUsePrimitiveRestart;
+    int mStatsInputActors;
+    int mStatsOutputActors;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
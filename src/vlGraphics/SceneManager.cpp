@@ -36,6 +36,7 @@
 #include <vlGraphics/Scissor.hpp>
 #include <vlGraphics/Texture.hpp>
 #include <vlCore/Image.hpp>
+#include <map>
 
 using namespace vl;
 
@@ -81,6 +82,33 @@ void SceneManager::computeBounds()
   setBoundsDirty(false);
 }
 //-----------------------------------------------------------------------------
+void SceneManager::extractMultiViewVisibleActors(ActorCollection& list, std::vector<u32>& view_masks, const std::vector<const Camera*>& cameras, u32 view_mask)
+{
+  std::map<Actor*, int> actor_index;
+  ActorCollection view_actors;
+  for(size_t iview=0; iview<cameras.size() && iview<32; ++iview)
+  {
+    const u32 bit = 1u << iview;
+    if ( !(view_mask & bit) )
+      continue;
+
+    view_actors.clear();
+    extractVisibleActors( view_actors, cameras[iview] );
+    for(int i=0; i<view_actors.size(); ++i)
+    {
+      std::map<Actor*, int>::iterator it = actor_index.find( view_actors.at(i) );
+      if ( it == actor_index.end() )
+      {
+        actor_index[ view_actors.at(i) ] = (int)view_masks.size();
+        list.push_back( view_actors.at(i) );
+        view_masks.push_back( bit );
+      }
+      else
+        view_masks[ it->second ] |= bit;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
 bool SceneManager::isEnabled(Actor*a) const
 {
   return a->isEnabled() && (a->enableMask() & enableMask()) != 0;
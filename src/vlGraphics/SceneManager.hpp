@@ -35,6 +35,7 @@
 #include <vlGraphics/link_config.hpp>
 #include <vlCore/Object.hpp>
 #include <vlCore/Sphere.hpp>
+#include <vector>
 
 namespace vl
 {
@@ -66,6 +67,7 @@ namespace vl
    * - SceneManager
    * - SceneManagerActorKdTree
    * - SceneManagerActorTree
+   * - SceneManagerDynamicBVH
    * - SceneManagerPortals
    * - Actor
   */
@@ -84,6 +86,13 @@ namespace vl
     //! \see SceneManager::enableMask(), Actor::enableMask(), Actor::isEnabled(), ActorTreeAbstract::isEnabled()
     virtual void extractVisibleActors(ActorCollection& list, const Camera* camera) = 0;
 
+    //! Extracts the enabled Actors visible from at least one of the given cameras (at most 32) and appends them to the given ActorCollection.
+    //! For each Actor appended the bitmask of the cameras it is visible from (bit \p i for \p cameras[i]) is appended to \p view_masks.
+    //! Only the cameras whose bit is set in \p view_mask are considered, their frustum planes must be up to date.
+    //! The default implementation calls extractVisibleActors() once per camera and merges the results, SceneManagerBVH tests
+    //! all the frusta in a single traversal of its tree.
+    virtual void extractMultiViewVisibleActors(ActorCollection& list, std::vector<u32>& view_masks, const std::vector<const Camera*>& cameras, u32 view_mask);
+
     //! Computes the bounding box and bounding sphere of the scene manager and of all the Actors contained in the SceneManager.
     virtual void computeBounds();
 
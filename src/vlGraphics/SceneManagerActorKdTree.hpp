@@ -34,11 +34,19 @@
 
 #include <vlGraphics/SceneManagerBVH.hpp>
 #include <vlGraphics/ActorKdTree.hpp>
+#include <vlGraphics/CompiledActorTree.hpp>
+#include <vlGraphics/ImpostorManager.hpp>
 
 namespace vl
 {
   /**
    * A SceneManagerBVH that implements its spatial partitioning strategy using an ActorKdTree.
+   *
+   * For static scenes compileTree() creates a CompiledActorTree which is then used in place of the ActorKdTree
+   * by extractVisibleActors() and extractActors(), until the tree is modified and discardCompiledTree() is called.
+ *
+ * When an ImpostorManager is installed with setImpostorManager() extractVisibleActors() traverses the ActorKdTree, also if compiled,
+ * replacing its distant nodes with their impostors.
    *
    * \sa
    * - Actor
@@ -59,6 +67,56 @@ namespace vl
       VL_DEBUG_SET_OBJECT_NAME()
       mBoundingVolumeTree = new ActorKdTree;
     }
+
+    virtual void extractVisibleActors(ActorCollection& list, const Camera* camera)
+    {
+      if ( mImpostorManager && cullingEnabled() && camera ) {
+        mImpostorManager->extractVisibleActors( tree(), list, camera, enableMask() );
+      }
+      else if ( !mCompiledTree ) {
+        SceneManagerBVH<ActorKdTree>::extractVisibleActors(list, camera);
+      }
+      else if ( cullingEnabled() ) {
+        mCompiledTree->extractVisibleActors( list, camera, enableMask() );
+      }
+      else {
+        mCompiledTree->extractActors(list);
+      }
+    }
+
+    virtual void extractActors(ActorCollection& list)
+    {
+      if ( !mCompiledTree ) {
+        SceneManagerBVH<ActorKdTree>::extractActors(list);
+      }
+      else {
+        mCompiledTree->extractActors(list);
+      }
+    }
+
+    //! Compiles the current tree into a CompiledActorTree used from now on for the Actor extraction.
+    //! The bounding boxes of the tree are updated before compiling it.
+    void compileTree()
+    {
+      tree()->computeAABB();
+      mCompiledTree = new CompiledActorTree(tree());
+    }
+
+    //! Discards the CompiledActorTree, to be called after the tree is modified.
+    void discardCompiledTree() { mCompiledTree = NULL; }
+
+    //! The CompiledActorTree created by compileTree(), NULL if none.
+    const CompiledActorTree* compiledTree() const { return mCompiledTree.get(); }
+
+    //! Installs an ImpostorManager used by extractVisibleActors() to replace the distant nodes of the tree, NULL to disable it.
+    void setImpostorManager(ImpostorManager* impostors) { mImpostorManager = impostors; }
+
+    //! The ImpostorManager used by extractVisibleActors(), NULL if none.
+    ImpostorManager* impostorManager() { return mImpostorManager.get(); }
+
+  protected:
+    ref<CompiledActorTree> mCompiledTree;
+    ref<ImpostorManager> mImpostorManager;
   };
 }
 
@@ -33,6 +33,7 @@
 #define SceneManagerVolumeTree_INCLUDE_ONCE
 
 #include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/Actor.hpp>
 
 namespace vl
 {
@@ -75,6 +76,18 @@ namespace vl
       }
     }
 
+    virtual void extractMultiViewVisibleActors(ActorCollection& list, std::vector<u32>& view_masks, const std::vector<const Camera*>& cameras, u32 view_mask)
+    {
+      // tests all the frusta during a single traversal of the hierarchical volume tree
+      if ( cullingEnabled() ) {
+        tree()->extractMultiViewVisibleActors( list, view_masks, cameras, enableMask(), view_mask );
+      }
+      else {
+        extractActors(list);
+        view_masks.resize( list.size(), view_mask );
+      }
+    }
+
     virtual void extractActors(ActorCollection& list)
     {
       // extracts Actors from the hierarchical volume tree
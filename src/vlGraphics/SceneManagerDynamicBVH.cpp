@@ -0,0 +1,626 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/SceneManagerDynamicBVH.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <algorithm>
+#include <limits>
+
+using namespace vl;
+
+namespace
+{
+  inline real surfaceArea(const AABB& aabb)
+  {
+    real w = aabb.width(), h = aabb.height(), d = aabb.depth();
+    return 2 * (w*h + h*d + d*w);
+  }
+
+  inline bool contains(const AABB& outer, const AABB& inner)
+  {
+    return outer.minCorner().x() <= inner.minCorner().x() && outer.maxCorner().x() >= inner.maxCorner().x() &&
+           outer.minCorner().y() <= inner.minCorner().y() && outer.maxCorner().y() >= inner.maxCorner().y() &&
+           outer.minCorner().z() <= inner.minCorner().z() && outer.maxCorner().z() >= inner.maxCorner().z();
+  }
+}
+//-----------------------------------------------------------------------------
+SceneManagerDynamicBVH::SceneManagerDynamicBVH()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mRoot = -1;
+  mFreeList = -1;
+  mFatMargin = 0.1f;
+  mAutoUpdate = true;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractActors(ActorCollection& list)
+{
+  for(size_t i=0; i<mNodes.size(); ++i)
+  {
+    if ( mNodes[i].mHeight == 0 )
+      list.push_back( mNodes[i].mActor.get() );
+  }
+  for(int i=0; i<mUnboundedActors.size(); ++i)
+    list.push_back( mUnboundedActors[i].get() );
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractVisibleActors(ActorCollection& list, const Camera* camera)
+{
+  if ( autoUpdate() )
+    updateActors();
+
+  if ( !cullingEnabled() || !camera )
+  {
+    ActorCollection actors;
+    extractActors(actors);
+    for(int i=0; i<actors.size(); ++i)
+    {
+      if ( isEnabled(actors[i].get()) )
+        list.push_back( actors[i].get() );
+    }
+    return;
+  }
+
+  for(int i=0; i<mUnboundedActors.size(); ++i)
+  {
+    if ( isEnabled(mUnboundedActors[i].get()) )
+      list.push_back( mUnboundedActors[i].get() );
+  }
+
+  if ( mRoot == -1 )
+    return;
+
+  const Frustum& frustum = camera->frustum();
+  if ( frustum.planes().size() <= 32 )
+  {
+    const unsigned plane_count = (unsigned)frustum.planes().size();
+    extractVisible( mRoot, list, frustum, plane_count == 32 ? 0xFFFFFFFF : (1u << plane_count) - 1 );
+  }
+  else
+  {
+    // plain hierarchical culling
+    std::vector<int> stack;
+    stack.push_back(mRoot);
+    while( !stack.empty() )
+    {
+      Node& node = mNodes[stack.back()];
+      stack.pop_back();
+      if ( frustum.cull(node.mAABB) )
+        continue;
+      if ( node.isLeaf() )
+      {
+        if ( isEnabled(node.mActor.get()) && !frustum.cull(node.mActor->boundingBox()) )
+          list.push_back( node.mActor.get() );
+      }
+      else
+      {
+        stack.push_back(node.mChild[0]);
+        stack.push_back(node.mChild[1]);
+      }
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractVisible(int inode, ActorCollection& list, const Frustum& frustum, u32 plane_mask)
+{
+  Node& node = mNodes[inode];
+  if ( plane_mask && frustum.cull(node.mAABB, plane_mask, node.mLastCulledPlane) )
+    return;
+
+  if ( node.isLeaf() )
+  {
+    Actor* actor = node.mActor.get();
+    // the leaf box is fat, test the actual one against the planes still intersected
+    int last_plane = -1;
+    if ( isEnabled(actor) && ( !plane_mask || !frustum.cull(actor->boundingBox(), plane_mask, last_plane) ) )
+      list.push_back(actor);
+  }
+  else
+  {
+    extractVisible(node.mChild[0], list, frustum, plane_mask);
+    extractVisible(node.mChild[1], list, frustum, plane_mask);
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractActorsInBox(ActorCollection& list, const AABB& box)
+{
+  if ( mRoot != -1 )
+    extractInBox(mRoot, list, box);
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractActorsInSphere(ActorCollection& list, const Sphere& sphere)
+{
+  if ( mRoot != -1 )
+    extractInSphere(mRoot, list, sphere.center(), sphere.radius() * sphere.radius());
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractNearestActors(ActorCollection& list, const vec3& point, int k, real max_distance)
+{
+  if ( mRoot == -1 || k <= 0 )
+    return;
+
+  NearestHeap heap;
+  heap.reserve(k);
+  extractNearest(mRoot, heap, point, k, max_distance < 0 ? std::numeric_limits<real>::max() : max_distance * max_distance);
+
+  // sort_heap() leaves the nearest Actor first
+  std::sort_heap(heap.begin(), heap.end());
+  for(size_t i=0; i<heap.size(); ++i)
+    list.push_back(heap[i].second);
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractInBox(int inode, ActorCollection& list, const AABB& box)
+{
+  Node& node = mNodes[inode];
+  if ( !node.mAABB.intersects(box) )
+    return;
+
+  if ( node.isLeaf() )
+  {
+    // the leaf box is fat, test the actual one
+    Actor* actor = node.mActor.get();
+    if ( isEnabled(actor) && actor->boundingBox().intersects(box) )
+      list.push_back(actor);
+  }
+  else
+  {
+    extractInBox(node.mChild[0], list, box);
+    extractInBox(node.mChild[1], list, box);
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractInSphere(int inode, ActorCollection& list, const vec3& center, real radius2)
+{
+  Node& node = mNodes[inode];
+  if ( node.mAABB.squaredDistance(center) > radius2 )
+    return;
+
+  if ( node.isLeaf() )
+  {
+    Actor* actor = node.mActor.get();
+    if ( isEnabled(actor) && actor->boundingBox().squaredDistance(center) <= radius2 )
+      list.push_back(actor);
+  }
+  else
+  {
+    extractInSphere(node.mChild[0], list, center, radius2);
+    extractInSphere(node.mChild[1], list, center, radius2);
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::extractNearest(int inode, NearestHeap& heap, const vec3& point, int k, real max_dist2)
+{
+  Node& node = mNodes[inode];
+  if ( node.mAABB.squaredDistance(point) > ( (int)heap.size() == k ? heap.front().first : max_dist2 ) )
+    return;
+
+  if ( node.isLeaf() )
+  {
+    Actor* actor = node.mActor.get();
+    if ( !isEnabled(actor) )
+      return;
+    const real dist2 = actor->boundingBox().squaredDistance(point);
+    if ( (int)heap.size() < k )
+    {
+      if ( dist2 <= max_dist2 )
+      {
+        heap.push_back( std::make_pair(dist2, actor) );
+        std::push_heap(heap.begin(), heap.end());
+      }
+    }
+    else
+    if ( dist2 < heap.front().first )
+    {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = std::make_pair(dist2, actor);
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+  else
+  {
+    // visit the nearest child first so that the farthest is more likely to be skipped
+    const int near_child = mNodes[node.mChild[1]].mAABB.squaredDistance(point) < mNodes[node.mChild[0]].mAABB.squaredDistance(point) ? 1 : 0;
+    const int far_child  = node.mChild[1 - near_child];
+    extractNearest(node.mChild[near_child], heap, point, k, max_dist2);
+    extractNearest(far_child, heap, point, k, max_dist2);
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::insertActor(Actor* actor)
+{
+  VL_CHECK(actor)
+  if ( !actor || hasActor(actor) )
+    return;
+
+  actor->computeBounds();
+  if ( actor->boundingBox().isNull() )
+  {
+    mProxies[actor] = -1;
+    mUnboundedActors.push_back(actor);
+  }
+  else
+  {
+    int leaf = allocateNode();
+    mNodes[leaf].mActor  = actor;
+    mNodes[leaf].mAABB   = fatAABB(actor->boundingBox());
+    mNodes[leaf].mHeight = 0;
+    mProxies[actor] = leaf;
+    insertLeaf(leaf);
+  }
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+bool SceneManagerDynamicBVH::removeActor(Actor* actor)
+{
+  std::map<Actor*, int>::iterator it = mProxies.find(actor);
+  if ( it == mProxies.end() )
+    return false;
+
+  if ( it->second == -1 )
+  {
+    mUnboundedActors.erase(actor);
+  }
+  else
+  {
+    removeLeaf(it->second);
+    freeNode(it->second);
+  }
+  mProxies.erase(it);
+  setBoundsDirty(true);
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool SceneManagerDynamicBVH::updateActor(Actor* actor)
+{
+  std::map<Actor*, int>::iterator it = mProxies.find(actor);
+  if ( it == mProxies.end() )
+    return false;
+
+  // keeps the Actor alive while moving it between mUnboundedActors and the tree
+  ref<Actor> keep_alive = actor;
+  actor->computeBounds();
+  const AABB& aabb = actor->boundingBox();
+  int leaf = it->second;
+
+  if ( leaf == -1 )
+  {
+    if ( aabb.isNull() )
+      return false;
+    // the Actor got bounds: move it into the tree
+    mUnboundedActors.erase(actor);
+    leaf = allocateNode();
+    mNodes[leaf].mActor  = actor;
+    mNodes[leaf].mAABB   = fatAABB(aabb);
+    mNodes[leaf].mHeight = 0;
+    it->second = leaf;
+    insertLeaf(leaf);
+  }
+  else
+  if ( aabb.isNull() )
+  {
+    // the Actor lost its bounds: take it out of the tree
+    mUnboundedActors.push_back(actor);
+    removeLeaf(leaf);
+    freeNode(leaf);
+    it->second = -1;
+  }
+  else
+  {
+    if ( contains(mNodes[leaf].mAABB, aabb) )
+      return false;
+    removeLeaf(leaf);
+    mNodes[leaf].mAABB = fatAABB(aabb);
+    insertLeaf(leaf);
+  }
+
+  setBoundsDirty(true);
+  return true;
+}
+//-----------------------------------------------------------------------------
+int SceneManagerDynamicBVH::updateActors()
+{
+  int count = 0;
+
+  // reinserting a leaf never changes its index, only internal nodes are reallocated
+  for(size_t i=0; i<mNodes.size(); ++i)
+  {
+    if ( mNodes[i].mHeight == 0 )
+    {
+      Actor* actor = mNodes[i].mActor.get();
+      actor->computeBounds();
+      if ( actor->boundingBox().isNull() || !contains(mNodes[i].mAABB, actor->boundingBox()) )
+        count += updateActor(actor) ? 1 : 0;
+    }
+  }
+
+  if ( !mUnboundedActors.empty() )
+  {
+    ActorCollection unbounded = mUnboundedActors;
+    for(int i=0; i<unbounded.size(); ++i)
+      count += updateActor(unbounded[i].get()) ? 1 : 0;
+  }
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::clear()
+{
+  mNodes.clear();
+  mProxies.clear();
+  mUnboundedActors.clear();
+  mRoot = -1;
+  mFreeList = -1;
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+AABB SceneManagerDynamicBVH::fatAABB(const AABB& aabb) const
+{
+  AABB fat = aabb;
+  fat.enlarge( aabb.longestSideLength() * fatMargin() );
+  return fat;
+}
+//-----------------------------------------------------------------------------
+int SceneManagerDynamicBVH::allocateNode()
+{
+  if ( mFreeList == -1 )
+  {
+    mNodes.push_back( Node() );
+    return (int)mNodes.size() - 1;
+  }
+  int node = mFreeList;
+  mFreeList = mNodes[node].mParent;
+  mNodes[node] = Node();
+  return node;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::freeNode(int node)
+{
+  mNodes[node] = Node();
+  mNodes[node].mParent = mFreeList;
+  mFreeList = node;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::insertLeaf(int leaf)
+{
+  if ( mRoot == -1 )
+  {
+    mRoot = leaf;
+    mNodes[leaf].mParent = -1;
+    return;
+  }
+
+  // find the best sibling descending the tree and choosing the child whose surface area increases the least
+  const AABB leaf_aabb = mNodes[leaf].mAABB;
+  int index = mRoot;
+  while( !mNodes[index].isLeaf() )
+  {
+    const Node& node = mNodes[index];
+    real area = surfaceArea(node.mAABB);
+    real combined_area = surfaceArea(node.mAABB + leaf_aabb);
+
+    // cost of creating a new parent for this node and the new leaf
+    real cost = 2 * combined_area;
+    // minimum cost of pushing the leaf further down the tree
+    real inheritance_cost = 2 * (combined_area - area);
+
+    real child_cost[2];
+    for(int i=0; i<2; ++i)
+    {
+      const Node& child = mNodes[node.mChild[i]];
+      child_cost[i] = surfaceArea(child.mAABB + leaf_aabb) + inheritance_cost;
+      if ( !child.isLeaf() )
+        child_cost[i] -= surfaceArea(child.mAABB);
+    }
+
+    if ( cost < child_cost[0] && cost < child_cost[1] )
+      break;
+
+    index = child_cost[0] < child_cost[1] ? node.mChild[0] : node.mChild[1];
+  }
+
+  // create a new parent for the sibling and the leaf
+  const int sibling = index;
+  const int old_parent = mNodes[sibling].mParent;
+  const int new_parent = allocateNode();
+  mNodes[new_parent].mParent   = old_parent;
+  mNodes[new_parent].mAABB     = leaf_aabb + mNodes[sibling].mAABB;
+  mNodes[new_parent].mHeight   = mNodes[sibling].mHeight + 1;
+  mNodes[new_parent].mChild[0] = sibling;
+  mNodes[new_parent].mChild[1] = leaf;
+  mNodes[sibling].mParent = new_parent;
+  mNodes[leaf].mParent = new_parent;
+
+  if ( old_parent != -1 )
+  {
+    if ( mNodes[old_parent].mChild[0] == sibling )
+      mNodes[old_parent].mChild[0] = new_parent;
+    else
+      mNodes[old_parent].mChild[1] = new_parent;
+  }
+  else
+    mRoot = new_parent;
+
+  fixUpwards( mNodes[leaf].mParent );
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::removeLeaf(int leaf)
+{
+  if ( leaf == mRoot )
+  {
+    mRoot = -1;
+    return;
+  }
+
+  const int parent = mNodes[leaf].mParent;
+  const int grand_parent = mNodes[parent].mParent;
+  const int sibling = mNodes[parent].mChild[0] == leaf ? mNodes[parent].mChild[1] : mNodes[parent].mChild[0];
+
+  if ( grand_parent != -1 )
+  {
+    // replace the parent with the sibling
+    if ( mNodes[grand_parent].mChild[0] == parent )
+      mNodes[grand_parent].mChild[0] = sibling;
+    else
+      mNodes[grand_parent].mChild[1] = sibling;
+    mNodes[sibling].mParent = grand_parent;
+    freeNode(parent);
+    fixUpwards(grand_parent);
+  }
+  else
+  {
+    mRoot = sibling;
+    mNodes[sibling].mParent = -1;
+    freeNode(parent);
+  }
+  mNodes[leaf].mParent = -1;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerDynamicBVH::fixUpwards(int index)
+{
+  while( index != -1 )
+  {
+    index = balance(index);
+    Node& node = mNodes[index];
+    const Node& c0 = mNodes[node.mChild[0]];
+    const Node& c1 = mNodes[node.mChild[1]];
+    node.mHeight = 1 + std::max(c0.mHeight, c1.mHeight);
+    node.mAABB = c0.mAABB + c1.mAABB;
+    index = node.mParent;
+  }
+}
+//-----------------------------------------------------------------------------
+int SceneManagerDynamicBVH::balance(int ia)
+{
+  Node& a = mNodes[ia];
+  if ( a.isLeaf() || a.mHeight < 2 )
+    return ia;
+
+  // rotates the higher child of "a" up
+  const int ib = a.mChild[0];
+  const int ic = a.mChild[1];
+  Node& b = mNodes[ib];
+  Node& c = mNodes[ic];
+  const int diff = c.mHeight - b.mHeight;
+
+  if ( diff > 1 )
+  {
+    // rotate c up
+    const int i_f = c.mChild[0];
+    const int i_g = c.mChild[1];
+    Node& f = mNodes[i_f];
+    Node& g = mNodes[i_g];
+
+    c.mChild[0] = ia;
+    c.mParent = a.mParent;
+    a.mParent = ic;
+
+    if ( c.mParent != -1 )
+    {
+      if ( mNodes[c.mParent].mChild[0] == ia )
+        mNodes[c.mParent].mChild[0] = ic;
+      else
+        mNodes[c.mParent].mChild[1] = ic;
+    }
+    else
+      mRoot = ic;
+
+    if ( f.mHeight > g.mHeight )
+    {
+      c.mChild[1] = i_f;
+      a.mChild[1] = i_g;
+      g.mParent = ia;
+      a.mAABB = b.mAABB + g.mAABB;
+      c.mAABB = a.mAABB + f.mAABB;
+      a.mHeight = 1 + std::max(b.mHeight, g.mHeight);
+      c.mHeight = 1 + std::max(a.mHeight, f.mHeight);
+    }
+    else
+    {
+      c.mChild[1] = i_g;
+      a.mChild[1] = i_f;
+      f.mParent = ia;
+      a.mAABB = b.mAABB + f.mAABB;
+      c.mAABB = a.mAABB + g.mAABB;
+      a.mHeight = 1 + std::max(b.mHeight, f.mHeight);
+      c.mHeight = 1 + std::max(a.mHeight, g.mHeight);
+    }
+    return ic;
+  }
+
+  if ( diff < -1 )
+  {
+    // rotate b up
+    const int i_d = b.mChild[0];
+    const int i_e = b.mChild[1];
+    Node& d = mNodes[i_d];
+    Node& e = mNodes[i_e];
+
+    b.mChild[0] = ia;
+    b.mParent = a.mParent;
+    a.mParent = ib;
+
+    if ( b.mParent != -1 )
+    {
+      if ( mNodes[b.mParent].mChild[0] == ia )
+        mNodes[b.mParent].mChild[0] = ib;
+      else
+        mNodes[b.mParent].mChild[1] = ib;
+    }
+    else
+      mRoot = ib;
+
+    if ( d.mHeight > e.mHeight )
+    {
+      b.mChild[1] = i_d;
+      a.mChild[0] = i_e;
+      e.mParent = ia;
+      a.mAABB = c.mAABB + e.mAABB;
+      b.mAABB = a.mAABB + d.mAABB;
+      a.mHeight = 1 + std::max(c.mHeight, e.mHeight);
+      b.mHeight = 1 + std::max(a.mHeight, d.mHeight);
+    }
+    else
+    {
+      b.mChild[1] = i_e;
+      a.mChild[0] = i_d;
+      d.mParent = ia;
+      a.mAABB = c.mAABB + d.mAABB;
+      b.mAABB = a.mAABB + e.mAABB;
+      a.mHeight = 1 + std::max(c.mHeight, d.mHeight);
+      b.mHeight = 1 + std::max(a.mHeight, e.mHeight);
+    }
+    return ib;
+  }
+
+  return ia;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,175 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef SceneManagerDynamicBVH_INCLUDE_ONCE
+#define SceneManagerDynamicBVH_INCLUDE_ONCE
+
+#include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlCore/Sphere.hpp>
+#include <map>
+#include <vector>
+
+namespace vl
+{
+  class Frustum;
+
+//-------------------------------------------------------------------------------------------------------------------------------------------
+// SceneManagerDynamicBVH
+//-------------------------------------------------------------------------------------------------------------------------------------------
+  /**
+   * A SceneManager based on a dynamic AABB tree which supports inserting, removing and moving Actors in O(log n).
+   *
+   * Each Actor is stored in a leaf whose bounding box is "fat", ie. enlarged by fatMargin() times the Actor's longest side,
+   * so that an Actor moving by small amounts does not need to be reinserted every frame. When an Actor leaves its fat box
+   * its leaf is removed and reinserted, the sibling being chosen by the increase in surface area it causes, and the
+   * tree is kept balanced by means of AVL-like rotations.
+   *
+   * Unlike SceneManagerActorKdTree no rebuild is ever needed: moved Actors are detected by updateActors(), which is called
+   * automatically by extractVisibleActors() if autoUpdate() is enabled, or can be notified one by one by updateActor().
+   * Actors with a null bounding box are never culled.
+   *
+   * \sa
+   * - Actor
+   * - ActorKdTree
+   * - ActorTree
+   * - SceneManager
+   * - SceneManagerActorKdTree
+   * - SceneManagerActorTree
+   * - SceneManagerPortals
+   */
+  class VLGRAPHICS_EXPORT SceneManagerDynamicBVH: public SceneManager
+  {
+    VL_INSTRUMENT_CLASS(vl::SceneManagerDynamicBVH, SceneManager)
+
+  public:
+    //! Constructor.
+    SceneManagerDynamicBVH();
+
+    virtual void extractActors(ActorCollection& list);
+
+    virtual void extractVisibleActors(ActorCollection& list, const Camera* camera);
+
+    //! Inserts an Actor in the tree, does nothing if the Actor is already present.
+    void insertActor(Actor* actor);
+
+    //! Removes an Actor from the tree, returns \p false if the Actor was not found.
+    bool removeActor(Actor* actor);
+
+    //! Returns \p true if the given Actor belongs to the scene manager.
+    bool hasActor(Actor* actor) const { return mProxies.find(actor) != mProxies.end(); }
+
+    //! Recomputes the bounds of the given Actor and reinserts it if it moved out of its fat bounding box.
+    //! Returns \p true if the Actor has been reinserted.
+    bool updateActor(Actor* actor);
+
+    //! Calls updateActor() for every Actor in the tree and returns the number of reinserted Actors.
+    int updateActors();
+
+    //! Removes all the Actors.
+    void clear();
+
+    /**
+     * Appends to \p list the enabled Actors whose bounding box intersects the given box.
+     * The tree is used as it was left by the last updateActors() or updateActor(): call updateActors() first if autoUpdate() is
+     * enabled and the Actors moved since the last extractVisibleActors(). Actors with a null bounding box are never returned.
+     */
+    void extractActorsInBox(ActorCollection& list, const AABB& box);
+
+    //! Appends to \p list the enabled Actors whose bounding box intersects the given sphere. \see extractActorsInBox()
+    void extractActorsInSphere(ActorCollection& list, const Sphere& sphere);
+
+    /**
+     * Appends to \p list the \p k enabled Actors whose bounding box is nearest to \p point, sorted by increasing distance.
+     * If \p max_distance is not negative the Actors farther than \p max_distance are ignored. \see extractActorsInBox()
+     */
+    void extractNearestActors(ActorCollection& list, const vec3& point, int k, real max_distance=-1);
+
+    //! The number of Actors contained in the scene manager.
+    int actorCount() const { return (int)mProxies.size(); }
+
+    //! The height of the tree, 0 if the tree is empty or contains a single Actor.
+    int treeHeight() const { return mRoot == -1 ? 0 : mNodes[mRoot].mHeight; }
+
+    //! The fraction of an Actor's longest side by which its leaf's bounding box is enlarged (default is 0.1).
+    //! Affects only the Actors inserted or reinserted after the call.
+    void setFatMargin(real margin) { mFatMargin = margin; }
+    //! The fraction of an Actor's longest side by which its leaf's bounding box is enlarged (default is 0.1).
+    real fatMargin() const { return mFatMargin; }
+
+    //! If \p true (default) extractVisibleActors() calls updateActors() before culling.
+    //! Disable it if you notify the moved Actors yourself using updateActor().
+    void setAutoUpdate(bool on) { mAutoUpdate = on; }
+    //! If \p true (default) extractVisibleActors() calls updateActors() before culling.
+    bool autoUpdate() const { return mAutoUpdate; }
+
+  protected:
+    struct Node
+    {
+      Node(): mParent(-1), mHeight(-1), mLastCulledPlane(-1) { mChild[0] = mChild[1] = -1; }
+      bool isLeaf() const { return mChild[0] == -1; }
+
+      AABB mAABB;
+      ref<Actor> mActor;
+      int mParent; // next free node when the node is not used
+      int mChild[2];
+      int mHeight; // -1 when the node is not used
+      int mLastCulledPlane;
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    void fixUpwards(int node);
+    AABB fatAABB(const AABB& aabb) const;
+    void extractVisible(int node, ActorCollection& list, const Frustum& frustum, u32 plane_mask);
+    void extractInBox(int node, ActorCollection& list, const AABB& box);
+    void extractInSphere(int node, ActorCollection& list, const vec3& center, real radius2);
+    // max-heap of the k nearest Actors found so far, keyed by squared distance
+    typedef std::vector< std::pair<real, Actor*> > NearestHeap;
+    void extractNearest(int node, NearestHeap& heap, const vec3& point, int k, real max_dist2);
+
+  protected:
+    std::vector<Node> mNodes;
+    // maps each Actor to its leaf, -1 for the Actors with a null bounding box which are kept in mUnboundedActors
+    std::map<Actor*, int> mProxies;
+    ActorCollection mUnboundedActors;
+    int mRoot;
+    int mFreeList;
+    real mFatMargin;
+    bool mAutoUpdate;
+  };
+}
+
+#endif
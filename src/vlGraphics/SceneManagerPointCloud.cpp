@@ -0,0 +1,546 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/SceneManagerPointCloud.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <cmath>
+#include <cstring>
+
+using namespace vl;
+
+namespace
+{
+  const unsigned int PointCloudFileVersion = 1;
+  const unsigned int PointCloudFileColors  = 1;
+
+  bool lessRecentlyUsed(const std::pair<unsigned, int>& a, const std::pair<unsigned, int>& b) { return a.first < b.first; }
+
+  AABB octantCube(const AABB& cube, int octant)
+  {
+    const vec3 c = cube.center();
+    AABB aabb;
+    aabb.setMinCorner( octant & 1 ? c.x() : cube.minCorner().x(), octant & 2 ? c.y() : cube.minCorner().y(), octant & 4 ? c.z() : cube.minCorner().z() );
+    aabb.setMaxCorner( octant & 1 ? cube.maxCorner().x() : c.x(), octant & 2 ? cube.maxCorner().y() : c.y(), octant & 4 ? cube.maxCorner().z() : c.z() );
+    return aabb;
+  }
+
+  int octantOf(const AABB& cube, const fvec3& p)
+  {
+    const vec3 c = cube.center();
+    return (p.x() >= c.x() ? 1 : 0) | (p.y() >= c.y() ? 2 : 0) | (p.z() >= c.z() ? 4 : 0);
+  }
+
+  bool writeNode(const String& path, const std::vector<fvec3>& points, const std::vector<ubvec4>* colors, const std::vector<int>& indices, const AABB& cube, int child_mask)
+  {
+    ref<DiskFile> file = new DiskFile(path);
+    if ( !file->open(OM_WriteOnly) )
+    {
+      Log::error( Say("PointCloudFiles: could not write '%s'.\n") << path );
+      return false;
+    }
+
+    std::vector<fvec3> pos( indices.size() );
+    for(size_t i=0; i<indices.size(); ++i)
+      pos[i] = points[ indices[i] ];
+    const float bounds[] = {
+      (float)cube.minCorner().x(), (float)cube.minCorner().y(), (float)cube.minCorner().z(),
+      (float)cube.maxCorner().x(), (float)cube.maxCorner().y(), (float)cube.maxCorner().z()
+    };
+
+    bool ok = file->write("VLPC", 4) == 4;
+    file->writeUInt32( PointCloudFileVersion );
+    file->writeUInt32( (unsigned int)indices.size() );
+    file->writeUInt32( child_mask );
+    file->writeUInt32( colors ? PointCloudFileColors : 0 );
+    file->writeFloat( bounds, 6 );
+    if ( !pos.empty() )
+      ok &= file->writeFloat( pos[0].ptr(), pos.size() * 3 ) == (long long)(pos.size() * 3 * sizeof(float));
+    if ( colors && !indices.empty() )
+    {
+      std::vector<ubvec4> col( indices.size() );
+      for(size_t i=0; i<indices.size(); ++i)
+        col[i] = (*colors)[ indices[i] ];
+      ok &= file->write( col[0].ptr(), col.size() * 4 ) == (long long)(col.size() * 4);
+    }
+    file->close();
+
+    if (!ok)
+      Log::error( Say("PointCloudFiles: could not write '%s'.\n") << path );
+    return ok;
+  }
+
+  bool buildNode(const std::vector<fvec3>& points, const std::vector<ubvec4>* colors, std::vector<int>& indices, const AABB& cube,
+                 const String& name, const String& pattern, int max_node_points, int depth, int max_depth, int& node_count)
+  {
+    // keeps the first point falling in each cell of a grid over the cube, the others go to the children
+    std::vector<int> kept;
+    std::vector<int> children[8];
+    if ( (int)indices.size() <= max_node_points || depth >= max_depth )
+      kept.swap(indices);
+    else
+    {
+      const int grid = std::max( 1, (int)std::pow( (double)max_node_points, 1.0 / 3.0 ) );
+      const vec3 cell_size = (cube.maxCorner() - cube.minCorner()) / (real)grid;
+      std::vector<bool> occupied( grid * grid * grid, false );
+      for(size_t i=0; i<indices.size(); ++i)
+      {
+        const fvec3& p = points[ indices[i] ];
+        int cell = 0;
+        for(int k=2; k>=0; --k)
+        {
+          int c = cell_size[k] > 0 ? (int)( (p[k] - cube.minCorner()[k]) / cell_size[k] ) : 0;
+          cell = cell * grid + clamp(c, 0, grid-1);
+        }
+        if ( !occupied[cell] && (int)kept.size() < max_node_points )
+        {
+          occupied[cell] = true;
+          kept.push_back( indices[i] );
+        }
+        else
+          children[ octantOf(cube, p) ].push_back( indices[i] );
+      }
+      std::vector<int>().swap(indices);
+    }
+
+    int child_mask = 0;
+    for(int i=0; i<8; ++i)
+      child_mask |= children[i].empty() ? 0 : 1 << i;
+
+    String path = pattern;
+    path.replace( "{node}", name );
+    if ( !writeNode(path, points, colors, kept, cube, child_mask) )
+      return false;
+    ++node_count;
+
+    for(int i=0; i<8; ++i)
+    {
+      if ( !children[i].empty() && !buildNode(points, colors, children[i], octantCube(cube, i), name + String::fromInt(i), pattern, max_node_points, depth+1, max_depth, node_count) )
+        return false;
+    }
+    return true;
+  }
+}
+//-----------------------------------------------------------------------------
+// PointCloudFiles
+//-----------------------------------------------------------------------------
+ref<Geometry> PointCloudFiles::loadNode(const String& name, AABB& bounds, int& child_mask)
+{
+  String path = pattern();
+  path.replace( "{node}", name );
+
+  ref<VirtualFile> file = directory() ? directory()->file(path) : locateFile(path);
+  if ( !file || !file->open(OM_ReadOnly) )
+    return NULL;
+
+  char signature[4] = { 0, 0, 0, 0 };
+  file->read(signature, 4);
+  const unsigned int version     = file->readUInt32();
+  const unsigned int point_count = file->readUInt32();
+  const unsigned int mask        = file->readUInt32();
+  const unsigned int flags       = file->readUInt32();
+  float b[6];
+  file->readFloat(b, 6);
+
+  const long long header_size  = 4 + 4*4 + 6*4;
+  const long long point_size   = 3*4 + (flags & PointCloudFileColors ? 4 : 0);
+  if ( memcmp(signature, "VLPC", 4) != 0 || version != PointCloudFileVersion || file->size() < header_size + point_size * point_count )
+  {
+    Log::error( Say("PointCloudFiles: '%s' is not a valid point cloud node.\n") << file->path() );
+    file->close();
+    return NULL;
+  }
+
+  ref<ArrayFloat3> verts = new ArrayFloat3;
+  verts->resize(point_count);
+  if (point_count)
+    file->readFloat( (float*)verts->ptr(), point_count * 3 );
+
+  ref<ArrayUByte4> colors;
+  if ( flags & PointCloudFileColors )
+  {
+    colors = new ArrayUByte4;
+    colors->resize(point_count);
+    if (point_count)
+      file->read( colors->ptr(), point_count * 4 );
+  }
+  file->close();
+
+  ref<Geometry> geom = new Geometry;
+  geom->setVertexArray( verts.get() );
+  if (colors)
+    geom->setColorArray( colors.get() );
+  geom->drawCalls().push_back( new DrawArrays(PT_POINTS, 0, point_count) );
+
+  bounds.setMinCorner( b[0], b[1], b[2] );
+  bounds.setMaxCorner( b[3], b[4], b[5] );
+  child_mask = mask & 0xFF;
+  return geom;
+}
+//-----------------------------------------------------------------------------
+int PointCloudFiles::buildOctree(const std::vector<fvec3>& points, const std::vector<ubvec4>* colors, const String& pattern, int max_node_points, int max_depth)
+{
+  if ( points.empty() || max_node_points < 1 || (colors && colors->size() != points.size()) )
+  {
+    Log::error("PointCloudFiles::buildOctree(): invalid parameters.\n");
+    return 0;
+  }
+
+  // the root is the cube enclosing all the points
+  AABB aabb;
+  for(size_t i=0; i<points.size(); ++i)
+    aabb.addPoint( (vec3)points[i] );
+  const real side = std::max( aabb.longestSideLength(), (real)1e-6 );
+  AABB cube;
+  cube.setMinCorner( aabb.center() - vec3(side, side, side) * (real)0.5 );
+  cube.setMaxCorner( aabb.center() + vec3(side, side, side) * (real)0.5 );
+
+  std::vector<int> indices( points.size() );
+  for(size_t i=0; i<points.size(); ++i)
+    indices[i] = (int)i;
+
+  int node_count = 0;
+  if ( !buildNode(points, colors, indices, cube, "r", pattern, max_node_points, 0, max_depth, node_count) )
+    return 0;
+  return node_count;
+}
+//-----------------------------------------------------------------------------
+// SceneManagerPointCloud
+//-----------------------------------------------------------------------------
+SceneManagerPointCloud::SceneManagerPointCloud():
+  mLoadMutex(NULL), mMinNodePixelSize(32.0f), mPointSize(2.0f), mPointBudget(2000000), mNodeCacheSize(1024),
+  mMaxLoadsPerFrame(2), mMaxUploadsPerFrame(8), mFrame(0), mStatsSelectedPoints(0), mStatsCachedNodes(0), mStatsPendingNodes(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+}
+//-----------------------------------------------------------------------------
+bool SceneManagerPointCloud::init()
+{
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.clear();
+    mLoadedNodes.clear();
+  }
+  mNodes.clear();
+  mSelected.clear();
+  mRootCube = AABB();
+  mStatsSelectedPoints = 0;
+  mStatsCachedNodes = 0;
+  mStatsPendingNodes = 0;
+
+  if (!nodeSource())
+  {
+    Log::error("SceneManagerPointCloud initialization failed: no node source.\n");
+    return false;
+  }
+
+  mEffect = new Effect;
+  mEffect->shader()->enable(EN_DEPTH_TEST);
+  mEffect->shader()->gocPointSize()->set( pointSize() );
+
+  if (!mPool)
+  {
+    mPool = new BufferObjectPool;
+    mPool->setPageSize( 16 * 1024 * 1024 );
+    mPool->setMaxAllocationSize( 16 * 1024 * 1024 );
+  }
+
+  // the root is loaded synchronously, it defines the cube of the whole octree
+  ref<Node> root = new Node( "r", AABB() );
+  loadNode( root.get() );
+  if ( !root->mGeometry )
+  {
+    Log::error("SceneManagerPointCloud initialization failed: could not load the root node.\n");
+    return false;
+  }
+  mRootCube = root->mCube;
+  mNodes[ root->mName ] = root;
+  {
+    ScopedMutex lock(mLoadMutex);
+    root->mState = NS_Loaded;
+    mLoadedNodes.push_back( root.get() );
+  }
+  finalizeLoadedNodes();
+
+  computeBounds();
+  return true;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::computeBounds()
+{
+  setBoundingBox(mRootCube);
+  setBoundingSphere(mRootCube);
+  setBoundsDirty(false);
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::extractActors(ActorCollection& list)
+{
+  for(int i=0; i<mSelected.size(); ++i)
+    list.push_back( mSelected[i].get() );
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::extractVisibleActors(ActorCollection& list, const Camera* camera)
+{
+  // without a camera no LOD selection can be made
+  if (!camera || !camera->viewport())
+  {
+    extractActors(list);
+    return;
+  }
+
+  ++mFrame;
+
+  // synchronous loading
+  if (!mLoadMutex)
+    processLoadRequests( maxLoadsPerFrame() );
+
+  finalizeLoadedNodes();
+  selectNodes(camera);
+  cancelUnusedRequests();
+  evictNodes();
+
+  for(int i=0; i<mSelected.size(); ++i)
+  {
+    if ( isEnabled(mSelected[i].get()) )
+      list.push_back( mSelected[i].get() );
+  }
+}
+//-----------------------------------------------------------------------------
+SceneManagerPointCloud::Node* SceneManagerPointCloud::acquireNode(const String& name, const AABB& cube)
+{
+  ref<Node>& node = mNodes[name];
+  if (!node)
+  {
+    node = new Node(name, cube);
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.push_back( node.get() );
+  }
+  node->mLastUsedFrame = mFrame;
+  return node.get();
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::selectNodes(const Camera* camera)
+{
+  mSelected.clear();
+  mStatsSelectedPoints = 0;
+
+  std::map< String, ref<Node> >::iterator root = mNodes.find("r");
+  if ( root == mNodes.end() || root->second->mState != NS_Ready )
+    return;
+  root->second->mLastUsedFrame = mFrame;
+  if ( cullingEnabled() && camera->frustum().cull(mRootCube) )
+    return;
+
+  // converts a length at unit distance to pixels
+  const real proj_factor = camera->projectionMatrix().e(1,1) * camera->viewport()->height() * (real)0.5;
+  const vec3 eye = camera->modelingMatrix().getT();
+
+  // the nodes are visited by decreasing projected size, the children of a node becoming candidates once it is selected
+  std::priority_queue<Candidate> queue;
+  queue.push( Candidate(root->first, mRootCube, 0) );
+  while( !queue.empty() )
+  {
+    const Candidate candidate = queue.top();
+    queue.pop();
+
+    // missing nodes are requested with their priority
+    Node* node = acquireNode( candidate.mName, candidate.mCube );
+    node->mPriority = candidate.mPriority;
+    if ( node->mState != NS_Ready )
+      continue;
+    if ( mStatsSelectedPoints + node->mPointCount > pointBudget() )
+      break;
+
+    mSelected.push_back( node->mActor.get() );
+    mStatsSelectedPoints += node->mPointCount;
+
+    for(int i=0; i<8; ++i)
+    {
+      if ( !(node->mChildMask & (1 << i)) )
+        continue;
+      const AABB cube = octantCube(node->mCube, i);
+      if ( cullingEnabled() && camera->frustum().cull(cube) )
+        continue;
+
+      const real radius = (cube.maxCorner() - cube.minCorner()).length() * (real)0.5;
+      const real distance = std::max( (cube.center() - eye).length(), (real)1e-6 );
+      const real pixel_size = radius * proj_factor / distance;
+      if ( pixel_size < minNodePixelSize() )
+        continue;
+
+      queue.push( Candidate(node->mName + String::fromInt(i), cube, pixel_size) );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool SceneManagerPointCloud::hasLoadRequests() const
+{
+  ScopedMutex lock(mLoadMutex);
+  return !mLoadQueue.empty();
+}
+//-----------------------------------------------------------------------------
+int SceneManagerPointCloud::processLoadRequests(int max_count)
+{
+  int count = 0;
+  for( ; count<max_count; ++count)
+  {
+    Node* node = NULL;
+    {
+      ScopedMutex lock(mLoadMutex);
+      if (mLoadQueue.empty())
+        break;
+      node = mLoadQueue.front();
+      mLoadQueue.pop_front();
+      node->mState = NS_Loading;
+    }
+
+    // no lock needed: the rendering thread does not touch the nodes being loaded
+    loadNode(node);
+
+    {
+      ScopedMutex lock(mLoadMutex);
+      node->mState = node->mGeometry ? NS_Loaded : NS_Failed;
+      if (node->mGeometry)
+        mLoadedNodes.push_back(node);
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::loadNode(Node* node)
+{
+  AABB cube;
+  int child_mask = 0;
+  ref<Geometry> geom = nodeSource()->loadNode(node->mName, cube, child_mask);
+  if ( !geom || !geom->vertexArray() )
+  {
+    Log::warning( Say("SceneManagerPointCloud: node '%s' not available.\n") << node->mName );
+    return;
+  }
+
+  // the cube of the other nodes is derived from the root's
+  if ( node->mName == "r" )
+    node->mCube = cube;
+  node->mChildMask = child_mask;
+  node->mPointCount = (int)geom->vertexArray()->size();
+  node->mGeometry = geom;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::finalizeLoadedNodes()
+{
+  std::vector<Node*> nodes;
+  {
+    ScopedMutex lock(mLoadMutex);
+    const int count = std::min( (int)mLoadedNodes.size(), maxUploadsPerFrame() );
+    nodes.assign( mLoadedNodes.begin(), mLoadedNodes.begin() + count );
+    mLoadedNodes.erase( mLoadedNodes.begin(), mLoadedNodes.begin() + count );
+  }
+
+  for(size_t i=0; i<nodes.size(); ++i)
+  {
+    Node* node = nodes[i];
+    Geometry* geom = node->mGeometry.get();
+
+    // sub-allocates the vertex data from the pool and uploads it now to spread the uploads over the frames
+    geom->vertexArray()->bufferObject()->setPool( mPool.get() );
+    if ( geom->colorArray() )
+      geom->colorArray()->bufferObject()->setPool( mPool.get() );
+    geom->setBufferObjectEnabled(true);
+    geom->updateDirtyBufferObject(BUM_KeepRamBuffer);
+
+    node->mActor = new Actor( geom, mEffect.get() );
+    node->mState = NS_Ready;
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::cancelUnusedRequests()
+{
+  std::vector<Node*> cancelled;
+  {
+    ScopedMutex lock(mLoadMutex);
+    std::vector< std::pair<real, Node*> > queue;
+    for(size_t i=0; i<mLoadQueue.size(); ++i)
+    {
+      if ( mLoadQueue[i]->mLastUsedFrame == mFrame )
+        queue.push_back( std::make_pair( mLoadQueue[i]->mPriority, mLoadQueue[i] ) );
+      else
+        cancelled.push_back( mLoadQueue[i] );
+    }
+    // larger nodes first
+    std::sort( queue.begin(), queue.end(), std::greater< std::pair<real, Node*> >() );
+    mLoadQueue.resize( queue.size() );
+    for(size_t i=0; i<queue.size(); ++i)
+      mLoadQueue[i] = queue[i].second;
+    mStatsPendingNodes = (int)mLoadQueue.size();
+  }
+
+  for(size_t i=0; i<cancelled.size(); ++i)
+    mNodes.erase( cancelled[i]->mName );
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPointCloud::evictNodes()
+{
+  // only the nodes not being loaded can be evicted, the root is always kept
+  std::vector< std::pair<unsigned, int> > candidates;
+  std::vector<Node*> nodes;
+  int resident = 0;
+  for( std::map< String, ref<Node> >::iterator it = mNodes.begin(); it != mNodes.end(); ++it )
+  {
+    Node* node = it->second.get();
+    if ( node->mState == NS_Ready || node->mState == NS_Failed )
+    {
+      ++resident;
+      if ( node->mLastUsedFrame != mFrame && node->mName != "r" )
+      {
+        candidates.push_back( std::make_pair(node->mLastUsedFrame, (int)nodes.size()) );
+        nodes.push_back(node);
+      }
+    }
+  }
+
+  if ( resident > nodeCacheSize() )
+  {
+    std::sort( candidates.begin(), candidates.end(), lessRecentlyUsed );
+    for(size_t i=0; i<candidates.size() && resident > nodeCacheSize(); ++i, --resident)
+      mNodes.erase( nodes[ candidates[i].second ]->mName );
+  }
+
+  mStatsCachedNodes = resident;
+}
+//-----------------------------------------------------------------------------
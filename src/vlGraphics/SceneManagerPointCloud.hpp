@@ -0,0 +1,281 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef SceneManagerPointCloud_INCLUDE_ONCE
+#define SceneManagerPointCloud_INCLUDE_ONCE
+
+#include <vlGraphics/SceneManager.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/BufferObjectPool.hpp>
+#include <vlCore/VirtualDirectory.hpp>
+#include <vlCore/IMutex.hpp>
+#include <map>
+#include <deque>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // PointCloudSource
+  //-----------------------------------------------------------------------------
+  /**
+   * Provides the nodes of a SceneManagerPointCloud.
+   *
+   * The point cloud is an octree whose nodes contain a subsampled set of the points of their region, the union of a node and of all
+   * its descendants being the full resolution data. The nodes are named like in Potree: the root is \p "r" and the children of a node
+   * append to its name the digit of their octant, bit 0 of the digit meaning +x, bit 1 meaning +y and bit 2 meaning +z, for example \p "r07".
+   *
+   * \note When SceneManagerPointCloud::processLoadRequests() is called from a worker thread loadNode() is called from that thread.
+   */
+  class VLGRAPHICS_EXPORT PointCloudSource: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::PointCloudSource, Object)
+
+  public:
+    /** Returns a Geometry with a vertex array and optionally a color array containing the points of the given node, NULL if not available.
+      * \param name The name of the node.
+      * \param bounds Receives the cube of the node, only used for the root node.
+      * \param child_mask Receives the bitmask of the existing children, bit \p i meaning the child of octant \p i. */
+    virtual ref<Geometry> loadNode(const String& name, AABB& bounds, int& child_mask) = 0;
+  };
+
+  //-----------------------------------------------------------------------------
+  // PointCloudFiles
+  //-----------------------------------------------------------------------------
+  /**
+   * A PointCloudSource loading each node from a file whose path is generated replacing the string \p "{node}" of a pattern,
+   * for example \p "/cloud/{node}.vlpc". The files are looked up in directory() if one is set, otherwise using the default FileSystem.
+   *
+   * The files are little endian and contain: the signature \p "VLPC", the version (u32, currently 1), the point count, the child mask,
+   * the flags (u32 each, bit 0 meaning that colors are present), the node cube as min and max corner (6 floats), the point positions
+   * (3 floats each) and if present the point colors (4 bytes each). buildOctree() generates them from a set of points.
+   */
+  class VLGRAPHICS_EXPORT PointCloudFiles: public PointCloudSource
+  {
+    VL_INSTRUMENT_CLASS(vl::PointCloudFiles, PointCloudSource)
+
+  public:
+    PointCloudFiles(const String& pattern=String()): mPattern(pattern)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual ref<Geometry> loadNode(const String& name, AABB& bounds, int& child_mask);
+
+    /** Writes the octree of the given points in the files generated from \p pattern, the directories must exist.
+      * Each node keeps up to \p max_node_points points evenly spread over its cube, the others are passed to its children.
+      * \param points The point positions.
+      * \param colors The point colors, either NULL or with the same size as \p points.
+      * \param pattern The path pattern of the files, see PointCloudFiles.
+      * \param max_node_points The maximum number of points of a node.
+      * \param max_depth The depth of the deepest nodes, which keep all their points.
+      * \return The number of nodes written, 0 on error. */
+    static int buildOctree(const std::vector<fvec3>& points, const std::vector<ubvec4>* colors, const String& pattern, int max_node_points=20000, int max_depth=12);
+
+    //! The path pattern of the node files.
+    void setPattern(const String& pattern) { mPattern = pattern; }
+    //! The path pattern of the node files.
+    const String& pattern() const { return mPattern; }
+
+    //! The directory containing the node files, if NULL the default FileSystem is used.
+    void setDirectory(VirtualDirectory* dir) { mDirectory = dir; }
+    //! The directory containing the node files, if NULL the default FileSystem is used.
+    VirtualDirectory* directory() { return mDirectory.get(); }
+
+  protected:
+    String mPattern;
+    ref<VirtualDirectory> mDirectory;
+  };
+
+  //-----------------------------------------------------------------------------
+  // SceneManagerPointCloud
+  //-----------------------------------------------------------------------------
+  /**
+   * A SceneManager rendering a point cloud streamed from a PointCloudSource, allowing point clouds much larger than the available memory.
+   *
+   * Every frame the visible nodes are selected by decreasing projected size, a node being considered only if its parent is,
+   * until pointBudget() points have been selected. Since the nodes are additive both a node and its selected children are rendered.
+   * Nodes projecting to less than minNodePixelSize() pixels are skipped. The missing nodes that would have been selected are requested,
+   * the larger ones first, thus only the root must be loaded before something is displayed.
+   *
+   * All the nodes share the same Effect, see effect(), which renders points of pointSize() pixels with depth test and without lighting,
+   * using the colors of the points if available. The vertex data of the nodes is sub-allocated from the bufferObjectPool().
+   *
+   * \par Loading
+   * Missing nodes are queued and loaded by processLoadRequests(), which only touches CPU data. Without a loadMutex() the scene manager calls
+   * it by itself during the Actor extraction loading up to maxLoadsPerFrame() nodes per frame. For asynchronous loading install a mutex with
+   * setLoadMutex() and call processLoadRequests() from one or more worker threads: the rendering thread then only uploads the vertex data
+   * of up to maxUploadsPerFrame() loaded nodes per frame.
+   * When more than nodeCacheSize() nodes are in memory the ones not used by the current frame are evicted, least recently used first.
+   * \note No thread must be running processLoadRequests() while init() is called or the SceneManagerPointCloud is destroyed.
+   */
+  class VLGRAPHICS_EXPORT SceneManagerPointCloud: public SceneManager
+  {
+    VL_INSTRUMENT_CLASS(vl::SceneManagerPointCloud, SceneManager)
+
+  public:
+    SceneManagerPointCloud();
+
+    //! Discards all the loaded nodes, prepares the shared resources and loads the root node.
+    //! Must be called with an active OpenGL context after setting the node source and when it changes.
+    //! \return False if the root node could not be loaded.
+    bool init();
+
+    virtual void extractVisibleActors(ActorCollection& list, const Camera* camera);
+
+    //! Appends the nodes selected by the last extractVisibleActors().
+    virtual void extractActors(ActorCollection& list);
+
+    virtual void computeBounds();
+
+    /** Loads up to \p max_count queued nodes, larger ones first. Can be called from any thread if a loadMutex() is installed.
+      * \return The number of nodes loaded. */
+    int processLoadRequests(int max_count);
+
+    //! Returns true if there are nodes waiting to be loaded.
+    bool hasLoadRequests() const;
+
+    //! The source of the nodes.
+    void setNodeSource(PointCloudSource* source) { mNodeSource = source; }
+    //! The source of the nodes.
+    PointCloudSource* nodeSource() { return mNodeSource.get(); }
+
+    //! The maximum number of points rendered per frame (default is 2 millions).
+    void setPointBudget(int points) { mPointBudget = points; }
+    //! The maximum number of points rendered per frame (default is 2 millions).
+    int pointBudget() const { return mPointBudget; }
+
+    //! The projected size in pixels below which a node is not rendered (default is 32).
+    void setMinNodePixelSize(float pixels) { mMinNodePixelSize = pixels; }
+    //! The projected size in pixels below which a node is not rendered (default is 32).
+    float minNodePixelSize() const { return mMinNodePixelSize; }
+
+    //! The size in pixels of the points (default is 2).
+    void setPointSize(float pixels) { mPointSize = pixels; if (mEffect) mEffect->shader()->gocPointSize()->set(pixels); }
+    //! The size in pixels of the points (default is 2).
+    float pointSize() const { return mPointSize; }
+
+    //! The maximum number of nodes kept in memory (default is 1024).
+    void setNodeCacheSize(int count) { mNodeCacheSize = count; }
+    //! The maximum number of nodes kept in memory (default is 1024).
+    int nodeCacheSize() const { return mNodeCacheSize; }
+
+    //! The maximum number of nodes loaded per frame when no loadMutex() is installed (default is 2).
+    void setMaxLoadsPerFrame(int count) { mMaxLoadsPerFrame = count; }
+    //! The maximum number of nodes loaded per frame when no loadMutex() is installed (default is 2).
+    int maxLoadsPerFrame() const { return mMaxLoadsPerFrame; }
+
+    //! The maximum number of loaded nodes whose vertex data is uploaded per frame (default is 8).
+    void setMaxUploadsPerFrame(int count) { mMaxUploadsPerFrame = count; }
+    //! The maximum number of loaded nodes whose vertex data is uploaded per frame (default is 8).
+    int maxUploadsPerFrame() const { return mMaxUploadsPerFrame; }
+
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    void setLoadMutex(IMutex* mutex) { mLoadMutex = mutex; }
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    IMutex* loadMutex() { return mLoadMutex; }
+
+    //! The Effect shared by all the nodes, created by init().
+    Effect* effect() { return mEffect.get(); }
+
+    //! The BufferObjectPool the vertex data of the nodes is sub-allocated from.
+    BufferObjectPool* bufferObjectPool() { return mPool.get(); }
+
+    //! The number of nodes selected by the last extractVisibleActors().
+    int statsSelectedNodes() const { return (int)mSelected.size(); }
+    //! The number of points selected by the last extractVisibleActors().
+    int statsSelectedPoints() const { return mStatsSelectedPoints; }
+    //! The number of nodes currently in memory.
+    int statsCachedNodes() const { return mStatsCachedNodes; }
+    //! The number of nodes waiting to be loaded.
+    int statsPendingNodes() const { return mStatsPendingNodes; }
+
+  protected:
+    enum ENodeState { NS_Queued, NS_Loading, NS_Loaded, NS_Ready, NS_Failed };
+
+    class Node: public Object
+    {
+    public:
+      Node(const String& name, const AABB& cube): mName(name), mCube(cube), mState(NS_Queued), mLastUsedFrame(0), mPriority(0), mChildMask(0), mPointCount(0) {}
+      String mName;
+      AABB mCube;
+      ENodeState mState;
+      unsigned mLastUsedFrame;
+      real mPriority;
+      // filled by the loader
+      ref<Geometry> mGeometry;
+      int mChildMask;
+      int mPointCount;
+      // created by the rendering thread
+      ref<Actor> mActor;
+    };
+
+    struct Candidate
+    {
+      Candidate(const String& name, const AABB& cube, real priority): mName(name), mCube(cube), mPriority(priority) {}
+      bool operator<(const Candidate& other) const { return mPriority < other.mPriority; }
+      String mName;
+      AABB mCube;
+      real mPriority;
+    };
+
+    Node* acquireNode(const String& name, const AABB& cube);
+    void selectNodes(const Camera* camera);
+    void loadNode(Node* node);
+    void finalizeLoadedNodes();
+    void cancelUnusedRequests();
+    void evictNodes();
+
+  protected:
+    ref<PointCloudSource> mNodeSource;
+    std::map< String, ref<Node> > mNodes;
+    std::deque<Node*> mLoadQueue;    // protected by mLoadMutex
+    std::vector<Node*> mLoadedNodes; // protected by mLoadMutex
+    ActorCollection mSelected;
+    ref<Effect> mEffect;
+    ref<BufferObjectPool> mPool;
+    AABB mRootCube;
+    IMutex* mLoadMutex;
+    float mMinNodePixelSize;
+    float mPointSize;
+    int mPointBudget;
+    int mNodeCacheSize;
+    int mMaxLoadsPerFrame;
+    int mMaxUploadsPerFrame;
+    unsigned mFrame;
+    int mStatsSelectedPoints;
+    int mStatsCachedNodes;
+    int mStatsPendingNodes;
+  };
+}
+
+#endif
@@ -33,6 +33,8 @@
 #include <vlGraphics/Geometry.hpp>
 #include <vlCore/Say.hpp>
 #include <vlGraphics/Camera.hpp>
+#include <vlCore/math_utils.hpp>
+#include <algorithm>
 
 using namespace vl;
 
@@ -142,13 +144,41 @@ void SceneManagerPortals::extractVisibleActors(ActorCollection& list, const Came
       extractActors(list);
     else
     {
+      const vec3 eye = camera->modelingMatrix().getT();
+
       ++mVisitTick;
       mTempActors.clear();
       mFrustumStack.clear();
+      mRectStack.clear();
 
       mFrustumStack.push_back(camera->frustum());
-      start->executeCallbacks(camera,this,NULL);
-      visitSector(NULL, start, camera->modelingMatrix().getT(), camera);
+      mRectStack.push_back( vec4(-1, -1, 1, 1) );
+      mViewProjMatrix = camera->projectionMatrix() * camera->viewMatrix();
+
+      if ( usePotentiallyVisibleSets() && !start->potentiallyVisibleSet().empty() )
+      {
+        // precomputed visibility
+        std::vector<Sector*> sectors = start->potentiallyVisibleSet();
+        sectors.push_back(start);
+        for(unsigned i=0; i<sectors.size(); ++i)
+          sectors[i]->executeCallbacks(camera,this,NULL);
+        cullSectors(sectors);
+      }
+      else
+      if ( visibilityCacheThreshold() >= 0 )
+      {
+        // cached visibility
+        if ( !isVisibilityCacheValid(start, eye) )
+          recordVisibleSectors(start, eye);
+        for(unsigned i=0; i<mVisitCacheCallbacks.size(); ++i)
+          mVisitCacheCallbacks[i].first->executeCallbacks(camera,this,mVisitCacheCallbacks[i].second);
+        cullSectors(mVisitCacheSectors);
+      }
+      else
+      {
+        visitCallbacks(camera, start, NULL);
+        visitSector(NULL, start, eye, camera);
+      }
 
       // remove duplicates
       std::sort(mTempActors.begin(), mTempActors.end());
@@ -161,71 +191,256 @@ void SceneManagerPortals::extractVisibleActors(ActorCollection& list, const Came
     extractActors(list);
 }
 //-----------------------------------------------------------------------------
-void SceneManagerPortals::visitSector(Sector* prev, Sector* sector, const vec3& eye, const Camera* camera)
+void SceneManagerPortals::visitCallbacks(const Camera* camera, Sector* sector, Portal* portal)
 {
-  // this sector is visible so we add the visible objects
+  if (mRecording)
+    mVisitCacheCallbacks.push_back( std::make_pair(sector, portal) );
+  else
+    sector->executeCallbacks(camera,this,portal);
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::cullSectorActors(Sector* sector)
+{
+  // with screen-space narrowing the top frustum is contained in all the others
+  const unsigned first = screenSpaceNarrowing() ? (unsigned)mFrustumStack.size() - 1 : 0;
   for(int j=0; j<sector->actors()->size(); ++j)
   {
     if (isEnabled(sector->actors()->at(j)))
     {
       sector->actors()->at(j)->computeBounds();
       bool visible = true;
-      for(unsigned i=0; visible && i<mFrustumStack.size(); ++i)
+      for(unsigned i=first; visible && i<mFrustumStack.size(); ++i)
         visible = visible & !mFrustumStack[i].cull( sector->actors()->at(j)->boundingBox() );
       if( visible )
         mTempActors.push_back( sector->actors()->at(j) );
     }
   }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::cullSectors(const std::vector<Sector*>& sectors)
+{
+  for(unsigned i=0; i<sectors.size(); ++i)
+  {
+    cullSectorActors(sectors[i]);
+    if(showPortals())
+    {
+      for(unsigned j=0; j<sectors[i]->portals().size(); ++j)
+        renderPortal(sectors[i]->portals()[j].get());
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::visitSector(Sector* prev, Sector* sector, const vec3& eye, const Camera* camera)
+{
+  // while recording the visible sectors there is no camera frustum to cull against
+  const bool narrowing = screenSpaceNarrowing() && !mRecording;
+
+  // this sector is visible so we add the visible objects
+  if (mRecording)
+    mVisitCacheSectors.push_back(sector);
+  else
+    cullSectorActors(sector);
+
   // check the visible portals
   for(unsigned j=0; j<sector->portals().size(); ++j)
   {
-    if(showPortals())
-      renderPortal(sector->portals()[j].get());
+    Portal* portal = sector->portals()[j].get();
+
+    if(showPortals() && !mRecording)
+      renderPortal(portal);
+
+    // the cached visibility depends on the state of all the portals met
+    if (mRecording)
+      mVisitCachePortals.push_back( std::make_pair(portal, portal->isOpen()) );
 
     // open/closed portals.
-    if(!sector->portals()[j]->isOpen())
+    if(!portal->isOpen() && !mIgnorePortalState)
       continue;
 
-    if (sector->portals()[j]->mVisitTick == mVisitTick)
+    if (portal->mVisitTick == mVisitTick)
       continue;
     else
-      sector->portals()[j]->mVisitTick = mVisitTick;
+      portal->mVisitTick = mVisitTick;
 
-    Sector* target_sec = sector->portals()[j]->targetSector();
+    Sector* target_sec = portal->targetSector();
     VL_CHECK(target_sec != sector)
     if ( target_sec != prev )
     {
       bool visible = true;
-      for(unsigned i=0; visible && i<mFrustumStack.size(); ++i)
-        visible = visible & !mFrustumStack[i].cull( sector->portals()[j]->geometry() );
+      for(unsigned i=narrowing ? (unsigned)mFrustumStack.size()-1 : 0; visible && i<mFrustumStack.size(); ++i)
+        visible = visible & !mFrustumStack[i].cull( portal->geometry() );
 
+      Frustum portal_frustum;
+      vec4 rect;
+      if (visible && narrowing)
+        visible = narrowFrustum(portal, portal_frustum, rect);
+      else
       if (visible)
       {
         // make visiting_portal_frustum
-        Frustum portal_frustum;
-        portal_frustum.planes().resize(sector->portals()[j]->geometry().size());
-        bool flip = dot((fvec3)eye - sector->portals()[j]->geometry()[0], sector->portals()[j]->normal()) < 0;
-        for(unsigned i=0; i<sector->portals()[j]->geometry().size(); ++i)
+        portal_frustum.planes().resize(portal->geometry().size());
+        bool flip = dot((fvec3)eye - portal->geometry()[0], portal->normal()) < 0;
+        for(unsigned i=0; i<portal->geometry().size(); ++i)
         {
-          int i2 = (i+1) % sector->portals()[j]->geometry().size();
-          vec3 v1 = (vec3)sector->portals()[j]->geometry()[i]  - eye;
-          vec3 v2 = (vec3)sector->portals()[j]->geometry()[i2] - eye;
+          int i2 = (i+1) % portal->geometry().size();
+          vec3 v1 = (vec3)portal->geometry()[i]  - eye;
+          vec3 v2 = (vec3)portal->geometry()[i2] - eye;
           vec3 n = cross(v1,v2);
           n.normalize();
           if (flip)
             n = -n;
           portal_frustum.setPlane(i, Plane(dot(n,eye),n));
         }
+        rect = mRecording ? vec4(-1, -1, 1, 1) : mRectStack.back();
+      }
 
+      if (visible)
+      {
         mFrustumStack.push_back(portal_frustum);
-        sector->executeCallbacks(camera,this,sector->portals()[j].get());
-        visitSector(sector, sector->portals()[j]->targetSector(), eye, camera);
+        mRectStack.push_back(rect);
+        visitCallbacks(camera, sector, portal);
+        visitSector(sector, target_sec, eye, camera);
+        mRectStack.pop_back();
         mFrustumStack.pop_back();
       }
     }
   }
 }
 //-----------------------------------------------------------------------------
+bool SceneManagerPortals::narrowFrustum(const Portal* portal, Frustum& frustum, vec4& rect) const
+{
+  // normalized device coordinates bounds of the portal clipped against the near plane
+  real min_x =  1, min_y =  1;
+  real max_x = -1, max_y = -1;
+  bool empty = true;
+  const std::vector<fvec3>& geom = portal->geometry();
+  for(unsigned i=0; i<geom.size(); ++i)
+  {
+    vec4 p = mViewProjMatrix * vec4( (vec3)geom[i], 1 );
+    vec4 q = mViewProjMatrix * vec4( (vec3)geom[(i+1) % geom.size()], 1 );
+    const real dp = p.z() + p.w();
+    const real dq = q.z() + q.w();
+    vec4 pts[2];
+    int count = 0;
+    if (dp >= 0)
+      pts[count++] = p;
+    if ( (dp >= 0) != (dq >= 0) )
+      pts[count++] = p + (q - p) * (dp / (dp - dq));
+    for(int k=0; k<count; ++k)
+    {
+      if (pts[k].w() <= 0)
+        continue;
+      const real x = pts[k].x() / pts[k].w();
+      const real y = pts[k].y() / pts[k].w();
+      if (empty)
+      {
+        min_x = max_x = x;
+        min_y = max_y = y;
+        empty = false;
+      }
+      else
+      {
+        min_x = x < min_x ? x : min_x; max_x = x > max_x ? x : max_x;
+        min_y = y < min_y ? y : min_y; max_y = y > max_y ? y : max_y;
+      }
+    }
+  }
+  if (empty)
+    return false;
+
+  // intersect with the rectangle of the portal we are looking through
+  const vec4& parent = mRectStack.back();
+  rect = vec4( max(min_x, parent.x()), max(min_y, parent.y()), min(max_x, parent.z()), min(max_y, parent.w()) );
+  if ( rect.x() >= rect.z() || rect.y() >= rect.w() )
+    return false;
+
+  // remaps the rectangle to the whole clip space and extracts the planes
+  mat4 narrow;
+  narrow.e(0,0) = 2 / (rect.z() - rect.x());
+  narrow.e(0,3) = -(rect.z() + rect.x()) / (rect.z() - rect.x());
+  narrow.e(1,1) = 2 / (rect.w() - rect.y());
+  narrow.e(1,3) = -(rect.w() + rect.y()) / (rect.w() - rect.y());
+  frustum.planes().resize(6);
+  extractPlanes( &frustum.planes()[0], narrow * mViewProjMatrix );
+  return true;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::recordVisibleSectors(Sector* start, const vec3& eye)
+{
+  mVisitCacheSectors.clear();
+  mVisitCacheCallbacks.clear();
+  mVisitCachePortals.clear();
+
+  // discover the sectors visible in all directions
+  std::vector<Frustum> frustum_stack;
+  std::vector<vec4> rect_stack;
+  frustum_stack.swap(mFrustumStack);
+  rect_stack.swap(mRectStack);
+  ++mVisitTick;
+  mRecording = true;
+  visitCallbacks(NULL, start, NULL);
+  visitSector(NULL, start, eye, NULL);
+  mRecording = false;
+  frustum_stack.swap(mFrustumStack);
+  rect_stack.swap(mRectStack);
+
+  std::sort(mVisitCacheSectors.begin(), mVisitCacheSectors.end());
+  mVisitCacheSectors.erase( std::unique(mVisitCacheSectors.begin(), mVisitCacheSectors.end()), mVisitCacheSectors.end() );
+
+  mVisitCacheSector = start;
+  mVisitCacheEye = eye;
+  mVisitCacheValid = true;
+}
+//-----------------------------------------------------------------------------
+bool SceneManagerPortals::isVisibilityCacheValid(Sector* start, const vec3& eye) const
+{
+  if ( !mVisitCacheValid || mVisitCacheSector != start || (eye - mVisitCacheEye).length() > visibilityCacheThreshold() )
+    return false;
+  for(unsigned i=0; i<mVisitCachePortals.size(); ++i)
+  {
+    if ( mVisitCachePortals[i].first->isOpen() != mVisitCachePortals[i].second )
+      return false;
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::computePotentiallyVisibleSets(int samples)
+{
+  VL_CHECK(samples > 0)
+  mIgnorePortalState = true;
+  for(unsigned i=0; i<mSectors.size(); ++i)
+  {
+    Sector* sector = mSectors[i].get();
+    std::vector<Sector*> pvs;
+    for(unsigned j=0; j<sector->volumes().size(); ++j)
+    {
+      const AABB& volume = sector->volumes()[j];
+      for(int x=0; x<samples; ++x)
+      for(int y=0; y<samples; ++y)
+      for(int z=0; z<samples; ++z)
+      {
+        vec3 t( (x + (real)0.5) / samples, (y + (real)0.5) / samples, (z + (real)0.5) / samples );
+        vec3 eye = volume.minCorner() + (volume.maxCorner() - volume.minCorner()) * t;
+        recordVisibleSectors(sector, eye);
+        pvs.insert( pvs.end(), mVisitCacheSectors.begin(), mVisitCacheSectors.end() );
+      }
+    }
+    std::sort(pvs.begin(), pvs.end());
+    pvs.erase( std::unique(pvs.begin(), pvs.end()), pvs.end() );
+    pvs.erase( std::remove(pvs.begin(), pvs.end(), sector), pvs.end() );
+    sector->potentiallyVisibleSet() = pvs;
+  }
+  mIgnorePortalState = false;
+  invalidateVisibilityCache();
+}
+//-----------------------------------------------------------------------------
+void SceneManagerPortals::clearPotentiallyVisibleSets()
+{
+  for(unsigned i=0; i<mSectors.size(); ++i)
+    mSectors[i]->potentiallyVisibleSet().clear();
+  mExternalSector->potentiallyVisibleSet().clear();
+}
+//-----------------------------------------------------------------------------
 void SceneManagerPortals::computePortalNormals()
 {
   for(unsigned i=0; i<mSectors.size(); ++i)
@@ -161,11 +161,18 @@ namespace vl
     const std::vector< ref<VisibilityCallback> >& callbacks() const { return mCallbacks; }
     void executeCallbacks(const Camera*cam,SceneManagerPortals* psm, Portal*p);
 
+    //! The Sectors that can be seen from some point inside this Sector, not including this Sector.
+    //! Usually computed offline using SceneManagerPortals::computePotentiallyVisibleSets() and saved along with the scene using VLX.
+    std::vector<Sector*>& potentiallyVisibleSet() { return mPotentiallyVisibleSet; }
+    //! The Sectors that can be seen from some point inside this Sector, not including this Sector.
+    const std::vector<Sector*>& potentiallyVisibleSet() const { return mPotentiallyVisibleSet; }
+
   protected:
     std::vector< ref<Portal> > mPortals;
     std::vector< AABB > mVolumes;
     ref< ActorCollection > mActors;
     std::vector< ref<VisibilityCallback> > mCallbacks;
+    std::vector<Sector*> mPotentiallyVisibleSet;
   };
 //-----------------------------------------------------------------------------
   /** The SceneManagerPortals calss implements a portal-based hidden surface removal algorithm to efficently render highly occluded scenes.
@@ -187,7 +194,8 @@ namespace vl
 
   public:
     //! Constructor.
-    SceneManagerPortals(): mExternalSector(new Sector), mVisitTick(1), mShowPortals(false)
+    SceneManagerPortals(): mExternalSector(new Sector), mVisitCacheSector(NULL), mVisitCacheThreshold(-1), mVisitTick(1), mShowPortals(false),
+      mScreenSpaceNarrowing(false), mUsePotentiallyVisibleSets(true), mVisitCacheValid(false), mRecording(false), mIgnorePortalState(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -229,9 +237,45 @@ namespace vl
     //! The stack of frustums active at a given point during sector discovery.
     const std::vector<Frustum>& frustumStack() const { return mFrustumStack; }
 
+    /** If enabled the frustum seen through a portal is built from the screen-space rectangle of the portal intersected with the rectangle of the
+     *  portal it is seen through, so that every Actor is tested against a single 6 planes frustum instead of the whole frustumStack().
+     *  This makes the culling of deeply nested sectors cheaper but slightly more conservative for non rectangular portals. Default is \p false. */
+    void setScreenSpaceNarrowing(bool enable) { mScreenSpaceNarrowing = enable; }
+    //! Whether the portal frustums are built from the screen-space rectangle of the portals, see setScreenSpaceNarrowing().
+    bool screenSpaceNarrowing() const { return mScreenSpaceNarrowing; }
+
+    /** If >= 0 the sectors visible from the camera position regardless of its orientation are cached and reused as long as the camera stays
+     *  in the same Sector, moves less than \p threshold and the state of the portals met during the sector discovery does not change.
+     *  The Actors of the cached sectors are then only culled against the camera frustum. Default is -1, that is, no caching.
+     *  \note Call invalidateVisibilityCache() after adding or removing sectors or portals. */
+    void setVisibilityCacheThreshold(real threshold) { mVisitCacheThreshold = threshold; invalidateVisibilityCache(); }
+    //! The distance the camera can move before the cached visible sectors are recomputed, see setVisibilityCacheThreshold().
+    real visibilityCacheThreshold() const { return mVisitCacheThreshold; }
+    //! Forces the visible sectors to be recomputed the next frame, see setVisibilityCacheThreshold().
+    void invalidateVisibilityCache() { mVisitCacheValid = false; }
+
+    /** Computes the Sector::potentiallyVisibleSet() of every sector by discovering the sectors visible from \p samples x \p samples x \p samples
+     *  points evenly distributed inside each of its volumes. All the portals are considered open.
+     *  This is meant to be done offline, the result can be saved and loaded along with the scene using VLX. */
+    void computePotentiallyVisibleSets(int samples=4);
+    //! Clears the Sector::potentiallyVisibleSet() of every sector.
+    void clearPotentiallyVisibleSets();
+    /** If enabled and the camera is in a Sector with a non empty Sector::potentiallyVisibleSet() the portals are not traversed and the Actors
+     *  of the sector and of its potentially visible set are only culled against the camera frustum. In this case the Sector::VisibilityCallback
+     *  of each of these sectors is executed with a NULL portal and the open/closed state of the portals is ignored. Default is \p true. */
+    void setUsePotentiallyVisibleSets(bool use) { mUsePotentiallyVisibleSets = use; }
+    //! Whether the Sector::potentiallyVisibleSet() are used when available, see setUsePotentiallyVisibleSets().
+    bool usePotentiallyVisibleSets() const { return mUsePotentiallyVisibleSets; }
+
   protected:
     void renderPortal(Portal* portal);
     void visitSector(Sector* prev, Sector* sector, const vec3& eye, const Camera* camera);
+    void visitCallbacks(const Camera* camera, Sector* sector, Portal* portal);
+    void cullSectorActors(Sector* sector);
+    void cullSectors(const std::vector<Sector*>& sectors);
+    bool narrowFrustum(const Portal* portal, Frustum& frustum, vec4& rect) const;
+    void recordVisibleSectors(Sector* start, const vec3& eye);
+    bool isVisibilityCacheValid(Sector* start, const vec3& eye) const;
     Sector* computeStartingSector(const Camera* camera);
 
   protected:
@@ -240,8 +284,22 @@ namespace vl
     std::vector< ref<Actor> > mTempActors;
     std::map<Portal*, ref<Actor> > mPortalActorMap;
     std::vector<Frustum> mFrustumStack;
+    std::vector<vec4> mRectStack;
+    mat4 mViewProjMatrix;
+    // visibility cache
+    std::vector<Sector*> mVisitCacheSectors;
+    std::vector< std::pair<Sector*, Portal*> > mVisitCacheCallbacks;
+    std::vector< std::pair<Portal*, bool> > mVisitCachePortals;
+    Sector* mVisitCacheSector;
+    vec3 mVisitCacheEye;
+    real mVisitCacheThreshold;
     unsigned mVisitTick;
     bool mShowPortals;
+    bool mScreenSpaceNarrowing;
+    bool mUsePotentiallyVisibleSets;
+    bool mVisitCacheValid;
+    bool mRecording;
+    bool mIgnorePortalState;
   };
 //-----------------------------------------------------------------------------
 }
@@ -0,0 +1,107 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/ScreenErrorLODEvaluator.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlCore/Time.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+float ScreenErrorLODEvaluator::projectedError(float error, const Actor* actor, const Camera* camera)
+{
+  // scale the error by the largest scaling of the Transform
+  if ( actor->transform() )
+  {
+    const mat4& m = actor->transform()->worldMatrix();
+    real scale = m.getX().length();
+    scale = m.getY().length() > scale ? m.getY().length() : scale;
+    scale = m.getZ().length() > scale ? m.getZ().length() : scale;
+    error *= (float)scale;
+  }
+
+  // the vertical scaling of the projection maps view space units to half the viewport height
+  real pixels_per_unit = camera->projectionMatrix().e(1,1) * camera->viewport()->height() * 0.5f;
+
+  if ( camera->projectionMatrixType() != PMT_OrthographicProjection )
+  {
+    const Sphere& sphere = actor->boundingSphere();
+    real distance = (sphere.center() - camera->modelingMatrix().getT()).length() - sphere.radius();
+    // the camera is inside the bounding sphere
+    if ( distance <= camera->nearPlane() )
+      return error > 0 ? 1.0e+30f : 0;
+    pixels_per_unit /= distance;
+  }
+
+  return (float)(error * pixels_per_unit);
+}
+//-----------------------------------------------------------------------------
+int ScreenErrorLODEvaluator::evaluate(Actor* actor, Camera* camera)
+{
+  int lod_count = (int)mGeometricErrors.size();
+  while( lod_count > 1 && !actor->lod(lod_count-1) )
+    --lod_count;
+  if ( lod_count <= 1 )
+    return 0;
+
+  // the coarsest LOD within the threshold, coarser LODs than the current one must satisfy the stricter threshold
+  int lod = 0;
+  for(int i=lod_count; i--; )
+  {
+    float threshold = i > mCurrentLOD ? mPixelError * (1 - mHysteresis) : mPixelError;
+    if ( projectedError(mGeometricErrors[i], actor, camera) <= threshold )
+    {
+      lod = i;
+      break;
+    }
+  }
+
+  if ( mCrossFadeTime > 0 )
+  {
+    if ( lod != mCurrentLOD )
+      mFadeStart = Time::currentTime();
+    if ( mFadeStart >= 0 )
+    {
+      real fade = (Time::currentTime() - mFadeStart) / mCrossFadeTime;
+      if ( fade >= 1 )
+      {
+        fade = 1;
+        mFadeStart = -1;
+      }
+      actor->gocUniform("vl_LODFade")->setUniformF( (float)fade );
+    }
+  }
+
+  mCurrentLOD = lod;
+  return lod;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef ScreenErrorLODEvaluator_INCLUDE_ONCE
+#define ScreenErrorLODEvaluator_INCLUDE_ONCE
+
+#include <vlGraphics/Actor.hpp>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // ScreenErrorLODEvaluator
+  //-----------------------------------------------------------------------------
+  /**
+   * A LODEvaluator that selects the coarsest LOD whose geometric error, projected on the screen, is below pixelError().
+   *
+   * The geometric error of each LOD is expressed in object space units, see geometricErrors() and PolygonSimplifier::outputErrors().
+   * It is scaled by the Actor's Transform and projected at the point of the Actor's bounding sphere nearest to the camera.
+   *
+   * To avoid popping when the projected error oscillates around the threshold a coarser LOD is selected only when its
+   * projected error is below <tt>pixelError() * (1 - hysteresis())</tt>, while a finer LOD is selected as soon as the
+   * current one exceeds pixelError().
+   *
+   * If a cross-fade time is specified the evaluator sets the Actor uniform \p "vl_LODFade" to a value going from 0 to 1
+   * during the given time after each LOD switch, which a shader can use to dither in the new LOD, for example with
+   * <tt>if (vl_LODFade < bayer_threshold(gl_FragCoord.xy)) discard;</tt>. Note that installing an Actor uniform prevents
+   * the Actor from being batched by StaticBatchRenderer.
+   *
+   * \note The evaluator keeps per-Actor state (the current LOD and the fade timing): install a different instance on each Actor.
+   * PolygonSimplifier::generateLODs() can generate and install them automatically.
+   *
+   * \sa
+   * - LODEvaluator
+   * - PixelLODEvaluator
+   * - DistanceLODEvaluator
+  */
+  class VLGRAPHICS_EXPORT ScreenErrorLODEvaluator: public LODEvaluator
+  {
+    VL_INSTRUMENT_CLASS(vl::ScreenErrorLODEvaluator, LODEvaluator)
+
+  public:
+    ScreenErrorLODEvaluator(): mPixelError(1), mHysteresis(0.25f), mCrossFadeTime(0), mCurrentLOD(0), mFadeStart(-1)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual int evaluate(Actor* actor, Camera* camera);
+
+    //! The object space geometric error of each LOD, in increasing order. The first one is usually 0.
+    const std::vector<float>& geometricErrors() const { return mGeometricErrors; }
+
+    //! The object space geometric error of each LOD, in increasing order. The first one is usually 0.
+    std::vector<float>& geometricErrors() { return mGeometricErrors; }
+
+    //! The maximum error in pixels allowed on screen (default = 1).
+    void setPixelError(float pixels) { mPixelError = pixels; }
+
+    //! The maximum error in pixels allowed on screen (default = 1).
+    float pixelError() const { return mPixelError; }
+
+    //! The fraction of pixelError() by which the projected error must be lower to switch to a coarser LOD (default = 0.25).
+    void setHysteresis(float fraction) { mHysteresis = fraction; }
+
+    //! The fraction of pixelError() by which the projected error must be lower to switch to a coarser LOD (default = 0.25).
+    float hysteresis() const { return mHysteresis; }
+
+    //! The duration in seconds of the \p "vl_LODFade" animation after each LOD switch, 0 disables it (default = 0).
+    void setCrossFadeTime(real seconds) { mCrossFadeTime = seconds; }
+
+    //! The duration in seconds of the \p "vl_LODFade" animation after each LOD switch, 0 disables it (default = 0).
+    real crossFadeTime() const { return mCrossFadeTime; }
+
+    //! The LOD selected by the last evaluate().
+    int currentLOD() const { return mCurrentLOD; }
+
+    //! Returns the error in pixels of the given object space error as seen by the given Camera for the given Actor.
+    static float projectedError(float error, const Actor* actor, const Camera* camera);
+
+  protected:
+    std::vector<float> mGeometricErrors;
+    float mPixelError;
+    float mHysteresis;
+    real mCrossFadeTime;
+    int mCurrentLOD;
+    real mFadeStart;
+  };
+}
+
+#endif
@@ -176,6 +176,10 @@ TexEnv* Shader::gocTexEnv(int unit_index) { GET_OR_CREATE_IDX(TexEnv, unit_index
 //------------------------------------------------------------------------------
 TextureMatrix* Shader::gocTextureMatrix(int unit_index) { GET_OR_CREATE_IDX(TextureMatrix, unit_index) }
 //------------------------------------------------------------------------------
+ShaderStorageBuffer* Shader::gocShaderStorageBuffer(int binding) { GET_OR_CREATE_IDX(ShaderStorageBuffer, binding) }
+//------------------------------------------------------------------------------
+ImageUnit* Shader::gocImageUnit(int unit_index) { GET_OR_CREATE_IDX(ImageUnit, unit_index) }
+//------------------------------------------------------------------------------
 // PixelTransfer
 //------------------------------------------------------------------------------
 void PixelTransfer::apply(int, const Camera*, OpenGLContext*) const
@@ -738,6 +742,9 @@ void SampleCoverage::apply(int, const Camera*, OpenGLContext*) const
 TexParameter::TexParameter()
 {
   mDirty = true;
+  mSamplerContext = NULL;
+  mSamplerGeneration = 0;
+  mSampler = 0;
   setMinFilter(TPF_LINEAR);
   setMagFilter(TPF_LINEAR);
   setWrapS(TPW_REPEAT);
@@ -753,7 +760,7 @@ TexParameter::TexParameter()
 //------------------------------------------------------------------------------
 void TexParameter::setMagFilter(ETexParamFilter magfilter)
 {
-  mDirty = true;
+  setSamplerDirty();
 
   switch(magfilter)
   {
@@ -1199,5 +1206,74 @@ void TextureSampler::apply(int index, const Camera*, OpenGLContext* ctx) const
     if ( texture()->getTexParameter()->dirty() )
       texture()->getTexParameter()->apply( texture()->dimension(), ctx );
   }
+
+#if defined(VL_OPENGL)
+  // shared sampler object, overrides the sampling state of the texture object
+  if ( Has_Sampler_Objects )
+  {
+    GLuint sampler = 0;
+    if ( hasTexture() && ctx->samplerObjectsEnabled() )
+    {
+      switch( texture()->dimension() )
+      {
+        case TD_TEXTURE_RECTANGLE:
+        case TD_TEXTURE_2D_MULTISAMPLE:
+        case TD_TEXTURE_2D_MULTISAMPLE_ARRAY:
+        case TD_TEXTURE_BUFFER:
+          break;
+        default:
+          sampler = ctx->samplerObject( texture()->getTexParameter() );
+      }
+    }
+    if ( sampler != ctx->samplerBinding( index ) )
+    {
+      glBindSampler( index, sampler ); VL_CHECK_OGL()
+      ctx->setSamplerBinding( index, sampler );
+    }
+  }
+#endif
+}
+//-----------------------------------------------------------------------------
+// ShaderStorageBuffer
+//-----------------------------------------------------------------------------
+void ShaderStorageBuffer::apply(int index, const Camera*, OpenGLContext*) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK(index < VL_MAX_SHADER_STORAGE_BUFFER_BINDINGS)
+  VL_CHECK(Has_Shader_Storage_Buffer)
+
+  GLuint handle = bufferObject() ? bufferObject()->handle() : 0;
+  if ( handle && bufferObject()->isPooled() ) {
+    // bind only the range of the BufferObjectPool page used by the buffer
+    GLsizeiptr size = mSize > 0 ? mSize : bufferObject()->byteCountBufferObject() - mOffset;
+    glBindBufferRange( GL_SHADER_STORAGE_BUFFER, index, handle, bufferObject()->byteOffsetBufferObject() + mOffset, size ); VL_CHECK_OGL()
+  } else
+  if ( handle && size() > 0 ) {
+    glBindBufferRange( GL_SHADER_STORAGE_BUFFER, index, handle, offset(), size() ); VL_CHECK_OGL()
+  } else {
+    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, index, handle ); VL_CHECK_OGL()
+  }
+
+  // glBindBufferBase() also binds the generic GL_SHADER_STORAGE_BUFFER binding point
+  glBindBuffer( GL_SHADER_STORAGE_BUFFER, 0 ); VL_CHECK_OGL()
+}
+//-----------------------------------------------------------------------------
+// ImageUnit
+//-----------------------------------------------------------------------------
+void ImageUnit::apply(int index, const Camera*, OpenGLContext*) const
+{
+  VL_CHECK_OGL();
+  VL_CHECK(index < VL_MAX_IMAGE_UNITS)
+  VL_CHECK(Has_Image_Load_Store)
+
+  if ( texture() && texture()->handle() )
+  {
+    ETextureFormat format = mFormat != TF_UNKNOWN ? mFormat : texture()->internalFormat();
+    glBindImageTexture( index, texture()->handle(), mLevel, mLayer < 0 ? GL_TRUE : GL_FALSE, mLayer < 0 ? 0 : mLayer, mAccess, format ); VL_CHECK_OGL()
+  }
+  else
+  {
+    glBindImageTexture( index, 0, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8 ); VL_CHECK_OGL()
+  }
 }
 //-----------------------------------------------------------------------------
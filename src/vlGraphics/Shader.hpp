@@ -35,6 +35,7 @@
 #include <vlGraphics/link_config.hpp>
 #include <vlCore/Vector4.hpp>
 #include <vlCore/Matrix4.hpp>
+#include <vlCore/DirtyTracker.hpp>
 #include <vlGraphics/RenderState.hpp>
 #include <vlGraphics/RenderStateSet.hpp>
 #include <vlGraphics/EnableSet.hpp>
@@ -417,6 +418,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const CullFace* rs = other->as<CullFace>();
+      return rs && rs->mFaceMode == mFaceMode;
+    }
+
   protected:
     EPolygonFace mFaceMode;
   };
@@ -450,6 +457,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const FrontFace* rs = other->as<FrontFace>();
+      return rs && rs->mFrontFace == mFrontFace;
+    }
+
   protected:
     EFrontFace mFrontFace;
   };
@@ -483,6 +496,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const DepthFunc* rs = other->as<DepthFunc>();
+      return rs && rs->mDepthFunc == mDepthFunc;
+    }
+
   protected:
     EFunction mDepthFunc;
   };
@@ -516,6 +535,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const DepthMask* rs = other->as<DepthMask>();
+      return rs && rs->mDepthMask == mDepthMask;
+    }
+
   protected:
     bool mDepthMask;
   };
@@ -555,6 +580,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const PolygonMode* rs = other->as<PolygonMode>();
+      return rs && rs->mFrontFace == mFrontFace && rs->mBackFace == mBackFace;
+    }
+
   protected:
     EPolygonMode mFrontFace;
     EPolygonMode mBackFace;
@@ -589,6 +620,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const ShadeModel* rs = other->as<ShadeModel>();
+      return rs && rs->mShadeModel == mShadeModel;
+    }
+
   protected:
     EShadeModel mShadeModel;
   };
@@ -641,6 +678,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const BlendFunc* rs = other->as<BlendFunc>();
+      return rs && rs->mSrcRGB == mSrcRGB && rs->mDstRGB == mDstRGB && rs->mSrcAlpha == mSrcAlpha && rs->mDstAlpha == mDstAlpha;
+    }
+
   protected:
     EBlendFactor mSrcRGB;
     EBlendFactor mDstRGB;
@@ -685,6 +728,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const BlendEquation* rs = other->as<BlendEquation>();
+      return rs && rs->mModeRGB == mModeRGB && rs->mModeAlpha == mModeAlpha;
+    }
+
   protected:
     EBlendEquation mModeRGB;
     EBlendEquation mModeAlpha;
@@ -725,6 +774,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const SampleCoverage* rs = other->as<SampleCoverage>();
+      return rs && rs->mValue == mValue && rs->mInvert == mInvert;
+    }
+
   protected:
     GLclampf mValue;
     bool mInvert;
@@ -761,6 +816,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const AlphaFunc* rs = other->as<AlphaFunc>();
+      return rs && rs->mRefValue == mRefValue && rs->mAlphaFunc == mAlphaFunc;
+    }
+
   protected:
     float mRefValue;
     EFunction mAlphaFunc;
@@ -993,6 +1054,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const PolygonOffset* rs = other->as<PolygonOffset>();
+      return rs && rs->mFactor == mFactor && rs->mUnits == mUnits;
+    }
+
   protected:
     float mFactor;
     float mUnits;
@@ -1027,6 +1094,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const LogicOp* rs = other->as<LogicOp>();
+      return rs && rs->mLogicOp == mLogicOp;
+    }
+
   protected:
     ELogicOp mLogicOp;
   };
@@ -1071,6 +1144,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const DepthRange* rs = other->as<DepthRange>();
+      return rs && rs->mZNear == mZNear && rs->mZFar == mZFar;
+    }
+
   protected:
     float mZNear;
     float mZFar;
@@ -1105,6 +1184,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const LineWidth* rs = other->as<LineWidth>();
+      return rs && rs->mLineWidth == mLineWidth;
+    }
+
   protected:
     float mLineWidth;
   };
@@ -1138,6 +1223,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const PointSize* rs = other->as<PointSize>();
+      return rs && rs->mPointSize == mPointSize;
+    }
+
   protected:
     float mPointSize;
   };
@@ -1328,6 +1419,14 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const StencilFunc* rs = other->as<StencilFunc>();
+      return rs && rs->mFunction_Front == mFunction_Front && rs->mFunction_Back == mFunction_Back &&
+             rs->mRefValue_Front == mRefValue_Front && rs->mRefValue_Back == mRefValue_Back &&
+             rs->mMask_Front == mMask_Front && rs->mMask_Back == mMask_Back;
+    }
+
   protected:
     EFunction mFunction_Front;
     EFunction mFunction_Back;
@@ -1395,6 +1494,14 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const StencilOp* rs = other->as<StencilOp>();
+      return rs && rs->mSFail_Front == mSFail_Front && rs->mSFail_Back == mSFail_Back &&
+             rs->mDpFail_Front == mDpFail_Front && rs->mDpFail_Back == mDpFail_Back &&
+             rs->mDpPass_Front == mDpPass_Front && rs->mDpPass_Back == mDpPass_Back;
+    }
+
   protected:
     EStencilOp mSFail_Front;
     EStencilOp mSFail_Back;
@@ -1443,6 +1550,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const StencilMask* rs = other->as<StencilMask>();
+      return rs && rs->mMask_Front == mMask_Front && rs->mMask_Back == mMask_Back;
+    }
+
   protected:
     unsigned int mMask_Front;
     unsigned int mMask_Back;
@@ -1477,6 +1590,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const BlendColor* rs = other->as<BlendColor>();
+      return rs && rs->mBlendColor == mBlendColor;
+    }
+
   protected:
     fvec4 mBlendColor;
   };
@@ -1524,6 +1643,12 @@ namespace vl
       return rs;
     }
 
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const ColorMask* rs = other->as<ColorMask>();
+      return rs && rs->mRed == mRed && rs->mGreen == mGreen && rs->mBlue == mBlue && rs->mAlpha == mAlpha;
+    }
+
   protected:
     bool mRed;
     bool mGreen;
@@ -1779,22 +1904,160 @@ namespace vl
       return rs;
     }
 
+    /** Two texture samplers are equivalent if they bind the same Texture and its TexParameter does not need to be applied. */
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const TextureSampler* rs = other->as<TextureSampler>();
+      return rs && rs->mTexture == mTexture && ( !mTexture || !mTexture->getTexParameter()->dirty() );
+    }
+
   protected:
     ref<Texture> mTexture;
   };
   //------------------------------------------------------------------------------
+  // ShaderStorageBuffer
+  //------------------------------------------------------------------------------
+  /** The ShaderStorageBuffer class binds a BufferObject, or a range of it, to a shader storage buffer binding point
+   * so that GLSL programs, compute shaders in particular, can read and write it as a \p buffer block.
+   *
+   * The index of the render state is the \p binding of the block, at most VL_MAX_SHADER_STORAGE_BUFFER_BINDINGS.
+   * Requires OpenGL 4.3 or GL_ARB_shader_storage_buffer_object, see Has_Shader_Storage_Buffer.
+   * \sa ImageUnit, DispatchCompute, GLSLComputeShader, Shader */
+  class VLGRAPHICS_EXPORT ShaderStorageBuffer: public RenderStateIndexed
+  {
+    VL_INSTRUMENT_CLASS(vl::ShaderStorageBuffer, RenderStateIndexed)
+
+  public:
+    ShaderStorageBuffer(BufferObject* buffer=NULL, GLintptr offset=0, GLsizeiptr size=0): mBufferObject(buffer), mOffset(offset), mSize(size)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual ERenderState type() const { return RS_ShaderStorageBuffer; }
+    virtual void apply(int index, const Camera*, OpenGLContext* ctx) const;
+
+    //! The bound BufferObject, NULL unbinds the binding point.
+    void setBufferObject(BufferObject* buffer) { mBufferObject = buffer; }
+    BufferObject* bufferObject() { return mBufferObject.get(); }
+    const BufferObject* bufferObject() const { return mBufferObject.get(); }
+
+    //! The bound range in bytes, a \p size of 0 binds the whole buffer.
+    void setRange(GLintptr offset, GLsizeiptr size) { mOffset = offset; mSize = size; }
+    GLintptr offset() const { return mOffset; }
+    GLsizeiptr size() const { return mSize; }
+
+    virtual ref<RenderState> clone() const
+    {
+      ref<ShaderStorageBuffer> rs = new ShaderStorageBuffer;
+      *rs = *this;
+      return rs;
+    }
+
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const ShaderStorageBuffer* rs = other->as<ShaderStorageBuffer>();
+      return rs && rs->mBufferObject == mBufferObject && rs->mOffset == mOffset && rs->mSize == mSize;
+    }
+
+  protected:
+    ref<BufferObject> mBufferObject;
+    GLintptr mOffset;
+    GLsizeiptr mSize;
+  };
+  //------------------------------------------------------------------------------
+  // ImageUnit
+  //------------------------------------------------------------------------------
+  /** The ImageUnit class binds a level of a Texture to an image unit, to be read and written by GLSL programs through \p image uniforms.
+   *
+   * The index of the render state is the image unit, at most VL_MAX_IMAGE_UNITS. If no format is specified the internal format
+   * of the Texture is used. Requires OpenGL 4.2 or GL_ARB_shader_image_load_store, see Has_Image_Load_Store.
+   * \sa ShaderStorageBuffer, DispatchCompute, GLSLComputeShader, Shader */
+  class VLGRAPHICS_EXPORT ImageUnit: public RenderStateIndexed
+  {
+    VL_INSTRUMENT_CLASS(vl::ImageUnit, RenderStateIndexed)
+
+  public:
+    ImageUnit(Texture* texture=NULL, EBufferObjectAccess access=BA_READ_WRITE, int level=0):
+      mTexture(texture), mLevel(level), mLayer(-1), mAccess(access), mFormat(TF_UNKNOWN)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual ERenderState type() const { return RS_ImageUnit; }
+    virtual void apply(int index, const Camera*, OpenGLContext* ctx) const;
+
+    //! The bound Texture, NULL unbinds the image unit.
+    void setTexture(Texture* texture) { mTexture = texture; }
+    Texture* texture() { return mTexture.get(); }
+    const Texture* texture() const { return mTexture.get(); }
+
+    //! The bound mipmap level.
+    void setLevel(int level) { mLevel = level; }
+    int level() const { return mLevel; }
+
+    //! The bound layer of an array, cubemap or 3D texture, -1 (default) binds all the layers.
+    void setLayer(int layer) { mLayer = layer; }
+    int layer() const { return mLayer; }
+
+    //! How the GLSL program accesses the image.
+    void setAccess(EBufferObjectAccess access) { mAccess = access; }
+    EBufferObjectAccess access() const { return mAccess; }
+
+    //! The format used to interpret the texels, TF_UNKNOWN (default) means the internal format of the Texture.
+    void setFormat(ETextureFormat format) { mFormat = format; }
+    ETextureFormat format() const { return mFormat; }
+
+    virtual ref<RenderState> clone() const
+    {
+      ref<ImageUnit> rs = new ImageUnit;
+      *rs = *this;
+      return rs;
+    }
+
+    virtual bool isEquivalent(const RenderState* other) const
+    {
+      const ImageUnit* rs = other->as<ImageUnit>();
+      return rs && rs->mTexture == mTexture && rs->mLevel == mLevel && rs->mLayer == mLayer && rs->mAccess == mAccess && rs->mFormat == mFormat;
+    }
+
+  protected:
+    ref<Texture> mTexture;
+    int mLevel;
+    int mLayer;
+    EBufferObjectAccess mAccess;
+    ETextureFormat mFormat;
+  };
+  //------------------------------------------------------------------------------
   // ShaderAnimator
   //------------------------------------------------------------------------------
   /** Callback object used to update/animate a Shader during the rendering.
   The updateShader() method will be called whenever a visible object uses the
   Shader to which the ShaderAnimator is bound.
+  An enabled ShaderAnimator is a continuous source of redraws, see DirtyTracker::addContinuousSource().
   \sa Shader::setUpdater(); */
   class VLGRAPHICS_EXPORT ShaderAnimator: public Object
   {
     VL_INSTRUMENT_ABSTRACT_CLASS(vl::ShaderAnimator, Object)
 
   public:
-    ShaderAnimator(): mEnabled(true) {}
+    ShaderAnimator(): mEnabled(true) { DirtyTracker::addContinuousSource(); }
+
+    //! The copy is registered as a continuous source if \p other is enabled.
+    ShaderAnimator(const ShaderAnimator& other): Object(other), mEnabled(other.mEnabled)
+    {
+      if (mEnabled)
+        DirtyTracker::addContinuousSource();
+    }
+
+    //! Copies the enabled state, keeping the continuous source registration consistent.
+    ShaderAnimator& operator=(const ShaderAnimator& other)
+    {
+      Object::operator=(other);
+      setEnabled(other.mEnabled);
+      return *this;
+    }
+
+    ~ShaderAnimator() { if (mEnabled) DirtyTracker::removeContinuousSource(); }
 
     /** Reimplement this function to update/animate a Shader.
     \param shader the Shader to be updated.
@@ -1804,7 +2067,15 @@ namespace vl
     virtual void updateShader(Shader* shader, Camera* camera, real cur_time) = 0;
 
     /** Whether the ShaderAnimator is enabled or not. */
-    void setEnabled(bool enable) { mEnabled = enable; }
+    void setEnabled(bool enable)
+    {
+      if (enable && !mEnabled)
+        DirtyTracker::addContinuousSource();
+      else
+      if (!enable && mEnabled)
+        DirtyTracker::removeContinuousSource();
+      mEnabled = enable;
+    }
 
     /** Whether the ShaderAnimator is enabled or not. */
     bool isEnabled() const { return mEnabled; }
@@ -2153,11 +2424,27 @@ namespace vl
 
     TextureMatrix* getTextureMatrix(int unit_index) { return static_cast<TextureMatrix*>( getRenderStateSet()->renderState( RS_TextureMatrix, unit_index ) ); }
 
+    // shader storage buffer
+
+    ShaderStorageBuffer* gocShaderStorageBuffer(int binding);
+
+    const ShaderStorageBuffer* getShaderStorageBuffer(int binding) const { return static_cast<const ShaderStorageBuffer*>( getRenderStateSet()->renderState( RS_ShaderStorageBuffer, binding ) ); }
+
+    ShaderStorageBuffer* getShaderStorageBuffer(int binding) { return static_cast<ShaderStorageBuffer*>( getRenderStateSet()->renderState( RS_ShaderStorageBuffer, binding ) ); }
+
+    // image unit
+
+    ImageUnit* gocImageUnit(int unit_index);
+
+    const ImageUnit* getImageUnit(int unit_index) const { return static_cast<const ImageUnit*>( getRenderStateSet()->renderState( RS_ImageUnit, unit_index ) ); }
+
+    ImageUnit* getImageUnit(int unit_index) { return static_cast<ImageUnit*>( getRenderStateSet()->renderState( RS_ImageUnit, unit_index ) ); }
+
     // enable methods
 
-    void enable(EEnable capability)  { gocEnableSet()->enable(capability); }
+    void enable(EEnable capability)  { gocEnableSet()->enable(capability); DirtyTracker::markDirty(); }
 
-    void disable(EEnable capability) { gocEnableSet()->disable(capability); }
+    void disable(EEnable capability) { gocEnableSet()->disable(capability); DirtyTracker::markDirty(); }
 
     const std::vector<EEnable>& enables() const { return getEnableSet()->enables(); }
 
@@ -2169,9 +2456,9 @@ namespace vl
 
     // render states methods
 
-    void setRenderState(RenderStateNonIndexed* renderstate) { gocRenderStateSet()->setRenderState(renderstate, -1); }
+    void setRenderState(RenderStateNonIndexed* renderstate) { gocRenderStateSet()->setRenderState(renderstate, -1); DirtyTracker::markDirty(); }
 
-    void setRenderState(RenderState* renderstate, int index) { gocRenderStateSet()->setRenderState(renderstate, index); }
+    void setRenderState(RenderState* renderstate, int index) { gocRenderStateSet()->setRenderState(renderstate, index); DirtyTracker::markDirty(); }
 
     const RenderState* renderState( ERenderState type, int index=0 ) const { if (!getRenderStateSet()) return NULL; return getRenderStateSet()->renderState(type, index); }
 
@@ -2184,7 +2471,7 @@ namespace vl
     RenderStateSlot* renderStates() { return getRenderStateSet()->renderStates(); }
 
     //! If index == -1 all the renderstates of the given type are removed regardless of their binding index.
-    void eraseRenderState(ERenderState type, int index=-1) { gocRenderStateSet()->eraseRenderState(type, index); }
+    void eraseRenderState(ERenderState type, int index=-1) { gocRenderStateSet()->eraseRenderState(type, index); DirtyTracker::markDirty(); }
 
     void eraseRenderState(RenderState* rs, int index) { if (rs) gocRenderStateSet()->eraseRenderState(rs->type(), index); }
 
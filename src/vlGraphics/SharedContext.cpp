@@ -0,0 +1,88 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/SharedContext.hpp>
+#include <vlCore/ScopedMutex.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+void SharedContext::publish()
+{
+  if ( !glFenceSync )
+  {
+    glFinish(); VL_CHECK_OGL();
+    return;
+  }
+
+  GLsync fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ); VL_CHECK_OGL();
+  // make sure the fence reaches the GPU, otherwise the rendering context could wait on it forever.
+  glFlush(); VL_CHECK_OGL();
+
+  ScopedMutex lock(mMutex);
+  mFences.push_back(fence);
+}
+//-----------------------------------------------------------------------------
+int SharedContext::acquire()
+{
+  std::vector<GLsync> fences;
+  {
+    ScopedMutex lock(mMutex);
+    fences.swap(mFences);
+  }
+
+  for(size_t i=0; i<fences.size(); ++i)
+  {
+    glWaitSync( fences[i], 0, GL_TIMEOUT_IGNORED ); VL_CHECK_OGL();
+    glDeleteSync( fences[i] ); VL_CHECK_OGL();
+  }
+
+  return (int)fences.size();
+}
+//-----------------------------------------------------------------------------
+bool SharedContext::isComplete()
+{
+  ScopedMutex lock(mMutex);
+  for(size_t i=0; i<mFences.size(); ++i)
+  {
+    GLenum status = glClientWaitSync( mFences[i], 0, 0 ); VL_CHECK_OGL();
+    if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED )
+      return false;
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+int SharedContext::pendingFences() const
+{
+  ScopedMutex lock(const_cast<IMutex*>(mMutex));
+  return (int)mFences.size();
+}
+//-----------------------------------------------------------------------------
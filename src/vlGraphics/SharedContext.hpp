@@ -0,0 +1,111 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef SharedContext_INCLUDE_ONCE
+#define SharedContext_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vlCore/Object.hpp>
+#include <vlCore/IMutex.hpp>
+#include <vector>
+
+namespace vl
+{
+  class OpenGLContext;
+
+  //-----------------------------------------------------------------------------
+  // SharedContext
+  //-----------------------------------------------------------------------------
+  /** An auxiliary, windowless OpenGL context sharing its resources with an OpenGLContext,
+   * used to create BufferObjects, Textures and GLSLPrograms from a worker thread.
+   *
+   * Instances are created on the GUI thread with OpenGLContext::createSharedContext(), then the worker
+   * thread calls makeCurrent() once and creates its resources normally. After a batch of resources has been
+   * created the worker calls publish(), which inserts a fence in the auxiliary context's command stream.
+   * Before using the new resources the rendering thread calls acquire(), which makes the rendering context
+   * wait on the GPU for all the published fences, without stalling the CPU.
+   *
+   * \note VL does not provide a thread class: set a mutex with setMutex() (see vl::IMutex) since publish()
+   * and acquire() are called from different threads.
+   * \note The OpenGL function pointers are shared with the main context, which must have been initialized
+   * with OpenGLContext::initGLContext() before the worker starts.
+   * \sa OpenGLContext::createSharedContext(), TextureStreamer, CommandList */
+  class VLGRAPHICS_EXPORT SharedContext: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::SharedContext, Object)
+
+  public:
+    SharedContext(OpenGLContext* shared_with): mSharedWith(shared_with), mMutex(NULL) {}
+
+    //! Makes the auxiliary context current for the calling (worker) thread.
+    virtual bool makeCurrent() = 0;
+
+    //! Releases the auxiliary context from the calling thread.
+    virtual void doneCurrent() = 0;
+
+    //! The OpenGLContext this context shares its resources with.
+    OpenGLContext* sharedWith() { return mSharedWith; }
+
+    //! The OpenGLContext this context shares its resources with.
+    const OpenGLContext* sharedWith() const { return mSharedWith; }
+
+    //! Called by the worker thread with this context current: marks all the commands issued so far as ready to be handed off.
+    //! If sync objects are not available the function falls back to glFinish().
+    void publish();
+
+    //! Called by the rendering thread with the shared OpenGLContext current: makes the rendering context wait for all the
+    //! published fences on the server side and releases them. Returns the number of fences acquired.
+    int acquire();
+
+    //! Returns true if all the published work has been completed by the GPU. Does not block and does not release the fences.
+    bool isComplete();
+
+    //! The number of published fences not yet acquired.
+    int pendingFences() const;
+
+    //! The mutex protecting the fence queue, required since publish() and acquire() are called by different threads.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex protecting the fence queue, required since publish() and acquire() are called by different threads.
+    IMutex* mutex() { return mMutex; }
+
+    //! The mutex protecting the fence queue, required since publish() and acquire() are called by different threads.
+    const IMutex* mutex() const { return mMutex; }
+
+  protected:
+    OpenGLContext* mSharedWith;
+    std::vector<GLsync> mFences;
+    IMutex* mMutex;
+  };
+}
+
+#endif
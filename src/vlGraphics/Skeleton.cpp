@@ -0,0 +1,80 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/Skeleton.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+int Skeleton::addJoint(Transform* joint, const mat4& inverse_bind_matrix)
+{
+  VL_CHECK(joint)
+  mJoints.push_back(joint);
+  mInverseBindMatrices.push_back(inverse_bind_matrix);
+  return (int)mJoints.size() - 1;
+}
+//-----------------------------------------------------------------------------
+int Skeleton::jointIndex(const char* name) const
+{
+  for(size_t i=0; i<mJoints.size(); ++i)
+    if (mJoints[i]->objectName() == name)
+      return (int)i;
+  return -1;
+}
+//-----------------------------------------------------------------------------
+void Skeleton::setBindPose(const Transform* mesh_transform)
+{
+  mat4 mesh_world = mesh_transform ? mesh_transform->worldMatrix() : mat4();
+  for(size_t i=0; i<mJoints.size(); ++i)
+    mInverseBindMatrices[i] = mJoints[i]->worldMatrix().getInverse() * mesh_world;
+}
+//-----------------------------------------------------------------------------
+void Skeleton::computePalette(const Transform* mesh_transform, fvec4* rows) const
+{
+  mat4 mesh_world_inv = mesh_transform ? mesh_transform->worldMatrix().getInverse() : mat4();
+  for(size_t i=0; i<mJoints.size(); ++i, rows+=3)
+  {
+    mat4 m = mesh_world_inv * mJoints[i]->worldMatrix() * mInverseBindMatrices[i];
+    // the last row of an affine matrix is always (0,0,0,1)
+    for(int r=0; r<3; ++r)
+      rows[r] = fvec4( (float)m.e(r,0), (float)m.e(r,1), (float)m.e(r,2), (float)m.e(r,3) );
+  }
+}
+//-----------------------------------------------------------------------------
+long long Skeleton::poseTick(const Transform* mesh_transform) const
+{
+  long long tick = mesh_transform ? mesh_transform->worldMatrixUpdateTick() : 0;
+  for(size_t i=0; i<mJoints.size(); ++i)
+    tick += mJoints[i]->worldMatrixUpdateTick();
+  return tick;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef Skeleton_INCLUDE_ONCE
+#define Skeleton_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlCore/Transform.hpp>
+#include <vector>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // Skeleton
+  //-----------------------------------------------------------------------------
+  /**
+   * The joints of a skinned mesh.
+   *
+   * The joints are ordinary Transform[s], their hierarchy is the Transform hierarchy: animating a character means animating the
+   * local matrices of its joint Transform[s], which must be updated along with the other Transform[s] of the scene, for example by
+   * adding the root joint to Rendering::transform().
+   *
+   * Each joint has an inverse bind matrix mapping the vertices from the mesh space to the space of the joint in the bind pose,
+   * the skinning matrix of the joint is <tt>inverse(mesh_world) * joint_world * inverse_bind</tt>, see computePalette().
+   * The vertices reference the joints by their index in joints(), see SkinningPalette.
+   *
+   * \sa SkinningPalette
+   */
+  class VLGRAPHICS_EXPORT Skeleton: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::Skeleton, Object)
+
+  public:
+    Skeleton()
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Appends a joint and returns its index.
+    int addJoint(Transform* joint, const mat4& inverse_bind_matrix=mat4());
+
+    //! The number of joints.
+    int jointCount() const { return (int)mJoints.size(); }
+
+    //! The i-th joint.
+    Transform* joint(int i) { return mJoints[i].get(); }
+
+    //! The i-th joint.
+    const Transform* joint(int i) const { return mJoints[i].get(); }
+
+    //! Returns the index of the first joint whose Transform's objectName() is \p name or -1.
+    int jointIndex(const char* name) const;
+
+    //! The inverse bind matrix of the i-th joint.
+    void setInverseBindMatrix(int i, const mat4& matrix) { mInverseBindMatrices[i] = matrix; }
+
+    //! The inverse bind matrix of the i-th joint.
+    const mat4& inverseBindMatrix(int i) const { return mInverseBindMatrices[i]; }
+
+    /** Uses the current pose as bind pose, computing the inverse bind matrices from the current world matrices of the joints.
+      * \p mesh_transform is the Transform of the skinned Actor, NULL means identity. */
+    void setBindPose(const Transform* mesh_transform=NULL);
+
+    /** Writes the 3x4 skinning matrix of every joint as 3 rows in \p rows, which must have room for <tt>3 * jointCount()</tt> elements.
+      * \p mesh_transform is the Transform of the skinned Actor, NULL means identity. */
+    void computePalette(const Transform* mesh_transform, fvec4* rows) const;
+
+    /** Returns the sum of the worldMatrixUpdateTick() of the joints and of \p mesh_transform: changes if any of the world matrices changed.
+      * Used by SkinningPalette to recompute only the animated skeletons. */
+    long long poseTick(const Transform* mesh_transform) const;
+
+    //! Removes all the joints.
+    void clear() { mJoints.clear(); mInverseBindMatrices.clear(); }
+
+  protected:
+    std::vector< ref<Transform> > mJoints;
+    std::vector< mat4 > mInverseBindMatrices;
+  };
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/SkinningPalette.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+SkinningPalette::SkinningPalette()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mPalette = new ArrayFloat4;
+  mTexture = new Texture;
+  mUpdatedSkins = 0;
+}
+//-----------------------------------------------------------------------------
+int SkinningPalette::addSkin(Skeleton* skeleton, Transform* mesh_transform)
+{
+  VL_CHECK(skeleton)
+  Skin skin;
+  skin.mSkeleton = skeleton;
+  skin.mMeshTransform = mesh_transform;
+  skin.mOffset = (int)mPalette->size();
+  skin.mJointCount = skeleton->jointCount();
+  // forces the first update
+  skin.mPoseTick = -1;
+  mSkins.push_back(skin);
+
+  // the palette only grows: the offsets of the skins never change
+  mPalette->resize( mPalette->size() + 3 * skin.mJointCount );
+  return skin.mOffset;
+}
+//-----------------------------------------------------------------------------
+int SkinningPalette::bindActor(Actor* actor, Skeleton* skeleton)
+{
+  int offset = addSkin(skeleton, actor->transform());
+  actor->gocUniform("vl_SkinningOffset")->setUniformI(offset);
+  return offset;
+}
+//-----------------------------------------------------------------------------
+void SkinningPalette::update()
+{
+  mUpdatedSkins = 0;
+  if (mPalette->size() == 0)
+    return;
+
+  if (!Has_Texture_Buffer)
+  {
+    Log::error("SkinningPalette::update(): texture buffers not supported.\n");
+    return;
+  }
+
+  // recompute the animated skins, tracking the range of texels to upload
+  int first = (int)mPalette->size();
+  int last  = 0;
+  for(size_t i=0; i<mSkins.size(); ++i)
+  {
+    Skin& skin = mSkins[i];
+    if (skin.mSkeleton->jointCount() != skin.mJointCount)
+    {
+      Log::error( Say("SkinningPalette::update(): the joint count of skin #%n changed after addSkin().\n") << i );
+      continue;
+    }
+    long long tick = skin.mSkeleton->poseTick( skin.mMeshTransform.get() );
+    if (tick == skin.mPoseTick)
+      continue;
+    skin.mPoseTick = tick;
+    skin.mSkeleton->computePalette( skin.mMeshTransform.get(), mPalette->begin() + skin.mOffset );
+    first = std::min(first, skin.mOffset);
+    last  = std::max(last,  skin.mOffset + 3 * skin.mJointCount);
+    ++mUpdatedSkins;
+  }
+
+  BufferObject* bo = mPalette->bufferObject();
+  if ( bo->byteCountBufferObject() != (GLsizeiptr)mPalette->bytesUsed() )
+  {
+    // new skins: reallocate and upload everything, the texture keeps referencing the same buffer object
+    GLint max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels); VL_CHECK_OGL();
+    if ( mPalette->size() > (size_t)max_texels )
+    {
+      Log::error( Say("SkinningPalette::update(): %n texels exceed GL_MAX_TEXTURE_BUFFER_SIZE (%n).\n") << mPalette->size() << max_texels );
+      return;
+    }
+    bo->setBufferData( BU_DYNAMIC_DRAW, false );
+  }
+  else
+  if ( first < last )
+    bo->setBufferSubData( first * sizeof(fvec4), (last - first) * sizeof(fvec4), mPalette->begin() + first );
+
+  if ( ! mTexture->handle() )
+    mTexture->createTextureBuffer( TF_RGBA32F, bo );
+}
+//-----------------------------------------------------------------------------
+void SkinningPalette::setupShader(Shader* shader, int unit)
+{
+  VL_CHECK(shader)
+  shader->gocTextureSampler(unit)->setTexture( mTexture.get() );
+  shader->gocUniform("vl_SkinningPalette")->setUniformI(unit);
+}
+//-----------------------------------------------------------------------------
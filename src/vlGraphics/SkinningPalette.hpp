@@ -0,0 +1,152 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef SkinningPalette_INCLUDE_ONCE
+#define SkinningPalette_INCLUDE_ONCE
+
+#include <vlGraphics/RenderEventCallback.hpp>
+#include <vlGraphics/Skeleton.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/Array.hpp>
+
+namespace vl
+{
+  class Actor;
+  class Shader;
+  //-----------------------------------------------------------------------------
+  // SkinningPalette
+  //-----------------------------------------------------------------------------
+  /**
+   * The skinning matrices of any number of skinned Actor[s], uploaded in a single texture buffer and applied by the vertex shader.
+   *
+   * Every skinned Actor registered with bindActor() gets a range of the palette holding the 3x4 skinning matrices of its Skeleton,
+   * the first texel of the range is stored in the Actor's \p "vl_SkinningOffset" uniform. Installed in Renderer::onStartedCallbacks(),
+   * once per rendering the palette recomputes the matrices of the skeletons whose pose changed (see Skeleton::poseTick()) and uploads
+   * them with a single buffer update, thus the CPU never touches the vertices and any number of Actor[s] sharing the same Geometry
+   * and Effect can be animated independently.
+   *
+   * The Geometry of a skinned mesh has, besides the usual vertex attributes:
+   * - the indices of the (up to) 4 joints influencing each vertex bound to \p VA_JointIndices, an ArrayUByte4 or ArrayUShort4 with
+   *   the VAI_INTEGER interpretation, declared as <tt>in uvec4 vl_VertexJointIndices</tt>.
+   * - the corresponding weights, summing to 1, bound to \p VA_JointWeights, an ArrayFloat4 or a normalized ArrayUByte4, declared as
+   *   <tt>in vec4 vl_VertexJointWeights</tt>.
+   *
+   * Vertices influenced by fewer joints simply have a weight of 0 for the unused indices. The vertex shader includes
+   * \p /glsl/std/skinning.glsl, see \p /glsl/skinning.vs:
+   *
+   * \code
+   * ref<SkinningPalette> palette = new SkinningPalette;
+   * rendering->renderer()->onStartedCallbacks()->push_back( palette.get() );
+   * palette->setupShader( fx->shader(), 0 );
+   * fx->shader()->gocGLSLProgram()->attachShader( new GLSLVertexShader("/glsl/skinning.vs") );
+   * geom->setVertexAttribArray( VA_JointIndices, joint_indices.get() );
+   * geom->setVertexAttribArray( VA_JointWeights, joint_weights.get() );
+   * for(int i=0; i<character_count; ++i)
+   *   palette->bindActor( characters[i].get(), skeletons[i].get() );
+   * \endcode
+   *
+   * \remarks
+   * Culling uses the bounds of the Geometry in the bind pose, set with Renderable::setBoundingBox() bounds enclosing all the poses
+   * if the animation moves the vertices far from the bind pose. The normals are transformed by the upper 3x3 part of the skinning
+   * matrices, which is correct as long as the joints are not scaled non-uniformly.
+   *
+   * \note Requires OpenGL 3.1 or GL_ARB_texture_buffer_object. The palette holds <tt>3 * joint_count</tt> texels per skin,
+   * which must not exceed \p GL_MAX_TEXTURE_BUFFER_SIZE.
+   *
+   * \sa Skeleton, MorphingCallback
+   */
+  class VLGRAPHICS_EXPORT SkinningPalette: public RenderEventCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::SkinningPalette, RenderEventCallback)
+
+  public:
+    SkinningPalette();
+
+    virtual bool onRenderingStarted(const RenderingAbstract*) { return true; }
+    virtual bool onRenderingFinished(const RenderingAbstract*) { return true; }
+    virtual bool onRendererStarted(const RendererAbstract*) { update(); return true; }
+    virtual bool onRendererFinished(const RendererAbstract*) { return true; }
+
+    /** Adds a skin animated by \p skeleton and returns the index of its first texel in the palette.
+      * \p mesh_transform is the Transform of the skinned Actor(s), NULL means identity. Skins can share the same Skeleton. */
+    int addSkin(Skeleton* skeleton, Transform* mesh_transform);
+
+    /** Adds a skin for \p actor animated by \p skeleton and sets the \p "vl_SkinningOffset" uniform of the Actor. Returns the skin's first texel. */
+    int bindActor(Actor* actor, Skeleton* skeleton);
+
+    //! The number of skins.
+    int skinCount() const { return (int)mSkins.size(); }
+
+    //! The index of the first texel of the i-th skin.
+    int texelOffset(int i) const { return mSkins[i].mOffset; }
+
+    //! Removes all the skins.
+    void clear() { mSkins.clear(); mPalette->clear(); }
+
+    /** Recomputes the matrices of the skins whose pose changed and uploads them. Called by onRendererStarted().
+      * \note An OpenGL context must be active when calling this function. */
+    void update();
+
+    //! Binds texture() to the given texture unit and sets the \p "vl_SkinningPalette" sampler uniform.
+    void setupShader(Shader* shader, int unit);
+
+    //! The texture buffer containing the palette, created by update().
+    Texture* texture() { return mTexture.get(); }
+
+    //! The texture buffer containing the palette, created by update().
+    const Texture* texture() const { return mTexture.get(); }
+
+    //! The skinning matrices, 3 rows per joint.
+    const ArrayFloat4* palette() const { return mPalette.get(); }
+
+    //! The number of skins recomputed by the last update().
+    int updatedSkins() const { return mUpdatedSkins; }
+
+  protected:
+    struct Skin
+    {
+      ref<Skeleton> mSkeleton;
+      ref<Transform> mMeshTransform;
+      int mOffset;
+      int mJointCount;
+      long long mPoseTick;
+    };
+
+  protected:
+    std::vector<Skin> mSkins;
+    ref<ArrayFloat4> mPalette;
+    ref<Texture> mTexture;
+    int mUpdatedSkins;
+  };
+}
+
+#endif
@@ -0,0 +1,622 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include <vlGraphics/StateDeduplicator.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlCore/ResourceDatabase.hpp>
+#include <vlCore/DirtyTracker.hpp>
+#include <vlCore/MurmurHash3.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+using namespace vl;
+
+namespace
+{
+  typedef std::vector<u64> Key;
+
+  void pushFloats(Key& key, const float* values, int count)
+  {
+    for(int i=0; i<count; ++i)
+    {
+      u32 bits = 0;
+      memcpy(&bits, &values[i], sizeof(bits));
+      key.push_back(bits);
+    }
+  }
+
+  void pushPointer(Key& key, const void* ptr) { key.push_back( (u64)(size_t)ptr ); }
+
+  void pushString(Key& key, const String& str)
+  {
+    key.push_back( str.length() );
+    for(int i=0; i<str.length(); ++i)
+      key.push_back( (u64)str[i] );
+  }
+
+  typedef bool (*VerifyFunc)(const Object* a, const Object* b);
+
+  //! Hash table of the canonical objects keyed by the MurmurHash3 of their keys.
+  class CanonicalTable
+  {
+  public:
+    //! Returns the first object inserted with the same key, and accepted by \p verify if not NULL, or inserts \p obj and returns it.
+    Object* insert(const Key& key, Object* obj, VerifyFunc verify=NULL)
+    {
+      u32 hash = 0;
+      if (!key.empty())
+        MurmurHash3_x86_32(&key[0], (int)(key.size()*sizeof(u64)), 0, &hash);
+      std::vector<int>& bucket = mBuckets[hash];
+      for(size_t i=0; i<bucket.size(); ++i)
+      {
+        if ( mKeys[bucket[i]] == key && ( !verify || verify(mObjects[bucket[i]], obj) ) )
+          return mObjects[bucket[i]];
+      }
+      bucket.push_back( (int)mObjects.size() );
+      mKeys.push_back(key);
+      mObjects.push_back(obj);
+      return obj;
+    }
+
+  protected:
+    std::map< u32, std::vector<int> > mBuckets;
+    std::vector<Key> mKeys;
+    std::vector<Object*> mObjects;
+  };
+
+  // Packs the values of the render states which do not implement RenderState::isEquivalent(), returns false for the other ones.
+  bool renderStateKey(const RenderState* rs, Key& key)
+  {
+    key.clear();
+    key.push_back( rs->type() );
+    if ( rs->classType() == Material::Type() )
+    {
+      const Material* mat = static_cast<const Material*>(rs);
+      pushFloats( key, mat->frontAmbient().ptr(), 4 );
+      pushFloats( key, mat->frontDiffuse().ptr(), 4 );
+      pushFloats( key, mat->frontSpecular().ptr(), 4 );
+      pushFloats( key, mat->frontEmission().ptr(), 4 );
+      pushFloats( key, mat->backAmbient().ptr(), 4 );
+      pushFloats( key, mat->backDiffuse().ptr(), 4 );
+      pushFloats( key, mat->backSpecular().ptr(), 4 );
+      pushFloats( key, mat->backEmission().ptr(), 4 );
+      float shininess[] = { mat->frontShininess(), mat->backShininess() };
+      pushFloats( key, shininess, 2 );
+      key.push_back( mat->colorMaterialFace() );
+      key.push_back( mat->colorMaterial() );
+      key.push_back( mat->colorMaterialEnabled() );
+      return true;
+    }
+    else
+    if ( rs->classType() == LightModel::Type() )
+    {
+      const LightModel* lm = static_cast<const LightModel*>(rs);
+      pushFloats( key, lm->ambientColor().ptr(), 4 );
+      key.push_back( lm->colorControl() );
+      key.push_back( lm->localViewer() );
+      key.push_back( lm->twoSide() );
+      return true;
+    }
+    else
+    if ( rs->classType() == Color::Type() )
+    {
+      pushFloats( key, static_cast<const Color*>(rs)->value().ptr(), 4 );
+      return true;
+    }
+    else
+    if ( rs->classType() == SecondaryColor::Type() )
+    {
+      pushFloats( key, static_cast<const SecondaryColor*>(rs)->value().ptr(), 3 );
+      return true;
+    }
+    else
+    if ( rs->classType() == Normal::Type() )
+    {
+      pushFloats( key, static_cast<const Normal*>(rs)->value().ptr(), 3 );
+      return true;
+    }
+    else
+    if ( rs->classType() == Fog::Type() )
+    {
+      const Fog* fog = static_cast<const Fog*>(rs);
+      pushFloats( key, fog->color().ptr(), 4 );
+      float params[] = { fog->density(), fog->start(), fog->end() };
+      pushFloats( key, params, 3 );
+      key.push_back( fog->mode() );
+      return true;
+    }
+    else
+    if ( rs->classType() == TextureSampler::Type() )
+    {
+      // the textures have already been canonicalized
+      pushPointer( key, static_cast<const TextureSampler*>(rs)->texture() );
+      return true;
+    }
+    return false;
+  }
+
+  // Packs the setup parameters of the textures not yet created, returns false for the textures which must not be merged.
+  bool textureKey(const Texture* tex, Key& key)
+  {
+    key.clear();
+    const Texture::SetupParams* setup = tex->setupParams();
+    // created textures, render targets and buffer textures are never merged
+    if ( tex->handle() || !setup || setup->bufferObject() )
+      return false;
+    const Image* img = setup->image();
+    if ( img ? !img->isValid() : setup->imagePath().empty() )
+      return false;
+
+    key.push_back( setup->dimension() );
+    key.push_back( setup->format() );
+    key.push_back( setup->border() );
+    key.push_back( setup->genMipmaps() );
+    key.push_back( setup->width() );
+    key.push_back( setup->height() );
+    key.push_back( setup->depth() );
+    key.push_back( setup->samples() );
+    key.push_back( setup->fixedSamplesLocations() );
+    key.push_back( tex->immutableStorage() );
+
+    const TexParameter* tp = tex->getTexParameter();
+    key.push_back( tp->minFilter() );
+    key.push_back( tp->magFilter() );
+    key.push_back( tp->wrapS() );
+    key.push_back( tp->wrapT() );
+    key.push_back( tp->wrapR() );
+    key.push_back( tp->compareMode() );
+    key.push_back( tp->compareFunc() );
+    key.push_back( tp->depthTextureMode() );
+    key.push_back( tp->generateMipmap() );
+    fvec4 border_color = tp->borderColor();
+    pushFloats( key, border_color.ptr(), 4 );
+    float anisotropy = tp->anisotropy();
+    pushFloats( key, &anisotropy, 1 );
+
+    if (img)
+    {
+      // images are compared by content, see sameImages()
+      key.push_back( img->width() );
+      key.push_back( img->height() );
+      key.push_back( img->depth() );
+      key.push_back( img->format() );
+      key.push_back( img->type() );
+      key.push_back( img->isCubemap() );
+      key.push_back( img->mipmaps().size() );
+      u32 hash = 0;
+      if ( img->pixels() )
+        MurmurHash3_x86_32( img->pixels(), img->requiredMemory(), 0, &hash );
+      key.push_back( hash );
+    }
+    else
+      pushString( key, setup->imagePath() );
+
+    return true;
+  }
+
+  bool sameImage(const Image* a, const Image* b)
+  {
+    if ( a == b )
+      return true;
+    if ( !a || !b || a->requiredMemory() != b->requiredMemory() || ( a->pixels() == NULL ) != ( b->pixels() == NULL ) )
+      return false;
+    return !a->pixels() || memcmp( a->pixels(), b->pixels(), a->requiredMemory() ) == 0;
+  }
+
+  // verifies the pixels of two textures having the same key
+  bool sameImages(const Object* a, const Object* b)
+  {
+    const Image* img_a = static_cast<const Texture*>(a)->setupParams()->image();
+    const Image* img_b = static_cast<const Texture*>(b)->setupParams()->image();
+    if ( !sameImage(img_a, img_b) )
+      return false;
+    if ( img_a && img_b && img_a != img_b )
+    {
+      for(size_t i=0; i<img_a->mipmaps().size(); ++i)
+      {
+        if ( !sameImage( img_a->mipmaps()[i].get(), img_b->mipmaps()[i].get() ) )
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // Packs the enables and the pointers to the canonical render states, uniforms, scissor and animator of a Shader.
+  void shaderKey(const Shader* shader, Key& key)
+  {
+    key.clear();
+
+    const EnableSet* enables = shader->getEnableSet();
+    key.push_back( enables != NULL );
+    key.push_back( enables ? enables->enableMask() : 0 );
+
+    const RenderStateSet* rss = shader->getRenderStateSet();
+    std::vector< std::pair<u64, u64> > slots;
+    if (rss)
+    {
+      for(size_t i=0; i<rss->renderStatesCount(); ++i)
+        slots.push_back( std::make_pair( (u64)rss->renderStates()[i].type(), (u64)(size_t)rss->renderStates()[i].mRS.get() ) );
+      std::sort( slots.begin(), slots.end() );
+      pushPointer( key, rss->glslProgram() );
+    }
+    key.push_back( slots.size() );
+    for(size_t i=0; i<slots.size(); ++i)
+    {
+      key.push_back( slots[i].first );
+      key.push_back( slots[i].second );
+    }
+
+    const UniformSet* uniforms = shader->getUniformSet();
+    key.push_back( uniforms ? uniforms->uniforms().size() : 0 );
+    key.push_back( uniforms ? uniforms->uniformBlocks().size() : 0 );
+    if (uniforms)
+    {
+      for(size_t i=0; i<uniforms->uniforms().size(); ++i)
+        pushPointer( key, uniforms->uniforms()[i].get() );
+      for(size_t i=0; i<uniforms->uniformBlocks().size(); ++i)
+        pushPointer( key, uniforms->uniformBlocks()[i].get() );
+    }
+
+    pushPointer( key, shader->scissor() );
+    pushPointer( key, shader->shaderAnimator() );
+    #ifdef VL_USER_DATA_SHADER
+      pushPointer( key, shader->shaderUserData() );
+    #endif
+  }
+
+  // Packs the parameters and the pointers to the canonical shaders of an Effect.
+  void effectKey(const Effect* effect, Key& key)
+  {
+    key.clear();
+    key.push_back( (u64)(i64)effect->renderRank() );
+    key.push_back( effect->enableMask() );
+    key.push_back( (u64)(i64)effect->activeLod() );
+    pushPointer( key, effect->lodEvaluator() );
+    for(int lod=0; lod<VL_MAX_EFFECT_LOD; ++lod)
+    {
+      const ShaderPasses* passes = effect->lod(lod).get();
+      key.push_back( passes ? (u64)passes->size() : ~(u64)0 );
+      for(int i=0; passes && i<passes->size(); ++i)
+        pushPointer( key, passes->at(i) );
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+// StateDeduplicator
+//-----------------------------------------------------------------------------
+void StateDeduplicator::deduplicate(ResourceDatabase* db)
+{
+  std::vector< ref<Actor> > actors;
+  std::vector< ref<Effect> > db_effects;
+  std::vector< ref<Shader> > db_shaders;
+  std::vector< ref<Texture> > db_textures;
+  db->get<Actor>(actors);
+  db->get<Effect>(db_effects);
+  db->get<Shader>(db_shaders);
+  db->get<Texture>(db_textures);
+
+  std::vector<Effect*> effects;
+  std::vector<Shader*> shaders;
+  std::vector<Texture*> textures;
+  for(size_t i=0; i<actors.size(); ++i)
+  {
+    if ( actors[i]->effect() )
+      effects.push_back( actors[i]->effect() );
+  }
+  for(size_t i=0; i<db_effects.size(); ++i)
+    effects.push_back( db_effects[i].get() );
+  for(size_t i=0; i<db_shaders.size(); ++i)
+    shaders.push_back( db_shaders[i].get() );
+  for(size_t i=0; i<db_textures.size(); ++i)
+    textures.push_back( db_textures[i].get() );
+
+  run(effects, shaders, textures);
+
+  for(size_t i=0; i<actors.size(); ++i)
+  {
+    if ( actors[i]->effect() )
+      actors[i]->setEffect( canonical( actors[i]->effect() )->as<Effect>() );
+  }
+
+  // replace the merged resources with their canonical objects, keeping only the first occurrence of each
+  if ( mergedEffects() || mergedShaders() || mergedRenderStates() || mergedTextures() )
+  {
+    std::set<const Object*> present;
+    for(size_t i=0; i<db->resources().size(); ++i)
+      present.insert( db->resources()[i].get() );
+
+    std::vector< ref<Object> > resources;
+    resources.reserve( db->resources().size() );
+    for(size_t i=0; i<db->resources().size(); ++i)
+    {
+      Object* obj = db->resources()[i].get_writable();
+      Object* canon = canonical(obj);
+      if ( canon != obj )
+      {
+        if ( present.find(canon) != present.end() )
+          continue;
+        present.insert(canon);
+      }
+      resources.push_back(canon);
+    }
+    db->resources().swap(resources);
+  }
+
+  mCanonical.clear();
+  mDuplicates.clear();
+}
+//-----------------------------------------------------------------------------
+void StateDeduplicator::deduplicate(ActorCollection& actors)
+{
+  std::vector<Effect*> effects;
+  for(int i=0; i<actors.size(); ++i)
+  {
+    if ( actors[i]->effect() )
+      effects.push_back( actors[i]->effect() );
+  }
+
+  run( effects, std::vector<Shader*>(), std::vector<Texture*>() );
+
+  for(int i=0; i<actors.size(); ++i)
+  {
+    if ( actors[i]->effect() )
+      actors[i]->setEffect( canonical( actors[i]->effect() )->as<Effect>() );
+  }
+
+  mCanonical.clear();
+  mDuplicates.clear();
+}
+//-----------------------------------------------------------------------------
+void StateDeduplicator::deduplicate(std::vector< ref<Effect> >& effects)
+{
+  std::vector<Effect*> ptrs;
+  for(size_t i=0; i<effects.size(); ++i)
+  {
+    if ( effects[i] )
+      ptrs.push_back( effects[i].get() );
+  }
+
+  run( ptrs, std::vector<Shader*>(), std::vector<Texture*>() );
+
+  for(size_t i=0; i<effects.size(); ++i)
+  {
+    if ( effects[i] )
+      effects[i] = canonical( effects[i].get() )->as<Effect>();
+  }
+
+  mCanonical.clear();
+  mDuplicates.clear();
+}
+//-----------------------------------------------------------------------------
+Object* StateDeduplicator::canonical(Object* obj) const
+{
+  std::map<Object*, Object*>::const_iterator it = mCanonical.find(obj);
+  return it != mCanonical.end() ? it->second : obj;
+}
+//-----------------------------------------------------------------------------
+void StateDeduplicator::merge(Object* duplicate, Object* canon)
+{
+  mCanonical[duplicate] = canon;
+  // keeps the duplicate alive so that its address is not reused while mCanonical refers to it
+  mDuplicates.push_back(duplicate);
+}
+//-----------------------------------------------------------------------------
+void StateDeduplicator::run(const std::vector<Effect*>& effects_in, const std::vector<Shader*>& shaders_in, const std::vector<Texture*>& textures_in)
+{
+  mCanonical.clear();
+  mDuplicates.clear();
+  mMergedEffects = 0;
+  mMergedShaders = 0;
+  mMergedRenderStates = 0;
+  mMergedTextures = 0;
+
+  // collect the unique effects, shaders and textures
+  std::vector<Effect*> effects;
+  std::set<Effect*> seen_effects;
+  for(size_t i=0; i<effects_in.size(); ++i)
+  {
+    if ( seen_effects.insert( effects_in[i] ).second )
+      effects.push_back( effects_in[i] );
+  }
+
+  std::vector<Shader*> shaders;
+  std::set<Shader*> seen_shaders;
+  for(size_t ieff=0; ieff<effects.size(); ++ieff)
+  {
+    for(int lod=0; lod<VL_MAX_EFFECT_LOD; ++lod)
+    {
+      ShaderPasses* passes = effects[ieff]->lod(lod).get();
+      for(int i=0; passes && i<passes->size(); ++i)
+      {
+        if ( passes->at(i) && seen_shaders.insert( passes->at(i) ).second )
+          shaders.push_back( passes->at(i) );
+      }
+    }
+  }
+  for(size_t i=0; i<shaders_in.size(); ++i)
+  {
+    if ( seen_shaders.insert( shaders_in[i] ).second )
+      shaders.push_back( shaders_in[i] );
+  }
+
+  Key key;
+
+  // textures
+  if ( mergeTextures() )
+  {
+    std::vector<Texture*> textures;
+    std::set<Texture*> seen_textures;
+    for(size_t ish=0; ish<shaders.size(); ++ish)
+    {
+      RenderStateSet* rss = shaders[ish]->getRenderStateSet();
+      for(size_t i=0; rss && i<rss->renderStatesCount(); ++i)
+      {
+        RenderState* rs = rss->renderStates()[i].mRS.get();
+        if ( rs && rs->type() == RS_TextureSampler )
+        {
+          Texture* tex = static_cast<TextureSampler*>(rs)->texture();
+          if ( tex && seen_textures.insert(tex).second )
+            textures.push_back(tex);
+        }
+      }
+    }
+    for(size_t i=0; i<textures_in.size(); ++i)
+    {
+      if ( seen_textures.insert( textures_in[i] ).second )
+        textures.push_back( textures_in[i] );
+    }
+
+    CanonicalTable table;
+    for(size_t i=0; i<textures.size(); ++i)
+    {
+      if ( textureKey( textures[i], key ) )
+      {
+        Object* canon = table.insert( key, textures[i], sameImages );
+        if ( canon != textures[i] )
+        {
+          merge( textures[i], canon );
+          ++mMergedTextures;
+        }
+      }
+    }
+
+    if ( mMergedTextures )
+    {
+      for(size_t ish=0; ish<shaders.size(); ++ish)
+      {
+        RenderStateSet* rss = shaders[ish]->getRenderStateSet();
+        for(size_t i=0; rss && i<rss->renderStatesCount(); ++i)
+        {
+          RenderState* rs = rss->renderStates()[i].mRS.get();
+          if ( rs && rs->type() == RS_TextureSampler )
+          {
+            TextureSampler* sampler = static_cast<TextureSampler*>(rs);
+            if ( sampler->texture() )
+              sampler->setTexture( canonical( sampler->texture() )->as<Texture>() );
+          }
+        }
+      }
+    }
+  }
+
+  // render states: hashed by value when known, otherwise compared with RenderState::isEquivalent()
+  CanonicalTable state_table;
+  std::map< int, std::vector<RenderState*> > equivalent_states;
+  std::set<RenderState*> seen_states;
+  for(size_t ish=0; ish<shaders.size(); ++ish)
+  {
+    RenderStateSet* rss = shaders[ish]->getRenderStateSet();
+    for(size_t i=0; rss && i<rss->renderStatesCount(); ++i)
+    {
+      RenderStateSlot& slot = rss->renderStates()[i];
+      RenderState* rs = slot.mRS.get();
+      if ( !rs || rs->type() == RS_GLSLProgram )
+        continue;
+
+      if ( seen_states.insert(rs).second )
+      {
+        RenderState* canon = rs;
+        if ( renderStateKey( rs, key ) )
+          canon = static_cast<RenderState*>( state_table.insert( key, rs ) );
+        else
+        {
+          std::vector<RenderState*>& candidates = equivalent_states[ rs->type() ];
+          for(size_t j=0; j<candidates.size(); ++j)
+          {
+            if ( candidates[j]->isEquivalent(rs) )
+            {
+              canon = candidates[j];
+              break;
+            }
+          }
+          if ( canon == rs )
+            candidates.push_back(rs);
+        }
+
+        if ( canon != rs )
+        {
+          merge( rs, canon );
+          ++mMergedRenderStates;
+        }
+      }
+
+      slot.mRS = canonical(rs)->as<RenderState>();
+    }
+  }
+
+  // shaders
+  CanonicalTable shader_table;
+  for(size_t i=0; i<shaders.size(); ++i)
+  {
+    shaderKey( shaders[i], key );
+    Object* canon = shader_table.insert( key, shaders[i] );
+    if ( canon != shaders[i] )
+    {
+      merge( shaders[i], canon );
+      ++mMergedShaders;
+    }
+  }
+
+  // effects
+  CanonicalTable effect_table;
+  for(size_t ieff=0; ieff<effects.size(); ++ieff)
+  {
+    for(int lod=0; mMergedShaders && lod<VL_MAX_EFFECT_LOD; ++lod)
+    {
+      ShaderPasses* passes = effects[ieff]->lod(lod).get();
+      for(int i=0; passes && i<passes->size(); ++i)
+      {
+        if ( passes->at(i) )
+          passes->set( i, canonical( passes->at(i) )->as<Shader>() );
+      }
+    }
+
+    effectKey( effects[ieff], key );
+    Object* canon = effect_table.insert( key, effects[ieff] );
+    if ( canon != effects[ieff] )
+    {
+      merge( effects[ieff], canon );
+      ++mMergedEffects;
+    }
+  }
+
+  if ( mMergedEffects || mMergedShaders || mMergedRenderStates || mMergedTextures )
+  {
+    DirtyTracker::markDirty();
+    Log::debug( Say("StateDeduplicator: merged %n effects, %n shaders, %n render states and %n textures.\n")
+      << mMergedEffects << mMergedShaders << mMergedRenderStates << mMergedTextures );
+  }
+}
+//-----------------------------------------------------------------------------
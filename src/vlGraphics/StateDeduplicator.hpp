@@ -0,0 +1,151 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#ifndef StateDeduplicator_INCLUDE_ONCE
+#define StateDeduplicator_INCLUDE_ONCE
+
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlCore/LoadWriterManager.hpp>
+#include <vector>
+#include <map>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // StateDeduplicator
+  //-----------------------------------------------------------------------------
+  /**
+   * Merges the Effect[s], Shader[s], RenderState[s] and Texture[s] which are separate objects but have the same value.
+   *
+   * Loaders usually create a new Effect and a new set of render states for every mesh or material, even when they are identical.
+   * Since RenderQueueSorterStandard and the state caching of OpenGLContext compare these objects by pointer, duplicates
+   * prevent the batching of the Actor[s] and cause redundant state changes. deduplicate() canonicalizes the objects bottom-up:
+   * - Texture[s] not yet created with the same SetupParams, TexParameter values and Image contents (or image path).
+   * - RenderState[s] of the same type with the same values: Material, LightModel, Color, SecondaryColor, Normal, Fog,
+   *   TextureSampler[s] bound to the same Texture and all the render states implementing RenderState::isEquivalent().
+   * - Shader[s] with the same enables, the same canonical render states and the same Uniform[s], Scissor and ShaderAnimator.
+   * - Effect[s] with the same canonical Shader[s] in every LOD, render rank, enable mask and LODEvaluator.
+   *
+   * Each object is hashed with MurmurHash3 from a key packing its values, or the pointers of its canonical sub-objects,
+   * and is replaced by the first object found with the same key. The merged objects are removed from the ResourceDatabase.
+   *
+   * \code
+   * // run on every loaded resource
+   * defLoadWriterManager()->loadCallbacks().push_back( new StateDeduplicatorLoadCallback );
+   * \endcode
+   *
+   * \remarks
+   * - After deduplication modifying the Effect, Shader or render state of an Actor affects all the Actor[s] sharing it:
+   *   use Shader::deepCopy() or RenderState::clone() to modify a single one.
+   * - Other render states like GLSLProgram, Light and ClipPlane, and the Uniform[s], are merged only when they are the same object.
+   *
+   * \sa RenderQueueSorterStandard, GeometryLoadCallback, DoubleVertexRemover
+   */
+  class VLGRAPHICS_EXPORT StateDeduplicator: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::StateDeduplicator, Object)
+
+  public:
+    StateDeduplicator(): mMergedEffects(0), mMergedShaders(0), mMergedRenderStates(0), mMergedTextures(0), mMergeTextures(true) {}
+
+    //! Deduplicates the Effect[s] of the Actor[s] and the Effect[s], Shader[s] and Texture[s] contained in \p db,
+    //! replacing the duplicates in the Actor[s] and in the database.
+    void deduplicate(ResourceDatabase* db);
+
+    //! Deduplicates the Effect[s] of the given Actor[s].
+    void deduplicate(ActorCollection& actors);
+
+    //! Deduplicates the given Effect[s] replacing each one with its canonical Effect.
+    void deduplicate(std::vector< ref<Effect> >& effects);
+
+    //! Whether the Texture[s] are merged as well (default = true).
+    void setMergeTextures(bool merge) { mMergeTextures = merge; }
+    //! Whether the Texture[s] are merged as well (default = true).
+    bool mergeTextures() const { return mMergeTextures; }
+
+    //! Number of Effect[s] merged by the last deduplicate().
+    int mergedEffects() const { return mMergedEffects; }
+    //! Number of Shader[s] merged by the last deduplicate().
+    int mergedShaders() const { return mMergedShaders; }
+    //! Number of RenderState[s] merged by the last deduplicate().
+    int mergedRenderStates() const { return mMergedRenderStates; }
+    //! Number of Texture[s] merged by the last deduplicate().
+    int mergedTextures() const { return mMergedTextures; }
+
+  protected:
+    //! Canonicalizes the given objects and fills mCanonical.
+    void run(const std::vector<Effect*>& effects, const std::vector<Shader*>& shaders, const std::vector<Texture*>& textures);
+
+    //! Returns the canonical object of \p obj, \p obj itself if it was not merged.
+    Object* canonical(Object* obj) const;
+
+    //! Records that \p duplicate is replaced by \p canon.
+    void merge(Object* duplicate, Object* canon);
+
+  protected:
+    std::map<Object*, Object*> mCanonical;
+    std::vector< ref<Object> > mDuplicates;
+    int mMergedEffects;
+    int mMergedShaders;
+    int mMergedRenderStates;
+    int mMergedTextures;
+    bool mMergeTextures;
+  };
+  //-----------------------------------------------------------------------------
+  // StateDeduplicatorLoadCallback
+  //-----------------------------------------------------------------------------
+  /** LoadCallback running a StateDeduplicator on every loaded ResourceDatabase, see LoadWriterManager::loadCallbacks(). */
+  class StateDeduplicatorLoadCallback: public LoadCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::StateDeduplicatorLoadCallback, LoadCallback)
+
+  public:
+    StateDeduplicatorLoadCallback(): mMergeTextures(true) {}
+
+    void operator()(ResourceDatabase* db)
+    {
+      StateDeduplicator deduplicator;
+      deduplicator.setMergeTextures( mergeTextures() );
+      deduplicator.deduplicate(db);
+    }
+
+    //! Whether the Texture[s] are merged as well (default = true).
+    void setMergeTextures(bool merge) { mMergeTextures = merge; }
+    //! Whether the Texture[s] are merged as well (default = true).
+    bool mergeTextures() const { return mMergeTextures; }
+
+  protected:
+    bool mMergeTextures;
+  };
+}
+
+#endif
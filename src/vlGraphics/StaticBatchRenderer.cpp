@@ -0,0 +1,525 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/StaticBatchRenderer.hpp>
+#include <vlCore/Log.hpp>
+#include <algorithm>
+#include <cstring>
+
+using namespace vl;
+
+namespace
+{
+  // writes m * v in the given range of a float array, with w = 1 for positions and w = 0 for the directions, which are
+  // renormalized. The 4th component of a direction, the handedness of a tangent, is kept and multiplied by \p handedness.
+  template<class T_Array>
+  void transformRange(T_Array* arr, size_t first, size_t count, const mat4& m, bool direction, GLfloat handedness)
+  {
+    const int size = (int)arr->glSize();
+    const int xyz = direction && size == 4 ? 3 : size;
+    for(size_t i=first; i<first+count; ++i)
+    {
+      GLfloat* pv = reinterpret_cast<GLfloat*>(&arr->at(i));
+      vec4 v(0, 0, 0, direction ? (real)0 : (real)1);
+      for(int j=0; j<xyz; ++j)
+        v.ptr()[j] = (real)pv[j];
+      v = m * v;
+      if (direction)
+      {
+        vec3 n = v.xyz();
+        n.normalize();
+        v = vec4(n, 0);
+      }
+      for(int j=0; j<xyz; ++j)
+        pv[j] = (GLfloat)v.ptr()[j];
+      if (xyz != size)
+        pv[3] *= handedness;
+    }
+  }
+
+  void transformArray(ArrayAbstract* arr, size_t first, size_t count, const mat4& m, bool direction, GLfloat handedness)
+  {
+    if (ArrayFloat3* arr3 = arr->as<ArrayFloat3>())
+      transformRange(arr3, first, count, m, direction, handedness);
+    else
+    if (ArrayFloat4* arr4 = arr->as<ArrayFloat4>())
+      transformRange(arr4, first, count, m, direction, handedness);
+  }
+
+  bool isFloatArray(const ArrayAbstract* arr)
+  {
+    return arr->as<ArrayFloat3>() || arr->as<ArrayFloat4>();
+  }
+}
+
+//-----------------------------------------------------------------------------
+// StaticBatchRenderer::Batch
+//-----------------------------------------------------------------------------
+StaticBatchRenderer::Batch::Batch(): mPrimitiveType(PT_TRIANGLES), mLastUsed(0), mDirty(true)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mGeometry = new Geometry;
+  mDrawCall = new MultiDrawElementsUInt;
+  mDrawCall->setIndexBuffer( new ArrayUInt1 );
+  mGeometry->drawCalls().push_back( mDrawCall.get() );
+  mActor = new Actor( mGeometry.get() );
+}
+//-----------------------------------------------------------------------------
+bool StaticBatchRenderer::Batch::compatible(const Geometry* geom, const Geometry* ref_geom)
+{
+  if ( geom->drawCalls().at(0)->primitiveType() != ref_geom->drawCalls().at(0)->primitiveType() )
+    return false;
+
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+  {
+    const ArrayAbstract* a = geom->vertexAttribArray(i);
+    const ArrayAbstract* b = ref_geom->vertexAttribArray(i);
+    if ( (a == NULL) != (b == NULL) )
+      return false;
+    if ( a == NULL )
+      continue;
+    if ( a->glType() != b->glType() || a->glSize() != b->glSize() ||
+         a->normalize() != b->normalize() || a->interpretation() != b->interpretation() )
+      return false;
+    if ( a->size() != geom->vertexArray()->size() )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool StaticBatchRenderer::Batch::accepts(const RenderToken* tok, const Geometry* first) const
+{
+  const Geometry* geom = static_cast<const Geometry*>(tok->mRenderable);
+  if ( mSlotMap.find( std::make_pair(tok->mActor, geom) ) != mSlotMap.end() )
+    return true;
+  // the first geometry defines the layout of the batch
+  return compatible( geom, mSlots.empty() ? first : mSlots[0].mGeometry.get() );
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::transformSlot(const Slot& slot)
+{
+  // the attributes in object space: positions, normals and the tangent space directions
+  const int attribs[] = { VA_Position, VA_Normal, VA_Tangent, VA_Bitangent };
+  const size_t count = slot.mGeometry->vertexArray()->size();
+
+  for(int i=0; i<4; ++i)
+  {
+    ArrayAbstract* dst = mGeometry->vertexAttribArray( attribs[i] );
+    if (!dst)
+      continue;
+    const ArrayAbstract* src = slot.mGeometry->vertexAttribArray( attribs[i] );
+    memcpy( dst->ptr() + slot.mFirstVertex * (dst->bytesUsed() / dst->size()), src->ptr(), src->bytesUsed() );
+
+    if ( slot.mActor->transform() )
+    {
+      const mat4& world = slot.mActor->transform()->worldMatrix();
+      if ( attribs[i] == VA_Position )
+        transformArray( dst, slot.mFirstVertex, count, world, false, 1 );
+      else
+      if ( attribs[i] == VA_Normal )
+        transformArray( dst, slot.mFirstVertex, count, world.getInverse().getTransposed(), true, 1 );
+      else
+      {
+        // the tangents lie on the surface and follow the world matrix, a mirroring transform flips their handedness
+        const real det = dot( cross( world.getX(), world.getY() ), world.getZ() );
+        transformArray( dst, slot.mFirstVertex, count, world, true, det < 0 ? -1.0f : 1.0f );
+      }
+    }
+
+    dst->setBufferObjectDirty(true);
+  }
+  mGeometry->setBufferObjectDirty(true);
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::collectIndices(Slot& slot, GLuint first_index, std::vector<GLuint>& indices)
+{
+  slot.mRanges.clear();
+  const Collection<DrawCall>& dcs = slot.mGeometry->drawCalls();
+  for(int idc=0; idc<dcs.size(); ++idc)
+  {
+    if ( !dcs.at(idc)->isEnabled() )
+      continue;
+    Range range;
+    range.mFirst = first_index + (GLuint)indices.size();
+    for(IndexIterator iit = dcs.at(idc)->indexIterator(); iit.hasNext(); iit.next())
+      indices.push_back( slot.mFirstVertex + iit.index() );
+    range.mCount = (GLsizei)(first_index + indices.size() - range.mFirst);
+    if (range.mCount)
+      slot.mRanges.push_back(range);
+  }
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::updateBounds()
+{
+  // the bounds cover all the slots, not only the ones referenced by the current draw call
+  const ArrayAbstract* pos = mGeometry->vertexArray();
+  mGeometry->setBoundingBox( pos->computeBoundingBox() );
+  mGeometry->setBoundingSphere( pos->computeBoundingSphere() );
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::rebuild()
+{
+  mDirty = false;
+
+  size_t vertex_count = 0;
+  for(size_t i=0; i<mSlots.size(); ++i)
+  {
+    mSlots[i].mFirstVertex = (GLuint)vertex_count;
+    vertex_count += mSlots[i].mGeometry->vertexArray()->size();
+  }
+
+  // vertex attributes
+
+  const Geometry* ref_geom = mSlots[0].mGeometry.get();
+  for(int iattr=0; iattr<VA_MaxAttribCount; ++iattr)
+  {
+    const ArrayAbstract* src0 = ref_geom->vertexAttribArray(iattr);
+    if (!src0)
+    {
+      mGeometry->setVertexAttribArray(iattr, NULL);
+      continue;
+    }
+
+    ref<ArrayAbstract> dst = src0->clone();
+    const size_t bpv = src0->bytesUsed() / src0->size();
+    dst->bufferObject()->resize( vertex_count * bpv );
+    for(size_t i=0; i<mSlots.size(); ++i)
+    {
+      const ArrayAbstract* src = mSlots[i].mGeometry->vertexAttribArray(iattr);
+      memcpy( dst->ptr() + mSlots[i].mFirstVertex * bpv, src->ptr(), src->bytesUsed() );
+    }
+    mGeometry->setVertexAttribArray(iattr, dst.get());
+  }
+
+  // indices: one range per source draw call
+
+  std::vector<GLuint> indices;
+  for(size_t i=0; i<mSlots.size(); ++i)
+    collectIndices( mSlots[i], 0, indices );
+
+  ArrayUInt1* index_buffer = mDrawCall->indexBuffer();
+  index_buffer->resize( indices.size() );
+  if (!indices.empty())
+    memcpy( index_buffer->ptr(), &indices[0], indices.size() * sizeof(GLuint) );
+  index_buffer->setBufferObjectDirty(true);
+
+  // world space positions and normals
+
+  for(size_t i=0; i<mSlots.size(); ++i)
+  {
+    transformSlot( mSlots[i] );
+    mSlots[i].mTransformTick = mSlots[i].mActor->transform() ? mSlots[i].mActor->transform()->worldMatrixUpdateTick() : -1;
+  }
+
+  updateBounds();
+  mGeometry->setBufferObjectDirty(true);
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::appendSlot(Slot& slot)
+{
+  const size_t first_vertex = mGeometry->vertexArray()->size();
+  const size_t vertex_count = slot.mGeometry->vertexArray()->size();
+  slot.mFirstVertex = (GLuint)first_vertex;
+
+  // vertex attributes, the arrays of the batch keep their content when resized
+
+  for(int iattr=0; iattr<VA_MaxAttribCount; ++iattr)
+  {
+    ArrayAbstract* dst = mGeometry->vertexAttribArray(iattr);
+    if (!dst)
+      continue;
+    const ArrayAbstract* src = slot.mGeometry->vertexAttribArray(iattr);
+    const size_t bpv = src->bytesUsed() / src->size();
+    dst->bufferObject()->resize( (first_vertex + vertex_count) * bpv );
+    memcpy( dst->ptr() + first_vertex * bpv, src->ptr(), src->bytesUsed() );
+    dst->setBufferObjectDirty(true);
+  }
+
+  // indices
+
+  std::vector<GLuint> indices;
+  ArrayUInt1* index_buffer = mDrawCall->indexBuffer();
+  const size_t first_index = index_buffer->size();
+  collectIndices( slot, (GLuint)first_index, indices );
+  index_buffer->resize( first_index + indices.size() );
+  if (!indices.empty())
+    memcpy( index_buffer->ptr() + first_index * sizeof(GLuint), &indices[0], indices.size() * sizeof(GLuint) );
+  index_buffer->setBufferObjectDirty(true);
+
+  // world space positions and normals
+
+  transformSlot( slot );
+  slot.mTransformTick = slot.mActor->transform() ? slot.mActor->transform()->worldMatrixUpdateTick() : -1;
+}
+//-----------------------------------------------------------------------------
+bool StaticBatchRenderer::Batch::releaseUnused(unsigned int frame, unsigned int max_unused)
+{
+  size_t kept = 0;
+  for(size_t i=0; i<mSlots.size(); ++i)
+  {
+    if ( frame - mSlots[i].mLastSeen > max_unused )
+      continue;
+    if ( kept != i )
+      mSlots[kept] = mSlots[i];
+    ++kept;
+  }
+
+  if ( kept == mSlots.size() )
+    return true;
+
+  // the released slots drop their references to the Actor[s] and Geometry[s], the batch is compacted by its next prepare()
+  mSlots.resize( kept );
+  mSlotMap.clear();
+  for(size_t i=0; i<mSlots.size(); ++i)
+    mSlotMap[ std::make_pair( (const Actor*)mSlots[i].mActor.get(), (const Geometry*)mSlots[i].mGeometry.get() ) ] = (int)i;
+  mDirty = true;
+
+  return !mSlots.empty();
+}
+//-----------------------------------------------------------------------------
+void StaticBatchRenderer::Batch::prepare(const RenderToken* const* tokens, int count, unsigned int frame)
+{
+  VL_CHECK(count > 0)
+
+  mLastUsed = frame;
+
+  // register the new Actor/Geometry pairs, all accepted by accepts()
+
+  const size_t first_new = mSlots.size();
+  for(int i=0; i<count; ++i)
+  {
+    const Geometry* geom = static_cast<const Geometry*>(tokens[i]->mRenderable);
+    std::pair<const Actor*, const Geometry*> key(tokens[i]->mActor, geom);
+    if ( mSlotMap.find(key) == mSlotMap.end() )
+    {
+      VL_CHECK( compatible( geom, mSlots.empty() ? geom : mSlots[0].mGeometry.get() ) )
+      if ( mSlots.empty() )
+        mPrimitiveType = geom->drawCalls().at(0)->primitiveType();
+      mSlotMap[key] = (int)mSlots.size();
+      mSlots.push_back( Slot() );
+      mSlots.back().mActor = tokens[i]->mActor;
+      mSlots.back().mGeometry = const_cast<Geometry*>(geom);
+      mSlots.back().mTransformTick = -1;
+      mSlots.back().mFirstVertex = 0;
+      mSlots.back().mLastSeen = frame;
+    }
+  }
+
+  // the first time or after releasing some slots the whole batch is built, otherwise the new slots are appended
+
+  bool moved = false;
+  if (mDirty)
+    rebuild();
+  else
+  if ( first_new < mSlots.size() )
+  {
+    for(size_t i=first_new; i<mSlots.size(); ++i)
+      appendSlot( mSlots[i] );
+    moved = true;
+  }
+
+  // collect the ranges of the visible slots, re-transforming the moved ones
+
+  mRanges.clear();
+  for(int i=0; i<count; ++i)
+  {
+    std::pair<const Actor*, const Geometry*> key(tokens[i]->mActor, static_cast<const Geometry*>(tokens[i]->mRenderable));
+    Slot& slot = mSlots[ mSlotMap[key] ];
+    slot.mLastSeen = frame;
+    long long tick = slot.mActor->transform() ? slot.mActor->transform()->worldMatrixUpdateTick() : -1;
+    if (tick != slot.mTransformTick)
+    {
+      transformSlot(slot);
+      slot.mTransformTick = tick;
+      moved = true;
+    }
+    mRanges.insert( mRanges.end(), slot.mRanges.begin(), slot.mRanges.end() );
+  }
+  if (moved)
+    updateBounds();
+
+  // merge contiguous ranges
+  std::sort( mRanges.begin(), mRanges.end() );
+  std::vector<GLsizei>& counts = mDrawCall->countVector();
+  std::vector<const GLuint*>& pointers = mDrawCall->pointerVector();
+  std::vector<const GLuint*>& bo_pointers = mDrawCall->bufferObjectPointerVector();
+  counts.clear();
+  pointers.clear();
+  bo_pointers.clear();
+  mDrawCall->baseVertices().clear();
+  const GLuint* base = (const GLuint*)mDrawCall->indexBuffer()->ptr();
+  GLuint end = 0;
+  for(size_t i=0; i<mRanges.size(); ++i)
+  {
+    if ( !counts.empty() && end == mRanges[i].mFirst )
+      counts.back() += mRanges[i].mCount;
+    else
+    {
+      counts.push_back( mRanges[i].mCount );
+      pointers.push_back( base + mRanges[i].mFirst );
+      bo_pointers.push_back( (const GLuint*)NULL + mRanges[i].mFirst );
+    }
+    end = mRanges[i].mFirst + mRanges[i].mCount;
+  }
+  mDrawCall->setPrimitiveType( mPrimitiveType );
+  mDrawCall->setEnabled( !counts.empty() );
+}
+//-----------------------------------------------------------------------------
+// StaticBatchRenderer
+//-----------------------------------------------------------------------------
+StaticBatchRenderer::StaticBatchRenderer(): mFrame(0), mMinBatchSize(2), mStatsBatchedObjects(0), mStatsBatches(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mBatchedRenderQueue = new RenderQueue;
+}
+//-----------------------------------------------------------------------------
+bool StaticBatchRenderer::isBatchable(const RenderToken* tok)
+{
+  if ( tok->mNextPass || tok->mShader->isBlendingEnabled() )
+    return false;
+
+  const Actor* actor = tok->mActor;
+  if ( !isEnabled(actor) || actor->scissor() || !actor->actorEventCallbacks()->empty() ||
+       ( actor->getUniformSet() && !actor->getUniformSet()->empty() ) )
+    return false;
+
+  for( std::map< unsigned int, ref<Shader> >::const_iterator eom_it = mShaderOverrideMask.begin(); eom_it != mShaderOverrideMask.end(); ++eom_it )
+  {
+    if ( eom_it->first & actor->enableMask() )
+      return false;
+  }
+
+  const Geometry* geom = tok->mRenderable->as<Geometry>();
+  if ( !geom || geom->isDisplayListEnabled() || geom->drawCalls().empty() ||
+       !geom->vertexArray() || !geom->vertexArray()->size() || !isFloatArray(geom->vertexArray()) ||
+       ( geom->normalArray() && !geom->normalArray()->as<ArrayFloat3>() ) ||
+       ( geom->vertexAttribArray(VA_Tangent) && !isFloatArray(geom->vertexAttribArray(VA_Tangent)) ) ||
+       ( geom->vertexAttribArray(VA_Bitangent) && !isFloatArray(geom->vertexAttribArray(VA_Bitangent)) ) )
+    return false;
+
+  // the per-vertex positions, directions and skinning data of morphing and skinned geometry cannot be merged in world space
+  if ( geom->vertexAttribArray(VA_NextPosition) || geom->vertexAttribArray(VA_NextNormal) || geom->vertexAttribArray(VA_JointIndices) )
+    return false;
+
+  const EPrimitiveType type = geom->drawCalls().at(0)->primitiveType();
+  if ( type == PT_PATCHES )
+    return false;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    const DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->primitiveType() != type || dc->instances() != 1 || dc->primitiveRestartEnabled() )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* StaticBatchRenderer::render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock)
+{
+  mStatsBatchedObjects = 0;
+  mStatsBatches = 0;
+  mBatchedRenderQueue->clear();
+  ++mFrame;
+
+  for(int i=0; i<in_render_queue->size(); )
+  {
+    const RenderToken* tok = in_render_queue->at(i);
+
+    std::map< const Shader*, ref<Batch> >::iterator it = mBatches.find(tok->mShader);
+    Batch* batch = it != mBatches.end() ? it->second.get() : NULL;
+
+    // collect the run of batchable tokens sharing the same Shader, cut at the first one not fitting the layout of the batch.
+    // A batch has a single draw call, so only the first run of a Shader is batched in a frame.
+    mRun.clear();
+    if ( !batch || batch->lastUsed() != mFrame )
+    {
+      const Geometry* first = static_cast<const Geometry*>(tok->mRenderable);
+      for(int j=i; j<in_render_queue->size(); ++j)
+      {
+        const RenderToken* tok_j = in_render_queue->at(j);
+        if ( tok_j->mShader != tok->mShader || !isBatchable(tok_j) )
+          break;
+        if ( batch ? !batch->accepts(tok_j, first) : !Batch::compatible(static_cast<const Geometry*>(tok_j->mRenderable), first) )
+          break;
+        mRun.push_back(tok_j);
+      }
+    }
+
+    if ( (int)mRun.size() >= mMinBatchSize && !mRun.empty() )
+    {
+      if (!batch)
+      {
+        batch = new Batch;
+        mBatches[tok->mShader] = batch;
+      }
+      batch->prepare( &mRun[0], (int)mRun.size(), mFrame );
+      batch->actor()->setEffect( tok->mActor->effect() );
+      batch->actor()->setEnableMask( tok->mActor->enableMask() );
+      batch->actor()->setRenderBlock( tok->mActor->renderBlock() );
+      batch->actor()->setRenderRank( tok->mActor->renderRank() );
+
+      RenderToken* batch_tok = mBatchedRenderQueue->newToken(false);
+      *batch_tok = *tok;
+      batch_tok->mActor = batch->actor();
+      batch_tok->mRenderable = batch->geometry();
+      batch_tok->mNextPass = NULL;
+
+      i += (int)mRun.size();
+      mStatsBatchedObjects += (int)mRun.size();
+      ++mStatsBatches;
+      continue;
+    }
+
+    // pass over the token as it is
+    RenderToken* out_tok = mBatchedRenderQueue->newToken(false);
+    *out_tok = *tok;
+    ++i;
+  }
+
+  Renderer::render( mBatchedRenderQueue.get(), camera, frame_clock );
+
+  // release the Actor[s] not rendered for a while and drop the batches left empty
+  if ( ( mFrame & 63 ) == 0 )
+  {
+    for( std::map< const Shader*, ref<Batch> >::iterator it = mBatches.begin(); it != mBatches.end(); )
+    {
+      if ( !it->second->releaseUnused( mFrame, 64 ) )
+        mBatches.erase( it++ );
+      else
+        ++it;
+    }
+  }
+
+  return in_render_queue;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,172 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef StaticBatchRenderer_INCLUDE_ONCE
+#define StaticBatchRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/MultiDrawElements.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // StaticBatchRenderer
+  //------------------------------------------------------------------------------
+  /** A Renderer that merges consecutive RenderToken[s] sharing the same Shader into a single multi-draw call.
+    *
+    * The Geometry[s] of the batched Actor[s] are copied, pre-transformed in world space, into a per-Shader batch
+    * Geometry which accumulates all the Actor[s] seen with that Shader: an Actor seen for the first time is appended to it,
+    * while every frame only the ranges of the visible Actor[s] are submitted using a single glMultiDrawElements() call.
+    * When the Transform of a batched Actor changes only its vertices are re-transformed. The Actor[s] not rendered for
+    * 64 frames are released and the batch is rebuilt the next time it is used, the batches left empty are dropped.
+    * Only the first run of consecutive tokens of a Shader is batched in a frame, the following ones are rendered as they are.
+    *
+    * A RenderToken is batched only if:
+    * - it is a single pass token and its Shader does not enable blending
+    * - its Renderable is a Geometry with no display list, a float position array and, if any, float normal, tangent and
+    *   bitangent arrays (\p VA_Tangent, \p VA_Bitangent)
+    * - its Geometry has no \p VA_NextPosition, \p VA_NextNormal / \p VA_JointWeights or \p VA_JointIndices array
+    * - all the draw calls of its Geometry share the same primitive type, are not instanced and do not use primitive restart
+    * - its Actor has no Scissor, no ActorEventCallback, no Actor uniforms and is not subject to the shaderOverrideMask()
+    * - its Geometry has the same vertex attribute layout of the other Geometry[s] of the batch
+    *
+    * The batched Actor[s] are rendered with no Transform, i.e. \p vl_ModelViewMatrix is the view matrix.
+    * Only the positions, normals, tangents and bitangents are transformed in world space, the other vertex attributes
+    * are copied as they are: any other attribute holding an object space position or direction is not supported.
+    * The batched Geometry[s] are assumed to be static: after modifying a batched Geometry call invalidateBatches().
+    * \sa Renderer */
+  class VLGRAPHICS_EXPORT StaticBatchRenderer: public Renderer
+  {
+    VL_INSTRUMENT_CLASS(vl::StaticBatchRenderer, Renderer)
+
+  public:
+    StaticBatchRenderer();
+
+    /** Renders the batched version of \p in_render_queue. Returns \p in_render_queue. */
+    virtual const RenderQueue* render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
+
+    /** Minimum number of consecutive compatible tokens required to form a batch (default = 2). */
+    void setMinBatchSize(int size) { mMinBatchSize = size; }
+
+    /** Minimum number of consecutive compatible tokens required to form a batch (default = 2). */
+    int minBatchSize() const { return mMinBatchSize; }
+
+    /** Releases all the batches, they will be rebuilt the next time they are needed. */
+    void invalidateBatches() { mBatches.clear(); }
+
+    /** Number of RenderToken[s] rendered through a batch during the last rendering. */
+    int statsBatchedObjects() const { return mStatsBatchedObjects; }
+
+    /** Number of batch draws issued during the last rendering. */
+    int statsBatches() const { return mStatsBatches; }
+
+  protected:
+    /** Returns true if the given RenderToken can be merged into a batch. */
+    bool isBatchable(const RenderToken* tok);
+
+    //! The merged geometry of all the batchable Actor[s] seen using the same Shader.
+    class Batch: public Object
+    {
+    public:
+      Batch();
+
+      //! Returns true if the token is part of the batch or compatible with its layout, \p first is the Geometry of the
+      //! first token of the run and defines the layout of an empty batch.
+      bool accepts(const RenderToken* tok, const Geometry* first) const;
+
+      //! Adds the given tokens to the batch if needed and prepares the draw call to render them.
+      //! All the tokens must be accepted by accepts().
+      void prepare(const RenderToken* const* tokens, int count, unsigned int frame);
+
+      //! Releases the Actor[s] not rendered during the last \p max_unused frames. Returns false if the batch is left empty.
+      bool releaseUnused(unsigned int frame, unsigned int max_unused);
+
+      //! The frame of the last prepare().
+      unsigned int lastUsed() const { return mLastUsed; }
+
+      Actor* actor() { return mActor.get(); }
+      Geometry* geometry() { return mGeometry.get(); }
+
+      //! Whether \p geom has the same primitive type and vertex attribute layout of \p ref_geom.
+      static bool compatible(const Geometry* geom, const Geometry* ref_geom);
+
+    protected:
+      struct Range
+      {
+        GLuint mFirst;
+        GLsizei mCount;
+        bool operator<(const Range& other) const { return mFirst < other.mFirst; }
+      };
+
+      struct Slot
+      {
+        ref<Actor> mActor;
+        ref<Geometry> mGeometry;
+        long long mTransformTick;
+        unsigned int mLastSeen;
+        GLuint mFirstVertex;
+        std::vector<Range> mRanges;
+      };
+
+      void rebuild();
+      void appendSlot(Slot& slot);
+      void collectIndices(Slot& slot, GLuint first_index, std::vector<GLuint>& indices);
+      void transformSlot(const Slot& slot);
+      void updateBounds();
+
+    protected:
+      std::map< std::pair<const Actor*, const Geometry*>, int > mSlotMap;
+      std::vector<Slot> mSlots;
+      std::vector<Range> mRanges;
+      ref<Actor> mActor;
+      ref<Geometry> mGeometry;
+      ref<MultiDrawElementsUInt> mDrawCall;
+      EPrimitiveType mPrimitiveType;
+      unsigned int mLastUsed;
+      bool mDirty;
+    };
+
+  protected:
+    std::map< const Shader*, ref<Batch> > mBatches;
+    ref<RenderQueue> mBatchedRenderQueue;
+    std::vector<const RenderToken*> mRun;
+    unsigned int mFrame;
+    int mMinBatchSize;
+    int mStatsBatchedObjects;
+    int mStatsBatches;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -42,6 +42,9 @@ namespace vl
       - Assign the left and right cameras representing the left and right eyes with the setLeftCamera()/setRightCamera() methods.
       - Set the desired convergence and eye separation using setConvergence() and setEyeSeparation().
       - Call updateLeftRightCameras() whenever the mono camera or viewport changes.
+      - Optionally assign separate eye viewports with setEyeViewports(), for example for side-by-side stereo.
+      - Optionally assign a combined camera with setCombinedCamera(): its frustum encloses both eyes so that
+        a single culling and sorting pass can serve both of them, see StereoRenderer.
 
       \sa App_Stereo.cpp for a basic example of how to setup stereo rendering using anaglyphs. */
   class StereoCamera: public Object
@@ -89,15 +92,34 @@ namespace vl
     /** The Camera representing the right eye. */
     Camera* rigthCamera() { return mRightCamera.get(); }
     /** The Camera representing the right eye. */
+    Camera* rightCamera() { return mRightCamera.get(); }
+    /** The Camera representing the right eye. */
     const Camera* rightCamera() const { return mRightCamera.get(); }
 
-    /** Updates the left and right cameras based on the mono camera view matrix and viewport. */
+    /** A Camera whose frustum encloses both the left and right eye frusta, updated by updateLeftRightCameras().
+        Use it as the Rendering camera to cull and sort the scene once for both eyes, see StereoRenderer. */
+    void setCombinedCamera(Camera* camera) { mCombinedCamera = camera; }
+    /** A Camera whose frustum encloses both the left and right eye frusta, updated by updateLeftRightCameras(). */
+    Camera* combinedCamera() { return mCombinedCamera.get(); }
+    /** A Camera whose frustum encloses both the left and right eye frusta, updated by updateLeftRightCameras(). */
+    const Camera* combinedCamera() const { return mCombinedCamera.get(); }
+
+    /** The viewports of the left and right eyes. If NULL (default) both eyes use the mono camera viewport. */
+    void setEyeViewports(Viewport* left, Viewport* right) { mLeftViewport = left; mRightViewport = right; }
+    /** The viewport of the left eye, NULL if the mono camera viewport is used. */
+    Viewport* leftViewport() { return mLeftViewport.get(); }
+    /** The viewport of the right eye, NULL if the mono camera viewport is used. */
+    Viewport* rightViewport() { return mRightViewport.get(); }
+
+    /** Updates the left, right and combined cameras based on the mono camera view matrix and viewport. */
     void updateLeftRightCameras()
     {
-      mLeftCamera->setViewport( mMonoCamera->viewport() );
-      mRightCamera->setViewport( mMonoCamera->viewport() );
+      Viewport* left_viewport  = mLeftViewport  ? mLeftViewport.get()  : mMonoCamera->viewport();
+      Viewport* right_viewport = mRightViewport ? mRightViewport.get() : mMonoCamera->viewport();
+      mLeftCamera->setViewport( left_viewport );
+      mRightCamera->setViewport( right_viewport );
 
-      float aspect_ratio = (float)mMonoCamera->viewport()->width()/mMonoCamera->viewport()->height();
+      float aspect_ratio = (float)left_viewport->width()/left_viewport->height();
       float near_clip = mMonoCamera->nearPlane();
       float far_clip  = mMonoCamera->farPlane();
       float radians = mMonoCamera->fov()/2*fDEG_TO_RAD;
@@ -116,12 +138,51 @@ namespace vl
       right =   aspect_ratio * wd2 + mEyeSeparation/2 * ndfl;
       mRightCamera->setProjectionFrustum(left, right, bottom, top, near_clip, far_clip);
       mRightCamera->setViewMatrix( mat4::getTranslation(+mEyeSeparation/2, 0, 0)*mMonoCamera->viewMatrix() );
+
+      if ( mCombinedCamera )
+        updateCombinedCamera( aspect_ratio * wd2, wd2 );
+    }
+
+  protected:
+    /** Fits a symmetric frustum around both eyes, with its apex moved back along the view direction.
+        The horizontal half extent of the union of the eye frusta at depth t is a convex function of t,
+        hence the line through its values at the near and far planes bounds it from above. */
+    void updateCombinedCamera(float half_width, float half_height)
+    {
+      float near_clip = mMonoCamera->nearPlane();
+      float far_clip  = mMonoCamera->farPlane();
+      float s = mEyeSeparation/2;
+
+      // half extent of the union of the eye frusta on the near and far planes, in mono camera coordinates
+      float ext_near = half_width + s * fabs(1 - near_clip / mConvergence);
+      float ext_far  = half_width * far_clip / near_clip + s * fabs(1 - far_clip / mConvergence);
+
+      // apex depth: where the bounding line crosses the view axis, never in front of the mono camera
+      float apex = 0;
+      if ( ext_far > ext_near )
+        apex = near_clip - ext_near * (far_clip - near_clip) / (ext_far - ext_near);
+      if ( apex > 0 )
+        apex = 0;
+
+      float comb_near = near_clip - apex;
+      float comb_far  = far_clip - apex;
+      float slope = ext_near / comb_near;
+      if ( ext_far / comb_far > slope )
+        slope = ext_far / comb_far;
+      float slope_v = half_height / near_clip;
+
+      mCombinedCamera->setViewport( mMonoCamera->viewport() );
+      mCombinedCamera->setProjectionFrustum( -slope * comb_near, slope * comb_near, -slope_v * comb_near, slope_v * comb_near, comb_near, comb_far );
+      mCombinedCamera->setViewMatrix( mat4::getTranslation(0, 0, apex)*mMonoCamera->viewMatrix() );
     }
 
   private:
     ref<Camera> mMonoCamera;
     ref<Camera> mLeftCamera;
     ref<Camera> mRightCamera;
+    ref<Camera> mCombinedCamera;
+    ref<Viewport> mLeftViewport;
+    ref<Viewport> mRightViewport;
     float mConvergence;
     float mEyeSeparation;
   };
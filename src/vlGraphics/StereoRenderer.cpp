@@ -0,0 +1,286 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/StereoRenderer.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/StringInterner.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// StereoProjViewTransfCallback
+//-----------------------------------------------------------------------------
+void StereoProjViewTransfCallback::setEyeCameras(const Camera* eye0, const Camera* eye1)
+{
+  const Camera* eye[] = { eye0, eye1 };
+  for(int i=0; i<2; ++i)
+  {
+    mViewMatrix[i] = (fmat4)eye[i]->viewMatrix();
+    mViewProjectionMatrix[i] = (fmat4)( eye[i]->projectionMatrix() * eye[i]->viewMatrix() );
+  }
+}
+//-----------------------------------------------------------------------------
+void StereoProjViewTransfCallback::updateMatrices(bool cam_changed, bool transf_changed, const GLSLProgram* glsl_program, const Camera* camera, const Transform* transform)
+{
+  ProjViewTransfCallback::updateMatrices(cam_changed, transf_changed, glsl_program, camera, transform);
+
+  if ( !cam_changed || !glsl_program )
+    return;
+
+  int view_loc = glsl_program->getUniformLocation("vl_StereoViewMatrix");
+  if ( view_loc != -1 )
+  {
+    glUniformMatrix4fv( view_loc, 2, GL_FALSE, mViewMatrix[0].ptr() ); VL_CHECK_OGL();
+  }
+
+  int view_proj_loc = glsl_program->getUniformLocation("vl_StereoViewProjectionMatrix");
+  if ( view_proj_loc != -1 )
+  {
+    glUniformMatrix4fv( view_proj_loc, 2, GL_FALSE, mViewProjectionMatrix[0].ptr() ); VL_CHECK_OGL();
+  }
+}
+//-----------------------------------------------------------------------------
+// StereoRenderer::StereoGeometry
+//-----------------------------------------------------------------------------
+void StereoRenderer::StereoGeometry::set(Geometry* geom)
+{
+  mGeometry = geom;
+  setBoundsDirty(true);
+}
+//-----------------------------------------------------------------------------
+void StereoRenderer::StereoGeometry::computeBounds_Implementation()
+{
+  if (!mGeometry)
+    return;
+  setBoundingBox( mGeometry->boundingBox() );
+  setBoundingSphere( mGeometry->boundingSphere() );
+}
+//-----------------------------------------------------------------------------
+void StereoRenderer::StereoGeometry::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
+{
+  Collection<DrawCall>& dcs = mGeometry->drawCalls();
+
+  // temporarily draw one instance per eye
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = dcs.at(i)->as<DrawElementsBase>())
+      de->setInstances(2);
+    else
+    if (DrawArrays* da = dcs.at(i)->as<DrawArrays>())
+      da->setInstances(2);
+  }
+
+  mGeometry->render(actor, shader, camera, gl_context);
+
+  for(int i=0; i<dcs.size(); ++i)
+  {
+    if (DrawElementsBase* de = dcs.at(i)->as<DrawElementsBase>())
+      de->setInstances(1);
+    else
+    if (DrawArrays* da = dcs.at(i)->as<DrawArrays>())
+      da->setInstances(1);
+  }
+}
+//-----------------------------------------------------------------------------
+// StereoRenderer::PassSetup
+//-----------------------------------------------------------------------------
+bool StereoRenderer::PassSetup::onRendererStarted(const RendererAbstract*)
+{
+  // Viewport::activate() sets all the viewports but not the scissor when not clearing
+  if ( mStereo )
+  {
+    const Viewport* vp[] = { mLeft, mRight };
+    for(int i=0; i<2; ++i)
+    {
+      glViewportIndexedf( i, (float)vp[i]->x(), (float)vp[i]->y(), (float)vp[i]->width(), (float)vp[i]->height() ); VL_CHECK_OGL();
+      glScissorIndexed( i, vp[i]->x(), vp[i]->y(), vp[i]->width(), vp[i]->height() ); VL_CHECK_OGL();
+    }
+  }
+  else
+  {
+    glScissor( mLeft->x(), mLeft->y(), mLeft->width(), mLeft->height() ); VL_CHECK_OGL();
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------
+// StereoRenderer
+//-----------------------------------------------------------------------------
+StereoRenderer::StereoRenderer(): mSinglePassEnabled(true), mStatsStereoObjects(0), mStatsMonoObjects(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mStereoRenderQueue = new RenderQueue;
+  mStereoViewProjectionMatrixID = StringInterner::intern("vl_StereoViewProjectionMatrix");
+  mMonoRenderQueue = new RenderQueue;
+  mPassSetup = new PassSetup;
+  setProjViewTransfCallback( new StereoProjViewTransfCallback );
+}
+//-----------------------------------------------------------------------------
+bool StereoRenderer::isStereoCapable(const RenderToken* tok)
+{
+  if ( tok->mNextPass || tok->mShader->isBlendingEnabled() || tok->mShader->scissor() )
+    return false;
+
+  const GLSLProgram* glsl = tok->mShader->glslProgram();
+  if ( !glsl || !glsl->handle() || !glsl->linked() )
+    return false;
+
+  // the location is cached by the program until it is relinked
+  if ( glsl->getUniformLocation( mStereoViewProjectionMatrixID ) == -1 )
+    return false;
+
+  const Actor* actor = tok->mActor;
+  if ( !isEnabled(actor) || actor->scissor() || !actor->actorEventCallbacks()->empty() )
+    return false;
+
+  for( std::map< unsigned int, ref<Shader> >::const_iterator eom_it = mShaderOverrideMask.begin(); eom_it != mShaderOverrideMask.end(); ++eom_it )
+  {
+    if ( eom_it->first & actor->enableMask() )
+      return false;
+  }
+
+  const Geometry* geom = tok->mRenderable->as<Geometry>();
+  if ( !geom || geom->isDisplayListEnabled() || geom->drawCalls().empty() )
+    return false;
+
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    const DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->instances() != 1 || !( dc->as<DrawElementsBase>() || dc->as<DrawArrays>() ) )
+      return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* StereoRenderer::render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock)
+{
+  mStatsStereoObjects = 0;
+  mStatsMonoObjects = 0;
+
+  if ( !mStereoCamera || !mStereoCamera->leftCamera() || !mStereoCamera->rightCamera() )
+    return Renderer::render( in_render_queue, camera, frame_clock );
+
+  if ( enableMask() == 0 )
+    return in_render_queue;
+
+  Camera* left  = mStereoCamera->leftCamera();
+  Camera* right = mStereoCamera->rightCamera();
+  Viewport* left_vp  = left->viewport();
+  Viewport* right_vp = right->viewport();
+  bool shared_viewport = left_vp == right_vp ||
+                         ( left_vp->x() == right_vp->x() && left_vp->y() == right_vp->y() &&
+                           left_vp->width() == right_vp->width() && left_vp->height() == right_vp->height() );
+
+  StereoProjViewTransfCallback* stereo_cb = projViewTransfCallback() ? projViewTransfCallback()->as<StereoProjViewTransfCallback>() : NULL;
+  bool single_pass = mSinglePassEnabled && stereo_cb && Has_Primitive_Instancing &&
+                     ( shared_viewport || Has_GL_ARB_viewport_array || Has_GL_Version_4_1 );
+
+  // split the queue: the stereo tokens are rendered first as they never use blending
+
+  mStereoRenderQueue->clear();
+  mMonoRenderQueue->clear();
+  int stereo_count = 0;
+  for(int i=0; i<in_render_queue->size(); ++i)
+  {
+    const RenderToken* tok = in_render_queue->at(i);
+    if ( single_pass && isStereoCapable(tok) )
+    {
+      if ( stereo_count == (int)mStereoGeometries.size() )
+        mStereoGeometries.push_back( new StereoGeometry );
+      StereoGeometry* stereo_geom = mStereoGeometries[stereo_count++].get();
+      stereo_geom->set( static_cast<Geometry*>(tok->mRenderable) );
+
+      RenderToken* out_tok = mStereoRenderQueue->newToken(false);
+      *out_tok = *tok;
+      out_tok->mRenderable = stereo_geom;
+    }
+    else
+    {
+      RenderToken* out_tok = mMonoRenderQueue->newToken(false);
+      *out_tok = *tok;
+    }
+  }
+  mStatsStereoObjects = mStereoRenderQueue->size();
+  mStatsMonoObjects = mMonoRenderQueue->size();
+
+  // clear both eye viewports once, the passes below do not clear
+
+  EClearFlags clear_flags = clearFlags();
+  if ( clear_flags != CF_DO_NOT_CLEAR )
+  {
+    framebuffer()->activate();
+    left_vp->setClearFlags( clear_flags );
+    left_vp->activate();
+    if ( !shared_viewport )
+    {
+      right_vp->setClearFlags( clear_flags );
+      right_vp->activate();
+    }
+  }
+  setClearFlags( CF_DO_NOT_CLEAR );
+
+  onStartedCallbacks()->push_back( mPassSetup.get() );
+
+  if ( mStereoRenderQueue->size() )
+  {
+    stereo_cb->setEyeCameras( left, right );
+    mPassSetup->mLeft = left_vp;
+    mPassSetup->mRight = right_vp;
+    mPassSetup->mStereo = !shared_viewport;
+    Renderer::render( mStereoRenderQueue.get(), left, frame_clock );
+  }
+
+  if ( mMonoRenderQueue->size() )
+  {
+    Camera* eye[] = { left, right };
+    for(int i=0; i<2; ++i)
+    {
+      if ( stereo_cb )
+        stereo_cb->setEyeCameras( eye[i], eye[i] );
+      mPassSetup->mLeft = eye[i]->viewport();
+      mPassSetup->mStereo = false;
+      Renderer::render( mMonoRenderQueue.get(), eye[i], frame_clock );
+    }
+  }
+
+  onStartedCallbacks()->erase( mPassSetup.get() );
+  setClearFlags( clear_flags );
+
+  // release the references to the rendered Geometry[s]
+  for(int i=0; i<stereo_count; ++i)
+    mStereoGeometries[i]->set(NULL);
+
+  return in_render_queue;
+}
+//-----------------------------------------------------------------------------
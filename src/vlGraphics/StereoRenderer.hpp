@@ -0,0 +1,186 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef StereoRenderer_INCLUDE_ONCE
+#define StereoRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/StereoCamera.hpp>
+#include <vlGraphics/ProjViewTransfCallback.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // StereoProjViewTransfCallback
+  //------------------------------------------------------------------------------
+  /** ProjViewTransfCallback that, in addition to the standard matrices, sends the view and view-projection
+    * matrices of both eyes to the GLSL programs declaring the following uniform arrays:
+    * \code
+    * uniform mat4 vl_StereoViewMatrix[2];
+    * uniform mat4 vl_StereoViewProjectionMatrix[2];
+    * \endcode
+    * Used by StereoRenderer. */
+  class VLGRAPHICS_EXPORT StereoProjViewTransfCallback: public ProjViewTransfCallback
+  {
+    VL_INSTRUMENT_CLASS(vl::StereoProjViewTransfCallback, ProjViewTransfCallback)
+
+  public:
+    StereoProjViewTransfCallback() { VL_DEBUG_SET_OBJECT_NAME() }
+
+    virtual void updateMatrices(bool cam_changed, bool transf_changed, const GLSLProgram* glsl_program, const Camera* camera, const Transform* transform);
+
+    /** Sets the cameras whose matrices are sent as entry 0 and 1 of the stereo uniform arrays. */
+    void setEyeCameras(const Camera* eye0, const Camera* eye1);
+
+  protected:
+    fmat4 mViewMatrix[2];
+    fmat4 mViewProjectionMatrix[2];
+  };
+  //------------------------------------------------------------------------------
+  // StereoRenderer
+  //------------------------------------------------------------------------------
+  /** A Renderer that draws a scene for both the left and right eye of a StereoCamera out of a single RenderQueue.
+    *
+    * Use the StereoCamera::combinedCamera() as the Rendering camera: the scene is then culled and sorted only once
+    * for both eyes. The RenderToken[s] whose GLSLProgram declares \p vl_StereoViewProjectionMatrix are drawn once
+    * with two instances, the instance index selecting the eye. Both eye viewports are set up as viewport #0 and #1
+    * via GL_ARB_viewport_array, a typical vertex shader looks like:
+    * \code
+    * #extension GL_ARB_shader_viewport_layer_array : require
+    * uniform mat4 vl_StereoViewProjectionMatrix[2];
+    * uniform mat4 vl_WorldMatrix;
+    * ...
+    * gl_Position = vl_StereoViewProjectionMatrix[gl_InstanceID] * vl_WorldMatrix * vl_VertexPosition;
+    * gl_ViewportIndex = gl_InstanceID; // or gl_Layer = gl_InstanceID when rendering to a layered framebuffer
+    * \endcode
+    * Without GL_ARB_shader_viewport_layer_array the index must be written by a geometry shader. Eye dependent
+    * computations must use \p vl_StereoViewMatrix and \p vl_StereoViewProjectionMatrix, the standard camera matrices
+    * are those of the left eye.
+    *
+    * A RenderToken is drawn in a single pass only if it is a single pass token, its Shader does not enable blending
+    * and has no Scissor, its Geometry has no display list and only non-instanced DrawElements or DrawArrays draw calls,
+    * and its Actor has no Scissor, no ActorEventCallback and is not subject to the shaderOverrideMask().
+    * All the other RenderToken[s] are rendered afterwards once per eye. The clear flags of the renderer are applied
+    * to both eye viewports before rendering; note that the renderer-started and renderer-finished events are
+    * dispatched once per internal pass.
+    *
+    * The projViewTransfCallback() must be a StereoProjViewTransfCallback (the default) for the single pass to be used.
+    * \sa StereoCamera, InstancingRenderer */
+  class VLGRAPHICS_EXPORT StereoRenderer: public Renderer
+  {
+    VL_INSTRUMENT_CLASS(vl::StereoRenderer, Renderer)
+
+  public:
+    StereoRenderer();
+
+    /** Renders \p in_render_queue for both eyes of the stereoCamera(). Returns \p in_render_queue.
+      * If no StereoCamera is set the queue is rendered as a regular Renderer would. */
+    virtual const RenderQueue* render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
+
+    /** The StereoCamera providing the left and right eye cameras. */
+    void setStereoCamera(StereoCamera* stereo_camera) { mStereoCamera = stereo_camera; }
+
+    /** The StereoCamera providing the left and right eye cameras. */
+    StereoCamera* stereoCamera() { return mStereoCamera.get(); }
+
+    /** The StereoCamera providing the left and right eye cameras. */
+    const StereoCamera* stereoCamera() const { return mStereoCamera.get(); }
+
+    /** Enables the instanced single pass rendering of the compatible RenderToken[s] (default = true).
+      * If disabled or not supported every RenderToken is rendered once per eye. */
+    void setSinglePassEnabled(bool enabled) { mSinglePassEnabled = enabled; }
+
+    /** Enables the instanced single pass rendering of the compatible RenderToken[s] (default = true). */
+    bool singlePassEnabled() const { return mSinglePassEnabled; }
+
+    /** Number of RenderToken[s] drawn once for both eyes during the last rendering. */
+    int statsStereoObjects() const { return mStatsStereoObjects; }
+
+    /** Number of RenderToken[s] drawn once per eye during the last rendering. */
+    int statsMonoObjects() const { return mStatsMonoObjects; }
+
+  protected:
+    /** Returns true if the given RenderToken can be drawn for both eyes at once. */
+    bool isStereoCapable(const RenderToken* tok);
+
+    //! Renders a Geometry with two instances, one per eye.
+    class StereoGeometry: public Renderable
+    {
+    public:
+      StereoGeometry(): mGeometry(NULL) {}
+
+      void set(Geometry* geom);
+
+    protected:
+      virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+      virtual void deleteBufferObject() {}
+      virtual void computeBounds_Implementation();
+      virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+
+    protected:
+      Geometry* mGeometry;
+    };
+
+    //! Sets up the eye viewports and scissors after the framebuffer and viewport activation of each pass.
+    class PassSetup: public RenderEventCallback
+    {
+    public:
+      PassSetup(): mLeft(NULL), mRight(NULL), mStereo(false) {}
+
+      virtual bool onRenderingStarted(const RenderingAbstract*) { return false; }
+      virtual bool onRenderingFinished(const RenderingAbstract*) { return false; }
+      virtual bool onRendererStarted(const RendererAbstract*);
+      virtual bool onRendererFinished(const RendererAbstract*) { return false; }
+
+    public:
+      const Viewport* mLeft;
+      const Viewport* mRight;
+      bool mStereo;
+    };
+
+  protected:
+    ref<StereoCamera> mStereoCamera;
+    ref<RenderQueue> mStereoRenderQueue;
+    ref<RenderQueue> mMonoRenderQueue;
+    std::vector< ref<StereoGeometry> > mStereoGeometries;
+    ref<PassSetup> mPassSetup;
+    int mStereoViewProjectionMatrixID;
+    bool mSinglePassEnabled;
+    int mStatsStereoObjects;
+    int mStatsMonoObjects;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -30,6 +30,7 @@
 /**************************************************************************************/
 
 #include <vlGraphics/Tessellator.hpp>
+#include <vlCore/MurmurHash3.hpp>
 
 using namespace vl;
 
@@ -42,6 +43,10 @@ Tessellator::Tessellator()
   mTolerance = 0.0;
   mWindingRule = TW_TESS_WINDING_ODD;
   mTessellateIntoSinglePolygon = true;
+  mFirstVert = 0;
+  mFirstIndex = 0;
+  mPrimitiveType = 0;
+  mCacheKey.mHash[0] = mCacheKey.mHash[1] = 0;
 }
 //-----------------------------------------------------------------------------
 Tessellator::~Tessellator()
@@ -50,9 +55,125 @@ Tessellator::~Tessellator()
 }
 //-----------------------------------------------------------------------------
 bool Tessellator::tessellate(bool append_tessellated_tris)
+{
+  if (!beginTessellation(append_tessellated_tris))
+    return false;
+
+  if (!tessellateFromCache())
+  {
+    GLUtesselator* tobj = newGLUTessellator();
+    tessellate(tobj);
+    gluDeleteTess(tobj);
+    storeInCache();
+  }
+
+  endTessellation();
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool Tessellator::tessellateBatch(const std::vector< ref<Tessellator> >& tessellators, bool append_tessellated_tris)
+{
+  bool ok = true;
+
+  // setup and cache lookup are done serially since the cache is not thread safe,
+  // polygons equal to one already pending are served from the cache once it's tessellated
+  std::vector<Tessellator*> pending;
+  std::vector<Tessellator*> duplicates;
+  std::vector<Tessellator*> started;
+  std::map<TessellationCache::Key, Tessellator*> pending_keys;
+  for(size_t i=0; i<tessellators.size(); ++i)
+  {
+    Tessellator* tess = tessellators[i].get_writable();
+    if (!tess->beginTessellation(append_tessellated_tris))
+    {
+      ok = false;
+      continue;
+    }
+    started.push_back(tess);
+    if (tess->mCache && pending_keys.find(tess->mCacheKey) != pending_keys.end() && pending_keys[tess->mCacheKey]->mCache == tess->mCache)
+      duplicates.push_back(tess);
+    else
+    if (!tess->tessellateFromCache())
+    {
+      pending.push_back(tess);
+      if (tess->mCache)
+        pending_keys[tess->mCacheKey] = tess;
+    }
+  }
+
+  // each thread owns its GLU tessellator object, the callbacks only touch the Tessellator passed as polygon data
+  const int pending_count = (int)pending.size();
+#ifdef _OPENMP
+  #pragma omp parallel if(pending_count > 1)
+#endif
+  {
+    GLUtesselator* tobj = newGLUTessellator();
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for(int i=0; i<pending_count; ++i)
+      pending[i]->tessellate(tobj);
+    gluDeleteTess(tobj);
+  }
+
+  for(size_t i=0; i<pending.size(); ++i)
+    pending[i]->storeInCache();
+
+  for(size_t i=0; i<duplicates.size(); ++i)
+    duplicates[i]->tessellateFromCache();
+
+  for(size_t i=0; i<started.size(); ++i)
+    started[i]->endTessellation();
+
+  return ok;
+}
+//-----------------------------------------------------------------------------
+void Tessellator::mergeTessellations(const std::vector< ref<Tessellator> >& tessellators, std::vector<fvec3>& verts, std::vector<u32>& indices)
+{
+  size_t vert_count = verts.size();
+  size_t index_count = indices.size();
+  for(size_t i=0; i<tessellators.size(); ++i)
+  {
+    vert_count += tessellators[i]->tessellatedVerts().size();
+    index_count += tessellators[i]->tessellatedIndices().size();
+  }
+  verts.reserve(vert_count);
+  indices.reserve(index_count);
+
+  for(size_t i=0; i<tessellators.size(); ++i)
+  {
+    const u32 offset = (u32)verts.size();
+    const std::vector<fvec3>& tess_verts = tessellators[i]->tessellatedVerts();
+    const std::vector<u32>& tess_indices = tessellators[i]->tessellatedIndices();
+    verts.insert(verts.end(), tess_verts.begin(), tess_verts.end());
+    for(size_t j=0; j<tess_indices.size(); ++j)
+      indices.push_back(tess_indices[j] + offset);
+  }
+}
+//-----------------------------------------------------------------------------
+GLUtesselator* Tessellator::newGLUTessellator()
+{
+  GLUtesselator* tobj = gluNewTess();
+  // callbacks
+  gluTessCallback(tobj, GLU_TESS_BEGIN_DATA,   (callback_type)tessBeginData);
+  gluTessCallback(tobj, GLU_TESS_VERTEX_DATA,  (callback_type)tessVertexData);
+  gluTessCallback(tobj, GLU_TESS_COMBINE_DATA, (callback_type)tessCombineData);
+  gluTessCallback(tobj, GLU_TESS_END,     (callback_type)tessEnd);
+  gluTessCallback(tobj, GLU_TESS_ERROR,        (callback_type)tessError);
+  return tobj;
+}
+//-----------------------------------------------------------------------------
+bool Tessellator::beginTessellation(bool append_tessellated_tris)
 {
   if (!append_tessellated_tris)
+  {
     mTessellatedTris.clear();
+    mTessellatedVerts.clear();
+    mTessellatedIndices.clear();
+  }
+  mFirstVert  = mTessellatedVerts.size();
+  mFirstIndex = mTessellatedIndices.size();
+  mTris.clear();
   mFans.clear();
   mTriStrips.clear();
   mLineLoops.clear();
@@ -64,19 +185,63 @@ bool Tessellator::tessellate(bool append_tessellated_tris)
     return false;
   }
 
-  GLUtesselator* tobj = gluNewTess();
-  // callbacks
-  gluTessCallback(tobj, GLU_TESS_BEGIN_DATA,   (callback_type)tessBeginData);
-  gluTessCallback(tobj, GLU_TESS_VERTEX_DATA,  (callback_type)tessVertexData);
-  gluTessCallback(tobj, GLU_TESS_COMBINE_DATA, (callback_type)tessCombineData);
-  gluTessCallback(tobj, GLU_TESS_END,     (callback_type)tessEnd);
-  gluTessCallback(tobj, GLU_TESS_ERROR,        (callback_type)tessError);
+  // the contour vertices come first in tessellatedVerts()
+  for(size_t i=0; i<mContourVerts.size(); ++i)
+    mTessellatedVerts.push_back( (fvec3)mContourVerts[i] );
+
+  if (mCache)
+  {
+    // the contour vertices, the contour sizes and the settings are hashed in turn, each hash seeding the next one
+    u64 verts_hash[2], contours_hash[2];
+    MurmurHash3_x64_128(&mContourVerts[0], (int)(mContourVerts.size() * sizeof(dvec3)), 0, verts_hash);
+    MurmurHash3_x64_128(&mContours[0], (int)(mContours.size() * sizeof(int)), (u32)verts_hash[0], contours_hash);
+    const double settings[] = {
+      mTessNormal.x(), mTessNormal.y(), mTessNormal.z(), mTolerance,
+      (double)mWindingRule, mBoundaryOnly ? 1.0 : 0.0, mTessellateIntoSinglePolygon ? 1.0 : 0.0
+    };
+    MurmurHash3_x64_128(settings, (int)sizeof(settings), (u32)contours_hash[0], mCacheKey.mHash);
+    mCacheKey.mHash[0] ^= verts_hash[1];
+    mCacheKey.mHash[1] ^= contours_hash[1];
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool Tessellator::tessellateFromCache()
+{
+  if (!mCache)
+    return false;
+
+  std::map<TessellationCache::Key, TessellationCache::Entry>::const_iterator it = mCache->mEntries.find(mCacheKey);
+  if (it == mCache->mEntries.end())
+  {
+    ++mCache->mMisses;
+    return false;
+  }
+  ++mCache->mHits;
+
+  const TessellationCache::Entry& entry = it->second;
+  mTessellatedVerts.resize(mFirstVert);
+  mTessellatedVerts.insert(mTessellatedVerts.end(), entry.mVerts.begin(), entry.mVerts.end());
+  for(size_t i=0; i<entry.mIndices.size(); ++i)
+    mTessellatedIndices.push_back( entry.mIndices[i] + (u32)mFirstVert );
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Tessellator::tessellate(GLUtesselator* tobj)
+{
   // normal
-   gluTessNormal( tobj, tessNormal().x(), tessNormal().y(), tessNormal().z() );
+  gluTessNormal( tobj, tessNormal().x(), tessNormal().y(), tessNormal().z() );
   // properties
-   gluTessProperty(tobj, GLU_TESS_BOUNDARY_ONLY, boundaryOnly() ? GL_TRUE : GL_FALSE);
-   gluTessProperty(tobj, GLU_TESS_TOLERANCE, tolerance());
-   gluTessProperty(tobj, GLU_TESS_WINDING_RULE, windingRule());
+  gluTessProperty(tobj, GLU_TESS_BOUNDARY_ONLY, boundaryOnly() ? GL_TRUE : GL_FALSE);
+  gluTessProperty(tobj, GLU_TESS_TOLERANCE, tolerance());
+  gluTessProperty(tobj, GLU_TESS_WINDING_RULE, windingRule());
+
+  // the GLU vertex data of a contour vertex points to its index
+  mContourIndices.resize( mContourVerts.size() );
+  for(size_t i=0; i<mContourIndices.size(); ++i)
+    mContourIndices[i] = (u32)i;
+
   // tessellation
   if (tessellateIntoSinglePolygon())
   {
@@ -85,7 +250,7 @@ bool Tessellator::tessellate(bool append_tessellated_tris)
     {
       gluTessBeginContour(tobj);
       for(int i=0; i<mContours[cont]; ++i, ++idx)
-        gluTessVertex(tobj, mContourVerts[idx].ptr(), mContourVerts[idx].ptr());
+        gluTessVertex(tobj, mContourVerts[idx].ptr(), &mContourIndices[idx]);
       gluTessEndContour(tobj);
     }
     gluTessEndPolygon(tobj);
@@ -97,52 +262,71 @@ bool Tessellator::tessellate(bool append_tessellated_tris)
       gluTessBeginPolygon(tobj, this);
       gluTessBeginContour(tobj);
       for(int i=0; i<mContours[cont]; ++i, ++idx)
-        gluTessVertex(tobj, mContourVerts[idx].ptr(), mContourVerts[idx].ptr());
+        gluTessVertex(tobj, mContourVerts[idx].ptr(), &mContourIndices[idx]);
       gluTessEndContour(tobj);
       gluTessEndPolygon(tobj);
     }
   }
-  gluDeleteTess(tobj);
 
   // triangulate fans
   for(unsigned fan=0; fan<mFans.size();    ++fan)
-  for(unsigned iv =1; iv<mFans[fan].size()-1; ++iv)
+  for(unsigned iv =1; iv+1<mFans[fan].size(); ++iv)
   {
-    mTessellatedTris.push_back(mFans[fan][0]);
-    mTessellatedTris.push_back(mFans[fan][iv]);
-    mTessellatedTris.push_back(mFans[fan][iv+1]);
+    mTris.push_back(mFans[fan][0]);
+    mTris.push_back(mFans[fan][iv]);
+    mTris.push_back(mFans[fan][iv+1]);
   }
 
   // triangulate strips
   for(unsigned strip=0; strip<mTriStrips.size(); ++strip)
-  for(unsigned iv=0; iv<mTriStrips[strip].size()-2; ++iv)
+  for(unsigned iv=0; iv+2<mTriStrips[strip].size(); ++iv)
   {
     if (iv % 2)
     {
-      mTessellatedTris.push_back(mTriStrips[strip][iv+0]);
-      mTessellatedTris.push_back(mTriStrips[strip][iv+2]);
-      mTessellatedTris.push_back(mTriStrips[strip][iv+1]);
+      mTris.push_back(mTriStrips[strip][iv+0]);
+      mTris.push_back(mTriStrips[strip][iv+2]);
+      mTris.push_back(mTriStrips[strip][iv+1]);
     }
     else
     {
-      mTessellatedTris.push_back(mTriStrips[strip][iv+0]);
-      mTessellatedTris.push_back(mTriStrips[strip][iv+1]);
-      mTessellatedTris.push_back(mTriStrips[strip][iv+2]);
+      mTris.push_back(mTriStrips[strip][iv+0]);
+      mTris.push_back(mTriStrips[strip][iv+1]);
+      mTris.push_back(mTriStrips[strip][iv+2]);
     }
   }
 
-  mContours.clear();
-  mContourVerts.clear();
+  // output the vertices generated by the tessellator and the indexed triangles
+  for(size_t i=0; i<mCombinedVertices.size(); ++i)
+    mTessellatedVerts.push_back( (fvec3)mCombinedVertices[i]->mPos );
+  for(size_t i=0; i<mTris.size(); ++i)
+    mTessellatedIndices.push_back( mTris[i] + (u32)mFirstVert );
+}
+//-----------------------------------------------------------------------------
+void Tessellator::storeInCache()
+{
+  if (!mCache)
+    return;
 
-  #if 0
-    if (tessellatedTris().empty())
-    {
-      vl::Log::warning("Tessellator::tessellate(): no triangles generated.\n");
-      return false;
-    }
-  #endif
+  TessellationCache::Entry& entry = mCache->mEntries[mCacheKey];
+  entry.mVerts.assign( mTessellatedVerts.begin() + mFirstVert, mTessellatedVerts.end() );
+  entry.mIndices.resize( mTessellatedIndices.size() - mFirstIndex );
+  for(size_t i=0; i<entry.mIndices.size(); ++i)
+    entry.mIndices[i] = mTessellatedIndices[mFirstIndex + i] - (u32)mFirstVert;
+}
+//-----------------------------------------------------------------------------
+void Tessellator::endTessellation()
+{
+  for(size_t i=mFirstIndex; i<mTessellatedIndices.size(); ++i)
+    mTessellatedTris.push_back( mTessellatedVerts[ mTessellatedIndices[i] ] );
 
-  return true;
+  mTris.clear();
+  mFans.clear();
+  mTriStrips.clear();
+  mLineLoops.clear();
+  freeCombinedVertices();
+  mContourIndices.clear();
+  mContours.clear();
+  mContourVerts.clear();
 }
 //-----------------------------------------------------------------------------
 void Tessellator::freeCombinedVertices()
@@ -194,33 +378,34 @@ void CALLBACK Tessellator::tessBeginData( GLenum type, Tessellator* tessellator
   }
 }
 //-----------------------------------------------------------------------------
-void CALLBACK Tessellator::tessVertexData( dvec3* vec, Tessellator* tessellator )
+void CALLBACK Tessellator::tessVertexData( u32* index, Tessellator* tessellator )
 {
   if(tessellator->mPrimitiveType == GL_TRIANGLES)
-    tessellator->mTessellatedTris.push_back( (fvec3)(*vec) );
+    tessellator->mTris.push_back( *index );
   else
   if(tessellator->mPrimitiveType == GL_TRIANGLE_FAN)
-    tessellator->mFans.back().push_back( (fvec3)(*vec) );
+    tessellator->mFans.back().push_back( *index );
   else
   if(tessellator->mPrimitiveType == GL_TRIANGLE_STRIP)
-    tessellator->mTriStrips.back().push_back( (fvec3)(*vec) );
+    tessellator->mTriStrips.back().push_back( *index );
   else
   if(tessellator->mPrimitiveType == GL_LINE_LOOP)
-    tessellator->mLineLoops.back().push_back( (fvec3)(*vec) );
+    tessellator->mLineLoops.back().push_back( *index );
   else
   {
     Log::error("Tessellator::vertexData() unknown primitive.\n");
   }
 }
 //-----------------------------------------------------------------------------
-void CALLBACK Tessellator::tessCombineData( GLdouble coords[3], dvec3*[4], GLfloat[4], dvec3 **dataOut, Tessellator* tessellator )
+void CALLBACK Tessellator::tessCombineData( GLdouble coords[3], u32*[4], GLfloat[4], u32 **dataOut, Tessellator* tessellator )
 {
-  dvec3 *vec = new dvec3;
-  vec->x() = coords[0];
-  vec->y() = coords[1];
-  vec->z() = coords[2];
-  *dataOut = vec;
-  tessellator->mCombinedVertices.push_back( vec );
+  CombinedVertex* vert = new CombinedVertex;
+  vert->mIndex = (u32)(tessellator->mContourVerts.size() + tessellator->mCombinedVertices.size());
+  vert->mPos.x() = coords[0];
+  vert->mPos.y() = coords[1];
+  vert->mPos.z() = coords[2];
+  *dataOut = &vert->mIndex;
+  tessellator->mCombinedVertices.push_back( vert );
 }
 //-----------------------------------------------------------------------------
 void CALLBACK Tessellator::tessEnd(void)
@@ -36,6 +36,7 @@
 #include <vlGraphics/Geometry.hpp>
 #include <vlCore/Vector3.hpp>
 #include <vector>
+#include <map>
 
 #ifndef CALLBACK
 #define CALLBACK
@@ -43,9 +44,71 @@
 
 namespace vl
 {
+  class Tessellator;
+
+  /**
+   * Caches the output of one or more Tessellator objects keyed by a 128 bits hash of their input contours and settings.
+   * Tessellating again a polygon already present in the cache simply copies the cached triangles.
+   * A TessellationCache can be shared among several Tessellator objects but is not thread safe, Tessellator::tessellateBatch()
+   * accesses it only from the calling thread.
+   * \sa Tessellator::setCache()
+   */
+  class VLGRAPHICS_EXPORT TessellationCache: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TessellationCache, Object)
+
+    friend class Tessellator;
+
+  public:
+    TessellationCache(): mHits(0), mMisses(0)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Removes all the cached tessellations and resets the hit/miss counters.
+    void clear() { mEntries.clear(); mHits = mMisses = 0; }
+
+    //! The number of cached tessellations.
+    int size() const { return (int)mEntries.size(); }
+
+    //! The number of tessellations served from the cache.
+    int hits() const { return mHits; }
+
+    //! The number of tessellations not found in the cache.
+    int misses() const { return mMisses; }
+
+  protected:
+    struct Key
+    {
+      u64 mHash[2];
+
+      bool operator<(const Key& other) const
+      {
+        if (mHash[0] != other.mHash[0])
+          return mHash[0] < other.mHash[0];
+        else
+          return mHash[1] < other.mHash[1];
+      }
+    };
+
+    struct Entry
+    {
+      std::vector<fvec3> mVerts;
+      std::vector<u32> mIndices;
+    };
+
+    std::map<Key, Entry> mEntries;
+    int mHits;
+    int mMisses;
+  };
+
   /**
    * Tessellates a complex polygon defined by a set of outlines into a set of triangles that can be rendered by Visualization Library.
    * For more information see the OpenGL Programmer's Guide chapter #11 "Tessellators and Quadrics".
+   *
+   * The result is available both as a triangle soup, see tessellatedTris(), and in indexed form, see tessellatedVerts()
+   * and tessellatedIndices(). Many polygons can be tessellated concurrently using tessellateBatch() and their results
+   * merged in a single indexed triangle set using mergeTessellations().
    */
   class VLGRAPHICS_EXPORT Tessellator: public Object
   {
@@ -78,6 +141,21 @@ namespace vl
     //! A set of triangles representing the tessellated polygon.
     std::vector<fvec3>& tessellatedTris() { return mTessellatedTris; }
 
+    //! The vertices referenced by tessellatedIndices(): the contour vertices followed by the vertices generated by the tessellator.
+    const std::vector<fvec3>& tessellatedVerts() const { return mTessellatedVerts; }
+
+    //! The indices into tessellatedVerts() of the triangles representing the tessellated polygon, equivalent to tessellatedTris().
+    const std::vector<u32>& tessellatedIndices() const { return mTessellatedIndices; }
+
+    //! If not NULL the tessellations are looked up in and stored into the given cache.
+    void setCache(TessellationCache* cache) { mCache = cache; }
+
+    //! If not NULL the tessellations are looked up in and stored into the given cache.
+    const TessellationCache* cache() const { return mCache.get(); }
+
+    //! If not NULL the tessellations are looked up in and stored into the given cache.
+    TessellationCache* cache() { return mCache.get(); }
+
     //! See gluTessNormal documentation.
     void setTessNormal(const fvec3& normal) { mTessNormal = normal; }
 
@@ -115,17 +193,42 @@ namespace vl
     //! Utility function that calls tessellate() and creates a Geometry with the tessellated triangles.
     ref<Geometry> tessellateGeometry(bool append_tessellated_tris=false);
 
+    /**
+     * Calls tessellate() on each of the given tessellators, concurrently if OpenMP is enabled, using one GLU tessellator object per thread.
+     * Tessellations found in the tessellators' cache() are not recomputed. Returns \p false if any of the tessellations failed.
+     */
+    static bool tessellateBatch(const std::vector< ref<Tessellator> >& tessellators, bool append_tessellated_tris=false);
+
+    /**
+     * Concatenates the tessellatedVerts() and tessellatedIndices() of the given tessellators in a single indexed triangle set,
+     * ready to be used with a DrawElementsUInt.
+     */
+    static void mergeTessellations(const std::vector< ref<Tessellator> >& tessellators, std::vector<fvec3>& verts, std::vector<u32>& indices);
+
     void setTessellateIntoSinglePolygon(bool on) { mTessellateIntoSinglePolygon = on; }
 
     bool tessellateIntoSinglePolygon() const { return mTessellateIntoSinglePolygon; }
 
   protected:
+    //! A vertex generated by the GLU tessellator, the GLU vertex data points to mIndex.
+    struct CombinedVertex
+    {
+      u32 mIndex;
+      dvec3 mPos;
+    };
+
     static void CALLBACK tessBeginData( GLenum type, Tessellator* tessellator );
-    static void CALLBACK tessVertexData( dvec3* vec, Tessellator* tessellator );
-    static void CALLBACK tessCombineData( GLdouble coords[3], dvec3 *d[4], GLfloat w[4], dvec3 **dataOut, Tessellator* tessellator );
+    static void CALLBACK tessVertexData( u32* index, Tessellator* tessellator );
+    static void CALLBACK tessCombineData( GLdouble coords[3], u32 *d[4], GLfloat w[4], u32 **dataOut, Tessellator* tessellator );
     static void CALLBACK tessEnd(void);
     static void CALLBACK tessError( GLenum errno );
+    static GLUtesselator* newGLUTessellator();
     void freeCombinedVertices();
+    bool beginTessellation(bool append_tessellated_tris);
+    bool tessellateFromCache();
+    void tessellate(GLUtesselator* tobj);
+    void storeInCache();
+    void endTessellation();
 
   protected:
     // input
@@ -133,11 +236,20 @@ namespace vl
     std::vector<dvec3> mContourVerts;
     // output
     std::vector<fvec3> mTessellatedTris;
+    std::vector<fvec3> mTessellatedVerts;
+    std::vector<u32> mTessellatedIndices;
     // intermediate data
-    std::vector< std::vector<fvec3> > mFans;
-    std::vector< std::vector<fvec3> > mTriStrips;
-    std::vector< std::vector<fvec3> > mLineLoops;
-    std::vector< dvec3* > mCombinedVertices;
+    std::vector<u32> mContourIndices;
+    std::vector<u32> mTris;
+    std::vector< std::vector<u32> > mFans;
+    std::vector< std::vector<u32> > mTriStrips;
+    std::vector< std::vector<u32> > mLineLoops;
+    std::vector< CombinedVertex* > mCombinedVertices;
+    // cache
+    ref<TessellationCache> mCache;
+    TessellationCache::Key mCacheKey;
+    size_t mFirstVert;
+    size_t mFirstIndex;
     GLenum mPrimitiveType;
     // see gluTessNorml()
     fvec3 mTessNormal;
@@ -40,7 +40,7 @@
 using namespace vl;
 
 //-----------------------------------------------------------------------------
-void Text::render_Implementation(const Actor* actor, const Shader*, const Camera* camera, OpenGLContext* gl_context) const
+void Text::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
 {
   gl_context->bindVAS(NULL, false, false);
 
@@ -72,9 +72,8 @@ void Text::render_Implementation(const Actor* actor, const Shader*, const Camera
 
   // Pass #1
 
-  // disable z-writing
-  GLboolean depth_mask=0;
-  glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+  // disable z-writing, the write masks are shadowed by the OpenGLContext to avoid glGet*() stalls
+  const bool depth_mask = gl_context->currentDepthMask();
   glDepthMask(GL_FALSE);
 
   // background
@@ -87,19 +86,44 @@ void Text::render_Implementation(const Actor* actor, const Shader*, const Camera
 
   // to have the most correct results we should render the text twice one for color and stencil, the other for the z-buffer
 
-  // shadow render
-  if (shadowEnabled())
-    renderText( actor, camera, shadowColor(), shadowVector() );
-  // outline render
-  if (outlineEnabled())
+  // signed distance field fonts compute shadow, outline and text in a single pass
+  const GLSLProgram* sdf_program = font()->signedDistanceField() && Has_GL_Version_3_0 ? mFont->signedDistanceFieldProgram() : NULL;
+  if (sdf_program)
   {
-    renderText( actor, camera, outlineColor(), fvec2(-1,0) );
-    renderText( actor, camera, outlineColor(), fvec2(+1,0) );
-    renderText( actor, camera, outlineColor(), fvec2(0,-1) );
-    renderText( actor, camera, outlineColor(), fvec2(0,+1) );
+    gl_context->useGLSLProgram(sdf_program);
+
+    const fvec4 outline_color = outlineEnabled() ? outlineColor() : fvec4(0,0,0,0);
+    const fvec4 shadow_color  = shadowEnabled()  ? shadowColor()  : fvec4(0,0,0,0);
+    // 1 pixel outline, in distance field units
+    const float outline_width = 1.0f / (2.0f * font()->signedDistanceFieldSpread());
+
+    glUniform1i( sdf_program->getUniformLocation("vl_SDFTexture"), 0 );
+    glUniform1f( sdf_program->getUniformLocation("vl_SDFOutlineWidth"), outline_width );
+    glUniform4fv( sdf_program->getUniformLocation("vl_SDFOutlineColor"), 1, outline_color.ptr() );
+    glUniform2fv( sdf_program->getUniformLocation("vl_SDFShadowOffset"), 1, shadowVector().ptr() );
+    glUniform4fv( sdf_program->getUniformLocation("vl_SDFShadowColor"), 1, shadow_color.ptr() );
+
+    renderText( actor, camera, color(), fvec2(0,0) );
+
+    // restore the Shader's GLSLProgram
+    gl_context->useGLSLProgram( shader ? shader->glslProgram() : NULL );
+  }
+  else
+  {
+    // shadow render
+    if (shadowEnabled())
+      renderText( actor, camera, shadowColor(), shadowVector() );
+    // outline render
+    if (outlineEnabled())
+    {
+      renderText( actor, camera, outlineColor(), fvec2(-1,0) );
+      renderText( actor, camera, outlineColor(), fvec2(+1,0) );
+      renderText( actor, camera, outlineColor(), fvec2(0,-1) );
+      renderText( actor, camera, outlineColor(), fvec2(0,+1) );
+    }
+    // text render
+    renderText( actor, camera, color(), fvec2(0,0) );
   }
-  // text render
-  renderText( actor, camera, color(), fvec2(0,0) );
 
   // Pass #2
   // fills the z-buffer (not the stencil buffer): approximated to the text bbox
@@ -110,16 +134,12 @@ void Text::render_Implementation(const Actor* actor, const Shader*, const Camera
   if (depth_mask)
   {
     // disables writing to the color buffer
-    GLboolean color_mask[4];
-    glGetBooleanv(GL_COLOR_WRITEMASK, color_mask);
+    const ubvec4 color_mask = gl_context->currentColorMask();
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
     // disable writing to the stencil buffer
-    int stencil_front_mask=0;
-    glGetIntegerv(GL_STENCIL_WRITEMASK, &stencil_front_mask);
-    int stencil_back_mask=0;
-    if (Has_GL_Version_2_0)
-      glGetIntegerv(GL_STENCIL_BACK_WRITEMASK, &stencil_back_mask);
+    unsigned int stencil_front_mask = 0, stencil_back_mask = 0;
+    gl_context->currentStencilMask(stencil_front_mask, stencil_back_mask);
     glStencilMask(0);
 
     // background
@@ -129,7 +149,7 @@ void Text::render_Implementation(const Actor* actor, const Shader*, const Camera
     renderBorder( actor, camera );
 
     // restores color writing
-    glColorMask(color_mask[0],color_mask[1],color_mask[2],color_mask[3]);
+    glColorMask(color_mask.r(),color_mask.g(),color_mask.b(),color_mask.a());
 
     // restore the stencil masks
     glStencilMask(stencil_front_mask);
@@ -142,49 +162,14 @@ void Text::render_Implementation(const Actor* actor, const Shader*, const Camera
   glNormal3fv( gl_context->normal().ptr() );
 }
 //-----------------------------------------------------------------------------
-void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& color, const fvec2& offset) const
+void Text::updateGlyphLayout() const
 {
-  if(!mFont)
-  {
-    Log::error("Text::renderText() error: no Font assigned to the Text object.\n");
-    VL_TRAP()
+  if ( ! mGlyphLayoutDirty && mGlyphLayoutFont == mFont.get() && mGlyphLayoutFontVersion == mFont->glyphCacheVersion() )
     return;
-  }
-
-  if (!font()->mFT_Face)
-  {
-    Log::error("Text::renderText() error: invalid FT_Face: probably you tried to load an unsupported font format.\n");
-    VL_TRAP()
-    return;
-  }
-
-  int viewport[] = { camera->viewport()->x(), camera->viewport()->y(), camera->viewport()->width(), camera->viewport()->height() };
-
-  if (viewport[2] < 1) viewport[2] = 1;
-  if (viewport[3] < 1) viewport[3] = 1;
-
-  // note that we only save and restore the server side states
-
-  if (mode() == Text2D)
-  {
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
-    VL_CHECK_OGL();
-
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    // glLoadIdentity();
-    // gluOrtho2D( -0.5f, viewport[2]-0.5f, -0.5f, viewport[3]-0.5f );
 
-    // clever trick part #1
-    fmat4 mat = fmat4::getOrtho(-0.5f, viewport[2]-0.5f, -0.5f, viewport[3]-0.5f, -1, +1);
-    mat.e(2,2) = 1.0f; // preserve the z value from the incoming vertex.
-    mat.e(2,3) = 0.0f;
-    glLoadMatrixf(mat.ptr());
-
-    VL_CHECK_OGL();
-  }
+  mGlyphVerts.clear();
+  mGlyphTexCoords.clear();
+  mGlyphBatches.clear();
 
   AABB rbbox = rawboundingRect( text() ); // for text alignment
   VL_CHECK(rbbox.maxCorner().z() == 0)
@@ -195,74 +180,19 @@ void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& col
   VL_CHECK(bbox.maxCorner().z() == 0)
   VL_CHECK(bbox.minCorner().z() == 0)
 
-  // basic render states
+  // glyph quads grouped by atlas texture
+  std::map< unsigned int, std::vector<fvec2> > verts;
+  std::map< unsigned int, std::vector<fvec2> > texcs;
 
   fvec2 pen(0,0);
+  fvec2 vect[4];
 
-  float texc[] = { 0,0, 0,0, 0,0, 0,0 };
-  VL_glActiveTexture( GL_TEXTURE0 );
-  glEnable(GL_TEXTURE_2D);
-  VL_glClientActiveTexture( GL_TEXTURE0 );
-  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-  glTexCoordPointer(2, GL_FLOAT, 0, texc);
-
-  // Constant color
-  glColor4f( color.r(), color.g(), color.b(), color.a() );
-
-  // Constant normal
-  glNormal3f( 0, 0, 1 );
-
-  fvec3 vect[4];
-  glEnableClientState( GL_VERTEX_ARRAY );
-  glVertexPointer(3, GL_FLOAT, 0, vect[0].ptr());
+  // transparent margin around the glyph images
+  const float gm = (float)mFont->glyphMargin();
 
   FT_Long has_kerning = FT_HAS_KERNING( font()->mFT_Face );
   FT_UInt previous = 0;
 
-  // viewport alignment
-  fmat4 m = mMatrix;
-
-  int w = camera->viewport()->width();
-  int h = camera->viewport()->height();
-
-  if (w < 1) w = 1;
-  if (h < 1) h = 1;
-
-  if ( !(actor && actor->transform()) && mode() == Text2D )
-  {
-    if (viewportAlignment() & AlignHCenter)
-    {
-      VL_CHECK( !(viewportAlignment() & AlignRight) )
-      VL_CHECK( !(viewportAlignment() & AlignLeft) )
-      // vect[i].x() += int((viewport[2]-1.0f) / 2.0f);
-      m.translate( (float)int((w-1.0f) / 2.0f), 0, 0);
-    }
-
-    if (viewportAlignment() & AlignRight)
-    {
-      VL_CHECK( !(viewportAlignment() & AlignHCenter) )
-      VL_CHECK( !(viewportAlignment() & AlignLeft) )
-      // vect[i].x() += int(viewport[2]-1.0f);
-      m.translate( (float)int(w-1.0f), 0, 0);
-    }
-
-    if (viewportAlignment() & AlignTop)
-    {
-      VL_CHECK( !(viewportAlignment() & AlignBottom) )
-      VL_CHECK( !(viewportAlignment() & AlignVCenter) )
-      // vect[i].y() += int(viewport[3]-1.0f);
-      m.translate( 0, (float)int(h-1.0f), 0);
-    }
-
-    if (viewportAlignment() & AlignVCenter)
-    {
-      VL_CHECK( !(viewportAlignment() & AlignTop) )
-      VL_CHECK( !(viewportAlignment() & AlignBottom) )
-      // vect[i].y() += int((viewport[3]-1.0f) / 2.0f);
-      m.translate( 0, (float)int((h-1.0f) / 2.0f), 0);
-    }
-  }
-
   // split the text in different lines
 
   VL_CHECK(text().length())
@@ -366,84 +296,37 @@ void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& col
 
       if (glyph->textureHandle())
       {
-        glBindTexture( GL_TEXTURE_2D, glyph->textureHandle() );
-
-        texc[0] = glyph->s0();
-        texc[1] = glyph->t1();
-
-        texc[2] = glyph->s1();
-        texc[3] = glyph->t1();
+        int left = layout() == RightToLeftText ? -glyph->left() : +glyph->left();
 
-        texc[4] = glyph->s1();
-        texc[5] = glyph->t0();
+        // quad layout
 
-        texc[6] = glyph->s0();
-        texc[7] = glyph->t0();
+        vect[0].x() = pen.x() + glyph->width()*0 + left - gm;
+        vect[0].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() - gm;
 
-        int left = layout() == RightToLeftText ? -glyph->left() : +glyph->left();
+        vect[1].x() = pen.x() + glyph->width()*1 + left + gm;
+        vect[1].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() - gm;
 
-        // triangle strip layout
+        vect[2].x() = pen.x() + glyph->width()*1 + left + gm;
+        vect[2].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() + gm;
 
-        vect[0].x() = pen.x() + glyph->width()*0 + left -1;
-        vect[0].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() -1;
+        vect[3].x() = pen.x() + glyph->width()*0 + left - gm;
+        vect[3].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() + gm;
 
-        vect[1].x() = pen.x() + glyph->width()*1 + left +1;
-        vect[1].y() = pen.y() + glyph->height()*0 + glyph->top() - glyph->height() -1;
+        for(int i=0; i<4; ++i)
+        {
+          if (layout() == RightToLeftText)
+            vect[i].x() -= glyph->width()-1 + 2*gm;
 
-        vect[2].x() = pen.x() + glyph->width()*1 + left +1;
-        vect[2].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() +1;
+          vect[i].y() -= mFont->mHeight;
 
-        vect[3].x() = pen.x() + glyph->width()*0 + left -1;
-        vect[3].y() = pen.y() + glyph->height()*1 + glyph->top() - glyph->height() +1;
+          // normalize coordinate orgin to the bottom/left corner
+          vect[i].x() -= (float)bbox.minCorner().x();
+          vect[i].y() -= (float)bbox.minCorner().y();
 
-        if (layout() == RightToLeftText)
-        {
-  #if (1)
-          vect[0].x() -= glyph->width()-1 +2;
-          vect[1].x() -= glyph->width()-1 +2;
-          vect[2].x() -= glyph->width()-1 +2;
-          vect[3].x() -= glyph->width()-1 +2;
-  #endif
-        }
+          vect[i].x() += applied_margin + displace;
+          vect[i].y() += applied_margin;
 
-        vect[0].y() -= mFont->mHeight;
-        vect[1].y() -= mFont->mHeight;
-        vect[2].y() -= mFont->mHeight;
-        vect[3].y() -= mFont->mHeight;
-
-  #if (1)
-        // normalize coordinate orgin to the bottom/left corner
-        vect[0] -= (fvec3)bbox.minCorner();
-        vect[1] -= (fvec3)bbox.minCorner();
-        vect[2] -= (fvec3)bbox.minCorner();
-        vect[3] -= (fvec3)bbox.minCorner();
-  #endif
-
-  #if (1)
-        vect[0].x() += applied_margin + displace;
-        vect[1].x() += applied_margin + displace;
-        vect[2].x() += applied_margin + displace;
-        vect[3].x() += applied_margin + displace;
-
-        vect[0].y() += applied_margin;
-        vect[1].y() += applied_margin;
-        vect[2].y() += applied_margin;
-        vect[3].y() += applied_margin;
-  #endif
-
-        // apply offset for outline rendering
-        vect[0].x() += offset.x();
-        vect[0].y() += offset.y();
-        vect[1].x() += offset.x();
-        vect[1].y() += offset.y();
-        vect[2].x() += offset.x();
-        vect[2].y() += offset.y();
-        vect[3].x() += offset.x();
-        vect[3].y() += offset.y();
-
-        // alignment
-        for(int i=0; i<4; ++i)
-        {
+          // alignment
           if (alignment() & AlignHCenter)
           {
             VL_CHECK( !(alignment() & AlignRight) )
@@ -473,52 +356,14 @@ void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& col
           }
         }
 
-        // apply text transform
-        vect[0] = m * vect[0];
-        vect[1] = m * vect[1];
-        vect[2] = m * vect[2];
-        vect[3] = m * vect[3];
-
-        // actor's transform following in Text2D
-        if ( actor->transform() && mode() == Text2D )
-        {
-          vec4 v(0,0,0,1);
-          v = actor->transform()->worldMatrix() * v;
-
-          camera->project(v,v);
-
-          // from screen space to viewport space
-          v.x() -= viewport[0];
-          v.y() -= viewport[1];
-
-          v.x() = (float)int(v.x());
-          v.y() = (float)int(v.y());
-
-          vect[0].x() += (float)v.x();
-          vect[0].y() += (float)v.y();
-          vect[1].x() += (float)v.x();
-          vect[1].y() += (float)v.y();
-          vect[2].x() += (float)v.x();
-          vect[2].y() += (float)v.y();
-          vect[3].x() += (float)v.x();
-          vect[3].y() += (float)v.y();
-
-          // clever trick part #2
-          vect[0].z() =
-          vect[1].z() =
-          vect[2].z() =
-          vect[3].z() = float((v.z() - 0.5f) / 0.5f);
-        }
+        std::vector<fvec2>& batch_verts = verts[glyph->textureHandle()];
+        std::vector<fvec2>& batch_texcs = texcs[glyph->textureHandle()];
 
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4); VL_CHECK_OGL();
-
-        #if (0)
-          glDisable(GL_TEXTURE_2D);
-          glColor3fv(vec3(1,0,0).ptr());
-          glDrawArrays(GL_LINE_LOOP, 0, 4);
-          glColor4fv(color.ptr());
-          glEnable(GL_TEXTURE_2D);
-        #endif
+        batch_verts.insert( batch_verts.end(), vect, vect+4 );
+        batch_texcs.push_back( fvec2(glyph->s0(), glyph->t1()) );
+        batch_texcs.push_back( fvec2(glyph->s1(), glyph->t1()) );
+        batch_texcs.push_back( fvec2(glyph->s1(), glyph->t0()) );
+        batch_texcs.push_back( fvec2(glyph->s0(), glyph->t0()) );
       }
 
       if (just_space && lines[iline][c] == ' ' && iline != lines.size()-1)
@@ -553,16 +398,176 @@ void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& col
     }
   }
 
+  // concatenate the batches in a single vertex array
+  std::map< unsigned int, std::vector<fvec2> >::const_iterator it = verts.begin();
+  for( ; it != verts.end(); ++it )
+  {
+    const std::vector<fvec2>& batch_texcs = texcs[it->first];
+    mGlyphBatches.push_back( GlyphBatch(it->first, (int)mGlyphVerts.size(), (int)it->second.size()) );
+    mGlyphVerts.insert( mGlyphVerts.end(), it->second.begin(), it->second.end() );
+    mGlyphTexCoords.insert( mGlyphTexCoords.end(), batch_texcs.begin(), batch_texcs.end() );
+  }
+
+  mGlyphLayoutBounds = alignedBoundingRect( rbbox );
+  mGlyphLayoutDirty = false;
+  mGlyphLayoutFont = mFont.get();
+  mGlyphLayoutFontVersion = mFont->glyphCacheVersion();
+}
+//-----------------------------------------------------------------------------
+void Text::renderText(const Actor* actor, const Camera* camera, const fvec4& color, const fvec2& offset) const
+{
+  if(!mFont)
+  {
+    Log::error("Text::renderText() error: no Font assigned to the Text object.\n");
+    VL_TRAP()
+    return;
+  }
+
+  if (!font()->mFT_Face)
+  {
+    Log::error("Text::renderText() error: invalid FT_Face: probably you tried to load an unsupported font format.\n");
+    VL_TRAP()
+    return;
+  }
+
+  updateGlyphLayout();
+
+  if (mGlyphBatches.empty())
+    return;
+
+  int viewport[] = { camera->viewport()->x(), camera->viewport()->y(), camera->viewport()->width(), camera->viewport()->height() };
+
+  if (viewport[2] < 1) viewport[2] = 1;
+  if (viewport[3] < 1) viewport[3] = 1;
+
+  // text transform, outline offset, viewport alignment and actor tracking are applied with a single matrix
+
+  fmat4 m = mMatrix;
+
+  int w = camera->viewport()->width();
+  int h = camera->viewport()->height();
+
+  if (w < 1) w = 1;
+  if (h < 1) h = 1;
+
+  if ( !(actor && actor->transform()) && mode() == Text2D )
+  {
+    if (viewportAlignment() & AlignHCenter)
+    {
+      VL_CHECK( !(viewportAlignment() & AlignRight) )
+      VL_CHECK( !(viewportAlignment() & AlignLeft) )
+      m.translate( (float)int((w-1.0f) / 2.0f), 0, 0);
+    }
+
+    if (viewportAlignment() & AlignRight)
+    {
+      VL_CHECK( !(viewportAlignment() & AlignHCenter) )
+      VL_CHECK( !(viewportAlignment() & AlignLeft) )
+      m.translate( (float)int(w-1.0f), 0, 0);
+    }
+
+    if (viewportAlignment() & AlignTop)
+    {
+      VL_CHECK( !(viewportAlignment() & AlignBottom) )
+      VL_CHECK( !(viewportAlignment() & AlignVCenter) )
+      m.translate( 0, (float)int(h-1.0f), 0);
+    }
+
+    if (viewportAlignment() & AlignVCenter)
+    {
+      VL_CHECK( !(viewportAlignment() & AlignTop) )
+      VL_CHECK( !(viewportAlignment() & AlignBottom) )
+      m.translate( 0, (float)int((h-1.0f) / 2.0f), 0);
+    }
+  }
+
+  // apply offset for outline rendering
+  m = m * fmat4::getTranslation( offset.x(), offset.y(), 0 );
+
+  // actor's transform following in Text2D
+  if ( actor->transform() && mode() == Text2D )
+  {
+    vec4 v(0,0,0,1);
+    v = actor->transform()->worldMatrix() * v;
+
+    camera->project(v,v);
+
+    // from screen space to viewport space
+    v.x() -= viewport[0];
+    v.y() -= viewport[1];
+
+    v.x() = (float)int(v.x());
+    v.y() = (float)int(v.y());
+
+    m = fmat4::getTranslation( (float)v.x(), (float)v.y(), 0 ) * m;
+
+    // clever trick part #2
+    m.e(2,0) = 0;
+    m.e(2,1) = 0;
+    m.e(2,2) = 0;
+    m.e(2,3) = float((v.z() - 0.5f) / 0.5f);
+  }
+
+  // note that we only save and restore the server side states
+
+  glMatrixMode(GL_MODELVIEW);
+  glPushMatrix();
+  if (mode() == Text2D)
+    glLoadMatrixf(m.ptr());
+  else
+    glMultMatrixf(m.ptr());
+  VL_CHECK_OGL();
+
+  if (mode() == Text2D)
+  {
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    // glLoadIdentity();
+    // gluOrtho2D( -0.5f, viewport[2]-0.5f, -0.5f, viewport[3]-0.5f );
+
+    // clever trick part #1
+    fmat4 mat = fmat4::getOrtho(-0.5f, viewport[2]-0.5f, -0.5f, viewport[3]-0.5f, -1, +1);
+    mat.e(2,2) = 1.0f; // preserve the z value from the incoming vertex.
+    mat.e(2,3) = 0.0f;
+    glLoadMatrixf(mat.ptr());
+
+    VL_CHECK_OGL();
+  }
+
+  // basic render states
+
+  VL_glActiveTexture( GL_TEXTURE0 );
+  glEnable(GL_TEXTURE_2D);
+  VL_glClientActiveTexture( GL_TEXTURE0 );
+  glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+  glTexCoordPointer(2, GL_FLOAT, 0, mGlyphTexCoords[0].ptr());
+
+  // Constant color
+  glColor4f( color.r(), color.g(), color.b(), color.a() );
+
+  // Constant normal
+  glNormal3f( 0, 0, 1 );
+
+  glEnableClientState( GL_VERTEX_ARRAY );
+  glVertexPointer(2, GL_FLOAT, 0, mGlyphVerts[0].ptr());
+
+  // one draw call per atlas texture
+  for(size_t i=0; i<mGlyphBatches.size(); ++i)
+  {
+    glBindTexture( GL_TEXTURE_2D, mGlyphBatches[i].mTexture );
+    glDrawArrays( GL_QUADS, mGlyphBatches[i].mStart, mGlyphBatches[i].mCount ); VL_CHECK_OGL();
+  }
+
   glDisableClientState( GL_VERTEX_ARRAY ); VL_CHECK_OGL();
   glDisableClientState( GL_TEXTURE_COORD_ARRAY ); VL_CHECK_OGL();
 
   VL_CHECK_OGL();
 
+  glMatrixMode(GL_MODELVIEW);
+  glPopMatrix(); VL_CHECK_OGL()
+
   if (mode() == Text2D)
   {
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix(); VL_CHECK_OGL()
-
     glMatrixMode(GL_PROJECTION);
     glPopMatrix(); VL_CHECK_OGL()
   }
@@ -811,13 +816,24 @@ void Text::renderBorder(const Actor* actor, const Camera* camera) const
 //! the Text's matrix transform and the eventual actor's transform
 AABB Text::boundingRect() const
 {
+  // the bounds of the current text are computed together with the glyph layout
+  if ( font() && font()->mFT_Face && ! text().empty() )
+  {
+    updateGlyphLayout();
+    return mGlyphLayoutBounds;
+  }
   return boundingRect(text());
 }
 //-----------------------------------------------------------------------------
 AABB Text::boundingRect(const String& text) const
+{
+  return alignedBoundingRect( rawboundingRect( text ) );
+}
+//-----------------------------------------------------------------------------
+AABB Text::alignedBoundingRect(const AABB& raw_bbox) const
 {
   int applied_margin = backgroundEnabled() || borderEnabled() ? margin() : 0;
-  AABB bbox = rawboundingRect( text );
+  AABB bbox = raw_bbox;
   bbox.setMaxCorner( bbox.maxCorner() + vec3(2.0f*applied_margin,2.0f*applied_margin,0) );
 
   // normalize coordinate orgin to the bottom/left corner
@@ -43,6 +43,10 @@ namespace vl
 {
   /**
    * A Renderable that renders text with a given Font.
+   *
+   * The glyph quads are laid out once in a single vertex array, which is reused until the text, font or any of the
+   * layout parameters change, and drawn with one draw call per Font atlas texture (usually one).
+   * The shadow and outline passes reuse the same array with a different offset.
    * \sa
    * - Actor
    * - VectorGraphics
@@ -54,13 +58,14 @@ namespace vl
   public:
     Text(): mColor(1,1,1,1), mBorderColor(0,0,0,1), mBackgroundColor(1,1,1,1), mOutlineColor(0,0,0,1), mShadowColor(0,0,0,0.5f), mShadowVector(2,-2),
       mInterlineSpacing(5), mAlignment(AlignBottom|AlignLeft), mViewportAlignment(AlignBottom|AlignLeft), mMargin(5), mMode(Text2D), mLayout(LeftToRightText), mTextAlignment(TextAlignLeft),
-      mBorderEnabled(false), mBackgroundEnabled(false), mOutlineEnabled(false), mShadowEnabled(false), mKerningEnabled(true)
+      mBorderEnabled(false), mBackgroundEnabled(false), mOutlineEnabled(false), mShadowEnabled(false), mKerningEnabled(true),
+      mGlyphLayoutDirty(true), mGlyphLayoutFont(NULL), mGlyphLayoutFontVersion(0)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
 
     const String& text() const { return mText; }
-    void setText(const String& text) { mText = text; }
+    void setText(const String& text) { mText = text; mGlyphLayoutDirty = true; }
 
     const fvec4& color() const { return mColor; }
     void setColor(const fvec4& color) { mColor = color; }
@@ -81,7 +86,7 @@ namespace vl
     void setShadowVector(const fvec2& shadow_vector) { mShadowVector = shadow_vector; }
 
     int margin() const { return mMargin; }
-    void setMargin(int margin) { mMargin = margin; }
+    void setMargin(int margin) { mMargin = margin; mGlyphLayoutDirty = true; }
 
     const Font* font() const { return mFont.get(); }
     Font* font() { return mFont.get(); }
@@ -91,7 +96,7 @@ namespace vl
     void setMatrix(const fmat4& matrix) { mMatrix = matrix; }
 
     int  alignment() const { return mAlignment; }
-    void setAlignment(int  align) { mAlignment = align; }
+    void setAlignment(int  align) { mAlignment = align; mGlyphLayoutDirty = true; }
 
     int  viewportAlignment() const { return mViewportAlignment; }
     void setViewportAlignment(int  align) { mViewportAlignment = align; }
@@ -103,19 +108,19 @@ namespace vl
     void setMode(ETextMode mode) { mMode = mode; }
 
     ETextLayout layout() const { return mLayout; }
-    void setLayout(ETextLayout layout) { mLayout = layout; }
+    void setLayout(ETextLayout layout) { mLayout = layout; mGlyphLayoutDirty = true; }
 
     ETextAlign textAlignment() const { return mTextAlignment; }
-    void setTextAlignment(ETextAlign align) { mTextAlignment = align; }
+    void setTextAlignment(ETextAlign align) { mTextAlignment = align; mGlyphLayoutDirty = true; }
 
     bool borderEnabled() const { return mBorderEnabled; }
-    void setBorderEnabled(bool border) { mBorderEnabled = border; }
+    void setBorderEnabled(bool border) { mBorderEnabled = border; mGlyphLayoutDirty = true; }
 
     bool backgroundEnabled() const { return mBackgroundEnabled; }
-    void setBackgroundEnabled(bool background) { mBackgroundEnabled = background; }
+    void setBackgroundEnabled(bool background) { mBackgroundEnabled = background; mGlyphLayoutDirty = true; }
 
     bool kerningEnabled() const { return mKerningEnabled; }
-    void setKerningEnabled(bool kerning) { mKerningEnabled = kerning; }
+    void setKerningEnabled(bool kerning) { mKerningEnabled = kerning; mGlyphLayoutDirty = true; }
 
     bool outlineEnabled() const { return mOutlineEnabled; }
     void setOutlineEnabled(bool outline) { mOutlineEnabled = outline; }
@@ -141,10 +146,23 @@ namespace vl
     virtual void deleteBufferObject() {}
 
   protected:
+    //! A range of glyph quads sharing the same atlas texture.
+    struct GlyphBatch
+    {
+      GlyphBatch(unsigned int texture, int start, int count): mTexture(texture), mStart(start), mCount(count) {}
+      unsigned int mTexture;
+      int mStart;
+      int mCount;
+    };
+
+    //! Lays out the glyph quads in a single vertex array and caches the boundingRect() of the text, only if the text, font or layout parameters changed.
+    void updateGlyphLayout() const;
     void renderText(const Actor*, const Camera* camera, const fvec4& color, const fvec2& offset) const;
     void renderBackground(const Actor* actor, const Camera* camera) const;
     void renderBorder(const Actor* actor, const Camera* camera) const;
     AABB rawboundingRect(const String& text) const;
+    //! Applies margin and alignment to the result of rawboundingRect().
+    AABB alignedBoundingRect(const AABB& raw_bbox) const;
 
   protected:
     mutable ref<Font> mFont;
@@ -168,6 +186,14 @@ namespace vl
     bool mOutlineEnabled;
     bool mShadowEnabled;
     bool mKerningEnabled;
+    // cached glyph layout
+    mutable std::vector<fvec2> mGlyphVerts;
+    mutable std::vector<fvec2> mGlyphTexCoords;
+    mutable std::vector<GlyphBatch> mGlyphBatches;
+    mutable AABB mGlyphLayoutBounds;
+    mutable bool mGlyphLayoutDirty;
+    mutable const Font* mGlyphLayoutFont;
+    mutable unsigned int mGlyphLayoutFontVersion;
   };
 }
 
@@ -35,6 +35,7 @@
 #include <vlCore/math_utils.hpp>
 #include <vlCore/Say.hpp>
 #include <vlCore/Log.hpp>
+#include <vlCore/MemoryTracker.hpp>
 
 using namespace vl;
 
@@ -362,6 +363,10 @@ void Texture::destroyTexture()
     glDeleteTextures( 1, &mHandle ); VL_CHECK_OGL();
   }
 
+  if ( mMemoryUsage ) {
+    MemoryTracker::track( MC_Texture, -mMemoryUsage, -1 );
+  }
+
   reset();
   // getTexParameter()->mDirty = true;
 }
@@ -382,9 +387,13 @@ void Texture::reset()
   mHandle = 0;
   mManaged = true;
   mSetupParams = NULL;
+  mMemoryUsage = 0;
+  mMemoryUsageMipmaps = false;
   mBufferObject = NULL;
   mSamples = 0;
   mFixedSamplesLocation = true;
+  mImmutable = false;
+  mStorageLevels = 0;
   // TexParameter is not reset but is marked dirty
   mTexParameter->setDirty(true);
 }
@@ -393,6 +402,7 @@ Texture::Texture(int width, ETextureFormat format, bool border)
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
   if (!createTexture(vl::TD_TEXTURE_1D, format, width, 0, 0, border, NULL, 0, 0))
   {
@@ -404,6 +414,7 @@ Texture::Texture(int width, int height, ETextureFormat format, bool border)
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
   if (!createTexture(vl::TD_TEXTURE_2D, format, width, height, 0, border, NULL, 0, 0))
   {
@@ -415,6 +426,7 @@ Texture::Texture(int width, int height, int depth, ETextureFormat format, bool b
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
   if (!createTexture(vl::TD_TEXTURE_3D, format, width, height, depth, border, NULL, 0, 0))
   {
@@ -426,6 +438,7 @@ Texture::Texture(const Image* image, ETextureFormat format, bool mipmaps , bool
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
 
   if (image && image->isValid())
@@ -454,6 +467,7 @@ Texture::Texture(const String& image_path, ETextureFormat format, bool mipmaps ,
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
 
   ref<Image> image = vl::loadImage(image_path);
@@ -484,6 +498,7 @@ Texture::Texture()
 {
   VL_DEBUG_SET_OBJECT_NAME()
   mTexParameter = new TexParameter;
+  mImmutableStorage = false;
   reset();
 }
 //-----------------------------------------------------------------------------
@@ -703,7 +718,41 @@ bool Texture::supports(ETextureDimension tex_dimension, ETextureFormat tex_forma
 #endif
 }
 //-----------------------------------------------------------------------------
-bool Texture::createTexture(ETextureDimension tex_dimension, ETextureFormat tex_format, int w, int h, int d, bool border, BufferObject* buffer_object, int samples, bool fixedsamplelocations)
+namespace
+{
+  // number of levels of a full mipmap chain, array textures do not shrink along their layers
+  int mipmapChainLevels(ETextureDimension dim, int w, int h, int d)
+  {
+    int size = w;
+    if ( dim != TD_TEXTURE_1D && dim != TD_TEXTURE_1D_ARRAY )
+      size = h > size ? h : size;
+    if ( dim == TD_TEXTURE_3D )
+      size = d > size ? d : size;
+    int levels = 1;
+    while( size > 1 ) {
+      size >>= 1;
+      ++levels;
+    }
+    return levels;
+  }
+
+  // sized format required by glTexStorage*() for the given internal format, unknown formats are passed through
+  GLenum sizedStorageFormat(ETextureFormat format)
+  {
+    switch( format )
+    {
+      case TF_RGBA:            return GL_RGBA8;
+      case TF_RGB:             return GL_RGB8;
+      case TF_RG:              return GL_RG8;
+      case TF_RED:             return GL_R8;
+      case TF_DEPTH_COMPONENT: return GL_DEPTH_COMPONENT24;
+      case TF_DEPTH_STENCIL:   return GL_DEPTH24_STENCIL8;
+      default:                 return format;
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool Texture::createTexture(ETextureDimension tex_dimension, ETextureFormat tex_format, int w, int h, int d, bool border, BufferObject* buffer_object, int samples, bool fixedsamplelocations, int levels)
 {
   VL_CHECK_OGL()
 
@@ -765,6 +814,65 @@ bool Texture::createTexture(ETextureDimension tex_dimension, ETextureFormat tex_
   int default_format = getDefaultFormat(tex_format);
   int default_type   = getDefaultType(tex_format);
 
+#if defined(VL_OPENGL)
+  // immutable storage: all the levels are allocated at once
+  if ( mImmutableStorage && Has_Texture_Storage && ! border )
+  {
+    if ( levels <= 0 )
+    {
+      switch( getTexParameter()->minFilter() )
+      {
+        case TPF_LINEAR_MIPMAP_LINEAR:
+        case TPF_LINEAR_MIPMAP_NEAREST:
+        case TPF_NEAREST_MIPMAP_LINEAR:
+        case TPF_NEAREST_MIPMAP_NEAREST:
+          levels = mipmapChainLevels(tex_dimension, w, h, d);
+          break;
+        default:
+          levels = 1;
+      }
+    }
+    if ( tex_dimension == TD_TEXTURE_RECTANGLE )
+      levels = 1;
+
+    GLenum sized_format = sizedStorageFormat(tex_format);
+    switch( tex_dimension )
+    {
+      case TD_TEXTURE_1D:
+        glTexStorage1D( GL_TEXTURE_1D, levels, sized_format, w );
+        mImmutable = true;
+        break;
+      case TD_TEXTURE_2D:
+      case TD_TEXTURE_RECTANGLE:
+      case TD_TEXTURE_CUBE_MAP:
+      case TD_TEXTURE_1D_ARRAY:
+        glTexStorage2D( tex_dimension, levels, sized_format, w, h );
+        mImmutable = true;
+        break;
+      case TD_TEXTURE_3D:
+      case TD_TEXTURE_2D_ARRAY:
+        glTexStorage3D( tex_dimension, levels, sized_format, w, h, d );
+        mImmutable = true;
+        break;
+      default:
+        break;
+    }
+
+    // formats without a sized equivalent (luminance, alpha, generic compressed etc.) fall back to mutable storage
+    if ( mImmutable && glGetError() != GL_NO_ERROR )
+    {
+      Log::debug( Say("Texture::createTexture(): immutable storage not available for format 0x%h, using mutable storage.\n") << (int)tex_format );
+      mImmutable = false;
+    }
+    mStorageLevels = mImmutable ? levels : 0;
+  }
+#endif
+
+  if (mImmutable)
+  {
+    // storage allocated above
+  }
+  else
   if (tex_dimension == TD_TEXTURE_2D_MULTISAMPLE)
   {
     glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, tex_format, w, h, fixedsamplelocations ); VL_CHECK_OGL();
@@ -838,6 +946,20 @@ bool Texture::createTexture(ETextureDimension tex_dimension, ETextureFormat tex_
   }
 
   glBindTexture(tex_dimension, 0); VL_CHECK_OGL();
+
+  // report the storage to MemoryTracker, texture buffers use the storage of their BufferObject
+  if ( tex_dimension != TD_TEXTURE_BUFFER )
+  {
+    long long texels = (long long)w * (h ? h : 1) * (d ? d : 1) * (tex_dimension == TD_TEXTURE_CUBE_MAP ? 6 : 1) * (samples > 0 ? samples : 1);
+    mMemoryUsage = texels * estimatedBitsPerTexel(tex_format) / 8;
+    // immutable storage allocates the mipmap chain upfront
+    if ( mStorageLevels > 1 )
+    {
+      mMemoryUsage += mMemoryUsage / 3;
+      mMemoryUsageMipmaps = true;
+    }
+    MemoryTracker::track( MC_Texture, mMemoryUsage, 1 );
+  }
   return true;
 }
 //-----------------------------------------------------------------------------
@@ -877,11 +999,20 @@ bool Texture::setMipLevel(int mip_level, const Image* img, bool gen_mipmaps)
 
   glBindTexture( dimension(), mHandle ); VL_CHECK_OGL()
 
-  int w = width()  + (border()?2:0);
-  int h = height() + (border()?2:0);
-  int d = depth()  + (border()?2:0);
+  // size of the requested mip level, array textures keep their layer count
+  int w = width() >> mip_level;
+  int h = dimension() == TD_TEXTURE_1D_ARRAY ? height() : height() >> mip_level;
+  int d = dimension() == TD_TEXTURE_2D_ARRAY ? depth()  : depth()  >> mip_level;
+  w = (w ? w : 1) + (border()?2:0);
+  h = (h ? h : 1) + (border()?2:0);
+  d = (d ? d : 1) + (border()?2:0);
   int is_compressed = (int)img->format() == (int)internalFormat() && isCompressedFormat( internalFormat() );
 
+#if defined(VL_OPENGL)
+  if ( mImmutable )
+    return setMipLevelImmutable( mip_level, img, gen_mipmaps, w, h, d, is_compressed != 0 );
+#endif
+
   bool use_glu = false;
   GLint generate_mipmap_orig = GL_FALSE;
   if ( gen_mipmaps )
@@ -1006,12 +1137,12 @@ bool Texture::setMipLevel(int mip_level, const Image* img, bool gen_mipmaps)
   {
     if (is_compressed)
     {
-      glCompressedTexImage2D(GL_TEXTURE_1D_ARRAY, mip_level, internalFormat(), width(), height(), 0, img->requiredMemory(), img->pixels());
+      glCompressedTexImage2D(GL_TEXTURE_1D_ARRAY, mip_level, internalFormat(), w, h, 0, img->requiredMemory(), img->pixels());
       VL_CHECK_OGL()
     }
     else
     {
-      glTexImage2D(GL_TEXTURE_1D_ARRAY, mip_level, internalFormat(), width(), height(), 0, img->format(), img->type(), img->pixels());
+      glTexImage2D(GL_TEXTURE_1D_ARRAY, mip_level, internalFormat(), w, h, 0, img->format(), img->type(), img->pixels());
       VL_CHECK_OGL()
     }
   }
@@ -1077,9 +1208,81 @@ bool Texture::setMipLevel(int mip_level, const Image* img, bool gen_mipmaps)
 
   glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
 
+  // a mipmap chain adds about a third to the base level
+  if ( ( gen_mipmaps || mip_level > 0 ) && mMemoryUsage && ! mMemoryUsageMipmaps )
+  {
+    MemoryTracker::track( MC_Texture, mMemoryUsage / 3 );
+    mMemoryUsage += mMemoryUsage / 3;
+    mMemoryUsageMipmaps = true;
+  }
+
   return true;
 }
 //-----------------------------------------------------------------------------
+bool Texture::setMipLevelImmutable(int mip_level, const Image* img, bool gen_mipmaps, int w, int h, int d, bool is_compressed)
+{
+#if defined(VL_OPENGL)
+  bool ok = mip_level < mStorageLevels;
+  if ( ! ok )
+  {
+    Log::error( Say("Texture::setMipLevel(): mip level %n exceeds the %n levels of the immutable storage.\n") << mip_level << mStorageLevels );
+  }
+  else
+  if (dimension() == TD_TEXTURE_CUBE_MAP)
+  {
+    const unsigned char* faces[] = { img->pixelsXP(), img->pixelsXN(), img->pixelsYP(), img->pixelsYN(), img->pixelsZP(), img->pixelsZN() };
+    for( int i=0; i<6; ++i )
+    {
+      if (is_compressed)
+        glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip_level, 0, 0, w, h, internalFormat(), img->requiredMemory() / 6, faces[i]);
+      else
+        glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, mip_level, 0, 0, w, h, img->format(), img->type(), faces[i]);
+      VL_CHECK_OGL()
+    }
+  }
+  else
+  if (dimension() == TD_TEXTURE_3D || dimension() == TD_TEXTURE_2D_ARRAY)
+  {
+    if (is_compressed)
+      glCompressedTexSubImage3D(dimension(), mip_level, 0, 0, 0, w, h, d, internalFormat(), img->requiredMemory(), img->pixels());
+    else
+      glTexSubImage3D(dimension(), mip_level, 0, 0, 0, w, h, d, img->format(), img->type(), img->pixels());
+    VL_CHECK_OGL()
+  }
+  else
+  if (dimension() == TD_TEXTURE_1D)
+  {
+    if (is_compressed)
+      glCompressedTexSubImage1D(GL_TEXTURE_1D, mip_level, 0, w, internalFormat(), img->requiredMemory(), img->pixels());
+    else
+      glTexSubImage1D(GL_TEXTURE_1D, mip_level, 0, w, img->format(), img->type(), img->pixels());
+    VL_CHECK_OGL()
+  }
+  else // TD_TEXTURE_2D, TD_TEXTURE_RECTANGLE, TD_TEXTURE_1D_ARRAY
+  {
+    if (is_compressed)
+      glCompressedTexSubImage2D(dimension(), mip_level, 0, 0, w, h, internalFormat(), img->requiredMemory(), img->pixels());
+    else
+      glTexSubImage2D(dimension(), mip_level, 0, 0, w, h, img->format(), img->type(), img->pixels());
+    VL_CHECK_OGL()
+  }
+
+  // fills the levels below mip_level, already allocated by glTexStorage*()
+  if ( ok && gen_mipmaps && mip_level + 1 < mStorageLevels )
+  {
+    glGenerateMipmap( dimension() ); VL_CHECK_OGL()
+  }
+
+  glBindTexture( dimension(), 0 ); VL_CHECK_OGL()
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+  return ok;
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
 bool Texture::createTexture()
 {
   VL_CHECK_OGL()
@@ -1141,6 +1344,25 @@ bool Texture::createTexture()
     if (tex_format == TF_UNKNOWN) {
       tex_format = (ETextureFormat)img->format();
     }
+    else
+    // compressed blocks can only be uploaded as they are: OpenGL does not transcode them
+    if ( Image::isCompressedFormat(img->format()) && (int)tex_format != (int)img->format() ) {
+      Log::warning( Say("Texture::createTexture(): the texture format of '%s' does not match its compressed image format, using the image format.\n") << img->objectName() );
+      tex_format = (ETextureFormat)img->format();
+    }
+  }
+
+  // levels allocated by immutable storage: the explicit mipmaps or the whole chain if generated
+  int levels = 0;
+  if ( img )
+  {
+    if ( !gen_mipmaps )
+      levels = 1;
+    else
+    if ( img->mipmaps().empty() )
+      levels = mipmapChainLevels( tex_dimension, w, h, d );
+    else
+      levels = 1 + (int)img->mipmaps().size();
   }
 
   if ( ! createTexture( tex_dimension,
@@ -1149,7 +1371,8 @@ bool Texture::createTexture()
                         border,
                         setupParams()->bufferObject(),
                         setupParams()->samples(),
-                        setupParams()->fixedSamplesLocations() ) ) {
+                        setupParams()->fixedSamplesLocations(),
+                        levels ) ) {
     return false;
   }
 
@@ -1206,6 +1429,9 @@ void Texture::clone(const Texture& other)
   mSamples       = other.mSamples;
   mBorder        = other.mBorder;
   mFixedSamplesLocation = other.mFixedSamplesLocation;
+  mImmutableStorage = other.mImmutableStorage;
+  mImmutable     = other.mImmutable;
+  mStorageLevels = other.mStorageLevels;
 }
 //-----------------------------------------------------------------------------
 bool Texture::isDepthTexture() const
@@ -1262,6 +1488,28 @@ bool Texture::isCompressedFormat(int format)
     TF_COMPRESSED_RED_GREEN_RGTC2_EXT,
     TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT,
 
+    // ARB_texture_compression_bptc
+    TF_COMPRESSED_RGBA_BPTC_UNORM,
+    TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,
+    TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,
+    TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
+
+    // ARB_ES3_compatibility (ETC2/EAC)
+    TF_COMPRESSED_RGB8_ETC2,
+    TF_COMPRESSED_SRGB8_ETC2,
+    TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,
+    TF_COMPRESSED_RGBA8_ETC2_EAC,
+    TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,
+    TF_COMPRESSED_R11_EAC,
+    TF_COMPRESSED_SIGNED_R11_EAC,
+    TF_COMPRESSED_RG11_EAC,
+    TF_COMPRESSED_SIGNED_RG11_EAC,
+
+    // KHR_texture_compression_astc_ldr
+    TF_COMPRESSED_RGBA_ASTC_4x4_KHR,
+    TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR,
+
     0
   };
 
@@ -1274,3 +1522,78 @@ bool Texture::isCompressedFormat(int format)
   return false;
 }
 //-----------------------------------------------------------------------------
+int Texture::estimatedBitsPerTexel(ETextureFormat format)
+{
+  switch(format)
+  {
+  case TF_COMPRESSED_RGB_FXT1_3DFX:
+  case TF_COMPRESSED_RGBA_FXT1_3DFX:
+  case TF_COMPRESSED_RGB_S3TC_DXT1_EXT:
+  case TF_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+  case TF_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+  case TF_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+  case TF_COMPRESSED_LUMINANCE_LATC1_EXT:
+  case TF_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
+  case TF_COMPRESSED_RED_RGTC1_EXT:
+  case TF_COMPRESSED_SIGNED_RED_RGTC1_EXT:
+  case TF_COMPRESSED_RGB8_ETC2:
+  case TF_COMPRESSED_SRGB8_ETC2:
+  case TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+  case TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+  case TF_COMPRESSED_R11_EAC:
+  case TF_COMPRESSED_SIGNED_R11_EAC:
+    return 4;
+
+  case TF_ALPHA: case TF_ALPHA4: case TF_ALPHA8: case TF_ALPHA8UI_EXT: case TF_ALPHA8I_EXT:
+  case TF_INTENSITY: case TF_INTENSITY4: case TF_INTENSITY8: case TF_INTENSITY8UI_EXT: case TF_INTENSITY8I_EXT:
+  case TF_LUMINANCE: case TF_LUMINANCE4: case TF_LUMINANCE8: case TF_LUMINANCE8UI_EXT: case TF_LUMINANCE8I_EXT:
+  case TF_LUMINANCE4_ALPHA4: case TF_LUMINANCE6_ALPHA2: case TF_R3_G3_B2: case TF_RGBA2:
+  case TF_RED: case TF_R8: case TF_R8I: case TF_R8UI: case TF_R8_SNORM:
+  case TF_SLUMINANCE: case TF_SLUMINANCE8:
+  case TF_COMPRESSED_ALPHA: case TF_COMPRESSED_INTENSITY: case TF_COMPRESSED_LUMINANCE: case TF_COMPRESSED_LUMINANCE_ALPHA:
+  case TF_COMPRESSED_RGB: case TF_COMPRESSED_RGBA: case TF_COMPRESSED_RED: case TF_COMPRESSED_RG:
+  case TF_COMPRESSED_SLUMINANCE: case TF_COMPRESSED_SLUMINANCE_ALPHA: case TF_COMPRESSED_SRGB: case TF_COMPRESSED_SRGB_ALPHA:
+  case TF_COMPRESSED_RGBA_S3TC_DXT3_EXT: case TF_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+  case TF_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT: case TF_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+  case TF_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT: case TF_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
+  case TF_COMPRESSED_RED_GREEN_RGTC2_EXT: case TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT:
+  case TF_COMPRESSED_RGBA_BPTC_UNORM: case TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+  case TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT: case TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+  case TF_COMPRESSED_RGBA8_ETC2_EAC: case TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+  case TF_COMPRESSED_RG11_EAC: case TF_COMPRESSED_SIGNED_RG11_EAC:
+  case TF_COMPRESSED_RGBA_ASTC_4x4_KHR: case TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR:
+    return 8;
+
+  case TF_ALPHA12: case TF_ALPHA16: case TF_ALPHA16F: case TF_ALPHA16UI_EXT: case TF_ALPHA16I_EXT:
+  case TF_INTENSITY12: case TF_INTENSITY16: case TF_INTENSITY16F: case TF_INTENSITY16UI_EXT: case TF_INTENSITY16I_EXT:
+  case TF_LUMINANCE12: case TF_LUMINANCE16: case TF_LUMINANCE16F: case TF_LUMINANCE16UI_EXT: case TF_LUMINANCE16I_EXT:
+  case TF_LUMINANCE_ALPHA: case TF_LUMINANCE8_ALPHA8: case TF_LUMINANCE12_ALPHA4: case TF_LUMINANCE_ALPHA8UI_EXT: case TF_LUMINANCE_ALPHA8I_EXT:
+  case TF_SLUMINANCE_ALPHA: case TF_SLUMINANCE8_ALPHA8:
+  case TF_RGBA4: case TF_RGB5_A1: case TF_RGB4: case TF_RGB5:
+  case TF_R16: case TF_R16F: case TF_R16I: case TF_R16UI: case TF_R16_SNORM:
+  case TF_RG: case TF_RG8: case TF_RG8I: case TF_RG8UI: case TF_RG8_SNORM:
+  case TF_DEPTH_COMPONENT16:
+    return 16;
+
+  case TF_RGB16: case TF_RGB16F: case TF_RGB16UI_EXT: case TF_RGB16I_EXT:
+  case TF_LUMINANCE12_ALPHA12:
+    return 48;
+
+  case TF_RGBA12: case TF_RGBA16: case TF_RGBA16F: case TF_RGBA16UI_EXT: case TF_RGBA16I_EXT:
+  case TF_RGBA16_SNORM:
+  case TF_RG32F: case TF_RG32I: case TF_RG32UI:
+  case TF_LUMINANCE_ALPHA32F: case TF_LUMINANCE_ALPHA32UI_EXT: case TF_LUMINANCE_ALPHA32I_EXT:
+  case TF_DEPTH32F_STENCIL8:
+    return 64;
+
+  case TF_RGB32F: case TF_RGB32UI_EXT: case TF_RGB32I_EXT:
+    return 96;
+
+  case TF_RGBA32F: case TF_RGBA32UI_EXT: case TF_RGBA32I_EXT:
+    return 128;
+
+  default:
+    return 32;
+  }
+}
+//-----------------------------------------------------------------------------
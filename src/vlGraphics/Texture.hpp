@@ -63,6 +63,7 @@ namespace vl
   {
     VL_INSTRUMENT_CLASS(vl::TexParameter, Object)
     friend class Texture;
+    friend class OpenGLContext;
 
   public:
     TexParameter();
@@ -81,23 +82,27 @@ namespace vl
     ETexCompareFunc compareFunc() const { return mCompareFunc; }
     EDepthTextureMode depthTextureMode() const { return mDepthTextureMode; }
 
-    void setMinFilter(ETexParamFilter minfilter) { mDirty = true; mMinFilter = minfilter; }
+    void setMinFilter(ETexParamFilter minfilter) { setSamplerDirty(); mMinFilter = minfilter; }
     void setMagFilter(ETexParamFilter magfilter);
     void setWrap(ETexParamWrap wrap)             { setWrapS(wrap); setWrapT(wrap); setWrapR(wrap); }
-    void setWrapS(ETexParamWrap texturewrap)     { mDirty = true; mWrapS = texturewrap; }
-    void setWrapT(ETexParamWrap texturewrap)     { mDirty = true; mWrapT = texturewrap; }
-    void setWrapR(ETexParamWrap texturewrap)     { mDirty = true; mWrapR = texturewrap; }
-    void setBorderColor(fvec4 bordercolor)       { mDirty = true; mBorderColor = bordercolor; }
-    void setAnisotropy(float anisotropy)         { mDirty = true; mAnisotropy = anisotropy; }
+    void setWrapS(ETexParamWrap texturewrap)     { setSamplerDirty(); mWrapS = texturewrap; }
+    void setWrapT(ETexParamWrap texturewrap)     { setSamplerDirty(); mWrapT = texturewrap; }
+    void setWrapR(ETexParamWrap texturewrap)     { setSamplerDirty(); mWrapR = texturewrap; }
+    void setBorderColor(fvec4 bordercolor)       { setSamplerDirty(); mBorderColor = bordercolor; }
+    void setAnisotropy(float anisotropy)         { setSamplerDirty(); mAnisotropy = anisotropy; }
     void setGenerateMipmap(bool generate_mipmap) { mDirty = true; mGenerateMipmap = generate_mipmap; }
-    void setCompareMode(ETexCompareMode mode) { mDirty = true; mCompareMode = mode; }
-    void setCompareFunc(ETexCompareFunc func) { mDirty = true; mCompareFunc = func; }
+    void setCompareMode(ETexCompareMode mode) { setSamplerDirty(); mCompareMode = mode; }
+    void setCompareFunc(ETexCompareFunc func) { setSamplerDirty(); mCompareFunc = func; }
     void setDepthTextureMode(EDepthTextureMode mode) { mDirty = true; mDepthTextureMode = mode; }
 
     void setDirty(bool dirty) const { mDirty = dirty; }
 
     bool dirty() const { return mDirty; }
 
+  protected:
+    // marks the parameters dirty and forgets the sampler object, see OpenGLContext::samplerObject()
+    void setSamplerDirty() { mDirty = true; mSamplerContext = NULL; }
+
   protected:
     ETexParamFilter mMinFilter;
     ETexParamFilter mMagfilter;
@@ -112,6 +117,11 @@ namespace vl
     bool mGenerateMipmap;
 
     mutable bool mDirty;
+
+    // sampler object matching these parameters, valid if mSamplerContext is not NULL, see OpenGLContext::samplerObject()
+    mutable const OpenGLContext* mSamplerContext;
+    mutable unsigned int mSamplerGeneration;
+    mutable unsigned int mSampler;
   };
   //------------------------------------------------------------------------------
   class TextureSampler;
@@ -266,9 +276,11 @@ namespace vl
     \note The OpenGL texture object is created immediately therefore an OpenGL context must be active when calling this function. */
     bool createTexture();
 
-    /** Creates an empty texture, with no mipmaps, of the specified type, format and dimensions.
+    /** Creates an empty texture of the specified type, format and dimensions.
+    \param levels The number of mipmap levels allocated by immutable storage, see setImmutableStorage(). If 0 the whole mipmap chain
+    is allocated when the minification filter of getTexParameter() uses mipmaps, otherwise a single level. Ignored by mutable textures.
     \note The OpenGL texture object is created immediately therefore an OpenGL context must be active when calling this function. */
-    bool createTexture(ETextureDimension tex_dimension, ETextureFormat tex_format, int w, int h, int d, bool border, BufferObject* bo, int samples, bool fixedsamplelocations);
+    bool createTexture(ETextureDimension tex_dimension, ETextureFormat tex_format, int w, int h, int d, bool border, BufferObject* bo, int samples, bool fixedsamplelocations, int levels=0);
 
     /** Copies the texture image to the specified mip-maping level. This function can be useful to
     specify one by one the mipmapping images or to create texture animation effects.
@@ -677,6 +689,10 @@ namespace vl
     /** OpenGL texture handle as returned by glGenTextures(). */
     unsigned int handle() const { return mHandle; }
 
+    /** Estimated GPU memory used by the texture in bytes, as reported to MemoryTracker under MC_Texture.
+    Returns 0 for texture buffers, whose storage is the one of their BufferObject, and for handles set with setHandle(). */
+    long long estimatedMemoryUsage() const { return mMemoryUsage; }
+
     /** If `managed` is true the texture will be automatically destroyed when the vl::Texture is destroyed or destroyTexture() is called.
     See also destroyTexture(). */
     void setManaged( bool managed ) { mManaged = managed; }
@@ -684,6 +700,20 @@ namespace vl
     See also destroyTexture(). */
     bool managed() const { return mManaged; }
 
+    /** If \p true the next createTexture() allocates all the mipmap levels at once with glTexStorage*() (default = false).
+    Immutable storage spares the driver the completeness and consistency checks of textures specified level by level with glTexImage*(),
+    the levels are then filled by setMipLevel() using glTexSubImage*(). Requires OpenGL 4.2 or GL_ARB_texture_storage, see Has_Texture_Storage.
+    Multisample textures, texture buffers, textures with a border and formats without a sized equivalent always use mutable storage. */
+    void setImmutableStorage(bool immutable) { mImmutableStorage = immutable; }
+    /** Whether createTexture() uses immutable storage, see setImmutableStorage(). */
+    bool immutableStorage() const { return mImmutableStorage; }
+
+    /** Returns \p true if the texture has been created with immutable storage, see setImmutableStorage(). */
+    bool isImmutable() const { return mImmutable; }
+
+    /** The number of mipmap levels allocated by immutable storage, 0 for mutable textures. */
+    int storageLevels() const { return mStorageLevels; }
+
     /** The texture type (1d, 2d, cubemap etc.) as specified by the \p target parameter of glTexImage*(). */
     void setDimension(ETextureDimension dimension) { mDimension = dimension; }
     /** The texture type (1d, 2d, cubemap etc.) as specified by the \p target parameter of glTexImage*(). */
@@ -749,11 +779,16 @@ namespace vl
     /** Returns \p true if the specified format is compressed. */
     static bool isCompressedFormat(int format);
 
+    //! Estimated number of bits per texel used by the given internal format, 32 if unknown. Used to compute estimatedMemoryUsage().
+    static int estimatedBitsPerTexel(ETextureFormat format);
+
   private:
     Texture(const Texture& other): Object(other) {}
     void operator=(const Texture&) {}
     // TexParameter is not reset but is marked dirty
     void reset();
+    // setMipLevel() for immutable storage, the texture is bound
+    bool setMipLevelImmutable(int mip_level, const Image* img, bool gen_mipmaps, int w, int h, int d, bool is_compressed);
 
   protected:
     unsigned int mHandle;
@@ -770,6 +805,11 @@ namespace vl
     int mSamples;
     bool mBorder;
     bool mFixedSamplesLocation;
+    long long mMemoryUsage;
+    bool mMemoryUsageMipmaps;
+    bool mImmutableStorage;
+    bool mImmutable;
+    int mStorageLevels;
   };
 }
 
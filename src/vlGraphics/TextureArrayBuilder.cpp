@@ -0,0 +1,194 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/TextureArrayBuilder.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlCore/Image.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <map>
+#include <set>
+
+using namespace vl;
+
+namespace
+{
+  // the textures that can share the same texture array
+  struct TextureArrayKey
+  {
+    int mWidth, mHeight;
+    int mImageFormat, mImageType;
+    int mTextureFormat;
+    bool mMipmaps;
+    int mMinFilter, mMagFilter, mWrapS, mWrapT;
+    float mAnisotropy;
+
+    bool operator<(const TextureArrayKey& other) const
+    {
+      if (mWidth != other.mWidth) return mWidth < other.mWidth;
+      if (mHeight != other.mHeight) return mHeight < other.mHeight;
+      if (mImageFormat != other.mImageFormat) return mImageFormat < other.mImageFormat;
+      if (mImageType != other.mImageType) return mImageType < other.mImageType;
+      if (mTextureFormat != other.mTextureFormat) return mTextureFormat < other.mTextureFormat;
+      if (mMipmaps != other.mMipmaps) return mMipmaps < other.mMipmaps;
+      if (mMinFilter != other.mMinFilter) return mMinFilter < other.mMinFilter;
+      if (mMagFilter != other.mMagFilter) return mMagFilter < other.mMagFilter;
+      if (mWrapS != other.mWrapS) return mWrapS < other.mWrapS;
+      if (mWrapT != other.mWrapT) return mWrapT < other.mWrapT;
+      return mAnisotropy < other.mAnisotropy;
+    }
+  };
+
+  struct TextureArrayGroup
+  {
+    std::vector<Texture*> mTextures;
+    std::map<Texture*, int> mLayers;
+    std::vector<Shader*> mShaders;
+  };
+}
+//-----------------------------------------------------------------------------
+int TextureArrayBuilder::build(ActorCollection* actors)
+{
+  std::set<Shader*> shader_set;
+  std::vector< ref<Shader> > shaders;
+  for(int i=0; i<actors->size(); ++i)
+  {
+    Effect* effect = actors->at(i)->effect();
+    if (!effect)
+      continue;
+    for(int lod=0; lod<VL_MAX_EFFECT_LOD; ++lod)
+    {
+      ShaderPasses* passes = effect->lod(lod).get();
+      for(int j=0; passes && j<passes->size(); ++j)
+      {
+        if ( shader_set.insert(passes->at(j)).second )
+          shaders.push_back(passes->at(j));
+      }
+    }
+  }
+  return build(shaders);
+}
+//-----------------------------------------------------------------------------
+int TextureArrayBuilder::build(std::vector< ref<Shader> >& shaders)
+{
+  mTextureArrays.clear();
+
+  // group the shaders by compatible texture
+  std::map<TextureArrayKey, TextureArrayGroup> groups;
+  for(size_t i=0; i<shaders.size(); ++i)
+  {
+    Shader* shader = shaders[i].get();
+    TextureSampler* sampler = shader->getTextureSampler(mTextureUnit);
+    Texture* tex = sampler ? sampler->texture() : NULL;
+    if ( !tex || !tex->setupParams() || tex->setupParams()->dimension() != TD_TEXTURE_2D )
+      continue;
+
+    Texture::SetupParams* params = tex->setupParams();
+    if ( !params->image() && !params->imagePath().empty() )
+      params->setImage( loadImage( params->imagePath() ).get() );
+    const Image* img = params->image();
+    if ( !img || img->dimension() != ID_2D || !img->pixels() )
+      continue;
+
+    const TexParameter* tp = tex->getTexParameter();
+    TextureArrayKey key;
+    key.mWidth  = img->width();
+    key.mHeight = img->height();
+    key.mImageFormat = img->format();
+    key.mImageType   = img->type();
+    key.mTextureFormat = params->format();
+    key.mMipmaps = params->genMipmaps();
+    key.mMinFilter = tp->minFilter();
+    key.mMagFilter = tp->magFilter();
+    key.mWrapS = tp->wrapS();
+    key.mWrapT = tp->wrapT();
+    key.mAnisotropy = tp->anisotropy();
+
+    TextureArrayGroup& group = groups[key];
+    if ( group.mLayers.find(tex) == group.mLayers.end() )
+    {
+      group.mLayers[tex] = (int)group.mTextures.size();
+      group.mTextures.push_back(tex);
+    }
+    group.mShaders.push_back(shader);
+  }
+
+  // create one texture array per group, splitting the groups exceeding maxLayers()
+  int remapped = 0;
+  for(std::map<TextureArrayKey, TextureArrayGroup>::iterator it = groups.begin(); it != groups.end(); ++it)
+  {
+    TextureArrayGroup& group = it->second;
+    if ( (int)group.mTextures.size() < mMinTextures )
+      continue;
+
+    std::vector< ref<Texture> > arrays;
+    for(size_t first=0; first<group.mTextures.size(); first+=mMaxLayers)
+    {
+      size_t last = first + mMaxLayers < group.mTextures.size() ? first + mMaxLayers : group.mTextures.size();
+      std::vector< ref<Image> > images;
+      for(size_t j=first; j<last; ++j)
+        images.push_back( const_cast<Image*>( group.mTextures[j]->setupParams()->image() ) );
+
+      ref<Image> layers = assemble3DImage(images);
+      if (!layers)
+      {
+        Log::error( Say("TextureArrayBuilder::build(): could not assemble %n images into a texture array.\n") << images.size() );
+        arrays.push_back(NULL);
+        continue;
+      }
+
+      const Texture::SetupParams* params = group.mTextures[first]->setupParams();
+      ref<Texture> tex_array = new Texture;
+      tex_array->prepareTexture2DArray( layers.get(), params->format(), params->genMipmaps() );
+      *tex_array->getTexParameter() = *group.mTextures[first]->getTexParameter();
+      tex_array->getTexParameter()->setDirty(true);
+      arrays.push_back(tex_array);
+      mTextureArrays.push_back(tex_array);
+    }
+
+    for(size_t j=0; j<group.mShaders.size(); ++j)
+    {
+      Shader* shader = group.mShaders[j];
+      TextureSampler* sampler = shader->getTextureSampler(mTextureUnit);
+      int layer = group.mLayers[sampler->texture()];
+      Texture* tex_array = arrays[layer / mMaxLayers].get();
+      if (!tex_array)
+        continue;
+      shader->gocUniform( mLayerUniformName.c_str() )->setUniformI( layer % mMaxLayers );
+      sampler->setTexture( tex_array );
+      ++remapped;
+    }
+  }
+
+  return remapped;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TextureArrayBuilder_INCLUDE_ONCE
+#define TextureArrayBuilder_INCLUDE_ONCE
+
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <string>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // TextureArrayBuilder
+  //------------------------------------------------------------------------------
+  /** Merges compatible 2D textures used by a set of Shader[s] into shared 2D array textures.
+    *
+    * For every Shader the builder inspects the Texture bound to textureUnit(). Textures created from an Image
+    * (see Texture::setupParams()) that share size, image format and type, texture format, mipmapping and filtering/wrapping
+    * parameters are packed into a single \p GL_TEXTURE_2D_ARRAY texture. Each Shader then binds the shared array texture and
+    * receives the index of its layer in the integer uniform layerUniformName() (default "vl_TextureLayer").
+    *
+    * After building, the Shader[s] of a group only differ by a uniform. OpenGLContext::applyRenderStates() then skips the
+    * texture bind, so the render queue can be sorted by GLSLProgram alone. The GLSL programs must sample the unit with a
+    * \p sampler2DArray, for example:
+    * \code
+    * uniform sampler2DArray tex;
+    * uniform int vl_TextureLayer;
+    * ...
+    * gl_FragColor = texture2DArray(tex, vec3(gl_TexCoord[0].st, float(vl_TextureLayer)));
+    * \endcode
+    * \sa Texture::prepareTexture2DArray(), vl::assemble3DImage() */
+  class VLGRAPHICS_EXPORT TextureArrayBuilder: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TextureArrayBuilder, Object)
+
+  public:
+    TextureArrayBuilder(): mLayerUniformName("vl_TextureLayer"), mTextureUnit(0), mMinTextures(2), mMaxLayers(256)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    /** Packs the compatible textures used by \p shaders, returns the number of Shader[s] remapped to a texture array. */
+    int build(std::vector< ref<Shader> >& shaders);
+
+    /** Packs the compatible textures used by all the Shader[s] of all the Effect LODs of the given actors. */
+    int build(ActorCollection* actors);
+
+    /** The texture arrays created by the last call to build(). */
+    const std::vector< ref<Texture> >& textureArrays() const { return mTextureArrays; }
+
+    /** The texture unit whose textures are packed (default = 0). */
+    void setTextureUnit(int unit) { mTextureUnit = unit; }
+
+    /** The texture unit whose textures are packed (default = 0). */
+    int textureUnit() const { return mTextureUnit; }
+
+    /** The name of the integer uniform set on each remapped Shader to the layer of its texture (default = "vl_TextureLayer"). */
+    void setLayerUniformName(const char* name) { mLayerUniformName = name; }
+
+    /** The name of the integer uniform set on each remapped Shader to the layer of its texture (default = "vl_TextureLayer"). */
+    const std::string& layerUniformName() const { return mLayerUniformName; }
+
+    /** Minimum number of distinct compatible textures required to create a texture array (default = 2). */
+    void setMinTextures(int count) { mMinTextures = count; }
+
+    /** Minimum number of distinct compatible textures required to create a texture array (default = 2). */
+    int minTextures() const { return mMinTextures; }
+
+    /** Maximum number of layers of a texture array, should not exceed GL_MAX_ARRAY_TEXTURE_LAYERS (default = 256). */
+    void setMaxLayers(int count) { mMaxLayers = count; }
+
+    /** Maximum number of layers of a texture array, should not exceed GL_MAX_ARRAY_TEXTURE_LAYERS (default = 256). */
+    int maxLayers() const { return mMaxLayers; }
+
+  protected:
+    std::vector< ref<Texture> > mTextureArrays;
+    std::string mLayerUniformName;
+    int mTextureUnit;
+    int mMinTextures;
+    int mMaxLayers;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,264 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/TextureStreamer.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// TextureStreamer
+//-----------------------------------------------------------------------------
+TextureStreamer::TextureStreamer()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mMutex = NULL;
+  mNextPBO = 0;
+  mUploadBudget = 4 * 1024 * 1024;
+  mDecodeOnUpdateCount = 1;
+  setPBOCount(4);
+
+  ref<Image> grey = new Image(1, 1, 0, 1, IF_RGBA, IT_UNSIGNED_BYTE);
+  memset(grey->pixels(), 128, grey->requiredMemory());
+  mPlaceholder = new Texture;
+  mPlaceholder->prepareTexture2D(grey.get(), TF_RGBA, false);
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::setPBOCount(int count)
+{
+  mPBOs.resize(count < 1 ? 1 : count);
+  for(size_t i=0; i<mPBOs.size(); ++i)
+    if (!mPBOs[i])
+      mPBOs[i] = new BufferObject;
+  mNextPBO = 0;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::request(TextureSampler* sampler)
+{
+  Texture* texture = sampler->texture();
+  if (!texture || texture == mPlaceholder.get())
+    return;
+
+  // already requested by another sampler
+  std::map<Texture*, ref<Request> >::iterator it = mRequests.find(texture);
+  if (it != mRequests.end())
+  {
+    it->second->mSamplers.push_back(sampler);
+    if (it->second->mNextLevel < 0 || it->second->mNextLevel == (int)it->second->mLevels.size() - 1)
+      sampler->setTexture(mPlaceholder.get());
+    return;
+  }
+
+  if (!texture->setupParams() || (!texture->setupParams()->image() && texture->setupParams()->imagePath().empty()))
+  {
+    Log::error("TextureStreamer::request(): the texture has no image to be loaded, call Texture::prepareTexture*() first.\n");
+    return;
+  }
+
+  ref<Request> req = new Request;
+  req->mTexture = texture;
+  req->mSamplers.push_back(sampler);
+  req->mImagePath = texture->setupParams()->imagePath();
+  req->mImage = const_cast<Image*>(texture->setupParams()->image());
+  req->mGenMipmaps = texture->setupParams()->genMipmaps();
+  mRequests[texture] = req;
+
+  sampler->setTexture(mPlaceholder.get());
+
+  ScopedMutex lock(mMutex);
+  if (req->mImage)
+    mDecoded.push_back(req);
+  else
+    mToDecode.push_back(req);
+}
+//-----------------------------------------------------------------------------
+int TextureStreamer::decode(int max_count)
+{
+  int count = 0;
+  for( ; count<max_count; ++count)
+  {
+    ref<Request> req;
+    {
+      ScopedMutex lock(mMutex);
+      if (mToDecode.empty())
+        break;
+      req = mToDecode.front();
+      mToDecode.pop_front();
+    }
+
+    // the decoding is done outside the lock, a NULL image is reported by update()
+    req->mImage = loadImage(req->mImagePath);
+    req->mDecoded = true;
+
+    ScopedMutex lock(mMutex);
+    mDecoded.push_back(req);
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::update()
+{
+  if (mDecodeOnUpdateCount > 0)
+    decode(mDecodeOnUpdateCount);
+
+  if (!mPlaceholder->handle() && mPlaceholder->setupParams())
+    mPlaceholder->createTexture();
+
+  {
+    ScopedMutex lock(mMutex);
+    mUploading.insert(mUploading.end(), mDecoded.begin(), mDecoded.end());
+    mDecoded.clear();
+  }
+
+  int budget = mUploadBudget;
+  bool uploaded = false;
+  while( !mUploading.empty() && (budget > 0 || !uploaded) )
+  {
+    Request* req = mUploading.front().get();
+
+    if (!req->mImage)
+    {
+      Log::error( Say("TextureStreamer: could not load image file '%s'.\n") << req->mImagePath );
+      // keep the placeholder bound
+      mRequests.erase(req->mTexture.get());
+      mUploading.pop_front();
+      continue;
+    }
+
+    if (req->mNextLevel < 0)
+    {
+      const Texture::SetupParams* params = req->mTexture->setupParams();
+      const Image* img = req->mImage.get();
+      ETextureFormat format = params->format() == TF_UNKNOWN ? (ETextureFormat)img->format() : params->format();
+      if ( !req->mTexture->createTexture(params->dimension(), format, img->width(), img->height(), img->depth(), params->border(), NULL, 0, false) )
+      {
+        Log::error( Say("TextureStreamer: could not create the texture for '%s'.\n") << req->mImagePath );
+        mRequests.erase(req->mTexture.get());
+        mUploading.pop_front();
+        continue;
+      }
+
+      // explicit mipmaps are uploaded progressively, from the smallest to the largest
+      req->mLevels.push_back(img);
+      if (req->mGenMipmaps)
+        for(size_t i=0; i<img->mipmaps().size(); ++i)
+          req->mLevels.push_back(img->mipmaps()[i].get());
+      req->mNextLevel = (int)req->mLevels.size() - 1;
+    }
+
+    const int level = req->mNextLevel;
+    if (!uploadLevel(req, level))
+    {
+      bindSamplers(req, req->mTexture.get());
+      mRequests.erase(req->mTexture.get());
+      mUploading.pop_front();
+      continue;
+    }
+    budget -= req->mLevels[level]->requiredMemory();
+    uploaded = true;
+
+    // the levels from mNextLevel to the smallest are available: the texture can replace the placeholder
+    if (req->mLevels.size() > 1)
+    {
+      glBindTexture( req->mTexture->dimension(), req->mTexture->handle() ); VL_CHECK_OGL()
+      glTexParameteri( req->mTexture->dimension(), GL_TEXTURE_BASE_LEVEL, level ); VL_CHECK_OGL()
+      glTexParameteri( req->mTexture->dimension(), GL_TEXTURE_MAX_LEVEL, (int)req->mLevels.size() - 1 ); VL_CHECK_OGL()
+      glBindTexture( req->mTexture->dimension(), 0 ); VL_CHECK_OGL()
+    }
+    if (level == (int)req->mLevels.size() - 1)
+      bindSamplers(req, req->mTexture.get());
+
+    req->mNextLevel--;
+    if (req->mNextLevel < 0)
+    {
+      finish(req);
+      mRequests.erase(req->mTexture.get());
+      mUploading.pop_front();
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+bool TextureStreamer::uploadLevel(Request* req, int level)
+{
+  Texture* tex = req->mTexture.get();
+  const Image* img = req->mLevels[level];
+  // mipmaps to be generated from the single level uploaded
+  const bool gen_mipmaps = req->mGenMipmaps && req->mLevels.size() == 1;
+
+  const bool use_pbo = Has_PBO && tex->dimension() == TD_TEXTURE_2D && !Texture::isCompressedFormat(img->format()) &&
+                       (!gen_mipmaps || Has_glGenerateMipmaps);
+  if (!use_pbo)
+    return tex->setMipLevel(level, img, gen_mipmaps);
+
+  // the driver copies the pixels from the buffer object asynchronously, the pool lets us write
+  // the next buffer object without waiting for the previous transfer to complete
+  BufferObject* pbo = mPBOs[mNextPBO].get();
+  mNextPBO = (mNextPBO + 1) % (int)mPBOs.size();
+  pbo->setBufferData( img->requiredMemory(), img->pixels(), BU_STREAM_DRAW );
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, img->byteAlignment() ); VL_CHECK_OGL()
+  glBindTexture( GL_TEXTURE_2D, tex->handle() ); VL_CHECK_OGL()
+  VL_glBindBuffer( GL_PIXEL_UNPACK_BUFFER, pbo->handle() ); VL_CHECK_OGL()
+  glTexImage2D( GL_TEXTURE_2D, level, tex->internalFormat(), img->width(), img->height(), tex->border()?1:0, img->format(), img->type(), 0 ); VL_CHECK_OGL()
+  VL_glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 ); VL_CHECK_OGL()
+  if (gen_mipmaps)
+  {
+    glGenerateMipmap( GL_TEXTURE_2D ); VL_CHECK_OGL()
+  }
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL()
+  return true;
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::bindSamplers(Request* req, Texture* texture)
+{
+  for(size_t i=0; i<req->mSamplers.size(); ++i)
+    req->mSamplers[i]->setTexture(texture);
+}
+//-----------------------------------------------------------------------------
+void TextureStreamer::finish(Request* req)
+{
+  // release the image like Texture::createTexture() does
+  Texture::SetupParams* params = req->mTexture->setupParams();
+  if (params)
+  {
+    if (req->mImage)
+      params->setImagePath( req->mImage->filePath() );
+    params->setImage(NULL);
+    params->setBufferObject(NULL);
+  }
+  req->mLevels.clear();
+  req->mImage = NULL;
+}
+//-----------------------------------------------------------------------------
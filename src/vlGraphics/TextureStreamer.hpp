@@ -0,0 +1,158 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TextureStreamer_INCLUDE_ONCE
+#define TextureStreamer_INCLUDE_ONCE
+
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/BufferObject.hpp>
+#include <vlCore/IMutex.hpp>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // TextureStreamer
+  //-----------------------------------------------------------------------------
+  /**
+   * Creates textures asynchronously: images are decoded by worker threads and uploaded over several frames.
+   *
+   * A texture is requested with request() passing the TextureSampler it is bound to. The texture must have been prepared
+   * with one of the Texture::prepareTexture*() functions. Until its upload is complete the TextureSampler is bound to a
+   * placeholder texture, see setPlaceholder().
+   *
+   * The images are decoded with loadImage() by decode(), which is meant to be called in a loop by one or more worker threads
+   * and is thread safe as long as a mutex has been installed with setMutex(). If no worker thread is used update() itself
+   * decodes decodeOnUpdateCount() images per frame.
+   *
+   * update() must be called once per frame with the OpenGL context current, this is automatically done by Rendering if the
+   * TextureStreamer is installed with Rendering::setTextureStreamer(), in which case the textures lazily created by the
+   * Rendering's automatic resource initialization are streamed as well.
+   * update() uploads the decoded images within uploadBudget() bytes per frame. Uncompressed 2D textures are uploaded through
+   * a pool of pixel-unpack BufferObject[s] so that the driver can copy them asynchronously. If the image has explicit mipmaps
+   * the mip levels are uploaded from the smallest to the largest, one or more per frame, and the texture replaces the
+   * placeholder as soon as the smallest level is available, its GL_TEXTURE_BASE_LEVEL being lowered as the larger levels arrive.
+   */
+  class VLGRAPHICS_EXPORT TextureStreamer: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TextureStreamer, Object)
+
+  protected:
+    //! \internal
+    class Request: public Object
+    {
+    public:
+      Request(): mNextLevel(-1), mGenMipmaps(false), mDecoded(false) {}
+
+      ref<Texture> mTexture;
+      std::vector< ref<TextureSampler> > mSamplers;
+      String mImagePath;
+      ref<Image> mImage;
+      std::vector<const Image*> mLevels;
+      int mNextLevel; // -1 until the texture has been created
+      bool mGenMipmaps;
+      bool mDecoded;
+    };
+
+  public:
+    TextureStreamer();
+
+    /** Requests the asynchronous creation of the texture bound to the given TextureSampler, which is bound to the placeholder
+     * texture until the texture is ready. The texture must have SetupParams with either an image or an image path.
+     * Several TextureSampler[s] can request the same texture. Must be called by the thread owning the OpenGL context. */
+    void request(TextureSampler* sampler);
+
+    /** Decodes up to \p max_count requested images. Thread safe if a mutex has been installed with setMutex().
+     * Returns the number of decoded images. */
+    int decode(int max_count=1);
+
+    /** Uploads the decoded images within the uploadBudget(), must be called once per frame with the OpenGL context current. */
+    void update();
+
+    //! Returns the number of textures requested whose upload has not been completed yet.
+    int pendingCount() const { return (int)mRequests.size(); }
+
+    //! The mutex protecting the queues shared with the decoding threads, required if decode() is called by worker threads. See also vl::IMutex.
+    void setMutex(IMutex* mutex) { mMutex = mutex; }
+
+    //! The mutex protecting the queues shared with the decoding threads, required if decode() is called by worker threads. See also vl::IMutex.
+    IMutex* mutex() { return mMutex; }
+
+    //! The texture bound while the requested texture is not ready. Defaults to a 1x1 grey texture.
+    void setPlaceholder(Texture* texture) { mPlaceholder = texture; }
+
+    //! The texture bound while the requested texture is not ready. Defaults to a 1x1 grey texture.
+    Texture* placeholder() { return mPlaceholder.get(); }
+
+    //! The maximum number of bytes uploaded by update(), at least one mip level is uploaded per frame if any is ready. Defaults to 4MB.
+    void setUploadBudget(int bytes) { mUploadBudget = bytes; }
+
+    //! The maximum number of bytes uploaded by update(), at least one mip level is uploaded per frame if any is ready. Defaults to 4MB.
+    int uploadBudget() const { return mUploadBudget; }
+
+    //! The number of images decoded by update() itself, set it to 0 if decode() is called by worker threads. Defaults to 1.
+    void setDecodeOnUpdateCount(int count) { mDecodeOnUpdateCount = count; }
+
+    //! The number of images decoded by update() itself, set it to 0 if decode() is called by worker threads. Defaults to 1.
+    int decodeOnUpdateCount() const { return mDecodeOnUpdateCount; }
+
+    //! The number of pixel-unpack BufferObject[s] used in round robin for the uploads. Defaults to 4.
+    void setPBOCount(int count);
+
+    //! The number of pixel-unpack BufferObject[s] used in round robin for the uploads. Defaults to 4.
+    int pboCount() const { return (int)mPBOs.size(); }
+
+  protected:
+    bool uploadLevel(Request* req, int level);
+    void bindSamplers(Request* req, Texture* texture);
+    void finish(Request* req);
+
+  protected:
+    ref<Texture> mPlaceholder;
+    // GL thread only
+    std::map<Texture*, ref<Request> > mRequests;
+    std::deque< ref<Request> > mUploading;
+    std::vector< ref<BufferObject> > mPBOs;
+    int mNextPBO;
+    // shared with the decoding threads, protected by mMutex
+    std::deque< ref<Request> > mToDecode;
+    std::deque< ref<Request> > mDecoded;
+    IMutex* mMutex;
+    int mUploadBudget;
+    int mDecodeOnUpdateCount;
+  };
+}
+
+#endif
@@ -0,0 +1,296 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/TileRenderer.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cstring>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// TileRenderer
+//-----------------------------------------------------------------------------
+TileRenderer::TileRenderer()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mTargetWidth  = 0;
+  mTargetHeight = 0;
+  mTileWidth  = 1024;
+  mTileHeight = 1024;
+  mReadbackDepth = 3;
+  mStatsTiles = 0;
+  mWriter = NULL;
+  mFirstFrame = 0;
+  mImageWidth = 0;
+  mStripRow = -1;
+  mStripHeight = 0;
+  mWriteFailed = false;
+}
+//-----------------------------------------------------------------------------
+TileRenderer::~TileRenderer()
+{
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+void TileRenderer::setTileSize(int width, int height)
+{
+  mTileWidth  = width  < 1 ? 1 : width;
+  mTileHeight = height < 1 ? 1 : height;
+}
+//-----------------------------------------------------------------------------
+bool TileRenderer::prepareTargets(OpenGLContext* ctx)
+{
+  if ( mFramebuffer && mPool && mPool->openglContext() == ctx && mTargetWidth == mTileWidth && mTargetHeight == mTileHeight )
+    return true;
+
+  releaseTargets();
+
+  mPool = ctx->renderTargetPool();
+  mFramebuffer = mPool->acquireFramebuffer( mTileWidth, mTileHeight );
+  mColorBuffer = mPool->acquireColorBuffer( mTileWidth, mTileHeight, CBF_RGBA8 );
+  mDepthBuffer = mPool->acquireDepthStencilBuffer( mTileWidth, mTileHeight, DSBT_DEPTH24_STENCIL8 );
+  if ( !mFramebuffer || !mColorBuffer || !mDepthBuffer )
+  {
+    releaseTargets();
+    return false;
+  }
+  mTargetWidth  = mTileWidth;
+  mTargetHeight = mTileHeight;
+
+  mFramebuffer->setDrawBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->setReadBuffer( RDB_COLOR_ATTACHMENT0 );
+  mFramebuffer->addColorAttachment( AP_COLOR_ATTACHMENT0, mColorBuffer.get() );
+  mFramebuffer->addDepthStencilAttachment( mDepthBuffer.get() );
+  return true;
+}
+//-----------------------------------------------------------------------------
+void TileRenderer::releaseTargets()
+{
+  // the targets are gone if the pool has been cleared together with its OpenGLContext
+  if ( mPool )
+  {
+    if ( mFramebuffer && mPool->isAcquired( mFramebuffer.get() ) )
+      mPool->release( mFramebuffer.get() );
+    if ( mColorBuffer && mPool->isAcquired( mColorBuffer.get() ) )
+      mPool->release( mColorBuffer.get() );
+    if ( mDepthBuffer && mPool->isAcquired( mDepthBuffer.get() ) )
+      mPool->release( mDepthBuffer.get() );
+  }
+  mFramebuffer = NULL;
+  mColorBuffer = NULL;
+  mDepthBuffer = NULL;
+  mPool = NULL;
+  mTargetWidth  = 0;
+  mTargetHeight = 0;
+}
+//-----------------------------------------------------------------------------
+void TileRenderer::releaseOpenGLResources()
+{
+  releaseTargets();
+  if ( mReader )
+  {
+    mReader->releaseBuffers();
+    mReader = NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+bool TileRenderer::render(Rendering* rendering, int width, int height, const String& path)
+{
+  ref<ImageRowWriter> writer = createImageRowWriter( path );
+  if ( !writer )
+    return false;
+  ref<VirtualFile> file = new DiskFile( path );
+  return render( rendering, width, height, writer.get(), file.get() );
+}
+//-----------------------------------------------------------------------------
+bool TileRenderer::render(Rendering* rendering, int width, int height, ImageRowWriter* writer, VirtualFile* file)
+{
+  mStatsTiles = 0;
+
+  if ( !rendering || !rendering->camera() || !rendering->camera()->viewport() || rendering->renderers().empty() || !writer || width <= 0 || height <= 0 )
+    return false;
+
+  if ( !Has_FBO )
+  {
+    Log::error("TileRenderer::render(): framebuffer objects not supported.\n");
+    return false;
+  }
+
+  OpenGLContext* ctx = rendering->renderers()[0]->framebuffer()->openglContext();
+  if ( !prepareTargets( ctx ) )
+  {
+    Log::error("TileRenderer::render(): could not create the offscreen framebuffer.\n");
+    return false;
+  }
+
+  if ( !writer->open( file, width, height ) )
+    return false;
+
+  if ( !mReader )
+  {
+    mReader = new AsyncReadPixels;
+    mReader->setCallback( new TileReadback(this) );
+  }
+  if ( mReader->ringSize() != mReadbackDepth )
+    mReader->setRingSize( mReadbackDepth );
+  mReader->setFormat( IF_RGBA, IT_UNSIGNED_BYTE );
+
+  // tiles from the top row to the bottom one, OpenGL rows go upwards
+  const int cols = (width  + mTileWidth  - 1) / mTileWidth;
+  const int rows = (height + mTileHeight - 1) / mTileHeight;
+  mTiles.clear();
+  mTiles.reserve( cols * rows );
+  for( int r=0; r<rows; ++r )
+  {
+    const int top    = height - r * mTileHeight;
+    const int bottom = top - mTileHeight > 0 ? top - mTileHeight : 0;
+    for( int c=0; c<cols; ++c )
+    {
+      Tile tile;
+      tile.mX = c * mTileWidth;
+      tile.mY = bottom;
+      tile.mWidth  = width - tile.mX < mTileWidth ? width - tile.mX : mTileWidth;
+      tile.mHeight = top - bottom;
+      tile.mRow = r;
+      mTiles.push_back( tile );
+    }
+  }
+
+  mWriter = writer;
+  mFirstFrame = mReader->readsIssued();
+  mImageWidth = width;
+  mStripRow = -1;
+  mStripHeight = 0;
+  mWriteFailed = false;
+  mStrip.resize( (size_t)width * mTileHeight * 4 );
+
+  // save the state changed by the snapshot
+  Camera* camera = rendering->camera();
+  Viewport* viewport = camera->viewport();
+  const mat4 projection = camera->projectionMatrix();
+  const EProjectionMatrixType projection_type = camera->projectionMatrixType();
+  const int viewport_x = viewport->x();
+  const int viewport_y = viewport->y();
+  const int viewport_w = viewport->width();
+  const int viewport_h = viewport->height();
+  const bool near_far_optimized = rendering->nearFarClippingPlanesOptimized();
+  DynamicResolution* dynamic_resolution = rendering->dynamicResolution();
+  const bool dynamic_resolution_enabled = dynamic_resolution && dynamic_resolution->isEnabled();
+  std::vector< ref<Framebuffer> > framebuffers( rendering->renderers().size() );
+  for( int i=0; i<rendering->renderers().size(); ++i )
+  {
+    Renderer* renderer = rendering->renderers()[i].get();
+    if ( renderer )
+    {
+      framebuffers[i] = renderer->framebuffer();
+      renderer->setFramebuffer( mFramebuffer.get() );
+    }
+  }
+  rendering->setNearFarClippingPlanesOptimized( false );
+  if ( dynamic_resolution )
+    dynamic_resolution->setEnabled( false );
+
+  for( size_t i=0; i<mTiles.size() && !mWriteFailed; ++i )
+  {
+    const Tile& tile = mTiles[i];
+
+    // maps the tile's NDC rectangle to [-1,+1]: the sub-frustum of the tile
+    const real sx = (real)width  / tile.mWidth;
+    const real sy = (real)height / tile.mHeight;
+    const real tx = (real)( width  - 2 * tile.mX - tile.mWidth  ) / tile.mWidth;
+    const real ty = (real)( height - 2 * tile.mY - tile.mHeight ) / tile.mHeight;
+    camera->setProjectionMatrix( mat4::getTranslation( tx, ty, 0 ) * mat4::getScaling( sx, sy, 1 ) * projection, projection_type );
+    viewport->set( 0, 0, tile.mWidth, tile.mHeight );
+
+    rendering->render();
+
+    mFramebuffer->bindFramebuffer( FBB_READ_FRAMEBUFFER );
+    mReader->setup( 0, 0, tile.mWidth, tile.mHeight, RDB_COLOR_ATTACHMENT0 );
+    mReader->readPixels();
+    ++mStatsTiles;
+  }
+  mReader->flush();
+  if ( mStripRow >= 0 && !mWriteFailed )
+    writeStrip();
+
+  // restore
+  camera->setProjectionMatrix( projection, projection_type );
+  viewport->set( viewport_x, viewport_y, viewport_w, viewport_h );
+  rendering->setNearFarClippingPlanesOptimized( near_far_optimized );
+  if ( dynamic_resolution )
+    dynamic_resolution->setEnabled( dynamic_resolution_enabled );
+  for( int i=0; i<rendering->renderers().size(); ++i )
+    if ( rendering->renderers()[i] )
+      rendering->renderers()[i]->setFramebuffer( framebuffers[i].get() );
+  ctx->framebuffer()->activate();
+
+  mWriter = NULL;
+  mTiles.clear();
+  std::vector<unsigned char>().swap( mStrip );
+
+  bool ok = writer->close() && !mWriteFailed;
+  if ( !ok )
+    Log::error( Say("TileRenderer::render(): could not write the %nx%n snapshot.\n") << width << height );
+  return ok;
+}
+//-----------------------------------------------------------------------------
+void TileRenderer::copyTile(const Image* image, unsigned long frame)
+{
+  if ( !mWriter || mWriteFailed || frame < mFirstFrame || frame - mFirstFrame >= mTiles.size() )
+    return;
+
+  // the readbacks are delivered in order: a tile of a new row completes the previous row
+  const Tile& tile = mTiles[ frame - mFirstFrame ];
+  if ( tile.mRow != mStripRow )
+  {
+    if ( mStripRow >= 0 )
+      writeStrip();
+    mStripRow = tile.mRow;
+    mStripHeight = tile.mHeight;
+  }
+
+  const size_t row_bytes = (size_t)tile.mWidth * 4;
+  for( int y=0; y<tile.mHeight; ++y )
+    memcpy( &mStrip[ ( (size_t)y * mImageWidth + tile.mX ) * 4 ], image->pixels() + (size_t)image->pitch() * y, row_bytes );
+}
+//-----------------------------------------------------------------------------
+void TileRenderer::writeStrip()
+{
+  // the strip rows go upwards, the file rows downwards
+  const int pitch = mImageWidth * 4;
+  for( int y=mStripHeight; y-- && !mWriteFailed; )
+    mWriteFailed = !mWriter->writeRows( &mStrip[ (size_t)pitch * y ], 1, pitch );
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,142 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TileRenderer_INCLUDE_ONCE
+#define TileRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/AsyncReadPixels.hpp>
+#include <vlGraphics/RenderTargetPool.hpp>
+#include <vlCore/ImageRowWriter.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // TileRenderer
+  //------------------------------------------------------------------------------
+  /** Renders snapshots of a Rendering far bigger than the framebuffer, or than the GPU memory, one tile at a time.
+    *
+    * The image is divided in tiles of tileWidth() x tileHeight() pixels. For each tile the projection matrix of the camera
+    * is restricted to the sub-frustum covering the tile, which works for perspective, orthographic and off-axis projections
+    * alike, and the scene is rendered into an offscreen FramebufferObject taken once from the OpenGLContext::renderTargetPool().
+    * The tile is read back with an AsyncReadPixels so that the readback of a tile overlaps the rendering of the next ones.
+    *
+    * The tiles are rendered from the top row to the bottom one and each completed row of tiles is streamed to an ImageRowWriter,
+    * so that only one row of tiles (width x tileHeight() pixels) is kept in memory whatever the size of the image.
+    *
+    * \code
+    * ref<TileRenderer> tiles = new TileRenderer;
+    * tiles->render( rendering.get(), 16384, 16384, "snapshot.png" );
+    * \endcode
+    *
+    * During the snapshot the near/far clipping planes optimization and the DynamicResolution of the Rendering are disabled, and
+    * the camera projection and Viewport, and the Framebuffer of the Renderer[s], are restored afterwards. The OpenGLContext of the
+    * first Renderer must be current. Screen space effects (pixel based LOD, post-processing) see the tile instead of the whole image.
+    * \sa ImageRowWriter, AsyncReadPixels, RenderTargetPool */
+  class VLGRAPHICS_EXPORT TileRenderer: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TileRenderer, Object)
+
+  public:
+    TileRenderer();
+    ~TileRenderer();
+
+    //! The maximum size of a tile, 1024 x 1024 by default. The tiles on the right and bottom border can be smaller.
+    void setTileSize(int width, int height);
+    int tileWidth() const { return mTileWidth; }
+    int tileHeight() const { return mTileHeight; }
+
+    //! The number of tile readbacks in flight, 3 by default.
+    void setReadbackDepth(int depth) { mReadbackDepth = depth < 1 ? 1 : depth; }
+    int readbackDepth() const { return mReadbackDepth; }
+
+    //! Renders a \p width x \p height snapshot of \p rendering streaming it into \p file through \p writer.
+    bool render(Rendering* rendering, int width, int height, ImageRowWriter* writer, VirtualFile* file);
+
+    //! Renders a \p width x \p height snapshot of \p rendering into a PNG or TIFF file, see createImageRowWriter().
+    bool render(Rendering* rendering, int width, int height, const String& path);
+
+    //! Number of tiles rendered by the last snapshot.
+    int statsTiles() const { return mStatsTiles; }
+
+    //! Gives back the offscreen targets to the RenderTargetPool and releases the readback buffers. Requires the OpenGL context to be current.
+    void releaseOpenGLResources();
+
+  protected:
+    struct Tile
+    {
+      int mX;
+      int mY;
+      int mWidth;
+      int mHeight;
+      int mRow;
+    };
+
+    class TileReadback: public ReadbackCallback
+    {
+    public:
+      TileReadback(TileRenderer* owner): mOwner(owner) {}
+      void onPixelsRead(AsyncReadPixels*, Image* image, unsigned long frame) { mOwner->copyTile(image, frame); }
+      TileRenderer* mOwner;
+    };
+
+    bool prepareTargets(OpenGLContext* ctx);
+    void releaseTargets();
+    void copyTile(const Image* image, unsigned long frame);
+    void writeStrip();
+
+  protected:
+    ref<RenderTargetPool> mPool;
+    ref<FramebufferObject> mFramebuffer;
+    ref<FBOColorBufferAttachment> mColorBuffer;
+    ref<FBODepthStencilBufferAttachment> mDepthBuffer;
+    ref<AsyncReadPixels> mReader;
+    int mTargetWidth;
+    int mTargetHeight;
+    int mTileWidth;
+    int mTileHeight;
+    int mReadbackDepth;
+    int mStatsTiles;
+    // snapshot in progress
+    ImageRowWriter* mWriter;
+    std::vector<Tile> mTiles;
+    std::vector<unsigned char> mStrip;
+    unsigned long mFirstFrame;
+    int mImageWidth;
+    int mStripRow;
+    int mStripHeight;
+    bool mWriteFailed;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
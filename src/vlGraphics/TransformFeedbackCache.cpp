@@ -0,0 +1,334 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/TransformFeedbackCache.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// TransformFeedbackCache
+//-----------------------------------------------------------------------------
+TransformFeedbackCache::TransformFeedbackCache(Geometry* source)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mSource = source;
+  mCaptureShader = new Shader;
+  mCache = new Geometry;
+  mCacheDraw = new DrawArrays(PT_TRIANGLES, 0, 0);
+  mCache->drawCalls().push_back( mCacheDraw.get() );
+  mCapturePrimitive = PT_UNKNOWN;
+  mCapacity = 0;
+  mCapturedVertexCount = 0;
+  mCaptureCount = 0;
+  mSourceTick = 0;
+  mQuery = 0;
+  mCacheDirty = true;
+}
+//-----------------------------------------------------------------------------
+TransformFeedbackCache::~TransformFeedbackCache()
+{
+  deleteBufferObject();
+}
+//-----------------------------------------------------------------------------
+void TransformFeedbackCache::addOutput(const char* varying, int attrib_location, int components)
+{
+  VL_CHECK( attrib_location >= 0 && attrib_location < VA_MaxAttribCount )
+  VL_CHECK( components >= 1 && components <= 4 )
+  mOutputs.push_back( Output(varying, attrib_location, components) );
+  setCacheDirty();
+}
+//-----------------------------------------------------------------------------
+void TransformFeedbackCache::deleteBufferObject()
+{
+  mCache->deleteBufferObject();
+#if defined(VL_OPENGL)
+  if ( mQuery )
+    glDeleteQueries( 1, &mQuery );
+#endif
+  mQuery = 0;
+  mCapturedVertexCount = 0;
+  setCacheDirty();
+}
+//-----------------------------------------------------------------------------
+void TransformFeedbackCache::computeBounds_Implementation()
+{
+  if ( mSource )
+  {
+    setBoundingBox( mSource->boundingBox() );
+    setBoundingSphere( mSource->boundingSphere() );
+  }
+  else
+  {
+    setBoundingBox( AABB() );
+    setBoundingSphere( Sphere() );
+  }
+}
+//-----------------------------------------------------------------------------
+long long TransformFeedbackCache::sourceTick() const
+{
+  long long tick = 0;
+  for( int i=0; i<VA_MaxAttribCount; ++i )
+  {
+    const ArrayAbstract* arr = mSource->vertexAttribArray(i);
+    if ( arr )
+      tick += arr->bufferObjectDirtyTick() + 1;
+  }
+  return tick;
+}
+//-----------------------------------------------------------------------------
+bool TransformFeedbackCache::isSourceChanged() const
+{
+  return mSource && ( mSource->isBufferObjectDirty() || sourceTick() != mSourceTick );
+}
+//-----------------------------------------------------------------------------
+namespace
+{
+  // the primitive type transform feedback records for the given draw call primitive
+  EPrimitiveType capturedPrimitive(EPrimitiveType type)
+  {
+    switch( type )
+    {
+    case PT_POINTS:         return PT_POINTS;
+    case PT_LINES:
+    case PT_LINE_STRIP:
+    case PT_LINE_LOOP:      return PT_LINES;
+    case PT_TRIANGLES:
+    case PT_TRIANGLE_STRIP:
+    case PT_TRIANGLE_FAN:   return PT_TRIANGLES;
+    default:                return PT_UNKNOWN;
+    }
+  }
+
+  // the number of vertices recorded for n indices of the given primitive
+  int capturedVertices(EPrimitiveType type, int n)
+  {
+    switch( type )
+    {
+    case PT_LINE_STRIP:     return n > 1 ? (n - 1) * 2 : 0;
+    case PT_LINE_LOOP:      return n > 1 ? n * 2 : 0;
+    case PT_TRIANGLE_STRIP:
+    case PT_TRIANGLE_FAN:   return n > 2 ? (n - 2) * 3 : 0;
+    default:                return n;
+    }
+  }
+
+  int verticesPerPrimitive(EPrimitiveType type)
+  {
+    return type == PT_TRIANGLES ? 3 : ( type == PT_LINES ? 2 : 1 );
+  }
+}
+//-----------------------------------------------------------------------------
+EPrimitiveType TransformFeedbackCache::capturePrimitiveType() const
+{
+  if ( mCapturePrimitive != PT_UNKNOWN )
+    return mCapturePrimitive;
+
+  EPrimitiveType type = PT_UNKNOWN;
+  for( int i=0; i<mSource->drawCalls().size(); ++i )
+  {
+    const DrawCall* dc = mSource->drawCalls().at(i);
+    if ( !dc->isEnabled() )
+      continue;
+    EPrimitiveType dc_type = capturedPrimitive( dc->primitiveType() );
+    if ( dc_type == PT_UNKNOWN || ( type != PT_UNKNOWN && dc_type != type ) )
+      return PT_UNKNOWN;
+    type = dc_type;
+  }
+  return type;
+}
+//-----------------------------------------------------------------------------
+int TransformFeedbackCache::capturedVertexCapacity(EPrimitiveType capture_type) const
+{
+  if ( mCapacity )
+    return mCapacity;
+
+  int count = 0;
+  for( int i=0; i<mSource->drawCalls().size(); ++i )
+  {
+    const DrawCall* dc = mSource->drawCalls().at(i);
+    if ( dc->isEnabled() )
+      count += capturedVertices( dc->primitiveType(), (int)dc->countIndices() ) * dc->instances();
+  }
+  // whole primitives only
+  return count - count % verticesPerPrimitive( capture_type );
+}
+//-----------------------------------------------------------------------------
+bool TransformFeedbackCache::capture(OpenGLContext* gl_context)
+{
+  VL_CHECK_OGL()
+
+  // don't retry a failed capture every frame
+  mCacheDirty = false;
+  mCapturedVertexCount = 0;
+  mCacheDraw->setCount( 0 );
+
+  GLSLProgram* glsl = mCaptureShader ? mCaptureShader->glslProgram() : NULL;
+  if ( !gl_context || !mSource || !glsl || !glsl->shaderCount() || mOutputs.empty() )
+    return false;
+
+  mSourceTick = sourceTick();
+
+#if defined(VL_OPENGL)
+  if ( !Has_Transform_Feedback || !glBeginTransformFeedback )
+  {
+    Log::error("TransformFeedbackCache::capture(): transform feedback not supported.\n");
+    return false;
+  }
+
+  EPrimitiveType type = capturePrimitiveType();
+  if ( type != PT_POINTS && type != PT_LINES && type != PT_TRIANGLES )
+  {
+    Log::error("TransformFeedbackCache::capture(): the source mixes primitive types or uses primitives that cannot be captured, see setCapturePrimitive().\n");
+    return false;
+  }
+
+  // the program is relinked when the varyings change
+  std::vector<std::string> varyings;
+  for( size_t i=0; i<mOutputs.size(); ++i )
+    varyings.push_back( mOutputs[i].mVarying );
+  if ( glsl->transformFeedbackVaryings() != varyings || glsl->transformFeedbackInterleaved() )
+    glsl->setTransformFeedbackVaryings( varyings, false );
+
+  // false also while a parallel link is pending, retried at the next rendering
+  if ( !glsl->linkProgram() )
+  {
+    mCacheDirty = glsl->linkPending();
+    return false;
+  }
+
+  // one buffer per output, reallocated only when the capacity changes
+  const int capacity = capturedVertexCapacity( type );
+  for( int loc=0; loc<VA_MaxAttribCount; ++loc )
+    mCache->setVertexAttribArray( loc, NULL );
+  while( mCacheArrays.size() < mOutputs.size() )
+    mCacheArrays.push_back( NULL );
+  for( size_t i=0; i<mOutputs.size(); ++i )
+  {
+    ref<ArrayAbstract>& arr = mCacheArrays[i];
+    if ( !arr || (int)arr->glSize() != mOutputs[i].mComponents )
+    {
+      switch( mOutputs[i].mComponents )
+      {
+      case 1:  arr = new ArrayFloat1; break;
+      case 2:  arr = new ArrayFloat2; break;
+      case 3:  arr = new ArrayFloat3; break;
+      default: arr = new ArrayFloat4; break;
+      }
+    }
+    GLsizeiptr bytes = (GLsizeiptr)capacity * arr->glSize() * sizeof(GLfloat);
+    if ( !arr->bufferObject()->handle() || arr->bufferObject()->byteCountBufferObject() != bytes )
+      arr->bufferObject()->setBufferData( bytes, NULL, BU_STATIC_COPY );
+    arr->setBufferObjectDirty( false );
+    mCache->setVertexAttribArray( mOutputs[i].mAttribLocation, arr.get() );
+  }
+  mCache->setBufferObjectDirty( false );
+
+  if ( capacity == 0 )
+    return true;
+
+  // capture program and its uniforms
+  gl_context->applyRenderStates( mCaptureShader->getRenderStateSet(), NULL ); VL_CHECK_OGL()
+  glsl->applyUniformSet( glsl->getUniformSet() );
+  if ( mCaptureShader->getUniformSet() )
+    glsl->applyUniformSet( mCaptureShader->getUniformSet() );
+
+  for( size_t i=0; i<mOutputs.size(); ++i )
+  {
+    glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, (GLuint)i, mCacheArrays[i]->bufferObject()->handle() ); VL_CHECK_OGL()
+  }
+
+  if ( !mQuery )
+  {
+    glGenQueries( 1, &mQuery ); VL_CHECK_OGL()
+  }
+
+  glEnable( GL_RASTERIZER_DISCARD );
+  glBeginQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, mQuery ); VL_CHECK_OGL()
+  glBeginTransformFeedback( type ); VL_CHECK_OGL()
+  mSource->render( NULL, mCaptureShader.get(), NULL, gl_context );
+  glEndTransformFeedback(); VL_CHECK_OGL()
+  glEndQuery( GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN ); VL_CHECK_OGL()
+  glDisable( GL_RASTERIZER_DISCARD );
+
+  for( size_t i=0; i<mOutputs.size(); ++i )
+  {
+    glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, (GLuint)i, 0 ); VL_CHECK_OGL()
+  }
+
+  // back to the default states, as expected by the Renderer[s]
+  gl_context->applyRenderStates( NULL, NULL ); VL_CHECK_OGL()
+
+  // waits for the capture to complete: acceptable since the capture is rare and the cache is drawn right after
+  GLuint primitives = 0;
+  glGetQueryObjectuiv( mQuery, GL_QUERY_RESULT, &primitives ); VL_CHECK_OGL()
+
+  mCapturedVertexCount = (int)primitives * verticesPerPrimitive( type );
+  if ( mCapturedVertexCount > capacity )
+  {
+    Log::warning( Say("TransformFeedbackCache::capture(): %n vertices generated but only %n captured, see setCapacity().\n") << mCapturedVertexCount << capacity );
+    mCapturedVertexCount = capacity;
+  }
+  mCacheDraw->setPrimitiveType( type );
+  mCacheDraw->setCount( mCapturedVertexCount );
+  ++mCaptureCount;
+
+  return true;
+#else
+  Log::error("TransformFeedbackCache::capture(): transform feedback not supported.\n");
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+void TransformFeedbackCache::render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const
+{
+  VL_CHECK_OGL()
+
+  // the cache is filled lazily by the first pass drawing it
+  TransformFeedbackCache* self = const_cast<TransformFeedbackCache*>(this);
+
+  if ( mCacheDirty || isSourceChanged() )
+  {
+    self->capture( gl_context );
+    // restore the states of the Shader being rendered, its uniforms are stored in its GLSLProgram and are still valid
+    gl_context->applyRenderStates( shader ? shader->getRenderStateSet() : NULL, camera ); VL_CHECK_OGL()
+  }
+
+  if ( mCapturedVertexCount )
+    self->mCache->render( actor, shader, camera, gl_context );
+
+  VL_CHECK_OGL()
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,169 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TransformFeedbackCache_INCLUDE_ONCE
+#define TransformFeedbackCache_INCLUDE_ONCE
+
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/Shader.hpp>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // TransformFeedbackCache
+  //-----------------------------------------------------------------------------
+  /**
+   * A Renderable that runs the expensive vertex processing of a source Geometry once, captures its results with transform feedback
+   * and then draws the captured vertices until the cache is invalidated.
+   *
+   * The capture runs the source() Geometry through the GLSLProgram of captureShader() with the rasterizer disabled and stores the
+   * varyings declared with addOutput() into one BufferObject each. The cached vertices are drawn by cache(), a non-indexed Geometry
+   * whose vertex attributes are bound to the locations given to addOutput(), so the Shader of the Actor only needs a cheap pass-through
+   * vertex shader. Every pass rendering the Actor (shadow maps, picking, main view) reuses the same capture.
+   *
+   * The capture shader should output view independent data (typically object space positions and normals): the cache is shared by all
+   * the cameras. The cache is recaptured when setCacheDirty() is called, when the BufferObject of one of the arrays of the source is
+   * marked dirty (for example by a MorphingCallback or after editing the arrays) or when the source Geometry is changed.
+   * Changes to the uniforms of the capture shader, like the height scale of a GLSL Terrain, require an explicit setCacheDirty().
+   *
+   * \code
+   * ref<TransformFeedbackCache> cache = new TransformFeedbackCache( terrain_geometry.get() );
+   * cache->captureShader()->gocGLSLProgram()->attachShader( new GLSLVertexShader("/glsl/displace.vs") );
+   * cache->addOutput( "out_position", VA_Position, 3 );
+   * cache->addOutput( "out_normal",   VA_Normal,   3 );
+   * scene_manager->tree()->addActor( cache.get(), effect.get() );
+   * \endcode
+   *
+   * The captured vertices are not indexed: triangle strips and fans are expanded into triangles and shared vertices are duplicated.
+   * The bounds are copied from the source unless set explicitly. Requires OpenGL 3.0, see Has_Transform_Feedback.
+   *
+   * \sa GLSLProgram::setTransformFeedbackVaryings(), MorphingCallback, DispatchCompute
+   */
+  class VLGRAPHICS_EXPORT TransformFeedbackCache: public Renderable
+  {
+    VL_INSTRUMENT_CLASS(vl::TransformFeedbackCache, Renderable)
+
+  public:
+    //! A varying captured into the cache and the vertex attribute it is drawn from.
+    struct Output
+    {
+      Output(): mAttribLocation(0), mComponents(0) {}
+      Output(const char* varying, int attrib_location, int components): mVarying(varying), mAttribLocation(attrib_location), mComponents(components) {}
+
+      std::string mVarying;
+      int mAttribLocation;
+      int mComponents;
+    };
+
+  public:
+    TransformFeedbackCache(Geometry* source=NULL);
+
+    ~TransformFeedbackCache();
+
+    //! The Geometry whose processed vertices are cached.
+    void setSource(Geometry* source) { mSource = source; setCacheDirty(); setBoundsDirty(true); }
+    Geometry* source() { return mSource.get(); }
+    const Geometry* source() const { return mSource.get(); }
+
+    //! The Shader whose GLSLProgram processes the source vertices during the capture. Its render states are applied, its enables are not.
+    void setCaptureShader(Shader* shader) { mCaptureShader = shader; setCacheDirty(); }
+    Shader* captureShader() { return mCaptureShader.get(); }
+    const Shader* captureShader() const { return mCaptureShader.get(); }
+
+    //! Captures the float varying \p varying with \p components components and draws it as the vertex attribute \p attrib_location.
+    //! The varyings are captured separately, OpenGL guarantees at least 4 of them.
+    void addOutput(const char* varying, int attrib_location, int components);
+
+    const std::vector<Output>& outputs() const { return mOutputs; }
+    void clearOutputs() { mOutputs.clear(); setCacheDirty(); }
+
+    //! The primitive type captured, PT_UNKNOWN (default) deduces it from the draw calls of the source.
+    //! Must be PT_POINTS, PT_LINES or PT_TRIANGLES, set it when a geometry or tessellation shader changes the primitive type.
+    void setCapturePrimitive(EPrimitiveType type) { mCapturePrimitive = type; setCacheDirty(); }
+    EPrimitiveType capturePrimitive() const { return mCapturePrimitive; }
+
+    //! The maximum number of vertices captured, 0 (default) computes it from the draw calls of the source.
+    //! Must be set when a geometry or tessellation shader amplifies the geometry.
+    void setCapacity(int vertex_count) { mCapacity = vertex_count; setCacheDirty(); }
+    int capacity() const { return mCapacity; }
+
+    //! Forces the capture to be run again at the next rendering.
+    void setCacheDirty() { mCacheDirty = true; }
+    bool isCacheDirty() const { return mCacheDirty; }
+
+    //! Runs the capture on \p gl_context, which must be current, leaving the default render states applied.
+    //! Called automatically by the rendering when the cache is dirty. Returns false if nothing could be captured.
+    bool capture(OpenGLContext* gl_context);
+
+    //! The Geometry drawing the captured vertices.
+    Geometry* cache() { return mCache.get(); }
+    const Geometry* cache() const { return mCache.get(); }
+
+    //! Number of vertices written by the last capture.
+    int capturedVertexCount() const { return mCapturedVertexCount; }
+
+    //! Number of captures executed so far.
+    unsigned long captureCount() const { return mCaptureCount; }
+
+    // --- Renderable interface implementation ---
+
+    virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+
+    virtual void deleteBufferObject();
+
+  protected:
+    virtual void computeBounds_Implementation();
+    virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+
+    bool isSourceChanged() const;
+    long long sourceTick() const;
+    EPrimitiveType capturePrimitiveType() const;
+    int capturedVertexCapacity(EPrimitiveType capture_type) const;
+
+  protected:
+    ref<Geometry> mSource;
+    ref<Shader> mCaptureShader;
+    ref<Geometry> mCache;
+    ref<DrawArrays> mCacheDraw;
+    std::vector< ref<ArrayAbstract> > mCacheArrays;
+    std::vector<Output> mOutputs;
+    EPrimitiveType mCapturePrimitive;
+    int mCapacity;
+    int mCapturedVertexCount;
+    unsigned long mCaptureCount;
+    long long mSourceTick;
+    unsigned int mQuery;
+    bool mCacheDirty;
+  };
+}
+
+#endif
@@ -0,0 +1,520 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/TriangleBVH.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/TriangleVisitor.hpp>
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define VL_TRIANGLEBVH_SSE
+#endif
+
+using namespace vl;
+
+namespace
+{
+  const int MaxLeafSize = 4;
+  const int BinCount = 12;
+
+  //! Triangle visitor collecting the triangles of the DrawCalls along with their origin, see forEachTriangle().
+  struct TriangleCollector
+  {
+    TriangleCollector(): mDrawCall(0), mTriangle(0) {}
+
+    void operator()(int a, int b, int c)
+    {
+      mTriangles.push_back(a);
+      mTriangles.push_back(b);
+      mTriangles.push_back(c);
+      mDrawCallIndex.push_back(mDrawCall);
+      mTriangleIndex.push_back(mTriangle++);
+    }
+
+    int mDrawCall;
+    int mTriangle;
+    std::vector<int> mTriangles;
+    std::vector<int> mDrawCallIndex;
+    std::vector<int> mTriangleIndex;
+  };
+
+  //! Bounds accumulation used by the binned SAH.
+  struct Bounds
+  {
+    Bounds() { mMin[0] = mMin[1] = mMin[2] = std::numeric_limits<float>::max(); mMax[0] = mMax[1] = mMax[2] = -std::numeric_limits<float>::max(); }
+    void add(const float* bmin, const float* bmax)
+    {
+      for(int i=0; i<3; ++i)
+      {
+        mMin[i] = bmin[i] < mMin[i] ? bmin[i] : mMin[i];
+        mMax[i] = bmax[i] > mMax[i] ? bmax[i] : mMax[i];
+      }
+    }
+    void add(const Bounds& b) { add(b.mMin, b.mMax); }
+    float area() const
+    {
+      if (mMin[0] > mMax[0])
+        return 0;
+      float dx = mMax[0] - mMin[0], dy = mMax[1] - mMin[1], dz = mMax[2] - mMin[2];
+      return dx*dy + dy*dz + dz*dx;
+    }
+    float mMin[3];
+    float mMax[3];
+  };
+
+  //! Partitions the triangles according to their centroid bin.
+  struct BinPredicate
+  {
+    BinPredicate(const std::vector<float>& centroids, int axis, float cmin, float scale, int split): mCentroids(centroids), mAxis(axis), mMin(cmin), mScale(scale), mSplit(split) {}
+    bool operator()(int tri) const { return binOf(mCentroids[tri*3+mAxis], mMin, mScale) < mSplit; }
+    static int binOf(float c, float cmin, float scale)
+    {
+      int bin = (int)((c - cmin) * scale);
+      return bin < 0 ? 0 : bin >= BinCount ? BinCount-1 : bin;
+    }
+    const std::vector<float>& mCentroids;
+    int mAxis;
+    float mMin;
+    float mScale;
+    int mSplit;
+  };
+
+  //! Orders the triangles along an axis for the median split fallback.
+  struct CentroidLess
+  {
+    CentroidLess(const std::vector<float>& centroids, int axis): mCentroids(centroids), mAxis(axis) {}
+    bool operator()(int a, int b) const { return mCentroids[a*3+mAxis] < mCentroids[b*3+mAxis]; }
+    const std::vector<float>& mCentroids;
+    int mAxis;
+  };
+}
+//-----------------------------------------------------------------------------
+void TriangleBVH::clear()
+{
+  mNodes.clear();
+  for(int i=0; i<3; ++i)
+  {
+    mV0[i].clear();
+    mE1[i].clear();
+    mE2[i].clear();
+  }
+  mTriangles.clear();
+  mDrawCallIndex.clear();
+  mTriangleIndex.clear();
+  mVertexArray = NULL;
+  mVertexArrayTick = 0;
+  mDrawCalls.clear();
+}
+//-----------------------------------------------------------------------------
+bool TriangleBVH::isUpToDate(const Geometry* geom) const
+{
+  if ( geom->vertexArray() != mVertexArray || !mVertexArray || mVertexArray->bufferObjectDirtyTick() != mVertexArrayTick )
+    return false;
+  if ( geom->drawCalls().size() != (int)mDrawCalls.size() )
+    return false;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+    if ( geom->drawCalls().at(i) != mDrawCalls[i] )
+      return false;
+  return true;
+}
+//-----------------------------------------------------------------------------
+void TriangleBVH::build(const Geometry* geom)
+{
+  clear();
+
+  const ArrayAbstract* posarr = geom->vertexArray();
+  mVertexArray = posarr;
+  mVertexArrayTick = posarr ? posarr->bufferObjectDirtyTick() : 0;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+    mDrawCalls.push_back( geom->drawCalls().at(i) );
+  if (!posarr)
+    return;
+
+  // collect the triangles
+  TriangleCollector collector;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    collector.mDrawCall = i;
+    collector.mTriangle = 0;
+    forEachTriangle(geom->drawCalls().at(i), collector);
+  }
+  const std::vector<int>& triangles = collector.mTriangles;
+  const std::vector<int>& drawcall_index = collector.mDrawCallIndex;
+  const std::vector<int>& triangle_index = collector.mTriangleIndex;
+
+  const int count = (int)drawcall_index.size();
+  if (!count)
+    return;
+
+  // vertices, bounds and centroids of the triangles
+  std::vector<vec3> pos_storage;
+  const vec3* pos = vec3Data(posarr, pos_storage);
+  std::vector<fvec3> verts(count*3);
+  std::vector<float> bounds(count*6);
+  std::vector<float> centroids(count*3);
+  for(int i=0; i<count; ++i)
+  {
+    for(int j=0; j<3; ++j)
+      verts[i*3+j] = (fvec3)pos[ triangles[i*3+j] ];
+    for(int k=0; k<3; ++k)
+    {
+      float cmin = std::min( verts[i*3+0][k], std::min(verts[i*3+1][k], verts[i*3+2][k]) );
+      float cmax = std::max( verts[i*3+0][k], std::max(verts[i*3+1][k], verts[i*3+2][k]) );
+      bounds[i*6+k]   = cmin;
+      bounds[i*6+3+k] = cmax;
+      centroids[i*3+k] = (cmin + cmax) * 0.5f;
+    }
+  }
+
+  std::vector<int> order(count);
+  for(int i=0; i<count; ++i)
+    order[i] = i;
+  mNodes.reserve( count / 2 * 2 + 1 );
+  buildNode(order, 0, count, bounds, centroids);
+
+  // store the triangles in leaf order, padded so that a leaf can always be loaded 4 triangles at a time
+  const int padded = count + MaxLeafSize - 1;
+  for(int k=0; k<3; ++k)
+  {
+    mV0[k].resize(padded, 0);
+    mE1[k].resize(padded, 0);
+    mE2[k].resize(padded, 0);
+  }
+  mTriangles.resize(count*3);
+  mDrawCallIndex.resize(count);
+  mTriangleIndex.resize(count);
+  for(int i=0; i<count; ++i)
+  {
+    const int tri = order[i];
+    const fvec3& a = verts[tri*3+0];
+    const fvec3 e1 = verts[tri*3+1] - a;
+    const fvec3 e2 = verts[tri*3+2] - a;
+    for(int k=0; k<3; ++k)
+    {
+      mV0[k][i] = a[k];
+      mE1[k][i] = e1[k];
+      mE2[k][i] = e2[k];
+      mTriangles[i*3+k] = triangles[tri*3+k];
+    }
+    mDrawCallIndex[i] = drawcall_index[tri];
+    mTriangleIndex[i] = triangle_index[tri];
+  }
+}
+//-----------------------------------------------------------------------------
+int TriangleBVH::buildNode(std::vector<int>& order, int first, int count, const std::vector<float>& bounds, const std::vector<float>& centroids)
+{
+  const int index = (int)mNodes.size();
+  mNodes.push_back(Node());
+
+  Bounds box, cbox;
+  for(int i=first; i<first+count; ++i)
+  {
+    box.add( &bounds[order[i]*6], &bounds[order[i]*6+3] );
+    cbox.add( &centroids[order[i]*3], &centroids[order[i]*3] );
+  }
+  for(int k=0; k<3; ++k)
+  {
+    mNodes[index].mMin[k] = box.mMin[k];
+    mNodes[index].mMax[k] = box.mMax[k];
+  }
+  mNodes[index].mFirst = first;
+  mNodes[index].mCount = count;
+  mNodes[index].mRight = -1;
+
+  if (count <= MaxLeafSize)
+    return index;
+
+  // binned surface area heuristic
+  int best_axis = -1;
+  int best_split = 0;
+  float best_cost = std::numeric_limits<float>::max();
+  for(int axis=0; axis<3; ++axis)
+  {
+    const float extent = cbox.mMax[axis] - cbox.mMin[axis];
+    if (extent <= 0)
+      continue;
+    const float scale = BinCount / extent;
+    Bounds bins[BinCount];
+    int bin_count[BinCount] = { 0 };
+    for(int i=first; i<first+count; ++i)
+    {
+      int bin = BinPredicate::binOf(centroids[order[i]*3+axis], cbox.mMin[axis], scale);
+      bins[bin].add( &bounds[order[i]*6], &bounds[order[i]*6+3] );
+      ++bin_count[bin];
+    }
+    // right to left sweep
+    float right_area[BinCount];
+    int right_count[BinCount];
+    Bounds right;
+    int rcount = 0;
+    for(int b=BinCount-1; b>0; --b)
+    {
+      right.add(bins[b]);
+      rcount += bin_count[b];
+      right_area[b] = right.area();
+      right_count[b] = rcount;
+    }
+    // left to right sweep
+    Bounds left;
+    int lcount = 0;
+    for(int b=1; b<BinCount; ++b)
+    {
+      left.add(bins[b-1]);
+      lcount += bin_count[b-1];
+      if (!lcount || !right_count[b])
+        continue;
+      float cost = left.area() * lcount + right_area[b] * right_count[b];
+      if (cost < best_cost)
+      {
+        best_cost = cost;
+        best_axis = axis;
+        best_split = b;
+      }
+    }
+  }
+
+  int mid;
+  if (best_axis >= 0)
+  {
+    const float scale = BinCount / (cbox.mMax[best_axis] - cbox.mMin[best_axis]);
+    mid = (int)( std::partition( order.begin() + first, order.begin() + first + count,
+                                 BinPredicate(centroids, best_axis, cbox.mMin[best_axis], scale, best_split) ) - order.begin() );
+  }
+  else
+  {
+    // all the centroids coincide: split in the middle
+    mid = first + count / 2;
+    std::nth_element( order.begin() + first, order.begin() + mid, order.begin() + first + count, CentroidLess(centroids, 0) );
+  }
+
+  buildNode(order, first, mid - first, bounds, centroids);
+  int right = buildNode(order, mid, first + count - mid, bounds, centroids);
+  mNodes[index].mRight = right;
+  return index;
+}
+//-----------------------------------------------------------------------------
+void TriangleBVH::intersect(const Ray& ray, std::vector<Hit>& hits) const
+{
+  if (mNodes.empty())
+    return;
+
+  const float o[] = { (float)ray.origin().x(), (float)ray.origin().y(), (float)ray.origin().z() };
+  const float d[] = { (float)ray.direction().x(), (float)ray.direction().y(), (float)ray.direction().z() };
+  float inv[3];
+  for(int k=0; k<3; ++k)
+    inv[k] = d[k] != 0 ? 1.0f / d[k] : 0;
+
+#if defined(VL_TRIANGLEBVH_SSE)
+  const __m128 ox = _mm_set1_ps(o[0]), oy = _mm_set1_ps(o[1]), oz = _mm_set1_ps(o[2]);
+  const __m128 dx = _mm_set1_ps(d[0]), dy = _mm_set1_ps(d[1]), dz = _mm_set1_ps(d[2]);
+  const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+#endif
+
+  std::vector<int> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while(!stack.empty())
+  {
+    const Node& node = mNodes[stack.back()];
+    const int node_index = stack.back();
+    stack.pop_back();
+
+    // slab test
+    float tmin = 0, tmax = std::numeric_limits<float>::max();
+    bool miss = false;
+    for(int k=0; k<3 && !miss; ++k)
+    {
+      if (d[k] == 0)
+        miss = o[k] < node.mMin[k] || o[k] > node.mMax[k];
+      else
+      {
+        float t1 = (node.mMin[k] - o[k]) * inv[k];
+        float t2 = (node.mMax[k] - o[k]) * inv[k];
+        if (t1 > t2)
+          std::swap(t1, t2);
+        tmin = t1 > tmin ? t1 : tmin;
+        tmax = t2 < tmax ? t2 : tmax;
+        miss = tmin > tmax;
+      }
+    }
+    if (miss)
+      continue;
+
+    if (node.mRight >= 0)
+    {
+      stack.push_back(node.mRight);
+      stack.push_back(node_index + 1);
+      continue;
+    }
+
+    // Moller-Trumbore, 4 triangles at a time
+    const int first = node.mFirst;
+#if defined(VL_TRIANGLEBVH_SSE)
+    const __m128 e1x = _mm_loadu_ps(&mE1[0][first]), e1y = _mm_loadu_ps(&mE1[1][first]), e1z = _mm_loadu_ps(&mE1[2][first]);
+    const __m128 e2x = _mm_loadu_ps(&mE2[0][first]), e2y = _mm_loadu_ps(&mE2[1][first]), e2z = _mm_loadu_ps(&mE2[2][first]);
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    const __m128 inv_det = _mm_div_ps(one, det);
+    const __m128 tx = _mm_sub_ps(ox, _mm_loadu_ps(&mV0[0][first]));
+    const __m128 ty = _mm_sub_ps(oy, _mm_loadu_ps(&mV0[1][first]));
+    const __m128 tz = _mm_sub_ps(oz, _mm_loadu_ps(&mV0[2][first]));
+    const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inv_det);
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+    const __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv_det);
+    const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv_det);
+    __m128 mask = _mm_cmpneq_ps(det, zero);
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+    mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+    int bits = _mm_movemask_ps(mask) & ((1 << node.mCount) - 1);
+    if (bits)
+    {
+      float dist[4];
+      _mm_storeu_ps(dist, t);
+      for(int i=0; i<node.mCount; ++i)
+        if (bits & (1 << i))
+          hits.push_back( Hit(dist[i], first + i) );
+    }
+#else
+    for(int i=first; i<first+node.mCount; ++i)
+    {
+      const float e1[] = { mE1[0][i], mE1[1][i], mE1[2][i] };
+      const float e2[] = { mE2[0][i], mE2[1][i], mE2[2][i] };
+      const float p[] = { d[1]*e2[2] - d[2]*e2[1], d[2]*e2[0] - d[0]*e2[2], d[0]*e2[1] - d[1]*e2[0] };
+      const float det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+      if (det == 0)
+        continue;
+      const float inv_det = 1.0f / det;
+      const float t[] = { o[0] - mV0[0][i], o[1] - mV0[1][i], o[2] - mV0[2][i] };
+      const float u = (t[0]*p[0] + t[1]*p[1] + t[2]*p[2]) * inv_det;
+      if (u < 0 || u > 1)
+        continue;
+      const float q[] = { t[1]*e1[2] - t[2]*e1[1], t[2]*e1[0] - t[0]*e1[2], t[0]*e1[1] - t[1]*e1[0] };
+      const float v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2]) * inv_det;
+      if (v < 0 || u + v > 1)
+        continue;
+      const float dist = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2]) * inv_det;
+      if (dist >= 0)
+        hits.push_back( Hit(dist, i) );
+    }
+#endif
+  }
+}
+//-----------------------------------------------------------------------------
+bool TriangleBVH::isTriangleCulled(const Frustum& frustum, int tri, u32 plane_mask) const
+{
+  const vec3 a( mV0[0][tri], mV0[1][tri], mV0[2][tri] );
+  const vec3 b = a + vec3( mE1[0][tri], mE1[1][tri], mE1[2][tri] );
+  const vec3 c = a + vec3( mE2[0][tri], mE2[1][tri], mE2[2][tri] );
+  for(unsigned i=0; i<frustum.planes().size(); ++i)
+  {
+    if ( !(plane_mask & (1u << i)) )
+      continue;
+    const Plane& plane = frustum.plane(i);
+    if ( plane.distance(a) > 0 && plane.distance(b) > 0 && plane.distance(c) > 0 )
+      return true;
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+void TriangleBVH::extractTriangles(const Frustum& frustum, std::vector<int>& triangles) const
+{
+  VL_CHECK(frustum.planes().size() <= 32)
+  if (mNodes.empty())
+    return;
+
+  std::vector< std::pair<int, u32> > stack;
+  stack.reserve(64);
+  stack.push_back( std::make_pair(0, frustum.planes().size() >= 32 ? 0xFFFFFFFFu : (1u << frustum.planes().size()) - 1) );
+  while(!stack.empty())
+  {
+    const Node& node = mNodes[stack.back().first];
+    const int node_index = stack.back().first;
+    u32 mask = stack.back().second;
+    stack.pop_back();
+
+    AABB aabb( vec3(node.mMin[0], node.mMin[1], node.mMin[2]), vec3(node.mMax[0], node.mMax[1], node.mMax[2]) );
+    int last_plane = -1;
+    if ( frustum.cull(aabb, mask, last_plane) )
+      continue;
+
+    if (!mask)
+    {
+      // fully inside
+      for(int i=node.mFirst; i<node.mFirst+node.mCount; ++i)
+        triangles.push_back(i);
+    }
+    else
+    if (node.mRight >= 0)
+    {
+      stack.push_back( std::make_pair(node.mRight, mask) );
+      stack.push_back( std::make_pair(node_index + 1, mask) );
+    }
+    else
+    {
+      for(int i=node.mFirst; i<node.mFirst+node.mCount; ++i)
+        if ( !isTriangleCulled(frustum, i, mask) )
+          triangles.push_back(i);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void TriangleBVH::extractTriangles(const Frustum& frustum, const mat4& matrix, std::vector<int>& triangles) const
+{
+  // brings the planes in the local space: dot(n, M * x) - o = dot(R^t * n, x) - (o - dot(n, t))
+  Frustum local;
+  local.planes().resize( frustum.planes().size() );
+  for(unsigned i=0; i<frustum.planes().size(); ++i)
+  {
+    const vec3& n = frustum.plane(i).normal();
+    vec3 ln( matrix.e(0,0)*n.x() + matrix.e(1,0)*n.y() + matrix.e(2,0)*n.z(),
+             matrix.e(0,1)*n.x() + matrix.e(1,1)*n.y() + matrix.e(2,1)*n.z(),
+             matrix.e(0,2)*n.x() + matrix.e(1,2)*n.y() + matrix.e(2,2)*n.z() );
+    real lo = frustum.plane(i).origin() - dot( n, matrix.getT() );
+    real len = ln.length();
+    if (len > 0)
+    {
+      ln /= len;
+      lo /= len;
+    }
+    local.setPlane( i, Plane(lo, ln) );
+  }
+  extractTriangles(local, triangles);
+}
+//-----------------------------------------------------------------------------
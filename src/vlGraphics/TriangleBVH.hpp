@@ -0,0 +1,146 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TriangleBVH_INCLUDE_ONCE
+#define TriangleBVH_INCLUDE_ONCE
+
+#include <vlCore/Ray.hpp>
+#include <vlCore/Matrix4.hpp>
+#include <vlGraphics/Frustum.hpp>
+#include <vector>
+
+namespace vl
+{
+  class Geometry;
+  class ArrayAbstract;
+  class DrawCall;
+
+  //-----------------------------------------------------------------------------
+  // TriangleBVH
+  //-----------------------------------------------------------------------------
+  /**
+   * A bounding volume hierarchy of the triangles of a Geometry, in the Geometry's local coordinates,
+   * used to accelerate ray picking and frustum (box) selection on large meshes.
+   *
+   * The hierarchy is built with a binned surface area heuristic and its leaves contain up to 4 triangles which are
+   * stored in SoA layout and tested against a ray all at once using SSE when available.
+   * You don't usually need to create a TriangleBVH directly, see Geometry::triangleBVH().
+   *
+   * \sa RayIntersector, Geometry::triangleBVH()
+   */
+  class VLGRAPHICS_EXPORT TriangleBVH: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::TriangleBVH, Object)
+
+  public:
+    //! A ray/triangle intersection
+    struct Hit
+    {
+      Hit(): mDistance(0), mTriangle(-1) {}
+      Hit(real dist, int tri): mDistance(dist), mTriangle(tri) {}
+      //! The ray parameter of the intersection point, that is, origin + direction * distance.
+      real mDistance;
+      //! The BVH triangle index of the intersected triangle, see drawCallIndex(), triangleIndex() and triangle().
+      int mTriangle;
+    };
+
+  public:
+    TriangleBVH(): mVertexArray(NULL), mVertexArrayTick(0)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Builds the BVH from all the triangles of the given Geometry.
+    void build(const Geometry* geom);
+
+    //! Returns \p true if the BVH was built from the same vertex array, vertex array content and draw calls the Geometry has now.
+    bool isUpToDate(const Geometry* geom) const;
+
+    //! Discards the BVH.
+    void clear();
+
+    //! The number of triangles in the BVH.
+    int triangleCount() const { return (int)mDrawCallIndex.size(); }
+    //! The number of nodes of the BVH.
+    int nodeCount() const { return (int)mNodes.size(); }
+
+    //! The index in Geometry::drawCalls() of the DrawCall the given triangle belongs to.
+    int drawCallIndex(int tri) const { return mDrawCallIndex[tri]; }
+    //! The index of the given triangle within its DrawCall, as enumerated by DrawCall::triangleIterator().
+    int triangleIndex(int tri) const { return mTriangleIndex[tri]; }
+    //! The 3 vertex indices of the given triangle.
+    const int* triangle(int tri) const { return &mTriangles[tri*3]; }
+
+    /** Appends to \p hits all the intersections between the triangles and the given ray, both the front and back faces are considered.
+      * The ray must be in the local coordinates of the Geometry. The hits are not sorted. */
+    void intersect(const Ray& ray, std::vector<Hit>& hits) const;
+
+    /** Appends to \p triangles the triangles which are at least partially inside the given frustum, with the same conservative
+      * test used by Frustum::cull(const std::vector<fvec3>&). The frustum must be in the local coordinates of the Geometry. */
+    void extractTriangles(const Frustum& frustum, std::vector<int>& triangles) const;
+
+    /** Like extractTriangles(const Frustum&, std::vector<int>&) but the frustum is given in world coordinates and
+      * \p matrix is the world matrix of the Geometry, as found in Actor::transform(). */
+    void extractTriangles(const Frustum& frustum, const mat4& matrix, std::vector<int>& triangles) const;
+
+  protected:
+    // If mRight < 0 the node is a leaf, otherwise its children are the following node and mRight.
+    // The triangles of any node's subtree are mFirst...mFirst+mCount-1.
+    struct Node
+    {
+      float mMin[3];
+      float mMax[3];
+      int mFirst;
+      int mCount;
+      int mRight;
+    };
+
+    int buildNode(std::vector<int>& order, int first, int count, const std::vector<float>& bounds, const std::vector<float>& centroids);
+    bool isTriangleCulled(const Frustum& frustum, int tri, u32 plane_mask) const;
+
+  protected:
+    std::vector<Node> mNodes;
+    // triangles in leaf order: first vertex and the two edges in SoA layout, padded to a multiple of 4
+    std::vector<float> mV0[3];
+    std::vector<float> mE1[3];
+    std::vector<float> mE2[3];
+    std::vector<int> mTriangles;
+    std::vector<int> mDrawCallIndex;
+    std::vector<int> mTriangleIndex;
+    // what the BVH was built from
+    const ArrayAbstract* mVertexArray;
+    long long mVertexArrayTick;
+    std::vector<const DrawCall*> mDrawCalls;
+  };
+}
+
+#endif
@@ -0,0 +1,175 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef TriangleVisitor_INCLUDE_ONCE
+#define TriangleVisitor_INCLUDE_ONCE
+
+#include <vlCore/Say.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlGraphics/DrawRangeElements.hpp>
+#include <vector>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // forEachTriangle
+  //-----------------------------------------------------------------------------
+  /** For internal use only. See vl::forEachTriangle() instead. */
+  template<class T_Index, class T_Visitor>
+  int forEachTriangleIndexed(const T_Index* idx, int count, int base_vertex, EPrimitiveType prim_type, T_Visitor& visitor)
+  {
+    int tri_count = 0;
+    if (prim_type == PT_TRIANGLES)
+    {
+      for(int i=0; i+2<count; i+=3, ++tri_count)
+        visitor( (int)idx[i+0] + base_vertex, (int)idx[i+1] + base_vertex, (int)idx[i+2] + base_vertex );
+    }
+    else
+    {
+      VL_CHECK(prim_type == PT_TRIANGLE_STRIP)
+      // odd triangles are flipped to preserve the winding
+      for(int i=0; i+2<count; ++i, ++tri_count)
+      {
+        if (i & 1)
+          visitor( (int)idx[i+0] + base_vertex, (int)idx[i+2] + base_vertex, (int)idx[i+1] + base_vertex );
+        else
+          visitor( (int)idx[i+0] + base_vertex, (int)idx[i+1] + base_vertex, (int)idx[i+2] + base_vertex );
+      }
+    }
+    return tri_count;
+  }
+
+  /** For internal use only. See vl::forEachTriangle() instead. */
+  template<class T_Visitor>
+  int forEachTriangleDirect(int start, int count, EPrimitiveType prim_type, T_Visitor& visitor)
+  {
+    int tri_count = 0;
+    if (prim_type == PT_TRIANGLES)
+    {
+      for(int i=0; i+2<count; i+=3, ++tri_count)
+        visitor( start+i+0, start+i+1, start+i+2 );
+    }
+    else
+    {
+      VL_CHECK(prim_type == PT_TRIANGLE_STRIP)
+      for(int i=0; i+2<count; ++i, ++tri_count)
+      {
+        if (i & 1)
+          visitor( start+i+0, start+i+2, start+i+1 );
+        else
+          visitor( start+i+0, start+i+1, start+i+2 );
+      }
+    }
+    return tri_count;
+  }
+
+  /**
+   * Calls \p visitor(a, b, c) for every triangle of \p dc, with the same indices and in the same order as DrawCall::triangleIterator().
+   * Returns the number of triangles visited.
+   *
+   * The DrawCall is inspected only once: PT_TRIANGLES and PT_TRIANGLE_STRIP DrawArrays, DrawElements and DrawRangeElements
+   * without primitive restart are visited by a loop over the raw index buffer, specialized for its index type, in which the
+   * visitor's call operator can be inlined. All the other cases go through the TriangleIterator.
+   *
+   * \code
+   * struct CountDegenerate
+   * {
+   *   CountDegenerate(): mCount(0) {}
+   *   void operator()(int a, int b, int c) { if (a == b || b == c || c == a) ++mCount; }
+   *   int mCount;
+   * };
+   * CountDegenerate visitor;
+   * for(int i=0; i<geom->drawCalls().size(); ++i)
+   *   forEachTriangle(geom->drawCalls().at(i), visitor);
+   * \endcode
+   *
+   * \sa vec3Data()
+   */
+  template<class T_Visitor>
+  int forEachTriangle(const DrawCall* dc, T_Visitor& visitor)
+  {
+    const EPrimitiveType prim_type = dc->primitiveType();
+    if (prim_type == PT_TRIANGLES || prim_type == PT_TRIANGLE_STRIP)
+    {
+      if (const DrawArrays* da = dc->as<DrawArrays>())
+        return forEachTriangleDirect(da->start(), da->count(), prim_type, visitor);
+
+      const DrawElementsBase* de = dc->as<DrawElementsBase>();
+      const DrawRangeElementsBase* dre = dc->as<DrawRangeElementsBase>();
+      const ArrayAbstract* idx = dc->indexArray();
+      if ( idx && ((de && !de->primitiveRestartEnabled()) || (dre && !dre->primitiveRestartEnabled())) )
+      {
+        int base_vertex = de ? de->baseVertex() : dre->baseVertex();
+        int count = (int)idx->size();
+        switch(idx->glType())
+        {
+        case GL_UNSIGNED_INT:   return forEachTriangleIndexed( (const GLuint*)idx->ptr(),   count, base_vertex, prim_type, visitor );
+        case GL_UNSIGNED_SHORT: return forEachTriangleIndexed( (const GLushort*)idx->ptr(), count, base_vertex, prim_type, visitor );
+        case GL_UNSIGNED_BYTE:  return forEachTriangleIndexed( (const GLubyte*)idx->ptr(),  count, base_vertex, prim_type, visitor );
+        default:
+          break;
+        }
+      }
+    }
+
+    int tri_count = 0;
+    for(TriangleIterator trit = dc->triangleIterator(); trit.hasNext(); trit.next(), ++tri_count)
+      visitor( trit.a(), trit.b(), trit.c() );
+    return tri_count;
+  }
+  //-----------------------------------------------------------------------------
+  // vec3Data
+  //-----------------------------------------------------------------------------
+  /**
+   * Returns the vectors of \p arr as a plain \p vec3 array: the array's own storage if its type matches \p vec3 (ArrayFloat3, or
+   * ArrayDouble3 if VL_PIPELINE_PRECISION is 2), otherwise \p storage filled with a single pass of ArrayAbstract::getAsVec3().
+   * Returns NULL if the array is NULL or empty. The returned pointer is valid as long as the array and \p storage are not modified.
+   */
+  inline const vec3* vec3Data(const ArrayAbstract* arr, std::vector<vec3>& storage)
+  {
+    if (!arr || !arr->size())
+      return NULL;
+#if VL_PIPELINE_PRECISION == 2
+    if (const ArrayDouble3* arr3 = arr->as<ArrayDouble3>())
+#else
+    if (const ArrayFloat3* arr3 = arr->as<ArrayFloat3>())
+#endif
+      return arr3->begin();
+    storage.resize( arr->size() );
+    for(size_t i=0; i<storage.size(); ++i)
+      storage[i] = arr->getAsVec3(i);
+    return &storage[0];
+  }
+}
+
+#endif
@@ -32,10 +32,12 @@
 #ifndef Uniform_INCLUDE_ONCE
 #define Uniform_INCLUDE_ONCE
 
+#include <vlGraphics/link_config.hpp>
 #include <vlCore/vlnamespace.hpp>
 #include <vlCore/Object.hpp>
 #include <vlCore/Vector4.hpp>
 #include <vlCore/Matrix4.hpp>
+#include <vlCore/DirtyTracker.hpp>
 #include <vlGraphics/OpenGL.hpp>
 #include <cstring>
 #include <map>
@@ -56,7 +58,7 @@ namespace vl
    * - Actor
    * - UniformSet
   */
-  class Uniform: public Object
+  class VLGRAPHICS_EXPORT Uniform: public Object
   {
     VL_INSTRUMENT_CLASS(vl::Uniform, Object)
 
@@ -64,12 +66,12 @@ namespace vl
 
   public:
 
-    Uniform(): mType(UT_NONE)
+    Uniform(): mType(UT_NONE), mNameID(-1), mVersion(0)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
 
-    Uniform(const char* name): mType(UT_NONE)
+    Uniform(const char* name): mType(UT_NONE), mNameID(-1), mVersion(0)
     {
       VL_DEBUG_SET_OBJECT_NAME()
       mName = name;
@@ -86,13 +88,34 @@ namespace vl
     const std::string& name() const { return mName; }
 
     //! Returns the name of the uniform variable
+    //! \note Use setName() to rename the uniform, renaming it through the returned reference does not update nameID().
     std::string& name() { return mName; }
 
     //! Sets the name of the uniform variable
-    void setName(const char* name) { mName = name; }
+    void setName(const char* name) { mName = name; mNameID = -1; }
 
     //! Sets the name of the uniform variable
-    void setName(const std::string& name) { mName = name; }
+    void setName(const std::string& name) { mName = name; mNameID = -1; }
+
+    //! Incremented every time the value of the uniform is set. Used by GLSLProgram::applyUniformSet() to skip
+    //! uploading uniforms whose value did not change since the last time they were applied.
+    unsigned int version() const { return mVersion; }
+
+    //! Marks the uniform value as changed, forcing its next upload, see version().
+    void touch() { ++mVersion; }
+
+    //! Returns the interned ID of name(), see internName().
+    int nameID() const
+    {
+      if (mNameID < 0)
+        mNameID = internName(mName);
+      return mNameID;
+    }
+
+    //! Returns a small integer uniquely identifying the given uniform name, equivalent to StringInterner::intern(name).
+    //! Used to index per-GLSLProgram tables such as the uniform location cache.
+    //! \note Names are interned lazily by the rendering thread, see StringInterner::setMutex() if Uniforms are looked up by name from other threads.
+    static int internName(const std::string& name);
 
     // generic array setters
 
@@ -313,14 +336,15 @@ namespace vl
       }
     }
 
-    void* rawData() { if (mData.empty()) return NULL; else return &mData[0]; }
+    //! Returns a writable pointer to the uniform data. Calling this function marks the uniform value as changed, see version().
+    void* rawData() { ++mVersion; if (mData.empty()) return NULL; else return &mData[0]; }
 
     const void* rawData() const { if (mData.empty()) return NULL; else return &mData[0]; }
 
   protected:
     VL_COMPILE_TIME_CHECK( sizeof(int) == sizeof(float) )
-    void initData(int count) { mData.resize(count); }
-    void initDouble(int count) { mData.resize(count*2); }
+    void initData(int count) { mData.resize(count); ++mVersion; DirtyTracker::markDirty(); }
+    void initDouble(int count) { mData.resize(count*2); ++mVersion; DirtyTracker::markDirty(); }
     int singleCount() const { return (int)mData.size(); }
     int doubleCount() const { VL_CHECK((mData.size() & 0x1) == 0 ); return (int)(mData.size() >> 1); }
     const double* doubleData() const { VL_CHECK(!mData.empty()); VL_CHECK((mData.size() & 0x1) == 0 ); return (double*)&mData[0]; }
@@ -331,6 +355,8 @@ namespace vl
     EUniformType mType;
     std::vector<int> mData;
     std::string mName;
+    mutable int mNameID;
+    unsigned int mVersion;
   };
 }
 
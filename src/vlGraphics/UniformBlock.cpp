@@ -0,0 +1,256 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/UniformBlock.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/StringInterner.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+//-----------------------------------------------------------------------------
+// UniformBlock
+//-----------------------------------------------------------------------------
+UniformBlock::UniformBlock(const char* name, int binding_point)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mName = name;
+  mNameID = -1;
+  mBindingPoint = binding_point;
+  mBufferObject = new BufferObject;
+}
+//-----------------------------------------------------------------------------
+void UniformBlock::setUniform(Uniform* uniform)
+{
+  VL_CHECK(uniform)
+  if (uniform == NULL)
+    return;
+  int id = uniform->nameID();
+  for(size_t i=0; i<mUniforms.size(); ++i)
+  {
+    if (mUniforms[i]->nameID() == id)
+    {
+      mUniforms[i] = uniform;
+      return;
+    }
+  }
+  mUniforms.push_back(uniform);
+}
+//-----------------------------------------------------------------------------
+Uniform* UniformBlock::gocUniform(const char* name)
+{
+  Uniform* uniform = getUniform(name);
+  if (uniform)
+    return uniform;
+  mUniforms.push_back( new Uniform(name) );
+  return mUniforms.back().get();
+}
+//-----------------------------------------------------------------------------
+Uniform* UniformBlock::getUniform(const char* name)
+{
+  int id = StringInterner::find(name);
+  if (id < 0)
+    return NULL;
+  for(size_t i=0; i<mUniforms.size(); ++i)
+    if (mUniforms[i]->nameID() == id)
+      return mUniforms[i].get();
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+const Uniform* UniformBlock::getUniform(const char* name) const
+{
+  int id = StringInterner::find(name);
+  if (id < 0)
+    return NULL;
+  for(size_t i=0; i<mUniforms.size(); ++i)
+    if (mUniforms[i]->nameID() == id)
+      return mUniforms[i].get();
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+namespace
+{
+  // scalar size in bytes, number of columns and rows of each uniform type.
+  bool uniformShape(EUniformType type, int& scalar_size, int& columns, int& rows)
+  {
+    scalar_size = 4;
+    columns = 1;
+    switch(type)
+    {
+      case UT_INT:      case UT_UNSIGNED_INT:      case UT_FLOAT:      rows = 1; return true;
+      case UT_INT_VEC2: case UT_UNSIGNED_INT_VEC2: case UT_FLOAT_VEC2: rows = 2; return true;
+      case UT_INT_VEC3: case UT_UNSIGNED_INT_VEC3: case UT_FLOAT_VEC3: rows = 3; return true;
+      case UT_INT_VEC4: case UT_UNSIGNED_INT_VEC4: case UT_FLOAT_VEC4: rows = 4; return true;
+
+      case UT_FLOAT_MAT2:   columns = 2; rows = 2; return true;
+      case UT_FLOAT_MAT3:   columns = 3; rows = 3; return true;
+      case UT_FLOAT_MAT4:   columns = 4; rows = 4; return true;
+      case UT_FLOAT_MAT2x3: columns = 2; rows = 3; return true;
+      case UT_FLOAT_MAT3x2: columns = 3; rows = 2; return true;
+      case UT_FLOAT_MAT2x4: columns = 2; rows = 4; return true;
+      case UT_FLOAT_MAT4x2: columns = 4; rows = 2; return true;
+      case UT_FLOAT_MAT3x4: columns = 3; rows = 4; return true;
+      case UT_FLOAT_MAT4x3: columns = 4; rows = 3; return true;
+
+      default: break;
+    }
+
+    scalar_size = 8;
+    switch(type)
+    {
+      case UT_DOUBLE:      rows = 1; return true;
+      case UT_DOUBLE_VEC2: rows = 2; return true;
+      case UT_DOUBLE_VEC3: rows = 3; return true;
+      case UT_DOUBLE_VEC4: rows = 4; return true;
+
+      case UT_DOUBLE_MAT2:   columns = 2; rows = 2; return true;
+      case UT_DOUBLE_MAT3:   columns = 3; rows = 3; return true;
+      case UT_DOUBLE_MAT4:   columns = 4; rows = 4; return true;
+      case UT_DOUBLE_MAT2x3: columns = 2; rows = 3; return true;
+      case UT_DOUBLE_MAT3x2: columns = 3; rows = 2; return true;
+      case UT_DOUBLE_MAT2x4: columns = 2; rows = 4; return true;
+      case UT_DOUBLE_MAT4x2: columns = 4; rows = 2; return true;
+      case UT_DOUBLE_MAT3x4: columns = 3; rows = 4; return true;
+      case UT_DOUBLE_MAT4x3: columns = 4; rows = 3; return true;
+
+      default: return false;
+    }
+  }
+
+  inline int alignUp(int value, int alignment) { return (value + alignment - 1) / alignment * alignment; }
+}
+//-----------------------------------------------------------------------------
+bool UniformBlock::std140Layout(const Uniform* uniform, int& alignment, int& size, int& column_stride)
+{
+  int scalar_size = 0, columns = 0, rows = 0;
+  if ( ! uniformShape(uniform->type(), scalar_size, columns, rows) )
+    return false;
+
+  // std140 rules 1-3: scalars are aligned to their size, 2-vectors to twice and 3/4-vectors to four times the scalar size
+  int vec_alignment = scalar_size * (rows == 1 ? 1 : rows == 2 ? 2 : 4);
+  int count = uniform->count();
+
+  if ( columns == 1 && count == 1 )
+  {
+    alignment = vec_alignment;
+    column_stride = size = scalar_size * rows;
+  }
+  else
+  {
+    // std140 rules 4-8: arrays and matrices are stored as arrays of column vectors each rounded up to the alignment of a vec4
+    alignment = column_stride = alignUp(vec_alignment, 16);
+    size = column_stride * columns * count;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void UniformBlock::update() const
+{
+  // the buffer object is a cache of the uniform values
+  BufferObject* buffer_object = mBufferObject.get_writable();
+
+  // check whether anything changed since the last upload
+  bool changed = mPackedUniforms.size() != mUniforms.size() || buffer_object->handle() == 0;
+  for(size_t i=0; !changed && i<mUniforms.size(); ++i)
+    changed = mPackedUniforms[i] != mUniforms[i] || mPackedVersions[i] != mUniforms[i]->version();
+
+  if ( ! changed )
+    return;
+
+  mPackedUniforms.resize( mUniforms.size() );
+  mPackedVersions.resize( mUniforms.size() );
+
+  // compute the std140 layout
+  int byte_count = 0;
+  for(size_t i=0; i<mUniforms.size(); ++i)
+  {
+    int alignment = 0, size = 0, column_stride = 0;
+    if ( std140Layout(mUniforms[i].get(), alignment, size, column_stride) )
+      byte_count = alignUp(byte_count, alignment) + size;
+  }
+  // the size of a block is rounded up to the alignment of a vec4
+  byte_count = alignUp(byte_count, 16);
+  if ( byte_count == 0 )
+    return;
+
+  if ( buffer_object->bytesUsed() != (size_t)byte_count )
+    buffer_object->resize( byte_count );
+  memset( buffer_object->ptr(), 0, byte_count );
+
+  // pack the values
+  int offset = 0;
+  for(size_t i=0; i<mUniforms.size(); ++i)
+  {
+    const Uniform* uniform = mUniforms[i].get();
+    mPackedUniforms[i] = mUniforms[i];
+    mPackedVersions[i] = uniform->version();
+
+    int alignment = 0, size = 0, column_stride = 0;
+    if ( ! std140Layout(uniform, alignment, size, column_stride) )
+    {
+      Log::bug( Say("UniformBlock::update(): uniform '%s' of block '%s' has an unsupported type or no value!\n") << uniform->name() << name() );
+      continue;
+    }
+
+    int scalar_size = 0, columns = 0, rows = 0;
+    uniformShape(uniform->type(), scalar_size, columns, rows);
+
+    offset = alignUp(offset, alignment);
+    const unsigned char* src = (const unsigned char*)uniform->rawData();
+    unsigned char* dst = buffer_object->ptr() + offset;
+    int column_bytes = scalar_size * rows;
+    for(int c=0, column_count=columns*uniform->count(); c<column_count; ++c)
+      memcpy( dst + c * column_stride, src + c * column_bytes, column_bytes );
+    offset += size;
+  }
+
+  // upload
+  if ( buffer_object->byteCountBufferObject() != (GLsizeiptr)byte_count )
+    buffer_object->setBufferData( BU_DYNAMIC_DRAW );
+  else
+    buffer_object->setBufferSubData( 0, byte_count );
+}
+//-----------------------------------------------------------------------------
+void UniformBlock::bind() const
+{
+  VL_CHECK_OGL();
+  VL_CHECK( Has_Uniform_Buffer_Object )
+  update();
+  if ( mBufferObject->handle() && mBufferObject->byteCountBufferObject() )
+  {
+    glBindBufferRange( GL_UNIFORM_BUFFER, bindingPoint(), mBufferObject->handle(), 0, mBufferObject->byteCountBufferObject() ); VL_CHECK_OGL();
+    // glBindBufferRange() also binds the generic GL_UNIFORM_BUFFER binding point
+    VL_glBindBuffer( GL_UNIFORM_BUFFER, 0 ); VL_CHECK_OGL();
+  }
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,141 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef UniformBlock_INCLUDE_ONCE
+#define UniformBlock_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlGraphics/Uniform.hpp>
+#include <vlGraphics/BufferObject.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // UniformBlock
+  //------------------------------------------------------------------------------
+  /**
+   * A set of Uniform objects stored in a uniform buffer object using the GLSL \p std140 layout.
+   *
+   * The uniforms must be added in the same order as they are declared in the GLSL uniform block, for example
+   * the block <tt>layout(std140) uniform Material { vec4 diffuse; vec4 specular; float shininess; };</tt>
+   * is mapped by a UniformBlock named "Material" containing the uniforms "diffuse", "specular" and "shininess".
+   *
+   * The values are packed and uploaded to the buffer object only when any of the uniforms changes (see Uniform::version()),
+   * and applying a UniformBlock to a GLSLProgram costs a single glBindBufferRange() no matter how many uniforms it contains.
+   * This makes UniformBlocks ideal to share data across programs or to switch materials.
+   *
+   * UniformBlocks are added to a UniformSet with UniformSet::setUniformBlock() and are applied by GLSLProgram::applyUniformSet().
+   * Binding point #0 is reserved to the \p vl_CameraMatrices block managed by ProjViewTransfCallback.
+   *
+   * \note Requires OpenGL 3.1 or GL_ARB_uniform_buffer_object.
+   *
+   * \sa
+   * - UniformSet
+   * - GLSLProgram
+   * - ProjViewTransfCallback
+  */
+  class VLGRAPHICS_EXPORT UniformBlock: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::UniformBlock, Object)
+
+  public:
+    UniformBlock(const char* name="", int binding_point=1);
+
+    //! The name of the GLSL uniform block
+    const std::string& name() const { return mName; }
+
+    //! The name of the GLSL uniform block
+    void setName(const char* name) { mName = name; mNameID = -1; }
+
+    //! The interned ID of name(), see Uniform::internName().
+    int nameID() const
+    {
+      if (mNameID < 0)
+        mNameID = Uniform::internName(mName);
+      return mNameID;
+    }
+
+    //! The uniform buffer binding point used by this block.
+    void setBindingPoint(int binding_point) { mBindingPoint = binding_point; }
+
+    //! The uniform buffer binding point used by this block.
+    int bindingPoint() const { return mBindingPoint; }
+
+    //! Appends a Uniform to the block, or replaces the one with the same name.
+    void setUniform(Uniform* uniform);
+
+    //! Returns the Uniform with the given name, creating it at the end of the block if not present.
+    Uniform* gocUniform(const char* name);
+
+    //! Returns the Uniform with the given name or NULL.
+    Uniform* getUniform(const char* name);
+
+    //! Returns the Uniform with the given name or NULL.
+    const Uniform* getUniform(const char* name) const;
+
+    //! The uniforms of the block, in std140 declaration order.
+    const std::vector< ref<Uniform> >& uniforms() const { return mUniforms; }
+
+    //! The uniforms of the block, in std140 declaration order.
+    std::vector< ref<Uniform> >& uniforms() { return mUniforms; }
+
+    //! Removes all the uniforms from the block.
+    void eraseAllUniforms() { mUniforms.clear(); mPackedUniforms.clear(); mPackedVersions.clear(); }
+
+    //! The buffer object storing the packed uniform values.
+    BufferObject* bufferObject() { return mBufferObject.get(); }
+
+    //! The buffer object storing the packed uniform values.
+    const BufferObject* bufferObject() const { return mBufferObject.get(); }
+
+    //! Packs the uniform values using the std140 layout and uploads them to the buffer object, only if any of them changed.
+    void update() const;
+
+    //! Calls update() and binds the buffer object to bindingPoint() using glBindBufferRange().
+    void bind() const;
+
+    //! Computes the std140 base alignment and size in bytes of the given uniform. Returns false if the type is not supported.
+    static bool std140Layout(const Uniform* uniform, int& alignment, int& size, int& column_stride);
+
+  protected:
+    std::string mName;
+    mutable int mNameID;
+    int mBindingPoint;
+    std::vector< ref<Uniform> > mUniforms;
+    // uniforms and versions as last packed in the buffer object
+    mutable std::vector< ref<Uniform> > mPackedUniforms;
+    mutable std::vector<unsigned int> mPackedVersions;
+    ref<BufferObject> mBufferObject;
+  };
+}
+
+#endif
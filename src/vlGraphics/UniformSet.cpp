@@ -30,18 +30,95 @@
 /**************************************************************************************/
 
 #include <vlGraphics/UniformSet.hpp>
+#include <vlCore/StringInterner.hpp>
 
 using namespace vl;
 
+//-----------------------------------------------------------------------------
+// Uniform
+//-----------------------------------------------------------------------------
+int Uniform::internName(const std::string& name)
+{
+  return StringInterner::intern(name);
+}
+//-----------------------------------------------------------------------------
+// UniformSet
+//-----------------------------------------------------------------------------
+namespace
+{
+  inline unsigned int hashNameID(int name_id) { return (unsigned int)name_id * 2654435761u; }
+}
 //-----------------------------------------------------------------------------
 UniformSet& UniformSet::deepCopyFrom(const UniformSet& other)
 {
   mUniforms = other.mUniforms;
   for(size_t i=0; i<mUniforms.size(); ++i)
     mUniforms[i] = mUniforms[i]->clone();
+  rebuildIndex();
+  // uniform blocks are meant to be shared
+  mUniformBlocks = other.mUniformBlocks;
   return *this;
 }
 //-----------------------------------------------------------------------------
+int UniformSet::findUniform(int name_id) const
+{
+  // never touches the index so that concurrent lookups are safe, a stale index falls back to a linear search
+  if ( mUniformIndexDirty || mUniformIndex.empty() )
+  {
+    for(size_t i=0; i<mUniforms.size(); ++i)
+      if (mUniforms[i]->nameID() == name_id)
+        return (int)i;
+    return -1;
+  }
+
+  unsigned int mask = (unsigned int)mUniformIndex.size() - 1;
+  for(unsigned int h = hashNameID(name_id) & mask; mUniformIndex[h].mPos >= 0; h = (h + 1) & mask)
+    if (mUniformIndex[h].mNameID == name_id)
+      return mUniformIndex[h].mPos;
+  return -1;
+}
+//-----------------------------------------------------------------------------
+void UniformSet::insertIndex(int pos)
+{
+  int name_id = mUniforms[pos]->nameID();
+  unsigned int mask = (unsigned int)mUniformIndex.size() - 1;
+  unsigned int h = hashNameID(name_id) & mask;
+  for( ; mUniformIndex[h].mPos >= 0; h = (h + 1) & mask )
+  {
+    // keep the first of duplicated names, like a linear search would
+    if (mUniformIndex[h].mNameID == name_id)
+      return;
+  }
+  mUniformIndex[h].mNameID = name_id;
+  mUniformIndex[h].mPos = pos;
+}
+//-----------------------------------------------------------------------------
+void UniformSet::rebuildIndex()
+{
+  mUniformIndexDirty = false;
+  mUniformIndex.clear();
+  if ( mUniforms.size() <= IndexThreshold )
+    return;
+
+  // keep the load factor at most 50%
+  size_t size = 32;
+  while( size < mUniforms.size() * 2 )
+    size *= 2;
+  IndexBucket empty = { -1, -1 };
+  mUniformIndex.resize( size, empty );
+  for(size_t i=0; i<mUniforms.size(); ++i)
+    insertIndex( (int)i );
+}
+//-----------------------------------------------------------------------------
+void UniformSet::appendUniform(Uniform* uniform)
+{
+  mUniforms.push_back( uniform );
+  if ( !mUniformIndexDirty && !mUniformIndex.empty() && mUniforms.size() * 2 <= mUniformIndex.size() )
+    insertIndex( (int)mUniforms.size() - 1 );
+  else
+    rebuildIndex();
+}
+//-----------------------------------------------------------------------------
 void UniformSet::setUniform(Uniform* uniform, bool check_for_doubles)
 {
   VL_CHECK(uniform)
@@ -49,26 +126,28 @@ void UniformSet::setUniform(Uniform* uniform, bool check_for_doubles)
     return;
   if ( check_for_doubles )
   {
-    for(unsigned i=0; i<mUniforms.size(); ++i)
+    int i = findUniform( uniform->nameID() );
+    if (i >= 0)
     {
-      if (mUniforms[i]->name() == uniform->name())
-      {
-        mUniforms[i] = uniform;
-        return;
-      }
+      // same name, the index stays valid
+      mUniforms[i] = uniform;
+      return;
     }
   }
-  mUniforms.push_back( uniform );
+  appendUniform( uniform );
 }
 //-----------------------------------------------------------------------------
 void UniformSet::eraseUniform(const char* name)
 {
-  for(unsigned i=0; i<mUniforms.size(); ++i)
-    if (mUniforms[i]->name() == name)
-    {
-      mUniforms.erase( mUniforms.begin() + i );
-      return;
-    }
+  int name_id = StringInterner::find(name);
+  if (name_id < 0)
+    return;
+  int i = findUniform( name_id );
+  if (i >= 0)
+  {
+    mUniforms.erase( mUniforms.begin() + i );
+    rebuildIndex();
+  }
 }
 //-----------------------------------------------------------------------------
 void UniformSet::eraseUniform(const Uniform* uniform)
@@ -77,34 +156,83 @@ void UniformSet::eraseUniform(const Uniform* uniform)
     if (mUniforms[i] == uniform)
     {
       mUniforms.erase( mUniforms.begin() + i );
+      rebuildIndex();
       return;
     }
 }
 //-----------------------------------------------------------------------------
 Uniform* UniformSet::gocUniform(const char* name)
 {
-  for(unsigned i=0; i<mUniforms.size(); ++i)
-    if (mUniforms[i]->name() == name)
-      return mUniforms[i].get();
+  int i = findUniform( StringInterner::intern(name) );
+  if (i >= 0)
+    return mUniforms[i].get();
   ref<Uniform> uniform = new Uniform;
   uniform->setName( name );
-  mUniforms.push_back(uniform);
+  appendUniform( uniform.get() );
   return uniform.get();
 }
 //-----------------------------------------------------------------------------
 Uniform* UniformSet::getUniform(const char* name)
 {
-  for(unsigned i=0; i<mUniforms.size(); ++i)
-    if (mUniforms[i]->name() == name)
-      return mUniforms[i].get();
-  return NULL;
+  int name_id = StringInterner::find(name);
+  return name_id >= 0 ? getUniformByNameID( name_id ) : NULL;
 }
 //-----------------------------------------------------------------------------
 const Uniform* UniformSet::getUniform(const char* name) const
 {
-  for(unsigned i=0; i<mUniforms.size(); ++i)
-    if (mUniforms[i]->name() == name)
-      return mUniforms[i].get();
+  int name_id = StringInterner::find(name);
+  return name_id >= 0 ? getUniformByNameID( name_id ) : NULL;
+}
+//-----------------------------------------------------------------------------
+void UniformSet::setUniformBlock(UniformBlock* block)
+{
+  VL_CHECK(block)
+  if (block == NULL)
+    return;
+  int id = block->nameID();
+  for(unsigned i=0; i<mUniformBlocks.size(); ++i)
+  {
+    if (mUniformBlocks[i]->nameID() == id)
+    {
+      mUniformBlocks[i] = block;
+      return;
+    }
+  }
+  mUniformBlocks.push_back( block );
+}
+//-----------------------------------------------------------------------------
+void UniformSet::eraseUniformBlock(const char* name)
+{
+  int id = StringInterner::find(name);
+  if (id < 0)
+    return;
+  for(unsigned i=0; i<mUniformBlocks.size(); ++i)
+    if (mUniformBlocks[i]->nameID() == id)
+    {
+      mUniformBlocks.erase( mUniformBlocks.begin() + i );
+      return;
+    }
+}
+//-----------------------------------------------------------------------------
+UniformBlock* UniformSet::getUniformBlock(const char* name)
+{
+  int id = StringInterner::find(name);
+  if (id < 0)
+    return NULL;
+  for(unsigned i=0; i<mUniformBlocks.size(); ++i)
+    if (mUniformBlocks[i]->nameID() == id)
+      return mUniformBlocks[i].get();
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+const UniformBlock* UniformSet::getUniformBlock(const char* name) const
+{
+  int id = StringInterner::find(name);
+  if (id < 0)
+    return NULL;
+  for(unsigned i=0; i<mUniformBlocks.size(); ++i)
+    if (mUniformBlocks[i]->nameID() == id)
+      return mUniformBlocks[i].get();
   return NULL;
 }
 //-----------------------------------------------------------------------------
@@ -35,6 +35,7 @@
 #include <vlGraphics/link_config.hpp>
 #include <vlCore/Object.hpp>
 #include <vlGraphics/Uniform.hpp>
+#include <vlGraphics/UniformBlock.hpp>
 
 namespace vl
 {
@@ -44,6 +45,13 @@ namespace vl
   /**
    * A set of Uniform objects managed by a Shader.
    *
+   * Uniforms are looked up by interned name (see Uniform::nameID()): sets larger than a few uniforms also maintain a small
+   * hash index so that setUniform(), getUniform() and eraseUniform() do not need to scan the whole set.
+   *
+   * \note Rename a Uniform before adding it to a UniformSet: the index is rebuilt eagerly when the set is modified through
+   * its methods, not when a contained Uniform changes name. Lookups never modify the set, so they are safe to perform
+   * from several threads as long as nobody is modifying it.
+   *
    * \sa
    * Shader, Effect, Actor
   */
@@ -52,7 +60,7 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::UniformSet, Object)
 
   public:
-    UniformSet()
+    UniformSet(): mUniformIndexDirty(false)
     {
       VL_DEBUG_SET_OBJECT_NAME()
     }
@@ -67,13 +75,15 @@ namespace vl
 
     const std::vector< ref<Uniform> >& uniforms() const { return mUniforms; }
 
-    std::vector< ref<Uniform> >& uniforms() { return mUniforms; }
+    //! \note Marks the lookup index as stale, lookups fall back to a linear search until the set is next modified
+    //! through its methods. Use the const version when only reading the uniforms.
+    std::vector< ref<Uniform> >& uniforms() { mUniformIndexDirty = true; return mUniforms; }
 
     void eraseUniform(const char* name);
 
     void eraseUniform(const Uniform* uniform);
 
-    void eraseAllUniforms() { mUniforms.clear(); }
+    void eraseAllUniforms() { mUniforms.clear(); mUniformIndex.clear(); mUniformIndexDirty = false; }
 
     Uniform* gocUniform(const char* name);
 
@@ -81,8 +91,54 @@ namespace vl
 
     const Uniform* getUniform(const char* name) const;
 
+    //! Returns the Uniform whose Uniform::nameID() is \p name_id or NULL if there isn't such a Uniform, see StringInterner.
+    Uniform* getUniformByNameID(int name_id) { int i = findUniform(name_id); return i >= 0 ? mUniforms[i].get() : NULL; }
+
+    //! Returns the Uniform whose Uniform::nameID() is \p name_id or NULL if there isn't such a Uniform, see StringInterner.
+    const Uniform* getUniformByNameID(int name_id) const { int i = findUniform(name_id); return i >= 0 ? mUniforms[i].get() : NULL; }
+
+    // uniform blocks
+
+    //! Adds a UniformBlock to the set, or replaces the one with the same name. See UniformBlock.
+    void setUniformBlock(UniformBlock* block);
+
+    const std::vector< ref<UniformBlock> >& uniformBlocks() const { return mUniformBlocks; }
+
+    std::vector< ref<UniformBlock> >& uniformBlocks() { return mUniformBlocks; }
+
+    void eraseUniformBlock(const char* name);
+
+    void eraseAllUniformBlocks() { mUniformBlocks.clear(); }
+
+    UniformBlock* getUniformBlock(const char* name);
+
+    const UniformBlock* getUniformBlock(const char* name) const;
+
+    //! Returns true if the set contains neither uniforms nor uniform blocks.
+    bool empty() const { return mUniforms.empty() && mUniformBlocks.empty(); }
+
+  protected:
+    //! Returns the position in uniforms() of the Uniform with the given interned name or -1.
+    int findUniform(int name_id) const;
+    //! Appends a Uniform keeping the index up to date.
+    void appendUniform(Uniform* uniform);
+    void insertIndex(int pos);
+    void rebuildIndex();
+
+    enum { IndexThreshold = 8 };
+
+    struct IndexBucket
+    {
+      int mNameID;
+      int mPos; // -1 marks an empty bucket
+    };
+
   protected:
     std::vector< ref<Uniform> > mUniforms;
+    std::vector< ref<UniformBlock> > mUniformBlocks;
+    // open addressing hash table of uniforms() positions keyed by Uniform::nameID(), only used by sets with more than IndexThreshold uniforms.
+    std::vector<IndexBucket> mUniformIndex;
+    bool mUniformIndexDirty;
   };
 }
 
@@ -0,0 +1,323 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/VertexCacheOptimizer.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <cmath>
+#include <algorithm>
+
+using namespace vl;
+
+namespace
+{
+  // Tom Forsyth's scoring parameters
+  const float CacheDecayPower   = 1.5f;
+  const float LastTriScore      = 0.75f;
+  const float ValenceBoostScale = 2.0f;
+  const float ValenceBoostPower = 0.5f;
+  const int   MaxCacheSize      = 64;
+
+  struct VertexInfo
+  {
+    VertexInfo(): mCachePos(-1), mScore(0), mFirstTri(0), mRemaining(0) {}
+    int mCachePos;
+    float mScore;
+    int mFirstTri;
+    int mRemaining;
+  };
+
+  float vertexScore(const VertexInfo& v, int cache_size)
+  {
+    if ( v.mRemaining == 0 )
+      return -1.0f;
+
+    float score = 0;
+    if ( v.mCachePos >= 0 )
+    {
+      if ( v.mCachePos < 3 )
+        score = LastTriScore; // the vertices of the last triangle are scored the same regardless of their position
+      else
+        score = powf( 1.0f - (v.mCachePos - 3) / float(cache_size - 3), CacheDecayPower );
+    }
+
+    score += ValenceBoostScale * powf( (float)v.mRemaining, -ValenceBoostPower );
+    return score;
+  }
+
+  template<class arr_type>
+  bool reorderTriangles(DrawCall* dc, int vertex_count, int cache_size)
+  {
+    DrawElements<arr_type>* de = dc->as< DrawElements<arr_type> >();
+    if ( !de )
+      return false;
+
+    arr_type* index_buffer = de->indexBuffer();
+
+    if ( de->primitiveType() != PT_TRIANGLES || de->count() != -1 || de->offset() != 0 || index_buffer->size() < 3 )
+      return true;
+
+    std::vector<u32> indices( index_buffer->size() );
+    for(size_t i=0; i<indices.size(); ++i)
+      indices[i] = index_buffer->at(i) + de->baseVertex();
+
+    VertexCacheOptimizer::optimizeTriangles( indices, vertex_count, cache_size );
+
+    for(size_t i=0; i<indices.size(); ++i)
+      index_buffer->at(i) = (typename arr_type::scalar_type)(indices[i] - de->baseVertex());
+    index_buffer->setBufferObjectDirty(true);
+    return true;
+  }
+}
+//-----------------------------------------------------------------------------
+void VertexCacheOptimizer::optimizeTriangles(std::vector<u32>& indices, int vertex_count, int cache_size)
+{
+  const int tri_count = (int)indices.size() / 3;
+  if ( tri_count < 2 )
+    return;
+
+  cache_size = std::min( std::max(cache_size, 4), MaxCacheSize );
+
+  // vertex to triangle adjacency
+  std::vector<VertexInfo> verts( vertex_count );
+  for(int i=0; i<tri_count*3; ++i)
+  {
+    VL_CHECK( (int)indices[i] < vertex_count )
+    verts[ indices[i] ].mRemaining++;
+  }
+  int offset = 0;
+  for(int i=0; i<vertex_count; ++i)
+  {
+    verts[i].mFirstTri = offset;
+    offset += verts[i].mRemaining;
+  }
+  std::vector<int> vert_tris( offset );
+  std::vector<int> fill( vertex_count, 0 );
+  for(int t=0; t<tri_count; ++t)
+  {
+    for(int k=0; k<3; ++k)
+    {
+      u32 v = indices[t*3+k];
+      vert_tris[ verts[v].mFirstTri + fill[v]++ ] = t;
+    }
+  }
+
+  // initial scores
+  for(int i=0; i<vertex_count; ++i)
+    verts[i].mScore = vertexScore( verts[i], cache_size );
+
+  std::vector<float> tri_score( tri_count );
+  std::vector<char> tri_added( tri_count, 0 );
+  for(int t=0; t<tri_count; ++t)
+    tri_score[t] = verts[indices[t*3+0]].mScore + verts[indices[t*3+1]].mScore + verts[indices[t*3+2]].mScore;
+
+  std::vector<u32> output;
+  output.reserve( indices.size() );
+
+  int cache[MaxCacheSize + 3];
+  int cache_count = 0;
+  int best_tri = -1;
+  float best_score = -1;
+  int scan_pos = 0;
+
+  for(int emitted=0; emitted<tri_count; ++emitted)
+  {
+    // no good candidate around the cache: find the best remaining triangle scanning linearly
+    if ( best_tri == -1 )
+    {
+      best_score = -1;
+      for(int t=scan_pos; t<tri_count; ++t)
+      {
+        if ( !tri_added[t] && tri_score[t] > best_score )
+        {
+          best_score = tri_score[t];
+          best_tri = t;
+        }
+      }
+      // all the triangles before best_tri have surely been added if we picked the first one available
+      while( scan_pos < tri_count && tri_added[scan_pos] )
+        ++scan_pos;
+    }
+    VL_CHECK(best_tri != -1)
+
+    // emit the triangle
+    tri_added[best_tri] = 1;
+    int tri_verts[3] = { (int)indices[best_tri*3+0], (int)indices[best_tri*3+1], (int)indices[best_tri*3+2] };
+    for(int k=0; k<3; ++k)
+    {
+      output.push_back( tri_verts[k] );
+
+      // remove the triangle from the vertex adjacency
+      VertexInfo& v = verts[ tri_verts[k] ];
+      int* tris = &vert_tris[v.mFirstTri];
+      for(int j=0; j<v.mRemaining; ++j)
+      {
+        if ( tris[j] == best_tri )
+        {
+          std::swap( tris[j], tris[v.mRemaining-1] );
+          break;
+        }
+      }
+      v.mRemaining--;
+    }
+
+    // update the LRU cache: move the triangle's vertices to the front
+    int new_cache[MaxCacheSize + 3];
+    int new_count = 0;
+    for(int k=0; k<3; ++k)
+      new_cache[new_count++] = tri_verts[k];
+    for(int j=0; j<cache_count; ++j)
+    {
+      int v = cache[j];
+      if ( v != tri_verts[0] && v != tri_verts[1] && v != tri_verts[2] )
+        new_cache[new_count++] = v;
+    }
+
+    // update the scores of the vertices in the cache and of their triangles
+    for(int j=0; j<new_count; ++j)
+    {
+      VertexInfo& v = verts[ new_cache[j] ];
+      v.mCachePos = j < cache_size ? j : -1;
+      float score = vertexScore( v, cache_size );
+      float delta = score - v.mScore;
+      v.mScore = score;
+      for(int k=0; k<v.mRemaining; ++k)
+        tri_score[ vert_tris[v.mFirstTri + k] ] += delta;
+    }
+
+    cache_count = std::min( new_count, cache_size );
+    for(int j=0; j<cache_count; ++j)
+      cache[j] = new_cache[j];
+
+    // pick the best triangle among the ones using vertices in the cache
+    best_tri = -1;
+    best_score = -1;
+    for(int j=0; j<cache_count; ++j)
+    {
+      const VertexInfo& v = verts[ cache[j] ];
+      for(int k=0; k<v.mRemaining; ++k)
+      {
+        int t = vert_tris[v.mFirstTri + k];
+        if ( tri_score[t] > best_score )
+        {
+          best_score = tri_score[t];
+          best_tri = t;
+        }
+      }
+    }
+  }
+
+  indices.swap( output );
+}
+//-----------------------------------------------------------------------------
+float VertexCacheOptimizer::computeACMR(const Geometry* geom, int cache_size)
+{
+  if ( !geom->vertexArray() || cache_size < 1 )
+    return 0;
+
+  // FIFO cache simulation: a vertex is in the cache if less than cache_size vertices were inserted after it
+  std::vector<int> stamp( geom->vertexArray()->size(), -cache_size-1 );
+  int clock = 0;
+  int misses = 0;
+  int triangles = 0;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    // each draw call starts with a cold cache
+    clock += cache_size + 1;
+    for(TriangleIterator trit = geom->drawCalls().at(i)->triangleIterator(); trit.hasNext(); trit.next())
+    {
+      int tri[3] = { trit.a(), trit.b(), trit.c() };
+      for(int k=0; k<3; ++k)
+      {
+        if ( tri[k] < 0 || tri[k] >= (int)stamp.size() )
+          continue;
+        if ( clock - stamp[tri[k]] > cache_size )
+        {
+          stamp[tri[k]] = clock++;
+          ++misses;
+        }
+      }
+      ++triangles;
+    }
+  }
+
+  return triangles ? (float)misses / triangles : 0;
+}
+//-----------------------------------------------------------------------------
+bool VertexCacheOptimizer::optimize(Geometry* geom)
+{
+  mACMRBefore = mACMRAfter = 0;
+
+  if ( !geom->vertexArray() )
+  {
+    Log::warning("VertexCacheOptimizer::optimize() failed. No vertices found.\n");
+    return false;
+  }
+
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    DrawCall* dc = geom->drawCalls().at(i);
+    if ( dc->primitiveRestartEnabled() || !dc->as<DrawElementsBase>() )
+    {
+      Log::warning("VertexCacheOptimizer::optimize() supports only DrawElements* draw calls without primitive restart.\n");
+      return false;
+    }
+  }
+
+  mACMRBefore = computeACMR(geom, mCacheSize);
+
+  // reorder the triangles
+  int vertex_count = (int)geom->vertexArray()->size();
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    DrawCall* dc = geom->drawCalls().at(i);
+    if ( !reorderTriangles<ArrayUInt1>(dc, vertex_count, mCacheSize) &&
+         !reorderTriangles<ArrayUShort1>(dc, vertex_count, mCacheSize) &&
+         !reorderTriangles<ArrayUByte1>(dc, vertex_count, mCacheSize) )
+    {
+      Log::warning("VertexCacheOptimizer::optimize(): unsupported DrawElements type.\n");
+    }
+  }
+
+  // reorder the vertices by first use and pick the smallest index types
+  geom->sortVertices();
+  geom->shrinkDrawCalls();
+
+  mACMRAfter = computeACMR(geom, mCacheSize);
+
+  Log::debug( Say("VertexCacheOptimizer: ACMR %.3n -> %.3n\n") << mACMRBefore << mACMRAfter );
+
+  return true;
+}
+//-----------------------------------------------------------------------------
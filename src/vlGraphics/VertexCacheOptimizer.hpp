@@ -0,0 +1,90 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef VertexCacheOptimizer_INCLUDE_ONCE
+#define VertexCacheOptimizer_INCLUDE_ONCE
+
+#include <vlGraphics/link_config.hpp>
+#include <vlCore/std_types.hpp>
+#include <vector>
+
+namespace vl
+{
+  class Geometry;
+
+  /**
+   * The VertexCacheOptimizer class reorders the triangles of a Geometry to maximize the post-transform vertex cache hit rate.
+   *
+   * The triangles of each DrawElementsUInt/UShort/UByte using PT_TRIANGLES are reordered using Tom Forsyth's
+   * "Linear-Speed Vertex Cache Optimisation" algorithm, then the vertices are reordered in order of first use
+   * to maximize vertex fetch locality using Geometry::sortVertices() and finally the index buffers are shrunk
+   * to the smallest fitting type using Geometry::shrinkDrawCalls().
+   *
+   * The quality of the result is measured as ACMR (Average Cache Miss Ratio, the number of transformed vertices
+   * per triangle) simulating a FIFO cache of cacheSize() entries, see acmrBefore() and acmrAfter().
+   * \sa TriangleStripGenerator, Geometry::sortVertices(), GeometryLoadCallback::setOptimizeVertexCache()
+   */
+  class VLGRAPHICS_EXPORT VertexCacheOptimizer
+  {
+  public:
+    VertexCacheOptimizer(): mCacheSize(32), mACMRBefore(0), mACMRAfter(0) {}
+
+    /** Optimizes the given Geometry. Returns false if the Geometry contains DrawCalls other than DrawElements* or using
+     * primitive restart, in which case the Geometry is left untouched. */
+    bool optimize(Geometry* geom);
+
+    /** Reorders the triangles defined by \p indices (3 indices per triangle) for the given cache size. */
+    static void optimizeTriangles(std::vector<u32>& indices, int vertex_count, int cache_size);
+
+    /** Returns the average number of cache misses per triangle of the given Geometry, simulating a FIFO cache of \p cache_size entries. */
+    static float computeACMR(const Geometry* geom, int cache_size);
+
+    /** The size of the simulated vertex cache (default = 32). */
+    void setCacheSize(int size) { mCacheSize = size; }
+
+    /** The size of the simulated vertex cache (default = 32). */
+    int cacheSize() const { return mCacheSize; }
+
+    /** The ACMR of the Geometry before the last call to optimize(). */
+    float acmrBefore() const { return mACMRBefore; }
+
+    /** The ACMR of the Geometry after the last call to optimize(). */
+    float acmrAfter() const { return mACMRAfter; }
+
+  protected:
+    int mCacheSize;
+    float mACMRBefore;
+    float mACMRAfter;
+  };
+}
+
+#endif
@@ -0,0 +1,672 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+
+#include <vlGraphics/VirtualTexture.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+
+using namespace vl;
+
+namespace
+{
+  const char* FeedbackVertexShader =
+    "#version 150\n"
+    "in vec4 vl_VertexPosition;\n"
+    "in vec4 vl_VertexTexCoord0;\n"
+    "uniform mat4 vl_ModelViewProjectionMatrix;\n"
+    "out vec2 tex_coord;\n"
+    "void main(void)\n"
+    "{\n"
+    "  tex_coord = vl_VertexTexCoord0.xy;\n"
+    "  gl_Position = vl_ModelViewProjectionMatrix * vl_VertexPosition;\n"
+    "}\n";
+
+  // same level selection as virtualTexture() in /glsl/virtual_texture.glsl, the bias compensating the lower resolution
+  const char* FeedbackFragmentShader =
+    "#version 150\n"
+    "uniform vec4 vl_VTParams;\n"
+    "uniform float vl_VTFeedbackBias;\n"
+    "in vec2 tex_coord;\n"
+    "out vec4 vl_FeedbackOutput;\n"
+    "void main(void)\n"
+    "{\n"
+    "  vec2 uv = clamp( tex_coord, 0.0, 1.0 );\n"
+    "  vec2 t = tex_coord * vl_VTParams.x * vl_VTParams.y;\n"
+    "  vec2 dx = dFdx( t ), dy = dFdy( t );\n"
+    "  float lod = 0.5 * log2( max( max( dot( dx, dx ), dot( dy, dy ) ), 1.0e-20 ) ) + vl_VTFeedbackBias;\n"
+    "  int level = int( clamp( floor( lod ), 0.0, vl_VTParams.w ) );\n"
+    "  int pages = int( vl_VTParams.x ) >> level;\n"
+    "  ivec2 tile = min( ivec2( uv * float( pages ) ), ivec2( pages - 1 ) );\n"
+    "  vl_FeedbackOutput = vec4( tile.x & 255, tile.y & 255, ( tile.x >> 8 ) | ( ( tile.y >> 8 ) << 4 ), level + 1 ) / 255.0;\n"
+    "}\n";
+
+  bool lessRecentlyUsed(const std::pair<unsigned, int>& a, const std::pair<unsigned, int>& b) { return a.first < b.first; }
+}
+//-----------------------------------------------------------------------------
+// VirtualTextureTileFiles
+//-----------------------------------------------------------------------------
+ref<Image> VirtualTextureTileFiles::loadTile(int level, int x, int y)
+{
+  if (pattern().empty())
+    return NULL;
+
+  String path = pattern();
+  path.replace( "{level}", String::fromInt(level) );
+  path.replace( "{x}", String::fromInt(x) );
+  path.replace( "{y}", String::fromInt(y) );
+
+  if (directory())
+  {
+    ref<VirtualFile> file = directory()->file(path);
+    return file ? loadImage(file.get()) : ref<Image>(NULL);
+  }
+  else
+    return loadImage(path);
+}
+//-----------------------------------------------------------------------------
+// VirtualTexture
+//-----------------------------------------------------------------------------
+VirtualTexture::VirtualTexture():
+  mLoadMutex(NULL), mCacheSlots(16, 16), mLevelCount(1), mTileSize(128), mTileBorder(1), mMaxLoadsPerFrame(4), mMaxUploadsPerFrame(16),
+  mFrame(0), mStatsRequestedTiles(0), mStatsCachedTiles(0), mStatsPendingTiles(0), mPageTableDirty(false)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mCacheUnit = new Uniform("vl_VTCache");
+  mCacheUnit->setUniformI(0);
+  mPageTableUnit = new Uniform("vl_VTPageTable");
+  mPageTableUnit->setUniformI(1);
+  mParams = new Uniform("vl_VTParams");
+  mParams->setUniform( fvec4(1, 1, 0, 0) );
+}
+//-----------------------------------------------------------------------------
+bool VirtualTexture::init()
+{
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.clear();
+    mLoadedTiles.clear();
+  }
+  mTiles.clear();
+  mSlots.clear();
+  mPageTable.clear();
+  mRootTile = NULL;
+  mCacheTexture = NULL;
+  mPageTableTexture = NULL;
+  mStatsRequestedTiles = 0;
+  mStatsCachedTiles = 0;
+  mStatsPendingTiles = 0;
+
+  if ( !tileSource() )
+  {
+    Log::error("VirtualTexture::init(): no tile source installed.\n");
+    return false;
+  }
+
+  // the feedback encodes the tile coordinates with 12 bits
+  if ( mLevelCount < 1 || mLevelCount > 13 || mTileSize < 1 || mTileBorder < 0 || mTileBorder > mTileSize )
+  {
+    Log::error( Say("VirtualTexture::init(): invalid level count %n, tile size %n or tile border %n.\n") << mLevelCount << mTileSize << mTileBorder );
+    return false;
+  }
+
+  const int slot_side = mTileSize + 2 * mTileBorder;
+  const ivec2 cache_size = mCacheSlots * slot_side;
+  const int page_count = 1 << (mLevelCount - 1);
+
+  int max_size = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size); VL_CHECK_OGL();
+  if ( mCacheSlots.x() < 1 || mCacheSlots.y() < 1 || mCacheSlots.x() > 256 || mCacheSlots.y() > 256 ||
+       cache_size.x() > max_size || cache_size.y() > max_size )
+  {
+    Log::error( Say("VirtualTexture::init(): invalid cache slots %n x %n, the cache texture would be %n x %n (max %n).\n")
+      << mCacheSlots.x() << mCacheSlots.y() << cache_size.x() << cache_size.y() << max_size );
+    return false;
+  }
+
+  mCacheTexture = new Texture;
+  if ( !mCacheTexture->createTexture( TD_TEXTURE_2D, TF_RGBA8, cache_size.x(), cache_size.y(), 0, false, NULL, 0, false ) )
+  {
+    mCacheTexture = NULL;
+    return false;
+  }
+  mCacheTexture->getTexParameter()->setMagFilter(TPF_LINEAR);
+  mCacheTexture->getTexParameter()->setMinFilter(TPF_LINEAR);
+  mCacheTexture->getTexParameter()->setWrap(TPW_CLAMP_TO_EDGE);
+
+  mPageTableTexture = new Texture;
+  if ( !mPageTableTexture->createTexture( TD_TEXTURE_2D, TF_RGBA8, page_count, page_count, 0, false, NULL, 0, false ) )
+  {
+    mCacheTexture = NULL;
+    mPageTableTexture = NULL;
+    return false;
+  }
+  mPageTableTexture->getTexParameter()->setMagFilter(TPF_NEAREST);
+  mPageTableTexture->getTexParameter()->setMinFilter(TPF_NEAREST_MIPMAP_NEAREST);
+  mPageTableTexture->getTexParameter()->setWrap(TPW_CLAMP_TO_EDGE);
+
+  // one page table level per tile level
+  GLint prev_tex = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &prev_tex); VL_CHECK_OGL();
+  glBindTexture(GL_TEXTURE_2D, mPageTableTexture->handle()); VL_CHECK_OGL();
+  for(int level=1; level<mLevelCount; ++level)
+  {
+    glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, page_count >> level, page_count >> level, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL); VL_CHECK_OGL();
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mLevelCount - 1); VL_CHECK_OGL();
+  glBindTexture(GL_TEXTURE_2D, prev_tex); VL_CHECK_OGL();
+
+  mSlots.resize( mCacheSlots.x() * mCacheSlots.y(), NULL );
+  mPageTable.resize( mLevelCount );
+  for(int level=0; level<mLevelCount; ++level)
+    mPageTable[level].resize( (page_count >> level) * (page_count >> level) * 4, 0 );
+
+  // the coarsest tile is always resident
+  mRootTile = new Tile( mLevelCount - 1, 0, 0 );
+  mRootTile->mState = TS_Loading;
+  loadTile( mRootTile.get() );
+  if ( !mRootTile->mImage )
+  {
+    Log::error("VirtualTexture::init(): could not load the coarsest tile.\n");
+    mCacheTexture = NULL;
+    mPageTableTexture = NULL;
+    mRootTile = NULL;
+    return false;
+  }
+  uploadTexture( mCacheTexture.get(), 0, 0, 0, slot_side, slot_side, mRootTile->mImage->pixels() );
+  mRootTile->mImage = NULL;
+  mRootTile->mSlot = 0;
+  mRootTile->mState = TS_Ready;
+  mSlots[0] = mRootTile.get();
+  mTiles[ TileKey(mRootTile->mLevel, 0, 0) ] = mRootTile;
+  mStatsCachedTiles = 1;
+
+  mParams->setUniform( fvec4( (float)page_count, (float)mTileSize, (float)mTileBorder, (float)(mLevelCount - 1) ) );
+
+  mPageTableDirty = true;
+  updatePageTable();
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::setupShader(Shader* shader, int cache_unit, int page_table_unit)
+{
+  VL_CHECK(shader)
+  mCacheUnit->setUniformI(cache_unit);
+  mPageTableUnit->setUniformI(page_table_unit);
+  shader->gocTextureSampler(cache_unit)->setTexture( mCacheTexture.get() );
+  shader->gocTextureSampler(page_table_unit)->setTexture( mPageTableTexture.get() );
+  shader->setUniform( mCacheUnit.get() );
+  shader->setUniform( mPageTableUnit.get() );
+  shader->setUniform( mParams.get() );
+}
+//-----------------------------------------------------------------------------
+VirtualTexture::Tile* VirtualTexture::acquireTile(int level, int x, int y)
+{
+  ref<Tile>& tile = mTiles[ TileKey(level, x, y) ];
+  if (!tile)
+  {
+    tile = new Tile(level, x, y);
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.push_back( tile.get() );
+  }
+  tile->mLastUsedFrame = mFrame;
+  return tile.get();
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::processFeedback(const Image* feedback)
+{
+  if ( !mRootTile || !feedback || !feedback->pixels() )
+    return;
+
+  if ( feedback->format() != IF_RGBA || feedback->type() != IT_UNSIGNED_BYTE )
+  {
+    Log::error("VirtualTexture::processFeedback(): the feedback must be IF_RGBA, IT_UNSIGNED_BYTE.\n");
+    return;
+  }
+
+  ++mFrame;
+  mStatsRequestedTiles = 0;
+
+  const int page_count = 1 << (mLevelCount - 1);
+  unsigned int prev = 0;
+  for(int j=0; j<feedback->height(); ++j)
+  {
+    const unsigned char* px = feedback->pixels() + j * feedback->pitch();
+    for(int i=0; i<feedback->width(); ++i, px += 4)
+    {
+      // neighbouring pixels usually request the same tile
+      unsigned int code = px[0] | (px[1] << 8) | (px[2] << 16) | (px[3] << 24);
+      if ( code == prev || px[3] == 0 )
+        continue;
+      prev = code;
+
+      const int level = px[3] - 1;
+      const int x = px[0] | ((px[2] & 0xF) << 8);
+      const int y = px[1] | ((px[2] >> 4) << 8);
+      if ( level >= mLevelCount || x >= (page_count >> level) || y >= (page_count >> level) )
+        continue;
+
+      // the ancestors are needed as fallbacks while the tile is loaded and must not be evicted
+      for(int l=level; l<mLevelCount; ++l)
+      {
+        const int shift = l - level;
+        std::map< TileKey, ref<Tile> >::iterator it = mTiles.find( TileKey(l, x >> shift, y >> shift) );
+        if ( it != mTiles.end() && it->second->mLastUsedFrame == mFrame )
+          break;
+        acquireTile( l, x >> shift, y >> shift );
+        mStatsRequestedTiles += l == level ? 1 : 0;
+      }
+    }
+  }
+
+  mRootTile->mLastUsedFrame = mFrame;
+  cancelUnusedRequests();
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::update()
+{
+  if ( !mRootTile )
+    return;
+
+  // synchronous loading
+  if (!mLoadMutex)
+    processLoadRequests( maxLoadsPerFrame() );
+
+  uploadLoadedTiles();
+  updatePageTable();
+}
+//-----------------------------------------------------------------------------
+bool VirtualTexture::hasLoadRequests() const
+{
+  ScopedMutex lock(mLoadMutex);
+  return !mLoadQueue.empty();
+}
+//-----------------------------------------------------------------------------
+int VirtualTexture::processLoadRequests(int max_count)
+{
+  int count = 0;
+  for( ; count<max_count; ++count)
+  {
+    Tile* tile = NULL;
+    {
+      ScopedMutex lock(mLoadMutex);
+      if (mLoadQueue.empty())
+        break;
+      tile = mLoadQueue.front();
+      mLoadQueue.pop_front();
+      tile->mState = TS_Loading;
+    }
+
+    // no lock needed: the rendering thread does not touch the tiles being loaded
+    loadTile(tile);
+
+    {
+      ScopedMutex lock(mLoadMutex);
+      tile->mState = tile->mImage ? TS_Loaded : TS_Failed;
+      if (tile->mImage)
+        mLoadedTiles.push_back(tile);
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::loadTile(Tile* tile)
+{
+  ref<Image> img = tileSource()->loadTile(tile->mLevel, tile->mX, tile->mY);
+  if (!img)
+  {
+    Log::warning( Say("VirtualTexture: tile %n (%n, %n) not available.\n") << tile->mLevel << tile->mX << tile->mY );
+    return;
+  }
+
+  const int slot_side = mTileSize + 2 * mTileBorder;
+  if ( img->dimension() != ID_2D || img->width() != img->height() || ( img->width() != mTileSize && img->width() != slot_side ) )
+  {
+    Log::error( Say("VirtualTexture: tile %n (%n, %n) must be %n x %n or %n x %n texels.\n")
+      << tile->mLevel << tile->mX << tile->mY << mTileSize << mTileSize << slot_side << slot_side );
+    return;
+  }
+
+  if ( img->format() != IF_RGBA )
+    img = img->convertFormat(IF_RGBA);
+  if ( img && img->type() != IT_UNSIGNED_BYTE )
+    img = img->convertType(IT_UNSIGNED_BYTE);
+  if ( !img )
+  {
+    Log::error( Say("VirtualTexture: tile %n (%n, %n) could not be converted to RGBA.\n") << tile->mLevel << tile->mX << tile->mY );
+    return;
+  }
+
+  // tightly packed, tiles without border replicate their edges
+  const int offset = img->width() == slot_side ? 0 : mTileBorder;
+  ref<Image> slot_img = new Image( slot_side, slot_side, 0, 1, IF_RGBA, IT_UNSIGNED_BYTE );
+  unsigned char* dst = slot_img->pixels();
+  for(int j=0; j<slot_side; ++j)
+  {
+    const unsigned char* row = img->pixels() + clamp(j - offset, 0, img->height() - 1) * img->pitch();
+    for(int i=0; i<slot_side; ++i, dst += 4)
+      memcpy( dst, row + clamp(i - offset, 0, img->width() - 1) * 4, 4 );
+  }
+
+  tile->mImage = slot_img;
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::cancelUnusedRequests()
+{
+  std::vector<Tile*> cancelled;
+  {
+    ScopedMutex lock(mLoadMutex);
+    std::deque<Tile*> queue;
+    for(size_t i=0; i<mLoadQueue.size(); ++i)
+    {
+      if ( mLoadQueue[i]->mLastUsedFrame == mFrame )
+        queue.push_back( mLoadQueue[i] );
+      else
+        cancelled.push_back( mLoadQueue[i] );
+    }
+    // coarser tiles first, they are needed to display the finer ones
+    for(int level=mLevelCount-1, k=0; k<(int)queue.size(); --level)
+    {
+      for(size_t i=0; i<queue.size(); ++i)
+      {
+        if ( queue[i]->mLevel == level )
+          mLoadQueue[k++] = queue[i];
+      }
+    }
+    mLoadQueue.resize( queue.size() );
+    mStatsPendingTiles = (int)mLoadQueue.size();
+  }
+
+  // the failed tiles not requested anymore can be retried later
+  for( std::map< TileKey, ref<Tile> >::iterator it = mTiles.begin(); it != mTiles.end(); )
+  {
+    if ( it->second->mState == TS_Failed && it->second->mLastUsedFrame != mFrame )
+      mTiles.erase( it++ );
+    else
+      ++it;
+  }
+
+  for(size_t i=0; i<cancelled.size(); ++i)
+    mTiles.erase( TileKey(cancelled[i]->mLevel, cancelled[i]->mX, cancelled[i]->mY) );
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::uploadLoadedTiles()
+{
+  std::vector<Tile*> tiles;
+  {
+    ScopedMutex lock(mLoadMutex);
+    const int count = std::min( (int)mLoadedTiles.size(), maxUploadsPerFrame() );
+    tiles.assign( mLoadedTiles.begin(), mLoadedTiles.begin() + count );
+    mLoadedTiles.erase( mLoadedTiles.begin(), mLoadedTiles.begin() + count );
+  }
+  if ( tiles.empty() )
+    return;
+
+  // free slots first, then the least recently used tiles not requested by the last feedback
+  std::vector< std::pair<unsigned, int> > candidates;
+  for(int i=0; i<(int)mSlots.size(); ++i)
+  {
+    if ( !mSlots[i] )
+      candidates.push_back( std::make_pair(0u, i) );
+    else
+    if ( mSlots[i]->mLastUsedFrame != mFrame && mSlots[i] != mRootTile.get() )
+      candidates.push_back( std::make_pair(mSlots[i]->mLastUsedFrame + 1, i) );
+  }
+  std::sort( candidates.begin(), candidates.end(), lessRecentlyUsed );
+
+  const int slot_side = mTileSize + 2 * mTileBorder;
+  size_t next_candidate = 0;
+  std::vector<Tile*> postponed;
+  for(size_t i=0; i<tiles.size(); ++i)
+  {
+    Tile* tile = tiles[i];
+
+    // loaded too late
+    if ( tile->mLastUsedFrame != mFrame )
+    {
+      mTiles.erase( TileKey(tile->mLevel, tile->mX, tile->mY) );
+      continue;
+    }
+
+    // no slot available: retry at the next frame
+    if ( next_candidate == candidates.size() )
+    {
+      postponed.push_back(tile);
+      continue;
+    }
+
+    const int slot = candidates[next_candidate++].second;
+    if ( mSlots[slot] )
+    {
+      Tile* evicted = mSlots[slot];
+      mTiles.erase( TileKey(evicted->mLevel, evicted->mX, evicted->mY) );
+    }
+
+    uploadTexture( mCacheTexture.get(), 0, (slot % mCacheSlots.x()) * slot_side, (slot / mCacheSlots.x()) * slot_side, slot_side, slot_side, tile->mImage->pixels() );
+
+    tile->mImage = NULL;
+    tile->mSlot = slot;
+    tile->mState = TS_Ready;
+    mSlots[slot] = tile;
+    mPageTableDirty = true;
+  }
+
+  if ( !postponed.empty() )
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadedTiles.insert( mLoadedTiles.begin(), postponed.begin(), postponed.end() );
+  }
+
+  mStatsCachedTiles = 0;
+  for(size_t i=0; i<mSlots.size(); ++i)
+    mStatsCachedTiles += mSlots[i] ? 1 : 0;
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::updatePageTable()
+{
+  if ( !mPageTableDirty )
+    return;
+  mPageTableDirty = false;
+
+  std::vector< std::vector<const Tile*> > resident( mLevelCount );
+  for(size_t i=0; i<mSlots.size(); ++i)
+  {
+    if ( mSlots[i] )
+      resident[ mSlots[i]->mLevel ].push_back( mSlots[i] );
+  }
+
+  // each tile inherits the entry of its parent unless it is resident itself
+  const int page_count = 1 << (mLevelCount - 1);
+  for(int level=mLevelCount-1; level>=0; --level)
+  {
+    const int side = page_count >> level;
+    std::vector<unsigned char>& table = mPageTable[level];
+    if ( level < mLevelCount - 1 )
+    {
+      const std::vector<unsigned char>& parent = mPageTable[level + 1];
+      for(int y=0; y<side; ++y)
+        for(int x=0; x<side; ++x)
+          memcpy( &table[ (y * side + x) * 4 ], &parent[ ((y >> 1) * (side >> 1) + (x >> 1)) * 4 ], 4 );
+    }
+
+    for(size_t i=0; i<resident[level].size(); ++i)
+    {
+      const Tile* tile = resident[level][i];
+      unsigned char* entry = &table[ (tile->mY * side + tile->mX) * 4 ];
+      entry[0] = (unsigned char)( tile->mSlot % mCacheSlots.x() );
+      entry[1] = (unsigned char)( tile->mSlot / mCacheSlots.x() );
+      entry[2] = (unsigned char)( tile->mLevel );
+      entry[3] = 255;
+    }
+
+    uploadTexture( mPageTableTexture.get(), level, 0, 0, side, side, &table[0] );
+  }
+}
+//-----------------------------------------------------------------------------
+void VirtualTexture::uploadTexture(Texture* tex, int level, int x, int y, int width, int height, const void* pixels)
+{
+  // called outside of the render queues, where the Renderer has applied the default render states: texture unit 0 is
+  // active with no texture bound and the unpack alignment is the default one, restored like Texture::createTexture() does.
+  glBindTexture(GL_TEXTURE_2D, tex->handle()); VL_CHECK_OGL();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); VL_CHECK_OGL();
+  glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels); VL_CHECK_OGL();
+
+  glBindTexture(GL_TEXTURE_2D, 0); VL_CHECK_OGL();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4); VL_CHECK_OGL();
+}
+//-----------------------------------------------------------------------------
+// VirtualTextureFeedback
+//-----------------------------------------------------------------------------
+VirtualTextureFeedback::VirtualTextureFeedback(VirtualTexture* vt): mScale(0.125f), mLevelBias(0)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+
+  // the feedback is cleared to 0, that is, no tile
+  camera()->viewport()->setClearColor(0, 0, 0, 0);
+
+  mFeedbackProgram = new GLSLProgram;
+  mFeedbackProgram->setObjectName("VirtualTextureFeedback");
+  mFeedbackProgram->attachShader( new GLSLVertexShader(FeedbackVertexShader) );
+  mFeedbackProgram->attachShader( new GLSLFragmentShader(FeedbackFragmentShader) );
+  mFeedbackProgram->bindFragDataLocation(0, "vl_FeedbackOutput");
+
+  mBias = new Uniform("vl_VTFeedbackBias");
+  mBias->setUniformF(0.0f);
+
+  mFeedbackEffect = new Effect;
+  mFeedbackEffect->shader()->enable(EN_DEPTH_TEST);
+  mFeedbackEffect->shader()->setRenderState(mFeedbackProgram.get());
+  mFeedbackEffect->shader()->setUniform(mBias.get());
+
+  // overrides the Effect of every Actor
+  effectOverrideMask()[0xFFFFFFFF] = mFeedbackEffect;
+
+  mReadback = new AsyncReadPixels(0, 0, 0, 0, RDB_COLOR_ATTACHMENT0);
+  mReadback->setCallback( new FeedbackCallback(this) );
+
+  setVirtualTexture(vt);
+}
+//-----------------------------------------------------------------------------
+void VirtualTextureFeedback::setVirtualTexture(VirtualTexture* vt)
+{
+  if ( mVirtualTexture )
+    mFeedbackEffect->shader()->eraseUniform("vl_VTParams");
+  mVirtualTexture = vt;
+  if ( vt )
+    mFeedbackEffect->shader()->setUniform( vt->paramsUniform() );
+}
+//-----------------------------------------------------------------------------
+void VirtualTextureFeedback::initFramebuffer(OpenGLContext* gl_context)
+{
+  VL_CHECK(gl_context);
+
+  mColorBuffer = new FBOColorBufferAttachment(CBF_RGBA8);
+  mDepthBuffer = new FBODepthBufferAttachment(DBF_DEPTH_COMPONENT24);
+  ref<FramebufferObject> fbo = gl_context->createFramebufferObject(1, 1, RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT0);
+  fbo->addColorAttachment( AP_COLOR_ATTACHMENT0, mColorBuffer.get() );
+  fbo->addDepthAttachment( mDepthBuffer.get() );
+  renderer()->setFramebuffer( fbo.get() );
+}
+//-----------------------------------------------------------------------------
+void VirtualTextureFeedback::render()
+{
+  if ( !virtualTexture() || enableMask() == 0 )
+    return;
+
+#if defined(VL_OPENGL)
+  if ( !sourceCamera() || !sourceCamera()->viewport() || !renderer() || !cast<FramebufferObject>(renderer()->framebuffer()) )
+  {
+    Log::error("VirtualTextureFeedback::render(): no source camera or no framebuffer object, see setSourceCamera() and initFramebuffer().\n");
+    VL_TRAP();
+    return;
+  }
+
+  if ( !(Has_GL_Version_3_2||Has_GL_Version_4_0) )
+  {
+    Log::error("VirtualTextureFeedback::render(): OpenGL 3.2 required.\n");
+    return;
+  }
+
+  // follow the source camera at a lower resolution
+  const Viewport* src_viewport = sourceCamera()->viewport();
+  if ( src_viewport->width() <= 0 || src_viewport->height() <= 0 )
+    return;
+  const int w = vl::max( 1, (int)(src_viewport->width()  * mScale) );
+  const int h = vl::max( 1, (int)(src_viewport->height() * mScale) );
+
+  camera()->viewport()->set( 0, 0, w, h );
+  camera()->setFOV( sourceCamera()->fov() );
+  camera()->setNearPlane( sourceCamera()->nearPlane() );
+  camera()->setFarPlane( sourceCamera()->farPlane() );
+  camera()->setProjectionMatrix( sourceCamera()->projectionMatrix(), sourceCamera()->projectionMatrixType() );
+  camera()->setModelingMatrix( sourceCamera()->modelingMatrix() );
+
+  // the texture coordinate derivatives are larger by the inverse of the scale
+  mBias->setUniformF( (float)( log( (double)w / src_viewport->width() ) / log(2.0) ) + mLevelBias );
+
+  // the renderbuffers are reallocated when attached again
+  FramebufferObject* fbo = cast<FramebufferObject>( renderer()->framebuffer() );
+  if ( fbo->width() != w || fbo->height() != h )
+  {
+    fbo->setWidth( w );
+    fbo->setHeight( h );
+    if ( mColorBuffer && mDepthBuffer )
+    {
+      mColorBuffer->setWidth( w );
+      mColorBuffer->setHeight( h );
+      mDepthBuffer->setWidth( w );
+      mDepthBuffer->setHeight( h );
+      fbo->addColorAttachment( AP_COLOR_ATTACHMENT0, mColorBuffer.get() );
+      fbo->addDepthAttachment( mDepthBuffer.get() );
+    }
+  }
+
+  Rendering::render();
+
+  // delivers the completed feedback to the VirtualTexture and starts reading this one
+  fbo->bindFramebuffer( FBB_READ_FRAMEBUFFER );
+  mReadback->setup( 0, 0, w, h, RDB_COLOR_ATTACHMENT0 );
+  mReadback->readPixels();
+
+  virtualTexture()->update();
+#endif
+}
+//-----------------------------------------------------------------------------
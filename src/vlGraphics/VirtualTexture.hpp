@@ -0,0 +1,383 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+
+#ifndef VirtualTexture_INCLUDE_ONCE
+#define VirtualTexture_INCLUDE_ONCE
+
+#include <vlGraphics/Rendering.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlGraphics/AsyncReadPixels.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlCore/VirtualDirectory.hpp>
+#include <vlCore/IMutex.hpp>
+#include <map>
+#include <deque>
+
+namespace vl
+{
+  class OpenGLContext;
+  class GLSLProgram;
+
+  //-----------------------------------------------------------------------------
+  // VirtualTextureTileSource
+  //-----------------------------------------------------------------------------
+  /**
+   * Provides the tiles of a VirtualTexture.
+   *
+   * The virtual texture is a mip pyramid of square tiles: level 0 is the full resolution texture, each level halves the resolution
+   * of the previous one and the coarsest level, VirtualTexture::levelCount() - 1, is a single tile. Level \p L has 2^(levelCount-1-L)
+   * tiles per side, tile (x, y) covering the texture coordinates [x, x+1] x [y, y+1] in units of the level's tile size, y growing with t.
+   *
+   * The tiles are VirtualTexture::tileSize() texels wide, or better tileSize() + 2 * tileBorder() texels including the neighbouring texels
+   * required to filter across the tile borders; tiles without border are extended replicating their edges.
+   *
+   * \note When VirtualTexture::processLoadRequests() is called from a worker thread loadTile() is called from that thread.
+   */
+  class VLGRAPHICS_EXPORT VirtualTextureTileSource: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::VirtualTextureTileSource, Object)
+
+  public:
+    //! Returns the image of the given tile, NULL if not available.
+    virtual ref<Image> loadTile(int level, int x, int y) = 0;
+  };
+
+  //-----------------------------------------------------------------------------
+  // VirtualTextureTileFiles
+  //-----------------------------------------------------------------------------
+  /**
+   * A VirtualTextureTileSource loading the tiles from image files whose paths are generated replacing the strings
+   * \p "{level}", \p "{x}" and \p "{y}" of a pattern, for example \p "/ortho/{level}/{x}_{y}.jpg".
+   * The files are looked up in directory() if one is set, otherwise using the default FileSystem.
+   */
+  class VLGRAPHICS_EXPORT VirtualTextureTileFiles: public VirtualTextureTileSource
+  {
+    VL_INSTRUMENT_CLASS(vl::VirtualTextureTileFiles, VirtualTextureTileSource)
+
+  public:
+    VirtualTextureTileFiles(const String& pattern=String()): mPattern(pattern)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    virtual ref<Image> loadTile(int level, int x, int y);
+
+    //! The path pattern of the tiles.
+    void setPattern(const String& pattern) { mPattern = pattern; }
+    //! The path pattern of the tiles.
+    const String& pattern() const { return mPattern; }
+
+    //! The directory containing the tiles, if NULL the default FileSystem is used.
+    void setDirectory(VirtualDirectory* dir) { mDirectory = dir; }
+    //! The directory containing the tiles, if NULL the default FileSystem is used.
+    VirtualDirectory* directory() { return mDirectory.get(); }
+
+  protected:
+    String mPattern;
+    ref<VirtualDirectory> mDirectory;
+  };
+
+  //-----------------------------------------------------------------------------
+  // VirtualTexture
+  //-----------------------------------------------------------------------------
+  /**
+   * A texture much larger than the GPU memory, such as the orthophoto of a large terrain, streamed tile by tile from a VirtualTextureTileSource
+   * according to what is actually visible.
+   *
+   * \par Textures
+   * The tiles in use are stored, with their borders, in the slots of cacheTexture(), a 2D texture whose size in slots is given by setCacheSlots().
+   * The mipmapped pageTableTexture() has one RGBA texel per tile of each level containing the cache slot of the finest resident tile covering
+   * it in RG and that tile's level in B. The coarsest tile is loaded by init() and always resident, so every lookup succeeds, falling back
+   * to coarser tiles while the finer ones are loaded. setupShader() installs both textures and the uniforms required by the
+   * \p "vec4 virtualTexture(vec2 uv)" function of \p "/glsl/virtual_texture.glsl", which replaces the usual texture lookups.
+   *
+   * \par Feedback
+   * The tiles needed are determined by a VirtualTextureFeedback, which renders the scene at low resolution writing for each pixel the tile
+   * that the shader would sample, reads the result back asynchronously and passes it to processFeedback(). The tiles not needed anymore are
+   * evicted from the cache, least recently used first, only when their slots are needed by new tiles.
+   *
+   * \par Loading
+   * Missing tiles are queued and loaded by processLoadRequests(), which only touches CPU data. Without a loadMutex() update() calls it
+   * loading up to maxLoadsPerFrame() tiles. For asynchronous loading install a mutex with setLoadMutex() and call processLoadRequests()
+   * from one or more worker threads: update() then only uploads up to maxUploadsPerFrame() loaded tiles per frame.
+   * \note No thread must be running processLoadRequests() while init() is called or the VirtualTexture is destroyed.
+   * \sa VirtualTextureFeedback, VirtualTextureTileSource
+   */
+  class VLGRAPHICS_EXPORT VirtualTexture: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::VirtualTexture, Object)
+
+  public:
+    VirtualTexture();
+
+    /** Discards all the loaded tiles, creates the cacheTexture() and pageTableTexture() and loads the coarsest tile.
+      * Must be called with an active OpenGL context after setting the parameters and when they change. */
+    bool init();
+
+    /** Installs cacheTexture() and pageTableTexture() on the given texture units of \p shader and the uniforms used by \p "/glsl/virtual_texture.glsl".
+      * Can be called before init(). */
+    void setupShader(Shader* shader, int cache_unit=0, int page_table_unit=1);
+
+    /** Requests the tiles found in an image rendered by a VirtualTextureFeedback and cancels the requests of the tiles not needed anymore.
+      * The pixels are IF_RGBA, IT_UNSIGNED_BYTE: R and G contain the low 8 bits of the tile x and y, the low and high 4 bits of B the
+      * high bits of x and y and A the level + 1, 0 meaning no tile. */
+    void processFeedback(const Image* feedback);
+
+    /** Loads the requested tiles if no loadMutex() is installed, uploads the loaded ones to the cacheTexture() and updates the pageTableTexture().
+      * Called by VirtualTextureFeedback::render(), requires an active OpenGL context. */
+    void update();
+
+    /** Loads up to \p max_count queued tiles, coarser tiles first. Can be called from any thread if a loadMutex() is installed.
+      * \return The number of tiles loaded. */
+    int processLoadRequests(int max_count);
+
+    //! Returns true if there are tiles waiting to be loaded.
+    bool hasLoadRequests() const;
+
+    //! The source of the tiles.
+    void setTileSource(VirtualTextureTileSource* source) { mTileSource = source; }
+    //! The source of the tiles.
+    VirtualTextureTileSource* tileSource() { return mTileSource.get(); }
+
+    //! The number of levels of the tile pyramid, the full resolution texture being tileSize() * 2^(count-1) texels wide, at most 13 (default is 1).
+    void setLevelCount(int count) { mLevelCount = count; }
+    //! The number of levels of the tile pyramid, the full resolution texture being tileSize() * 2^(count-1) texels wide, at most 13 (default is 1).
+    int levelCount() const { return mLevelCount; }
+
+    //! The size in texels of the full resolution virtual texture.
+    int virtualSize() const { return mTileSize << (mLevelCount - 1); }
+
+    //! The size in texels of the tiles, excluding the border (default is 128).
+    void setTileSize(int size) { mTileSize = size; }
+    //! The size in texels of the tiles, excluding the border (default is 128).
+    int tileSize() const { return mTileSize; }
+
+    //! The number of texels shared with the neighbouring tiles on each side of a tile, 1 is enough for bilinear filtering (default is 1).
+    void setTileBorder(int border) { mTileBorder = border; }
+    //! The number of texels shared with the neighbouring tiles on each side of a tile, 1 is enough for bilinear filtering (default is 1).
+    int tileBorder() const { return mTileBorder; }
+
+    //! The size in slots of the cacheTexture() along x and y, at most 256 (default is 16 x 16).
+    void setCacheSlots(const ivec2& slots) { mCacheSlots = slots; }
+    //! The size in slots of the cacheTexture() along x and y, at most 256 (default is 16 x 16).
+    const ivec2& cacheSlots() const { return mCacheSlots; }
+
+    //! The maximum number of tiles loaded by update() when no loadMutex() is installed (default is 4).
+    void setMaxLoadsPerFrame(int count) { mMaxLoadsPerFrame = count; }
+    //! The maximum number of tiles loaded by update() when no loadMutex() is installed (default is 4).
+    int maxLoadsPerFrame() const { return mMaxLoadsPerFrame; }
+
+    //! The maximum number of loaded tiles uploaded to the cacheTexture() by update() (default is 16).
+    void setMaxUploadsPerFrame(int count) { mMaxUploadsPerFrame = count; }
+    //! The maximum number of loaded tiles uploaded to the cacheTexture() by update() (default is 16).
+    int maxUploadsPerFrame() const { return mMaxUploadsPerFrame; }
+
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    void setLoadMutex(IMutex* mutex) { mLoadMutex = mutex; }
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    IMutex* loadMutex() { return mLoadMutex; }
+
+    //! The 2D texture caching the tiles, created by init().
+    Texture* cacheTexture() { return mCacheTexture.get(); }
+
+    //! The mipmapped 2D texture mapping each tile to the cache slot of the tile sampled in its place, created by init().
+    Texture* pageTableTexture() { return mPageTableTexture.get(); }
+
+    /** The \p "uniform vec4 vl_VTParams" installed by setupShader(): the number of tiles per side of level 0, tileSize(), tileBorder()
+      * and levelCount() - 1. */
+    Uniform* paramsUniform() { return mParams.get(); }
+
+    //! The number of distinct tiles found by the last processFeedback().
+    int statsRequestedTiles() const { return mStatsRequestedTiles; }
+    //! The number of tiles currently in the cacheTexture().
+    int statsCachedTiles() const { return mStatsCachedTiles; }
+    //! The number of tiles waiting to be loaded.
+    int statsPendingTiles() const { return mStatsPendingTiles; }
+
+  protected:
+    enum ETileState { TS_Queued, TS_Loading, TS_Loaded, TS_Ready, TS_Failed };
+
+    class Tile: public Object
+    {
+    public:
+      Tile(int level, int x, int y): mLevel(level), mX(x), mY(y), mState(TS_Queued), mLastUsedFrame(0), mSlot(-1) {}
+      int mLevel, mX, mY;
+      ETileState mState;
+      unsigned mLastUsedFrame;
+      // filled by the loader
+      ref<Image> mImage;
+      // assigned by the rendering thread
+      int mSlot;
+    };
+
+    struct TileKey
+    {
+      TileKey(int level, int x, int y): mLevel(level), mX(x), mY(y) {}
+      bool operator<(const TileKey& other) const
+      {
+        if (mLevel != other.mLevel) return mLevel < other.mLevel;
+        if (mX != other.mX) return mX < other.mX;
+        return mY < other.mY;
+      }
+      int mLevel, mX, mY;
+    };
+
+    Tile* acquireTile(int level, int x, int y);
+    void loadTile(Tile* tile);
+    void uploadLoadedTiles();
+    void cancelUnusedRequests();
+    void updatePageTable();
+    void uploadTexture(Texture* tex, int level, int x, int y, int width, int height, const void* pixels);
+
+  protected:
+    ref<VirtualTextureTileSource> mTileSource;
+    std::map< TileKey, ref<Tile> > mTiles;
+    std::deque<Tile*> mLoadQueue;    // protected by mLoadMutex
+    std::vector<Tile*> mLoadedTiles; // protected by mLoadMutex
+    std::vector<Tile*> mSlots;
+    std::vector< std::vector<unsigned char> > mPageTable;
+    ref<Tile> mRootTile;
+    ref<Texture> mCacheTexture;
+    ref<Texture> mPageTableTexture;
+    ref<Uniform> mCacheUnit;
+    ref<Uniform> mPageTableUnit;
+    ref<Uniform> mParams;
+    IMutex* mLoadMutex;
+    ivec2 mCacheSlots;
+    int mLevelCount;
+    int mTileSize;
+    int mTileBorder;
+    int mMaxLoadsPerFrame;
+    int mMaxUploadsPerFrame;
+    unsigned mFrame;
+    int mStatsRequestedTiles;
+    int mStatsCachedTiles;
+    int mStatsPendingTiles;
+    bool mPageTableDirty;
+  };
+
+  //-----------------------------------------------------------------------------
+  // VirtualTextureFeedback
+  //-----------------------------------------------------------------------------
+  /** A Rendering determining the tiles of a VirtualTexture needed by the sourceCamera() and keeping the VirtualTexture up to date.
+    *
+    * The scene is rendered at scale() times the resolution of the sourceCamera()'s viewport using a single override Effect
+    * (see Rendering::effectOverrideMask()) whose GLSL program writes for each pixel the tile that \p "virtualTexture()" would sample
+    * for the texture coordinates 0 of the Actor. The image is read back with an AsyncReadPixels, so that it is delivered to
+    * VirtualTexture::processFeedback() a frame or two later without stalling the pipeline, then VirtualTexture::update() is called.
+    *
+    * Usage:
+    * - add the same SceneManager[s] used by the main Rendering to sceneManagers()
+    * - set enableMask() so that only the Actors textured with the virtualTexture() are rendered, see Actor::setEnableMask()
+    * - call initFramebuffer() once with the OpenGLContext used for the rendering
+    * - call setSourceCamera() with the main camera and add the VirtualTextureFeedback before the main Rendering in a RenderingTree.
+    *
+    * \note
+    * - Actor vertex programs, such as displacement, are overridden too and are not taken into account.
+    * - Requires OpenGL 3.2.
+    * \sa VirtualTexture */
+  class VLGRAPHICS_EXPORT VirtualTextureFeedback: public Rendering
+  {
+    VL_INSTRUMENT_CLASS(vl::VirtualTextureFeedback, Rendering)
+
+  public:
+    VirtualTextureFeedback(VirtualTexture* vt=NULL);
+
+    /** Collects the feedback of the previous frames, renders the feedback of this frame and updates the virtualTexture(). */
+    virtual void render();
+
+    /** Creates the framebuffer object with an RGBA8 color attachment and a depth attachment used by the feedback
+      * and installs it as the Framebuffer of renderer(). The framebuffer object is resized automatically. */
+    void initFramebuffer(OpenGLContext* gl_context);
+
+    //! The VirtualTexture whose tiles are determined.
+    void setVirtualTexture(VirtualTexture* vt);
+    //! The VirtualTexture whose tiles are determined.
+    VirtualTexture* virtualTexture() { return mVirtualTexture.get(); }
+
+    //! The Camera whose view, projection and viewport size are used to render the feedback.
+    void setSourceCamera(Camera* camera) { mSourceCamera = camera; }
+    //! The Camera whose view, projection and viewport size are used to render the feedback.
+    Camera* sourceCamera() { return mSourceCamera.get(); }
+
+    //! The resolution of the feedback relative to the sourceCamera()'s viewport (default is 1/8).
+    void setScale(float scale) { mScale = scale; }
+    //! The resolution of the feedback relative to the sourceCamera()'s viewport (default is 1/8).
+    float scale() const { return mScale; }
+
+    //! Added to the level computed for each pixel, positive values request coarser tiles (default is 0).
+    void setLevelBias(float bias) { mLevelBias = bias; }
+    //! Added to the level computed for each pixel, positive values request coarser tiles (default is 0).
+    float levelBias() const { return mLevelBias; }
+
+    //! The override Effect used to render the feedback, which can be used to adjust its render states.
+    Effect* feedbackEffect() { return mFeedbackEffect.get(); }
+
+    //! The AsyncReadPixels reading back the feedback.
+    AsyncReadPixels* readback() { return mReadback.get(); }
+
+    //! Discards the feedback in flight and releases the pixel buffer objects used for the readback. Must be called with the OpenGL context current.
+    void releaseBufferObjects() { mReadback->releaseBuffers(); }
+
+  protected:
+    // forwards the feedback to the VirtualTexture
+    class FeedbackCallback: public ReadbackCallback
+    {
+    public:
+      FeedbackCallback(VirtualTextureFeedback* owner): mOwner(owner) {}
+      virtual void onPixelsRead(AsyncReadPixels*, Image* image, unsigned long)
+      {
+        if ( mOwner->virtualTexture() )
+          mOwner->virtualTexture()->processFeedback(image);
+      }
+    private:
+      VirtualTextureFeedback* mOwner;
+    };
+
+  protected:
+    ref<VirtualTexture> mVirtualTexture;
+    ref<Camera> mSourceCamera;
+    ref<Effect> mFeedbackEffect;
+    ref<GLSLProgram> mFeedbackProgram;
+    ref<Uniform> mBias;
+    ref<AsyncReadPixels> mReadback;
+    ref<FBOColorBufferAttachment> mColorBuffer;
+    ref<FBODepthBufferAttachment> mDepthBuffer;
+    float mScale;
+    float mLevelBias;
+  };
+  //-----------------------------------------------------------------------------
+}
+
+#endif
@@ -0,0 +1,379 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlGraphics/WeightedBlendedOITRenderer.hpp>
+#include <vlGraphics/RenderQueue.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+
+using namespace vl;
+
+namespace
+{
+  const char* ResolveVertexShader =
+    "#version 150\n"
+    "void main(void)\n"
+    "{\n"
+    "  // full screen triangle\n"
+    "  gl_Position = vec4( gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0 );\n"
+    "}\n";
+
+  const char* ResolveFragmentShader =
+    "#version 150\n"
+    "uniform sampler2D vl_OITAccumulation;\n"
+    "uniform sampler2D vl_OITRevealage;\n"
+    "out vec4 vl_FragColor;\n"
+    "void main(void)\n"
+    "{\n"
+    "  ivec2 texel = ivec2( gl_FragCoord.xy );\n"
+    "  float revealage = texelFetch( vl_OITRevealage, texel, 0 ).r;\n"
+    "  if ( revealage == 1.0 )\n"
+    "    discard;\n"
+    "  vec4 accum = texelFetch( vl_OITAccumulation, texel, 0 );\n"
+    "  vl_FragColor = vec4( accum.rgb / clamp( accum.a, 1e-4, 5e4 ), revealage );\n"
+    "}\n";
+
+  inline void blendFuncSeparatei(GLuint buf, GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+  {
+#if defined(VL_OPENGL)
+    if ( glBlendFuncSeparatei )
+      glBlendFuncSeparatei( buf, src_rgb, dst_rgb, src_alpha, dst_alpha );
+    else
+      glBlendFuncSeparateiARB( buf, src_rgb, dst_rgb, src_alpha, dst_alpha );
+#else
+    (void)buf; (void)src_rgb; (void)dst_rgb; (void)src_alpha; (void)dst_alpha;
+#endif
+  }
+}
+
+//-----------------------------------------------------------------------------
+WeightedBlendedOITRenderer::WeightedBlendedOITRenderer()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+
+  mStatsTranslucentObjects = 0;
+  mShaderWeighted = false;
+
+  mOpaqueRenderQueue = new RenderQueue;
+  mTranslucentRenderQueue = new RenderQueue;
+  mOITActorCallback = new OITActorCallback(this);
+
+  // the OIT buffers are cleared explicitly since they need different clear values
+  mTranslucentRenderer = new Renderer;
+  mTranslucentRenderer->setClearFlags(CF_DO_NOT_CLEAR);
+
+  mResolveProgram = new GLSLProgram;
+  mResolveProgram->setObjectName("WeightedBlendedOITRenderer");
+  mResolveProgram->attachShader( new GLSLVertexShader(ResolveVertexShader) );
+  mResolveProgram->attachShader( new GLSLFragmentShader(ResolveFragmentShader) );
+}
+//-----------------------------------------------------------------------------
+WeightedBlendedOITRenderer::~WeightedBlendedOITRenderer()
+{
+  releaseOpenGLResources();
+}
+//-----------------------------------------------------------------------------
+const Framebuffer* WeightedBlendedOITRenderer::framebuffer() const
+{
+  if (mWrappedRenderer)
+    return mWrappedRenderer->framebuffer();
+  else
+    return NULL;
+}
+//-----------------------------------------------------------------------------
+Framebuffer* WeightedBlendedOITRenderer::framebuffer()
+{
+  if (mWrappedRenderer)
+    return mWrappedRenderer->framebuffer();
+  else
+    return NULL;
+}
+//-----------------------------------------------------------------------------
+bool WeightedBlendedOITRenderer::isSupported() const
+{
+#if defined(VL_OPENGL)
+  return Has_FBO && Has_GLSL && ( Has_GL_Version_4_0 || ( Has_GL_Version_3_2 && Has_GL_ARB_draw_buffers_blend ) );
+#else
+  return false;
+#endif
+}
+//-----------------------------------------------------------------------------
+const RenderQueue* WeightedBlendedOITRenderer::render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock)
+{
+  // skip if renderer is disabled
+  if (enableMask() == 0)
+    return in_render_queue;
+
+  // enter/exit behavior contract
+
+  class InOutContract 
+  {
+    RendererAbstract* mRenderer;
+
+  public:
+    InOutContract(RendererAbstract* renderer): mRenderer(renderer)
+    {
+      // increment the render tick.
+      mRenderer->incrementRenderTick();
+
+      // dispatch the renderer-started event.
+      mRenderer->dispatchOnRendererStarted();
+
+      // check user-generated errors.
+      VL_CHECK_OGL()
+    }
+
+    ~InOutContract()
+    {
+      // dispatch the renderer-finished event
+      mRenderer->dispatchOnRendererFinished();
+
+      // check user-generated errors.
+      VL_CHECK_OGL()
+    }
+  } contract(this);
+
+  // --------------- rendering --------------- 
+
+  if (!mWrappedRenderer)
+  {
+    Log::error("WeightedBlendedOITRenderer::render(): no Renderer is wrapped!\n");
+    VL_TRAP();
+    return in_render_queue;
+  }
+
+  mStatsTranslucentObjects = 0;
+
+  if ( !isSupported() || !framebuffer() )
+    return mWrappedRenderer->render( in_render_queue, camera, frame_clock );
+
+  // (1)
+  // split the opaque and the translucent objects, the latter need no sorting.
+  mOpaqueRenderQueue->clear();
+  mTranslucentRenderQueue->clear();
+  for( int i=0; i<in_render_queue->size(); ++i)
+  {
+    const RenderToken* in_tok = in_render_queue->at(i);
+    if ( ! mWrappedRenderer->isEnabled(in_tok->mActor) )
+      continue;
+
+    RenderToken* tok = in_tok->mShader->isBlendingEnabled() ? mTranslucentRenderQueue->newToken(false) : mOpaqueRenderQueue->newToken(false);
+    *tok = *in_tok;
+  }
+  mStatsTranslucentObjects = mTranslucentRenderQueue->size();
+
+  // (2)
+  // render the opaque objects.
+  mWrappedRenderer->render( mOpaqueRenderQueue.get(), camera, frame_clock );
+
+  if ( mTranslucentRenderQueue->size() == 0 )
+    return in_render_queue;
+
+#if defined(VL_OPENGL)
+  // (3)
+  // copy the opaque depth and clear the accumulation and revealage buffers.
+  prepareFramebuffer();
+  const int w = mOITFramebuffer->width();
+  const int h = mOITFramebuffer->height();
+
+  framebuffer()->activate( FBB_READ_FRAMEBUFFER ); VL_CHECK_OGL();
+  mOITFramebuffer->activate( FBB_DRAW_FRAMEBUFFER ); VL_CHECK_OGL();
+  VL_glBlitFramebuffer( 0, 0, w, h, 0, 0, w, h, GL_DEPTH_BUFFER_BIT, GL_NEAREST ); VL_CHECK_OGL();
+
+  mOITFramebuffer->activate( FBB_FRAMEBUFFER ); VL_CHECK_OGL();
+  const GLfloat zero[] = { 0, 0, 0, 0 };
+  const GLfloat one[]  = { 1, 1, 1, 1 };
+  glClearBufferfv( GL_COLOR, 0, zero ); VL_CHECK_OGL();
+  glClearBufferfv( GL_COLOR, 1, one ); VL_CHECK_OGL();
+
+  // (4)
+  // render the translucent objects, the OIT render states are applied after the ones of each Actor.
+  mTranslucentActors.clear();
+  for( int i=0; i<mTranslucentRenderQueue->size(); ++i )
+  {
+    Actor* actor = mTranslucentRenderQueue->at(i)->mActor;
+    if ( actor->actorEventCallbacks()->find( mOITActorCallback.get() ) == -1 )
+    {
+      actor->actorEventCallbacks()->push_back( mOITActorCallback.get() );
+      mTranslucentActors.push_back( actor );
+    }
+  }
+
+  mTranslucentRenderer->setFramebuffer( mOITFramebuffer.get() );
+  mTranslucentRenderer->render( mTranslucentRenderQueue.get(), camera, frame_clock );
+
+  for( size_t i=0; i<mTranslucentActors.size(); ++i )
+    mTranslucentActors[i]->actorEventCallbacks()->erase( mOITActorCallback.get() );
+  mTranslucentActors.clear();
+
+  // restore the default blending and depth mask
+  VL_glBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ); VL_CHECK_OGL();
+  glDepthMask( GL_TRUE ); VL_CHECK_OGL();
+
+  // (5)
+  // composite the translucent objects on top of the opaque ones.
+  resolve( camera );
+#endif
+
+  return in_render_queue;
+}
+//-----------------------------------------------------------------------------
+void WeightedBlendedOITRenderer::prepareFramebuffer()
+{
+  Framebuffer* target = framebuffer();
+  const int w = target->width();
+  const int h = target->height();
+
+  if ( mOITFramebuffer && mOITFramebuffer->width() == w && mOITFramebuffer->height() == h )
+    return;
+
+  if ( !mOITFramebuffer )
+  {
+    mOITFramebuffer = target->openglContext()->createFramebufferObject( w, h, RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT0 );
+    mOITFramebuffer->setDrawBuffers( RDB_COLOR_ATTACHMENT0, RDB_COLOR_ATTACHMENT1 );
+  }
+  else
+  {
+    mOITFramebuffer->setWidth( w );
+    mOITFramebuffer->setHeight( h );
+  }
+
+  if ( mAccumulationTexture )
+    mAccumulationTexture->destroyTexture();
+  if ( mRevealageTexture )
+    mRevealageTexture->destroyTexture();
+  mAccumulationTexture = new Texture( w, h, TF_RGBA16F );
+  mRevealageTexture    = new Texture( w, h, TF_R16F );
+
+  // fetched with texelFetch(), no mipmaps
+  const Texture* textures[] = { mAccumulationTexture.get(), mRevealageTexture.get() };
+  for( int i=0; i<2; ++i )
+  {
+    glBindTexture( GL_TEXTURE_2D, textures[i]->handle() ); VL_CHECK_OGL();
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST ); VL_CHECK_OGL();
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST ); VL_CHECK_OGL();
+  }
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+
+  // the attachments are recreated so that they are bound with the new dimensions
+  mOITFramebuffer->addTextureAttachment( AP_COLOR_ATTACHMENT0, new FBOTexture2DAttachment( mAccumulationTexture.get(), 0, T2DT_TEXTURE_2D ) );
+  mOITFramebuffer->addTextureAttachment( AP_COLOR_ATTACHMENT1, new FBOTexture2DAttachment( mRevealageTexture.get(), 0, T2DT_TEXTURE_2D ) );
+  mOITFramebuffer->addDepthStencilAttachment( new FBODepthStencilBufferAttachment( DSBT_DEPTH24_STENCIL8 ) );
+}
+//-----------------------------------------------------------------------------
+void WeightedBlendedOITRenderer::applyOITRenderStates() const
+{
+#if defined(VL_OPENGL)
+  if ( shaderWeighted() )
+  {
+    // out0 = weighted premultiplied color, out1 = alpha
+    blendFuncSeparatei( 0, GL_ONE, GL_ONE, GL_ONE, GL_ONE );
+    blendFuncSeparatei( 1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ONE_MINUS_SRC_COLOR );
+  }
+  else
+  {
+    // the same non premultiplied color is written to both buffers
+    blendFuncSeparatei( 0, GL_SRC_ALPHA, GL_ONE, GL_ONE, GL_ONE );
+    blendFuncSeparatei( 1, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA );
+  }
+  VL_CHECK_OGL();
+  VL_glBlendEquation( GL_FUNC_ADD ); VL_CHECK_OGL();
+  glDepthMask( GL_FALSE ); VL_CHECK_OGL();
+#endif
+}
+//-----------------------------------------------------------------------------
+void WeightedBlendedOITRenderer::resolve(const Camera* camera)
+{
+#if defined(VL_OPENGL)
+  OpenGLContext* gl_context = framebuffer()->openglContext();
+
+  if ( !mResolveProgram->linked() && !mResolveProgram->linkProgram() )
+  {
+    Log::error("WeightedBlendedOITRenderer::resolve(): could not link the resolve program.\n");
+    return;
+  }
+
+  framebuffer()->activate( FBB_FRAMEBUFFER ); VL_CHECK_OGL();
+  const Viewport* viewport = camera->viewport();
+  glViewport( viewport->x(), viewport->y(), viewport->width(), viewport->height() ); VL_CHECK_OGL();
+
+  // result = average * (1 - revealage) + opaque * revealage
+  glEnable( GL_BLEND ); VL_CHECK_OGL();
+  VL_glBlendFuncSeparate( GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA ); VL_CHECK_OGL();
+
+  gl_context->useGLSLProgram( mResolveProgram.get() );
+  glUniform1i( mResolveProgram->getUniformLocation("vl_OITAccumulation"), 0 ); VL_CHECK_OGL();
+  glUniform1i( mResolveProgram->getUniformLocation("vl_OITRevealage"), 1 ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE1 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, mRevealageTexture->handle() ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, mAccumulationTexture->handle() ); VL_CHECK_OGL();
+
+  glDrawArrays( GL_TRIANGLES, 0, 3 ); VL_CHECK_OGL();
+
+  // restore the default states
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE1 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_2D, 0 ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  gl_context->useGLSLProgram( NULL );
+  VL_glBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ); VL_CHECK_OGL();
+  glDisable( GL_BLEND ); VL_CHECK_OGL();
+#else
+  (void)camera;
+#endif
+}
+//-----------------------------------------------------------------------------
+void WeightedBlendedOITRenderer::releaseOpenGLResources()
+{
+  if ( mOITFramebuffer )
+  {
+    if ( mOITFramebuffer->openglContext() )
+      mOITFramebuffer->openglContext()->destroyFramebufferObject( mOITFramebuffer.get() );
+    mOITFramebuffer = NULL;
+  }
+  if ( mAccumulationTexture )
+  {
+    mAccumulationTexture->destroyTexture();
+    mAccumulationTexture = NULL;
+  }
+  if ( mRevealageTexture )
+  {
+    mRevealageTexture->destroyTexture();
+    mRevealageTexture = NULL;
+  }
+  mResolveProgram->deleteProgram();
+}
+//-----------------------------------------------------------------------------
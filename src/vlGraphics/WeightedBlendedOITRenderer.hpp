@@ -0,0 +1,163 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef WeightedBlendedOITRenderer_INCLUDE_ONCE
+#define WeightedBlendedOITRenderer_INCLUDE_ONCE
+
+#include <vlGraphics/Renderer.hpp>
+#include <vlGraphics/FramebufferObject.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vector>
+
+namespace vl
+{
+  class GLSLProgram;
+  //------------------------------------------------------------------------------
+  // WeightedBlendedOITRenderer
+  //------------------------------------------------------------------------------
+  /** Wraps a Renderer adding order independent transparency based on weighted blended OIT (McGuire and Bavoil, 2013).
+    *
+    * The opaque objects, i.e. those whose Shader does not enable EN_BLEND, are rendered by the wrapped renderer as usual.
+    * Its depth buffer is then copied into an internal framebuffer object with two floating point color attachments:
+    * the translucent objects are rendered, with depth writes disabled, accumulating their premultiplied colors in the first
+    * (\p GL_RGBA16F) and the product of their transparencies, the revealage, in the second (\p GL_R16F). Finally a full screen
+    * resolve pass composites the weighted average of the translucent colors on top of the opaque image.
+    *
+    * Since the blending is commutative no sorting of the translucent objects nor of their primitives is required: DepthSortCallback
+    * is not needed and a RenderQueueSorter ordering by state, such as RenderQueueSorterByShader, can be used instead of the standard one.
+    * The cost depends on the covered pixels rather than on the number of primitives.
+    *
+    * The translucent Shader[s] can either:
+    * - write a single non premultiplied color, like the fixed function pipeline or GLSL programs writing \p gl_FragColor: in this
+    *   case all the fragments have the same weight (setShaderWeighted(false), the default).
+    * - write to the output 0 the premultiplied color multiplied by a depth based weight and to the output 1 the alpha, like in
+    *   \p "out0 = vec4(color.rgb * color.a, color.a) * w; out1 = vec4(color.a);" where for example
+    *   \p "w = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);"
+    *   (setShaderWeighted(true)).
+    *
+    * The render states of the translucent Shader[s] are respected except for the blending function and the depth mask, which are
+    * overridden by this renderer.
+    *
+    * \note
+    * - Requires OpenGL 4.0 or OpenGL 3.2 and GL_ARB_draw_buffers_blend, otherwise it behaves like the wrapped renderer.
+    * - The depth buffer of the wrapped renderer's Framebuffer must have a \p GL_DEPTH24_STENCIL8 format in order to be copied,
+    *   which is usually the case for the default framebuffer; if it is a FramebufferObject use FBODepthStencilBufferAttachment(DSBT_DEPTH24_STENCIL8).
+    * \sa DepthSortCallback, RenderQueueSorterStandard */
+  class VLGRAPHICS_EXPORT WeightedBlendedOITRenderer: public Renderer
+  {
+    VL_INSTRUMENT_CLASS(vl::WeightedBlendedOITRenderer, Renderer)
+
+  public:
+    /** Constructor. */
+    WeightedBlendedOITRenderer();
+
+    /** Destructor. */
+    ~WeightedBlendedOITRenderer();
+
+    /** Renders the opaque objects using the wrapped renderer and the translucent ones using weighted blended OIT. */
+    virtual const RenderQueue* render(const RenderQueue* in_render_queue, Camera* camera, real frame_clock);
+
+    /** The renderer to be wrapped, used to render the opaque objects */
+    void setWrappedRenderer(Renderer* renderer) { mWrappedRenderer = renderer; }
+
+    /** The renderer to be wrapped, used to render the opaque objects */
+    const Renderer* wrappedRenderer() const { return mWrappedRenderer.get(); }
+
+    /** The renderer to be wrapped, used to render the opaque objects */
+    Renderer* wrappedRenderer() { return mWrappedRenderer.get(); }
+
+    /** Returns the wrapped Renderer's Framebuffer */
+    const Framebuffer* framebuffer() const;
+
+    /** Returns the wrapped Renderer's Framebuffer */
+    Framebuffer* framebuffer();
+
+    /** If true the translucent shaders write the weighted premultiplied color and the alpha to two outputs, see the class documentation. Defaults to false. */
+    void setShaderWeighted(bool weighted) { mShaderWeighted = weighted; }
+
+    /** If true the translucent shaders write the weighted premultiplied color and the alpha to two outputs, see the class documentation. Defaults to false. */
+    bool shaderWeighted() const { return mShaderWeighted; }
+
+    /** Returns the number of translucent objects rendered during the last frame. */
+    int statsTranslucentObjects() const { return mStatsTranslucentObjects; }
+
+    /** The texture accumulating the weighted premultiplied colors. */
+    Texture* accumulationTexture() { return mAccumulationTexture.get(); }
+
+    /** The texture accumulating the revealage, i.e. the product of the transparencies. */
+    Texture* revealageTexture() { return mRevealageTexture.get(); }
+
+    /** Releases the framebuffer object and the textures used by the OIT pass. Must be called with the OpenGL context current. */
+    void releaseOpenGLResources();
+
+  protected:
+    /** Returns true if the current OpenGL context supports the OIT pass. */
+    bool isSupported() const;
+
+    /** (Re)creates the OIT framebuffer object to match the wrapped renderer's Framebuffer dimensions. */
+    void prepareFramebuffer();
+
+    /** Overrides the blending and the depth mask of the Shader being rendered during the translucent pass. */
+    void applyOITRenderStates() const;
+
+    /** Composites the accumulated translucent colors on top of the wrapped renderer's Framebuffer. */
+    void resolve(const Camera* camera);
+
+    // applies the OIT blending after the render states of each translucent Actor
+    class OITActorCallback: public ActorEventCallback
+    {
+    public:
+      OITActorCallback(WeightedBlendedOITRenderer* owner): mOwner(owner) {}
+      virtual void onActorRenderStarted(Actor*, real, const Camera*, Renderable*, const Shader*, int) { mOwner->applyOITRenderStates(); }
+      virtual void onActorDelete(Actor*) {}
+    private:
+      WeightedBlendedOITRenderer* mOwner;
+    };
+
+  protected:
+    ref<Renderer> mWrappedRenderer;
+    ref<Renderer> mTranslucentRenderer;
+    ref<RenderQueue> mOpaqueRenderQueue;
+    ref<RenderQueue> mTranslucentRenderQueue;
+    ref<OITActorCallback> mOITActorCallback;
+    ref<FramebufferObject> mOITFramebuffer;
+    ref<Texture> mAccumulationTexture;
+    ref<Texture> mRevealageTexture;
+    ref<GLSLProgram> mResolveProgram;
+    std::vector<Actor*> mTranslucentActors;
+    int mStatsTranslucentObjects;
+    bool mShaderWeighted;
+  };
+  //------------------------------------------------------------------------------
+}
+
+#endif
@@ -30,6 +30,8 @@
 /**************************************************************************************/
 
 #include <vlGraphics/FontManager.hpp>
+#include <vlGraphics/BufferObjectPool.hpp>
+#include <vlGraphics/PrimitiveGeometryCache.hpp>
 
 using namespace vl;
 
@@ -48,4 +50,34 @@ void vl::setDefFontManager(FontManager* fm)
 {
   gDefaultFontManager = fm;
 }
+//-----------------------------------------------------------------------------
+// Default BufferObjectPool
+//-----------------------------------------------------------------------------
+namespace
+{
+  ref<BufferObjectPool> gDefaultBufferObjectPool = NULL;
+}
+BufferObjectPool* vl::defBufferObjectPool()
+{
+  return gDefaultBufferObjectPool.get();
+}
+void vl::setDefBufferObjectPool(BufferObjectPool* pool)
+{
+  gDefaultBufferObjectPool = pool;
+}
+//-----------------------------------------------------------------------------
+// Default PrimitiveGeometryCache
+//-----------------------------------------------------------------------------
+namespace
+{
+  ref<PrimitiveGeometryCache> gDefaultPrimitiveGeometryCache = NULL;
+}
+PrimitiveGeometryCache* vl::defPrimitiveGeometryCache()
+{
+  return gDefaultPrimitiveGeometryCache.get();
+}
+void vl::setDefPrimitiveGeometryCache(PrimitiveGeometryCache* cache)
+{
+  gDefaultPrimitiveGeometryCache = cache;
+}
 //------------------------------------------------------------------------------
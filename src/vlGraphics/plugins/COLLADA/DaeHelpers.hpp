@@ -220,6 +220,31 @@ namespace vl
         }
       }
 
+      //! Converts the whole source to floats at once, dataSize() floats per element, the result is computed once and cached.
+      const float* bulkData()
+      {
+        if (mBulkData.empty() && mCount && mDataSize)
+        {
+          // offsets of the fields to read within each element
+          size_t fields[32];
+          size_t field_count = 0;
+          for(size_t i=0; i<32 && i<mStride; ++i)
+            if (mFieldsMask & (1<<i))
+              fields[field_count++] = i;
+
+          mBulkData.resize(mCount * mDataSize, 0.0f);
+          if(mFloatSource && mFloatSource->getValue().getCount())
+            convertAll(&mFloatSource->getValue()[0], mFloatSource->getValue().getCount(), fields, field_count);
+          else
+          if(mIntSource && mIntSource->getValue().getCount())
+            convertAll(&mIntSource->getValue()[0], mIntSource->getValue().getCount(), fields, field_count);
+          else
+          if(mBoolSource && mBoolSource->getValue().getCount())
+            convertAll(&mBoolSource->getValue()[0], mBoolSource->getValue().getCount(), fields, field_count);
+        }
+        return mBulkData.empty() ? NULL : &mBulkData[0];
+      }
+
       //! The number of elements in the source.
       size_t count() const { return mCount; }
 
@@ -227,6 +252,22 @@ namespace vl
       size_t dataSize() const { return mDataSize; }
 
     protected:
+      template<class T>
+      void convertAll(const T* src, size_t src_count, const size_t* fields, size_t field_count)
+      {
+        float* out = &mBulkData[0];
+        for(size_t n=0, read_pos=mOffset; n<mCount; ++n, read_pos+=mStride, out+=mDataSize)
+        {
+          // elements falling outside of the array are left to zero
+          if (read_pos + (field_count ? fields[field_count-1] : 0) >= src_count)
+            break;
+          for(size_t i=0; i<field_count; ++i)
+            out[i] = (float)src[read_pos+fields[i]];
+        }
+      }
+
+    protected:
+      std::vector<float> mBulkData;
       size_t mFieldsMask;
       size_t mDataSize;
       domFloat_arrayRef mFloatSource;
@@ -279,6 +320,72 @@ namespace vl
       std::vector< ref<Dae::Primitive> > mPrimitives;
     };
     //-----------------------------------------------------------------------------
+    //! Triangles sharing the same material and inputs collected by the fast import path: each distinct
+    //! combination of attribute indices becomes one vertex. See LoadWriterDae::LoadOptions::setFastImport().
+    struct TriangleBatch: public Object
+    {
+      TriangleBatch()
+      {
+        mVertexCount = 0;
+      }
+
+      //! Returns the index of the vertex made of the given attribute indices (one per channel), adding it if new.
+      GLuint vertex(const size_t* attribs)
+      {
+        const size_t channels = mChannels.size();
+        if ( (mVertexCount + 1) * 2 > mSlots.size() )
+          rehash( mSlots.empty() ? 1024 : mSlots.size() * 2 );
+        const size_t mask = mSlots.size() - 1;
+        for(size_t slot = hash(attribs) & mask; ; slot = (slot + 1) & mask)
+        {
+          GLuint v = mSlots[slot];
+          if (v == 0)
+          {
+            mSlots[slot] = (GLuint)++mVertexCount;
+            mAttribs.insert(mAttribs.end(), attribs, attribs + channels);
+            return (GLuint)(mVertexCount - 1);
+          }
+          if ( memcmp(&mAttribs[(v-1) * channels], attribs, channels * sizeof(size_t)) == 0 )
+            return v - 1;
+        }
+      }
+
+      //! The number of distinct vertices.
+      size_t vertexCount() const { return mVertexCount; }
+
+    protected:
+      size_t hash(const size_t* attribs) const
+      {
+        size_t h = 2166136261u;
+        for(size_t i=0; i<mChannels.size(); ++i)
+          h = (h ^ attribs[i]) * 16777619u;
+        return h ^ (h >> 15);
+      }
+
+      void rehash(size_t size)
+      {
+        mSlots.assign(size, 0);
+        const size_t mask = size - 1;
+        for(size_t v=0; v<mVertexCount; ++v)
+        {
+          size_t slot = hash(&mAttribs[v * mChannels.size()]) & mask;
+          while(mSlots[slot])
+            slot = (slot + 1) & mask;
+          mSlots[slot] = (GLuint)(v + 1);
+        }
+      }
+
+    public:
+      std::string mMaterial;
+      std::vector< ref<Dae::Input> > mChannels;
+      std::vector<size_t> mAttribs;   // mChannels.size() attribute indices per vertex
+      std::vector<GLuint> mIndices;   // triangle list
+
+    protected:
+      std::vector<GLuint> mSlots;     // open addressing table storing vertex index + 1
+      size_t mVertexCount;
+    };
+    //-----------------------------------------------------------------------------
     //! COLLADA node
     struct Node: public Object
     {
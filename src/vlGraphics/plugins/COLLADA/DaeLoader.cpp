@@ -72,6 +72,30 @@ namespace
       { Dae::IS_WEIGHT,          "WEIGHT"          },
       { Dae::IS_UNKNOWN,          NULL             }
     };
+  //-----------------------------------------------------------------------------
+  size_t hashArray(size_t h, const ArrayAbstract* arr)
+  {
+    if (!arr)
+      return h * 16777619u;
+    h = (h ^ arr->glSize()) * 16777619u;
+    const unsigned char* ptr = arr->ptr();
+    for(size_t i=0; i<arr->bytesUsed(); ++i)
+      h = (h ^ ptr[i]) * 16777619u;
+    return h;
+  }
+  //-----------------------------------------------------------------------------
+  bool sameArray(const ArrayAbstract* a, const ArrayAbstract* b)
+  {
+    if (!a || !b)
+      return a == b;
+    return a->glSize() == b->glSize() && a->bytesUsed() == b->bytesUsed() && memcmp(a->ptr(), b->ptr(), a->bytesUsed()) == 0;
+  }
+  //-----------------------------------------------------------------------------
+  template<class T>
+  void appendBytes(std::string& str, const T& value)
+  {
+    str.append( (const char*)&value, sizeof(T) );
+  }
 }
 //-----------------------------------------------------------------------------
 DaeLoader::DaeLoader()
@@ -190,142 +214,150 @@ ref<Dae::Mesh> DaeLoader::parseGeometry(daeElement* geometry)
   // one single set of vertex attribute array for each input semantic and recycle it if possible.
   // Unfortunately COLLADA makes this trivial task impossible to achieve.
 
-  // --- ---- triangles ---- ---
-  domTriangles_Array triangles_arr = mesh->getTriangles_array();
-  for(size_t itri=0; itri< triangles_arr.getCount(); ++itri)
+  if ( loadOptions()->fastImport() )
   {
-    domTrianglesRef triangles = triangles_arr.get(itri);
+    // triangles, fans, strips, polygons and polylists become one triangle list per material
+    parseTrianglesFast( mesh, dae_mesh.get(), geometry->getAttribute("id").c_str() );
+  }
+  else
+  {
+    // --- ---- triangles ---- ---
+    domTriangles_Array triangles_arr = mesh->getTriangles_array();
+    for(size_t itri=0; itri< triangles_arr.getCount(); ++itri)
+    {
+      domTrianglesRef triangles = triangles_arr.get(itri);
 
-    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
-    dae_mesh->mPrimitives.push_back(dae_primitive);
-    dae_primitive->mType = Dae::PT_TRIANGLES;
-    dae_primitive->mCount = (size_t)triangles->getCount();
+      ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+      dae_mesh->mPrimitives.push_back(dae_primitive);
+      dae_primitive->mType = Dae::PT_TRIANGLES;
+      dae_primitive->mCount = (size_t)triangles->getCount();
 
-    // --- input ---
-    domInputLocalOffset_Array input_arr = triangles->getInput_array();
-    parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
+      // --- input ---
+      domInputLocalOffset_Array input_arr = triangles->getInput_array();
+      parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
 
-    // --- ---- p ---- ---
-    dae_primitive->mP.push_back( triangles->getP() );
+      // --- ---- p ---- ---
+      dae_primitive->mP.push_back( triangles->getP() );
 
-    // --- ---- material ---- ---
-    dae_primitive->mMaterial = triangles->getMaterial() ? triangles->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      // --- ---- material ---- ---
+      dae_primitive->mMaterial = triangles->getMaterial() ? triangles->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
 
-    // --- ---- generates the geometry ---- ---
-    generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
-  }
+      // --- ---- generates the geometry ---- ---
+      generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+    }
 
-  // --- ---- triangles fan ---- ---
-  domTrifans_Array trifan_arr = mesh->getTrifans_array();
-  for(size_t itri=0; itri< trifan_arr.getCount(); ++itri)
-  {
-    domTrifansRef trifan = trifan_arr.get(itri);
+    // --- ---- triangles fan ---- ---
+    domTrifans_Array trifan_arr = mesh->getTrifans_array();
+    for(size_t itri=0; itri< trifan_arr.getCount(); ++itri)
+    {
+      domTrifansRef trifan = trifan_arr.get(itri);
 
-    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
-    dae_mesh->mPrimitives.push_back(dae_primitive);
-    dae_primitive->mType = Dae::PT_TRIFANS;
-    dae_primitive->mCount = (size_t)trifan->getCount();
+      ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+      dae_mesh->mPrimitives.push_back(dae_primitive);
+      dae_primitive->mType = Dae::PT_TRIFANS;
+      dae_primitive->mCount = (size_t)trifan->getCount();
 
-    // --- input ---
-    domInputLocalOffset_Array input_arr = trifan->getInput_array();
-    parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
+      // --- input ---
+      domInputLocalOffset_Array input_arr = trifan->getInput_array();
+      parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
 
-    // --- ---- p ---- ---
-    for(size_t ip=0; ip<trifan->getP_array().getCount(); ++ip)
-      dae_primitive->mP.push_back( trifan->getP_array().get(ip) );
+      // --- ---- p ---- ---
+      for(size_t ip=0; ip<trifan->getP_array().getCount(); ++ip)
+        dae_primitive->mP.push_back( trifan->getP_array().get(ip) );
 
-    // --- ---- material ---- ---
-    dae_primitive->mMaterial = trifan->getMaterial() ? trifan->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      // --- ---- material ---- ---
+      dae_primitive->mMaterial = trifan->getMaterial() ? trifan->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
 
-    // --- ---- generates the geometry ---- ---
-    generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
-  }
+      // --- ---- generates the geometry ---- ---
+      generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+    }
 
-  // --- ---- triangle strip ---- ---
-  domTristrips_Array tristrip_arr = mesh->getTristrips_array();
-  for(size_t itri=0; itri< tristrip_arr.getCount(); ++itri)
-  {
-    domTristripsRef tristrip = tristrip_arr.get(itri);
+    // --- ---- triangle strip ---- ---
+    domTristrips_Array tristrip_arr = mesh->getTristrips_array();
+    for(size_t itri=0; itri< tristrip_arr.getCount(); ++itri)
+    {
+      domTristripsRef tristrip = tristrip_arr.get(itri);
 
-    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
-    dae_mesh->mPrimitives.push_back(dae_primitive);
-    dae_primitive->mType = Dae::PT_TRISTRIPS;
-    dae_primitive->mCount = (size_t)tristrip->getCount();
+      ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+      dae_mesh->mPrimitives.push_back(dae_primitive);
+      dae_primitive->mType = Dae::PT_TRISTRIPS;
+      dae_primitive->mCount = (size_t)tristrip->getCount();
 
-    // --- input ---
-    domInputLocalOffset_Array input_arr = tristrip->getInput_array();
-    parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
+      // --- input ---
+      domInputLocalOffset_Array input_arr = tristrip->getInput_array();
+      parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
 
-    // --- ---- p ---- ---
-    for(size_t ip=0; ip<tristrip->getP_array().getCount(); ++ip)
-      dae_primitive->mP.push_back( tristrip->getP_array().get(ip) );
+      // --- ---- p ---- ---
+      for(size_t ip=0; ip<tristrip->getP_array().getCount(); ++ip)
+        dae_primitive->mP.push_back( tristrip->getP_array().get(ip) );
 
-    // --- ---- material ---- ---
-    dae_primitive->mMaterial = tristrip->getMaterial() ? tristrip->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      // --- ---- material ---- ---
+      dae_primitive->mMaterial = tristrip->getMaterial() ? tristrip->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
 
-    // --- ---- generates the geometry ---- ---
-    generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
-  }
+      // --- ---- generates the geometry ---- ---
+      generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+    }
 
-  // --- ---- polygons ---- ---
-  domPolygons_Array polygon_arr = mesh->getPolygons_array();
-  for(size_t itri=0; itri< polygon_arr.getCount(); ++itri)
-  {
-    domPolygonsRef polygon = polygon_arr.get(itri);
+    // --- ---- polygons ---- ---
+    domPolygons_Array polygon_arr = mesh->getPolygons_array();
+    for(size_t itri=0; itri< polygon_arr.getCount(); ++itri)
+    {
+      domPolygonsRef polygon = polygon_arr.get(itri);
 
-    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
-    dae_mesh->mPrimitives.push_back(dae_primitive);
-    dae_primitive->mType = Dae::PT_POLYGONS;
-    dae_primitive->mCount = (size_t)polygon->getCount();
+      ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+      dae_mesh->mPrimitives.push_back(dae_primitive);
+      dae_primitive->mType = Dae::PT_POLYGONS;
+      dae_primitive->mCount = (size_t)polygon->getCount();
 
-    // --- input ---
-    domInputLocalOffset_Array input_arr = polygon->getInput_array();
-    parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
+      // --- input ---
+      domInputLocalOffset_Array input_arr = polygon->getInput_array();
+      parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
 
-    // --- ---- p ---- ---
-    for(size_t ip=0; ip<polygon->getP_array().getCount(); ++ip)
-      dae_primitive->mP.push_back( polygon->getP_array().get(ip) );
+      // --- ---- p ---- ---
+      for(size_t ip=0; ip<polygon->getP_array().getCount(); ++ip)
+        dae_primitive->mP.push_back( polygon->getP_array().get(ip) );
 
-    // --- ---- material ---- ---
-    dae_primitive->mMaterial = polygon->getMaterial() ? polygon->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      // --- ---- material ---- ---
+      dae_primitive->mMaterial = polygon->getMaterial() ? polygon->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
 
-    // --- ---- generates the geometry ---- ---
-    generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
-  }
+      // --- ---- generates the geometry ---- ---
+      generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+    }
 
-  // --- ---- polylists ---- ---
-  domPolylist_Array polylist_arr = mesh->getPolylist_array();
-  for(size_t itri=0; itri< polylist_arr.getCount(); ++itri)
-  {
-    domPolylistRef polylist = polylist_arr.get(itri);
+    // --- ---- polylists ---- ---
+    domPolylist_Array polylist_arr = mesh->getPolylist_array();
+    for(size_t itri=0; itri< polylist_arr.getCount(); ++itri)
+    {
+      domPolylistRef polylist = polylist_arr.get(itri);
 
-    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
-    dae_mesh->mPrimitives.push_back(dae_primitive);
-    dae_primitive->mType = Dae::PT_POLYGONS;
-    dae_primitive->mCount = (size_t)polylist->getVcount()->getValue().getCount();
+      ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+      dae_mesh->mPrimitives.push_back(dae_primitive);
+      dae_primitive->mType = Dae::PT_POLYGONS;
+      dae_primitive->mCount = (size_t)polylist->getVcount()->getValue().getCount();
 
-    // --- input ---
-    domInputLocalOffset_Array input_arr = polylist->getInput_array();
-    parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
+      // --- input ---
+      domInputLocalOffset_Array input_arr = polylist->getInput_array();
+      parseInputs(dae_primitive.get(), input_arr, dae_mesh->mVertexInputs);
 
-    // --- ---- p ---- ---
-    size_t ip=0;
-    for(size_t ivc=0; ivc<polylist->getVcount()->getValue().getCount(); ++ivc)
-    {
-      domPRef p = static_cast<domP*>(domP::create(mDAE).cast());
-      VL_CHECK(p->typeID() == domP::ID());
-      dae_primitive->mP.push_back( p );
-      size_t vcount = (size_t)polylist->getVcount()->getValue()[ivc];
-      p->getValue().setCount(vcount * dae_primitive->mIndexStride);
-      for(size_t i=0; i<p->getValue().getCount(); ++i)
-        p->getValue().set(i, polylist->getP()->getValue()[ip++]);
-    }
+      // --- ---- p ---- ---
+      size_t ip=0;
+      for(size_t ivc=0; ivc<polylist->getVcount()->getValue().getCount(); ++ivc)
+      {
+        domPRef p = static_cast<domP*>(domP::create(mDAE).cast());
+        VL_CHECK(p->typeID() == domP::ID());
+        dae_primitive->mP.push_back( p );
+        size_t vcount = (size_t)polylist->getVcount()->getValue()[ivc];
+        p->getValue().setCount(vcount * dae_primitive->mIndexStride);
+        for(size_t i=0; i<p->getValue().getCount(); ++i)
+          p->getValue().set(i, polylist->getP()->getValue()[ip++]);
+      }
 
-    // --- ---- material ---- ---
-    dae_primitive->mMaterial = polylist->getMaterial() ? polylist->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      // --- ---- material ---- ---
+      dae_primitive->mMaterial = polylist->getMaterial() ? polylist->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
 
-    // --- ---- generates the geometry ---- ---
-    generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+      // --- ---- generates the geometry ---- ---
+      generateGeometry( dae_primitive.get(), geometry->getAttribute("id").c_str() );
+    }
   }
 
   // --- ---- linestrips ---- ---
@@ -382,6 +414,218 @@ ref<Dae::Mesh> DaeLoader::parseGeometry(daeElement* geometry)
   return dae_mesh;
 }
 //-----------------------------------------------------------------------------
+Dae::TriangleBatch* DaeLoader::triangleBatch(std::vector< ref<Dae::TriangleBatch> >& batches, const Dae::Primitive* dae_primitive)
+{
+  size_t channels = dae_primitive->mChannels.size();
+  if (!channels)
+    return NULL;
+  if (channels > (size_t)Dae::Vert::MAX_ATTRIBS)
+  {
+    Log::warning( Say("LoadWriterDae: only the first %n inputs of a primitive are imported.\n") << Dae::Vert::MAX_ATTRIBS );
+    channels = Dae::Vert::MAX_ATTRIBS;
+  }
+
+  // primitives with the same material and the same inputs go in the same batch, the offsets may differ
+  for(size_t i=0; i<batches.size(); ++i)
+  {
+    Dae::TriangleBatch* batch = batches[i].get();
+    if (batch->mMaterial != dae_primitive->mMaterial || batch->mChannels.size() != channels)
+      continue;
+    bool same = true;
+    for(size_t ich=0; ich<channels && same; ++ich)
+    {
+      const Dae::Input* a = batch->mChannels[ich].get();
+      const Dae::Input* b = dae_primitive->mChannels[ich].get();
+      same = a->mSemantic == b->mSemantic && a->mSource == b->mSource && a->mSet == b->mSet;
+    }
+    if (same)
+      return batch;
+  }
+
+  ref<Dae::TriangleBatch> batch = new Dae::TriangleBatch;
+  batch->mMaterial = dae_primitive->mMaterial;
+  batch->mChannels.assign( dae_primitive->mChannels.begin(), dae_primitive->mChannels.begin() + channels );
+  batches.push_back(batch);
+  return batch.get();
+}
+//-----------------------------------------------------------------------------
+void DaeLoader::addCorners(Dae::TriangleBatch* batch, const Dae::Primitive* dae_primitive, const domListOfUInts& p, size_t first, size_t count, std::vector<GLuint>& out)
+{
+  out.resize(count);
+  size_t attribs[Dae::Vert::MAX_ATTRIBS];
+  const size_t channels = batch->mChannels.size();
+  for(size_t i=0, pos=first*dae_primitive->mIndexStride; i<count; ++i, pos+=dae_primitive->mIndexStride)
+  {
+    for(size_t ich=0; ich<channels; ++ich)
+      attribs[ich] = (size_t)p[pos + dae_primitive->mChannels[ich]->mOffset];
+    out[i] = batch->vertex(attribs);
+  }
+}
+//-----------------------------------------------------------------------------
+void DaeLoader::parseTrianglesFast(domMesh* mesh, Dae::Mesh* dae_mesh, const char* name)
+{
+  std::vector< ref<Dae::TriangleBatch> > batches;
+  std::vector<GLuint> poly;
+
+  // --- ---- triangles ---- ---
+  domTriangles_Array triangles_arr = mesh->getTriangles_array();
+  for(size_t itri=0; itri< triangles_arr.getCount(); ++itri)
+  {
+    domTrianglesRef triangles = triangles_arr.get(itri);
+
+    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+    parseInputs(dae_primitive.get(), triangles->getInput_array(), dae_mesh->mVertexInputs);
+    dae_primitive->mMaterial = triangles->getMaterial() ? triangles->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+    Dae::TriangleBatch* batch = triangleBatch(batches, dae_primitive.get());
+    if (!batch || !triangles->getP())
+      continue;
+
+    const domListOfUInts& p = triangles->getP()->getValue();
+    size_t corners = std::min( (size_t)triangles->getCount() * 3, (size_t)p.getCount() / dae_primitive->mIndexStride );
+    addCorners(batch, dae_primitive.get(), p, 0, corners - corners % 3, poly);
+    batch->mIndices.insert( batch->mIndices.end(), poly.begin(), poly.end() );
+  }
+
+  // --- ---- polylists ---- ---
+  domPolylist_Array polylist_arr = mesh->getPolylist_array();
+  for(size_t itri=0; itri< polylist_arr.getCount(); ++itri)
+  {
+    domPolylistRef polylist = polylist_arr.get(itri);
+
+    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+    parseInputs(dae_primitive.get(), polylist->getInput_array(), dae_mesh->mVertexInputs);
+    dae_primitive->mMaterial = polylist->getMaterial() ? polylist->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+    Dae::TriangleBatch* batch = triangleBatch(batches, dae_primitive.get());
+    if (!batch || !polylist->getP() || !polylist->getVcount())
+      continue;
+
+    // the polygons are read in place from <p> instead of being copied into one <p> each
+    const domListOfUInts& p = polylist->getP()->getValue();
+    const domListOfUInts& vcount = polylist->getVcount()->getValue();
+    const size_t total_corners = (size_t)p.getCount() / dae_primitive->mIndexStride;
+    for(size_t ivc=0, first=0; ivc<vcount.getCount(); ++ivc)
+    {
+      size_t count = (size_t)vcount[ivc];
+      if (first + count > total_corners)
+        break;
+      addCorners(batch, dae_primitive.get(), p, first, count, poly);
+      for(size_t i=1; i+1<count; ++i)
+      {
+        batch->mIndices.push_back(poly[0]);
+        batch->mIndices.push_back(poly[i]);
+        batch->mIndices.push_back(poly[i+1]);
+      }
+      first += count;
+    }
+  }
+
+  // --- ---- polygons and triangle fans: one <p> per polygon ---- ---
+  domPolygons_Array polygon_arr = mesh->getPolygons_array();
+  domTrifans_Array trifan_arr = mesh->getTrifans_array();
+  for(size_t itri=0; itri< polygon_arr.getCount() + trifan_arr.getCount(); ++itri)
+  {
+    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+    domP_Array* p_array = NULL;
+    if (itri < polygon_arr.getCount())
+    {
+      domPolygonsRef polygon = polygon_arr.get(itri);
+      parseInputs(dae_primitive.get(), polygon->getInput_array(), dae_mesh->mVertexInputs);
+      dae_primitive->mMaterial = polygon->getMaterial() ? polygon->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      p_array = &polygon->getP_array();
+    }
+    else
+    {
+      domTrifansRef trifan = trifan_arr.get(itri - polygon_arr.getCount());
+      parseInputs(dae_primitive.get(), trifan->getInput_array(), dae_mesh->mVertexInputs);
+      dae_primitive->mMaterial = trifan->getMaterial() ? trifan->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+      p_array = &trifan->getP_array();
+    }
+    Dae::TriangleBatch* batch = triangleBatch(batches, dae_primitive.get());
+    if (!batch)
+      continue;
+
+    for(size_t ip=0; ip<p_array->getCount(); ++ip)
+    {
+      const domListOfUInts& p = p_array->get(ip)->getValue();
+      addCorners(batch, dae_primitive.get(), p, 0, (size_t)p.getCount() / dae_primitive->mIndexStride, poly);
+      for(size_t i=1; i+1<poly.size(); ++i)
+      {
+        batch->mIndices.push_back(poly[0]);
+        batch->mIndices.push_back(poly[i]);
+        batch->mIndices.push_back(poly[i+1]);
+      }
+    }
+  }
+
+  // --- ---- triangle strips ---- ---
+  domTristrips_Array tristrip_arr = mesh->getTristrips_array();
+  for(size_t itri=0; itri< tristrip_arr.getCount(); ++itri)
+  {
+    domTristripsRef tristrip = tristrip_arr.get(itri);
+
+    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+    parseInputs(dae_primitive.get(), tristrip->getInput_array(), dae_mesh->mVertexInputs);
+    dae_primitive->mMaterial = tristrip->getMaterial() ? tristrip->getMaterial() : VL_NO_MATERIAL_SPECIFIED;
+    Dae::TriangleBatch* batch = triangleBatch(batches, dae_primitive.get());
+    if (!batch)
+      continue;
+
+    for(size_t ip=0; ip<tristrip->getP_array().getCount(); ++ip)
+    {
+      const domListOfUInts& p = tristrip->getP_array().get(ip)->getValue();
+      addCorners(batch, dae_primitive.get(), p, 0, (size_t)p.getCount() / dae_primitive->mIndexStride, poly);
+      // odd triangles are flipped to keep the strip winding
+      for(size_t i=0; i+2<poly.size(); ++i)
+      {
+        batch->mIndices.push_back(poly[i + (i & 1)]);
+        batch->mIndices.push_back(poly[i + 1 - (i & 1)]);
+        batch->mIndices.push_back(poly[i+2]);
+      }
+    }
+  }
+
+  // --- ---- one Geometry with one draw call per batch ---- ---
+  for(size_t i=0; i<batches.size(); ++i)
+  {
+    if (batches[i]->mIndices.empty())
+      continue;
+
+    ref<Dae::Primitive> dae_primitive = new Dae::Primitive;
+    dae_primitive->mType = Dae::PT_TRIANGLES;
+    dae_primitive->mMaterial = batches[i]->mMaterial;
+    dae_primitive->mChannels = batches[i]->mChannels;
+    dae_primitive->mCount = batches[i]->mIndices.size() / 3;
+    ref<Geometry> geom = generateGeometry( batches[i].get(), name );
+    dae_primitive->mGeometry = shareGeometry( geom.get() );
+    dae_mesh->mPrimitives.push_back(dae_primitive);
+  }
+}
+//-----------------------------------------------------------------------------
+Geometry* DaeLoader::shareGeometry(Geometry* geom)
+{
+  // hash all the vertex attributes and indices
+  size_t h = 2166136261u;
+  for(int i=0; i<VA_MaxAttribCount; ++i)
+    h = hashArray( h, geom->vertexAttribArray(i) );
+  DrawElementsUInt* de = geom->drawCalls().at(0)->as<DrawElementsUInt>();
+  h = hashArray( h, de->indexBuffer() );
+
+  // reuse a Geometry with the same content if any
+  std::pair< std::multimap< size_t, ref<Geometry> >::iterator, std::multimap< size_t, ref<Geometry> >::iterator > range = mSharedGeometries.equal_range(h);
+  for(std::multimap< size_t, ref<Geometry> >::iterator it = range.first; it != range.second; ++it)
+  {
+    Geometry* other = it->second.get();
+    bool same = sameArray( de->indexBuffer(), other->drawCalls().at(0)->as<DrawElementsUInt>()->indexBuffer() );
+    for(int i=0; i<VA_MaxAttribCount && same; ++i)
+      same = sameArray( geom->vertexAttribArray(i), other->vertexAttribArray(i) );
+    if (same)
+      return other;
+  }
+
+  mSharedGeometries.insert( std::make_pair(h, geom) );
+  return geom;
+}
+//-----------------------------------------------------------------------------
 Dae::Source* DaeLoader::getSource(daeElement* source_el)
 {
   std::map< daeElementRef, ref<Dae::Source> >::iterator it = mSources.find(source_el);
@@ -524,6 +768,33 @@ ref<Effect> DaeLoader::setup_vl_Effect( Dae::Material* mat )
   return fx;
 }
 //-----------------------------------------------------------------------------
+ref<Effect> DaeLoader::sharedEffect( Dae::Material* mat )
+{
+  // materials with the same parameters share the same Effect
+  const std::string& name = mat->mDaeEffect->objectName();
+  std::string signature = name.substr( 0, name.find(':') + 1 ); // "blinn:", "phong:" etc. or empty
+  Dae::TechniqueCOMMON* common_tech = mat->mDaeEffect->mDaeTechniqueCOMMON.get();
+  if (common_tech)
+  {
+    appendBytes( signature, common_tech->mOpaqueMode );
+    appendBytes( signature, common_tech->mEmission.mColor );
+    appendBytes( signature, common_tech->mAmbient.mColor );
+    appendBytes( signature, common_tech->mDiffuse.mColor );
+    appendBytes( signature, common_tech->mSpecular.mColor );
+    appendBytes( signature, common_tech->mTransparent.mColor );
+    appendBytes( signature, common_tech->mShininess );
+    appendBytes( signature, common_tech->mTransparency );
+    appendBytes( signature, common_tech->mEmission.mSampler.get() );
+    appendBytes( signature, common_tech->mDiffuse.mSampler.get() );
+    appendBytes( signature, common_tech->mTransparent.mSampler.get() );
+  }
+
+  ref<Effect>& fx = mSharedEffects[signature];
+  if (!fx)
+    fx = setup_vl_Effect(mat);
+  return fx;
+}
+//-----------------------------------------------------------------------------
 void DaeLoader::bindMaterials(Dae::Node* dae_node, Dae::Mesh* dae_mesh, domBind_materialRef bind_material)
 {
   // map symbols to actual materials
@@ -580,7 +851,7 @@ void DaeLoader::bindMaterials(Dae::Node* dae_node, Dae::Mesh* dae_mesh, domBind_
       }
     }
 
-    ref<Effect> fx = dae_material ? setup_vl_Effect(dae_material.get()) : mDefaultFX;
+    ref<Effect> fx = !dae_material ? mDefaultFX : ( loadOptions()->fastImport() ? sharedEffect(dae_material.get()) : setup_vl_Effect(dae_material.get()) );
 
     ref<Actor> actor = new Actor( dae_mesh->mPrimitives[iprim]->mGeometry.get(), fx.get(), dae_node->mTransform.get() );
     dae_node->mActors.push_back( actor );
@@ -782,6 +1053,7 @@ bool DaeLoader::load(VirtualFile* file)
   setupLights();
 
   // return the Actors
+  std::map< Effect*, ref<Effect> > lit_effects;
   for( size_t inode=0; inode<mNodes.size(); ++inode )
   {
     for(size_t i=0; i<mNodes[inode]->mActors.size(); ++i)
@@ -796,7 +1068,8 @@ bool DaeLoader::load(VirtualFile* file)
         actor->transform()->removeFromParent();
 
       // *** merge draw calls ***
-      if (loadOptions()->mergeDrawCalls())
+      // the fast import already generates one triangle draw call per material
+      if (loadOptions()->mergeDrawCalls() && !loadOptions()->fastImport())
       {
         Geometry* geom = actor->lod(0)->as<Geometry>();
         if (geom)
@@ -815,36 +1088,40 @@ bool DaeLoader::load(VirtualFile* file)
         }
       }
 
-      // *** check for transforms that require normal rescaling ***
-      mat4 nmatrix = actor->transform()->worldMatrix().as3x3().invert().transpose();
-      real len_x = nmatrix.getX().length();
-      real len_y = nmatrix.getY().length();
-      real len_z = nmatrix.getZ().length();
-      if ( fabs(len_x - 1) > 0.05f || fabs(len_y - 1) > 0.05f || fabs(len_z - 1) > 0.05f )
-      {
-        // Log::warning("Detected mesh with scaled transform: enabled normal renormalization.\n");
-        if ( actor->effect()->shader()->isEnabled(vl::EN_LIGHTING) )
-          actor->effect()->shader()->enable(vl::EN_NORMALIZE); // or vl::EN_RESCALE_NORMAL
-      }
-
       // *** light association & normal computation (only if lighting is on!) ***
       if ( actor->effect()->shader()->isEnabled(EN_LIGHTING) )
       {
         // *** light association ***
-        // crete new effect/shader with it's own light set
-        ref<Effect> fx = new Effect;
-        fx->setObjectName( actor->effect()->objectName().c_str() );
-        fx->shader()->setEnableSet( actor->effect()->shader()->getEnableSet() );
-        fx->shader()->setRenderStateSet( actor->effect()->shader()->getRenderStateSet() );
+        // crete new effect/shader with it's own light set, the fast import creates it once per source effect
+        ref<Effect>& fx = lit_effects[ actor->effect() ];
+        if ( !fx || !loadOptions()->fastImport() )
+        {
+          fx = new Effect;
+          fx->setObjectName( actor->effect()->objectName().c_str() );
+          fx->shader()->setEnableSet( actor->effect()->shader()->getEnableSet() );
+          fx->shader()->setRenderStateSet( actor->effect()->shader()->getRenderStateSet() );
+          for(size_t ilight=0; ilight<mLights.size() && ilight<8; ++ilight)
+            fx->shader()->setRenderState( mLights[ilight].get(), ilight );
+        }
         actor->setEffect( fx.get() );
-        for(size_t ilight=0; ilight<mLights.size() && ilight<8; ++ilight)
-          fx->shader()->setRenderState( mLights[ilight].get(), ilight );
 
        // *** compute missing normals ***
         Geometry* geom = actor->lod(0)->as<Geometry>();
        if ( loadOptions()->computeMissingNormals() && geom && !geom->normalArray() )
          geom->computeNormals();
       }
+
+      // *** check for transforms that require normal rescaling ***
+      mat4 nmatrix = actor->transform()->worldMatrix().as3x3().invert().transpose();
+      real len_x = nmatrix.getX().length();
+      real len_y = nmatrix.getY().length();
+      real len_z = nmatrix.getZ().length();
+      if ( fabs(len_x - 1) > 0.05f || fabs(len_y - 1) > 0.05f || fabs(len_z - 1) > 0.05f )
+      {
+        // Log::warning("Detected mesh with scaled transform: enabled normal renormalization.\n");
+        if ( actor->effect()->shader()->isEnabled(vl::EN_LIGHTING) )
+          actor->effect()->shader()->enable(vl::EN_NORMALIZE); // or vl::EN_RESCALE_NORMAL
+      }
     }
   }
 
@@ -911,19 +1188,26 @@ void DaeLoader::loadImages(const domImage_Array& images)
 {
   for(size_t i=0; i<images.getCount(); ++i)
   {
-    if ( strstr( images[i]->getInit_from()->getValue().getProtocol(), "file") == 0 )
-    {
-      Log::error( Say("LoadWriterDae: protocol not supported: %s\n") << images[i]->getInit_from()->getValue().getURI() );
-      continue;
-    }
-
-    std::string full_path = percentDecode( images[i]->getInit_from()->getValue().getURI() + 6 );
-    ref<Image> image = loadImage( full_path.c_str() );
-
-    mImages[ images[i].cast() ] = image;
+    // the fast import loads only the images referenced by a <surface>, see parseEffects()
+    if ( loadOptions()->fastImport() )
+      mPendingImages.insert( images[i].cast() );
+    else
+      mImages[ images[i].cast() ] = loadDaeImage( images[i].cast() );
   }
 }
 //-----------------------------------------------------------------------------
+ref<Image> DaeLoader::loadDaeImage(domImage* image)
+{
+  if ( strstr( image->getInit_from()->getValue().getProtocol(), "file") == 0 )
+  {
+    Log::error( Say("LoadWriterDae: protocol not supported: %s\n") << image->getInit_from()->getValue().getURI() );
+    return NULL;
+  }
+
+  std::string full_path = percentDecode( image->getInit_from()->getValue().getURI() + 6 );
+  return loadImage( full_path.c_str() );
+}
+//-----------------------------------------------------------------------------
 void DaeLoader::parseImages(daeElement* library)
 {
   if (!library)
@@ -997,6 +1281,13 @@ void DaeLoader::parseEffects(daeElement* library)
             if (it != mImages.end())
               dae_newparam->mDaeSurface->mImage = it->second.get();
             else
+            if ( mPendingImages.count( ref_image ) )
+            {
+              // fast import: the image is loaded the first time it's referenced
+              mImages[ ref_image ] = dae_newparam->mDaeSurface->mImage = loadDaeImage( static_cast<domImage*>(ref_image) );
+              mPendingImages.erase( ref_image );
+            }
+            else
             {
               VL_LOG_DEBUG << "- 'mImages.find( ref_image )' FAILED: " << __FILE__ << ":" << __LINE__ << "\n";
               continue;
@@ -1822,51 +2113,127 @@ void DaeLoader::generateGeometry(Dae::Primitive* prim, const char* name)
 
   // --- fix bad normals ---
   if ( loadOptions()->fixBadNormals() && prim->mGeometry->normalArray() )
+    fixNormals( prim->mGeometry.get() );
+
+   // disabled: we transform the root matrix instead
+   // --- orient geometry based on up vector ---
+   // prim->mGeometry->transform((mat4)mUpMatrix);
+}
+//-----------------------------------------------------------------------------
+ref<Geometry> DaeLoader::generateGeometry(Dae::TriangleBatch* batch, const char* name)
+{
+  ref<Geometry> geom = new Geometry;
+  if (name)
+    geom->setObjectName(name);
+
+  // single triangle list draw call
+  ref<ArrayUInt1> index_buffer = new ArrayUInt1;
+  index_buffer->resize( batch->mIndices.size() );
+  memcpy( index_buffer->ptr(), &batch->mIndices[0], batch->mIndices.size() * sizeof(GLuint) );
+  ref<DrawElementsUInt> de = new DrawElementsUInt( PT_TRIANGLES );
+  de->setIndexBuffer( index_buffer.get() );
+  geom->drawCalls().push_back( de.get() );
+
+  // vertex attributes are copied from the bulk converted sources
+  size_t tex_unit = 0;
+  const size_t channels = batch->mChannels.size();
+  for( size_t ich=0; ich<channels; ++ich )
   {
-    ref<ArrayFloat3> norm_old = vl::cast<ArrayFloat3>(prim->mGeometry->normalArray());
-    VL_CHECK(norm_old);
+    Dae::Source* source = batch->mChannels[ich]->mSource.get();
+    const size_t data_size = source->dataSize();
+
+    ref<ArrayAbstract> vert_attrib;
+    switch(data_size)
+    {
+      case 1: vert_attrib = new ArrayFloat1; break;
+      case 2: vert_attrib = new ArrayFloat2; break;
+      case 3: vert_attrib = new ArrayFloat3; break;
+      case 4: vert_attrib = new ArrayFloat4; break;
+      default:
+        Log::warning( Say("LoadWriterDae: input '%s' skipped because parameter count is more than 4.\n") << getSemanticString(batch->mChannels[ich]->mSemantic) );
+        continue;
+    }
 
-    // recompute normals
-    prim->mGeometry->computeNormals();
-    ref<ArrayFloat3> norm_new = vl::cast<ArrayFloat3>(prim->mGeometry->normalArray());
-    VL_CHECK(norm_new);
+    // install vertex attribute
+    switch(batch->mChannels[ich]->mSemantic)
+    {
+    case Dae::IS_POSITION: geom->setVertexArray( vert_attrib.get() ); break;
+    case Dae::IS_NORMAL:   geom->setNormalArray( vert_attrib.get() ); break;
+    case Dae::IS_COLOR:    geom->setColorArray( vert_attrib.get() ); break;
+    case Dae::IS_TEXCOORD: geom->setTexCoordArray( tex_unit++, vert_attrib.get() ); break;
+    default:
+      VL_LOG_DEBUG << ( Say("- LoadWriterDae: input semantic '%s' not supported.\n") << getSemanticString(batch->mChannels[ich]->mSemantic) );
+      continue;
+    }
+
+    // name it as TEXCOORD@SET0 etc. to be recognized when binding (not used yet)
+    vert_attrib->setObjectName( String(Say("%s@SET%n") << getSemanticString(batch->mChannels[ich]->mSemantic) << batch->mChannels[ich]->mSet).toStdString().c_str() );
 
-    size_t flipped = 0;
-    size_t degenerate = 0;
-    for(size_t i=0; i<norm_new->size(); ++i)
+    // fill the vertex attribute array
+    vert_attrib->bufferObject()->resize( batch->vertexCount() * data_size * sizeof(float) );
+    float* ptr = (float*)vert_attrib->ptr();
+    const float* data = source->bulkData();
+    const size_t count = source->count();
+    for(size_t ivert=0; ivert<batch->vertexCount(); ++ivert, ptr+=data_size)
     {
-      // compare VL normals with original ones
-      float l = norm_old->at(i).length();
-      if ( l < 0.5f )
-      {
-        norm_old->at(i) = norm_new->at(i);
-        ++degenerate;
-      }
+      size_t idx = batch->mAttribs[ivert * channels + ich];
+      if (data && idx < count)
+        memcpy( ptr, data + idx * data_size, data_size * sizeof(float) );
+      else
+        memset( ptr, 0, data_size * sizeof(float) );
+    }
+  }
 
-      if ( l < 0.9f || l > 1.1f )
-      {
-        norm_old->at(i).normalize();
-        ++degenerate;
-      }
+  // --- fix bad normals ---
+  if ( loadOptions()->fixBadNormals() && geom->normalArray() )
+    fixNormals( geom.get() );
 
-      if ( dot(norm_new->at(i), norm_old->at(i)) < -0.1f )
-      {
-        norm_old->at(i) = -norm_old->at(i);
-        ++flipped;
-      }
+  return geom;
+}
+//-----------------------------------------------------------------------------
+void DaeLoader::fixNormals(Geometry* geom)
+{
+  ref<ArrayFloat3> norm_old = vl::cast<ArrayFloat3>(geom->normalArray());
+  VL_CHECK(norm_old);
+  if (!norm_old)
+    return;
+
+  // recompute normals
+  geom->computeNormals();
+  ref<ArrayFloat3> norm_new = vl::cast<ArrayFloat3>(geom->normalArray());
+  VL_CHECK(norm_new);
+
+  size_t flipped = 0;
+  size_t degenerate = 0;
+  for(size_t i=0; i<norm_new->size(); ++i)
+  {
+    // compare VL normals with original ones
+    float l = norm_old->at(i).length();
+    if ( l < 0.5f )
+    {
+      norm_old->at(i) = norm_new->at(i);
+      ++degenerate;
     }
 
-    // mic fixme: issue these things as debug once things got stable
-    if (degenerate || flipped)
-      VL_LOG_DEBUG << ( Say("- LoadWriterDae: fixed bad normals in \"%s\": degenerate=%n, flipped=%n (out of %n).\n")  << prim->mGeometry->objectName() << degenerate << flipped << norm_old->size() );
+    if ( l < 0.9f || l > 1.1f )
+    {
+      norm_old->at(i).normalize();
+      ++degenerate;
+    }
 
-    // reinstall fixed normals
-    prim->mGeometry->setNormalArray(norm_old.get());
+    if ( dot(norm_new->at(i), norm_old->at(i)) < -0.1f )
+    {
+      norm_old->at(i) = -norm_old->at(i);
+      ++flipped;
+    }
   }
 
-   // disabled: we transform the root matrix instead
-   // --- orient geometry based on up vector ---
-   // prim->mGeometry->transform((mat4)mUpMatrix);
+  // mic fixme: issue these things as debug once things got stable
+  if (degenerate || flipped)
+    VL_LOG_DEBUG << ( Say("- LoadWriterDae: fixed bad normals in \"%s\": degenerate=%n, flipped=%n (out of %n).\n")  << geom->objectName() << degenerate << flipped << norm_old->size() );
+
+  // reinstall fixed normals
+  geom->setNormalArray(norm_old.get());
 }
 //-----------------------------------------------------------------------------
 void DaeLoader::parseAsset(domElement* root)
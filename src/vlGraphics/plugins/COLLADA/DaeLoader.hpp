@@ -64,6 +64,14 @@ namespace vl
 
     ref<Dae::Mesh> parseGeometry(daeElement* geometry);
 
+    void parseTrianglesFast(domMesh* mesh, Dae::Mesh* dae_mesh, const char* name);
+
+    Dae::TriangleBatch* triangleBatch(std::vector< ref<Dae::TriangleBatch> >& batches, const Dae::Primitive* dae_primitive);
+
+    void addCorners(Dae::TriangleBatch* batch, const Dae::Primitive* dae_primitive, const domListOfUInts& p, size_t first, size_t count, std::vector<GLuint>& out);
+
+    Geometry* shareGeometry(Geometry* geom);
+
     Dae::Source* getSource(daeElement* source_el);
 
     void bindMaterials(Dae::Node* dae_node, Dae::Mesh* dae_mesh, domBind_materialRef bind_material);
@@ -74,6 +82,8 @@ namespace vl
 
     void loadImages(const domImage_Array& images);
 
+    ref<Image> loadDaeImage(domImage* image);
+
     void parseImages(daeElement* library);
 
     void parseEffects(daeElement* library);
@@ -88,6 +98,8 @@ namespace vl
 
     ref<Effect> setup_vl_Effect( Dae::Material* mat );
 
+    ref<Effect> sharedEffect( Dae::Material* mat );
+
     static std::string percentDecode(const char* uri);
 
     static Dae::EInputSemantic getSemantic(const char* semantic);
@@ -104,6 +116,10 @@ namespace vl
 
     void generateGeometry(Dae::Primitive* primitive, const char* name);
 
+    ref<Geometry> generateGeometry(Dae::TriangleBatch* batch, const char* name);
+
+    void fixNormals(Geometry* geom);
+
   protected:
     const LoadWriterDae::LoadOptions* mLoadOptions;
 
@@ -117,6 +133,9 @@ namespace vl
     std::map< daeElementRef, ref<Dae::Source> > mSources; // daeElement* -> <source>
     std::map< daeElementRef, ref<Image> > mImages;
     std::map< daeElementRef, ref<Dae::NewParam> > mDaeNewParams;
+    std::set< daeElementRef > mPendingImages; // fast import: images loaded only when referenced
+    std::map< std::string, ref<Effect> > mSharedEffects; // fast import: effect signature -> Effect
+    std::multimap< size_t, ref<Geometry> > mSharedGeometries; // fast import: content hash -> Geometry
     ref<Effect> mDefaultFX;
     ref<Dae::Node> mScene;
     DAE mDAE;
@@ -73,6 +73,7 @@ namespace vl
         mExtractSkins = false;
         mLightMeshSize = 0;
         mExportLights = false;
+        mFastImport = false;
       }
 
       //! If true the <node>'s transform hierachy is flattened and baked inside the Actor::transform(), otherwise the full transform tree is exported. Enabled by default.
@@ -133,6 +134,15 @@ namespace vl
       //! If true the lights contained in the COLLADA file will be exported otherwise one single dummy light will be used to lit the models.
       bool exportLights() const { return mExportLights; }
 
+      //! If true the meshes are imported with a lighter path meant for large scenes: the sources are converted in bulk,
+      //! the triangles, polylists, polygons, fans and strips of each mesh are built directly into one triangle list per material,
+      //! geometries and materials with identical content are shared and only the images actually used by the effects are loaded.
+      //! Disabled by default.
+      void setFastImport(bool fast) { mFastImport = fast; }
+
+      //! If true the meshes are imported with a lighter path meant for large scenes, see setFastImport().
+      bool fastImport() const { return mFastImport; }
+
     protected:
       TransparencyOption mInvertTransparency;
       bool mFlattenTransformHierarchy;
@@ -143,6 +153,7 @@ namespace vl
       bool mMergeDrawCalls;
       float mLightMeshSize;
       bool mExportLights;
+      bool mFastImport;
     };
 
   public:
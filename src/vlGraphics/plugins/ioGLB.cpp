@@ -0,0 +1,1078 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include "ioGLB.hpp"
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <vlCore/FileSystem.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/MemoryFile.hpp>
+#include <vlCore/MappedFile.hpp>
+#include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/Quaternion.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlGraphics/DrawArrays.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <string.h>
+#include <stdlib.h>
+
+using namespace vl;
+
+namespace
+{
+  const unsigned int GLB_MAGIC      = 0x46546C67; // "glTF"
+  const unsigned int GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+  const unsigned int GLB_CHUNK_BIN  = 0x004E4942; // "BIN\0"
+
+  inline unsigned int readUInt32LE(const unsigned char* p)
+  {
+    return (unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24);
+  }
+
+//-----------------------------------------------------------------------------
+// JsonValue
+//-----------------------------------------------------------------------------
+  //! A parsed JSON value, object members are stored as parallel key and value vectors.
+  class JsonValue
+  {
+  public:
+    typedef enum { JT_Null, JT_Bool, JT_Number, JT_String, JT_Array, JT_Object } EType;
+
+    JsonValue(): mType(JT_Null), mNumber(0) {}
+
+    bool isNull() const { return mType == JT_Null; }
+
+    //! Number of elements of an array or of members of an object.
+    size_t size() const { return mValues.size(); }
+
+    //! Returns the i-th element of an array or a null value.
+    const JsonValue& operator[](int i) const
+    {
+      return mType == JT_Array && i >= 0 && i < (int)mValues.size() ? mValues[i] : nullValue();
+    }
+
+    //! Returns the member named \p key of an object or a null value.
+    const JsonValue& operator[](const char* key) const
+    {
+      if (mType == JT_Object)
+      {
+        for(size_t i=0; i<mKeys.size(); ++i)
+          if (mKeys[i] == key)
+            return mValues[i];
+      }
+      return nullValue();
+    }
+
+    bool has(const char* key) const { return !(*this)[key].isNull(); }
+
+    double toNumber(double def=0) const { return mType == JT_Number ? mNumber : def; }
+
+    int toInt(int def=0) const { return mType == JT_Number ? (int)mNumber : def; }
+
+    bool toBool(bool def) const { return mType == JT_Bool ? mNumber != 0 : def; }
+
+    const std::string& toString() const { return mString; }
+
+    static const JsonValue& nullValue()
+    {
+      static const JsonValue null_value;
+      return null_value;
+    }
+
+  public:
+    EType mType;
+    double mNumber;
+    std::string mString;
+    std::vector<std::string> mKeys;
+    std::vector<JsonValue> mValues;
+  };
+//-----------------------------------------------------------------------------
+// JsonParser
+//-----------------------------------------------------------------------------
+  //! Minimal recursive descent JSON parser, enough for the glTF header.
+  class JsonParser
+  {
+  public:
+    JsonParser(const char* begin, const char* end): mPtr(begin), mEnd(end), mDepth(0) {}
+
+    bool parse(JsonValue& value)
+    {
+      if (!parseValue(value))
+        return false;
+      // the GLB JSON chunk is padded with spaces, be tolerant with trailing zeros too
+      while(mPtr < mEnd && (isSpace(*mPtr) || *mPtr == 0))
+        ++mPtr;
+      return mPtr == mEnd;
+    }
+
+  protected:
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    void skipSpaces()
+    {
+      while(mPtr < mEnd && isSpace(*mPtr))
+        ++mPtr;
+    }
+
+    bool parseValue(JsonValue& v)
+    {
+      skipSpaces();
+      if (mPtr == mEnd)
+        return false;
+      switch(*mPtr)
+      {
+      case '{': return parseObject(v);
+      case '[': return parseArray(v);
+      case '"': v.mType = JsonValue::JT_String; return parseString(v.mString);
+      case 't': return parseLiteral("true",  v, JsonValue::JT_Bool, 1);
+      case 'f': return parseLiteral("false", v, JsonValue::JT_Bool, 0);
+      case 'n': return parseLiteral("null",  v, JsonValue::JT_Null, 0);
+      default:  return parseNumber(v);
+      }
+    }
+
+    bool parseLiteral(const char* literal, JsonValue& v, JsonValue::EType type, double value)
+    {
+      size_t len = strlen(literal);
+      if ((size_t)(mEnd - mPtr) < len || strncmp(mPtr, literal, len) != 0)
+        return false;
+      mPtr += len;
+      v.mType = type;
+      v.mNumber = value;
+      return true;
+    }
+
+    bool parseNumber(JsonValue& v)
+    {
+      char token[64];
+      int len = 0;
+      while(mPtr < mEnd && ((*mPtr >= '0' && *mPtr <= '9') || *mPtr == '-' || *mPtr == '+' || *mPtr == '.' || *mPtr == 'e' || *mPtr == 'E'))
+      {
+        if (len == (int)sizeof(token) - 1)
+          return false;
+        token[len++] = *mPtr++;
+      }
+      token[len] = 0;
+      char* end = NULL;
+      v.mNumber = strtod(token, &end);
+      v.mType = JsonValue::JT_Number;
+      return len && end == token + len;
+    }
+
+    static void appendUTF8(std::string& str, unsigned int code)
+    {
+      if (code < 0x80)
+        str += (char)code;
+      else
+      if (code < 0x800)
+      {
+        str += (char)(0xC0 | (code >> 6));
+        str += (char)(0x80 | (code & 0x3F));
+      }
+      else
+      if (code < 0x10000)
+      {
+        str += (char)(0xE0 | (code >> 12));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+      }
+      else
+      {
+        str += (char)(0xF0 | (code >> 18));
+        str += (char)(0x80 | ((code >> 12) & 0x3F));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+      }
+    }
+
+    bool parseHex4(unsigned int& code)
+    {
+      if (mEnd - mPtr < 4)
+        return false;
+      code = 0;
+      for(int i=0; i<4; ++i, ++mPtr)
+      {
+        char c = *mPtr;
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= c - '0';
+        else
+        if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else
+        if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else
+          return false;
+      }
+      return true;
+    }
+
+    bool parseString(std::string& str)
+    {
+      ++mPtr; // skip '"'
+      str.clear();
+      while(mPtr < mEnd && *mPtr != '"')
+      {
+        if (*mPtr != '\\')
+        {
+          const char* run = mPtr;
+          while(mPtr < mEnd && *mPtr != '"' && *mPtr != '\\')
+            ++mPtr;
+          str.append(run, mPtr);
+          continue;
+        }
+        if (++mPtr == mEnd)
+          return false;
+        char c = *mPtr++;
+        switch(c)
+        {
+        case '"':  str += '"'; break;
+        case '\\': str += '\\'; break;
+        case '/':  str += '/'; break;
+        case 'b':  str += '\b'; break;
+        case 'f':  str += '\f'; break;
+        case 'n':  str += '\n'; break;
+        case 'r':  str += '\r'; break;
+        case 't':  str += '\t'; break;
+        case 'u':
+        {
+          unsigned int code = 0;
+          if (!parseHex4(code))
+            return false;
+          // surrogate pair
+          if (code >= 0xD800 && code < 0xDC00 && mEnd - mPtr >= 6 && mPtr[0] == '\\' && mPtr[1] == 'u')
+          {
+            mPtr += 2;
+            unsigned int low = 0;
+            if (!parseHex4(low))
+              return false;
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          }
+          appendUTF8(str, code);
+          break;
+        }
+        default:
+          return false;
+        }
+      }
+      if (mPtr == mEnd)
+        return false;
+      ++mPtr; // skip '"'
+      return true;
+    }
+
+    bool parseArray(JsonValue& v)
+    {
+      if (++mDepth > 256)
+        return false;
+      ++mPtr; // skip '['
+      v.mType = JsonValue::JT_Array;
+      skipSpaces();
+      if (mPtr < mEnd && *mPtr == ']')
+      {
+        ++mPtr;
+        --mDepth;
+        return true;
+      }
+      for(;;)
+      {
+        v.mValues.push_back(JsonValue());
+        if (!parseValue(v.mValues.back()))
+          return false;
+        skipSpaces();
+        if (mPtr == mEnd)
+          return false;
+        if (*mPtr == ']')
+          break;
+        if (*mPtr++ != ',')
+          return false;
+      }
+      ++mPtr;
+      --mDepth;
+      return true;
+    }
+
+    bool parseObject(JsonValue& v)
+    {
+      if (++mDepth > 256)
+        return false;
+      ++mPtr; // skip '{'
+      v.mType = JsonValue::JT_Object;
+      skipSpaces();
+      if (mPtr < mEnd && *mPtr == '}')
+      {
+        ++mPtr;
+        --mDepth;
+        return true;
+      }
+      for(;;)
+      {
+        skipSpaces();
+        if (mPtr == mEnd || *mPtr != '"')
+          return false;
+        v.mKeys.push_back(std::string());
+        if (!parseString(v.mKeys.back()))
+          return false;
+        skipSpaces();
+        if (mPtr == mEnd || *mPtr++ != ':')
+          return false;
+        v.mValues.push_back(JsonValue());
+        if (!parseValue(v.mValues.back()))
+          return false;
+        skipSpaces();
+        if (mPtr == mEnd)
+          return false;
+        if (*mPtr == '}')
+          break;
+        if (*mPtr++ != ',')
+          return false;
+      }
+      ++mPtr;
+      --mDepth;
+      return true;
+    }
+
+  protected:
+    const char* mPtr;
+    const char* mEnd;
+    int mDepth;
+  };
+//-----------------------------------------------------------------------------
+  int componentSize(int component_type)
+  {
+    switch(component_type)
+    {
+    case 5120: case 5121: return 1; // BYTE, UNSIGNED_BYTE
+    case 5122: case 5123: return 2; // SHORT, UNSIGNED_SHORT
+    case 5125: case 5126: return 4; // UNSIGNED_INT, FLOAT
+    default: return 0;
+    }
+  }
+
+  int typeComponents(const std::string& type)
+  {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2")   return 2;
+    if (type == "VEC3")   return 3;
+    if (type == "VEC4")   return 4;
+    return 0; // matrices are not used by the supported attributes
+  }
+
+  ref<ArrayAbstract> createArray(int component_type, int components)
+  {
+    #define GLB_CREATE_ARRAY(type)                     \
+      switch(components)                               \
+      {                                                \
+      case 1: return new Array##type##1;               \
+      case 2: return new Array##type##2;               \
+      case 3: return new Array##type##3;               \
+      case 4: return new Array##type##4;               \
+      default: return NULL;                            \
+      }
+
+    switch(component_type)
+    {
+    case 5120: GLB_CREATE_ARRAY(Byte)
+    case 5121: GLB_CREATE_ARRAY(UByte)
+    case 5122: GLB_CREATE_ARRAY(Short)
+    case 5123: GLB_CREATE_ARRAY(UShort)
+    case 5125: GLB_CREATE_ARRAY(UInt)
+    case 5126: GLB_CREATE_ARRAY(Float)
+    default: return NULL;
+    }
+
+    #undef GLB_CREATE_ARRAY
+  }
+
+  bool primitiveType(int mode, EPrimitiveType& type)
+  {
+    switch(mode)
+    {
+    case 0: type = PT_POINTS;         return true;
+    case 1: type = PT_LINES;          return true;
+    case 2: type = PT_LINE_LOOP;      return true;
+    case 3: type = PT_LINE_STRIP;     return true;
+    case 4: type = PT_TRIANGLES;      return true;
+    case 5: type = PT_TRIANGLE_STRIP; return true;
+    case 6: type = PT_TRIANGLE_FAN;   return true;
+    default: return false;
+    }
+  }
+
+  ETexParamWrap wrapMode(int wrap)
+  {
+    switch(wrap)
+    {
+    case 33071: return TPW_CLAMP_TO_EDGE;
+    case 33648: return TPW_MIRRORED_REPEAT;
+    default:    return TPW_REPEAT;
+    }
+  }
+//-----------------------------------------------------------------------------
+// GLBImporter
+//-----------------------------------------------------------------------------
+  //! Converts the glTF document into VL objects, every object is created once and cached by index.
+  class GLBImporter
+  {
+  public:
+    ref<ResourceDatabase> import(VirtualFile* file);
+
+  protected:
+    bool readFile(VirtualFile* file);
+    Buffer* buffer(int index);
+    ArrayAbstract* accessor(int index);
+    ref<ArrayAbstract> floatTexCoords(int index);
+    Geometry* primitive(int imesh, int iprim);
+    Effect* effect(int imaterial, bool vertex_colors);
+    Texture* texture(int index);
+    ref<Image> image(int index);
+    void node(int index, Transform* parent);
+
+  protected:
+    ref<VirtualFile> mFile;
+    ref<ResourceDatabase> mResources;
+    JsonValue mJson;
+    ref<Buffer> mBinChunk;
+    std::map<int, ref<Buffer> > mBuffers;
+    std::map<int, ref<ArrayAbstract> > mAccessors;
+    std::map<int, ref<Texture> > mTextures;
+    std::map<int, ref<Effect> > mEffects;
+    std::map< std::pair<int,int>, ref<Geometry> > mGeometries;
+    std::set<int> mVisitedNodes;
+  };
+//-----------------------------------------------------------------------------
+  bool GLBImporter::readFile(VirtualFile* file)
+  {
+    if ( !file->isOpen() && !file->open(OM_ReadOnly) )
+    {
+      Log::error( Say("loadGLB(): could not open '%s'.\n") << file->path() );
+      return false;
+    }
+
+    long long file_size = file->size();
+    unsigned char header[12];
+    std::vector<char> json;
+
+    if ( file_size >= 12 && file->read(header, 12) == 12 && readUInt32LE(header) == GLB_MAGIC )
+    {
+      unsigned int version = readUInt32LE(header+4);
+      long long length     = readUInt32LE(header+8);
+      if ( version != 2 || length > file_size )
+      {
+        Log::error( Say("loadGLB(): '%s' is not a valid glTF 2.0 binary file.\n") << file->path() );
+        return false;
+      }
+
+      // JSON chunk, always the first one
+      unsigned char chunk[8];
+      if ( file->read(chunk, 8) != 8 || readUInt32LE(chunk+4) != GLB_CHUNK_JSON || 20 + (long long)readUInt32LE(chunk) > length )
+      {
+        Log::error( Say("loadGLB(): '%s' has no valid JSON chunk.\n") << file->path() );
+        return false;
+      }
+      json.resize( readUInt32LE(chunk) );
+      if ( !json.empty() && file->read(&json[0], json.size()) != (long long)json.size() )
+      {
+        Log::error( Say("loadGLB(): could not read '%s'.\n") << file->path() );
+        return false;
+      }
+
+      // optional BIN chunk, loaded in a single buffer shared by all the accessors
+      long long bin_pos = 20 + (long long)json.size();
+      if ( bin_pos + 8 <= length && file->read(chunk, 8) == 8 && readUInt32LE(chunk+4) == GLB_CHUNK_BIN )
+      {
+        long long bin_size = readUInt32LE(chunk);
+        if ( bin_pos + 8 + bin_size > length )
+        {
+          Log::error( Say("loadGLB(): '%s' has a truncated BIN chunk.\n") << file->path() );
+          return false;
+        }
+        mBinChunk = new Buffer;
+        // zero-copy path: the buffer uses the mapped pages as storage
+        MappedFile* mapped = file->as<MappedFile>();
+        unsigned char* ptr = mapped && bin_size ? mapped->mappedPtr(bin_pos + 8, bin_size) : NULL;
+        if ( ptr )
+          mBinChunk->setUserAllocatedBuffer( ptr, (size_t)bin_size, mapped->mapping() );
+        else
+        {
+          mBinChunk->resize( (size_t)bin_size );
+          if ( bin_size && file->read(mBinChunk->ptr(), bin_size) != bin_size )
+          {
+            Log::error( Say("loadGLB(): could not read '%s'.\n") << file->path() );
+            return false;
+          }
+        }
+      }
+    }
+    else
+    {
+      // .gltf: the whole file is the JSON document
+      json.resize( (size_t)file_size );
+      file->seekSet(0);
+      if ( !json.empty() && file->read(&json[0], json.size()) != (long long)json.size() )
+      {
+        Log::error( Say("loadGLB(): could not read '%s'.\n") << file->path() );
+        return false;
+      }
+    }
+
+    JsonParser parser( json.empty() ? NULL : &json[0], json.empty() ? NULL : &json[0] + json.size() );
+    if ( !parser.parse(mJson) || mJson.mType != JsonValue::JT_Object )
+    {
+      Log::error( Say("loadGLB(): '%s' contains invalid JSON.\n") << file->path() );
+      return false;
+    }
+
+    const std::string& version = mJson["asset"]["version"].toString();
+    if ( version.empty() || version[0] != '2' )
+    {
+      Log::error( Say("loadGLB(): '%s' is not a glTF 2.0 file.\n") << file->path() );
+      return false;
+    }
+
+    const JsonValue& required = mJson["extensionsRequired"];
+    for(size_t i=0; i<required.size(); ++i)
+      Log::warning( Say("loadGLB(): required extension '%s' not supported.\n") << required[i].toString().c_str() );
+
+    return true;
+  }
+//-----------------------------------------------------------------------------
+  Buffer* GLBImporter::buffer(int index)
+  {
+    std::map<int, ref<Buffer> >::iterator it = mBuffers.find(index);
+    if ( it != mBuffers.end() )
+      return it->second.get();
+
+    ref<Buffer>& buf = mBuffers[index];
+    const JsonValue& json = mJson["buffers"][index];
+    if ( json.isNull() )
+    {
+      Log::error( Say("loadGLB(): invalid buffer %n.\n") << index );
+      return NULL;
+    }
+
+    if ( !json.has("uri") )
+    {
+      // the first buffer without uri refers to the GLB BIN chunk
+      if ( index == 0 && mBinChunk )
+        buf = mBinChunk;
+      else
+        Log::error( Say("loadGLB(): buffer %n has no data.\n") << index );
+    }
+    else
+    {
+      const std::string& uri = json["uri"].toString();
+      if ( uri.compare(0, 5, "data:") == 0 )
+        Log::error("loadGLB(): embedded data URIs are not supported.\n");
+      else
+      {
+        ref<VirtualFile> file = defFileSystem()->locateFile( String::fromUTF8(uri.c_str()), mFile->path().extractPath() );
+        if ( !file )
+          Log::error( Say("loadGLB(): could not locate '%s'.\n") << uri.c_str() );
+        else
+        if ( file->open(OM_ReadOnly) )
+        {
+          buf = new Buffer;
+          buf->resize( (size_t)file->size() );
+          if ( file->size() && file->read(buf->ptr(), file->size()) != file->size() )
+          {
+            Log::error( Say("loadGLB(): could not read '%s'.\n") << file->path() );
+            buf = NULL;
+          }
+          file->close();
+        }
+      }
+    }
+
+    if ( buf && (long long)buf->bytesUsed() < (long long)json["byteLength"].toNumber(0) )
+    {
+      Log::error( Say("loadGLB(): buffer %n is shorter than declared.\n") << index );
+      buf = NULL;
+    }
+
+    return buf.get();
+  }
+//-----------------------------------------------------------------------------
+  ArrayAbstract* GLBImporter::accessor(int index)
+  {
+    std::map<int, ref<ArrayAbstract> >::iterator it = mAccessors.find(index);
+    if ( it != mAccessors.end() )
+      return it->second.get();
+
+    ref<ArrayAbstract>& arr = mAccessors[index];
+    const JsonValue& json = mJson["accessors"][index];
+    int component_type = json["componentType"].toInt();
+    int components     = typeComponents( json["type"].toString() );
+    double count       = json["count"].toNumber(-1);
+    size_t comp_size   = componentSize(component_type);
+    size_t elem_size   = comp_size * components;
+
+    ref<ArrayAbstract> array = createArray(component_type, components);
+    if ( !array || count < 0 )
+    {
+      Log::error( Say("loadGLB(): accessor %n not supported.\n") << index );
+      return NULL;
+    }
+
+    if ( json.has("sparse") )
+      Log::warning( Say("loadGLB(): sparse accessor %n not supported, only the base values are loaded.\n") << index );
+
+    if ( !json.has("bufferView") )
+    {
+      // no buffer view means all zeros
+      array->bufferObject()->resize( (size_t)count * elem_size );
+      if ( count )
+        memset( array->ptr(), 0, (size_t)count * elem_size );
+    }
+    else
+    {
+      const JsonValue& view = mJson["bufferViews"][ json["bufferView"].toInt(-1) ];
+      Buffer* buf = view.isNull() ? NULL : buffer( view["buffer"].toInt(-1) );
+      if ( !buf )
+        return NULL;
+
+      double view_offset = view["byteOffset"].toNumber(0);
+      double view_length = view["byteLength"].toNumber(0);
+      double offset      = json["byteOffset"].toNumber(0);
+      double stride      = view["byteStride"].toNumber(0);
+      if ( stride == 0 )
+        stride = (double)elem_size;
+
+      // validate in double precision to reject corrupted sizes without overflows
+      if ( stride < elem_size || view_offset + view_length > buf->bytesUsed() || ( count && offset + stride * (count-1) + elem_size > view_length ) )
+      {
+        Log::error( Say("loadGLB(): accessor %n out of bounds.\n") << index );
+        return NULL;
+      }
+
+      unsigned char* src = buf->ptr() + (size_t)(view_offset + offset);
+      if ( (size_t)stride == elem_size && (size_t)src % comp_size == 0 )
+      {
+        // zero-copy: the array storage is a view on the shared buffer which is kept alive by the array
+        array->bufferObject()->setUserAllocatedBuffer( src, (size_t)count * elem_size, buf );
+      }
+      else
+      {
+        // interleaved or misaligned data is copied in its own storage
+        array->bufferObject()->resize( (size_t)count * elem_size );
+        unsigned char* dst = array->ptr();
+        for(size_t i=0; i<(size_t)count; ++i, dst += elem_size, src += (size_t)stride)
+          memcpy(dst, src, elem_size);
+      }
+    }
+
+    array->setNormalize( json["normalized"].toBool(false) );
+    arr = array;
+    return arr.get();
+  }
+//-----------------------------------------------------------------------------
+  ref<ArrayAbstract> GLBImporter::floatTexCoords(int index)
+  {
+    ArrayAbstract* array = accessor(index);
+    const JsonValue& json = mJson["accessors"][index];
+    int component_type = json["componentType"].toInt();
+    if ( !array || component_type == 5126 )
+      return array;
+
+    // fixed function texture coordinates are never normalized, convert the quantized ones to floats
+    float scale = 1.0f;
+    if ( json["normalized"].toBool(false) )
+    {
+      switch(component_type)
+      {
+      case 5120: scale = 1.0f / 127.0f;   break;
+      case 5121: scale = 1.0f / 255.0f;   break;
+      case 5122: scale = 1.0f / 32767.0f; break;
+      case 5123: scale = 1.0f / 65535.0f; break;
+      }
+    }
+    ref<ArrayFloat2> tex_coords = new ArrayFloat2;
+    tex_coords->resize( array->size() );
+    for(size_t i=0; i<array->size(); ++i)
+    {
+      vec4 v = array->getAsVec4(i);
+      tex_coords->at(i) = fvec2( (float)v.x(), (float)v.y() ) * scale;
+    }
+    return tex_coords;
+  }
+//-----------------------------------------------------------------------------
+  Geometry* GLBImporter::primitive(int imesh, int iprim)
+  {
+    std::pair<int,int> key(imesh, iprim);
+    std::map< std::pair<int,int>, ref<Geometry> >::iterator it = mGeometries.find(key);
+    if ( it != mGeometries.end() )
+      return it->second.get();
+
+    ref<Geometry>& geom = mGeometries[key];
+    const JsonValue& mesh  = mJson["meshes"][imesh];
+    const JsonValue& prim  = mesh["primitives"][iprim];
+    const JsonValue& attrs = prim["attributes"];
+
+    EPrimitiveType type = PT_TRIANGLES;
+    if ( !primitiveType(prim["mode"].toInt(4), type) )
+    {
+      Log::error( Say("loadGLB(): mesh %n has an invalid primitive mode.\n") << imesh );
+      return NULL;
+    }
+
+    ArrayAbstract* position = attrs.has("POSITION") ? accessor( attrs["POSITION"].toInt() ) : NULL;
+    if ( !position )
+    {
+      Log::warning( Say("loadGLB(): mesh %n primitive %n has no positions.\n") << imesh << iprim );
+      return NULL;
+    }
+
+    ref<Geometry> geometry = new Geometry;
+    geometry->setObjectName( mesh["name"].toString().c_str() );
+    geometry->setVertexArray( position );
+
+    if ( attrs.has("NORMAL") )
+    {
+      ArrayAbstract* normal = accessor( attrs["NORMAL"].toInt() );
+      if ( normal && normal->size() == position->size() )
+        geometry->setNormalArray( normal );
+    }
+
+    if ( attrs.has("TEXCOORD_0") )
+    {
+      ref<ArrayAbstract> tex_coord = floatTexCoords( attrs["TEXCOORD_0"].toInt() );
+      if ( tex_coord && tex_coord->size() == position->size() )
+        geometry->setTexCoordArray( 0, tex_coord.get() );
+    }
+
+    if ( attrs.has("COLOR_0") )
+    {
+      ArrayAbstract* color = accessor( attrs["COLOR_0"].toInt() );
+      if ( color && color->size() == position->size() )
+        geometry->setColorArray( color );
+    }
+
+    if ( prim.has("indices") )
+    {
+      int index = prim["indices"].toInt(-1);
+      ArrayAbstract* indices = accessor(index);
+      if ( !indices )
+        return NULL;
+
+      // the index arrays share the binary buffer as well
+      switch( mJson["accessors"][index]["componentType"].toInt() )
+      {
+      case 5121:
+      {
+        ref<DrawElementsUByte> de = new DrawElementsUByte(type);
+        de->setIndexBuffer( indices->as<ArrayUByte1>() );
+        geometry->drawCalls().push_back( de.get() );
+        break;
+      }
+      case 5123:
+      {
+        ref<DrawElementsUShort> de = new DrawElementsUShort(type);
+        de->setIndexBuffer( indices->as<ArrayUShort1>() );
+        geometry->drawCalls().push_back( de.get() );
+        break;
+      }
+      case 5125:
+      {
+        ref<DrawElementsUInt> de = new DrawElementsUInt(type);
+        de->setIndexBuffer( indices->as<ArrayUInt1>() );
+        geometry->drawCalls().push_back( de.get() );
+        break;
+      }
+      default:
+        Log::error( Say("loadGLB(): mesh %n has an invalid index type.\n") << imesh );
+        return NULL;
+      }
+    }
+    else
+      geometry->drawCalls().push_back( new DrawArrays(type, 0, (int)position->size()) );
+
+    geom = geometry;
+    return geom.get();
+  }
+//-----------------------------------------------------------------------------
+  ref<Image> GLBImporter::image(int index)
+  {
+    const JsonValue& json = mJson["images"][index];
+    if ( json.has("bufferView") )
+    {
+      const JsonValue& view = mJson["bufferViews"][ json["bufferView"].toInt(-1) ];
+      Buffer* buf = view.isNull() ? NULL : buffer( view["buffer"].toInt(-1) );
+      double offset = view["byteOffset"].toNumber(0);
+      double length = view["byteLength"].toNumber(0);
+      if ( !buf || offset + length > buf->bytesUsed() )
+      {
+        Log::error( Say("loadGLB(): image %n out of bounds.\n") << index );
+        return NULL;
+      }
+
+      // decode the image straight from the shared buffer, the extension selects the image loader
+      ref<Buffer> bytes = new Buffer;
+      bytes->setUserAllocatedBuffer( buf->ptr() + (size_t)offset, (size_t)length, buf );
+      ref<MemoryFile> file = new MemoryFile;
+      file->setBuffer( bytes.get() );
+      String ext = json["mimeType"].toString() == "image/jpeg" ? ".jpg" : ".png";
+      file->setPath( mFile->path() + "#image" + String::fromInt(index) + ext );
+      return loadImage( file.get() );
+    }
+    else
+    if ( json.has("uri") )
+    {
+      const std::string& uri = json["uri"].toString();
+      if ( uri.compare(0, 5, "data:") == 0 )
+      {
+        Log::error("loadGLB(): embedded data URIs are not supported.\n");
+        return NULL;
+      }
+      ref<VirtualFile> file = defFileSystem()->locateFile( String::fromUTF8(uri.c_str()), mFile->path().extractPath() );
+      if ( file )
+        return loadImage( file.get() );
+      Log::error( Say("loadGLB(): could not locate '%s'.\n") << uri.c_str() );
+    }
+    return NULL;
+  }
+//-----------------------------------------------------------------------------
+  Texture* GLBImporter::texture(int index)
+  {
+    std::map<int, ref<Texture> >::iterator it = mTextures.find(index);
+    if ( it != mTextures.end() )
+      return it->second.get();
+
+    ref<Texture>& texture = mTextures[index];
+    const JsonValue& json = mJson["textures"][index];
+    if ( !json.has("source") )
+      return NULL;
+
+    ref<Image> img = image( json["source"].toInt() );
+    if ( !img )
+      return NULL;
+
+    const JsonValue& sampler = mJson["samplers"][ json["sampler"].toInt(-1) ];
+    texture = new Texture;
+    texture->getTexParameter()->setMinFilter(TPF_LINEAR_MIPMAP_LINEAR);
+    texture->getTexParameter()->setMagFilter(TPF_LINEAR);
+    texture->getTexParameter()->setWrapS( wrapMode( sampler["wrapS"].toInt(10497) ) );
+    texture->getTexParameter()->setWrapT( wrapMode( sampler["wrapT"].toInt(10497) ) );
+    texture->prepareTexture2D( img.get(), TF_RGBA, true );
+    return texture.get();
+  }
+//-----------------------------------------------------------------------------
+  Effect* GLBImporter::effect(int imaterial, bool vertex_colors)
+  {
+    // primitives with vertex colors use a separate Effect with color material enabled
+    int key = imaterial * 2 + (vertex_colors ? 1 : 0);
+    std::map<int, ref<Effect> >::iterator it = mEffects.find(key);
+    if ( it != mEffects.end() )
+      return it->second.get();
+
+    ref<Effect>& effect = mEffects[key];
+    effect = new Effect;
+    effect->shader()->enable(EN_DEPTH_TEST);
+    effect->shader()->enable(EN_LIGHTING);
+    if ( vertex_colors )
+      effect->shader()->gocMaterial()->setColorMaterialEnabled(true);
+
+    const JsonValue& material = mJson["materials"][imaterial];
+    effect->setObjectName( material["name"].toString().c_str() );
+
+    const JsonValue& pbr = material["pbrMetallicRoughness"];
+    const JsonValue& base_color = pbr["baseColorFactor"];
+    fvec4 diffuse(1, 1, 1, 1);
+    for(size_t i=0; i<base_color.size() && i<4; ++i)
+      diffuse[i] = (float)base_color[i].toNumber(1);
+    effect->shader()->gocMaterial()->setDiffuse( diffuse );
+
+    const JsonValue& emissive = material["emissiveFactor"];
+    if ( emissive.size() == 3 )
+      effect->shader()->gocMaterial()->setEmission( fvec4( (float)emissive[0].toNumber(), (float)emissive[1].toNumber(), (float)emissive[2].toNumber(), 1.0f ) );
+
+    if ( material["doubleSided"].toBool(false) )
+      effect->shader()->gocLightModel()->setTwoSide(true);
+    else
+      effect->shader()->enable(EN_CULL_FACE);
+
+    const std::string& alpha_mode = material["alphaMode"].toString();
+    if ( alpha_mode == "BLEND" )
+      effect->shader()->enable(EN_BLEND);
+    else
+    if ( alpha_mode == "MASK" )
+    {
+      effect->shader()->gocAlphaFunc()->set( FU_GEQUAL, (float)material["alphaCutoff"].toNumber(0.5) );
+      effect->shader()->enable(EN_ALPHA_TEST);
+    }
+
+    if ( pbr.has("baseColorTexture") )
+    {
+      Texture* tex = texture( pbr["baseColorTexture"]["index"].toInt(-1) );
+      if ( tex )
+        effect->shader()->gocTextureSampler(0)->setTexture( tex );
+    }
+
+    return effect.get();
+  }
+//-----------------------------------------------------------------------------
+  void GLBImporter::node(int index, Transform* parent)
+  {
+    const JsonValue& json = mJson["nodes"][index];
+    if ( json.isNull() || mVisitedNodes.count(index) )
+    {
+      Log::error( Say("loadGLB(): invalid node %n.\n") << index );
+      return;
+    }
+    mVisitedNodes.insert(index);
+
+    ref<Transform> tr = new Transform;
+    tr->setObjectName( json["name"].toString().c_str() );
+
+    const JsonValue& matrix = json["matrix"];
+    if ( matrix.size() == 16 )
+    {
+      // column major as in OpenGL
+      mat4 m;
+      for(int i=0; i<16; ++i)
+        m.ptr()[i] = (real)matrix[i].toNumber();
+      tr->setLocalMatrix(m);
+    }
+    else
+    {
+      const JsonValue& t = json["translation"];
+      const JsonValue& r = json["rotation"];
+      const JsonValue& s = json["scale"];
+      mat4 m;
+      if ( t.size() == 3 )
+        m = mat4::getTranslation( vec3( (real)t[0].toNumber(), (real)t[1].toNumber(), (real)t[2].toNumber() ) );
+      if ( r.size() == 4 )
+        m = m * quat( (real)r[0].toNumber(), (real)r[1].toNumber(), (real)r[2].toNumber(), (real)r[3].toNumber() ).toMatrix4();
+      if ( s.size() == 3 )
+        m = m * mat4::getScaling( vec3( (real)s[0].toNumber(1), (real)s[1].toNumber(1), (real)s[2].toNumber(1) ) );
+      tr->setLocalMatrix(m);
+    }
+    parent->addChild( tr.get() );
+
+    if ( json.has("mesh") )
+    {
+      int imesh = json["mesh"].toInt(-1);
+      const JsonValue& mesh = mJson["meshes"][imesh];
+      const JsonValue& prims = mesh["primitives"];
+      for(size_t i=0; i<prims.size(); ++i)
+      {
+        Geometry* geom = primitive(imesh, (int)i);
+        if ( !geom )
+          continue;
+        Effect* fx = effect( prims[i]["material"].toInt(-1), geom->colorArray() != NULL );
+        ref<Actor> actor = new Actor( geom, fx, tr.get() );
+        actor->setObjectName( mesh["name"].toString().c_str() );
+        mResources->resources().push_back( actor.get() );
+      }
+    }
+
+    const JsonValue& children = json["children"];
+    for(size_t i=0; i<children.size(); ++i)
+      node( children[i].toInt(-1), tr.get() );
+  }
+//-----------------------------------------------------------------------------
+  ref<ResourceDatabase> GLBImporter::import(VirtualFile* file)
+  {
+    mFile = file;
+    mResources = new ResourceDatabase;
+
+    bool ok = readFile(file);
+    file->close();
+    if ( !ok )
+      return NULL;
+
+    // root nodes: the ones of the default scene or, without scenes, all the nodes that are nobody's child
+    std::vector<int> roots;
+    const JsonValue& scenes = mJson["scenes"];
+    if ( scenes.size() )
+    {
+      const JsonValue& nodes = scenes[ mJson["scene"].toInt(0) ]["nodes"];
+      for(size_t i=0; i<nodes.size(); ++i)
+        roots.push_back( nodes[i].toInt(-1) );
+    }
+    else
+    {
+      const JsonValue& nodes = mJson["nodes"];
+      std::vector<bool> is_child( nodes.size(), false );
+      for(size_t i=0; i<nodes.size(); ++i)
+      {
+        const JsonValue& children = nodes[i]["children"];
+        for(size_t j=0; j<children.size(); ++j)
+          if ( children[j].toInt(-1) >= 0 && children[j].toInt(-1) < (int)nodes.size() )
+            is_child[ children[j].toInt(-1) ] = true;
+      }
+      for(size_t i=0; i<nodes.size(); ++i)
+        if ( !is_child[i] )
+          roots.push_back( (int)i );
+    }
+
+    ref<Transform> root = new Transform;
+    root->setObjectName( file->path().extractFileName().toStdString().c_str() );
+    for(size_t i=0; i<roots.size(); ++i)
+      node( roots[i], root.get() );
+
+    root->computeWorldMatrixRecursive();
+    mResources->resources().push_back( root.get() );
+
+    return mResources;
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> vl::loadGLB(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+
+  if (file)
+    return loadGLB( file.get() );
+  else
+  {
+    Log::error( Say("Could not locate '%s'.\n") << path );
+    return NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> vl::loadGLB(VirtualFile* file)
+{
+  GLBLoader glb;
+  return glb.loadGLB(file);
+}
+//-----------------------------------------------------------------------------
+// GLBLoader
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> GLBLoader::loadGLB(VirtualFile* file)
+{
+  GLBImporter importer;
+  return importer.import(file);
+}
+//-----------------------------------------------------------------------------
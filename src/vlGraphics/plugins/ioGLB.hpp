@@ -0,0 +1,107 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#if !defined(LoadGLB_INCLUDE_ONCE)
+#define LoadGLB_INCLUDE_ONCE
+
+#include <vlGraphics/Geometry.hpp>
+#include <vlCore/ResourceLoadWriter.hpp>
+#include <vlCore/ResourceDatabase.hpp>
+
+namespace vl
+{
+  class VirtualFile;
+}
+
+namespace vl
+{
+//-----------------------------------------------------------------------------
+  VLGRAPHICS_EXPORT ref<ResourceDatabase> loadGLB(VirtualFile* file);
+  VLGRAPHICS_EXPORT ref<ResourceDatabase> loadGLB(const String& path);
+//---------------------------------------------------------------------------
+// LoadWriterGLB
+//---------------------------------------------------------------------------
+  /**
+   * The LoadWriterGLB class is a ResourceLoadWriter capable of reading glTF 2.0 files (.glb and .gltf).
+   */
+  class LoadWriterGLB: public ResourceLoadWriter
+  {
+    VL_INSTRUMENT_CLASS(vl::LoadWriterGLB, ResourceLoadWriter)
+
+  public:
+    LoadWriterGLB(): ResourceLoadWriter("|glb|gltf|", "|glb|gltf|") {}
+
+    ref<ResourceDatabase> loadResource(const String& path) const
+    {
+      return loadGLB(path);
+    }
+
+    ref<ResourceDatabase> loadResource(VirtualFile* file) const
+    {
+      return loadGLB(file);
+    }
+
+    //! Not supported yet.
+    bool writeResource(const String& /*path*/, ResourceDatabase* /*resource*/) const
+    {
+      return false;
+    }
+
+    //! Not supported yet.
+    bool writeResource(VirtualFile* /*file*/, ResourceDatabase* /*resource*/) const
+    {
+      return false;
+    }
+  };
+//-----------------------------------------------------------------------------
+// GLBLoader
+//-----------------------------------------------------------------------------
+  /**
+   * Loads a glTF 2.0 file, either binary (.glb) or JSON (.gltf) with its binary buffer stored in a separate file.
+   *
+   * The binary buffer is loaded once in a single Buffer (or wrapped without copying if the file is a MappedFile)
+   * and the accessors that are tightly packed are mapped directly onto it: the resulting vertex and index arrays
+   * share the same storage at different offsets instead of owning a copy of their data.
+   * Interleaved accessors are de-interleaved into their own storage.
+   *
+   * The nodes are converted into a Transform hierarchy, the mesh primitives into Geometry objects and the
+   * materials into Effect objects, the returned ResourceDatabase contains one Actor per mesh primitive instance
+   * followed by the root Transform. Skins, morph targets, animations, cameras and sparse accessors are not supported.
+   */
+  class VLGRAPHICS_EXPORT GLBLoader
+  {
+  public:
+    //! Loads a glTF 2.0 file.
+    ref<ResourceDatabase> loadGLB(VirtualFile* file);
+  };
+};
+
+#endif
@@ -37,11 +37,14 @@
 #include <vlCore/FileSystem.hpp>
 #include <vlGraphics/DoubleVertexRemover.hpp>
 #include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/MappedFile.hpp>
 #include <vlGraphics/Effect.hpp>
 #include <vlGraphics/Actor.hpp>
 #include <string>
 #include <vector>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
 using namespace vl;
 
@@ -53,10 +56,411 @@ namespace
   template <class T>
   void append(std::vector<T>& vec, const T& data, const int& alloc_step = 1024*10)
   {
+    // grow geometrically so that huge files are not copied over and over
     if (vec.size() == vec.capacity())
-      vec.reserve( vec.size() + alloc_step );
+      vec.reserve( vec.size() + std::max(vec.size() / 2, (size_t)alloc_step) );
     vec.push_back(data);
   }
+
+  //! Removes leading and trailing spaces, tabs and new lines.
+  void trimLine(const char*& begin, const char*& end)
+  {
+    while( begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r' || *begin == '\n') )
+      ++begin;
+    while( end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n') )
+      --end;
+  }
+
+  //! Parses up to \p count space separated floats, stops at the first invalid one like sscanf().
+  void parseFloats(const char* p, const char* end, float* values, int count)
+  {
+    for(int i=0; i<count && p; ++i)
+      p = TextStream::parseFloat( TextStream::skipSpaces(p, end), end, values[i] );
+  }
+
+  //! Parses a face vertex in the form "v", "v/vt", "v//vn" or "v/vt/vn", missing indices are left untouched.
+  void parseFaceVertex(const char* p, const char* end, int& iv, int& ivt, int& ivn)
+  {
+    p = TextStream::parseInt(p, end, iv);
+    if ( !p || p == end || *p != '/' )
+      return;
+    const char* q = TextStream::parseInt(++p, end, ivt);
+    if (q)
+      p = q;
+    if ( p < end && *p == '/' )
+      TextStream::parseInt(++p, end, ivn);
+  }
+
+  /** Detects the vertex format of a face from its first vertex:
+   * 0 = f v       v       v
+   * 1 = f v/vt    v/vt    v/vt
+   * 2 = f v//vn   v//vn   v//vn
+   * 3 = f v/vt/vn v/vt/vn v/vt/vn */
+  int detectFaceFormat(const char* p, const char* end)
+  {
+    const char* slash1 = NULL;
+    const char* slash2 = NULL;
+    for( p = TextStream::skipSpaces(p, end); p < end && *p != ' ' && *p != '\t' && !slash2; ++p )
+    {
+      if (*p == '/')
+      {
+        if (!slash1)
+          slash1 = p;
+        else
+          slash2 = p;
+      }
+    }
+    if (!slash1)
+      return 0;
+    else
+    if (!slash2)
+      return 1;
+    else
+      return slash2 == slash1+1 ? 2 : 3;
+  }
+
+  //! Converts a 1-based OBJ index, or a negative one relative to the \p count elements defined so far, to a 0-based index.
+  //! Returns -1 for a missing (0) index.
+  inline int resolveIndex(int i, int count)
+  {
+    return i > 0 ? i - 1 : (i < 0 ? count + i : -1);
+  }
+
+  //! Iterates the lines of an in memory OBJ file joining the lines continued with a '\'.
+  class ObjLineReader
+  {
+  public:
+    ObjLineReader(const char* begin, const char* end): mPtr(begin), mEnd(end) {}
+
+    //! Returns the next trimmed line, which may be empty.
+    bool next(const char*& line, const char*& line_end)
+    {
+      if ( !physicalLine(line, line_end) )
+        return false;
+      trimLine(line, line_end);
+      if ( line < line_end && line_end[-1] == '\\' && line[0] != '#' )
+      {
+        mJoined.assign(line, line_end);
+        const char* next_line = NULL;
+        const char* next_line_end = NULL;
+        while( mJoined[mJoined.length()-1] == '\\' && physicalLine(next_line, next_line_end) )
+        {
+          mJoined[mJoined.length()-1] = ' ';
+          mJoined = String::trimStdString(mJoined) + ' ';
+          trimLine(next_line, next_line_end);
+          mJoined.append(next_line, next_line_end);
+        }
+        line = mJoined.c_str();
+        line_end = line + mJoined.size();
+      }
+      return true;
+    }
+
+  protected:
+    bool physicalLine(const char*& line, const char*& line_end)
+    {
+      if ( mPtr >= mEnd )
+        return false;
+      line = mPtr;
+      const char* eol = (const char*)memchr(mPtr, '\n', mEnd - mPtr);
+      const char* cr  = (const char*)memchr(mPtr, '\r', (eol ? eol : mEnd) - mPtr);
+      if (cr)
+        eol = cr;
+      if (!eol)
+      {
+        line_end = mPtr = mEnd;
+        return true;
+      }
+      line_end = eol;
+      mPtr = eol + 1;
+      // CR/LF and LF/CR pairs
+      if ( mPtr < mEnd && (*mPtr == '\r' || *mPtr == '\n') && *mPtr != *eol )
+        ++mPtr;
+      return true;
+    }
+
+  protected:
+    const char* mPtr;
+    const char* mEnd;
+    std::string mJoined;
+  };
+
+  //! Returns the start of the first line after \p p which is not the continuation of a line ending with '\'.
+  const char* nextLineStart(const char* p, const char* end)
+  {
+    while( p < end )
+    {
+      const char* nl = (const char*)memchr(p, '\n', end - p);
+      if (!nl)
+        return end;
+      const char* last = nl;
+      while( last > p && (last[-1] == '\r' || last[-1] == ' ' || last[-1] == '\t') )
+        --last;
+      p = nl + 1;
+      if ( last == nl || last[-1] != '\\' )
+        break;
+    }
+    return p < end ? p : end;
+  }
+
+  //! A line aligned portion of an OBJ file parsed by ObjLoader::parseParallel().
+  struct ObjChunk
+  {
+    typedef enum { Faces, Object, UseMtl, MtlLib } ECommand;
+
+    //! The statements changing the current mesh and the ranges of faces in between them, in file order.
+    struct Command
+    {
+      ECommand mType;
+      std::string mArg;
+      int mFaceBegin, mFaceEnd;
+      int mVertexBegin, mVertexEnd;
+      int mFormat;
+    };
+
+    ObjChunk(): mBegin(NULL), mEnd(NULL), mCoordCount(0), mNormalCount(0), mTexCoordCount(0), mCoordOffset(0), mNormalOffset(0), mTexCoordOffset(0) {}
+
+    const char* mBegin;
+    const char* mEnd;
+    int mCoordCount, mNormalCount, mTexCoordCount;
+    int mCoordOffset, mNormalOffset, mTexCoordOffset;
+    std::vector<fvec4> mCoords;
+    std::vector<fvec3> mNormals;
+    std::vector<fvec3> mTexCoords;
+    std::vector<int> mFaceType;
+    std::vector<int> mPositionIndex;
+    std::vector<int> mTexCoordIndex;
+    std::vector<int> mNormalIndex;
+    std::vector<Command> mCommands;
+  };
+
+  //! Returns the length of the first token of the line and stores its end in \p cmd_end.
+  inline int commandLength(const char* line, const char* line_end, const char*& cmd_end)
+  {
+    cmd_end = line;
+    while( cmd_end < line_end && *cmd_end != ' ' && *cmd_end != '\t' )
+      ++cmd_end;
+    return (int)(cmd_end - line);
+  }
+
+  inline bool isCommand(const char* line, int length, const char* cmd)
+  {
+    return (int)strlen(cmd) == length && strncmp(line, cmd, length) == 0;
+  }
+
+  //! First pass: counts the vertex data so that the chunks know the global index of their first element.
+  void countChunk(ObjChunk& chunk)
+  {
+    ObjLineReader reader(chunk.mBegin, chunk.mEnd);
+    const char* line = NULL;
+    const char* line_end = NULL;
+    const char* cmd_end = NULL;
+    while( reader.next(line, line_end) )
+    {
+      if (line == line_end || line[0] != 'v')
+        continue;
+      int len = commandLength(line, line_end, cmd_end);
+      if ( len == 1 )
+        ++chunk.mCoordCount;
+      else
+      if ( isCommand(line, len, "vn") )
+        ++chunk.mNormalCount;
+      else
+      if ( isCommand(line, len, "vt") )
+        ++chunk.mTexCoordCount;
+    }
+  }
+
+  //! Second pass: parses the vertex data and the faces resolving the indices to the global arrays.
+  void parseChunk(ObjChunk& chunk)
+  {
+    chunk.mCoords.reserve(chunk.mCoordCount);
+    chunk.mNormals.reserve(chunk.mNormalCount);
+    chunk.mTexCoords.reserve(chunk.mTexCoordCount);
+
+    ObjLineReader reader(chunk.mBegin, chunk.mEnd);
+    const char* line = NULL;
+    const char* line_end = NULL;
+    const char* cmd_end = NULL;
+    while( reader.next(line, line_end) )
+    {
+      if (line == line_end || line[0] == '#')
+        continue;
+      int len = commandLength(line, line_end, cmd_end);
+
+      if ( isCommand(line, len, "v") )
+      {
+        float v[] = { 0, 0, 0, 1.0f };
+        parseFloats(cmd_end, line_end, v, 3);
+        append(chunk.mCoords, fvec4(v[0],v[1],v[2],v[3]));
+      }
+      else
+      if ( isCommand(line, len, "vt") )
+      {
+        float v[] = { 0, 0, 0 };
+        parseFloats(cmd_end, line_end, v, 3);
+        append(chunk.mTexCoords, fvec3(v[0],v[1],v[2]));
+      }
+      else
+      if ( isCommand(line, len, "vn") )
+      {
+        float v[] = { 0, 0, 0 };
+        parseFloats(cmd_end, line_end, v, 3);
+        append(chunk.mNormals, fvec3(v[0],v[1],v[2]));
+      }
+      else
+      if ( isCommand(line, len, "f") )
+      {
+        if ( chunk.mCommands.empty() || chunk.mCommands.back().mType != ObjChunk::Faces )
+        {
+          ObjChunk::Command cmd;
+          cmd.mType = ObjChunk::Faces;
+          cmd.mFaceBegin = cmd.mFaceEnd = (int)chunk.mFaceType.size();
+          cmd.mVertexBegin = cmd.mVertexEnd = (int)chunk.mPositionIndex.size();
+          cmd.mFormat = detectFaceFormat(cmd_end, line_end);
+          chunk.mCommands.push_back(cmd);
+        }
+
+        // the global number of elements defined so far, for relative indices
+        int coord_count     = chunk.mCoordOffset    + (int)chunk.mCoords.size();
+        int normal_count    = chunk.mNormalOffset   + (int)chunk.mNormals.size();
+        int tex_coord_count = chunk.mTexCoordOffset + (int)chunk.mTexCoords.size();
+
+        int face_type = 0;
+        for( const char* p = TextStream::skipSpaces(cmd_end, line_end); p < line_end; p = TextStream::skipSpaces(p, line_end) )
+        {
+          ++face_type;
+          int iv=0,ivt=0,ivn=0;
+          parseFaceVertex(p, line_end, iv, ivt, ivn);
+          while( p < line_end && *p != ' ' && *p != '\t' )
+            ++p;
+          append(chunk.mPositionIndex, resolveIndex(iv,  coord_count));
+          append(chunk.mTexCoordIndex, resolveIndex(ivt, tex_coord_count));
+          append(chunk.mNormalIndex,   resolveIndex(ivn, normal_count));
+        }
+        append(chunk.mFaceType, face_type);
+        chunk.mCommands.back().mFaceEnd = (int)chunk.mFaceType.size();
+        chunk.mCommands.back().mVertexEnd = (int)chunk.mPositionIndex.size();
+      }
+      else
+      if ( isCommand(line, len, "o") || isCommand(line, len, "usemtl") || isCommand(line, len, "mtllib") )
+      {
+        ObjChunk::Command cmd;
+        cmd.mType = line[0] == 'o' ? ObjChunk::Object : (line[0] == 'u' ? ObjChunk::UseMtl : ObjChunk::MtlLib);
+        cmd.mArg = String::trimStdString( std::string(cmd_end, line_end) );
+        cmd.mFaceBegin = cmd.mFaceEnd = cmd.mVertexBegin = cmd.mVertexEnd = cmd.mFormat = 0;
+        chunk.mCommands.push_back(cmd);
+      }
+    }
+  }
+
+  //! The triangles of an ObjMesh sharing the vertices with the same position/normal/texture coordinate indices.
+  struct WeldedMesh
+  {
+    WeldedMesh(): mValid(false) {}
+
+    std::vector<fvec3> mPositions;
+    std::vector<fvec3> mNormals;
+    std::vector<fvec2> mTexCoords;
+    std::vector<unsigned int> mIndices;
+    bool mValid;
+  };
+
+  inline unsigned int hashCorner(int p, int t, int n)
+  {
+    unsigned int h = (unsigned int)p * 73856093u ^ (unsigned int)t * 19349663u ^ (unsigned int)n * 83492791u;
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+  }
+
+  //! Triangulates \p mesh, each distinct combination of indices becomes a vertex. Leaves \p out invalid if an index is out of range.
+  void weldMesh(const ObjMesh* mesh, const std::vector<fvec4>& coords, const std::vector<fvec3>& normals, const std::vector<fvec3>& tex_coords, WeldedMesh& out)
+  {
+    const std::vector<int>& ipos = mesh->facePositionIndex();
+    const std::vector<int>& inrm = mesh->faceNormalIndex();
+    const std::vector<int>& itex = mesh->faceTexCoordIndex();
+    const bool has_normals = !inrm.empty();
+    const bool has_tex_coords = !itex.empty();
+    const unsigned int corner_count = (unsigned int)ipos.size();
+
+    for(unsigned int i=0; i<corner_count; ++i)
+    {
+      if ( ipos[i] < 0 || ipos[i] >= (int)coords.size() )
+        return;
+      if ( has_normals && (inrm[i] < 0 || inrm[i] >= (int)normals.size()) )
+        return;
+      if ( has_tex_coords && (itex[i] < 0 || itex[i] >= (int)tex_coords.size()) )
+        return;
+    }
+
+    // open addressing hash table from the corner indices to the vertex, see also DoubleVertexRemover::computeMapHash()
+    unsigned int table_size = 1;
+    while(table_size < corner_count * 2)
+      table_size <<= 1;
+    const unsigned int mask = table_size - 1;
+    std::vector<unsigned int> table( table_size, 0xFFFFFFFF );
+    // the first corner referring to each vertex
+    std::vector<unsigned int> vertex_corner;
+    std::vector<unsigned int> corner_vertex( corner_count );
+
+    for(unsigned int i=0; i<corner_count; ++i)
+    {
+      int p = ipos[i];
+      int t = has_tex_coords ? itex[i] : -1;
+      int n = has_normals ? inrm[i] : -1;
+      for(unsigned int slot = hashCorner(p, t, n) & mask; ; slot = (slot + 1) & mask)
+      {
+        unsigned int v = table[slot];
+        if (v == 0xFFFFFFFF)
+        {
+          v = table[slot] = (unsigned int)vertex_corner.size();
+          vertex_corner.push_back(i);
+          corner_vertex[i] = v;
+          break;
+        }
+        unsigned int c = vertex_corner[v];
+        if ( ipos[c] == p && (!has_tex_coords || itex[c] == t) && (!has_normals || inrm[c] == n) )
+        {
+          corner_vertex[i] = v;
+          break;
+        }
+      }
+    }
+
+    const size_t vert_count = vertex_corner.size();
+    out.mPositions.resize(vert_count);
+    if (has_normals)
+      out.mNormals.resize(vert_count);
+    if (has_tex_coords)
+      out.mTexCoords.resize(vert_count);
+    for(size_t v=0; v<vert_count; ++v)
+    {
+      unsigned int c = vertex_corner[v];
+      out.mPositions[v] = coords[ipos[c]].xyz();
+      if (has_normals)
+        out.mNormals[v] = normals[inrm[c]];
+      if (has_tex_coords)
+        out.mTexCoords[v] = tex_coords[itex[c]].st();
+    }
+
+    // triangle fans, like the non indexed path
+    unsigned int base = 0;
+    for(size_t iface=0; iface<mesh->face_type().size(); ++iface)
+    {
+      int type = mesh->face_type()[iface];
+      for( int ivert=2; ivert < type; ++ivert )
+      {
+        out.mIndices.push_back( corner_vertex[base] );
+        out.mIndices.push_back( corner_vertex[base+ivert-1] );
+        out.mIndices.push_back( corner_vertex[base+ivert] );
+      }
+      base += type;
+    }
+
+    out.mValid = true;
+  }
 }
 //-----------------------------------------------------------------------------
 // ObjTexture
@@ -334,37 +738,63 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     bool smoothing_group = false;
   #endif
 
-  std::string stdstr_line;
-  while( stream->readLine(stdstr_line) )
+  // the lines are parsed in place in the stream buffer, see TextStream::readLineView()
+  const char* line = NULL;
+  const char* line_end = NULL;
+  int line_length = 0;
+  std::string multi_line;
+  if ( threadCount() > 1 )
+  {
+    if ( !parseParallel(file, mMaterials, mMeshes) )
+    {
+      stream->inputFile()->close();
+      return NULL;
+    }
+  }
+  else
+  while( stream->readLineView(line, line_length) )
   {
     ++line_count;
-    std::string line = String::trimStdString(stdstr_line);
-    if (line.empty() || line[0] == '#')
+    line_end = line + line_length;
+    trimLine(line, line_end);
+    if (line == line_end || line[0] == '#')
       continue;
 
     // note: comments cannot be multiline
-    while( line[line.length()-1] == '\\' && stream->readLine(stdstr_line) )
+    if ( line_end[-1] == '\\' )
     {
-      ++line_count;
-      // remove "\"
-      line[line.length()-1] = ' ';
-      // remove spaces before \ and insert a single ' ' space
-      line = String::trimStdString(line) + ' ';
-      // appends new line
-      line += String::trimStdString(stdstr_line);
+      multi_line.assign(line, line_end);
+      while( multi_line[multi_line.length()-1] == '\\' && stream->readLineView(line, line_length) )
+      {
+        ++line_count;
+        // remove "\"
+        multi_line[multi_line.length()-1] = ' ';
+        // remove spaces before \ and insert a single ' ' space
+        multi_line = String::trimStdString(multi_line) + ' ';
+        // appends new line
+        line_end = line + line_length;
+        trimLine(line, line_end);
+        multi_line.append(line, line_end);
+      }
+      line = multi_line.c_str();
+      line_end = line + multi_line.size();
     }
 
-    cmd[0] = 0;
-    sscanf(line.c_str(), "%s ", cmd);
+    const char* cmd_end = line;
+    while( cmd_end < line_end && *cmd_end != ' ' && *cmd_end != '\t' )
+      ++cmd_end;
+    int cmd_length = std::min( (int)(cmd_end - line), BUF_SIZE-1 );
+    memcpy(cmd, line, cmd_length);
+    cmd[cmd_length] = 0;
     if ( !cmd[0] )
       continue;
 // ----------------------------------------------------------------------------
     // Vertex data:
     if (strcmp(cmd,"v") == 0) // Geometric vertices
     {
-      float x=0,y=0,z=0,w=1.0f;
-      sscanf(line.c_str()+2,"%f %f %f", &x, &y, &z);
-      append(mCoords,fvec4(x,y,z,w));
+      float v[] = { 0, 0, 0, 1.0f };
+      parseFloats(cmd_end, line_end, v, 3);
+      append(mCoords,fvec4(v[0],v[1],v[2],v[3]));
       /*append(mCoords,x);
       append(mCoords,y);
       append(mCoords,z);
@@ -374,9 +804,9 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     if (strcmp(cmd,"vt") == 0) // Texture vertices
     {
       // note, this might have less than 3 mCoords
-      float x=0,y=0,z=0;
-      sscanf(line.c_str()+3,"%f %f %f", &x, &y, &z);
-      append(mTexCoords,fvec3(x,y,z));
+      float v[] = { 0, 0, 0 };
+      parseFloats(cmd_end, line_end, v, 3);
+      append(mTexCoords,fvec3(v[0],v[1],v[2]));
       /*append(mTexCoords,x);
       append(mTexCoords,y);
       append(mTexCoords,z);*/
@@ -384,9 +814,9 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     else
     if (strcmp(cmd,"vn") == 0) // Vertex mNormals
     {
-      float x=0,y=0,z=0;
-      sscanf(line.c_str()+3,"%f %f %f", &x, &y, &z);
-      append(mNormals,fvec3(x,y,z));
+      float v[] = { 0, 0, 0 };
+      parseFloats(cmd_end, line_end, v, 3);
+      append(mNormals,fvec3(v[0],v[1],v[2]));
       /*append(mNormals,x);
       append(mNormals,y);
       append(mNormals,z);*/
@@ -411,11 +841,10 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
 
         // detect vertex format
 
-        int i=1;
-        while( line[i] == ' ' || line[i] == '\t' ) ++i;
+        int i = (int)(TextStream::skipSpaces(cmd_end, line_end) - line);
         int slash1 = 0;
         int slash2 = 0;
-        while( i < (int)line.size() && line[i] != ' ' && line[i] != '\t' )
+        while( i < (int)(line_end - line) && line[i] != ' ' && line[i] != '\t' )
         {
           if (line[i] == '/')
           {
@@ -448,57 +877,48 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
 
       int face_type = 0;
       // divide into tokens
-      for(size_t i=0; i < line.size(); ++i)
+      for( const char* p = TextStream::skipSpaces(cmd_end, line_end); p < line_end; p = TextStream::skipSpaces(p, line_end) )
       {
-        if (line[i] == ' ')
-        {
-          ++face_type;
-
-          // eat all the spaces
-          while( line[i] == ' ' )
-            ++i;
+        ++face_type;
 
-          if (line[i] == 0)
-            break;
+        int iv=0,ivt=0,ivn=0;
+        parseFaceVertex(p, line_end, iv, ivt, ivn);
+        // skip the rest of the token
+        while( p < line_end && *p != ' ' && *p != '\t' )
+          ++p;
 
-          int iv=-1,ivt=-1,ivn=-1;
-          // 0 = f v       v       v
-          // 1 = f v/vt    v/vt    v/vt
-          // 2 = f v//vn   v//vn   v//vn
-          // 3 = f v/vt/vn v/vt/vn v/vt/vn
-          switch(f_format_type)
-          {
-          case 0:
-            sscanf(line.c_str()+i, "%d", &iv);
-            if (iv>0)  --iv; else  iv  = (int)mCoords.size()    - iv;
-            append(cur_mesh->facePositionIndex(), iv);
-            break;
-          case 1:
-            sscanf(line.c_str()+i, "%d/%d", &iv,&ivt);
-            if (iv>0)  --iv; else  iv  = (int)mCoords.size()    - iv;
-            if (ivt>0) --ivt; else ivt = (int)mTexCoords.size() - ivt;
-            append(cur_mesh->facePositionIndex(), iv);
-            append(cur_mesh->faceTexCoordIndex(), ivt);
-            break;
-          case 2:
-            sscanf(line.c_str()+i, "%d//%d", &iv,&ivn);
-            if (iv>0)  --iv; else  iv  = (int)mCoords.size()    - iv;
-            if (ivn>0) --ivn; else ivn = (int)mNormals.size()   - ivn;
-            append(cur_mesh->facePositionIndex(), iv);
-            append(cur_mesh->faceNormalIndex(), ivn);
-            break;
-          case 3:
-            sscanf(line.c_str()+i, "%d/%d/%d", &iv,&ivt,&ivn);
-            if (iv>0)  --iv; else  iv  = (int)mCoords.size()    - iv;
-            if (ivt>0) --ivt; else ivt = (int)mTexCoords.size() - ivt;
-            if (ivn>0) --ivn; else ivn = (int)mNormals.size()   - ivn;
-            append(cur_mesh->facePositionIndex(), iv);
-            append(cur_mesh->faceTexCoordIndex(), ivt);
-            append(cur_mesh->faceNormalIndex(), ivn);
-            break;
-          default:
-            break;
-          }
+        // 0 = f v       v       v
+        // 1 = f v/vt    v/vt    v/vt
+        // 2 = f v//vn   v//vn   v//vn
+        // 3 = f v/vt/vn v/vt/vn v/vt/vn
+        switch(f_format_type)
+        {
+        case 0:
+          iv  = resolveIndex(iv,  (int)mCoords.size());
+          append(cur_mesh->facePositionIndex(), iv);
+          break;
+        case 1:
+          iv  = resolveIndex(iv,  (int)mCoords.size());
+          ivt = resolveIndex(ivt, (int)mTexCoords.size());
+          append(cur_mesh->facePositionIndex(), iv);
+          append(cur_mesh->faceTexCoordIndex(), ivt);
+          break;
+        case 2:
+          iv  = resolveIndex(iv,  (int)mCoords.size());
+          ivn = resolveIndex(ivn, (int)mNormals.size());
+          append(cur_mesh->facePositionIndex(), iv);
+          append(cur_mesh->faceNormalIndex(), ivn);
+          break;
+        case 3:
+          iv  = resolveIndex(iv,  (int)mCoords.size());
+          ivt = resolveIndex(ivt, (int)mTexCoords.size());
+          ivn = resolveIndex(ivn, (int)mNormals.size());
+          append(cur_mesh->facePositionIndex(), iv);
+          append(cur_mesh->faceTexCoordIndex(), ivt);
+          append(cur_mesh->faceNormalIndex(), ivn);
+          break;
+        default:
+          break;
         }
       }
       VL_CHECK(face_type > 2)
@@ -599,7 +1019,7 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     if (strcmp(cmd,"o") == 0) // Object name
     {
       starts_new_geom = true;
-      object_name = String::trimStdString(line.c_str()+1);
+      object_name = String::trimStdString( std::string(cmd_end, line_end) );
     }
     else
 // ----------------------------------------------------------------------------
@@ -623,31 +1043,14 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     if (strcmp(cmd,"usemtl") == 0) // Material name
     {
       starts_new_geom = true;
-      std::string mat_name = String(line.c_str()+6).trim().toStdString();
+      std::string mat_name = String( std::string(cmd_end, line_end).c_str() ).trim().toStdString();
       // can also become NULL
       cur_material = mMaterials[mat_name];
     }
     else
     if (strcmp(cmd,"mtllib") == 0) // Material library
     {
-      // creates the path for the mtl
-      String path = file->path().extractPath() + String(line.c_str()+7).trim();
-      ref<VirtualFile> vfile = defFileSystem()->locateFile(path, file->path().extractPath());
-      std::string str_file = file->path().toStdString();
-      std::string str_path = path.toStdString();
-      if (vfile)
-      {
-        // reads the material
-        std::vector<ObjMaterial> mats;
-        loadObjMaterials(vfile.get(), mats);
-        // updates the material library
-        for(size_t i=0; i < mats.size(); ++i)
-          mMaterials[mats[i].objectName()] = new ObjMaterial(mats[i]);
-      }
-      else
-      {
-        Log::error( Say("Could not find OBJ material file '%s'.\n") << path );
-      }
+      loadMaterialLibrary(file, std::string(cmd_end, line_end), mMaterials);
     }
     /*else
     if (strcmp(cmd,"shadow_obj") == 0) // Shadow casting
@@ -774,6 +1177,18 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
     }
   }
 
+  // in parallel mode the meshes are welded and indexed concurrently, the VL objects are created below
+  std::vector<WeldedMesh> welded;
+  if ( threadCount() > 1 )
+  {
+    welded.resize( mMeshes.size() );
+    #ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount)
+    #endif
+    for(int imesh=0; imesh<(int)mMeshes.size(); ++imesh)
+      weldMesh( mMeshes[imesh].get(), mCoords, mNormals, mTexCoords, welded[imesh] );
+  }
+
   for(int imesh=0; imesh<(int)mMeshes.size(); ++imesh)
   {
     if ( mMeshes[imesh]->facePositionIndex().empty() )
@@ -790,11 +1205,6 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
       VL_CHECK( sum == (int)mMeshes[imesh]->facePositionIndex().size() )
     #endif
 
-    ref< ArrayFloat3 >   v_coords  = new ArrayFloat3;
-    ref< ArrayFloat3 >   n_coords  = new ArrayFloat3;
-    // we support only 2d textures
-    ref< ArrayFloat2 >   t_coords2 = new ArrayFloat2;
-
     if ( !mMeshes[imesh]->faceNormalIndex().empty() && mMeshes[imesh]->faceNormalIndex().size() != mMeshes[imesh]->facePositionIndex().size() )
     {
       Log::print("OBJ mesh corrupted.\n");
@@ -807,94 +1217,139 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
       continue;
     }
 
-    // allocate vertex buffer
+    // Geometry
 
-    int tri_verts_count = 0;
-    for(int k=0; k<(int)mMeshes[imesh]->face_type().size(); ++k)
-      tri_verts_count += (mMeshes[imesh]->face_type()[k] - 2) * 3;
+    ref<Geometry> geom = new Geometry;
+    geom->setObjectName(mMeshes[imesh]->objectName().c_str());
+
+    if ( !welded.empty() )
+    {
+      const WeldedMesh& mesh = welded[imesh];
+      if ( !mesh.mValid )
+      {
+        Log::print("OBJ mesh corrupted.\n");
+        continue;
+      }
+
+      ref< ArrayFloat3 > v_coords = new ArrayFloat3;
+      v_coords->resize( mesh.mPositions.size() );
+      memcpy( v_coords->ptr(), &mesh.mPositions[0], v_coords->bytesUsed() );
+      geom->setVertexArray( v_coords.get() );
 
-    v_coords->resize( tri_verts_count );
-    if ( !mMeshes[imesh]->faceNormalIndex().empty() )
-      n_coords->resize( tri_verts_count );
-    if ( !mMeshes[imesh]->faceTexCoordIndex().empty() )
-      t_coords2->resize( tri_verts_count );
+      if ( !mesh.mNormals.empty() )
+      {
+        ref< ArrayFloat3 > n_coords = new ArrayFloat3;
+        n_coords->resize( mesh.mNormals.size() );
+        memcpy( n_coords->ptr(), &mesh.mNormals[0], n_coords->bytesUsed() );
+        geom->setNormalArray( n_coords.get() );
+      }
 
-    // fill geometry
+      if ( !mesh.mTexCoords.empty() )
+      {
+        ref< ArrayFloat2 > t_coords2 = new ArrayFloat2;
+        t_coords2->resize( mesh.mTexCoords.size() );
+        memcpy( t_coords2->ptr(), &mesh.mTexCoords[0], t_coords2->bytesUsed() );
+        geom->setTexCoordArray( 0, t_coords2.get() );
+      }
 
-    int src_base_idx = 0;
-    int dst_base_idx = 0;
-    for(int iface=0; iface<(int)mMeshes[imesh]->face_type().size(); ++iface)
+      ref<DrawElementsUInt> de = new DrawElementsUInt(PT_TRIANGLES);
+      de->indexBuffer()->resize( mesh.mIndices.size() );
+      if ( !mesh.mIndices.empty() )
+        memcpy( de->indexBuffer()->ptr(), &mesh.mIndices[0], mesh.mIndices.size() * sizeof(unsigned int) );
+      geom->drawCalls().push_back( de.get() );
+    }
+    else
     {
-      int type = mMeshes[imesh]->face_type()[iface];
-      for( int ivert=2; ivert < type; ++ivert )
+      ref< ArrayFloat3 >   v_coords  = new ArrayFloat3;
+      ref< ArrayFloat3 >   n_coords  = new ArrayFloat3;
+      // we support only 2d textures
+      ref< ArrayFloat2 >   t_coords2 = new ArrayFloat2;
+
+      // allocate vertex buffer
+
+      int tri_verts_count = 0;
+      for(int k=0; k<(int)mMeshes[imesh]->face_type().size(); ++k)
+        tri_verts_count += (mMeshes[imesh]->face_type()[k] - 2) * 3;
+
+      v_coords->resize( tri_verts_count );
+      if ( !mMeshes[imesh]->faceNormalIndex().empty() )
+        n_coords->resize( tri_verts_count );
+      if ( !mMeshes[imesh]->faceTexCoordIndex().empty() )
+        t_coords2->resize( tri_verts_count );
+
+      // fill geometry
+
+      int src_base_idx = 0;
+      int dst_base_idx = 0;
+      for(int iface=0; iface<(int)mMeshes[imesh]->face_type().size(); ++iface)
       {
-        int a = mMeshes[imesh]->facePositionIndex()[src_base_idx+0];
-        int b = mMeshes[imesh]->facePositionIndex()[src_base_idx+ivert-1];
-        int c = mMeshes[imesh]->facePositionIndex()[src_base_idx+ivert];
-
-        VL_CHECK( a>= 0)
-        VL_CHECK( b>= 0)
-        VL_CHECK( c>= 0)
-        VL_CHECK( a<(int)mCoords.size() )
-        VL_CHECK( b<(int)mCoords.size() )
-        VL_CHECK( c<(int)mCoords.size() )
-
-        v_coords->at(dst_base_idx+0) = mCoords[a].xyz();
-        v_coords->at(dst_base_idx+1) = mCoords[b].xyz();
-        v_coords->at(dst_base_idx+2) = mCoords[c].xyz();
-
-        if (!mMeshes[imesh]->faceNormalIndex().empty())
+        int type = mMeshes[imesh]->face_type()[iface];
+        for( int ivert=2; ivert < type; ++ivert )
         {
-          int na = mMeshes[imesh]->faceNormalIndex()[src_base_idx+0];
-          int nb = mMeshes[imesh]->faceNormalIndex()[src_base_idx+ivert-1];
-          int nc = mMeshes[imesh]->faceNormalIndex()[src_base_idx+ivert];
-
-          VL_CHECK( na>= 0)
-          VL_CHECK( nb>= 0)
-          VL_CHECK( nc>= 0)
-          VL_CHECK( na<(int)mNormals.size() )
-          VL_CHECK( nb<(int)mNormals.size() )
-          VL_CHECK( nc<(int)mNormals.size() )
-
-          n_coords->at(dst_base_idx+0) = mNormals[na];
-          n_coords->at(dst_base_idx+1) = mNormals[nb];
-          n_coords->at(dst_base_idx+2) = mNormals[nc];
-        }
+          int a = mMeshes[imesh]->facePositionIndex()[src_base_idx+0];
+          int b = mMeshes[imesh]->facePositionIndex()[src_base_idx+ivert-1];
+          int c = mMeshes[imesh]->facePositionIndex()[src_base_idx+ivert];
 
-        // we consider all the texture coords as 2d
-        if (!mMeshes[imesh]->faceTexCoordIndex().empty())
-        {
-          int na = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+0];
-          int nb = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+ivert-1];
-          int nc = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+ivert];
-
-          VL_CHECK( na>= 0)
-          VL_CHECK( nb>= 0)
-          VL_CHECK( nc>= 0)
-          VL_CHECK( na<(int)mTexCoords.size() )
-          VL_CHECK( nb<(int)mTexCoords.size() )
-          VL_CHECK( nc<(int)mTexCoords.size() )
-
-          t_coords2->at(dst_base_idx+0) = mTexCoords[na].st();
-          t_coords2->at(dst_base_idx+1) = mTexCoords[nb].st();
-          t_coords2->at(dst_base_idx+2) = mTexCoords[nc].st();
-        }
+          VL_CHECK( a>= 0)
+          VL_CHECK( b>= 0)
+          VL_CHECK( c>= 0)
+          VL_CHECK( a<(int)mCoords.size() )
+          VL_CHECK( b<(int)mCoords.size() )
+          VL_CHECK( c<(int)mCoords.size() )
 
-        dst_base_idx+=3;
-      }
-      src_base_idx += type;
-    }
+          v_coords->at(dst_base_idx+0) = mCoords[a].xyz();
+          v_coords->at(dst_base_idx+1) = mCoords[b].xyz();
+          v_coords->at(dst_base_idx+2) = mCoords[c].xyz();
 
-    // Geometry
+          if (!mMeshes[imesh]->faceNormalIndex().empty())
+          {
+            int na = mMeshes[imesh]->faceNormalIndex()[src_base_idx+0];
+            int nb = mMeshes[imesh]->faceNormalIndex()[src_base_idx+ivert-1];
+            int nc = mMeshes[imesh]->faceNormalIndex()[src_base_idx+ivert];
 
-    ref<Geometry> geom = new Geometry;
-    geom->setObjectName(mMeshes[imesh]->objectName().c_str());
-    geom->setVertexArray( v_coords.get() );
-    if ( mMeshes[imesh]->faceNormalIndex().size() )
-      geom->setNormalArray( n_coords.get() );
-    if ( mMeshes[imesh]->faceTexCoordIndex().size() )
-      geom->setTexCoordArray(0, t_coords2.get() );
-    geom->drawCalls().push_back( new DrawArrays(PT_TRIANGLES, 0, tri_verts_count) );
+            VL_CHECK( na>= 0)
+            VL_CHECK( nb>= 0)
+            VL_CHECK( nc>= 0)
+            VL_CHECK( na<(int)mNormals.size() )
+            VL_CHECK( nb<(int)mNormals.size() )
+            VL_CHECK( nc<(int)mNormals.size() )
+
+            n_coords->at(dst_base_idx+0) = mNormals[na];
+            n_coords->at(dst_base_idx+1) = mNormals[nb];
+            n_coords->at(dst_base_idx+2) = mNormals[nc];
+          }
+
+          // we consider all the texture coords as 2d
+          if (!mMeshes[imesh]->faceTexCoordIndex().empty())
+          {
+            int na = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+0];
+            int nb = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+ivert-1];
+            int nc = mMeshes[imesh]->faceTexCoordIndex()[src_base_idx+ivert];
+
+            VL_CHECK( na>= 0)
+            VL_CHECK( nb>= 0)
+            VL_CHECK( nc>= 0)
+            VL_CHECK( na<(int)mTexCoords.size() )
+            VL_CHECK( nb<(int)mTexCoords.size() )
+            VL_CHECK( nc<(int)mTexCoords.size() )
+
+            t_coords2->at(dst_base_idx+0) = mTexCoords[na].st();
+            t_coords2->at(dst_base_idx+1) = mTexCoords[nb].st();
+            t_coords2->at(dst_base_idx+2) = mTexCoords[nc].st();
+          }
+
+          dst_base_idx+=3;
+        }
+        src_base_idx += type;
+      }
+
+      geom->setVertexArray( v_coords.get() );
+      if ( mMeshes[imesh]->faceNormalIndex().size() )
+        geom->setNormalArray( n_coords.get() );
+      if ( mMeshes[imesh]->faceTexCoordIndex().size() )
+        geom->setTexCoordArray(0, t_coords2.get() );
+      geom->drawCalls().push_back( new DrawArrays(PT_TRIANGLES, 0, tri_verts_count) );
+    }
 
     // Material/Effect
 
@@ -923,6 +1378,198 @@ ref<ResourceDatabase> ObjLoader::loadOBJ( VirtualFile* file )
   return res_db;
 }
 //-----------------------------------------------------------------------------
+void ObjLoader::loadMaterialLibrary(VirtualFile* file, const std::string& mtllib, std::map< std::string, ref<ObjMaterial> >& materials)
+{
+  // creates the path for the mtl
+  String path = file->path().extractPath() + String( mtllib.c_str() ).trim();
+  ref<VirtualFile> vfile = defFileSystem()->locateFile(path, file->path().extractPath());
+  if (vfile)
+  {
+    // reads the material
+    std::vector<ObjMaterial> mats;
+    loadObjMaterials(vfile.get(), mats);
+    // updates the material library
+    for(size_t i=0; i < mats.size(); ++i)
+      materials[mats[i].objectName()] = new ObjMaterial(mats[i]);
+  }
+  else
+  {
+    Log::error( Say("Could not find OBJ material file '%s'.\n") << path );
+  }
+}
+//-----------------------------------------------------------------------------
+bool ObjLoader::parseParallel(VirtualFile* file, std::map< std::string, ref<ObjMaterial> >& materials, std::vector< ref<ObjMesh> >& meshes)
+{
+  // access the whole file, without copying it if it is memory mapped
+  long long size = file->size();
+  if (size < 0)
+  {
+    Log::error( Say("loadOBJ(): could not read '%s'.\n") << file->path() );
+    return false;
+  }
+  std::vector<char> storage;
+  const char* data = NULL;
+  MappedFile* mapped = file->as<MappedFile>();
+  if ( mapped && size )
+    data = (const char*)mapped->mappedPtr(0, size);
+  if ( !data && size )
+  {
+    storage.resize( (size_t)size );
+    if ( file->read(&storage[0], size) != size )
+    {
+      Log::error( Say("loadOBJ(): could not read '%s'.\n") << file->path() );
+      return false;
+    }
+    data = &storage[0];
+  }
+  const char* data_end = data + size;
+
+  // split the file in line aligned chunks, a few per thread to balance the load.
+  // Files using CR only line terminators are parsed as a single chunk.
+  std::vector<ObjChunk> chunks;
+  int chunk_count = mThreadCount * 4;
+  if ( size && !memchr(data, '\n', (size_t)size) )
+    chunk_count = 1;
+  const char* chunk_begin = data;
+  for(int i=1; i<=chunk_count && chunk_begin < data_end; ++i)
+  {
+    const char* chunk_end = i == chunk_count ? data_end : data + size * i / chunk_count;
+    if ( chunk_end < chunk_begin )
+      chunk_end = chunk_begin;
+    // the chunk ends after a complete line
+    if ( chunk_end < data_end )
+      chunk_end = nextLineStart(chunk_end > data ? chunk_end - 1 : chunk_end, data_end);
+    chunks.push_back( ObjChunk() );
+    chunks.back().mBegin = chunk_begin;
+    chunks.back().mEnd   = chunk_end;
+    chunk_begin = chunk_end;
+  }
+
+  // count the vertex data of each chunk and compute where they start in the global arrays
+
+  #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount)
+  #endif
+  for(int i=0; i<(int)chunks.size(); ++i)
+    countChunk(chunks[i]);
+
+  for(size_t i=1; i<chunks.size(); ++i)
+  {
+    chunks[i].mCoordOffset    = chunks[i-1].mCoordOffset    + chunks[i-1].mCoordCount;
+    chunks[i].mNormalOffset   = chunks[i-1].mNormalOffset   + chunks[i-1].mNormalCount;
+    chunks[i].mTexCoordOffset = chunks[i-1].mTexCoordOffset + chunks[i-1].mTexCoordCount;
+  }
+
+  // parse the vertex data and the faces
+
+  #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount)
+  #endif
+  for(int i=0; i<(int)chunks.size(); ++i)
+    parseChunk(chunks[i]);
+
+  // merge the vertex data
+
+  mCoords.clear();
+  mNormals.clear();
+  mTexCoords.clear();
+  if ( !chunks.empty() )
+  {
+    mCoords.reserve( chunks.back().mCoordOffset + chunks.back().mCoordCount );
+    mNormals.reserve( chunks.back().mNormalOffset + chunks.back().mNormalCount );
+    mTexCoords.reserve( chunks.back().mTexCoordOffset + chunks.back().mTexCoordCount );
+  }
+  for(size_t i=0; i<chunks.size(); ++i)
+  {
+    mCoords.insert( mCoords.end(), chunks[i].mCoords.begin(), chunks[i].mCoords.end() );
+    mNormals.insert( mNormals.end(), chunks[i].mNormals.begin(), chunks[i].mNormals.end() );
+    mTexCoords.insert( mTexCoords.end(), chunks[i].mTexCoords.begin(), chunks[i].mTexCoords.end() );
+  }
+
+  // replay the statements in file order to build the meshes like the serial parser does
+
+  ref<ObjMaterial> cur_material;
+  ref<ObjMesh> cur_mesh;
+  int f_format_type = 0;
+  std::string object_name;
+  bool starts_new_geom = true;
+  for(size_t i=0; i<chunks.size(); ++i)
+  {
+    const ObjChunk& chunk = chunks[i];
+    for(size_t icmd=0; icmd<chunk.mCommands.size(); ++icmd)
+    {
+      const ObjChunk::Command& cmd = chunk.mCommands[icmd];
+      switch(cmd.mType)
+      {
+      case ObjChunk::Faces:
+      {
+        if (starts_new_geom)
+        {
+          cur_mesh = new ObjMesh;
+          cur_mesh->setObjectName(object_name.c_str());
+          meshes.push_back( cur_mesh );
+          starts_new_geom = false;
+          cur_mesh->setMaterial(cur_material.get());
+          f_format_type = cmd.mFormat;
+        }
+        cur_mesh->face_type().insert( cur_mesh->face_type().end(), chunk.mFaceType.begin() + cmd.mFaceBegin, chunk.mFaceType.begin() + cmd.mFaceEnd );
+        std::vector<int>::const_iterator vbegin = chunk.mPositionIndex.begin() + cmd.mVertexBegin;
+        std::vector<int>::const_iterator vend   = chunk.mPositionIndex.begin() + cmd.mVertexEnd;
+        cur_mesh->facePositionIndex().insert( cur_mesh->facePositionIndex().end(), vbegin, vend );
+        if ( f_format_type == 1 || f_format_type == 3 )
+        {
+          vbegin = chunk.mTexCoordIndex.begin() + cmd.mVertexBegin;
+          vend   = chunk.mTexCoordIndex.begin() + cmd.mVertexEnd;
+          cur_mesh->faceTexCoordIndex().insert( cur_mesh->faceTexCoordIndex().end(), vbegin, vend );
+        }
+        if ( f_format_type == 2 || f_format_type == 3 )
+        {
+          vbegin = chunk.mNormalIndex.begin() + cmd.mVertexBegin;
+          vend   = chunk.mNormalIndex.begin() + cmd.mVertexEnd;
+          cur_mesh->faceNormalIndex().insert( cur_mesh->faceNormalIndex().end(), vbegin, vend );
+        }
+        break;
+      }
+      case ObjChunk::Object:
+        starts_new_geom = true;
+        object_name = cmd.mArg;
+        break;
+      case ObjChunk::UseMtl:
+        starts_new_geom = true;
+        // can also become NULL
+        cur_material = materials[cmd.mArg];
+        break;
+      case ObjChunk::MtlLib:
+        loadMaterialLibrary(file, cmd.mArg, materials);
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+// LoadWriterOBJ
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> LoadWriterOBJ::loadResource(const String& path) const
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile( path );
+  if (file)
+    return loadResource( file.get() );
+  else
+  {
+    Log::error( Say("Could not locate '%s'.\n") << path );
+    return NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> LoadWriterOBJ::loadResource(VirtualFile* file) const
+{
+  ObjLoader loader;
+  loader.setThreadCount( threadCount() );
+  return loader.loadOBJ(file);
+}
+//-----------------------------------------------------------------------------
 ref<ResourceDatabase> vl::loadOBJ( const String& path )
 {
   ref<VirtualFile> file = defFileSystem()->locateFile( path );
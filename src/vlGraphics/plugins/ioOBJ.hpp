@@ -59,19 +59,19 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::LoadWriterOBJ, ResourceLoadWriter)
 
   public:
-    LoadWriterOBJ(): ResourceLoadWriter("|obj|", "|obj|") {}
+    LoadWriterOBJ(): ResourceLoadWriter("|obj|", "|obj|"), mThreadCount(1) {}
 
     void registerLoadWriter();
 
-    ref<ResourceDatabase> loadResource(const String& path) const
-    {
-      return loadOBJ(path);
-    }
+    ref<ResourceDatabase> loadResource(const String& path) const;
 
-    ref<ResourceDatabase> loadResource(VirtualFile* file) const
-    {
-      return loadOBJ(file);
-    }
+    ref<ResourceDatabase> loadResource(VirtualFile* file) const;
+
+    //! The number of threads used to load the OBJ files, see ObjLoader::setThreadCount().
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    //! The number of threads used to load the OBJ files, see ObjLoader::setThreadCount().
+    int threadCount() const { return mThreadCount; }
 
     //! Not supported yet.
     bool writeResource(const String& /*path*/, ResourceDatabase* /*resource*/) const
@@ -84,6 +84,9 @@ namespace vl
     {
       return false;
     }
+
+  protected:
+    int mThreadCount;
   };
 //-----------------------------------------------------------------------------
 // ObjTexture
@@ -338,9 +341,20 @@ namespace vl
 // ObjLoader
 //-----------------------------------------------------------------------------
   //! Loads a Wavefront OBJ file
-  class ObjLoader
+  class VLGRAPHICS_EXPORT ObjLoader
   {
   public:
+    ObjLoader(): mThreadCount(1) {}
+
+    /** The number of threads used to load the file, defaults to 1.
+     * When greater than 1 the file is read in memory (or mapped if it is a MappedFile) and split in line aligned chunks
+     * which are parsed in parallel, then the meshes are built in parallel sharing the vertices with the same
+     * position/normal/texture coordinate indices, using a DrawElementsUInt instead of a DrawArrays. */
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    //! The number of threads used to load the file, defaults to 1.
+    int threadCount() const { return mThreadCount; }
+
     const std::vector<fvec4>& vertexArray() const { return mCoords; }
     const std::vector<fvec3>& normalArray() const { return mNormals; }
     const std::vector<fvec3>& texCoordsArray() const { return mTexCoords; }
@@ -363,6 +377,14 @@ namespace vl
     void loadObjMaterials(VirtualFile* file, std::vector<ObjMaterial>& materials );
 
   protected:
+    //! Parses the file in parallel filling the vertex arrays, \p materials and \p meshes.
+    bool parseParallel(VirtualFile* file, std::map< std::string, ref<ObjMaterial> >& materials, std::vector< ref<ObjMesh> >& meshes);
+
+    //! Loads the materials of an "mtllib" statement into \p materials.
+    void loadMaterialLibrary(VirtualFile* file, const std::string& mtllib, std::map< std::string, ref<ObjMaterial> >& materials);
+
+  protected:
+    int mThreadCount;
     std::vector<fvec4> mCoords;
     std::vector<fvec3> mNormals;
     std::vector<fvec3> mTexCoords;
@@ -41,6 +41,151 @@
 #include <vlCore/LoadWriterManager.hpp>
 
 using namespace vl;
+
+namespace
+{
+  //! Size of the blocks in which the binary elements are read.
+  const size_t PLY_BLOCK_SIZE = 1024*1024;
+
+  bool littleEndianCPU()
+  {
+    unsigned short bet = 0x00FF;
+    return ((unsigned char*)&bet)[0] == 0xFF;
+  }
+
+  //! Reads a file in large blocks, exposing the buffered bytes directly.
+  class BlockReader
+  {
+  public:
+    BlockReader(VirtualFile* file, size_t block_size): mFile(file), mBuffer(block_size), mPos(0), mEnd(0) {}
+
+    //! Makes at least \p bytes bytes available at ptr(), returns false if the file ends before.
+    bool ensure(size_t bytes)
+    {
+      if ( mEnd - mPos >= bytes )
+        return true;
+      // move the unread bytes to the beginning of the buffer
+      if (mPos)
+      {
+        memmove(&mBuffer[0], &mBuffer[mPos], mEnd - mPos);
+        mEnd -= mPos;
+        mPos = 0;
+      }
+      if ( mBuffer.size() < bytes )
+        mBuffer.resize(bytes);
+      while( mEnd < bytes )
+      {
+        long long count = mFile->read(&mBuffer[mEnd], mBuffer.size() - mEnd);
+        if (count <= 0)
+          return false;
+        mEnd += (size_t)count;
+      }
+      return true;
+    }
+
+    const unsigned char* ptr() const { return &mBuffer[mPos]; }
+
+    void skip(size_t bytes) { mPos += bytes; }
+
+    size_t blockSize() const { return mBuffer.size(); }
+
+  protected:
+    VirtualFile* mFile;
+    std::vector<unsigned char> mBuffer;
+    size_t mPos;
+    size_t mEnd;
+  };
+
+  template<typename T, bool swap_bytes>
+  inline T loadScalar(const unsigned char* ptr)
+  {
+    T value;
+    if (swap_bytes)
+    {
+      unsigned char bytes[sizeof(T)];
+      for(size_t i=0; i<sizeof(T); ++i)
+        bytes[i] = ptr[sizeof(T)-1-i];
+      memcpy(&value, bytes, sizeof(T));
+    }
+    else
+      memcpy(&value, ptr, sizeof(T));
+    return value;
+  }
+
+  // conversions consistent with PlyScalar::getAsFloat() and PlyScalar::getAsInt()
+  template<typename T>
+  inline void convertScalar(float& dst, T value) { dst = (float)value; }
+
+  template<typename T>
+  inline void convertScalar(unsigned char& dst, T value) { dst = (unsigned char)(int)value; }
+
+  //! Decodes the property at \p src of \p count records of \p stride bytes into every \p dst_stride-th element of \p dst.
+  template<typename T, bool swap_bytes, typename TDst>
+  void decodeColumn(const unsigned char* src, size_t stride, size_t count, TDst* dst, size_t dst_stride)
+  {
+    for(size_t i=0; i<count; ++i, src+=stride, dst+=dst_stride)
+      convertScalar(*dst, loadScalar<T,swap_bytes>(src));
+  }
+
+  template<typename T, typename TDst>
+  void decodeColumn(bool swap_bytes, const unsigned char* src, size_t stride, size_t count, TDst* dst, size_t dst_stride)
+  {
+    if (swap_bytes)
+      decodeColumn<T,true>(src, stride, count, dst, dst_stride);
+    else
+      decodeColumn<T,false>(src, stride, count, dst, dst_stride);
+  }
+
+  template<typename TDst>
+  void decodeColumn(PlyLoader::EType type, bool swap_bytes, const unsigned char* src, size_t stride, size_t count, TDst* dst, size_t dst_stride)
+  {
+    switch(type)
+    {
+      case PlyLoader::PlyChar:   decodeColumn<char>          (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyUChar:  decodeColumn<unsigned char> (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyShort:  decodeColumn<short>         (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyUShort: decodeColumn<unsigned short>(swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyInt:    decodeColumn<int>           (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyUInt:   decodeColumn<unsigned int>  (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyFloat:  decodeColumn<float>         (swap_bytes, src, stride, count, dst, dst_stride); break;
+      case PlyLoader::PlyDouble: decodeColumn<double>        (swap_bytes, src, stride, count, dst, dst_stride); break;
+      default: break;
+    }
+  }
+
+  template<typename T>
+  inline int decodeInt(bool swap_bytes, const unsigned char* ptr)
+  {
+    return swap_bytes ? (int)loadScalar<T,true>(ptr) : (int)loadScalar<T,false>(ptr);
+  }
+
+  //! Decodes a scalar as an int like PlyScalar::getAsInt() does.
+  inline int decodeInt(PlyLoader::EType type, bool swap_bytes, const unsigned char* ptr)
+  {
+    switch(type)
+    {
+      case PlyLoader::PlyChar:   return (int)(char)ptr[0];
+      case PlyLoader::PlyUChar:  return (int)ptr[0];
+      case PlyLoader::PlyShort:  return decodeInt<short>(swap_bytes, ptr);
+      case PlyLoader::PlyUShort: return decodeInt<unsigned short>(swap_bytes, ptr);
+      case PlyLoader::PlyInt:    return decodeInt<int>(swap_bytes, ptr);
+      case PlyLoader::PlyUInt:   return decodeInt<unsigned int>(swap_bytes, ptr);
+      case PlyLoader::PlyFloat:  return decodeInt<float>(swap_bytes, ptr);
+      case PlyLoader::PlyDouble: return decodeInt<double>(swap_bytes, ptr);
+      default:
+        return 0;
+    }
+  }
+
+  //! Where a vertex property is stored: the array component it fills.
+  struct PlyColumn
+  {
+    PlyColumn(): mType(PlyLoader::PlyError), mOffset(0), mComponent(0) {}
+    PlyLoader::EType mType;
+    size_t mOffset;
+    int mComponent;
+  };
+}
 //-----------------------------------------------------------------------------
 ref<ResourceDatabase> vl::loadPLY(const String& path)
 {
@@ -78,6 +223,22 @@ void PlyLoader::PlyScalar::read(VirtualFile* file, bool le)
       Log::error("PlyLoader: scalar read error.\n");
   }
 }
+void PlyLoader::PlyScalar::decode(const unsigned char* ptr, bool swap_bytes)
+{
+  switch(scalarType())
+  {
+    case PlyChar:   mData.mChar   = (char)ptr[0]; break;
+    case PlyUChar:  mData.mUChar  = ptr[0]; break;
+    case PlyShort:  mData.mShort  = swap_bytes ? loadScalar<short,true>(ptr)          : loadScalar<short,false>(ptr); break;
+    case PlyUShort: mData.mUShort = swap_bytes ? loadScalar<unsigned short,true>(ptr) : loadScalar<unsigned short,false>(ptr); break;
+    case PlyInt:    mData.mInt    = swap_bytes ? loadScalar<int,true>(ptr)            : loadScalar<int,false>(ptr); break;
+    case PlyUInt:   mData.mUInt   = swap_bytes ? loadScalar<unsigned int,true>(ptr)   : loadScalar<unsigned int,false>(ptr); break;
+    case PlyFloat:  mData.mFloat  = swap_bytes ? loadScalar<float,true>(ptr)          : loadScalar<float,false>(ptr); break;
+    case PlyDouble: mData.mDouble = swap_bytes ? loadScalar<double,true>(ptr)         : loadScalar<double,false>(ptr); break;
+    default:
+      Log::error("PlyLoader: scalar read error.\n");
+  }
+}
 void PlyLoader::PlyScalar::read(TextStream* text)
 {
   int idata;
@@ -175,14 +336,40 @@ void PlyLoader::PlyElement::analyze()
     }
   }
 }
+int PlyLoader::typeSize(EType type)
+{
+  switch(type)
+  {
+    case PlyChar:   return 1;
+    case PlyUChar:  return 1;
+    case PlyShort:  return 2;
+    case PlyUShort: return 2;
+    case PlyInt:    return 4;
+    case PlyUInt:   return 4;
+    case PlyFloat:  return 4;
+    case PlyDouble: return 8;
+    default:
+      return 0;
+  }
+}
 void PlyLoader::readElements(VirtualFile* file)
 {
+  // the data is read in large blocks and decoded from memory
+  BlockReader reader(file, PLY_BLOCK_SIZE);
+  const bool swap_bytes = littleEndian() != littleEndianCPU();
+
   // reposition to the correct location
   file->seekSet(0);
   std::string str;
   do
   {
-    unsigned char ch = file->readUInt8();
+    if ( !reader.ensure(1) )
+    {
+      Log::error("PlyLoader: end_header not found.\n");
+      return;
+    }
+    unsigned char ch = *reader.ptr();
+    reader.skip(1);
     if (ch == '\n' && str == "end_header")
       break;
     if (ch == '\n')
@@ -194,11 +381,210 @@ void PlyLoader::readElements(VirtualFile* file)
   } while(true);
 
   for(unsigned i=0; i<mElements.size(); ++i)
-    for(int j=0; j<mElements[i]->elemCount(); ++j)
+  {
+    PlyElement* el = mElements[i].get();
+
+    // the layout of the records with only scalar properties is fixed
+    size_t record_size = 0;
+    bool fixed_layout = true;
+    for(unsigned j=0; j<el->properties().size(); ++j)
     {
-      mElements[i]->read(file, littleEndian());
-      newElement(mElements[i].get());
+      PlyScalar* scalar = cast<PlyScalar>(el->properties()[j].get());
+      if (scalar)
+        record_size += typeSize(scalar->scalarType());
+      else
+        fixed_layout = false;
+    }
+
+    if ( fixed_layout && record_size && el->name() == "vertex" )
+    {
+      // map each property to the component of the array it fills
+      PlyColumn vert_cols[3], norm_cols[3], color_cols[4];
+      size_t offset = 0;
+      for(unsigned j=0; j<el->properties().size(); ++j)
+      {
+        PlyScalar* scalar = cast<PlyScalar>(el->properties()[j].get());
+        const String& name = scalar->name();
+        PlyColumn* col = NULL;
+        if (name == "x")     col = &vert_cols[0];  else
+        if (name == "y")     col = &vert_cols[1];  else
+        if (name == "z")     col = &vert_cols[2];  else
+        if (name == "nx")    col = &norm_cols[0];  else
+        if (name == "ny")    col = &norm_cols[1];  else
+        if (name == "nz")    col = &norm_cols[2];  else
+        if (name == "red")   col = &color_cols[0]; else
+        if (name == "green") col = &color_cols[1]; else
+        if (name == "blue")  col = &color_cols[2]; else
+        if (name == "alpha") col = &color_cols[3];
+        if (col)
+        {
+          col->mType = scalar->scalarType();
+          col->mOffset = offset;
+        }
+        offset += typeSize(scalar->scalarType());
+      }
+
+      // x, y, z stored as consecutive native floats are copied as they are
+      const bool packed_verts = !swap_bytes && vert_cols[0].mType == PlyFloat && vert_cols[1].mType == PlyFloat && vert_cols[2].mType == PlyFloat &&
+                                vert_cols[1].mOffset == vert_cols[0].mOffset + 4 && vert_cols[2].mOffset == vert_cols[0].mOffset + 8;
+
+      const size_t records_per_block = std::max( (size_t)1, reader.blockSize() / record_size );
+      size_t left = el->elemCount();
+      while( left )
+      {
+        size_t count = std::min(left, records_per_block);
+        if ( !reader.ensure(count * record_size) )
+        {
+          Log::error("PlyLoader: unexpected end of file.\n");
+          return;
+        }
+        const unsigned char* src = reader.ptr();
+
+        if (mVerts)
+        {
+          float* dst = mVerts->at(mVertexIndex).ptr();
+          if (packed_verts)
+          {
+            if (record_size == 12)
+              memcpy(dst, src, count * 12);
+            else
+            for(size_t k=0; k<count; ++k)
+              memcpy(dst + k*3, src + vert_cols[0].mOffset + k*record_size, 12);
+          }
+          else
+          {
+            memset(dst, 0, count * sizeof(fvec3));
+            for(int c=0; c<3; ++c)
+              decodeColumn(vert_cols[c].mType, swap_bytes, src + vert_cols[c].mOffset, record_size, count, dst + c, 3);
+          }
+        }
+
+        if (mNormals)
+        {
+          float* dst = mNormals->at(mVertexIndex).ptr();
+          memset(dst, 0, count * sizeof(fvec3));
+          for(int c=0; c<3; ++c)
+            decodeColumn(norm_cols[c].mType, swap_bytes, src + norm_cols[c].mOffset, record_size, count, dst + c, 3);
+        }
+
+        if (mColors)
+        {
+          unsigned char* dst = mColors->at(mVertexIndex).ptr();
+          memset(dst, 0, count * sizeof(ubvec4));
+          for(int c=0; c<4; ++c)
+            decodeColumn(color_cols[c].mType, swap_bytes, src + color_cols[c].mOffset, record_size, count, dst + c, 4);
+        }
+
+        reader.skip(count * record_size);
+        mVertexIndex += (int)count;
+        left -= count;
+      }
+    }
+    else
+    if ( fixed_layout && el->name() != "face" )
+    {
+      // not used by the loader
+      for( size_t left = el->elemCount() * record_size; left; )
+      {
+        size_t count = std::min(left, reader.blockSize());
+        if ( !reader.ensure(count) )
+        {
+          Log::error("PlyLoader: unexpected end of file.\n");
+          return;
+        }
+        reader.skip(count);
+        left -= count;
+      }
+    }
+    else
+    if ( el->name() == "face" && el->properties().size() == 1 && cast<PlyScalarList>(el->properties()[0].get()) && el->properties()[0]->name() == "vertex_indices" )
+    {
+      // triangulates the faces directly from the buffer
+      PlyScalarList* list = cast<PlyScalarList>(el->properties()[0].get());
+      const size_t count_size = typeSize(list->countType());
+      const size_t index_size = typeSize(list->scalarType());
+      mIndices.reserve( mIndices.size() + el->elemCount() * 3 );
+      for(int j=0; j<el->elemCount(); ++j)
+      {
+        if ( !reader.ensure(count_size) )
+        {
+          Log::error("PlyLoader: unexpected end of file.\n");
+          return;
+        }
+        int count = decodeInt(list->countType(), swap_bytes, reader.ptr());
+        reader.skip(count_size);
+        if ( count < 0 || !reader.ensure(count * index_size) )
+        {
+          Log::error("PlyLoader: unexpected end of file.\n");
+          return;
+        }
+        const unsigned char* src = reader.ptr();
+        if (count > 2)
+        {
+          unsigned int first = decodeInt(list->scalarType(), swap_bytes, src);
+          unsigned int prev  = decodeInt(list->scalarType(), swap_bytes, src + index_size);
+          for(int k=2; k<count; ++k)
+          {
+            unsigned int next = decodeInt(list->scalarType(), swap_bytes, src + k*index_size);
+            mIndices.push_back( first );
+            mIndices.push_back( prev );
+            mIndices.push_back( next );
+            prev = next;
+          }
+        }
+        reader.skip(count * index_size);
+      }
     }
+    else
+    {
+      // generic path for the elements with variable size
+      for(int j=0; j<el->elemCount(); ++j)
+      {
+        for(unsigned k=0; k<el->properties().size(); ++k)
+        {
+          PlyScalar* scalar = cast<PlyScalar>(el->properties()[k].get());
+          PlyScalarList* list = cast<PlyScalarList>(el->properties()[k].get());
+          if (scalar)
+          {
+            size_t size = typeSize(scalar->scalarType());
+            if ( !reader.ensure(size) )
+            {
+              Log::error("PlyLoader: unexpected end of file.\n");
+              return;
+            }
+            scalar->decode(reader.ptr(), swap_bytes);
+            reader.skip(size);
+          }
+          else
+          if (list)
+          {
+            size_t count_size = typeSize(list->countType());
+            size_t size = typeSize(list->scalarType());
+            if ( !reader.ensure(count_size) )
+            {
+              Log::error("PlyLoader: unexpected end of file.\n");
+              return;
+            }
+            int count = decodeInt(list->countType(), swap_bytes, reader.ptr());
+            reader.skip(count_size);
+            if ( count < 0 || !reader.ensure(count * size) )
+            {
+              Log::error("PlyLoader: unexpected end of file.\n");
+              return;
+            }
+            list->scalars().resize(count);
+            for(int s=0; s<count; ++s)
+            {
+              list->scalars()[s].setScalarType(list->scalarType());
+              list->scalars()[s].decode(reader.ptr() + s*size, swap_bytes);
+            }
+            reader.skip(count * size);
+          }
+        }
+        newElement(el);
+      }
+    }
+  }
 }
 void PlyLoader::readElements(TextStream* text)
 {
@@ -230,7 +616,7 @@ void PlyLoader::newElement(PlyElement*el)
   {
     for(unsigned int j=0; j<el->properties().size(); ++j)
     {
-      PlyScalarList* list = cast<PlyScalarList>(el->properties()[j].get()); VL_CHECK(list)
+      PlyScalarList* list = cast<PlyScalarList>(el->properties()[j].get());
       if (list && list->name() == "vertex_indices")
       {
         for(int i=1; i<(int)list->scalars().size()-1; ++i)
@@ -106,6 +106,8 @@ namespace vl
     //! Used by PlyLoader
     class PlyPropertyAbstract: public Object
     {
+      VL_INSTRUMENT_ABSTRACT_CLASS(vl::PlyLoader::PlyPropertyAbstract, Object)
+
     public:
       const String& name() const { return mName; }
       void setName(const String& name) { mName = name; }
@@ -117,12 +119,16 @@ namespace vl
     //! Used by PlyLoader
     class PlyScalar: public PlyPropertyAbstract
     {
+      VL_INSTRUMENT_CLASS(vl::PlyLoader::PlyScalar, PlyPropertyAbstract)
+
     public:
       PlyScalar(): mScalarType(PlyError) { mData.mDouble = 0; }
       void setScalarType(EType type) { mScalarType = type; }
       EType scalarType() const { return mScalarType; }
       virtual void read(VirtualFile* file, bool le);
       virtual void read(TextStream* text);
+      //! Decodes the value from memory, \p swap_bytes is true if the data endianness differs from the CPU one.
+      void decode(const unsigned char* ptr, bool swap_bytes);
       float getAsFloat() const;
       int getAsInt() const;
     protected:
@@ -142,6 +148,8 @@ namespace vl
     //! Used by PlyLoader
     class PlyScalarList: public PlyPropertyAbstract
     {
+      VL_INSTRUMENT_CLASS(vl::PlyLoader::PlyScalarList, PlyPropertyAbstract)
+
     public:
       PlyScalarList(): mScalarType(PlyError), mCountType(PlyError) {}
       void setCountType(EType type) { mCountType = type; }
@@ -182,6 +190,8 @@ namespace vl
     //! Used by PlyLoader
     class PlyElement: public Object
     {
+      VL_INSTRUMENT_CLASS(vl::PlyLoader::PlyElement, Object)
+
     public:
       PlyElement(): mElemCount(0) {}
       const String& name() const { return mName; }
@@ -247,6 +257,8 @@ namespace vl
     void readElements(TextStream* text);
     void newElement(PlyElement*el);
     EType translateType(const String& type);
+    //! The size in bytes of a binary scalar of the given type, 0 for PlyError.
+    static int typeSize(EType type);
     void analyzeHeader();
     bool readHeader(TextStream* line_reader);
   protected:
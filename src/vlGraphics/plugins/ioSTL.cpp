@@ -42,6 +42,90 @@
 #include <stdio.h>
 
 using namespace vl;
+
+namespace
+{
+  //! Number of triangles decoded per block by STLLoader::loadBinary().
+  const unsigned int STL_BLOCK_TRIANGLES = 4096;
+
+  //! The size in bytes of a binary STL triangle: normal, 3 vertices and the attribute byte count.
+  const unsigned int STL_TRIANGLE_SIZE = 50;
+
+  inline fvec3 readVec3(const unsigned char* ptr)
+  {
+    fvec3 v;
+    memcpy(v.ptr(), ptr, sizeof(float)*3);
+    return v;
+  }
+
+  //! Assigns a unique index to each distinct vertex position using an open addressing hash table.
+  class VertexWelder
+  {
+  public:
+    VertexWelder(size_t expected_count)
+    {
+      size_t size = 1024;
+      while(size < expected_count * 2)
+        size <<= 1;
+      mTable.resize(size, 0xFFFFFFFF);
+      mVertices.reserve(expected_count);
+    }
+
+    unsigned int index(const fvec3& v)
+    {
+      if ( mVertices.size() * 2 >= mTable.size() )
+        rehash(mTable.size() * 2);
+      const size_t mask = mTable.size() - 1;
+      for(size_t slot = hash(v) & mask; ; slot = (slot + 1) & mask)
+      {
+        unsigned int i = mTable[slot];
+        if (i == 0xFFFFFFFF)
+        {
+          mTable[slot] = (unsigned int)mVertices.size();
+          mVertices.push_back(v);
+          return mTable[slot];
+        }
+        if (mVertices[i] == v)
+          return i;
+      }
+    }
+
+    const std::vector<fvec3>& vertices() const { return mVertices; }
+
+  protected:
+    static size_t hash(const fvec3& v)
+    {
+      unsigned int bits[3];
+      // +0.0f maps -0 to +0 so that they hash alike
+      float x = v.x() + 0.0f, y = v.y() + 0.0f, z = v.z() + 0.0f;
+      memcpy(&bits[0], &x, 4);
+      memcpy(&bits[1], &y, 4);
+      memcpy(&bits[2], &z, 4);
+      unsigned int h = bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+      h ^= h >> 16;
+      h *= 0x45d9f3bu;
+      h ^= h >> 16;
+      return h;
+    }
+
+    void rehash(size_t size)
+    {
+      mTable.assign(size, 0xFFFFFFFF);
+      const size_t mask = size - 1;
+      for(size_t i=0; i<mVertices.size(); ++i)
+      {
+        size_t slot = hash(mVertices[i]) & mask;
+        while(mTable[slot] != 0xFFFFFFFF)
+          slot = (slot + 1) & mask;
+        mTable[slot] = (unsigned int)i;
+      }
+    }
+
+  protected:
+    std::vector<unsigned int> mTable;
+    std::vector<fvec3> mVertices;
+  };
+}
 //-----------------------------------------------------------------------------
 ref<ResourceDatabase> vl::loadSTL(const String& path)
 {
@@ -56,6 +140,26 @@ ref<ResourceDatabase> vl::loadSTL(const String& path)
   }
 }
 //-----------------------------------------------------------------------------
+ref<ResourceDatabase> LoadWriterSTL::loadResource(const String& path) const
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+
+  if (file)
+    return loadResource( file.get() );
+  else
+  {
+    Log::error( Say("Could not locate '%s'.\n") << path );
+    return NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> LoadWriterSTL::loadResource(VirtualFile* file) const
+{
+  STLLoader stl;
+  stl.setWeldVertices( weldVertices() );
+  return stl.loadSTL(file);
+}
+//-----------------------------------------------------------------------------
 ref<ResourceDatabase> vl::loadSTL(VirtualFile* file)
 {
   STLLoader stl;
@@ -70,39 +174,88 @@ ref<ResourceDatabase> STLLoader::loadBinary(VirtualFile* file)
   file->read( header,80 );
   unsigned int tri_count = file->readUInt32();
 
+  // don't trust the triangle count beyond the actual file size
+  long long file_size = file->size();
+  if ( file_size >= 84 && (long long)tri_count * STL_TRIANGLE_SIZE > file_size - 84 )
+  {
+    Log::warning( Say("STL file '%s' is truncated.\n") << file->path() );
+    tri_count = (unsigned int)((file_size - 84) / STL_TRIANGLE_SIZE);
+  }
+
   ref<ArrayFloat3>  verts   = new ArrayFloat3;
   ref<ArrayFloat3>  normals = new ArrayFloat3;
-  verts->resize(tri_count*3);
-  normals->resize(tri_count*3);
-  ref<DrawArrays> de = new DrawArrays(PT_TRIANGLES,0,tri_count*3);
-  ref<Geometry> geom = new Geometry;
-  geom->drawCalls().push_back(de.get());
-  geom->setVertexArray(verts.get());
-  geom->setNormalArray(normals.get());
+  ref<DrawElementsUInt> de_welded;
+  // typically each vertex is shared by ~6 triangles
+  VertexWelder welder( weldVertices() ? tri_count / 2 : 0 );
+  if (weldVertices())
+  {
+    de_welded = new DrawElementsUInt(PT_TRIANGLES);
+    de_welded->indexBuffer()->resize(tri_count*3);
+  }
+  else
+  {
+    verts->resize(tri_count*3);
+    normals->resize(tri_count*3);
+  }
+
+  // decode the triangles block by block straight into the final arrays
+  std::vector<u8> block( STL_BLOCK_TRIANGLES * STL_TRIANGLE_SIZE );
+  unsigned int tri_read = 0;
+  while( tri_read < tri_count )
+  {
+    unsigned int count = std::min(STL_BLOCK_TRIANGLES, tri_count - tri_read);
+    long long bytes = file->read( &block[0], count * STL_TRIANGLE_SIZE );
+    if ( bytes != count * STL_TRIANGLE_SIZE )
+    {
+      Log::warning( Say("STL file '%s' is truncated.\n") << file->path() );
+      count = bytes > 0 ? (unsigned int)(bytes / STL_TRIANGLE_SIZE) : 0;
+      tri_count = tri_read + count;
+    }
 
-  struct STriangle {
-    fvec3 n;
-    fvec3 v0;
-    fvec3 v1;
-    fvec3 v2;
-    vl::u16 abc; // attribute byte count
-  } tri;
+    const u8* tri = &block[0];
+    if (weldVertices())
+    {
+      unsigned int* idx = de_welded->indexBuffer()->begin() + tri_read*3;
+      for(unsigned int i=0; i<count; ++i, tri+=STL_TRIANGLE_SIZE, idx+=3)
+      {
+        idx[0] = welder.index( readVec3(tri+12) );
+        idx[1] = welder.index( readVec3(tri+24) );
+        idx[2] = welder.index( readVec3(tri+36) );
+      }
+    }
+    else
+    {
+      fvec3* n = normals->begin() + tri_read*3;
+      fvec3* v = verts->begin() + tri_read*3;
+      for(unsigned int i=0; i<count; ++i, tri+=STL_TRIANGLE_SIZE, n+=3, v+=3)
+      {
+        n[0] = n[1] = n[2] = readVec3(tri);
+        v[0] = readVec3(tri+12);
+        v[1] = readVec3(tri+24);
+        v[2] = readVec3(tri+36);
+      }
+    }
 
-  std::vector<u8> tris;
-  tris.resize( tri_count * 50 );
-  file->read( &tris[0], tri_count * 50 );
+    tri_read += count;
+  }
 
-  // read triangles
-  for(unsigned int i=0; i<tri_count; ++i)
+  ref<Geometry> geom = new Geometry;
+  geom->setVertexArray(verts.get());
+  if (weldVertices())
+  {
+    de_welded->indexBuffer()->resize(tri_count*3);
+    verts->resize( welder.vertices().size() );
+    if ( verts->size() )
+      memcpy( verts->ptr(), &welder.vertices()[0], verts->bytesUsed() );
+    geom->drawCalls().push_back(de_welded.get());
+    geom->computeNormals();
+  }
+  else
   {
-    STriangle& tri = *((STriangle*)&tris[ i * 50 ]);
-
-    normals->at(i*3+0) = tri.n;
-    normals->at(i*3+1) = tri.n;
-    normals->at(i*3+2) = tri.n;
-    verts->at(i*3+0) = tri.v0;
-    verts->at(i*3+1) = tri.v1;
-    verts->at(i*3+2) = tri.v2;
+    verts->resize(tri_count*3);
+    normals->resize(tri_count*3);
+    geom->drawCalls().push_back( new DrawArrays(PT_TRIANGLES,0,tri_count*3) );
+    geom->setNormalArray(normals.get());
   }
 
   ref<ResourceDatabase> res_db = new ResourceDatabase;
@@ -58,17 +58,17 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::LoadWriterSTL, ResourceLoadWriter)
 
   public:
-    LoadWriterSTL(): ResourceLoadWriter("|stl|", "|stl|") {}
+    LoadWriterSTL(): ResourceLoadWriter("|stl|", "|stl|"), mWeldVertices(false) {}
 
-    ref<ResourceDatabase> loadResource(const String& path) const
-    {
-      return loadSTL(path);
-    }
+    ref<ResourceDatabase> loadResource(const String& path) const;
 
-    ref<ResourceDatabase> loadResource(VirtualFile* file) const
-    {
-      return loadSTL(file);
-    }
+    ref<ResourceDatabase> loadResource(VirtualFile* file) const;
+
+    //! Whether the binary STL files are loaded as indexed geometry, see STLLoader::setWeldVertices().
+    void setWeldVertices(bool weld) { mWeldVertices = weld; }
+
+    //! Whether the binary STL files are loaded as indexed geometry, see STLLoader::setWeldVertices().
+    bool weldVertices() const { return mWeldVertices; }
 
     //! Not supported yet.
     bool writeResource(const String& /*path*/, ResourceDatabase* /*resource*/) const
@@ -81,6 +81,9 @@ namespace vl
     {
       return false;
     }
+
+  protected:
+    bool mWeldVertices;
   };
 //-----------------------------------------------------------------------------
 // STLLoader
@@ -91,10 +94,23 @@ namespace vl
   class VLGRAPHICS_EXPORT STLLoader
   {
   public:
+    STLLoader(): mWeldVertices(false) {}
+
     //! Loads a STL file.
     ref<ResourceDatabase> loadSTL(VirtualFile* file);
     ref<ResourceDatabase> loadAscii(VirtualFile* file);
+    //! Decodes the triangles in fixed size blocks directly into the final arrays.
     ref<ResourceDatabase> loadBinary(VirtualFile* file);
+
+    //! If enabled the binary STL triangles sharing the same vertex positions are welded while loading
+    //! producing an indexed Geometry, the per-facet normals are then replaced by smooth vertex normals.
+    void setWeldVertices(bool weld) { mWeldVertices = weld; }
+
+    //! If enabled the binary STL triangles sharing the same vertex positions are welded while loading.
+    bool weldVertices() const { return mWeldVertices; }
+
+  protected:
+    bool mWeldVertices;
   };
 };
 
@@ -0,0 +1,577 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#include "ioVLMZ.hpp"
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <vlCore/FileSystem.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/GZipCodec.hpp>
+#include <vlGraphics/Effect.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/DrawElements.hpp>
+#include <vlCore/LoadWriterManager.hpp>
+
+using namespace vl;
+
+namespace
+{
+  const unsigned int VLMZ_VERSION = 1;
+
+  inline unsigned short zigzag16(int delta)
+  {
+    short s = (short)delta;
+    return (unsigned short)((s << 1) ^ (s >> 15));
+  }
+
+  inline unsigned short unzigzag16(unsigned short z)
+  {
+    return (unsigned short)((z >> 1) ^ -(int)(z & 1));
+  }
+
+  inline unsigned char zigzag8(int delta)
+  {
+    signed char s = (signed char)delta;
+    return (unsigned char)((s << 1) ^ (s >> 7));
+  }
+
+  inline unsigned char unzigzag8(unsigned char z)
+  {
+    return (unsigned char)((z >> 1) ^ -(int)(z & 1));
+  }
+
+  //! Writes a 16 bits channel delta coded and split in a low and a high byte plane.
+  void writeChannel16(VirtualFile* stream, const std::vector<unsigned short>& values, std::vector<unsigned char>& planes)
+  {
+    const size_t count = values.size();
+    planes.resize(count * 2);
+    unsigned short prev = 0;
+    for(size_t i=0; i<count; ++i)
+    {
+      unsigned short z = zigzag16(values[i] - prev);
+      planes[i]         = (unsigned char)(z & 0xFF);
+      planes[count + i] = (unsigned char)(z >> 8);
+      prev = values[i];
+    }
+    if (count)
+      stream->write(&planes[0], planes.size());
+  }
+
+  //! Writes an 8 bits channel delta coded.
+  void writeChannel8(VirtualFile* stream, const std::vector<unsigned char>& values, std::vector<unsigned char>& planes)
+  {
+    const size_t count = values.size();
+    planes.resize(count);
+    unsigned char prev = 0;
+    for(size_t i=0; i<count; ++i)
+    {
+      planes[i] = zigzag8(values[i] - prev);
+      prev = values[i];
+    }
+    if (count)
+      stream->write(&planes[0], planes.size());
+  }
+
+  //! Reads a channel written by writeChannel16() dequantizing it into every \p stride-th float of \p dst.
+  bool readChannel16(VirtualFile* stream, size_t count, std::vector<unsigned char>& planes, float* dst, int stride, float offset, float scale)
+  {
+    planes.resize(count * 2);
+    if ( count && stream->read(&planes[0], planes.size()) != (long long)planes.size() )
+      return false;
+    const unsigned char* lo = planes.empty() ? NULL : &planes[0];
+    const unsigned char* hi = lo + count;
+    unsigned short q = 0;
+    for(size_t i=0; i<count; ++i, dst+=stride)
+    {
+      q = (unsigned short)(q + unzigzag16( (unsigned short)(lo[i] | (hi[i] << 8)) ));
+      *dst = offset + q * scale;
+    }
+    return true;
+  }
+
+  //! Reads a channel written by writeChannel8() into every \p stride-th byte of \p dst.
+  bool readChannel8(VirtualFile* stream, size_t count, std::vector<unsigned char>& planes, unsigned char* dst, int stride)
+  {
+    planes.resize(count);
+    if ( count && stream->read(&planes[0], planes.size()) != (long long)planes.size() )
+      return false;
+    unsigned char q = 0;
+    for(size_t i=0; i<count; ++i, dst+=stride)
+    {
+      q = (unsigned char)(q + unzigzag8(planes[i]));
+      *dst = q;
+    }
+    return true;
+  }
+
+  inline float signNotZero(float v) { return v < 0 ? -1.0f : 1.0f; }
+
+  //! Octahedron encoding of a unit vector in two signed bytes.
+  void encodeOctahedron(const fvec3& n, unsigned char& ox, unsigned char& oy)
+  {
+    float l1 = fabs(n.x()) + fabs(n.y()) + fabs(n.z());
+    float x = l1 ? n.x() / l1 : 0;
+    float y = l1 ? n.y() / l1 : 0;
+    if (n.z() < 0)
+    {
+      float t = x;
+      x = (1.0f - fabs(y)) * signNotZero(t);
+      y = (1.0f - fabs(t)) * signNotZero(y);
+    }
+    ox = (unsigned char)(signed char)floor(x * 127.0f + 0.5f);
+    oy = (unsigned char)(signed char)floor(y * 127.0f + 0.5f);
+  }
+
+  fvec3 decodeOctahedron(unsigned char ox, unsigned char oy)
+  {
+    float x = (signed char)ox / 127.0f;
+    float y = (signed char)oy / 127.0f;
+    float z = 1.0f - fabs(x) - fabs(y);
+    if (z < 0)
+    {
+      float t = x;
+      x = (1.0f - fabs(y)) * signNotZero(t);
+      y = (1.0f - fabs(t)) * signNotZero(y);
+    }
+    return fvec3(x, y, z).normalize();
+  }
+
+  void writeVarint(std::vector<unsigned char>& out, unsigned int v)
+  {
+    while(v >= 0x80)
+    {
+      out.push_back( (unsigned char)(v | 0x80) );
+      v >>= 7;
+    }
+    out.push_back( (unsigned char)v );
+  }
+
+  //! Quantizes \p count values read every \p stride floats from \p src to 16 bits within [offset, offset + scale * max_q].
+  void quantize(const float* src, int stride, size_t count, float offset, float scale, std::vector<unsigned short>& q)
+  {
+    q.resize(count);
+    for(size_t i=0; i<count; ++i, src+=stride)
+    {
+      float v = scale ? floor((*src - offset) / scale + 0.5f) : 0;
+      q[i] = (unsigned short)(v < 0 ? 0 : (v > 65535 ? 65535 : v));
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> vl::loadVLMZ(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+
+  if (file)
+    return loadVLMZ( file.get() );
+  else
+  {
+    Log::error( Say("Could not locate '%s'.\n") << path );
+    return NULL;
+  }
+}
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> vl::loadVLMZ(VirtualFile* file)
+{
+  VLMZLoader vlmz;
+  return vlmz.loadVLMZ(file);
+}
+//-----------------------------------------------------------------------------
+bool vl::writeVLMZ(const String& path, const ResourceDatabase* resource, int position_bits)
+{
+  ref<DiskFile> file = new DiskFile(path);
+  return writeVLMZ( file.get(), resource, position_bits );
+}
+//-----------------------------------------------------------------------------
+bool vl::writeVLMZ(VirtualFile* file, const ResourceDatabase* resource, int position_bits)
+{
+  VLMZLoader vlmz;
+  vlmz.setPositionBits(position_bits);
+  return vlmz.writeVLMZ(file, resource);
+}
+//-----------------------------------------------------------------------------
+// VLMZLoader
+//-----------------------------------------------------------------------------
+ref<ResourceDatabase> VLMZLoader::loadVLMZ(VirtualFile* file)
+{
+  if (!file)
+  {
+    Log::error("loadVLMZ() called with NULL argument.\n");
+    return NULL;
+  }
+
+  ref<GZipCodec> stream = new GZipCodec(file);
+  if ( !stream->open(OM_ReadOnly) )
+  {
+    Log::error( Say("loadVLMZ(): could not open '%s'.\n") << file->path() );
+    return NULL;
+  }
+
+  char signature[4] = { 0, 0, 0, 0 };
+  stream->read(signature, 4);
+  unsigned int version = stream->readUInt32();
+  unsigned int mesh_count = stream->readUInt32();
+  if ( memcmp(signature, "VLMZ", 4) != 0 || version != VLMZ_VERSION )
+  {
+    Log::error( Say("loadVLMZ(): '%s' is not a VLMZ v%n file.\n") << file->path() << VLMZ_VERSION );
+    stream->close();
+    return NULL;
+  }
+
+  ref<ResourceDatabase> res_db = new ResourceDatabase;
+  for(unsigned int i=0; i<mesh_count; ++i)
+  {
+    ref<Geometry> geom = readMesh(stream.get());
+    if (!geom)
+    {
+      Log::error( Say("loadVLMZ(): '%s' is corrupted.\n") << file->path() );
+      stream->close();
+      return NULL;
+    }
+
+    ref<Effect> effect = new Effect;
+    effect->shader()->enable(EN_DEPTH_TEST);
+    if ( geom->normalArray() )
+      effect->shader()->enable(EN_LIGHTING);
+    if ( geom->colorArray() )
+      effect->shader()->gocMaterial()->setColorMaterialEnabled(true);
+
+    res_db->resources().push_back( geom );
+    res_db->resources().push_back( new Actor(geom.get(), effect.get(), NULL ) );
+    res_db->resources().push_back( effect.get() );
+  }
+
+  stream->close();
+  return res_db;
+}
+//-----------------------------------------------------------------------------
+ref<Geometry> VLMZLoader::readMesh(VirtualFile* stream)
+{
+  unsigned int name_length = stream->readUInt32();
+  if (name_length > 0xFFFF)
+    return NULL;
+  std::string name(name_length, ' ');
+  if ( name_length && stream->read(&name[0], name_length) != name_length )
+    return NULL;
+
+  const unsigned int vert_count  = stream->readUInt32();
+  const unsigned int index_count = stream->readUInt32();
+  const unsigned int flags       = stream->readUInt32();
+  if ( !vert_count || !index_count || index_count % 3 )
+    return NULL;
+
+  fvec3 pos_offset, pos_scale;
+  stream->readFloat(pos_offset.ptr(), 3);
+  stream->readFloat(pos_scale.ptr(), 3);
+  fvec2 tex_offset, tex_scale;
+  if (flags & HasTexCoords)
+  {
+    stream->readFloat(tex_offset.ptr(), 2);
+    stream->readFloat(tex_scale.ptr(), 2);
+  }
+
+  ref<Geometry> geom = new Geometry;
+  geom->setObjectName(name.c_str());
+  std::vector<unsigned char> planes;
+
+  // attributes are decoded directly into the final arrays
+
+  ref<ArrayFloat3> verts = new ArrayFloat3;
+  verts->resize(vert_count);
+  for(int c=0; c<3; ++c)
+    if ( !readChannel16(stream, vert_count, planes, verts->begin()->ptr() + c, 3, pos_offset[c], pos_scale[c]) )
+      return NULL;
+  geom->setVertexArray(verts.get());
+
+  if (flags & HasNormals)
+  {
+    std::vector<unsigned char> oct(vert_count * 2);
+    for(int c=0; c<2 && vert_count; ++c)
+      if ( !readChannel8(stream, vert_count, planes, &oct[c], 2) )
+        return NULL;
+    ref<ArrayFloat3> normals = new ArrayFloat3;
+    normals->resize(vert_count);
+    for(unsigned int i=0; i<vert_count; ++i)
+      normals->at(i) = decodeOctahedron(oct[i*2+0], oct[i*2+1]);
+    geom->setNormalArray(normals.get());
+  }
+
+  if (flags & HasColors)
+  {
+    ref<ArrayUByte4> colors = new ArrayUByte4;
+    colors->resize(vert_count);
+    for(int c=0; c<4; ++c)
+      if ( !readChannel8(stream, vert_count, planes, colors->ptr() + c, 4) )
+        return NULL;
+    geom->setColorArray(colors.get());
+  }
+
+  if (flags & HasTexCoords)
+  {
+    ref<ArrayFloat2> tex_coords = new ArrayFloat2;
+    tex_coords->resize(vert_count);
+    for(int c=0; c<2; ++c)
+      if ( !readChannel16(stream, vert_count, planes, tex_coords->begin()->ptr() + c, 2, tex_offset[c], tex_scale[c]) )
+        return NULL;
+    geom->setTexCoordArray(0, tex_coords.get());
+  }
+
+  // indices: delta coded variable length integers
+
+  unsigned int index_bytes = stream->readUInt32();
+  planes.resize(index_bytes);
+  if ( index_bytes && stream->read(&planes[0], index_bytes) != index_bytes )
+    return NULL;
+  ref<DrawElementsUInt> de = new DrawElementsUInt(PT_TRIANGLES);
+  de->indexBuffer()->resize(index_count);
+  unsigned int* idx = de->indexBuffer()->begin();
+  const unsigned char* ptr = planes.empty() ? NULL : &planes[0];
+  const unsigned char* end = ptr + index_bytes;
+  int prev = 0;
+  for(unsigned int i=0; i<index_count; ++i)
+  {
+    unsigned int z = 0;
+    for(int shift=0; ; shift+=7)
+    {
+      if ( ptr == end || shift > 28 )
+        return NULL;
+      unsigned char b = *ptr++;
+      z |= (unsigned int)(b & 0x7F) << shift;
+      if ( !(b & 0x80) )
+        break;
+    }
+    prev += (int)(z >> 1) ^ -(int)(z & 1);
+    if ( prev < 0 || (unsigned int)prev >= vert_count )
+      return NULL;
+    idx[i] = prev;
+  }
+  geom->drawCalls().push_back(de.get());
+
+  return geom;
+}
+//-----------------------------------------------------------------------------
+bool VLMZLoader::writeVLMZ(VirtualFile* file, const ResourceDatabase* resource)
+{
+  if (!file || !resource)
+  {
+    Log::error("writeVLMZ() called with NULL argument.\n");
+    return false;
+  }
+
+  // collect the Geometries and the Actors' ones
+  std::vector<const Geometry*> geoms;
+  for(size_t i=0; i<resource->resources().size(); ++i)
+  {
+    const Object* obj = resource->resources()[i].get();
+    const Geometry* geom = cast_const<Geometry>(obj);
+    const Actor* actor = cast_const<Actor>(obj);
+    if (actor)
+      geom = cast_const<Geometry>(actor->lod(0));
+    if ( !geom || std::find(geoms.begin(), geoms.end(), geom) != geoms.end() )
+      continue;
+    // only the Geometries with triangles are stored
+    for(int j=0; j<geom->drawCalls().size(); ++j)
+    {
+      if ( geom->drawCalls()[j]->countTriangles() )
+      {
+        geoms.push_back(geom);
+        break;
+      }
+    }
+  }
+
+  ref<GZipCodec> stream = new GZipCodec(file);
+  if ( !stream->open(OM_WriteOnly) )
+  {
+    Log::error( Say("writeVLMZ(): could not open '%s' for writing.\n") << file->path() );
+    return false;
+  }
+
+  stream->write("VLMZ", 4);
+  stream->writeUInt32(VLMZ_VERSION);
+  stream->writeUInt32((unsigned int)geoms.size());
+  bool ok = true;
+  for(size_t i=0; i<geoms.size() && ok; ++i)
+    ok = writeMesh(stream.get(), geoms[i]);
+
+  stream->close();
+  return ok;
+}
+//-----------------------------------------------------------------------------
+bool VLMZLoader::writeMesh(VirtualFile* stream, const Geometry* geom)
+{
+  const ArrayFloat3* verts = cast_const<ArrayFloat3>(geom->vertexArray());
+  if (!verts)
+  {
+    Log::error("writeVLMZ(): only ArrayFloat3 vertex arrays are supported.\n");
+    return false;
+  }
+  const ArrayFloat3* normals    = cast_const<ArrayFloat3>(geom->normalArray());
+  const ArrayUByte4* colors     = cast_const<ArrayUByte4>(geom->colorArray());
+  const ArrayFloat2* tex_coords = cast_const<ArrayFloat2>(geom->texCoordArray(0));
+  if (normals && normals->size() != verts->size())
+    normals = NULL;
+  if (colors && colors->size() != verts->size())
+    colors = NULL;
+  if (tex_coords && tex_coords->size() != verts->size())
+    tex_coords = NULL;
+
+  // collect the triangles reordering the vertices by first use, which also drops the unused ones
+
+  std::vector<unsigned int> remap( verts->size(), 0xFFFFFFFF );
+  std::vector<unsigned int> order;
+  std::vector<unsigned int> indices;
+  for(int i=0; i<geom->drawCalls().size(); ++i)
+  {
+    for( TriangleIterator it = geom->drawCalls()[i]->triangleIterator(); it.hasNext(); it.next() )
+    {
+      int tri[] = { it.a(), it.b(), it.c() };
+      for(int k=0; k<3; ++k)
+      {
+        if ( tri[k] < 0 || tri[k] >= (int)verts->size() )
+        {
+          Log::error("writeVLMZ(): index out of range.\n");
+          return false;
+        }
+        if ( remap[tri[k]] == 0xFFFFFFFF )
+        {
+          remap[tri[k]] = (unsigned int)order.size();
+          order.push_back(tri[k]);
+        }
+        indices.push_back( remap[tri[k]] );
+      }
+    }
+  }
+  const size_t vert_count = order.size();
+
+  // quantization ranges
+
+  fvec3 pos_min, pos_max;
+  fvec2 tex_min, tex_max;
+  for(size_t i=0; i<vert_count; ++i)
+  {
+    const fvec3& v = verts->at(order[i]);
+    for(int c=0; c<3; ++c)
+    {
+      pos_min[c] = i ? std::min(pos_min[c], v[c]) : v[c];
+      pos_max[c] = i ? std::max(pos_max[c], v[c]) : v[c];
+    }
+    if (tex_coords)
+    {
+      const fvec2& t = tex_coords->at(order[i]);
+      for(int c=0; c<2; ++c)
+      {
+        tex_min[c] = i ? std::min(tex_min[c], t[c]) : t[c];
+        tex_max[c] = i ? std::max(tex_max[c], t[c]) : t[c];
+      }
+    }
+  }
+  const float pos_levels = (float)((1 << positionBits()) - 1);
+  fvec3 pos_scale = (pos_max - pos_min) / pos_levels;
+  fvec2 tex_scale = (tex_max - tex_min) / 65535.0f;
+
+  unsigned int flags = (normals ? HasNormals : 0) | (colors ? HasColors : 0) | (tex_coords ? HasTexCoords : 0);
+  std::string name = geom->objectName();
+  stream->writeUInt32((unsigned int)name.length());
+  if ( !name.empty() )
+    stream->write(name.c_str(), name.length());
+  stream->writeUInt32((unsigned int)vert_count);
+  stream->writeUInt32((unsigned int)indices.size());
+  stream->writeUInt32(flags);
+  stream->writeFloat(pos_min.ptr(), 3);
+  stream->writeFloat(pos_scale.ptr(), 3);
+  if (tex_coords)
+  {
+    stream->writeFloat(tex_min.ptr(), 2);
+    stream->writeFloat(tex_scale.ptr(), 2);
+  }
+
+  // attribute streams
+
+  std::vector<float> channel(vert_count);
+  std::vector<unsigned short> q16;
+  std::vector<unsigned char> q8(vert_count);
+  std::vector<unsigned char> planes;
+  for(int c=0; c<3; ++c)
+  {
+    for(size_t i=0; i<vert_count; ++i)
+      channel[i] = verts->at(order[i])[c];
+    quantize(channel.empty() ? NULL : &channel[0], 1, vert_count, pos_min[c], pos_scale[c], q16);
+    writeChannel16(stream, q16, planes);
+  }
+
+  if (normals)
+  {
+    std::vector<unsigned char> oct_x(vert_count), oct_y(vert_count);
+    for(size_t i=0; i<vert_count; ++i)
+      encodeOctahedron(normals->at(order[i]), oct_x[i], oct_y[i]);
+    writeChannel8(stream, oct_x, planes);
+    writeChannel8(stream, oct_y, planes);
+  }
+
+  if (colors)
+  {
+    for(int c=0; c<4; ++c)
+    {
+      for(size_t i=0; i<vert_count; ++i)
+        q8[i] = colors->at(order[i])[c];
+      writeChannel8(stream, q8, planes);
+    }
+  }
+
+  if (tex_coords)
+  {
+    for(int c=0; c<2; ++c)
+    {
+      for(size_t i=0; i<vert_count; ++i)
+        channel[i] = tex_coords->at(order[i])[c];
+      quantize(channel.empty() ? NULL : &channel[0], 1, vert_count, tex_min[c], tex_scale[c], q16);
+      writeChannel16(stream, q16, planes);
+    }
+  }
+
+  // index stream
+
+  planes.clear();
+  int prev = 0;
+  for(size_t i=0; i<indices.size(); ++i)
+  {
+    int delta = (int)indices[i] - prev;
+    writeVarint( planes, (unsigned int)((delta << 1) ^ (delta >> 31)) );
+    prev = (int)indices[i];
+  }
+  stream->writeUInt32((unsigned int)planes.size());
+  if ( !planes.empty() )
+    stream->write(&planes[0], planes.size());
+
+  return true;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,146 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+#if !defined(LoadVLMZ_INCLUDE_ONCE)
+#define LoadVLMZ_INCLUDE_ONCE
+
+#include <vlGraphics/Geometry.hpp>
+#include <vlCore/ResourceLoadWriter.hpp>
+#include <vlCore/ResourceDatabase.hpp>
+
+namespace vl
+{
+  class VirtualFile;
+}
+
+namespace vl
+{
+//-----------------------------------------------------------------------------
+  VLGRAPHICS_EXPORT ref<ResourceDatabase> loadVLMZ(VirtualFile* file);
+  VLGRAPHICS_EXPORT ref<ResourceDatabase> loadVLMZ(const String& path);
+  VLGRAPHICS_EXPORT bool writeVLMZ(VirtualFile* file, const ResourceDatabase* resource, int position_bits=16);
+  VLGRAPHICS_EXPORT bool writeVLMZ(const String& path, const ResourceDatabase* resource, int position_bits=16);
+//---------------------------------------------------------------------------
+// LoadWriterVLMZ
+//---------------------------------------------------------------------------
+  /**
+   * The LoadWriterVLMZ class is a ResourceLoadWriter capable of reading and writing VLMZ compressed mesh files.
+   *
+   * A VLMZ file is a GZip stream containing one or more triangle meshes. Positions and texture coordinates are
+   * quantized to 16 bits within their bounding box, normals are octahedron encoded in 2 bytes and colors are stored
+   * as 4 bytes. Vertices are reordered by first use, delta coded and split in byte planes, indices are delta coded
+   * as variable length integers, so that the data compresses well. See VLMZLoader for the details.
+   */
+  class LoadWriterVLMZ: public ResourceLoadWriter
+  {
+    VL_INSTRUMENT_CLASS(vl::LoadWriterVLMZ, ResourceLoadWriter)
+
+  public:
+    LoadWriterVLMZ(): ResourceLoadWriter("|vlmz|", "|vlmz|"), mPositionBits(16) {}
+
+    ref<ResourceDatabase> loadResource(const String& path) const
+    {
+      return loadVLMZ(path);
+    }
+
+    ref<ResourceDatabase> loadResource(VirtualFile* file) const
+    {
+      return loadVLMZ(file);
+    }
+
+    bool writeResource(const String& path, ResourceDatabase* resource) const
+    {
+      return writeVLMZ(path, resource, positionBits());
+    }
+
+    bool writeResource(VirtualFile* file, ResourceDatabase* resource) const
+    {
+      return writeVLMZ(file, resource, positionBits());
+    }
+
+    //! The number of bits (1-16) used to quantize the vertex positions when writing.
+    void setPositionBits(int bits) { mPositionBits = bits < 1 ? 1 : (bits > 16 ? 16 : bits); }
+
+    //! The number of bits (1-16) used to quantize the vertex positions when writing.
+    int positionBits() const { return mPositionBits; }
+
+  protected:
+    int mPositionBits;
+  };
+//-----------------------------------------------------------------------------
+// VLMZLoader
+//-----------------------------------------------------------------------------
+  /**
+   * Loads and writes VLMZ compressed mesh files.
+   *
+   * The uncompressed stream is made of:
+   * - the "VLMZ" signature, the format version and the number of meshes
+   * - for each mesh: the name, vertex count, index count and attribute flags, the position (and texture coordinate)
+   *   dequantization offset and scale, followed by the attribute streams and the index stream.
+   *
+   * Attributes are decoded directly into the ArrayFloat3 vertex/normal, ArrayUByte4 color and ArrayFloat2
+   * texture coordinate arrays of the Geometry, triangles are stored in a DrawElementsUInt.
+   */
+  class VLGRAPHICS_EXPORT VLMZLoader
+  {
+  public:
+    typedef enum
+    {
+      HasNormals   = 1,
+      HasColors    = 2,
+      HasTexCoords = 4
+    } EAttributeFlags;
+
+    VLMZLoader(): mPositionBits(16) {}
+
+    //! Loads a VLMZ file.
+    ref<ResourceDatabase> loadVLMZ(VirtualFile* file);
+
+    //! Writes the triangles of the Geometries in \p resource, and of the Actors' lod(0) Geometries, to a VLMZ file.
+    //! Vertex arrays must be ArrayFloat3, normals ArrayFloat3, colors ArrayUByte4 and texture coordinates (unit 0) ArrayFloat2.
+    bool writeVLMZ(VirtualFile* file, const ResourceDatabase* resource);
+
+    //! The number of bits (1-16) used to quantize the vertex positions when writing.
+    void setPositionBits(int bits) { mPositionBits = bits < 1 ? 1 : (bits > 16 ? 16 : bits); }
+
+    //! The number of bits (1-16) used to quantize the vertex positions when writing.
+    int positionBits() const { return mPositionBits; }
+
+  protected:
+    ref<Geometry> readMesh(VirtualFile* stream);
+    bool writeMesh(VirtualFile* stream, const Geometry* geom);
+
+  protected:
+    int mPositionBits;
+  };
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include <vlX/Registry.hpp>
 #include <vlCore/FileSystem.hpp>
 #include <vlCore/LoadWriterManager.hpp>
+#include <vlCore/ResourceCache.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/Say.hpp>
 #include <vlCore/Time.hpp>
@@ -41,9 +42,11 @@
 #include <vlCore/AABB.hpp>
 #include <vlCore/Sphere.hpp>
 #include <vlCore/MersenneTwister.hpp>
+#include <vlGraphics/FrameProfiler.hpp>
 #include <cassert>
 
 static void registerVLXCoreWrappers();
+static void registerCoreLoadWriters(vl::LoadWriterManager* lwm);
 
 using namespace vl;
 
@@ -71,6 +74,9 @@ using namespace vl;
 #if defined(VL_IO_2D_DDS)
   #include <vlCore/plugins/ioDDS.hpp>
 #endif
+#if defined(VL_IO_2D_KTX)
+  #include <vlCore/plugins/ioKTX.hpp>
+#endif
 #if defined(VL_IO_2D_BMP)
   #include <vlCore/plugins/ioBMP.hpp>
 #endif
@@ -112,69 +118,91 @@ void VisualizationLibrary::initCore(bool log_info)
     return;
   }
 
-  // Install globabl settings
-  vl::setGlobalSettings( new GlobalSettings );
+  FrameProfiler::ScopedProfile profile_core( startupProfiler(), "initCore" );
+
+  {
+    FrameProfiler::ScopedProfile profile( startupProfiler(), "GlobalSettings and Log" );
 
-  // Install default logger
-  ref<StandardLog> logger = new StandardLog;
-  logger->setLogFile( globalSettings()->defaultLogPath() );
-  setDefLogger( logger.get() );
+    // Install globabl settings
+    vl::setGlobalSettings( new GlobalSettings );
 
-  // Install default LoadWriterManager
-  vl::setDefLoadWriterManager( new LoadWriterManager );
+    // Install default logger
+    ref<StandardLog> logger = new StandardLog;
+    logger->setLogFile( globalSettings()->defaultLogPath() );
+    setDefLogger( logger.get() );
+  }
 
-  // Install default FileSystem
-  vl::setDefFileSystem( new FileSystem );
-  vl::defFileSystem()->directories().push_back( new DiskDirectory( globalSettings()->defaultDataPath() ) );
+  {
+    FrameProfiler::ScopedProfile profile( startupProfiler(), "FileSystem and LoadWriterManager" );
 
-  // Install default MersenneTwister (seed done automatically)
-  vl::setDefMersenneTwister( new MersenneTwister );
+    // Install default LoadWriterManager
+    vl::setDefLoadWriterManager( new LoadWriterManager );
 
-  // Install default VLXRegistry
-  vlX::setDefVLXRegistry( new vlX::Registry );
+    // Install default FileSystem
+    vl::setDefFileSystem( new FileSystem );
+    vl::defFileSystem()->directories().push_back( new DiskDirectory( globalSettings()->defaultDataPath() ) );
 
-  // Register VLCore classes to VLX
-  registerVLXCoreWrappers();
+    // Install default MersenneTwister (seed done automatically)
+    vl::setDefMersenneTwister( new MersenneTwister );
+  }
 
-  // Register VLCore modules
+  {
+    FrameProfiler::ScopedProfile profile( startupProfiler(), "VLX registry" );
+
+    // Install default VLXRegistry
+    vlX::setDefVLXRegistry( new vlX::Registry );
+
+    // Register VLCore classes to VLX
+    registerVLXCoreWrappers();
+  }
+
+  // Register VLCore modules the first time a resource is loaded or written
+  defLoadWriterManager()->addLazyRegistration( registerCoreLoadWriters );
+
+  // Log VL and system information.
+  if (globalSettings()->verbosityLevel() && log_info) {
+    FrameProfiler::ScopedProfile profile( startupProfiler(), "logSystemInfo" );
+    logSystemInfo();
+  }
 
+  gInitializedCore = true;
+}
+//------------------------------------------------------------------------------
+void registerCoreLoadWriters(LoadWriterManager* lwm)
+{
   // This is always present
-  registerLoadWriter(new vlX::LoadWriterVLX);
+  lwm->registerLoadWriter(new vlX::LoadWriterVLX);
 
   #if defined(VL_IO_2D_JPG)
-    registerLoadWriter(new LoadWriterJPG);
+    lwm->registerLoadWriter(new LoadWriterJPG);
   #endif
   #if defined(VL_IO_2D_PNG)
-    registerLoadWriter(new LoadWriterPNG);
+    lwm->registerLoadWriter(new LoadWriterPNG);
   #endif
   #if defined(VL_IO_2D_TIFF)
-    registerLoadWriter(new LoadWriterTIFF);
+    lwm->registerLoadWriter(new LoadWriterTIFF);
   #endif
   #if defined(VL_IO_2D_TGA)
-    registerLoadWriter(new LoadWriterTGA);
+    lwm->registerLoadWriter(new LoadWriterTGA);
   #endif
   #if defined(VL_IO_2D_BMP)
-    registerLoadWriter(new LoadWriterBMP);
+    lwm->registerLoadWriter(new LoadWriterBMP);
   #endif
   #if defined(VL_IO_2D_DDS)
-    registerLoadWriter(new LoadWriterDDS);
+    lwm->registerLoadWriter(new LoadWriterDDS);
+  #endif
+  #if defined(VL_IO_2D_KTX)
+    lwm->registerLoadWriter(new LoadWriterKTX);
   #endif
   #if defined(VL_IO_2D_DAT)
-    registerLoadWriter(new LoadWriterDAT);
+    lwm->registerLoadWriter(new LoadWriterDAT);
   #endif
   #if defined(VL_IO_2D_MHD)
-    registerLoadWriter(new LoadWriterMHD);
+    lwm->registerLoadWriter(new LoadWriterMHD);
   #endif
   #if defined(VL_IO_2D_DICOM)
-    registerLoadWriter(new LoadWriterDICOM);
+    lwm->registerLoadWriter(new LoadWriterDICOM);
   #endif
-
-  // Log VL and system information.
-  if (globalSettings()->verbosityLevel() && log_info) {
-    logSystemInfo();
-  }
-
-  gInitializedCore = true;
 }
 //------------------------------------------------------------------------------
 void VisualizationLibrary::shutdownCore()
@@ -192,6 +220,9 @@ void VisualizationLibrary::shutdownCore()
   // Dispose default VLXRegistry
   vlX::setDefVLXRegistry( NULL );
 
+  // Dispose default ResourceCache
+  setDefResourceCache( NULL );
+
   // Dispose default LoadWriterManager
   defLoadWriterManager()->loadCallbacks().clear();
   defLoadWriterManager()->writeCallbacks().clear();
@@ -205,8 +236,10 @@ void VisualizationLibrary::shutdownCore()
   // Dispose default logger
   Log::debug("VisualizationLibrary::shutdownCore().\n");
 
-  // we keep the logger alive as much as we can.
+  // we keep the logger alive as much as we can, but the messages queued by an asynchronous logger must be written now.
   // setDefLogger( NULL );
+  if (defLogger())
+    defLogger()->flush();
 
   // keep global settings (used by logger)
   // gSettings = NULL;
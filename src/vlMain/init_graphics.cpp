@@ -33,7 +33,10 @@
 #include <vlCore/LoadWriterManager.hpp>
 #include <vlGraphics/Rendering.hpp>
 #include <vlGraphics/BezierSurface.hpp>
+#include <vlGraphics/BillboardSet.hpp>
 #include <vlGraphics/FontManager.hpp>
+#include <vlGraphics/PrimitiveGeometryCache.hpp>
+#include <vlGraphics/FrameProfiler.hpp>
 
 #include <vlX/WrappersGraphics.hpp>
 
@@ -55,11 +58,18 @@
 #if defined(VL_IO_3D_MD2)
   #include <vlGraphics/plugins/ioMD2.hpp>
 #endif
+#if defined(VL_IO_3D_VLMZ)
+  #include <vlGraphics/plugins/ioVLMZ.hpp>
+#endif
+#if defined(VL_IO_3D_GLB)
+  #include <vlGraphics/plugins/ioGLB.hpp>
+#endif
 #if defined(VL_IO_3D_COLLADA)
   #include <vlGraphics/plugins/COLLADA/ioDae.hpp>
 #endif
 
 static void registerVLXGraphicsWrappers();
+static void registerGraphicsLoadWriters(vl::LoadWriterManager* lwm);
 
 using namespace vl;
 
@@ -67,6 +77,7 @@ using namespace vl;
 namespace
 {
   bool gInitializedGraphics = false;
+  ref<FrameProfiler> gStartupProfiler;
 };
 //------------------------------------------------------------------------------
 void VisualizationLibrary::initGraphics()
@@ -77,37 +88,56 @@ void VisualizationLibrary::initGraphics()
     return;
   }
 
-  // Install default FontManager
+  FrameProfiler::ScopedProfile profile_graphics( startupProfiler(), "initGraphics" );
+
+  // Install default FontManager, FreeType is initialized on first use
   setDefFontManager( new FontManager );
 
-  // Register VLGraphics classes to VLX
-  registerVLXGraphicsWrappers();
+  // Install default PrimitiveGeometryCache, the geometries are created on first use
+  setDefPrimitiveGeometryCache( new PrimitiveGeometryCache );
+
+  {
+    FrameProfiler::ScopedProfile profile( startupProfiler(), "VLX graphics wrappers" );
+
+    // Register VLGraphics classes to VLX
+    registerVLXGraphicsWrappers();
+  }
 
-  // Register VLGraphics modules
+  // Register VLGraphics modules the first time a resource is loaded or written
+  defLoadWriterManager()->addLazyRegistration( registerGraphicsLoadWriters );
 
+  gInitializedGraphics = true;
+}
+//------------------------------------------------------------------------------
+void registerGraphicsLoadWriters(LoadWriterManager* lwm)
+{
   #if defined(VL_IO_3D_OBJ)
-    registerLoadWriter(new LoadWriterOBJ);
+    lwm->registerLoadWriter(new LoadWriterOBJ);
   #endif
   #if defined(VL_IO_3D_3DS)
-    registerLoadWriter(new LoadWriter3DS);
+    lwm->registerLoadWriter(new LoadWriter3DS);
   #endif
   #if defined(VL_IO_3D_AC3D)
-    registerLoadWriter(new LoadWriterAC3D);
+    lwm->registerLoadWriter(new LoadWriterAC3D);
   #endif
   #if defined(VL_IO_3D_PLY)
-    registerLoadWriter(new LoadWriterPLY);
+    lwm->registerLoadWriter(new LoadWriterPLY);
   #endif
   #if defined(VL_IO_3D_STL)
-    registerLoadWriter(new LoadWriterSTL);
+    lwm->registerLoadWriter(new LoadWriterSTL);
   #endif
   #if defined(VL_IO_3D_MD2)
-    registerLoadWriter(new LoadWriterMD2);
+    lwm->registerLoadWriter(new LoadWriterMD2);
+  #endif
+  #if defined(VL_IO_3D_VLMZ)
+    lwm->registerLoadWriter(new LoadWriterVLMZ);
+  #endif
+  #if defined(VL_IO_3D_GLB)
+    lwm->registerLoadWriter(new LoadWriterGLB);
   #endif
   #if defined(VL_IO_3D_COLLADA)
-    registerLoadWriter(new LoadWriterDae);
+    lwm->registerLoadWriter(new LoadWriterDae);
   #endif
-
-  gInitializedGraphics = true;
 }
 //------------------------------------------------------------------------------
 void VisualizationLibrary::shutdownGraphics()
@@ -123,21 +153,39 @@ void VisualizationLibrary::shutdownGraphics()
   defFontManager()->releaseAllFonts();
   setDefFontManager( NULL );
 
+  // Dispose default BufferObjectPool
+  setDefBufferObjectPool( NULL );
+
+  // Dispose default PrimitiveGeometryCache
+  setDefPrimitiveGeometryCache( NULL );
+
   Log::debug("VisualizationLibrary::shutdownGraphics()\n");
 }
 //------------------------------------------------------------------------------
 void VisualizationLibrary::init(bool log_info)
 {
+  // collect the startup time breakdown, CPU scopes only since there is no OpenGL context yet
+  gStartupProfiler = new FrameProfiler;
+  gStartupProfiler->setGPUTiming(false);
+  gStartupProfiler->setHistorySize(1);
+  gStartupProfiler->beginFrame();
+
   initCore(log_info);
   initGraphics();
+
+  gStartupProfiler->endFrame();
+  Log::debug( "VisualizationLibrary::init() time breakdown:\n" + gStartupProfiler->report() );
 }
 //------------------------------------------------------------------------------
 void VisualizationLibrary::shutdown()
 {
   shutdownGraphics();
   shutdownCore();
+  gStartupProfiler = NULL;
 }
 //------------------------------------------------------------------------------
+FrameProfiler* VisualizationLibrary::startupProfiler() { return gStartupProfiler.get(); }
+//------------------------------------------------------------------------------
 bool VisualizationLibrary::isGraphicsInitialized() { return gInitializedGraphics; }
 //------------------------------------------------------------------------------
 void registerVLXGraphicsWrappers()
@@ -147,6 +195,8 @@ void registerVLXGraphicsWrappers()
 
   // BezierSurface
   vlX::defVLXRegistry()->registerClassWrapper( BezierSurface::Type(), new vlX::VLXClassWrapper_Geometry );
+  // BillboardSet
+  vlX::defVLXRegistry()->registerClassWrapper( BillboardSet::Type(), new vlX::VLXClassWrapper_Geometry );
 
   // PatchParameter
   vlX::defVLXRegistry()->registerClassWrapper( PatchParameter::Type(), new vlX::VLXClassWrapper_PatchParameter );
@@ -226,6 +276,15 @@ void registerVLXGraphicsWrappers()
   // Viewport
   vlX::defVLXRegistry()->registerClassWrapper( Viewport::Type(), new vlX::VLXClassWrapper_Viewport );
 
+  // Portals
+  vlX::defVLXRegistry()->registerClassWrapper( Portal::Type(), new vlX::VLXClassWrapper_Portal );
+  vlX::defVLXRegistry()->registerClassWrapper( Sector::Type(), new vlX::VLXClassWrapper_Sector );
+  vlX::defVLXRegistry()->registerClassWrapper( SceneManagerPortals::Type(), new vlX::VLXClassWrapper_SceneManagerPortals );
+
+  // Particles
+  vlX::defVLXRegistry()->registerClassWrapper( ParticleEmitter::Type(), new vlX::VLXClassWrapper_ParticleEmitter );
+  vlX::defVLXRegistry()->registerClassWrapper( ParticleSystem::Type(), new vlX::VLXClassWrapper_ParticleSystem );
+
   // GLSL
   vlX::defVLXRegistry()->registerClassWrapper( GLSLProgram::Type(), new vlX::VLXClassWrapper_GLSLProgram );
   ref<vlX::VLXClassWrapper_GLSLShader> sh_serializer = new vlX::VLXClassWrapper_GLSLShader;
@@ -234,6 +293,7 @@ void registerVLXGraphicsWrappers()
   vlX::defVLXRegistry()->registerClassWrapper( GLSLGeometryShader::Type(), sh_serializer.get() );
   vlX::defVLXRegistry()->registerClassWrapper( GLSLTessControlShader::Type(), sh_serializer.get() );
   vlX::defVLXRegistry()->registerClassWrapper( GLSLTessEvaluationShader::Type(), sh_serializer.get() );
+  vlX::defVLXRegistry()->registerClassWrapper( GLSLComputeShader::Type(), sh_serializer.get() );
 
   // GLSLShader
   vlX::defVLXRegistry()->registerClassWrapper( GLSLShader::Type(), new vlX::VLXClassWrapper_GLSLShader );
@@ -251,6 +311,11 @@ void registerVLXGraphicsWrappers()
   vlX::defVLXRegistry()->registerClassWrapper( ArrayDouble3::Type(), array_serializer.get() );
   vlX::defVLXRegistry()->registerClassWrapper( ArrayDouble4::Type(), array_serializer.get() );
 
+  vlX::defVLXRegistry()->registerClassWrapper( ArrayHFloat1::Type(), array_serializer.get() );
+  vlX::defVLXRegistry()->registerClassWrapper( ArrayHFloat2::Type(), array_serializer.get() );
+  vlX::defVLXRegistry()->registerClassWrapper( ArrayHFloat3::Type(), array_serializer.get() );
+  vlX::defVLXRegistry()->registerClassWrapper( ArrayHFloat4::Type(), array_serializer.get() );
+
   vlX::defVLXRegistry()->registerClassWrapper( ArrayInt1::Type(), array_serializer.get() );
   vlX::defVLXRegistry()->registerClassWrapper( ArrayInt2::Type(), array_serializer.get() );
   vlX::defVLXRegistry()->registerClassWrapper( ArrayInt3::Type(), array_serializer.get() );
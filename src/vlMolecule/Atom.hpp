@@ -63,6 +63,7 @@ namespace vl
       mRadius   = 0.25f;
       mVisited  = false;
       mVisible  = true;
+      mIndex    = -1;
       mShowAtomName= false;
       /*mAtomName = nothing*/
     }
@@ -81,6 +82,7 @@ namespace vl
       mShowAtomName= other.mShowAtomName;
       // mAdjacentAtoms = other.mAdjacentAtoms; // do not copy
       // mVisited = other.mVisited;             // do not copy
+      // mIndex = other.mIndex;                 // do not copy
       mAtomName = other.mAtomName;
       return *this;
     }
@@ -112,6 +114,11 @@ namespace vl
     void setVisited(bool visited) { mVisited = visited; }
     bool visited() const { return mVisited; }
 
+    //! The index of the atom in Molecule::atoms() as of the last Molecule::computeAtomAdjacency(), -1 if never computed.
+    int index() const { return mIndex; }
+    //! The index of the atom in Molecule::atoms() as of the last Molecule::computeAtomAdjacency(), -1 if never computed.
+    void setIndex(int index) { mIndex = index; }
+
     void setAtomName(const std::string& name) { mAtomName = name; }
     const std::string& atomName() const { return mAtomName; }
 
@@ -134,6 +141,8 @@ namespace vl
     std::vector< Atom* > mAdjacentAtoms;
     std::string mAtomName;
     unsigned int mId;
+    // Index in the Molecule, see Molecule::computeAtomAdjacency().
+    int mIndex;
     // Aid to visit a molecule.
     bool mVisited;
     // Whether is visible or not
@@ -31,6 +31,7 @@
 
 #include <vlMolecule/Molecule.hpp>
 #include <vlMolecule/RingExtractor.hpp>
+#include <algorithm>
 
 using namespace vl;
 
@@ -71,6 +72,17 @@ void Molecule::reset()
   mActorToAtomMap.clear();
   mBondToActorMap.clear();
   mActorToBondMap.clear();
+  // adjacency
+  mAtomAdjacencyValid = false;
+  mAdjacencyOffsets.clear();
+  mAdjacentAtomIndices.clear();
+  mAdjacentBondIndices.clear();
+  // impostors
+  mImpostorsEnabled = false;
+  mImpostorAtoms.clear();
+  mImpostorBonds.clear();
+  mAtomImpostorActor = NULL;
+  mBondImpostorActor = NULL;
 }
 //-----------------------------------------------------------------------------
 Molecule& Molecule::operator=(const Molecule& other)
@@ -87,6 +99,7 @@ Molecule& Molecule::operator=(const Molecule& other)
   mAromaticRingColor = other.mAromaticRingColor;
   mLineWidth    = other.mLineWidth;
   mSmoothLines  = other.mSmoothLines;
+  mImpostorsEnabled = other.mImpostorsEnabled;
 
   std::map<const Atom*, Atom*> atom_map;
   for(unsigned i=0; i<other.atoms().size(); ++i)
@@ -124,6 +137,7 @@ void Molecule::addAtom(Atom* atom)
 //-----------------------------------------------------------------------------
 void Molecule::eraseAllAtoms()
 {
+  mAtomAdjacencyValid = false;
   mAtoms.clear();
   mBonds.clear();
   mCycles.clear();
@@ -136,6 +150,7 @@ void Molecule::eraseAtom(int i)
   for(unsigned j=0; j<incident_bonds.size(); ++j)
     eraseBond( incident_bonds[j] );
   atoms().erase(atoms().begin() + i);
+  mAtomAdjacencyValid = false;
 }
 //-----------------------------------------------------------------------------
 void Molecule::eraseAtom(Atom*a)
@@ -149,6 +164,7 @@ void Molecule::eraseAtom(Atom*a)
       for(unsigned j=0; j<incident_bonds.size(); ++j)
         eraseBond( incident_bonds[j] );
       atoms().erase(atoms().begin() + i);
+      mAtomAdjacencyValid = false;
       return;
     }
   }
@@ -168,20 +184,37 @@ const Bond* Molecule::bond(int index) const { return mBonds[index].get(); }
 //-----------------------------------------------------------------------------
 Bond* Molecule::bond(int index) { return mBonds[index].get(); }
 //-----------------------------------------------------------------------------
-const Bond* Molecule::bond(Atom* a1, Atom* a2) const
+int Molecule::findBond(const Atom* a1, const Atom* a2) const
 {
+  if (isAtomAdjacencyValid())
+  {
+    int i1 = atomIndex(a1);
+    int i2 = atomIndex(a2);
+    if (i1 == -1 || i2 == -1)
+      return -1;
+    // the adjacency lists are in bond order: the first match is the first bond in bonds()
+    for(int k=mAdjacencyOffsets[i1]; k<mAdjacencyOffsets[i1+1]; ++k)
+      if (mAdjacentAtomIndices[k] == i2)
+        return mAdjacentBondIndices[k];
+    return -1;
+  }
+
   for(unsigned i=0; i<bonds().size(); ++i)
     if ( (bond(i)->atom1() == a1 && bond(i)->atom2() == a2) || (bond(i)->atom1() == a2 && bond(i)->atom2() == a1) )
-      return bonds()[i].get();
-  return NULL;
+      return (int)i;
+  return -1;
+}
+//-----------------------------------------------------------------------------
+const Bond* Molecule::bond(Atom* a1, Atom* a2) const
+{
+  int i = findBond(a1, a2);
+  return i != -1 ? bonds()[i].get() : NULL;
 }
 //-----------------------------------------------------------------------------
 Bond* Molecule::bond(Atom* a1, Atom* a2)
 {
-  for(unsigned i=0; i<bonds().size(); ++i)
-    if ( (bond(i)->atom1() == a1 && bond(i)->atom2() == a2) || (bond(i)->atom1() == a2 && bond(i)->atom2() == a1) )
-      return bonds()[i].get();
-  return NULL;
+  int i = findBond(a1, a2);
+  return i != -1 ? bonds()[i].get() : NULL;
 }
 //-----------------------------------------------------------------------------
 void Molecule::addBond(Bond* bond)
@@ -197,14 +230,15 @@ void Molecule::eraseBond(Bond*b)
     if (bond(i) == b)
     {
       bonds().erase(bonds().begin() + i);
+      mAtomAdjacencyValid = false;
       return;
     }
   }
 }
 //-----------------------------------------------------------------------------
-void Molecule::eraseBond(int bond) { bonds().erase(bonds().begin() + bond); }
+void Molecule::eraseBond(int bond) { bonds().erase(bonds().begin() + bond); mAtomAdjacencyValid = false; }
 //-----------------------------------------------------------------------------
-void Molecule::eraseAllBonds() { bonds().clear(); }
+void Molecule::eraseAllBonds() { bonds().clear(); mAtomAdjacencyValid = false; }
 //-----------------------------------------------------------------------------
 void Molecule::eraseBond(Atom* a1, Atom* a2)
 {
@@ -214,6 +248,7 @@ void Molecule::eraseBond(Atom* a1, Atom* a2)
          (bond(i)->atom1() == a2 && bond(i)->atom2() == a1) )
     {
       bonds().erase(bonds().begin() + i);
+      mAtomAdjacencyValid = false;
       return;
     }
   }
@@ -224,22 +259,161 @@ void Molecule::eraseBond(int a1, int a2) { eraseBond(atom(a1), atom(a2)); }
 void Molecule::computeAtomAdjacency()
 {
   for(int i=0; i<atomCount(); ++i)
+  {
     atom(i)->adjacentAtoms().clear();
+    atom(i)->setIndex(i);
+  }
   for(int i=0; i<bondCount(); ++i)
   {
     bond(i)->atom1()->adjacentAtoms().push_back( bond(i)->atom2() );
     bond(i)->atom2()->adjacentAtoms().push_back( bond(i)->atom1() );
   }
+
+  // compressed adjacency lists: count the degrees, then fill in bond order
+  mAdjacencyOffsets.assign( atomCount()+1, 0 );
+  for(int i=0; i<bondCount(); ++i)
+  {
+    int i1 = atomIndex( bond(i)->atom1() );
+    int i2 = atomIndex( bond(i)->atom2() );
+    if (i1 == -1 || i2 == -1)
+      continue;
+    ++mAdjacencyOffsets[i1+1];
+    ++mAdjacencyOffsets[i2+1];
+  }
+  for(int i=0; i<atomCount(); ++i)
+    mAdjacencyOffsets[i+1] += mAdjacencyOffsets[i];
+
+  mAdjacentAtomIndices.resize( mAdjacencyOffsets.back() );
+  mAdjacentBondIndices.resize( mAdjacencyOffsets.back() );
+  std::vector<int> fill( mAdjacencyOffsets.begin(), mAdjacencyOffsets.end()-1 );
+  for(int i=0; i<bondCount(); ++i)
+  {
+    int i1 = atomIndex( bond(i)->atom1() );
+    int i2 = atomIndex( bond(i)->atom2() );
+    if (i1 == -1 || i2 == -1)
+      continue;
+    mAdjacentAtomIndices[fill[i1]] = i2;
+    mAdjacentBondIndices[fill[i1]++] = i;
+    mAdjacentAtomIndices[fill[i2]] = i1;
+    mAdjacentBondIndices[fill[i2]++] = i;
+  }
+
+  mAtomAdjacencyValid = true;
+}
+//-----------------------------------------------------------------------------
+int Molecule::atomIndex(const Atom* a) const
+{
+  if (!a)
+    return -1;
+  int i = a->index();
+  if (i >= 0 && i < atomCount() && atoms()[i] == a)
+    return i;
+  for(int j=0; j<atomCount(); ++j)
+    if (atoms()[j] == a)
+      return j;
+  return -1;
 }
 //-----------------------------------------------------------------------------
 void Molecule::incidentBonds(std::vector<Bond*>& incident_bonds, Atom* atom)
 {
   incident_bonds.clear();
+  if (isAtomAdjacencyValid())
+  {
+    int iatom = atomIndex(atom);
+    if (iatom != -1)
+    {
+      for(int k=mAdjacencyOffsets[iatom]; k<mAdjacencyOffsets[iatom+1]; ++k)
+      {
+        // a bond from an atom to itself appears twice in its list
+        if (incident_bonds.empty() || incident_bonds.back() != bond(mAdjacentBondIndices[k]))
+          incident_bonds.push_back( bond(mAdjacentBondIndices[k]) );
+      }
+    }
+    return;
+  }
   for(int i=0; i<bondCount(); ++i)
     if(bond(i)->atom1() == atom || bond(i)->atom2() == atom)
       incident_bonds.push_back( bond(i) );
 }
 //-----------------------------------------------------------------------------
+int Molecule::inferBonds(float tolerance)
+{
+  const int n = atomCount();
+  if (n < 2)
+    return 0;
+
+  // covalent radii and bounds
+  std::vector<float> cov_radius(n);
+  float max_radius = 0;
+  AABB aabb;
+  for(int i=0; i<n; ++i)
+  {
+    cov_radius[i] = (float)atomInfo( atom(i)->atomType() ).covalentRadius();
+    max_radius = vl::max(max_radius, cov_radius[i]);
+    aabb.addPoint( (vec3)atom(i)->coordinates() );
+  }
+
+  // grid cells as large as the longest possible bond, so that bonded atoms are in the same or in adjacent cells
+  float cell_size = 2.0f * max_radius + tolerance;
+  if (cell_size <= 0)
+    return 0;
+  const real max_cells = 1 << 20;
+  cell_size = vl::max( cell_size, (float)(aabb.width()  / max_cells) );
+  cell_size = vl::max( cell_size, (float)(aabb.height() / max_cells) );
+  cell_size = vl::max( cell_size, (float)(aabb.depth()  / max_cells) );
+  const long long nx = (long long)(aabb.width()  / cell_size) + 1;
+  const long long ny = (long long)(aabb.height() / cell_size) + 1;
+  const long long nz = (long long)(aabb.depth()  / cell_size) + 1;
+  const fvec3 origin = (fvec3)aabb.minCorner();
+
+  // the atoms sorted by cell
+  std::vector<ivec3> cell(n);
+  std::vector< std::pair<long long, int> > sorted(n);
+  for(int i=0; i<n; ++i)
+  {
+    fvec3 c = (atom(i)->coordinates() - origin) / cell_size;
+    cell[i] = ivec3( vl::clamp((int)c.x(), 0, (int)nx-1), vl::clamp((int)c.y(), 0, (int)ny-1), vl::clamp((int)c.z(), 0, (int)nz-1) );
+    sorted[i] = std::make_pair( (cell[i].z() * ny + cell[i].y()) * nx + cell[i].x(), i );
+  }
+  std::sort( sorted.begin(), sorted.end() );
+
+  // existing bonds are not duplicated
+  computeAtomAdjacency();
+
+  std::vector< std::pair<int, int> > new_bonds;
+  for(int i=0; i<n; ++i)
+  {
+    const fvec3& pi = atom(i)->coordinates();
+    for(int z=cell[i].z()-1; z<=cell[i].z()+1; ++z)
+    for(int y=cell[i].y()-1; y<=cell[i].y()+1; ++y)
+    for(int x=cell[i].x()-1; x<=cell[i].x()+1; ++x)
+    {
+      if (x < 0 || y < 0 || z < 0 || x >= nx || y >= ny || z >= nz)
+        continue;
+      long long key = (z * ny + y) * nx + x;
+      std::vector< std::pair<long long, int> >::const_iterator it = std::lower_bound( sorted.begin(), sorted.end(), std::make_pair(key, 0) );
+      for( ; it != sorted.end() && it->first == key; ++it )
+      {
+        int j = it->second;
+        if (j <= i)
+          continue;
+        float max_dist = cov_radius[i] + cov_radius[j] + tolerance;
+        // coincident atoms are not bonded
+        float dist2 = (atom(j)->coordinates() - pi).lengthSquared();
+        if (dist2 < max_dist*max_dist && dist2 > 0.40f*0.40f && findBond(atom(i), atom(j)) == -1)
+          new_bonds.push_back( std::make_pair(i, j) );
+      }
+    }
+  }
+
+  bonds().reserve( bonds().size() + new_bonds.size() );
+  for(size_t i=0; i<new_bonds.size(); ++i)
+    addBond( atom(new_bonds[i].first), atom(new_bonds[i].second) )->setBondType(BT_Unknown);
+
+  computeAtomAdjacency();
+  return (int)new_bonds.size();
+}
+//-----------------------------------------------------------------------------
 void Molecule::setCPKAtomColors()
 {
   for(unsigned i=0; i<atoms().size(); ++i)
@@ -44,6 +44,8 @@
 
 namespace vl
 {
+  class PickingRendering;
+
   //! Defines the main molecule styles.
   typedef enum
   {
@@ -99,7 +101,9 @@ namespace vl
     int bondCount() const { return (int)mBonds.size(); }
     const Bond* bond(int index) const;
     Bond* bond(int index);
+    //! Returns the first bond between \p a1 and \p a2 or NULL, uses the index-based adjacency if isAtomAdjacencyValid().
     const Bond* bond(Atom* a1, Atom* a2) const;
+    //! Returns the first bond between \p a1 and \p a2 or NULL, uses the index-based adjacency if isAtomAdjacencyValid().
     Bond* bond(Atom* a1, Atom* a2);
     void addBond(Bond* bond);
     Bond* addBond(Atom* a1, Atom* a2);
@@ -109,9 +113,33 @@ namespace vl
     void eraseBond(int a1, int a2);
     void eraseAllBonds();
 
+    /** Computes the adjacentAtoms() of each Atom and the index-based adjacency returned by adjacencyOffsets(), adjacentAtomIndices()
+     *  and adjacentBondIndices(), which makes incidentBonds(), bond(Atom*, Atom*) and the RingExtractor linear in the number of bonds.
+     *  The adjacency is invalidated by the Molecule methods adding or erasing atoms and bonds and must be recomputed after modifying
+     *  atoms() or bonds() directly. */
     void computeAtomAdjacency();
+    //! Whether the index-based adjacency is up to date, see computeAtomAdjacency().
+    bool isAtomAdjacencyValid() const { return mAtomAdjacencyValid; }
+
+    //! The bonds incident to \p atom, uses the index-based adjacency if isAtomAdjacencyValid().
     void incidentBonds(std::vector<Bond*>& inc_bonds, Atom* atom);
 
+    //! The atoms adjacent to the i-th atom are adjacentAtomIndices()[ adjacencyOffsets()[i] ] to adjacentAtomIndices()[ adjacencyOffsets()[i+1]-1 ], see computeAtomAdjacency().
+    const std::vector<int>& adjacencyOffsets() const { return mAdjacencyOffsets; }
+    //! The indices of the adjacent atoms of every atom, one after the other, see adjacencyOffsets().
+    const std::vector<int>& adjacentAtomIndices() const { return mAdjacentAtomIndices; }
+    //! The index of the bond connecting each atom to the corresponding atom in adjacentAtomIndices().
+    const std::vector<int>& adjacentBondIndices() const { return mAdjacentBondIndices; }
+
+    //! Returns the index of \p atom in atoms() or -1, constant time if isAtomAdjacencyValid().
+    int atomIndex(const Atom* atom) const;
+
+    /** Creates a bond between every pair of atoms closer than the sum of their covalent radii plus \p tolerance (in Angstroms),
+     *  for example for files that lack the bond section. The inferred bonds have type BT_Unknown and do not duplicate existing bonds.
+     *  The candidate pairs are found with a uniform grid, the cost is roughly linear in the number of atoms.
+     *  Returns the number of bonds added and recomputes the atom adjacency. */
+    int inferBonds(float tolerance=0.45f);
+
     //! Returns the i-th cycle
     const std::vector< ref<Atom> >& cycle(int i) const { return mCycles[i]; }
     //! Returns the i-th cycle
@@ -228,16 +256,54 @@ namespace vl
     //! Maps an Actor to it's corresponding Bond
     std::map< ref<Actor>, ref<Bond> >& actorToBondMap() { return mActorToBondMap; }
 
+    /** If enabled the MS_AtomsOnly and MS_BallAndStick styles render all the atoms with a single Actor drawing one point per atom,
+     *  expanded by a geometry shader into a ray cast sphere impostor, and all the bonds with a single Actor drawing one line per bond,
+     *  expanded into a ray cast cylinder impostor, instead of generating an Actor, a Transform and a mesh for each atom and bond (default is false).
+     *  The impostors are pixel exact at any distance and their cost does not depend on atomDetail() and bondDetail().
+     *  The atomToActorMap(), actorToAtomMap(), bondToActorMap() and actorToBondMap() maps are not generated for the impostors,
+     *  see impostorAtom() and impostorBond() instead. If isImpostorRenderingSupported() returns false the meshes are generated as usual. */
+    void setImpostorsEnabled(bool enabled) { mImpostorsEnabled = enabled; }
+    //! Whether the atoms and bonds are rendered as impostors, see setImpostorsEnabled().
+    bool impostorsEnabled() const { return mImpostorsEnabled; }
+
+    //! Returns true if the impostors can be used, i.e. if OpenGL 3.2 is available. Requires an active OpenGL context.
+    static bool isImpostorRenderingSupported();
+
+    //! The Actor rendering the atom impostors, NULL if not generated by the last prepareForRendering().
+    Actor* atomImpostorActor() { return mAtomImpostorActor.get(); }
+    //! The Actor rendering the atom impostors, NULL if not generated by the last prepareForRendering().
+    const Actor* atomImpostorActor() const { return mAtomImpostorActor.get(); }
+    //! The Actor rendering the bond impostors, NULL if not generated by the last prepareForRendering().
+    Actor* bondImpostorActor() { return mBondImpostorActor.get(); }
+    //! The Actor rendering the bond impostors, NULL if not generated by the last prepareForRendering().
+    const Actor* bondImpostorActor() const { return mBondImpostorActor.get(); }
+
+    //! Returns the Atom rendered by the given primitive of atomImpostorActor(), for example PickingRendering::PickResult::mPrimitiveID, or NULL.
+    Atom* impostorAtom(int primitive_id) { return primitive_id >= 0 && primitive_id < (int)mImpostorAtoms.size() ? mImpostorAtoms[primitive_id].get() : NULL; }
+    //! Returns the Atom rendered by the given primitive of atomImpostorActor(), for example PickingRendering::PickResult::mPrimitiveID, or NULL.
+    const Atom* impostorAtom(int primitive_id) const { return primitive_id >= 0 && primitive_id < (int)mImpostorAtoms.size() ? mImpostorAtoms[primitive_id].get() : NULL; }
+    //! Returns the Bond rendered by the given primitive of bondImpostorActor(), for example PickingRendering::PickResult::mPrimitiveID, or NULL.
+    Bond* impostorBond(int primitive_id) { return primitive_id >= 0 && primitive_id < (int)mImpostorBonds.size() ? mImpostorBonds[primitive_id].get() : NULL; }
+    //! Returns the Bond rendered by the given primitive of bondImpostorActor(), for example PickingRendering::PickResult::mPrimitiveID, or NULL.
+    const Bond* impostorBond(int primitive_id) const { return primitive_id >= 0 && primitive_id < (int)mImpostorBonds.size() ? mImpostorBonds[primitive_id].get() : NULL; }
+
+    /** Installs in \p picking the Effects rendering the exact shape of the impostors, see PickingRendering::setCustomPickEffect().
+     *  Without them the impostors would be picked as single points and lines. Needs to be called only once per PickingRendering. */
+    void setupImpostorPicking(PickingRendering* picking);
+
   protected:
     void prepareAtomInsert(int bonus=100)
     {
+      mAtomAdjacencyValid = false;
+      // grows geometrically to keep the loading of large molecules linear
       if (atoms().size() == atoms().capacity())
-        atoms().reserve(atoms().size() + bonus);
+        atoms().reserve(atoms().size() + vl::max(bonus, (int)atoms().size()));
     }
     void prepareBondInsert(int bonus=100)
     {
+      mAtomAdjacencyValid = false;
       if (bonds().size() == bonds().capacity())
-        bonds().reserve(bonds().size() + bonus);
+        bonds().reserve(bonds().size() + vl::max(bonus, (int)bonds().size()));
     }
     void wireframeStyle();
     void atomsStyle();
@@ -246,6 +312,10 @@ namespace vl
     void generateRings();
     void generateAtomLabels();
     void generateAtomLabel(const Atom* atom, Transform* tr);
+    int findBond(const Atom* a1, const Atom* a2) const;
+    void generateAtomImpostors();
+    void generateBondImpostors();
+    void initImpostorEffects();
 
   protected:
     fvec4 mAromaticRingColor;
@@ -258,6 +328,17 @@ namespace vl
     std::map< ref<Actor>, ref<Atom> > mActorToAtomMap;
     std::map< ref<Bond>, ref<Actor> > mBondToActorMap;
     std::map< ref<Actor>, ref<Bond> > mActorToBondMap;
+    std::vector<int> mAdjacencyOffsets;
+    std::vector<int> mAdjacentAtomIndices;
+    std::vector<int> mAdjacentBondIndices;
+    std::vector< ref<Atom> > mImpostorAtoms;
+    std::vector< ref<Bond> > mImpostorBonds;
+    ref<Actor> mAtomImpostorActor;
+    ref<Actor> mBondImpostorActor;
+    ref<Effect> mAtomImpostorEffect;
+    ref<Effect> mBondImpostorEffect;
+    ref<Effect> mAtomImpostorPickEffect;
+    ref<Effect> mBondImpostorPickEffect;
     String mMoleculeName;
     ref<KeyValues> mTags;
     ref<Text> mAtomLabelTemplate;
@@ -272,18 +353,22 @@ namespace vl
     bool mShowAtomNames;
     bool mMoleculeToActorMapEnabled;
     bool mActorToMoleculeMapEnabled;
+    bool mImpostorsEnabled;
+    bool mAtomAdjacencyValid;
   };
 
   //! Loads a Tripos MOL2 file.
   //! The Molecule tags will contain the following key/value pairs:
   //! - \p "MultiMol2Index": the index (0-based) of the structure in a multi MOL2 file.
   //! - \p "FilePath": the full path of the file that contained the structure.
+  //! The bonds of the structures without a bond section are inferred with Molecule::inferBonds().
   VLMOLECULE_EXPORT bool loadMOL2(const String& path, std::vector< ref<Molecule> >& structures);
 
   //! Loads a Tripos MOL2 file.
   //! The Molecule tags will contain the following key/value pairs:
   //! - \p "MultiMol2Index": the index (0-based) of the structure in a multi MOL2 file.
   //! - \p "FilePath": the full path of the file that contained the structure.
+  //! The bonds of the structures without a bond section are inferred with Molecule::inferBonds().
   VLMOLECULE_EXPORT bool loadMOL2(VirtualFile* vfile, std::vector< ref<Molecule> >& structures);
 }
 
@@ -33,6 +33,10 @@
 #include <vlGraphics/GeometryPrimitives.hpp>
 #include <vlGraphics/Text.hpp>
 #include <vlGraphics/Light.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/OpenGL.hpp>
+#include <vlGraphics/PickingRendering.hpp>
+#include <vlCore/Log.hpp>
 
 using namespace vl;
 
@@ -182,10 +186,71 @@ protected:
   float mQuantization;
 };
 //-----------------------------------------------------------------------------
+namespace
+{
+  // Effect rendering the impostors emitted by the given geometry shader, or their picking IDs.
+  ref<Effect> makeImpostorEffect(const char* geometry_shader, bool picking, Light* light)
+  {
+    ref<GLSLProgram> glsl = new GLSLProgram;
+    glsl->attachShader( new GLSLVertexShader("/glsl/molecule_impostor.vs") );
+    glsl->attachShader( new GLSLGeometryShader(geometry_shader) );
+
+    ref<Effect> fx = new Effect;
+    fx->shader()->enable(EN_DEPTH_TEST);
+    if (picking)
+    {
+      glsl->attachShader( new GLSLFragmentShader("/glsl/molecule_impostor_pick.fs") );
+      glsl->bindFragDataLocation(0, "vl_PickOutput");
+    }
+    else
+    {
+      // molecule_impostor.fs reads the light #0 parameters
+      glsl->attachShader( new GLSLFragmentShader("/glsl/molecule_impostor.fs") );
+      fx->shader()->setRenderState(light, 0);
+    }
+    fx->shader()->setRenderState(glsl.get());
+    return fx;
+  }
+}
+//-----------------------------------------------------------------------------
+bool Molecule::isImpostorRenderingSupported()
+{
+  return Has_GL_Version_3_2 || Has_GL_Version_4_0;
+}
+//-----------------------------------------------------------------------------
+void Molecule::initImpostorEffects()
+{
+  if (mAtomImpostorEffect)
+    return;
+
+  ref<Light> light = new Light;
+  mAtomImpostorEffect     = makeImpostorEffect("/glsl/molecule_atom_impostor.gs", false, light.get());
+  mBondImpostorEffect     = makeImpostorEffect("/glsl/molecule_bond_impostor.gs", false, light.get());
+  mAtomImpostorPickEffect = makeImpostorEffect("/glsl/molecule_atom_impostor.gs", true,  NULL);
+  mBondImpostorPickEffect = makeImpostorEffect("/glsl/molecule_bond_impostor.gs", true,  NULL);
+}
+//-----------------------------------------------------------------------------
+void Molecule::setupImpostorPicking(PickingRendering* picking)
+{
+  VL_CHECK(picking)
+  if (!picking)
+    return;
+  initImpostorEffects();
+  picking->setCustomPickEffect(mAtomImpostorEffect.get(), mAtomImpostorPickEffect.get());
+  picking->setCustomPickEffect(mBondImpostorEffect.get(), mBondImpostorPickEffect.get());
+}
+//-----------------------------------------------------------------------------
 void Molecule::prepareForRendering()
 {
   actorTree()->actors()->clear();
   transformTree()->eraseAllChildren();
+  mImpostorAtoms.clear();
+  mImpostorBonds.clear();
+  mAtomImpostorActor = NULL;
+  mBondImpostorActor = NULL;
+
+  if (impostorsEnabled() && !isImpostorRenderingSupported() && (moleculeStyle() == MS_AtomsOnly || moleculeStyle() == MS_BallAndStick))
+    Log::warning("Molecule::prepareForRendering(): impostors require OpenGL 3.2, generating the atom and bond meshes.\n");
 
   switch(moleculeStyle())
   {
@@ -234,6 +299,10 @@ void Molecule::generateAtomLabel(const Atom* atom, Transform* tr)
 //-----------------------------------------------------------------------------
 void Molecule::generateAtomLabels()
 {
+  // avoids a Transform per atom when no label can be generated
+  if (!atomLabelTemplate()->font() || !showAtomNames())
+    return;
+
   for(unsigned i=0; i<atoms().size(); ++i)
   {
     ref<Transform> tr = new Transform(mat4::getTranslation((vec3)atoms()[i]->coordinates()));
@@ -314,6 +383,12 @@ void Molecule::atomsStyle()
   mBondToActorMap.clear();
   mActorToBondMap.clear();
 
+  if (impostorsEnabled() && isImpostorRenderingSupported())
+  {
+    generateAtomImpostors();
+    return;
+  }
+
   EffectCache fx_cache;
   AtomGeometryCache atom_geom_cache;
   atom_geom_cache.setDetail(atomDetail());
@@ -346,6 +421,13 @@ void Molecule::ballAndStickStyle()
   mBondToActorMap.clear();
   mActorToBondMap.clear();
 
+  if (impostorsEnabled() && isImpostorRenderingSupported())
+  {
+    generateAtomImpostors();
+    generateBondImpostors();
+    return;
+  }
+
   EffectCache fx_cache;
   AtomGeometryCache atom_geom_cache;
   atom_geom_cache.setDetail(atomDetail());
@@ -419,6 +501,104 @@ void Molecule::ballAndStickStyle()
   }
 }
 //-----------------------------------------------------------------------------
+void Molecule::generateAtomImpostors()
+{
+  initImpostorEffects();
+
+  // one point per atom: position, color and radius (texture coordinate #0)
+  std::vector<fvec3> pt;
+  std::vector<fvec4> cols;
+  std::vector<float> radii;
+  AABB aabb;
+  for(unsigned iatom=0; iatom<atoms().size(); ++iatom)
+  {
+    Atom* a = atom(iatom);
+    if (a->visible())
+    {
+      pt.push_back( a->coordinates() );
+      cols.push_back( a->color() );
+      radii.push_back( a->radius() );
+      aabb.addPoint( (vec3)a->coordinates(), a->radius() );
+      // the primitive ID is the index of the atom in this list
+      mImpostorAtoms.push_back( a );
+    }
+  }
+  if (pt.empty())
+    return;
+
+  ref<Geometry> geom = new Geometry;
+  ref<ArrayFloat3> points = new ArrayFloat3;
+  ref<ArrayFloat4> colors = new ArrayFloat4;
+  ref<ArrayFloat1> radius = new ArrayFloat1;
+  points->initFrom(pt);
+  colors->initFrom(cols);
+  radius->initFrom(radii);
+  geom->setVertexArray(points.get());
+  geom->setColorArray(colors.get());
+  geom->setTexCoordArray(0, radius.get());
+  geom->drawCalls().push_back(new DrawArrays(PT_POINTS, 0, (int)points->size()));
+  // the vertices are the atom centers, the bounds must include the radii
+  geom->setBoundingBox(aabb);
+  geom->setBoundingSphere(aabb);
+
+  mAtomImpostorActor = new Actor(geom.get(), mAtomImpostorEffect.get(), NULL);
+  actorTree()->actors()->push_back(mAtomImpostorActor.get());
+}
+//-----------------------------------------------------------------------------
+void Molecule::generateBondImpostors()
+{
+  initImpostorEffects();
+
+  // one line per bond: end points, colors and radius (texture coordinate #0)
+  std::vector<fvec3> pt;
+  std::vector<fvec4> cols;
+  std::vector<float> radii;
+  AABB aabb;
+  for(unsigned int ibond=0; ibond<bonds().size(); ++ibond)
+  {
+    Bond* b = bond(ibond);
+    if (b->visible() && b->atom1()->visible() && b->atom2()->visible())
+    {
+      fvec4 c1 = b->color();
+      fvec4 c2 = b->color();
+      if (b->useAtomColors())
+      {
+        c1 = b->atom1()->color();
+        c2 = b->atom2()->color();
+      }
+      pt.push_back( b->atom1()->coordinates() );
+      pt.push_back( b->atom2()->coordinates() );
+      cols.push_back( c1 );
+      cols.push_back( c2 );
+      radii.push_back( b->radius() );
+      radii.push_back( b->radius() );
+      aabb.addPoint( (vec3)b->atom1()->coordinates(), b->radius() );
+      aabb.addPoint( (vec3)b->atom2()->coordinates(), b->radius() );
+      // the primitive ID is the index of the bond in this list
+      mImpostorBonds.push_back( b );
+    }
+  }
+  if (pt.empty())
+    return;
+
+  ref<Geometry> geom = new Geometry;
+  ref<ArrayFloat3> points = new ArrayFloat3;
+  ref<ArrayFloat4> colors = new ArrayFloat4;
+  ref<ArrayFloat1> radius = new ArrayFloat1;
+  points->initFrom(pt);
+  colors->initFrom(cols);
+  radius->initFrom(radii);
+  geom->setVertexArray(points.get());
+  geom->setColorArray(colors.get());
+  geom->setTexCoordArray(0, radius.get());
+  geom->drawCalls().push_back(new DrawArrays(PT_LINES, 0, (int)points->size()));
+  geom->setBoundingBox(aabb);
+  geom->setBoundingSphere(aabb);
+
+  mBondImpostorActor = new Actor(geom.get(), mBondImpostorEffect.get(), NULL);
+  actorTree()->actors()->push_back(mBondImpostorActor.get());
+}
+//-----------------------------------------------------------------------------
 void Molecule::sticksStyle()
 {
   mAtomToActorMap.clear();
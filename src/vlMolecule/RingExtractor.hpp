@@ -41,6 +41,7 @@
 namespace vl
 {
   //! The RingExtractor class traverses a molecule's graph and detects various types of cycles, mainly used for aromatic ring detection.
+  //! The graph is visited through the index-based adjacency computed by Molecule::computeAtomAdjacency().
   class RingExtractor
   {
   public:
@@ -54,6 +55,12 @@ namespace vl
     {
       if (!molecule()->atoms().empty())
       {
+        // keepAromaticCycles() discards every cycle containing a non aromatic bond
+        if (!hasAromaticBonds())
+        {
+          molecule()->cycles().clear();
+          return;
+        }
         bootstrap();
         removeDoubles();
         sortCycles();
@@ -63,28 +70,37 @@ namespace vl
       }
     }
 
+    bool hasAromaticBonds() const
+    {
+      for(int i=0; i<molecule()->bondCount(); ++i)
+        if (molecule()->bond(i)->bondType() == BT_Aromatic)
+          return true;
+      return false;
+    }
+
     void bootstrap()
     {
       if (!molecule()->atoms().empty())
       {
         molecule()->computeAtomAdjacency();
-        for(int i=0; i<molecule()->atomCount(); ++i)
-          molecule()->atom(i)->setVisited(false);
-        std::vector< ref<Atom> > current_path;
-        depthFirstVisit( molecule()->atoms()[0].get(), current_path );
+        mVisited.assign(molecule()->atomCount(), 0);
+        std::vector<int> current_path;
+        depthFirstVisit( 0, current_path );
       }
     }
 
-    void depthFirstVisit(Atom* atom, std::vector< ref<Atom> >& current_path)
+    //! Visits the atoms reachable from the atom with index \p iatom, \p current_path contains the indices of the atoms being visited.
+    void depthFirstVisit(int iatom, std::vector<int>& current_path)
     {
-      if ( !atom->visited() || current_path.empty())
+      if ( !mVisited[iatom] || current_path.empty())
       {
-        atom->setVisited(true);
-        current_path.push_back(atom);
-        for(unsigned i=0; i<atom->adjacentAtoms().size(); ++i)
-          depthFirstVisit( atom->adjacentAtoms()[i], current_path );
+        mVisited[iatom] = 1;
+        current_path.push_back(iatom);
+        const std::vector<int>& offsets = molecule()->adjacencyOffsets();
+        for(int k=offsets[iatom]; k<offsets[iatom+1]; ++k)
+          depthFirstVisit( molecule()->adjacentAtomIndices()[k], current_path );
         current_path.pop_back();
-        atom->setVisited(false);
+        mVisited[iatom] = 0;
       }
       else // cycle found
       {
@@ -92,11 +108,11 @@ namespace vl
 
         for(size_t i = current_path.size()-1; i--; )
         {
-          if ( current_path[i] == atom )
+          if ( current_path[i] == iatom )
           {
             std::vector< ref<Atom> > cycle;
             for(; i<current_path.size(); ++i)
-              cycle.push_back( current_path[i] );
+              cycle.push_back( molecule()->atom(current_path[i]) );
             if (cycle.size() > 2)
               molecule()->cycles().push_back(cycle);
             break;
@@ -207,15 +223,14 @@ namespace vl
     {
       std::vector< std::vector< ref<Atom> > > sub_cycles;
 
-      std::map<Atom*, bool> my_atom;
-      for(unsigned j=0; j<molecule()->atoms().size(); ++j)
-        my_atom[molecule()->atoms()[j].get()] = false;
+      // indexed by Molecule::atomIndex()
+      std::vector<char> my_atom(molecule()->atoms().size(), 0);
 
       for(unsigned icycle=0; icycle<molecule()->cycles().size(); ++icycle)
       {
         // init
         for(unsigned j=0; j<molecule()->cycles()[icycle].size(); ++j)
-          my_atom[ molecule()->cycles()[icycle][j].get() ] = true;
+          my_atom[ molecule()->atomIndex( molecule()->cycles()[icycle][j].get() ) ] = 1;
 
         bool is_sup_cycle = false;
         for(unsigned j=0; j<molecule()->cycles().size(); ++j)
@@ -224,7 +239,7 @@ namespace vl
             continue;
           unsigned shared_atoms = 0;
           for(unsigned k=0; k<molecule()->cycles()[j].size(); k++)
-            shared_atoms += my_atom[ molecule()->cycles()[j][k].get() ] ? 1 : 0;
+            shared_atoms += my_atom[ molecule()->atomIndex( molecule()->cycles()[j][k].get() ) ] ? 1 : 0;
           if ( shared_atoms == molecule()->cycles()[j].size() )
           {
             is_sup_cycle = true;
@@ -236,13 +251,14 @@ namespace vl
 
         // reset
         for(unsigned j=0; j<molecule()->cycles()[icycle].size(); ++j)
-          my_atom[ molecule()->cycles()[icycle][j].get() ] = false;
+          my_atom[ molecule()->atomIndex( molecule()->cycles()[icycle][j].get() ) ] = 0;
       }
       molecule()->cycles() = sub_cycles;
     }
 
   protected:
     Molecule* mMolecule;
+    std::vector<char> mVisited;
   };
 }
 
@@ -155,6 +155,10 @@ namespace
     // by default set cpk colors
     structure->setCPKAtomColors();
 
+    // files lacking the bond section: infer the bonds from the covalent radii
+    if (structure->bonds().empty())
+      structure->inferBonds();
+
     // compute adjacent atoms
     structure->computeAtomAdjacency();
 
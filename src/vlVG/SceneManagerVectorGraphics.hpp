@@ -83,6 +83,13 @@ namespace vl
       int actor_rank = mActorRenderRankStart;
       for(int i=0; i<vectorGraphicObjects()->size(); ++i)
       {
+        // retained primitives are rendered first, one Actor per batch
+        vectorGraphicObjects()->at(i)->updateRetainedBatches();
+        for(int j=0; j<vectorGraphicObjects()->at(i)->retainedActors()->size(); ++j)
+        {
+          vectorGraphicObjects()->at(i)->retainedActors()->at(j)->setRenderRank( actor_rank++ );
+          queue.push_back( vectorGraphicObjects()->at(i)->retainedActors()->at(j) );
+        }
         for(int j=0; j<vectorGraphicObjects()->at(i)->actors()->size(); ++j)
         {
           vectorGraphicObjects()->at(i)->actors()->at(j)->setRenderRank( actor_rank++ );
@@ -39,6 +39,8 @@ VectorGraphics::VectorGraphics()
   mDefaultEffect = new Effect;
   mDefaultEffect->shader()->enable(EN_BLEND);
   mActors.setAutomaticDelete(false);
+  mRetainedActors.setAutomaticDelete(false);
+  mLastRetainedHandle = 0;
 }
 //-----------------------------------------------------------------------------
 Actor* VectorGraphics::drawLine(double x1, double y1, double x2, double y2)
@@ -54,20 +56,7 @@ Actor* VectorGraphics::drawLines(const std::vector<dvec2>& ln)
   // fill the vertex position array
   ref<Geometry> geom = prepareGeometry(ln);
   // generate texture coords
-  if (mState.mImage)
-  {
-    ref<ArrayFloat2> tex_array = new ArrayFloat2;
-    tex_array->resize(geom->vertexArray()->size());
-    float u1 = 1.0f / mState.mImage->width() * 0.5f;
-    float u2 = 1.0f - 1.0f / mState.mImage->width() * 0.5f;
-    for(size_t i=0; i<tex_array->size(); i+=2)
-    {
-      tex_array->at(i+0) = fvec2(u1, 0);
-      tex_array->at(i+1) = fvec2(u2, 0);
-    }
-    // generate geometry
-    geom->setTexCoordArray(0, tex_array.get());
-  }
+  generateLinesTexCoords(geom.get());
   // issue the primitive
   geom->drawCalls().push_back( new DrawArrays(PT_LINES, 0, (int)ln.size()) );
   // add the actor
@@ -100,6 +89,9 @@ Actor* VectorGraphics::drawLineLoop(const std::vector<dvec2>& ln)
 //-----------------------------------------------------------------------------
 Actor* VectorGraphics::fillPolygon(const std::vector<dvec2>& poly)
 {
+  if (mState.mPolygonFillMode != PolygonFill_Convex)
+    return fillPolygonStencilCover(poly);
+
   // fill the vertex position array
   ref<Geometry> geom = prepareGeometryPolyToTriangles(poly);
   // generate texture coords
@@ -110,6 +102,45 @@ Actor* VectorGraphics::fillPolygon(const std::vector<dvec2>& poly)
   return addActor( new Actor(geom.get(), currentEffect(), NULL) );
 }
 //-----------------------------------------------------------------------------
+Actor* VectorGraphics::fillPolygonStencilCover(const std::vector<dvec2>& poly)
+{
+  // stencil: the triangle fan leaves a non-zero stencil value inside the polygon
+  ref<Geometry> fan = prepareGeometry(poly);
+  fan->drawCalls().push_back( new DrawArrays(PT_TRIANGLE_FAN, 0, (int)poly.size()) );
+  addActor( new Actor(fan.get(), stencilFillEffect(mState.mPolygonFillMode), NULL) );
+
+  // cover: a quad bounding the polygon drawn where the stencil is not zero, which also resets it to zero
+  dvec2 min_corner = poly.empty() ? dvec2() : poly[0];
+  dvec2 max_corner = min_corner;
+  for(unsigned i=1; i<poly.size(); ++i)
+  {
+    min_corner.x() = poly[i].x() < min_corner.x() ? poly[i].x() : min_corner.x();
+    min_corner.y() = poly[i].y() < min_corner.y() ? poly[i].y() : min_corner.y();
+    max_corner.x() = poly[i].x() > max_corner.x() ? poly[i].x() : max_corner.x();
+    max_corner.y() = poly[i].y() > max_corner.y() ? poly[i].y() : max_corner.y();
+  }
+  std::vector<dvec2> quad;
+  quad.push_back(dvec2(min_corner.x(),min_corner.y()));
+  quad.push_back(dvec2(min_corner.x(),max_corner.y()));
+  quad.push_back(dvec2(max_corner.x(),max_corner.y()));
+  quad.push_back(dvec2(max_corner.x(),min_corner.y()));
+  ref<Geometry> cover = prepareGeometry(quad);
+  // the quad has the same bounding box as the polygon hence the same planar texture coordinates
+  generatePlanarTexCoords(cover.get(), quad);
+  cover->drawCalls().push_back( new DrawArrays(PT_TRIANGLE_FAN, 0, (int)quad.size()) );
+
+  State cover_state = mState;
+  cover_state.mStencilTestEnabled   = true;
+  cover_state.mStencilMask          = 0xFFFFFFFF;
+  cover_state.mStencil_SFail        = SO_KEEP;
+  cover_state.mStencil_DpFail       = SO_KEEP;
+  cover_state.mStencil_DpPass       = SO_ZERO;
+  cover_state.mStencil_Function     = FU_NOTEQUAL;
+  cover_state.mStencil_RefValue     = 0;
+  cover_state.mStencil_FunctionMask = ~(unsigned int)0;
+  return addActor( new Actor(cover.get(), currentEffect(cover_state), NULL) );
+}
+//-----------------------------------------------------------------------------
 Actor* VectorGraphics::fillTriangles(const std::vector<dvec2>& triangles)
 {
   // fill the vertex position array
@@ -274,6 +305,7 @@ void VectorGraphics::endDrawing(bool release_cache)
     mVGToEffectMap.clear();
     mImageToTextureMap.clear();
     mRectToScissorMap.clear();
+    mStencilFillEffect[0] = mStencilFillEffect[1] = NULL;
   }
   /*mState  = State();
   mMatrix = dmat4();*/
@@ -290,6 +322,7 @@ void VectorGraphics::clear()
   mVGToEffectMap.clear();
   mImageToTextureMap.clear();
   mRectToScissorMap.clear();
+  mStencilFillEffect[0] = mStencilFillEffect[1] = NULL;
 
   // restore the default states
   mState  = State();
@@ -651,6 +684,24 @@ void VectorGraphics::generateLinearTexCoords(Geometry* geom)
   }
 }
 //-----------------------------------------------------------------------------
+void VectorGraphics::generateLinesTexCoords(Geometry* geom)
+{
+  if (mState.mImage)
+  {
+    ref<ArrayFloat2> tex_array = new ArrayFloat2;
+    tex_array->resize(geom->vertexArray()->size());
+    float u1 = 1.0f / mState.mImage->width() * 0.5f;
+    float u2 = 1.0f - 1.0f / mState.mImage->width() * 0.5f;
+    for(size_t i=0; i+1<tex_array->size(); i+=2)
+    {
+      tex_array->at(i+0) = fvec2(u1, 0);
+      tex_array->at(i+1) = fvec2(u2, 0);
+    }
+    // generate geometry
+    geom->setTexCoordArray(0, tex_array.get());
+  }
+}
+//-----------------------------------------------------------------------------
 ref<Geometry> VectorGraphics::prepareGeometryPolyToTriangles(const std::vector<dvec2>& ln)
 {
   // transform the lines
@@ -832,6 +883,32 @@ Effect* VectorGraphics::currentEffect(const State& vgs)
   return effect;
 }
 //-----------------------------------------------------------------------------
+Effect* VectorGraphics::stencilFillEffect(EPolygonFillMode mode)
+{
+  VL_CHECK(mode == PolygonFill_EvenOdd || mode == PolygonFill_NonZero)
+  const int index = mode == PolygonFill_NonZero ? 1 : 0;
+  if (!mStencilFillEffect[index])
+  {
+    mStencilFillEffect[index] = new Effect;
+    Shader* shader = mStencilFillEffect[index]->shader();
+    // touch only the stencil buffer
+    shader->gocColorMask()->set(false, false, false, false);
+    shader->gocDepthMask()->set(false);
+    shader->enable(EN_STENCIL_TEST);
+    shader->gocStencilMask()->set(PF_FRONT_AND_BACK, 0xFFFFFFFF);
+    shader->gocStencilFunc()->set(PF_FRONT_AND_BACK, FU_ALWAYS, 0, ~(unsigned int)0);
+    if (mode == PolygonFill_NonZero)
+    {
+      // the fan triangles wound one way count +1, the others -1
+      shader->gocStencilOp()->set(PF_FRONT, SO_KEEP, SO_KEEP, SO_INCR_WRAP);
+      shader->gocStencilOp()->set(PF_BACK,  SO_KEEP, SO_KEEP, SO_DECR_WRAP);
+    }
+    else
+      shader->gocStencilOp()->set(PF_FRONT_AND_BACK, SO_KEEP, SO_KEEP, SO_INVERT);
+  }
+  return mStencilFillEffect[index].get();
+}
+//-----------------------------------------------------------------------------
 Actor* VectorGraphics::addActor(Actor* actor)
 {
   actor->setScissor(mScissor.get());
@@ -839,3 +916,245 @@ Actor* VectorGraphics::addActor(Actor* actor)
   return actor;
 }
 //-----------------------------------------------------------------------------
+int VectorGraphics::retain(EPrimitiveType primitive, const std::vector<dvec2>& points)
+{
+  int handle = ++mLastRetainedHandle;
+  return retainItem(handle, primitive, points) ? handle : 0;
+}
+//-----------------------------------------------------------------------------
+bool VectorGraphics::updateRetained(int handle, EPrimitiveType primitive, const std::vector<dvec2>& points)
+{
+  if (!removeRetained(handle))
+    return false;
+  return retainItem(handle, primitive, points);
+}
+//-----------------------------------------------------------------------------
+bool VectorGraphics::removeRetained(int handle)
+{
+  std::map<int, RetainedBatch*>::iterator it = mRetainedItems.find(handle);
+  if (it == mRetainedItems.end())
+  {
+    Log::error( Say("VectorGraphics::removeRetained(): invalid handle %n.\n") << handle );
+    return false;
+  }
+  it->second->mItems.erase(handle);
+  it->second->mDirty = true;
+  mRetainedItems.erase(it);
+  return true;
+}
+//-----------------------------------------------------------------------------
+void VectorGraphics::clearRetained()
+{
+  mRetainedBatches.clear();
+  mRetainedItems.clear();
+  mRetainedActors.clear();
+}
+//-----------------------------------------------------------------------------
+void VectorGraphics::updateRetainedBatches()
+{
+  for(std::map<RetainedKey, ref<RetainedBatch> >::iterator it = mRetainedBatches.begin(); it != mRetainedBatches.end(); )
+  {
+    RetainedBatch* batch = it->second.get();
+    if (!batch->mDirty)
+    {
+      ++it;
+      continue;
+    }
+
+    // empty batches are removed together with their Actor
+    if (batch->mItems.empty())
+    {
+      for(int i=0; i<mRetainedActors.size(); ++i)
+      {
+        if (mRetainedActors.at(i) == batch->mActor.get())
+        {
+          mRetainedActors.eraseAt(i);
+          break;
+        }
+      }
+      mRetainedBatches.erase(it++);
+      continue;
+    }
+
+    // concatenate the items in creation order
+    size_t vert_count = 0;
+    for(std::map<int, RetainedItem>::const_iterator item = batch->mItems.begin(); item != batch->mItems.end(); ++item)
+      vert_count += item->second.mVerts.size();
+
+    Geometry* geom = cast<Geometry>(batch->mActor->lod(0));
+    ArrayFloat3* pos_array = cast<ArrayFloat3>(geom->vertexArray());
+    ArrayFloat2* tex_array = cast<ArrayFloat2>(geom->texCoordArray(0));
+    pos_array->resize(vert_count);
+    if (tex_array)
+      tex_array->resize(vert_count);
+    size_t ivert = 0;
+    for(std::map<int, RetainedItem>::const_iterator item = batch->mItems.begin(); item != batch->mItems.end(); ++item)
+    {
+      const RetainedItem& ri = item->second;
+      if (!ri.mVerts.empty())
+        memcpy(pos_array->ptr() + ivert * sizeof(fvec3), &ri.mVerts[0], ri.mVerts.size() * sizeof(fvec3));
+      if (tex_array && !ri.mTexCoords.empty())
+        memcpy(tex_array->ptr() + ivert * sizeof(fvec2), &ri.mTexCoords[0], ri.mTexCoords.size() * sizeof(fvec2));
+      ivert += ri.mVerts.size();
+    }
+    pos_array->setBufferObjectDirty(true);
+    if (tex_array)
+      tex_array->setBufferObjectDirty(true);
+    cast<DrawArrays>(geom->drawCalls().at(0))->setCount((int)vert_count);
+    geom->setBufferObjectDirty(true);
+    geom->setDisplayListDirty(true);
+    geom->setBoundsDirty(true);
+    batch->mDirty = false;
+    ++it;
+  }
+}
+//-----------------------------------------------------------------------------
+bool VectorGraphics::retainItem(int handle, EPrimitiveType primitive, const std::vector<dvec2>& points)
+{
+  // vertices and texture coordinates are generated as in immediate mode, then the primitive is
+  // converted to independent points, lines or triangles so that it can be merged with the others
+  EPrimitiveType batch_primitive = PT_POINTS;
+  ref<Geometry> geom = prepareGeometry(points);
+  switch(primitive)
+  {
+    case PT_POINTS:
+      batch_primitive = PT_POINTS;
+      // needed for pixel/perfect rendering
+      if (mState.mPointSize % 2 == 0)
+      {
+        ArrayFloat3* pos_array = cast<ArrayFloat3>(geom->vertexArray());
+        for(size_t i=0; i<pos_array->size(); ++i)
+        {
+          pos_array->at(i).s() += 0.5;
+          pos_array->at(i).t() += 0.5;
+        }
+      }
+      break;
+    case PT_LINES:
+      batch_primitive = PT_LINES;
+      generateLinesTexCoords(geom.get());
+      break;
+    case PT_LINE_STRIP:
+    case PT_LINE_LOOP:
+      batch_primitive = PT_LINES;
+      generateLinearTexCoords(geom.get());
+      break;
+    case PT_QUADS:
+      batch_primitive = PT_TRIANGLES;
+      generateQuadsTexCoords(geom.get(), points);
+      break;
+    case PT_TRIANGLES:
+    case PT_TRIANGLE_FAN:
+    case PT_TRIANGLE_STRIP:
+    case PT_QUAD_STRIP:
+    case PT_POLYGON:
+      batch_primitive = PT_TRIANGLES;
+      generatePlanarTexCoords(geom.get(), points);
+      break;
+    default:
+      Log::error("VectorGraphics::retain(): unsupported primitive type.\n");
+      return false;
+  }
+
+  // compute the vertex indices of the independent primitives
+  const int count = (int)points.size();
+  std::vector<int> idx;
+  switch(primitive)
+  {
+    case PT_POINTS:
+      for(int i=0; i<count; ++i)
+        idx.push_back(i);
+      break;
+    case PT_LINES:
+      for(int i=0; i+1<count; i+=2)
+        { idx.push_back(i); idx.push_back(i+1); }
+      break;
+    case PT_LINE_STRIP:
+    case PT_LINE_LOOP:
+      for(int i=0; i+1<count; ++i)
+        { idx.push_back(i); idx.push_back(i+1); }
+      if (primitive == PT_LINE_LOOP && count > 2)
+        { idx.push_back(count-1); idx.push_back(0); }
+      break;
+    case PT_TRIANGLES:
+      for(int i=0; i+2<count; i+=3)
+        { idx.push_back(i); idx.push_back(i+1); idx.push_back(i+2); }
+      break;
+    case PT_TRIANGLE_FAN:
+    case PT_POLYGON:
+      for(int i=1; i+1<count; ++i)
+        { idx.push_back(0); idx.push_back(i); idx.push_back(i+1); }
+      break;
+    case PT_TRIANGLE_STRIP:
+      for(int i=0; i+2<count; ++i)
+      {
+        if (i % 2)
+          { idx.push_back(i); idx.push_back(i+2); idx.push_back(i+1); }
+        else
+          { idx.push_back(i); idx.push_back(i+1); idx.push_back(i+2); }
+      }
+      break;
+    case PT_QUADS:
+      for(int i=0; i+3<count; i+=4)
+      {
+        idx.push_back(i); idx.push_back(i+1); idx.push_back(i+2);
+        idx.push_back(i); idx.push_back(i+2); idx.push_back(i+3);
+      }
+      break;
+    case PT_QUAD_STRIP:
+      for(int i=0; i+3<count; i+=2)
+      {
+        idx.push_back(i); idx.push_back(i+1); idx.push_back(i+3);
+        idx.push_back(i); idx.push_back(i+3); idx.push_back(i+2);
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (idx.empty())
+  {
+    Log::error("VectorGraphics::retain(): not enough points for the given primitive type.\n");
+    return false;
+  }
+
+  // find or create the batch sharing the current state and scissor
+  RetainedKey key;
+  key.mState = mState;
+  key.mScissorEnabled = mScissor.get() != NULL;
+  if (mScissor)
+    key.mScissorRect = mScissor->scissorRect();
+  key.mPrimitiveType = batch_primitive;
+  ref<RetainedBatch>& batch = mRetainedBatches[key];
+  if (!batch)
+  {
+    batch = new RetainedBatch;
+    batch->mKey = key;
+    ref<Geometry> batch_geom = new Geometry;
+    batch_geom->setVertexArray( new ArrayFloat3 );
+    if (mState.mImage)
+      batch_geom->setTexCoordArray( 0, new ArrayFloat2 );
+    batch_geom->drawCalls().push_back( new DrawArrays(batch_primitive, 0, 0) );
+    batch->mActor = new Actor(batch_geom.get(), currentEffect(), NULL);
+    batch->mActor->setScissor(mScissor.get());
+    mRetainedActors.push_back(batch->mActor.get());
+  }
+
+  // store the item
+  const ArrayFloat3* pos_array = cast<const ArrayFloat3>(geom->vertexArray());
+  const ArrayFloat2* tex_array = cast<const ArrayFloat2>(geom->texCoordArray(0));
+  RetainedItem& item = batch->mItems[handle];
+  item.mVerts.resize(idx.size());
+  for(size_t i=0; i<idx.size(); ++i)
+    item.mVerts[i] = pos_array->at(idx[i]);
+  if (mState.mImage)
+  {
+    item.mTexCoords.resize(idx.size());
+    for(size_t i=0; i<idx.size(); ++i)
+      item.mTexCoords[i] = tex_array ? tex_array->at(idx[i]) : fvec2(0,0);
+  }
+  batch->mDirty = true;
+  mRetainedItems[handle] = batch.get();
+  return true;
+}
+//-----------------------------------------------------------------------------
@@ -56,6 +56,17 @@ namespace vl
     TextureMode_Repeat
   } ETextureMode;
 
+  //! Defines how fillPolygon() fills a polygon
+  typedef enum
+  {
+    //! The polygon is drawn as a triangle fan, correct only for convex polygons (default)
+    PolygonFill_Convex,
+    //! Stencil-then-cover using the even-odd rule, works with concave and self-intersecting polygons
+    PolygonFill_EvenOdd,
+    //! Stencil-then-cover using the non-zero winding rule, works with concave and self-intersecting polygons
+    PolygonFill_NonZero
+  } EPolygonFillMode;
+
   //! Poligon stipple patterns
   typedef enum
   {
@@ -100,6 +111,7 @@ namespace vl
    * - Scissor test to clip the objects against a rectangular region
    * - Line and point smoothing
    * - Color logic operations
+   * - Retained mode: primitives stored by handle and merged in one draw call per State, see retain()
    *
    * For more information please refer to the \ref pagGuideVectorGraphics "2D Vector Graphics" page.
    */
@@ -173,6 +185,8 @@ namespace vl
         mStencil_Function = FU_ALWAYS;
         mStencil_RefValue = 0;
         mStencil_FunctionMask = ~(unsigned int)0;
+        // polygon fill
+        mPolygonFillMode = PolygonFill_Convex;
       }
 
       fvec4 mColor;
@@ -206,6 +220,8 @@ namespace vl
       EFunction  mStencil_Function;
       int          mStencil_RefValue;
       unsigned int         mStencil_FunctionMask;
+      // selects the Actors generated by fillPolygon(), does not affect the Effect
+      EPolygonFillMode mPolygonFillMode;
 
       bool operator<(const State& other) const
       {
@@ -321,6 +337,53 @@ namespace vl
           return false;
       }
     };
+    //------------------------------------------------------------------------- start internal
+    //! \internal
+    class RetainedKey
+    {
+    public:
+      RetainedKey(): mScissorEnabled(false), mPrimitiveType(PT_POINTS) {}
+
+      bool operator<(const RetainedKey& other) const
+      {
+        if (mPrimitiveType != other.mPrimitiveType)
+          return mPrimitiveType < other.mPrimitiveType;
+        else
+        if (mScissorEnabled != other.mScissorEnabled)
+          return mScissorEnabled < other.mScissorEnabled;
+        else
+        if (mScissorEnabled && (mScissorRect < other.mScissorRect || other.mScissorRect < mScissorRect))
+          return mScissorRect < other.mScissorRect;
+        else
+          return mState < other.mState;
+      }
+
+      State mState;
+      RectI mScissorRect;
+      bool mScissorEnabled;
+      EPrimitiveType mPrimitiveType;
+    };
+    //------------------------------------------------------------------------- start internal
+    //! \internal
+    class RetainedItem
+    {
+    public:
+      std::vector<fvec3> mVerts;
+      std::vector<fvec2> mTexCoords;
+    };
+    //------------------------------------------------------------------------- start internal
+    //! \internal
+    //! All the retained items sharing the same RetainedKey, rendered by a single Actor and draw call.
+    class RetainedBatch: public Object
+    {
+    public:
+      RetainedBatch(): mDirty(true) {}
+
+      RetainedKey mKey;
+      ref<Actor> mActor;
+      std::map<int, RetainedItem> mItems;
+      bool mDirty;
+    };
     //------------------------------------------------------------------------- end internal
 
   public:
@@ -344,7 +407,12 @@ namespace vl
     //! Renders a closed line passing through the points defined by 'ln'.
     Actor* drawLineLoop(const std::vector<dvec2>& ln);
 
-    //! Renders a convex polygon whose corners are defined by 'poly'
+    /** Renders a polygon whose corners are defined by 'poly'.
+     * With the default PolygonFill_Convex mode the polygon is drawn as a triangle fan and must be convex.
+     * With PolygonFill_EvenOdd and PolygonFill_NonZero any polygon is filled without tessellation: a first Actor draws the
+     * triangle fan in the stencil buffer only, and the returned Actor draws a quad covering the polygon where the stencil is
+     * not zero, resetting it to zero. These modes require a stencil buffer and override the current stencil settings.
+     * \see setPolygonFillMode() */
     Actor* fillPolygon(const std::vector<dvec2>& poly);
 
     //! Renders a set of triangles. The 'triangles' parameters must contain N triplets of dvec2. Each triplet defines a triangle.
@@ -527,6 +595,12 @@ namespace vl
     //! The current stencil function.
     void getStencilFunc(EFunction& func, int& refval, unsigned int& mask);
 
+    //! Sets how fillPolygon() fills the polygons, see EPolygonFillMode. Does not affect the retained primitives.
+    void setPolygonFillMode(EPolygonFillMode mode) { mState.mPolygonFillMode = mode; }
+
+    //! Returns how fillPolygon() fills the polygons.
+    EPolygonFillMode polygonFillMode() const { return mState.mPolygonFillMode; }
+
     //! Sets the current Font
     void setFont(const String& name, int size, bool smooth=false) { mState.mFont = defFontManager()->acquireFont(name,size,smooth); }
 
@@ -588,6 +662,38 @@ namespace vl
      * This function is useful when you want to crate multiple instances of the same geometry. */
     Actor* drawActorCopy(Actor* actor, Transform* transform=NULL);
 
+    /** Stores the given primitive in retained mode and returns a handle to it, or 0 on failure.
+     * The primitive is transformed by the current matrix() and captures the current state and scissor, as the draw* and fill* functions do.
+     * Unlike those functions no Actor is created: the primitives sharing the same state and scissor are merged into a single
+     * vertex array and rendered with a single draw call. Line strips and loops are converted to PT_LINES, while triangle fans and strips,
+     * quads, quad strips and polygons are converted to PT_TRIANGLES, polygons being treated as convex like in fillPolygon().
+     * Retained primitives are not affected by startDrawing() and clear() and are rendered before the Actor[s] returned by actors().
+     * \sa updateRetained(), removeRetained(), clearRetained(), updateRetainedBatches() */
+    int retain(EPrimitiveType primitive, const std::vector<dvec2>& points);
+
+    /** Replaces the retained primitive identified by \p handle with the given one using the current matrix, state and scissor.
+     * Returns false if \p handle does not exist or the new primitive is not valid, in which case the primitive is removed. */
+    bool updateRetained(int handle, EPrimitiveType primitive, const std::vector<dvec2>& points);
+
+    //! Removes the retained primitive identified by \p handle. Returns false if the handle does not exist.
+    bool removeRetained(int handle);
+
+    //! Removes all the retained primitives.
+    void clearRetained();
+
+    //! Returns the number of retained primitives.
+    int retainedCount() const { return (int)mRetainedItems.size(); }
+
+    /** Rebuilds the vertex arrays of the batches whose retained primitives have been added, updated or removed.
+     * This function is automatically called by SceneManagerVectorGraphics before the rendering. */
+    void updateRetainedBatches();
+
+    //! The Actor[s] rendering the retained primitives, one for each batch.
+    const ActorCollection* retainedActors() const { return &mRetainedActors; }
+
+    //! The Actor[s] rendering the retained primitives, one for each batch.
+    ActorCollection* retainedActors() { return &mRetainedActors; }
+
     //! Returns the current transform matrix
     const dmat4& matrix() const { return mMatrix; }
 
@@ -647,6 +753,8 @@ namespace vl
 
     void generateLinearTexCoords(Geometry* geom);
 
+    void generateLinesTexCoords(Geometry* geom);
+
     ref<Geometry> prepareGeometry(const std::vector<dvec2>& ln);
 
     ref<Geometry> prepareGeometryPolyToTriangles(const std::vector<dvec2>& ln);
@@ -657,8 +765,14 @@ namespace vl
 
     Effect* currentEffect(const State& vgs);
 
+    Effect* stencilFillEffect(EPolygonFillMode mode);
+
+    Actor* fillPolygonStencilCover(const std::vector<dvec2>& poly);
+
     Actor* addActor(Actor* actor) ;
 
+    bool retainItem(int handle, EPrimitiveType primitive, const std::vector<dvec2>& points);
+
   private:
     // state-machine state variables
     State mState;
@@ -671,8 +785,14 @@ namespace vl
     std::map<State, ref<Effect> > mVGToEffectMap;
     std::map<ImageState, ref<Texture> > mImageToTextureMap;
     std::map<RectI, ref<Scissor> > mRectToScissorMap;
+    ref<Effect> mStencilFillEffect[2];
     ref<Effect> mDefaultEffect;
     ActorCollection mActors;
+    // retained mode
+    std::map<RetainedKey, ref<RetainedBatch> > mRetainedBatches;
+    std::map<int, RetainedBatch*> mRetainedItems;
+    ActorCollection mRetainedActors;
+    int mLastRetainedHandle;
   };
 //-------------------------------------------------------------------------------------------------------------------------------------------
 }
@@ -0,0 +1,976 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlVolume/BrickedVolume.hpp>
+#include <vlGraphics/Actor.hpp>
+#include <vlGraphics/Camera.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlCore/DiskFile.hpp>
+#include <vlCore/FileSystem.hpp>
+#include <vlCore/ScopedMutex.hpp>
+#include <vlCore/plugins/ioDAT.hpp>
+#include <vlCore/plugins/ioMHD.hpp>
+#if defined(VL_IO_2D_TIFF)
+  #include <vlCore/plugins/ioTIFF.hpp>
+#endif
+#include <vlCore/Log.hpp>
+#include <vlCore/Say.hpp>
+#include <algorithm>
+#include <cmath>
+
+using namespace vl;
+
+namespace
+{
+  int sampleBytes(EImageType type)
+  {
+    switch(type)
+    {
+    case IT_UNSIGNED_BYTE:  return 1;
+    case IT_UNSIGNED_SHORT: return 2;
+    case IT_SHORT:          return 2;
+    case IT_FLOAT:          return 4;
+    default:                return 0;
+    }
+  }
+
+  template<typename T> T roundSample(double v) { return (T)floor(v + 0.5); }
+  template<> float roundSample<float>(double v) { return (float)v; }
+
+  // averages 2x2x2 samples of 'src', which has twice the size of 'dst'
+  template<typename T>
+  void downsample2(const T* src, T* dst, const ivec3& dst_size)
+  {
+    const int sx = dst_size.x() * 2;
+    const int sxy = sx * dst_size.y() * 2;
+    for(int z=0; z<dst_size.z(); ++z)
+    {
+      for(int y=0; y<dst_size.y(); ++y)
+      {
+        for(int x=0; x<dst_size.x(); ++x)
+        {
+          const T* s = src + 2*x + 2*y*sx + 2*z*sxy;
+          double sum = (double)s[0] + s[1] + s[sx] + s[sx+1] + s[sxy] + s[sxy+1] + s[sxy+sx] + s[sxy+sx+1];
+          *dst++ = roundSample<T>(sum / 8);
+        }
+      }
+    }
+  }
+
+  // averages 2x2 samples of two slices, replicating the last row and column of odd sized slices
+  template<typename T>
+  void downsampleSlices(const T* slice0, const T* slice1, int w, int h, T* dst)
+  {
+    const int dw = (w + 1) / 2;
+    const int dh = (h + 1) / 2;
+    for(int y=0; y<dh; ++y)
+    {
+      const int y0 = (y*2) * w;
+      const int y1 = std::min(y*2 + 1, h - 1) * w;
+      for(int x=0; x<dw; ++x)
+      {
+        const int x0 = x*2;
+        const int x1 = std::min(x*2 + 1, w - 1);
+        double sum = (double)slice0[y0+x0] + slice0[y0+x1] + slice0[y1+x0] + slice0[y1+x1] +
+                             slice1[y0+x0] + slice1[y0+x1] + slice1[y1+x0] + slice1[y1+x1];
+        *dst++ = roundSample<T>(sum / 8);
+      }
+    }
+  }
+
+  // maps signed 16 bits samples to unsigned ones preserving their order
+  void shortToUnsignedShort(unsigned char* data, long long count)
+  {
+    u16* p = (u16*)data;
+    for(long long i=0; i<count; ++i)
+      p[i] = (u16)(p[i] ^ 0x8000);
+  }
+
+  // copies a region of a volume replicating the border samples outside of it, 'dst' has the size of the region
+  void copyRegion(const unsigned char* src, const ivec3& src_size, int bytes, const ivec3& origin, const ivec3& size, unsigned char* dst)
+  {
+    for(int z=0; z<size.z(); ++z)
+    {
+      const int sz = clamp(origin.z() + z, 0, src_size.z()-1);
+      for(int y=0; y<size.y(); ++y)
+      {
+        const int sy = clamp(origin.y() + y, 0, src_size.y()-1);
+        const unsigned char* row = src + ( (long long)sz * src_size.y() + sy ) * src_size.x() * bytes;
+        for(int x=0; x<size.x(); ++x, dst += bytes)
+          memcpy( dst, row + clamp(origin.x() + x, 0, src_size.x()-1) * bytes, bytes );
+      }
+    }
+  }
+
+  bool lessRecentlyUsed(const std::pair<unsigned, int>& a, const std::pair<unsigned, int>& b) { return a.first < b.first; }
+}
+//-----------------------------------------------------------------------------
+// VolumeBrickSource
+//-----------------------------------------------------------------------------
+ivec3 VolumeBrickSource::levelSize(int level) const
+{
+  const ivec3 size = volumeSize();
+  const int n = (1 << level) - 1;
+  return ivec3( (size.x() + n) >> level, (size.y() + n) >> level, (size.z() + n) >> level );
+}
+//-----------------------------------------------------------------------------
+ref<Image> VolumeBrickSource::downsampleRegion(int level, const ivec3& origin, const ivec3& size)
+{
+  VL_CHECK(level > 0)
+
+  // only the part of the region inside the volume is computed, the border samples are replicated afterwards
+  const ivec3 level_size = levelSize(level);
+  const ivec3 o0( clamp(origin.x(), 0, level_size.x()-1), clamp(origin.y(), 0, level_size.y()-1), clamp(origin.z(), 0, level_size.z()-1) );
+  const ivec3 o1( clamp(origin.x() + size.x() - 1, 0, level_size.x()-1), clamp(origin.y() + size.y() - 1, 0, level_size.y()-1), clamp(origin.z() + size.z() - 1, 0, level_size.z()-1) );
+  const ivec3 inner_size = o1 - o0 + ivec3(1,1,1);
+
+  ref<Image> finer = loadRegion(level - 1, o0 * 2, inner_size * 2);
+  if (!finer)
+    return NULL;
+
+  ref<Image> img = new Image(inner_size.x(), inner_size.y(), inner_size.z(), 1, IF_LUMINANCE, sampleType());
+  switch(sampleType())
+  {
+  case IT_UNSIGNED_BYTE:  downsample2( (const u8*)finer->pixels(),  (u8*)img->pixels(),  inner_size ); break;
+  case IT_UNSIGNED_SHORT: downsample2( (const u16*)finer->pixels(), (u16*)img->pixels(), inner_size ); break;
+  case IT_FLOAT:          downsample2( (const float*)finer->pixels(), (float*)img->pixels(), inner_size ); break;
+  default:
+    Log::error("VolumeBrickSource::downsampleRegion(): unsupported sample type.\n");
+    return NULL;
+  }
+
+  if ( o0 == origin && inner_size == size )
+    return img;
+
+  ref<Image> region = new Image(size.x(), size.y(), size.z(), 1, IF_LUMINANCE, sampleType());
+  copyRegion( img->pixels(), inner_size, sampleBytes(sampleType()), origin - o0, size, region->pixels() );
+  return region;
+}
+//-----------------------------------------------------------------------------
+// VolumeBrickImageSource
+//-----------------------------------------------------------------------------
+VolumeBrickImageSource::VolumeBrickImageSource(const Image* img)
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  if (img)
+    setImage(img);
+}
+//-----------------------------------------------------------------------------
+void VolumeBrickImageSource::setImage(const Image* img)
+{
+  mLevels.clear();
+  if (!img)
+    return;
+
+  if ( !img->isValid() || img->dimension() != ID_3D )
+  {
+    Log::error("VolumeBrickImageSource::setImage(): the image must be a valid 3D image.\n");
+    return;
+  }
+
+  ref<Image> lum;
+  if (img->format() != IF_LUMINANCE)
+  {
+    lum = img->convertFormat(IF_LUMINANCE);
+    if (!lum)
+      return;
+  }
+  const Image* src = lum ? lum.get() : img;
+
+  const EImageType type = src->type() == IT_SHORT ? IT_UNSIGNED_SHORT : src->type();
+  if ( type != IT_UNSIGNED_BYTE && type != IT_UNSIGNED_SHORT && type != IT_FLOAT )
+  {
+    Log::error("VolumeBrickImageSource::setImage(): only IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT, IT_SHORT and IT_FLOAT images are supported.\n");
+    return;
+  }
+
+  // tightly packed copy of the full resolution volume
+  const ivec3 size( src->width(), src->height(), src->depth() );
+  const int row_bytes = size.x() * sampleBytes(type);
+  ref<Image> level0 = new Image(size.x(), size.y(), size.z(), 1, IF_LUMINANCE, type);
+  for(int row=0; row<size.y() * size.z(); ++row)
+    memcpy( level0->pixels() + row * row_bytes, src->pixels() + row * src->pitch(), row_bytes );
+  if (src->type() == IT_SHORT)
+    shortToUnsignedShort( level0->pixels(), (long long)size.x() * size.y() * size.z() );
+  mLevels.push_back(level0);
+
+  // each level is computed from the previous one
+  for(int level=1; levelSize(level-1) != ivec3(1,1,1); ++level)
+  {
+    ref<Image> img_level = downsampleRegion( level, ivec3(0,0,0), levelSize(level) );
+    if (!img_level)
+      break;
+    mLevels.push_back(img_level);
+  }
+}
+//-----------------------------------------------------------------------------
+ivec3 VolumeBrickImageSource::volumeSize() const
+{
+  return mLevels.empty() ? ivec3(0,0,0) : ivec3( mLevels[0]->width(), mLevels[0]->height(), mLevels[0]->depth() );
+}
+//-----------------------------------------------------------------------------
+EImageType VolumeBrickImageSource::sampleType() const
+{
+  return mLevels.empty() ? IT_UNSIGNED_BYTE : mLevels[0]->type();
+}
+//-----------------------------------------------------------------------------
+ref<Image> VolumeBrickImageSource::loadRegion(int level, const ivec3& origin, const ivec3& size)
+{
+  const Image* img = levelImage(level);
+  if (!img)
+    return NULL;
+  ref<Image> region = new Image(size.x(), size.y(), size.z(), 1, IF_LUMINANCE, img->type());
+  copyRegion( img->pixels(), ivec3(img->width(), img->height(), img->depth()), sampleBytes(img->type()), origin, size, region->pixels() );
+  return region;
+}
+//-----------------------------------------------------------------------------
+// VolumeBrickRawSource
+//-----------------------------------------------------------------------------
+ref<VolumeBrickRawSource> VolumeBrickRawSource::openDAT(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+
+  String raw_path;
+  ivec3 size;
+  EImageFormat format;
+  EImageType type;
+  if ( !loadDATHeader(file.get(), raw_path, size, format, type) )
+    return NULL;
+  if ( format != IF_LUMINANCE )
+  {
+    Log::error( Say("VolumeBrickRawSource::openDAT('%s'): only LUMINANCE volumes are supported.\n") << path );
+    return NULL;
+  }
+
+  ref<VirtualFile> raw_file = defFileSystem()->locateFile(raw_path);
+  if ( !raw_file )
+  {
+    Log::error( Say("VolumeBrickRawSource::openDAT('%s'): could not find RAW file '%s'.\n") << path << raw_path );
+    return NULL;
+  }
+
+  ref<VolumeBrickRawSource> source = new VolumeBrickRawSource;
+  source->setVolumeSize(size);
+  source->setFileType(type);
+  source->setLevelFile(0, raw_file.get());
+  return source;
+}
+//-----------------------------------------------------------------------------
+ref<VolumeBrickRawSource> VolumeBrickRawSource::openMHD(const String& path)
+{
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+
+  String raw_path;
+  ivec3 size;
+  EImageFormat format;
+  EImageType type;
+  if ( !loadMHDHeader(file.get(), raw_path, size, format, type) )
+    return NULL;
+
+  ref<VirtualFile> raw_file = defFileSystem()->locateFile(raw_path);
+  if ( !raw_file )
+  {
+    Log::error( Say("VolumeBrickRawSource::openMHD('%s'): could not find RAW file '%s'.\n") << path << raw_path );
+    return NULL;
+  }
+
+  ref<VolumeBrickRawSource> source = new VolumeBrickRawSource;
+  source->setVolumeSize(size);
+  source->setFileType(type);
+  source->setLevelFile(0, raw_file.get());
+  return source;
+}
+//-----------------------------------------------------------------------------
+ref<VolumeBrickRawSource> VolumeBrickRawSource::openTIFF(const String& path, const String& raw_path)
+{
+#if defined(VL_IO_2D_TIFF)
+  ref<VirtualFile> file = defFileSystem()->locateFile(path);
+  if ( !file )
+  {
+    Log::error( Say("File '%s' not found.\n") << path );
+    return NULL;
+  }
+
+  TIFFReader reader;
+  if ( !reader.open(file.get()) )
+    return NULL;
+  if ( reader.format() != IF_LUMINANCE )
+  {
+    Log::error( Say("VolumeBrickRawSource::openTIFF('%s'): only single sample 8 or 16 bits unsigned or float pages are supported.\n") << path );
+    return NULL;
+  }
+
+  const ivec3 size( reader.width(), reader.height(), reader.pageCount() );
+  const EImageType type = reader.type();
+  const int row_bytes = size.x() * sampleBytes(type);
+  ref<DiskFile> raw_file = new DiskFile(raw_path);
+  if ( !raw_file->exists() || raw_file->size() != (long long)row_bytes * size.y() * size.z() )
+  {
+    Log::debug( Say("VolumeBrickRawSource: converting '%s' into '%s'.\n") << path << raw_path );
+    if ( !raw_file->open(OM_WriteOnly) )
+    {
+      Log::error( Say("VolumeBrickRawSource::openTIFF(): could not open '%s' for writing.\n") << raw_path );
+      return NULL;
+    }
+
+    std::vector<unsigned char> band;
+    bool ok = true;
+    for(int z=0; ok && z<size.z(); ++z)
+    {
+      ok = reader.setPage(z) && reader.width() == size.x() && reader.height() == size.y() && reader.format() == IF_LUMINANCE && reader.type() == type;
+      // bands aligned to the strips or tiles, which are counted from the top of the page, so that each one is decoded once
+      band.resize( (size_t)row_bytes * reader.blockHeight() );
+      for(int y=0; ok && y<size.y(); )
+      {
+        const int rows_above = size.y() - y;
+        const int band_rows  = rows_above - (rows_above - 1) / reader.blockHeight() * reader.blockHeight();
+        ok = reader.readRegion(0, y, size.x(), band_rows, &band[0], row_bytes) &&
+             raw_file->write(&band[0], (long long)row_bytes * band_rows) == (long long)row_bytes * band_rows;
+        y += band_rows;
+      }
+    }
+    raw_file->close();
+    if (!ok)
+    {
+      Log::error( Say("VolumeBrickRawSource::openTIFF(): error while converting '%s' into '%s'.\n") << path << raw_path );
+      return NULL;
+    }
+  }
+
+  ref<VolumeBrickRawSource> source = new VolumeBrickRawSource;
+  source->setVolumeSize(size);
+  source->setFileType(type);
+  source->setLevelFile(0, raw_file.get());
+  return source;
+#else
+  Log::error( Say("VolumeBrickRawSource::openTIFF('%s'): VL has been compiled without the TIFF plugin.\n") << path );
+  return NULL;
+#endif
+}
+//-----------------------------------------------------------------------------
+void VolumeBrickRawSource::setLevelFile(int level, VirtualFile* file, long long offset)
+{
+  VL_CHECK(level >= 0)
+  if ( level >= (int)mLevelFiles.size() )
+  {
+    mLevelFiles.resize(level + 1);
+    mLevelOffsets.resize(level + 1, 0);
+  }
+  mLevelFiles[level] = file;
+  mLevelOffsets[level] = offset;
+}
+//-----------------------------------------------------------------------------
+ref<Image> VolumeBrickRawSource::loadRegion(int level, const ivec3& origin, const ivec3& size)
+{
+  VirtualFile* file = levelFile(level);
+  if (!file)
+  {
+    if (level > 0)
+      return downsampleRegion(level, origin, size);
+    Log::error("VolumeBrickRawSource::loadRegion(): no full resolution file.\n");
+    return NULL;
+  }
+
+  const int bytes = sampleBytes(mFileType);
+  if (!bytes)
+  {
+    Log::error("VolumeBrickRawSource::loadRegion(): unsupported file type.\n");
+    return NULL;
+  }
+
+  const ivec3 level_size = levelSize(level);
+  ref<Image> img = new Image(size.x(), size.y(), size.z(), 1, IF_LUMINANCE, sampleType());
+
+  // the rows of the region inside the volume are read once, skipping the rows replicated from the border
+  const int x0 = clamp(origin.x(), 0, level_size.x()-1);
+  const int x1 = clamp(origin.x() + size.x() - 1, 0, level_size.x()-1);
+  const int row_count = x1 - x0 + 1;
+  std::vector<unsigned char> row_buf( row_count * bytes );
+  unsigned char* dst = img->pixels();
+  int prev_sy = -1, prev_sz = -1;
+
+  ScopedMutex lock(mFileMutex);
+  if ( !file->isOpen() && !file->open(OM_ReadOnly) )
+  {
+    Log::error( Say("VolumeBrickRawSource::loadRegion(): could not open '%s'.\n") << file->path() );
+    return NULL;
+  }
+
+  for(int z=0; z<size.z(); ++z)
+  {
+    const int sz = clamp(origin.z() + z, 0, level_size.z()-1);
+    for(int y=0; y<size.y(); ++y, dst += size.x() * bytes)
+    {
+      const int sy = clamp(origin.y() + y, 0, level_size.y()-1);
+      if ( sy != prev_sy || sz != prev_sz )
+      {
+        const long long offset = mLevelOffsets[level] + ( ( (long long)sz * level_size.y() + sy ) * level_size.x() + x0 ) * bytes;
+        if ( !file->seekSet(offset) || file->read( &row_buf[0], row_buf.size() ) != (long long)row_buf.size() )
+        {
+          Log::error( Say("VolumeBrickRawSource::loadRegion(): error reading '%s'.\n") << file->path() );
+          return NULL;
+        }
+        if (mFileType == IT_SHORT)
+          shortToUnsignedShort( &row_buf[0], row_count );
+        prev_sy = sy;
+        prev_sz = sz;
+      }
+      for(int x=0; x<size.x(); ++x)
+        memcpy( dst + x * bytes, &row_buf[ ( clamp(origin.x() + x, 0, level_size.x()-1) - x0 ) * bytes ], bytes );
+    }
+  }
+
+  return img;
+}
+//-----------------------------------------------------------------------------
+bool VolumeBrickRawSource::writeHalfResolution(VirtualFile* in, long long in_offset, const ivec3& size, EImageType type, VirtualFile* out)
+{
+  const int bytes = sampleBytes(type);
+  if (!bytes)
+  {
+    Log::error("VolumeBrickRawSource::writeHalfResolution(): unsupported sample type.\n");
+    return false;
+  }
+
+  if ( !in->isOpen() && !in->open(OM_ReadOnly) )
+  {
+    Log::error( Say("VolumeBrickRawSource::writeHalfResolution(): could not open '%s'.\n") << in->path() );
+    return false;
+  }
+
+  if ( !out->open(OM_WriteOnly) )
+  {
+    Log::error( Say("VolumeBrickRawSource::writeHalfResolution(): could not open '%s' for writing.\n") << out->path() );
+    return false;
+  }
+
+  const long long slice_bytes = (long long)size.x() * size.y() * bytes;
+  const long long out_slice_bytes = (long long)( (size.x() + 1) / 2 ) * ( (size.y() + 1) / 2 ) * bytes;
+  std::vector<unsigned char> slice0( (size_t)slice_bytes );
+  std::vector<unsigned char> slice1( (size_t)slice_bytes );
+  std::vector<unsigned char> out_slice( (size_t)out_slice_bytes );
+
+  bool ok = true;
+  for(int z=0; z<(size.z() + 1) / 2 && ok; ++z)
+  {
+    const int z0 = z * 2;
+    const int z1 = std::min(z * 2 + 1, size.z() - 1);
+    ok &= in->seekSet( in_offset + z0 * slice_bytes ) && in->read( &slice0[0], slice_bytes ) == slice_bytes;
+    ok &= in->seekSet( in_offset + z1 * slice_bytes ) && in->read( &slice1[0], slice_bytes ) == slice_bytes;
+    if (!ok)
+      break;
+
+    switch(type)
+    {
+    case IT_UNSIGNED_BYTE:  downsampleSlices( (const u8*)&slice0[0],    (const u8*)&slice1[0],    size.x(), size.y(), (u8*)&out_slice[0] ); break;
+    case IT_UNSIGNED_SHORT: downsampleSlices( (const u16*)&slice0[0],   (const u16*)&slice1[0],   size.x(), size.y(), (u16*)&out_slice[0] ); break;
+    case IT_SHORT:          downsampleSlices( (const i16*)&slice0[0],   (const i16*)&slice1[0],   size.x(), size.y(), (i16*)&out_slice[0] ); break;
+    case IT_FLOAT:          downsampleSlices( (const float*)&slice0[0], (const float*)&slice1[0], size.x(), size.y(), (float*)&out_slice[0] ); break;
+    default: break;
+    }
+
+    ok &= out->write( &out_slice[0], out_slice_bytes ) == out_slice_bytes;
+  }
+
+  out->close();
+  if (!ok)
+    Log::error( Say("VolumeBrickRawSource::writeHalfResolution(): error while downsampling '%s' into '%s'.\n") << in->path() << out->path() );
+  return ok;
+}
+//-----------------------------------------------------------------------------
+bool VolumeBrickRawSource::generateLevelFiles(const String& path_pattern, int level_count)
+{
+  if ( !levelFile(0) )
+  {
+    Log::error("VolumeBrickRawSource::generateLevelFiles(): no full resolution file.\n");
+    return false;
+  }
+
+  for(int level=1; level<level_count; ++level)
+  {
+    String path = path_pattern;
+    path.replace( "{level}", String::fromInt(level) );
+
+    const ivec3 size = levelSize(level);
+    const long long file_size = (long long)size.x() * size.y() * size.z() * sampleBytes(mFileType);
+    ref<DiskFile> file = new DiskFile(path);
+    if ( !file->exists() || file->size() != file_size )
+    {
+      Log::debug( Say("VolumeBrickRawSource: generating level %n '%s'.\n") << level << path );
+      if ( !writeHalfResolution( levelFile(level-1), mLevelOffsets[level-1], levelSize(level-1), mFileType, file.get() ) )
+        return false;
+    }
+    setLevelFile(level, file.get());
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+// BrickedVolume
+//-----------------------------------------------------------------------------
+BrickedVolume::BrickedVolume()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mBrickSize = 32;
+  mLoadMutex = NULL;
+  mCacheSlots = ivec3(8,8,8);
+  mSampleType = IT_UNSIGNED_BYTE;
+  mMaxPixelError = 2.0f;
+  mLevelCount = 0;
+  mMaxLoadsPerFrame = 4;
+  mMaxUploadsPerFrame = 16;
+  mFrame = 0;
+  mStatsCachedBricks = 0;
+  mStatsPendingBricks = 0;
+  mPageTableDirty = false;
+}
+//-----------------------------------------------------------------------------
+bool BrickedVolume::init()
+{
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.clear();
+    mLoadedBricks.clear();
+  }
+  mBricks.clear();
+  mSelected.clear();
+  mSlots.clear();
+  mPageTable.clear();
+  mAtlasTexture = NULL;
+  mPageTableTexture = NULL;
+  mLevelCount = 0;
+  mStatsCachedBricks = 0;
+  mStatsPendingBricks = 0;
+
+  if ( !brickSource() )
+  {
+    Log::error("BrickedVolume::init(): no brick source installed.\n");
+    return false;
+  }
+
+  mVolumeSize = brickSource()->volumeSize();
+  mSampleType = brickSource()->sampleType();
+  if ( mVolumeSize.x() < 1 || mVolumeSize.y() < 1 || mVolumeSize.z() < 1 || brickSize() < 1 )
+  {
+    Log::error("BrickedVolume::init(): invalid volume or brick size.\n");
+    return false;
+  }
+
+  ETextureFormat atlas_format;
+  switch(mSampleType)
+  {
+  case IT_UNSIGNED_BYTE:  atlas_format = TF_R8; break;
+  case IT_UNSIGNED_SHORT: atlas_format = TF_R16; break;
+  case IT_FLOAT:          atlas_format = TF_R32F; break;
+  default:
+    Log::error("BrickedVolume::init(): unsupported sample type.\n");
+    return false;
+  }
+
+  // the coarsest level fits in a single brick
+  const int bs = brickSize();
+  for( mLevelCount = 1; ; ++mLevelCount )
+  {
+    const ivec3 size = brickSource()->levelSize(mLevelCount - 1);
+    if ( size.x() <= bs && size.y() <= bs && size.z() <= bs )
+      break;
+  }
+
+  mPageCount = ivec3( (mVolumeSize.x() + bs - 1) / bs, (mVolumeSize.y() + bs - 1) / bs, (mVolumeSize.z() + bs - 1) / bs );
+  const ivec3 atlas_size = mCacheSlots * (bs + 2);
+
+  int max_size = 0;
+  glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &max_size); VL_CHECK_OGL();
+  if ( mCacheSlots.x() < 1 || mCacheSlots.y() < 1 || mCacheSlots.z() < 1 || mCacheSlots.x() > 256 || mCacheSlots.y() > 256 || mCacheSlots.z() > 256 ||
+       atlas_size.x() > max_size || atlas_size.y() > max_size || atlas_size.z() > max_size )
+  {
+    Log::error( Say("BrickedVolume::init(): invalid cache slots %n x %n x %n, the atlas texture would be %n x %n x %n (max %n).\n")
+      << mCacheSlots.x() << mCacheSlots.y() << mCacheSlots.z() << atlas_size.x() << atlas_size.y() << atlas_size.z() << max_size );
+    return false;
+  }
+  if ( mPageCount.x() > max_size || mPageCount.y() > max_size || mPageCount.z() > max_size )
+  {
+    Log::error("BrickedVolume::init(): too many bricks, increase the brick size.\n");
+    return false;
+  }
+
+  mAtlasTexture = new Texture;
+  if ( !mAtlasTexture->createTexture( TD_TEXTURE_3D, atlas_format, atlas_size.x(), atlas_size.y(), atlas_size.z(), false, NULL, 0, false ) )
+  {
+    mAtlasTexture = NULL;
+    return false;
+  }
+  mAtlasTexture->getTexParameter()->setMagFilter(TPF_LINEAR);
+  mAtlasTexture->getTexParameter()->setMinFilter(TPF_LINEAR);
+  mAtlasTexture->getTexParameter()->setWrap(TPW_CLAMP_TO_EDGE);
+
+  mPageTableTexture = new Texture;
+  if ( !mPageTableTexture->createTexture( TD_TEXTURE_3D, TF_RGBA8, mPageCount.x(), mPageCount.y(), mPageCount.z(), false, NULL, 0, false ) )
+  {
+    mAtlasTexture = NULL;
+    mPageTableTexture = NULL;
+    return false;
+  }
+  mPageTableTexture->getTexParameter()->setMagFilter(TPF_NEAREST);
+  mPageTableTexture->getTexParameter()->setMinFilter(TPF_NEAREST);
+  mPageTableTexture->getTexParameter()->setWrap(TPW_CLAMP_TO_EDGE);
+
+  mSlots.resize( mCacheSlots.x() * mCacheSlots.y() * mCacheSlots.z(), NULL );
+  mPageTable.resize( mPageCount.x() * mPageCount.y() * mPageCount.z() * 4, 0 );
+  mPageTableDirty = true;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::updateUniforms( Actor* actor, real clock, const Camera* camera, Renderable* rend, const Shader* shader )
+{
+  if ( mAtlasTexture && mPageTableTexture && brickSource() )
+  {
+    ++mFrame;
+
+    // synchronous loading
+    if (!mLoadMutex)
+      processLoadRequests( maxLoadsPerFrame() );
+
+    // the camera position in object space
+    vec3 eye = camera->modelingMatrix().getT();
+    if ( actor->transform() )
+      eye = actor->transform()->worldMatrix().getInverse() * eye;
+
+    // converts a length at unit distance to pixels
+    real proj_factor = camera->projectionMatrix().e(1,1) * camera->viewport()->height() * (real)0.5;
+
+    std::vector<Brick*> prev_selected;
+    prev_selected.swap(mSelected);
+    selectBrick( mLevelCount - 1, ivec3(0,0,0), eye, proj_factor, actor, camera );
+    mPageTableDirty |= prev_selected != mSelected;
+
+    cancelUnusedRequests();
+    uploadLoadedBricks();
+    updatePageTable();
+  }
+
+  RaycastVolume::updateUniforms( actor, clock, camera, rend, shader );
+
+  const GLSLProgram* glsl = shader->getGLSLProgram();
+  if ( glsl->getUniformLocation( "volume_size" ) != -1 )
+    actor->gocUniform( "volume_size" )->setUniform( fvec3( (float)mVolumeSize.x(), (float)mVolumeSize.y(), (float)mVolumeSize.z() ) );
+}
+//-----------------------------------------------------------------------------
+bool BrickedVolume::brickExists(int level, const ivec3& pos) const
+{
+  const ivec3 size = mBrickSource->levelSize(level);
+  const int bs = brickSize();
+  return pos.x() * bs < size.x() && pos.y() * bs < size.y() && pos.z() * bs < size.z();
+}
+//-----------------------------------------------------------------------------
+AABB BrickedVolume::brickBounds(int level, const ivec3& pos) const
+{
+  // full resolution samples covered by the brick
+  const int span = brickSize() << level;
+  vec3 s0( (real)(pos.x() * span), (real)(pos.y() * span), (real)(pos.z() * span) );
+  vec3 s1( (real)std::min((pos.x() + 1) * span, mVolumeSize.x()), (real)std::min((pos.y() + 1) * span, mVolumeSize.y()), (real)std::min((pos.z() + 1) * span, mVolumeSize.z()) );
+  const vec3 scale = ( box().maxCorner() - box().minCorner() ) / vec3( (real)mVolumeSize.x(), (real)mVolumeSize.y(), (real)mVolumeSize.z() );
+
+  AABB aabb;
+  aabb.setMinCorner( box().minCorner() + s0 * scale );
+  aabb.setMaxCorner( box().minCorner() + s1 * scale );
+  return aabb;
+}
+//-----------------------------------------------------------------------------
+BrickedVolume::Brick* BrickedVolume::acquireBrick(int level, const ivec3& pos)
+{
+  ref<Brick>& brick = mBricks[ BrickKey(level, pos) ];
+  if (!brick)
+  {
+    brick = new Brick(level, pos);
+    ScopedMutex lock(mLoadMutex);
+    mLoadQueue.push_back( brick.get() );
+  }
+  brick->mLastUsedFrame = mFrame;
+  return brick.get();
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::selectBrick(int level, const ivec3& pos, const vec3& eye, real proj_factor, const Actor* actor, const Camera* camera)
+{
+  Brick* brick = acquireBrick(level, pos);
+  if ( brick->mState != BS_Ready )
+    return;
+
+  AABB aabb = brickBounds(level, pos);
+
+  // bricks outside the view are kept at their level
+  bool visible = true;
+  if ( actor->transform() )
+    visible = !camera->frustum().cull( aabb.transformed( actor->transform()->worldMatrix() ) );
+  else
+    visible = !camera->frustum().cull( aabb );
+
+  if ( level > 0 && visible )
+  {
+    // screen-space size of the sample spacing of the brick
+    const vec3 nearest = aabb.clip(eye);
+    const real distance = std::max( (nearest - eye).length(), (real)1e-6 );
+    const vec3 extent = box().maxCorner() - box().minCorner();
+    const real spacing = std::max( extent.x() / mVolumeSize.x(), std::max( extent.y() / mVolumeSize.y(), extent.z() / mVolumeSize.z() ) ) * (1 << level);
+    const real pixel_error = spacing * proj_factor / distance;
+
+    if ( pixel_error > maxPixelError() )
+    {
+      // refine only if all the children are available, otherwise keep requesting them
+      bool children_ready = true;
+      for(int i=0; i<8; ++i)
+      {
+        const ivec3 child = pos * 2 + ivec3( i & 1, (i >> 1) & 1, i >> 2 );
+        if ( brickExists(level-1, child) )
+          children_ready &= acquireBrick(level-1, child)->mState == BS_Ready;
+      }
+      if (children_ready)
+      {
+        for(int i=0; i<8; ++i)
+        {
+          const ivec3 child = pos * 2 + ivec3( i & 1, (i >> 1) & 1, i >> 2 );
+          if ( brickExists(level-1, child) )
+            selectBrick( level-1, child, eye, proj_factor, actor, camera );
+        }
+        return;
+      }
+    }
+  }
+
+  mSelected.push_back(brick);
+}
+//-----------------------------------------------------------------------------
+bool BrickedVolume::hasLoadRequests() const
+{
+  ScopedMutex lock(mLoadMutex);
+  return !mLoadQueue.empty();
+}
+//-----------------------------------------------------------------------------
+int BrickedVolume::processLoadRequests(int max_count)
+{
+  const int bs = brickSize();
+  int count = 0;
+  for( ; count<max_count; ++count)
+  {
+    Brick* brick = NULL;
+    {
+      ScopedMutex lock(mLoadMutex);
+      if (mLoadQueue.empty())
+        break;
+      brick = mLoadQueue.front();
+      mLoadQueue.pop_front();
+      brick->mState = BS_Loading;
+    }
+
+    // no lock needed: the rendering thread does not touch the bricks being loaded.
+    // The brick is loaded with a one sample apron so that the atlas can be sampled with linear filtering.
+    ref<Image> img = brickSource()->loadRegion( brick->mLevel, brick->mPos * bs - ivec3(1,1,1), ivec3(bs+2, bs+2, bs+2) );
+    if ( img && ( img->width() != bs+2 || img->height() != bs+2 || img->depth() != bs+2 || img->format() != IF_LUMINANCE || img->type() != mSampleType ) )
+    {
+      Log::error( Say("BrickedVolume: brick %n (%n, %n, %n) has an invalid size, format or type.\n") << brick->mLevel << brick->mPos.x() << brick->mPos.y() << brick->mPos.z() );
+      img = NULL;
+    }
+    else
+    if ( !img )
+      Log::warning( Say("BrickedVolume: brick %n (%n, %n, %n) not available.\n") << brick->mLevel << brick->mPos.x() << brick->mPos.y() << brick->mPos.z() );
+
+    {
+      ScopedMutex lock(mLoadMutex);
+      brick->mImage = img;
+      brick->mState = img ? BS_Loaded : BS_Failed;
+      if (img)
+        mLoadedBricks.push_back(brick);
+    }
+  }
+  return count;
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::cancelUnusedRequests()
+{
+  std::vector<Brick*> cancelled;
+  {
+    ScopedMutex lock(mLoadMutex);
+    std::deque<Brick*> queue;
+    for(size_t i=0; i<mLoadQueue.size(); ++i)
+    {
+      if ( mLoadQueue[i]->mLastUsedFrame == mFrame )
+        queue.push_back( mLoadQueue[i] );
+      else
+        cancelled.push_back( mLoadQueue[i] );
+    }
+    // coarser bricks first, they are needed to display the finer ones
+    for(int level=mLevelCount-1, k=0; k<(int)queue.size(); --level)
+    {
+      for(size_t i=0; i<queue.size(); ++i)
+      {
+        if ( queue[i]->mLevel == level )
+          mLoadQueue[k++] = queue[i];
+      }
+    }
+    mLoadQueue.resize( queue.size() );
+    mStatsPendingBricks = (int)mLoadQueue.size();
+  }
+
+  for(size_t i=0; i<cancelled.size(); ++i)
+    mBricks.erase( BrickKey(cancelled[i]->mLevel, cancelled[i]->mPos) );
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::uploadLoadedBricks()
+{
+  std::vector<Brick*> bricks;
+  {
+    ScopedMutex lock(mLoadMutex);
+    const int count = std::min( (int)mLoadedBricks.size(), maxUploadsPerFrame() );
+    bricks.assign( mLoadedBricks.begin(), mLoadedBricks.begin() + count );
+    mLoadedBricks.erase( mLoadedBricks.begin(), mLoadedBricks.begin() + count );
+  }
+
+  // free slots first, then the least recently used bricks not used by this frame
+  std::vector< std::pair<unsigned, int> > candidates;
+  for(int i=0; i<(int)mSlots.size(); ++i)
+  {
+    if ( !mSlots[i] )
+      candidates.push_back( std::make_pair(0u, i) );
+    else
+    if ( mSlots[i]->mLastUsedFrame != mFrame )
+      candidates.push_back( std::make_pair(mSlots[i]->mLastUsedFrame + 1, i) );
+  }
+  std::sort( candidates.begin(), candidates.end(), lessRecentlyUsed );
+
+  const int bs = brickSize();
+  const int slot_side = bs + 2;
+  size_t next_candidate = 0;
+  std::vector<Brick*> postponed;
+  for(size_t i=0; i<bricks.size(); ++i)
+  {
+    Brick* brick = bricks[i];
+
+    // loaded too late
+    if ( brick->mLastUsedFrame != mFrame )
+    {
+      mBricks.erase( BrickKey(brick->mLevel, brick->mPos) );
+      continue;
+    }
+
+    // no slot available: retry at the next frame
+    if ( next_candidate == candidates.size() )
+    {
+      postponed.push_back(brick);
+      continue;
+    }
+
+    const int slot = candidates[next_candidate++].second;
+    if ( mSlots[slot] )
+    {
+      Brick* evicted = mSlots[slot];
+      mBricks.erase( BrickKey(evicted->mLevel, evicted->mPos) );
+    }
+
+    const ivec3 slot_pos( slot % mCacheSlots.x(), (slot / mCacheSlots.x()) % mCacheSlots.y(), slot / (mCacheSlots.x() * mCacheSlots.y()) );
+    const GLenum gl_type = mSampleType == IT_UNSIGNED_BYTE ? GL_UNSIGNED_BYTE : mSampleType == IT_UNSIGNED_SHORT ? GL_UNSIGNED_SHORT : GL_FLOAT;
+    uploadTexture( mAtlasTexture.get(), slot_pos * slot_side, ivec3(slot_side, slot_side, slot_side), GL_RED, gl_type, brick->mImage->pixels() );
+
+    brick->mImage = NULL;
+    brick->mSlot = slot;
+    brick->mState = BS_Ready;
+    mSlots[slot] = brick;
+    mPageTableDirty = true;
+  }
+
+  if ( !postponed.empty() )
+  {
+    ScopedMutex lock(mLoadMutex);
+    mLoadedBricks.insert( mLoadedBricks.begin(), postponed.begin(), postponed.end() );
+  }
+
+  mStatsCachedBricks = 0;
+  for(size_t i=0; i<mSlots.size(); ++i)
+    mStatsCachedBricks += mSlots[i] ? 1 : 0;
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::updatePageTable()
+{
+  if ( !mPageTableDirty )
+    return;
+  mPageTableDirty = false;
+
+  std::fill( mPageTable.begin(), mPageTable.end(), (unsigned char)0 );
+
+  // each full resolution brick points to the selected brick covering it
+  for(size_t i=0; i<mSelected.size(); ++i)
+  {
+    const Brick* brick = mSelected[i];
+    const int slot = brick->mSlot;
+    const unsigned char entry[] = {
+      (unsigned char)( slot % mCacheSlots.x() ),
+      (unsigned char)( (slot / mCacheSlots.x()) % mCacheSlots.y() ),
+      (unsigned char)( slot / (mCacheSlots.x() * mCacheSlots.y()) ),
+      (unsigned char)( brick->mLevel + 1 )
+    };
+    const int span = 1 << brick->mLevel;
+    const ivec3 p0 = brick->mPos * span;
+    const ivec3 p1( std::min(p0.x() + span, mPageCount.x()), std::min(p0.y() + span, mPageCount.y()), std::min(p0.z() + span, mPageCount.z()) );
+    for(int z=p0.z(); z<p1.z(); ++z)
+      for(int y=p0.y(); y<p1.y(); ++y)
+        for(int x=p0.x(); x<p1.x(); ++x)
+          memcpy( &mPageTable[ ( (z * mPageCount.y() + y) * mPageCount.x() + x ) * 4 ], entry, 4 );
+  }
+
+  uploadTexture( mPageTableTexture.get(), ivec3(0,0,0), mPageCount, GL_RGBA, GL_UNSIGNED_BYTE, &mPageTable[0] );
+}
+//-----------------------------------------------------------------------------
+void BrickedVolume::uploadTexture(Texture* tex, const ivec3& offset, const ivec3& size, int gl_format, int gl_type, const void* pixels)
+{
+  // called while rendering: the texture bound to the active unit and the unpack alignment are restored
+  GLint prev_tex = 0, prev_align = 4;
+  glGetIntegerv(GL_TEXTURE_BINDING_3D, &prev_tex); VL_CHECK_OGL();
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &prev_align); VL_CHECK_OGL();
+
+  glBindTexture(GL_TEXTURE_3D, tex->handle()); VL_CHECK_OGL();
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); VL_CHECK_OGL();
+  VL_glTexSubImage3D(GL_TEXTURE_3D, 0, offset.x(), offset.y(), offset.z(), size.x(), size.y(), size.z(), gl_format, gl_type, pixels); VL_CHECK_OGL();
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, prev_align); VL_CHECK_OGL();
+  glBindTexture(GL_TEXTURE_3D, prev_tex); VL_CHECK_OGL();
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,349 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef BrickedVolume_INCLUDE_ONCE
+#define BrickedVolume_INCLUDE_ONCE
+
+#include <vlVolume/RaycastVolume.hpp>
+#include <vlGraphics/Texture.hpp>
+#include <vlCore/VirtualFile.hpp>
+#include <vlCore/IMutex.hpp>
+#include <map>
+#include <deque>
+
+namespace vl
+{
+  //-----------------------------------------------------------------------------
+  // VolumeBrickSource
+  //-----------------------------------------------------------------------------
+  /**
+   * Provides the samples of a BrickedVolume at multiple resolutions.
+   *
+   * Level 0 is the full resolution volume, each level halves the resolution of the previous one: the sample i of level L
+   * is the average of the samples 2i and 2i+1 of level L-1 and covers the full resolution samples [i*2^L, (i+1)*2^L).
+   *
+   * \note When BrickedVolume::processLoadRequests() is called from a worker thread loadRegion() is called from that thread.
+   */
+  class VLVOLUME_EXPORT VolumeBrickSource: public Object
+  {
+    VL_INSTRUMENT_ABSTRACT_CLASS(vl::VolumeBrickSource, Object)
+
+  public:
+    //! The size in samples of the full resolution volume.
+    virtual ivec3 volumeSize() const = 0;
+
+    //! The type of the samples returned by loadRegion(): IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT or IT_FLOAT.
+    virtual EImageType sampleType() const = 0;
+
+    /** Returns an IF_LUMINANCE image of \p size samples of sampleType() containing the samples of \p level starting at \p origin,
+      * the samples outside the volume replicating the nearest border sample. Returns NULL on failure. */
+    virtual ref<Image> loadRegion(int level, const ivec3& origin, const ivec3& size) = 0;
+
+    //! The size in samples of the given level.
+    ivec3 levelSize(int level) const;
+
+  protected:
+    //! Computes a region of \p level averaging 2x2x2 samples of a region of \p level - 1, which is loaded with loadRegion().
+    ref<Image> downsampleRegion(int level, const ivec3& origin, const ivec3& size);
+  };
+
+  //-----------------------------------------------------------------------------
+  // VolumeBrickImageSource
+  //-----------------------------------------------------------------------------
+  /**
+   * A VolumeBrickSource returning the samples of a volume Image held in memory, for example loaded with loadMHD(), loadDAT() or assembled
+   * from DICOM slices with assemble3DImage(). Useful when the volume fits in the system memory but not in the GPU memory.
+   *
+   * The image is converted to IF_LUMINANCE, IT_SHORT samples are mapped to IT_UNSIGNED_SHORT adding 32768.
+   * All the lower resolution levels are computed by setImage(), which requires about 1/7 of the memory of the image.
+   */
+  class VLVOLUME_EXPORT VolumeBrickImageSource: public VolumeBrickSource
+  {
+    VL_INSTRUMENT_CLASS(vl::VolumeBrickImageSource, VolumeBrickSource)
+
+  public:
+    VolumeBrickImageSource(const Image* img=NULL);
+
+    //! Sets the volume and computes its lower resolution levels.
+    void setImage(const Image* img);
+
+    //! The image of the given level, level 0 being the full resolution volume.
+    const Image* levelImage(int level) const { return level >= 0 && level < (int)mLevels.size() ? mLevels[level].get() : NULL; }
+
+    virtual ivec3 volumeSize() const;
+
+    virtual EImageType sampleType() const;
+
+    virtual ref<Image> loadRegion(int level, const ivec3& origin, const ivec3& size);
+
+  protected:
+    std::vector< ref<Image> > mLevels;
+  };
+
+  //-----------------------------------------------------------------------------
+  // VolumeBrickRawSource
+  //-----------------------------------------------------------------------------
+  /**
+   * A VolumeBrickSource reading the samples on demand from raw files, so that the volume does not need to fit in the system memory.
+   *
+   * Each level can have its own raw file set with setLevelFile(), usually generated once with generateLevelFiles().
+   * A level without a file is computed from the nearest finer level, which for the coarser levels of a large volume means reading
+   * a large portion of the full resolution file for every brick.
+   *
+   * The raw files contain IF_LUMINANCE samples of fileType(), x varying fastest, with no padding. IT_SHORT samples are mapped to
+   * IT_UNSIGNED_SHORT adding 32768.
+   * \note If loadRegion() is called from more than one thread at a time a fileMutex() must be installed.
+   */
+  class VLVOLUME_EXPORT VolumeBrickRawSource: public VolumeBrickSource
+  {
+    VL_INSTRUMENT_CLASS(vl::VolumeBrickRawSource, VolumeBrickSource)
+
+  public:
+    VolumeBrickRawSource(): mFileType(IT_UNSIGNED_BYTE), mFileMutex(NULL)
+    {
+      VL_DEBUG_SET_OBJECT_NAME()
+    }
+
+    //! Creates a VolumeBrickRawSource reading the raw file described by the given DAT file, see loadDAT().
+    static ref<VolumeBrickRawSource> openDAT(const String& path);
+
+    //! Creates a VolumeBrickRawSource reading the raw file described by the given MHD file, see loadMHD().
+    static ref<VolumeBrickRawSource> openMHD(const String& path);
+
+    /** Converts the pages of a multi-page grayscale TIFF file into the raw file \p raw_path and creates a VolumeBrickRawSource reading it.
+      * The pages are read with a TIFFReader one band of strips or tiles at a time, so that neither the pages nor the volume need to fit
+      * in memory. An existing raw file of the right size is reused. Returns NULL if VL has been compiled without the TIFF plugin. */
+    static ref<VolumeBrickRawSource> openTIFF(const String& path, const String& raw_path);
+
+    /** Writes to \p out a raw file with half the resolution of \p in, reading two slices at a time.
+      * \param in The raw file to be downsampled, its samples start at \p in_offset.
+      * \param size The size in samples of \p in.
+      * \param type The type of the samples of both files: IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT, IT_SHORT or IT_FLOAT. */
+    static bool writeHalfResolution(VirtualFile* in, long long in_offset, const ivec3& size, EImageType type, VirtualFile* out);
+
+    /** Generates with writeHalfResolution() the missing raw files of the levels from 1 to \p level_count - 1 and installs them with setLevelFile().
+      * The paths of the files are generated replacing the string \p "{level}" of \p path_pattern, for example \p "/data/stack_{level}.raw".
+      * The files are written on disk, existing files of the right size are reused. */
+    bool generateLevelFiles(const String& path_pattern, int level_count);
+
+    //! The size in samples of the full resolution volume.
+    void setVolumeSize(const ivec3& size) { mVolumeSize = size; }
+    virtual ivec3 volumeSize() const { return mVolumeSize; }
+
+    //! The type of the samples stored in the raw files: IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT, IT_SHORT or IT_FLOAT.
+    void setFileType(EImageType type) { mFileType = type; }
+    //! The type of the samples stored in the raw files: IT_UNSIGNED_BYTE, IT_UNSIGNED_SHORT, IT_SHORT or IT_FLOAT.
+    EImageType fileType() const { return mFileType; }
+
+    virtual EImageType sampleType() const { return mFileType == IT_SHORT ? IT_UNSIGNED_SHORT : mFileType; }
+
+    //! The raw file containing the samples of \p level starting at \p offset bytes, NULL to compute the level from the finer ones.
+    void setLevelFile(int level, VirtualFile* file, long long offset=0);
+    //! The raw file containing the samples of \p level.
+    VirtualFile* levelFile(int level) { return level >= 0 && level < (int)mLevelFiles.size() ? mLevelFiles[level].get() : NULL; }
+
+    //! The mutex serializing the accesses to the raw files, required when calling loadRegion() from more than one thread.
+    void setFileMutex(IMutex* mutex) { mFileMutex = mutex; }
+    //! The mutex serializing the accesses to the raw files, required when calling loadRegion() from more than one thread.
+    IMutex* fileMutex() { return mFileMutex; }
+
+    virtual ref<Image> loadRegion(int level, const ivec3& origin, const ivec3& size);
+
+  protected:
+    std::vector< ref<VirtualFile> > mLevelFiles;
+    std::vector<long long> mLevelOffsets;
+    ivec3 mVolumeSize;
+    EImageType mFileType;
+    IMutex* mFileMutex;
+  };
+
+  //-----------------------------------------------------------------------------
+  // BrickedVolume
+  //-----------------------------------------------------------------------------
+  /**
+   * A RaycastVolume streaming the volume from a VolumeBrickSource brick by brick at multiple resolutions, allowing the rendering
+   * of volumes much larger than the GPU and system memory.
+   *
+   * The levels of the VolumeBrickSource are divided in bricks of brickSize() samples (32 by default), the bricks of level L being
+   * the children of the bricks of level L+1. Each frame the brick octree is refined where the projected sample spacing of a brick
+   * exceeds maxPixelError(), as long as the finer bricks are available, otherwise the coarser brick is rendered while the missing
+   * ones are loaded. Only the coarsest brick, covering the whole volume, must be loaded before something is displayed.
+   *
+   * \par Textures
+   * The bricks selected for rendering are stored, with a one sample apron, in the slots of atlasTexture(), a 3D texture whose size in slots
+   * is given by setCacheSlots(). The pageTableTexture() has one RGBA texel per full resolution brick containing the atlas slot of the brick
+   * rendered in its place in RGB and its level + 1 in A, 0 meaning no brick available. Both textures are created by init() and must be
+   * installed by the user in the Shader of the bound Actor, usually on the texture units 0 and 2 leaving unit 1 for the transfer function.
+   * Besides the RaycastVolume ones updateUniforms() sets the \p "uniform vec3 volume_size" variable to the size of the full resolution
+   * volume, see \p "/glsl/volume_raycast_bricked.fs" for a shader using them.
+   *
+   * \par Loading
+   * Missing bricks are queued and loaded by processLoadRequests(), which only touches CPU data. Without a loadMutex() the volume calls it
+   * by itself before rendering loading up to maxLoadsPerFrame() bricks per frame. For asynchronous loading install a mutex with setLoadMutex()
+   * and call processLoadRequests() from one or more worker threads: the rendering thread then only uploads up to maxUploadsPerFrame()
+   * loaded bricks per frame. When all the slots are in use the bricks not used by the current frame are evicted, least recently used first.
+   * \note No thread must be running processLoadRequests() while init() is called or the BrickedVolume is destroyed.
+   */
+  class VLVOLUME_EXPORT BrickedVolume: public RaycastVolume
+  {
+    VL_INSTRUMENT_CLASS(vl::BrickedVolume, RaycastVolume)
+
+  public:
+    BrickedVolume();
+
+    //! Discards all the loaded bricks and creates the atlasTexture() and pageTableTexture().
+    //! Must be called with an active OpenGL context after setting the parameters and when they change.
+    bool init();
+
+    /** Selects the bricks to be rendered, uploads the loaded ones and updates the page table, then updates the uniforms. */
+    virtual void updateUniforms( Actor* actor, real clock, const Camera* camera, Renderable* rend, const Shader* shader );
+
+    /** Loads up to \p max_count queued bricks, coarser bricks first. Can be called from any thread if a loadMutex() is installed.
+      * \return The number of bricks loaded. */
+    int processLoadRequests(int max_count);
+
+    //! Returns true if there are bricks waiting to be loaded.
+    bool hasLoadRequests() const;
+
+    //! The source of the bricks.
+    void setBrickSource(VolumeBrickSource* source) { mBrickSource = source; }
+    //! The source of the bricks.
+    VolumeBrickSource* brickSource() { return mBrickSource.get(); }
+
+    //! The number of levels of the brick octree, computed by init().
+    int levelCount() const { return mLevelCount; }
+
+    //! The size in slots of the atlasTexture(), each slot holding brickSize() + 2 samples per side (default is 8 x 8 x 8).
+    void setCacheSlots(const ivec3& slots) { mCacheSlots = slots; }
+    //! The size in slots of the atlasTexture(), each slot holding brickSize() + 2 samples per side (default is 8 x 8 x 8).
+    const ivec3& cacheSlots() const { return mCacheSlots; }
+
+    //! The maximum projected distance in pixels between two samples of a brick before it is refined (default is 2).
+    void setMaxPixelError(float pixels) { mMaxPixelError = pixels; }
+    //! The maximum projected distance in pixels between two samples of a brick before it is refined (default is 2).
+    float maxPixelError() const { return mMaxPixelError; }
+
+    //! The maximum number of bricks loaded per frame when no loadMutex() is installed (default is 4).
+    void setMaxLoadsPerFrame(int count) { mMaxLoadsPerFrame = count; }
+    //! The maximum number of bricks loaded per frame when no loadMutex() is installed (default is 4).
+    int maxLoadsPerFrame() const { return mMaxLoadsPerFrame; }
+
+    //! The maximum number of loaded bricks uploaded to the atlasTexture() per frame (default is 16).
+    void setMaxUploadsPerFrame(int count) { mMaxUploadsPerFrame = count; }
+    //! The maximum number of loaded bricks uploaded to the atlasTexture() per frame (default is 16).
+    int maxUploadsPerFrame() const { return mMaxUploadsPerFrame; }
+
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    void setLoadMutex(IMutex* mutex) { mLoadMutex = mutex; }
+    //! The mutex protecting the load queue, required when calling processLoadRequests() from other threads.
+    IMutex* loadMutex() { return mLoadMutex; }
+
+    //! The 3D texture caching the bricks, created by init().
+    Texture* atlasTexture() { return mAtlasTexture.get(); }
+
+    //! The 3D texture mapping each full resolution brick to the atlas slot of the brick rendered in its place, created by init().
+    Texture* pageTableTexture() { return mPageTableTexture.get(); }
+
+    //! The number of bricks selected for rendering in the last frame.
+    int statsSelectedBricks() const { return (int)mSelected.size(); }
+    //! The number of bricks currently in the atlasTexture().
+    int statsCachedBricks() const { return mStatsCachedBricks; }
+    //! The number of bricks waiting to be loaded.
+    int statsPendingBricks() const { return mStatsPendingBricks; }
+
+  protected:
+    enum EBrickState { BS_Queued, BS_Loading, BS_Loaded, BS_Ready, BS_Failed };
+
+    class Brick: public Object
+    {
+    public:
+      Brick(int level, const ivec3& pos): mLevel(level), mPos(pos), mState(BS_Queued), mLastUsedFrame(0), mSlot(-1) {}
+      int mLevel;
+      ivec3 mPos;
+      EBrickState mState;
+      unsigned mLastUsedFrame;
+      // filled by the loader
+      ref<Image> mImage;
+      // assigned by the rendering thread
+      int mSlot;
+    };
+
+    struct BrickKey
+    {
+      BrickKey(int level, const ivec3& pos): mLevel(level), mPos(pos) {}
+      bool operator<(const BrickKey& other) const
+      {
+        if (mLevel != other.mLevel) return mLevel < other.mLevel;
+        if (mPos.x() != other.mPos.x()) return mPos.x() < other.mPos.x();
+        if (mPos.y() != other.mPos.y()) return mPos.y() < other.mPos.y();
+        return mPos.z() < other.mPos.z();
+      }
+      int mLevel;
+      ivec3 mPos;
+    };
+
+    Brick* acquireBrick(int level, const ivec3& pos);
+    bool brickExists(int level, const ivec3& pos) const;
+    AABB brickBounds(int level, const ivec3& pos) const;
+    void selectBrick(int level, const ivec3& pos, const vec3& eye, real proj_factor, const Actor* actor, const Camera* camera);
+    void uploadLoadedBricks();
+    void cancelUnusedRequests();
+    void updatePageTable();
+    void uploadTexture(Texture* tex, const ivec3& offset, const ivec3& size, int gl_format, int gl_type, const void* pixels);
+
+  protected:
+    ref<VolumeBrickSource> mBrickSource;
+    std::map< BrickKey, ref<Brick> > mBricks;
+    std::deque<Brick*> mLoadQueue;    // protected by mLoadMutex
+    std::vector<Brick*> mLoadedBricks; // protected by mLoadMutex
+    std::vector<Brick*> mSelected;
+    std::vector<Brick*> mSlots;
+    std::vector<unsigned char> mPageTable;
+    ref<Texture> mAtlasTexture;
+    ref<Texture> mPageTableTexture;
+    IMutex* mLoadMutex;
+    ivec3 mCacheSlots;
+    ivec3 mVolumeSize;
+    ivec3 mPageCount;
+    EImageType mSampleType;
+    float mMaxPixelError;
+    int mLevelCount;
+    int mMaxLoadsPerFrame;
+    int mMaxUploadsPerFrame;
+    unsigned mFrame;
+    int mStatsCachedBricks;
+    int mStatsPendingBricks;
+    bool mPageTableDirty;
+  };
+}
+
+#endif
@@ -0,0 +1,231 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlVolume/GPUMarchingCubes.hpp>
+#include <vlVolume/MarchingCubes.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/Shader.hpp>
+
+using namespace vl;
+
+//------------------------------------------------------------------------------
+// GPUMarchingCubes
+//------------------------------------------------------------------------------
+GPUMarchingCubes::GPUMarchingCubes()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mBox = AABB( vec3(0,0,0), vec3(1,1,1) );
+  mThreshold = 0.5f;
+  mMaxTriangleCount = 1024*1024;
+  mTransformFeedback = 0;
+  mExtractionDirty = true;
+  mExtracted = false;
+
+  mVertexArray = new ArrayFloat3;
+  mNormalArray = new ArrayFloat3;
+  mGeometry = new Geometry;
+  mGeometry->setVertexArray( mVertexArray.get() );
+  mGeometry->setNormalArray( mNormalArray.get() );
+}
+//------------------------------------------------------------------------------
+GPUMarchingCubes::~GPUMarchingCubes()
+{
+  deleteBufferObject();
+}
+//------------------------------------------------------------------------------
+bool GPUMarchingCubes::isSupported()
+{
+  return ( Has_GL_Version_4_0 || Has_GL_ARB_transform_feedback2 ) && Has_Geometry_Shader && Has_Texture_Buffer;
+}
+//------------------------------------------------------------------------------
+void GPUMarchingCubes::deleteBufferObject()
+{
+  mVertexArray->bufferObject()->deleteBufferObject();
+  mNormalArray->bufferObject()->deleteBufferObject();
+  if (mTransformFeedback)
+  {
+    glDeleteTransformFeedbacks( 1, &mTransformFeedback ); VL_CHECK_OGL();
+    mTransformFeedback = 0;
+  }
+  mExtractionDirty = true;
+  mExtracted = false;
+}
+//------------------------------------------------------------------------------
+void GPUMarchingCubes::computeBounds_Implementation()
+{
+  setBoundingBox( mBox );
+  setBoundingSphere( mBox.isNull() ? Sphere() : Sphere(mBox) );
+}
+//------------------------------------------------------------------------------
+bool GPUMarchingCubes::init() const
+{
+  if ( ! isSupported() )
+  {
+    Log::error("GPUMarchingCubes requires OpenGL 4.0 or GL_ARB_transform_feedback2.\n");
+    return false;
+  }
+
+  if ( ! mExtractionProgram )
+  {
+    mExtractionProgram = new GLSLProgram;
+    mExtractionProgram->setObjectName("GPUMarchingCubes::extractionProgram");
+    mExtractionProgram->attachShader( new GLSLVertexShader("/glsl/marching_cubes.vs") );
+    mExtractionProgram->attachShader( new GLSLGeometryShader("/glsl/marching_cubes.gs") );
+    // positions and normals go to the buffers of mVertexArray and mNormalArray respectively
+    std::vector<std::string> varyings;
+    varyings.push_back("vl_MCPosition");
+    varyings.push_back("vl_MCNormal");
+    mExtractionProgram->setTransformFeedbackVaryings( varyings, false );
+  }
+
+  if ( ! mExtractionProgram->linked() && ! mExtractionProgram->linkProgram() )
+    return false;
+
+  // the triangle table is shared with MarchingCubes
+  if ( ! mTriangleTable )
+  {
+    ref<BufferObject> table = new BufferObject;
+    table->setBufferData( sizeof(int)*256*16, MarchingCubes::triangleConnectionTable(), BU_STATIC_DRAW );
+    mTriangleTable = new Texture;
+    if ( ! mTriangleTable->createTextureBuffer(TF_R32I, table.get()) )
+    {
+      Log::error("GPUMarchingCubes: could not create the triangle table texture.\n");
+      mTriangleTable = NULL;
+      return false;
+    }
+  }
+
+  if ( ! mTransformFeedback )
+  {
+    glGenTransformFeedbacks( 1, &mTransformFeedback ); VL_CHECK_OGL();
+  }
+
+  return true;
+}
+//------------------------------------------------------------------------------
+bool GPUMarchingCubes::extract(OpenGLContext* gl_context) const
+{
+  VL_CHECK_OGL();
+
+  mExtractionDirty = false;
+  mExtracted = false;
+
+  if ( ! init() )
+    return false;
+
+  Texture* volume = mVolumeTexture.get();
+  if ( volume && ! volume->handle() && volume->setupParams() )
+    volume->createTexture();
+  if ( ! volume || ! volume->handle() || volume->dimension() != TD_TEXTURE_3D )
+  {
+    Log::error("GPUMarchingCubes::extract(): the volume texture must be a valid 3D texture.\n");
+    return false;
+  }
+
+  const ivec3 cells( volume->width()-1, volume->height()-1, volume->depth()-1 );
+  if ( cells.x() < 1 || cells.y() < 1 || cells.z() < 1 )
+    return false;
+
+  // (re)allocate the output buffers, 3 vertices per triangle
+  GLsizeiptr byte_count = (GLsizeiptr)mMaxTriangleCount * 3 * sizeof(fvec3);
+  if ( mVertexArray->bufferObject()->byteCountBufferObject() != byte_count )
+  {
+    mVertexArray->bufferObject()->setBufferData( byte_count, NULL, BU_DYNAMIC_COPY );
+    mNormalArray->bufferObject()->setBufferData( byte_count, NULL, BU_DYNAMIC_COPY );
+  }
+
+  gl_context->useGLSLProgram( mExtractionProgram.get() );
+
+  const fvec3 box_min  = (fvec3)mBox.minCorner();
+  const fvec3 box_size = (fvec3)(mBox.maxCorner() - mBox.minCorner());
+  glUniform1i( mExtractionProgram->getUniformLocation("vl_MCVolume"), 0 ); VL_CHECK_OGL();
+  glUniform1i( mExtractionProgram->getUniformLocation("vl_MCTriangleTable"), 1 ); VL_CHECK_OGL();
+  glUniform1f( mExtractionProgram->getUniformLocation("vl_MCThreshold"), mThreshold ); VL_CHECK_OGL();
+  glUniform3i( mExtractionProgram->getUniformLocation("vl_MCCells"), cells.x(), cells.y(), cells.z() ); VL_CHECK_OGL();
+  glUniform3fv( mExtractionProgram->getUniformLocation("vl_MCBoxMin"), 1, box_min.ptr() ); VL_CHECK_OGL();
+  glUniform3fv( mExtractionProgram->getUniformLocation("vl_MCBoxSize"), 1, box_size.ptr() ); VL_CHECK_OGL();
+
+  // bind the volume and the triangle table on the texture units 0 and 1 preserving the current bindings
+  GLint active_unit = 0, prev_volume = 0, prev_table = 0;
+  glGetIntegerv( GL_ACTIVE_TEXTURE, &active_unit ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glGetIntegerv( GL_TEXTURE_BINDING_3D, &prev_volume ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_3D, volume->handle() ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE1 ); VL_CHECK_OGL();
+  glGetIntegerv( GL_TEXTURE_BINDING_BUFFER, &prev_table ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_BUFFER, mTriangleTable->handle() ); VL_CHECK_OGL();
+
+  // one point per cell, the geometry shader emits the triangles of the cell and nothing is rasterized
+  gl_context->bindVAS( NULL, false, false );
+  glEnable( GL_RASTERIZER_DISCARD ); VL_CHECK_OGL();
+  glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, mTransformFeedback ); VL_CHECK_OGL();
+  glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, mVertexArray->bufferObject()->handle() ); VL_CHECK_OGL();
+  glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 1, mNormalArray->bufferObject()->handle() ); VL_CHECK_OGL();
+  glBeginTransformFeedback( GL_TRIANGLES ); VL_CHECK_OGL();
+  glDrawArrays( GL_POINTS, 0, cells.x() * cells.y() * cells.z() ); VL_CHECK_OGL();
+  glEndTransformFeedback(); VL_CHECK_OGL();
+  glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0 ); VL_CHECK_OGL();
+  glBindBufferBase( GL_TRANSFORM_FEEDBACK_BUFFER, 1, 0 ); VL_CHECK_OGL();
+  glBindTransformFeedback( GL_TRANSFORM_FEEDBACK, 0 ); VL_CHECK_OGL();
+  // glBindBufferBase() also binds the generic GL_TRANSFORM_FEEDBACK_BUFFER binding point
+  VL_glBindBuffer( GL_TRANSFORM_FEEDBACK_BUFFER, 0 ); VL_CHECK_OGL();
+  glDisable( GL_RASTERIZER_DISCARD ); VL_CHECK_OGL();
+
+  // restore the texture bindings
+  glBindTexture( GL_TEXTURE_BUFFER, prev_table ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_3D, prev_volume ); VL_CHECK_OGL();
+  VL_glActiveTexture( active_unit ); VL_CHECK_OGL();
+
+  mExtracted = true;
+  return true;
+}
+//------------------------------------------------------------------------------
+void GPUMarchingCubes::render_Implementation(const Actor*, const Shader* shader, const Camera*, OpenGLContext* gl_context) const
+{
+  VL_CHECK_OGL();
+
+  if ( mExtractionDirty )
+  {
+    extract( gl_context );
+    // restore the Shader's GLSLProgram
+    gl_context->useGLSLProgram( shader ? shader->glslProgram() : NULL );
+  }
+
+  if ( ! mExtracted )
+    return;
+
+  // draws the triangles captured by the last extraction without reading back their number
+  gl_context->bindVAS( mGeometry.get(), true, false );
+  glDrawTransformFeedback( GL_TRIANGLES, mTransformFeedback ); VL_CHECK_OGL();
+}
+//------------------------------------------------------------------------------
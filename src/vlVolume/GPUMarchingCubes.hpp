@@ -0,0 +1,143 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef GPUMarchingCubes_INCLUDE_ONCE
+#define GPUMarchingCubes_INCLUDE_ONCE
+
+#include <vlVolume/link_config.hpp>
+#include <vlGraphics/Geometry.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Texture.hpp>
+
+namespace vl
+{
+  //------------------------------------------------------------------------------
+  // GPUMarchingCubes
+  //------------------------------------------------------------------------------
+  /**
+   * Extracts and renders the isosurface of a 3D Texture entirely on the GPU.
+   *
+   * Each cell of the volume is processed by a geometry shader which writes the triangles of the isosurface into
+   * the BufferObject[s] of vertexArray() and normalArray() using transform feedback. The isosurface is then rendered with
+   * glDrawTransformFeedback() so that the number of generated triangles never needs to be read back by the CPU.
+   * The extraction is performed at the next rendering after the threshold, the box or the volume texture change,
+   * call setExtractionDirty() when the content of the volume texture is modified.
+   *
+   * The volume texture is read with the same conventions of MarchingCubes (the texels are the samples of the volume,
+   * the isosurface separates the samples below the threshold from the others) and can be the same Texture rendered by a RaycastVolume.
+   * The Shader used to render the GPUMarchingCubes receives the vertex positions and normals like any other Geometry.
+   *
+   * Requires OpenGL 4.0 or GL_ARB_transform_feedback2, together with geometry shaders and texture buffers.
+   * \sa MarchingCubes, RaycastVolume
+   */
+  class VLVOLUME_EXPORT GPUMarchingCubes: public Renderable
+  {
+    VL_INSTRUMENT_CLASS(vl::GPUMarchingCubes, Renderable)
+
+  public:
+    GPUMarchingCubes();
+
+    ~GPUMarchingCubes();
+
+    //! Returns true if the current OpenGL context supports GPUMarchingCubes.
+    static bool isSupported();
+
+    //! The 3D texture containing the volume data, the first component of each texel is used.
+    void setVolumeTexture(Texture* texture) { mVolumeTexture = texture; mExtractionDirty = true; }
+    //! The 3D texture containing the volume data, the first component of each texel is used.
+    Texture* volumeTexture() { return mVolumeTexture.get(); }
+    //! The 3D texture containing the volume data, the first component of each texel is used.
+    const Texture* volumeTexture() const { return mVolumeTexture.get(); }
+
+    //! The box in model coordinates spanned by the volume samples, like RaycastVolume::setBox().
+    void setBox(const AABB& box) { mBox = box; mExtractionDirty = true; setBoundsDirty(true); }
+    //! The box in model coordinates spanned by the volume samples.
+    const AABB& box() const { return mBox; }
+
+    //! The isosurface threshold, in the units of the texture values as seen by the shaders (normalized values for normalized texture formats).
+    void setThreshold(float threshold) { mThreshold = threshold; mExtractionDirty = true; }
+    //! The isosurface threshold.
+    float threshold() const { return mThreshold; }
+
+    //! The maximum number of triangles stored by the output buffers, the exceeding triangles are discarded. Defaults to 1M triangles.
+    void setMaxTriangleCount(int count) { mMaxTriangleCount = count; mExtractionDirty = true; }
+    //! The maximum number of triangles stored by the output buffers.
+    int maxTriangleCount() const { return mMaxTriangleCount; }
+
+    //! Schedules the extraction of the isosurface at the next rendering, call it when the content of the volume texture changes.
+    void setExtractionDirty() { mExtractionDirty = true; }
+    //! Returns true if the isosurface will be extracted at the next rendering.
+    bool extractionDirty() const { return mExtractionDirty; }
+
+    //! The vertex positions of the isosurface, stored only in the array's BufferObject.
+    const ArrayFloat3* vertexArray() const { return mVertexArray.get(); }
+    //! The vertex normals of the isosurface, stored only in the array's BufferObject.
+    const ArrayFloat3* normalArray() const { return mNormalArray.get(); }
+
+    //! The GLSLProgram used to extract the isosurface.
+    const GLSLProgram* extractionProgram() const { return mExtractionProgram.get(); }
+
+    //! Extracts the isosurface immediately, \p gl_context must be active.
+    //! \note The extraction GLSLProgram is left active, see OpenGLContext::useGLSLProgram().
+    bool extract(OpenGLContext* gl_context) const;
+
+    //! Returns true if the last extraction was successful.
+    bool extracted() const { return mExtracted; }
+
+    virtual void updateDirtyBufferObject(EBufferObjectUpdateMode) {}
+
+    virtual void deleteBufferObject();
+
+  protected:
+    virtual void computeBounds_Implementation();
+    virtual void render_Implementation(const Actor* actor, const Shader* shader, const Camera* camera, OpenGLContext* gl_context) const;
+    bool init() const;
+
+  protected:
+    // textures and buffers are created and written while rendering
+    mutable ref<Texture> mVolumeTexture;
+    AABB mBox;
+    float mThreshold;
+    int mMaxTriangleCount;
+    // the output of the extraction, drawn through mGeometry
+    mutable ref<ArrayFloat3> mVertexArray;
+    mutable ref<ArrayFloat3> mNormalArray;
+    ref<Geometry> mGeometry;
+    mutable ref<GLSLProgram> mExtractionProgram;
+    mutable ref<Texture> mTriangleTable;
+    mutable unsigned int mTransformFeedback;
+    mutable bool mExtractionDirty;
+    mutable bool mExtracted;
+  };
+}
+
+#endif
@@ -0,0 +1,344 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#include <vlVolume/GPUVolumeBaker.hpp>
+#include <vlGraphics/OpenGLContext.hpp>
+#include <vlGraphics/Shader.hpp>
+#include <vlCore/VirtualFile.hpp>
+
+using namespace vl;
+
+namespace
+{
+  //! Binds \p texture to the current texture unit applying its TexParameter like TextureSampler does, returns the previous binding.
+  GLint bindTexture(const Texture* texture, GLenum binding, OpenGLContext* gl_context)
+  {
+    GLint prev = 0;
+    glGetIntegerv( binding, &prev ); VL_CHECK_OGL();
+    glBindTexture( texture->dimension(), texture->handle() ); VL_CHECK_OGL();
+    // texelFetch() returns 0 from incomplete textures, eg. non mipmapped textures with a mipmap minification filter
+    if ( texture->getTexParameter()->dirty() )
+      texture->getTexParameter()->apply( texture->dimension(), gl_context );
+    return prev;
+  }
+
+  //! Saves and restores the enables, viewport and color mask modified by GPUVolumeBaker::bake().
+  class ScopedBakeState
+  {
+  public:
+    ScopedBakeState()
+    {
+      // GL_ALPHA_TEST is also applied to the fragments written by the GLSL programs of the compatibility profile
+      static const GLenum caps[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_ALPHA_TEST };
+      mCapCount = Has_Fixed_Function_Pipeline ? 6 : 5;
+      for( int i=0; i<mCapCount; ++i )
+      {
+        mCaps[i] = caps[i];
+        mEnabled[i] = glIsEnabled( caps[i] ) == GL_TRUE; VL_CHECK_OGL();
+        glDisable( caps[i] ); VL_CHECK_OGL();
+      }
+      glGetIntegerv( GL_VIEWPORT, mViewport ); VL_CHECK_OGL();
+      glGetBooleanv( GL_COLOR_WRITEMASK, mColorMask ); VL_CHECK_OGL();
+      glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE ); VL_CHECK_OGL();
+    }
+
+    ~ScopedBakeState()
+    {
+      for( int i=0; i<mCapCount; ++i )
+      {
+        if ( mEnabled[i] )
+        {
+          glEnable( mCaps[i] ); VL_CHECK_OGL();
+        }
+      }
+      glViewport( mViewport[0], mViewport[1], mViewport[2], mViewport[3] ); VL_CHECK_OGL();
+      glColorMask( mColorMask[0], mColorMask[1], mColorMask[2], mColorMask[3] ); VL_CHECK_OGL();
+    }
+
+  private:
+    GLenum mCaps[6];
+    bool mEnabled[6];
+    int mCapCount;
+    GLint mViewport[4];
+    GLboolean mColorMask[4];
+  };
+}
+//------------------------------------------------------------------------------
+// GPUVolumeBaker
+//------------------------------------------------------------------------------
+GPUVolumeBaker::GPUVolumeBaker()
+{
+  VL_DEBUG_SET_OBJECT_NAME()
+  mFramebuffer = 0;
+}
+//------------------------------------------------------------------------------
+GPUVolumeBaker::~GPUVolumeBaker()
+{
+  releaseResources();
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::isSupported()
+{
+  return Has_GL_Version_3_0 && Has_GLSL && Has_FBO;
+}
+//------------------------------------------------------------------------------
+void GPUVolumeBaker::releaseResources()
+{
+  if ( mFramebuffer )
+  {
+    VL_glDeleteFramebuffers( 1, &mFramebuffer ); VL_CHECK_OGL();
+    mFramebuffer = 0;
+  }
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::init()
+{
+  if ( ! isSupported() )
+  {
+    Log::error("GPUVolumeBaker requires OpenGL 3.0.\n");
+    return false;
+  }
+
+  if ( ! mRGBAProgram )
+  {
+    mRGBAProgram = new GLSLProgram;
+    mRGBAProgram->setObjectName("GPUVolumeBaker::RGBAProgram");
+    mRGBAProgram->attachShader( new GLSLVertexShader("/glsl/volume_bake.vs") );
+    mRGBAProgram->attachShader( new GLSLFragmentShader("/glsl/volume_bake_rgba.fs") );
+  }
+
+  if ( ! mGradientProgram )
+  {
+    mGradientProgram = new GLSLProgram;
+    mGradientProgram->setObjectName("GPUVolumeBaker::gradientProgram");
+    mGradientProgram->attachShader( new GLSLVertexShader("/glsl/volume_bake.vs") );
+    mGradientProgram->attachShader( new GLSLFragmentShader("/glsl/volume_bake_gradient.fs") );
+  }
+
+  if ( ! mRGBAProgram->linked() && ! mRGBAProgram->linkProgram() )
+    return false;
+
+  if ( ! mGradientProgram->linked() && ! mGradientProgram->linkProgram() )
+    return false;
+
+  if ( ! mFramebuffer )
+  {
+    VL_glGenFramebuffers( 1, &mFramebuffer ); VL_CHECK_OGL();
+  }
+
+  return true;
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::genRGBAVolume(OpenGLContext* gl_context, Texture* data, Texture* trfunc, Texture* out, const fvec3& light_dir, bool alpha_from_data)
+{
+  if ( ! init() )
+    return false;
+
+  // light normalization
+  fvec3 L = light_dir;
+  L.normalize();
+
+  gl_context->useGLSLProgram( mRGBAProgram.get() );
+  glUniform1i( mRGBAProgram->getUniformLocation("vl_VBLighting"), 1 ); VL_CHECK_OGL();
+  glUniform3fv( mRGBAProgram->getUniformLocation("vl_VBLightDir"), 1, L.ptr() ); VL_CHECK_OGL();
+  glUniform1i( mRGBAProgram->getUniformLocation("vl_VBAlphaFromData"), alpha_from_data ? 1 : 0 ); VL_CHECK_OGL();
+
+  return bake( gl_context, mRGBAProgram.get(), data, trfunc, out );
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::genRGBAVolume(OpenGLContext* gl_context, Texture* data, Texture* trfunc, Texture* out, bool alpha_from_data)
+{
+  if ( ! init() )
+    return false;
+
+  gl_context->useGLSLProgram( mRGBAProgram.get() );
+  glUniform1i( mRGBAProgram->getUniformLocation("vl_VBLighting"), 0 ); VL_CHECK_OGL();
+  glUniform1i( mRGBAProgram->getUniformLocation("vl_VBAlphaFromData"), alpha_from_data ? 1 : 0 ); VL_CHECK_OGL();
+
+  return bake( gl_context, mRGBAProgram.get(), data, trfunc, out );
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::genGradientNormals(OpenGLContext* gl_context, Texture* data, Texture* out)
+{
+  if ( ! init() )
+    return false;
+
+  gl_context->useGLSLProgram( mGradientProgram.get() );
+
+  return bake( gl_context, mGradientProgram.get(), data, NULL, out );
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::sampleFunction(OpenGLContext* gl_context, const String& glsl_function, Texture* out, const fvec3& min_corner, const fvec3& max_corner)
+{
+  if ( ! init() )
+    return false;
+
+  if ( ! mFunctionProgram || glsl_function != mFunctionSource )
+  {
+    // the user function is a separate shader object linked with the sampling shader
+    String source = locateFile( glsl_function ) ? String::loadText( glsl_function ) : glsl_function;
+    if ( source.find("#version") == -1 )
+      source = String("#version 150 compatibility\n") + source;
+    ref<GLSLFragmentShader> function_shader = new GLSLFragmentShader( source );
+
+    mFunctionProgram = new GLSLProgram;
+    mFunctionProgram->setObjectName("GPUVolumeBaker::functionProgram");
+    mFunctionProgram->attachShader( new GLSLVertexShader("/glsl/volume_bake.vs") );
+    mFunctionProgram->attachShader( new GLSLFragmentShader("/glsl/volume_bake_function.fs") );
+    mFunctionProgram->attachShader( function_shader.get() );
+    mFunctionSource = glsl_function;
+  }
+
+  if ( ! mFunctionProgram->linked() && ! mFunctionProgram->linkProgram() )
+    return false;
+
+  if ( out && ! out->handle() && out->setupParams() )
+    out->createTexture();
+
+  if ( ! out || ! out->handle() )
+  {
+    Log::error("GPUVolumeBaker: the output texture must be created before sampling a function.\n");
+    return false;
+  }
+
+  fvec3 size( (float)out->width(), (float)out->height(), (float)out->depth() );
+  gl_context->useGLSLProgram( mFunctionProgram.get() );
+  glUniform3fv( mFunctionProgram->getUniformLocation("vl_VBMinCorner"), 1, min_corner.ptr() ); VL_CHECK_OGL();
+  glUniform3fv( mFunctionProgram->getUniformLocation("vl_VBMaxCorner"), 1, max_corner.ptr() ); VL_CHECK_OGL();
+  glUniform3fv( mFunctionProgram->getUniformLocation("vl_VBSize"), 1, size.ptr() ); VL_CHECK_OGL();
+
+  return bake( gl_context, mFunctionProgram.get(), NULL, NULL, out );
+}
+//------------------------------------------------------------------------------
+bool GPUVolumeBaker::bake(OpenGLContext* gl_context, GLSLProgram* program, Texture* data, Texture* trfunc, Texture* out)
+{
+  VL_CHECK_OGL();
+
+  bool ok = false;
+  if ( data && ! data->handle() && data->setupParams() )
+    data->createTexture();
+  if ( trfunc && ! trfunc->handle() && trfunc->setupParams() )
+    trfunc->createTexture();
+
+  // the function program has no input volume
+  const bool has_input = program != mFunctionProgram.get();
+
+  if ( has_input && ( ! data || ! data->handle() || data->dimension() != TD_TEXTURE_3D ) )
+    Log::error("GPUVolumeBaker: the volume texture must be a valid 3D texture.\n");
+  else
+  if ( program == mRGBAProgram.get() && ( ! trfunc || ! trfunc->handle() || trfunc->dimension() != TD_TEXTURE_1D ) )
+    Log::error("GPUVolumeBaker: the transfer function must be a valid 1D texture.\n");
+  else
+  if ( ! out )
+    Log::error("GPUVolumeBaker: no output texture specified.\n");
+  else
+    ok = true;
+
+  if ( ok && ! out->handle() && has_input )
+  {
+    if ( out->setupParams() )
+      out->createTexture();
+    else
+      out->createTexture3D( data->width(), data->height(), data->depth(), TF_RGBA8 );
+  }
+
+  if ( ok && ( ! out->handle() || out->dimension() != TD_TEXTURE_3D || ( has_input &&
+       ( out->width() != data->width() || out->height() != data->height() || out->depth() != data->depth() ) ) ) )
+  {
+    Log::error("GPUVolumeBaker: the output texture must be a 3D texture as large as the volume texture.\n");
+    ok = false;
+  }
+
+  if ( ! ok )
+  {
+    gl_context->useGLSLProgram( NULL );
+    return false;
+  }
+
+  glUniform1i( program->getUniformLocation("vl_VBVolume"), 0 ); VL_CHECK_OGL();
+  glUniform1i( program->getUniformLocation("vl_VBTrFunc"), 1 ); VL_CHECK_OGL();
+  int slice_location = program->getUniformLocation("vl_VBSlice");
+
+  // bind the volume and the transfer function on the texture units 0 and 1 preserving the current bindings
+  GLint active_unit = 0, prev_volume = 0, prev_trfunc = 0;
+  glGetIntegerv( GL_ACTIVE_TEXTURE, &active_unit ); VL_CHECK_OGL();
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  // the output texture is bound first only to make it complete
+  prev_volume = bindTexture( out, GL_TEXTURE_BINDING_3D, gl_context );
+  if ( data )
+    bindTexture( data, GL_TEXTURE_BINDING_3D, gl_context );
+  if ( trfunc )
+  {
+    VL_glActiveTexture( GL_TEXTURE1 ); VL_CHECK_OGL();
+    prev_trfunc = bindTexture( trfunc, GL_TEXTURE_BINDING_1D, gl_context );
+  }
+
+  GLint prev_fbo = 0;
+  glGetIntegerv( GL_FRAMEBUFFER_BINDING, &prev_fbo ); VL_CHECK_OGL();
+  VL_glBindFramebuffer( GL_FRAMEBUFFER, mFramebuffer ); VL_CHECK_OGL();
+
+  {
+    ScopedBakeState bake_state;
+    glViewport( 0, 0, out->width(), out->height() ); VL_CHECK_OGL();
+
+    // one triangle covering the viewport for each slice, generated by the vertex shader
+    gl_context->bindVAS( NULL, false, false );
+    for( int z=0; z<out->depth() && ok; ++z )
+    {
+      VL_glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, out->handle(), 0, z ); VL_CHECK_OGL();
+      if ( z == 0 && VL_glCheckFramebufferStatus( GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE )
+      {
+        Log::error("GPUVolumeBaker: the format of the output texture is not color-renderable.\n");
+        ok = false;
+        break;
+      }
+      glUniform1i( slice_location, z ); VL_CHECK_OGL();
+      glDrawArrays( GL_TRIANGLES, 0, 3 ); VL_CHECK_OGL();
+    }
+    VL_glFramebufferTextureLayer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0, 0 ); VL_CHECK_OGL();
+  }
+
+  VL_glBindFramebuffer( GL_FRAMEBUFFER, prev_fbo ); VL_CHECK_OGL();
+
+  // restore the texture bindings
+  if ( trfunc )
+  {
+    glBindTexture( GL_TEXTURE_1D, prev_trfunc ); VL_CHECK_OGL();
+  }
+  VL_glActiveTexture( GL_TEXTURE0 ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_3D, prev_volume ); VL_CHECK_OGL();
+  VL_glActiveTexture( active_unit ); VL_CHECK_OGL();
+
+  gl_context->useGLSLProgram( NULL );
+  return ok;
+}
+//------------------------------------------------------------------------------
@@ -0,0 +1,109 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef GPUVolumeBaker_INCLUDE_ONCE
+#define GPUVolumeBaker_INCLUDE_ONCE
+
+#include <vlVolume/link_config.hpp>
+#include <vlGraphics/GLSL.hpp>
+#include <vlGraphics/Texture.hpp>
+
+namespace vl
+{
+  class OpenGLContext;
+
+  //------------------------------------------------------------------------------
+  // GPUVolumeBaker
+  //------------------------------------------------------------------------------
+  /**
+   * GPU implementation of genRGBAVolume() and genGradientNormals() operating directly on 3D textures.
+   *
+   * Each slice of the output 3D texture is attached to a framebuffer object and rendered with a fragment shader
+   * which reads the volume with texelFetch(), so that a volume can be re-baked every time its transfer function changes
+   * without reading back or uploading any data. The results are the same of the CPU functions within the 8 bits precision of the output.
+   *
+   * The volume texture can have any single channel format, the transfer function must be a 1D texture.
+   * If the output texture has not been created yet it is created with the size of the volume and format TF_RGBA8,
+   * otherwise it must be a 3D texture as large as the volume with a color-renderable format.
+   * All the baking functions must be called with \p gl_context active and preserve the OpenGL state tracked by it,
+   * except for the current GLSLProgram which is set to NULL, see OpenGLContext::useGLSLProgram().
+   *
+   * sampleFunction() fills a 3D texture with the values of a function given as GLSL source, see VolumePlot::computeGPU().
+   *
+   * Requires OpenGL 3.0 with GLSL and framebuffer objects.
+   * \sa genRGBAVolume(), genGradientNormals(), SlicedVolume, RaycastVolume
+   */
+  class VLVOLUME_EXPORT GPUVolumeBaker: public Object
+  {
+    VL_INSTRUMENT_CLASS(vl::GPUVolumeBaker, Object)
+
+  public:
+    GPUVolumeBaker();
+
+    ~GPUVolumeBaker();
+
+    //! Returns true if the current OpenGL context supports GPUVolumeBaker.
+    static bool isSupported();
+
+    //! Same as genRGBAVolume(const Image* data, const Image* trfunc, const fvec3& light_dir, bool alpha_from_data), writes the result into \p out.
+    bool genRGBAVolume(OpenGLContext* gl_context, Texture* data, Texture* trfunc, Texture* out, const fvec3& light_dir, bool alpha_from_data=true);
+
+    //! Same as genRGBAVolume(const Image* data, const Image* trfunc, bool alpha_from_data), writes the result into \p out.
+    bool genRGBAVolume(OpenGLContext* gl_context, Texture* data, Texture* trfunc, Texture* out, bool alpha_from_data=true);
+
+    //! Same as genGradientNormals(const Image* data), writes the packed normals into the RGB components of \p out.
+    bool genGradientNormals(OpenGLContext* gl_context, Texture* data, Texture* out);
+
+    /** Writes into each texel of \p out the value of the function \p glsl_function sampled on a regular grid spanning \p min_corner and \p max_corner.
+     * \p glsl_function is the GLSL source, or the path of a file containing it, defining the function <tt>float vl_VBFunction(vec3 p)</tt>
+     * where \p p is the sample position. If the source does not declare a \p \#version then <tt>\#version 150 compatibility</tt> is used.
+     * \p out must be a 3D texture already created, or with setupParams(), with a color-renderable format such as TF_R32F.
+     * The program is recompiled only when \p glsl_function changes. */
+    bool sampleFunction(OpenGLContext* gl_context, const String& glsl_function, Texture* out, const fvec3& min_corner, const fvec3& max_corner);
+
+    //! Deletes the framebuffer object used for baking, the OpenGL context used for baking must be active.
+    void releaseResources();
+
+  protected:
+    bool init();
+    bool bake(OpenGLContext* gl_context, GLSLProgram* program, Texture* data, Texture* trfunc, Texture* out);
+
+  protected:
+    ref<GLSLProgram> mRGBAProgram;
+    ref<GLSLProgram> mGradientProgram;
+    ref<GLSLProgram> mFunctionProgram;
+    String mFunctionSource;
+    unsigned int mFramebuffer;
+  };
+}
+
+#endif
@@ -71,16 +71,18 @@ MarchingCubes::MarchingCubes()
 #endif
   mVolumeInfo.setAutomaticDelete(false);
   mHighQualityNormals = true;
+  mInteractive = false;
+  mThreadCount = 1;
 }
 //------------------------------------------------------------------------------
 // MarchingCubes
 //------------------------------------------------------------------------------
-void MarchingCubes::computeEdges(Volume* vol, float threshold)
+void MarchingCubes::computeEdges(Volume* vol, float threshold, Slab& slab)
 {
-  // mEdges.clear();
-  mEdges.resize(vol->slices().x() * vol->slices().y() * vol->slices().z());
-  mCubes.clear();
-  mCubes.reserve(1024);
+  slab.mVerts.clear();
+  slab.mNorms.clear();
+  slab.mIndices.clear();
+  slab.mCubes.clear();
 
   /////////////////////////////////////////////////////////////////////////////////
   // note: this funtion can generate double vertices when the 't' is 0.0 or 1.0
@@ -89,15 +91,20 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
   // Geometry::computeNormals() which is much quicker than computing the gradient.
   /////////////////////////////////////////////////////////////////////////////////
 
+  // the edges emitted here are indexed relatively to the slab, see processCube()
+
   const float dx = vol->cellSize().x() * 0.25f;
   const float dy = vol->cellSize().y() * 0.25f;
   const float dz = vol->cellSize().z() * 0.25f;
   float v0, v1, v2, v3, t;
-  int iedge = 0;
   int w = vol->slices().x() -1;
   int h = vol->slices().y() -1;
   int d = vol->slices().z() -1;
-  for(unsigned short z = 0; z < vol->slices().z(); ++z)
+  const int block_size = Volume::blockSize();
+  int iedge = slab.mZBegin * vol->slices().x() * vol->slices().y();
+  // clear the edges left by a previous run
+  std::fill( mEdges.begin() + iedge, mEdges.begin() + slab.mZEnd * vol->slices().x() * vol->slices().y(), Edge() );
+  for(unsigned short z = (unsigned short)slab.mZBegin; z < slab.mZEnd; ++z)
   {
     for(unsigned short y = 0; y < vol->slices().y(); ++y)
     {
@@ -105,22 +112,20 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
       {
         if (x != w && y != h && z != d)
         {
-          if (vol->cube(x,y,z).includes(threshold))
+          // skip at once the cells of a block which doesn't include the threshold
+          if (x % block_size == 0 && !vol->block(x/block_size, y/block_size, z/block_size).includes(threshold))
           {
-            if (mCubes.capacity()-mCubes.size() == 0)
-              mCubes.reserve(mCubes.size()*2);
-            mCubes.push_back( usvec3(x,y,z) );
+            int skip = w - x < block_size ? w - x : block_size;
+            x     = (unsigned short)(x + skip - 1);
+            iedge += skip - 1;
+            continue;
           }
+          if (vol->cube(x,y,z).includes(threshold))
+            slab.mCubes.push_back( usvec3(x,y,z) );
           else
             continue;
         }
 
-        if (mVerts.capacity() - mVerts.size() == 0)
-        {
-          mVerts.reserve( mVerts.size() * 2 );
-          mNorms.reserve( mNorms.size() * 2 );
-        }
-
         v0 = vol->value( x,y,z );
         fvec3 v0_coord = vol->coordinate(x, y, z);
 
@@ -135,14 +140,14 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
               t = (threshold-v0)/(v1-v0);
               VL_CHECK(t>=-0.001f && t<=1.001f)
               // emit vertex
-              mEdges[iedge].mX = (int)mVerts.size();
+              mEdges[iedge].mX = (int)slab.mVerts.size();
               // compute vertex and normal position
-              mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x + 1, y, z) * t );
+              slab.mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x + 1, y, z) * t );
               if (mHighQualityNormals)
               {
                 fvec3 n;
-                vol->normalHQ(n, mVerts.back(), dx, dy, dz);
-                mNorms.push_back(n);
+                vol->normalHQ(n, slab.mVerts.back(), dx, dy, dz);
+                slab.mNorms.push_back(n);
               }
             }
           }
@@ -158,14 +163,14 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
               t = (threshold-v0)/(v2-v0);
               VL_CHECK(t>=-0.001f && t<=1.001f)
               // emit vertex
-              mEdges[iedge].mY = (int)mVerts.size();
+              mEdges[iedge].mY = (int)slab.mVerts.size();
               // compute vertex and normal position
-              mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x, y + 1, z) * t );
+              slab.mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x, y + 1, z) * t );
               if (mHighQualityNormals)
               {
                 fvec3 n;
-                vol->normalHQ(n, mVerts.back(), dx, dy, dz);
-                mNorms.push_back(n);
+                vol->normalHQ(n, slab.mVerts.back(), dx, dy, dz);
+                slab.mNorms.push_back(n);
               }
             }
           }
@@ -181,14 +186,14 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
               t = (threshold-v0)/(v3-v0);
               VL_CHECK(t>=-0.001f && t<=1.001f)
               // emit vertex
-              mEdges[iedge].mZ = (int)mVerts.size();
+              mEdges[iedge].mZ = (int)slab.mVerts.size();
               // compute vertex and normal position
-              mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x, y, z + 1) * t );
+              slab.mVerts.push_back( v0_coord * (1.0f-t) + vol->coordinate(x, y, z + 1) * t );
               if (mHighQualityNormals)
               {
                 fvec3 n;
-                vol->normalHQ(n, mVerts.back(), dx, dy, dz);
-                mNorms.push_back(n);
+                vol->normalHQ(n, slab.mVerts.back(), dx, dy, dz);
+                slab.mNorms.push_back(n);
               }
             }
           }
@@ -198,7 +203,7 @@ void MarchingCubes::computeEdges(Volume* vol, float threshold)
   }
 }
 //------------------------------------------------------------------------------
-void MarchingCubes::processCube(int x, int y, int z, Volume* vol, float threshold)
+void MarchingCubes::processCube(int x, int y, int z, Volume* vol, float threshold, int vert0, int vert1, std::vector<IndexType>& indices)
 {
   int inner_corners = 0;
 
@@ -257,12 +262,17 @@ void MarchingCubes::processCube(int x, int y, int z, Volume* vol, float threshol
     mEdges[cell5].mZ,
   };
 
+  // the edges are indexed relatively to the slab owning their sample plane:
+  // 'vert0' is the first vertex of the slab containing the plane 'z' and 'vert1' the one of the plane 'z+1'.
+  for(int i=0; i<12; ++i)
+  {
+    if (edge_ivert[i] >= 0)
+      edge_ivert[i] += (i >= 4 && i < 8) ? vert1 : vert0;
+  }
+
   int ivertex;
   for(int icorner = 0; mTriangleConnectionTable[inner_corners][icorner]>=0; icorner+=3)
   {
-    if (mIndices.capacity() - mIndices.size() == 0)
-      mIndices.reserve( mIndices.size()*2 );
-
     ivertex = mTriangleConnectionTable[inner_corners][icorner+0];
     int a = edge_ivert[ivertex];
 
@@ -279,18 +289,9 @@ void MarchingCubes::processCube(int x, int y, int z, Volume* vol, float threshol
     if (a==b||b==c||c==a)
       continue;
 
-    #if 0
-      // skip degenerate tris #2
-      fvec3 v0 = mVerts[a];
-      fvec3 v1 = mVerts[b] - v0;
-      fvec3 v2 = mVerts[c] - v1;
-      if (cross(v2,v1).isNull())
-        continue;
-    #endif
-
-    mIndices.push_back((IndexType)a);
-    mIndices.push_back((IndexType)b);
-    mIndices.push_back((IndexType)c);
+    indices.push_back((IndexType)a);
+    indices.push_back((IndexType)b);
+    indices.push_back((IndexType)c);
   }
 }
 //------------------------------------------------------------------------------
@@ -300,88 +301,130 @@ void MarchingCubes::reset()
   mNormsArray->clear();
   mColorArray->clear();
   mDrawElements->indexBuffer()->clear();
-  mIndices.clear();
-  mVerts.clear();
-  mNorms.clear();
-  mColors.clear();
-  mCubes.clear();
+  mSlabs.clear();
   mEdges.clear();
   mVolumeInfo.clear();
 }
 //------------------------------------------------------------------------------
 void MarchingCubes::run(bool generate_colors)
 {
-  mVerts.clear();
-  mNorms.clear();
-  mIndices.clear();
-  mVerts.reserve(1024);
-  mNorms.reserve(1024);
-  mColors.reserve(1024);
-  mIndices.reserve(1024);
-
   /*Time time; time.start();*/
 
+  int slab_used   = 0;
+  int vert_count  = 0;
+  int index_count = 0;
+
   for(int ivol=0; ivol<mVolumeInfo.size(); ++ivol)
   {
-    Volume* vol     = mVolumeInfo.at(ivol)->volume();
+    Volume* vol     = mInteractive ? mVolumeInfo.at(ivol)->volume()->downsampled() : mVolumeInfo.at(ivol)->volume();
     float threshold = mVolumeInfo.at(ivol)->threshold();
-    int start       = (int)mVerts.size();
+    int start       = vert_count;
 
     if (vol->dataIsDirty())
       vol->setupInternalData();
 
-    // note: this function takes the 90% of the time
-    computeEdges(vol, threshold);
+    // split the sample planes in slabs, a few per thread to balance the load
+    int planes     = vol->slices().z();
+    int slab_count = mThreadCount > 1 ? mThreadCount * 4 : 1;
+    if (slab_count > planes)
+      slab_count = planes;
+    if ((int)mSlabs.size() < slab_used + slab_count)
+      mSlabs.resize(slab_used + slab_count);
+    Slab* slabs = &mSlabs[slab_used];
+    for(int islab=0; islab<slab_count; ++islab)
+    {
+      slabs[islab].mZBegin = planes *  islab    / slab_count;
+      slabs[islab].mZEnd   = planes * (islab+1) / slab_count;
+    }
 
-    // note: this loop takes the remaining 10% of the time
-    //// the z->y->x order is important in order to minimize cache misses
-    //for(int z = 0; z < mVolume->slices().z()-1; ++z)
-    //  for(int y = 0; y < mVolume->slices().y()-1; ++y)
-    //    for(int x = 0; x < mVolume->slices().x()-1; ++x)
-    //      if(vol->cube(x,y,z).includes(threshold))
-    //        processCube(x, y, z, vol, threshold);
+    mEdges.resize(vol->slices().x() * vol->slices().y() * vol->slices().z());
 
-    for(unsigned int i=0; i<mCubes.size(); ++i)
-      processCube(mCubes[i].x(), mCubes[i].y(), mCubes[i].z(), vol, threshold);
+    // note: this pass takes the 90% of the time
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(mThreadCount > 1)
+    #endif
+    for(int islab=0; islab<slab_count; ++islab)
+      computeEdges(vol, threshold, slabs[islab]);
 
-    int count = (int)mVerts.size() - start;
-    mVolumeInfo.at(ivol)->setVert0(start);
-    mVolumeInfo.at(ivol)->setVertC(count);
+    // the vertices of the slabs are concatenated in order
+    for(int islab=0; islab<slab_count; ++islab)
+    {
+      slabs[islab].mVert0 = vert_count;
+      vert_count += (int)slabs[islab].mVerts.size();
+    }
 
-    // fill color array
-    if (generate_colors)
+    // note: this pass takes the remaining 10% of the time
+    // the cubes on the last plane of a slab use the edges emitted by the next slab
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(mThreadCount > 1)
+    #endif
+    for(int islab=0; islab<slab_count; ++islab)
     {
-      mColors.resize( mVerts.size() );
-      for(int i=start; i<start+count; ++i)
-        mColors[i] = mVolumeInfo.at(ivol)->color();
+      Slab& slab = slabs[islab];
+      int next_vert0 = islab+1 < slab_count ? slabs[islab+1].mVert0 : vert_count;
+      for(unsigned int i=0; i<slab.mCubes.size(); ++i)
+      {
+        const usvec3& cube = slab.mCubes[i];
+        int vert1 = cube.z()+1 < slab.mZEnd ? slab.mVert0 : next_vert0;
+        processCube(cube.x(), cube.y(), cube.z(), vol, threshold, slab.mVert0, vert1, slab.mIndices);
+      }
     }
+
+    for(int islab=0; islab<slab_count; ++islab)
+    {
+      slabs[islab].mIndex0 = index_count;
+      index_count += (int)slabs[islab].mIndices.size();
+    }
+
+    mVolumeInfo.at(ivol)->setVert0(start);
+    mVolumeInfo.at(ivol)->setVertC(vert_count - start);
+
+    slab_used += slab_count;
   }
 
-  mVertsArray->resize(mVerts.size());
-  mVertsArray->setBufferObjectDirty();
-  if (mVerts.size())
-    memcpy(mVertsArray->ptr(), &mVerts[0], sizeof(mVerts[0]) * mVerts.size());
+  // concatenate the slabs into the final arrays
 
-  mNormsArray->resize(mNorms.size());
+  mVertsArray->resize(vert_count);
+  mVertsArray->setBufferObjectDirty();
+  mNormsArray->resize(mHighQualityNormals ? vert_count : 0);
   mNormsArray->setBufferObjectDirty();
-  if (mNorms.size())
-    memcpy(mNormsArray->ptr(), &mNorms[0], sizeof(mNorms[0]) * mNorms.size());
+  mDrawElements->indexBuffer()->resize(index_count);
+  mDrawElements->indexBuffer()->setBufferObjectDirty(true);
+  IndexType* index_ptr = (IndexType*)mDrawElements->indexBuffer()->ptr();
+
+  #ifdef _OPENMP
+  #pragma omp parallel for num_threads(mThreadCount) if(mThreadCount > 1)
+  #endif
+  for(int islab=0; islab<slab_used; ++islab)
+  {
+    const Slab& slab = mSlabs[islab];
+    if (slab.mVerts.size())
+      memcpy(mVertsArray->ptr() + sizeof(fvec3) * slab.mVert0, &slab.mVerts[0], sizeof(slab.mVerts[0]) * slab.mVerts.size());
+    if (slab.mNorms.size())
+      memcpy(mNormsArray->ptr() + sizeof(fvec3) * slab.mVert0, &slab.mNorms[0], sizeof(slab.mNorms[0]) * slab.mNorms.size());
+    if (slab.mIndices.size())
+      memcpy(index_ptr + slab.mIndex0, &slab.mIndices[0], sizeof(slab.mIndices[0]) * slab.mIndices.size());
+  }
+
+  // release the memory of the slabs not used by this run
+  mSlabs.resize(slab_used);
 
+  // fill color array
   if (generate_colors)
   {
-    mColorArray->resize(mColors.size());
+    mColorArray->resize(vert_count);
     mColorArray->setBufferObjectDirty();
-    if (mColors.size())
-      memcpy(mColorArray->ptr(), &mColors[0], sizeof(mColors[0]) * mColors.size());
+    for(int ivol=0; ivol<mVolumeInfo.size(); ++ivol)
+    {
+      int start = mVolumeInfo.at(ivol)->vert0();
+      int count = mVolumeInfo.at(ivol)->vertC();
+      for(int i=start; i<start+count; ++i)
+        mColorArray->at(i) = mVolumeInfo.at(ivol)->color();
+    }
   }
   else
     mColorArray->clear();
 
-  mDrawElements->indexBuffer()->resize(mIndices.size());
-  mDrawElements->indexBuffer()->setBufferObjectDirty(true);
-  if (mIndices.size())
-    memcpy(mDrawElements->indexBuffer()->ptr(), &mIndices[0], sizeof(mIndices[0]) * mIndices.size());
-
   if (!mHighQualityNormals)
   {
     ref<Geometry> geom = new Geometry;
@@ -501,6 +544,13 @@ ref<Volume> Volume::downsample() const
   return vol;
 }
 //------------------------------------------------------------------------------
+Volume* Volume::downsampled()
+{
+  if (!mDownsampled)
+    mDownsampled = downsample();
+  return mDownsampled.get();
+}
+//------------------------------------------------------------------------------
 void Volume::setupInternalData()
 {
   mDataIsDirty = false;
@@ -536,6 +586,33 @@ void Volume::setupInternalData()
       }
     }
   }
+
+  // compute the per block minimum and maximum values
+  mBlockSlices = ivec3( (w+blockSize()-1)/blockSize(), (h+blockSize()-1)/blockSize(), (d+blockSize()-1)/blockSize() );
+  mBlocks.resize( mBlockSlices.x()*mBlockSlices.y()*mBlockSlices.z() );
+  for(int bz = 0; bz < mBlockSlices.z(); ++bz)
+  {
+    for(int by = 0; by < mBlockSlices.y(); ++by)
+    {
+      for(int bx = 0; bx < mBlockSlices.x(); ++bx)
+      {
+        Cube& block = mBlocks[ bx + mBlockSlices.x()*by + mBlockSlices.x()*mBlockSlices.y()*bz ];
+        block = cube(bx*blockSize(), by*blockSize(), bz*blockSize());
+        for(int z = bz*blockSize(); z < (bz+1)*blockSize() && z < d; ++z)
+        {
+          for(int y = by*blockSize(); y < (by+1)*blockSize() && y < h; ++y)
+          {
+            for(int x = bx*blockSize(); x < (bx+1)*blockSize() && x < w; ++x)
+            {
+              const Cube& c = cube(x,y,z);
+              if (block.mMin > c.mMin) block.mMin = c.mMin;
+              if (block.mMax < c.mMax) block.mMax = c.mMax;
+            }
+          }
+        }
+      }
+    }
+  }
 }
 //------------------------------------------------------------------------------
 void Volume::setup( float* data, bool use_directly, bool copy_data, const fvec3& bottom_left, const fvec3& top_right, const ivec3& slices )
@@ -570,6 +647,7 @@ void Volume::setup( float* data, bool use_directly, bool copy_data, const fvec3&
   mMaximum = -1;
   mAverage = 0;
   mDataIsDirty = true;
+  mDownsampled = NULL;
 }
 //------------------------------------------------------------------------------
 void Volume::setup(const Volume& volume)
@@ -579,6 +657,7 @@ void Volume::setup(const Volume& volume)
   mMaximum = -1;
   mAverage = 0;
   mDataIsDirty = true;
+  mDownsampled = NULL;
 }
 //------------------------------------------------------------------------------
 float Volume::sampleNearest(float x, float y, float z) const
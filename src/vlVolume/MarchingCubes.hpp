@@ -127,6 +127,25 @@ namespace vl
       return mCubes[ x + y*(slices().x()-1) + z*(slices().x()-1)*(slices().y()-1) ];
     }
 
+    //! Returns the minimum and maximum values of the blockSize() x blockSize() x blockSize() cells of the given block.
+    //! MarchingCubes uses the blocks to skip at once the regions of the volume not crossed by the isosurface.
+    const Volume::Cube& block(int x, int y, int z) const
+    {
+      VL_CHECK(x<blockSlices().x())
+      VL_CHECK(y<blockSlices().y())
+      VL_CHECK(z<blockSlices().z())
+      return mBlocks[ x + y*blockSlices().x() + z*blockSlices().x()*blockSlices().y() ];
+    }
+
+    //! The number of blocks along x, y and z, see block().
+    const ivec3& blockSlices() const { return mBlockSlices; }
+
+    //! The number of cells along each side of a block, see block().
+    static int blockSize() { return 8; }
+
+    //! Returns a half resolution version of the volume computed with downsample(), cached until the next setDataDirty() or setup().
+    Volume* downsampled();
+
     //! Returns the x/y/z size of a cell
     const fvec3& cellSize() const { return mCellSize; }
 
@@ -134,7 +153,7 @@ namespace vl
     bool dataIsDirty() const { return mDataIsDirty; }
 
     //! Notifies that the data of a Volume has changed and that the internal acceleration structures should be recomputed.
-    void setDataDirty() { mDataIsDirty = true; }
+    void setDataDirty() { mDataIsDirty = true; mDownsampled = NULL; }
 
     void setupInternalData();
 
@@ -152,6 +171,9 @@ namespace vl
     bool mDataIsDirty;
 
     std::vector<Cube> mCubes;
+    std::vector<Cube> mBlocks;
+    ivec3 mBlockSlices;
+    ref<Volume> mDownsampled;
   };
   //------------------------------------------------------------------------------
   // VolumeInfo
@@ -241,6 +263,27 @@ namespace vl
     //! Select hight quality normals for best rendering quality, select low quality normals for best performances.
     bool highQualityNormals() const { return mHighQualityNormals; }
 
+    /** The number of threads used by run() to extract the isosurfaces.
+      * Each volume is split along Z in slabs of sample planes which are processed concurrently into their own buffers,
+      * the edges shared between adjacent slabs are resolved after all the slabs have computed their vertices and the results
+      * are then concatenated in the same order as the single threaded run, so the generated geometry does not depend on the thread count.
+      * Requires VL to be compiled with OpenMP support (CMake option VL_OPENMP), otherwise the value is ignored. Defaults to 1. */
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+
+    /** The number of threads used by run() to extract the isosurfaces, see setThreadCount(). */
+    int threadCount() const { return mThreadCount; }
+
+    /** When enabled run() extracts the isosurfaces from the half resolution volumes returned by Volume::downsampled(),
+      * generating roughly a quarter of the triangles in a fraction of the time. Enable it while the thresholds are being
+      * changed interactively, then disable it and call run() again once the interaction is over to refine the isosurfaces. */
+    void setInteractive(bool interactive) { mInteractive = interactive; }
+
+    /** Whether run() extracts the isosurfaces from the half resolution volumes, see setInteractive(). */
+    bool interactive() const { return mInteractive; }
+
+    //! The triangle table: 256 rows of 16 values, one per cube configuration, each listing up to 5 triangles as triplets of edge indices terminated by -1.
+    static const int* triangleConnectionTable() { return &mTriangleConnectionTable[0][0]; }
+
   public:
     ref<ArrayFloat3> mVertsArray;
     ref<ArrayFloat3> mNormsArray;
@@ -253,21 +296,31 @@ namespace vl
     ref<DrawElementsUShort> mDrawElements;
 #endif
 
-  protected:
-    void computeEdges(Volume*, float threshold);
-    void processCube(int x, int y, int z, Volume* vol, float threshold);
-
   private:
-    std::vector<fvec3> mVerts;
-    std::vector<fvec3> mNorms;
-    std::vector<fvec4> mColors;
-
 #if defined(VL_OPENGL)
     typedef unsigned int IndexType;
 #else
     typedef unsigned short IndexType;
 #endif
-    std::vector<IndexType> mIndices;
+
+    //! The output of a range of Z sample planes of a volume, see setThreadCount().
+    struct Slab
+    {
+      Slab(): mZBegin(0), mZEnd(0), mVert0(0), mIndex0(0) {}
+      std::vector<fvec3> mVerts;
+      std::vector<fvec3> mNorms;
+      std::vector<IndexType> mIndices;
+      std::vector<usvec3> mCubes;
+      int mZBegin, mZEnd;
+      int mVert0, mIndex0;
+    };
+
+  protected:
+    void computeEdges(Volume*, float threshold, Slab& slab);
+    void processCube(int x, int y, int z, Volume* vol, float threshold, int vert0, int vert1, std::vector<IndexType>& indices);
+
+  private:
+    std::vector<Slab> mSlabs;
 
     struct Edge
     {
@@ -275,9 +328,10 @@ namespace vl
       int mX, mY, mZ;
     };
     std::vector<Edge>  mEdges;
-    std::vector<usvec3> mCubes;
     Collection<VolumeInfo> mVolumeInfo;
     bool mHighQualityNormals;
+    bool mInteractive;
+    int mThreadCount;
 
   protected:
     static const int mTriangleConnectionTable[256][16];
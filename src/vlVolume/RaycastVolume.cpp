@@ -65,6 +65,11 @@ using namespace vl;
 RaycastVolume::RaycastVolume()
 {
   VL_DEBUG_SET_OBJECT_NAME()
+  mEmptySpaceSkipping = false;
+  mBrickSize = 8;
+  mEarlyTerminationOpacity = 0.99f;
+  mAdaptiveStepMax = 1.0f;
+
   // box geometry
   mGeometry = new Geometry;
 
@@ -105,7 +110,9 @@ RaycastVolume::RaycastVolume()
  *   These light values are computed based on the lights stored in RaycastVolume::lights().
  * - The \p "uniform vec3 eye_position" variable contains the camera position in object space, useful to compute
  *   specular highlights, raycast direction etc.
- * - The \p "uniform vec3 eye_look" variable contains the camera look vector in object space. */
+ * - The \p "uniform vec3 eye_look" variable contains the camera look vector in object space.
+ * - The \p "empty_space_skipping", \p "brick_size", \p "early_termination" and \p "adaptive_step_max" uniforms are set
+ *   from setEmptySpaceSkippingEnabled(), setBrickSize(), setEarlyTerminationOpacity() and setAdaptiveStepMax(). */
 void RaycastVolume::updateUniforms( vl::Actor*actor, vl::real, const vl::Camera* camera, vl::Renderable*, const vl::Shader* shader )
 {
   const GLSLProgram* glsl = shader->getGLSLProgram();
@@ -191,6 +198,16 @@ void RaycastVolume::updateUniforms( vl::Actor*actor, vl::real, const vl::Camera*
 
   // Compute gradient delta: 0.25 seems to produce better results than 0.5.
   actor->gocUniform( "gradient_delta" )->setUniform( fvec3( 0.25f / tex->width(), 0.25f / tex->height(), 0.25f / tex->depth() ) );
+
+  // empty space skipping and early ray termination
+  if ( glsl->getUniformLocation( "empty_space_skipping" ) != -1 )
+    actor->gocUniform( "empty_space_skipping" )->setUniformI( mEmptySpaceSkipping ? 1 : 0 );
+  if ( glsl->getUniformLocation( "brick_size" ) != -1 )
+    actor->gocUniform( "brick_size" )->setUniformI( mBrickSize );
+  if ( glsl->getUniformLocation( "early_termination" ) != -1 )
+    actor->gocUniform( "early_termination" )->setUniformF( mEarlyTerminationOpacity );
+  if ( glsl->getUniformLocation( "adaptive_step_max" ) != -1 )
+    actor->gocUniform( "adaptive_step_max" )->setUniformF( mAdaptiveStepMax );
 }
 //-----------------------------------------------------------------------------
 void RaycastVolume::bindActor( Actor* actor )
@@ -86,12 +86,46 @@ namespace vl
     const std::vector< ref<Light> >& lights() const { return mLights; }
     std::vector< ref<Light> >& lights() { return mLights; }
 
+    /** Enables empty space skipping in the raycast shaders supporting it (\p "uniform bool empty_space_skipping").
+    The isosurface and MIP shaders skip the bricks whose value range, read from the \p "minmax_texunit" sampler generated with genMinMaxBricks(),
+    cannot contribute to the image, while \p volume_raycast_dvr.fs skips the bricks marked as empty in the \p "occupancy_texunit" sampler
+    generated with genOccupancyBricks(). Disabled by default. */
+    void setEmptySpaceSkippingEnabled( bool enabled ) { mEmptySpaceSkipping = enabled; }
+
+    /** Whether empty space skipping is enabled, see setEmptySpaceSkippingEnabled(). */
+    bool emptySpaceSkippingEnabled() const { return mEmptySpaceSkipping; }
+
+    /** The brick size passed to genMinMaxBricks() or genOccupancyBricks() (\p "uniform int brick_size"). Defaults to 8. */
+    void setBrickSize( int size ) { mBrickSize = size; }
+
+    /** The brick size passed to genMinMaxBricks() or genOccupancyBricks(). */
+    int brickSize() const { return mBrickSize; }
+
+    /** The accumulated opacity at which the front to back shaders stop marching the ray (\p "uniform float early_termination").
+    Defaults to 0.99, 0 disables early ray termination. */
+    void setEarlyTerminationOpacity( float opacity ) { mEarlyTerminationOpacity = opacity; }
+
+    /** The accumulated opacity at which the front to back shaders stop marching the ray. */
+    float earlyTerminationOpacity() const { return mEarlyTerminationOpacity; }
+
+    /** The maximum multiple of the sample step used by \p volume_raycast_dvr.fs while crossing transparent samples (\p "uniform float adaptive_step_max").
+    The step grows by one sample step for every consecutive transparent sample and returns to the base step at the first visible one.
+    Defaults to 1, i.e. constant sample step. */
+    void setAdaptiveStepMax( float max_step ) { mAdaptiveStepMax = max_step; }
+
+    /** The maximum multiple of the sample step used while crossing transparent samples. */
+    float adaptiveStepMax() const { return mAdaptiveStepMax; }
+
   protected:
     ref<Geometry> mGeometry;
     AABB mBox;
     ref<ArrayFloat3> mTexCoord;
     ref<ArrayFloat3> mVertCoord;
     std::vector< ref<Light> > mLights;
+    bool mEmptySpaceSkipping;
+    int mBrickSize;
+    float mEarlyTerminationOpacity;
+    float mAdaptiveStepMax;
   };
 }
 
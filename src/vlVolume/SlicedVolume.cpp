@@ -32,6 +32,7 @@
 #include <vlVolume/SlicedVolume.hpp>
 #include <vlGraphics/GLSL.hpp>
 #include <vlGraphics/Camera.hpp>
+#include <vlGraphics/OpenGL.hpp>
 #include <vlCore/Time.hpp>
 
 using namespace vl;
@@ -69,6 +70,10 @@ using namespace vl;
  * The updateUniforms() method also fills the \p "uniform vec3 eye_position" variable which contains the camera position in
  * object space, useful to compute specular highlights etc.
  *
+ * By default the slices are computed on the CPU and uploaded every time the camera or the Actor move. With setGPUSlicingEnabled()
+ * the geometry is instead a static set of points, one per slice, which the \p /glsl/volume_slicing.gs geometry shader intersects
+ * with the box: in this case only the \p "vl_SVCorners", \p "vl_SVTexCoords" and \p "vl_SVSliceCount" uniforms are updated every frame.
+ *
  * \sa
  * - \ref pagGuideSlicedVolume
  * - \ref pagGuideRaycastVolume
@@ -81,6 +86,8 @@ SlicedVolume::SlicedVolume()
   VL_DEBUG_SET_OBJECT_NAME()
   mActor = NULL;
   mSliceCount = 1024;
+  mGPUSliceCount = 0;
+  mGPUSlicing = false;
   mGeometry = new Geometry;
   mGeometry->setObjectName("vl::SlicedVolume");
 
@@ -183,6 +190,12 @@ void SlicedVolume::onActorRenderStarted(Actor* actor, real clock, const Camera*
     updateUniforms(actor, clock, camera, rend, shader);
   }
 
+  if (mGPUSlicing)
+  {
+    updateGPUSlices(actor, camera);
+    return;
+  }
+
   // setup geometry: generate viewport aligned slices
 
   // skip generation is actor and camera did not move
@@ -342,6 +355,62 @@ void SlicedVolume::onActorRenderStarted(Actor* actor, real clock, const Camera*
   // it does not seem to depend from camera clipping plane optimization.
 }
 //-----------------------------------------------------------------------------
+bool SlicedVolume::isGPUSlicingSupported()
+{
+  return Has_Geometry_Shader;
+}
+//-----------------------------------------------------------------------------
+void SlicedVolume::setGPUSlicingEnabled(bool enabled)
+{
+  if (mGPUSlicing == enabled)
+    return;
+
+  mGPUSlicing = enabled;
+  // regenerate the geometry of the current mode at the next rendering
+  mGPUSliceCount = 0;
+  mCache.fill(0);
+  mGeometry->setBoundingBox( mBox );
+  mGeometry->setBoundingSphere( mBox );
+}
+//-----------------------------------------------------------------------------
+void SlicedVolume::updateGPUSlices(Actor* actor, const Camera* camera)
+{
+  // the static points are regenerated only when the number of slices changes
+  int slice_count = sliceCount() ? sliceCount() : vl::max( camera->viewport()->width(), camera->viewport()->height() );
+  if (slice_count != mGPUSliceCount)
+  {
+    mGPUSliceCount = slice_count;
+    ref<ArrayFloat3> vertex_array = new ArrayFloat3;
+    vertex_array->resize(slice_count);
+    for(int i=0; i<slice_count; ++i)
+      vertex_array->at(i) = (fvec3)box().center();
+    mGeometry->drawCalls().clear();
+    mGeometry->drawCalls().push_back( new DrawArrays(PT_POINTS, 0, slice_count) );
+    mGeometry->setVertexArray(vertex_array.get());
+    mGeometry->setTexCoordArray(0, NULL);
+    mGeometry->setDisplayListDirty(true);
+    mGeometry->setBufferObjectDirty(true);
+    // the points do not represent the extent of the slices
+    mGeometry->setBoundingBox( mBox );
+    mGeometry->setBoundingSphere( mBox );
+  }
+
+  fvec3 corners[] =
+  {
+    fvec3((float)box().minCorner().x(), (float)box().minCorner().y(), (float)box().minCorner().z()),
+    fvec3((float)box().maxCorner().x(), (float)box().minCorner().y(), (float)box().minCorner().z()),
+    fvec3((float)box().maxCorner().x(), (float)box().maxCorner().y(), (float)box().minCorner().z()),
+    fvec3((float)box().minCorner().x(), (float)box().maxCorner().y(), (float)box().minCorner().z()),
+    fvec3((float)box().minCorner().x(), (float)box().minCorner().y(), (float)box().maxCorner().z()),
+    fvec3((float)box().maxCorner().x(), (float)box().minCorner().y(), (float)box().maxCorner().z()),
+    fvec3((float)box().maxCorner().x(), (float)box().maxCorner().y(), (float)box().maxCorner().z()),
+    fvec3((float)box().minCorner().x(), (float)box().maxCorner().y(), (float)box().maxCorner().z())
+  };
+  actor->gocUniform("vl_SVCorners")->setUniform(8, corners);
+  actor->gocUniform("vl_SVTexCoords")->setUniform(8, mTexCoord);
+  actor->gocUniform("vl_SVSliceCount")->setUniformI(slice_count);
+}
+//-----------------------------------------------------------------------------
 void SlicedVolume::generateTextureCoordinates(const ivec3& img_size)
 {
   if (!img_size.x() || !img_size.y() || !img_size.z())
@@ -402,6 +471,7 @@ void SlicedVolume::setBox(const AABB& box)
   mCache.fill(0);
   mGeometry->setBoundingBox( box );
   mGeometry->setBoundingSphere( box );
-  mGeometry->setBoundsDirty(true);
+  // with GPU slicing the vertices do not represent the extent of the slices
+  mGeometry->setBoundsDirty( !mGPUSlicing );
 }
 //-----------------------------------------------------------------------------
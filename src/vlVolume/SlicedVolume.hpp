@@ -65,6 +65,18 @@ namespace vl
     //! If equal to 0 the number of slices is computed automatically as max(viewport.width, viewport.height).
     int sliceCount() const { return mSliceCount; }
 
+    //! Returns true if the current OpenGL context supports the generation of the slices on the GPU, see setGPUSlicingEnabled().
+    static bool isGPUSlicingSupported();
+
+    //! If enabled the slices are generated by a geometry shader instead of being recomputed on the CPU and uploaded every time the camera or the Actor move.
+    //! The geometry becomes a static set of points, one per slice, which the GLSLProgram must turn into the slice polygons using the
+    //! \p /glsl/volume_slicing.vs vertex shader and the \p /glsl/volume_slicing.gs geometry shader together with the usual fragment shader.
+    //! Requires geometry shaders, see isGPUSlicingSupported(). Disabled by default.
+    void setGPUSlicingEnabled(bool enabled);
+
+    //! Whether the slices are generated on the GPU, see setGPUSlicingEnabled().
+    bool gpuSlicingEnabled() const { return mGPUSlicing; }
+
     //! Returns the Geometry associated to a SlicedVolume and its bound Actor
     Geometry* geometry() { return mGeometry.get(); }
 
@@ -95,8 +107,13 @@ namespace vl
     //! Returns the currently bound actor
     Actor* actor() { return mActor; }
 
+  protected:
+    void updateGPUSlices(Actor* actor, const Camera* camera);
+
   protected:
     int mSliceCount;
+    int mGPUSliceCount;
+    bool mGPUSlicing;
     ref<Geometry> mGeometry;
     AABB mBox;
     fmat4 mCache;
@@ -84,6 +84,7 @@ VolumePlot::VolumePlot()
   mLabelFont = defFontManager()->acquireFont("/font/bitstream-vera/VeraMono.ttf", 8);
   mMinCorner = fvec3(-1,-1,-1);
   mMaxCorner = fvec3(+1,+1,+1);
+  mThreadCount = 1;
 
   // defaults
 
@@ -105,6 +106,60 @@ VolumePlot::VolumePlot()
  * \param threshold The isovalue of the isosurface passed to the MarcingCubes algorithm.
  */
 void VolumePlot::compute(const Function& func, float threshold)
+{
+  ref<Volume> volume = new Volume;
+  volume->setup( NULL, false, false, minCorner(), maxCorner(), mSamplingResolution );
+
+  evaluateFunction(volume->values(), minCorner(), maxCorner(), func);
+
+  generatePlot(volume.get(), threshold);
+}
+//-----------------------------------------------------------------------------
+/**
+ * \param gl_context The active OpenGL context used to sample the function.
+ * \param glsl_function The GLSL source or path defining <tt>float vl_VBFunction(vec3 p)</tt>.
+ * \param threshold The isovalue of the isosurface passed to the MarcingCubes algorithm.
+ */
+bool VolumePlot::computeGPU(OpenGLContext* gl_context, const String& glsl_function, float threshold)
+{
+  if ( ! GPUVolumeBaker::isSupported() )
+  {
+    Log::error("VolumePlot::computeGPU() requires OpenGL 3.0.\n");
+    return false;
+  }
+
+  if ( ! mVolumeBaker )
+    mVolumeBaker = new GPUVolumeBaker;
+
+  const ivec3& res = mSamplingResolution;
+  if ( ! mFunctionTexture || mFunctionTexture->width() != res.x() || mFunctionTexture->height() != res.y() || mFunctionTexture->depth() != res.z() )
+  {
+    mFunctionTexture = new Texture;
+    mFunctionTexture->createTexture3D( res.x(), res.y(), res.z(), TF_R32F );
+    mFunctionTexture->getTexParameter()->setMinFilter(TPF_LINEAR);
+    mFunctionTexture->getTexParameter()->setMagFilter(TPF_LINEAR);
+  }
+
+  if ( ! mVolumeBaker->sampleFunction( gl_context, glsl_function, mFunctionTexture.get(), minCorner(), maxCorner() ) )
+    return false;
+
+  // read back the samples for the MarchingCubes
+  ref<Volume> volume = new Volume;
+  volume->setup( NULL, false, false, minCorner(), maxCorner(), mSamplingResolution );
+
+#if defined(VL_OPENGL)
+  GLint prev_texture = 0;
+  glGetIntegerv( GL_TEXTURE_BINDING_3D, &prev_texture ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_3D, mFunctionTexture->handle() ); VL_CHECK_OGL();
+  glGetTexImage( GL_TEXTURE_3D, 0, GL_RED, GL_FLOAT, volume->values() ); VL_CHECK_OGL();
+  glBindTexture( GL_TEXTURE_3D, prev_texture ); VL_CHECK_OGL();
+#endif
+
+  generatePlot(volume.get(), threshold);
+  return true;
+}
+//-----------------------------------------------------------------------------
+void VolumePlot::generatePlot(Volume* volume, float threshold)
 {
   actorTreeMulti()->actors()->clear();
   mActors.clear();
@@ -127,12 +182,7 @@ void VolumePlot::compute(const Function& func, float threshold)
   mActors.push_back(mIsosurfaceActor.get());
   mActors.push_back( new Actor(box_outline.get(),mBoxEffect.get(),mPlotTransform.get()) );
 
-  ref<Volume> volume = new Volume;
-  volume->setup( NULL, false, false, minCorner(), maxCorner(), mSamplingResolution );
-
-  mc.volumeInfo()->push_back( new VolumeInfo( volume.get(), threshold ) );
-
-  evaluateFunction(volume->values(), minCorner(), maxCorner(), func);
+  mc.volumeInfo()->push_back( new VolumeInfo( volume, threshold ) );
 
   // generate vertices and polygons
   mc.run(false);
@@ -208,12 +258,16 @@ void VolumePlot::setupLabels(const String& format, const fvec3& min_corner, cons
 //-----------------------------------------------------------------------------
 void VolumePlot::evaluateFunction(float* scalar, const fvec3& min_corner, const fvec3& max_corner, const Function& func)
 {
-  fvec3 v;
   int w = mSamplingResolution.x();
   int h = mSamplingResolution.y();
   int d = mSamplingResolution.z();
+  // each z slab is evaluated by one thread
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) num_threads(mThreadCount) if(mThreadCount > 1)
+#endif
   for(int z=0; z<d; ++z)
   {
+    fvec3 v;
     float tz = (float)z/(d-1);
     v.z() = min_corner.z()*(1.0f-tz) + max_corner.z()*tz;
     for(int y=0; y<h; ++y)
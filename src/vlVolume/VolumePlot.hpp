@@ -41,6 +41,7 @@
 #include <vlGraphics/ActorTreeAbstract.hpp>
 #include <vlGraphics/SceneManagerActorTree.hpp>
 #include <vlVolume/MarchingCubes.hpp>
+#include <vlVolume/GPUVolumeBaker.hpp>
 
 namespace vl
 {
@@ -52,7 +53,8 @@ namespace vl
     VL_INSTRUMENT_CLASS(vl::VolumePlot, Object)
 
   public:
-    //! A function to be used with VolumePlot
+    //! A function to be used with VolumePlot.
+    //! When threadCount() is greater than 1 operator() is called concurrently by several threads and must be thread safe.
     class Function
     {
     public:
@@ -66,6 +68,24 @@ namespace vl
     //! Computes the function and generates the plot. This method should be called after all the other methods.
     void compute(const Function& func, float threshold);
 
+    /** Same as compute() but the function is sampled on the GPU into functionTexture(), see GPUVolumeBaker::sampleFunction().
+     * \p glsl_function is the GLSL source, or the path of a file containing it, defining <tt>float vl_VBFunction(vec3 p)</tt>.
+     * The samples are then read back to generate the isosurface, functionTexture() can also be rendered directly for example
+     * with a GPUMarchingCubes or a RaycastVolume. Must be called with \p gl_context active, returns false if the function
+     * could not be compiled or if GPUVolumeBaker is not supported. */
+    bool computeGPU(OpenGLContext* gl_context, const String& glsl_function, float threshold);
+
+    //! The 3D texture of format TF_R32F containing the samples computed by the last computeGPU().
+    Texture* functionTexture() { return mFunctionTexture.get(); }
+    //! The 3D texture of format TF_R32F containing the samples computed by the last computeGPU().
+    const Texture* functionTexture() const { return mFunctionTexture.get(); }
+
+    //! The number of threads used by compute() to evaluate the function, one slab of the grid per thread at a time. Default value: 1.
+    //! Requires VL_OPENMP, see also Function.
+    void setThreadCount(int count) { mThreadCount = count < 1 ? 1 : count; }
+    //! The number of threads used by compute() to evaluate the function.
+    int threadCount() const { return mThreadCount; }
+
     //! The Actor representing the isosurface
     const Actor* isosurfaceActor() const { return mIsosurfaceActor.get(); }
     //! The Actor representing the isosurface
@@ -131,6 +151,7 @@ namespace vl
   protected:
     void setupLabels(const String& format, const fvec3& min_corner, const fvec3& max_corner, Font* font, Transform* root_tr);
     void evaluateFunction(float* scalar, const fvec3& min_corner, const fvec3& max_corner, const Function& func);
+    void generatePlot(Volume* volume, float threshold);
 
   protected:
     std::vector< ref<Actor> > mActors;
@@ -146,6 +167,9 @@ namespace vl
     ref<Effect> mBoxEffect;
     ref<Text> mTextTemplate;
     ref<ActorTree> mActorTreeMulti;
+    ref<GPUVolumeBaker> mVolumeBaker;
+    ref<Texture> mFunctionTexture;
+    int mThreadCount;
   };
 }
 
@@ -32,6 +32,7 @@
 #include <vlVolume/VolumeUtils.hpp>
 #include <vlCore/Log.hpp>
 #include <vlCore/glsl_math.hpp>
+#include <vector>
 
 using namespace vl;
 
@@ -72,105 +73,155 @@ ref<Image> vl::genRGBAVolume(const Image* data, const Image* trfunc, bool alpha_
   return img;
 }
 //-----------------------------------------------------------------------------
-template<typename data_type, EImageType img_type>
-ref<Image> vl::genRGBAVolumeT(const Image* data, const Image* trfunc, const fvec3& light_dir, bool alpha_from_data)
+namespace
 {
-  if (!trfunc || !data)
-    return NULL;
-  if (data->format() != IF_LUMINANCE)
-  {
-    Log::error("genRGBAVolume() called with non IF_LUMINANCE data format().\n");
-    return NULL;
-  }
-  if (data->type() != img_type)
+  //! Transfer function lookup used by genRGBAVolume(), \p lum is the normalized data value.
+  inline fvec4 lookupTransferFunction(const Image* trfunc, float lum)
   {
-    Log::error("genRGBAVolume() called with invalid data type().\n");
-    return NULL;
+    float xval = lum*trfunc->width();
+    VL_CHECK(xval>=0)
+    if (xval > trfunc->width()-1.001f)
+      xval = trfunc->width()-1.001f;
+    int ix1 = (int)xval;
+    int ix2 = ix1+1;
+    VL_CHECK(ix2<trfunc->width())
+    float w21  = (float)fract(xval);
+    float w11  = 1.0f - w21;
+    fvec4 c11  = (fvec4)((const ubvec4*)trfunc->pixels())[ix1];
+    fvec4 c21  = (fvec4)((const ubvec4*)trfunc->pixels())[ix2];
+    return (c11*w11 + c21*w21)*(1.0f/255.0f);
   }
-  if (data->dimension() != ID_3D)
+
+  //! Number of entries of the transfer function lookup table, 0 means no lookup table.
+  template<typename data_type> struct TransferFunctionLUTSize { static const size_t value = 0; };
+  template<> struct TransferFunctionLUTSize<unsigned char>    { static const size_t value = 256; };
+  template<> struct TransferFunctionLUTSize<unsigned short>   { static const size_t value = 65536; };
+
+  //! Precomputes lookupTransferFunction() for every possible value of 8 and 16 bits data, float data is looked up voxel by voxel.
+  template<typename data_type>
+  class TransferFunctionLUT
   {
-    Log::error("genRGBAVolume() called with non 3D data.\n");
-    return NULL;
-  }
-  if (trfunc->dimension() != ID_1D)
+  public:
+    TransferFunctionLUT(const Image* trfunc, float normalizer_num): mTrFunc(trfunc), mNormalizer(normalizer_num)
+    {
+      mLUT.resize( TransferFunctionLUTSize<data_type>::value );
+      for(size_t i=0; i<mLUT.size(); ++i)
+        mLUT[i] = lookupTransferFunction(trfunc, (data_type)i * normalizer_num);
+    }
+
+    fvec4 operator()(data_type val) const
+    {
+      if (mLUT.empty())
+        return lookupTransferFunction(mTrFunc, val * mNormalizer);
+      else
+        return mLUT[(size_t)val];
+    }
+
+  private:
+    std::vector<fvec4> mLUT;
+    const Image* mTrFunc;
+    float mNormalizer;
+  };
+
+  //! Checks the parameters of genRGBAVolumeT().
+  bool checkRGBAVolumeParams(const Image* data, const Image* trfunc, EImageType img_type)
   {
-    Log::error("genRGBAVolume() transfer function image must be an 1D image.\n");
-    return NULL;
+    if (!trfunc || !data)
+      return false;
+    if (data->format() != IF_LUMINANCE)
+    {
+      Log::error("genRGBAVolume() called with non IF_LUMINANCE data format().\n");
+      return false;
+    }
+    if (data->type() != img_type)
+    {
+      Log::error("genRGBAVolume() called with invalid data type().\n");
+      return false;
+    }
+    if (data->dimension() != ID_3D)
+    {
+      Log::error("genRGBAVolume() called with non 3D data.\n");
+      return false;
+    }
+    if (trfunc->dimension() != ID_1D)
+    {
+      Log::error("genRGBAVolume() transfer function image must be an 1D image.\n");
+      return false;
+    }
+    if (trfunc->format() != IF_RGBA)
+    {
+      Log::error("genRGBAVolume() transfer function format() must be IF_RGBA.\n");
+      return false;
+    }
+    if (trfunc->type() != IT_UNSIGNED_BYTE)
+    {
+      Log::error("genRGBAVolume() transfer function format() must be IT_UNSIGNED_BYTE.\n");
+      return false;
+    }
+    return true;
   }
-  if (trfunc->format() != IF_RGBA)
+
+  float dataNormalizer(EImageType type)
   {
-    Log::error("genRGBAVolume() transfer function format() must be IF_RGBA.\n");
-    return NULL;
+    switch(type)
+    {
+      case IT_UNSIGNED_BYTE:  return 1.0f/255.0f;
+      case IT_UNSIGNED_SHORT: return 1.0f/65535.0f;
+      case IT_FLOAT:          return 1.0f;
+      default:                return 0;
+    }
   }
-  if (trfunc->type() != IT_UNSIGNED_BYTE)
-  {
-    Log::error("genRGBAVolume() transfer function format() must be IT_UNSIGNED_BYTE.\n");
+}
+//-----------------------------------------------------------------------------
+template<typename data_type, EImageType img_type>
+ref<Image> vl::genRGBAVolumeT(const Image* data, const Image* trfunc, const fvec3& light_dir, bool alpha_from_data)
+{
+  if (!checkRGBAVolumeParams(data, trfunc, img_type))
     return NULL;
-  }
 
-  float normalizer_num = 0;
-  switch(data->type())
-  {
-    case IT_UNSIGNED_BYTE:  normalizer_num = 1.0f/255.0f;   break;
-    case IT_UNSIGNED_SHORT: normalizer_num = 1.0f/65535.0f; break;
-    case IT_FLOAT:          normalizer_num = 1.0f;          break;
-    default:
-      break;
-  }
+  const float normalizer_num = dataNormalizer(data->type());
+  const TransferFunctionLUT<data_type> lut(trfunc, normalizer_num);
 
   // light normalization
   fvec3 L = light_dir;
   L.normalize();
-  int w = data->width();
-  int h = data->height();
-  int d = data->depth();
-  int pitch = data->pitch();
+  const int w = data->width();
+  const int h = data->height();
+  const int d = data->depth();
+  const size_t pitch = data->pitch();
   const unsigned char* lum_px = data->pixels();
   // generated volume
   ref<Image> volume = new Image( w, h, d, 1, IF_RGBA, IT_UNSIGNED_BYTE );
-  ubvec4* rgba_px = (ubvec4*)volume->pixels();
+  ubvec4* volume_px = (ubvec4*)volume->pixels();
+
+  // the slices are independent from each other
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(d > 1)
+#endif
   for(int z=0; z<d; ++z)
   {
-    int z1 = z-1;
-    int z2 = z+1;
-    z1 = clamp(z1, 0, d-1);
-    z2 = clamp(z2, 0, d-1);
+    const int z1 = clamp(z-1, 0, d-1);
+    const int z2 = clamp(z+1, 0, d-1);
+    ubvec4* rgba_px = volume_px + (size_t)w*h*z;
     for(int y=0; y<h; ++y)
     {
-      int y1 = y-1;
-      int y2 = y+1;
-      y1 = clamp(y1, 0, h-1);
-      y2 = clamp(y2, 0, h-1);
+      const int y1 = clamp(y-1, 0, h-1);
+      const int y2 = clamp(y+1, 0, h-1);
+      const data_type* row    = (const data_type*)(lum_px + y *pitch + z *pitch*h);
+      const data_type* row_y1 = (const data_type*)(lum_px + y1*pitch + z *pitch*h);
+      const data_type* row_y2 = (const data_type*)(lum_px + y2*pitch + z *pitch*h);
+      const data_type* row_z1 = (const data_type*)(lum_px + y *pitch + z1*pitch*h);
+      const data_type* row_z2 = (const data_type*)(lum_px + y *pitch + z2*pitch*h);
       for(int x=0; x<w; ++x, ++rgba_px)
       {
-        // value
-        float lum = (*(data_type*)(lum_px + x*sizeof(data_type) + y*pitch + z*pitch*h)) * normalizer_num;
         // value -> transfer function
-        float xval = lum*trfunc->width();
-        VL_CHECK(xval>=0)
-        if (xval > trfunc->width()-1.001f)
-          xval = trfunc->width()-1.001f;
-        int ix1 = (int)xval;
-        int ix2 = ix1+1;
-        VL_CHECK(ix2<trfunc->width())
-        float w21  = (float)fract(xval);
-        float w11  = 1.0f - w21;
-        fvec4 c11  = (fvec4)((ubvec4*)trfunc->pixels())[ix1];
-        fvec4 c21  = (fvec4)((ubvec4*)trfunc->pixels())[ix2];
-        fvec4 rgba = (c11*w11 + c21*w21)*(1.0f/255.0f);
+        float lum  = row[x] * normalizer_num;
+        fvec4 rgba = lut(row[x]);
 
         // bake the lighting
-        int x1 = x-1;
-        int x2 = x+1;
-        x1 = clamp(x1, 0, w-1);
-        x2 = clamp(x2, 0, w-1);
-        data_type vx1 = (*(data_type*)(lum_px + x1*sizeof(data_type) + y *pitch + z *pitch*h));
-        data_type vx2 = (*(data_type*)(lum_px + x2*sizeof(data_type) + y *pitch + z *pitch*h));
-        data_type vy1 = (*(data_type*)(lum_px + x *sizeof(data_type) + y1*pitch + z *pitch*h));
-        data_type vy2 = (*(data_type*)(lum_px + x *sizeof(data_type) + y2*pitch + z *pitch*h));
-        data_type vz1 = (*(data_type*)(lum_px + x *sizeof(data_type) + y *pitch + z1*pitch*h));
-        data_type vz2 = (*(data_type*)(lum_px + x *sizeof(data_type) + y *pitch + z2*pitch*h));
-        fvec3 N1(float(vx1-vx2), float(vy1-vy2), float(vz1-vz2));
+        const int x1 = clamp(x-1, 0, w-1);
+        const int x2 = clamp(x+1, 0, w-1);
+        fvec3 N1(float(row[x1]-row[x2]), float(row_y1[x]-row_y2[x]), float(row_z1[x]-row_z2[x]));
         N1.normalize();
         fvec3 N2 = -N1 * 0.15f;
         float l1 = max(dot(N1,L),0.0f);
@@ -200,87 +251,35 @@ ref<Image> vl::genRGBAVolumeT(const Image* data, const Image* trfunc, const fvec
 template<typename data_type, EImageType img_type>
 ref<Image> vl::genRGBAVolumeT(const Image* data, const Image* trfunc, bool alpha_from_data)
 {
-  if (!trfunc || !data)
-    return NULL;
-  if (data->format() != IF_LUMINANCE)
-  {
-    Log::error("genRGBAVolume() called with non IF_LUMINANCE data format().\n");
-    return NULL;
-  }
-  if (data->type() != img_type)
-  {
-    Log::error("genRGBAVolume() called with invalid data type().\n");
-    return NULL;
-  }
-  if (data->dimension() != ID_3D)
-  {
-    Log::error("genRGBAVolume() called with non 3D data.\n");
-    return NULL;
-  }
-  if (trfunc->dimension() != ID_1D)
-  {
-    Log::error("genRGBAVolume() transfer function image must be an 1D image.\n");
-    return NULL;
-  }
-  if (trfunc->format() != IF_RGBA)
-  {
-    Log::error("genRGBAVolume() transfer function format() must be IF_RGBA.\n");
+  if (!checkRGBAVolumeParams(data, trfunc, img_type))
     return NULL;
-  }
-  if (trfunc->type() != IT_UNSIGNED_BYTE)
-  {
-    Log::error("genRGBAVolume() transfer function format() must be IT_UNSIGNED_BYTE.\n");
-    return NULL;
-  }
 
-  float normalizer_num = 0;
-  switch(data->type())
-  {
-    case IT_UNSIGNED_BYTE:  normalizer_num = 1.0f/255.0f;   break;
-    case IT_UNSIGNED_SHORT: normalizer_num = 1.0f/65535.0f; break;
-    case IT_FLOAT:          normalizer_num = 1.0f;          break;
-    default:
-      break;
-  }
+  const float normalizer_num = dataNormalizer(data->type());
+  const TransferFunctionLUT<data_type> lut(trfunc, normalizer_num);
 
-  // light normalization
-  int w = data->width();
-  int h = data->height();
-  int d = data->depth();
-  int pitch = data->pitch();
+  const int w = data->width();
+  const int h = data->height();
+  const int d = data->depth();
+  const size_t pitch = data->pitch();
   const unsigned char* lum_px = data->pixels();
   // generated volume
   ref<Image> volume = new Image( w, h, d, 1, IF_RGBA, IT_UNSIGNED_BYTE );
-  ubvec4* rgba_px = (ubvec4*)volume->pixels();
+  ubvec4* volume_px = (ubvec4*)volume->pixels();
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(d > 1)
+#endif
   for(int z=0; z<d; ++z)
   {
-    int z1 = z-1;
-    int z2 = z+1;
-    z1 = clamp(z1, 0, d-1);
-    z2 = clamp(z2, 0, d-1);
+    ubvec4* rgba_px = volume_px + (size_t)w*h*z;
     for(int y=0; y<h; ++y)
     {
-      int y1 = y-1;
-      int y2 = y+1;
-      y1 = clamp(y1, 0, h-1);
-      y2 = clamp(y2, 0, h-1);
+      const data_type* row = (const data_type*)(lum_px + y*pitch + z*pitch*h);
       for(int x=0; x<w; ++x, ++rgba_px)
       {
-        // value
-        float lum = (*(data_type*)(lum_px + x*sizeof(data_type) + y*pitch + z*pitch*h)) * normalizer_num;
         // value -> transfer function
-        float xval = lum*trfunc->width();
-        VL_CHECK(xval>=0)
-        if (xval > trfunc->width()-1.001f)
-          xval = trfunc->width()-1.001f;
-        int ix1 = (int)xval;
-        int ix2 = ix1+1;
-        VL_CHECK(ix2<trfunc->width())
-        float w21  = (float)fract(xval);
-        float w11  = 1.0f - w21;
-        fvec4 c11  = (fvec4)((ubvec4*)trfunc->pixels())[ix1];
-        fvec4 c21  = (fvec4)((ubvec4*)trfunc->pixels())[ix2];
-        fvec4 rgba = (c11*w11 + c21*w21)*(1.0f/255.0f);
+        float lum  = row[x] * normalizer_num;
+        fvec4 rgba = lut(row[x]);
 
         // map pixel
         rgba_px->r() = (unsigned char)(rgba.r()*255.0f);
@@ -304,39 +303,61 @@ ref<Image> vl::genGradientNormals(const Image* in_img)
   img = img->convertType( IT_FLOAT );
   ref<Image> gradient = new Image;
   gradient->allocate3D(img->width(), img->height(), img->depth(), 1, IF_RGB, IT_FLOAT);
-  float* src_px = (float*)img->pixels();
+  const float* src_px = (const float*)img->pixels();
   fvec3* dst_px = (fvec3*)gradient->pixels();
-  int w = img->width();
-  int h = img->height();
+  const int w = img->width();
+  const int h = img->height();
+  const int d = img->depth();
+  const size_t slice = (size_t)w*h;
 
-  fvec3 A, B;
-  for(int z=0; z<gradient->depth(); ++z)
+  // the slices are independent from each other, within a row the central differences are computed
+  // component by component on contiguous buffers so that the compiler can vectorize them
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(d > 1)
+#endif
+  for(int z=0; z<d; ++z)
   {
-    for(int y=0; y<gradient->height(); ++y)
+    std::vector<float> gx(w), gy(w), gz(w);
+    // clamped coordinates
+    const int zn = z > 0   ? z-1 : 0;
+    const int zp = z < d-1 ? z+1 : d-1;
+    for(int y=0; y<h; ++y)
     {
-      for(int x=0; x<gradient->width(); ++x)
-      {
-        // clamped coordinates
-        int xp = x+1, xn = x-1;
-        int yp = y+1, yn = y-1;
-        int zp = z+1, zn = z-1;
-        if (xn<0) xn = 0;
-        if (yn<0) yn = 0;
-        if (zn<0) zn = 0;
-        if (xp>img->width() -1) xp = img->width() -1;
-        if (yp>img->height()-1) yp = img->height()-1;
-        if (zp>img->depth() -1) zp = img->depth() -1;
+      const int yn = y > 0   ? y-1 : 0;
+      const int yp = y < h-1 ? y+1 : h-1;
+      const float* row    = src_px + w*y  + slice*z;
+      const float* row_yn = src_px + w*yn + slice*z;
+      const float* row_yp = src_px + w*yp + slice*z;
+      const float* row_zn = src_px + w*y  + slice*zn;
+      const float* row_zp = src_px + w*y  + slice*zp;
+      float* GX = &gx[0];
+      float* GY = &gy[0];
+      float* GZ = &gz[0];
 
-        A.x() = src_px[xn + w*y  + w*h*z];
-        B.x() = src_px[xp + w*y  + w*h*z];
-        A.y() = src_px[x  + w*yn + w*h*z];
-        B.y() = src_px[x  + w*yp + w*h*z];
-        A.z() = src_px[x  + w*y  + w*h*zn];
-        B.z() = src_px[x  + w*y  + w*h*zp];
+      GX[0] = row[0] - row[w > 1 ? 1 : 0];
+      for(int x=1; x<w-1; ++x)
+        GX[x] = row[x-1] - row[x+1];
+      if (w > 1)
+        GX[w-1] = row[w-2] - row[w-1];
+      for(int x=0; x<w; ++x)
+        GY[x] = row_yn[x] - row_yp[x];
+      for(int x=0; x<w; ++x)
+        GZ[x] = row_zn[x] - row_zp[x];
 
-        // write normal packed into 0..1 format
-        dst_px[x + w*y + w*h*z] = (normalize(A - B) * 0.5f + 0.5f);
+      // normalization, same as fvec3::normalize()
+      for(int x=0; x<w; ++x)
+      {
+        float l = ::sqrt(GX[x]*GX[x] + GY[x]*GY[x] + GZ[x]*GZ[x]);
+        float s = l ? (float)(1.0/l) : 1.0f;
+        GX[x] *= s;
+        GY[x] *= s;
+        GZ[x] *= s;
       }
+
+      // write normal packed into 0..1 format
+      fvec3* dst_row = dst_px + w*y + slice*z;
+      for(int x=0; x<w; ++x)
+        dst_row[x] = fvec3(GX[x], GY[x], GZ[x]) * 0.5f + 0.5f;
     }
   }
   return gradient;
@@ -381,3 +402,187 @@ ref<Image> vl::genGradientNormals(const Image* img)
   return gradient;
 }
 #endif
+//-----------------------------------------------------------------------------
+ref<Image> vl::genMinMaxBricks(const Image* in_img, int brick_size)
+{
+  if (!in_img || in_img->dimension() != ID_3D)
+  {
+    Log::error("genMinMaxBricks() called with non 3D data.\n");
+    return NULL;
+  }
+  if (brick_size < 1)
+  {
+    Log::error("genMinMaxBricks() called with invalid brick size.\n");
+    return NULL;
+  }
+
+  // normalized values as seen by the shaders
+  ref<Image> img = in_img->convertFormat( IF_LUMINANCE );
+  img = img->convertType( IT_FLOAT );
+  const float* src_px = (const float*)img->pixels();
+  int w = img->width();
+  int h = img->height();
+  int d = img->depth();
+
+  int bw = (w + brick_size - 1) / brick_size;
+  int bh = (h + brick_size - 1) / brick_size;
+  int bd = (d + brick_size - 1) / brick_size;
+  ref<Image> bricks = new Image;
+  bricks->allocate3D(bw, bh, bd, 1, IF_RG, IT_FLOAT);
+  fvec2* dst_px = (fvec2*)bricks->pixels();
+
+  for(int bz=0; bz<bd; ++bz)
+  {
+    for(int by=0; by<bh; ++by)
+    {
+      for(int bx=0; bx<bw; ++bx)
+      {
+        // each brick includes the first samples of the following bricks so that the trilinear interpolation inside the brick is bounded by its range
+        int x0 = bx*brick_size, x1 = ( x0 + brick_size < w-1 ) ? x0 + brick_size : w-1;
+        int y0 = by*brick_size, y1 = ( y0 + brick_size < h-1 ) ? y0 + brick_size : h-1;
+        int z0 = bz*brick_size, z1 = ( z0 + brick_size < d-1 ) ? z0 + brick_size : d-1;
+        fvec2 range( src_px[x0 + w*y0 + w*h*z0], src_px[x0 + w*y0 + w*h*z0] );
+        for(int z=z0; z<=z1; ++z)
+        {
+          for(int y=y0; y<=y1; ++y)
+          {
+            const float* row = src_px + w*y + w*h*z;
+            for(int x=x0; x<=x1; ++x)
+            {
+              if (row[x] < range.x()) range.x() = row[x];
+              if (row[x] > range.y()) range.y() = row[x];
+            }
+          }
+        }
+        dst_px[bx + bw*by + bw*bh*bz] = range;
+      }
+    }
+  }
+  return bricks;
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::genOccupancyBricks(const Image* minmax, const Image* trfunc, float alpha_threshold)
+{
+  if (!minmax || minmax->dimension() != ID_3D || minmax->format() != IF_RG || minmax->type() != IT_FLOAT)
+  {
+    Log::error("genOccupancyBricks() the min/max image must be generated by genMinMaxBricks().\n");
+    return NULL;
+  }
+  if (!trfunc || trfunc->dimension() != ID_1D || trfunc->format() != IF_RGBA || trfunc->type() != IT_UNSIGNED_BYTE)
+  {
+    Log::error("genOccupancyBricks() transfer function image must be an 1D IF_RGBA/IT_UNSIGNED_BYTE image.\n");
+    return NULL;
+  }
+
+  // prefix count of the transfer function entries above the threshold: a range is occupied if it contains at least one of them
+  const ubvec4* tf_px = (const ubvec4*)trfunc->pixels();
+  int tf_size = trfunc->width();
+  std::vector<int> visible(tf_size+1, 0);
+  for(int i=0; i<tf_size; ++i)
+    visible[i+1] = visible[i] + ( tf_px[i].a() > alpha_threshold * 255.0f ? 1 : 0 );
+
+  ref<Image> occupancy = new Image;
+  occupancy->allocate3D(minmax->width(), minmax->height(), minmax->depth(), 1, IF_LUMINANCE, IT_UNSIGNED_BYTE);
+  const fvec2* src_px = (const fvec2*)minmax->pixels();
+  unsigned char* dst_px = occupancy->pixels();
+  int count = minmax->width() * minmax->height() * minmax->depth();
+  for(int i=0; i<count; ++i)
+  {
+    // the transfer function texels used by the linear filtering of the values in the range
+    int t0 = (int)floor( src_px[i].x() * tf_size - 0.5f );
+    int t1 = (int)ceil ( src_px[i].y() * tf_size - 0.5f );
+    t0 = clamp(t0, 0, tf_size-1);
+    t1 = clamp(t1, 0, tf_size-1);
+    dst_px[i] = visible[t1+1] - visible[t0] > 0 ? 255 : 0;
+  }
+  return occupancy;
+}
+//-----------------------------------------------------------------------------
+ref<Image> vl::genPreIntegrationTable(const Image* trfunc, float step_ratio)
+{
+  if (!trfunc || trfunc->dimension() != ID_1D || trfunc->format() != IF_RGBA || trfunc->type() != IT_UNSIGNED_BYTE)
+  {
+    Log::error("genPreIntegrationTable() transfer function image must be an 1D IF_RGBA/IT_UNSIGNED_BYTE image.\n");
+    return NULL;
+  }
+
+  ref<Image> table = new Image;
+  table->allocate2D(trfunc->width(), trfunc->width(), 1, IF_RGBA, IT_FLOAT);
+  if ( !updatePreIntegrationTable(table.get(), trfunc, step_ratio, 0, trfunc->width()-1) )
+    return NULL;
+  return table;
+}
+//-----------------------------------------------------------------------------
+bool vl::updatePreIntegrationTable(Image* table, const Image* trfunc, float step_ratio, int first, int last)
+{
+  if (!trfunc || trfunc->dimension() != ID_1D || trfunc->format() != IF_RGBA || trfunc->type() != IT_UNSIGNED_BYTE)
+  {
+    Log::error("updatePreIntegrationTable() transfer function image must be an 1D IF_RGBA/IT_UNSIGNED_BYTE image.\n");
+    return false;
+  }
+  const int n = trfunc->width();
+  if (!table || table->dimension() != ID_2D || table->format() != IF_RGBA || table->type() != IT_FLOAT || table->width() != n || table->height() != n)
+  {
+    Log::error("updatePreIntegrationTable() the table must be generated by genPreIntegrationTable() with a transfer function of the same size.\n");
+    return false;
+  }
+  first = clamp(first, 0, n-1);
+  last  = clamp(last,  0, n-1);
+  if (first > last)
+    return true;
+
+  // extinction coefficient and opacity weighted color of each entry, the opacities refer to the step the transfer function has been designed for
+  const ubvec4* tf_px = (const ubvec4*)trfunc->pixels();
+  std::vector<double> tau(n);
+  std::vector<dvec3> color(n);
+  for(int i=0; i<n; ++i)
+  {
+    double alpha = min(tf_px[i].a() / 255.0, 0.9999);
+    tau[i] = -::log(1.0 - alpha);
+    color[i] = dvec3(tf_px[i].r(), tf_px[i].g(), tf_px[i].b()) / 255.0;
+  }
+
+  // integrals of the piecewise linear extinction and opacity weighted color from the first entry
+  std::vector<double> T(n, 0.0);
+  std::vector<dvec3> K(n);
+  for(int i=1; i<n; ++i)
+  {
+    T[i] = T[i-1] + ( tau[i-1] + tau[i] ) * 0.5;
+    K[i] = K[i-1] + ( color[i-1]*tau[i-1] + color[i]*tau[i] ) * 0.5;
+  }
+
+  // only the segments whose value range overlaps the modified entries change
+  fvec4* table_px = (fvec4*)table->pixels();
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) if(n >= 128)
+#endif
+  for(int b=0; b<n; ++b)
+  {
+    for(int f=0; f<n; ++f)
+    {
+      if ( min(f,b) > last || max(f,b) < first )
+        continue;
+
+      double alpha = 0;
+      dvec3 rgb;
+      if (f == b)
+      {
+        // constant value along the segment: opacity correction for the step ratio
+        alpha = 1.0 - ::exp( -tau[f] * step_ratio );
+        rgb = color[f] * alpha;
+      }
+      else
+      {
+        // the extinction is averaged over the value range crossed by the segment, the color is the opacity weighted average
+        double dT = ::fabs( T[b] - T[f] );
+        alpha = 1.0 - ::exp( -dT * step_ratio / (b > f ? b - f : f - b) );
+        if (dT > 0)
+          rgb = abs( K[b] - K[f] ) * ( alpha / dT );
+      }
+      // premultiplied color, front value = x, back value = y
+      table_px[f + b*n] = fvec4( (float)rgb.r(), (float)rgb.g(), (float)rgb.b(), (float)alpha );
+    }
+  }
+
+  return true;
+}
@@ -42,7 +42,9 @@ namespace vl
    * \param trfunc An 1D Image used as transfer function that is used to assign to each value in \p data an RGBA value in the new image.
    * The Image pointed by \p trfunc must mast have type() \p IT_UNSIGNED_BYTE and format() \p IF_RGBA.
    * \param light_dir The direction of the light in object space.
-   * \param alpha_from_data If set to true the \p alpha channel of the generated image will be taken from \p data otherwise from the transfer function. */
+   * \param alpha_from_data If set to true the \p alpha channel of the generated image will be taken from \p data otherwise from the transfer function.
+   *
+   * The slices are processed in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP), see GPUVolumeBaker for a GPU implementation. */
   VLVOLUME_EXPORT ref<Image> genRGBAVolume(const Image* data, const Image* trfunc, const fvec3& light_dir, bool alpha_from_data=true);
 
   /** Generates an RGBA image based on the given data source and transfer function.
@@ -58,9 +60,36 @@ namespace vl
   /** Generates an image whose RGB components represent the normals computed from the input image gradient packed into 0..1 range.
   * The format of the image is IF_RGB/IT_FLOAT which is equivalent to a 3D grid of fvec3.
   * The generated image is ready to be used as a texture for normal lookup.
-  * The original normal can be recomputed as N = (RGB - 0.5)*2.0. */
+  * The original normal can be recomputed as N = (RGB - 0.5)*2.0.
+  * The slices are processed in parallel if VL is compiled with OpenMP support (CMake option VL_OPENMP), see GPUVolumeBaker for a GPU implementation. */
   VLVOLUME_EXPORT ref<Image> genGradientNormals(const Image* data);
 
+  /** Generates a 3D image containing the minimum and maximum value of each brick of \p brick_size x \p brick_size x \p brick_size samples of \p data.
+   * Each brick also includes the first samples of the following bricks so that the values interpolated inside a brick never exceed its range.
+   * The values are normalized as they are seen by the shaders, the format of the image is IF_RG/IT_FLOAT (red = minimum, green = maximum).
+   * The generated image is used by the raycast shaders to skip the empty space, see RaycastVolume::setEmptySpaceSkippingEnabled(). */
+  VLVOLUME_EXPORT ref<Image> genMinMaxBricks(const Image* data, int brick_size=8);
+
+  /** Generates a 3D occupancy image from the output of genMinMaxBricks() and a transfer function.
+   * A brick is occupied (255) if the transfer function assigns an alpha greater than \p alpha_threshold to at least one of the values in its range, otherwise it is empty (0).
+   * The Image pointed by \p trfunc must be an 1D image with format() IF_RGBA and type() IT_UNSIGNED_BYTE.
+   * The format of the generated image is IF_LUMINANCE/IT_UNSIGNED_BYTE, see also RaycastVolume::setEmptySpaceSkippingEnabled(). */
+  VLVOLUME_EXPORT ref<Image> genOccupancyBricks(const Image* minmax, const Image* trfunc, float alpha_threshold=0);
+
+  /** Generates the pre-integration table of a transfer function, used by \p volume_raycast_preintegrated.fs to sample the volume with larger steps without slab artifacts.
+   * The texel (front, back) contains the color and opacity accumulated along a ray segment starting at the value \p front and ending at the value \p back,
+   * assuming that the value varies linearly in between. The color is premultiplied by the opacity.
+   * The Image pointed by \p trfunc must be an 1D image with format() IF_RGBA and type() IT_UNSIGNED_BYTE, the generated image is an N x N IF_RGBA/IT_FLOAT image,
+   * N being the width of \p trfunc, and the values are mapped to the texels in the same way as in the transfer function texture.
+   * \param trfunc The transfer function.
+   * \param step_ratio The length of the ray segments divided by the sampling distance the opacities of the transfer function refer to. */
+  VLVOLUME_EXPORT ref<Image> genPreIntegrationTable(const Image* trfunc, float step_ratio=1.0f);
+
+  /** Updates the texels of a table generated by genPreIntegrationTable() after the entries from \p first to \p last of \p trfunc have been modified.
+   * Only the segments whose value range overlaps the modified entries are recomputed, which makes editing a small portion of the transfer function cheap.
+   * \p step_ratio must be the same passed to genPreIntegrationTable(). Returns false if the table doesn't match the transfer function. */
+  VLVOLUME_EXPORT bool updatePreIntegrationTable(Image* table, const Image* trfunc, float step_ratio, int first, int last);
+
   /** Internally used. */
   template<typename data_type, EImageType img_type>
   VLVOLUME_EXPORT ref<Image> genRGBAVolumeT(const Image* data, const Image* trfunc, const fvec3& light_dir, bool alpha_from_data);
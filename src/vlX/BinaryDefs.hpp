@@ -51,8 +51,20 @@ namespace vlX
     VLB_ChunkID,
     VLB_ChunkRealDouble,
     VLB_ChunkInteger,
-    VLB_ChunkBool
+    VLB_ChunkBool,
+    VLB_ChunkArrayBinary,
+    VLB_ChunkArrayBinaryAligned
   } EVLBChunkType;
+
+  //! Flags stored in the VLB header.
+  typedef enum
+  {
+    //! Binary arrays are stored in VLB_ChunkArrayBinaryAligned chunks and can be used straight from a memory mapping.
+    VLB_FlagMappable = 0x1
+  } EVLBFlags;
+
+  //! File offset alignment of the data of VLB_ChunkArrayBinaryAligned chunks.
+  const int VLB_MappableAlignment = 16;
 }
 
 #endif
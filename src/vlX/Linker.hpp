@@ -41,6 +41,8 @@ namespace vlX
   class Linker
   {
   public:
+    Linker(): mIDCount(0) {}
+
     void add(VLXTaggedValue* module)
     {
       mModules.push_back(module);
@@ -58,6 +60,8 @@ namespace vlX
       if (link_mapper.error())
         return false;
 
+      mIDCount = link_map.size();
+
       // link all the IDs to the associated VLXStructure
       VisitorLinker linker(&link_map);
       for(size_t i=0; i<mModules.size(); ++i)
@@ -73,8 +77,12 @@ namespace vlX
 
     const std::vector< vl::ref<VLXTaggedValue> >& modules() const { return mModules; }
 
+    //! The number of distinct IDs found by the last link().
+    size_t idCount() const { return mIDCount; }
+
   public:
     std::vector< vl::ref<VLXTaggedValue> > mModules;
+    size_t mIDCount;
   };
 }
 
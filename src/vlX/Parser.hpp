@@ -43,6 +43,7 @@ namespace vlX
     VL_INSTRUMENT_ABSTRACT_CLASS(vlX::Parser, vl::Object)
 
   public:
+    Parser(): mVersion(0), mIDCount(0) {}
 
     virtual bool parseHeader() = 0;
 
@@ -56,9 +57,14 @@ namespace vlX
       for(size_t i=0; i<mStructures.size(); ++i)
         linker.add(mStructures[i].get());
 
-      return linker.link();
+      bool ok = linker.link();
+      mIDCount = linker.idCount();
+      return ok;
     }
 
+    //! The number of distinct structure IDs found by the last link(), can be used to preallocate lookup tables.
+    size_t idCount() const { return mIDCount; }
+
     //! Moves the <Metadata> key/value pairs in the Metadata map for quick and easy access and removes the <Metadata> structure.
     void parseMetadata()
     {
@@ -96,6 +102,7 @@ namespace vlX
   protected:
     std::string mEncoding;
     unsigned short mVersion;
+    size_t mIDCount;
     std::vector< vl::ref<VLXStructure> > mStructures;
     std::map< std::string, VLXValue > mMetadata;
   };
@@ -35,6 +35,8 @@
 #include <vlX/Parser.hpp>
 #include <vlX/BinaryDefs.hpp>
 #include <vlX/defines.hpp>
+#include <vlCore/MappedFile.hpp>
+#include <deque>
 
 namespace vlX
 {
@@ -106,6 +108,33 @@ namespace vlX
 #endif
     }
 
+    //! Decodes exactly \p count integers from \p size bytes, returns false if the data is malformed.
+    static bool decodeIntegers(const unsigned char* in, size_t size, long long* out, size_t count)
+    {
+      const unsigned char nxt_flag = 0x80;
+      const unsigned char neg_flag = 0x40;
+      size_t i = 0;
+      for( size_t k=0; k<count; ++k )
+      {
+        if ( i >= size )
+          return false;
+        unsigned char byte = in[i++];
+        bool is_neg = (byte & neg_flag) != 0;
+        long long n = byte & 0x3F;
+        int shift = 6;
+        while(byte & nxt_flag)
+        {
+          if ( i >= size || shift > 62 )
+            return false;
+          byte = in[i++];
+          n |= (long long)(byte & 0x7F) << shift;
+          shift += 7;
+        }
+        out[k] = is_neg ? -n : n;
+      }
+      return i == size;
+    }
+
     void decodeIntegers(const std::vector<unsigned char>& in, std::vector<long long>& out)
     {
       out.reserve(in.size());
@@ -151,6 +180,7 @@ namespace vlX
       {
       public:
         CloseFileClass(vl::VirtualFile* f): mFile(f) {}
+        vl::VirtualFile* file() { return mFile.get(); }
         ~CloseFileClass()
         {
           if (mFile)
@@ -165,6 +195,8 @@ namespace vlX
 
       // clear metadata
       mMetadata.clear();
+      mPendingIntegers.clear();
+      mPendingFloats.clear();
 
       // read version and encoding
       mVersion = 0;
@@ -188,6 +220,15 @@ namespace vlX
         return false;
       }
 
+      // mappable files are read through a memory mapping so that the binary arrays can use it as storage
+      if ( (mFlags & VLB_FlagMappable) && !inputFile()->as<vl::MappedFile>() && inputFile()->as<vl::DiskFile>() )
+      {
+        vl::ref<vl::MappedFile> mapped = new vl::MappedFile;
+        if ( mapped->open(inputFile()->path(), vl::OM_ReadOnly) && mapped->seekSet(inputFile()->position()) )
+          setInputFile(mapped.get());
+      }
+      CloseFileClass CloseMappedFile(inputFile() != CloseFile.file() ? inputFile() : NULL);
+
       unsigned char chunk;
       std::string str;
 
@@ -212,6 +253,12 @@ namespace vlX
         }
       }
 
+      if (!decodePendingArrays())
+      {
+        vl::Log::error("Error parsing binary file: corrupted array data.\n");
+        return false;
+      }
+
       parseMetadata();
 
       return true;
@@ -316,24 +363,22 @@ namespace vlX
           if (!readInteger(count))
             return false;
 
-          // values
-          VLXArrayInteger& arr = *val.getArrayInteger();
+          // values: read the encoded bytes, they are decoded by decodePendingArrays()
+          if (count < 0)
+            return false;
           if (count)
           {
             long long encode_count = 0;
-            if (!readInteger(encode_count))
+            if (!readInteger(encode_count) || encode_count < count)
               return false;
-            VL_CHECK(encode_count >= 0)
-            if (encode_count)
-            {
-              std::vector<unsigned char> encoded;
-              encoded.resize((size_t)encode_count);
-              inputFile()->readUInt8(&encoded[0], encode_count);
-              decodeIntegers(encoded, arr.value());
-            }
+            mPendingIntegers.push_back( PendingIntegers() );
+            PendingIntegers& pending = mPendingIntegers.back();
+            pending.mArray = val.getArrayInteger();
+            pending.mCount = (size_t)count;
+            pending.mEncoded.resize((size_t)encode_count);
+            return inputFile()->readUInt8(&pending.mEncoded[0], encode_count) == encode_count;
           }
-          VL_CHECK((size_t)count == arr.value().size())
-          return (size_t)count == arr.value().size();
+          return true;
         }
 
       case VLB_ChunkArrayRealDouble:
@@ -382,18 +427,17 @@ namespace vlX
           long long count = 0;
           if (!readInteger(count))
             return false;
-          // values
-          VLXArrayReal& arr = *val.getArrayReal();
-          arr.value().resize( (size_t)count );
+          // values: read the floats, they are converted to doubles by decodePendingArrays()
+          if (count < 0)
+            return false;
           if (count)
           {
 #if 1
-            std::vector<float> floats;
-            floats.resize( (size_t)count );
-            long long c = inputFile()->readFloat( &floats[0], count );
-            // copy over floats to doubles
-            for(size_t i=0; i<floats.size(); ++i)
-              arr.value()[i] = floats[i];
+            mPendingFloats.push_back( PendingFloats() );
+            PendingFloats& pending = mPendingFloats.back();
+            pending.mArray = val.getArrayReal();
+            pending.mFloats.resize( (size_t)count );
+            long long c = inputFile()->readFloat( &pending.mFloats[0], count );
             VL_CHECK(c == count * (int)sizeof(float))
             return c == count * (int)sizeof(float);
 #elif 0
@@ -402,7 +446,8 @@ namespace vlX
             std::vector<unsigned char> zipped;
             zipped.resize((size_t)zsize);
             inputFile()->read(&zipped[0], zipped.size());
-            bool ok = decompress(&zipped[0], (size_t)zsize, &arr.value()[0]);
+            val.getArrayReal()->value().resize( (size_t)count );
+            bool ok = decompress(&zipped[0], (size_t)zsize, &val.getArrayReal()->value()[0]);
             VL_CHECK(ok);
             return ok;
 #endif
@@ -411,6 +456,12 @@ namespace vlX
             return true;
         }
 
+      case VLB_ChunkArrayBinary:
+        return readArrayBinary(val, false);
+
+      case VLB_ChunkArrayBinaryAligned:
+        return readArrayBinary(val, true);
+
       case VLB_ChunkRawtext:
         // tag
         if (!readString(str))
@@ -495,15 +546,129 @@ namespace vlX
       }
     }
 
+    bool readArrayBinary(VLXValue& val, bool aligned)
+    {
+      std::string str;
+      // tag
+      if (!readString(str))
+        return false;
+      else
+        val.setArrayBinary( new VLXArrayBinary( str.c_str() ) );
+      // scalar type
+      unsigned char scalar_type = 0;
+      if ( inputFile()->readUInt8(&scalar_type, 1) != 1 || !VLXArrayBinary::scalarSize((EVLXScalarType)scalar_type) )
+        return false;
+      // count
+      long long count = 0;
+      if (!readInteger(count) || count < 0)
+        return false;
+      // padding
+      if (aligned)
+      {
+        unsigned char pad = 0;
+        if ( inputFile()->readUInt8(&pad, 1) != 1 || !inputFile()->seekCur(pad) )
+          return false;
+      }
+      VLXArrayBinary& arr = *val.getArrayBinary();
+      long long bytes = count * (long long)VLXArrayBinary::scalarSize((EVLXScalarType)scalar_type);
+      // zero-copy path: the data is little endian and aligned, use the mapped pages as storage
+      unsigned short bet = 0x00FF;
+      bool little_endian_cpu = ((unsigned char*)&bet)[0] == 0xFF;
+      vl::MappedFile* mapped = inputFile()->as<vl::MappedFile>();
+      if ( aligned && little_endian_cpu && mapped && count )
+      {
+        long long offset = mapped->position();
+        unsigned char* ptr = mapped->mappedPtr(offset, bytes);
+        if ( !ptr || !mapped->seekSet(offset + bytes) )
+          return false;
+        arr.setUserAllocatedBuffer( (EVLXScalarType)scalar_type, (size_t)count, ptr, mapped->mapping() );
+        return true;
+      }
+      // values: read straight into the array storage
+      arr.allocate( (EVLXScalarType)scalar_type, (size_t)count );
+      if (!count)
+        return true;
+      void* ptr = arr.buffer()->ptr();
+      long long c = 0;
+      switch(arr.scalarType())
+      {
+      case VLX_Byte:
+      case VLX_UByte:     c = inputFile()->readUInt8 ( (unsigned char*)ptr,  count ); break;
+      case VLX_Short:
+      case VLX_UShort:
+      case VLX_HalfFloat: c = inputFile()->readUInt16( (unsigned short*)ptr, count ); break;
+      case VLX_Int:
+      case VLX_UInt:      c = inputFile()->readUInt32( (unsigned int*)ptr,   count ); break;
+      case VLX_Float:     c = inputFile()->readFloat ( (float*)ptr,          count ); break;
+      case VLX_Double:    c = inputFile()->readDouble( (double*)ptr,         count ); break;
+      }
+      VL_CHECK(c == bytes)
+      return c == bytes;
+    }
+
+    //! Decodes the integer arrays and converts the float arrays read by parse(), one array per thread.
+    bool decodePendingArrays()
+    {
+      int int_count = (int)mPendingIntegers.size();
+      int count = int_count + (int)mPendingFloats.size();
+      int failed = 0;
+#ifdef _OPENMP
+      #pragma omp parallel for schedule(dynamic) reduction(+:failed) if(count > 1)
+#endif
+      for(int i=0; i<count; ++i)
+      {
+        if (i < int_count)
+        {
+          PendingIntegers& pending = mPendingIntegers[i];
+          std::vector<long long>& out = pending.mArray->value();
+          out.resize(pending.mCount);
+          if ( !decodeIntegers(&pending.mEncoded[0], pending.mEncoded.size(), &out[0], out.size()) )
+            failed += 1;
+          std::vector<unsigned char>().swap(pending.mEncoded);
+        }
+        else
+        {
+          PendingFloats& pending = mPendingFloats[i - int_count];
+          std::vector<double>& out = pending.mArray->value();
+          out.resize(pending.mFloats.size());
+          for(size_t j=0; j<out.size(); ++j)
+            out[j] = pending.mFloats[j];
+          std::vector<float>().swap(pending.mFloats);
+        }
+      }
+      mPendingIntegers.clear();
+      mPendingFloats.clear();
+      return failed == 0;
+    }
+
+    //! The flags read from the VLB header, see EVLBFlags.
+    unsigned int flags() const { return mFlags; }
+
     void setInputFile(vl::VirtualFile* file) { mInputFile = file; }
 
     vl::VirtualFile* inputFile() { return mInputFile.get(); }
 
     const vl::VirtualFile* inputFile() const { return mInputFile.get(); }
 
+  private:
+    // arrays whose decoding is deferred to decodePendingArrays()
+    struct PendingIntegers
+    {
+      vl::ref<VLXArrayInteger> mArray;
+      std::vector<unsigned char> mEncoded;
+      size_t mCount;
+    };
+    struct PendingFloats
+    {
+      vl::ref<VLXArrayReal> mArray;
+      std::vector<float> mFloats;
+    };
+
   private:
     unsigned int mFlags;
     vl::ref<vl::VirtualFile> mInputFile;
+    std::deque<PendingIntegers> mPendingIntegers;
+    std::deque<PendingFloats> mPendingFloats;
   };
 }
 
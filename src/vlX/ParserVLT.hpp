@@ -559,8 +559,16 @@ namespace vlX
         {
           vl::ref<VLXArrayInteger> arr_integer;
           arr = arr_integer = new VLXArrayInteger;
-          do
+          arr_integer->value().push_back( atoll( mToken.mString.c_str() ) );
+          for(;;)
           {
+            // scan the numbers straight from the input buffer
+            int res = mTokenizer->readNumbers( arr_integer->value() );
+            if (res != 0)
+              return res > 0;
+            // comments and unexpected tokens go through the generic tokenizer
+            if (!getToken(mToken))
+              return false;
             switch(mToken.mType)
             {
             case VLTToken::Integer: arr_integer->value().push_back( atoll( mToken.mString.c_str() ) ); break;
@@ -569,8 +577,6 @@ namespace vlX
               return false;
             }
           }
-          while(getToken(mToken));
-          return false;
         }
         else
         if (mToken.mType == VLTToken::real)
@@ -578,17 +584,17 @@ namespace vlX
           vl::ref<VLXArrayReal> arr_floating;
           arr = arr_floating = new VLXArrayReal;
           arr_floating->value().reserve(1024);
-          // mic fixme:
-          // READING ARRAYS OF NUMBERS IS THE MAIN HOT SPOT FOR THE VLT PARSER
-          // - we could speed things up by quickly tokenizing and aotf-ing all the numbers here
-          // - we could also use a quicker atof() that works for numbers of the type +1234.1234 using the tokenizer to determine the sub-type
-          // - ideally we should mix the following:
-          //   - read big chunks of bytes instead of one by one like now
-          //   - merge the quick atof with the tokenizer in one single operation, fall back to standard atof() when complex numbers are detected
-          //   - proceed until we find ")"
-          //   - we could disallow comments in Arrays to speedup the parsing
-          do
+          arr_floating->value().push_back( atof( mToken.mString.c_str() ) );
+          for(;;)
           {
+            // reading arrays of numbers is the main hot spot of the VLT parser: scan and convert
+            // the numbers straight from the input buffer instead of producing a token for each one
+            int res = mTokenizer->readNumbers( arr_floating->value() );
+            if (res != 0)
+              return res > 0;
+            // comments and unexpected tokens go through the generic tokenizer
+            if (!getToken(mToken))
+              return false;
             switch(mToken.mType)
             {
             case VLTToken::Integer:
@@ -598,8 +604,6 @@ namespace vlX
               return false;
             }
           }
-          while(getToken(mToken));
-          return false;
         }
         else
           return false;
@@ -0,0 +1,147 @@
+/**************************************************************************************/
+/*                                                                                    */
+/*  Visualization Library                                                             */
+/*  http://visualizationlibrary.org                                                   */
+/*                                                                                    */
+/*  Copyright (c) 2005-2017, Michele Bosi                                             */
+/*  All rights reserved.                                                              */
+/*                                                                                    */
+/*  Redistribution and use in source and binary forms, with or without modification,  */
+/*  are permitted provided that the following conditions are met:                     */
+/*                                                                                    */
+/*  - Redistributions of source code must retain the above copyright notice, this     */
+/*  list of conditions and the following disclaimer.                                  */
+/*                                                                                    */
+/*  - Redistributions in binary form must reproduce the above copyright notice, this  */
+/*  list of conditions and the following disclaimer in the documentation and/or       */
+/*  other materials provided with the distribution.                                   */
+/*                                                                                    */
+/*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND   */
+/*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED     */
+/*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE            */
+/*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR  */
+/*  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES    */
+/*  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;      */
+/*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON    */
+/*  ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT           */
+/*  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS     */
+/*  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.                      */
+/*                                                                                    */
+/**************************************************************************************/
+
+
+#ifndef VLXPointerMap_INCLUDE_ONCE
+#define VLXPointerMap_INCLUDE_ONCE
+
+#include <vector>
+#include <cstddef>
+
+namespace vlX
+{
+  /**
+   * Insert-only hash map from non-NULL pointers to \p T_Value, used by the serializer and the visitors
+   * to track millions of objects without the tree rebalancing and reference counting costs of a
+   * std::map keyed by vl::ref<>. Uses open addressing with linear probing and grows at 50% load.
+   */
+  template<typename T_Value>
+  class PointerMap
+  {
+  public:
+    PointerMap(): mSize(0), mShift(0) {}
+
+    //! Returns the value associated to \p key or NULL if no such key was inserted.
+    T_Value* find(const void* key)
+    {
+      if (mSlots.empty())
+        return NULL;
+      for(size_t i = slot(key); ; i = (i + 1) & (mSlots.size() - 1))
+      {
+        if (mSlots[i].mKey == key)
+          return &mSlots[i].mValue;
+        if (mSlots[i].mKey == NULL)
+          return NULL;
+      }
+    }
+
+    //! Returns the value associated to \p key or NULL if no such key was inserted.
+    const T_Value* find(const void* key) const { return const_cast<PointerMap*>(this)->find(key); }
+
+    //! Returns the value associated to \p key, inserting a default constructed one if needed.
+    T_Value& operator[](const void* key)
+    {
+      if ( (mSize + 1) * 2 > mSlots.size() )
+        rehash( mSlots.empty() ? 16 : mSlots.size() * 2 );
+      size_t i = slot(key);
+      for( ; mSlots[i].mKey != NULL; i = (i + 1) & (mSlots.size() - 1) )
+      {
+        if (mSlots[i].mKey == key)
+          return mSlots[i].mValue;
+      }
+      mSlots[i].mKey = key;
+      ++mSize;
+      return mSlots[i].mValue;
+    }
+
+    //! Makes room for \p count keys without rehashing.
+    void reserve(size_t count)
+    {
+      size_t capacity = 16;
+      while(capacity < count * 2)
+        capacity *= 2;
+      if (capacity > mSlots.size())
+        rehash(capacity);
+    }
+
+    //! Removes all the keys and releases the memory.
+    void clear()
+    {
+      std::vector<Slot>().swap(mSlots);
+      mSize = 0;
+      mShift = 0;
+    }
+
+    size_t size() const { return mSize; }
+
+    bool empty() const { return mSize == 0; }
+
+  private:
+    struct Slot
+    {
+      Slot(): mKey(NULL), mValue() {}
+      const void* mKey;
+      T_Value mValue;
+    };
+
+    // Fibonacci hashing: the top bits of the product are well distributed even for aligned pointers
+    size_t slot(const void* key) const
+    {
+      unsigned long long h = (unsigned long long)(size_t)key * 0x9E3779B97F4A7C15ULL;
+      return (size_t)(h >> mShift);
+    }
+
+    void rehash(size_t capacity)
+    {
+      std::vector<Slot> slots(capacity);
+      mSlots.swap(slots);
+      mShift = 64;
+      for(size_t c = capacity; c > 1; c >>= 1)
+        --mShift;
+      for(size_t i=0; i<slots.size(); ++i)
+      {
+        if (slots[i].mKey == NULL)
+          continue;
+        size_t j = slot(slots[i].mKey);
+        while(mSlots[j].mKey != NULL)
+          j = (j + 1) & (mSlots.size() - 1);
+        mSlots[j] = slots[i];
+      }
+    }
+
+  private:
+    std::vector<Slot> mSlots;
+    size_t mSize;
+    int mShift;
+  };
+}
+
+#endif
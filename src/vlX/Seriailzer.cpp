@@ -139,20 +139,20 @@ bool VLXSerializer::canImport(const VLXStructure* st) const
 //-----------------------------------------------------------------------------
 void VLXSerializer::registerImportedStructure(const VLXStructure* st, Object* obj)
 {
-  VL_CHECK( mImportedStructures.find(st) == mImportedStructures.end() )
-  mImportedStructures[st] = obj;
+  VL_CHECK( mImportedStructures.find(st) == NULL )
+  mImportedStructures[st] = std::make_pair( ref<VLXStructure>(const_cast<VLXStructure*>(st)), ref<Object>(obj) );
 }
 //-----------------------------------------------------------------------------
 void VLXSerializer::registerExportedObject(const vl::Object* obj, VLXStructure* st)
 {
-  VL_CHECK(mExportedObjects.find(obj) == mExportedObjects.end())
-  mExportedObjects[obj] = st;
+  VL_CHECK(mExportedObjects.find(obj) == NULL)
+  mExportedObjects[obj] = std::make_pair( ref<Object>(const_cast<Object*>(obj)), ref<VLXStructure>(st) );
 }
 //-----------------------------------------------------------------------------
 Object* VLXSerializer::getImportedStructure(const VLXStructure* st)
 {
-  std::map< ref<VLXStructure>, ref<Object> >::iterator it = mImportedStructures.find(st);
-  if (it == mImportedStructures.end())
+  std::pair< ref<VLXStructure>, ref<Object> >* it = mImportedStructures.find(st);
+  if (it == NULL)
     return NULL;
   else
   {
@@ -163,8 +163,8 @@ Object* VLXSerializer::getImportedStructure(const VLXStructure* st)
 //-----------------------------------------------------------------------------
 VLXStructure* VLXSerializer::getExportedObject(const vl::Object* obj)
 {
-  std::map< ref<Object>, ref<VLXStructure> >::iterator it = mExportedObjects.find(obj);
-  if (it == mExportedObjects.end())
+  std::pair< ref<Object>, ref<VLXStructure> >* it = mExportedObjects.find(obj);
+  if (it == NULL)
     return NULL;
   else
   {
@@ -324,6 +324,7 @@ bool VLXSerializer::saveVLB(vl::VirtualFile* file, const vl::Object* obj, bool s
 
     VisitorExportToVLB bin_export_visitor(file);
     bin_export_visitor.setIDSet(&uid_set);
+    bin_export_visitor.setMappable(vlbMappable());
     bin_export_visitor.writeHeader();
     meta->acceptVisitor(&bin_export_visitor);
     st->acceptVisitor(&bin_export_visitor);
@@ -373,6 +374,8 @@ vl::ref<vl::Object> VLXSerializer::loadVLT(vl::VirtualFile* file, bool start_fre
     return NULL;
   }
 
+  mImportedStructures.reserve( parser.idCount() );
+
   if (parser.structures().empty())
     return NULL;
   else
@@ -417,6 +420,8 @@ ref<Object> VLXSerializer::loadVLB(vl::VirtualFile* file, bool start_fresh)
     return NULL;
   }
 
+  mImportedStructures.reserve( parser.idCount() );
+
   if (parser.structures().empty())
     return NULL;
   else
@@ -34,6 +34,7 @@
 
 #include <vlX/Registry.hpp>
 #include <vlX/Value.hpp>
+#include <vlX/PointerMap.hpp>
 #include <vlCore/String.hpp>
 #include <string>
 #include <map>
@@ -50,7 +51,7 @@ namespace vlX
     typedef enum { NoError, ImportError, ExportError, ReadError, WriteError } EError;
 
   public:
-    VLXSerializer(): mError(NoError), mIDCounter(0)
+    VLXSerializer(): mError(NoError), mIDCounter(0), mVLBMappable(false)
     {
       setRegistry( defVLXRegistry() );
     }
@@ -177,13 +178,23 @@ namespace vlX
     //! Erases all previously set directives
     void eraseAllDirectives() { mDirectives.clear(); }
 
+    //! If true saveVLB() writes a "mappable" VLB file whose binary arrays are stored uncompressed at aligned file offsets.
+    //! When such a file is loaded the arrays use the pages of a vl::MappedFile as storage instead of copying them, the pages
+    //! are released when the arrays release their local storage, for example after being uploaded with discard_local_storage.
+    void setVLBMappable(bool mappable) { mVLBMappable = mappable; }
+
+    //! If true saveVLB() writes a "mappable" VLB file, see setVLBMappable().
+    bool vlbMappable() const { return mVLBMappable; }
+
   private:
     vl::String mDocumentURL;
     std::map<std::string, std::string> mDirectives;
     EError mError;
     int mIDCounter;
-    std::map< vl::ref<VLXStructure>, vl::ref<vl::Object> > mImportedStructures; // structure --> object
-    std::map< vl::ref<vl::Object>, vl::ref<VLXStructure> > mExportedObjects;    // object --> structure
+    bool mVLBMappable;
+    // the keys are kept alive by the first element of the pair so that their addresses cannot be reused
+    PointerMap< std::pair< vl::ref<VLXStructure>, vl::ref<vl::Object> > > mImportedStructures; // structure --> object
+    PointerMap< std::pair< vl::ref<vl::Object>, vl::ref<VLXStructure> > > mExportedObjects;    // object --> structure
     std::map< std::string, VLXValue > mMetadata; // metadata to import or to export
     vl::ref<Registry> mRegistry;
   };
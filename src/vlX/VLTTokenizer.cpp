@@ -614,3 +614,219 @@ bool VLTTokenizer::getRawtextBlock(VLTToken& token)
   return false;
 }
 //-----------------------------------------------------------------------------
+namespace
+{
+  // Converts a number already validated by the tokenizer. Uses exact double arithmetic when the
+  // mantissa fits in 53 bits and the power of ten is exactly representable, which yields the same
+  // correctly rounded result as atof(), otherwise falls back to atof().
+  double fastAtof(const char* str, int len)
+  {
+    static const double pow10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = str;
+    const char* end = str + len;
+    bool neg = false;
+    if (*p == '+' || *p == '-')
+      neg = *p++ == '-';
+
+    unsigned long long mant = 0;
+    int digits = 0;
+    int exp10 = 0;
+    for( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+      mant = mant * 10 + (*p - '0');
+      digits += mant != 0;
+    }
+    if (p < end && *p == '.')
+    {
+      for( ++p; p < end && *p >= '0' && *p <= '9'; ++p )
+      {
+        mant = mant * 10 + (*p - '0');
+        digits += mant != 0;
+        --exp10;
+      }
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      ++p;
+      bool exp_neg = *p == '-';
+      ++p;
+      int e = 0;
+      for( ; p < end && e < 10000; ++p )
+        e = e * 10 + (*p - '0');
+      exp10 += exp_neg ? -e : e;
+    }
+
+    if ( digits > 15 || exp10 < -22 || exp10 > 22 )
+      return atof( std::string(str, len).c_str() );
+
+    double val = (double)mant;
+    val = exp10 < 0 ? val / pow10[-exp10] : val * pow10[exp10];
+    return neg ? -val : val;
+  }
+
+  long long fastAtoll(const char* str, int len)
+  {
+    const char* p = str;
+    const char* end = str + len;
+    bool neg = false;
+    if (*p == '+' || *p == '-')
+      neg = *p++ == '-';
+    if (end - p > 18)
+      return atoll( std::string(str, len).c_str() );
+    long long val = 0;
+    for( ; p < end; ++p )
+      val = val * 10 + (*p - '0');
+    return neg ? -val : val;
+  }
+
+  template<typename T> void pushNumber(std::vector<T>& out, const char* str, int len, bool is_real);
+
+  template<> void pushNumber<double>(std::vector<double>& out, const char* str, int len, bool is_real)
+  {
+    out.push_back( is_real ? fastAtof(str, len) : (double)fastAtoll(str, len) );
+  }
+
+  template<> void pushNumber<long long>(std::vector<long long>& out, const char* str, int len, bool)
+  {
+    out.push_back( fastAtoll(str, len) );
+  }
+}
+//-----------------------------------------------------------------------------
+template<typename T>
+int VLTTokenizer::readNumbers_Template(std::vector<T>& out, bool accept_reals)
+{
+  if (mRawtextBlock)
+    return 0;
+
+  char number[128];
+  char ch = 0;
+  while( peekChar(ch) )
+  {
+    // spaces, same new line handling as readTextChar()
+    if (ch == ' ' || ch == '\t')
+    {
+      skipChar();
+      continue;
+    }
+    if (ch == '\n' || ch == '\r')
+    {
+      skipChar();
+      char ch2 = 0;
+      if ( peekChar(ch2) && (ch2 == '\n' || ch2 == '\r') && ch2 != ch )
+        skipChar();
+      ++mLineNumber;
+      continue;
+    }
+
+    if (ch == ')')
+    {
+      skipChar();
+      return 1;
+    }
+
+    if ( !((ch >= '0' && ch <= '9') || ch == '.' || ch == '+' || ch == '-') )
+      return 0;
+
+    // same state machine as getToken()
+    enum { sZERO, sPLUS_MINUS, sINT, sFRAC, sPOINT, sE, sPLUS_MINUS_EXP, sEXP } state = sINT;
+    if ( ch >= '1' && ch <= '9' )
+      state = sINT;
+    else
+    if (ch == '0')
+      state = sZERO;
+    else
+    if (ch == '.')
+      state = sPOINT;
+    else
+      state = sPLUS_MINUS;
+
+    int len = 0;
+    number[len++] = ch;
+    skipChar();
+    bool done = false;
+    while( !done && peekChar(ch) )
+    {
+      bool accept = false;
+      switch(state)
+      {
+      case sZERO:
+        if (ch == '.') { accept = true; state = sPOINT; }
+        break;
+      case sPLUS_MINUS:
+        if (ch == '0') { accept = true; state = sZERO; }
+        else
+        if (ch >= '1' && ch <= '9') { accept = true; state = sINT; }
+        else
+        if (ch == '.') { accept = true; state = sPOINT; }
+        break;
+      case sINT:
+        if (ch >= '0' && ch <= '9') accept = true;
+        else
+        if (ch == '.') { accept = true; state = sPOINT; }
+        break;
+      case sPOINT:
+        if (ch >= '0' && ch <= '9') { accept = true; state = sFRAC; }
+        break;
+      case sFRAC:
+        if (ch >= '0' && ch <= '9') accept = true;
+        else
+        if (ch == 'E' || ch == 'e') { accept = true; state = sE; }
+        break;
+      case sE:
+        if (ch == '+' || ch == '-') { accept = true; state = sPLUS_MINUS_EXP; }
+        break;
+      case sPLUS_MINUS_EXP:
+        if (ch >= '0' && ch <= '9') { accept = true; state = sEXP; }
+        break;
+      case sEXP:
+        if (ch >= '0' && ch <= '9') accept = true;
+        break;
+      }
+
+      if (!accept)
+        done = true;
+      else
+      if (len == (int)sizeof(number) - 1)
+      {
+        Log::error( Say("Line %n : number too long.\n") << mLineNumber );
+        return -1;
+      }
+      else
+      {
+        number[len++] = ch;
+        skipChar();
+      }
+    }
+
+    bool is_real = state == sFRAC || state == sEXP;
+    if ( !is_real && state != sINT && state != sZERO )
+    {
+      if (done)
+        Log::error( Say("Line %n :unexpected character '%c'.\n") << mLineNumber << ch );
+      else
+        Log::error( Say("Line %n : unexpected end of file.\n") << mLineNumber );
+      return -1;
+    }
+    if (is_real && !accept_reals)
+      return -1;
+
+    pushNumber(out, number, len, is_real);
+  }
+
+  return 0;
+}
+//-----------------------------------------------------------------------------
+int VLTTokenizer::readNumbers(std::vector<double>& out)
+{
+  return readNumbers_Template(out, true);
+}
+//-----------------------------------------------------------------------------
+int VLTTokenizer::readNumbers(std::vector<long long>& out)
+{
+  return readNumbers_Template(out, false);
+}
+//-----------------------------------------------------------------------------
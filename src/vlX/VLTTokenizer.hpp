@@ -84,8 +84,46 @@ namespace vlX
 
     VLX_EXPORT bool getRawtextBlock(VLTToken& token);
 
+    /**
+     * Fast path used to read the content of ( number arrays ): appends the numbers that follow to \p out
+     * scanning the input buffer directly, without going through getToken().
+     * Returns 1 if the closing ')' was reached and consumed, -1 on syntax error and 0 if something else
+     * was found, such as a comment, which is left unconsumed and must be read with getToken().
+     */
+    VLX_EXPORT int readNumbers(std::vector<double>& out);
+
+    //! Like readNumbers(std::vector<double>&) but only accepts integers.
+    VLX_EXPORT int readNumbers(std::vector<long long>& out);
+
     int lineNumber() const { return mLineNumber; }
 
+  private:
+    // returns the next character without consuming it, false at the end of the file
+    bool peekChar(char& ch)
+    {
+      if ( !mUngetBuffer.empty() )
+      {
+        ch = mUngetBuffer.back();
+        return true;
+      }
+      if ( bufferEmpty() && !fillBuffer() )
+        return false;
+      ch = mBuffer[mPtr];
+      return true;
+    }
+
+    // consumes the character returned by peekChar()
+    void skipChar()
+    {
+      if ( !mUngetBuffer.empty() )
+        mUngetBuffer.pop_back();
+      else
+        ++mPtr;
+    }
+
+    template<typename T>
+    int readNumbers_Template(std::vector<T>& out, bool accept_reals);
+
   private:
     int mLineNumber;
     bool mRawtextBlock;
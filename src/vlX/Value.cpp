@@ -61,6 +61,7 @@ void VLXValue::release()
   */
   case ArrayInteger:
   case ArrayReal:
+  case ArrayBinary:
     if (mUnion.mArray)
       mUnion.mArray->decReference();
     break;
@@ -110,6 +111,7 @@ VLXValue& VLXValue::operator=(const VLXValue& other)
   */
   case ArrayInteger:
   case ArrayReal:
+  case ArrayBinary:
     if (other.mUnion.mArray)
       other.mUnion.mArray->incReference();
     break;
@@ -187,6 +189,17 @@ VLXArrayReal* VLXValue::setArrayReal(VLXArrayReal* arr)
   return arr;
 }
 //-----------------------------------------------------------------------------
+VLXArrayBinary* VLXValue::setArrayBinary(VLXArrayBinary* arr)
+{
+  VL_CHECK(arr);
+  release();
+  mType = ArrayBinary;
+  mUnion.mArray = arr;
+  if (mUnion.mArray)
+    mUnion.mArray->incReference();
+  return arr;
+}
+//-----------------------------------------------------------------------------
 /*
 VLXArrayString* VLXValue::setArrayString(VLXArrayString* arr)
 {
@@ -229,6 +242,9 @@ VLXArray* VLXValue::setArray(VLXArray* arr)
   else
   if (arr->classType() == VLXArrayReal::Type())
     return setArrayReal(arr->as<VLXArrayReal>());
+  else
+  if (arr->classType() == VLXArrayBinary::Type())
+    return setArrayBinary(arr->as<VLXArrayBinary>());
   /*
   else
   if (arr->classType() == VLXArrayString::Type())
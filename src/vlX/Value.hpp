@@ -34,6 +34,8 @@
 
 #include <vlX/link_config.hpp>
 #include <vlX/Visitor.hpp>
+#include <vlCore/Buffer.hpp>
+#include <vlCore/half.hpp>
 #include <vector>
 
 namespace vlX
@@ -149,6 +151,150 @@ namespace vlX
     VLXArrayReal(const char* tag=NULL): VLXArrayTemplate<double>(tag) { }
 
     virtual void acceptVisitor(Visitor* v) { v->visitArray(this); }
+
+    using VLXArrayTemplate<double>::copyTo;
+
+    //! Uses the batched vl::half conversion.
+    void copyTo(vl::half* ptr) const { if (!value().empty()) vl::half::convertDoubleToHalf(&value()[0], ptr, (int)value().size()); }
+  };
+  //-----------------------------------------------------------------------------
+  //! Scalar types of a VLXArrayBinary, the values are stored in VLB files.
+  typedef enum
+  {
+    VLX_Byte = 1,
+    VLX_UByte,
+    VLX_Short,
+    VLX_UShort,
+    VLX_Int,
+    VLX_UInt,
+    VLX_HalfFloat,
+    VLX_Float,
+    VLX_Double
+  } EVLXScalarType;
+
+  inline EVLXScalarType vlx_scalarType(const signed char*)    { return VLX_Byte; }
+  inline EVLXScalarType vlx_scalarType(const unsigned char*)  { return VLX_UByte; }
+  inline EVLXScalarType vlx_scalarType(const short*)          { return VLX_Short; }
+  inline EVLXScalarType vlx_scalarType(const unsigned short*) { return VLX_UShort; }
+  inline EVLXScalarType vlx_scalarType(const int*)            { return VLX_Int; }
+  inline EVLXScalarType vlx_scalarType(const unsigned int*)   { return VLX_UInt; }
+  inline EVLXScalarType vlx_scalarType(const vl::half*)       { return VLX_HalfFloat; }
+  inline EVLXScalarType vlx_scalarType(const float*)          { return VLX_Float; }
+  inline EVLXScalarType vlx_scalarType(const double*)         { return VLX_Double; }
+  //-----------------------------------------------------------------------------
+  /** An array of scalars kept in their native binary type, can also have a tag.
+   * Used to serialize vl::Array data without widening every scalar to 64 bits: VLB files store the buffer() as it is and
+   * VLXClassWrapper_Array moves its storage into the imported array, after which isValid() returns false.
+   * VLT files store it as a regular VLXArrayInteger or VLXArrayReal. */
+  class VLXArrayBinary: public VLXArray
+  {
+    VL_INSTRUMENT_CLASS(vlX::ArrayBinary, VLXArray)
+
+  public:
+    VLXArrayBinary(const char* tag=NULL): VLXArray(tag), mScalarType(VLX_Float), mCount(0), mBorrowed(false)
+    {
+      mBuffer = new vl::Buffer;
+    }
+
+    virtual void acceptVisitor(Visitor* v) { v->visitArray(this); }
+
+    //! Allocates the storage for \p count scalars of the given type.
+    void allocate(EVLXScalarType type, size_t count)
+    {
+      mScalarType = type;
+      mCount = count;
+      mBorrowed = false;
+      mBuffer->resize(count * scalarSize(type));
+    }
+
+    //! Uses \p count scalars of the given type stored at \p ptr without copying them, see vl::Buffer::setUserAllocatedBuffer().
+    void setUserAllocatedBuffer(EVLXScalarType type, size_t count, void* ptr, vl::Object* owner)
+    {
+      mScalarType = type;
+      mCount = count;
+      mBorrowed = false;
+      mBuffer->setUserAllocatedBuffer(ptr, count * scalarSize(type), owner);
+    }
+
+    //! Refers to \p count scalars stored at \p ptr, kept alive by \p owner, without copying them.
+    //! Used on export to write the arrays straight from their source storage, see isBorrowed().
+    void setBorrowedBuffer(EVLXScalarType type, size_t count, const void* ptr, const vl::Object* owner)
+    {
+      setUserAllocatedBuffer(type, count, const_cast<void*>(ptr), const_cast<vl::Object*>(owner));
+      mBorrowed = true;
+    }
+
+    //! If true the storage belongs to another object: it must not be modified nor handed over, only copied.
+    bool isBorrowed() const { return mBorrowed; }
+
+    EVLXScalarType scalarType() const { return mScalarType; }
+
+    //! The number of scalars in the array.
+    size_t count() const { return mCount; }
+
+    //! Returns false if the storage has been handed over to another object.
+    bool isValid() const { return mBuffer->bytesUsed() == mCount * scalarSize(mScalarType); }
+
+    bool isInteger() const { return mScalarType != VLX_HalfFloat && mScalarType != VLX_Float && mScalarType != VLX_Double; }
+
+    vl::Buffer* buffer() { return mBuffer.get(); }
+
+    const vl::Buffer* buffer() const { return mBuffer.get(); }
+
+    static size_t scalarSize(EVLXScalarType type)
+    {
+      switch(type)
+      {
+      case VLX_Byte:
+      case VLX_UByte:     return 1;
+      case VLX_Short:
+      case VLX_UShort:
+      case VLX_HalfFloat: return 2;
+      case VLX_Int:
+      case VLX_UInt:
+      case VLX_Float:     return 4;
+      case VLX_Double:    return 8;
+      default:            return 0;
+      }
+    }
+
+    //! Converts the values to the type of \p ptr which must have room for count() elements.
+    template<typename T2> void copyTo(T2* ptr) const
+    {
+      switch(mScalarType)
+      {
+      case VLX_Byte:      copyTo_Template<signed char>(ptr);    break;
+      case VLX_UByte:     copyTo_Template<unsigned char>(ptr);  break;
+      case VLX_Short:     copyTo_Template<short>(ptr);          break;
+      case VLX_UShort:    copyTo_Template<unsigned short>(ptr); break;
+      case VLX_Int:       copyTo_Template<int>(ptr);            break;
+      case VLX_UInt:      copyTo_Template<unsigned int>(ptr);   break;
+      case VLX_HalfFloat: copyHalfTo(ptr);                      break;
+      case VLX_Float:     copyTo_Template<float>(ptr);          break;
+      case VLX_Double:    copyTo_Template<double>(ptr);         break;
+      }
+    }
+
+  private:
+    template<typename T, typename T2> void copyTo_Template(T2* ptr) const
+    {
+      const T* src = (const T*)mBuffer->ptr();
+      for(size_t i=0; i<mCount; ++i)
+        ptr[i] = (T2)(double)src[i];
+    }
+
+    // half-floats going to float or double use the batched vl::half conversions
+    template<typename T2> void copyHalfTo(T2* ptr) const { copyTo_Template<vl::half>(ptr); }
+
+    void copyHalfTo(float* ptr) const { vl::half::convertHalfToFloat((const vl::half*)mBuffer->ptr(), ptr, (int)mCount); }
+
+    void copyHalfTo(double* ptr) const { vl::half::convertHalfToDouble((const vl::half*)mBuffer->ptr(), ptr, (int)mCount); }
+
+  private:
+    EVLXScalarType mScalarType;
+    size_t mCount;
+    bool mBorrowed;
+    vl::ref<vl::Buffer> mBuffer;
   };
   //-----------------------------------------------------------------------------
   /*
@@ -252,7 +398,8 @@ namespace vlX
       List,
       Structure,
       ArrayInteger,
-      ArrayReal
+      ArrayReal,
+      ArrayBinary
       /*
       ArrayString,
       ArrayIdentifier,
@@ -314,6 +461,14 @@ namespace vlX
       setArrayReal(arr);
     }
 
+    VLXValue(VLXArrayBinary* arr)
+    {
+      mLineNumber = 0;
+      mType = Integer;
+      mUnion.mInteger = 0;
+      setArrayBinary(arr);
+    }
+
     /*
     VLXValue(VLXArrayString* arr)
     {
@@ -424,6 +579,7 @@ namespace vlX
     VLX_EXPORT VLXArray*           setArray(VLXArray*);
     VLX_EXPORT VLXArrayInteger*    setArrayInteger(VLXArrayInteger*);
     VLX_EXPORT VLXArrayReal*       setArrayReal(VLXArrayReal*);
+    VLX_EXPORT VLXArrayBinary*     setArrayBinary(VLXArrayBinary*);
     /*
     VLX_EXPORT VLXArrayString*     setArrayString(VLXArrayString*);
     VLX_EXPORT VLXArrayIdentifier* setArrayIdentifier(VLXArrayIdentifier*);
@@ -447,6 +603,9 @@ namespace vlX
     VLXArrayReal* getArrayReal() { VL_CHECK(mType == ArrayReal); return mUnion.mArray->as<VLXArrayReal>(); }
     const VLXArrayReal* getArrayReal() const { VL_CHECK(mType == ArrayReal); return mUnion.mArray->as<VLXArrayReal>(); }
 
+    VLXArrayBinary* getArrayBinary() { VL_CHECK(mType == ArrayBinary); return mUnion.mArray->as<VLXArrayBinary>(); }
+    const VLXArrayBinary* getArrayBinary() const { VL_CHECK(mType == ArrayBinary); return mUnion.mArray->as<VLXArrayBinary>(); }
+
     // string
 
     const std::string& setString(const char* str)
@@ -33,7 +33,7 @@
 #define VLXVisitor_INCLUDE_ONCE
 
 #include <vlCore/Object.hpp>
-#include <set>
+#include <vlX/PointerMap.hpp>
 
 namespace vlX
 {
@@ -43,6 +43,7 @@ namespace vlX
   class VLXArray;
   class VLXArrayInteger;
   class VLXArrayReal;
+  class VLXArrayBinary;
   /*
   class VLXArrayString;
   class VLXArrayIdentifier;
@@ -60,6 +61,7 @@ namespace vlX
     virtual void visitRawtextBlock(VLXRawtextBlock*) {}
     virtual void visitArray(VLXArrayInteger*) {}
     virtual void visitArray(VLXArrayReal*) {}
+    virtual void visitArray(VLXArrayBinary*) {}
     /*
     virtual void visitArray(VLXArrayString*) {}
     virtual void visitArray(VLXArrayIdentifier*) {}
@@ -68,20 +70,17 @@ namespace vlX
 
     bool isVisited(void* node)
     {
-      std::set< void* >::iterator it = mVisited.find(node);
-      if (it == mVisited.end())
-      {
-        mVisited.insert(node);
-        return false;
-      }
-      else
+      bool& visited = mVisited[node];
+      if (visited)
         return true;
+      visited = true;
+      return false;
     }
 
     void resetVisitedNodes() { mVisited.clear(); };
 
   private:
-    std::set< void* > mVisited;
+    PointerMap<bool> mVisited;
   };
 }
 
@@ -117,6 +117,8 @@ namespace vlX
 
     virtual void visitArray(VLXArrayReal*)  {}
 
+    virtual void visitArray(VLXArrayBinary*)  {}
+
     void setIDSet(std::map< std::string, int >* uids) { mIDSet = uids; }
 
     std::map< std::string, int >* uidSet() { return mIDSet; }
@@ -48,6 +48,7 @@ namespace vlX
     VisitorExportToVLB(vl::VirtualFile* file = NULL)
     {
       mIDSet = NULL;
+      mMappable = false;
       setOutputFile(file);
     }
 
@@ -101,6 +102,10 @@ namespace vlX
         value.getArrayReal()->acceptVisitor(this);
         break;
 
+      case VLXValue::ArrayBinary:
+        value.getArrayBinary()->acceptVisitor(this);
+        break;
+
       case VLXValue::RawtextBlock:
       {
         VLXRawtextBlock* fblock = value.getRawtextBlock();
@@ -278,6 +283,47 @@ namespace vlX
       }
     }
 
+    virtual void visitArray(VLXArrayBinary* arr)
+    {
+      VL_CHECK(arr->isValid())
+
+      // header
+      mOutputFile->writeUInt8( (unsigned char)(mMappable ? VLB_ChunkArrayBinaryAligned : VLB_ChunkArrayBinary) );
+      // tag
+      writeString(arr->tag().c_str());
+      // scalar type
+      mOutputFile->writeUInt8( (unsigned char)arr->scalarType() );
+      // count
+      writeInteger(arr->count());
+      // padding so that the data starts at an aligned file offset
+      if (mMappable)
+      {
+        unsigned char padding[VLB_MappableAlignment] = { 0 };
+        long long offset = mOutputFile->position() + 1;
+        unsigned char pad = (unsigned char)((VLB_MappableAlignment - offset % VLB_MappableAlignment) % VLB_MappableAlignment);
+        mOutputFile->writeUInt8( pad );
+        mOutputFile->write( padding, pad );
+      }
+      // value, little endian
+      if (arr->count())
+      {
+        const void* ptr = arr->buffer()->ptr();
+        long long count = arr->count();
+        switch(arr->scalarType())
+        {
+        case VLX_Byte:
+        case VLX_UByte:     mOutputFile->writeUInt8 ( (const unsigned char*)ptr,  count ); break;
+        case VLX_Short:
+        case VLX_UShort:
+        case VLX_HalfFloat: mOutputFile->writeUInt16( (const unsigned short*)ptr, count ); break;
+        case VLX_Int:
+        case VLX_UInt:      mOutputFile->writeUInt32( (const unsigned int*)ptr,   count ); break;
+        case VLX_Float:     mOutputFile->writeFloat ( (const float*)ptr,          count ); break;
+        case VLX_Double:    mOutputFile->writeDouble( (const double*)ptr,         count ); break;
+        }
+      }
+    }
+
     /*
     virtual void visitArray(VLXArrayString* arr)
     {
@@ -300,7 +346,7 @@ namespace vlX
       mOutputFile->write(vlx_identifier, sizeof(vlx_identifier));
       mOutputFile->writeUInt16(VL_SERIALIZER_VERSION);    // "version" (16 bits uint)
       mOutputFile->write("ascii", 5+1); // "encoding" (zero terminated string)
-      mOutputFile->writeUInt32(0);      // "flags" (reserved for the future)
+      mOutputFile->writeUInt32(mMappable ? VLB_FlagMappable : 0); // "flags"
     }
 
     void writeString(const char* str)
@@ -369,6 +415,12 @@ namespace vlX
 
     void setIDSet(std::map< std::string, int >* uids) { mIDSet = uids; }
 
+    //! If true binary arrays are written with their data aligned to VLB_MappableAlignment so that they can be loaded from a memory mapping without copying.
+    void setMappable(bool mappable) { mMappable = mappable; }
+
+    //! If true binary arrays are written with their data aligned to VLB_MappableAlignment so that they can be loaded from a memory mapping without copying.
+    bool mappable() const { return mMappable; }
+
     std::map< std::string, int >* uidSet() { return mIDSet; }
 
     const std::map< std::string, int >* uidSet() const { return mIDSet; }
@@ -390,6 +442,7 @@ namespace vlX
   private:
     std::map< std::string, int >* mIDSet;
     vl::ref<vl::VirtualFile> mOutputFile;
+    bool mMappable;
   };
 }
 
@@ -128,6 +128,10 @@ namespace vlX
           value.getArrayReal()->acceptVisitor(this);
           break;
 
+        case VLXValue::ArrayBinary:
+          value.getArrayBinary()->acceptVisitor(this);
+          break;
+
         /*
         case VLXValue::ArrayString:
           value.getArrayString()->acceptVisitor(this);
@@ -295,6 +299,27 @@ namespace vlX
       output(")\n");
     }
 
+    virtual void visitArray(VLXArrayBinary* arr)
+    {
+      // VLT has no binary arrays, they are written as regular integer or real arrays
+      if (arr->isInteger())
+      {
+        vl::ref<VLXArrayInteger> arr_integer = new VLXArrayInteger( arr->tag().c_str() );
+        arr_integer->value().resize( arr->count() );
+        if (arr->count())
+          arr->copyTo( arr_integer->ptr() );
+        visitArray( arr_integer.get() );
+      }
+      else
+      {
+        vl::ref<VLXArrayReal> arr_real = new VLXArrayReal( arr->tag().c_str() );
+        arr_real->value().resize( arr->count() );
+        if (arr->count())
+          arr->copyTo( arr_real->ptr() );
+        visitArray( arr_real.get() );
+      }
+    }
+
     /*
     virtual void visitArray(VLXArrayString* arr)
     {
@@ -126,6 +126,8 @@ namespace vlX
 
     virtual void visitArray(VLXArrayReal*)  {}
 
+    virtual void visitArray(VLXArrayBinary*)  {}
+
     EError error() const { return mError; }
 
     void setError(EError err) { mError = err; }
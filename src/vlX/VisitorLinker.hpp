@@ -159,6 +159,8 @@ namespace vlX
 
     virtual void visitArray(VLXArrayReal*)  {}
 
+    virtual void visitArray(VLXArrayBinary*)  {}
+
     EError error() const { return mError; }
 
     void setError(EError err) { mError = err; }
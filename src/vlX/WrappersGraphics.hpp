@@ -45,9 +45,11 @@
 #include <vlGraphics/MultiDrawElements.hpp>
 #include <vlGraphics/DrawArrays.hpp>
 #include <vlGraphics/SceneManagerActorTree.hpp>
+#include <vlGraphics/SceneManagerPortals.hpp>
 #include <vlGraphics/DistanceLODEvaluator.hpp>
 #include <vlGraphics/PixelLODEvaluator.hpp>
 #include <vlGraphics/DepthSortCallback.hpp>
+#include <vlGraphics/ParticleSystem.hpp>
 #include <vlGraphics/GLSL.hpp>
 #include <vlCore/ResourceDatabase.hpp>
 #include <vlCore/DiskFile.hpp>
@@ -70,341 +72,185 @@ namespace vlX
       vl::ref<vl::ArrayAbstract> arr_abstract;
 
       if (vlx->tag() == "<vl::ArrayFloat1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_float = value.getArrayReal();
-        vl::ref<vl::ArrayFloat1> arr_float1 = new vl::ArrayFloat1; arr_abstract = arr_float1;
-        arr_float1->resize( vlx_arr_float->value().size() );
-        vlx_arr_float->copyTo((float*)arr_float1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayFloat1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayFloat2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_float = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_float->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayFloat2> arr_float2 = new vl::ArrayFloat2; arr_abstract = arr_float2;
-        arr_float2->resize( vlx_arr_float->value().size() / 2 );
-        vlx_arr_float->copyTo((float*)arr_float2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayFloat2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayFloat3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_float = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_float->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayFloat3> arr_float3 = new vl::ArrayFloat3; arr_abstract = arr_float3;
-        arr_float3->resize( vlx_arr_float->value().size() / 3 );
-        vlx_arr_float->copyTo((float*)arr_float3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayFloat3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayFloat4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_float = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_float->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayFloat4> arr_float4 = new vl::ArrayFloat4; arr_abstract = arr_float4;
-        arr_float4->resize( vlx_arr_float->value().size() / 4 );
-        vlx_arr_float->copyTo((float*)arr_float4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayFloat4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayDouble1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_floating = value.getArrayReal();
-        vl::ref<vl::ArrayDouble1> arr_floating1 = new vl::ArrayDouble1; arr_abstract = arr_floating1;
-        arr_floating1->resize( vlx_arr_floating->value().size() );
-        vlx_arr_floating->copyTo((double*)arr_floating1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayDouble1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayDouble2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_floating = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_floating->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayDouble2> arr_floating2 = new vl::ArrayDouble2; arr_abstract = arr_floating2;
-        arr_floating2->resize( vlx_arr_floating->value().size() / 2 );
-        vlx_arr_floating->copyTo((double*)arr_floating2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayDouble2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayDouble3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_floating = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_floating->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayDouble3> arr_floating3 = new vl::ArrayDouble3; arr_abstract = arr_floating3;
-        arr_floating3->resize( vlx_arr_floating->value().size() / 3 );
-        vlx_arr_floating->copyTo((double*)arr_floating3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayDouble3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayDouble4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayReal, value);
-        const VLXArrayReal* vlx_arr_floating = value.getArrayReal();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_floating->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayDouble4> arr_floating4 = new vl::ArrayDouble4; arr_abstract = arr_floating4;
-        arr_floating4->resize( vlx_arr_floating->value().size() / 4 );
-        vlx_arr_floating->copyTo((double*)arr_floating4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayDouble4>(s, value);
+      else
+      if (vlx->tag() == "<vl::ArrayHFloat1>")
+        arr_abstract = import_ArrayT<vl::ArrayHFloat1>(s, value);
+      else
+      if (vlx->tag() == "<vl::ArrayHFloat2>")
+        arr_abstract = import_ArrayT<vl::ArrayHFloat2>(s, value);
+      else
+      if (vlx->tag() == "<vl::ArrayHFloat3>")
+        arr_abstract = import_ArrayT<vl::ArrayHFloat3>(s, value);
+      else
+      if (vlx->tag() == "<vl::ArrayHFloat4>")
+        arr_abstract = import_ArrayT<vl::ArrayHFloat4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayInt1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayInt1> arr_int1 = new vl::ArrayInt1; arr_abstract = arr_int1;
-        arr_int1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((int*)arr_int1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayInt1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayInt2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayInt2> arr_int2 = new vl::ArrayInt2; arr_abstract = arr_int2;
-        arr_int2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((int*)arr_int2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayInt2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayInt3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayInt3> arr_int3 = new vl::ArrayInt3; arr_abstract = arr_int3;
-        arr_int3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((int*)arr_int3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayInt3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayInt4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayInt4> arr_int4 = new vl::ArrayInt4; arr_abstract = arr_int4;
-        arr_int4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((int*)arr_int4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayInt4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUInt1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayUInt1> arr_int1 = new vl::ArrayUInt1; arr_abstract = arr_int1;
-        arr_int1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((unsigned int*)arr_int1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUInt1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUInt2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayUInt2> arr_int2 = new vl::ArrayUInt2; arr_abstract = arr_int2;
-        arr_int2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((unsigned int*)arr_int2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUInt2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUInt3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayUInt3> arr_int3 = new vl::ArrayUInt3; arr_abstract = arr_int3;
-        arr_int3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((unsigned int*)arr_int3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUInt3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUInt4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayUInt4> arr_int4 = new vl::ArrayUInt4; arr_abstract = arr_int4;
-        arr_int4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((unsigned int*)arr_int4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUInt4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayShort1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayShort1> arr_short1 = new vl::ArrayShort1; arr_abstract = arr_short1;
-        arr_short1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((short*)arr_short1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayShort1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayShort2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayShort2> arr_short2 = new vl::ArrayShort2; arr_abstract = arr_short2;
-        arr_short2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((short*)arr_short2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayShort2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayShort3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayShort3> arr_short3 = new vl::ArrayShort3; arr_abstract = arr_short3;
-        arr_short3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((short*)arr_short3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayShort3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayShort4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayShort4> arr_short4 = new vl::ArrayShort4; arr_abstract = arr_short4;
-        arr_short4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((short*)arr_short4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayShort4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUShort1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayUShort1> arr_short1 = new vl::ArrayUShort1; arr_abstract = arr_short1;
-        arr_short1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((unsigned short*)arr_short1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUShort1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUShort2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayUShort2> arr_short2 = new vl::ArrayUShort2; arr_abstract = arr_short2;
-        arr_short2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((unsigned short*)arr_short2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUShort2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUShort3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayUShort3> arr_short3 = new vl::ArrayUShort3; arr_abstract = arr_short3;
-        arr_short3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((unsigned short*)arr_short3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUShort3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUShort4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayUShort4> arr_short4 = new vl::ArrayUShort4; arr_abstract = arr_short4;
-        arr_short4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((unsigned short*)arr_short4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUShort4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayByte1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayByte1> arr_byte1 = new vl::ArrayByte1; arr_abstract = arr_byte1;
-        arr_byte1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((char*)arr_byte1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayByte1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayByte2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayByte2> arr_byte2 = new vl::ArrayByte2; arr_abstract = arr_byte2;
-        arr_byte2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((char*)arr_byte2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayByte2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayByte3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayByte3> arr_byte3 = new vl::ArrayByte3; arr_abstract = arr_byte3;
-        arr_byte3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((char*)arr_byte3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayByte3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayByte4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayByte4> arr_byte4 = new vl::ArrayByte4; arr_abstract = arr_byte4;
-        arr_byte4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((char*)arr_byte4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayByte4>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUByte1>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        vl::ref<vl::ArrayUByte1> arr_byte1 = new vl::ArrayUByte1; arr_abstract = arr_byte1;
-        arr_byte1->resize( vlx_arr_int->value().size() );
-        vlx_arr_int->copyTo((unsigned char*)arr_byte1->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUByte1>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUByte2>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 2 == 0, value)
-        vl::ref<vl::ArrayUByte2> arr_byte2 = new vl::ArrayUByte2; arr_abstract = arr_byte2;
-        arr_byte2->resize( vlx_arr_int->value().size() / 2 );
-        vlx_arr_int->copyTo((unsigned char*)arr_byte2->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUByte2>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUByte3>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 3 == 0, value)
-        vl::ref<vl::ArrayUByte3> arr_byte3 = new vl::ArrayUByte3; arr_abstract = arr_byte3;
-        arr_byte3->resize( vlx_arr_int->value().size() / 3 );
-        vlx_arr_int->copyTo((unsigned char*)arr_byte3->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUByte3>(s, value);
       else
       if (vlx->tag() == "<vl::ArrayUByte4>")
-      {
-        VLX_IMPORT_CHECK_RETURN_NULL(value.type() == VLXValue::ArrayInteger, value);
-        const VLXArrayInteger* vlx_arr_int = value.getArrayInteger();
-        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr_int->value().size() % 4 == 0, value)
-        vl::ref<vl::ArrayUByte4> arr_byte4 = new vl::ArrayUByte4; arr_abstract = arr_byte4;
-        arr_byte4->resize( vlx_arr_int->value().size() / 4 );
-        vlx_arr_int->copyTo((unsigned char*)arr_byte4->ptr());
-      }
+        arr_abstract = import_ArrayT<vl::ArrayUByte4>(s, value);
       else
       {
         s.signalImportError( vl::Say("Line %n : unknown array '%s'.\n") << vlx->lineNumber() << vlx->tag() );
       }
 
+      if (!arr_abstract)
+        return NULL;
+
       // register imported structure asap
       s.registerImportedStructure(vlx, arr_abstract.get());
       return arr_abstract.get();
     }
 
-    template<typename T_Array, typename T_VLXArray>
+    template<typename T_Array>
+    vl::ref<vl::ArrayAbstract> import_ArrayT(VLXSerializer& s, const VLXValue& value)
+    {
+      typedef typename T_Array::scalar_type scalar_type;
+      const size_t gl_size = sizeof(typename T_Array::vector_type) / sizeof(scalar_type);
+      const EVLXScalarType scalar = vlx_scalarType((const scalar_type*)NULL);
+      const bool is_real = scalar == VLX_HalfFloat || scalar == VLX_Float || scalar == VLX_Double;
+
+      vl::ref<T_Array> arr = new T_Array;
+      if (value.type() == VLXValue::ArrayBinary)
+      {
+        // the parsed VLX tree is discarded after import: take over its storage if the scalar type matches
+        VLXArrayBinary* vlx_arr = const_cast<VLXArrayBinary*>(value.getArrayBinary());
+        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr->isValid() && vlx_arr->count() % gl_size == 0, value )
+        if (vlx_arr->scalarType() == scalar && !vlx_arr->isBorrowed())
+          arr->bufferObject()->vl::Buffer::swap( *vlx_arr->buffer() );
+        else
+        if (vlx_arr->scalarType() == scalar)
+        {
+          // storage borrowed from an exported array
+          arr->resize( vlx_arr->count() / gl_size );
+          if (vlx_arr->count())
+            memcpy( arr->ptr(), vlx_arr->buffer()->ptr(), arr->bytesUsed() );
+        }
+        else
+        {
+          arr->resize( vlx_arr->count() / gl_size );
+          vlx_arr->copyTo( (scalar_type*)arr->ptr() );
+        }
+      }
+      else
+      if (is_real)
+      {
+        VLX_IMPORT_CHECK_RETURN_NULL( value.type() == VLXValue::ArrayReal, value )
+        const VLXArrayReal* vlx_arr = value.getArrayReal();
+        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr->value().size() % gl_size == 0, value )
+        arr->resize( vlx_arr->value().size() / gl_size );
+        vlx_arr->copyTo( (scalar_type*)arr->ptr() );
+      }
+      else
+      {
+        VLX_IMPORT_CHECK_RETURN_NULL( value.type() == VLXValue::ArrayInteger, value )
+        const VLXArrayInteger* vlx_arr = value.getArrayInteger();
+        VLX_IMPORT_CHECK_RETURN_NULL( vlx_arr->value().size() % gl_size == 0, value )
+        arr->resize( vlx_arr->value().size() / gl_size );
+        vlx_arr->copyTo( (scalar_type*)arr->ptr() );
+      }
+      return arr;
+    }
+
+    //! Arrays are exported as VLXArrayBinary, stored in VLB files without conversions.
+    //! The VLXArrayBinary borrows the array storage so that it is written straight from it without intermediate copies.
+    template<typename T_Array>
     vl::ref<VLXStructure> export_ArrayT(VLXSerializer& s, const vl::Object* arr_abstract)
     {
+      typedef typename T_Array::scalar_type scalar_type;
       const T_Array* arr = arr_abstract->as<T_Array>();
       vl::ref<VLXStructure> st =new VLXStructure(vlx_makeTag(arr_abstract).c_str(), s.generateID("array_"));
-      vl::ref<T_VLXArray> vlx_array = new T_VLXArray;
-      if (arr->size())
-      {
-        vlx_array->value().resize( arr->size() * arr->glSize() );
-        typename T_VLXArray::scalar_type* dst = &vlx_array->value()[0];
-        const typename T_Array::scalar_type* src = (const typename T_Array::scalar_type*)arr->begin();
-        const typename T_Array::scalar_type* end = (const typename T_Array::scalar_type*)arr->end();
-        for(; src<end; ++src, ++dst)
-          *dst = (typename T_VLXArray::scalar_type)*src;
-      }
+      vl::ref<VLXArrayBinary> vlx_array = new VLXArrayBinary;
+      vlx_array->setBorrowedBuffer( vlx_scalarType((const scalar_type*)NULL), arr->size() * arr->glSize(), arr->ptr(), arr );
       st->value().push_back( VLXStructure::KeyValue("Value", vlx_array.get() ) );
       return st;
     }
@@ -413,120 +259,133 @@ namespace vlX
     {
       vl::ref<VLXStructure> vlx;
       if(obj->classType() == vl::ArrayUInt1::Type())
-        vlx = export_ArrayT<vl::ArrayUInt1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUInt1>(s, obj);
       else
       if(obj->classType() == vl::ArrayUInt2::Type())
-        vlx = export_ArrayT<vl::ArrayUInt2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUInt2>(s, obj);
       else
       if(obj->classType() == vl::ArrayUInt3::Type())
-        vlx = export_ArrayT<vl::ArrayUInt3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUInt3>(s, obj);
       else
       if(obj->classType() == vl::ArrayUInt4::Type())
-        vlx = export_ArrayT<vl::ArrayUInt4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUInt4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayInt1::Type())
-        vlx = export_ArrayT<vl::ArrayInt1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayInt1>(s, obj);
       else
       if(obj->classType() == vl::ArrayInt2::Type())
-        vlx = export_ArrayT<vl::ArrayInt2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayInt2>(s, obj);
       else
       if(obj->classType() == vl::ArrayInt3::Type())
-        vlx = export_ArrayT<vl::ArrayInt3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayInt3>(s, obj);
       else
       if(obj->classType() == vl::ArrayInt4::Type())
-        vlx = export_ArrayT<vl::ArrayInt4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayInt4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayUShort1::Type())
-        vlx = export_ArrayT<vl::ArrayUShort1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort1>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort2::Type())
-        vlx = export_ArrayT<vl::ArrayUShort2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort2>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort3::Type())
-        vlx = export_ArrayT<vl::ArrayUShort3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort3>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort4::Type())
-        vlx = export_ArrayT<vl::ArrayUShort4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayUShort1::Type())
-        vlx = export_ArrayT<vl::ArrayUShort1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort1>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort2::Type())
-        vlx = export_ArrayT<vl::ArrayUShort2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort2>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort3::Type())
-        vlx = export_ArrayT<vl::ArrayUShort3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort3>(s, obj);
       else
       if(obj->classType() == vl::ArrayUShort4::Type())
-        vlx = export_ArrayT<vl::ArrayUShort4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUShort4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayShort1::Type())
-        vlx = export_ArrayT<vl::ArrayShort1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayShort1>(s, obj);
       else
       if(obj->classType() == vl::ArrayShort2::Type())
-        vlx = export_ArrayT<vl::ArrayShort2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayShort2>(s, obj);
       else
       if(obj->classType() == vl::ArrayShort3::Type())
-        vlx = export_ArrayT<vl::ArrayShort3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayShort3>(s, obj);
       else
       if(obj->classType() == vl::ArrayShort4::Type())
-        vlx = export_ArrayT<vl::ArrayShort4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayShort4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayUByte1::Type())
-        vlx = export_ArrayT<vl::ArrayUByte1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUByte1>(s, obj);
       else
       if(obj->classType() == vl::ArrayUByte2::Type())
-        vlx = export_ArrayT<vl::ArrayUByte2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUByte2>(s, obj);
       else
       if(obj->classType() == vl::ArrayUByte3::Type())
-        vlx = export_ArrayT<vl::ArrayUByte3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUByte3>(s, obj);
       else
       if(obj->classType() == vl::ArrayUByte4::Type())
-        vlx = export_ArrayT<vl::ArrayUByte4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayUByte4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayByte1::Type())
-        vlx = export_ArrayT<vl::ArrayByte1, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayByte1>(s, obj);
       else
       if(obj->classType() == vl::ArrayByte2::Type())
-        vlx = export_ArrayT<vl::ArrayByte2, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayByte2>(s, obj);
       else
       if(obj->classType() == vl::ArrayByte3::Type())
-        vlx = export_ArrayT<vl::ArrayByte3, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayByte3>(s, obj);
       else
       if(obj->classType() == vl::ArrayByte4::Type())
-        vlx = export_ArrayT<vl::ArrayByte4, VLXArrayInteger>(s, obj);
+        vlx = export_ArrayT<vl::ArrayByte4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayFloat1::Type())
-        vlx = export_ArrayT<vl::ArrayFloat1, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayFloat1>(s, obj);
       else
       if(obj->classType() == vl::ArrayFloat2::Type())
-        vlx = export_ArrayT<vl::ArrayFloat2, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayFloat2>(s, obj);
       else
       if(obj->classType() == vl::ArrayFloat3::Type())
-        vlx = export_ArrayT<vl::ArrayFloat3, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayFloat3>(s, obj);
       else
       if(obj->classType() == vl::ArrayFloat4::Type())
-        vlx = export_ArrayT<vl::ArrayFloat4, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayFloat4>(s, obj);
       else
 
       if(obj->classType() == vl::ArrayDouble1::Type())
-        vlx = export_ArrayT<vl::ArrayDouble1, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayDouble1>(s, obj);
       else
       if(obj->classType() == vl::ArrayDouble2::Type())
-        vlx = export_ArrayT<vl::ArrayDouble2, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayDouble2>(s, obj);
       else
       if(obj->classType() == vl::ArrayDouble3::Type())
-        vlx = export_ArrayT<vl::ArrayDouble3, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayDouble3>(s, obj);
       else
       if(obj->classType() == vl::ArrayDouble4::Type())
-        vlx = export_ArrayT<vl::ArrayDouble4, VLXArrayReal>(s, obj);
+        vlx = export_ArrayT<vl::ArrayDouble4>(s, obj);
+      else
+
+      if(obj->classType() == vl::ArrayHFloat1::Type())
+        vlx = export_ArrayT<vl::ArrayHFloat1>(s, obj);
+      else
+      if(obj->classType() == vl::ArrayHFloat2::Type())
+        vlx = export_ArrayT<vl::ArrayHFloat2>(s, obj);
+      else
+      if(obj->classType() == vl::ArrayHFloat3::Type())
+        vlx = export_ArrayT<vl::ArrayHFloat3>(s, obj);
+      else
+      if(obj->classType() == vl::ArrayHFloat4::Type())
+        vlx = export_ArrayT<vl::ArrayHFloat4>(s, obj);
       else
       {
         s.signalExportError("Array type not supported for export.\n");
@@ -2762,7 +2621,7 @@ namespace vlX
 
   //---------------------------------------------------------------------------
 
-  /** VLX wrapper of vl::GLSLVertexShader, vl::GLSLFragmentShader, vl::GLSLGeometryShader, vl::GLSLTessControlShader, vl::GLSLTessEvaluationShader. */
+  /** VLX wrapper of vl::GLSLVertexShader, vl::GLSLFragmentShader, vl::GLSLGeometryShader, vl::GLSLTessControlShader, vl::GLSLTessEvaluationShader, vl::GLSLComputeShader. */
   struct VLXClassWrapper_GLSLShader: public ClassWrapper
   {
     void importGLSLShader(VLXSerializer& s, const VLXStructure* vlx, vl::GLSLShader* obj)
@@ -2807,6 +2666,9 @@ namespace vlX
       if (vlx->tag() == "<vl::GLSLTessEvaluationShader>")
         obj = new vl::GLSLTessEvaluationShader;
       else
+      if (vlx->tag() == "<vl::GLSLComputeShader>")
+        obj = new vl::GLSLComputeShader;
+      else
       {
         s.signalImportError( vl::Say("Line %n : shader type '%s' not supported.\n") << vlx->tag() );
         return NULL;
@@ -3164,6 +3026,20 @@ namespace vlX
             s.signalImportError( vl::Say("Line %n : unknown sort mode '%s'.\n") << vlx_sm->lineNumber() << vlx_sm->getIdentifier() );
           obj->as<vl::DepthSortCallback>()->setSortMode(sm);
         }
+
+        const VLXValue* vlx_tol = vlx->getValue("SortTolerance");
+        if (vlx_tol)
+        {
+          VLX_IMPORT_CHECK_RETURN( vlx_tol->type() == VLXValue::Real, *vlx_tol )
+          obj->as<vl::DepthSortCallback>()->setSortTolerance( (vl::real)vlx_tol->getReal() );
+        }
+
+        const VLXValue* vlx_cs = vlx->getValue("ClusterSize");
+        if (vlx_cs)
+        {
+          VLX_IMPORT_CHECK_RETURN( vlx_cs->type() == VLXValue::Integer, *vlx_cs )
+          obj->as<vl::DepthSortCallback>()->setClusterSize( (int)vlx_cs->getInteger() );
+        }
       }
     }
 
@@ -3195,6 +3071,8 @@ namespace vlX
           *vlx << "SortMode" << vlx_Identifier("SM_SortBackToFront");
         else
           *vlx << "SortMode" << vlx_Identifier("SM_SortFrontToBack");
+        *vlx << "SortTolerance" << (double)dsc->sortTolerance();
+        *vlx << "ClusterSize" << (long long)dsc->clusterSize();
       }
       else
       {
@@ -3539,6 +3417,525 @@ namespace vlX
       return vlx;
     }
   };
+
+  //---------------------------------------------------------------------------
+
+  /** VLX wrapper of vl::Portal */
+  struct VLXClassWrapper_Portal: public ClassWrapper
+  {
+    void importPortal(VLXSerializer& s, const VLXStructure* vlx, vl::Portal* obj)
+    {
+      const VLXValue* name = vlx->getValue("ObjectName");
+      if (name)
+        obj->setObjectName( name->getString() );
+
+      for(size_t i=0; i<vlx->value().size(); ++i)
+      {
+        const std::string& key = vlx->value()[i].key();
+        const VLXValue& value = vlx->value()[i].value();
+        if (key == "Geometry")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          const VLXArrayReal* arr = value.getArrayReal();
+          VLX_IMPORT_CHECK_RETURN( arr->value().size() % 3 == 0, value )
+          obj->geometry().resize( arr->value().size() / 3 );
+          for(size_t j=0; j<obj->geometry().size(); ++j)
+            obj->geometry()[j] = vl::fvec3( (float)arr->value()[j*3+0], (float)arr->value()[j*3+1], (float)arr->value()[j*3+2] );
+        }
+        else
+        if (key == "TargetSector")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Structure, value )
+          vl::Sector* sector = s.importVLX( value.getStructure() )->as<vl::Sector>();
+          VLX_IMPORT_CHECK_RETURN( sector != NULL, value )
+          obj->setTargetSector(sector);
+        }
+        else
+        if (key == "IsOpen")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Bool, value )
+          obj->setIsOpen( value.getBool() );
+        }
+      }
+    }
+
+    virtual vl::ref<vl::Object> importVLX(VLXSerializer& s, const VLXStructure* vlx)
+    {
+      vl::ref<vl::Portal> obj = new vl::Portal;
+      // register imported structure asap
+      s.registerImportedStructure(vlx, obj.get());
+      importPortal(s, vlx, obj.get());
+      return obj;
+    }
+
+    void exportPortal(VLXSerializer& s, const vl::Portal* obj, VLXStructure* vlx)
+    {
+      if (!obj->objectName().empty() && obj->objectName() != obj->className())
+        *vlx << "ObjectName" << vlx_String(obj->objectName());
+
+      if (!obj->geometry().empty())
+      {
+        VLXValue geom( new VLXArrayReal );
+        geom.getArrayReal()->value().resize( obj->geometry().size() * 3 );
+        for(size_t i=0; i<obj->geometry().size(); ++i)
+        {
+          geom.getArrayReal()->value()[i*3+0] = obj->geometry()[i].x();
+          geom.getArrayReal()->value()[i*3+1] = obj->geometry()[i].y();
+          geom.getArrayReal()->value()[i*3+2] = obj->geometry()[i].z();
+        }
+        *vlx << "Geometry" << geom;
+      }
+
+      if (obj->targetSector())
+        *vlx << "TargetSector" << s.exportVLX(obj->targetSector());
+      *vlx << "IsOpen" << obj->isOpen();
+    }
+
+    virtual vl::ref<VLXStructure> exportVLX(VLXSerializer& s, const vl::Object* obj)
+    {
+      const vl::Portal* cast_obj = obj->as<vl::Portal>(); VL_CHECK(cast_obj)
+      vl::ref<VLXStructure> vlx = new VLXStructure(vlx_makeTag(obj).c_str(), s.generateID("portal_"));
+      // register exported object asap
+      s.registerExportedObject(obj, vlx.get());
+      exportPortal(s, cast_obj, vlx.get());
+      return vlx;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+
+  /** VLX wrapper of vl::Sector */
+  struct VLXClassWrapper_Sector: public ClassWrapper
+  {
+    void importSector(VLXSerializer& s, const VLXStructure* vlx, vl::Sector* obj)
+    {
+      const VLXValue* name = vlx->getValue("ObjectName");
+      if (name)
+        obj->setObjectName( name->getString() );
+
+      for(size_t i=0; i<vlx->value().size(); ++i)
+      {
+        const std::string& key = vlx->value()[i].key();
+        const VLXValue& value = vlx->value()[i].value();
+        if (key == "Actors")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::List, value )
+          const VLXList* list = value.getList();
+          for(size_t j=0; j<list->value().size(); ++j)
+          {
+            VLX_IMPORT_CHECK_RETURN( list->value()[j].type() == VLXValue::Structure, list->value()[j] )
+            vl::Actor* actor = s.importVLX( list->value()[j].getStructure() )->as<vl::Actor>();
+            VLX_IMPORT_CHECK_RETURN( actor != NULL, list->value()[j] )
+            obj->actors()->push_back(actor);
+          }
+        }
+        else
+        if (key == "Volumes")
+        {
+          // min and max corner of every volume
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          const VLXArrayReal* arr = value.getArrayReal();
+          VLX_IMPORT_CHECK_RETURN( arr->value().size() % 6 == 0, value )
+          for(size_t j=0; j<arr->value().size(); j+=6)
+          {
+            const double* v = &arr->value()[j];
+            obj->volumes().push_back( vl::AABB( vl::vec3((vl::real)v[0], (vl::real)v[1], (vl::real)v[2]), vl::vec3((vl::real)v[3], (vl::real)v[4], (vl::real)v[5]) ) );
+          }
+        }
+        else
+        if (key == "Portals")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::List, value )
+          const VLXList* list = value.getList();
+          for(size_t j=0; j<list->value().size(); ++j)
+          {
+            VLX_IMPORT_CHECK_RETURN( list->value()[j].type() == VLXValue::Structure, list->value()[j] )
+            vl::Portal* portal = s.importVLX( list->value()[j].getStructure() )->as<vl::Portal>();
+            VLX_IMPORT_CHECK_RETURN( portal != NULL, list->value()[j] )
+            obj->portals().push_back(portal);
+          }
+        }
+        else
+        if (key == "PotentiallyVisibleSet")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::List, value )
+          const VLXList* list = value.getList();
+          for(size_t j=0; j<list->value().size(); ++j)
+          {
+            VLX_IMPORT_CHECK_RETURN( list->value()[j].type() == VLXValue::Structure, list->value()[j] )
+            vl::Sector* sector = s.importVLX( list->value()[j].getStructure() )->as<vl::Sector>();
+            VLX_IMPORT_CHECK_RETURN( sector != NULL, list->value()[j] )
+            obj->potentiallyVisibleSet().push_back(sector);
+          }
+        }
+      }
+    }
+
+    virtual vl::ref<vl::Object> importVLX(VLXSerializer& s, const VLXStructure* vlx)
+    {
+      vl::ref<vl::Sector> obj = new vl::Sector;
+      // register imported structure asap
+      s.registerImportedStructure(vlx, obj.get());
+      importSector(s, vlx, obj.get());
+      return obj;
+    }
+
+    void exportSector(VLXSerializer& s, const vl::Sector* obj, VLXStructure* vlx)
+    {
+      if (!obj->objectName().empty() && obj->objectName() != obj->className())
+        *vlx << "ObjectName" << vlx_String(obj->objectName());
+
+      VLXValue actors;
+      actors.setList( new VLXList );
+      for(int i=0; i<obj->actors()->size(); ++i)
+        *actors.getList() << s.exportVLX(obj->actors()->at(i));
+      *vlx << "Actors" << actors;
+
+      // empty arrays are not typed in VLT
+      if (!obj->volumes().empty())
+      {
+        VLXValue volumes( new VLXArrayReal );
+        for(size_t i=0; i<obj->volumes().size(); ++i)
+        {
+          const vl::AABB& aabb = obj->volumes()[i];
+          for(int j=0; j<3; ++j)
+            volumes.getArrayReal()->value().push_back( aabb.minCorner()[j] );
+          for(int j=0; j<3; ++j)
+            volumes.getArrayReal()->value().push_back( aabb.maxCorner()[j] );
+        }
+        *vlx << "Volumes" << volumes;
+      }
+
+      VLXValue portals;
+      portals.setList( new VLXList );
+      for(size_t i=0; i<obj->portals().size(); ++i)
+        *portals.getList() << s.exportVLX(obj->portals()[i].get());
+      *vlx << "Portals" << portals;
+
+      if (!obj->potentiallyVisibleSet().empty())
+      {
+        VLXValue pvs;
+        pvs.setList( new VLXList );
+        for(size_t i=0; i<obj->potentiallyVisibleSet().size(); ++i)
+          *pvs.getList() << s.exportVLX(obj->potentiallyVisibleSet()[i]);
+        *vlx << "PotentiallyVisibleSet" << pvs;
+      }
+    }
+
+    virtual vl::ref<VLXStructure> exportVLX(VLXSerializer& s, const vl::Object* obj)
+    {
+      const vl::Sector* cast_obj = obj->as<vl::Sector>(); VL_CHECK(cast_obj)
+      vl::ref<VLXStructure> vlx = new VLXStructure(vlx_makeTag(obj).c_str(), s.generateID("sector_"));
+      // register exported object asap
+      s.registerExportedObject(obj, vlx.get());
+      exportSector(s, cast_obj, vlx.get());
+      return vlx;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+
+  /** VLX wrapper of vl::SceneManagerPortals */
+  struct VLXClassWrapper_SceneManagerPortals: public ClassWrapper
+  {
+    void importSceneManagerPortals(VLXSerializer& s, const VLXStructure* vlx, vl::SceneManagerPortals* obj)
+    {
+      const VLXValue* name = vlx->getValue("ObjectName");
+      if (name)
+        obj->setObjectName( name->getString() );
+
+      for(size_t i=0; i<vlx->value().size(); ++i)
+      {
+        const std::string& key = vlx->value()[i].key();
+        const VLXValue& value = vlx->value()[i].value();
+        if (key == "Sectors")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::List, value )
+          const VLXList* list = value.getList();
+          for(size_t j=0; j<list->value().size(); ++j)
+          {
+            VLX_IMPORT_CHECK_RETURN( list->value()[j].type() == VLXValue::Structure, list->value()[j] )
+            vl::Sector* sector = s.importVLX( list->value()[j].getStructure() )->as<vl::Sector>();
+            VLX_IMPORT_CHECK_RETURN( sector != NULL, list->value()[j] )
+            obj->sectors().push_back(sector);
+          }
+        }
+        else
+        if (key == "ExternalSector")
+        {
+          // the external sector is owned by the scene manager, its content is imported into it
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Structure, value )
+          s.registerImportedStructure(value.getStructure(), obj->externalSector());
+          VLXClassWrapper_Sector().importSector(s, value.getStructure(), obj->externalSector());
+        }
+        else
+        if (key == "CullingEnabled")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Bool, value )
+          obj->setCullingEnabled( value.getBool() );
+        }
+      }
+
+      obj->computePortalNormals();
+    }
+
+    virtual vl::ref<vl::Object> importVLX(VLXSerializer& s, const VLXStructure* vlx)
+    {
+      vl::ref<vl::SceneManagerPortals> obj = new vl::SceneManagerPortals;
+      // register imported structure asap
+      s.registerImportedStructure(vlx, obj.get());
+      importSceneManagerPortals(s, vlx, obj.get());
+      return obj;
+    }
+
+    void exportSceneManagerPortals(VLXSerializer& s, const vl::SceneManagerPortals* obj, VLXStructure* vlx)
+    {
+      if (!obj->objectName().empty() && obj->objectName() != obj->className())
+        *vlx << "ObjectName" << vlx_String(obj->objectName());
+      *vlx << "CullingEnabled" << obj->cullingEnabled();
+
+      // exported first so that sectors referring to it through portals or potentially visible sets are linked to it
+      *vlx << "ExternalSector" << s.exportVLX(obj->externalSector());
+
+      VLXValue sectors;
+      sectors.setList( new VLXList );
+      for(size_t i=0; i<obj->sectors().size(); ++i)
+        *sectors.getList() << s.exportVLX(obj->sectors()[i].get());
+      *vlx << "Sectors" << sectors;
+    }
+
+    virtual vl::ref<VLXStructure> exportVLX(VLXSerializer& s, const vl::Object* obj)
+    {
+      const vl::SceneManagerPortals* cast_obj = obj->as<vl::SceneManagerPortals>(); VL_CHECK(cast_obj)
+      vl::ref<VLXStructure> vlx = new VLXStructure(vlx_makeTag(obj).c_str(), s.generateID("portalscenemanager_"));
+      // register exported object asap
+      s.registerExportedObject(obj, vlx.get());
+      exportSceneManagerPortals(s, cast_obj, vlx.get());
+      return vlx;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+
+  /** VLX wrapper of vl::ParticleEmitter */
+  struct VLXClassWrapper_ParticleEmitter: public ClassWrapper
+  {
+    void importParticleEmitter(VLXSerializer& s, const VLXStructure* vlx, vl::ParticleEmitter* obj)
+    {
+      const VLXValue* name = vlx->getValue("ObjectName");
+      if (name)
+        obj->setObjectName( name->getString() );
+
+      for(size_t i=0; i<vlx->value().size(); ++i)
+      {
+        const std::string& key = vlx->value()[i].key();
+        const VLXValue& value = vlx->value()[i].value();
+        if (key == "Enabled")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Bool, value )
+          obj->setEnabled( value.getBool() );
+        }
+        else
+        if (key == "Rate")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setRate( (float)value.getReal() );
+        }
+        else
+        if (key == "Shape")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Identifier, value )
+          obj->setShape( vlx_EParticleEmitterShape(value, s) );
+        }
+        else
+        if (key == "Position")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setPosition( (vl::fvec3)vlx_vec3( value.getArrayReal() ) );
+        }
+        else
+        if (key == "Extent")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setExtent( (vl::fvec3)vlx_vec3( value.getArrayReal() ) );
+        }
+        else
+        if (key == "Velocity")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setVelocity( (vl::fvec3)vlx_vec3( value.getArrayReal() ) );
+        }
+        else
+        if (key == "VelocitySpread")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setVelocitySpread( (float)value.getReal() );
+        }
+        else
+        if (key == "Lifetime")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          vl::vec2 life = vlx_vec2( value.getArrayReal() );
+          obj->setLifetime( (float)life.x(), (float)life.y() );
+        }
+        else
+        if (key == "SizeBegin")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setSizeBegin( (float)value.getReal() );
+        }
+        else
+        if (key == "SizeEnd")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setSizeEnd( (float)value.getReal() );
+        }
+        else
+        if (key == "ColorBegin")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setColorBegin( (vl::fvec4)vlx_vec4( value.getArrayReal() ) );
+        }
+        else
+        if (key == "ColorEnd")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setColorEnd( (vl::fvec4)vlx_vec4( value.getArrayReal() ) );
+        }
+      }
+    }
+
+    virtual vl::ref<vl::Object> importVLX(VLXSerializer& s, const VLXStructure* vlx)
+    {
+      vl::ref<vl::ParticleEmitter> obj = new vl::ParticleEmitter;
+      // register imported structure asap
+      s.registerImportedStructure(vlx, obj.get());
+      importParticleEmitter(s, vlx, obj.get());
+      return obj;
+    }
+
+    void exportParticleEmitter(const vl::ParticleEmitter* obj, VLXStructure* vlx)
+    {
+      if (!obj->objectName().empty() && obj->objectName() != obj->className())
+        *vlx << "ObjectName" << vlx_String(obj->objectName());
+      *vlx << "Enabled" << obj->isEnabled();
+      *vlx << "Rate" << obj->rate();
+      *vlx << "Shape" << vlx_Identifier(vlx_EParticleEmitterShape(obj->shape()));
+      *vlx << "Position" << vlx_toValue((vl::vec3)obj->position());
+      *vlx << "Extent" << vlx_toValue((vl::vec3)obj->extent());
+      *vlx << "Velocity" << vlx_toValue((vl::vec3)obj->velocity());
+      *vlx << "VelocitySpread" << obj->velocitySpread();
+      *vlx << "Lifetime" << vlx_toValue((vl::vec2)obj->lifetime());
+      *vlx << "SizeBegin" << obj->sizeBegin();
+      *vlx << "SizeEnd" << obj->sizeEnd();
+      *vlx << "ColorBegin" << vlx_toValue((vl::vec4)obj->colorBegin());
+      *vlx << "ColorEnd" << vlx_toValue((vl::vec4)obj->colorEnd());
+    }
+
+    virtual vl::ref<VLXStructure> exportVLX(VLXSerializer& s, const vl::Object* obj)
+    {
+      const vl::ParticleEmitter* cast_obj = obj->as<vl::ParticleEmitter>(); VL_CHECK(cast_obj)
+      vl::ref<VLXStructure> vlx = new VLXStructure(vlx_makeTag(obj).c_str(), s.generateID("particleemitter_"));
+      // register exported object asap
+      s.registerExportedObject(obj, vlx.get());
+      exportParticleEmitter(cast_obj, vlx.get());
+      return vlx;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+
+  /** VLX wrapper of vl::ParticleSystem */
+  struct VLXClassWrapper_ParticleSystem: public VLXClassWrapper_Renderable
+  {
+    void importParticleSystem(VLXSerializer& s, const VLXStructure* vlx, vl::ParticleSystem* obj)
+    {
+      VLXClassWrapper_Renderable::importRenderable(vlx, obj);
+
+      for(size_t i=0; i<vlx->value().size(); ++i)
+      {
+        const std::string& key = vlx->value()[i].key();
+        const VLXValue& value = vlx->value()[i].value();
+        if (key == "Capacity")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Integer, value )
+          obj->setCapacity( (int)value.getInteger() );
+        }
+        else
+        if (key == "Gravity")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::ArrayReal, value )
+          obj->setGravity( (vl::fvec3)vlx_vec3( value.getArrayReal() ) );
+        }
+        else
+        if (key == "Damping")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setDamping( (float)value.getReal() );
+        }
+        else
+        if (key == "AutoUpdate")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Bool, value )
+          obj->setAutoUpdate( value.getBool() );
+        }
+        else
+        if (key == "MaxTimeStep")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::Real, value )
+          obj->setMaxTimeStep( (float)value.getReal() );
+        }
+        else
+        if (key == "Emitters")
+        {
+          VLX_IMPORT_CHECK_RETURN( value.type() == VLXValue::List, value )
+          const VLXList* list = value.getList();
+          for(size_t j=0; j<list->value().size(); ++j)
+          {
+            const VLXValue& vlx_em = list->value()[j];
+            VLX_IMPORT_CHECK_RETURN( vlx_em.type() == VLXValue::Structure, vlx_em )
+            vl::ParticleEmitter* em = s.importVLX( vlx_em.getStructure() )->as<vl::ParticleEmitter>();
+            VLX_IMPORT_CHECK_RETURN( em != NULL, vlx_em )
+            obj->emitters()->push_back(em);
+          }
+        }
+      }
+    }
+
+    virtual vl::ref<vl::Object> importVLX(VLXSerializer& s, const VLXStructure* vlx)
+    {
+      vl::ref<vl::ParticleSystem> obj = new vl::ParticleSystem;
+      // register imported structure asap
+      s.registerImportedStructure(vlx, obj.get());
+      importParticleSystem(s, vlx, obj.get());
+      return obj;
+    }
+
+    void exportParticleSystem(VLXSerializer& s, const vl::ParticleSystem* obj, VLXStructure* vlx)
+    {
+      exportRenderable(obj, vlx);
+      *vlx << "Capacity" << (long long)obj->capacity();
+      *vlx << "Gravity" << vlx_toValue((vl::vec3)obj->gravity());
+      *vlx << "Damping" << obj->damping();
+      *vlx << "AutoUpdate" << obj->autoUpdate();
+      *vlx << "MaxTimeStep" << obj->maxTimeStep();
+      VLXValue emitters;
+      emitters.setList( new VLXList );
+      for(int i=0; i<obj->emitters()->size(); ++i)
+        *emitters.getList() << s.exportVLX(obj->emitters()->at(i));
+      *vlx << "Emitters" << emitters;
+    }
+
+    virtual vl::ref<VLXStructure> exportVLX(VLXSerializer& s, const vl::Object* obj)
+    {
+      const vl::ParticleSystem* cast_obj = obj->as<vl::ParticleSystem>(); VL_CHECK(cast_obj)
+      vl::ref<VLXStructure> vlx = new VLXStructure(vlx_makeTag(obj).c_str(), s.generateID("particlesystem_"));
+      // register exported object asap
+      s.registerExportedObject(obj, vlx.get());
+      exportParticleSystem(s, cast_obj, vlx.get());
+      return vlx;
+    }
+  };
 }
 
 #endif
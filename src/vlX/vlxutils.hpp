@@ -529,6 +529,23 @@ namespace vlX
     case vl::TF_COMPRESSED_RED_GREEN_RGTC2_EXT       : return "TF_COMPRESSED_RED_GREEN_RGTC2_EXT";
     case vl::TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT: return "TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT";
 
+    case vl::TF_COMPRESSED_RGBA_BPTC_UNORM: return "TF_COMPRESSED_RGBA_BPTC_UNORM";
+    case vl::TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM: return "TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM";
+    case vl::TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT: return "TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT";
+    case vl::TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT: return "TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT";
+    case vl::TF_COMPRESSED_RGB8_ETC2: return "TF_COMPRESSED_RGB8_ETC2";
+    case vl::TF_COMPRESSED_SRGB8_ETC2: return "TF_COMPRESSED_SRGB8_ETC2";
+    case vl::TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2: return "TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2";
+    case vl::TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2: return "TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2";
+    case vl::TF_COMPRESSED_RGBA8_ETC2_EAC: return "TF_COMPRESSED_RGBA8_ETC2_EAC";
+    case vl::TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC: return "TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC";
+    case vl::TF_COMPRESSED_R11_EAC: return "TF_COMPRESSED_R11_EAC";
+    case vl::TF_COMPRESSED_SIGNED_R11_EAC: return "TF_COMPRESSED_SIGNED_R11_EAC";
+    case vl::TF_COMPRESSED_RG11_EAC: return "TF_COMPRESSED_RG11_EAC";
+    case vl::TF_COMPRESSED_SIGNED_RG11_EAC: return "TF_COMPRESSED_SIGNED_RG11_EAC";
+    case vl::TF_COMPRESSED_RGBA_ASTC_4x4_KHR: return "TF_COMPRESSED_RGBA_ASTC_4x4_KHR";
+    case vl::TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR: return "TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR";
+
     // EXT_texture_integer
     // case vl::TF_RGBA32UI_EXT: return "TF_RGBA32UI_EXT";
     // case vl::TF_RGB32UI_EXT: return "TF_RGB32UI_EXT";
@@ -768,6 +785,23 @@ namespace vlX
     if( value.getIdentifier() == "TF_COMPRESSED_RED_GREEN_RGTC2_EXT") return vl::TF_COMPRESSED_RED_GREEN_RGTC2_EXT;
     if( value.getIdentifier() == "TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT") return vl::TF_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT;
 
+    if( value.getIdentifier() == "TF_COMPRESSED_RGBA_BPTC_UNORM") return vl::TF_COMPRESSED_RGBA_BPTC_UNORM;
+    if( value.getIdentifier() == "TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM") return vl::TF_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT") return vl::TF_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT") return vl::TF_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGB8_ETC2") return vl::TF_COMPRESSED_RGB8_ETC2;
+    if( value.getIdentifier() == "TF_COMPRESSED_SRGB8_ETC2") return vl::TF_COMPRESSED_SRGB8_ETC2;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2") return vl::TF_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    if( value.getIdentifier() == "TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2") return vl::TF_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGBA8_ETC2_EAC") return vl::TF_COMPRESSED_RGBA8_ETC2_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC") return vl::TF_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_R11_EAC") return vl::TF_COMPRESSED_R11_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_SIGNED_R11_EAC") return vl::TF_COMPRESSED_SIGNED_R11_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_RG11_EAC") return vl::TF_COMPRESSED_RG11_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_SIGNED_RG11_EAC") return vl::TF_COMPRESSED_SIGNED_RG11_EAC;
+    if( value.getIdentifier() == "TF_COMPRESSED_RGBA_ASTC_4x4_KHR") return vl::TF_COMPRESSED_RGBA_ASTC_4x4_KHR;
+    if( value.getIdentifier() == "TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR") return vl::TF_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR;
+
     // EXT_texture_integer
     if( value.getIdentifier() == "TF_RGBA32UI_EXT") return vl::TF_RGBA32UI_EXT;
     if( value.getIdentifier() == "TF_RGB32UI_EXT") return vl::TF_RGB32UI_EXT;
@@ -1296,6 +1330,28 @@ namespace vlX
     }
   }
 
+  inline const char* vlx_EParticleEmitterShape(vl::EParticleEmitterShape shape)
+  {
+    switch(shape)
+    {
+    default:
+    case vl::PES_Point: return "PES_Point";
+    case vl::PES_Box: return "PES_Box";
+    case vl::PES_Sphere: return "PES_Sphere";
+    }
+  }
+
+  inline vl::EParticleEmitterShape vlx_EParticleEmitterShape(const VLXValue& value, VLXSerializer& s)
+  {
+    if( value.getIdentifier() == "PES_Point") return vl::PES_Point;
+    if( value.getIdentifier() == "PES_Box") return vl::PES_Box;
+    if( value.getIdentifier() == "PES_Sphere") return vl::PES_Sphere;
+
+    vl::Log::error( vl::Say("Line %n : unknown token '%s'.\n") << value.lineNumber() << value.getIdentifier() );
+    s.setError(VLXSerializer::ImportError);
+    return vl::PES_Point;
+  }
+
 }
 
 #endif